@@ -43,10 +43,28 @@
  *
  * GET RID OFF SEND QUEUE ??
  *
- * Version 0.3.0
+ * Version 0.4.1.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Request CRC-32C based update identifiers in the reconnect 
+ *              handshake.
+ *            * Request multi verification notifications in the reconnect
+ *              handshake.
+ *          - 2026/10/15 - kyehwanl
+ *            * Packets are queued into bounded send buffers and written by
+ *              the send thread, the caller never waits for the socket. The 
+ *              proxy user is informed about a full and a drained buffer.
+ *            * sendGoodbye waits until the queued packets are written.
+ *            * Connect a server on the same host using the shared memory
+ *              transport if the proxy requests it, otherwise use TCP.
+ *            * Request bulk verify requests in the reconnect handshake.
+ *            * Request the incremental synchronization in the reconnect
+ *              handshake. Added queuePacketToServerWait.
+ *            * Request the flow control in the reconnect handshake. The send
+ *              thread holds back the queued packets while the server paused
+ *              the proxy (setServerFlowControl).
  * 0.3.0.10 - 2015/11/10 - oborchert
  *            * Removed un-used static function _suppressSIGINT. It was already
  *              replaced with SIG_IGN. 
@@ -62,11 +80,13 @@
  *            * Code Created
  * -----------------------------------------------------------------------------
  */
+#include <errno.h>
 #include <stdio.h>
 #include <signal.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <netinet/tcp.h>
+#include <sys/socket.h>
 #include "client/client_connection_handler.h"
 #include "shared/srx_packets.h"
 #include "util/client_socket.h"
@@ -90,8 +110,23 @@
 /** Max. entries in the send queue */
 #define MAX_SEND_QUEUE  100000
 
+/** The capacity in bytes of each of the two send buffers. */
+#define SEND_BUFFER_SIZE (1024 * 1024)
+/** The number of queued bytes that lets the proxy user pause. */
+#define SEND_BUFFER_HIGH ((SEND_BUFFER_SIZE / 4) * 3)
+/** The number of queued bytes that lets the proxy user continue. */
+#define SEND_BUFFER_LOW  (SEND_BUFFER_SIZE / 4)
+
 #define HDR "([0x%08X] Client Connection Handler): "
 
+// Defined in srx_api.c
+void callCMgmtHandler(SRxProxy* proxy, SRxProxyCommCode mainCode, int subCode);
+
+// Forward declaration
+static bool _startSendThread(ClientConnectionHandler* self);
+static void _stopSendThread(ClientConnectionHandler* self);
+static void _flushSendBuffer(ClientConnectionHandler* self);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Status variables for handshake timeout - since 0.3.0
 ////////////////////////////////////////////////////////////////////////////////
@@ -130,6 +165,14 @@ ClientConnectionHandler* createClientConnectionHandler(SRxProxy* proxy)
     // and released in the connection handlers init and release method
     self->cond        = NULL;
     self->rcvMonitor  = NULL;
+    // The send buffers are created with the send thread.
+    self->sendRunning  = false;
+    self->sendFill     = NULL;
+    self->sendOut      = NULL;
+    self->sendFillSize = 0;
+    self->sendOutSize  = 0;
+    self->sendFull     = false;
+    self->serverPaused = false;
 
     // Set default socket parameters
     self->clSock.type = SRX_PROXY_CLIENT_SOCKET;
@@ -185,9 +228,13 @@ bool initializeClientConnectionHandler(ClientConnectionHandler* self,
   }
 
   // Initialize the client socket - This also creates it. By default the socket
-  // can be closed.
-  if (!createClientSocket(&self->clSock, host, port, true,
-                          SRX_PROXY_CLIENT_SOCKET, true))
+  // can be closed. A server on the same host is preferably connected using
+  // the shared memory transport.
+  if (   !(   ((SRxProxy*)self->srxProxy)->requestShmTransport
+           && createShmClientSocket(&self->clSock, host, port,
+                                    SRX_PROXY_CLIENT_SOCKET, true))
+      && !createClientSocket(&self->clSock, host, port, true,
+                             SRX_PROXY_CLIENT_SOCKET, true))
   {
     RAISE_ERROR("%s Could not create and initialize the client socket.!",
                 errPrefix);
@@ -240,6 +287,12 @@ bool initializeClientConnectionHandler(ClientConnectionHandler* self,
   pthread_cond_init(self->cond, NULL);
   initMutex(self->rcvMonitor);
 
+  if (!_startSendThread(self))
+  {
+    RAISE_ERROR("%s Could not start the send thread, send directly!", 
+                errPrefix);
+  }
+
   // Instance is initialized and connected on TCP layer...
   self->initialized = true;
   // ... but not on application layer yet! This is to be done in the proxy.
@@ -275,6 +328,9 @@ void releaseClientConnectionHandler(ClientConnectionHandler* self)
         sendGoodbye(self, self->keepWindow);
       }
 
+      // Packets queued after the goodbye are dropped.
+      _stopSendThread(self);
+
       //pthread_kill(self->recvThread, SIGINT);
       //pthread_cancel(self->recvThread);
 
@@ -450,6 +506,375 @@ bool sendPacketToServer(ClientConnectionHandler* self, void* data,
   return true;
 }
 
+/**
+ * Call the send queue state callback of the proxy if one is registered.
+ *
+ * @param self The client connection handler.
+ * @param full The state of the send buffer.
+ *
+ * @since 0.4.1.0
+ */
+static void _callSendQueueState(ClientConnectionHandler* self, bool full)
+{
+  SRxProxy* proxy = self->srxProxy;
+
+  if (proxy->sendQueueState != NULL)
+  {
+    proxy->sendQueueState(full, proxy->userPtr);
+  }
+}
+
+/**
+ * Queue one or more complete PDUs into the send buffer. Without send thread
+ * the data is send using sendPacketToServer.
+ *
+ * @param self Instance that should be used
+ * @param data The PDUs to be send.
+ * @param length Data size in bytes.
+ * @param wait Wait until the send thread made room in a full send buffer.
+ *
+ * @return 0 if the data is queued, otherwise the error code. ENOBUFS 
+ *         indicates a full send buffer.
+ *
+ * @since 0.4.1.0
+ */
+static int _queuePacket(ClientConnectionHandler* self, void* data,
+                        uint32_t length, bool wait)
+{
+  bool reportFull = false;
+  int  retVal     = 0;
+
+  if (!self->sendRunning || !isConnectedToServer(&self->clSock))
+  {
+    if (sendPacketToServer(self, data, length))
+    {
+      return 0;
+    }
+    retVal = getLastSendError();
+    return retVal != 0 ? retVal : ENOTCONN;
+  }
+  if (length > SEND_BUFFER_SIZE)
+  {
+    return EMSGSIZE;
+  }
+
+  pthread_mutex_lock(&self->sendMutex);
+  while (   wait && self->sendRunning
+         && ((self->sendFillSize + length) > SEND_BUFFER_SIZE))
+  {
+    pthread_cond_wait(&self->sendCond, &self->sendMutex);
+  }
+  if ((self->sendFillSize + length) > SEND_BUFFER_SIZE)
+  {
+    retVal = ENOBUFS;
+  }
+  else
+  {
+    memcpy(self->sendFill + self->sendFillSize, data, length);
+    self->sendFillSize += length;
+    pthread_cond_broadcast(&self->sendCond);
+  }
+  if (   !self->sendFull 
+      && ((self->sendFillSize + self->sendOutSize) > SEND_BUFFER_HIGH))
+  {
+    self->sendFull = true;
+    reportFull     = true;
+  }
+  pthread_mutex_unlock(&self->sendMutex);
+
+  if (reportFull)
+  {
+    _callSendQueueState(self, true);
+  }
+
+  return retVal;
+}
+
+/**
+ * Queue one or more complete PDUs into the send buffer. The data is written
+ * to the server by the send thread, the caller never waits for the socket.
+ * Without send thread the data is send using sendPacketToServer.
+ *
+ * @param self Instance that should be used
+ * @param data The PDUs to be send.
+ * @param length Data size in bytes.
+ *
+ * @return 0 if the data is queued, otherwise the error code. ENOBUFS
+ *         indicates a full send buffer.
+ *
+ * @since 0.4.1.0
+ */
+int queuePacketToServer(ClientConnectionHandler* self, void* data,
+                        uint32_t length)
+{
+  return _queuePacket(self, data, length, false);
+}
+
+/**
+ * Queue one or more complete PDUs into the send buffer. If the send buffer is
+ * full the caller waits until the send thread wrote the queued data. This
+ * allows to send more data than the send buffer can take. Must not be called
+ * by the send thread.
+ *
+ * @param self Instance that should be used
+ * @param data The PDUs to be send.
+ * @param length Data size in bytes.
+ *
+ * @return 0 if the data is queued, otherwise the error code.
+ *
+ * @since 0.4.1.0
+ */
+int queuePacketToServerWait(ClientConnectionHandler* self, void* data,
+                            uint32_t length)
+{
+  return _queuePacket(self, data, length, true);
+}
+
+/**
+ * Pause or resume writing the send buffer as requested by the server. While
+ * paused the queued packets are kept in the send buffer and the send queue
+ * state callback reports a full buffer, the user should pause submitting
+ * requests. Once resumed the buffer is written and a drained buffer is
+ * reported as usual.
+ *
+ * @param self Instance that should be used
+ * @param pause true to pause, false to resume.
+ *
+ * @since 0.4.1.0
+ */
+void setServerFlowControl(ClientConnectionHandler* self, bool pause)
+{
+  bool report = false;
+
+  pthread_mutex_lock(&self->sendMutex);
+  if (self->serverPaused != pause)
+  {
+    self->serverPaused = pause;
+    if (pause)
+    {
+      report         = !self->sendFull;
+      self->sendFull = true;
+    }
+    else if (   self->sendFull
+             && ((self->sendFillSize + self->sendOutSize) <= SEND_BUFFER_LOW))
+    {
+      // Otherwise the send thread reports the drained buffer.
+      report         = true;
+      self->sendFull = false;
+    }
+    pthread_cond_broadcast(&self->sendCond);
+  }
+  pthread_mutex_unlock(&self->sendMutex);
+
+  if (report)
+  {
+    _callSendQueueState(self, pause);
+  }
+}
+
+/**
+ * Report an error of the send thread to the proxy user.
+ *
+ * @param self The client connection handler.
+ * @param error The error code of the failed send operation.
+ *
+ * @since 0.4.1.0
+ */
+static void _reportSendThreadError(ClientConnectionHandler* self, int error)
+{
+  LOG(LEVEL_ERROR, "Failure during sending queued requests (error=%u)!",
+                   error);
+  if (self->clSock.clientFD == -1)
+  {
+    self->established = false;
+    callCMgmtHandler(self->srxProxy, COM_ERR_PROXY_CONNECTION_LOST,
+                     COM_PROXY_NO_SUBCODE);
+  }
+  else
+  {
+    callCMgmtHandler(self->srxProxy, COM_ERR_PROXY_COULD_NOT_SEND, error);
+  }
+}
+
+/**
+ * The send thread. It swaps the fill buffer with the out buffer and writes 
+ * the out buffer with one send operation. Once stopped the remaining queued
+ * data is written before the thread exits.
+ *
+ * @param thisPtr The client connection handler.
+ *
+ * @return NULL
+ *
+ * @since 0.4.1.0
+ */
+static void* _sendThreadLoop(void* thisPtr)
+{
+  ClientConnectionHandler* self = (ClientConnectionHandler*)thisPtr;
+  uint8_t* buffer;
+  bool     reportDrained;
+  int      error;
+
+  LOG(LEVEL_DEBUG, HDR "Send thread started!", pthread_self());
+  pthread_mutex_lock(&self->sendMutex);
+  while (self->sendRunning || (self->sendFillSize > 0))
+  {
+    // While paused by the server the data stays queued, unless stopped.
+    if (   (self->sendFillSize == 0)
+        || (self->serverPaused && self->sendRunning))
+    {
+      pthread_cond_wait(&self->sendCond, &self->sendMutex);
+      continue;
+    }
+    buffer             = self->sendOut;
+    self->sendOut      = self->sendFill;
+    self->sendOutSize  = self->sendFillSize;
+    self->sendFill     = buffer;
+    self->sendFillSize = 0;
+    pthread_mutex_unlock(&self->sendMutex);
+
+    error = 0;
+    if (!sendData(&self->clSock, self->sendOut, self->sendOutSize))
+    {
+      error = getLastSendError();
+      error = error != 0 ? error : ENOTCONN;
+    }
+
+    pthread_mutex_lock(&self->sendMutex);
+    self->sendOutSize = 0;
+    reportDrained =    self->sendFull && !self->serverPaused
+                    && (self->sendFillSize <= SEND_BUFFER_LOW);
+    if (reportDrained)
+    {
+      self->sendFull = false;
+    }
+    // Wake up a waiting flush
+    pthread_cond_broadcast(&self->sendCond);
+    pthread_mutex_unlock(&self->sendMutex);
+
+    if (error != 0)
+    {
+      _reportSendThreadError(self, error);
+    }
+    if (reportDrained)
+    {
+      _callSendQueueState(self, false);
+    }
+    pthread_mutex_lock(&self->sendMutex);
+  }
+  pthread_mutex_unlock(&self->sendMutex);
+  LOG(LEVEL_DEBUG, HDR "Send thread stopped!", pthread_self());
+
+  return NULL;
+}
+
+/**
+ * Create the send buffers and start the send thread.
+ *
+ * @param self The client connection handler.
+ *
+ * @return true if the send thread is running.
+ *
+ * @since 0.4.1.0
+ */
+static bool _startSendThread(ClientConnectionHandler* self)
+{
+  self->sendFill     = malloc(SEND_BUFFER_SIZE);
+  self->sendOut      = malloc(SEND_BUFFER_SIZE);
+  self->sendFillSize = 0;
+  self->sendOutSize  = 0;
+  self->sendFull     = false;
+  if ((self->sendFill == NULL) || (self->sendOut == NULL))
+  {
+    free(self->sendFill);
+    free(self->sendOut);
+    self->sendFill = NULL;
+    self->sendOut  = NULL;
+    return false;
+  }
+
+  pthread_mutex_init(&self->sendMutex, NULL);
+  pthread_cond_init(&self->sendCond, NULL);
+  self->sendRunning = true;
+  if (pthread_create(&self->sendThread, NULL, _sendThreadLoop, self) != 0)
+  {
+    self->sendRunning = false;
+    pthread_cond_destroy(&self->sendCond);
+    pthread_mutex_destroy(&self->sendMutex);
+    free(self->sendFill);
+    free(self->sendOut);
+    self->sendFill = NULL;
+    self->sendOut  = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Stop the send thread once the queued data is written and release the send
+ * buffers. Can be called more than once.
+ *
+ * @param self The client connection handler.
+ *
+ * @since 0.4.1.0
+ */
+static void _stopSendThread(ClientConnectionHandler* self)
+{
+  if (!self->sendRunning)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&self->sendMutex);
+  self->sendRunning = false;
+  pthread_cond_broadcast(&self->sendCond);
+  pthread_mutex_unlock(&self->sendMutex);
+  if (!pthread_equal(pthread_self(), self->sendThread))
+  {
+    pthread_join(self->sendThread, NULL);
+  }
+  else
+  {
+    // Called through a callback of the send thread
+    pthread_detach(self->sendThread);
+    return;
+  }
+
+  pthread_cond_destroy(&self->sendCond);
+  pthread_mutex_destroy(&self->sendMutex);
+  free(self->sendFill);
+  free(self->sendOut);
+  self->sendFill = NULL;
+  self->sendOut  = NULL;
+}
+
+/**
+ * Wait until the send thread wrote all queued data.
+ *
+ * @param self The client connection handler.
+ *
+ * @since 0.4.1.0
+ */
+static void _flushSendBuffer(ClientConnectionHandler* self)
+{
+  if (!self->sendRunning || pthread_equal(pthread_self(), self->sendThread))
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&self->sendMutex);
+  // The goodbye ends the session, the queued data is written even if the
+  // server paused the proxy.
+  self->serverPaused = false;
+  pthread_cond_broadcast(&self->sendCond);
+  while (   self->sendRunning 
+         && ((self->sendFillSize > 0) || (self->sendOutSize > 0)))
+  {
+    pthread_cond_wait(&self->sendCond, &self->sendMutex);
+  }
+  pthread_mutex_unlock(&self->sendMutex);
+}
+
 /**
  * Handler to catch the timeout alarm for handshake.
  * 
@@ -460,6 +885,8 @@ bool sendPacketToServer(ClientConnectionHandler* self, void* data,
 void _catch_handshakeTimeout(int sig)
 {
   _handshakeAlarm = 1;      // set timeout indicator
+  // The shutdown also wakes a reader waiting for the shared memory transport.
+  shutdown(*_handshakeSocket, SHUT_RDWR);
   close(*_handshakeSocket); // unblocks the read
   *_handshakeSocket = -1;
 }
@@ -572,6 +999,9 @@ bool sendGoodbye(ClientConnectionHandler* self, uint16_t keepWindow)
   hdr->keepWindow = htons(keepWindow);
   hdr->length     = htonl(length);
 
+  // The goodbye must follow all queued packets.
+  _flushSendBuffer(self);
+
   if (isConnectedToServer(&self->clSock))
   {
     if (sendData(&self->clSock, &pdu, length))
@@ -651,6 +1081,16 @@ bool reconnectSRX(ClientConnectionHandler* self)
 
     hdr->type            = PDU_SRXPROXY_HELLO;
     hdr->version         = htons(SRX_PROTOCOL_VER);
+    hdr->flags           = (proxy->requestCRC32CID ? SRX_HELLO_FLAG_CRC32C_ID 
+                                                   : 0)
+                           | (proxy->requestMultiNotify 
+                              ? SRX_HELLO_FLAG_MULTI_NOTIFY : 0)
+                           | (proxy->requestBulkVerify
+                              ? SRX_HELLO_FLAG_BULK_VERIFY : 0)
+                           | (proxy->requestIncrSync
+                              ? SRX_HELLO_FLAG_INCR_SYNC : 0)
+                           | (proxy->requestFlowControl
+                              ? SRX_HELLO_FLAG_FLOW_CONTROL : 0);
     hdr->length          = htonl(length);
     hdr->proxyIdentifier = htonl(proxy->proxyID);
     hdr->asn             = htonl(proxy->proxyAS);
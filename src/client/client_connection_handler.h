@@ -20,10 +20,15 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * Version 0.3.0.10
+ * Version 0.4.1.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Added the bounded send buffers and the send thread, added
+ *              queuePacketToServer.
+ *            * Added queuePacketToServerWait.
+ *            * Added serverPaused and setServerFlowControl.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  * 0.3.0    - 2013/02/27 - oborchert
@@ -78,6 +83,18 @@ typedef struct {
   RWLock           queueLock;     // Protects the \c sendQueue
   bool		   bRecvSet;
 
+  // Output buffering, the send thread writes the queued packets.
+  pthread_t        sendThread;    // Writes the queued packets
+  bool             sendRunning;   // Indicates if the send thread runs
+  pthread_mutex_t  sendMutex;     // Protects the send buffers
+  pthread_cond_t   sendCond;      // Signals queued and written data
+  uint8_t*         sendFill;      // Packets queued since the last swap
+  uint32_t         sendFillSize;  // Number of bytes in sendFill
+  uint8_t*         sendOut;       // Packets currently written
+  uint32_t         sendOutSize;   // Number of bytes in sendOut
+  bool             sendFull;      // The high water mark was reported
+  bool             serverPaused;  // The server asked to pause sending
+
   // Used to allow handling of send and receive from two separate threads.
   sem_t		   sem_transx;
   sem_t		   sem_register;
@@ -198,6 +215,57 @@ inline bool connHandlerUnlock(ClientConnectionHandler* self);
 bool sendPacketToServer(ClientConnectionHandler* self, SRXPROXY_PDU* header,
                         uint32_t length);
 
+/**
+ * Queue one or more complete PDUs into the send buffer. The data is written
+ * to the server by the send thread, the caller never waits for the socket.
+ * Once the queued data exceeds the high water mark the send queue state 
+ * callback of the proxy is called with full = true, once the send thread 
+ * drained it below the low water mark it is called with full = false.
+ * Without send thread the data is send using sendPacketToServer.
+ *
+ * @param self Instance that should be used
+ * @param data The PDUs to be send.
+ * @param length Data size in bytes.
+ *
+ * @return 0 if the data is queued, otherwise the error code. ENOBUFS 
+ *         indicates a full send buffer.
+ *
+ * @since 0.4.1.0
+ */
+int queuePacketToServer(ClientConnectionHandler* self, void* data,
+                        uint32_t length);
+
+/**
+ * Queue one or more complete PDUs into the send buffer. If the send buffer is
+ * full the caller waits until the send thread wrote the queued data. This
+ * allows to send more data than the send buffer can take. Must not be called
+ * by the send thread.
+ *
+ * @param self Instance that should be used
+ * @param data The PDUs to be send.
+ * @param length Data size in bytes.
+ *
+ * @return 0 if the data is queued, otherwise the error code.
+ *
+ * @since 0.4.1.0
+ */
+int queuePacketToServerWait(ClientConnectionHandler* self, void* data,
+                            uint32_t length);
+
+/**
+ * Pause or resume writing the send buffer as requested by the server. While
+ * paused the queued packets are kept in the send buffer and the send queue
+ * state callback reports a full buffer, the user should pause submitting
+ * requests. Once resumed the buffer is written and a drained buffer is
+ * reported as usual.
+ *
+ * @param self Instance that should be used
+ * @param pause true to pause, false to resume.
+ *
+ * @since 0.4.1.0
+ */
+void setServerFlowControl(ClientConnectionHandler* self, bool pause);
+
 
 /*
  * Create the connection of application layer between srx and proxy
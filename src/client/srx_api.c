@@ -23,10 +23,47 @@
  * Secure Routing extension (SRx) client API - This API provides a fully
  * functional proxy client to the SRx server.
  *
- * Version: 0.4.0.0
+ * Version: 0.4.1.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added verifyUpdateBatch.
+ *            * Moved the send statistics and error reporting of verifyUpdate 
+ *              into helper functions.
+ *            * Fixed the offset of the bgpsec data in createV6Request.
+ *            * Negotiate CRC-32C based update identifiers in the handshake.
+ *            * Negotiate multi verification notifications in the handshake
+ *              and added processVerifyNotifyMulti.
+ *          - 2026/10/15 - kyehwanl
+ *            * Requests are queued into the send buffer of the connection 
+ *              handler instead of retrying the socket with usleep. Peer 
+ *              changes, delete and sign requests use the same queue to keep
+ *              their order.
+ *            * Added setSendQueueStateCallback.
+ *            * Added setValidationReadyBatchCallback. Validation results are
+ *              collected per call of processPackets and delivered at once.
+ *            * processSignNotify reports the signature data. Added 
+ *              signUpdateBatch.
+ *            * Added the optional result cache (setResultCache). Repeated 
+ *              verify requests of an update with a known result are answered
+ *              without contacting the server, deletes are send once the last
+ *              request of the update is deleted.
+ *            * A server on the same host is connected using the shared memory
+ *              transport if requested, getInternalSocketFD returns the
+ *              descriptor to poll for it.
+ *            * Negotiate bulk verify requests in the handshake.
+ *              verifyUpdateBatch packs consecutive requests sharing the same
+ *              path into one bulk verify request.
+ *            * Negotiate the incremental synchronization in the handshake. If
+ *              the result cache knows all verified updates, a synchronization
+ *              request is answered with the known update IDs and only the
+ *              updates missing at the server are reported to the user
+ *              (setSyncMissingUpdatesCallback).
+ *            * Negotiate the flow control in the handshake. The flow control
+ *              of the server pauses and resumes the send thread.
+ *            * Added connectToSRxShards. The requests are spread over several
+ *              connections by their update ID.
  * 0.4.0.0  - 2016/06/19 - oborchert
  *            * redesigned the BGPSEC data blob and adjusted the code 
  *              accordingly
@@ -74,17 +111,74 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <assert.h>
+#include <pthread.h>
+#include <uthash.h>
 #include "client/srx_api.h"
 #include "client/client_connection_handler.h"
+#include "shared/srx_identifier.h"
 #include "shared/srx_packets.h"
 #include "util/mutex.h"
 #include "util/log.h"
+#include "util/shm_transport.h"
 #include "util/socket.h"
 
 #define HDR "( SRX API): "
 
+/** The maximum size of the buffer verifyUpdateBatch uses to send requests. */
+#define VERIFY_BATCH_SIZE 65536
+
 static ProxyLogger _pLogger = NULL;
 
+/**
+ * A single update known to the result cache of the proxy.
+ *
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** The update ID as generated by the server. */
+  SRxUpdateID    updateID;
+  /** The origin AS of the update. */
+  uint32_t       originAS;
+  /** The prefix of the update. */
+  IPPrefix       prefix;
+  /** The local ID of a request send to the server or 0. */
+  uint32_t       localID;
+  /** The server confirmed the update ID with a receipt for localID. Only 
+   * then the ID can not have been changed by the server due to a collision.*/
+  bool           confirmed;
+  /** The number of verify requests not deleted yet. */
+  uint32_t       refCount;
+  /** The results received so far (SRX_FLAG_ROA / SRX_FLAG_BGPSEC). */
+  uint8_t        valType;
+  /** The last prefix-origin validation result received. */
+  uint8_t        roaResult;
+  /** The last path validation result received. */
+  uint8_t        bgpsecResult;
+  UT_hash_handle hh;
+} ProxyResultEntry;
+
+/**
+ * The result cache of the proxy. 
+ *
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** Protects the entries, verify and notifications run in different 
+   * threads. */
+  pthread_mutex_t   mutex;
+  /** The entries hashed by update ID. */
+  ProxyResultEntry* entries;
+  /** The number of entries. */
+  uint32_t          size;
+  /** The maximum number of entries. */
+  uint32_t          maxSize;
+  /** The number of verify requests answered from the cache. */
+  uint64_t          hits;
+  /** Set if the cache knows all updates verified by the server, only then it
+   * can be used for the incremental synchronization. */
+  bool              complete;
+} ProxyResultCache;
+
 ////////////////////////////////////////////////////////////////////////////////
 // Forward declaration
 ////////////////////////////////////////////////////////////////////////////////
@@ -179,6 +273,18 @@ SRxProxy* createSRxProxy(ValidationReady   validationReadyCallback,
 
   // By default the socket is controlled internally
   proxy->externalSocketControl = false;
+  proxy->requestCRC32CID       = true;
+  proxy->useCRC32CID           = false;
+  proxy->requestMultiNotify    = true;
+  proxy->useMultiNotify        = false;
+  proxy->requestBulkVerify     = true;
+  proxy->useBulkVerify         = false;
+  proxy->requestIncrSync       = true;
+  proxy->useIncrSync           = false;
+  proxy->requestFlowControl    = true;
+  proxy->useFlowControl        = false;
+  proxy->requestShmTransport   = true;
+  proxy->useShmTransport       = false;
 
   // initialize the connection handler
   proxy->connHandler = createClientConnectionHandler(proxy);
@@ -186,6 +292,523 @@ SRxProxy* createSRxProxy(ValidationReady   validationReadyCallback,
   return proxy;
 }
 
+/**
+ * Register the function that is called when the send buffer of the proxy 
+ * passes its high water mark and when it is drained again.
+ *
+ * @param proxy The proxy instance
+ * @param callback The function or NULL to deactivate it.
+ *
+ * @since 0.4.1.0
+ */
+void setSendQueueStateCallback(SRxProxy* proxy, SendQueueState callback)
+{
+  proxy->sendQueueState = callback;
+}
+
+/**
+ * Register the function that receives the missing updates of an incremental
+ * synchronization.
+ *
+ * @param proxy The proxy instance
+ * @param callback The function or NULL to always use the synchronization
+ *                 callback.
+ *
+ * @since 0.4.1.0
+ */
+void setSyncMissingUpdatesCallback(SRxProxy* proxy,
+                                   SyncMissingUpdates callback)
+{
+  proxy->syncMissing = callback;
+}
+
+/**
+ * Deliver the collected validation results to the batch callback.
+ *
+ * @param proxy The proxy instance
+ *
+ * @since 0.4.1.0
+ */
+static void _flushResultBatch(SRxProxy* proxy)
+{
+  uint32_t noResults = proxy->resBatchSize;
+
+  if ((noResults > 0) && (proxy->resBatchCallback != NULL))
+  {
+    // Reset first, the callback might call back into the API.
+    proxy->resBatchSize = 0;
+    proxy->resBatchCallback(noResults, proxy->resBatch, proxy->userPtr);
+  }
+}
+
+/**
+ * Register the function that receives the validation results in batches 
+ * instead of one call of the validation ready callback per result.
+ *
+ * @param proxy The proxy instance
+ * @param callback The function or NULL to use the validation ready callback.
+ *
+ * @return false if the batch could not be allocated.
+ *
+ * @since 0.4.1.0
+ */
+bool setValidationReadyBatchCallback(SRxProxy* proxy, 
+                                     ValidationReadyBatch callback)
+{
+  // Results collected for the old callback go there.
+  _flushResultBatch(proxy);
+
+  if ((callback != NULL) && (proxy->resBatch == NULL))
+  {
+    proxy->resBatch = malloc(SRX_RESULT_BATCH_SIZE 
+                             * sizeof(SRxProxyResult));
+    if (proxy->resBatch == NULL)
+    {
+      RAISE_SYS_ERROR("Not enough memory for the validation result batch!");
+      return false;
+    }
+  }
+  proxy->resBatchCallback = callback;
+  proxy->resBatchSize     = 0;
+
+  return true;
+}
+
+/**
+ * Generate the update ID of the given update the same way the server does.
+ * The server ignores the path data of IPv6 requests.
+ *
+ * @param proxy The proxy instance
+ * @param prefix The prefix of the update.
+ * @param as32 The origin AS of the update.
+ * @param bgpsec The path data of the update or NULL.
+ *
+ * @return The update ID.
+ *
+ * @since 0.4.1.0
+ */
+static SRxUpdateID _generateUpdateID(SRxProxy* proxy, IPPrefix* prefix,
+                                     uint32_t as32, BGPSecData* bgpsec)
+{
+  BGPSecData idData;
+
+  memset(&idData, 0, sizeof(BGPSecData));
+  if ((bgpsec != NULL) && (prefix->ip.version == 4))
+  {
+    idData.numberHops       = bgpsec->numberHops;
+    idData.attr_length      = bgpsec->attr_length;
+    idData.asPath           = bgpsec->numberHops != 0 ? bgpsec->asPath : NULL;
+    idData.bgpsec_path_attr = bgpsec->attr_length != 0
+                              ? bgpsec->bgpsec_path_attr : NULL;
+  }
+  return proxy->useCRC32CID
+         ? generateIdentifierCRC32C(as32, prefix, &idData)
+         : generateIdentifier(as32, prefix, &idData);
+}
+
+/**
+ * Return the index of the connection that serves the given update. The
+ * server resolves an ID collision by incrementing the ID, the low bits are
+ * left out so such an update mostly stays with the same connection.
+ *
+ * @param proxy The proxy instance with more than one connection.
+ * @param updateID The update ID.
+ *
+ * @return The index within the shards of the proxy.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t _getShardIndex(SRxProxy* proxy, SRxUpdateID updateID)
+{
+  return (((updateID >> 8) * 2654435761u) >> 16) % proxy->noShards;
+}
+
+/**
+ * Return the proxy of the connection that serves the given update.
+ *
+ * @param proxy The proxy instance
+ * @param updateID The update ID.
+ *
+ * @return The proxy of the connection, the proxy itself if it uses a single
+ *         connection.
+ *
+ * @since 0.4.1.0
+ */
+static SRxProxy* _getShard(SRxProxy* proxy, SRxUpdateID updateID)
+{
+  return proxy->noShards > 1
+         ? (SRxProxy*)proxy->shards[_getShardIndex(proxy, updateID)]
+         : proxy;
+}
+
+/**
+ * Remove all entries from the result cache.
+ *
+ * @param cache The result cache.
+ *
+ * @since 0.4.1.0
+ */
+static void _clearResultCache(ProxyResultCache* cache)
+{
+  ProxyResultEntry* entry;
+  ProxyResultEntry* tmp;
+
+  HASH_ITER(hh, cache->entries, entry, tmp)
+  {
+    HASH_DEL(cache->entries, entry);
+    free(entry);
+  }
+  cache->size = 0;
+}
+
+/**
+ * Enable the result cache of the proxy. The proxy generates the update ID of
+ * each verify request the same way the server does. Once the server reported
+ * the result of an update, further verify requests for the same update are 
+ * answered by the proxy without contacting the server. The results answered
+ * from the cache are reported from within verifyUpdate and verifyUpdateBatch.
+ * Delete requests are only send once all verify requests of the update are
+ * deleted.
+ *
+ * @param proxy The proxy instance
+ * @param maxEntries The maximum number of updates kept, 0 disables the cache.
+ *
+ * @return false if the cache could not be created.
+ *
+ * @since 0.4.1.0
+ */
+bool setResultCache(SRxProxy* proxy, uint32_t maxEntries)
+{
+  ProxyResultCache* cache = (ProxyResultCache*)proxy->resultCache;
+
+  if (maxEntries == 0)
+  {
+    if (cache != NULL)
+    {
+      proxy->resultCache = NULL;
+      _clearResultCache(cache);
+      pthread_mutex_destroy(&cache->mutex);
+      free(cache);
+    }
+    return true;
+  }
+
+  if (cache == NULL)
+  {
+    cache = malloc(sizeof(ProxyResultCache));
+    if (cache == NULL)
+    {
+      RAISE_SYS_ERROR("Not enough memory for the result cache!");
+      return false;
+    }
+    memset(cache, 0, sizeof(ProxyResultCache));
+    pthread_mutex_init(&cache->mutex, NULL);
+    // Updates verified before are not known to the cache.
+    cache->complete = !isConnected(proxy);
+    proxy->resultCache = cache;
+  }
+  cache->maxSize = maxEntries;
+
+  return true;
+}
+
+/**
+ * Return the number of verify requests answered by the result cache.
+ *
+ * @param proxy The proxy instance
+ *
+ * @return The number of requests.
+ *
+ * @since 0.4.1.0
+ */
+uint64_t getResultCacheHits(SRxProxy* proxy)
+{
+  ProxyResultCache* cache = (ProxyResultCache*)proxy->resultCache;
+  uint64_t          hits  = cache != NULL ? cache->hits : 0;
+  uint32_t          idx;
+
+  // The first connection is the proxy itself.
+  for (idx = 1; idx < proxy->noShards; idx++)
+  {
+    hits += getResultCacheHits((SRxProxy*)proxy->shards[idx]);
+  }
+
+  return hits;
+}
+
+/**
+ * Drop all results known to the result cache, e.g. once the connection to
+ * the server is lost.
+ *
+ * @param proxy The proxy instance
+ * @param complete Set if all updates will be verified again, otherwise the
+ *                 cache can not be used for the incremental synchronization.
+ *
+ * @since 0.4.1.0
+ */
+static void _resetResultCache(SRxProxy* proxy, bool complete)
+{
+  ProxyResultCache* cache = (ProxyResultCache*)proxy->resultCache;
+
+  if (cache != NULL)
+  {
+    pthread_mutex_lock(&cache->mutex);
+    _clearResultCache(cache);
+    cache->complete = complete;
+    pthread_mutex_unlock(&cache->mutex);
+  }
+}
+
+/**
+ * Store the result received from the server in the result cache if the 
+ * update is known to it.
+ *
+ * @param proxy The proxy instance
+ * @param updateID The update ID.
+ * @param localID The local ID of a receipt or 0.
+ * @param valType The validation results provided.
+ * @param roaResult The prefix-origin validation result.
+ * @param bgpsecResult The path validation result.
+ *
+ * @since 0.4.1.0
+ */
+static void _storeCachedResult(SRxProxy* proxy, SRxUpdateID updateID, 
+                               uint32_t localID, ValidationResultType valType,
+                               uint8_t roaResult, uint8_t bgpsecResult)
+{
+  ProxyResultCache* cache = (ProxyResultCache*)proxy->resultCache;
+  ProxyResultEntry* entry;
+
+  if (cache == NULL)
+  {
+    return;
+  }
+  pthread_mutex_lock(&cache->mutex);
+  HASH_FIND(hh, cache->entries, &updateID, sizeof(SRxUpdateID), entry);
+  if (entry != NULL)
+  {
+    if ((localID != 0) && (localID == entry->localID))
+    {
+      entry->confirmed = true;
+    }
+    if (valType & SRX_FLAG_ROA)
+    {
+      entry->roaResult = roaResult;
+    }
+    if (valType & SRX_FLAG_BGPSEC)
+    {
+      entry->bgpsecResult = bgpsecResult;
+    }
+    entry->valType |= valType;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+/**
+ * Look up the update of a verify request in the result cache. In case the
+ * requested results are known they are reported right away. Otherwise the 
+ * update is added and the request has to be send to the server.
+ *
+ * @param proxy The proxy instance
+ * @param localID The local ID of the request.
+ * @param method The requested validation (SRX_FLAG_ROA / SRX_FLAG_BGPSEC).
+ * @param defaultResult The default result of the request.
+ * @param prefix The prefix of the update.
+ * @param as32 The origin AS of the update.
+ * @param bgpsec The path data of the update or NULL.
+ *
+ * @return true if the request was answered from the cache.
+ *
+ * @since 0.4.1.0
+ */
+static bool _answerFromResultCache(SRxProxy* proxy, uint32_t localID,
+                                   uint8_t method, 
+                                   SRxDefaultResult* defaultResult,
+                                   IPPrefix* prefix, uint32_t as32, 
+                                   BGPSecData* bgpsec)
+{
+  ProxyResultCache* cache = (ProxyResultCache*)proxy->resultCache;
+  ProxyResultEntry* entry;
+  SRxUpdateID       updateID;
+  SRxProxyResult    result;
+  bool              answered = false;
+  bool              notify   = false;
+
+  if ((cache == NULL) || ((method & SRX_FLAG_ROA_AND_BGPSEC) == 0))
+  {
+    return false;
+  }
+
+  // Generate the ID from the same data the server uses
+  updateID = _generateUpdateID(proxy, prefix, as32, bgpsec);
+
+  pthread_mutex_lock(&cache->mutex);
+  HASH_FIND(hh, cache->entries, &updateID, sizeof(SRxUpdateID), entry);
+  if (entry != NULL)
+  {
+    // A different update with the same ID got a collision free ID from the
+    // server, it can not be answered here.
+    if (   (entry->originAS != as32) 
+        || (memcmp(&entry->prefix, prefix, sizeof(IPPrefix)) != 0))
+    {
+      cache->complete = false;
+      pthread_mutex_unlock(&cache->mutex);
+      return false;
+    }
+    entry->refCount++;
+    if (!entry->confirmed && (entry->localID == 0))
+    {
+      // The receipt of this request confirms the ID.
+      entry->localID = localID;
+    }
+    if (   entry->confirmed
+        && (   (entry->valType & method & SRX_FLAG_ROA_AND_BGPSEC) 
+            == (method & SRX_FLAG_ROA_AND_BGPSEC)))
+    {
+      answered = true;
+      cache->hits++;
+      result.updateID     = updateID;
+      result.localID      = localID;
+      result.valType      = method & SRX_FLAG_ROA_AND_BGPSEC;
+      result.roaResult    = (method & SRX_FLAG_ROA) ? entry->roaResult
+                                                    : SRx_RESULT_UNDEFINED;
+      result.bgpsecResult = (method & SRX_FLAG_BGPSEC) ? entry->bgpsecResult
+                                                       : SRx_RESULT_UNDEFINED;
+      // The server notifies only if a receipt is requested or the result 
+      // differs from the default result.
+      notify =    (localID != 0)
+               || (   (method & SRX_FLAG_ROA) 
+                   && (result.roaResult != defaultResult->result.roaResult))
+               || (   (method & SRX_FLAG_BGPSEC)
+                   && (   result.bgpsecResult 
+                       != defaultResult->result.bgpsecResult));
+    }
+  }
+  else if (cache->size < cache->maxSize)
+  {
+    entry = malloc(sizeof(ProxyResultEntry));
+    if (entry != NULL)
+    {
+      memset(entry, 0, sizeof(ProxyResultEntry));
+      entry->updateID = updateID;
+      entry->originAS = as32;
+      entry->prefix   = *prefix;
+      entry->localID  = localID;
+      entry->refCount = 1;
+      HASH_ADD(hh, cache->entries, updateID, sizeof(SRxUpdateID), entry);
+      cache->size++;
+    }
+    else
+    {
+      cache->complete = false;
+    }
+  }
+  else
+  {
+    // The update is verified without being known to the cache.
+    cache->complete = false;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+
+  if (notify)
+  {
+    if (proxy->resBatchCallback != NULL)
+    {
+      proxy->resBatchCallback(1, &result, proxy->userPtr);
+    }
+    else if (proxy->resCallback != NULL)
+    {
+      proxy->resCallback(result.updateID, result.localID, result.valType,
+                         result.roaResult, result.bgpsecResult, 
+                         proxy->userPtr);
+    }
+  }
+
+  return answered;
+}
+
+/**
+ * Release one verify request of the given update from the result cache.
+ *
+ * @param proxy The proxy instance
+ * @param updateID The update ID.
+ *
+ * @return false if other verify requests of the update are still active and
+ *         the delete must not be send to the server.
+ *
+ * @since 0.4.1.0
+ */
+static bool _releaseCachedUpdate(SRxProxy* proxy, SRxUpdateID updateID)
+{
+  ProxyResultCache* cache = (ProxyResultCache*)proxy->resultCache;
+  ProxyResultEntry* entry;
+  bool              doDelete = true;
+
+  if (cache == NULL)
+  {
+    return true;
+  }
+  pthread_mutex_lock(&cache->mutex);
+  HASH_FIND(hh, cache->entries, &updateID, sizeof(SRxUpdateID), entry);
+  if (entry != NULL)
+  {
+    if (entry->refCount > 1)
+    {
+      entry->refCount--;
+      doDelete = false;
+    }
+    else
+    {
+      HASH_DEL(cache->entries, entry);
+      cache->size--;
+      free(entry);
+    }
+  }
+  pthread_mutex_unlock(&cache->mutex);
+
+  return doDelete;
+}
+
+/**
+ * Deliver the validation result either to the batch or to the validation 
+ * ready callback.
+ *
+ * @param proxy The proxy instance
+ * @param updateID The update ID.
+ * @param localID The local ID or 0.
+ * @param valType The validation results provided.
+ * @param roaResult The prefix-origin validation result.
+ * @param bgpsecResult The path validation result.
+ *
+ * @since 0.4.1.0
+ */
+static void _deliverResult(SRxProxy* proxy, SRxUpdateID updateID, 
+                           uint32_t localID, ValidationResultType valType,
+                           uint8_t roaResult, uint8_t bgpsecResult)
+{
+  SRxProxyResult* result;
+
+  _storeCachedResult(proxy, updateID, localID, valType, roaResult, 
+                     bgpsecResult);
+  if (proxy->resBatchCallback == NULL)
+  {
+    proxy->resCallback(updateID, localID, valType, roaResult, bgpsecResult,
+                       proxy->userPtr);
+    return;
+  }
+
+  result = &proxy->resBatch[proxy->resBatchSize++];
+  result->updateID     = updateID;
+  result->localID      = localID;
+  result->valType      = valType;
+  result->roaResult    = roaResult;
+  result->bgpsecResult = bgpsecResult;
+  if (proxy->resBatchSize == SRX_RESULT_BATCH_SIZE)
+  {
+    _flushResultBatch(proxy);
+  }
+}
+
 /**
  * Disconnect proxy SRx server if necessary and frees up the memory again.
  *
@@ -197,6 +820,8 @@ void releaseSRxProxy(SRxProxy* proxy)
   {
     disconnectFromSRx(proxy, SRX_DEFAULT_KEEP_WINDOW);
     releaseSList(&proxy->peerAS);
+    free(proxy->resBatch);
+    setResultCache(proxy, 0);
     free(proxy->connHandler);
     free(proxy);
   }
@@ -218,6 +843,12 @@ void addPeers(SRxProxy* proxy, uint32_t noPeers, uint32_t* peerAS)
   ClientConnectionHandler* connHandler =
                                    (ClientConnectionHandler*)proxy->connHandler;
 
+  // Each connection announces the peers, the first one is the proxy itself.
+  for (i = 1; i < proxy->noShards; i++)
+  {
+    addPeers((SRxProxy*)proxy->shards[i], noPeers, peerAS);
+  }
+
   //if (connHandler->initialized)
   if (isConnected(proxy))
   {
@@ -242,7 +873,7 @@ void addPeers(SRxProxy* proxy, uint32_t noPeers, uint32_t* peerAS)
     }
 
     // Send peerAS changes to SRx
-    sendData(&connHandler->clSock, &data, dataSize);
+    queuePacketToServer(connHandler, &data, dataSize);
   }
   else
   {
@@ -270,6 +901,12 @@ void removePeers(SRxProxy* proxy, uint32_t noPeers, uint32_t* peerAS)
   ClientConnectionHandler* connHandler =
                                    (ClientConnectionHandler*)proxy->connHandler;
 
+  // Each connection announces the peers, the first one is the proxy itself.
+  for (i = 1; i < proxy->noShards; i++)
+  {
+    removePeers((SRxProxy*)proxy->shards[i], noPeers, peerAS);
+  }
+
   //if (connHandler->initialized)
   if (isConnected(proxy))
   {
@@ -289,7 +926,7 @@ void removePeers(SRxProxy* proxy, uint32_t noPeers, uint32_t* peerAS)
       hdr->peerAS     = htonl(*peerAS);
       // Remove peerAS from list
       deleteFromSList(&proxy->peerAS, peerAS);
-      sendData(&connHandler->clSock, &data, dataSize);
+      queuePacketToServer(connHandler, &data, dataSize);
     }
   }
   else
@@ -313,10 +950,18 @@ void removePeers(SRxProxy* proxy, uint32_t noPeers, uint32_t* peerAS)
  */
 void deleteUpdate(SRxProxy* proxy, uint16_t keep_window, SRxUpdateID updateID)
 {
+  // The update is known to the connection of its ID only.
+  proxy = _getShard(proxy, updateID);
   // The client connection handler
   ClientConnectionHandler* connHandler =
                                    (ClientConnectionHandler*)proxy->connHandler;
 
+  // Other verify requests of the same update are still active.
+  if (!_releaseCachedUpdate(proxy, updateID))
+  {
+    return;
+  }
+
   //if (connHandler->initialized && connHandler->established)
   if (isConnected(proxy))
   {
@@ -330,7 +975,7 @@ void deleteUpdate(SRxProxy* proxy, uint16_t keep_window, SRxUpdateID updateID)
     hdr->length           = htonl(length);
     hdr->updateIdentifier = htonl(updateID);
 
-    sendData(&connHandler->clSock, hdr, length);
+    queuePacketToServer(connHandler, hdr, length);
 
     free(hdr);
   }
@@ -396,6 +1041,7 @@ bool connectToSRx(SRxProxy* proxy, const char* host, int port,
                       " %s:%u is accessible!", proxy->proxyID, host, port);
     return false;
   }
+  proxy->useShmTransport = connHandler->clSock.shmTransport;
 
   if (connHandler->established)
   {
@@ -419,6 +1065,15 @@ bool connectToSRx(SRxProxy* proxy, const char* host, int port,
 
   hdr->type            = PDU_SRXPROXY_HELLO;
   hdr->version         = htons(SRX_PROTOCOL_VER);
+  hdr->flags           = (proxy->requestCRC32CID ? SRX_HELLO_FLAG_CRC32C_ID : 0)
+                         | (proxy->requestMultiNotify 
+                            ? SRX_HELLO_FLAG_MULTI_NOTIFY : 0)
+                         | (proxy->requestBulkVerify
+                            ? SRX_HELLO_FLAG_BULK_VERIFY : 0)
+                         | (proxy->requestIncrSync
+                            ? SRX_HELLO_FLAG_INCR_SYNC : 0)
+                         | (proxy->requestFlowControl
+                            ? SRX_HELLO_FLAG_FLOW_CONTROL : 0);
   hdr->length          = htonl(length);
   hdr->proxyIdentifier = htonl(proxy->proxyID);
   hdr->asn             = htonl(proxy->proxyAS);
@@ -476,6 +1131,170 @@ bool connectToSRx(SRxProxy* proxy, const char* host, int port,
   return connHandler->established;
 }
 
+/**
+ * Create the proxy of an additional connection. It uses the callbacks, the
+ * user pointer, the settings, and the peers of the given proxy.
+ *
+ * @param proxy The proxy instance
+ * @param idx The index of the connection.
+ *
+ * @return The proxy of the connection or NULL.
+ *
+ * @since 0.4.1.0
+ */
+static SRxProxy* _createShard(SRxProxy* proxy, uint32_t idx)
+{
+  ProxyResultCache* cache = (ProxyResultCache*)proxy->resultCache;
+  SRxProxy*         shard = malloc(sizeof(SRxProxy));
+  SListNode*        node;
+  uint32_t*         peerAS;
+
+  if (shard == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for connection %u of the proxy!", idx);
+    return NULL;
+  }
+  memcpy(shard, proxy, sizeof(SRxProxy));
+  shard->proxyID          = proxy->proxyID != 0 ? proxy->proxyID + idx : 0;
+  shard->resBatchCallback = NULL;
+  shard->resBatch         = NULL;
+  shard->resBatchSize     = 0;
+  shard->resultCache      = NULL;
+  shard->shards           = NULL;
+  shard->noShards         = 0;
+  shard->socketConfig.sendErrors   = 0;
+  shard->socketConfig.succsessSend = 0;
+  resetProxyError(shard);
+
+  initSList(&shard->peerAS);
+  for (node = getRootNodeOfSList(&proxy->peerAS); node != NULL;
+       node = node->next)
+  {
+    peerAS  = appendToSList(&shard->peerAS, sizeof(uint32_t));
+    *peerAS = *((uint32_t*)node->data);
+  }
+
+  shard->connHandler = createClientConnectionHandler(shard);
+  if (   (shard->connHandler == NULL)
+      || !setValidationReadyBatchCallback(shard, proxy->resBatchCallback)
+      || ((cache != NULL) && !setResultCache(shard, cache->maxSize)))
+  {
+    releaseSRxProxy(shard);
+    return NULL;
+  }
+
+  return shard;
+}
+
+/**
+ * Disconnect and release the additional connections of the proxy.
+ *
+ * @param proxy The proxy instance
+ * @param keepWindow The keep window requested from the servers.
+ *
+ * @since 0.4.1.0
+ */
+static void _releaseShards(SRxProxy* proxy, uint16_t keepWindow)
+{
+  void**    shards   = proxy->shards;
+  uint32_t  noShards = proxy->noShards;
+  uint32_t  idx;
+
+  proxy->shards   = NULL;
+  proxy->noShards = 0;
+  // The first connection is the proxy itself.
+  for (idx = 1; idx < noShards; idx++)
+  {
+    if (shards[idx] != NULL)
+    {
+      disconnectFromSRx((SRxProxy*)shards[idx], keepWindow);
+      releaseSRxProxy((SRxProxy*)shards[idx]);
+    }
+  }
+  free(shards);
+}
+
+/**
+ * Connect the proxy using several connections, to one SRx server or spread
+ * over a set of servers. Connection i uses server (i % noServers). The
+ * updates are spread over the connections by their update ID.
+ *
+ * @param proxy The proxy instance
+ * @param noShards The number of connections (1 .. SRX_MAX_PROXY_SHARDS)
+ * @param noServers The number of servers.
+ * @param hosts The host names of the servers.
+ * @param ports The ports of the servers.
+ * @param handshakeTimeout The time in seconds before a handshake is timed out.
+ *
+ * @return true if all connections are established, otherwise none is.
+ *
+ * @since 0.4.1.0
+ */
+bool connectToSRxShards(SRxProxy* proxy, uint32_t noShards,
+                        uint32_t noServers, const char** hosts, int* ports,
+                        int handshakeTimeout)
+{
+  SRxProxy* shard;
+  uint32_t  idx;
+  uint32_t  svr;
+  bool      connected = true;
+
+  if ((noShards == 0) || (noShards > SRX_MAX_PROXY_SHARDS) || (noServers == 0))
+  {
+    RAISE_ERROR("Invalid number of connections [%u] or servers [%u]!",
+                noShards, noServers);
+    return false;
+  }
+  if (isConnected(proxy))
+  {
+    LOG(LEVEL_WARNING, "Proxy [ID:%u] is already connected!", proxy->proxyID);
+    return false;
+  }
+  if (!connectToSRx(proxy, hosts[0], ports[0], handshakeTimeout, false))
+  {
+    return false;
+  }
+  if (noShards == 1)
+  {
+    return true;
+  }
+
+  proxy->shards = calloc(noShards, sizeof(void*));
+  if (proxy->shards == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for %u connections!", noShards);
+    disconnectFromSRx(proxy, SRX_DEFAULT_KEEP_WINDOW);
+    return false;
+  }
+  proxy->shards[0] = proxy;
+  proxy->noShards  = noShards;
+
+  for (idx = 1; connected && (idx < noShards); idx++)
+  {
+    svr   = idx % noServers;
+    shard = _createShard(proxy, idx);
+    proxy->shards[idx] = shard;
+    connected =    (shard != NULL)
+                && connectToSRx(shard, hosts[svr], ports[svr],
+                                handshakeTimeout, false);
+    // The updates are spread by the ID the proxy generates.
+    if (connected && (shard->useCRC32CID != proxy->useCRC32CID))
+    {
+      RAISE_ERROR("Server %s:%u and server %s:%u use different update "
+                  "identifiers!", hosts[svr], ports[svr], hosts[0], ports[0]);
+      connected = false;
+    }
+  }
+
+  if (!connected)
+  {
+    // Closes all connections established so far.
+    disconnectFromSRx(proxy, SRX_DEFAULT_KEEP_WINDOW);
+  }
+
+  return connected;
+}
+
 /**
  * Disconnects the proxy from the SRx Server instance on both, application and
  * transport layer.
@@ -495,6 +1314,8 @@ bool disconnectFromSRx(SRxProxy* proxy, uint16_t keepWindow)
   ClientConnectionHandler* connHandler =
                                    (ClientConnectionHandler*)proxy->connHandler;
   // Macro for type casting back to the proxy.
+  _releaseShards(proxy, keepWindow);
+  _resetResultCache(proxy, false);
   if (isConnected(proxy))
   {
     sendGoodbye(connHandler, keepWindow);
@@ -549,8 +1370,16 @@ bool reconnectWithSRx(SRxProxy* proxy)
   ClientConnectionHandler* connHandler =
                                    (ClientConnectionHandler*)proxy->connHandler;
 
+  uint32_t idx;
+
   // reconnect using  reconnectSRX of client_connection_handler
   reConnected = reconnectSRX(connHandler);
+  // The first connection is the proxy itself.
+  for (idx = 1; idx < proxy->noShards; idx++)
+  {
+    reConnected = reconnectWithSRx((SRxProxy*)proxy->shards[idx])
+                  && reConnected;
+  }
 
   if(reConnected)
   {
@@ -588,6 +1417,8 @@ int getInternalSocketFD(SRxProxy* proxy, bool main)
     ClientConnectionHandler* connHandler =
                                    (ClientConnectionHandler*)proxy->connHandler;
     socketFD = main ? connHandler->clSock.clientFD : connHandler->clSock.oldFD;
+    // The data of the shared memory transport does not arrive on the socket.
+    socketFD = getShmTransportPollFD(socketFD);
   }
 
   return socketFD;
@@ -716,7 +1547,7 @@ uint8_t* createV6Request(uint8_t* pdu, SRxVerifyFlag method, uint32_t rToken,
   hdr->bgpsecValReqData.attrLen = htons(attrLength);
   if ((numHops + attrLength) != 0)
   {
-    uint8_t* pduPtr = pdu + sizeof(SRXPROXY_VERIFY_V4_REQUEST);
+    uint8_t* pduPtr = pdu + sizeof(SRXPROXY_VERIFY_V6_REQUEST);
     memcpy(pduPtr, bgpsec->asPath, (numHops*4));
     pduPtr += (numHops*4);
     memcpy(pduPtr, bgpsec->bgpsec_path_attr, attrLength);
@@ -725,6 +1556,74 @@ uint8_t* createV6Request(uint8_t* pdu, SRxVerifyFlag method, uint32_t rToken,
   return pdu;
 }
 
+/**
+ * Maintains the send statistics after a successful send operation.
+ *
+ * @param proxy The proxy instance
+ *
+ * @since 0.4.1.0
+ */
+static void _countSendSuccess(SRxProxy* proxy)
+{
+  if (   proxy->socketConfig.resetSendErrors
+      <= proxy->socketConfig.succsessSend)
+  {
+    // save one extra comparison and just reset every
+    // proxy->socketConfig.resetSendErrors times the error counter.
+    proxy->socketConfig.succsessSend = 0;
+    proxy->socketConfig.sendErrors = 0;
+  }
+  else
+  {
+    proxy->socketConfig.succsessSend++;
+  }
+}
+
+/**
+ * Counts the send error and reports it to the communication management.
+ *
+ * @param proxy The proxy instance
+ * @param connHandler The client connection handler
+ * @param transmissionError The error code of the failed send operation
+ *
+ * @since 0.4.1.0
+ */
+static void _reportSendError(SRxProxy* proxy, 
+                             ClientConnectionHandler* connHandler,
+                             int transmissionError)
+{
+  // Count this send error
+  proxy->socketConfig.sendErrors++;
+  // SEt the consecutive success counter to 0
+  proxy->socketConfig.succsessSend = 0;
+
+  LOG(LEVEL_ERROR, "Failure during sending update request (error=%u)!",
+                    transmissionError);
+
+  if (connHandler->clSock.clientFD == -1)
+  {
+    connHandler->established = false;
+    _resetResultCache(proxy, false);
+    callCMgmtHandler(proxy, COM_ERR_PROXY_CONNECTION_LOST,
+                            COM_PROXY_NO_SUBCODE);
+  }
+  else
+  {
+    if (   proxy->socketConfig.sendErrorThreshold
+        <= proxy->socketConfig.sendErrors)
+    {
+      // Send a special error
+      callCMgmtHandler(proxy, COM_ERR_PROXY_COULD_NOT_SEND, -1);
+      proxy->socketConfig.sendErrors = 0;
+    }
+    else
+    {
+      callCMgmtHandler(proxy, COM_ERR_PROXY_COULD_NOT_SEND, 
+                              transmissionError);
+    }
+  }
+}
+
 /**
  * Verifies the given update data. All parameters except the result parameter
  * are IN parameters, result is an OUT parameter that will be filled within this
@@ -752,6 +1651,11 @@ void verifyUpdate(SRxProxy* proxy, uint32_t localID,
                   IPPrefix* prefix, uint32_t as32,
                   BGPSecData* bgpsec)
 {
+  if (proxy->noShards > 1)
+  {
+    // Each update is served by the connection of its ID.
+    proxy = _getShard(proxy, _generateUpdateID(proxy, prefix, as32, bgpsec));
+  }
   if (!isConnected(proxy))
   {
     RAISE_ERROR(HDR "Abort verify, not connected to SRx server!" ,
@@ -764,6 +1668,13 @@ void verifyUpdate(SRxProxy* proxy, uint32_t localID,
                    | (usePathVal ? SRX_FLAG_BGPSEC : 0)
                    | (localID != 0 ? SRX_FLAG_REQUEST_RECEIPT : 0);
 
+  // A repeated request for an update with a known result is answered here.
+  if (_answerFromResultCache(proxy, localID, method, defaultResult, prefix,
+                             as32, bgpsec))
+  {
+    return;
+  }
+
   bool isV4 = prefix->ip.version == 4;
   // The client connection handler
   ClientConnectionHandler* connHandler =
@@ -773,120 +1684,500 @@ void verifyUpdate(SRxProxy* proxy, uint32_t localID,
   uint16_t bgpsecLength = 0;
   if (bgpsec != NULL)
   {
-    bgpsecLength = (bgpsec->numberHops * 4) + bgpsec->attr_length;
+    bgpsecLength = (bgpsec->numberHops * 4) + bgpsec->attr_length;
+  }
+  uint32_t length = (isV4 ? sizeof(SRXPROXY_VERIFY_V4_REQUEST)
+                          : sizeof(SRXPROXY_VERIFY_V6_REQUEST)) + bgpsecLength;
+  uint8_t  pdu[length];
+  uint32_t requestToken = localID;
+
+  memset(pdu, 0, length);
+
+  // Generate VERIFY PACKET
+  if (isV4)
+  {
+    createV4Request(pdu, method, requestToken, defaultResult, prefix, as32, bgpsec);
+  }
+  else
+  {
+    createV6Request(pdu, method, requestToken, defaultResult, prefix, as32, bgpsec);
+  }
+
+  // Queue the data, the send thread writes it. The caller never waits for the
+  // socket, a full send buffer is reported as ENOBUFS.
+  int transmissionError = queuePacketToServer(connHandler, pdu, length);
+  if (transmissionError == 0)
+  {
+    _countSendSuccess(proxy);
+  }
+  else
+  {
+    _reportSendError(proxy, connHandler, transmissionError);
+  }
+}
+
+/**
+ * Return the length of the verify request PDU for the given request.
+ *
+ * @param request The verification request
+ *
+ * @return The length of the PDU in bytes.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t _getVerifyRequestLength(SRxVerifyRequest* request)
+{
+  uint32_t length = request->prefix->ip.version == 4 
+                    ? sizeof(SRXPROXY_VERIFY_V4_REQUEST)
+                    : sizeof(SRXPROXY_VERIFY_V6_REQUEST);
+  if (request->bgpsec != NULL)
+  {
+    length += (request->bgpsec->numberHops * 4) + request->bgpsec->attr_length;
+  }
+  return length;
+}
+
+/**
+ * Determine if the other request can be send within the same bulk verify
+ * request as the first one. This requires the same prefix type, validation
+ * methods, default results, and path data.
+ *
+ * @param first The first request of the bulk
+ * @param other The request to be added
+ *
+ * @return true if both requests fit into one bulk verify request.
+ *
+ * @since 0.4.1.0
+ */
+static bool _isSameBulk(SRxVerifyRequest* first, SRxVerifyRequest* other)
+{
+  BGPSecData* fData = first->bgpsec;
+  BGPSecData* oData = other->bgpsec;
+
+  if (   (first->prefix->ip.version != other->prefix->ip.version)
+      || (first->usePrefixOriginVal != other->usePrefixOriginVal)
+      || (first->usePathVal != other->usePathVal)
+      || (first->defaultResult->resSourceROA
+          != other->defaultResult->resSourceROA)
+      || (first->defaultResult->resSourceBGPSEC
+          != other->defaultResult->resSourceBGPSEC)
+      || (first->defaultResult->result.roaResult
+          != other->defaultResult->result.roaResult)
+      || (first->defaultResult->result.bgpsecResult
+          != other->defaultResult->result.bgpsecResult))
+  {
+    return false;
+  }
+  // The prefixes of one BGP update normally reference the same path data.
+  if ((fData == oData) || ((fData == NULL) && (oData->numberHops == 0)
+                                           && (oData->attr_length == 0))
+                       || ((oData == NULL) && (fData->numberHops == 0)
+                                           && (fData->attr_length == 0)))
+  {
+    return true;
+  }
+
+  return    (fData != NULL) && (oData != NULL)
+         && (fData->numberHops == oData->numberHops)
+         && (fData->attr_length == oData->attr_length)
+         && (memcmp(fData->asPath, oData->asPath, fData->numberHops * 4) == 0)
+         && (memcmp(fData->bgpsec_path_attr, oData->bgpsec_path_attr,
+                    fData->attr_length) == 0);
+}
+
+/**
+ * Return the number of consecutive requests that can be send within one bulk
+ * verify request, never more than SRX_MAX_BULK_ENTRIES.
+ *
+ * @param requests The requests, the first one starts the bulk
+ * @param noRequests The number of requests
+ *
+ * @return The number of requests for the bulk, at least one.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t _getBulkRunLength(SRxVerifyRequest* requests,
+                                  uint32_t noRequests)
+{
+  uint32_t noRun = 1;
+
+  while (   (noRun < noRequests) && (noRun < SRX_MAX_BULK_ENTRIES)
+         && _isSameBulk(&requests[0], &requests[noRun]))
+  {
+    noRun++;
+  }
+
+  return noRun;
+}
+
+/**
+ * Return the maximum length of the bulk verify request PDU for the given
+ * number of requests.
+ *
+ * @param request The first request of the bulk
+ * @param noEntries The number of requests within the bulk
+ *
+ * @return The length of the PDU in bytes.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t _getBulkRequestLength(SRxVerifyRequest* request,
+                                      uint32_t noEntries)
+{
+  uint32_t length = sizeof(SRXPROXY_VERIFY_BULK_REQUEST)
+                    + (noEntries * (request->prefix->ip.version == 4
+                                    ? sizeof(SRXPROXY_BULK_ENTRY_V4)
+                                    : sizeof(SRXPROXY_BULK_ENTRY_V6)));
+  if (request->bgpsec != NULL)
+  {
+    length += (request->bgpsec->numberHops * 4) + request->bgpsec->attr_length;
+  }
+  return length;
+}
+
+/**
+ * Create a bulk verify request for the given requests. Requests answered by
+ * the result cache are not added. The PDU must be zeroed.
+ *
+ * @param proxy The proxy instance
+ * @param pdu The allocated space for the PDU (see _getBulkRequestLength)
+ * @param requests The requests that fit into one bulk (see _getBulkRunLength)
+ * @param noRequests The number of requests
+ *
+ * @return The length of the PDU or zero if all requests were answered by the
+ *         result cache.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t _createBulkRequest(SRxProxy* proxy, uint8_t* pdu,
+                                   SRxVerifyRequest* requests,
+                                   uint32_t noRequests)
+{
+  SRXPROXY_VERIFY_BULK_REQUEST* hdr = (SRXPROXY_VERIFY_BULK_REQUEST*)pdu;
+  SRxVerifyRequest* request = &requests[0];
+  BGPSecData*       bgpsec  = request->bgpsec;
+  uint16_t numHops   = bgpsec != NULL ? bgpsec->numberHops : 0;
+  uint16_t attrLen   = bgpsec != NULL ? bgpsec->attr_length : 0;
+  uint8_t* entryPtr  = pdu + sizeof(SRXPROXY_VERIFY_BULK_REQUEST)
+                       + (numHops * 4) + attrLen;
+  uint32_t noEntries = 0;
+  uint32_t idx;
+  uint8_t  method    =   (request->usePrefixOriginVal ? SRX_FLAG_ROA : 0)
+                       | (request->usePathVal ? SRX_FLAG_BGPSEC : 0);
+
+  for (idx = 0; idx < noRequests; idx++)
+  {
+    request = &requests[idx];
+    if (_answerFromResultCache(proxy, request->localID,
+                               method | (request->localID != 0
+                                         ? SRX_FLAG_REQUEST_RECEIPT : 0),
+                               request->defaultResult, request->prefix,
+                               request->as32, request->bgpsec))
+    {
+      continue;
+    }
+    if (request->prefix->ip.version == 4)
+    {
+      SRXPROXY_BULK_ENTRY_V4* entry = (SRXPROXY_BULK_ENTRY_V4*)entryPtr;
+      entry->requestToken  = htonl(request->localID);
+      entry->originAS      = htonl(request->as32);
+      entry->prefixAddress = request->prefix->ip.addr.v4;
+      entry->prefixLen     = request->prefix->length;
+      entryPtr += sizeof(SRXPROXY_BULK_ENTRY_V4);
+    }
+    else
+    {
+      SRXPROXY_BULK_ENTRY_V6* entry = (SRXPROXY_BULK_ENTRY_V6*)entryPtr;
+      entry->requestToken  = htonl(request->localID);
+      entry->originAS      = htonl(request->as32);
+      entry->prefixAddress = request->prefix->ip.addr.v6;
+      entry->prefixLen     = request->prefix->length;
+      entryPtr += sizeof(SRXPROXY_BULK_ENTRY_V6);
+    }
+    noEntries++;
+  }
+
+  if (noEntries == 0)
+  {
+    return 0;
+  }
+
+  request = &requests[0];
+  hdr->type         = PDU_SRXPROXY_VERIFY_BULK_REQUEST;
+  hdr->flags        = method;
+  hdr->roaResSrc    = request->defaultResult->resSourceROA;
+  hdr->bgpsecResSrc = request->defaultResult->resSourceBGPSEC;
+  hdr->length       = htonl(entryPtr - pdu);
+  hdr->roaDefRes    = request->defaultResult->result.roaResult;
+  hdr->bgpsecDefRes = request->defaultResult->result.bgpsecResult;
+  hdr->ipVersion    = request->prefix->ip.version;
+  hdr->noEntries    = htonl(noEntries);
+  hdr->numHops      = htons(numHops);
+  hdr->attrLen      = htons(attrLen);
+  if ((numHops + attrLen) != 0)
+  {
+    uint8_t* pduPtr = pdu + sizeof(SRXPROXY_VERIFY_BULK_REQUEST);
+    memcpy(pduPtr, bgpsec->asPath, (numHops * 4));
+    pduPtr += (numHops * 4);
+    memcpy(pduPtr, bgpsec->bgpsec_path_attr, attrLen);
+  }
+
+  return entryPtr - pdu;
+}
+
+/**
+ * Queue the given buffer containing one or more complete PDUs for sending to
+ * the server. The data is written by the send thread of the connection 
+ * handler.
+ *
+ * @param proxy The proxy instance
+ * @param connHandler The client connection handler
+ * @param buffer The buffer containing the PDUs
+ * @param length The number of bytes to be send
+ *
+ * @return true if the data could be queued.
+ *
+ * @since 0.4.1.0
+ */
+static bool _sendVerifyBatch(SRxProxy* proxy, 
+                             ClientConnectionHandler* connHandler,
+                             uint8_t* buffer, uint32_t length)
+{
+  int transmissionError = queuePacketToServer(connHandler, buffer, length);
+
+  if (transmissionError == 0)
+  {
+    _countSendSuccess(proxy);
+    return true;
+  }
+
+  _reportSendError(proxy, connHandler, transmissionError);
+  return false;
+}
+
+/**
+ * Verifies the given updates using the connection of the given proxy only,
+ * see verifyUpdateBatch.
+ *
+ * @param proxy The proxy instance of the connection
+ * @param noRequests The number of requests
+ * @param requests The array of requests
+ *
+ * @return The number of requests that were sent.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t _verifyUpdateBatch(SRxProxy* proxy, uint32_t noRequests,
+                                   SRxVerifyRequest* requests)
+{
+  ClientConnectionHandler* connHandler;
+  SRxVerifyRequest* request;
+  uint8_t*  buffer;
+  uint32_t  bufferSize = 0;
+  uint32_t  used       = 0;
+  uint32_t  length;
+  uint32_t  idx;
+  uint32_t  noSent     = 0;
+  uint32_t  noEncoded  = 0;
+  uint32_t  noRun      = 1;
+  uint8_t   method;
+
+  if (noRequests == 0)
+  {
+    return 0;
   }
-  uint32_t length = (isV4 ? sizeof(SRXPROXY_VERIFY_V4_REQUEST)
-                          : sizeof(SRXPROXY_VERIFY_V6_REQUEST)) + bgpsecLength;
-  uint8_t  pdu[length];
-  uint32_t requestToken = localID;
-
-  memset(pdu, 0, length);
+  if (!isConnected(proxy))
+  {
+    RAISE_ERROR(HDR "Abort verify, not connected to SRx server!" ,
+                pthread_self());
+    return 0;
+  }
+  connHandler = (ClientConnectionHandler*)proxy->connHandler;
 
-  // Generate VERIFY PACKET
-  if (isV4)
+  // Determine the buffer size, never more than VERIFY_BATCH_SIZE unless a 
+  // single request is larger.
+  for (idx = 0; (idx < noRequests) && (bufferSize < VERIFY_BATCH_SIZE); idx++)
   {
-    createV4Request(pdu, method, requestToken, defaultResult, prefix, as32, bgpsec);
+    bufferSize += _getVerifyRequestLength(&requests[idx]);
   }
-  else
+  buffer = malloc(bufferSize);
+  if (buffer == NULL)
   {
-    createV6Request(pdu, method, requestToken, defaultResult, prefix, as32, bgpsec);
+    RAISE_SYS_ERROR("Not enough memory to verify %u updates!", noRequests);
+    return 0;
   }
 
-  // Send Data
-  int maxAttempt = proxy->socketConfig.enablePSC
-                   ? proxy->socketConfig.maxAttempts : 1;
-  int attempt = 0;
-  int transmissionError = 0;
-  do
+  for (idx = 0; idx < noRequests; idx += noRun)
   {
-    attempt++;
-    if(sendPacketToServer(connHandler, (SRXPROXY_PDU*)pdu, length))
+    request = &requests[idx];
+    // Consecutive requests sharing the same path are packed into one bulk
+    // verify request, e.g. the prefixes of one BGP update.
+    noRun   = proxy->useBulkVerify
+              ? _getBulkRunLength(request, noRequests - idx) : 1;
+    length  = noRun > 1 ? _getBulkRequestLength(request, noRun)
+                        : _getVerifyRequestLength(request);
+    method  =   (request->usePrefixOriginVal ? SRX_FLAG_ROA : 0)
+              | (request->usePathVal ? SRX_FLAG_BGPSEC : 0)
+              | (request->localID != 0 ? SRX_FLAG_REQUEST_RECEIPT : 0);
+
+    if ((noRun == 1)
+        && _answerFromResultCache(proxy, request->localID, method,
+                                  request->defaultResult, request->prefix,
+                                  request->as32, request->bgpsec))
     {
-      // Leave the loop
-      if (   proxy->socketConfig.resetSendErrors
-          <= proxy->socketConfig.succsessSend)
+      // Counts as send once the requests encoded before are send.
+      noEncoded++;
+      continue;
+    }
+
+    if ((used + length) > bufferSize)
+    {
+      // Flush the encoded requests first
+      if ((used > 0) && !_sendVerifyBatch(proxy, connHandler, buffer, used))
       {
-        // save one extra comparison and just reset every
-        // proxy->socketConfig.resetSendErrors times the error counter.
-        proxy->socketConfig.succsessSend = 0;
-        proxy->socketConfig.sendErrors = 0;
+        break;
       }
-      else
+      noSent += noEncoded;
+      noEncoded = 0;
+      used      = 0;
+      if (length > bufferSize)
       {
-        proxy->socketConfig.succsessSend++;
+        uint8_t* newBuffer = realloc(buffer, length);
+        if (newBuffer == NULL)
+        {
+          RAISE_SYS_ERROR("Not enough memory to verify the update!");
+          break;
+        }
+        buffer     = newBuffer;
+        bufferSize = length;
       }
-      break;
+    }
+
+    memset(buffer + used, 0, length);
+    if (noRun > 1)
+    {
+      // Requests answered by the result cache are not part of the bulk.
+      used      += _createBulkRequest(proxy, buffer + used, request, noRun);
+      noEncoded += noRun;
+      continue;
+    }
+    if (request->prefix->ip.version == 4)
+    {
+      createV4Request(buffer + used, method, request->localID, 
+                      request->defaultResult, request->prefix, request->as32, 
+                      request->bgpsec);
     }
     else
     {
-      transmissionError = getLastSendError();
-      if (transmissionError == EAGAIN)
-      {
-        if (attempt < maxAttempt)
-        {
-          // Brut force sleep!!!
-          usleep(proxy->socketConfig.maxSleepMillis / 1000);
-          // reset transmission error for next turn
-          transmissionError = 0;
-        }
-      }
+      createV6Request(buffer + used, method, request->localID, 
+                      request->defaultResult, request->prefix, request->as32, 
+                      request->bgpsec);
     }
-  } while (transmissionError == 0);
+    used += length;
+    noEncoded++;
+  }
 
-  if (attempt > 1)
+  // Send the remaining requests
+  if ((idx == noRequests)
+      && ((used == 0) || _sendVerifyBatch(proxy, connHandler, buffer, used)))
   {
-    // note that this send included multiple attempts
-    proxy->socketConfig.totalCountOfMultipleAttempts++;
+    noSent += noEncoded;
   }
 
-//  if (!sendPacketToServer(connHandler, (SRXPROXY_PDU*)pdu, length))
-  if (transmissionError != 0)
-  {
-    // Count this send error
-    proxy->socketConfig.sendErrors++;
-    // SEt the consecutive success counter to 0
-    proxy->socketConfig.succsessSend = 0;
+  free(buffer);
+
+  return noSent;
+}
 
-    LOG(LEVEL_ERROR, "Failure during sending update request (error=%u)!",
-                      transmissionError);
+/**
+ * Verifies the given updates over the connections of the proxy. The requests
+ * of each connection keep their order.
+ *
+ * @param proxy The proxy instance with more than one connection.
+ * @param noRequests The number of requests
+ * @param requests The array of requests
+ *
+ * @return The number of requests that were sent.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t _verifyShardedBatch(SRxProxy* proxy, uint32_t noRequests,
+                                    SRxVerifyRequest* requests)
+{
+  SRxVerifyRequest* shardRequests;
+  SRxVerifyRequest* request;
+  uint8_t*          shardIdx;
+  uint32_t          idx;
+  uint32_t          shard;
+  uint32_t          noShardRequests;
+  uint32_t          noSent = 0;
+
+  shardRequests = malloc(noRequests * sizeof(SRxVerifyRequest));
+  shardIdx      = malloc(noRequests);
+  if ((shardRequests == NULL) || (shardIdx == NULL))
+  {
+    RAISE_SYS_ERROR("Not enough memory to verify %u updates!", noRequests);
+    free(shardRequests);
+    free(shardIdx);
+    return 0;
+  }
 
-    if (connHandler->clSock.clientFD == -1)
+  for (idx = 0; idx < noRequests; idx++)
+  {
+    request       = &requests[idx];
+    shardIdx[idx] = _getShardIndex(proxy,
+                                   _generateUpdateID(proxy, request->prefix,
+                                                     request->as32,
+                                                     request->bgpsec));
+  }
+  for (shard = 0; shard < proxy->noShards; shard++)
+  {
+    noShardRequests = 0;
+    for (idx = 0; idx < noRequests; idx++)
     {
-      if (proxy->connHandler != NULL)
+      if (shardIdx[idx] == shard)
       {
-        ClientConnectionHandler* hdl=
-                                   (ClientConnectionHandler*)proxy->connHandler;
-        hdl->established = false;
+        shardRequests[noShardRequests++] = requests[idx];
       }
-      callCMgmtHandler(proxy, COM_ERR_PROXY_CONNECTION_LOST,
-                              COM_PROXY_NO_SUBCODE);
     }
-    else
+    if (noShardRequests > 0)
     {
-      if (   proxy->socketConfig.sendErrorThreshold
-          <= proxy->socketConfig.sendErrors)
-      {
-        // Send a special error
-        callCMgmtHandler(proxy, COM_ERR_PROXY_COULD_NOT_SEND, -1);
-        proxy->socketConfig.sendErrors = 0;
-      }
-      else
-      {
-        callCMgmtHandler(proxy, COM_ERR_PROXY_COULD_NOT_SEND, 
-                                transmissionError);
-      }
+      noSent += _verifyUpdateBatch((SRxProxy*)proxy->shards[shard],
+                                   noShardRequests, shardRequests);
     }
+  }
+  free(shardRequests);
+  free(shardIdx);
 
-    // Store into send queue for re-transmit later
-    // TODO: Send queue might not be used anymore.
-    void* dataCopy;
-    dataCopy = appendToSList(&connHandler->sendQueue, (size_t)length);
-    if (dataCopy == NULL)
-    {
-      RAISE_ERROR("ERROR, could not store update in send Queue for delayed "
-                  "sending!");
-    }
+  return noSent;
+}
+
+/**
+ * Verifies the given updates. All requests are encoded into one contiguous
+ * buffer and send using as few send operations as possible. This is the
+ * preferred method to verify a large number of updates, e.g. during the initial
+ * table transfer of a peering session. If the server supports it, consecutive
+ * requests with the same validation methods, default results, and path data
+ * are send as one bulk verify request.
+ *
+ * @param proxy The proxy instance
+ * @param noRequests The number of requests
+ * @param requests The array of requests
+ *
+ * @return The number of requests that were sent. A value less than noRequests
+ *         indicates a send error which was reported through the communication
+ *         management callback.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t verifyUpdateBatch(SRxProxy* proxy, uint32_t noRequests,
+                           SRxVerifyRequest* requests)
+{
+  if ((proxy->noShards > 1) && (noRequests > 0))
+  {
+    return _verifyShardedBatch(proxy, noRequests, requests);
   }
+  return _verifyUpdateBatch(proxy, noRequests, requests);
 }
 
 /**
@@ -910,6 +2201,9 @@ bool signUpdate(SRxProxy* proxy, SRxUpdateID updateId, bool onlyOwnSignature,
 {
   bool retVal = true;
 
+  // The update is known to the connection of its ID only.
+  proxy = _getShard(proxy, updateId);
+
   uint32_t length = sizeof(SRXPROXY_SIGN_REQUEST);
   uint8_t pdu[length];
   SRXPROXY_SIGN_REQUEST* hdr = (SRXPROXY_SIGN_REQUEST*)pdu;
@@ -924,7 +2218,7 @@ bool signUpdate(SRxProxy* proxy, SRxUpdateID updateId, bool onlyOwnSignature,
   hdr->prependCounter   = htonl(prependCounter);
   hdr->peerAS           = htonl(peerAS);
 
-  if (!sendPacketToServer(proxy->connHandler, (SRXPROXY_PDU*)pdu, length))
+  if (queuePacketToServer(proxy->connHandler, pdu, length) != 0)
   {
     RAISE_ERROR("Failure during sending signature request for update "
                 "[ID:0x%08X]!", updateId);
@@ -934,6 +2228,123 @@ bool signUpdate(SRxProxy* proxy, SRxUpdateID updateId, bool onlyOwnSignature,
   return retVal;
 }
 
+/**
+ * Request the signatures of the given updates using the connection of the
+ * given proxy only, see signUpdateBatch.
+ *
+ * @param proxy Pointer to the proxy instance of the connection
+ * @param noRequests The number of requests
+ * @param requests The array of requests
+ *
+ * @return The number of requests that were sent, either 0 or noRequests.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t _signUpdateBatch(SRxProxy* proxy, uint32_t noRequests,
+                                 SRxSignRequest* requests)
+{
+  uint32_t               length = noRequests * sizeof(SRXPROXY_SIGN_REQUEST);
+  uint8_t*               buffer;
+  SRXPROXY_SIGN_REQUEST* hdr;
+  uint32_t               idx;
+  uint32_t               noSent = 0;
+
+  if (noRequests == 0)
+  {
+    return 0;
+  }
+  if (!isConnected(proxy))
+  {
+    RAISE_ERROR(HDR "Abort signing, not connected to SRx server!");
+    return 0;
+  }
+  buffer = calloc(noRequests, sizeof(SRXPROXY_SIGN_REQUEST));
+  if (buffer == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory to sign %u updates!", noRequests);
+    return 0;
+  }
+
+  for (idx = 0; idx < noRequests; idx++)
+  {
+    hdr = (SRXPROXY_SIGN_REQUEST*)(buffer 
+                                   + idx * sizeof(SRXPROXY_SIGN_REQUEST));
+    hdr->type             = PDU_SRXPROXY_SIGN_REQUEST;
+    hdr->algorithm        = htons(requests[idx].algorithm);
+    hdr->blockType        = requests[idx].onlyOwnSignature 
+                            ? SRX_PROXY_BLOCK_TYPE_LATEST_SIGNATURE : 0;
+    hdr->length           = htonl(sizeof(SRXPROXY_SIGN_REQUEST));
+    hdr->updateIdentifier = htonl(requests[idx].updateId);
+    hdr->prependCounter   = htonl(requests[idx].prependCounter);
+    hdr->peerAS           = htonl(requests[idx].peerAS);
+  }
+
+  if (_sendVerifyBatch(proxy, (ClientConnectionHandler*)proxy->connHandler,
+                       buffer, length))
+  {
+    noSent = noRequests;
+  }
+  free(buffer);
+
+  return noSent;
+}
+
+/**
+ * Request the signatures of the given updates. All requests are encoded into
+ * one buffer and send at once, the server signs requests of the same update
+ * together. The signatures are returned using the signature notification
+ * callback.
+ *
+ * @param proxy Pointer to the proxy instance
+ * @param noRequests The number of requests
+ * @param requests The array of requests
+ *
+ * @return The number of requests that were sent, either 0 or noRequests.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t signUpdateBatch(SRxProxy* proxy, uint32_t noRequests,
+                         SRxSignRequest* requests)
+{
+  SRxSignRequest* shardRequests;
+  uint32_t        idx;
+  uint32_t        shard;
+  uint32_t        noShardRequests;
+  uint32_t        noSent = 0;
+
+  if ((proxy->noShards <= 1) || (noRequests == 0))
+  {
+    return _signUpdateBatch(proxy, noRequests, requests);
+  }
+
+  // Each request goes to the connection of its update.
+  shardRequests = malloc(noRequests * sizeof(SRxSignRequest));
+  if (shardRequests == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory to sign %u updates!", noRequests);
+    return 0;
+  }
+  for (shard = 0; shard < proxy->noShards; shard++)
+  {
+    noShardRequests = 0;
+    for (idx = 0; idx < noRequests; idx++)
+    {
+      if (_getShardIndex(proxy, requests[idx].updateId) == shard)
+      {
+        shardRequests[noShardRequests++] = requests[idx];
+      }
+    }
+    if (noShardRequests > 0)
+    {
+      noSent += _signUpdateBatch((SRxProxy*)proxy->shards[shard],
+                                 noShardRequests, shardRequests);
+    }
+  }
+  free(shardRequests);
+
+  return noSent;
+}
+
 /**
  * Set the API Proxy logger.
  *
@@ -1007,6 +2418,14 @@ void processHelloResponse(SRXPROXY_HELLO_RESPONSE* hdr, SRxProxy* proxy)
 
   if (ntohs(hdr->version) == SRX_PROTOCOL_VER)
   {
+    // Servers that do not know the flag respond with zero - legacy IDs
+    proxy->useCRC32CID = (hdr->flags & SRX_HELLO_FLAG_CRC32C_ID) != 0;
+    proxy->useMultiNotify = (hdr->flags & SRX_HELLO_FLAG_MULTI_NOTIFY) != 0;
+    proxy->useBulkVerify  = (hdr->flags & SRX_HELLO_FLAG_BULK_VERIFY) != 0;
+    proxy->useIncrSync    = (hdr->flags & SRX_HELLO_FLAG_INCR_SYNC) != 0;
+    proxy->useFlowControl = (hdr->flags & SRX_HELLO_FLAG_FLOW_CONTROL) != 0;
+    // A new session starts unpaused.
+    setServerFlowControl(connHandler, false);
     connHandler->established = true;
   }
   else
@@ -1028,6 +2447,7 @@ void processGoodbye(SRXPROXY_GOODBYE* hdr, SRxProxy* proxy)
   ClientConnectionHandler* connHandler =
                                    (ClientConnectionHandler*)proxy->connHandler;
   LOG(LEVEL_DEBUG, HDR "Received Goodbye", pthread_self());
+  _resetResultCache(proxy, false);
   // SERVER CLOSES THE CONNECTION. END EVERYTHING.
   connHandler->established = false;
   connHandler->stop = true;
@@ -1055,7 +2475,7 @@ static int ct = 0;
  */
 void processVerifyNotify(SRXPROXY_VERIFY_NOTIFICATION* hdr, SRxProxy* proxy)
 {
-  if (proxy->resCallback != NULL)
+  if ((proxy->resCallback != NULL) || (proxy->resBatchCallback != NULL))
   {
     bool hasReceipt = (hdr->resultType & SRX_FLAG_REQUEST_RECEIPT)
                       == SRX_FLAG_REQUEST_RECEIPT;
@@ -1090,8 +2510,8 @@ void processVerifyNotify(SRXPROXY_VERIFY_NOTIFICATION* hdr, SRxProxy* proxy)
     ValidationResultType valType = hdr->resultType & SRX_FLAG_ROA_AND_BGPSEC;
 
     // hasReceipt ? localID : 0 is result of BZ263
-    proxy->resCallback(updateID, localID, valType, roaResult, bgpsecResult,
-                       proxy->userPtr);
+    _deliverResult(proxy, updateID, localID, valType, roaResult, 
+                   bgpsecResult);
   }
   else
   {
@@ -1101,24 +2521,85 @@ void processVerifyNotify(SRXPROXY_VERIFY_NOTIFICATION* hdr, SRxProxy* proxy)
 }
 
 /**
- * Process signature notification.
- * NOT IMPLEMENTED YET
+ * The SRx server send a multi verification notification. This method calls the
+ * proxy callback for each notification. The notifications do not carry a 
+ * receipt.
+ *
+ * @param hdr The "Multi Verify Notification" Header
+ * @param proxy The instance of the connection handler.
+ *
+ * @since 0.4.1.0
+ */
+void processVerifyNotifyMulti(SRXPROXY_VERIFY_NOTIFICATION_MULTI* hdr, 
+                              SRxProxy* proxy)
+{
+  SRXPROXY_NOTIFICATION_ENTRY* entry = hdr->notification;
+  uint32_t length  = ntohl(hdr->length);
+  uint32_t noNotifications  = 0;
+  uint32_t maxNotifications = 0;
+  ValidationResultType valType;
+
+  if ((proxy->resCallback == NULL) && (proxy->resBatchCallback == NULL))
+  {
+    LOG(LEVEL_INFO, "processVerifyNotifyMulti: NO IMPLEMENTATION PROVIDED FOR "
+                    "proxy->resCallback!!!\n");
+    return;
+  }
+  if (length >= sizeof(SRXPROXY_VERIFY_NOTIFICATION_MULTI))
+  {
+    noNotifications  = ntohl(hdr->noNotifications);
+    maxNotifications = (length - sizeof(SRXPROXY_VERIFY_NOTIFICATION_MULTI))
+                       / sizeof(SRXPROXY_NOTIFICATION_ENTRY);
+  }
+  if (noNotifications > maxNotifications)
+  {
+    LOG(LEVEL_WARNING, HDR "Multi notification with %u notifications but only "
+                       "space for %u!", noNotifications, maxNotifications);
+    noNotifications = maxNotifications;
+  }
+
+  for (; noNotifications > 0; noNotifications--, entry++)
+  {
+    valType = entry->resultType & SRX_FLAG_ROA_AND_BGPSEC;
+    _deliverResult(proxy, ntohl(entry->updateID), 0, valType, 
+                   (valType & SRX_FLAG_ROA) ? entry->roaResult 
+                                            : SRx_RESULT_UNDEFINED,
+                   (valType & SRX_FLAG_BGPSEC) ? entry->bgpsecResult 
+                                               : SRx_RESULT_UNDEFINED);
+  }
+}
+
+/**
+ * Process signature notification. The signature data following the header,
+ * either the own signature segments or the complete BGPSec path attribute, is
+ * passed to the signature callback of the proxy. A notification whose
+ * signature data exceeds the packet is rejected.
  *
  * @param hdr The "Signature Notification" Header
- * @param self The instance of the connection handler.
+ * @param proxy The proxy instance.
  */
 void processSignNotify(SRXPROXY_SIGNATURE_NOTIFICATION* hdr, SRxProxy* proxy)
 {
-  // @TODO: Finishe the implementation with the correct data.
+  BGPSecCallbackData bgpsecCallback;
+  uint32_t           length = ntohl(hdr->length);
+
   if (proxy->sigCallback != NULL)
   {
-    LOG(LEVEL_INFO, "processSignNotify: NOT IMPLEMENTED IN THIS PROTOTYPE!!!\n");
-    SRxUpdateID updId = hdr->updateIdentifier;
-    //TODO finish processSigNotify - especially the bgpsec data
-    BGPSecCallbackData bgpsecCallback;
-    bgpsecCallback.length = 0;
-    bgpsecCallback.data = NULL;
-    proxy->sigCallback(updId, &bgpsecCallback, proxy->userPtr);
+    // The signature data follows the header, either the own signature 
+    // segments or the complete BGPSec path attribute.
+    bgpsecCallback.length = ntohl(hdr->bgpsecLength);
+    bgpsecCallback.data   = (uint8_t*)hdr 
+                            + sizeof(SRXPROXY_SIGNATURE_NOTIFICATION);
+    if (   (length < sizeof(SRXPROXY_SIGNATURE_NOTIFICATION))
+        || (bgpsecCallback.length 
+            > length - sizeof(SRXPROXY_SIGNATURE_NOTIFICATION)))
+    {
+      RAISE_ERROR("Malformed signature notification for update [0x%08X]!",
+                  ntohl(hdr->updateIdentifier));
+      return;
+    }
+    proxy->sigCallback(ntohl(hdr->updateIdentifier), &bgpsecCallback, 
+                       proxy->userPtr);
   }
   else
   {
@@ -1127,6 +2608,239 @@ void processSignNotify(SRXPROXY_SIGNATURE_NOTIFICATION* hdr, SRxProxy* proxy)
   }
 }
 
+/**
+ * Send the given updates within synchronization updates packets. The caller
+ * waits if the send buffer is full.
+ *
+ * @param proxy The proxy instance
+ * @param updates The updates in network format
+ * @param noUpdates The number of updates
+ *
+ * @return true if all packets could be queued.
+ *
+ * @since 0.4.1.0
+ */
+static bool _sendSyncUpdates(SRxProxy* proxy,
+                             SRXPROXY_NOTIFICATION_ENTRY* updates,
+                             uint32_t noUpdates)
+{
+  ClientConnectionHandler* connHandler =
+                                   (ClientConnectionHandler*)proxy->connHandler;
+  SRXPROXY_SYNC_UPDATES* pdu;
+  uint32_t count;
+  uint32_t length;
+  int      error = 0;
+
+  pdu = malloc(  sizeof(SRXPROXY_SYNC_UPDATES)
+               + (SRX_MAX_SYNC_UPDATES * sizeof(SRXPROXY_NOTIFICATION_ENTRY)));
+  if (pdu == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the synchronization!");
+    return false;
+  }
+  memset(pdu, 0, sizeof(SRXPROXY_SYNC_UPDATES));
+  pdu->type = PDU_SRXPROXY_SYNC_UPDATES;
+
+  while ((noUpdates > 0) && (error == 0))
+  {
+    count  = noUpdates < SRX_MAX_SYNC_UPDATES ? noUpdates
+                                              : SRX_MAX_SYNC_UPDATES;
+    length = sizeof(SRXPROXY_SYNC_UPDATES)
+             + (count * sizeof(SRXPROXY_NOTIFICATION_ENTRY));
+    pdu->length    = htonl(length);
+    pdu->noUpdates = htonl(count);
+    memcpy(pdu->update, updates, count * sizeof(SRXPROXY_NOTIFICATION_ENTRY));
+    error      = queuePacketToServerWait(connHandler, pdu, length);
+    updates   += count;
+    noUpdates -= count;
+  }
+  free(pdu);
+
+  if (error != 0)
+  {
+    LOG(LEVEL_ERROR, "Failure during sending the synchronization updates "
+                     "(error=%u)!", error);
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Perform the incremental synchronization. The IDs and results of all updates
+ * known to the result cache are send to the server. Updates without a
+ * confirmed ID might be stored under a different ID by the server, these are
+ * reported as missing right away.
+ *
+ * @param proxy The proxy instance
+ *
+ * @return false if the incremental synchronization can not be used, the user
+ *         has to verify all updates again.
+ *
+ * @since 0.4.1.0
+ */
+static bool _syncResultCache(SRxProxy* proxy)
+{
+  ProxyResultCache* cache     = (ProxyResultCache*)proxy->resultCache;
+  ProxyResultEntry* entry;
+  ProxyResultEntry* tmp;
+  SRxUpdateID*      missing   = NULL;
+  uint32_t          noMissing = 0;
+  uint32_t          noUpdates = 0;
+  uint32_t          size;
+
+  SRXPROXY_NOTIFICATION_ENTRY* updates = NULL;
+  SRXPROXY_NOTIFICATION_ENTRY* update;
+
+  if (!proxy->useIncrSync || (cache == NULL) || (proxy->syncMissing == NULL))
+  {
+    return false;
+  }
+
+  pthread_mutex_lock(&cache->mutex);
+  size = cache->size > 0 ? cache->size : 1;
+  if (cache->complete)
+  {
+    updates = malloc(size * sizeof(SRXPROXY_NOTIFICATION_ENTRY));
+    missing = malloc(size * sizeof(SRxUpdateID));
+  }
+  if ((updates == NULL) || (missing == NULL))
+  {
+    pthread_mutex_unlock(&cache->mutex);
+    free(updates);
+    free(missing);
+    return false;
+  }
+
+  HASH_ITER(hh, cache->entries, entry, tmp)
+  {
+    if (!entry->confirmed)
+    {
+      missing[noMissing++] = entry->updateID;
+      HASH_DEL(cache->entries, entry);
+      cache->size--;
+      free(entry);
+      continue;
+    }
+    update = &updates[noUpdates++];
+    update->updateID     = htonl(entry->updateID);
+    update->resultType   = entry->valType & SRX_FLAG_ROA_AND_BGPSEC;
+    update->roaResult    = entry->roaResult;
+    update->bgpsecResult = entry->bgpsecResult;
+    update->zero         = 0;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+
+  // The mutex is released, the caller might wait for the send thread.
+  if (!_sendSyncUpdates(proxy, updates, noUpdates))
+  {
+    // Fall back to verify all updates again.
+    free(updates);
+    free(missing);
+    return false;
+  }
+  free(updates);
+
+  LOG(LEVEL_INFO, "Incremental synchronization of %u updates started, %u "
+                  "updates without confirmed ID are missing.", noUpdates,
+                  noMissing);
+  if (noMissing > 0)
+  {
+    proxy->syncMissing(noMissing, missing, proxy->userPtr);
+  }
+  free(missing);
+
+  return true;
+}
+
+/**
+ * The SRx server reports the updates of the incremental synchronization it
+ * does not hold anymore. They are removed from the result cache and passed to
+ * the missing updates callback, the user has to verify them again.
+ *
+ * @param hdr The "Missing Updates" Header
+ * @param proxy The instance of the connection handler.
+ *
+ * @since 0.4.1.0
+ */
+void processSyncMissing(SRXPROXY_SYNC_MISSING* hdr, SRxProxy* proxy)
+{
+  ProxyResultCache* cache     = (ProxyResultCache*)proxy->resultCache;
+  ProxyResultEntry* entry;
+  uint32_t          noUpdates = ntohl(hdr->noUpdates);
+  SRxUpdateID*      updateIDs;
+  uint32_t          idx;
+
+  if (ntohl(hdr->length)
+      != sizeof(SRXPROXY_SYNC_MISSING) + (noUpdates * sizeof(SRxUpdateID)))
+  {
+    RAISE_ERROR("Received a malformed missing updates packet!");
+    return;
+  }
+
+  // The IDs of the packed PDU are copied into host format.
+  updateIDs = malloc((noUpdates > 0 ? noUpdates : 1) * sizeof(SRxUpdateID));
+  if (updateIDs == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for %u missing updates!", noUpdates);
+    return;
+  }
+  for (idx = 0; idx < noUpdates; idx++)
+  {
+    updateIDs[idx] = ntohl(hdr->updateID[idx]);
+  }
+  if (cache != NULL)
+  {
+    pthread_mutex_lock(&cache->mutex);
+    for (idx = 0; idx < noUpdates; idx++)
+    {
+      HASH_FIND(hh, cache->entries, &updateIDs[idx], sizeof(SRxUpdateID),
+                entry);
+      if (entry != NULL)
+      {
+        HASH_DEL(cache->entries, entry);
+        cache->size--;
+        free(entry);
+      }
+    }
+    pthread_mutex_unlock(&cache->mutex);
+  }
+
+  if (proxy->syncMissing != NULL)
+  {
+    proxy->syncMissing(noUpdates, updateIDs, proxy->userPtr);
+  }
+  else
+  {
+    LOG(LEVEL_INFO, "processSyncMissing: NO IMPLEMENTATION PROVIDED FOR "
+                    "proxy->syncMissing!!!\n");
+  }
+  free(updateIDs);
+}
+
+/**
+ * The SRx server asks the proxy to pause or resume sending. The queued
+ * requests are held back in the send buffer meanwhile.
+ *
+ * @param hdr The "Flow Control" Header
+ * @param proxy The instance of the connection handler.
+ *
+ * @since 0.4.1.0
+ */
+void processFlowControl(SRXPROXY_FLOW_CONTROL* hdr, SRxProxy* proxy)
+{
+  if (ntohl(hdr->length) != sizeof(SRXPROXY_FLOW_CONTROL))
+  {
+    RAISE_ERROR("Received a malformed flow control packet!");
+    return;
+  }
+
+  LOG(LEVEL_INFO, "The SRx server %s the proxy.",
+                  hdr->pause != 0 ? "paused" : "resumed");
+  setServerFlowControl((ClientConnectionHandler*)proxy->connHandler,
+                       hdr->pause != 0);
+}
+
 /**
  * If the user of this API registered a synchNotification handler it will be
  * called now, otherwise the request will just be logged.
@@ -1136,6 +2850,12 @@ void processSignNotify(SRXPROXY_SIGNATURE_NOTIFICATION* hdr, SRxProxy* proxy)
  */
 void processSyncRequest(SRXPROXY_SYNCH_REQUEST* hdr, SRxProxy* proxy)
 {
+  if (_syncResultCache(proxy))
+  {
+    return;
+  }
+  // The router verifies all updates again.
+  _resetResultCache(proxy, proxy->syncNotification != NULL);
   if (proxy->syncNotification != NULL)
   {
     proxy->syncNotification(proxy->userPtr);
@@ -1248,6 +2968,13 @@ static void dispatchPackets(SRXPROXY_BasicHeader* packet, void* proxyPtr)
 {
   SRxProxy* proxy = (SRxProxy*)proxyPtr;
 
+  // Keep the order of batched results and other notifications.
+  if (   (packet->type != PDU_SRXPROXY_VERI_NOTIFICATION)
+      && (packet->type != PDU_SRXPROXY_VERI_NOTIFICATION_MULTI))
+  {
+    _flushResultBatch(proxy);
+  }
+
   switch (packet->type)
   {
     case PDU_SRXPROXY_HELLO_RESPONSE:
@@ -1262,6 +2989,11 @@ static void dispatchPackets(SRXPROXY_BasicHeader* packet, void* proxyPtr)
       processVerifyNotify((SRXPROXY_VERIFY_NOTIFICATION*)packet, proxy);
       break;
 
+    case PDU_SRXPROXY_VERI_NOTIFICATION_MULTI:
+      processVerifyNotifyMulti((SRXPROXY_VERIFY_NOTIFICATION_MULTI*)packet, 
+                               proxy);
+      break;
+
     case PDU_SRXPROXY_SIGN_NOTIFICATION:
       processSignNotify((SRXPROXY_SIGNATURE_NOTIFICATION*)packet, proxy);
       break;
@@ -1270,6 +3002,14 @@ static void dispatchPackets(SRXPROXY_BasicHeader* packet, void* proxyPtr)
       processSyncRequest((SRXPROXY_SYNCH_REQUEST*)packet, proxy);
       break;
 
+    case PDU_SRXPROXY_SYNC_MISSING:
+      processSyncMissing((SRXPROXY_SYNC_MISSING*)packet, proxy);
+      break;
+
+    case PDU_SRXPROXY_FLOW_CONTROL:
+      processFlowControl((SRXPROXY_FLOW_CONTROL*)packet, proxy);
+      break;
+
     case PDU_SRXPROXY_ERROR:
       processError((SRXPROXY_ERROR*)packet, proxy);
       break;
@@ -1302,6 +3042,8 @@ bool processPackets(SRxProxy* proxy)
 
   bRetVal = receivePackets(getClientFDPtr(&connHandler->clSock),
                           connHandler->packetHandler, proxy, PHT_PROXY);
+  // Deliver the results of this read cycle at once.
+  _flushResultBatch(proxy);
 
   if(!bRetVal)
   {
@@ -23,10 +23,29 @@
  * Secure Routing extension (SRx) client API - This API provides a fully 
  * functional proxy client to the SRx server.
  *
- * Version 0.4.0.0
+ * Version 0.4.1.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added SRxVerifyRequest and verifyUpdateBatch
+ *            * Added requestCRC32CID and useCRC32CID to SRxProxy
+ *            * Added requestMultiNotify and useMultiNotify to SRxProxy
+ *          - 2026/10/15 - kyehwanl
+ *            * Added SendQueueState, sendQueueState to SRxProxy, and 
+ *              setSendQueueStateCallback.
+ *            * Added SRxProxyResult, ValidationReadyBatch, and 
+ *              setValidationReadyBatchCallback.
+ *            * Added resultCache to SRxProxy, setResultCache, and 
+ *              getResultCacheHits.
+ *            * Added SRxSignRequest and signUpdateBatch.
+ *            * Added requestShmTransport and useShmTransport to SRxProxy.
+ *            * Added requestBulkVerify and useBulkVerify to SRxProxy.
+ *            * Added SyncMissingUpdates, requestIncrSync, useIncrSync, and
+ *              syncMissing to SRxProxy, and setSyncMissingUpdatesCallback.
+ *            * Added requestFlowControl and useFlowControl to SRxProxy.
+ *            * Added shards and noShards to SRxProxy, SRX_MAX_PROXY_SHARDS,
+ *              and connectToSRxShards.
  * 0.4.0.0  - 2016/06/19 - oborchert
  *            * Modified the structure for the signaturesReady callback method
  * 0.3.0.10 - 2015/11/09 - oborchert 
@@ -181,6 +200,46 @@ typedef bool (*ValidationReady)(SRxUpdateID          updateID,
                                 uint8_t              bgpsecResult,
                                 void* userPtr);
 
+/**
+ * A single validation result as passed to ValidationReadyBatch. The 
+ * attributes are the parameters of ValidationReady.
+ *
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** The updateID provided by the srx-server. */
+  SRxUpdateID          updateID;
+  /** The local "update-id" used by the user of this API or 0. */
+  uint32_t             localID;
+  /** Specifies which of the validation results contain actual values. */
+  ValidationResultType valType;
+  /** The prefix-origin validation result. */
+  uint8_t              roaResult;
+  /** The path validation result. */
+  uint8_t              bgpsecResult;
+} SRxProxyResult;
+
+/** The maximum number of results passed to ValidationReadyBatch at once. */
+#define SRX_RESULT_BATCH_SIZE 4096
+
+/**
+ * Optional replacement of ValidationReady. All validation results received
+ * within one call of processPackets are passed at once, in the order they 
+ * were received. This allows the user of the API to apply the results while
+ * holding its lock only once. The results array is only valid during the 
+ * call.
+ *
+ * @param noResults The number of results.
+ * @param results The results.
+ * @param usrPtr Pointer to SRxProxy.userPtr provided by router / user of the
+ *               API.
+ *
+ * @since 0.4.1.0
+ */
+typedef void (*ValidationReadyBatch)(uint32_t noResults, 
+                                     SRxProxyResult* results,
+                                     void* userPtr);
+
 /**
  * Used to return the calculated signatures.
  *
@@ -203,6 +262,23 @@ typedef void (*SignaturesReady)(SRxUpdateID updId, BGPSecCallbackData* data,
  */
 typedef void (*SyncNotification)(void* userPtr);
 
+/**
+ * This callback function reports the updates the SRx server does not hold
+ * anymore after an incremental synchronization. Only these updates must be
+ * verified again, the results of all other updates are still valid or are
+ * reported through the validation ready callback. Updates that could not be
+ * send to the SRx server at all must be verified again as well.
+ *
+ * @param noUpdates The number of updates.
+ * @param updateIDs The IDs of the updates.
+ * @param usrPtr Pointer to SRxProxy.userPtr provided by router / user of the
+ *               API.
+ *
+ * @since 0.4.1.0
+ */
+typedef void (*SyncMissingUpdates)(uint32_t noUpdates, SRxUpdateID* updateIDs,
+                                   void* userPtr);
+
 /**
  * Used to communicate messages and errors between srx-server and the proxy.
  *
@@ -216,6 +292,26 @@ typedef void (*SyncNotification)(void* userPtr);
 typedef void (*SrxCommManagement)(SRxProxyCommCode code, int subCode, 
                                 void* userPtr);
 
+/**
+ * Reports the fill state of the send buffer of the proxy. Requests are 
+ * written to the SRx server by a thread of the proxy, the caller never waits 
+ * for the socket. Once the buffer exceeds its high water mark this function 
+ * is called with full = true, the user should pause submitting requests. Once
+ * the buffer is drained below its low water mark it is called with 
+ * full = false. Requests that do not fit into the buffer are reported as
+ * COM_ERR_PROXY_COULD_NOT_SEND with sub code ENOBUFS. A server that uses the
+ * flow control holds the buffer back while it is overloaded, this is reported
+ * as full buffer as well.
+ *
+ * @param full true if the buffer passed the high water mark, false if it
+ *             drained below the low water mark.
+ * @param usrPtr Pointer to SRxProxy.userPtr provided by router / user of the
+ *               API.
+ *
+ * @since 0.4.1.0
+ */
+typedef void (*SendQueueState)(bool full, void* userPtr);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Proxy type and functions
 ////////////////////////////////////////////////////////////////////////////////
@@ -257,16 +353,24 @@ typedef struct {
  */
 typedef struct {
   ValidationReady   resCallback;
+  // Optional, replaces resCallback, see setValidationReadyBatchCallback.
+  ValidationReadyBatch resBatchCallback;
+  SRxProxyResult*      resBatch;      // The results not delivered yet
+  uint32_t             resBatchSize;  // The number of results in resBatch
   SignaturesReady   sigCallback;
   SyncNotification  syncNotification;
+  // Optional, see setSyncMissingUpdatesCallback
+  SyncMissingUpdates syncMissing;
   
   SrxCommManagement commManagement;  
+  SendQueueState    sendQueueState; // Optional, see setSendQueueStateCallback
   SRxProxyCommCode  lastCode;    // Last communication code.
   int               lastSubCode; // subCode of communication codelast error.
 
   uint32_t          proxyID;
 
   void*             connHandler;  // MUST be of type ClientConnectionHandler
+  void*             resultCache;  // Optional, see setResultCache
 
   uint32_t          proxyAS;
   SList             peerAS;          // Maybe change to a pointer
@@ -277,6 +381,48 @@ typedef struct {
 
   bool externalSocketControl; // Allows the current socket connection to be
                               // controlled externally.
+
+  // Request CRC-32C based update identifiers during the handshake (default 
+  // true). Set to false if the legacy identifiers are required.
+  bool requestCRC32CID;
+  // Set during the handshake, true if the server generates the update 
+  // identifiers using CRC-32C (see generateIdentifierCRC32C).
+  bool useCRC32CID;
+  // Request multi verification notifications during the handshake (default
+  // true). Result changes are then received in bulk.
+  bool requestMultiNotify;
+  // Set during the handshake, true if the server sends result changes using
+  // multi verification notifications.
+  bool useMultiNotify;
+  // Request bulk verify requests during the handshake (default true). The
+  // prefixes of one update are then send with a single copy of the path.
+  bool requestBulkVerify;
+  // Set during the handshake, true if the server accepts bulk verify
+  // requests.
+  bool useBulkVerify;
+  // Request the incremental synchronization during the handshake (default
+  // true). It is only used if the result cache is enabled and the missing
+  // updates callback is registered.
+  bool requestIncrSync;
+  // Set during the handshake, true if the server accepts the incremental
+  // synchronization.
+  bool useIncrSync;
+  // Request the flow control during the handshake (default true). The server
+  // pauses the proxy while it is overloaded, the send buffer is held back and
+  // reported full using the send queue state callback.
+  bool requestFlowControl;
+  // Set during the handshake, true if the server uses the flow control.
+  bool useFlowControl;
+  // Connect a server on the same host using the shared memory transport if
+  // it provides it (default true), otherwise TCP is used.
+  bool requestShmTransport;
+  // Set by connectToSRx, true if the shared memory transport is used.
+  bool useShmTransport;
+  // The proxies of all connections, see connectToSRxShards. The first one is
+  // the proxy itself. Each element MUST be of type SRxProxy.
+  void**   shards;
+  // The number of connections, 0 if the proxy uses a single connection.
+  uint32_t noShards;
     
   // Experimental
   ProxySocketConfig socketConfig;
@@ -319,6 +465,92 @@ SRxProxy* createSRxProxy(ValidationReady   validationReadyCallback,
                          SyncNotification  requestSynchronizationCallback,
                          SrxCommManagement communicationMgmtCallback,
                          uint32_t proxyID, uint32_t proxyAS, void* userPtr);
+/**
+ * Register the function that is called when the send buffer of the proxy 
+ * passes its high water mark and when it is drained again. The function is
+ * called from the thread that submits a request or from the send thread of
+ * the proxy.
+ *
+ * @param proxy The proxy instance
+ * @param callback The function or NULL to deactivate it.
+ *
+ * @since 0.4.1.0
+ */
+void setSendQueueStateCallback(SRxProxy* proxy, SendQueueState callback);
+
+/**
+ * Register the function that receives the missing updates of an incremental
+ * synchronization. If the result cache knows all updates verified during the
+ * previous connection, a synchronization request of the SRx server is not
+ * passed to the synchronization callback. Instead the proxy sends the IDs of
+ * the known updates and the server reports the ones it does not hold anymore.
+ * Only these are passed to the given function and must be verified again.
+ *
+ * @param proxy The proxy instance
+ * @param callback The function or NULL to always use the synchronization
+ *                 callback.
+ *
+ * @since 0.4.1.0
+ */
+void setSyncMissingUpdatesCallback(SRxProxy* proxy,
+                                   SyncMissingUpdates callback);
+
+/**
+ * Register the function that receives the validation results in batches 
+ * instead of one call of the validation ready callback per result. The 
+ * results received within one call of processPackets are delivered at the
+ * end of the call. A batch is delivered early if it holds 
+ * SRX_RESULT_BATCH_SIZE results or before any other notification of the
+ * server is processed.
+ *
+ * @param proxy The proxy instance
+ * @param callback The function or NULL to use the validation ready callback.
+ *
+ * @return false if the batch could not be allocated.
+ *
+ * @since 0.4.1.0
+ */
+bool setValidationReadyBatchCallback(SRxProxy* proxy, 
+                                     ValidationReadyBatch callback);
+
+/**
+ * Enable, resize, or disable the result cache of the proxy. The proxy 
+ * generates the update ID of each verify request the same way the server 
+ * does. Once the server reported the result of an update, further verify 
+ * requests for the same update are answered by the proxy without contacting
+ * the server, e.g. if the same route is learned from several peers. Such a
+ * request is answered from within verifyUpdate / verifyUpdateBatch by 
+ * calling the validation ready (or batch) callback, only if a receipt is
+ * requested or the result differs from the default result. A delete request
+ * is only send to the server once all verify requests of the update are 
+ * deleted. The cache is emptied if the connection is lost or the server
+ * requests a synchronization.
+ *
+ * @note The server changes the ID of an update in case of a collision. An 
+ *       update is therefore only answered from the cache once the server 
+ *       confirmed its ID with a receipt, verify requests without local ID
+ *       are not answered until a request with local ID was send.
+ *
+ * @param proxy The proxy instance
+ * @param maxEntries The maximum number of updates kept, 0 disables the cache.
+ *
+ * @return false if the cache could not be created.
+ *
+ * @since 0.4.1.0
+ */
+bool setResultCache(SRxProxy* proxy, uint32_t maxEntries);
+
+/**
+ * Return the number of verify requests answered by the result cache.
+ *
+ * @param proxy The proxy instance
+ *
+ * @return The number of requests.
+ *
+ * @since 0.4.1.0
+ */
+uint64_t getResultCacheHits(SRxProxy* proxy);
+
 /**
  * Releases the instance. This also closes the connection if necessary.
  *
@@ -377,6 +609,40 @@ void deleteUpdate(SRxProxy* proxy, uint16_t keep_window, SRxUpdateID updateID);
 bool connectToSRx(SRxProxy* proxy, const char* host, int port,
                   int handshakeTimeout, bool externalSocketControl);
 
+/** The maximum number of connections of a single proxy. */
+#define SRX_MAX_PROXY_SHARDS 64
+
+/**
+ * Connect the proxy using several connections, to one SRx server or spread
+ * over a set of servers. Connection i uses server (i % noServers). Each
+ * connection has its own send and receive thread, the updates are spread
+ * over the connections by their update ID. Delete and sign requests follow
+ * the update ID, peer changes are send over all connections. The results of
+ * all connections are passed to the callbacks of the proxy, possibly from
+ * several receive threads at the same time.
+ *
+ * The settings of the proxy, e.g. the result cache, the batch callback, and
+ * the peers, are copied to the other connections here; change them before
+ * calling this function. Connection i uses the proxy ID + i unless the proxy
+ * ID is 0. All servers must agree on the type of update identifiers. The
+ * socket control is always internal. disconnectFromSRx closes all
+ * connections.
+ *
+ * @param proxy The proxy instance
+ * @param noShards The number of connections (1 .. SRX_MAX_PROXY_SHARDS)
+ * @param noServers The number of servers.
+ * @param hosts The host names of the servers.
+ * @param ports The ports of the servers.
+ * @param handshakeTimeout The time in seconds before a handshake is timed out.
+ *
+ * @return true if all connections are established, otherwise none is.
+ *
+ * @since 0.4.1.0
+ */
+bool connectToSRxShards(SRxProxy* proxy, uint32_t noShards,
+                        uint32_t noServers, const char** hosts, int* ports,
+                        int handshakeTimeout);
+
 /**
  * Disconnects the proxy from the SRx Server instance on both, application and
  * transport layer.
@@ -440,6 +706,48 @@ void verifyUpdate(SRxProxy* proxy, uint32_t localID,
                   IPPrefix* prefix, uint32_t as32,
                   BGPSecData* bgpsec);
 
+/**
+ * A single verification request used by verifyUpdateBatch. The parameters have
+ * the same meaning as the parameters of verifyUpdate.
+ */
+typedef struct {
+  /** The local ID, see verifyUpdate. */
+  uint32_t          localID;
+  /** Request prefix origin validation. */
+  bool              usePrefixOriginVal;
+  /** Request path validation. */
+  bool              usePathVal;
+  /** The default result information. */
+  SRxDefaultResult* defaultResult;
+  /** The prefix of the request. (both v4/v6 possible) */
+  IPPrefix*         prefix;
+  /** Origin AS (32-bit) */
+  uint32_t          as32;
+  /** The bgpsec information, can be NULL. */
+  BGPSecData*       bgpsec;
+} SRxVerifyRequest;
+
+/**
+ * Verifies the given updates. All requests are encoded into one contiguous
+ * buffer and send using as few send operations as possible. This is the 
+ * preferred method to verify a large number of updates, e.g. during the initial
+ * table transfer of a peering session. If the server supports it, consecutive
+ * requests with the same validation methods, default results, and path data
+ * are send as one bulk verify request.
+ *
+ * @param proxy The proxy instance
+ * @param noRequests The number of requests
+ * @param requests The array of requests
+ *
+ * @return The number of requests that were sent. A value less than noRequests
+ *         indicates a send error which was reported through the communication
+ *         management callback.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t verifyUpdateBatch(SRxProxy* proxy, uint32_t noRequests,
+                           SRxVerifyRequest* requests);
+
 /**
  * This method generates a signature request. The signature will be returned
  * using the signature notification callback.
@@ -459,6 +767,42 @@ void verifyUpdate(SRxProxy* proxy, uint32_t localID,
 bool signUpdate(SRxProxy* proxy, SRxUpdateID updateId, bool onlyOwnSignature,
                 uint16_t algorithm, uint32_t prependCounter, uint32_t peerAS);
 
+/**
+ * A single signature request used by signUpdateBatch. The parameters have
+ * the same meaning as the parameters of signUpdate.
+ *
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** The update id the signature is requested for. */
+  SRxUpdateID updateId;
+  /** Return only the own signature segments. */
+  bool        onlyOwnSignature;
+  /** The algorithm to use. */
+  uint16_t    algorithm;
+  /** Number of times the own AS will be prepended into the path. */
+  uint32_t    prependCounter;
+  /** The peer AS the update will be send to. */
+  uint32_t    peerAS;
+} SRxSignRequest;
+
+/**
+ * Request the signatures of the given updates. All requests are encoded into
+ * one buffer and send at once, the server signs requests of the same update
+ * together. The signatures are returned using the signature notification
+ * callback.
+ *
+ * @param proxy Pointer to the proxy instance
+ * @param noRequests The number of requests
+ * @param requests The array of requests
+ *
+ * @return The number of requests that were sent, either 0 or noRequests.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t signUpdateBatch(SRxProxy* proxy, uint32_t noRequests,
+                         SRxSignRequest* requests);
+
 /**
  * This function is called to read packets received from srx-server and process
  * them accordingly. This function allows the caller to have the packet handling
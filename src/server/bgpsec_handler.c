@@ -21,10 +21,23 @@
  * by this software.
  *
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Added the path validation (RFC 8205) using OpenSSL and the 
+ *              worker threads executing the queued validations.
+ *            * Replaced validateSignature with validateBGPSecPath.
+ *            * Verification results are memorized.
+ *            * Added the signing of updates on the worker threads, requests
+ *              of the same update share the preparation of the signed data.
+ *            * Implemented loadPrivateKey, removed the stub createSignature.
+ *            * The workers are placed and named by createThread.
+ *            * The validated updates are registered with the SKIs of their
+ *              signatures, storing or deleting a router key revalidates the
+ *              updates registered with its SKI.
+ *            * Name the queue mutex for the lock statistics.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Added Changelog
  *            * Fixed speller in documentation header
@@ -32,42 +45,1296 @@
  *            * Code created. 
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
 #include "server/bgpsec_handler.h"
+#include "util/lock_stats.h"
 #include "util/log.h"
+#include "util/thread.h"
 
+#define HDR "([0x%08X] BGPSec Handler): "
+
+/** The flag of the path attribute indicating a two byte length. */
+#define BGPSEC_ATTR_FLAG_EXT_LEN 0x10
+/** The length of a Secure_Path segment. */
+#define BGPSEC_SP_SEGMENT_LEN    6
+/** The length of the SKI and signature length of a signature segment. */
+#define BGPSEC_SIG_SEGMENT_HDR   (KC_SKI_LENGTH + 2)
+/** The length of the SHA-256 digest. */
+#define BGPSEC_DIGEST_LEN        32
+
+/** The kind of a queued job. */
+typedef enum {
+  BGPSEC_JOB_VALIDATE = 0,
+  BGPSEC_JOB_SIGN     = 1
+} BGPSecJobType;
+
+/** A queued path validation or signing. */
+struct _BGPSecJob {
+  /** The next job in the queue. */
+  BGPSecJob*    next;
+  /** Validation or signing. */
+  BGPSecJobType type;
+  /** The ID of the update. */
+  SRxUpdateID   updateID;
+  /** The client that requested the signature. */
+  uint8_t       clientID;
+  /** The AS number of the router that received or signs the update. */
+  uint32_t      localAS;
+  /** The target of the signature. */
+  uint32_t      peerAS;
+  /** The number of times the own AS is in the path. */
+  uint8_t       pCount;
+  /** Return only the own segments. */
+  bool          onlyOwn;
+  /** The prefix of the update. */
+  IPPrefix      prefix;
+  /** The length of the attribute, 0 for originated updates. */
+  uint16_t      attrLength;
+  /** The BGPSec path attribute. */
+  uint8_t       attr[];
+};
+
+/** The data signed for all signing requests of the same update. */
+typedef struct {
+  /** The signed data, starting with the target AS. */
+  uint8_t*  data;
+  /** The length of the signed data. */
+  uint32_t  length;
+  /** The offset of the own Secure_Path segment within the data. */
+  uint32_t  ownOffset;
+  /** The first received Secure_Path segment, NULL if originated. */
+  uint8_t*  path;
+  /** The number of received Secure_Path segments. */
+  uint16_t  noSegments;
+  /** The received ECDSA P-256 signature segments. */
+  uint8_t*  sigs;
+  /** The length of the received signature segments. */
+  uint16_t  sigsLength;
+} BGPSecSignData;
+
+/** A signature segment of the ECDSA P-256 signature block. */
+typedef struct {
+  /** The subject key identifier of the router key. */
+  uint8_t* ski;
+  /** The signature. */
+  uint8_t* sig;
+  /** The length of the signature. */
+  uint16_t sigLen;
+} BGPSecSigSegment;
+
+/**
+ * Read an unsigned 16 bit value in network byte order.
+ *
+ * @param data The data.
+ *
+ * @return The value.
+ */
+static inline uint16_t _read16(const uint8_t* data)
+{
+  return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+/**
+ * Read an unsigned 32 bit value in network byte order.
+ *
+ * @param data The data.
+ *
+ * @return The value.
+ */
+static inline uint32_t _read32(const uint8_t* data)
+{
+  return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16)
+         | ((uint32_t)data[2] << 8) | data[3];
+}
+
+/**
+ * Locate the Secure_Path and the ECDSA P-256 signature block within the 
+ * attribute.
+ *
+ * @param attr The BGPSec path attribute including its attribute header.
+ * @param attrLength The length of the attribute.
+ * @param path OUT - The first Secure_Path segment.
+ * @param noSegments OUT - The number of Secure_Path segments.
+ * @param sigs OUT - The first signature segment.
+ * @param sigsLength OUT - The length of all signature segments.
+ *
+ * @return false if the attribute is malformed or does not contain a
+ *         signature block of a supported algorithm suite.
+ */
+static bool _parseAttribute(uint8_t* attr, uint16_t attrLength, 
+                            uint8_t** path, uint16_t* noSegments, 
+                            uint8_t** sigs, uint16_t* sigsLength)
+{
+  uint8_t* end = attr + attrLength;
+  uint8_t* pos;
+  uint16_t length;
+
+  if ((attrLength < 3) || (attr[1] != BGPSEC_PATH_ATTR_TYPE))
+  {
+    return false;
+  }
+  if ((attr[0] & BGPSEC_ATTR_FLAG_EXT_LEN) != 0)
+  {
+    length = attrLength < 4 ? 0 : _read16(attr + 2);
+    pos    = attr + 4;
+  }
+  else
+  {
+    length = attr[2];
+    pos    = attr + 3;
+  }
+  if ((length == 0) || (pos + length != end))
+  {
+    return false;
+  }
+
+  // Secure_Path: the length includes the length field itself.
+  length = end - pos < 2 ? 0 : _read16(pos);
+  if (   (length < 2 + BGPSEC_SP_SEGMENT_LEN) || (pos + length > end)
+      || ((length - 2) % BGPSEC_SP_SEGMENT_LEN != 0))
+  {
+    return false;
+  }
+  *path       = pos + 2;
+  *noSegments = (length - 2) / BGPSEC_SP_SEGMENT_LEN;
+  pos        += length;
+
+  // Up to two signature blocks, the length includes the length field itself.
+  while (end - pos >= 3)
+  {
+    length = _read16(pos);
+    if ((length < 3) || (pos + length > end))
+    {
+      return false;
+    }
+    if (pos[2] == BGPSEC_ALGO_ECDSA_P256)
+    {
+      *sigs       = pos + 3;
+      *sigsLength = length - 3;
+      return true;
+    }
+    pos += length;
+  }
+
+  return false;
+}
+
+/**
+ * Split the signature block into its segments.
+ *
+ * @param sigs The first signature segment.
+ * @param sigsLength The length of all signature segments.
+ * @param segments OUT - The segments.
+ * @param noSegments The number of segments expected.
+ *
+ * @return false if the block does not contain the expected segments.
+ */
+static bool _parseSignatures(uint8_t* sigs, uint16_t sigsLength,
+                             BGPSecSigSegment* segments, uint16_t noSegments)
+{
+  uint8_t* end = sigs + sigsLength;
+  uint8_t* pos = sigs;
+  uint16_t idx;
+
+  for (idx = 0; idx < noSegments; idx++)
+  {
+    if (end - pos < BGPSEC_SIG_SEGMENT_HDR)
+    {
+      return false;
+    }
+    segments[idx].ski    = pos;
+    segments[idx].sigLen = _read16(pos + KC_SKI_LENGTH);
+    segments[idx].sig    = pos + BGPSEC_SIG_SEGMENT_HDR;
+    pos += BGPSEC_SIG_SEGMENT_HDR + segments[idx].sigLen;
+    if ((segments[idx].sigLen == 0) || (pos > end))
+    {
+      return false;
+    }
+  }
+
+  return pos == end;
+}
+
+/**
+ * Calculate the digest signed by the router of the given segment (RFC 8205,
+ * section 4.2). The segments are in wire order, the most recent first.
+ *
+ * @param mdCtx The digest context to use.
+ * @param localAS The AS number of the router that received the update.
+ * @param prefix The prefix of the update.
+ * @param path The first Secure_Path segment.
+ * @param sigs The signature segments.
+ * @param noSegments The number of segments.
+ * @param signer The segment of the signer.
+ * @param digest OUT - The digest.
+ *
+ * @return false if the digest could not be calculated.
+ */
+static bool _calcDigest(EVP_MD_CTX* mdCtx, uint32_t localAS, IPPrefix* prefix,
+                        uint8_t* path, BGPSecSigSegment* sigs, 
+                        uint16_t noSegments, uint16_t signer, uint8_t* digest)
+{
+  uint8_t  buf[4];
+  uint16_t idx;
+  bool     ok;
+
+  // The target is the AS the signer sent the update to.
+  if (signer == 0)
+  {
+    buf[0] = (uint8_t)(localAS >> 24);
+    buf[1] = (uint8_t)(localAS >> 16);
+    buf[2] = (uint8_t)(localAS >> 8);
+    buf[3] = (uint8_t)localAS;
+    ok = EVP_DigestInit_ex(mdCtx, EVP_sha256(), NULL) == 1
+         && EVP_DigestUpdate(mdCtx, buf, 4) == 1;
+  }
+  else
+  {
+    ok = EVP_DigestInit_ex(mdCtx, EVP_sha256(), NULL) == 1
+         && EVP_DigestUpdate(mdCtx, path + (signer - 1) * BGPSEC_SP_SEGMENT_LEN 
+                                        + 2, 4) == 1;
+  }
+
+  // The previous signature segment followed by the own path segment, down
+  // to the origin.
+  for (idx = signer; ok && idx + 1 < noSegments; idx++)
+  {
+    ok = EVP_DigestUpdate(mdCtx, sigs[idx + 1].ski, 
+                          BGPSEC_SIG_SEGMENT_HDR + sigs[idx + 1].sigLen) == 1
+         && EVP_DigestUpdate(mdCtx, path + idx * BGPSEC_SP_SEGMENT_LEN,
+                             BGPSEC_SP_SEGMENT_LEN) == 1;
+  }
+  ok = ok && EVP_DigestUpdate(mdCtx, path + (noSegments - 1) 
+                                            * BGPSEC_SP_SEGMENT_LEN,
+                              BGPSEC_SP_SEGMENT_LEN) == 1;
+
+  // Algorithm suite, AFI, SAFI (unicast) and the NLRI.
+  buf[0] = BGPSEC_ALGO_ECDSA_P256;
+  buf[1] = 0;
+  buf[2] = prefix->ip.version == 4 ? 1 : 2;
+  buf[3] = 1;
+  ok = ok && EVP_DigestUpdate(mdCtx, buf, 4) == 1
+          && EVP_DigestUpdate(mdCtx, &prefix->length, 1) == 1
+          && EVP_DigestUpdate(mdCtx, prefix->ip.version == 4 
+                                     ? prefix->ip.addr.v4.u8 
+                                     : prefix->ip.addr.v6.u8,
+                              (prefix->length + 7) / 8) == 1;
+
+  return ok && EVP_DigestFinal_ex(mdCtx, digest, NULL) == 1;
+}
+
+/**
+ * Verify the signature over the digest with the given key.
+ *
+ * @param key The public key of the signer.
+ * @param digest The digest.
+ * @param sig The signature segment.
+ *
+ * @return true if the signature is valid.
+ */
+static bool _verifySignature(EVP_PKEY* key, uint8_t* digest, 
+                             BGPSecSigSegment* sig)
+{
+  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(key, NULL);
+  bool          valid;
+
+  valid =    (ctx != NULL)
+          && (EVP_PKEY_verify_init(ctx) == 1)
+          && (EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha256()) == 1)
+          && (EVP_PKEY_verify(ctx, sig->sig, sig->sigLen, digest, 
+                              BGPSEC_DIGEST_LEN) == 1);
+  EVP_PKEY_CTX_free(ctx);
+
+  return valid;
+}
+
+/**
+ * Calculate the memo key of a signature verification: the digest over the 
+ * router key (serial, AS, SKI), the signed digest and the signature.
+ *
+ * @param mdCtx The digest context to use.
+ * @param serial The serial of the router key.
+ * @param as The AS number of the signer.
+ * @param digest The signed digest.
+ * @param sig The signature segment.
+ * @param memoKey OUT - The memo key (SIG_MEMO_KEY_LENGTH).
+ *
+ * @return false if the key could not be calculated.
+ */
+static bool _calcMemoKey(EVP_MD_CTX* mdCtx, uint64_t serial, uint32_t as,
+                         uint8_t* digest, BGPSecSigSegment* sig, 
+                         uint8_t* memoKey)
+{
+  uint8_t buf[12];
+  int     idx;
+
+  for (idx = 0; idx < 8; idx++)
+  {
+    buf[idx] = (uint8_t)(serial >> (56 - idx * 8));
+  }
+  buf[8]  = (uint8_t)(as >> 24);
+  buf[9]  = (uint8_t)(as >> 16);
+  buf[10] = (uint8_t)(as >> 8);
+  buf[11] = (uint8_t)as;
+
+  return EVP_DigestInit_ex(mdCtx, EVP_sha256(), NULL) == 1
+         && EVP_DigestUpdate(mdCtx, buf, sizeof(buf)) == 1
+         && EVP_DigestUpdate(mdCtx, sig->ski, KC_SKI_LENGTH) == 1
+         && EVP_DigestUpdate(mdCtx, digest, BGPSEC_DIGEST_LEN) == 1
+         && EVP_DigestUpdate(mdCtx, sig->sig, sig->sigLen) == 1
+         && EVP_DigestFinal_ex(mdCtx, memoKey, NULL) == 1;
+}
+
+/**
+ * Verify the signature of the given segment. The result is taken from and
+ * stored in the signature memo.
+ *
+ * @param self Instance
+ * @param mdCtx The digest context to use.
+ * @param localAS The AS number of the router that received the update.
+ * @param prefix The prefix of the update.
+ * @param path The first Secure_Path segment.
+ * @param sigs The signature segments.
+ * @param noSegments The number of segments.
+ * @param signer The segment of the signer.
+ * @param updateID The update registered with the SKI of the signature, NULL
+ *                 if none.
+ *
+ * @return true if the signature is valid.
+ */
+static bool _verifySegment(BGPSecHandler* self, EVP_MD_CTX* mdCtx,
+                           uint32_t localAS, IPPrefix* prefix, uint8_t* path,
+                           BGPSecSigSegment* sigs, uint16_t noSegments,
+                           uint16_t signer, SRxUpdateID* updateID)
+{
+  uint32_t  as = _read32(path + signer * BGPSEC_SP_SEGMENT_LEN + 2);
+  uint64_t  serial;
+  EVP_PKEY* key;
+  uint8_t   digest[BGPSEC_DIGEST_LEN];
+  uint8_t   memoKey[SIG_MEMO_KEY_LENGTH];
+  bool      memoOK;
+  bool      valid = false;
+
+  // Registered before the lookup, a key stored meanwhile revalidates.
+  if (updateID != NULL)
+  {
+    addUpdateToKey(self->keyCache, sigs[signer].ski, *updateID, localAS);
+  }
+  key = getRouterKey(self->keyCache, as, sigs[signer].ski, &serial);
+
+  // A missing key is not memorized, it might be received later.
+  if (   (key != NULL)
+      && _calcDigest(mdCtx, localAS, prefix, path, sigs, noSegments, signer, 
+                     digest))
+  {
+    memoOK = (self->sigMemo.sets != NULL)
+             && _calcMemoKey(mdCtx, serial, as, digest, &sigs[signer], 
+                             memoKey);
+    if (!memoOK || !lookupSigMemo(&self->sigMemo, memoKey, &valid))
+    {
+      valid = _verifySignature(key, digest, &sigs[signer]);
+      if (memoOK)
+      {
+        storeSigMemo(&self->sigMemo, memoKey, valid);
+      }
+    }
+  }
+  EVP_PKEY_free(key);
+
+  return valid;
+}
+
+/**
+ * Validate the path with the given digest context.
+ *
+ * @param self Instance
+ * @param mdCtx The digest context to use.
+ * @param localAS The AS number of the router that received the update.
+ * @param prefix The prefix of the update.
+ * @param attr The BGPSec path attribute including its attribute header.
+ * @param attrLength The length of the attribute.
+ * @param updateID The update registered with the SKIs of the verified
+ *                 signatures, NULL if none.
+ *
+ * @return SRx_RESULT_VALID or SRx_RESULT_INVALID.
+ */
+static uint8_t _validatePath(BGPSecHandler* self, EVP_MD_CTX* mdCtx,
+                             uint32_t localAS, IPPrefix* prefix, 
+                             uint8_t* attr, uint16_t attrLength,
+                             SRxUpdateID* updateID)
+{
+  uint8_t*          path;
+  uint8_t*          sigBlock;
+  uint16_t          sigBlockLength;
+  uint16_t          noSegments;
+  uint16_t          idx;
+  BGPSecSigSegment* sigs;
+  uint8_t           result = SRx_RESULT_INVALID;
+
+  if (!_parseAttribute(attr, attrLength, &path, &noSegments, 
+                       &sigBlock, &sigBlockLength))
+  {
+    LOG(LEVEL_DEBUG, HDR "Malformed or unsupported BGPSec path attribute", 
+        pthread_self());
+    return SRx_RESULT_INVALID;
+  }
+  sigs = malloc(noSegments * sizeof(BGPSecSigSegment));
+  if (sigs == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory to validate the BGPSec path!");
+    return SRx_RESULT_INVALID;
+  }
+
+  if (_parseSignatures(sigBlock, sigBlockLength, sigs, noSegments))
+  {
+    result = SRx_RESULT_VALID;
+    for (idx = 0; (idx < noSegments) && (result == SRx_RESULT_VALID); idx++)
+    {
+      if (!_verifySegment(self, mdCtx, localAS, prefix, path, sigs, 
+                          noSegments, idx, updateID))
+      {
+        result = SRx_RESULT_INVALID;
+      }
+    }
+  }
+  free(sigs);
+
+  return result;
+}
+
+/**
+ * Write an unsigned 16 bit value in network byte order.
+ *
+ * @param data The destination.
+ * @param value The value.
+ */
+static inline void _write16(uint8_t* data, uint16_t value)
+{
+  data[0] = (uint8_t)(value >> 8);
+  data[1] = (uint8_t)value;
+}
+
+/**
+ * Write an unsigned 32 bit value in network byte order.
+ *
+ * @param data The destination.
+ * @param value The value.
+ */
+static inline void _write32(uint8_t* data, uint32_t value)
+{
+  data[0] = (uint8_t)(value >> 24);
+  data[1] = (uint8_t)(value >> 16);
+  data[2] = (uint8_t)(value >> 8);
+  data[3] = (uint8_t)value;
+}
+
+/**
+ * Prepare the data signed by the router (RFC 8205, section 4.2) for all 
+ * signing requests of the update. The target AS and the own Secure_Path
+ * segment are filled in per request by _signPath.
+ *
+ * @param prefix The prefix of the update.
+ * @param attr The received BGPSec path attribute, NULL for originated 
+ *             updates.
+ * @param attrLength The length of the attribute.
+ * @param data OUT - The prepared data, references the attribute.
+ *
+ * @return false if the attribute is malformed or not enough memory was 
+ *         available.
+ */
+static bool _prepareSignData(IPPrefix* prefix, uint8_t* attr, 
+                             uint16_t attrLength, BGPSecSignData* data)
+{
+  BGPSecSigSegment* sigs = NULL;
+  uint16_t          plen = (prefix->length + 7) / 8;
+  uint16_t          idx;
+  uint8_t*          pos;
+  uint32_t          segLen;
+
+  memset(data, 0, sizeof(BGPSecSignData));
+  if (attr != NULL)
+  {
+    if (!_parseAttribute(attr, attrLength, &data->path, &data->noSegments,
+                         &data->sigs, &data->sigsLength))
+    {
+      return false;
+    }
+    sigs = malloc(data->noSegments * sizeof(BGPSecSigSegment));
+    if (   (sigs == NULL)
+        || !_parseSignatures(data->sigs, data->sigsLength, sigs, 
+                             data->noSegments))
+    {
+      free(sigs);
+      return false;
+    }
+  }
+
+  // Target, the received signatures each followed by the path segment of 
+  // the next router, the origin segment, algorithm, AFI, SAFI and the NLRI.
+  data->length = 4 + data->sigsLength 
+                 + (data->noSegments + 1) * BGPSEC_SP_SEGMENT_LEN + 5 + plen;
+  data->data   = malloc(data->length);
+  if (data->data == NULL)
+  {
+    free(sigs);
+    return false;
+  }
+
+  pos = data->data + 4;
+  for (idx = 0; idx < data->noSegments; idx++)
+  {
+    segLen = BGPSEC_SIG_SEGMENT_HDR + sigs[idx].sigLen;
+    memcpy(pos, sigs[idx].ski, segLen);
+    pos += segLen;
+    if (idx == 0)
+    {
+      data->ownOffset = pos - data->data;
+    }
+    else
+    {
+      memcpy(pos, data->path + (idx - 1) * BGPSEC_SP_SEGMENT_LEN, 
+             BGPSEC_SP_SEGMENT_LEN);
+    }
+    pos += BGPSEC_SP_SEGMENT_LEN;
+  }
+  if (data->noSegments == 0)
+  {
+    data->ownOffset = 4;
+  }
+  else
+  {
+    memcpy(pos, data->path + (data->noSegments - 1) * BGPSEC_SP_SEGMENT_LEN,
+           BGPSEC_SP_SEGMENT_LEN);
+  }
+  pos += BGPSEC_SP_SEGMENT_LEN;
+
+  pos[0] = BGPSEC_ALGO_ECDSA_P256;
+  _write16(pos + 1, prefix->ip.version == 4 ? 1 : 2);
+  pos[3] = 1;
+  pos[4] = prefix->length;
+  memcpy(pos + 5, prefix->ip.version == 4 ? prefix->ip.addr.v4.u8 
+                                          : prefix->ip.addr.v6.u8, plen);
+  free(sigs);
+
+  return true;
+}
+
+/**
+ * Create the signing context of the loaded private key.
+ *
+ * @param self Instance
+ *
+ * @return The context or NULL if no key is loaded or an error occurred.
+ */
+static EVP_PKEY_CTX* _createSignCtx(BGPSecHandler* self)
+{
+  EVP_PKEY_CTX* ctx;
+
+  if (self->signKey == NULL)
+  {
+    return NULL;
+  }
+  ctx = EVP_PKEY_CTX_new(self->signKey, NULL);
+  if (   (ctx != NULL)
+      && (   (EVP_PKEY_sign_init(ctx) != 1)
+          || (EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha256()) != 1)))
+  {
+    EVP_PKEY_CTX_free(ctx);
+    ctx = NULL;
+  }
+
+  return ctx;
+}
+
+/**
+ * Sign the prepared data for the given peer and create the signature data.
+ *
+ * @param self Instance
+ * @param signCtx The signing context.
+ * @param data The prepared data, the target and own segment are modified.
+ * @param localAS The AS number of the signing router.
+ * @param peerAS The target of the signature.
+ * @param pCount The number of times the own AS is in the path.
+ * @param onlyOwn Create only the own segments, not the whole attribute.
+ * @param block OUT - The signature data, allocated.
+ * @param length OUT - The length of the signature data.
+ *
+ * @return false if the signature could not be created.
+ */
+static bool _signPath(BGPSecHandler* self, EVP_PKEY_CTX* signCtx,
+                      BGPSecSignData* data, uint32_t localAS, uint32_t peerAS,
+                      uint8_t pCount, bool onlyOwn, uint8_t** block, 
+                      uint32_t* length)
+{
+  uint8_t  digest[BGPSEC_DIGEST_LEN];
+  uint8_t  own[BGPSEC_SP_SEGMENT_LEN];
+  uint8_t* sig;
+  size_t   sigLen;
+  uint32_t spLength = 2 + (data->noSegments + 1) * BGPSEC_SP_SEGMENT_LEN;
+  uint32_t sbLength;
+  uint8_t* pos;
+
+  own[0] = pCount;
+  own[1] = 0;
+  _write32(own + 2, localAS);
+  _write32(data->data, peerAS);
+  memcpy(data->data + data->ownOffset, own, BGPSEC_SP_SEGMENT_LEN);
+
+  if (   (EVP_Digest(data->data, data->length, digest, NULL, EVP_sha256(), 
+                     NULL) != 1)
+      || (EVP_PKEY_sign(signCtx, NULL, &sigLen, digest, BGPSEC_DIGEST_LEN) 
+          != 1))
+  {
+    return false;
+  }
+
+  // Reserve the space of the whole attribute, the signature is written 
+  // directly into its place.
+  sbLength = 3 + BGPSEC_SIG_SEGMENT_HDR + sigLen + data->sigsLength;
+  *block   = malloc(4 + spLength + sbLength);
+  if (*block == NULL)
+  {
+    return false;
+  }
+  pos = onlyOwn ? *block : *block + 4 + spLength + 3;
+  sig = pos + (onlyOwn ? BGPSEC_SP_SEGMENT_LEN : 0) + BGPSEC_SIG_SEGMENT_HDR;
+  if (EVP_PKEY_sign(signCtx, sig, &sigLen, digest, BGPSEC_DIGEST_LEN) != 1)
+  {
+    free(*block);
+    *block = NULL;
+    return false;
+  }
+
+  if (onlyOwn)
+  {
+    memcpy(*block, own, BGPSEC_SP_SEGMENT_LEN);
+    memcpy(*block + BGPSEC_SP_SEGMENT_LEN, self->signSKI, KC_SKI_LENGTH);
+    _write16(*block + BGPSEC_SP_SEGMENT_LEN + KC_SKI_LENGTH, sigLen);
+    *length = BGPSEC_SP_SEGMENT_LEN + BGPSEC_SIG_SEGMENT_HDR + sigLen;
+    return true;
+  }
+
+  // The real signature might be shorter than the maximum.
+  sbLength = 3 + BGPSEC_SIG_SEGMENT_HDR + sigLen + data->sigsLength;
+  if (spLength + sbLength > 0xFFFF)
+  {
+    free(*block);
+    *block = NULL;
+    return false;
+  }
+  pos    = *block;
+  pos[0] = 0x80 | BGPSEC_ATTR_FLAG_EXT_LEN;
+  pos[1] = BGPSEC_PATH_ATTR_TYPE;
+  _write16(pos + 2, spLength + sbLength);
+  pos += 4;
+  _write16(pos, spLength);
+  memcpy(pos + 2, own, BGPSEC_SP_SEGMENT_LEN);
+  if (data->noSegments > 0)
+  {
+    memcpy(pos + 2 + BGPSEC_SP_SEGMENT_LEN, data->path, 
+           data->noSegments * BGPSEC_SP_SEGMENT_LEN);
+  }
+  pos += spLength;
+  _write16(pos, sbLength);
+  pos[2] = BGPSEC_ALGO_ECDSA_P256;
+  memcpy(pos + 3, self->signSKI, KC_SKI_LENGTH);
+  _write16(pos + 3 + KC_SKI_LENGTH, sigLen);
+  if (data->sigsLength > 0)
+  {
+    memcpy(pos + 3 + BGPSEC_SIG_SEGMENT_HDR + sigLen, data->sigs, 
+           data->sigsLength);
+  }
+  *length = 4 + spLength + sbLength;
+
+  return true;
+}
+
+/**
+ * Sign the queued job and report the signature to the callback. The data is
+ * prepared once for consecutive jobs of the same update.
+ *
+ * @param self Instance
+ * @param signCtx IN/OUT - The signing context of the worker, created on
+ *                first use.
+ * @param job The signing job.
+ * @param prepared IN/OUT - The job the data was prepared for, NULL if none.
+ * @param data IN/OUT - The prepared data.
+ */
+static void _signJob(BGPSecHandler* self, EVP_PKEY_CTX** signCtx, 
+                     BGPSecJob* job, BGPSecJob** prepared, 
+                     BGPSecSignData* data)
+{
+  uint8_t* block  = NULL;
+  uint32_t length = 0;
+
+  if (   (*prepared == NULL)
+      || ((*prepared)->updateID != job->updateID)
+      || ((*prepared)->localAS != job->localAS)
+      || ((*prepared)->attrLength != job->attrLength)
+      || (memcmp((*prepared)->attr, job->attr, job->attrLength) != 0))
+  {
+    if (*prepared != NULL)
+    {
+      free(data->data);
+      free(*prepared);
+    }
+    // On failure the data stays NULL for all jobs of the update.
+    *prepared = job;
+    _prepareSignData(&job->prefix, job->attrLength > 0 ? job->attr : NULL, 
+                     job->attrLength, data);
+  }
+
+  if ((data->data != NULL) && (*signCtx == NULL))
+  {
+    *signCtx = _createSignCtx(self);
+  }
+  if (   (data->data == NULL) || (*signCtx == NULL)
+      || !_signPath(self, *signCtx, data, job->localAS, job->peerAS, 
+                    job->pCount, job->onlyOwn, &block, &length))
+  {
+    LOG(LEVEL_DEBUG, HDR "Update [0x%08X] could not be signed", 
+        pthread_self(), job->updateID);
+    block  = NULL;
+    length = 0;
+  }
+
+  if (self->signedCallback != NULL)
+  {
+    self->signedCallback(job->updateID, job->clientID, block, length, 
+                         self->signedUser);
+  }
+  free(block);
+  if (*prepared != job)
+  {
+    free(job);
+  }
+}
+
+/**
+ * The loop of a worker thread. The worker takes up to BGPSEC_BATCH_SIZE 
+ * jobs from the queue at once, stores the validation results in the update
+ * cache and reports the signatures to the callback.
+ *
+ * @param arg The BGPSec handler.
+ *
+ * @return NULL
+ */
+static void* _bgpsecWorker(void* arg)
+{
+  BGPSecHandler* self = (BGPSecHandler*)arg;
+  EVP_MD_CTX*    mdCtx = EVP_MD_CTX_new();
+  EVP_PKEY_CTX*  signCtx = NULL;
+  BGPSecJob*     batch;
+  BGPSecJob*     job;
+  BGPSecJob*     prepared;
+  BGPSecSignData data;
+  uint32_t       count;
+  SRxResult      result;
+
+  if (mdCtx == NULL)
+  {
+    RAISE_ERROR("Could not create the digest context of a BGPSec worker!");
+    return NULL;
+  }
+
+  result.roaResult = SRx_RESULT_DONOTUSE;
+  while (true)
+  {
+    lockMutex(&self->queueMutex);
+    while (self->running && (self->head == NULL))
+    {
+      waitCond(&self->queueCond, &self->queueMutex, 0);
+    }
+    if (!self->running)
+    {
+      unlockMutex(&self->queueMutex);
+      break;
+    }
+    batch = self->head;
+    job   = batch;
+    for (count = 1; (count < BGPSEC_BATCH_SIZE) && (job->next != NULL); 
+         count++)
+    {
+      job = job->next;
+    }
+    self->head = job->next;
+    if (self->head == NULL)
+    {
+      self->tail = NULL;
+    }
+    job->next        = NULL;
+    self->queueSize -= count;
+    unlockMutex(&self->queueMutex);
+
+    prepared = NULL;
+    while (batch != NULL)
+    {
+      job   = batch;
+      batch = job->next;
+      if (job->type == BGPSEC_JOB_SIGN)
+      {
+        _signJob(self, &signCtx, job, &prepared, &data);
+        continue;
+      }
+      result.bgpsecResult = _validatePath(self, mdCtx, job->localAS,
+                                          &job->prefix, job->attr, 
+                                          job->attrLength, &job->updateID);
+      // The update might have been removed meanwhile.
+      if (!modifyUpdateResult(self->updCache, &job->updateID, &result))
+      {
+        LOG(LEVEL_DEBUG, HDR "Update [0x%08X] not found, BGPSec result "
+            "dropped", pthread_self(), job->updateID);
+      }
+      free(job);
+    }
+    if (prepared != NULL)
+    {
+      free(data.data);
+      free(prepared);
+    }
+  }
+
+  EVP_PKEY_CTX_free(signCtx);
+  EVP_MD_CTX_free(mdCtx);
+
+  return NULL;
+}
+
+/**
+ * Queue the path validation of the updates depending on a router key that was
+ * stored or deleted. The workers store the new results in the update cache.
+ * Registered with the key cache.
+ *
+ * @param user The BGPSec handler.
+ * @param ski The subject key identifier of the key.
+ * @param deps The updates whose validation used the SKI.
+ * @param count The number of updates.
+ */
+static void _revalidateUpdates(void* user, const uint8_t* ski,
+                               KC_KeyDependent* deps, uint32_t count)
+{
+  BGPSecHandler* self = (BGPSecHandler*)user;
+  IPPrefix       prefix;
+  uint8_t*       attr;
+  uint16_t       attrLength;
+  uint16_t       noHops;
+  uint32_t       queued = 0;
+  uint32_t       idx;
+
+  for (idx = 0; idx < count; idx++)
+  {
+    // The update might have been removed meanwhile.
+    if (   getUpdateSigningData(self->updCache, &deps[idx].updateID, &prefix,
+                                &attr, &attrLength, &noHops)
+        && (attr != NULL)
+        && queueBGPSecValidation(self, deps[idx].updateID,
+                                 deps[idx].localAS, &prefix, attr,
+                                 attrLength))
+    {
+      queued++;
+    }
+    free(attr);
+  }
+  LOG(LEVEL_INFO, "Router key change, %u of %u update(s) queued for the "
+                  "BGPSec revalidation", queued, count);
+}
+
+/**
+ * Initializes the handler, registers an existing Key Cache and starts the
+ * worker threads. Storing or deleting a router key in the Key Cache
+ * revalidates the updates depending on it.
+ *
+ * @param self Variable that should be initialized
+ * @param keyCache Existing Key Cache, its update cache receives the results
+ * @param serverHost BGPSec/Router protocol server host name
+ * @param serverPort BGPSec/Router protocol server port number
+ * @param noWorkers The number of path validation threads (since 0.4.1.0)
+ * @param memoSize The number of signature verifications memorized, 0 
+ *                 disables the memo (since 0.4.1.0)
+ * @return \c true = successful, \c false = an error occurred
+ */
 bool createBGPSecHandler(BGPSecHandler* self, KeyCache* keyCache,
-                         const char* serverHost, int serverPort) 
+                         const char* serverHost, int serverPort,
+                         uint8_t noWorkers, uint32_t memoSize) 
 {
-  LOG(LEVEL_DEBUG, FILE_LINE_INFO 
-                 " createBGPSecHandler is not implemented yet - returns true!");
+  char name[THREAD_NAME_LEN + 1];
+
+  memset(self, 0, sizeof(BGPSecHandler));
   self->keyCache = keyCache;
+  self->updCache = keyCache->updateCache;
+  self->running  = true;
+
+  if (noWorkers == 0)
+  {
+    noWorkers = 1;
+  }
+  self->workers = calloc(noWorkers, sizeof(pthread_t));
+  if (self->workers == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the BGPSec workers!");
+    return false;
+  }
+  if (!initMutex(&self->queueMutex))
+  {
+    RAISE_SYS_ERROR("Could not initialize the BGPSec queue mutex!");
+    free(self->workers);
+    self->workers = NULL;
+    return false;
+  }
+  setLockName(&self->queueMutex, "bgpsecHandler.queueMutex");
+  initCond(&self->queueCond);
+  // Without memo all signatures are verified.
+  initSigMemo(&self->sigMemo, memoSize);
+
+  for (self->noWorkers = 0; self->noWorkers < noWorkers; self->noWorkers++)
+  {
+    snprintf(name, sizeof(name), "srx-bgpsec-%u", self->noWorkers);
+    if (createThread(&self->workers[self->noWorkers], NULL,
+                     THREAD_CLASS_BGPSEC, name, _bgpsecWorker, self) != 0)
+    {
+      RAISE_ERROR("Failed to start BGPSec worker %u of %u - stopping", 
+                  self->noWorkers + 1, noWorkers);
+      releaseBGPSecHandler(self);
+      return false;
+    }
+  }
+
+  LOG(LEVEL_INFO, "- %u BGPSec worker thread(s) started!", self->noWorkers);
+  setKeyInvalidatedCallback(keyCache, _revalidateUpdates, self);
+
   return true;
 }
 
+/**
+ * Stops the worker threads and frees all allocated resources. Queued 
+ * validations are dropped.
+ * 
+ * @param self Instance
+ */
 void releaseBGPSecHandler(BGPSecHandler* self) 
 {
-  LOG(LEVEL_DEBUG, 
-      FILE_LINE_INFO "releaseBGPSecHandler is not implemented yet!");
+  BGPSecJob* job;
+  uint8_t    idx;
+
+  if (self->workers == NULL)
+  {
+    return;
+  }
+
+  setKeyInvalidatedCallback(self->keyCache, NULL, NULL);
+  lockMutex(&self->queueMutex);
+  self->running = false;
+  pthread_cond_broadcast(&self->queueCond);
+  unlockMutex(&self->queueMutex);
+
+  for (idx = 0; idx < self->noWorkers; idx++)
+  {
+    pthread_join(self->workers[idx], NULL);
+  }
+  free(self->workers);
+  self->workers   = NULL;
+  self->noWorkers = 0;
+
+  while (self->head != NULL)
+  {
+    job        = self->head;
+    self->head = job->next;
+    free(job);
+  }
+  self->tail      = NULL;
+  self->queueSize = 0;
+
+  destroyCond(&self->queueCond);
+  releaseMutex(&self->queueMutex);
+  releaseSigMemo(&self->sigMemo);
+  EVP_PKEY_free(self->signKey);
+  self->signKey = NULL;
 }
 
+/**
+ * Loads the private EC key of the router (PEM) and calculates its subject key
+ * identifier. The key must be loaded before signing requests are queued and
+ * can not be replaced.
+ *
+ * @param self Instance
+ * @param filename Filename of the private key
+ * @return \c true = key loaded, \c false = invalid key, or file does not exist
+ */
 bool loadPrivateKey(BGPSecHandler* self, const char* filename) 
 {
-  LOG(LEVEL_DEBUG, 
-      FILE_LINE_INFO "loadPrivateKey is not implemented yet!");
+  FILE*          file;
+  EVP_PKEY*      key;
+  X509_PUBKEY*   pubKey = NULL;
+  const uint8_t* bits;
+  int            bitsLength;
+  char           curve[32];
+  bool           ok;
+
+  if (self->signKey != NULL)
+  {
+    RAISE_ERROR("The private key of the router can not be replaced!");
+    return false;
+  }
+  file = fopen(filename, "r");
+  if (file == NULL)
+  {
+    RAISE_SYS_ERROR("Could not open the private key file '%s'", filename);
+    return false;
+  }
+  key = PEM_read_PrivateKey(file, NULL, NULL, NULL);
+  fclose(file);
+  if (key == NULL)
+  {
+    RAISE_ERROR("The file '%s' does not contain a private key", filename);
+    return false;
+  }
+
+  // Only ECDSA P-256 is supported (RFC 8208), the SKI is the SHA-1 hash of
+  // the public key bits.
+  ok =    (EVP_PKEY_get_base_id(key) == EVP_PKEY_EC)
+       && (EVP_PKEY_get_group_name(key, curve, sizeof(curve), NULL) == 1)
+       && (strcmp(curve, "prime256v1") == 0)
+       && (X509_PUBKEY_set(&pubKey, key) == 1)
+       && (X509_PUBKEY_get0_param(NULL, &bits, &bitsLength, NULL, pubKey) 
+           == 1)
+       && (EVP_Digest(bits, bitsLength, self->signSKI, NULL, EVP_sha1(), 
+                      NULL) == 1);
+  X509_PUBKEY_free(pubKey);
+  if (!ok)
+  {
+    RAISE_ERROR("The private key in '%s' is not an ECDSA P-256 key", 
+                filename);
+    EVP_PKEY_free(key);
+    return false;
+  }
+  self->signKey = key;
+  LOG(LEVEL_INFO, "- Loaded the private key of the router from '%s'", 
+      filename);
+
   return true;
 }
 
-uint8_t validateSignature(BGPSecHandler* self) 
+/**
+ * Register the callback that receives the signatures of queued signing 
+ * requests. Must be called before signing requests are queued.
+ *
+ * @param self Instance
+ * @param callback The callback.
+ * @param user The user pointer given to the callback.
+ *
+ * @since 0.4.1.0
+ */
+void setBGPSecSignedCallback(BGPSecHandler* self, BGPSecSigned callback,
+                             void* user)
 {
-  LOG(LEVEL_DEBUG, FILE_LINE_INFO 
-                  " validateSignature is not implemented yet - returns valid!");
-  return SRx_RESULT_VALID;
+  self->signedCallback = callback;
+  self->signedUser     = user;
 }
 
-bool createSignature(BGPSecHandler* self) 
+/**
+ * Validates the BGPSec path attribute of an update (RFC 8205, section 5.2).
+ * The path is valid if all signatures of the ECDSA P-256 signature block are
+ * verified. The router keys are fetched from the registered Key Cache. 
+ * Signatures verified before with the same router key are not verified again.
+ *
+ * @param self Instance
+ * @param localAS The AS number of the router that received the update, the 
+ *                target of the most recent signature.
+ * @param prefix The prefix of the update.
+ * @param attr The BGPSec path attribute including its attribute header.
+ * @param attrLength The length of the attribute.
+ *
+ * @return SRx_RESULT_VALID or SRx_RESULT_INVALID.
+ *
+ * @since 0.4.1.0
+ */
+uint8_t validateBGPSecPath(BGPSecHandler* self, uint32_t localAS,
+                           IPPrefix* prefix, uint8_t* attr, 
+                           uint16_t attrLength)
 {
-  LOG(LEVEL_DEBUG, FILE_LINE_INFO 
-                   " createSignature is not implemented yet - returns false!");
-  return false;
+  EVP_MD_CTX* mdCtx = EVP_MD_CTX_new();
+  uint8_t     result = SRx_RESULT_INVALID;
+
+  if (mdCtx != NULL)
+  {
+    result = _validatePath(self, mdCtx, localAS, prefix, attr, attrLength,
+                           NULL);
+    EVP_MD_CTX_free(mdCtx);
+  }
+
+  return result;
 }
 
+/**
+ * Append the job to the queue and wake up a worker. The job is released if
+ * it could not be queued.
+ *
+ * @param self Instance
+ * @param job The job.
+ *
+ * @return false if the workers stopped.
+ */
+static bool _queueJob(BGPSecHandler* self, BGPSecJob* job)
+{
+  bool queued = false;
+
+  lockMutex(&self->queueMutex);
+  if (self->running && (self->noWorkers > 0))
+  {
+    if (self->tail != NULL)
+    {
+      self->tail->next = job;
+    }
+    else
+    {
+      self->head = job;
+    }
+    self->tail = job;
+    self->queueSize++;
+    signalCond(&self->queueCond);
+    queued = true;
+  }
+  unlockMutex(&self->queueMutex);
+
+  if (!queued)
+  {
+    free(job);
+  }
+
+  return queued;
+}
+
+/**
+ * Queue the path validation of the update. A worker thread validates the 
+ * path and stores the result in the update cache. The attribute is copied.
+ *
+ * @param self Instance
+ * @param updateID The ID of the update.
+ * @param localAS The AS number of the router that received the update.
+ * @param prefix The prefix of the update.
+ * @param attr The BGPSec path attribute including its attribute header.
+ * @param attrLength The length of the attribute.
+ *
+ * @return false if not enough memory was available or the workers stopped.
+ *
+ * @since 0.4.1.0
+ */
+bool queueBGPSecValidation(BGPSecHandler* self, SRxUpdateID updateID, 
+                           uint32_t localAS, IPPrefix* prefix, uint8_t* attr,
+                           uint16_t attrLength)
+{
+  BGPSecJob* job = malloc(sizeof(BGPSecJob) + attrLength);
+
+  if (job == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory to queue the BGPSec validation!");
+    return false;
+  }
+  memset(job, 0, sizeof(BGPSecJob));
+  job->type       = BGPSEC_JOB_VALIDATE;
+  job->updateID   = updateID;
+  job->localAS    = localAS;
+  job->prefix     = *prefix;
+  job->attrLength = attrLength;
+  memcpy(job->attr, attr, attrLength);
+
+  return _queueJob(self, job);
+}
+
+/**
+ * Return the number of queued path validations.
+ *
+ * @param self Instance
+ *
+ * @return The number of queued validations.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t getBGPSecQueueSize(BGPSecHandler* self)
+{
+  return self->queueSize;
+}
+
+/**
+ * Sign the update for the peer (RFC 8205, section 4.2). The own Secure_Path
+ * segment is added to the received path and signed with the loaded private 
+ * key. Signature blocks of other algorithm suites are dropped.
+ *
+ * @param self Instance
+ * @param request The signing request.
+ * @param block OUT - The signature data, see BGPSecSignRequest.onlyOwn. Must 
+ *              be released by the caller using free.
+ * @param length OUT - The length of the signature data.
+ *
+ * @return false if no key is loaded, the received attribute is malformed, or
+ *         the signature could not be created.
+ *
+ * @since 0.4.1.0
+ */
+bool signBGPSecPath(BGPSecHandler* self, BGPSecSignRequest* request,
+                    uint8_t** block, uint32_t* length)
+{
+  EVP_PKEY_CTX*  signCtx = _createSignCtx(self);
+  BGPSecSignData data;
+  bool           ok = false;
+
+  *block  = NULL;
+  *length = 0;
+  if (   (signCtx != NULL)
+      && _prepareSignData(&request->prefix, request->attr, 
+                          request->attrLength, &data))
+  {
+    ok = _signPath(self, signCtx, &data, request->localAS, request->peerAS, 
+                   request->pCount, request->onlyOwn, block, length);
+    free(data.data);
+  }
+  EVP_PKEY_CTX_free(signCtx);
+
+  return ok;
+}
+
+/**
+ * Queue the signing of the update. A worker thread signs the update and 
+ * reports the signature to the registered callback. Requests for the same 
+ * update queued together share the preparation of the signed data. The 
+ * attribute is copied.
+ *
+ * @param self Instance
+ * @param request The signing request.
+ *
+ * @return false if not enough memory was available or the workers stopped.
+ *
+ * @since 0.4.1.0
+ */
+bool queueBGPSecSigning(BGPSecHandler* self, BGPSecSignRequest* request)
+{
+  uint16_t   attrLength = request->attr != NULL ? request->attrLength : 0;
+  BGPSecJob* job = malloc(sizeof(BGPSecJob) + attrLength);
+
+  if (job == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory to queue the BGPSec signing!");
+    return false;
+  }
+  memset(job, 0, sizeof(BGPSecJob));
+  job->type       = BGPSEC_JOB_SIGN;
+  job->updateID   = request->updateID;
+  job->clientID   = request->clientID;
+  job->localAS    = request->localAS;
+  job->peerAS     = request->peerAS;
+  job->pCount     = request->pCount;
+  job->onlyOwn    = request->onlyOwn;
+  job->prefix     = request->prefix;
+  job->attrLength = attrLength;
+  if (attrLength > 0)
+  {
+    memcpy(job->attr, request->attr, attrLength);
+  }
+
+  return _queueJob(self, job);
+}
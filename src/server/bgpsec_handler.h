@@ -19,13 +19,23 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0.10
+ * The BGPSec handler validates BGPSec paths (RFC 8205) using the router keys
+ * of the key cache. The validations are executed by a pool of worker threads,
+ * separate from the command handler, and the results are stored in the update
+ * cache.
  *
- *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Added the worker pool, queueBGPSecValidation and 
+ *              getBGPSecQueueSize.
+ *            * Replaced validateSignature with validateBGPSecPath.
+ *            * Added the signature memo.
+ *            * Added the signing of updates: loadPrivateKey, signBGPSecPath,
+ *              queueBGPSecSigning and setBGPSecSignedCallback. Removed the 
+ *              stub createSignature.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Added Changelog
  *            * Fixed speller in documentation header
@@ -36,40 +46,137 @@
 #ifndef __BGPSEC_HANDLER_H__
 #define __BGPSEC_HANDLER_H__
 
+#include <pthread.h>
+#include <openssl/evp.h>
 #include "server/key_cache.h"
+#include "server/sig_memo.h"
+#include "server/update_cache.h"
 #include "shared/srx_defs.h"
+#include "util/mutex.h"
+#include "util/prefix.h"
+
+/** The type code of the BGPSec path attribute. @since 0.4.1.0 */
+#define BGPSEC_PATH_ATTR_TYPE   33
+/** The algorithm suite ECDSA P-256 with SHA-256 (RFC 8208). 
+ * @since 0.4.1.0 */
+#define BGPSEC_ALGO_ECDSA_P256  1
+/** The maximum number of validations and signings a worker takes from the 
+ * queue at once. @since 0.4.1.0 */
+#define BGPSEC_BATCH_SIZE       32
+
+/** A queued path validation or signing, defined in bgpsec_handler.c. */
+typedef struct _BGPSecJob BGPSecJob;
+
+/**
+ * A request to sign an update for a peer.
+ *
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** The ID of the update. */
+  SRxUpdateID updateID;
+  /** The client that requested the signature. */
+  uint8_t     clientID;
+  /** The AS number of the signing router. */
+  uint32_t    localAS;
+  /** The peer AS the update is sent to, the target of the signature. */
+  uint32_t    peerAS;
+  /** The number of times the own AS is in the path (1 = no prepending). */
+  uint8_t     pCount;
+  /** Return only the own Secure_Path and signature segment, otherwise the
+   * complete BGPSec path attribute. */
+  bool        onlyOwn;
+  /** The prefix of the update. */
+  IPPrefix    prefix;
+  /** The BGPSec path attribute received with the update, NULL for updates
+   * originated by the router. */
+  uint8_t*    attr;
+  /** The length of the attribute. */
+  uint16_t    attrLength;
+} BGPSecSignRequest;
+
+/**
+ * Called by a worker thread for each queued signing request.
+ *
+ * @param updateID The ID of the update.
+ * @param clientID The client that requested the signature.
+ * @param block The signature data, NULL if the update could not be signed.
+ *              Only valid during the call.
+ * @param length The length of the signature data.
+ * @param user The user pointer given to setBGPSecSignedCallback.
+ *
+ * @since 0.4.1.0
+ */
+typedef void (*BGPSecSigned)(SRxUpdateID updateID, uint8_t clientID, 
+                             uint8_t* block, uint32_t length, void* user);
 
 /** 
  * A single BGPSec Handler.
  */
 typedef struct {
-  KeyCache* keyCache;
+  KeyCache*         keyCache;
+  /** The update cache the results are stored in. @since 0.4.1.0 */
+  UpdateCache*      updCache;
+  
+  /** The worker threads. @since 0.4.1.0 */
+  pthread_t*        workers;
+  /** The number of worker threads. @since 0.4.1.0 */
+  uint8_t           noWorkers;
+  /** Protects the queue. @since 0.4.1.0 */
+  Mutex             queueMutex;
+  /** Signaled when validations are queued or the workers stop. 
+   * @since 0.4.1.0 */
+  Cond              queueCond;
+  /** The first queued validation. @since 0.4.1.0 */
+  BGPSecJob*        head;
+  /** The last queued validation. @since 0.4.1.0 */
+  BGPSecJob*        tail;
+  /** The number of queued validations. @since 0.4.1.0 */
+  volatile uint32_t queueSize;
+  /** Indicates that the workers keep running. @since 0.4.1.0 */
+  volatile bool     running;
+  /** The results of verified signatures. @since 0.4.1.0 */
+  SigMemo           sigMemo;
+  /** The private key of the router, NULL if not loaded. @since 0.4.1.0 */
+  EVP_PKEY*         signKey;
+  /** The subject key identifier of the private key. @since 0.4.1.0 */
+  uint8_t           signSKI[KC_SKI_LENGTH];
+  /** Receives the signatures. @since 0.4.1.0 */
+  BGPSecSigned      signedCallback;
+  /** The user pointer of the callback. @since 0.4.1.0 */
+  void*             signedUser;
 } BGPSecHandler;
 
 /**
- * Initializes the handler and registers an existing Key Cache.
+ * Initializes the handler, registers an existing Key Cache and starts the
+ * worker threads. Storing or deleting a router key in the Key Cache
+ * revalidates the updates depending on it.
  *
  * @param self Variable that should be initialized
- * @param keyCache Existing Key Cache
+ * @param keyCache Existing Key Cache, its update cache receives the results
  * @param serverHost BGPSec/Router protocol server host name
  * @param serverPort BGPSec/Router protocol server port number
+ * @param noWorkers The number of path validation threads (since 0.4.1.0)
+ * @param memoSize The number of signature verifications memorized, 0 
+ *                 disables the memo (since 0.4.1.0)
  * @return \c true = successful, \c false = an error occurred
  */
 bool createBGPSecHandler(BGPSecHandler* self, KeyCache* keyCache,
-                         const char* serverHost, int serverPort);
+                         const char* serverHost, int serverPort,
+                         uint8_t noWorkers, uint32_t memoSize);
 
 /**
- * Frees all allocated resources.
+ * Stops the worker threads and frees all allocated resources. Queued 
+ * validations are dropped.
  * 
  * @param self Instance
  */
 void releaseBGPSecHandler(BGPSecHandler* self);
 
 /**
- * Loads a private key. 
- * At least one call is necessary before createSignature can be used.
- *
- * @todo Adjust parameter if necessary
+ * Loads the private EC key of the router (PEM) and calculates its subject key
+ * identifier. The key must be loaded before signing requests are queued and
+ * can not be replaced.
  *
  * @param self Instance
  * @param filename Filename of the private key
@@ -78,27 +185,102 @@ void releaseBGPSecHandler(BGPSecHandler* self);
 bool loadPrivateKey(BGPSecHandler* self, const char* filename);
 
 /**
- * Validates the signature of a given Byte-stream. 
- * The keys are fetched from the registered Key Cache.
+ * Register the callback that receives the signatures of queued signing 
+ * requests. Must be called before signing requests are queued.
+ *
+ * @param self Instance
+ * @param callback The callback.
+ * @param user The user pointer given to the callback.
+ *
+ * @since 0.4.1.0
+ */
+void setBGPSecSignedCallback(BGPSecHandler* self, BGPSecSigned callback,
+                             void* user);
+
+/**
+ * Validates the BGPSec path attribute of an update (RFC 8205, section 5.2).
+ * The path is valid if all signatures of the ECDSA P-256 signature block are
+ * verified. The router keys are fetched from the registered Key Cache. 
+ * Signatures verified before with the same router key are not verified again.
+ *
+ * @param self Instance
+ * @param localAS The AS number of the router that received the update, the 
+ *                target of the most recent signature.
+ * @param prefix The prefix of the update.
+ * @param attr The BGPSec path attribute including its attribute header.
+ * @param attrLength The length of the attribute.
+ *
+ * @return SRx_RESULT_VALID or SRx_RESULT_INVALID.
+ *
+ * @since 0.4.1.0
+ */
+uint8_t validateBGPSecPath(BGPSecHandler* self, uint32_t localAS,
+                           IPPrefix* prefix, uint8_t* attr, 
+                           uint16_t attrLength);
+
+/**
+ * Queue the path validation of the update. A worker thread validates the 
+ * path and stores the result in the update cache. The attribute is copied.
  *
- * The return value is one of SRX_RES_BGPSEC_* - \ref result_values.
+ * @param self Instance
+ * @param updateID The ID of the update.
+ * @param localAS The AS number of the router that received the update.
+ * @param prefix The prefix of the update.
+ * @param attr The BGPSec path attribute including its attribute header.
+ * @param attrLength The length of the attribute.
+ *
+ * @return false if not enough memory was available or the workers stopped.
  *
- * @todo Adjust parameters once the specification has been finalized
+ * @since 0.4.1.0
+ */
+bool queueBGPSecValidation(BGPSecHandler* self, SRxUpdateID updateID, 
+                           uint32_t localAS, IPPrefix* prefix, uint8_t* attr,
+                           uint16_t attrLength);
+
+/**
+ * Return the number of queued path validations and signings.
  *
  * @param self Instance
- * @return \c 0 = valid (SRX_RES_VALID), or SRX_RES_BGPSEC_*
+ *
+ * @return The number of queued validations and signings.
+ *
+ * @since 0.4.1.0
  */
-uint8_t validateSignature(BGPSecHandler* self);
+uint32_t getBGPSecQueueSize(BGPSecHandler* self);
 
 /**
- * Creates a signature for a given Byte-stream.
+ * Sign the update for the peer (RFC 8205, section 4.2). The own Secure_Path
+ * segment is added to the received path and signed with the loaded private 
+ * key. Signature blocks of other algorithm suites are dropped.
+ *
+ * @param self Instance
+ * @param request The signing request.
+ * @param block OUT - The signature data, see BGPSecSignRequest.onlyOwn. Must 
+ *              be released by the caller using free.
+ * @param length OUT - The length of the signature data.
+ *
+ * @return false if no key is loaded, the received attribute is malformed, or
+ *         the signature could not be created.
  *
- * @todo Adjust parameters (e.g. AS to identify the private key, etc.)
+ * @since 0.4.1.0
+ */
+bool signBGPSecPath(BGPSecHandler* self, BGPSecSignRequest* request,
+                    uint8_t** block, uint32_t* length);
+
+/**
+ * Queue the signing of the update. A worker thread signs the update and 
+ * reports the signature to the registered callback. Requests for the same 
+ * update queued together share the preparation of the signed data. The 
+ * attribute is copied.
  *
  * @param self Instance
- * @return \c true = signatures created, \c false = unknown key/internal error
+ * @param request The signing request.
+ *
+ * @return false if not enough memory was available or the workers stopped.
+ *
+ * @since 0.4.1.0
  */
-bool createSignature(BGPSecHandler* self);
+bool queueBGPSecSigning(BGPSecHandler* self, BGPSecSignRequest* request);
 
 #endif // !__BGPSEC_HANDLER_H__
 
@@ -0,0 +1,291 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ *            * Account the blobs and buckets under MEM_TAG_BLOBS.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "server/blob_store.h"
+#include "shared/crc32.h"
+#include "util/log.h"
+#include "util/mem_stats.h"
+
+/** The size of each slab of the blob pool in bytes. */
+#define BLOB_STORE_SLAB_SIZE 65536
+
+/** A stored blob. */
+struct _StoredBlob {
+  /** The next blob within the bucket. */
+  StoredBlob* next;
+  /** The CRC-32C of the content. */
+  uint32_t    hash;
+  /** The number of references. */
+  uint32_t    refCount;
+  /** The length of the content. */
+  uint32_t    length;
+  /** The content. */
+  uint8_t     data[];
+};
+
+/** Returns the stored blob of the given handle. */
+#define STORED_BLOB(HANDLE) \
+  ((StoredBlob*)((uint8_t*)(HANDLE) - offsetof(StoredBlob, data)))
+
+/**
+ * Double the number of buckets once the store holds more blobs than buckets.
+ * The store keeps working with the old buckets if no memory is available.
+ *
+ * @param self The store.
+ */
+static void _grow(BlobStore* self)
+{
+  uint32_t     newMask = (self->mask << 1) | 1;
+  StoredBlob** buckets = calloc(newMask + 1, sizeof(StoredBlob*));
+  StoredBlob*  blob;
+  uint32_t     idx;
+
+  if (buckets == NULL)
+  {
+    return;
+  }
+  for (idx = 0; idx <= self->mask; idx++)
+  {
+    while ((blob = self->buckets[idx]) != NULL)
+    {
+      self->buckets[idx] = blob->next;
+      blob->next = buckets[blob->hash & newMask];
+      buckets[blob->hash & newMask] = blob;
+    }
+  }
+  addMemStats(MEM_TAG_BLOBS, (int64_t)(newMask - self->mask)
+                             * sizeof(StoredBlob*), 0);
+  free(self->buckets);
+  self->buckets = buckets;
+  self->mask    = newMask;
+}
+
+/**
+ * Find the stored blob.
+ *
+ * @param self The store.
+ * @param hash The CRC-32C of the content.
+ * @param data The content.
+ * @param length The length of the content.
+ *
+ * @return The stored blob or NULL.
+ */
+static StoredBlob* _find(BlobStore* self, uint32_t hash, const uint8_t* data,
+                         uint32_t length)
+{
+  StoredBlob* blob;
+
+  for (blob = self->buckets[hash & self->mask]; blob != NULL; 
+       blob = blob->next)
+  {
+    if (   (blob->hash == hash) && (blob->length == length)
+        && (memcmp(blob->data, data, length) == 0))
+    {
+      break;
+    }
+  }
+
+  return blob;
+}
+
+/**
+ * Initialize the empty store.
+ *
+ * @param self The store.
+ *
+ * @return false if not enough memory was available.
+ */
+bool initBlobStore(BlobStore* self)
+{
+  memset(self, 0, sizeof(BlobStore));
+  self->buckets = calloc(BLOB_STORE_INIT_BUCKETS, sizeof(StoredBlob*));
+  if (self->buckets == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the blob store!");
+    return false;
+  }
+  self->mask = BLOB_STORE_INIT_BUCKETS - 1;
+  if (!initSizeClassPool(&self->pool, BLOB_STORE_SLAB_SIZE))
+  {
+    free(self->buckets);
+    self->buckets = NULL;
+    return false;
+  }
+  setSizeClassPoolTag(&self->pool, MEM_TAG_BLOBS);
+  addMemStats(MEM_TAG_BLOBS, BLOB_STORE_INIT_BUCKETS * sizeof(StoredBlob*), 0);
+
+  return true;
+}
+
+/**
+ * Release all blobs and the store itself.
+ *
+ * @param self The store.
+ */
+void releaseBlobStore(BlobStore* self)
+{
+  if (self->buckets != NULL)
+  {
+    emptyBlobStore(self);
+    addMemStats(MEM_TAG_BLOBS,
+                -(int64_t)((self->mask + 1) * sizeof(StoredBlob*)), 0);
+    free(self->buckets);
+    self->buckets = NULL;
+    releaseSizeClassPool(&self->pool);
+  }
+}
+
+/**
+ * Release all blobs, the buckets are kept. All blob handles become invalid.
+ *
+ * @param self The store.
+ */
+void emptyBlobStore(BlobStore* self)
+{
+  StoredBlob* blob;
+  uint32_t    idx;
+
+  for (idx = 0; idx <= self->mask; idx++)
+  {
+    while ((blob = self->buckets[idx]) != NULL)
+    {
+      self->buckets[idx] = blob->next;
+      freeToSizeClassPool(&self->pool, blob, 
+                          sizeof(StoredBlob) + blob->length);
+    }
+  }
+  self->noBlobs      = 0;
+  self->noReferences = 0;
+  self->size         = 0;
+}
+
+/**
+ * Return the stored blob with the given content and add a reference to it. 
+ * The blob is stored if it is not known yet.
+ *
+ * @param self The store.
+ * @param data The content.
+ * @param length The length of the content, must be > 0.
+ *
+ * @return The handle of the stored blob, it points to the stored content 
+ *         which must not be modified. NULL if not enough memory was 
+ *         available.
+ */
+uint8_t* internBlob(BlobStore* self, const uint8_t* data, uint32_t length)
+{
+  uint32_t    hash = crc32c(0, data, length);
+  StoredBlob* blob = _find(self, hash, data, length);
+
+  if (blob == NULL)
+  {
+    blob = allocFromSizeClassPool(&self->pool, sizeof(StoredBlob) + length);
+    if (blob == NULL)
+    {
+      return NULL;
+    }
+    blob->hash     = hash;
+    blob->refCount = 0;
+    blob->length   = length;
+    memcpy(blob->data, data, length);
+    blob->next = self->buckets[hash & self->mask];
+    self->buckets[hash & self->mask] = blob;
+    self->noBlobs++;
+    self->size += length;
+    if (self->noBlobs > self->mask)
+    {
+      _grow(self);
+    }
+  }
+  blob->refCount++;
+  self->noReferences++;
+
+  return blob->data;
+}
+
+/**
+ * Return the stored blob with the given content without adding a reference.
+ *
+ * @param self The store.
+ * @param data The content.
+ * @param length The length of the content.
+ *
+ * @return The handle of the stored blob or NULL if no such blob is stored.
+ */
+uint8_t* findBlob(BlobStore* self, const uint8_t* data, uint32_t length)
+{
+  StoredBlob* blob = NULL;
+
+  if (length > 0)
+  {
+    blob = _find(self, crc32c(0, data, length), data, length);
+  }
+
+  return blob != NULL ? blob->data : NULL;
+}
+
+/**
+ * Remove a reference from the blob. The blob is freed with its last 
+ * reference.
+ *
+ * @param self The store.
+ * @param blob The handle of the blob, may be NULL.
+ */
+void releaseBlob(BlobStore* self, uint8_t* blob)
+{
+  StoredBlob*  stored;
+  StoredBlob** link;
+
+  if (blob == NULL)
+  {
+    return;
+  }
+  stored = STORED_BLOB(blob);
+  self->noReferences--;
+  if (--stored->refCount > 0)
+  {
+    return;
+  }
+
+  for (link = &self->buckets[stored->hash & self->mask]; *link != NULL;
+       link = &(*link)->next)
+  {
+    if (*link == stored)
+    {
+      *link = stored->next;
+      break;
+    }
+  }
+  self->noBlobs--;
+  self->size -= stored->length;
+  freeToSizeClassPool(&self->pool, stored, sizeof(StoredBlob) + stored->length);
+}
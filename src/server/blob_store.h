@@ -0,0 +1,128 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Interning store for the update blobs (AS path or BGPSec path attribute) of
+ * the update cache. Identical blobs are stored once and reference counted,
+ * most updates of a full table share a small set of distinct paths. A stored
+ * blob is identified by its address, two updates carry the same blob if and 
+ * only if they reference the same stored blob.
+ *
+ * The blobs are kept in a hash table keyed by the CRC-32C of their content,
+ * their memory is taken from a size class pool.
+ *
+ * @note Not thread-safe! The update cache serializes all access using its 
+ *       item mutex.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __BLOB_STORE_H__
+#define __BLOB_STORE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "util/mem_pool.h"
+
+/** The initial number of buckets, MUST be a power of 2. */
+#define BLOB_STORE_INIT_BUCKETS 1024
+
+/** A stored blob, defined in blob_store.c. */
+typedef struct _StoredBlob StoredBlob;
+
+/** The blob store. */
+typedef struct {
+  /** The memory of the stored blobs. */
+  SizeClassPool pool;
+  /** The hash buckets. */
+  StoredBlob**  buckets;
+  /** The number of buckets - 1. */
+  uint32_t      mask;
+  /** The number of distinct blobs stored. */
+  uint32_t      noBlobs;
+  /** The number of references to all blobs. */
+  uint64_t      noReferences;
+  /** The number of blob bytes stored. */
+  uint64_t      size;
+} BlobStore;
+
+/**
+ * Initialize the empty store.
+ *
+ * @param self The store.
+ *
+ * @return false if not enough memory was available.
+ */
+bool initBlobStore(BlobStore* self);
+
+/**
+ * Release all blobs and the store itself.
+ *
+ * @param self The store.
+ */
+void releaseBlobStore(BlobStore* self);
+
+/**
+ * Release all blobs, the buckets are kept. All blob handles become invalid.
+ *
+ * @param self The store.
+ */
+void emptyBlobStore(BlobStore* self);
+
+/**
+ * Return the stored blob with the given content and add a reference to it. 
+ * The blob is stored if it is not known yet.
+ *
+ * @param self The store.
+ * @param data The content.
+ * @param length The length of the content, must be > 0.
+ *
+ * @return The handle of the stored blob, it points to the stored content 
+ *         which must not be modified. NULL if not enough memory was 
+ *         available.
+ */
+uint8_t* internBlob(BlobStore* self, const uint8_t* data, uint32_t length);
+
+/**
+ * Return the stored blob with the given content without adding a reference.
+ *
+ * @param self The store.
+ * @param data The content.
+ * @param length The length of the content.
+ *
+ * @return The handle of the stored blob or NULL if no such blob is stored.
+ */
+uint8_t* findBlob(BlobStore* self, const uint8_t* data, uint32_t length);
+
+/**
+ * Remove a reference from the blob. The blob is freed with its last 
+ * reference.
+ *
+ * @param self The store.
+ * @param blob The handle of the blob, may be NULL.
+ */
+void releaseBlob(BlobStore* self, uint8_t* blob);
+
+#endif // !__BLOB_STORE_H__
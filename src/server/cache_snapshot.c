@@ -0,0 +1,723 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Snapshots of the prefix cache and update cache for a warm restart.
+ *
+ * The snapshot file consists of the header, the ROA records, and the update
+ * records. Each update record is followed by its blob. The ROA section and
+ * each update record start at a multiple of CS_ALIGNMENT.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Code created.
+ *            * Version 2 of the format stores the sessions of multiple 
+ *              validation caches.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added buildCacheSnapshot and loadCacheSnapshotData to transfer
+ *              a snapshot in memory. A snapshot might contain no session.
+ *            * Added restoreCacheUpdate.
+ *            * Version 3 of the format stores the kind of the blob instead of
+ *              guessing it from the blob length.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "server/cache_snapshot.h"
+#include "shared/crc32.h"
+#include "util/log.h"
+#include "util/mutex.h"
+
+#define HDR "([0x%08X] Cache Snapshot): "
+
+/** The magic number of a snapshot file ("SRXS"). */
+#define CS_MAGIC          0x53585253
+/** The version of the snapshot format. */
+#define CS_VERSION        3
+/** The sections and each update record start at a multiple of this. */
+#define CS_ALIGNMENT      8
+/** Align the given size to CS_ALIGNMENT. */
+#define CS_ALIGN(SIZE)    (((SIZE) + CS_ALIGNMENT - 1) & ~(CS_ALIGNMENT - 1))
+/** The initial size of the buffer the updates are copied into. */
+#define CS_INITIAL_BUFFER 65536
+
+/**
+ * The header of the snapshot file. The record sizes allow to detect snapshots
+ * written by a build using a different structure layout.
+ */
+typedef struct {
+  uint32_t magic;            // CS_MAGIC
+  uint16_t version;          // CS_VERSION
+  uint16_t headerSize;       // sizeof(CS_Header)
+  uint16_t sessionRecordSize;// sizeof(CS_SessionRecord)
+  uint16_t roaRecordSize;    // sizeof(CS_ROARecord)
+  uint16_t updateRecordSize; // sizeof(CS_UpdateRecord)
+  uint32_t crc;              // CRC-32C of all sections
+  uint64_t created;          // The time the snapshot was taken
+  uint64_t size;             // The size of the complete file
+  uint64_t updateOffset;     // The file offset of the first update record
+  uint32_t noSessions;       // The number of session records
+  uint32_t noROAs;           // The number of ROA records
+  uint32_t noUpdates;        // The number of update records
+} CS_Header;
+
+/** The session of a validation cache. */
+typedef struct {
+  uint32_t valCacheID;
+  uint32_t sessionID;        // The session id (in network order!)
+  uint32_t serial;           // The serial (in network order!)
+} CS_SessionRecord;
+
+/** A single ROA white-list entry, it belongs to the session of valCacheID. */
+typedef struct {
+  IPPrefix prefix;
+  uint32_t originAS;
+  uint32_t valCacheID;
+  uint8_t  maxLen;
+} CS_ROARecord;
+
+/** A single update, followed by blobLength bytes of blob. */
+typedef struct {
+  SRxUpdateID      updateID;
+  uint32_t         asn;
+  IPPrefix         prefix;
+  SRxDefaultResult defaultResult;
+  SRxResult        srxResult;
+  uint32_t         blobLength;
+  uint8_t          bgpsecAttr; // 1 if the blob is the BGPSec path attribute
+} CS_UpdateRecord;
+
+/** The buffer the update records are copied into during the cache walk. */
+typedef struct {
+  uint8_t* data;
+  size_t   size;
+  size_t   capacity;
+  uint32_t count;
+} CS_Buffer;
+
+/** Serializes the writing of snapshots, they use the same temporary file. */
+static Mutex _writeMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Copy the given update into the buffer. Called for each update during the
+ * update cache walk.
+ *
+ * @param user The buffer.
+ * @param updateID The id of the update.
+ * @param asn The origin AS of the update.
+ * @param prefix The prefix of the update.
+ * @param defResult The default result of the update.
+ * @param srxResult The current validation result of the update.
+ * @param blob The update blob or NULL.
+ * @param blobLength The length of the blob.
+ * @param bgpsecAttr true if the blob is the BGPSec path attribute.
+ *
+ * @return false if the buffer could not be extended.
+ */
+static bool _copyUpdate(void* user, SRxUpdateID* updateID, uint32_t asn,
+                        IPPrefix* prefix, SRxDefaultResult* defResult,
+                        SRxResult* srxResult, uint8_t* blob,
+                        uint32_t blobLength, bool bgpsecAttr)
+{
+  CS_Buffer*       buffer = (CS_Buffer*)user;
+  size_t           size   = CS_ALIGN(sizeof(CS_UpdateRecord) + blobLength);
+  size_t           newCapacity;
+  uint8_t*         data;
+  CS_UpdateRecord* record;
+
+  if (buffer->size + size > buffer->capacity)
+  {
+    newCapacity = buffer->capacity == 0 ? CS_INITIAL_BUFFER
+                                        : buffer->capacity * 2;
+    while (buffer->size + size > newCapacity)
+    {
+      newCapacity *= 2;
+    }
+    data = realloc(buffer->data, newCapacity);
+    if (data == NULL)
+    {
+      return false;
+    }
+    buffer->data     = data;
+    buffer->capacity = newCapacity;
+  }
+
+  // The padding is part of the CRC, keep it deterministic.
+  memset(buffer->data + buffer->size, 0, size);
+  record = (CS_UpdateRecord*)(buffer->data + buffer->size);
+  record->updateID      = *updateID;
+  record->asn           = asn;
+  record->prefix        = *prefix;
+  record->defaultResult = *defResult;
+  record->srxResult     = *srxResult;
+  record->blobLength    = blob != NULL ? blobLength : 0;
+  record->bgpsecAttr    = bgpsecAttr ? 1 : 0;
+  if (record->blobLength > 0)
+  {
+    memcpy(record + 1, blob, blobLength);
+  }
+  buffer->size += size;
+  buffer->count++;
+
+  return true;
+}
+
+/**
+ * Serialize the given sessions, their ROA white-list entries, and all updates
+ * of the update cache into a snapshot in memory. The snapshot has the format
+ * of the snapshot file.
+ *
+ * @param sessions The sessions of the validation caches.
+ * @param noSessions The number of sessions.
+ * @param roas The ROA white-list entries as announcements.
+ * @param noROAs The number of ROA white-list entries.
+ * @param updCache The update cache.
+ * @param data OUT - The snapshot. Must be freed by the caller.
+ * @param size OUT - The size of the snapshot.
+ *
+ * @return false if not enough memory was available.
+ *
+ * @since 0.4.1.0
+ */
+bool buildCacheSnapshot(RPKISession* sessions, uint32_t noSessions,
+                        PC_ROAwlChange* roas, uint32_t noROAs,
+                        UpdateCache* updCache, uint8_t** data, size_t* size)
+{
+  CS_Buffer         updates;
+  CS_Header*        header;
+  CS_SessionRecord* records;
+  CS_ROARecord*     roaRecords;
+  size_t            sessionSize = noSessions * sizeof(CS_SessionRecord);
+  size_t            roaSize     = noROAs * sizeof(CS_ROARecord);
+  size_t            updateOffset;
+  uint32_t          idx;
+
+  *data = NULL;
+  *size = 0;
+
+  // The update records are copied behind the header and the sections, they
+  // are filled in once the update cache is walked. The padding stays zero.
+  updateOffset = CS_ALIGN(sizeof(CS_Header)) + CS_ALIGN(sessionSize)
+                 + CS_ALIGN(roaSize);
+  memset(&updates, 0, sizeof(CS_Buffer));
+  updates.capacity = updateOffset + CS_INITIAL_BUFFER;
+  updates.data     = calloc(1, updates.capacity);
+  if (updates.data == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory to take a snapshot of %u sessions with "
+                    "%u ROA-wl entries!", noSessions, noROAs);
+    return false;
+  }
+  updates.size = updateOffset;
+
+  if (!walkUpdateCache(updCache, _copyUpdate, &updates))
+  {
+    RAISE_SYS_ERROR("Not enough memory to take a snapshot of the updates!");
+    free(updates.data);
+    return false;
+  }
+
+  records = (CS_SessionRecord*)(updates.data + CS_ALIGN(sizeof(CS_Header)));
+  for (idx = 0; idx < noSessions; idx++)
+  {
+    records[idx].valCacheID = sessions[idx].valCacheID;
+    records[idx].sessionID  = sessions[idx].sessionID;
+    records[idx].serial     = sessions[idx].serial;
+  }
+
+  roaRecords = (CS_ROARecord*)((uint8_t*)records + CS_ALIGN(sessionSize));
+  for (idx = 0; idx < noROAs; idx++)
+  {
+    roaRecords[idx].prefix     = roas[idx].prefix;
+    roaRecords[idx].originAS   = roas[idx].originAS;
+    roaRecords[idx].valCacheID = roas[idx].valCacheID;
+    roaRecords[idx].maxLen     = roas[idx].maxLen;
+  }
+
+  header = (CS_Header*)updates.data;
+  header->magic             = CS_MAGIC;
+  header->version           = CS_VERSION;
+  header->headerSize        = sizeof(CS_Header);
+  header->sessionRecordSize = sizeof(CS_SessionRecord);
+  header->roaRecordSize     = sizeof(CS_ROARecord);
+  header->updateRecordSize  = sizeof(CS_UpdateRecord);
+  header->created           = (uint64_t)time(NULL);
+  header->updateOffset      = updateOffset;
+  header->size              = updates.size;
+  header->noSessions        = noSessions;
+  header->noROAs            = noROAs;
+  header->noUpdates         = updates.count;
+  header->crc = crc32c(0, (uint8_t*)records, sessionSize);
+  header->crc = crc32c(header->crc, (uint8_t*)roaRecords, roaSize);
+  header->crc = crc32c(header->crc, updates.data + updateOffset,
+                       updates.size - updateOffset);
+
+  *data = updates.data;
+  *size = updates.size;
+
+  return true;
+}
+
+/**
+ * Write a snapshot of the sessions of the RPKI handler's validation caches 
+ * with their ROA white-list and of all updates of the update cache. Only the 
+ * validation caches whose data of a serial is complete are written, nothing is
+ * written if there is none.
+ *
+ * @param fileName The name of the snapshot file.
+ * @param rpkiHandler The RPKI handler maintaining the prefix cache.
+ * @param updCache The update cache.
+ *
+ * @return true if the snapshot was written.
+ */
+bool writeCacheSnapshot(const char* fileName, RPKIHandler* rpkiHandler,
+                        UpdateCache* updCache)
+{
+  RPKISession*    sessions   = NULL;
+  PC_ROAwlChange* changes    = NULL;
+  uint8_t*        data       = NULL;
+  char*           tmpName    = NULL;
+  FILE*           file       = NULL;
+  bool            retVal     = false;
+  uint32_t        noSessions = 0;
+  uint32_t        noROAs     = 0;
+  size_t          size;
+
+  lockMutex(&_writeMutex);
+  if (!exportRPKISessions(rpkiHandler, &sessions, &noSessions, &changes, 
+                          &noROAs))
+  {
+    LOG(LEVEL_DEBUG, HDR "No complete serial available, no snapshot taken!",
+                     pthread_self());
+    goto done;
+  }
+  if (!buildCacheSnapshot(sessions, noSessions, changes, noROAs, updCache,
+                          &data, &size))
+  {
+    goto done;
+  }
+
+  // Write into a temporary file that replaces the snapshot once completed.
+  tmpName = malloc(strlen(fileName) + 5);
+  if (tmpName == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory to write the snapshot!");
+    goto done;
+  }
+  sprintf(tmpName, "%s.tmp", fileName);
+  file = fopen(tmpName, "wb");
+  if (file == NULL)
+  {
+    RAISE_SYS_ERROR("Could not create the snapshot file '%s' (%s)!", tmpName,
+                    strerror(errno));
+    goto done;
+  }
+  if (   (fwrite(data, size, 1, file) != 1)
+      || (fflush(file) != 0) || (fsync(fileno(file)) != 0))
+  {
+    RAISE_SYS_ERROR("Could not write the snapshot file '%s' (%s)!", tmpName,
+                    strerror(errno));
+    fclose(file);
+    unlink(tmpName);
+    goto done;
+  }
+  fclose(file);
+  if (rename(tmpName, fileName) != 0)
+  {
+    RAISE_SYS_ERROR("Could not replace the snapshot file '%s' (%s)!", fileName,
+                    strerror(errno));
+    unlink(tmpName);
+    goto done;
+  }
+
+  LOG(LEVEL_INFO, HDR "Snapshot of %u sessions with %u ROA-wl entries and %u "
+                  "updates written to '%s'", pthread_self(), noSessions,
+                  noROAs, ((CS_Header*)data)->noUpdates, fileName);
+  retVal = true;
+
+done:
+  unlockMutex(&_writeMutex);
+  free(tmpName);
+  free(data);
+  free(changes);
+  free(sessions);
+
+  return retVal;
+}
+
+/**
+ * Verify the header and the structure of the mapped snapshot.
+ *
+ * @param data The mapped snapshot.
+ * @param size The size of the mapped snapshot.
+ *
+ * @return true if the snapshot can be loaded.
+ */
+static bool _checkSnapshot(uint8_t* data, size_t size)
+{
+  CS_Header*       header = (CS_Header*)data;
+  CS_UpdateRecord* record;
+  uint64_t         sectionSize;
+  uint64_t         offset;
+  uint32_t         crc;
+  uint32_t         idx;
+
+  if (   (size < sizeof(CS_Header)) || (header->magic != CS_MAGIC)
+      || (header->version != CS_VERSION)
+      || (header->headerSize != sizeof(CS_Header))
+      || (header->sessionRecordSize != sizeof(CS_SessionRecord))
+      || (header->roaRecordSize != sizeof(CS_ROARecord))
+      || (header->updateRecordSize != sizeof(CS_UpdateRecord))
+      || (header->size != size))
+  {
+    LOG(LEVEL_WARNING, HDR "Snapshot of unknown format or size!",
+                       pthread_self());
+    return false;
+  }
+
+  // A snapshot taken for a standby might not contain a session yet.
+  if ((header->updateOffset > size)
+      || (header->updateOffset 
+          != CS_ALIGN(sizeof(CS_Header))
+             + CS_ALIGN((uint64_t)header->noSessions*sizeof(CS_SessionRecord))
+             + CS_ALIGN((uint64_t)header->noROAs * sizeof(CS_ROARecord))))
+  {
+    LOG(LEVEL_WARNING, HDR "Snapshot with invalid session or ROA section!",
+                       pthread_self());
+    return false;
+  }
+
+  // Walk the update records.
+  offset = header->updateOffset;
+  for (idx = 0; idx < header->noUpdates; idx++)
+  {
+    if (offset + sizeof(CS_UpdateRecord) > size)
+    {
+      break;
+    }
+    record  = (CS_UpdateRecord*)(data + offset);
+    offset += CS_ALIGN(sizeof(CS_UpdateRecord) + record->blobLength);
+  }
+  if ((idx < header->noUpdates) || (offset != size))
+  {
+    LOG(LEVEL_WARNING, HDR "Snapshot with invalid update section!",
+                       pthread_self());
+    return false;
+  }
+
+  // The CRC covers the records of all sections without the section padding.
+  offset      = CS_ALIGN(sizeof(CS_Header));
+  sectionSize = (uint64_t)header->noSessions * sizeof(CS_SessionRecord);
+  crc         = crc32c(0, data + offset, (uint32_t)sectionSize);
+  offset     += CS_ALIGN(sectionSize);
+  sectionSize = (uint64_t)header->noROAs * sizeof(CS_ROARecord);
+  crc         = crc32c(crc, data + offset, (uint32_t)sectionSize);
+  crc         = crc32c(crc, data + header->updateOffset,
+               (uint32_t)(size - header->updateOffset));
+  if (crc != header->crc)
+  {
+    LOG(LEVEL_WARNING, HDR "Snapshot with invalid checksum!", pthread_self());
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Store the given update without client in the update cache and validate it
+ * again. The path validation result is kept, the origin is validated again
+ * using the ROA white-list of the prefix cache if it was validated before.
+ *
+ * @param prefixCache The prefix cache.
+ * @param updCache The update cache.
+ * @param updateID The id of the update.
+ * @param asn The origin AS of the update.
+ * @param prefix The prefix of the update.
+ * @param defResult The default result of the update.
+ * @param srxResult The validation result of the update.
+ * @param blob The update blob or NULL.
+ * @param blobLength The length of the blob.
+ * @param bgpsecAttr true if the blob is the BGPSec path attribute, false if
+ *                   it is the AS path.
+ *
+ * @return false if the update could not be restored.
+ *
+ * @since 0.4.1.0
+ */
+bool restoreCacheUpdate(PrefixCache* prefixCache, UpdateCache* updCache,
+                        SRxUpdateID* updateID, uint32_t asn, IPPrefix* prefix,
+                        SRxDefaultResult* defResult, SRxResult* srxResult,
+                        uint8_t* blob, uint32_t blobLength,
+                        bool bgpsecAttr)
+{
+  BGPSecData  bgpsecData;
+  BGPSecData* bgpsec = NULL;
+  SRxResult   srxRes;
+
+  // The blob is the data the update id was generated of, store it as is.
+  if ((blob != NULL) && (blobLength > 0))
+  {
+    memset(&bgpsecData, 0, sizeof(BGPSecData));
+    if (bgpsecAttr)
+    {
+      bgpsecData.attr_length      = (uint16_t)blobLength;
+      bgpsecData.bgpsec_path_attr = blob;
+    }
+    else
+    {
+      bgpsecData.numberHops = (uint16_t)(blobLength / 4);
+      bgpsecData.asPath     = (uint32_t*)blob;
+    }
+    bgpsec = &bgpsecData;
+  }
+
+  if (storeUpdate(updCache, 0, NULL, updateID, prefix, asn, defResult,
+                  bgpsec) != 1)
+  {
+    return false;
+  }
+
+  // The path validation result is kept, the origin is validated again using
+  // the restored ROA white-list.
+  if (srxResult->bgpsecResult != SRx_RESULT_UNDEFINED)
+  {
+    srxRes.roaResult    = SRx_RESULT_DONOTUSE;
+    srxRes.bgpsecResult = srxResult->bgpsecResult;
+    modifyUpdateResult(updCache, updateID, &srxRes);
+  }
+  if (srxResult->roaResult != SRx_RESULT_UNDEFINED)
+  {
+    return requestUpdateValidation(prefixCache, updateID, prefix, asn);
+  }
+
+  return true;
+}
+
+/**
+ * Store the update of the given record in the update cache and validate it
+ * again.
+ *
+ * @param prefixCache The prefix cache.
+ * @param updCache The update cache.
+ * @param record The update record.
+ *
+ * @return false if the update could not be restored.
+ */
+static bool _restoreUpdate(PrefixCache* prefixCache, UpdateCache* updCache,
+                           CS_UpdateRecord* record)
+{
+  SRxUpdateID      updateID = record->updateID;
+  IPPrefix         prefix   = record->prefix;
+  SRxDefaultResult defRes   = record->defaultResult;
+  SRxResult        srxRes   = record->srxResult;
+
+  return restoreCacheUpdate(prefixCache, updCache, &updateID, record->asn,
+                            &prefix, &defRes, &srxRes,
+                            record->blobLength > 0 ? (uint8_t*)(record + 1)
+                                                   : NULL,
+                            record->blobLength, record->bgpsecAttr != 0);
+}
+
+/**
+ * Load the snapshot in memory into the empty caches. The ROA white-list
+ * entries are applied to the prefix cache, the updates are stored without
+ * client and validated again.
+ *
+ * @param data The snapshot.
+ * @param size The size of the snapshot.
+ * @param prefixCache The prefix cache.
+ * @param updCache The update cache.
+ * @param sessions OUT - The restored sessions, NULL if the snapshot contains
+ *                 none. Must be freed by the caller.
+ * @param noSessions OUT - The number of restored sessions.
+ *
+ * @return false if the snapshot is not valid. In this case the caches are not
+ *         modified.
+ *
+ * @since 0.4.1.0
+ */
+bool loadCacheSnapshotData(uint8_t* data, size_t size,
+                           PrefixCache* prefixCache, UpdateCache* updCache,
+                           RPKISession** sessions, uint32_t* noSessions)
+{
+  CS_Header         header;
+  CS_SessionRecord* records;
+  CS_ROARecord*     roas;
+  CS_UpdateRecord*  record;
+  PC_ROAwlChange*   changes = NULL;
+  uint64_t          offset;
+  uint32_t          applied;
+  uint32_t          restored = 0;
+  uint32_t          idx;
+  uint32_t          sIdx;
+
+  *sessions   = NULL;
+  *noSessions = 0;
+  if (!_checkSnapshot(data, size))
+  {
+    return false;
+  }
+  memcpy(&header, data, sizeof(CS_Header));
+
+  records = (CS_SessionRecord*)(data + CS_ALIGN(sizeof(CS_Header)));
+  roas    = (CS_ROARecord*)((uint8_t*)records 
+               + CS_ALIGN(header.noSessions * sizeof(CS_SessionRecord)));
+  if (header.noSessions > 0)
+  {
+    *sessions = malloc(header.noSessions * sizeof(RPKISession));
+  }
+  if (header.noROAs > 0)
+  {
+    changes = malloc(header.noROAs * sizeof(PC_ROAwlChange));
+  }
+  if (   ((header.noSessions > 0) && (*sessions == NULL))
+      || ((header.noROAs > 0) && (changes == NULL)))
+  {
+    RAISE_SYS_ERROR("Not enough memory to restore %u sessions with %u ROA-wl "
+                    "entries!", header.noSessions, header.noROAs);
+    free(*sessions);
+    *sessions = NULL;
+    free(changes);
+    return false;
+  }
+  for (sIdx = 0; sIdx < header.noSessions; sIdx++)
+  {
+    (*sessions)[sIdx].valCacheID = records[sIdx].valCacheID;
+    (*sessions)[sIdx].sessionID  = records[sIdx].sessionID;
+    (*sessions)[sIdx].serial     = records[sIdx].serial;
+  }
+  *noSessions = header.noSessions;
+
+  // The ROAs first, the updates are validated against them.
+  for (idx = 0; idx < header.noROAs; idx++)
+  {
+    changes[idx].isAnn      = true;
+    changes[idx].originAS   = roas[idx].originAS;
+    changes[idx].prefix     = roas[idx].prefix;
+    changes[idx].maxLen     = roas[idx].maxLen;
+    changes[idx].session_id = 0;
+    changes[idx].valCacheID = roas[idx].valCacheID;
+    for (sIdx = 0; sIdx < header.noSessions; sIdx++)
+    {
+      if (records[sIdx].valCacheID == roas[idx].valCacheID)
+      {
+        changes[idx].session_id = records[sIdx].sessionID;
+        break;
+      }
+    }
+  }
+  applied = header.noROAs > 0
+            ? applyROAwlChanges(prefixCache, changes, header.noROAs) : 0;
+  free(changes);
+
+  offset = header.updateOffset;
+  for (idx = 0; idx < header.noUpdates; idx++)
+  {
+    record = (CS_UpdateRecord*)(data + offset);
+    if (_restoreUpdate(prefixCache, updCache, record))
+    {
+      restored++;
+    }
+    offset += CS_ALIGN(sizeof(CS_UpdateRecord) + record->blobLength);
+  }
+
+  LOG(LEVEL_INFO, HDR "Restored %u of %u ROA-wl entries of %u sessions and %u "
+                  "of %u updates", pthread_self(), applied, header.noROAs,
+                  header.noSessions, restored, header.noUpdates);
+
+  return true;
+}
+
+/**
+ * Load the snapshot into the empty caches. The ROA white-list entries are
+ * applied to the prefix cache, the updates are stored without client and
+ * validated again. The garbage collector removes them if no client registers
+ * for them within the keep window.
+ *
+ * @param fileName The name of the snapshot file.
+ * @param prefixCache The prefix cache.
+ * @param updCache The update cache.
+ * @param sessions OUT - The restored sessions. They are passed to the RPKI
+ *                 handler to be resumed and must be freed by the caller.
+ * @param noSessions OUT - The number of restored sessions.
+ *
+ * @return false if no valid snapshot could be loaded. In this case the caches
+ *         are not modified.
+ */
+bool loadCacheSnapshot(const char* fileName, PrefixCache* prefixCache,
+                       UpdateCache* updCache, RPKISession** sessions,
+                       uint32_t* noSessions)
+{
+  struct stat fileStat;
+  uint8_t*    data;
+  bool        retVal;
+  int         fd;
+
+  fd = open(fileName, O_RDONLY);
+  if (fd == -1)
+  {
+    if (errno == ENOENT)
+    {
+      LOG(LEVEL_INFO, HDR "No snapshot '%s' available", pthread_self(),
+                      fileName);
+    }
+    else
+    {
+      RAISE_SYS_ERROR("Could not open the snapshot '%s' (%s)!", fileName,
+                      strerror(errno));
+    }
+    return false;
+  }
+  if ((fstat(fd, &fileStat) != 0) || (fileStat.st_size < sizeof(CS_Header)))
+  {
+    LOG(LEVEL_WARNING, HDR "The snapshot '%s' is too small!", pthread_self(),
+                       fileName);
+    close(fd);
+    return false;
+  }
+  data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    RAISE_SYS_ERROR("Could not map the snapshot '%s' (%s)!", fileName,
+                    strerror(errno));
+    return false;
+  }
+
+  LOG(LEVEL_DEBUG, HDR "Load the snapshot '%s'", pthread_self(), fileName);
+  retVal = loadCacheSnapshotData(data, fileStat.st_size, prefixCache,
+                                 updCache, sessions, noSessions);
+  munmap(data, fileStat.st_size);
+
+  return retVal;
+}
@@ -0,0 +1,160 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Snapshots of the prefix cache and update cache for a warm restart. A
+ * snapshot contains the session id and serial of each validation cache 
+ * session, the ROA white-list entries of these sessions, and all updates
+ * with their validation results. The snapshot is written into a temporary
+ * file that replaces the previous snapshot once it is complete. On startup the
+ * snapshot is memory mapped and loaded into the caches, the sessions are then
+ * resumed with a serial query.
+ *
+ * The snapshot is stored in host byte order and is only meant to be loaded by
+ * the same build of the server.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Code created.
+ *            * Store the sessions of multiple validation caches.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added buildCacheSnapshot, loadCacheSnapshotData, and
+ *              restoreCacheUpdate for the replication to a standby server.
+ *            * restoreCacheUpdate receives the kind of the blob.
+ */
+
+#ifndef __CACHE_SNAPSHOT_H__
+#define __CACHE_SNAPSHOT_H__
+
+#include <stdbool.h>
+#include "server/prefix_cache.h"
+#include "server/rpki_handler.h"
+#include "server/update_cache.h"
+
+/**
+ * Serialize the given sessions, their ROA white-list entries, and all updates
+ * of the update cache into a snapshot in memory. The snapshot has the format
+ * of the snapshot file.
+ *
+ * @param sessions The sessions of the validation caches.
+ * @param noSessions The number of sessions.
+ * @param roas The ROA white-list entries as announcements.
+ * @param noROAs The number of ROA white-list entries.
+ * @param updCache The update cache.
+ * @param data OUT - The snapshot. Must be freed by the caller.
+ * @param size OUT - The size of the snapshot.
+ *
+ * @return false if not enough memory was available.
+ *
+ * @since 0.4.1.0
+ */
+bool buildCacheSnapshot(RPKISession* sessions, uint32_t noSessions,
+                        PC_ROAwlChange* roas, uint32_t noROAs,
+                        UpdateCache* updCache, uint8_t** data, size_t* size);
+
+/**
+ * Write a snapshot of the sessions of the RPKI handler's validation caches 
+ * with their ROA white-list and of all updates of the update cache. Only the 
+ * validation caches whose data of a serial is complete are written, nothing is
+ * written if there is none.
+ *
+ * @param fileName The name of the snapshot file.
+ * @param rpkiHandler The RPKI handler maintaining the prefix cache.
+ * @param updCache The update cache.
+ *
+ * @return true if the snapshot was written.
+ */
+bool writeCacheSnapshot(const char* fileName, RPKIHandler* rpkiHandler,
+                        UpdateCache* updCache);
+
+/**
+ * Load the snapshot into the empty caches. The ROA white-list entries are
+ * applied to the prefix cache, the updates are stored without client and
+ * validated again. The garbage collector removes them if no client registers
+ * for them within the keep window.
+ *
+ * @param fileName The name of the snapshot file.
+ * @param prefixCache The prefix cache.
+ * @param updCache The update cache.
+ * @param sessions OUT - The restored sessions. They are passed to the RPKI
+ *                 handler to be resumed and must be freed by the caller.
+ * @param noSessions OUT - The number of restored sessions.
+ *
+ * @return false if no valid snapshot could be loaded. In this case the caches
+ *         are not modified.
+ */
+bool loadCacheSnapshot(const char* fileName, PrefixCache* prefixCache,
+                       UpdateCache* updCache, RPKISession** sessions,
+                       uint32_t* noSessions);
+
+/**
+ * Load the snapshot in memory into the empty caches. The ROA white-list
+ * entries are applied to the prefix cache, the updates are stored without
+ * client and validated again.
+ *
+ * @param data The snapshot.
+ * @param size The size of the snapshot.
+ * @param prefixCache The prefix cache.
+ * @param updCache The update cache.
+ * @param sessions OUT - The restored sessions, NULL if the snapshot contains
+ *                 none. Must be freed by the caller.
+ * @param noSessions OUT - The number of restored sessions.
+ *
+ * @return false if the snapshot is not valid. In this case the caches are not
+ *         modified.
+ *
+ * @since 0.4.1.0
+ */
+bool loadCacheSnapshotData(uint8_t* data, size_t size,
+                           PrefixCache* prefixCache, UpdateCache* updCache,
+                           RPKISession** sessions, uint32_t* noSessions);
+
+/**
+ * Store the given update without client in the update cache and validate it
+ * again. The path validation result is kept, the origin is validated again
+ * using the ROA white-list of the prefix cache if it was validated before.
+ *
+ * @param prefixCache The prefix cache.
+ * @param updCache The update cache.
+ * @param updateID The id of the update.
+ * @param asn The origin AS of the update.
+ * @param prefix The prefix of the update.
+ * @param defResult The default result of the update.
+ * @param srxResult The validation result of the update.
+ * @param blob The update blob or NULL.
+ * @param blobLength The length of the blob.
+ * @param bgpsecAttr true if the blob is the BGPSec path attribute, false if
+ *                   it is the AS path.
+ *
+ * @return false if the update could not be restored.
+ *
+ * @since 0.4.1.0
+ */
+bool restoreCacheUpdate(PrefixCache* prefixCache, UpdateCache* updCache,
+                        SRxUpdateID* updateID, uint32_t asn, IPPrefix* prefix,
+                        SRxDefaultResult* defResult, SRxResult* srxResult,
+                        uint8_t* blob, uint32_t blobLength,
+                        bool bgpsecAttr);
+
+#endif // !__CACHE_SNAPSHOT_H__
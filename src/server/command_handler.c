@@ -25,10 +25,35 @@
  * queue is fed by the srx-proxy communication thread.
  *
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Start one command handler thread per command queue lane.
+ *            * Update counter of the proxy mapping is modified atomically.
+ *            * Negotiate the update ID generation during the handshake.
+ *            * Results are broadcasted using the send queue. The output buffer
+ *              of a client is released before its connection is closed.
+ *            * Added broadcastResults which packs the results for proxies 
+ *              that negotiated it into multi verification notifications.
+ *            * The prefix of an origin validation request is kept on the stack.
+ *            * Record the processing time of validation requests.
+ *          - 2026/10/15 - kyehwanl
+ *            * Count the results sent to each client.
+ *            * Path validation requests are queued to the BGPSec handler.
+ *            * Store the AS number of the proxy during the handshake.
+ *            * Signature requests are queued to the BGPSec handler, the
+ *              signatures are sent by _sendSignature.
+ *            * The command handler threads are placed and named by createThread.
+ *            * Negotiate the bulk verify requests during the handshake.
+ *            * Negotiate the incremental synchronization during the handshake.
+ *            * The shutdown command is queued as control command.
+ *            * Negotiate the flow control during the handshake. A proxy that
+ *              connects while the proxies are paused is paused as well.
+ *              Check the queue levels after each command while paused.
+ *            * Trace the validation of sampled updates.
+ *            * IPv4 updates are validated using requestUpdateValidationV4.
  * 0.3.0.10 - 2016/01/21 - kyehwanl
  *            * added pthread handler function for unexpected error
  * 0.3.0.10 - 2015/11/09 - oborchert
@@ -47,15 +72,19 @@
 #include "shared/srx_identifier.h"
 #include "shared/srx_packets.h"
 #include "server/srx_packet_sender.h"
+#include "server/stage_stats.h"
 #include "util/log.h"
 #include "util/math.h"
 #include "util/prefix.h"
 #include "util/slist.h"
+#include "util/thread.h"
 
 #define HDR "([0x%08X] Command Handler): "
 
-// Forward declaration
+// Forward declarations
 static void* handleCommands(void* arg);
+static void _sendSignature(SRxUpdateID updateID, uint8_t clientID, 
+                           uint8_t* block, uint32_t length, void* user);
 
 /**
  * Registers a BGPSec Handler, RPKI Handler and Update Cache.
@@ -79,6 +108,9 @@ bool initializeCommandHandler(CommandHandler* self, Configuration* cfg,
   self->rpkiHandler = rpkiHandler;
   self->updCache = updCache;
 
+  // The signatures are sent directly by the BGPSec workers.
+  setBGPSecSignedCallback(bgpsecHandler, _sendSignature, self);
+
   // Queue can be changed every time 'start' is called
   self->queue = NULL;
 
@@ -124,36 +156,48 @@ void releaseCommandHandler(CommandHandler* self)
 bool startProcessingCommands(CommandHandler* self, CommandQueue* cmdQueue)
 {
   int idx;
+  int numThreads = cmdQueue->numLanes;
+  CommandHandlerWorker* worker;
+  char name[THREAD_NAME_LEN + 1];
 
   self->queue = cmdQueue;
   LOG(LEVEL_DEBUG, HDR "Start Processing Commands...", pthread_self());
 
-  for (idx = 0; idx < NUM_COMMAND_HANDLER_THREADS; idx++)
+  if (numThreads > MAX_COMMAND_HANDLER_THREADS)
+  {
+    numThreads = MAX_COMMAND_HANDLER_THREADS;
+  }
+
+  for (idx = 0; idx < numThreads; idx++)
   {
     LOG (LEVEL_DEBUG, HDR "Create command handler Thread No %u", pthread_self(),
                       idx);
-    if (pthread_create(&self->threads[idx], NULL, handleCommands, self) > 0)
+    worker = &self->workers[idx];
+    worker->cmdHandler = self;
+    worker->lane       = (uint8_t)idx;
+    snprintf(name, sizeof(name), "srx-cmd-%d", idx);
+    if (createThread(&worker->thread, NULL, THREAD_CLASS_COMMAND, name,
+                     handleCommands, worker) > 0)
     {
-      // Continue with less threads
+      // Each lane needs its thread, without it the lane would not be served.
       if (idx > 0)
       {
-        RAISE_ERROR("Failed to initiate a command handler thread "
-                    "- continuing with %d threads",
-                    self->numThreads);
-        break;
-
-        // No thread
+        RAISE_ERROR("Failed to initiate command handler thread %d of %d "
+                    "- stopping", idx+1, numThreads);
+        stopProcessingCommands(self);
       }
       else
       {
         RAISE_ERROR("Failed to initiate a command handler thread - stopping");
-        return false;
       }
+      return false;
     }
 
     self->numThreads++;
   }
 
+  LOG(LEVEL_INFO, "- %d command handler thread(s) started!", self->numThreads);
+
   return true;
 }
 
@@ -175,21 +219,22 @@ void stopProcessingCommands(CommandHandler* self)
     // First remove all pending commands
     removeAllCommands(self->queue);
 
-    // Send SHUTDOWN to terminate the thread
+    // Send SHUTDOWN to terminate the thread. The dataID selects the lane.
     // TODO: Revisit this - It might cause errors during shutdown
     for (idx = 0; idx < self->numThreads; idx++)
     {
-      queueCommand(self->queue, COMMAND_TYPE_SHUTDOWN,
-                   NULL, NULL, 0, 0, NULL);
+      queueCommand(self->queue, COMMAND_TYPE_SHUTDOWN, COMMAND_PRIORITY_CONTROL,
+                   NULL, NULL, self->workers[idx].lane, 0, NULL);
     }
 
     // Wait until each thread terminated
     for (idx = 0; idx < self->numThreads; idx++)
     {
-      s = pthread_join(self->threads[idx], NULL);
+      s = pthread_join(self->workers[idx].thread, NULL);
       if (s != 0)
         handle_error_en(s, "pthread_join");
     }
+    self->numThreads = 0;
   }
 }
 
@@ -272,9 +317,30 @@ static bool _processHandshake(CommandHandler* cmdHandler,
 
       clientThread->proxyID  = proxyID;
       clientThread->routerID = clientID;
-      if (sendHelloResponse(item->serverSocket, item->client, proxyID))
+      // Use CRC-32C based update IDs, multi notifications, bulk verify
+      // requests, the incremental synchronization and the flow control if
+      // the proxy asks for it.
+      uint8_t helloFlags = hdr->flags & (  SRX_HELLO_FLAG_CRC32C_ID 
+                                         | SRX_HELLO_FLAG_MULTI_NOTIFY
+                                         | SRX_HELLO_FLAG_BULK_VERIFY
+                                         | SRX_HELLO_FLAG_INCR_SYNC
+                                         | SRX_HELLO_FLAG_FLOW_CONTROL);
+      ProxyClientMapping* mapping = 
+                                &cmdHandler->svrConnHandler->proxyMap[clientID];
+      mapping->asn         = ntohl(hdr->asn);
+      mapping->crc32cID    = (helloFlags & SRX_HELLO_FLAG_CRC32C_ID) != 0;
+      mapping->multiNotify = (helloFlags & SRX_HELLO_FLAG_MULTI_NOTIFY) != 0;
+      mapping->bulkVerify  = (helloFlags & SRX_HELLO_FLAG_BULK_VERIFY) != 0;
+      mapping->incrSync    = (helloFlags & SRX_HELLO_FLAG_INCR_SYNC) != 0;
+      mapping->flowControl = (helloFlags & SRX_HELLO_FLAG_FLOW_CONTROL) != 0;
+      if (sendHelloResponse(item->serverSocket, item->client, proxyID, 
+                            helloFlags))
       {
         clientThread->initialized = true;
+        if (mapping->flowControl && cmdHandler->svrConnHandler->flowPaused)
+        {
+          sendFlowControl(item->serverSocket, item->client, true, false);
+        }
         if (cmdHandler->sysConfig->syncAfterConnEstablished)
         {
           LOG(LEVEL_DEBUG, HDR "The configuration requires a sync request to be"
@@ -320,22 +386,65 @@ static bool verifyUpdateViaRPKI(RPKIHandler* rpkiHandler, SRxUpdateID* updateID,
 
 /**
  * The update did not have any result stored. This means that the update was
- * not yet validated using BGPSEC. This will be started here.
+ * not yet validated using BGPSEC. The validation is queued to the workers of
+ * the BGPSec handler which store the result in the update cache. Requests 
+ * without BGPSec path attribute keep the default result.
  *
- * @param rpkiHandler The RPKI validation handler
+ * @param cmdHandler The command handler
+ * @param item The command item that contains the validation request.
  * @param updId The update ID
  * @param srxRes The result container.
+ * @param defResult The default result of the update.
  *
  * @return true if the validation could be performed.
  */
-static bool verifyViaBGPSEC(void* bgpsecHandler, SRxUpdateID updateID,
-                            SRxResult* srxRes, SRxDefaultResult* defResult)
+static bool verifyViaBGPSEC(CommandHandler* cmdHandler, CommandQueueItem* item,
+                            SRxUpdateID updateID, SRxResult* srxRes, 
+                            SRxDefaultResult* defResult)
 {
-  LOG(LEVEL_DEBUG, HDR " " FILE_LINE_INFO "BGPSEC Validation requested for "
-                 "update [0x%08X] can not be performed, implementation for this"
-                 " does not exist yet!", pthread_self(), updateID);
-  srxRes->bgpsecResult = defResult->result.bgpsecResult;
-  return true;
+  SRXRPOXY_BasicHeader_VerifyRequest* bhdr =
+                                (SRXRPOXY_BasicHeader_VerifyRequest*)item->data;
+  ClientThread*     client = (ClientThread*)item->client;
+  uint8_t*          valPtr = (uint8_t*)item->data;
+  IPPrefix          prefix;
+  uint16_t          numHops;
+  uint16_t          attrLength;
+
+  memset(&prefix, 0, sizeof(IPPrefix));
+  prefix.length = bhdr->prefixLen;
+  if (bhdr->type == PDU_SRXPROXY_VERIFY_V4_REQUEST)
+  {
+    SRXPROXY_VERIFY_V4_REQUEST* v4 = (SRXPROXY_VERIFY_V4_REQUEST*)item->data;
+    prefix.ip.version = 4;
+    prefix.ip.addr.v4 = v4->prefixAddress;
+    numHops           = ntohs(v4->bgpsecValReqData.numHops);
+    attrLength        = ntohs(v4->bgpsecValReqData.attrLen);
+    valPtr           += sizeof(SRXPROXY_VERIFY_V4_REQUEST);
+  }
+  else
+  {
+    SRXPROXY_VERIFY_V6_REQUEST* v6 = (SRXPROXY_VERIFY_V6_REQUEST*)item->data;
+    prefix.ip.version = 6;
+    prefix.ip.addr.v6 = v6->prefixAddress;
+    numHops           = ntohs(v6->bgpsecValReqData.numHops);
+    attrLength        = ntohs(v6->bgpsecValReqData.attrLen);
+    valPtr           += sizeof(SRXPROXY_VERIFY_V6_REQUEST);
+  }
+
+  if (attrLength == 0)
+  {
+    LOG(LEVEL_DEBUG, HDR "Update [0x%08X] has no BGPSec path attribute, "
+                     "default result used", pthread_self(), updateID);
+    srxRes->bgpsecResult = defResult->result.bgpsecResult;
+    return true;
+  }
+
+  // The attribute follows the AS path.
+  valPtr += numHops * 4;
+
+  return queueBGPSecValidation(cmdHandler->bgpsecHandler, updateID,
+               cmdHandler->svrConnHandler->proxyMap[client->routerID].asn,
+               &prefix, valPtr, attrLength);
 }
 
 /**
@@ -401,44 +510,47 @@ static bool _processUpdateValidation(CommandHandler* cmdHandler,
   // Only do origin validation if not already performed
   if (originVal && (srxRes.roaResult == SRx_RESULT_UNDEFINED))
   {
-    IPPrefix*  prefix  = malloc(sizeof(IPPrefix));
-    uint32_t   asn;
-    memset(prefix, 0, sizeof(IPPrefix));
+    PrefixCache* prefixCache = cmdHandler->rpkiHandler->prefixCache;
+    bool         requested;
 
     if (bhdr->type == PDU_SRXPROXY_VERIFY_V4_REQUEST)
     {
+      // IPv4 goes straight to the prefix cache using the 32 bit address.
       SRXPROXY_VERIFY_V4_REQUEST* v4 = (SRXPROXY_VERIFY_V4_REQUEST*)item->data;
-      prefix->ip.version = 4;
-      prefix->length = v4->common.prefixLen;
-      cpyIPv4Address(&prefix->ip.addr.v4, &v4->prefixAddress);
-      asn = ntohl(v4->originAS);
+      requested = requestUpdateValidationV4(prefixCache, &updateID,
+                                            v4->prefixAddress.u32,
+                                            v4->common.prefixLen,
+                                            ntohl(v4->originAS));
     }
     else
     {
       SRXPROXY_VERIFY_V6_REQUEST* v6 = (SRXPROXY_VERIFY_V6_REQUEST*)item->data;
-      prefix->length = v6->common.prefixLen;
-      prefix->ip.version = 6;
-      cpyIPv6Address(&prefix->ip.addr.v6, &v6->prefixAddress);
-      asn = ntohl(v6->originAS);
+      IPPrefix prefix;
+      prefix.length = v6->common.prefixLen;
+      prefix.ip.version = 6;
+      prefix.ip.addr.v6 = v6->prefixAddress;
+      requested = requestUpdateValidation(prefixCache, &updateID, &prefix,
+                                          ntohl(v6->originAS));
     }
 
-    if (!requestUpdateValidation(cmdHandler->rpkiHandler->prefixCache,
-                                 &updateID, prefix, asn))
+    if (!requested)
     {
       RAISE_SYS_ERROR( HDR "An error occurred during the validation for "
                            "update [0x%08X] within the prefix cache!",
                       pthread_self(), item->dataID);
       processed = false;
     }
-    free(prefix);
+    else if (isUpdateTraced(updateID))
+    {
+      traceUpdate(updateID, TRACE_VALIDATION);
+    }
   }
 
   // Only do bgpdsec path validation if not already performed
   if (pathVal && (srxRes.bgpsecResult == SRx_RESULT_UNDEFINED))
   {
     // VerifyViaBGPSEC will notify the update cache with the newest result.
-    if (!verifyViaBGPSEC(cmdHandler->rpkiHandler, updateID, &srxRes,
-                         &defRes))
+    if (!verifyViaBGPSEC(cmdHandler, item, updateID, &srxRes, &defRes))
     {
       RAISE_SYS_ERROR("Update could not be validated using BGPSEC");
       processed = false;
@@ -449,7 +561,44 @@ static bool _processUpdateValidation(CommandHandler* cmdHandler,
 }
 
 /**
- * This method performs the signing of updates.
+ * Called by the BGPSec workers with the signature of a queued signing 
+ * request. The signature is sent to the client using the send queue.
+ *
+ * @param updateID The ID of the update.
+ * @param clientID The client that requested the signature.
+ * @param block The signature data, NULL if the update could not be signed.
+ * @param length The length of the signature data.
+ * @param user The command handler.
+ */
+static void _sendSignature(SRxUpdateID updateID, uint8_t clientID, 
+                           uint8_t* block, uint32_t length, void* user)
+{
+  CommandHandler*     self    = (CommandHandler*)user;
+  ProxyClientMapping* mapping = &self->svrConnHandler->proxyMap[clientID];
+
+  // The client might have disconnected meanwhile.
+  if (!mapping->isActive)
+  {
+    LOG(LEVEL_DEBUG, HDR "Client %u is gone, signature of update [0x%08X] "
+        "dropped", pthread_self(), clientID, updateID);
+  }
+  else if (block == NULL)
+  {
+    sendError(SRXERR_INTERNAL_ERROR, &self->svrConnHandler->svrSock, 
+              mapping->socket, true);
+  }
+  else if (!sendSignatureNotification(&self->svrConnHandler->svrSock, 
+                                      mapping->socket, updateID, length, 
+                                      block, true))
+  {
+    LOG(LEVEL_NOTICE, HDR "Signature of update [0x%08X] could not be sent to "
+        "client %u", pthread_self(), updateID, clientID);
+  }
+}
+
+/**
+ * This method performs the signing of updates. The signing is queued to the
+ * BGPSec handler, the signature is sent by _sendSignature.
  *
  * @param cmdHandler The command handler
  * @param item The item containing all data needed to sign.
@@ -457,8 +606,51 @@ static bool _processUpdateValidation(CommandHandler* cmdHandler,
 static void _processUpdateSigning(CommandHandler* cmdHandler,
                                  CommandQueueItem* item)
 {
-  // TODO Sign the data
-  LOG(LEVEL_INFO, "Signing of updates is currently not supported!");
+  SRXPROXY_SIGN_REQUEST* hdr      = (SRXPROXY_SIGN_REQUEST*)item->data;
+  ClientThread*          clThread = (ClientThread*)item->client;
+  SRxUpdateID            updateID = (SRxUpdateID)item->dataID;
+  BGPSecSignRequest      request;
+  uint32_t               prepend  = ntohl(hdr->prependCounter);
+  uint16_t               noHops;
+
+  if (   (ntohs(hdr->algorithm) != BGPSEC_ALGO_ECDSA_P256)
+      || (cmdHandler->bgpsecHandler->signKey == NULL))
+  {
+    LOG(LEVEL_INFO, HDR "Signing with algorithm %u is not supported!", 
+        pthread_self(), ntohs(hdr->algorithm));
+    sendError(SRXERR_ALGO_NOT_SUPPORTED, item->serverSocket, item->client, 
+              false);
+    return;
+  }
+
+  memset(&request, 0, sizeof(BGPSecSignRequest));
+  request.updateID = updateID;
+  request.clientID = clThread->routerID;
+  request.localAS  = 
+                  cmdHandler->svrConnHandler->proxyMap[clThread->routerID].asn;
+  request.peerAS   = ntohl(hdr->peerAS);
+  request.pCount   = prepend < 255 ? prepend + 1 : 255;
+  request.onlyOwn  = 
+           (hdr->blockType & SRX_PROXY_BLOCK_TYPE_LATEST_SIGNATURE) != 0;
+
+  if (!getUpdateSigningData(cmdHandler->updCache, &updateID, &request.prefix,
+                            &request.attr, &request.attrLength, &noHops))
+  {
+    sendError(SRXERR_UPDATE_NOT_FOUND, item->serverSocket, item->client, 
+              false);
+  }
+  else if ((request.attr == NULL) && (noHops > 0))
+  {
+    // A path received without signatures can not be signed.
+    LOG(LEVEL_NOTICE, HDR "Update [0x%08X] has no BGPSec path attribute, it "
+        "can not be signed", pthread_self(), updateID);
+    sendError(SRXERR_INTERNAL_ERROR, item->serverSocket, item->client, false);
+  }
+  else if (!queueBGPSecSigning(cmdHandler->bgpsecHandler, &request))
+  {
+    sendError(SRXERR_INTERNAL_ERROR, item->serverSocket, item->client, false);
+  }
+  free(request.attr);
 }
 
 /**
@@ -481,7 +673,9 @@ static void _processDeleteUpdate(CommandHandler* cmdHandler,
                             &updateID, htons(duHdr->keepWindow)))
   {
     // Reduce the updates by one. BZ308
-    cmdHandler->svrConnHandler->proxyMap[clThread->routerID].updateCount--;
+    __sync_sub_and_fetch(
+         &cmdHandler->svrConnHandler->proxyMap[clThread->routerID].updateCount,
+         1);
   }
   else
   {
@@ -512,19 +706,24 @@ static void _processPeerChange(CommandHandler* cmdHandler,
  * can be added by receiving a white list entry, BGPSEC entry, as well as a
  * request or action received from the SRx proxy.
  *
- * @param arg The Command Handler
+ * Each thread only processes the commands of its own command queue lane.
+ *
+ * @param arg The Command Handler Worker
  *
  */
 static void* handleCommands(void* arg)
 {
-  CommandHandler* cmdHandler = (CommandHandler*)arg;
+  CommandHandlerWorker* worker = (CommandHandlerWorker*)arg;
+  CommandHandler* cmdHandler = worker->cmdHandler;
   CommandQueueItem* item;
+  uint64_t start;
   bool keepGoing = true;
   uint8_t clientID = 0; // only used in process handshake and goodbye
 
   generalSignalProcess();
 
-  LOG (LEVEL_DEBUG, "([0x%08X]) > Command Handler Thread started!", pthread_self());
+  LOG (LEVEL_DEBUG, "([0x%08X]) > Command Handler Thread (lane %u) started!",
+       pthread_self(), worker->lane);
 
   while (keepGoing)
   {
@@ -532,7 +731,12 @@ static void* handleCommands(void* arg)
     // Block until the next command is available for this thread
     LOG(LEVEL_DEBUG, HDR "recvLock request ...%s", pthread_self(),__FUNCTION__);
 
-    item = fetchNextCommand(cmdHandler->queue);
+    item = fetchNextCommand(cmdHandler->queue, worker->lane);
+    if (item == NULL)
+    {
+      // The queue is not alive anymore.
+      break;
+    }
 
     switch (item->cmdType)
     {
@@ -565,6 +769,7 @@ static void* handleCommands(void* arg)
                 RAISE_ERROR("Handshake between SRx and proxy failed. Shutdown "
                             "TCP connection!");
 
+                releaseClientSendBuffer(item->client);
                 closeClientConnection(&cmdHandler->svrConnHandler->svrSock,
                                       item->client);
 		            deleteFromSList(&cmdHandler->svrConnHandler->clients,
@@ -573,13 +778,16 @@ static void* handleCommands(void* arg)
               break;
             case PDU_SRXPROXY_VERIFY_V4_REQUEST:
             case PDU_SRXPROXY_VERIFY_V6_REQUEST:
+              start = getStageTime();
               _processUpdateValidation(cmdHandler, item);
+              recordStage(STAGE_VALIDATION, start);
               break;
             case PDU_SRXPROXY_SIGN_REQUEST:
               _processUpdateSigning(cmdHandler, item);
               break;
             case PDU_SRXPROXY_GOODBYE:
               gbhdr = (SRXPROXY_GOODBYE*)item->data;
+              releaseClientSendBuffer(item->client);
               closeClientConnection(&cmdHandler->svrConnHandler->svrSock,
                                     item->client);
               clientID = ((ClientThread*)item->client)->routerID;
@@ -605,6 +813,7 @@ static void* handleCommands(void* arg)
               sendError(SRXERR_INVALID_PACKET, item->serverSocket,
                         item->client, false);
               sendGoodbye(item->serverSocket, item->client, false);
+              releaseClientSendBuffer(item->client);
               closeClientConnection(&cmdHandler->svrConnHandler->svrSock,
                                     item->client);
 
@@ -626,17 +835,15 @@ static void* handleCommands(void* arg)
       // Still keep going.
     }
 
-    if (cmdHandler->queue->nextItemNode != NULL)
-    {
-      LOG(LEVEL_DEBUG, HDR "recv Unlock request ...%s", pthread_self(),
-                       __FUNCTION__);
-      //unlockMutex(&cmdHandler->queue->recvMutex);
-      //signalCond(&cmdHandler->queue->recvCond);
-    }
-
     // Now remove the item from command handler. it is processed.
     deleteCommand(cmdHandler->queue, item);
 
+    // Let the proxies resume as soon as the queues drained.
+    if (cmdHandler->svrConnHandler->flowPaused)
+    {
+      updateFlowControl(cmdHandler->svrConnHandler);
+    }
+
   } /* end of while */
 
   LOG (LEVEL_DEBUG, "([0x%08X]) < Command Handler Thread stopped!",
@@ -698,9 +905,13 @@ bool broadcastResult(CommandHandler* self, SRxValidationResult* valResult)
       if (self->svrConnHandler->proxyMap[clients[clientCt]].isActive)
       {
         client = self->svrConnHandler->proxyMap[clients[clientCt]].socket;
+        __sync_add_and_fetch(
+          &self->svrConnHandler->proxyMap[clients[clientCt]].noNotifications,
+          1);
 
-        retVal |= sendPacketToClient(&self->svrConnHandler->svrSock,
-                                     client , pdu, pduLength);
+        retVal |= sendPacketToProxy(&self->svrConnHandler->svrSock,
+                                    client , pdu, pduLength, 
+                                    !self->sysConfig->mode_no_sendqueue);
       }
       // If the mapping is inactive the proxy might be in reboot.
     }
@@ -711,3 +922,163 @@ bool broadcastResult(CommandHandler* self, SRxValidationResult* valResult)
   return retVal;
 }
 
+/**
+ * Send the result to the client using a single verification notification.
+ *
+ * @param self Instance
+ * @param mapping The mapping of the client.
+ * @param valResult The validation result.
+ *
+ * @return true if the notification could be send.
+ *
+ * @since 0.4.1.0
+ */
+static bool _sendResult(CommandHandler* self, ProxyClientMapping* mapping,
+                        SRxValidationResult* valResult)
+{
+  SRXPROXY_VERIFY_NOTIFICATION pdu;
+  uint32_t pduLength = sizeof(SRXPROXY_VERIFY_NOTIFICATION);
+
+  memset(&pdu, 0, pduLength);
+  pdu.type         = PDU_SRXPROXY_VERI_NOTIFICATION;
+  pdu.resultType   = (valResult->valType & SRX_FLAG_ROA_AND_BGPSEC);
+  pdu.roaResult    = valResult->valResult.roaResult;
+  pdu.bgpsecResult = valResult->valResult.bgpsecResult;
+  pdu.length       = htonl(pduLength);
+  pdu.updateID     = htonl(valResult->updateID);
+
+  return sendPacketToProxy(&self->svrConnHandler->svrSock, mapping->socket,
+                           &pdu, pduLength, 
+                           !self->sysConfig->mode_no_sendqueue);
+}
+
+/**
+ * Send the collected notifications of the multi verification notification to
+ * the client and empty it. While collecting, the number of notifications is
+ * kept in host order.
+ *
+ * @param self Instance
+ * @param mapping The mapping of the client.
+ * @param pdu The multi verification notification.
+ *
+ * @return true if the notification could be send.
+ *
+ * @since 0.4.1.0
+ */
+static bool _flushMultiNotification(CommandHandler* self, 
+                                    ProxyClientMapping* mapping,
+                                    SRXPROXY_VERIFY_NOTIFICATION_MULTI* pdu)
+{
+  uint32_t noNotifications = pdu->noNotifications;
+  uint32_t pduLength = sizeof(SRXPROXY_VERIFY_NOTIFICATION_MULTI)
+                       + (noNotifications * sizeof(SRXPROXY_NOTIFICATION_ENTRY));
+  bool retVal = false;
+
+  if ((noNotifications > 0) && mapping->isActive)
+  {
+    pdu->length          = htonl(pduLength);
+    pdu->noNotifications = htonl(noNotifications);
+    retVal = sendPacketToProxy(&self->svrConnHandler->svrSock, mapping->socket,
+                               pdu, pduLength, 
+                               !self->sysConfig->mode_no_sendqueue);
+  }
+  pdu->noNotifications = 0;
+
+  return retVal;
+}
+
+/**
+ * Sends the (new) results to all connected clients. Clients that negotiated
+ * SRX_HELLO_FLAG_MULTI_NOTIFY receive the results packed into multi 
+ * verification notifications, all others one notification per result.
+ *
+ * @param self Instance
+ * @param valResults The validation results.
+ * @param count The number of validation results.
+ *
+ * @return true if at least one notification could be send.
+ *
+ * @since 0.4.1.0
+ */
+bool broadcastResults(CommandHandler* self, SRxValidationResult* valResults,
+                      uint32_t count)
+{
+  SRXPROXY_VERIFY_NOTIFICATION_MULTI* multi[MAX_PROXY_CLIENT_ELEMENTS];
+  SRXPROXY_VERIFY_NOTIFICATION_MULTI* pdu;
+  SRXPROXY_NOTIFICATION_ENTRY*        entry;
+  SRxValidationResult* valResult;
+  ProxyClientMapping*  mapping;
+  uint8_t  clients[UINT8_MAX];
+  uint32_t pduLength = sizeof(SRXPROXY_VERIFY_NOTIFICATION_MULTI)
+                       + (SRX_MAX_MULTI_NOTIFICATIONS 
+                          * sizeof(SRXPROXY_NOTIFICATION_ENTRY));
+  uint32_t idx;
+  int      clientCt;
+  bool     retVal = false;
+
+  memset(multi, 0, sizeof(multi));
+  for (idx = 0; idx < count; idx++)
+  {
+    valResult = &valResults[idx];
+    clientCt  = getClientIDsOfUpdate(self->updCache, &valResult->updateID,
+                                     clients, UINT8_MAX);
+    if (clientCt == -1)
+    {
+      RAISE_SYS_ERROR("Cannot send update results, client management "
+                      "failed!!");
+      continue;
+    }
+
+    while (clientCt-- > 0)
+    {
+      mapping = &self->svrConnHandler->proxyMap[clients[clientCt]];
+      // If the mapping is inactive the proxy might be in reboot.
+      if (!mapping->isActive)
+      {
+        continue;
+      }
+      __sync_add_and_fetch(&mapping->noNotifications, 1);
+      pdu = multi[clients[clientCt]];
+      if (mapping->multiNotify && (pdu == NULL))
+      {
+        pdu = malloc(pduLength);
+        if (pdu != NULL)
+        {
+          memset(pdu, 0, sizeof(SRXPROXY_VERIFY_NOTIFICATION_MULTI));
+          pdu->type = PDU_SRXPROXY_VERI_NOTIFICATION_MULTI;
+          multi[clients[clientCt]] = pdu;
+        }
+      }
+      if (pdu == NULL)
+      {
+        retVal |= _sendResult(self, mapping, valResult);
+        continue;
+      }
+
+      entry = &pdu->notification[pdu->noNotifications++];
+      entry->updateID     = htonl(valResult->updateID);
+      entry->resultType   = (valResult->valType & SRX_FLAG_ROA_AND_BGPSEC);
+      entry->roaResult    = valResult->valResult.roaResult;
+      entry->bgpsecResult = valResult->valResult.bgpsecResult;
+      entry->zero         = 0;
+      if (pdu->noNotifications == SRX_MAX_MULTI_NOTIFICATIONS)
+      {
+        retVal |= _flushMultiNotification(self, mapping, pdu);
+      }
+    }
+  }
+
+  for (idx = 0; idx < MAX_PROXY_CLIENT_ELEMENTS; idx++)
+  {
+    if (multi[idx] != NULL)
+    {
+      retVal |= _flushMultiNotification(self, 
+                                        &self->svrConnHandler->proxyMap[idx], 
+                                        multi[idx]);
+      free(multi[idx]);
+    }
+  }
+
+  return retVal;
+}
+
@@ -21,10 +21,14 @@
  * by this software.
  * 
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0 - 2026/10/14 - kyehwanl
+ *            * Replaced the fixed NUM_COMMAND_HANDLER_THREADS by a configurable
+ *              number of worker threads, each serving one command queue lane.
+ *            * Added broadcastResults.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  * 0.3.0    - 2013/01/28 - oborchert
@@ -49,15 +53,30 @@
 #include "util/server_socket.h"
 
 /**
- * Number of parallel threads.
+ * Maximum number of parallel threads. Each thread serves one lane of the
+ * command queue.
  */
-#define NUM_COMMAND_HANDLER_THREADS 1
-// #define NUM_COMMAND_HANDLER_THREADS 2
+#define MAX_COMMAND_HANDLER_THREADS MAX_COMMAND_QUEUE_LANES
+
+/* Forward declaration */
+struct _CommandHandler;
 
 /**
- * A single Command Handler.
+ * A single command handler worker thread.
  */
 typedef struct {
+  /** The command handler this worker belongs to. */
+  struct _CommandHandler* cmdHandler;
+  /** The command queue lane this worker consumes. */
+  uint8_t                 lane;
+  /** The worker thread. */
+  pthread_t               thread;
+} CommandHandlerWorker;
+
+/**
+ * A single Command Handler.
+ */
+typedef struct _CommandHandler {
   // Arguments (create)
   ServerConnectionHandler*  svrConnHandler;
   BGPSecHandler*            bgpsecHandler;
@@ -71,7 +90,7 @@ typedef struct {
   CommandQueue*             queue;
 
   // Internal
-  pthread_t                 threads[NUM_COMMAND_HANDLER_THREADS];
+  CommandHandlerWorker      workers[MAX_COMMAND_HANDLER_THREADS];
   int                       numThreads;
 } CommandHandler;
 
@@ -101,7 +120,8 @@ void releaseCommandHandler(CommandHandler* self);
 /**
  * Handles all commands in the given queue.
  * 
- * @note Spawns a threads, i.e. is non-blocking
+ * @note Spawns one thread per lane of the command queue, i.e. is 
+ *       non-blocking
  *
  * @param self Instance
  * @param cmdQueue An existing Command Queue
@@ -128,5 +148,21 @@ void stopProcessingCommands(CommandHandler* self);
  */
 bool broadcastResult(CommandHandler* self, SRxValidationResult* valResult);
 
+/**
+ * Sends the (new) results to all connected clients. Clients that negotiated
+ * SRX_HELLO_FLAG_MULTI_NOTIFY receive the results packed into multi 
+ * verification notifications, all others one notification per result.
+ *
+ * @param self Instance
+ * @param valResults The validation results.
+ * @param count The number of validation results.
+ *
+ * @return true if at least one notification could be send.
+ *
+ * @since 0.4.1.0
+ */
+bool broadcastResults(CommandHandler* self, SRxValidationResult* valResults,
+                      uint32_t count);
+
 #endif // !__COMMAND_HANDLER_H__
 
@@ -20,10 +20,30 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0 - 2026/10/15 - kyehwanl
+ *           * Each lane keeps one ring per priority, fetchNextCommand serves
+ *             them by a smooth weighted round robin. Session commands also
+ *             wait for the older items of the other rings of their lane.
+ *           * The idle ring is served only if all other rings of the lane are
+ *             empty. Queueing into a full idle ring fails instead of waiting
+ *             and idle items never keep a receive chunk.
+ *           * Session commands do not wait for the idle rings.
+ *           * Copies of large packets are packet buffers.
+ *           * Trace the fetch of sampled updates.
+ *           * Name the locks for the lock statistics.
+ *           * Account the rings under MEM_TAG_COMMAND_QUEUE.
+ *         - 2026/10/14 - kyehwanl
+ *           * Lanes are lock-free ring buffers with inline packet storage. The
+ *             mutex of a lane is only used to sleep while the lane is empty.
+ *           * Split the queue into lanes, one per command handler thread.
+ *           * Added barrier handling for session commands.
+ *           * Packets still stored in the receive chunk are referenced by the
+ *             item instead of being copied. deleteCommand releases them.
+ *           * Record the command queue wait time and lane depth.
  *   0.3.0 - 2013/02/06 - oborchert
  *           * Added Version Control
  *           * Changed log level of output during shutdown
@@ -34,55 +54,253 @@
  * -----------------------------------------------------------------------------
  */
 
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "server/command_queue.h"
+#include "server/stage_stats.h"
 #include "shared/srx_defs.h"
 #include "shared/srx_packets.h"
+#include "util/lock_stats.h"
 #include "util/log.h"
 #include "util/math.h"
+#include "util/mem_stats.h"
 
 #define HDR "([0x%08X] Command Queue): "
 
+/** Number of attempts to fetch an item before the consumer goes to sleep. */
+#define FETCH_SPIN_COUNT 64
+
+/** Micro seconds a producer waits before it retries to queue into a full 
+ * lane. */
+#define QUEUE_FULL_WAIT_US 50
+
+/** The number of slots of each ring. */
+static const uint32_t _ringSize[NUM_COMMAND_PRIORITIES] = {
+  COMMAND_QUEUE_CONTROL_SIZE, COMMAND_QUEUE_DELETE_SIZE,
+  COMMAND_QUEUE_LANE_SIZE, COMMAND_QUEUE_BULK_SIZE, COMMAND_QUEUE_IDLE_SIZE
+};
+
+/** The round robin weight of each ring. Under load a lane serves 8 control,
+ * 4 delete, 2 verify and 1 bulk command in each round. The idle ring does not
+ * take part in the round robin. */
+static const int _ringWeight[NUM_COMMAND_PRIORITIES] = { 8, 4, 2, 1, 0 };
+
+/**
+ * Initializes a single ring of a lane.
+ *
+ * @param ring The ring to be initialized.
+ * @param size The number of slots, a power of 2.
+ *
+ * @return true if the ring could be initialized.
+ *
+ * @since 0.4.1.0
+ */
+static bool _initializeRing(CommandQueueRing* ring, uint32_t size)
+{
+  uint32_t idx;
+
+  ring->slots = malloc(sizeof(CommandQueueSlot) * size);
+  if (ring->slots == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the command queue lane!");
+    return false;
+  }
+  addMemStats(MEM_TAG_COMMAND_QUEUE, sizeof(CommandQueueSlot) * size, 1);
+
+  // Each slot starts with its own position as sequence number.
+  for (idx = 0; idx < size; idx++)
+  {
+    ring->slots[idx].sequence = idx;
+  }
+  ring->mask       = size - 1;
+  ring->enqueuePos = 0;
+  ring->dequeuePos = 0;
+  ring->doneItems  = 0;
+
+  return true;
+}
+
+/**
+ * Releases the rings of the given lane.
+ *
+ * @param lane The lane.
+ *
+ * @since 0.4.1.0
+ */
+static void _releaseRings(CommandQueueLane* lane)
+{
+  int prio;
+
+  for (prio = 0; prio < NUM_COMMAND_PRIORITIES; prio++)
+  {
+    if (lane->rings[prio].slots != NULL)
+    {
+      addMemStats(MEM_TAG_COMMAND_QUEUE,
+                  -(int64_t)(sizeof(CommandQueueSlot)
+                             * (lane->rings[prio].mask + 1)), -1);
+    }
+    free(lane->rings[prio].slots);
+    lane->rings[prio].slots = NULL;
+  }
+}
+
+/**
+ * Initializes a single lane of the command queue.
+ *
+ * @param lane The lane to be initialized.
+ *
+ * @return true if the lane could be initialized.
+ *
+ * @since 0.4.1.0
+ */
+static bool _initializeLane(CommandQueueLane* lane)
+{
+  int prio;
+
+  memset(lane->rings, 0, sizeof(lane->rings));
+  for (prio = 0; prio < NUM_COMMAND_PRIORITIES; prio++)
+  {
+    lane->credit[prio] = 0;
+    if (!_initializeRing(&lane->rings[prio], _ringSize[prio]))
+    {
+      _releaseRings(lane);
+      return false;
+    }
+  }
+
+  // Create the mutex used to sleep on an empty lane
+  if (!initMutex(&lane->cmdQueueMutex))
+  {
+    _releaseRings(lane);
+    return false;
+  }
+
+  if(!initCond(&lane->consumeCond))
+  {
+    releaseMutex(&lane->cmdQueueMutex);
+    _releaseRings(lane);
+    return false;
+  }
+
+  lane->waiters = 0;
+  setLockName(&lane->cmdQueueMutex, "commandQueue.cmdQueueMutex");
+
+  return true;
+}
+
+/**
+ * Releases the resources of the given lane.
+ *
+ * @param lane The lane to be released.
+ *
+ * @since 0.4.1.0
+ */
+static void _releaseLane(CommandQueueLane* lane)
+{
+  destroyCond(&lane->consumeCond);
+  releaseMutex(&lane->cmdQueueMutex);
+  _releaseRings(lane);
+}
+
+/**
+ * Return the number of items queued and not yet fetched in the given lane.
+ *
+ * @param lane The lane.
+ *
+ * @return The number of items.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t _getLaneDepth(CommandQueueLane* lane)
+{
+  uint32_t depth = 0;
+  int      prio;
+
+  for (prio = 0; prio < NUM_COMMAND_PRIORITIES; prio++)
+  {
+    depth += lane->rings[prio].enqueuePos - lane->rings[prio].dequeuePos;
+  }
+
+  return depth;
+}
+
 /** 
  * Initializes and setup the command queue.
  *
  * @param self Variable that should be initialized
+ * @param numLanes The number of lanes (command handler threads), at least 1
+ *                 and at most MAX_COMMAND_QUEUE_LANES.
  * 
  * @return true if the queue could be initialized.
  */
-bool initializeCommandQueue(CommandQueue* self)
+bool initializeCommandQueue(CommandQueue* self, uint8_t numLanes)
 {
+  int idx;
+
   if (self->alive)
   {
     RAISE_ERROR("This command queue is already alive!!");  
     return false;
   }
-  
-  // Create read and write Mutex
-  if (!initMutex(&self->cmdQueueMutex))
+
+  if ((numLanes == 0) || (numLanes > MAX_COMMAND_QUEUE_LANES))
   {
+    RAISE_ERROR("Invalid number of command queue lanes (%u)!", numLanes);
     return false;
   }
 
-  if(!initCond(&self->consumeCond))
+  if (!initMutex(&self->barrierMutex))
   {
-    releaseMutex(&self->cmdQueueMutex);
-    pthread_cond_destroy(&self->consumeCond);
     return false;
   }
 
-  // An empty list
-  self->totalItems = 0;
-  self->unprocessedItems = 0;
-  initSList(&self->queue);
+  if (!initCond(&self->barrierCond))
+  {
+    releaseMutex(&self->barrierMutex);
+    return false;
+  }
 
-  // No item is available, i.e. block fetch
-  self->nextItemNode = NULL;
+  for (idx = 0; idx < numLanes; idx++)
+  {
+    if (!_initializeLane(&self->lanes[idx]))
+    {
+      while (idx-- > 0)
+      {
+        _releaseLane(&self->lanes[idx]);
+      }
+      destroyCond(&self->barrierCond);
+      releaseMutex(&self->barrierMutex);
+      return false;
+    }
+  }
 
-  self->alive = true;
+  self->numLanes       = numLanes;
+  self->barrierWaiters = 0;
+  self->alive          = true;
   
   return true;
 }
 
+/**
+ * Wake up the consumer of the given lane in case it sleeps.
+ *
+ * @param lane The lane
+ *
+ * @since 0.4.1.0
+ */
+static inline void _wakeupConsumer(CommandQueueLane* lane)
+{
+  // Make sure the published slot is visible before the waiters are checked.
+  __sync_synchronize();
+  if (lane->waiters > 0)
+  {
+    lockMutex(&lane->cmdQueueMutex);
+    signalCond(&lane->consumeCond);
+    unlockMutex(&lane->cmdQueueMutex);
+  }
+}
+
 /** Used to destroy command queue. The queue is not usable after executing 
  * this command.
  * 
@@ -92,22 +310,160 @@ void releaseCommandQueue(CommandQueue* self)
 {
   if (self != NULL)
   {
+    int idx;
+
     LOG(LEVEL_DEBUG, HDR "Release Command Queue", pthread_self());    
-    lockMutex(&self->cmdQueueMutex);
     LOG(LEVEL_DEBUG, HDR "Set alive = false", pthread_self());    
     self->alive = false;
-    LOG(LEVEL_DEBUG, HDR "Signal consumer (fetch thread)", pthread_self());        
-    signalCond(&self->consumeCond);    
-    
-    unlockMutex(&self->cmdQueueMutex);
+    LOG(LEVEL_DEBUG, HDR "Signal consumer (fetch threads)", pthread_self());
+    for (idx = 0; idx < self->numLanes; idx++)
+    {
+      lockMutex(&self->lanes[idx].cmdQueueMutex);
+      signalCond(&self->lanes[idx].consumeCond);
+      unlockMutex(&self->lanes[idx].cmdQueueMutex);
+    }
+    lockMutex(&self->barrierMutex);
+    signalCond(&self->barrierCond);
+    unlockMutex(&self->barrierMutex);
     
     LOG(LEVEL_DEBUG, HDR "Now empty command queue", pthread_self());    
     removeAllCommands(self);
        
-    LOG(LEVEL_DEBUG, HDR "Release internal list and Mutex", pthread_self());    
+    LOG(LEVEL_DEBUG, HDR "Release internal ring buffers and Mutex", 
+                     pthread_self());    
     // Release all items and the mutexes
-    releaseSList(&self->queue); 
-    releaseMutex(&self->cmdQueueMutex);
+    for (idx = 0; idx < self->numLanes; idx++)
+    {
+      _releaseLane(&self->lanes[idx]);
+    }
+    destroyCond(&self->barrierCond);
+    releaseMutex(&self->barrierMutex);
+  }
+}
+
+/**
+ * Determine the lane for the given data ID.
+ *
+ * @param self The command queue
+ * @param dataID The data ID (update ID)
+ *
+ * @return The lane index.
+ *
+ * @since 0.4.1.0
+ */
+static inline uint8_t _getLane(CommandQueue* self, uint32_t dataID)
+{
+  return (uint8_t)(dataID % self->numLanes);
+}
+
+/**
+ * Claim the next free slot of the ring.
+ *
+ * @param ring The ring
+ *
+ * @return The claimed slot or NULL if the ring is full.
+ *
+ * @since 0.4.1.0
+ */
+static CommandQueueSlot* _claimSlot(CommandQueueRing* ring)
+{
+  CommandQueueSlot* slot;
+  uint32_t pos = ring->enqueuePos;
+  int32_t  dif;
+
+  for (;;)
+  {
+    slot = &ring->slots[pos & ring->mask];
+    dif  = (int32_t)(slot->sequence - pos);
+    if (dif == 0)
+    {
+      if (__sync_bool_compare_and_swap(&ring->enqueuePos, pos, pos + 1))
+      {
+        slot->item.position = pos;
+        return slot;
+      }
+    }
+    else if (dif < 0)
+    {
+      // The slot is not yet deleted by the consumer - full.
+      return NULL;
+    }
+    pos = ring->enqueuePos;
+  }
+}
+
+/**
+ * Fetch the next filled slot of the ring.
+ *
+ * @param ring The ring
+ *
+ * @return The slot or NULL if the ring is empty.
+ *
+ * @since 0.4.1.0
+ */
+static CommandQueueSlot* _fetchSlot(CommandQueueRing* ring)
+{
+  CommandQueueSlot* slot;
+  uint32_t pos = ring->dequeuePos;
+  int32_t  dif;
+
+  for (;;)
+  {
+    slot = &ring->slots[pos & ring->mask];
+    dif  = (int32_t)(slot->sequence - (pos + 1));
+    if (dif == 0)
+    {
+      if (__sync_bool_compare_and_swap(&ring->dequeuePos, pos, pos + 1))
+      {
+        __sync_synchronize();
+        return slot;
+      }
+    }
+    else if (dif < 0)
+    {
+      // Empty
+      return NULL;
+    }
+    pos = ring->dequeuePos;
+  }
+}
+
+/**
+ * Hand the slot of the given item back to the producers.
+ *
+ * @param self The command queue
+ * @param item The item to be released.
+ *
+ * @since 0.4.1.0
+ */
+static void _releaseSlot(CommandQueue* self, CommandQueueItem* item)
+{
+  CommandQueueRing* ring = &self->lanes[item->lane].rings[item->priority];
+  CommandQueueSlot* slot = &ring->slots[item->position & ring->mask];
+
+  if (item->chunk != NULL)
+  {
+    releasePacketChunk(item->chunk);
+  }
+  else if (item->data != slot->inlineData)
+  {
+    freePacketBuffer(item->data);
+  }
+  free(item->barrier);
+  item->chunk   = NULL;
+  item->data    = NULL;
+  item->barrier = NULL;
+
+  __sync_synchronize();
+  slot->sequence = item->position + ring->mask + 1;
+  __sync_add_and_fetch(&ring->doneItems, 1);
+
+  if (self->barrierWaiters > 0)
+  {
+    // Wake up a waiting session command.
+    lockMutex(&self->barrierMutex);
+    signalCond(&self->barrierCond);
+    unlockMutex(&self->barrierMutex);
   }
 }
 
@@ -117,128 +473,353 @@ void releaseCommandQueue(CommandQueue* self)
  *
  * @param self The command queue where the command has to be added to
  * @param cmdType The type of the command.
+ * @param priority The priority class, selects the ring within the lane.
  * @param svrSock The server socket
  * @param client The server client
  * @param dataID An identifier related to the data block. In case of SRX_PROXY
- *               this identifier contains either 0 or the update ID.
+ *               this identifier contains either 0 or the update ID. It also
+ *               selects the lane the command is queued in.
  * @param dataLength The length of the data attached to this command queue.
- * @param data The data package attached.
+ * @param data The data package attached. If it is stored in the chunk the
+ *             calling thread dispatches, a reference is kept instead of a
+ *             copy.
  *
  * @return true if the command could be added to the queue.
  */
 bool queueCommand(CommandQueue* self, CommandQueueType cmdType,
-                  ServerSocket* svrSock, ServerClient* client, uint32_t dataID,
-                  uint32_t dataLength, uint8_t* data)
+                  CommandQueuePriority priority, ServerSocket* svrSock,
+                  ServerClient* client, uint32_t dataID, uint32_t dataLength,
+                  uint8_t* data)
 {
-  // This method is changed in such that the wait mutex is synchronized with
-  // the fetchCommand method. The waitmutex is locked and a notify is called 
-  // once a command is placed and the counter is incresed. The mutex is released
-  // afterwards.
-  
   if (!self->alive)
   {
-    LOG(LEVEL_DEBUG, HDR, "Command Queue is not alive anymore, cannot queue "
-                          "command type (%u)!", pthread_self(), cmdType);
+    LOG(LEVEL_DEBUG, HDR "Command Queue is not alive anymore, cannot queue "
+                         "command type (%u)!", pthread_self(), cmdType);
     return false;
   }
   
   LOG(LEVEL_DEBUG, HDR "queueComamnd type (%u)", pthread_self(), cmdType);
-  CommandQueueItem* newItem;    
+  CommandQueueSlot* slot;
+  CommandQueueItem* newItem;
+  uint8_t           laneIdx = _getLane(self, dataID);
+  CommandQueueLane* lane    = &self->lanes[laneIdx];
+  CommandQueueRing* ring;
+  uint32_t*         barrier = NULL;
+  uint8_t*          buffer  = NULL;
+  PacketChunk*      chunk   = NULL;
+  int               idx;
+  int               prio;
 
-  // Try to add a new item - make sure no one modifies the queue
-  lockMutex(&self->cmdQueueMutex);  
-  newItem = (CommandQueueItem*)appendToSList(&self->queue, 
-                                             sizeof(CommandQueueItem));
-  newItem->consumed = false;
-  
-  // Set the new next node inside this mutex to make sure we -
-  // - get the new item
-  // - unlock only once
-  if (self->nextItemNode == NULL)
+  if ((priority < 0) || (priority >= NUM_COMMAND_PRIORITIES))
   {
-    self->nextItemNode = getLastNodeOfSList(&self->queue);
+    RAISE_ERROR("Invalid command queue priority (%u)!", priority);
+    return false;
   }
+  ring = &lane->rings[priority];
 
-  // Failed to add an item
-  if (newItem == NULL)
+  //TODO: BZ197 This might be revisited - Dirty BUG test
+  if ((data != NULL) && (dataLength >= 1000000)) // increased by factor 10
   {
-    unlockMutex(&self->cmdQueueMutex);
+    // SEGV due to dataLength : 50529027 (0x03030303)
+    RAISE_SYS_ERROR("Given datalength too big due to transmission error "
+      "- Inform developers with reference code BZ197!");
     return false;
   }
 
-  // 'NULL' packet
-  if (data == NULL)
+  // Packets still stored in the receive chunk are referenced, other large 
+  // packets need their own memory. Idle items might wait long, they must not
+  // hold back the receive chunk.
+  if ((data != NULL) && (priority != COMMAND_PRIORITY_IDLE))
   {
-    newItem->data = NULL;
-  } 
-  else
+    chunk = retainDispatchedPacket(data, dataLength);
+  }
+  if ((chunk == NULL) && (data != NULL) 
+      && (dataLength > COMMAND_QUEUE_INLINE_DATA))
   {
-    // Try to copy the 'packet' into the command item
-    newItem->data = malloc(dataLength);
-    if (newItem->data == NULL)
+    buffer = allocPacketBuffer(dataLength);
+    if (buffer == NULL)
     {
       RAISE_SYS_ERROR("Not enough memory to copy the data into the queue");
-      deleteFromSList(&self->queue, newItem);
-      
       return false;
     }
-    //TODO: BZ197 This might be revisited - Dirty BUG test
-    if (dataLength < 1000000) // dirty bug test - increased by factor 10
+    memcpy(buffer, data, dataLength);
+  }
+
+  // Session commands such as goodbye do not carry an update ID. They must not
+  // overtake the commands already queued in the other lanes or in the other
+  // rings of their own lane. A hello starts a new session, nothing queued
+  // before it can belong to that session. The idle rings are not part of the
+  // barrier, they are only served without load and their deferred
+  // validations do not depend on the session.
+  if ((cmdType == COMMAND_TYPE_SRX_PROXY) && (dataID == 0) 
+      && ((data == NULL)
+          || (((SRXPROXY_BasicHeader*)data)->type != PDU_SRXPROXY_HELLO)))
+  {
+    barrier = malloc(sizeof(uint32_t) * self->numLanes
+                     * NUM_COMMAND_PRIORITIES);
+    if (barrier == NULL)
+    {
+      RAISE_SYS_ERROR("Not enough memory to queue a session command");
+      releasePacketChunk(chunk);
+      freePacketBuffer(buffer);
+      return false;
+    }
+    for (idx = 0; idx < self->numLanes; idx++)
     {
-      memcpy(newItem->data, data, dataLength); 
-      // SEGV due to dataLength : 50529027 (0x03030303)
+      for (prio = 0; prio < NUM_COMMAND_PRIORITIES; prio++)
+      {
+        barrier[idx * NUM_COMMAND_PRIORITIES + prio] =
+                               (prio != COMMAND_PRIORITY_IDLE)
+                               ? self->lanes[idx].rings[prio].enqueuePos : 0;
+      }
     }
-    else
+  }
+
+  // Claim a slot, in case the ring is full wait for the consumer. A full idle
+  // ring is not waited for, the caller drops the deferred command.
+  while ((slot = _claimSlot(ring)) == NULL)
+  {
+    if (!self->alive || (priority == COMMAND_PRIORITY_IDLE))
     {
-      RAISE_SYS_ERROR("Given datalength too big due to transmission error "
-        "- Inform developers with reference code BZ197!");
-      deleteFromSList(&self->queue, newItem);
-      unlockMutex(&self->cmdQueueMutex);
+      releasePacketChunk(chunk);
+      freePacketBuffer(buffer);
+      free(barrier);
       return false;
     }
+    LOG(LEVEL_DEBUG, HDR "Command queue lane %u ring %u is full, wait...",
+                     pthread_self(), laneIdx, priority);
+    _wakeupConsumer(lane);
+    usleep(QUEUE_FULL_WAIT_US);
   }
 
-  // Set the other item members
+  newItem = &slot->item;
+  newItem->consumed     = false;
+  newItem->lane         = laneIdx;
+  newItem->priority     = (uint8_t)priority;
+  newItem->barrier      = barrier;
   newItem->serverSocket = svrSock;
   newItem->client       = client;
   newItem->cmdType      = cmdType;
   newItem->dataID       = dataID;
   newItem->dataLength   = dataLength;
-    
-  self->totalItems++;
-  self->unprocessedItems++;
-  
+  newItem->chunk        = chunk;
+  newItem->queued       = getStageTime();
+
+  if (data == NULL)
+  {
+    // 'NULL' packet
+    newItem->data = NULL;
+  } 
+  else if (chunk != NULL)
+  {
+    newItem->data = data;
+  }
+  else if (buffer == NULL)
+  {
+    newItem->data = slot->inlineData;
+    memcpy(newItem->data, data, dataLength); 
+  }
+  else
+  {
+    newItem->data = buffer;
+  }
+
+  // Publish the slot to the consumer.
+  __sync_synchronize();
+  slot->sequence = newItem->position + 1;
+
   LOG(LEVEL_DEBUG, HDR "Signale new data to consume...%s", pthread_self(),
                    __FUNCTION__);
-  signalCond(&self->consumeCond);
-  
-  LOG(LEVEL_DEBUG, HDR "UNLOCK readWriteLock...%s", pthread_self(),
-                   __FUNCTION__);
-  unlockMutex(&self->cmdQueueMutex);
+  _wakeupConsumer(lane);
+  recordQueueDepth(STATS_QUEUE_COMMAND, _getLaneDepth(lane));
 
   return true;
 }
 
+/**
+ * Determine if the given lane processed all items that were queued before the
+ * given barrier item. The ring of the item itself is not checked in its own
+ * lane, it is processed in order. The idle ring is never checked.
+ *
+ * @param self The command queue
+ * @param item The barrier item
+ * @param laneIdx The lane to check.
+ *
+ * @return true if all prior items of the lane are processed.
+ *
+ * @since 0.4.1.0
+ */
+static bool _isBarrierDone(CommandQueue* self, CommandQueueItem* item,
+                           uint8_t laneIdx)
+{
+  CommandQueueLane* lane = &self->lanes[laneIdx];
+  uint32_t*         barrier = &item->barrier[laneIdx * NUM_COMMAND_PRIORITIES];
+  int               prio;
+
+  for (prio = 0; prio < NUM_COMMAND_PRIORITIES; prio++)
+  {
+    if (((laneIdx != item->lane) || (prio != item->priority))
+        && (prio != COMMAND_PRIORITY_IDLE)
+        && ((int32_t)(lane->rings[prio].doneItems - barrier[prio]) < 0))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Block until all other lanes processed the items that were queued before the
+ * given barrier item.
+ *
+ * @param self The command queue
+ * @param item The barrier item
+ *
+ * @since 0.4.1.0
+ */
+static void _waitForBarrier(CommandQueue* self, CommandQueueItem* item)
+{
+  int  idx;
+  bool done = false;
+
+  lockMutex(&self->barrierMutex);
+  __sync_add_and_fetch(&self->barrierWaiters, 1);
+  while (self->alive && !done)
+  {
+    done = true;
+    for (idx = 0; idx < self->numLanes; idx++)
+    {
+      if ((idx != item->lane) && !_isBarrierDone(self, item, idx))
+      {
+        done = false;
+        break;
+      }
+    }
+    if (!done)
+    {
+      LOG(LEVEL_DEBUG, HDR "Session command waits for lane %u.", 
+                       pthread_self(), idx);
+      waitCond(&self->barrierCond, &self->barrierMutex, 0);
+    }
+  }
+  __sync_sub_and_fetch(&self->barrierWaiters, 1);
+  unlockMutex(&self->barrierMutex);
+}
+
+/**
+ * Determine if the ring is blocked by a session command at its head that
+ * still waits for older items in the other rings of its lane. This prevents
+ * the consumer from fetching it before it can be processed.
+ *
+ * @param self The command queue
+ * @param laneIdx The lane of the ring.
+ * @param prio The ring within the lane.
+ *
+ * @return true if the ring must not be served.
+ *
+ * @since 0.4.1.0
+ */
+static bool _isRingBlocked(CommandQueue* self, uint8_t laneIdx, int prio)
+{
+  CommandQueueRing* ring = &self->lanes[laneIdx].rings[prio];
+  uint32_t          pos  = ring->dequeuePos;
+  CommandQueueSlot* slot = &ring->slots[pos & ring->mask];
+
+  if ((int32_t)(slot->sequence - (pos + 1)) != 0)
+  {
+    // Empty or not yet published.
+    return false;
+  }
+  __sync_synchronize();
+
+  return (slot->item.barrier != NULL)
+         && !_isBarrierDone(self, &slot->item, laneIdx);
+}
+
+/**
+ * Fetch the next slot of the lane using a smooth weighted round robin over
+ * the rings that have items. Each ring with items gains its weight, the ring
+ * with the most credit is served and pays the weight of all competing rings.
+ * Rings without items do not collect credit. The idle ring is only served if
+ * no other ring has items.
+ *
+ * @param self The command queue
+ * @param laneIdx The lane to fetch from.
+ *
+ * @return The slot or NULL if the lane has no item that can be served.
+ *
+ * @since 0.4.1.0
+ */
+static CommandQueueSlot* _fetchWeighted(CommandQueue* self, uint8_t laneIdx)
+{
+  CommandQueueLane* lane  = &self->lanes[laneIdx];
+  CommandQueueSlot* slot  = NULL;
+  bool              ready[NUM_COMMAND_PRIORITIES];
+  int               best  = -1;
+  int               total = 0;
+  int               prio;
+
+  for (prio = 0; prio < NUM_COMMAND_PRIORITIES; prio++)
+  {
+    ready[prio] = (lane->rings[prio].enqueuePos
+                   != lane->rings[prio].dequeuePos)
+                  && !_isRingBlocked(self, laneIdx, prio);
+    if (!ready[prio])
+    {
+      lane->credit[prio] = 0;
+      continue;
+    }
+    if (_ringWeight[prio] == 0)
+    {
+      continue;
+    }
+    lane->credit[prio] += _ringWeight[prio];
+    total              += _ringWeight[prio];
+    if ((best < 0) || (lane->credit[prio] > lane->credit[best]))
+    {
+      best = prio;
+    }
+  }
+
+  if (best >= 0)
+  {
+    lane->credit[best] -= total;
+    slot = _fetchSlot(&lane->rings[best]);
+  }
+
+  // The selected slot might be claimed but not yet published. The idle ring
+  // is only tried if no other ring has items.
+  for (prio = 0; (slot == NULL) && (prio < NUM_COMMAND_PRIORITIES); prio++)
+  {
+    if (ready[prio] && ((best < 0) || (_ringWeight[prio] > 0)))
+    {
+      slot = _fetchSlot(&lane->rings[prio]);
+    }
+  }
+
+  return slot;
+}
+
 /**
  * Retrieves the next command. This method DOES NOT clear the memory. 
- * After a command is processed the method 'deleteCommand' will remove it from 
- * the queue and free up all associated memory.
+ * After a command is processed the method 'deleteCommand' will hand the slot
+ * back to the queue and free up all associated memory.
  * 
  * @param self The command queue
+ * @param laneIdx The lane to fetch from.
  * 
  * @return The command queue command.
  *  */
-CommandQueueItem* fetchNextCommand(CommandQueue* self)
+CommandQueueItem* fetchNextCommand(CommandQueue* self, uint8_t laneIdx)
 {
-  // Changed the mutex management in this method. It will lock the wait mutex 
-  // and wait unti la command is in the queue. once a command is read from the 
-  // queue the wait mutesx will be unlocked and the command will be returned.
-  // This method plays the loc/unlock mutex game with queuecommand
-  
+  CommandQueueSlot* slot = NULL;
+  CommandQueueLane* lane;
   CommandQueueItem* item;
+  int               spin;
   
-  LOG(LEVEL_DEBUG, HDR "Fetch next command from command queue...", 
-                   pthread_self());
+  LOG(LEVEL_DEBUG, HDR "Fetch next command from command queue lane %u...", 
+                   pthread_self(), laneIdx);
 
   if (!self->alive)
   {
@@ -246,76 +827,89 @@ CommandQueueItem* fetchNextCommand(CommandQueue* self)
                  " possible!");
     return NULL;
   }
- 
-  LOG(LEVEL_DEBUG, HDR "Request access lock to cmd Queue", pthread_self());
-  lockMutex(&self->cmdQueueMutex);
 
-  // Wait until a new item is in the queue
-  while (self->alive && self->unprocessedItems == 0)
+  if (laneIdx >= self->numLanes)
   {
-    LOG(LEVEL_DEBUG, HDR "No command in queue, wait until command arrives.", 
-                     pthread_self());
-    // Will be woken up by queueCommand
-    waitCond(&self->consumeCond, &self->cmdQueueMutex, 0);
-    LOG(LEVEL_DEBUG, HDR "Received notification of command arrival.", 
-                     pthread_self());
+    RAISE_ERROR ("Invalid command queue lane %u!", laneIdx);
+    return NULL;
+  }
+  lane = &self->lanes[laneIdx];
+
+  while (self->alive && (slot == NULL))
+  {
+    for (spin = 0; (slot == NULL) && (spin < FETCH_SPIN_COUNT); spin++)
+    {
+      slot = _fetchWeighted(self, laneIdx);
+    }
+
+    if (slot == NULL)
+    {
+      LOG(LEVEL_DEBUG, HDR "No command in queue, wait until command arrives.", 
+                       pthread_self());
+      lockMutex(&lane->cmdQueueMutex);
+      __sync_add_and_fetch(&lane->waiters, 1);
+      // Check again, the producer might have missed the waiters counter.
+      slot = _fetchWeighted(self, laneIdx);
+      if ((slot == NULL) && self->alive)
+      {
+        // Will be woken up by queueCommand
+        waitCond(&lane->consumeCond, &lane->cmdQueueMutex, 0);
+        LOG(LEVEL_DEBUG, HDR "Received notification of command arrival.", 
+                         pthread_self());
+      }
+      __sync_sub_and_fetch(&lane->waiters, 1);
+      unlockMutex(&lane->cmdQueueMutex);
+    }
   }
   
-  if (!self->alive)
+  if (slot == NULL)
   {
     LOG(LEVEL_INFO, HDR "Command queue is terminated during fetching command, "
                         "abort fetching!!!", pthread_self());
-    unlockMutex(&self->cmdQueueMutex);
     return NULL;
   }
   
-  // Retrieve the item and set the fetcher to the next one.
-  item = (CommandQueueItem*)self->nextItemNode->data;
-  self->unprocessedItems--;				// SEE also ./util/slist.c:106    
-  if (item == NULL)
-  {
-    RAISE_ERROR("Fatal CommandQueue encountered an empty command.");
-  }
+  item = &slot->item;
   if (item->consumed)
   {
     RAISE_ERROR("Fetch an already consumed command!!");
   }
   // Indicate this item is consumed and can be deleted.
   item->consumed = true;
-  
-  //move to next item.
-  self->nextItemNode = getNextNodeOfSListNode(self->nextItemNode);
-  // TODO: Check what happens to the memory allocated to store the command!!!
-  // Unlock the write mutex
-  unlockMutex(&self->cmdQueueMutex);  
+  recordStage(STAGE_COMMAND_QUEUE, item->queued);
+  if (   (item->cmdType == COMMAND_TYPE_SRX_PROXY)
+      && isUpdateTraced(item->dataID))
+  {
+    traceUpdate(item->dataID, TRACE_COMMAND_FETCH);
+  }
+
+  if (item->barrier != NULL)
+  {
+    _waitForBarrier(self, item);
+  }
 
   return item;
 }
 
 /**
- * Remove the queue element that is already consumed from the list and frees 
- * up all allocated memory associated with this element.
+ * Hands the queue element that is already consumed back to the queue and 
+ * frees up all allocated memory associated with this element.
  * 
  * @param self The command queue
- * @param item The item. It also will be freed!
+ * @param item The item. It MUST NOT be used afterwards!
  */
 void deleteCommand(CommandQueue* self, CommandQueueItem* item)
 {
   LOG(LEVEL_DEBUG, HDR "Delete the given command queue item.", pthread_self());
-  lockMutex (&self->cmdQueueMutex);
-  // Free The packet data within the item
-  if(item != NULL) 
+  if (item != NULL)
   {
-    free(item->data);
+    _releaseSlot(self, item);
   }
-  self->totalItems--;
-  // The delete from list also frees the item.
-  deleteFromSList(&self->queue, item);
-  unlockMutex(&self->cmdQueueMutex);
 }
 
 /**
- * Clears the complete queue.
+ * Clears the complete queue. Items already fetched by a consumer remain 
+ * untouched and must be deleted using deleteCommand.
  * 
  * @param self The command queue.
  */
@@ -323,34 +917,25 @@ void removeAllCommands(CommandQueue* self)
 {
   LOG(LEVEL_DEBUG, HDR "Remove all commands from the command queue.",
                    pthread_self());
-  SListNode* currNode;
-
-  // No adding or single removing allowed
-  lockMutex(&self->cmdQueueMutex);
+  CommandQueueSlot* slot;
+  int               idx;
+  int               prio;
 
-  // Release all packets stored in the items
-  FOREACH_SLIST(&self->queue, currNode)
+  for (idx = 0; idx < self->numLanes; idx++)
   {
-    void* p = ((CommandQueueItem*)getDataOfSListNode(currNode))->data;
-    if (p)
+    for (prio = 0; prio < NUM_COMMAND_PRIORITIES; prio++)
     {
-      free(p);
+      while ((slot = _fetchSlot(&self->lanes[idx].rings[prio])) != NULL)
+      {
+        _releaseSlot(self, &slot->item);
+      }
     }
   }
-  // Now delete the items.
-  emptySList(&self->queue);
 
-  if (self->nextItemNode != NULL)
-  {
-    RAISE_SYS_ERROR("Queue[0x%08X] Removing of all commands without success!", 
-                    self);
-  };
-  
-  self->totalItems       = self->queue.size;
-  self->unprocessedItems = self->nextItemNode == NULL ? 0 : self->totalItems;
-  
-  // Grant write access again
-  unlockMutex(&self->cmdQueueMutex); 
+  // Nothing is left to wait for.
+  lockMutex(&self->barrierMutex);
+  signalCond(&self->barrierCond);
+  unlockMutex(&self->barrierMutex);
 }
 
 /**
@@ -362,7 +947,19 @@ void removeAllCommands(CommandQueue* self)
  */
 inline int getTotalQueueSize(CommandQueue* self)
 {
-  return self->totalItems;
+  CommandQueueRing* ring;
+  int total = 0;
+  int idx;
+  int prio;
+  for (idx = 0; idx < self->numLanes; idx++)
+  {
+    for (prio = 0; prio < NUM_COMMAND_PRIORITIES; prio++)
+    {
+      ring   = &self->lanes[idx].rings[prio];
+      total += (int)(ring->enqueuePos - ring->doneItems);
+    }
+  }
+  return total;
 }
 
 /**
@@ -374,5 +971,17 @@ inline int getTotalQueueSize(CommandQueue* self)
  */
 inline int getUnprocessedQueueSize(CommandQueue* self)
 {
-  return self->unprocessedItems;
+  CommandQueueRing* ring;
+  int unprocessed = 0;
+  int idx;
+  int prio;
+  for (idx = 0; idx < self->numLanes; idx++)
+  {
+    for (prio = 0; prio < NUM_COMMAND_PRIORITIES; prio++)
+    {
+      ring         = &self->lanes[idx].rings[prio];
+      unprocessed += (int)(ring->enqueuePos - ring->dequeuePos);
+    }
+  }
+  return unprocessed;
 }
@@ -20,10 +20,24 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0 - 2026/10/15 - kyehwanl
+ *           * Each lane keeps one ring per priority class (control, delete,
+ *             verify, bulk). The rings are served by a weighted round robin.
+ *           * Added the idle priority class, served only if all other rings
+ *             of the lane are empty.
+ *         - 2026/10/14 - kyehwanl
+ *           * Replaced the SList of each lane by a pre-allocated lock-free 
+ *             ring buffer. Small packets are stored inside the ring slot.
+ *           * Split the queue into lanes, one per command handler thread.
+ *             Commands are assigned to a lane by their dataID (update ID) to
+ *             keep the per-update ordering. Session commands (dataID 0) are
+ *             queued as barriers and wait until all lanes caught up.
+ *           * Added the receive chunk reference to CommandQueueItem.
+ *           * Added the queue time to CommandQueueItem.
  *   0.3.0 - 2013/02/06 - oborchert
  *           * Added Version Control
  *           * Changed log level of output during shutdown
@@ -41,13 +55,55 @@
 #include "util/mutex.h"
 #include "util/packet.h"
 #include "util/server_socket.h"
-#include "util/slist.h"
 
 // Specifies the types of commands the queue can handle.
 typedef enum {
   COMMAND_TYPE_SRX_PROXY = 0,
   COMMAND_TYPE_SHUTDOWN  = 1
 } CommandQueueType;
+
+/**
+ * The priority classes of the commands. Each lane keeps one ring per class,
+ * the rings are served by a weighted round robin, a class without commands
+ * does not hold back the others.
+ *
+ * @since 0.4.1.0
+ */
+typedef enum {
+  COMMAND_PRIORITY_CONTROL = 0, // Handshake, goodbye, peer change, shutdown
+  COMMAND_PRIORITY_DELETE  = 1, // Update deletion (withdrawal)
+  COMMAND_PRIORITY_VERIFY  = 2, // Validation and signature requests
+  COMMAND_PRIORITY_BULK    = 3, // Bulk verify requests
+  COMMAND_PRIORITY_IDLE    = 4, // Deferred validations (lazy mode)
+
+  NUM_COMMAND_PRIORITIES   = 5  // Number of priorities (needs to be last)
+} CommandQueuePriority;
+
+/** The maximum number of lanes, one lane per command handler thread. */
+#define MAX_COMMAND_QUEUE_LANES 16
+
+/** The number of slots of the verify ring of each lane, all ring sizes MUST
+ * be a power of 2. */
+#define COMMAND_QUEUE_LANE_SIZE 16384
+
+/** The number of slots of the control ring of each lane. */
+#define COMMAND_QUEUE_CONTROL_SIZE 1024
+
+/** The number of slots of the delete ring of each lane. */
+#define COMMAND_QUEUE_DELETE_SIZE 4096
+
+/** The number of slots of the bulk ring of each lane. */
+#define COMMAND_QUEUE_BULK_SIZE 8192
+
+/** The number of slots of the idle ring of each lane. */
+#define COMMAND_QUEUE_IDLE_SIZE 16384
+
+/** Packets up to this size are stored within the slot itself. */
+#define COMMAND_QUEUE_INLINE_DATA 128
+
+/** The typical size of a cache line, used to separate the ring positions. */
+#define COMMAND_QUEUE_CACHE_LINE 64
+
 /** 
  * A Command Queue Item.
  */
@@ -58,25 +114,69 @@ typedef struct {
   uint32_t         dataID;       // For the case of SRX_PROXY  it contains the 
                                  // update id in host format.
   bool             consumed;     // Indicated if this element is already fetched
+  uint8_t          lane;         // The lane this item is queued in.
+  uint8_t          priority;     // The ring within the lane.
+  uint32_t         position;     // The ring position of this item.
+  uint32_t*        barrier;      // NULL or the number of items queued in each
+                                 // ring of each lane prior to this item
+                                 // (session commands), indexed by
+                                 // lane * NUM_COMMAND_PRIORITIES + priority
   uint32_t         dataLength;   // Length in Bytes of \c packet
   uint8_t*         data;         // The actual packet (= data)
+  PacketChunk*     chunk;        // The receive chunk data is stored in or NULL
+  uint64_t         queued;       // Time (ns) the item was queued.
 } CommandQueueItem;
 
+/**
+ * A single slot of the ring buffer.
+ */
+typedef struct {
+  volatile uint32_t sequence;   // Sequence number of the slot, tells if the 
+                                // slot is free, filled or in use.
+  CommandQueueItem  item;       // The item stored in this slot.
+  uint8_t           inlineData[COMMAND_QUEUE_INLINE_DATA]; // Small packets
+} CommandQueueSlot;
+
+/**
+ * A bounded multi producer / multi consumer ring buffer. A slot is handed back
+ * to the producers once the command is deleted.
+ *
+ * @since 0.4.1.0
+ */
+typedef struct {
+  CommandQueueSlot* slots;      // The ring buffer.
+  uint32_t          mask;       // The number of slots - 1
+  uint8_t           pad1[COMMAND_QUEUE_CACHE_LINE];
+  volatile uint32_t enqueuePos; // Number of items ever queued in this ring.
+  uint8_t           pad2[COMMAND_QUEUE_CACHE_LINE];
+  volatile uint32_t dequeuePos; // Number of items ever fetched from this ring.
+  uint8_t           pad3[COMMAND_QUEUE_CACHE_LINE];
+  volatile uint32_t doneItems;  // Number of items ever deleted from this ring.
+} CommandQueueRing;
+
+/**
+ * A single lane of the command queue. Each lane is consumed by exactly one
+ * command handler thread. The lane holds one ring per priority.
+ */
+typedef struct {
+  CommandQueueRing  rings[NUM_COMMAND_PRIORITIES]; // One ring per priority.
+  int               credit[NUM_COMMAND_PRIORITIES]; // Round robin credit of
+                                // each ring, only used by the consumer.
+  volatile int      waiters;    // Number of threads waiting for new items.
+  Mutex             cmdQueueMutex; // Only used to sleep on an empty lane.
+  Cond              consumeCond;   // The condition for consuming elements 
+                                   // from an empty lane.
+} CommandQueueLane;
+
 /**
  * A single Command Queue.
  */
 typedef struct {
-  SList       queue;          // The list that actually represents the queue.
-  SListNode*  nextItemNode;   // The next node containing a CommandQueueItem to be 
-                              // fetched.
-  Mutex       cmdQueueMutex; // Used to safely access the queue in read and
-                              // write
-  Cond        consumeCond;    // The condition for consuming elements from the 
-                              // command queue
-
-  int         totalItems;     // Total number of Items in the queue, unprocessed 
-                              // and processed.
-  int         unprocessedItems; // THe number of unprocessed Items.
+  CommandQueueLane lanes[MAX_COMMAND_QUEUE_LANES]; // The lanes of the queue.
+  uint8_t     numLanes;       // The number of lanes in use.
+  Mutex       barrierMutex;   // Used to wait for the doneItems counters.
+  Cond        barrierCond;    // Signaled each time a lane finished an item.
+  volatile int barrierWaiters; // Number of session commands waiting.
   bool        alive;          // used to stop fetching commands
 } CommandQueue;
 
@@ -84,10 +184,12 @@ typedef struct {
  * Initializes and setup the command queue.
  *
  * @param self Variable that should be initialized.
+ * @param numLanes The number of lanes (command handler threads), at least 1
+ *                 and at most MAX_COMMAND_QUEUE_LANES.
  * 
  * @return true if the queue could be initialized.
  */
-bool initializeCommandQueue(CommandQueue* self);
+bool initializeCommandQueue(CommandQueue* self, uint8_t numLanes);
 
 /**
  * Frees the whole queue.
@@ -102,29 +204,38 @@ void releaseCommandQueue(CommandQueue* self);
  *
  * @param self The command queue where the command has to be added to
  * @param cmdType The type of the command.
+ * @param priority The priority class, selects the ring within the lane.
  * @param svrSock The server socket
  * @param client The server client
  * @param dataID An identifier related to the data block. In case of SRX_PROXY
- *               this identifier contains either 0 or the update ID.
+ *               this identifier contains either 0 or the update ID. It also
+ *               selects the lane the command is queued in. SRX_PROXY commands
+ *               with the dataID 0 other than a hello are processed only after
+ *               all commands queued before them in any ring are processed.
  * @param dataLength The length of the data attached to this command queue.
- * @param data The data package attached.
+ * @param data The data package attached. If it is stored in the chunk the
+ *             calling thread dispatches, a reference is kept instead of a
+ *             copy.
  *
  * @return true if the command could be added to the queue.
  */
 bool queueCommand(CommandQueue* self, CommandQueueType cmdType,
-                  ServerSocket* svrSock, ServerClient* client, uint32_t dataID,
-                  uint32_t dataLength, uint8_t* data);
+                  CommandQueuePriority priority, ServerSocket* svrSock,
+                  ServerClient* client, uint32_t dataID, uint32_t dataLength,
+                  uint8_t* data);
 
 /** 
- * Returns the next item in the queue. The Item is NOT removed from the queue
- * until dequeueCommand is called. 
+ * Returns the next item in the given lane of the queue. The rings of the lane
+ * are selected by a weighted round robin. The Item is NOT removed from the
+ * queue until deleteCommand is called.
  *
  * @note Blocks until a command is available!
  *
  * @param self Queue instance
- * @return The next item
+ * @param lane The lane to fetch from.
+ * @return The next item or NULL if the queue is not alive anymore.
  */
-CommandQueueItem* fetchNextCommand(CommandQueue* self);
+CommandQueueItem* fetchNextCommand(CommandQueue* self, uint8_t lane);
 
 /**
  * Removes a command from the queue.
@@ -20,10 +20,33 @@
  * other licenses. Please refer to the licenses of all libraries required
  * by this software.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0 - 2026/10/14 - kyehwanl
+ *           * Added parameter command-handlers.
+ *           * Added parameter expected-updates.
+ *           * Added parameter event-loop-threads.
+ *           * Added parameter gc-budget.
+ *           * Added parameters snapshot.file and snapshot.interval.
+ *           * Added parameter rpki.cache and the rpki.caches list.
+ *         - 2026/10/15 - kyehwanl
+ *           * Added parameter metrics.port.
+ *           * Added parameter bgpsec.workers.
+ *           * Added parameter bgpsec.memo.
+ *           * Added parameter bgpsec.key.
+ *           * Added parameters expected-prefixes and expected-roas.
+ *           * Added parameter thread-cpus and the threads group.
+ *           * Added parameters shared-roa.name, shared-roa.mode, shared-roa.capacity
+ *             and shared-roa.interval.
+ *           * Added parameter shm-transport.
+ *           * Added parameter mode.lazy-validation.
+ *           * Added parameter mode.provisional-sync.
+ *           * Added parameter receiver-threads.
+ *           * Added parameters send-batch-delay and send-batch-bytes.
+ *           * Added parameters replication.port, replication.primary, and
+ *             replication.timeout.
  * 0.3.0.10- 2016-01-08 - oborchert
  *           * Fixed type cast problems in during configuration.
  *         - 2015/11/10 - oborchert
@@ -95,6 +118,79 @@
 #define CFG_PARAM_MODE_NO_SEND_QUEUE 10
 #define CFG_PARAM_MODE_NO_RCV_QUEUE  11
 
+#define CFG_PARAM_COMMAND_HANDLERS 12
+#define CFG_PARAM_EXPECTED_UPDATES 13
+#define CFG_PARAM_EVENT_LOOP       14
+#define CFG_PARAM_GC_BUDGET        15
+
+#define CFG_PARAM_SNAPSHOT_FILE     16
+#define CFG_PARAM_SNAPSHOT_INTERVAL 17
+
+#define CFG_PARAM_RPKI_CACHE 18
+
+#define CFG_PARAM_METRICS_PORT 19
+
+#define CFG_PARAM_BGPSEC_WORKERS 20
+#define CFG_PARAM_BGPSEC_MEMO    21
+#define CFG_PARAM_BGPSEC_KEY     22
+
+#define CFG_PARAM_EXPECTED_PREFIXES 23
+#define CFG_PARAM_EXPECTED_ROAS     24
+
+#define CFG_PARAM_THREAD_CPUS 25
+
+#define CFG_PARAM_SHARED_ROA_NAME     26
+#define CFG_PARAM_SHARED_ROA_MODE     27
+#define CFG_PARAM_SHARED_ROA_CAPACITY 28
+#define CFG_PARAM_SHARED_ROA_INTERVAL 29
+
+#define CFG_PARAM_SHM_TRANSPORT 30
+
+#define CFG_PARAM_MODE_LAZY_VALIDATION 31
+#define CFG_PARAM_MODE_PROVISIONAL_SYNC 32
+
+#define CFG_PARAM_RECEIVER_THREADS 33
+
+#define CFG_PARAM_SEND_BATCH_DELAY 34
+#define CFG_PARAM_SEND_BATCH_BYTES 35
+
+#define CFG_PARAM_REPLICATION_PORT    36
+#define CFG_PARAM_REPLICATION_PRIMARY 37
+#define CFG_PARAM_REPLICATION_TIMEOUT 38
+
+/** The maximum number of command handler threads. */
+#define CFG_MAX_COMMAND_HANDLERS 16
+/** The default number of BGPSec path validation workers. */
+#define CFG_DEFAULT_BGPSEC_WORKERS 2
+/** The maximum number of BGPSec path validation workers. */
+#define CFG_MAX_BGPSEC_WORKERS 16
+/** The default number of memorized signature verifications. */
+#define CFG_DEFAULT_BGPSEC_MEMO 65536
+/** The maximum number of event loop (reactor) threads. */
+#define CFG_MAX_EVENT_LOOP_THREADS 16
+/** The maximum number of receiver queue threads. */
+#define CFG_MAX_RECEIVER_THREADS 16
+/** The default time in microseconds a batch of a slow proxy may wait. */
+#define CFG_DEFAULT_SEND_BATCH_DELAY 200
+/** The maximum time in microseconds a batch of a slow proxy may wait. */
+#define CFG_MAX_SEND_BATCH_DELAY 100000
+/** The default number of bytes that completes the batch of a slow proxy. */
+#define CFG_DEFAULT_SEND_BATCH_BYTES 65536
+/** The maximum number of bytes that completes the batch of a slow proxy. */
+#define CFG_MAX_SEND_BATCH_BYTES (16 * 1024 * 1024)
+/** The default time in milliseconds the garbage collector spends per second.*/
+#define CFG_DEFAULT_GC_BUDGET 5
+/** The maximum time in milliseconds the garbage collector spends per second.*/
+#define CFG_MAX_GC_BUDGET 1000
+/** The default time in seconds between two cache snapshots. */
+#define CFG_DEFAULT_SNAPSHOT_INTERVAL 300
+/** The default maximum number of ROAs in the shared ROA table. */
+#define CFG_DEFAULT_SHARED_ROA_CAPACITY 1048576
+/** The default time in seconds between two shared ROA table refreshes. */
+#define CFG_DEFAULT_SHARED_ROA_INTERVAL 1
+/** The default time in seconds after which the replication stream is lost. */
+#define CFG_DEFAULT_REPLICATION_TIMEOUT 3
+
 #define HDR "([0x%08X] Configuration): "
 
 #ifndef SYSCONFDIR
@@ -107,6 +203,11 @@
 
 // Forward declaration
 static char* _duplicateString(char* src, char** dest, const char* err);
+static bool _addRpkiCache(Configuration* self, char* cache);
+static bool _setReplicationPrimary(Configuration* self, char* primary);
+static bool _setThreadCPUs(Configuration* self, const char* className,
+                           const char* cpus);
+static bool _setSharedROAMode(Configuration* self, const char* mode);
 
 /** Supported short options */
 static const char* _SHORT_OPTIONS = "hf:v:::sl:CkpcP::::::";
@@ -131,6 +232,17 @@ static const struct option _LONG_OPTIONS[] = {
 
   { "proxy-clients", required_argument, NULL, 'C'},
   { "keep-window", required_argument, NULL, 'k'},
+  { "command-handlers", required_argument, NULL, CFG_PARAM_COMMAND_HANDLERS},
+  { "expected-updates", required_argument, NULL, CFG_PARAM_EXPECTED_UPDATES},
+  { "expected-prefixes", required_argument, NULL, CFG_PARAM_EXPECTED_PREFIXES},
+  { "expected-roas", required_argument, NULL, CFG_PARAM_EXPECTED_ROAS},
+  { "event-loop-threads", required_argument, NULL, CFG_PARAM_EVENT_LOOP},
+  { "receiver-threads", required_argument, NULL, CFG_PARAM_RECEIVER_THREADS},
+  { "send-batch-delay", required_argument, NULL, CFG_PARAM_SEND_BATCH_DELAY},
+  { "send-batch-bytes", required_argument, NULL, CFG_PARAM_SEND_BATCH_BYTES},
+  { "shm-transport", no_argument, NULL, CFG_PARAM_SHM_TRANSPORT},
+  { "gc-budget",    required_argument, NULL, CFG_PARAM_GC_BUDGET},
+  { "thread-cpus",  required_argument, NULL, CFG_PARAM_THREAD_CPUS},
 
   { "port",             required_argument, NULL, 'p'},
   { "console.port",     required_argument, NULL, 'c'},
@@ -138,12 +250,41 @@ static const struct option _LONG_OPTIONS[] = {
 
   { "rpki.host",    required_argument, NULL, CFG_PARAM_RPKI_HOST},
   { "rpki.port",    required_argument, NULL, CFG_PARAM_RPKI_PORT},
+  { "rpki.cache",   required_argument, NULL, CFG_PARAM_RPKI_CACHE},
 
   { "bgpsec.host",  required_argument, NULL, CFG_PARAM_BGPSEC_HOST},
   { "bgpsec.port",  required_argument, NULL, CFG_PARAM_BGPSEC_PORT},
+  { "bgpsec.workers", required_argument, NULL, CFG_PARAM_BGPSEC_WORKERS},
+  { "bgpsec.memo",  required_argument, NULL, CFG_PARAM_BGPSEC_MEMO},
+  { "bgpsec.key",   required_argument, NULL, CFG_PARAM_BGPSEC_KEY},
+
+  { "snapshot.file",     required_argument, NULL, CFG_PARAM_SNAPSHOT_FILE},
+  { "snapshot.interval", required_argument, NULL, CFG_PARAM_SNAPSHOT_INTERVAL},
+
+  { "metrics.port", required_argument, NULL, CFG_PARAM_METRICS_PORT},
+
+  { "replication.port",    required_argument, NULL,
+                           CFG_PARAM_REPLICATION_PORT},
+  { "replication.primary", required_argument, NULL,
+                           CFG_PARAM_REPLICATION_PRIMARY},
+  { "replication.timeout", required_argument, NULL,
+                           CFG_PARAM_REPLICATION_TIMEOUT},
+
+  { "shared-roa.name",     required_argument, NULL,
+                           CFG_PARAM_SHARED_ROA_NAME},
+  { "shared-roa.mode",     required_argument, NULL,
+                           CFG_PARAM_SHARED_ROA_MODE},
+  { "shared-roa.capacity", required_argument, NULL,
+                           CFG_PARAM_SHARED_ROA_CAPACITY},
+  { "shared-roa.interval", required_argument, NULL,
+                           CFG_PARAM_SHARED_ROA_INTERVAL},
 
   { "mode.no-sendqueue", no_argument, NULL, CFG_PARAM_MODE_NO_SEND_QUEUE},
   { "mode.no-receivequeue", no_argument, NULL, CFG_PARAM_MODE_NO_RCV_QUEUE},
+  { "mode.lazy-validation", no_argument, NULL,
+                            CFG_PARAM_MODE_LAZY_VALIDATION},
+  { "mode.provisional-sync", no_argument, NULL,
+                             CFG_PARAM_MODE_PROVISIONAL_SYNC},
 
   { NULL, 0, NULL, 0}
 };
@@ -168,19 +309,81 @@ static const char* _USAGE_TEXT =
   "                               proxy connection is established!\n"
   "  -k  --keep-window <sec>      The default keepWindow in seconds. Zero\n"
   "                               deactivates this feature\n"
+  "      --command-handlers <no>  Number of command handler threads (1-16)\n"
+  "      --expected-updates <no>  Expected number of updates, used to size\n"
+  "                               the update cache memory pools and table\n"
+  "      --expected-prefixes <no> Expected number of prefixes, used to size\n"
+  "                               the prefix cache memory pools\n"
+  "      --expected-roas <no>     Expected number of ROA white-list entries,\n"
+  "                               used to size the prefix cache ROA index\n"
+  "      --event-loop-threads <no> Serve all proxy connections from <no>\n"
+  "                               epoll reactor threads (0-16). Zero uses\n"
+  "                               one thread per connection (default)\n"
+  "      --receiver-threads <no>  Number of receiver queue threads (1-16),\n"
+  "                               the packets of a proxy keep their order\n"
+  "      --send-batch-delay <us>  Time in microseconds the results for a\n"
+  "                               proxy that does not keep up are batched\n"
+  "                               (def.: 200, 0 = no batching)\n"
+  "      --send-batch-bytes <no>  Number of bytes that completes a batch\n"
+  "                               (def.: 65536)\n"
+  "      --shm-transport          Serve proxies on this host via shared\n"
+  "                               memory rings instead of TCP. Requires\n"
+  "                               one thread per connection\n"
+  "      --gc-budget <ms>         Time in milliseconds the garbage collector\n"
+  "                               may spend per second (def.: 5)\n"
+  "      --thread-cpus <cls=cpus> Pin the threads of a class to the CPUs,\n"
+  "                               e.g. bgpsec=2-5,8. Classes: command,\n"
+  "                               receiver, sender, network, rpki, bgpsec,\n"
+  "                               housekeeping. Can be repeated\n"
   "  -p, --port <no>              Use a different listening port (def.: 17900)\n"
   "  -c, --console.port <no>      Use a different console port (def.: 17901)\n"
   "  -P, --console.password <pwd> Password for remote shutdown\n"
   "      --rpki.host <name>       RPKI/Router protocol server host name\n"
   "      --rpki.port <no>         RPKI/Router protocol server port number\n"
+  "      --rpki.cache <name:no>   Additional RPKI/Router protocol server, can\n"
+  "                               be repeated. All servers are used in\n"
+  "                               parallel\n"
   "      --bgpsec.host <name>     BGPSec/Router protocol server host name\n"
-  "      --bgpsec.port <no>       BGPSec/Router protocol server port number\n\n"
+  "      --bgpsec.port <no>       BGPSec/Router protocol server port number\n"
+  "      --bgpsec.workers <no>    Number of BGPSec path validation threads\n"
+  "                               (1-16, def.: 2)\n"
+  "      --bgpsec.memo <no>       Number of signature verifications\n"
+  "                               memorized (0 = off, def.: 65536)\n"
+  "      --bgpsec.key <file>      Private key (PEM) used to sign updates\n"
+  "      --snapshot.file <file>   Write cache snapshots into this file and\n"
+  "                               restore the caches from it on startup\n"
+  "      --snapshot.interval <sec> Time between two snapshots (def.: 300)\n"
+  "      --metrics.port <no>      Serve the metrics in Prometheus text format\n"
+  "                               via HTTP on this port (def.: 0 = off)\n"
+  "      --replication.port <no>  Replicate the caches to a standby server\n"
+  "                               connecting to this port (def.: 0 = off)\n"
+  "      --replication.primary <name:no> Run as standby of this primary\n"
+  "                               server and take over once it is lost\n"
+  "      --replication.timeout <sec> Time without data after which the\n"
+  "                               primary is considered lost (def.: 3)\n"
+  "      --shared-roa.name <name> Share the ROA white-list with other SRx\n"
+  "                               servers on this host via the shared\n"
+  "                               memory object of this name\n"
+  "      --shared-roa.mode <mode> publish: Publish the own ROA white-list\n"
+  "                               (def.), attach: Validate using the ROAs of\n"
+  "                               the publishing server\n"
+  "      --shared-roa.capacity <no> Maximum number of shared ROAs\n"
+  "                               (def.: 1048576)\n"
+  "      --shared-roa.interval <sec> Time between two publications or\n"
+  "                               refreshes (def.: 1)\n\n"
   " Experimental Options:\n=====================\n"
   "      --mode.no-sendqueue      Disable send queue for immediate results.\n"
   "                               This is experimental.\n"
   "      --mode.no-receivequeue   Disable the receive queue. This queue allows"
   "\n                               to push the processing of packets into\n"
   "                                its own thread. This is experimental.\n"
+  "      --mode.lazy-validation   Validate new updates during idle time\n"
+  "                               unless the router has no usable default\n"
+  "                               result. This is experimental.\n"
+  "      --mode.provisional-sync  Serve the proxies before the first\n"
+  "                               validation cache is synchronized. The\n"
+  "                               origin validation waits for the sync, the\n"
+  "                               router keeps its default result meanwhile.\n"
 ;
 
 /**
@@ -210,6 +413,9 @@ void initConfiguration(Configuration* self)
 
   self->rpki_host = NULL;
   self->rpki_port = -1;
+  memset(self->extraRpkiHosts, 0, sizeof(self->extraRpkiHosts));
+  memset(self->extraRpkiPorts, 0, sizeof(self->extraRpkiPorts));
+  self->noExtraRpki = 0;
 
   self->bgpsec_host = NULL;
   self->bgpsec_port = -1;
@@ -217,8 +423,35 @@ void initConfiguration(Configuration* self)
 
   self->mode_no_sendqueue = false;
   self->mode_no_receivequeue = false;
+  self->mode_lazy_validation = false;
+  self->mode_provisional_sync = false;
 
   self->defaultKeepWindow = SRX_DEFAULT_KEEP_WINDOW; // from srx_defs.h
+  self->commandHandlerThreads = 1;
+  self->expectedUpdates       = 0;
+  self->expectedPrefixes      = 0;
+  self->expectedROAs          = 0;
+  self->eventLoopThreads      = 0;
+  self->receiverThreads       = 1;
+  self->sendBatchDelay        = CFG_DEFAULT_SEND_BATCH_DELAY;
+  self->sendBatchBytes        = CFG_DEFAULT_SEND_BATCH_BYTES;
+  self->shmTransport          = false;
+  self->gcTimeBudget          = CFG_DEFAULT_GC_BUDGET;
+  self->snapshotFile          = NULL;
+  self->snapshotInterval      = CFG_DEFAULT_SNAPSHOT_INTERVAL;
+  self->metrics_port          = 0;
+  self->replication_port      = 0;
+  self->replicationPrimaryHost = NULL;
+  self->replicationPrimaryPort = 0;
+  self->replicationTimeout    = CFG_DEFAULT_REPLICATION_TIMEOUT;
+  self->bgpsecWorkers         = CFG_DEFAULT_BGPSEC_WORKERS;
+  self->bgpsecMemoSize        = CFG_DEFAULT_BGPSEC_MEMO;
+  self->bgpsecKeyFile         = NULL;
+  memset(self->threadCPUs, 0, sizeof(self->threadCPUs));
+  self->sharedROAName         = NULL;
+  self->sharedROAAttach       = false;
+  self->sharedROACapacity     = CFG_DEFAULT_SHARED_ROA_CAPACITY;
+  self->sharedROAInterval     = CFG_DEFAULT_SHARED_ROA_INTERVAL;
   memset(&self->mapping_routerID, 0, MAX_PROXY_MAPPINGS);
 }
 
@@ -229,6 +462,8 @@ void initConfiguration(Configuration* self)
  */
 void releaseConfiguration(Configuration* self)
 {
+  int idx;
+
   LOG(LEVEL_DEBUG, HDR "Release configuration object", pthread_self());
   if (self != NULL)
   {
@@ -244,10 +479,41 @@ void releaseConfiguration(Configuration* self)
     {
       free(self->rpki_host);
     }
+    while (self->noExtraRpki > 0)
+    {
+      self->noExtraRpki--;
+      free(self->extraRpkiHosts[self->noExtraRpki]);
+      self->extraRpkiHosts[self->noExtraRpki] = NULL;
+    }
     if (self->bgpsec_host != NULL)
     {
       free(self->bgpsec_host);
     }
+    if (self->snapshotFile != NULL)
+    {
+      free(self->snapshotFile);
+    }
+    if (self->replicationPrimaryHost != NULL)
+    {
+      free(self->replicationPrimaryHost);
+      self->replicationPrimaryHost = NULL;
+    }
+    if (self->bgpsecKeyFile != NULL)
+    {
+      free(self->bgpsecKeyFile);
+    }
+    for (idx = 0; idx < NUM_THREAD_CLASSES; idx++)
+    {
+      if (self->threadCPUs[idx] != NULL)
+      {
+        free(self->threadCPUs[idx]);
+        self->threadCPUs[idx] = NULL;
+      }
+    }
+    if (self->sharedROAName != NULL)
+    {
+      free(self->sharedROAName);
+    }
   }
   LOG(LEVEL_DEBUG, HDR "Configuration objects released", pthread_self());
 }
@@ -301,6 +567,164 @@ static char* _duplicateString(char* src, char** dest, const char* err)
   return resultStr;
 }
 
+/**
+ * Add an additional validation cache given as "host:port".
+ *
+ * @param self The configuration instance.
+ * @param cache The host name and port number separated by the last colon.
+ *
+ * @return true if the cache could be added.
+ *
+ * @since 0.4.1.0
+ */
+static bool _addRpkiCache(Configuration* self, char* cache)
+{
+  char* sep = strrchr(cache, ':');
+  char* host;
+  int   port;
+
+  if (self->noExtraRpki == CFG_MAX_RPKI_CACHES - 1)
+  {
+    RAISE_ERROR("No more than %d validation caches can be configured!",
+                CFG_MAX_RPKI_CACHES);
+    return false;
+  }
+  if ((sep == NULL) || (sep == cache))
+  {
+    RAISE_ERROR("Invalid validation cache '%s', expected <host>:<port>!",
+                cache);
+    return false;
+  }
+  port = strtol(sep + 1, NULL, 10);
+  if (port <= 0)
+  {
+    RAISE_ERROR("Invalid validation cache port ('%s')", cache);
+    return false;
+  }
+
+  *sep = '\0';
+  host = _duplicateString(cache, NULL, "Validation cache host name");
+  *sep = ':';
+  if (host == NULL)
+  {
+    return false;
+  }
+  self->extraRpkiHosts[self->noExtraRpki] = host;
+  self->extraRpkiPorts[self->noExtraRpki] = port;
+  self->noExtraRpki++;
+
+  return true;
+}
+
+/**
+ * Set the primary server given as "host:port", this server runs as its
+ * standby.
+ *
+ * @param self The configuration instance.
+ * @param primary The host name and port number separated by the last colon.
+ *
+ * @return true if the primary server could be set.
+ *
+ * @since 0.4.1.0
+ */
+static bool _setReplicationPrimary(Configuration* self, char* primary)
+{
+  char* sep = strrchr(primary, ':');
+  char* host;
+  int   port;
+
+  if ((sep == NULL) || (sep == primary))
+  {
+    RAISE_ERROR("Invalid primary server '%s', expected <host>:<port>!",
+                primary);
+    return false;
+  }
+  port = strtol(sep + 1, NULL, 10);
+  if ((port <= 0) || (port > 0xFFFF))
+  {
+    RAISE_ERROR("Invalid primary server port ('%s')", primary);
+    return false;
+  }
+
+  *sep = '\0';
+  host = _duplicateString(primary, &self->replicationPrimaryHost,
+                          "Primary server host name");
+  *sep = ':';
+  if (host == NULL)
+  {
+    return false;
+  }
+  self->replicationPrimaryPort = port;
+
+  return true;
+}
+
+/**
+ * Set the CPUs of the thread class with the given name.
+ *
+ * @param self The configuration instance.
+ * @param className The name of the thread class.
+ * @param cpus The CPU list, e.g. "0-3,8".
+ *
+ * @return true if the CPUs could be set.
+ *
+ * @since 0.4.1.0
+ */
+static bool _setThreadCPUs(Configuration* self, const char* className,
+                           const char* cpus)
+{
+  int idx;
+
+  for (idx = 0; idx < NUM_THREAD_CLASSES; idx++)
+  {
+    if (strcmp(className, getThreadClassName(idx)) == 0)
+    {
+      if (!isValidCPUList(cpus))
+      {
+        RAISE_ERROR("Invalid CPU list '%s' for the %s threads!", cpus,
+                    className);
+        return false;
+      }
+      self->threadCPUs[idx] = _duplicateString((char*)cpus,
+                                               &self->threadCPUs[idx],
+                                               "Thread CPU list");
+      return self->threadCPUs[idx] != NULL;
+    }
+  }
+  RAISE_ERROR("Unknown thread class '%s'!", className);
+
+  return false;
+}
+
+/**
+ * Set the mode the shared ROA table is used in.
+ *
+ * @param self The configuration instance.
+ * @param mode "publish" or "attach".
+ *
+ * @return true if the mode is known.
+ *
+ * @since 0.4.1.0
+ */
+static bool _setSharedROAMode(Configuration* self, const char* mode)
+{
+  if (strcmp(mode, "publish") == 0)
+  {
+    self->sharedROAAttach = false;
+  }
+  else if (strcmp(mode, "attach") == 0)
+  {
+    self->sharedROAAttach = true;
+  }
+  else
+  {
+    RAISE_ERROR("Unknown shared ROA table mode '%s'!", mode);
+    return false;
+  }
+
+  return true;
+}
+
 /**
  * Parse the given command line parameters. This function also is allowed to
  * only parse for the specification of a configuration file. This is -f/--file
@@ -380,6 +804,235 @@ int parseProgramArgs(Configuration* self, int argc, const char** argv,
         self->defaultKeepWindow = (uint16_t)strtol(optarg, NULL,
                                                    SRX_DEFAULT_KEEP_WINDOW);
         break;
+      case CFG_PARAM_COMMAND_HANDLERS:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Number of command handlers missing!");
+          return 0;
+        }
+        self->commandHandlerThreads = (uint8_t)strtol(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_EXPECTED_UPDATES:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Number of expected updates missing!");
+          return 0;
+        }
+        self->expectedUpdates = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_EXPECTED_PREFIXES:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Number of expected prefixes missing!");
+          return 0;
+        }
+        self->expectedPrefixes = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_EXPECTED_ROAS:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Number of expected ROAs missing!");
+          return 0;
+        }
+        self->expectedROAs = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_EVENT_LOOP:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Number of event loop threads missing!");
+          return 0;
+        }
+        self->eventLoopThreads = (uint8_t)strtol(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_RECEIVER_THREADS:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Number of receiver threads missing!");
+          return 0;
+        }
+        self->receiverThreads = (uint8_t)strtol(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_SEND_BATCH_DELAY:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Send batch delay missing!");
+          return 0;
+        }
+        self->sendBatchDelay = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_SEND_BATCH_BYTES:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Send batch bytes missing!");
+          return 0;
+        }
+        self->sendBatchBytes = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_SHM_TRANSPORT:
+        self->shmTransport = true;
+        break;
+      case CFG_PARAM_GC_BUDGET:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Garbage collector time budget missing!");
+          return 0;
+        }
+        self->gcTimeBudget = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_THREAD_CPUS:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Thread class and CPU list missing!");
+          return 0;
+        }
+        else
+        {
+          char* sep = strchr(optarg, '=');
+          bool  ok;
+
+          if (sep == NULL)
+          {
+            RAISE_ERROR("Invalid thread CPUs '%s', expected <class>=<cpus>!",
+                        optarg);
+            return 0;
+          }
+          *sep = '\0';
+          ok   = _setThreadCPUs(self, optarg, sep + 1);
+          *sep = '=';
+          if (!ok)
+          {
+            return 0;
+          }
+        }
+        break;
+      case CFG_PARAM_SNAPSHOT_FILE:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Snapshot filename missing!");
+          return 0;
+        }
+        self->snapshotFile = _duplicateString(optarg, &self->snapshotFile,
+                                              "Snapshot filename");
+        if (self->snapshotFile == NULL)
+        {
+          RAISE_ERROR("Snapshot file '%s' could not be set!", optarg);
+          return 0;
+        }
+        break;
+      case CFG_PARAM_SNAPSHOT_INTERVAL:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Snapshot interval missing!");
+          return 0;
+        }
+        self->snapshotInterval = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_SHARED_ROA_NAME:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Shared ROA table name missing!");
+          return 0;
+        }
+        self->sharedROAName = _duplicateString(optarg, &self->sharedROAName,
+                                               "Shared ROA table name");
+        if (self->sharedROAName == NULL)
+        {
+          RAISE_ERROR("Shared ROA table '%s' could not be set!", optarg);
+          return 0;
+        }
+        break;
+      case CFG_PARAM_SHARED_ROA_MODE:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Shared ROA table mode missing!");
+          return 0;
+        }
+        if (!_setSharedROAMode(self, optarg))
+        {
+          return 0;
+        }
+        break;
+      case CFG_PARAM_SHARED_ROA_CAPACITY:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Shared ROA table capacity missing!");
+          return 0;
+        }
+        self->sharedROACapacity = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_SHARED_ROA_INTERVAL:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Shared ROA table interval missing!");
+          return 0;
+        }
+        self->sharedROAInterval = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_METRICS_PORT:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Metrics port number missing!");
+          return 0;
+        }
+        self->metrics_port = strtol(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_REPLICATION_PORT:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Replication port number missing!");
+          return 0;
+        }
+        self->replication_port = strtol(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_REPLICATION_PRIMARY:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Primary server missing!");
+          return 0;
+        }
+        if (!_setReplicationPrimary(self, optarg))
+        {
+          return 0;
+        }
+        break;
+      case CFG_PARAM_REPLICATION_TIMEOUT:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Replication timeout missing!");
+          return 0;
+        }
+        self->replicationTimeout = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_BGPSEC_WORKERS:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Number of BGPSec workers missing!");
+          return 0;
+        }
+        self->bgpsecWorkers = (uint8_t)strtol(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_BGPSEC_MEMO:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Size of the signature memo missing!");
+          return 0;
+        }
+        self->bgpsecMemoSize = (uint32_t)strtoul(optarg, NULL, 10);
+        break;
+      case CFG_PARAM_BGPSEC_KEY:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Private key filename missing!");
+          return 0;
+        }
+        self->bgpsecKeyFile = _duplicateString(optarg, &self->bgpsecKeyFile,
+                                               "Private key filename");
+        if (self->bgpsecKeyFile == NULL)
+        {
+          RAISE_ERROR("Private key file '%s' could not be set!", optarg);
+          return 0;
+        }
+        break;
       case 'l':
         self->msgDest = MSG_DEST_FILENAME;
         if (optarg == NULL)
@@ -482,6 +1135,17 @@ int parseProgramArgs(Configuration* self, int argc, const char** argv,
           return 0;
         }
         break;
+      case CFG_PARAM_RPKI_CACHE:
+        if (optarg == NULL)
+        {
+          RAISE_ERROR("Additional validation cache missing!");
+          return 0;
+        }
+        if (!_addRpkiCache(self, optarg))
+        {
+          return 0;
+        }
+        break;
       case CFG_PARAM_BGPSEC_HOST:
         if (optarg == NULL)
         {
@@ -537,6 +1201,14 @@ int parseProgramArgs(Configuration* self, int argc, const char** argv,
         self->mode_no_receivequeue = true;
         printf("Turn off receive queue!\n");
         break;
+      case CFG_PARAM_MODE_LAZY_VALIDATION:
+        self->mode_lazy_validation = true;
+        printf("Turn on lazy validation!\n");
+        break;
+      case CFG_PARAM_MODE_PROVISIONAL_SYNC:
+        self->mode_provisional_sync = true;
+        printf("Turn on provisional results until the first sync!\n");
+        break;
       default:
         RAISE_ERROR("Usage: %s %s", argv[0], _USAGE_TEXT);
         return 0;
@@ -608,6 +1280,46 @@ bool readConfigFile(Configuration* self, const char* filename)
     (self->defaultKeepWindow = (int)intVal):
     (intVal = 0);
 
+  config_lookup_int(&cfg, "command-handlers", &intVal) == CONFIG_TRUE ?
+    (self->commandHandlerThreads = (uint8_t)intVal):
+    (intVal = 0);
+
+  config_lookup_int(&cfg, "expected-updates", &intVal) == CONFIG_TRUE ?
+    (self->expectedUpdates = (uint32_t)intVal):
+    (intVal = 0);
+
+  config_lookup_int(&cfg, "expected-prefixes", &intVal) == CONFIG_TRUE ?
+    (self->expectedPrefixes = (uint32_t)intVal):
+    (intVal = 0);
+
+  config_lookup_int(&cfg, "expected-roas", &intVal) == CONFIG_TRUE ?
+    (self->expectedROAs = (uint32_t)intVal):
+    (intVal = 0);
+
+  config_lookup_int(&cfg, "event-loop-threads", &intVal) == CONFIG_TRUE ?
+    (self->eventLoopThreads = (uint8_t)intVal):
+    (intVal = 0);
+
+  config_lookup_int(&cfg, "receiver-threads", &intVal) == CONFIG_TRUE ?
+    (self->receiverThreads = (uint8_t)intVal):
+    (intVal = 0);
+
+  config_lookup_int(&cfg, "send-batch-delay", &intVal) == CONFIG_TRUE ?
+    (self->sendBatchDelay = (uint32_t)intVal):
+    (intVal = 0);
+
+  config_lookup_int(&cfg, "send-batch-bytes", &intVal) == CONFIG_TRUE ?
+    (self->sendBatchBytes = (uint32_t)intVal):
+    (intVal = 0);
+
+  config_lookup_bool(&cfg, "shm-transport", (int*)&boolVal) == CONFIG_TRUE ?
+    (self->shmTransport = (bool)boolVal):
+    (boolVal = 0);
+
+  config_lookup_int(&cfg, "gc-budget", &intVal) == CONFIG_TRUE ?
+    (self->gcTimeBudget = (uint32_t)intVal):
+    (intVal = 0);
+
   // Global - message destination
   config_lookup_bool(&cfg, "syslog", (int*)&boolVal) == CONFIG_TRUE ?
     (useSyslog = (bool)boolVal):
@@ -684,6 +1396,32 @@ bool readConfigFile(Configuration* self, const char* filename)
       (intVal = 0);
   }
 
+  // Additional RPKI caches, only if none are given on the command line.
+  sett = config_lookup(&cfg, "rpki.caches");
+  if ((sett != NULL) && (self->noExtraRpki == 0))
+  {
+    config_setting_t* cacheSett;
+    char              buff[256];
+    int               idx;
+
+    for (idx = 0; idx < config_setting_length(sett); idx++)
+    {
+      cacheSett = config_setting_get_elem(sett, idx);
+      if (   !config_setting_lookup_string(cacheSett, "host", &strtmp)
+          || !config_setting_lookup_int(cacheSett, "port", &intVal))
+      {
+        RAISE_ERROR("Additional validation cache %d requires host and port!",
+                    idx + 1);
+        goto free_config;
+      }
+      snprintf(buff, sizeof(buff), "%s:%d", strtmp, (int)intVal);
+      if (!_addRpkiCache(self, buff))
+      {
+        goto free_config;
+      }
+    }
+  }
+
   // BGPSec
   sett = config_lookup(&cfg, "bgpsec");
   if (sett != NULL)
@@ -703,6 +1441,127 @@ bool readConfigFile(Configuration* self, const char* filename)
     config_setting_lookup_int(sett, "port", &intVal) == CONFIG_TRUE ?
       (self->bgpsec_port = (int)intVal):
       (intVal = 0);
+    config_setting_lookup_int(sett, "workers", &intVal) == CONFIG_TRUE ?
+      (self->bgpsecWorkers = (uint8_t)intVal):
+      (intVal = 0);
+    config_setting_lookup_int(sett, "memo", &intVal) == CONFIG_TRUE ?
+      (self->bgpsecMemoSize = (uint32_t)intVal):
+      (intVal = 0);
+    if (config_setting_lookup_string(sett, "key", &strtmp))
+    {
+      if (self->bgpsecKeyFile == NULL)
+      {
+        self->bgpsecKeyFile = _duplicateString((char*)strtmp, 
+                                               &self->bgpsecKeyFile,
+                                               "Private key filename");
+      }
+      if (self->bgpsecKeyFile == NULL)
+      {
+        goto free_config;
+      }
+    }
+  }
+
+  // Snapshot
+  sett = config_lookup(&cfg, "snapshot");
+  if (sett != NULL)
+  {
+    if (config_setting_lookup_string(sett, "file", &strtmp))
+    {
+      if (self->snapshotFile == NULL)
+      {
+        self->snapshotFile = _duplicateString((char*)strtmp, 
+                                              &self->snapshotFile,
+                                              "Snapshot filename");
+      }
+      if (self->snapshotFile == NULL)
+      {
+        goto free_config;
+      }
+    }
+    config_setting_lookup_int(sett, "interval", &intVal) == CONFIG_TRUE ?
+      (self->snapshotInterval = (uint32_t)intVal):
+      (intVal = 0);
+  }
+
+  // Metrics
+  sett = config_lookup(&cfg, "metrics");
+  if (sett != NULL)
+  {
+    config_setting_lookup_int(sett, "port", &intVal) == CONFIG_TRUE ?
+      (self->metrics_port = (int)intVal):
+      (intVal = 0);
+  }
+
+  // Replication
+  sett = config_lookup(&cfg, "replication");
+  if (sett != NULL)
+  {
+    config_setting_lookup_int(sett, "port", &intVal) == CONFIG_TRUE ?
+      (self->replication_port = (int)intVal):
+      (intVal = 0);
+    if (   config_setting_lookup_string(sett, "primary", &strtmp)
+        && (self->replicationPrimaryHost == NULL))
+    {
+      char buff[256];
+
+      snprintf(buff, sizeof(buff), "%s", strtmp);
+      if (!_setReplicationPrimary(self, buff))
+      {
+        goto free_config;
+      }
+    }
+    config_setting_lookup_int(sett, "timeout", &intVal) == CONFIG_TRUE ?
+      (self->replicationTimeout = (uint32_t)intVal):
+      (intVal = 0);
+  }
+
+  // Shared ROA table
+  sett = config_lookup(&cfg, "shared-roa");
+  if (sett != NULL)
+  {
+    if (config_setting_lookup_string(sett, "name", &strtmp))
+    {
+      if (self->sharedROAName == NULL)
+      {
+        self->sharedROAName = _duplicateString((char*)strtmp,
+                                               &self->sharedROAName,
+                                               "Shared ROA table name");
+      }
+      if (self->sharedROAName == NULL)
+      {
+        goto free_config;
+      }
+    }
+    if (   config_setting_lookup_string(sett, "mode", &strtmp)
+        && !_setSharedROAMode(self, strtmp))
+    {
+      goto free_config;
+    }
+    config_setting_lookup_int(sett, "capacity", &intVal) == CONFIG_TRUE ?
+      (self->sharedROACapacity = (uint32_t)intVal):
+      (intVal = 0);
+    config_setting_lookup_int(sett, "interval", &intVal) == CONFIG_TRUE ?
+      (self->sharedROAInterval = (uint32_t)intVal):
+      (intVal = 0);
+  }
+
+  // Thread placement, only the classes not given on the command line.
+  sett = config_lookup(&cfg, "threads");
+  if (sett != NULL)
+  {
+    int idx;
+
+    for (idx = 0; idx < NUM_THREAD_CLASSES; idx++)
+    {
+      if (   (self->threadCPUs[idx] == NULL)
+          && config_setting_lookup_string(sett, getThreadClassName(idx),
+                                          &strtmp)
+          && !_setThreadCPUs(self, getThreadClassName(idx), strtmp))
+      {
+        goto free_config;
+      }
+    }
   }
 
   // Experimental
@@ -716,6 +1575,14 @@ bool readConfigFile(Configuration* self, const char* filename)
     config_setting_lookup_bool(sett, "no-receivequeue", (int*)&boolVal) == CONFIG_TRUE ?
       (self->mode_no_receivequeue = (bool)boolVal):
       (boolVal = 0);
+
+    config_setting_lookup_bool(sett, "lazy-validation", (int*)&boolVal) == CONFIG_TRUE ?
+      (self->mode_lazy_validation = (bool)boolVal):
+      (boolVal = 0);
+
+    config_setting_lookup_bool(sett, "provisional-sync", (int*)&boolVal) == CONFIG_TRUE ?
+      (self->mode_provisional_sync = (bool)boolVal):
+      (boolVal = 0);
   }
 
   // mapping configuration
@@ -750,6 +1617,8 @@ bool readConfigFile(Configuration* self, const char* filename)
 
 bool isCompleteConfiguration(Configuration* self)
 {
+  int idx;
+
 #define ERROR_IF_TRUE(COND, FMT, ...) \
     if (COND) { \
       RAISE_ERROR(FMT, ## __VA_ARGS__); \
@@ -769,15 +1638,77 @@ bool isCompleteConfiguration(Configuration* self)
                 "Host name of validation cache is not set!");
   ERROR_IF_TRUE(self->rpki_port <= 0,
                 "Port number of validation cache is not set or invalid!");
+  for (idx = 0; idx < self->noExtraRpki; idx++)
+  {
+    ERROR_IF_TRUE(self->extraRpkiPorts[idx] <= 0,
+                  "Port number of validation cache '%s' is invalid!",
+                  self->extraRpkiHosts[idx]);
+  }
   ERROR_IF_TRUE(self->bgpsec_host == NULL,
                 "Host name of BGPSec certificate cache is not set!");
   ERROR_IF_TRUE(self->bgpsec_port <= 0,
                 "Port number of BGPSec certificate cache is not set or "
                 "invalid!");
+  ERROR_IF_TRUE((self->bgpsecWorkers == 0)
+                || (self->bgpsecWorkers > CFG_MAX_BGPSEC_WORKERS),
+                "The number of BGPSec workers must be between 1 and %d!",
+                CFG_MAX_BGPSEC_WORKERS);
   ERROR_IF_TRUE(self->defaultKeepWindow <= 0,
                 "The keep-window time can not be negative!");
   ERROR_IF_TRUE(self->defaultKeepWindow > 0xFFFF,
                 "The keep-window time more than 65535 seconds!");
+  ERROR_IF_TRUE((self->commandHandlerThreads == 0)
+                || (self->commandHandlerThreads > CFG_MAX_COMMAND_HANDLERS),
+                "The number of command handlers must be between 1 and %d!",
+                CFG_MAX_COMMAND_HANDLERS);
+  ERROR_IF_TRUE(self->eventLoopThreads > CFG_MAX_EVENT_LOOP_THREADS,
+                "The number of event loop threads must not exceed %d!",
+                CFG_MAX_EVENT_LOOP_THREADS);
+  ERROR_IF_TRUE((self->receiverThreads == 0)
+                || (self->receiverThreads > CFG_MAX_RECEIVER_THREADS),
+                "The number of receiver threads must be between 1 and %d!",
+                CFG_MAX_RECEIVER_THREADS);
+  ERROR_IF_TRUE(self->sendBatchDelay > CFG_MAX_SEND_BATCH_DELAY,
+                "The send batch delay must not exceed %d microseconds!",
+                CFG_MAX_SEND_BATCH_DELAY);
+  ERROR_IF_TRUE((self->sendBatchBytes == 0)
+                || (self->sendBatchBytes > CFG_MAX_SEND_BATCH_BYTES),
+                "The send batch bytes must be between 1 and %d!",
+                CFG_MAX_SEND_BATCH_BYTES);
+  ERROR_IF_TRUE((self->gcTimeBudget == 0) 
+                || (self->gcTimeBudget > CFG_MAX_GC_BUDGET),
+                "The garbage collector time budget must be between 1 and "
+                "%d milliseconds!", CFG_MAX_GC_BUDGET);
+  ERROR_IF_TRUE((self->snapshotFile != NULL) && (self->snapshotInterval == 0),
+                "The snapshot interval must be at least one second!");
+  ERROR_IF_TRUE((self->metrics_port < 0) || (self->metrics_port > 0xFFFF),
+                "Invalid metrics port '%d'!", self->metrics_port);
+  ERROR_IF_TRUE((self->metrics_port != 0)
+                && (   (self->metrics_port == self->server_port)
+                    || (self->metrics_port == self->console_port)),
+                "The metrics port must differ from the server and console "
+                "port!");
+  ERROR_IF_TRUE((self->replication_port < 0)
+                || (self->replication_port > 0xFFFF),
+                "Invalid replication port '%d'!", self->replication_port);
+  ERROR_IF_TRUE((self->replication_port != 0)
+                && (   (self->replication_port == self->server_port)
+                    || (self->replication_port == self->console_port)
+                    || (self->replication_port == self->metrics_port)),
+                "The replication port must differ from the server, console, "
+                "and metrics port!");
+  ERROR_IF_TRUE(self->replicationTimeout == 0,
+                "The replication timeout must be at least one second!");
+  ERROR_IF_TRUE((self->sharedROAName != NULL)
+                && (self->sharedROAName[0] != '/'),
+                "The shared ROA table name '%s' must start with '/'!",
+                self->sharedROAName);
+  ERROR_IF_TRUE((self->sharedROAName != NULL) && !self->sharedROAAttach
+                && (self->sharedROACapacity == 0),
+                "The shared ROA table capacity must be at least one!");
+  ERROR_IF_TRUE((self->sharedROAName != NULL)
+                && (self->sharedROAInterval == 0),
+                "The shared ROA table interval must be at least one second!");
 
   return true;
 }
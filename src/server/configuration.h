@@ -20,10 +20,33 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added commandHandlerThreads to the configuration.
+ *            * Added expectedUpdates to the configuration.
+ *            * Added eventLoopThreads to the configuration.
+ *            * Added gcTimeBudget to the configuration.
+ *            * Added snapshotFile and snapshotInterval to the configuration.
+ *            * Added the additional RPKI validation caches to the 
+ *              configuration.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added metrics_port to the configuration.
+ *            * Added bgpsecWorkers to the configuration.
+ *            * Added bgpsecMemoSize to the configuration.
+ *            * Added bgpsecKeyFile to the configuration.
+ *            * Added expectedPrefixes and expectedROAs to the configuration.
+ *            * Added threadCPUs to the configuration.
+ *            * Added the shared ROA table to the configuration.
+ *            * Added shmTransport to the configuration.
+ *            * Added mode_lazy_validation to the configuration.
+ *            * Added mode_provisional_sync to the configuration.
+ *            * Added receiverThreads to the configuration.
+ *            * Added sendBatchDelay and sendBatchBytes to the configuration.
+ *            * Added the replication to a standby server to the
+ *              configuration.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  * 0.3.0    - 2014/11/17 - oborchert
@@ -44,11 +67,14 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "util/thread.h"
 
 //@TODO: Remove line below
 //static char* DEFAULT_CONSOLE_PASSWORD = "SRxSERVER";
 
 #define MAX_PROXY_MAPPINGS 256 
+/** The maximum number of RPKI validation caches, including rpki_host. */
+#define CFG_MAX_RPKI_CACHES 8
 
 /**
  * Destination for messages (errors, information).
@@ -94,12 +120,25 @@ typedef struct {
   char*                 rpki_host;    
   /** Port number of the RPKI/Router protocol server */
   int                   rpki_port;    
+  /** Host names of additional RPKI/Router protocol servers. The sessions to 
+   * all servers run in parallel. */
+  char*                 extraRpkiHosts[CFG_MAX_RPKI_CACHES - 1];
+  /** Port numbers of the additional RPKI/Router protocol servers. */
+  int                   extraRpkiPorts[CFG_MAX_RPKI_CACHES - 1];
+  /** The number of additional RPKI/Router protocol servers (default: 0). */
+  uint8_t               noExtraRpki;
  
   // BGPSec
   /** Host name of the BGPSec protocol server */
   char*                 bgpsec_host;  
   /** Port number of the BGPSec protocol server */
   int                   bgpsec_port;  
+  /** The number of BGPSec path validation worker threads (default: 2). */
+  uint8_t               bgpsecWorkers;
+  /** The number of signature verifications memorized (0 = disabled). */
+  uint32_t              bgpsecMemoSize;
+  /** The private key file used to sign updates, NULL if not signing. */
+  char*                 bgpsecKeyFile;
   /** The minimum expected number of expected proxy clients */
   uint8_t               expectedProxies;
   // Experimental configurations
@@ -107,9 +146,76 @@ typedef struct {
   bool                  mode_no_sendqueue;
   /** If set true, disable the receiver queue. */
   bool                  mode_no_receivequeue;
+  /** If set true, validate new updates during idle time. */
+  bool                  mode_lazy_validation;
+  /** If set true, serve the proxies before the first validation cache is
+   * synchronized, the origin validation waits for the synchronization. */
+  bool                  mode_provisional_sync;
   
   /** The configured default keep window. Zero = deactivate.*/
   int                   defaultKeepWindow;
+  /** The number of command handler threads (default: 1). Commands are 
+   * distributed by their update ID. */
+  uint8_t               commandHandlerThreads;
+  /** The expected number of updates, used as sizing hint for the update cache
+   * (default: 0 = no hint). */
+  uint32_t              expectedUpdates;
+  /** The expected number of prefixes, used as sizing hint for the prefix 
+   * cache (default: 0 = no hint). */
+  uint32_t              expectedPrefixes;
+  /** The expected number of ROA white-list entries, used as sizing hint for 
+   * the prefix cache (default: 0 = no hint). */
+  uint32_t              expectedROAs;
+  /** The number of epoll reactor threads serving the proxy connections 
+   * (default: 0 = one thread per connection). */
+  uint8_t               eventLoopThreads;
+  /** The number of receiver queue threads (default: 1). The packets are
+   * distributed by their proxy connection. */
+  uint8_t               receiverThreads;
+  /** The time in microseconds the results for a proxy that does not keep up
+   * are batched (default: 200, 0 = no batching). */
+  uint32_t              sendBatchDelay;
+  /** The number of bytes that completes the batch of a proxy that does not
+   * keep up (default: 65536). */
+  uint32_t              sendBatchBytes;
+  /** Serve proxies on the same host via the shared memory transport, only
+   * without event loop threads (default: false). */
+  bool                  shmTransport;
+  /** The time in milliseconds the garbage collector of the update cache may
+   * spend per second (default: 5). */
+  uint32_t              gcTimeBudget;
+  /** The file the cache snapshots are written into and restored from on 
+   * startup (default: NULL = no snapshots). */
+  char*                 snapshotFile;
+  /** The time in seconds between two cache snapshots (default: 300). */
+  uint32_t              snapshotInterval;
+  /** Port the metrics are served on (default: 0 = no metrics) */
+  int                   metrics_port;
+  /** Port a standby server connects to for the replication of the caches
+   * (default: 0 = no replication) */
+  int                   replication_port;
+  /** The host name of the primary server, this server runs as its standby
+   * until the primary is lost (default: NULL = no standby) */
+  char*                 replicationPrimaryHost;
+  /** The replication port of the primary server. */
+  int                   replicationPrimaryPort;
+  /** The time in seconds without data after which the replication stream is
+   * considered lost (default: 3). */
+  uint32_t              replicationTimeout;
+  /** The CPU list of each thread class, e.g. "0-3,8" (default: NULL = not
+   * pinned). */
+  char*                 threadCPUs[NUM_THREAD_CLASSES];
+  /** The name of the shared memory ROA table (default: NULL = not shared). */
+  char*                 sharedROAName;
+  /** Attach to the shared ROA table of another SRx server instead of
+   * publishing the own ROA white-list into it (default: false). */
+  bool                  sharedROAAttach;
+  /** The maximum number of ROAs in the shared ROA table
+   * (default: 1048576). */
+  uint32_t              sharedROACapacity;
+  /** The time in seconds between two publications or refreshes of the
+   * shared ROA table (default: 1). */
+  uint32_t              sharedROAInterval;
   /** the configuration array for the proxy mapping */
   uint32_t              mapping_routerID[256];
 } Configuration;
@@ -24,8 +24,25 @@
  *
  * Changelog:
  * -----------------------------------------------------------------------------
- * 0.4.1.0  - 2016/10/26 - oborchert
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Use getNumberOfUpdates instead of the removed update list.
+ *            * Walk the AS and ROA arrays of the prefix cache.
+ *            * rpki-reset sends the reset query to all validation caches,
+ *              show-srxconfig lists the additional validation caches.
+ *            * Added show-rpki memory.
+ *            * Find updates that share the record of another update.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added command stats.
+ *            * dump-pcache and dump-ucache write JSON lines into the given 
+ *              file or standard out without locking the complete cache.
+ *            * show-srxconfig lists mode.lazy-validation.
+ *            * Added command trace.
+ *            * Added command locks.
+ *            * Added command memory.
+ *            * show-srxconfig lists mode.provisional-sync.
+ *          - 2016/10/26 - oborchert
  *            * BZ1037: Replaces legacy calls to bzero with memset
+ *            * The console thread is placed and named by createThread.
  * 0.3.0.10 - 2016/01/21 - kyehwanl
  *            * added pthread cancel function for enabling keyboard interrupt
  * 0.3.0.10 - 2015/11/10 - oborchert
@@ -60,6 +77,7 @@
  */
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 
@@ -68,8 +86,11 @@
 #include "server/prefix_cache.h"
 #include "server/srx_server.h"
 #include "server/srx_packet_sender.h"
+#include "server/stage_stats.h"
 #include "server/update_cache.h"
 #include "shared/srx_defs.h"
+#include "util/lock_stats.h"
+#include "util/mem_stats.h"
 
 // Needed for the reset command to allow sending resets to the rpki validation
 // caches
@@ -82,6 +103,7 @@
 #include "util/server_socket.h"
 #include "util/prefix.h"
 #include "util/slist.h"
+#include "util/thread.h"
 
 #define MIN_CONSOLE_BUFFER 1024
 #define MAX_ROAS_TO_DIPLAY 20
@@ -128,6 +150,10 @@ static void doNumPrefixes(SRXConsole* self, char* cmd, char* param);
 static void doNumProxies(SRXConsole* self, char* cmd, char* param);
 
 static void doCommandQueue(SRXConsole* self, char* cmd, char* param);
+static void doStats(SRXConsole* self, char* cmd, char* param);
+static void doTrace(SRXConsole* self, char* cmd, char* param);
+static void doLocks(SRXConsole* self, char* cmd, char* param);
+static void doMemory(SRXConsole* self, char* cmd, char* param);
 static void doDumpPCache(SRXConsole* self, char* cmd, char* param);
 static void doDumpUCache(SRXConsole* self, char* cmd, char* param);
 
@@ -164,9 +190,11 @@ char* CON_HELP_RESP= "\r\nAvailable commands are:\r\n"
 #ifdef SRX_ALL
                  " show-rpki <cmd>       Display rpki data according to\r\n"
                  "                       the command string.\r\n"
-                 "      cmd:= (as|prefix|count [(as|prefix)])\r\n"
+                 "      cmd:= (as|prefix|memory|count [(as|prefix)])\r\n"
                  "             as, prefix: Show the rpki-rtr data that match"
                                            " the given input\r\n"
+                 "             memory    : memory used by the rpki-rtr"
+                                           " data\r\n"
                  "             count     : total number of rpki-rtr data"
                                            " records!\r\n"
                  "             count (as|prefix): total number of rpki-rtr\r\n"
@@ -199,17 +227,24 @@ char* CON_HELP_RESP= "\r\nAvailable commands are:\r\n"
                                              "attached\r\n"
                  " command-queue         Displays the content of the "
                                              "command queue.\r\n"
-#ifdef SRX_ALL
-                 " dump-pcache <file>    Dump the prefix cache into a file with"
-                 "\r\n                       the given name.\r\n"
-                 " dump-ucache <file>    Dump the update cache into a file with"
-                 "\r\n                       the given name.\r\n"
-#else
-                 " dump-pcache           Dump the prefix cache to command line"
-                 "\r\n                       of SRx!\r\n"
-                 " dump-ucache           Dump the update cache to command line"
-                 "\r\n                       of SRx!\r\n"
-#endif
+                 " stats [reset]         Display the latency of the processing"
+                 "\r\n                       stages and the queue depths, or"
+                 "\r\n                       reset them.\r\n"
+                 " trace [<n>]           Display the stage times of the traced"
+                 "\r\n                       updates or trace one of <n>"
+                 "\r\n                       updates (0 = off).\r\n"
+                 " locks [reset]         Display the contention of the named"
+                 "\r\n                       locks or reset it (requires"
+                 "\r\n                       --enable-lock-stats).\r\n"
+                 " memory [reset]        Display the memory allocated by each"
+                 "\r\n                       subsystem or reset the high-water"
+                 "\r\n                       marks.\r\n"
+                 " dump-pcache [<file>]  Dump the prefix cache as JSON lines"
+                 "\r\n                       into the file or to command line"
+                 "\r\n                       of SRx ('-').\r\n"
+                 " dump-ucache [<file>]  Dump the update cache as JSON lines"
+                 "\r\n                       into the file or to command line"
+                 "\r\n                       of SRx ('-').\r\n"
                  " !! [<parameter>]      Repeat last command with optional new"
                  "\r\n                       parameter if specified, otherwise"
                  "\r\n                       old parameter!"
@@ -244,6 +279,10 @@ char* CON_NOPREFIX_CMD = "num-prefixes";
 char* CON_NOPROXY_CMD  = "num-proxies";
 
 char* CON_COMMAND_QUEUE   = "command-queue";
+char* CON_STATS_CMD       = "stats";
+char* CON_TRACE_CMD       = "trace";
+char* CON_LOCKS_CMD       = "locks";
+char* CON_MEMORY_CMD      = "memory";
 char* CON_DUMP_PCACHE_CMD = "dump-pcache";
 char* CON_DUMP_UCACHE_CMD = "dump-ucache";
 
@@ -360,7 +399,8 @@ bool createConsole(SRXConsole* self, int port, ShutDownMethod shutDown,
     return false;
   }
 
-  ret = pthread_create(&self->consoleThread, NULL, consoleLoop, (void*)self);
+  ret = createThread(&self->consoleThread, NULL, THREAD_CLASS_HOUSEKEEPING,
+                     "srx-console", consoleLoop, (void*)self);
   if (ret > 0)
   {
     RAISE_ERROR("Failed to create the console Thread!");
@@ -793,6 +833,30 @@ static bool doProcessCommand(SRXConsole* self)
   {
     doCommandQueue(self, cmd, param);
   }
+  // latency and queue depth statistics
+  else if (    (cmdLen == strlen(CON_STATS_CMD))
+            && (strncmp(CON_STATS_CMD, cmd, cmdLen)==0))
+  {
+    doStats(self, cmd, param);
+  }
+  // sampled per update traces
+  else if (    (cmdLen == strlen(CON_TRACE_CMD))
+            && (strncmp(CON_TRACE_CMD, cmd, cmdLen)==0))
+  {
+    doTrace(self, cmd, param);
+  }
+  // lock contention statistics
+  else if (    (cmdLen == strlen(CON_LOCKS_CMD))
+            && (strncmp(CON_LOCKS_CMD, cmd, cmdLen)==0))
+  {
+    doLocks(self, cmd, param);
+  }
+  // memory accounting
+  else if (    (cmdLen == strlen(CON_MEMORY_CMD))
+            && (strncmp(CON_MEMORY_CMD, cmd, cmdLen)==0))
+  {
+    doMemory(self, cmd, param);
+  }
   // dump the prefix cache
   else if (    (cmdLen == strlen(CON_DUMP_PCACHE_CMD))
             && (strncmp(CON_DUMP_PCACHE_CMD, cmd, cmdLen)==0))
@@ -978,7 +1042,7 @@ static void doChangeLogLevel(SRXConsole* self, char* cmd, char* param)
 }
 
 /**
- * Send a reset query to the validation cache.
+ * Send a reset query to all validation caches.
  *
  * @param self The console
  * @param cmd the rpki-clear command
@@ -992,13 +1056,15 @@ static void doValCacheReset(SRXConsole* self, char* cmd, char* param)
   {
     message = "Error: \'rpki-reset\' does not take parameters\r\n";
   }
-  else if (sendResetQuery(&self->rpkiHandler->rrclInstance))
+  else if (sendRPKIResetQueries(self->rpkiHandler) 
+           == self->rpkiHandler->noCaches)
   {
     message = "Reset query successfully send to RPKI validation cache!\r\n";
   }
   else
   {
-    message = "ERROR: Could not send reset query to RPKI validation cache!\r\n";
+    message = "ERROR: Could not send reset query to all RPKI validation "
+              "caches!\r\n";
   }
   sendToConsoleClient(self, message, true);
 }
@@ -1142,14 +1208,14 @@ static char* _showROACoverage_VALID(char* msgPtr, uint32_t updAS,
                                     uint8_t prefixLen, PC_Prefix* currentPrefix,
                                     uint16_t missingROAs, int noLines)
 {
-  SListNode* asListNode;
-  SListNode* roaListNode;
+  uint32_t asIdx;
+  uint16_t roaIdx;
 
   PC_AS*  pcAS;
   PC_ROA* pcROA;
 
   // Check each as in the current prefix.
-  FOREACH_SLIST(&currentPrefix->asn, asListNode)
+  for (asIdx = 0; asIdx < currentPrefix->asnCount; asIdx++)
   {
     if ((missingROAs * noLines) == 0)
     {
@@ -1158,12 +1224,12 @@ static char* _showROACoverage_VALID(char* msgPtr, uint32_t updAS,
     }
     else
     {
-      pcAS = (PC_AS*)asListNode->data;
+      pcAS = &currentPrefix->asn[asIdx];
       // Check if the As contains ROAs and if the ROAs cover this update
-      FOREACH_SLIST(&pcAS->roas, roaListNode)
+      for (roaIdx = 0; roaIdx < pcAS->roaCount; roaIdx++)
       {
         // Check if this ROA covers any update
-        pcROA = (PC_ROA*)roaListNode->data;
+        pcROA = &pcAS->roas[roaIdx];
         if (pcROA->update_count > 0)
         {
           // Check each roa if the max length covers the update
@@ -1215,8 +1281,8 @@ static char* _showROACoverage_VALID(char* msgPtr, uint32_t updAS,
 static char* _showROACoverage_INVALID(char* msgPtr, uint8_t prefixLen,
                                       PC_Prefix* currentPrefix, int noLines)
 {
-  SListNode* asListNode;
-  SListNode* roaListNode;
+  uint32_t asIdx;
+  uint16_t roaIdx;
 
   PC_AS*  pcAS;
   PC_ROA* pcROA;
@@ -1227,7 +1293,7 @@ static char* _showROACoverage_INVALID(char* msgPtr, uint8_t prefixLen,
     return msgPtr;
   }
   // Check each as in the current prefix.
-  FOREACH_SLIST(&currentPrefix->asn, asListNode)
+  for (asIdx = 0; asIdx < currentPrefix->asnCount; asIdx++)
   {
     // Check if more output lines are permitted.
     if (noLines == 0)
@@ -1237,16 +1303,16 @@ static char* _showROACoverage_INVALID(char* msgPtr, uint8_t prefixLen,
     }
     else
     {
-      pcAS = (PC_AS*)asListNode->data;
+      pcAS = &currentPrefix->asn[asIdx];
       // First Check if the current prefix covers any updates
       // Check if the As contains ROAs and if the ROAs cover this update
-      FOREACH_SLIST(&pcAS->roas, roaListNode)
+      for (roaIdx = 0; roaIdx < pcAS->roaCount; roaIdx++)
       {
         // Check if this ROA covers any update
-        pcROA = (PC_ROA*)roaListNode->data;
+        pcROA = &pcAS->roas[roaIdx];
         // Check each roa if the max length covers the update
         msgPtr += sprintf(msgPtr, "                   AS(%i), "
-                         "Prefix (%s/%u-%u), ROACount %i\r\n", pcROA->as,
+                         "Prefix (%s/%u-%u), ROACount %i\r\n", pcAS->asn,
                          ipOfPrefix_tToStr(currentPrefix->treeNode->prefix),
                          currentPrefix->treeNode->prefix->bitlen,
                          pcROA->max_len, pcROA->roa_count);
@@ -1294,22 +1360,30 @@ static void _showRoaCoverage(SRXConsole* self, SRxUpdateID updateID,
   memset(msg, '\0', msgLen);
   char* msgPtr = msg;
   PC_Update* pcUpdate = NULL;
+  uint32_t   idx;
+  bool       found;
 
   msgPtr += sprintf(msgPtr, " -ROA Coverage...: ");
 
   // Get the Update
   PrefixCache* pCache = self->rpkiHandler->prefixCache;
-  SListNode* node = pCache->updates.root;
+  DListNode* node;
 
-  // Not very efficient but to be changed in version 0.3
-  while ((node != NULL) && (pcUpdate == NULL))
+  // Not very efficient but to be changed in version 0.3. The update might 
+  // share the record of another update with the same prefix and origin.
+  FOREACH_DLIST(&pCache->updates, node)
   {
-    pcUpdate = (PC_Update*)node->data;
-    if (pcUpdate->updateID != updateID)
+    pcUpdate = DLIST_ENTRY(node, PC_Update, listNode);
+    found    = pcUpdate->updateID == updateID;
+    for (idx = 0; !found && (idx < pcUpdate->noSharedIDs); idx++)
     {
-      node = node->next;
-      pcUpdate = NULL;
+      found = pcUpdate->sharedIDs[idx] == updateID;
     }
+    if (found)
+    {
+      break;
+    }
+    pcUpdate = NULL;
   }
   if (pcUpdate == NULL)
   {
@@ -1556,6 +1630,44 @@ static void doShowUpdate(SRXConsole* self, char* cmd, char* param)
   }
 }
 
+/**
+ * Display the memory used by the ROA white-list of the prefix cache.
+ *
+ * @param self The console itself
+ *
+ * @since 0.4.1.0
+ */
+static void doShowRPKIMemory(SRXConsole* self)
+{
+  PC_MemoryStats stats;
+  char           out[1024];
+  char*          outPtr = out;
+  size_t         total;
+
+  getPrefixCacheMemory(self->rpkiHandler->prefixCache, &stats);
+  total = stats.treeBytes + stats.prefixBytes + stats.arrayBytes 
+          + stats.indexBytes;
+  outPtr += sprintf(outPtr, "VRPs.............: %u\r\n", stats.vrps);
+  outPtr += sprintf(outPtr, " -ROA records....: %u\r\n", stats.roas);
+  outPtr += sprintf(outPtr, " -AS records.....: %u\r\n", stats.ases);
+  outPtr += sprintf(outPtr, " -Prefixes.......: %u\r\n", stats.prefixes);
+  outPtr += sprintf(outPtr, "Tree.............: %zu bytes\r\n", 
+                    stats.treeBytes);
+  outPtr += sprintf(outPtr, "Prefixes.........: %zu bytes\r\n", 
+                    stats.prefixBytes);
+  outPtr += sprintf(outPtr, "AS/ROA arrays....: %zu bytes (pool %zu "
+                    "bytes)\r\n", stats.arrayBytes, stats.poolBytes);
+  outPtr += sprintf(outPtr, "Indexes..........: %zu bytes\r\n", 
+                    stats.indexBytes);
+  outPtr += sprintf(outPtr, "Total............: %zu bytes", total);
+  if (stats.vrps > 0)
+  {
+    outPtr += sprintf(outPtr, " (%zu bytes per VRP)", total / stats.vrps);
+  }
+  sprintf(outPtr, "\r\n");
+  sendToConsoleClient(self, out, true);
+}
+
 /** Process the show-rpki command
  *
  * @param self The console itself
@@ -1587,6 +1699,10 @@ static void doShowRPKI(SRXConsole* self, char* cmd, char* param)
       cmdNotSupportedYet(self);
     }
   }
+  else if (strcmp(param, "memory") == 0)
+  {
+    doShowRPKIMemory(self);
+  }
   else if (strcmp(param, "count") == 0)
   {
     if (strlen(param) == 0)
@@ -1600,8 +1716,8 @@ static void doShowRPKI(SRXConsole* self, char* cmd, char* param)
   }
   else
   {
-    sendToConsoleClient(self, "Error: Show what ? (as, prefix, id, count)\r\n",
-                        true);
+    sendToConsoleClient(self, "Error: Show what ? (as, prefix, id, memory, "
+                              "count)\r\n", true);
   }
 }
 
@@ -1611,10 +1727,11 @@ static void doShowSRX(SRXConsole* self, char* cmd, char* param)
 
   Configuration* cfg = self->commandHandler->sysConfig;
 
-  char  str[1024];
+  char  str[2048];
   char* strPtr = str;
+  int   idx;
   // produce a \0 terminated string
-  memset(str,'\0',1024);
+  memset(str,'\0',2048);
 
   strPtr += sprintf(strPtr, "\r\nConfiguration:\r\n==============\r\n");
   strPtr += sprintf(strPtr, "port..................: %u\r\n", cfg->server_port);
@@ -1623,6 +1740,12 @@ static void doShowSRX(SRXConsole* self, char* cmd, char* param)
                             cfg->syncAfterConnEstablished ? "true" : "false");
   strPtr += sprintf(strPtr, "rpki.host.............: %s\r\n", cfg->rpki_host);
   strPtr += sprintf(strPtr, "rpki.port.............: %u\r\n", cfg->rpki_port);
+  for (idx = 0; idx < cfg->noExtraRpki; idx++)
+  {
+    strPtr += sprintf(strPtr, "rpki.cache............: %s:%u\r\n",
+                              cfg->extraRpkiHosts[idx], 
+                              cfg->extraRpkiPorts[idx]);
+  }
   strPtr += sprintf(strPtr, "bgpsec.host...........: %s\r\n", cfg->bgpsec_host);
   strPtr += sprintf(strPtr, "bgpsec.port...........: %u\r\n", cfg->bgpsec_port);
   strPtr += sprintf(strPtr, "console.port..........: %u\r\n",cfg->console_port);
@@ -1632,6 +1755,12 @@ static void doShowSRX(SRXConsole* self, char* cmd, char* param)
   strPtr += sprintf(strPtr, "mode.no-receivequeue..: %s\r\n",
                  cfg->mode_no_receivequeue ? "true  (receive queue turned off)"
                                            : "false (receive queue turned on)");
+  strPtr += sprintf(strPtr, "mode.lazy-validation..: %s\r\n",
+                 cfg->mode_lazy_validation ? "true  (validate when idle)"
+                                           : "false (validate right away)");
+  strPtr += sprintf(strPtr, "mode.provisional-sync.: %s\r\n",
+                cfg->mode_provisional_sync ? "true  (validate after the sync)"
+                                           : "false (validate right away)");
   strPtr += sprintf(strPtr, "\r\n");
   sendToConsoleClient(self, str, true);
 }
@@ -1742,7 +1871,7 @@ static void doNumUpdates(SRXConsole* self, char* cmd, char* param)
   // produce a \0 terminated string
   memset(str,'\0',256);
 
-  elements = self->commandHandler->updCache->allItems.size;
+  elements = getNumberOfUpdates(self->commandHandler->updCache);
   sprintf(str, "Update Cache: %u updates stored.\r\n", elements);
   sendToConsoleClient(self, str, false);
   elements = self->commandHandler->rpkiHandler->prefixCache->updates.size;
@@ -1818,8 +1947,340 @@ static void doCommandQueue(SRXConsole* self, char* cmd, char* param)
 }
 
 /**
- * Dump the prefix cache into a file/console on the server side.
- * Use parameter '-' to dump it on the console of the server.
+ * Display the latency histograms of the processing stages in micro seconds
+ * and the depth histograms of the queues. The parameter "reset" sets them
+ * back to zero.
+ *
+ * @param self Pointer to the console
+ * @param cmd The command
+ * @param param the parameters (empty or "reset")
+ *
+ * @since 0.4.1.0
+ */
+static void doStats(SRXConsole* self, char* cmd, char* param)
+{
+  LOG(LEVEL_DEBUG, CP1 CP2 "%s %s", self->clientSockFd, cmd, param);
+  HistogramSnapshot snapshot;
+  char  out[2048];
+  char* outPtr = out;
+  int   idx;
+
+  if (strcmp(param, "reset") == 0)
+  {
+    resetStageStats();
+    sendToConsoleClient(self, "Statistics reset!\r\n", true);
+    return;
+  }
+  if (param[0] != '\0')
+  {
+    sendToConsoleClient(self, "Usage: stats [reset]\r\n", true);
+    return;
+  }
+
+  outPtr += sprintf(outPtr, "Stage latency (us) of the last %llu s:\r\n"
+                    "%-17s %12s %9s %9s %9s %9s %9s\r\n",
+                    (unsigned long long)getStageStatsAge(), "stage", "count",
+                    "mean", "p50", "p99", "p99.9", "max");
+  for (idx = 0; idx < NUM_STAGES; idx++)
+  {
+    getStageSnapshot(idx, &snapshot);
+    outPtr += sprintf(outPtr, "%-17s %12llu %9.1f %9.1f %9.1f %9.1f %9.1f"
+                      "\r\n", stageToStr(idx),
+                      (unsigned long long)snapshot.count,
+                      getHistogramMean(&snapshot) / 1000.0,
+                      getHistogramPercentile(&snapshot, 500) / 1000.0,
+                      getHistogramPercentile(&snapshot, 990) / 1000.0,
+                      getHistogramPercentile(&snapshot, 999) / 1000.0,
+                      snapshot.max / 1000.0);
+  }
+  outPtr += sprintf(outPtr, "\r\nQueue depth at enqueue (send queue in "
+                    "bytes):\r\n%-17s %12s %9s %9s %9s %9s %9s\r\n", 
+                    "queue", "count", "mean", "p50", "p99", "p99.9", "max");
+  for (idx = 0; idx < NUM_STATS_QUEUES; idx++)
+  {
+    getQueueDepthSnapshot(idx, &snapshot);
+    outPtr += sprintf(outPtr, "%-17s %12llu %9llu %9llu %9llu %9llu %9llu"
+                      "\r\n", statsQueueToStr(idx),
+                      (unsigned long long)snapshot.count,
+                      (unsigned long long)getHistogramMean(&snapshot),
+                      (unsigned long long)
+                        getHistogramPercentile(&snapshot, 500),
+                      (unsigned long long)
+                        getHistogramPercentile(&snapshot, 990),
+                      (unsigned long long)
+                        getHistogramPercentile(&snapshot, 999),
+                      (unsigned long long)snapshot.max);
+  }
+  sendToConsoleClient(self, out, true);
+}
+
+/**
+ * Display the traced updates, oldest first, with the time of each trace point
+ * in micro seconds after the receipt of the PDU. With a number as parameter
+ * one of that many updates is traced from now on, 0 disables tracing.
+ *
+ * @param self Pointer to the console
+ * @param cmd The command
+ * @param param the parameters (empty or the sample rate)
+ *
+ * @since 0.4.1.0
+ */
+static void doTrace(SRXConsole* self, char* cmd, char* param)
+{
+  LOG(LEVEL_DEBUG, CP1 CP2 "%s %s", self->clientSockFd, cmd, param);
+  UpdateTraceSpan* spans;
+  uint32_t noSpans;
+  uint32_t idx;
+  char     out[4096];
+  char*    outPtr = out;
+  char*    endPtr;
+  unsigned long rate;
+  int      point;
+
+  if (param[0] != '\0')
+  {
+    rate = strtoul(param, &endPtr, 10);
+    if ((*endPtr != '\0') || (rate > UINT32_MAX))
+    {
+      sendToConsoleClient(self, "Usage: trace [<n>]\r\n", true);
+      return;
+    }
+    setUpdateTraceRate((uint32_t)rate);
+    snprintf(out, sizeof(out), (rate == 0) ? "Tracing disabled!\r\n"
+                                           : "Tracing 1 of %lu updates!\r\n",
+             rate);
+    sendToConsoleClient(self, out, true);
+    return;
+  }
+
+  spans = malloc(sizeof(UpdateTraceSpan) * UPDATE_TRACE_RING_SIZE);
+  if (spans == NULL)
+  {
+    sendToConsoleClient(self, "Not enough memory!\r\n", true);
+    return;
+  }
+  noSpans = getUpdateTraces(spans, UPDATE_TRACE_RING_SIZE);
+
+  outPtr += sprintf(outPtr, "%u traced updates, 1 of %u (us):\r\n%-10s",
+                    noSpans, g_updateTraceRate, "update");
+  for (point = 1; point < NUM_TRACE_POINTS; point++)
+  {
+    outPtr += sprintf(outPtr, " %9s", tracePointToStr(point));
+  }
+  outPtr += sprintf(outPtr, "\r\n");
+
+  for (idx = 0; idx < noSpans; idx++)
+  {
+    // Flush before the buffer can not take another line.
+    if ((outPtr - out) > (sizeof(out) - 128))
+    {
+      sendToConsoleClient(self, out, false);
+      outPtr = out;
+    }
+    outPtr += sprintf(outPtr, "0x%08X", spans[idx].updateID);
+    for (point = 1; point < NUM_TRACE_POINTS; point++)
+    {
+      if (   (spans[idx].time[point] == 0)
+          || (spans[idx].time[point] < spans[idx].time[TRACE_PDU_RECEIVE]))
+      {
+        outPtr += sprintf(outPtr, " %9s", "-");
+      }
+      else
+      {
+        outPtr += sprintf(outPtr, " %9.1f",
+                          (spans[idx].time[point]
+                           - spans[idx].time[TRACE_PDU_RECEIVE]) / 1000.0);
+      }
+    }
+    outPtr += sprintf(outPtr, "\r\n");
+  }
+  free(spans);
+  sendToConsoleClient(self, out, true);
+}
+
+/**
+ * Display the contention of the named locks: the number of acquisitions, the
+ * share that had to wait, the wait time and the time the locks were held
+ * exclusively in micro seconds. The parameter "reset" sets them back to zero.
+ *
+ * @param self Pointer to the console
+ * @param cmd The command
+ * @param param the parameters (empty or "reset")
+ *
+ * @since 0.4.1.0
+ */
+static void doLocks(SRXConsole* self, char* cmd, char* param)
+{
+  LOG(LEVEL_DEBUG, CP1 CP2 "%s %s", self->clientSockFd, cmd, param);
+  LockStatsSnapshot* stats;
+  uint32_t noStats;
+  uint32_t idx;
+  char     out[LOCK_STATS_MAX_NAMES * 160 + 256];
+  char*    outPtr = out;
+
+  if (!isLockStatsEnabled())
+  {
+    sendToConsoleClient(self, "Lock statistics are not compiled in, use "
+                              "--enable-lock-stats!\r\n", true);
+    return;
+  }
+  if (strcmp(param, "reset") == 0)
+  {
+    resetLockStats();
+    sendToConsoleClient(self, "Lock statistics reset!\r\n", true);
+    return;
+  }
+  if (param[0] != '\0')
+  {
+    sendToConsoleClient(self, "Usage: locks [reset]\r\n", true);
+    return;
+  }
+
+  stats = malloc(sizeof(LockStatsSnapshot) * LOCK_STATS_MAX_NAMES);
+  if (stats == NULL)
+  {
+    sendToConsoleClient(self, "Not enough memory!\r\n", true);
+    return;
+  }
+  noStats = getLockStats(stats, LOCK_STATS_MAX_NAMES);
+
+  outPtr += sprintf(outPtr, "%-28s %5s %12s %6s %9s %9s %9s %9s %9s\r\n",
+                    "lock", "locks", "acquired", "wait%", "wait-avg",
+                    "wait-p99", "wait-max", "hold-avg", "hold-p99");
+  for (idx = 0; idx < noStats; idx++)
+  {
+    outPtr += sprintf(outPtr, "%-28s %5u %12llu %6.2f %9.1f %9.1f %9.1f "
+                      "%9.1f %9.1f\r\n", stats[idx].name, stats[idx].noLocks,
+                      (unsigned long long)stats[idx].wait.count,
+                      stats[idx].wait.count == 0 ? 0.0
+                        : 100.0 * stats[idx].contended / stats[idx].wait.count,
+                      getHistogramMean(&stats[idx].wait) / 1000.0,
+                      getHistogramPercentile(&stats[idx].wait, 990) / 1000.0,
+                      stats[idx].wait.max / 1000.0,
+                      getHistogramMean(&stats[idx].hold) / 1000.0,
+                      getHistogramPercentile(&stats[idx].hold, 990) / 1000.0);
+  }
+  free(stats);
+  sendToConsoleClient(self, out, true);
+}
+
+/**
+ * Display the bytes and objects allocated by each subsystem and the highest
+ * number of bytes since the last reset. The parameter "reset" sets the
+ * high-water marks back to the current values.
+ *
+ * @param self Pointer to the console
+ * @param cmd The command
+ * @param param the parameters (empty or "reset")
+ *
+ * @since 0.4.1.0
+ */
+static void doMemory(SRXConsole* self, char* cmd, char* param)
+{
+  LOG(LEVEL_DEBUG, CP1 CP2 "%s %s", self->clientSockFd, cmd, param);
+  MemStats stats;
+  MemStats total;
+  char     out[(NUM_MEM_TAGS + 3) * 80];
+  char*    outPtr = out;
+  int      tag;
+
+  if (strcmp(param, "reset") == 0)
+  {
+    resetMemStatsMax();
+    sendToConsoleClient(self, "High-water marks reset!\r\n", true);
+    return;
+  }
+  if (param[0] != '\0')
+  {
+    sendToConsoleClient(self, "Usage: memory [reset]\r\n", true);
+    return;
+  }
+
+  memset(&total, 0, sizeof(MemStats));
+  outPtr += sprintf(outPtr, "%-16s %14s %12s %14s\r\n", "subsystem",
+                    "bytes", "objects", "max-bytes");
+  for (tag = 0; tag < NUM_MEM_TAGS; tag++)
+  {
+    getMemStats((MemTag)tag, &stats);
+    outPtr += sprintf(outPtr, "%-16s %14lld %12lld %14lld\r\n",
+                      memTagToStr((MemTag)tag), (long long)stats.bytes,
+                      (long long)stats.objects, (long long)stats.maxBytes);
+    total.bytes   += stats.bytes;
+    total.objects += stats.objects;
+  }
+  sprintf(outPtr, "%-16s %14lld %12lld\r\n", "total", (long long)total.bytes,
+          (long long)total.objects);
+  sendToConsoleClient(self, out, true);
+}
+
+/**
+ * Open the stream a cache is dumped into. Without parameter or with '-' the
+ * standard out of the server is used, otherwise the file with the given name.
+ *
+ * @param self The console itself
+ * @param param The parameter of the dump command.
+ * @param fileName (out) The name of the output for display.
+ *
+ * @return The stream or NULL if the file could not be opened.
+ *
+ * @since 0.4.1.0
+ */
+static FILE* _openDumpStream(SRXConsole* self, char* param, char** fileName)
+{
+  FILE* stream;
+  char  str[256];
+
+  if ((strlen(param) == 0) || (param[0] == CON_STDOUT))
+  {
+    *fileName = "standard out";
+    return stdout;
+  }
+
+  *fileName = param;
+  stream = fopen(param, "w");
+  if (stream == NULL)
+  {
+    snprintf(str, sizeof(str), "Can not open file '%s'!\r\n", param);
+    sendToConsoleClient(self, str, true);
+  }
+
+  return stream;
+}
+
+/**
+ * Close the stream opened with _openDumpStream and report the result of the 
+ * dump.
+ *
+ * @param self The console itself
+ * @param stream The stream.
+ * @param fileName The name of the output for display.
+ * @param success Indicates if the dump was complete.
+ *
+ * @since 0.4.1.0
+ */
+static void _closeDumpStream(SRXConsole* self, FILE* stream, char* fileName,
+                             bool success)
+{
+  char str[256];
+
+  if (stream == stdout)
+  {
+    success = (fflush(stdout) == 0) && success;
+  }
+  else
+  {
+    success = (fclose(stream) == 0) && success;
+  }
+  snprintf(str, sizeof(str), success ? "Export into %s done.\r\n"
+                                     : "Export into %s incomplete!\r\n",
+           fileName);
+  sendToConsoleClient(self, str, true);
+}
+
+/**
+ * Dump the prefix cache as JSON lines into a file/console on the server side.
+ * Use parameter '-' to dump it on the console of the server. The prefix cache 
+ * is read in chunks without holding its lock.
  *
  * @param self The console itself
  * @param cmd The dump command
@@ -1828,32 +2289,26 @@ static void doCommandQueue(SRXConsole* self, char* cmd, char* param)
 static void doDumpPCache(SRXConsole* self, char* cmd, char* param)
 {
   LOG(LEVEL_DEBUG, CP1 CP2 "%s %s", self->clientSockFd, cmd, param);
-  int elements = 0;
-  char str[256];
-  // produce a \0 terminated string
-  memset(str,'\0',256);
-
-  char ch = (strlen(param) == 0) ? CON_STDOUT : param[0];
-  char* fileName = (ch == CON_STDOUT) ? "standard out" : param;
-  // Get the number of elements from the command queue. Here is is for display
-  // only, synchronizing is not necessary
-  elements = self->rpkiHandler->prefixCache->prefixTree->num_active_node;
-  sprintf(str, "Prefix Cache has %u items. Start export into %s!\r\n",
-          elements, fileName);
-  sendToConsoleClient(self, str, true);
+  char  str[256];
+  char* fileName;
+  FILE* out = _openDumpStream(self, param, &fileName);
 
-  FILE* out = (ch == CON_STDOUT) ? stdout : NULL;
   if (out != NULL)
   {
-    outputPrefixCacheAsXML(self->rpkiHandler->prefixCache, stdout);
+    // For display only, the counter is maintained without lock.
+    snprintf(str, sizeof(str), 
+             "Prefix Cache has %u prefixes. Start export into %s!\r\n",
+             getNumberOfPrefixes(self->rpkiHandler->prefixCache), fileName);
+    sendToConsoleClient(self, str, true);
+    _closeDumpStream(self, out, fileName,
+                     dumpPrefixCache(self->rpkiHandler->prefixCache, out));
   }
-  sprintf(str, "Export of prefix cache into %s done.!\r\n", param);
-  sendToConsoleClient(self, str, true);
 }
 
 /**
- * Dump the update cache into a file/console on the server side.
- * Use parameter '-' to dump it on the console of the server.
+ * Dump the update cache as JSON lines into a file/console on the server side.
+ * Use parameter '-' to dump it on the console of the server. Only one shard 
+ * of the update cache is locked at a time.
  *
  * @param self The console itself
  * @param cmd The dump command
@@ -1862,27 +2317,20 @@ static void doDumpPCache(SRXConsole* self, char* cmd, char* param)
 static void doDumpUCache(SRXConsole* self, char* cmd, char* param)
 {
   LOG(LEVEL_DEBUG, CP1 CP2 "%s %s", self->clientSockFd, cmd, param);
-  int elements = 0;
-  char str[256];
-  // produce a \0 terminated string
-  memset(str,'\0',256);
+  char  str[256];
+  char* fileName;
+  FILE* out = _openDumpStream(self, param, &fileName);
 
-  char ch = (strlen(param) == 0) ? CON_STDOUT : param[0];
-  char* fileName = (ch == CON_STDOUT) ? "standard out" : param;
-  // Get the number of elements from the command queue. Here is is for display
-  // only, synchronizing is not necessary
-  elements = self->commandHandler->updCache->allItems.size;
-  sprintf(str, "Update Cache has %u items. Start export into %s!\r\n",
-          elements, fileName);
-  sendToConsoleClient(self, str, true);
-
-  FILE* out = (ch == CON_STDOUT) ? stdout : NULL;
   if (out != NULL)
   {
-    outputUpdateCacheAsXML(self->commandHandler->updCache, stdout, -1);
+    // For display only, synchronizing is not necessary
+    snprintf(str, sizeof(str), 
+             "Update Cache has %u items. Start export into %s!\r\n",
+             getNumberOfUpdates(self->commandHandler->updCache), fileName);
+    sendToConsoleClient(self, str, true);
+    _closeDumpStream(self, out, fileName,
+                     dumpUpdateCache(self->commandHandler->updCache, out));
   }
-  sprintf(str, "Export of prefix cache into %s done.!\r\n", param);
-  sendToConsoleClient(self, str, true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
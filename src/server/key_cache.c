@@ -20,18 +20,263 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Added the router key store.
+ *            * Store the update cache.
+ *            * Router keys are stored in SKI indexed buckets which are read
+ *              lock-free within the epoch. Only EC keys are accepted.
+ *            * Removed the stubs getPublicKey, storePublicKey and 
+ *              deletePublicKey.
+ *            * Each stored router key gets a serial, returned by getRouterKey.
+ *            * Added the index of the updates depending on a SKI.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  * 0.1.0    - 2010/04/08
  *            * File created
  */
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/x509.h>
 #include "server/key_cache.h"
 #include "util/log.h"
 
+/** A stored router key. */
+struct _KC_RouterKey {
+  /** The next key of the bucket. */
+  KC_RouterKey* volatile next;
+  /** The AS number. */
+  uint32_t      as;
+  /** The number of times the key was stored, only used by the writer. */
+  uint32_t      refCount;
+  /** The serial of the key. */
+  uint64_t      serial;
+  /** The decoded public key. */
+  EVP_PKEY*     key;
+  /** The subject key identifier. */
+  uint8_t       ski[KC_SKI_LENGTH];
+};
+
+/** A slot of the set of dependent updates. */
+typedef struct {
+  /** The update. */
+  KC_KeyDependent dep;
+  /** true if the slot is used. */
+  bool            used;
+} KC_KeyUpdateSlot;
+
+/** The updates depending on a SKI, an open addressing set. */
+struct _KC_KeyUpdates {
+  /** The next SKI of the bucket. */
+  KC_KeyUpdates*    next;
+  /** The subject key identifier. */
+  uint8_t           ski[KC_SKI_LENGTH];
+  /** The number of used slots. */
+  uint32_t          count;
+  /** The number of slots, a power of two. */
+  uint32_t          capacity;
+  /** The slots. */
+  KC_KeyUpdateSlot* slots;
+};
+
+/**
+ * Select the bucket of the given SKI. The SKI is a SHA-1 hash, its leading
+ * bytes are distributed uniformly.
+ *
+ * @param ski The subject key identifier.
+ *
+ * @return The bucket index.
+ */
+static inline uint32_t _routerKeyBucket(const uint8_t* ski) {
+  return ((ski[0] << 8) | ski[1]) & (KC_ROUTER_KEY_BUCKETS - 1);
+}
+
+/**
+ * Find the router key in its bucket.
+ *
+ * @param self Instance
+ * @param as The AS number.
+ * @param ski The subject key identifier.
+ *
+ * @return The key or NULL.
+ */
+static KC_RouterKey* _findRouterKey(KeyCache* self, uint32_t as, 
+                                    const uint8_t* ski) {
+  KC_RouterKey* entry = self->routerKeys[_routerKeyBucket(ski)];
+
+  for (; entry != NULL; entry = entry->next) {
+    if ((entry->as == as) && (memcmp(entry->ski, ski, KC_SKI_LENGTH) == 0)) {
+      break;
+    }
+  }
+  return entry;
+}
+
+/**
+ * Release a retired router key.
+ *
+ * @param data The router key.
+ */
+static void _releaseRouterKey(void* data) {
+  KC_RouterKey* entry = (KC_RouterKey*)data;
+
+  // Validations in progress keep their own reference.
+  EVP_PKEY_free(entry->key);
+  free(entry);
+}
+
+/**
+ * Return the first slot to probe for the update. The update IDs are hashes
+ * but might be generated sequentially by tests.
+ *
+ * @param updId The update ID.
+ * @param capacity The number of slots.
+ *
+ * @return The slot index.
+ */
+static inline uint32_t _keyUpdateSlot(SRxUpdateID updId, uint32_t capacity) {
+  return (updId * 0x9E3779B1U) & (capacity - 1);
+}
+
+/**
+ * Insert the update into the set which MUST have a free slot.
+ *
+ * @param entry The set.
+ * @param dep The update.
+ *
+ * @return false if the update was in the set already, its local AS is
+ *         updated.
+ */
+static bool _insertKeyUpdate(KC_KeyUpdates* entry, KC_KeyDependent* dep) {
+  uint32_t idx = _keyUpdateSlot(dep->updateID, entry->capacity);
+
+  for (; entry->slots[idx].used; idx = (idx + 1) & (entry->capacity - 1)) {
+    if (entry->slots[idx].dep.updateID == dep->updateID) {
+      entry->slots[idx].dep.localAS = dep->localAS;
+      return false;
+    }
+  }
+  entry->slots[idx].dep  = *dep;
+  entry->slots[idx].used = true;
+  entry->count++;
+
+  return true;
+}
+
+/**
+ * Return true if the update is still stored in the update cache.
+ *
+ * @param self Instance
+ * @param updId The update ID.
+ *
+ * @return true if the update is stored.
+ */
+static bool _isUpdateStored(KeyCache* self, SRxUpdateID updId) {
+  SRxResult        result;
+  SRxDefaultResult defResult;
+
+  return getUpdateResult(self->updateCache, &updId, 0, NULL, &result,
+                         &defResult);
+}
+
+/**
+ * Rebuild the set with the given number of slots.
+ *
+ * @param self Instance
+ * @param entry The set.
+ * @param capacity The new number of slots, a power of two larger than the
+ *                 number of updates.
+ * @param prune Drop the updates no longer in the update cache.
+ *
+ * @return false if not enough memory was available, the set is unchanged.
+ */
+static bool _rebuildKeyUpdates(KeyCache* self, KC_KeyUpdates* entry,
+                               uint32_t capacity, bool prune) {
+  KC_KeyUpdateSlot* slots  = entry->slots;
+  uint32_t          oldCap = entry->capacity;
+  uint32_t          idx;
+
+  entry->slots = calloc(capacity, sizeof(KC_KeyUpdateSlot));
+  if (entry->slots == NULL) {
+    entry->slots = slots;
+    return false;
+  }
+  entry->capacity = capacity;
+  entry->count    = 0;
+  for (idx = 0; idx < oldCap; idx++) {
+    if (   slots[idx].used
+        && (!prune || _isUpdateStored(self, slots[idx].dep.updateID))) {
+      _insertKeyUpdate(entry, &slots[idx].dep);
+    }
+  }
+  free(slots);
+
+  return true;
+}
+
+/**
+ * Find the set of the SKI. The caller MUST hold the key update mutex.
+ *
+ * @param self Instance
+ * @param ski The subject key identifier.
+ *
+ * @return The set or NULL.
+ */
+static KC_KeyUpdates* _findKeyUpdates(KeyCache* self, const uint8_t* ski) {
+  KC_KeyUpdates* entry = self->keyUpdates[_routerKeyBucket(ski)];
+
+  for (; entry != NULL; entry = entry->next) {
+    if (memcmp(entry->ski, ski, KC_SKI_LENGTH) == 0) {
+      break;
+    }
+  }
+  return entry;
+}
+
+/**
+ * Report the updates depending on the SKI to the registered callback. Must
+ * be called without holding the router key mutex.
+ *
+ * @param self Instance
+ * @param ski The subject key identifier of the stored or deleted key.
+ */
+static void _reportKeyUpdates(KeyCache* self, const uint8_t* ski) {
+  KC_KeyUpdates*   entry;
+  KC_KeyDependent* deps = NULL;
+  KeyInvalidated   callback;
+  void*            user;
+  uint32_t         count = 0;
+  uint32_t         idx;
+
+  lockMutex(&self->keyUpdateMutex);
+  callback = self->invCallback;
+  user     = self->invUser;
+  entry    = callback != NULL ? _findKeyUpdates(self, ski) : NULL;
+  if ((entry != NULL) && (entry->count > 0)) {
+    deps = malloc(entry->count * sizeof(KC_KeyDependent));
+    if (deps == NULL) {
+      RAISE_SYS_ERROR("Not enough memory to revalidate the updates depending "
+                      "on a router key");
+    }
+    for (idx = 0; (deps != NULL) && (idx < entry->capacity); idx++) {
+      if (   entry->slots[idx].used
+          && _isUpdateStored(self, entry->slots[idx].dep.updateID)) {
+        deps[count++] = entry->slots[idx].dep;
+      }
+    }
+  }
+  unlockMutex(&self->keyUpdateMutex);
+
+  if (count > 0) {
+    LOG(LEVEL_DEBUG, "Router key change affects %u update(s)", count);
+    callback(user, ski, deps, count);
+  }
+  free(deps);
+}
+
 bool createKeyCache(KeyCache* self, UpdateCache* updateCache,
                     KeyInvalidated invCallback, KeyNotFound nfCallback) {
   if (updateCache == NULL) {
@@ -39,31 +284,232 @@ bool createKeyCache(KeyCache* self, UpdateCache* updateCache,
     return false;
   }
 
+  self->updateCache = updateCache;
   self->invCallback = invCallback;
+  self->invUser = NULL;
   self->notFoundCallback = nfCallback;
+  self->noRouterKeys = 0;
+  self->nextKeySerial = 1;
+
+  self->routerKeys = calloc(KC_ROUTER_KEY_BUCKETS, sizeof(KC_RouterKey*));
+  if (self->routerKeys == NULL) {
+    RAISE_SYS_ERROR("Not enough memory for the router keys");
+    return false;
+  }
+  self->keyUpdates = calloc(KC_ROUTER_KEY_BUCKETS, sizeof(KC_KeyUpdates*));
+  if (self->keyUpdates == NULL) {
+    RAISE_SYS_ERROR("Not enough memory for the updates of the router keys");
+    free((void*)self->routerKeys);
+    self->routerKeys = NULL;
+    return false;
+  }
+  if (   !initMutex(&self->routerKeyMutex)
+      || !initMutex(&self->keyUpdateMutex)) {
+    RAISE_ERROR("Could not create the router key mutex");
+    free((void*)self->routerKeys);
+    free(self->keyUpdates);
+    self->routerKeys = NULL;
+    self->keyUpdates = NULL;
+    return false;
+  }
+  initEpochDomain(&self->routerKeyEpoch);
 
   return true;
 }
 
 void releaseKeyCache(KeyCache* self) {
+  KC_RouterKey*  entry;
+  KC_KeyUpdates* updates;
+  uint32_t       idx;
+
+  if (self->routerKeys == NULL) {
+    return;
+  }
+
+  synchronizeEpoch(&self->routerKeyEpoch);
+  for (idx = 0; idx < KC_ROUTER_KEY_BUCKETS; idx++) {
+    while (self->routerKeys[idx] != NULL) {
+      entry = self->routerKeys[idx];
+      self->routerKeys[idx] = entry->next;
+      _releaseRouterKey(entry);
+    }
+    while (self->keyUpdates[idx] != NULL) {
+      updates = self->keyUpdates[idx];
+      self->keyUpdates[idx] = updates->next;
+      free(updates->slots);
+      free(updates);
+    }
+  }
+  releaseEpochDomain(&self->routerKeyEpoch);
+  free((void*)self->routerKeys);
+  free(self->keyUpdates);
+  self->routerKeys = NULL;
+  self->keyUpdates = NULL;
+  self->noRouterKeys = 0;
+  releaseMutex(&self->routerKeyMutex);
+  releaseMutex(&self->keyUpdateMutex);
+}
+
+void setKeyInvalidatedCallback(KeyCache* self, KeyInvalidated callback,
+                               void* user) {
+  lockMutex(&self->keyUpdateMutex);
+  self->invCallback = callback;
+  self->invUser     = user;
+  unlockMutex(&self->keyUpdateMutex);
 }
 
-bool getPublicKey(KeyCache* self, SRxKeyID keyId) {
-  if (self->notFoundCallback != NULL) {
-    self->notFoundCallback(keyId);
+bool addUpdateToKey(KeyCache* self, const uint8_t* ski, SRxUpdateID updId,
+                    uint32_t localAS) {
+  KC_KeyUpdates*  entry;
+  KC_KeyDependent dep = { updId, localAS };
+  uint32_t        bucket = _routerKeyBucket(ski);
+  bool            ok = true;
+
+  lockMutex(&self->keyUpdateMutex);
+  entry = _findKeyUpdates(self, ski);
+  if (entry == NULL) {
+    entry = calloc(1, sizeof(KC_KeyUpdates));
+    if (entry != NULL) {
+      entry->slots = calloc(KC_KEY_UPDATES_INIT, sizeof(KC_KeyUpdateSlot));
+      if (entry->slots == NULL) {
+        free(entry);
+        entry = NULL;
+      }
+    }
+    if (entry != NULL) {
+      memcpy(entry->ski, ski, KC_SKI_LENGTH);
+      entry->capacity = KC_KEY_UPDATES_INIT;
+      entry->next = self->keyUpdates[bucket];
+      self->keyUpdates[bucket] = entry;
+    }
   }
-  return false;
+  // The set is kept at most half full. Once full, the updates no longer
+  // stored are dropped and it grows unless that freed half of it.
+  if ((entry != NULL) && ((entry->count + 1) * 2 > entry->capacity)) {
+    if (   !_rebuildKeyUpdates(self, entry, entry->capacity, true)
+        || (   ((entry->count + 1) * 4 > entry->capacity)
+            && !_rebuildKeyUpdates(self, entry, entry->capacity * 2,
+                                   false))) {
+      entry = NULL;
+    }
+  }
+  if (entry != NULL) {
+    _insertKeyUpdate(entry, &dep);
+  } else {
+    RAISE_SYS_ERROR("Not enough memory to register update [0x%08X] with its "
+                    "router key", updId);
+    ok = false;
+  }
+  unlockMutex(&self->keyUpdateMutex);
+
+  return ok;
 }
 
-bool storePublicKey(KeyCache* self, SRxKeyID keyId) {
+
+bool storeRouterKey(KeyCache* self, uint32_t as, const uint8_t* ski,
+                    const uint8_t* keyInfo, uint16_t keyLength) {
+  KC_RouterKey*  entry;
+  EVP_PKEY*      key;
+  const uint8_t* der = keyInfo;
+  uint32_t       bucket = _routerKeyBucket(ski);
+
+  lockMutex(&self->routerKeyMutex);
+  reclaimEpochData(&self->routerKeyEpoch);
+  entry = _findRouterKey(self, as, ski);
+  if (entry != NULL) {
+    entry->refCount++;
+    unlockMutex(&self->routerKeyMutex);
+    return true;
+  }
+
+  // Decode the key once, the validations use it as is.
+  key = d2i_PUBKEY(NULL, &der, keyLength);
+  if ((key != NULL) && (EVP_PKEY_base_id(key) != EVP_PKEY_EC)) {
+    EVP_PKEY_free(key);
+    key = NULL;
+  }
+  entry = key != NULL ? malloc(sizeof(KC_RouterKey)) : NULL;
+  if (entry == NULL) {
+    unlockMutex(&self->routerKeyMutex);
+    if (key == NULL) {
+      RAISE_ERROR("Could not decode the EC router key of AS %u", as);
+    } else {
+      EVP_PKEY_free(key);
+      RAISE_SYS_ERROR("Not enough memory to store the router key of AS %u", 
+                      as);
+    }
+    return false;
+  }
+  entry->as = as;
+  entry->refCount = 1;
+  entry->serial = self->nextKeySerial++;
+  entry->key = key;
+  memcpy(entry->ski, ski, KC_SKI_LENGTH);
+  entry->next = self->routerKeys[bucket];
+  // Readers must see the initialized entry.
+  __sync_synchronize();
+  self->routerKeys[bucket] = entry;
+  self->noRouterKeys++;
+  unlockMutex(&self->routerKeyMutex);
+  _reportKeyUpdates(self, ski);
+
   return true;
 }
 
-bool deletePublicKey(KeyCache* self, SRxKeyID keyId) {
-  return true;
+bool deleteRouterKey(KeyCache* self, uint32_t as, const uint8_t* ski) {
+  KC_RouterKey* volatile* prev;
+  KC_RouterKey*           entry;
+  bool                    deleted = false;
+
+  lockMutex(&self->routerKeyMutex);
+  prev = &self->routerKeys[_routerKeyBucket(ski)];
+  for (entry = *prev; entry != NULL; prev = &entry->next, entry = *prev) {
+    if ((entry->as == as) && (memcmp(entry->ski, ski, KC_SKI_LENGTH) == 0)) {
+      break;
+    }
+  }
+  if ((entry != NULL) && (--entry->refCount == 0)) {
+    // Readers still walking over the entry keep following its next pointer.
+    *prev = entry->next;
+    self->noRouterKeys--;
+    retireEpochData(&self->routerKeyEpoch, entry, _releaseRouterKey);
+    deleted = true;
+  }
+  reclaimEpochData(&self->routerKeyEpoch);
+  unlockMutex(&self->routerKeyMutex);
+  if (deleted) {
+    _reportKeyUpdates(self, ski);
+  }
+
+  return entry != NULL;
 }
 
-bool addUpdateToKey(KeyCache* self, SRxKeyID keyId, SRxUpdateID updId) {
-  return true;
+EVP_PKEY* getRouterKey(KeyCache* self, uint32_t as, const uint8_t* ski,
+                       uint64_t* serial) {
+  KC_RouterKey* entry;
+  EVP_PKEY*     key = NULL;
+  bool          inEpoch = enterEpoch(&self->routerKeyEpoch);
+
+  // Without reader slot the writer lock is used.
+  if (!inEpoch) {
+    lockMutex(&self->routerKeyMutex);
+  }
+  entry = _findRouterKey(self, as, ski);
+  if ((entry != NULL) && (EVP_PKEY_up_ref(entry->key) == 1)) {
+    key = entry->key;
+    if (serial != NULL) {
+      *serial = entry->serial;
+    }
+  }
+  if (inEpoch) {
+    leaveEpoch(&self->routerKeyEpoch);
+  } else {
+    unlockMutex(&self->routerKeyMutex);
+  }
+
+  return key;
 }
 
+uint32_t getNumberOfRouterKeys(KeyCache* self) {
+  return self->noRouterKeys;
+}
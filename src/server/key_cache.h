@@ -20,11 +20,29 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
+ * The key cache also stores the router keys (BGPSec router certificates) 
+ * received from the validation caches. They are looked up by their subject key
+ * identifier and AS number. The keys are decoded once when they are stored.
+ * The SKI is a SHA-1 hash, its leading bytes select the bucket directly.
+ * Readers walk the buckets without locking within the epoch of the key cache,
+ * writers are serialized by a mutex.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Added the router key store: storeRouterKey, deleteRouterKey,
+ *              getRouterKey and getNumberOfRouterKeys.
+ *            * The update cache is stored in the key cache.
+ *            * Router keys are stored in SKI indexed buckets which are read
+ *              lock-free. Only EC keys are accepted.
+ *            * Removed the stubs getPublicKey, storePublicKey and 
+ *              deletePublicKey.
+ *            * Each stored router key gets a serial, returned by getRouterKey.
+ *            * addUpdateToKey maintains the index of the updates depending on
+ *              a SKI. Storing or deleting a router key reports them to the
+ *              KeyInvalidated callback, see setKeyInvalidatedCallback.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Added Changelog
  *            * Fixed speller in documentation header
@@ -35,15 +53,54 @@
 #ifndef __KEY_CACHE_H__
 #define __KEY_CACHE_H__
 
+#include <openssl/evp.h>
 #include "server/update_cache.h"
 #include "shared/srx_defs.h"
+#include "util/epoch.h"
+#include "util/mutex.h"
+
+/** The length of a subject key identifier. @since 0.4.1.0 */
+#define KC_SKI_LENGTH 20
+/** The number of router key buckets, a power of two not larger than 2^16. 
+ * @since 0.4.1.0 */
+#define KC_ROUTER_KEY_BUCKETS 4096
+
+/** The initial capacity of the set of updates depending on a SKI, a power
+ * of two. @since 0.4.1.0 */
+#define KC_KEY_UPDATES_INIT   16
+
+/** A stored router key, defined in key_cache.c. @since 0.4.1.0 */
+typedef struct _KC_RouterKey KC_RouterKey;
+/** The updates depending on a SKI, defined in key_cache.c.
+ * @since 0.4.1.0 */
+typedef struct _KC_KeyUpdates KC_KeyUpdates;
+
+/**
+ * An update whose BGPSec path validation used a SKI.
+ *
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** The ID of the update. */
+  SRxUpdateID updateID;
+  /** The AS number of the router that received the update. */
+  uint32_t    localAS;
+} KC_KeyDependent;
 
 /**
- * Function that is called when a key was removed or replaced.
+ * Function that is called when a router key was stored or deleted.
  *
- * @param keyId Affected key
+ * @param user The user pointer registered with the callback.
+ * @param ski The subject key identifier of the key.
+ * @param deps The updates whose validation used the SKI and that are still
+ *             in the update cache. Only valid during the call.
+ * @param count The number of updates.
+ *
+ * @since 0.4.1.0 The key is identified by its SKI, the dependent updates are
+ *                given.
  */
-typedef void (*KeyInvalidated)(SRxKeyID keyId);
+typedef void (*KeyInvalidated)(void* user, const uint8_t* ski,
+                               KC_KeyDependent* deps, uint32_t count);
 
 /**
  * Function that is called when a key could not be found.
@@ -58,7 +115,26 @@ typedef void (*KeyNotFound)(SRxKeyID keyId);
 typedef struct {
   UpdateCache*    updateCache;
   KeyInvalidated  invCallback;
+  /** The user pointer of invCallback. @since 0.4.1.0 */
+  void*           invUser;
   KeyNotFound     notFoundCallback;
+  /** The router key buckets, selected by the subject key identifier. 
+   * @since 0.4.1.0 */
+  KC_RouterKey* volatile* routerKeys;
+  /** Serializes the writers of the router keys. @since 0.4.1.0 */
+  Mutex           routerKeyMutex;
+  /** The epoch of the router key readers. @since 0.4.1.0 */
+  EpochDomain     routerKeyEpoch;
+  /** The number of router keys stored. @since 0.4.1.0 */
+  uint32_t        noRouterKeys;
+  /** The serial of the next router key stored. @since 0.4.1.0 */
+  uint64_t        nextKeySerial;
+  /** The updates depending on a SKI, selected like the router keys.
+   * @since 0.4.1.0 */
+  KC_KeyUpdates** keyUpdates;
+  /** Protects the updates depending on a SKI and the callback.
+   * @since 0.4.1.0 */
+  Mutex           keyUpdateMutex;
 } KeyCache;
 
 /**
@@ -81,50 +157,97 @@ bool createKeyCache(KeyCache* self, UpdateCache* updateCache,
 void releaseKeyCache(KeyCache* self);
 
 /**
- * Returns a stored public key, or an error if they key could not be found. 
- * In case of an error, the KeyNotFound callback is invoke.
+ * Register the callback that is called with the dependent updates each time
+ * a router key is stored for the first time or deleted for the last time.
+ * Replaces the callback given to createKeyCache.
+ *
+ * @param self Instance
+ * @param callback The callback, NULL to remove it.
+ * @param user The user pointer given to the callback.
  *
- * @todo Adjust according to specification
+ * @since 0.4.1.0
+ */
+void setKeyInvalidatedCallback(KeyCache* self, KeyInvalidated callback,
+                               void* user);
+
+/**
+ * Records that the BGPSec path validation of an update used the key with the
+ * given SKI, whether the key is stored or not. Updates no longer in the
+ * update cache are dropped from the index when it grows.
  *
  * @param self Instance
- * @param keyId Key to look-up
- * @return \c true = key was found, \c false = key not found
+ * @param ski The subject key identifier (KC_SKI_LENGTH bytes).
+ * @param updId Update that should be registered with the key
+ * @param localAS The AS number of the router that received the update.
+ *
+ * @return false if not enough memory was available.
+ *
+ * @since 0.4.1.0 The key is identified by its SKI.
  */
-bool getPublicKey(KeyCache* self, SRxKeyID keyId);
+bool addUpdateToKey(KeyCache* self, const uint8_t* ski, SRxUpdateID updId,
+                    uint32_t localAS);
 
 /**
- * Stores a key. 
- * If the key already existed, the KeyInvalidated callback is called, and the
- * Update Cache (update_cache.h) will be informed.
- 
+ * Stores a router key. A key announced more than once (e.g. by multiple 
+ * validation caches) is stored once and has to be deleted as often as it was
+ * stored. Storing a new key reports the updates depending on its SKI.
+ *
  * @param self Instance
- * @param keyId Identifier of the passed key
- * @return \c true = key stored, \c false = failed to store
+ * @param as The AS number of the router key.
+ * @param ski The subject key identifier (KC_SKI_LENGTH bytes).
+ * @param keyInfo The DER encoded subject public key info.
+ * @param keyLength The maximum length of keyInfo.
  *
- * @todo Adjust according to specification
+ * @return false if the key is not an EC key or could not be stored.
+ *
+ * @since 0.4.1.0
  */
-bool storePublicKey(KeyCache* self, SRxKeyID keyId);
+bool storeRouterKey(KeyCache* self, uint32_t as, const uint8_t* ski,
+                    const uint8_t* keyInfo, uint16_t keyLength);
 
 /**
- * Removes a key. 
- * KeyInvalidated is invoked, and the Update Cache (update_cache.h) is 
- * informed.
+ * Deletes a router key. Deleting it for the last time reports the updates
+ * depending on its SKI.
  *
  * @param self Instance
- * @param keyId Key that should be removed
- * @return \c true = key was removed, \c false = unknown key
+ * @param as The AS number of the router key.
+ * @param ski The subject key identifier (KC_SKI_LENGTH bytes).
+ *
+ * @return false if the key is unknown.
+ *
+ * @since 0.4.1.0
  */
-bool deletePublicKey(KeyCache* self, SRxKeyID keyId);
+bool deleteRouterKey(KeyCache* self, uint32_t as, const uint8_t* ski);
 
 /**
- * Records that a key has been used to sign a certain update.
+ * Returns the public key of a router key. The returned key is referenced and
+ * must be released by the caller using EVP_PKEY_free. The lookup does not 
+ * lock unless all reader slots of the epoch are in use.
  *
  * @param self Instance
- * @param keyId Key with which to register the update
- * @param updId Update that should be registered with the key
- * @return \c true = registered with the given key, \c false = unknown key
+ * @param as The AS number of the router key.
+ * @param ski The subject key identifier (KC_SKI_LENGTH bytes).
+ * @param serial OUT - The serial of the key, unique for each key stored. A key
+ *               that is deleted and stored again gets a new serial. Can be 
+ *               NULL.
+ *
+ * @return The key or NULL if it is unknown.
+ *
+ * @since 0.4.1.0
+ */
+EVP_PKEY* getRouterKey(KeyCache* self, uint32_t as, const uint8_t* ski,
+                       uint64_t* serial);
+
+/**
+ * Returns the number of router keys stored.
+ *
+ * @param self Instance
+ *
+ * @return The number of router keys.
+ *
+ * @since 0.4.1.0
  */
-bool addUpdateToKey(KeyCache* self, SRxKeyID keyId, SRxUpdateID updId);
+uint32_t getNumberOfRouterKeys(KeyCache* self);
 
 #endif // !__KEY_CACHE_H__
 
@@ -25,7 +25,7 @@
  * In this version the SRX server only can connect to once RPKI VALIDATION CACHE
  * MULTI CACHE will be part of a later release.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * EXIT Values:
  *
@@ -38,6 +38,34 @@
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Command queue is created with one lane per command handler.
+ *            * Result changes are broadcasted in batches.
+ *            * Start the garbage collector of the update cache and stop it
+ *              before the prefix cache is released.
+ *            * Restore the caches from the configured snapshot on startup and
+ *              resume the validation cache session. Snapshots are written
+ *              periodically and during the cleanup.
+ *            * Pass all configured validation caches to the RPKI handler.
+ *            * Record the time used to broadcast changed results.
+ *          - 2026/10/15 - kyehwanl
+ *            * Start the metrics server if a metrics port is configured.
+ *            * Messages are written by the log writer thread.
+ *            * The RPKI handler stores router keys in the key cache, the 
+ *              BGPSec handler starts the configured number of workers.
+ *            * Pass the size of the signature memo to the BGPSec handler.
+ *            * Load the private key of the router if configured.
+ *            * Apply the configured CPUs of the thread classes before any
+ *              thread is started.
+ *            * Share the ROA white-list with the other SRx servers on this host if a
+ *              shared ROA table is configured.
+ *            * Check the flow control of the proxies once a second.
+ *            * Serve the proxies with provisional results until the first
+ *              validation cache is synchronized if configured.
+ *            * Configure the batching of the send queue.
+ *            * Follow the configured primary server as hot standby server and
+ *              take over once it is lost. Replicate the caches to a standby
+ *              server if a replication port is configured.
  * 0.3.0.10 - 2015/11/10 - oborchert
  *            * Removed unused static colsoleLoop
  * 0.3.0.7  - 2015/04/21 - oborchert
@@ -65,19 +93,25 @@
 #include <stdio.h>
 #include <signal.h>
 #include "server/bgpsec_handler.h"
+#include "server/cache_snapshot.h"
 #include "server/command_handler.h"
 #include "server/command_queue.h"
 #include "server/configuration.h"
 #include "server/console.h"
+#include "server/metrics.h"
 #include "server/key_cache.h"
 #include "server/prefix_cache.h"
+#include "server/replication.h"
 #include "server/rpki_handler.h"
 #include "server/server_connection_handler.h"
+#include "server/shared_roa.h"
 #include "server/srx_server.h"
 #include "server/srx_packet_sender.h"
+#include "server/stage_stats.h"
 #include "server/update_cache.h"
 #include "util/directory.h"
 #include "util/log.h"
+#include "util/timer.h"
 
 // Some defines needed for east
 #define SETUP_RPKI_HANDLER         1
@@ -107,10 +141,16 @@ static PrefixCache   prefixCache;
 static KeyCache      keyCache;
 /** The server console. */
 static SRXConsole    console;
+/** The metrics server, only started if a metrics port is configured. */
+static SRxMetrics    metrics;
+/** The replication to or from another SRx server. */
+static Replication   replication;
+/** Set while the server follows a primary server, nothing is broadcasted. */
+static volatile bool inStandby = false;
 
 
 
-/** Handles ROA validation requests              - Currently only one cache. **/
+/** Handles ROA validation requests of all configured validation caches.  **/
 static RPKIHandler              rpkiHandler;
 
 /** Handles BGPSEC path validation requests.     - Currently only one cache. **/
@@ -127,6 +167,19 @@ static ServerConnectionHandler  svrConnHandler;
 
 static bool cleanupRequired = false;
 
+/** The validation cache sessions restored from the snapshot. */
+static RPKISession* restoredSessions  = NULL;
+/** The number of restored validation cache sessions. */
+static uint32_t     noRestoredSessions = 0;
+/** The timer that writes the snapshots, -1 if none. */
+static int         snapshotTimer   = -1;
+/** The ROA table shared with the other SRx servers on this host. */
+static SharedROATable sharedROAs;
+/** The timer that publishes or refreshes the shared ROAs, -1 if none. */
+static int            sharedROATimer = -1;
+/** The timer that checks the flow control of the proxies, -1 if none. */
+static int            flowControlTimer = -1;
+
 
 // To allow to use it already ;-)
 static void doCleanupHandlers(int handler);
@@ -142,7 +195,84 @@ static void doCleanupHandlers(int handler);
  */
 static void handleUpdateResultChange (SRxValidationResult* valResult)
 {
+  uint64_t start;
+
+  if (inStandby)
+  {
+    return;
+  }
+  start = getStageTime();
   broadcastResult (&cmdHandler, valResult);
+  recordStage(STAGE_RESULT_BROADCAST, start);
+}
+
+/** This method handles the batches of changed results reported by the update
+ * cache. The results are broadcasted to the SRX clients connected to the srx
+ * server.
+ * @param valResults The changed validation results.
+ * @param count The number of results.
+ */
+static void handleUpdateResultsChange (SRxValidationResult* valResults,
+                                       uint32_t count)
+{
+  uint64_t start;
+
+  if (inStandby)
+  {
+    return;
+  }
+  start = getStageTime();
+  broadcastResults (&cmdHandler, valResults, count);
+  recordStage(STAGE_RESULT_BROADCAST, start);
+}
+
+/** This method writes a snapshot of the caches each time the snapshot timer
+ * expires.
+ * @param id The id of the snapshot timer.
+ * @param now The current time.
+ */
+static void handleSnapshotTimer (int id, time_t now)
+{
+  writeCacheSnapshot(config.snapshotFile, &rpkiHandler, &updCache);
+}
+
+/** This method publishes the ROA white-list into the shared ROA table or, if
+ * attached to the table of another server, revalidates the updates each time
+ * the shared ROA timer expires.
+ * @param id The id of the shared ROA timer.
+ * @param now The current time.
+ */
+static void handleSharedROATimer (int id, time_t now)
+{
+  if (config.sharedROAAttach)
+  {
+    refreshSharedROAs(&prefixCache);
+  }
+  else
+  {
+    publishSharedROAs(&prefixCache);
+  }
+}
+
+/** This method checks the queue levels each time the flow control timer
+ * expires. It lets paused proxies resume even if no PDU is received and no
+ * command is processed anymore.
+ * @param id The id of the flow control timer.
+ * @param now The current time.
+ */
+static void handleFlowControlTimer (int id, time_t now)
+{
+  updateFlowControl(&svrConnHandler);
+}
+
+/** This method ends the provisional mode once the first validation cache is
+ * synchronized and validates the updates received until then.
+ * @param user Not used.
+ */
+static void handleRPKISynchronized (void* user)
+{
+  endProvisionalMode(&svrConnHandler);
+  validateProvisionalUpdates(&prefixCache);
 }
 
 ////////////////////////
@@ -164,6 +294,7 @@ static void handleUpdateResultChange (SRxValidationResult* valResult)
 static int setupConfiguration (int argc, const char* argv[])
 {
   int params;
+  int idx;
 
   // Set to defaults
   //initConfiguration(&config, DEFAULT_CONFIG_FILE);
@@ -207,6 +338,15 @@ static int setupConfiguration (int argc, const char* argv[])
     return 0;
   }
 
+  // Place the threads, all of them are started after this point.
+  for (idx = 0; idx < NUM_THREAD_CLASSES; idx++)
+  {
+    if (!setThreadClassCPUs(idx, config.threadCPUs[idx]))
+    {
+      return 0;
+    }
+  }
+
   if ( !config.verbose )
   {
     // If verbose is turned off, at least set ERROR output.
@@ -235,16 +375,79 @@ static int setupConfiguration (int argc, const char* argv[])
  */
 static bool setupCaches()
 {
+  // A standby server has no clients until it takes over.
+  inStandby = config.replicationPrimaryHost != NULL;
   if (   !createUpdateCache(&updCache, handleUpdateResultChange,
                             config.expectedProxies, &config)
       || !initializePrefixCache(&prefixCache, &updCache)
       || !createKeyCache(&keyCache, &updCache, NULL, NULL))
-  { ///< TODO Set KeyInvalidated, KeyNotFound
+  { ///< TODO Set KeyNotFound, KeyInvalidated is set by the BGPSec handler
     RAISE_ERROR("Failed to setup a cache - stopping");
     return false;
   }
 
+  setUpdateResultsChangedCallback(&updCache, handleUpdateResultsChange);
+  // A standby server collects the updates as the primary server does.
+  if (!inStandby && !startUpdateCacheGC(&updCache, &prefixCache))
+  {
+    RAISE_ERROR("Failed to start the garbage collector - stopping");
+    return false;
+  }
+
   LOG(LEVEL_INFO, "- Caches created");
+
+  if (config.sharedROAName != NULL)
+  {
+    if (config.sharedROAAttach
+        ? !attachSharedROATable(&sharedROAs, config.sharedROAName)
+        : !createSharedROATable(&sharedROAs, config.sharedROAName,
+                                config.sharedROACapacity))
+    {
+      RAISE_ERROR("Failed to setup the shared ROA table - stopping");
+      return false;
+    }
+    setSharedROATable(&prefixCache, &sharedROAs);
+    LOG(LEVEL_INFO, "- Shared ROA table '%s' %s", config.sharedROAName,
+                    config.sharedROAAttach ? "attached" : "created");
+  }
+
+  if ((config.snapshotFile != NULL) && !inStandby)
+  {
+    if (loadCacheSnapshot(config.snapshotFile, &prefixCache, &updCache,
+                          &restoredSessions, &noRestoredSessions))
+    {
+      LOG(LEVEL_INFO, "- Caches restored from snapshot");
+    }
+  }
+  return true;
+}
+
+/**
+ * Follow the configured primary server until it can not be reached anymore,
+ * then take over with the caches and the sessions received from it.
+ * @return false if the caches could not be taken over.
+ */
+static bool setupStandby()
+{
+  if (!runReplicationStandby(&replication, config.replicationPrimaryHost,
+                             config.replicationPrimaryPort,
+                             config.replicationTimeout, &prefixCache,
+                             &updCache, &restoredSessions,
+                             &noRestoredSessions))
+  {
+    return false;
+  }
+
+  // The proxies have the keep window to register for the updates again.
+  keepUpdatesWithoutClient(&updCache, (uint16_t)config.defaultKeepWindow);
+  inStandby = false;
+  if (!startUpdateCacheGC(&updCache, &prefixCache))
+  {
+    RAISE_ERROR("Failed to start the garbage collector - stopping");
+    return false;
+  }
+
+  LOG(LEVEL_INFO, "- Took over from the primary server");
   return true;
 }
 
@@ -257,9 +460,27 @@ static bool setupHandlers()
 {
   uint8_t handlers = 0;
   bool retVal = true;
-
-  if (!createRPKIHandler (&rpkiHandler, &prefixCache,
-                          config.rpki_host, config.rpki_port))
+  const char* rpkiHosts[CFG_MAX_RPKI_CACHES];
+  int         rpkiPorts[CFG_MAX_RPKI_CACHES];
+  int         idx;
+
+  // The configured validation cache first, then the additional ones.
+  rpkiHosts[0] = config.rpki_host;
+  rpkiPorts[0] = config.rpki_port;
+  for (idx = 0; idx < config.noExtraRpki; idx++)
+  {
+    rpkiHosts[idx + 1] = config.extraRpkiHosts[idx];
+    rpkiPorts[idx + 1] = config.extraRpkiPorts[idx];
+  }
+
+  retVal = createRPKIHandler (&rpkiHandler, &prefixCache, &keyCache, 
+                              rpkiHosts, rpkiPorts, config.noExtraRpki + 1, 
+                              restoredSessions, noRestoredSessions);
+  // The sessions are handed over to the handler.
+  free(restoredSessions);
+  restoredSessions   = NULL;
+  noRestoredSessions = 0;
+  if (!retVal)
   {
     RAISE_ERROR("Failed to create RPKI Handler.");
   }
@@ -267,10 +488,17 @@ static bool setupHandlers()
   {
     handlers |= SETUP_RPKI_HANDLER;
     if (!createBGPSecHandler (&bgpsecHandler, &keyCache,
-                              config.bgpsec_host, config.bgpsec_port))
+                              config.bgpsec_host, config.bgpsec_port,
+                              config.bgpsecWorkers, config.bgpsecMemoSize))
     {
       RAISE_ERROR("Failed to create BGPSEC Handler.");
     }
+    else if (   (config.bgpsecKeyFile != NULL)
+             && !loadPrivateKey(&bgpsecHandler, config.bgpsecKeyFile))
+    {
+      handlers |= SETUP_BGPSEC_HANDLER;
+      RAISE_ERROR("Failed to load the private key of the router.");
+    }
     else
     {
       handlers |= SETUP_BGPSEC_HANDLER;
@@ -289,6 +517,12 @@ static bool setupHandlers()
         else
         {
           handlers |= SETUP_COMMAND_HANDLER;
+          if (config.mode_provisional_sync)
+          {
+            // Called right away if a restored session is synchronized
+            // already.
+            setRPKISyncCallback(&rpkiHandler, handleRPKISynchronized, NULL);
+          }
         }
       }
     }
@@ -297,6 +531,42 @@ static bool setupHandlers()
   if (handlers == SETUP_ALL_HANDLERS)
   {
     LOG(LEVEL_INFO, "- All Handlers created");
+    if (config.snapshotFile != NULL)
+    {
+      snapshotTimer = setupTimer(handleSnapshotTimer);
+      if (snapshotTimer != -1)
+      {
+        startIntervalTimer(snapshotTimer, config.snapshotInterval, false);
+      }
+      else
+      {
+        RAISE_ERROR("Failed to setup the snapshot timer, no snapshots will be "
+                    "written!");
+      }
+    }
+    if (config.sharedROAName != NULL)
+    {
+      sharedROATimer = setupTimer(handleSharedROATimer);
+      if (sharedROATimer != -1)
+      {
+        startIntervalTimer(sharedROATimer, config.sharedROAInterval, false);
+      }
+      else
+      {
+        RAISE_ERROR("Failed to setup the shared ROA timer, the shared ROAs "
+                    "will not be updated!");
+      }
+    }
+    flowControlTimer = setupTimer(handleFlowControlTimer);
+    if (flowControlTimer != -1)
+    {
+      startIntervalTimer(flowControlTimer, 1, false);
+    }
+    else
+    {
+      RAISE_ERROR("Failed to setup the flow control timer, paused proxies "
+                  "only resume while PDUs are processed!");
+    }
   }
   else
   {
@@ -321,6 +591,7 @@ static bool setupQueues()
     cont = false;
     if (createSendQueue())
     {
+      setSendBatching(config.sendBatchDelay, config.sendBatchBytes);
       if (startSendQueue())
       {
         // Send queue successfully started
@@ -336,7 +607,8 @@ static bool setupQueues()
 
   if (cont)
   {
-    if (!initializeCommandQueue(&cmdQueue))
+    if (!initializeCommandQueue(&cmdQueue,
+                                config.commandHandlerThreads))
     {
       stopSendQueue();
       releaseSendQueue();
@@ -370,6 +642,8 @@ static void signalReceived(int _sig)
   stopProcessingRequests(&svrConnHandler);
 
   releaseConsole(&console);
+  releaseMetricsServer(&metrics);
+  releaseReplicationServer(&replication);
 
   // Stopps, clears and releases all memory used by the send queue
   releaseSendQueue();
@@ -404,6 +678,15 @@ static void run()
  */
 static void doCleanupHandlers(int handler)
 {
+  // Revalidated shared ROAs are broadcasted and the flow control is send to
+  // the proxies, stop the timer thread first.
+  if ((sharedROATimer != -1) || (flowControlTimer != -1))
+  {
+    deleteAllTimers();
+    sharedROATimer   = -1;
+    snapshotTimer    = -1;
+    flowControlTimer = -1;
+  }
   if ((handler & SETUP_CONNECTION_HANDLER) > 0)
   {
     releaseServerConnectionHandler(&svrConnHandler);
@@ -418,6 +701,12 @@ static void doCleanupHandlers(int handler)
   }
   if ((handler & SETUP_RPKI_HANDLER) > 0)
   {
+    // Snapshots need the RPKI handler, stop the timer thread first.
+    if (snapshotTimer != -1)
+    {
+      deleteAllTimers();
+      snapshotTimer = -1;
+    }
     releaseRPKIHandler(&rpkiHandler);
   }
 }
@@ -435,7 +724,10 @@ static void doCleanupCaches(int cache)
   }
   if ((cache & SETUP_PREFIX_CACHE) > 0)
   {
+    // The garbage collector removes updates from the prefix cache.
+    stopUpdateCacheGC(&updCache);
     releasePrefixCache(&prefixCache);
+    releaseSharedROATable(&sharedROAs);
   }
   if ((cache & SETUP_UPDATE_CACHE) > 0)
   {
@@ -451,11 +743,20 @@ static void doCleanup()
 {
   // First disconnects the server console.
   releaseConsole(&console);
+  releaseMetricsServer(&metrics);
+  // The replication needs the RPKI handler.
+  releaseReplicationServer(&replication);
 
   // Queues
   releaseCommandQueue(&cmdQueue);
   releaseSendQueue();
 
+  // A last snapshot while the handlers are still available.
+  if (config.snapshotFile != NULL)
+  {
+    writeCacheSnapshot(config.snapshotFile, &rpkiHandler, &updCache);
+  }
+
   // Handlers
   doCleanupHandlers(SETUP_ALL_HANDLERS);
 
@@ -532,6 +833,13 @@ int main(int argc, const char* argv[])
       LOG(LEVEL_ERROR, "Could not set log file.");
   }
 
+  // From now on the messages are written by the log writer thread.
+  if (!startLogWriter())
+  {
+    LOG(LEVEL_WARNING, "Could not start the log writer, messages are written "
+                       "synchronously.");
+  }
+
   LOG(LEVEL_DEBUG, "([0x%08X]) > Start Main SRx server thread.", pthread_self());
 
   if ( passedConfig != 1)
@@ -555,6 +863,15 @@ int main(int argc, const char* argv[])
     releaseConfiguration(&config);
     exitCode = 2;
   }
+  else if (   (config.replicationPrimaryHost != NULL)
+           && !setupStandby() )
+  {
+    LOG(LEVEL_ERROR, "Failure taking over from the primary server, exit "
+                     "program (2)");
+    doCleanupCaches(SETUP_ALL_CACHES);
+    releaseConfiguration(&config);
+    exitCode = 2;
+  }
   else if ( !setupHandlers() )
   {
     LOG(LEVEL_ERROR, "Failure setting up handlers, exit program (3)");
@@ -585,6 +902,23 @@ int main(int argc, const char* argv[])
   }
   else
   {
+    // The metrics are optional, the server runs without them.
+    if (   (config.metrics_port != 0)
+        && !createMetricsServer(&metrics, config.metrics_port, &updCache,
+                                &rpkiHandler, &cmdQueue, &svrConnHandler))
+    {
+      LOG(LEVEL_ERROR, "Failure setting up the metrics server on port %d",
+          config.metrics_port);
+    }
+    // A server that took over serves the next standby server the same way.
+    if (   (config.replication_port != 0)
+        && !createReplicationServer(&replication, config.replication_port,
+                                    config.replicationTimeout, &rpkiHandler,
+                                    &updCache))
+    {
+      LOG(LEVEL_ERROR, "Failure setting up the replication server on port %d",
+          config.replication_port);
+    }
     // Ready for requests
     cleanupRequired = true;
     run();
@@ -602,6 +936,7 @@ int main(int argc, const char* argv[])
   }
 
   LOG(LEVEL_DEBUG, "([0x%08X]) < Stop Main SRx server thread.", pthread_self());
+  stopLogWriter();
   if(fp)
     fclose(fp);
   return exitCode;
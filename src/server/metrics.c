@@ -0,0 +1,718 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Serves the metrics of the SRx server in the Prometheus text format via
+ * HTTP/1.0. One request is served at a time, each connection is closed after
+ * the response. All values are read without lock and might miss a concurrent
+ * change.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ *            * Added the memory of each subsystem.
+ *            * Added the send batches of each proxy.
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "server/metrics.h"
+#include "server/prefix_cache.h"
+#include "server/srx_packet_sender.h"
+#include "server/stage_stats.h"
+#include "util/log.h"
+#include "util/mem_stats.h"
+#include "util/thread.h"
+
+#define HDR "([0x%08X] Metrics): "
+
+/** The time in milliseconds the server waits for a connection before it
+ * checks if it has to stop. */
+#define METRICS_ACCEPT_WAIT_MS 1000
+/** The time in seconds a client has to send its request. */
+#define METRICS_READ_TIMEOUT   2
+/** The maximum size of a request that is read. */
+#define METRICS_REQUEST_SIZE   2048
+/** The initial size of the response buffer. */
+#define METRICS_BUFFER_SIZE    16384
+
+/** The content type of the Prometheus text format. */
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4"
+
+/** The quantiles reported for each stage, in per mil. */
+static const uint32_t _QUANTILES[] = { 500, 900, 990, 999 };
+/** The number of quantiles. */
+#define NUM_QUANTILES (sizeof(_QUANTILES) / sizeof(uint32_t))
+
+static void* _metricsLoop(void* selfPtr);
+
+/**
+ * Append the formatted text to the response buffer. The buffer grows if
+ * needed.
+ *
+ * @param self The metrics server.
+ * @param format The printf format.
+ *
+ * @return false if the buffer could not be extended.
+ */
+static bool _append(SRxMetrics* self, const char* format, ...)
+{
+  va_list ap;
+  int     len;
+  size_t  newSize;
+  char*   newBuffer;
+
+  while (true)
+  {
+    va_start(ap, format);
+    len = vsnprintf(self->buffer + self->bufferUsed,
+                    self->bufferSize - self->bufferUsed, format, ap);
+    va_end(ap);
+    if (len < 0)
+    {
+      return false;
+    }
+    if (self->bufferUsed + len < self->bufferSize)
+    {
+      self->bufferUsed += len;
+      return true;
+    }
+    newSize   = self->bufferSize * 2;
+    newBuffer = realloc(self->buffer, newSize);
+    if (newBuffer == NULL)
+    {
+      RAISE_SYS_ERROR("Not enough memory to generate the metrics!");
+      return false;
+    }
+    self->buffer     = newBuffer;
+    self->bufferSize = newSize;
+  }
+}
+
+/**
+ * Append the HELP and TYPE line of a metric.
+ *
+ * @param self The metrics server.
+ * @param name The metric name.
+ * @param type The metric type.
+ * @param help The help text.
+ */
+static void _appendHeader(SRxMetrics* self, const char* name, const char* type,
+                          const char* help)
+{
+  _append(self, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/**
+ * Append the update, prefix, and VRP counts.
+ *
+ * @param self The metrics server.
+ */
+static void _appendCacheMetrics(SRxMetrics* self)
+{
+  PrefixCache* prefixCache = self->rpkiHandler->prefixCache;
+
+  _appendHeader(self, "srx_updates", "gauge",
+                "Number of updates stored in the update cache.");
+  _append(self, "srx_updates %u\n", getNumberOfUpdates(self->updCache));
+  _appendHeader(self, "srx_update_shadows", "gauge",
+                "Number of origin validation records in the prefix cache.");
+  _append(self, "srx_update_shadows %u\n", prefixCache->updates.size);
+  _appendHeader(self, "srx_prefixes", "gauge",
+                "Number of prefixes stored in the prefix cache.");
+  _append(self, "srx_prefixes %u\n", getNumberOfPrefixes(prefixCache));
+  _appendHeader(self, "srx_vrps", "gauge",
+                "Number of ROA white-list entries stored in the prefix cache.");
+  _append(self, "srx_vrps %u\n", getNumberOfVRPs(prefixCache));
+}
+
+/**
+ * Append the current depth of the queues.
+ *
+ * @param self The metrics server.
+ */
+static void _appendQueueMetrics(SRxMetrics* self)
+{
+  _appendHeader(self, "srx_queue_depth", "gauge",
+                "Number of elements waiting in the queue, bytes for the send "
+                "queue.");
+  _append(self, "srx_queue_depth{queue=\"%s\"} %d\n",
+          statsQueueToStr(STATS_QUEUE_RECEIVER),
+          getSCHReceiverQueueSize(self->svrConnHandler));
+  _append(self, "srx_queue_depth{queue=\"%s\"} %d\n",
+          statsQueueToStr(STATS_QUEUE_COMMAND),
+          getUnprocessedQueueSize(self->cmdQueue));
+  _append(self, "srx_queue_depth{queue=\"%s\"} %zu\n",
+          statsQueueToStr(STATS_QUEUE_SEND), getSendQueueSize());
+}
+
+/**
+ * Append the counters of each proxy mapping.
+ *
+ * @param self The metrics server.
+ */
+static void _appendProxyMetrics(SRxMetrics* self)
+{
+  ProxyClientMapping* mapping;
+  int                 clientID;
+
+  _appendHeader(self, "srx_proxies", "gauge",
+                "Number of connected proxies.");
+  _append(self, "srx_proxies %u\n", self->svrConnHandler->clients.size);
+
+  _appendHeader(self, "srx_proxy_active", "gauge",
+                "1 if the proxy is connected, otherwise 0.");
+  for (clientID = 1; clientID < MAX_PROXY_CLIENT_ELEMENTS; clientID++)
+  {
+    mapping = &self->svrConnHandler->proxyMap[clientID];
+    if (mapping->proxyID != 0)
+    {
+      _append(self, "srx_proxy_active{client=\"%d\",proxy=\"%u\"} %d\n",
+              clientID, mapping->proxyID, mapping->isActive ? 1 : 0);
+    }
+  }
+  _appendHeader(self, "srx_proxy_updates", "gauge",
+                "Number of updates assigned to the proxy.");
+  for (clientID = 1; clientID < MAX_PROXY_CLIENT_ELEMENTS; clientID++)
+  {
+    mapping = &self->svrConnHandler->proxyMap[clientID];
+    if (mapping->proxyID != 0)
+    {
+      _append(self, "srx_proxy_updates{client=\"%d\",proxy=\"%u\"} %u\n",
+              clientID, mapping->proxyID, mapping->updateCount);
+    }
+  }
+  _appendHeader(self, "srx_proxy_requests_total", "counter",
+                "Number of validation requests received from the proxy.");
+  for (clientID = 1; clientID < MAX_PROXY_CLIENT_ELEMENTS; clientID++)
+  {
+    mapping = &self->svrConnHandler->proxyMap[clientID];
+    if (mapping->proxyID != 0)
+    {
+      _append(self, "srx_proxy_requests_total{client=\"%d\",proxy=\"%u\"} "
+              "%llu\n", clientID, mapping->proxyID,
+              (unsigned long long)mapping->noRequests);
+    }
+  }
+  _appendHeader(self, "srx_proxy_notifications_total", "counter",
+                "Number of validation results sent to the proxy.");
+  for (clientID = 1; clientID < MAX_PROXY_CLIENT_ELEMENTS; clientID++)
+  {
+    mapping = &self->svrConnHandler->proxyMap[clientID];
+    if (mapping->proxyID != 0)
+    {
+      _append(self, "srx_proxy_notifications_total{client=\"%d\",proxy=\"%u\"}"
+              " %llu\n", clientID, mapping->proxyID,
+              (unsigned long long)mapping->noNotifications);
+    }
+  }
+}
+
+/**
+ * Append the batches the send queue wrote to each connected proxy. The
+ * average batch size is the number of packets divided by the batches.
+ *
+ * @param self The metrics server.
+ */
+static void _appendSendBatchMetrics(SRxMetrics* self)
+{
+  SendBatchStats      stats[MAX_PROXY_CLIENT_ELEMENTS];
+  bool                found[MAX_PROXY_CLIENT_ELEMENTS];
+  ProxyClientMapping* mapping;
+  int                 clientID;
+
+  for (clientID = 1; clientID < MAX_PROXY_CLIENT_ELEMENTS; clientID++)
+  {
+    mapping = &self->svrConnHandler->proxyMap[clientID];
+    found[clientID] =    (mapping->proxyID != 0) && (mapping->socket != NULL)
+                      && getClientSendStats(mapping->socket, &stats[clientID]);
+  }
+
+  _appendHeader(self, "srx_proxy_send_batches_total", "counter",
+                "Number of batches written to the proxy.");
+  for (clientID = 1; clientID < MAX_PROXY_CLIENT_ELEMENTS; clientID++)
+  {
+    if (found[clientID])
+    {
+      _append(self, "srx_proxy_send_batches_total{client=\"%d\",proxy=\"%u\"}"
+              " %llu\n", clientID,
+              self->svrConnHandler->proxyMap[clientID].proxyID,
+              (unsigned long long)stats[clientID].noBatches);
+    }
+  }
+  _appendHeader(self, "srx_proxy_send_batch_packets_total", "counter",
+                "Number of packets written to the proxy in batches.");
+  for (clientID = 1; clientID < MAX_PROXY_CLIENT_ELEMENTS; clientID++)
+  {
+    if (found[clientID])
+    {
+      _append(self, "srx_proxy_send_batch_packets_total{client=\"%d\","
+              "proxy=\"%u\"} %llu\n", clientID,
+              self->svrConnHandler->proxyMap[clientID].proxyID,
+              (unsigned long long)stats[clientID].noPackets);
+    }
+  }
+  _appendHeader(self, "srx_proxy_send_batch_bytes_total", "counter",
+                "Number of bytes written to the proxy in batches.");
+  for (clientID = 1; clientID < MAX_PROXY_CLIENT_ELEMENTS; clientID++)
+  {
+    if (found[clientID])
+    {
+      _append(self, "srx_proxy_send_batch_bytes_total{client=\"%d\","
+              "proxy=\"%u\"} %llu\n", clientID,
+              self->svrConnHandler->proxyMap[clientID].proxyID,
+              (unsigned long long)stats[clientID].noBytes);
+    }
+  }
+  _appendHeader(self, "srx_proxy_send_batch_max_packets", "gauge",
+                "Number of packets of the largest batch.");
+  for (clientID = 1; clientID < MAX_PROXY_CLIENT_ELEMENTS; clientID++)
+  {
+    if (found[clientID])
+    {
+      _append(self, "srx_proxy_send_batch_max_packets{client=\"%d\","
+              "proxy=\"%u\"} %u\n", clientID,
+              self->svrConnHandler->proxyMap[clientID].proxyID,
+              stats[clientID].maxPackets);
+    }
+  }
+  _appendHeader(self, "srx_proxy_send_batching", "gauge",
+                "1 if the proxy does not keep up and is served in batches.");
+  for (clientID = 1; clientID < MAX_PROXY_CLIENT_ELEMENTS; clientID++)
+  {
+    if (found[clientID])
+    {
+      _append(self, "srx_proxy_send_batching{client=\"%d\",proxy=\"%u\"} "
+              "%d\n", clientID,
+              self->svrConnHandler->proxyMap[clientID].proxyID,
+              stats[clientID].batching ? 1 : 0);
+    }
+  }
+}
+
+/**
+ * Append the state of the session to each validation cache. The lag is the
+ * number of serials the applied data is behind the last Serial Notify.
+ *
+ * @param self The metrics server.
+ */
+static void _appendRTRMetrics(SRxMetrics* self)
+{
+  RPKIHandler* handler = self->rpkiHandler;
+  RPKICache*   cache;
+  time_t       now     = time(NULL);
+  time_t       lastEoD;
+  uint32_t     serial;
+  int32_t      lag;
+  int          idx;
+
+  _appendHeader(self, "srx_rtr_synchronized", "gauge",
+                "1 if the prefix cache holds the data of the validation "
+                "cache.");
+  for (idx = 0; idx < handler->noCaches; idx++)
+  {
+    cache = &handler->caches[idx];
+    _append(self, "srx_rtr_synchronized{cache=\"%s:%d\"} %d\n",
+            cache->rrclParams.serverHost, cache->rrclParams.serverPort,
+            cache->hasSession ? 1 : 0);
+  }
+  _appendHeader(self, "srx_rtr_serial", "gauge",
+                "Serial of the data applied to the prefix cache.");
+  for (idx = 0; idx < handler->noCaches; idx++)
+  {
+    cache = &handler->caches[idx];
+    _append(self, "srx_rtr_serial{cache=\"%s:%d\"} %u\n",
+            cache->rrclParams.serverHost, cache->rrclParams.serverPort,
+            ntohl(cache->serial));
+  }
+  _appendHeader(self, "srx_rtr_serial_lag", "gauge",
+                "Serials the applied data is behind the last Serial Notify.");
+  for (idx = 0; idx < handler->noCaches; idx++)
+  {
+    cache  = &handler->caches[idx];
+    serial = ntohl(cache->rrclInstance.notifiedSerial);
+    // Serial number arithmetic (RFC 1982), a notify older than the applied
+    // data means no lag.
+    lag = (int32_t)(serial - ntohl(cache->serial));
+    _append(self, "srx_rtr_serial_lag{cache=\"%s:%d\"} %d\n",
+            cache->rrclParams.serverHost, cache->rrclParams.serverPort,
+            lag > 0 ? lag : 0);
+  }
+  _appendHeader(self, "srx_rtr_end_of_data_age_seconds", "gauge",
+                "Seconds since the last End of Data was applied.");
+  for (idx = 0; idx < handler->noCaches; idx++)
+  {
+    cache   = &handler->caches[idx];
+    lastEoD = cache->lastEndOfData;
+    if (lastEoD != 0)
+    {
+      _append(self, "srx_rtr_end_of_data_age_seconds{cache=\"%s:%d\"} %ld\n",
+              cache->rrclParams.serverHost, cache->rrclParams.serverPort,
+              (long)(now - lastEoD));
+    }
+    else
+    {
+      _append(self, "srx_rtr_end_of_data_age_seconds{cache=\"%s:%d\"} NaN\n",
+              cache->rrclParams.serverHost, cache->rrclParams.serverPort);
+    }
+  }
+}
+
+/**
+ * Append the memory allocated by each subsystem.
+ *
+ * @param self The metrics server.
+ */
+static void _appendMemoryMetrics(SRxMetrics* self)
+{
+  MemStats stats[NUM_MEM_TAGS];
+  int      tag;
+
+  for (tag = 0; tag < NUM_MEM_TAGS; tag++)
+  {
+    getMemStats((MemTag)tag, &stats[tag]);
+  }
+  _appendHeader(self, "srx_memory_bytes", "gauge",
+                "Bytes allocated by the subsystem.");
+  for (tag = 0; tag < NUM_MEM_TAGS; tag++)
+  {
+    _append(self, "srx_memory_bytes{subsystem=\"%s\"} %lld\n",
+            memTagToStr((MemTag)tag), (long long)stats[tag].bytes);
+  }
+  _appendHeader(self, "srx_memory_max_bytes", "gauge",
+                "Highest number of bytes allocated by the subsystem.");
+  for (tag = 0; tag < NUM_MEM_TAGS; tag++)
+  {
+    _append(self, "srx_memory_max_bytes{subsystem=\"%s\"} %lld\n",
+            memTagToStr((MemTag)tag), (long long)stats[tag].maxBytes);
+  }
+  _appendHeader(self, "srx_memory_objects", "gauge",
+                "Number of objects allocated by the subsystem.");
+  for (tag = 0; tag < NUM_MEM_TAGS; tag++)
+  {
+    _append(self, "srx_memory_objects{subsystem=\"%s\"} %lld\n",
+            memTagToStr((MemTag)tag), (long long)stats[tag].objects);
+  }
+}
+
+/**
+ * Append the latency summary of each processing stage in seconds.
+ *
+ * @param self The metrics server.
+ * @param snapshot Space for a histogram snapshot.
+ */
+static void _appendStageMetrics(SRxMetrics* self, HistogramSnapshot* snapshot)
+{
+  const char* stage;
+  int         idx;
+  int         qIdx;
+
+  _appendHeader(self, "srx_stage_latency_seconds", "summary",
+                "Latency of the processing stages.");
+  for (idx = 0; idx < NUM_STAGES; idx++)
+  {
+    stage = stageToStr((ServerStage)idx);
+    getStageSnapshot((ServerStage)idx, snapshot);
+    for (qIdx = 0; qIdx < NUM_QUANTILES; qIdx++)
+    {
+      _append(self, "srx_stage_latency_seconds{stage=\"%s\",quantile=\"%.3g\"}"
+              " %.9f\n", stage, _QUANTILES[qIdx] / 1000.0,
+              getHistogramPercentile(snapshot, _QUANTILES[qIdx]) / 1e9);
+    }
+    _append(self, "srx_stage_latency_seconds_sum{stage=\"%s\"} %.9f\n",
+            stage, snapshot->sum / 1e9);
+    _append(self, "srx_stage_latency_seconds_count{stage=\"%s\"} %llu\n",
+            stage, (unsigned long long)snapshot->count);
+  }
+}
+
+/**
+ * Generate the complete metrics into the response buffer.
+ *
+ * @param self The metrics server.
+ * @param snapshot Space for a histogram snapshot.
+ */
+static void _generateMetrics(SRxMetrics* self, HistogramSnapshot* snapshot)
+{
+  self->bufferUsed = 0;
+  self->buffer[0]  = '\0';
+
+  _appendHeader(self, "srx_uptime_seconds", "gauge",
+                "Seconds since the server started.");
+  _append(self, "srx_uptime_seconds %ld\n",
+          (long)(time(NULL) - self->rpkiHandler->started));
+  _appendCacheMetrics(self);
+  _appendQueueMetrics(self);
+  _appendProxyMetrics(self);
+  _appendSendBatchMetrics(self);
+  _appendRTRMetrics(self);
+  _appendMemoryMetrics(self);
+  _appendStageMetrics(self, snapshot);
+}
+
+/**
+ * Write all given data to the socket.
+ *
+ * @param sockFd The socket.
+ * @param data The data.
+ * @param size The number of bytes.
+ *
+ * @return true if all data could be written.
+ */
+static bool _sendAll(int sockFd, const char* data, size_t size)
+{
+  ssize_t sent;
+
+  while (size > 0)
+  {
+    sent = send(sockFd, data, size, MSG_NOSIGNAL);
+    if (sent <= 0)
+    {
+      return false;
+    }
+    data += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+/**
+ * Read the request of the client and send the response.
+ *
+ * @param self The metrics server.
+ * @param clientFd The client socket.
+ * @param snapshot Space for a histogram snapshot.
+ */
+static void _serveClient(SRxMetrics* self, int clientFd,
+                         HistogramSnapshot* snapshot)
+{
+  char           request[METRICS_REQUEST_SIZE];
+  char           header[256];
+  size_t         received = 0;
+  ssize_t        bytes;
+  struct timeval timeout;
+  int            len;
+  bool           found;
+
+  timeout.tv_sec  = METRICS_READ_TIMEOUT;
+  timeout.tv_usec = 0;
+  setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  // Read until the end of the request header, the body is not used.
+  request[0] = '\0';
+  while (   (received < sizeof(request) - 1)
+         && (strstr(request, "\r\n\r\n") == NULL)
+         && (strstr(request, "\n\n") == NULL))
+  {
+    bytes = recv(clientFd, request + received, 
+                 sizeof(request) - 1 - received, 0);
+    if (bytes <= 0)
+    {
+      break;
+    }
+    received += bytes;
+    request[received] = '\0';
+  }
+
+  if (strncmp(request, "GET ", 4) != 0)
+  {
+    len = snprintf(header, sizeof(header), "HTTP/1.0 405 Method Not Allowed\r\n"
+                   "Allow: GET\r\nContent-Length: 0\r\n"
+                   "Connection: close\r\n\r\n");
+    _sendAll(clientFd, header, len);
+    return;
+  }
+  // Serve "/" and "/metrics", a query string is ignored.
+  found =    (strncmp(request + 4, "/metrics", 8) == 0)
+          && ((request[12] == ' ') || (request[12] == '?'));
+  found |=   (request[4] == '/') && (request[5] == ' ');
+  if (!found)
+  {
+    len = snprintf(header, sizeof(header), "HTTP/1.0 404 Not Found\r\n"
+                   "Content-Length: 0\r\nConnection: close\r\n\r\n");
+    _sendAll(clientFd, header, len);
+    return;
+  }
+
+  _generateMetrics(self, snapshot);
+  len = snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\n"
+                 "Content-Type: " METRICS_CONTENT_TYPE "\r\n"
+                 "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+                 self->bufferUsed);
+  if (_sendAll(clientFd, header, len))
+  {
+    _sendAll(clientFd, self->buffer, self->bufferUsed);
+  }
+}
+
+/**
+ * Create the metrics server, bind it to the given port and start its thread.
+ *
+ * @param self The metrics server.
+ * @param port The port to listen on.
+ * @param updCache The update cache.
+ * @param rpkiHandler The RPKI handler.
+ * @param cmdQueue The command queue.
+ * @param svrConnHandler The server connection handler.
+ *
+ * @return true if the metrics server could be started.
+ */
+bool createMetricsServer(SRxMetrics* self, int port, UpdateCache* updCache,
+                         RPKIHandler* rpkiHandler, CommandQueue* cmdQueue,
+                         ServerConnectionHandler* svrConnHandler)
+{
+  struct sockaddr_in srvAddr;
+  int yes = 1;
+
+  memset(self, 0, sizeof(SRxMetrics));
+  self->updCache       = updCache;
+  self->rpkiHandler    = rpkiHandler;
+  self->cmdQueue       = cmdQueue;
+  self->svrConnHandler = svrConnHandler;
+  self->srvSockFd      = -1;
+
+  self->buffer = malloc(METRICS_BUFFER_SIZE);
+  if (self->buffer == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the metrics server!");
+    return false;
+  }
+  self->bufferSize = METRICS_BUFFER_SIZE;
+
+  // Create a TCP socket
+  self->srvSockFd = socket(AF_INET, SOCK_STREAM, 0);
+  if (self->srvSockFd < 0)
+  {
+    RAISE_SYS_ERROR("Failed to open a socket");
+    free(self->buffer);
+    self->buffer = NULL;
+    return false;
+  }
+
+  // Bind to a server-address
+  memset(&srvAddr, 0, sizeof (struct sockaddr_in));
+  srvAddr.sin_family = AF_INET;
+  srvAddr.sin_addr.s_addr = INADDR_ANY;
+  srvAddr.sin_port = htons(port);
+
+  // Allow a restart without having to wait for the socket to be released.
+  setsockopt(self->srvSockFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof (yes));
+
+  if (   (bind(self->srvSockFd, (struct sockaddr*)&srvAddr,
+               sizeof (struct sockaddr_in)) < 0)
+      || (listen(self->srvSockFd, 4) < 0))
+  {
+    RAISE_SYS_ERROR("Failed to bind the metrics socket to port %d", port);
+    close(self->srvSockFd);
+    free(self->buffer);
+    self->buffer = NULL;
+    return false;
+  }
+
+  self->keepGoing = true;
+  if (createThread(&self->thread, NULL, THREAD_CLASS_HOUSEKEEPING,
+                   "srx-metrics", _metricsLoop, (void*)self) != 0)
+  {
+    RAISE_ERROR("Failed to create the metrics thread!");
+    self->keepGoing = false;
+    close(self->srvSockFd);
+    free(self->buffer);
+    self->buffer = NULL;
+    return false;
+  }
+
+  LOG(LEVEL_INFO, "Metrics server on port [%u] created.", port);
+  return true;
+}
+
+/**
+ * Stop the metrics server and release its resources. Can be called more than
+ * once.
+ *
+ * @param self The metrics server.
+ */
+void releaseMetricsServer(SRxMetrics* self)
+{
+  if (self->keepGoing)
+  {
+    // The thread checks the flag at least once per METRICS_ACCEPT_WAIT_MS
+    self->keepGoing = false;
+    pthread_join(self->thread, NULL);
+    close(self->srvSockFd);
+    self->srvSockFd = -1;
+    free(self->buffer);
+    self->buffer = NULL;
+  }
+}
+
+/**
+ * Serve the metrics until the server is released.
+ *
+ * @param selfPtr The pointer to the metrics server.
+ *
+ * @return NULL
+ */
+static void* _metricsLoop(void* selfPtr)
+{
+  SRxMetrics*        self = (SRxMetrics*)selfPtr;
+  HistogramSnapshot* snapshot = malloc(sizeof(HistogramSnapshot));
+  struct pollfd      pfd;
+  int                clientFd;
+
+  LOG (LEVEL_DEBUG, HDR "Metrics Thread started!", pthread_self());
+
+  pfd.fd     = self->srvSockFd;
+  pfd.events = POLLIN;
+  while (self->keepGoing && (snapshot != NULL))
+  {
+    if (poll(&pfd, 1, METRICS_ACCEPT_WAIT_MS) <= 0)
+    {
+      continue;
+    }
+    clientFd = accept(self->srvSockFd, NULL, NULL);
+    if (clientFd < 0)
+    {
+      continue;
+    }
+    _serveClient(self, clientFd, snapshot);
+    close(clientFd);
+  }
+  if (snapshot == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the metrics thread!");
+  }
+  free(snapshot);
+
+  LOG (LEVEL_DEBUG, HDR "Metrics Thread stopped!", pthread_self());
+
+  return NULL;
+}
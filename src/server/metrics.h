@@ -0,0 +1,94 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Serves the metrics of the SRx server in the Prometheus text format via
+ * HTTP. The metrics are read from counters that are maintained without lock,
+ * a scrape does not lock any cache or queue.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "server/command_queue.h"
+#include "server/rpki_handler.h"
+#include "server/server_connection_handler.h"
+#include "server/update_cache.h"
+
+/** Contains the information needed for the metrics server. */
+typedef struct {
+  /** The update cache. */
+  UpdateCache*             updCache;
+  /** The RPKI handler, provides the prefix cache and the RTR sessions. */
+  RPKIHandler*             rpkiHandler;
+  /** The command queue. */
+  CommandQueue*            cmdQueue;
+  /** The connection handler, provides the proxies and the receiver queue. */
+  ServerConnectionHandler* svrConnHandler;
+
+  /** The server socket file descriptor. */
+  int                      srvSockFd;
+  /** The thread serving the requests. */
+  pthread_t                thread;
+  /** Indicates if the server has to keep running. */
+  volatile bool            keepGoing;
+
+  /** The buffer the response is generated in. */
+  char*                    buffer;
+  /** The size of the buffer. */
+  size_t                   bufferSize;
+  /** The number of bytes used in the buffer. */
+  size_t                   bufferUsed;
+} SRxMetrics;
+
+/**
+ * Create the metrics server, bind it to the given port and start its thread.
+ *
+ * @param self The metrics server.
+ * @param port The port to listen on.
+ * @param updCache The update cache.
+ * @param rpkiHandler The RPKI handler.
+ * @param cmdQueue The command queue.
+ * @param svrConnHandler The server connection handler.
+ *
+ * @return true if the metrics server could be started.
+ */
+bool createMetricsServer(SRxMetrics* self, int port, UpdateCache* updCache,
+                         RPKIHandler* rpkiHandler, CommandQueue* cmdQueue,
+                         ServerConnectionHandler* svrConnHandler);
+
+/**
+ * Stop the metrics server and release its resources. Can be called more than
+ * once.
+ *
+ * @param self The metrics server.
+ */
+void releaseMetricsServer(SRxMetrics* self);
+
+#endif // !__METRICS_H__
@@ -0,0 +1,261 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Index of the IPv4 ROA white-list for the origin validation.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#include <stdlib.h>
+#include "server/origin_index.h"
+#include "util/log.h"
+
+/**
+ * Return the network mask of the given prefix length.
+ *
+ * @param len The prefix length.
+ *
+ * @return The mask in host byte order.
+ */
+static inline uint32_t _mask(uint8_t len)
+{
+  return len == 0 ? 0 : 0xFFFFFFFFU << (32 - len);
+}
+
+/**
+ * Create the new content of the slot, the entries of the given prefix are
+ * replaced.
+ *
+ * @param old The current content or NULL.
+ * @param addr The masked prefix address.
+ * @param len The prefix length.
+ * @param roas The new ROAs of the prefix.
+ * @param count The number of ROAs.
+ * @param slot OUT - The new content, NULL if the slot is empty.
+ *
+ * @return false if not enough memory was available.
+ */
+static bool _createSlot(OIV4Slot* old, uint32_t addr, uint8_t len,
+                        OIV4Entry* roas, uint32_t count, OIV4Slot** slot)
+{
+  uint32_t  keep = 0;
+  uint32_t  idx;
+  OIV4Slot* newSlot;
+
+  for (idx = 0; old != NULL && idx < old->count; idx++)
+  {
+    if ((old->entries[idx].addr != addr) || (old->entries[idx].len != len))
+    {
+      keep++;
+    }
+  }
+
+  *slot = NULL;
+  if (keep + count == 0)
+  {
+    return true;
+  }
+
+  newSlot = malloc(sizeof(OIV4Slot) + (keep + count) * sizeof(OIV4Entry));
+  if (newSlot == NULL)
+  {
+    return false;
+  }
+  newSlot->count = 0;
+  for (idx = 0; old != NULL && idx < old->count; idx++)
+  {
+    if ((old->entries[idx].addr != addr) || (old->entries[idx].len != len))
+    {
+      newSlot->entries[newSlot->count++] = old->entries[idx];
+    }
+  }
+  for (idx = 0; idx < count; idx++)
+  {
+    newSlot->entries[newSlot->count].addr    = addr;
+    newSlot->entries[newSlot->count].as      = roas[idx].as;
+    newSlot->entries[newSlot->count].len     = len;
+    newSlot->entries[newSlot->count].max_len = roas[idx].max_len;
+    newSlot->count++;
+  }
+  *slot = newSlot;
+
+  return true;
+}
+
+/**
+ * Initialize the empty index.
+ *
+ * @param self The index.
+ *
+ * @return false if not enough memory was available.
+ */
+bool initOriginIndexV4(OriginIndexV4* self)
+{
+  self->slots    = calloc(ORIGIN_INDEX_V4_SLOTS, sizeof(OIV4Slot*));
+  self->disabled = self->slots == NULL;
+
+  return self->slots != NULL;
+}
+
+/**
+ * Release all slots and the index itself. No reader must access the index.
+ *
+ * @param self The index.
+ */
+void releaseOriginIndexV4(OriginIndexV4* self)
+{
+  if (self->slots != NULL)
+  {
+    clearOriginIndexV4(self);
+    free((void*)self->slots);
+    self->slots = NULL;
+  }
+  self->disabled = true;
+}
+
+/**
+ * Remove all entries and enable a disabled index. No reader must access the
+ * index.
+ *
+ * @param self The index.
+ */
+void clearOriginIndexV4(OriginIndexV4* self)
+{
+  uint32_t idx;
+
+  if (self->slots == NULL)
+  {
+    return;
+  }
+  for (idx = 0; idx < ORIGIN_INDEX_V4_SLOTS; idx++)
+  {
+    free(self->slots[idx]);
+    self->slots[idx] = NULL;
+  }
+  self->disabled = false;
+}
+
+/**
+ * Replace the ROAs of the given prefix with the given ROAs. The caller must
+ * serialize all writers.
+ *
+ * @param self The index.
+ * @param epoch The epoch domain the replaced slot arrays are retired in.
+ * @param addr The prefix address in host byte order.
+ * @param len The prefix length.
+ * @param roas The new ROAs of the prefix, only the AS and max length are used.
+ * @param count The number of ROAs, 0 removes the prefix.
+ *
+ * @return false if not enough memory was available, the index is disabled.
+ */
+bool setOriginIndexV4(OriginIndexV4* self, EpochDomain* epoch, uint32_t addr,
+                      uint8_t len, OIV4Entry* roas, uint32_t count)
+{
+  uint32_t  first;
+  uint32_t  last;
+  uint32_t  idx;
+  OIV4Slot* old;
+  OIV4Slot* slot;
+
+  if (self->disabled)
+  {
+    return false;
+  }
+
+  // A prefix shorter than a slot is copied into all slots it covers.
+  addr  = addr & _mask(len);
+  first = addr >> (32 - ORIGIN_INDEX_V4_BITS);
+  last  = len < ORIGIN_INDEX_V4_BITS
+          ? first + (1U << (ORIGIN_INDEX_V4_BITS - len)) - 1
+          : first;
+
+  for (idx = first; idx <= last; idx++)
+  {
+    old = self->slots[idx];
+    if (!_createSlot(old, addr, len, roas, count, &slot))
+    {
+      RAISE_SYS_ERROR("Not enough memory to update the IPv4 origin index, "
+                      "the index is disabled!");
+      self->disabled = true;
+      return false;
+    }
+    __sync_synchronize();
+    self->slots[idx] = slot;
+    if (old != NULL)
+    {
+      retireEpochData(epoch, old, free);
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Determine the origin validation state of the given prefix and origin AS.
+ * The caller must be within the epoch.
+ *
+ * @param self The index.
+ * @param addr The prefix address in host byte order.
+ * @param len The prefix length.
+ * @param as The origin AS.
+ * @param result OUT - The validation state.
+ *
+ * @return false if the index is disabled.
+ */
+bool lookupOriginIndexV4(OriginIndexV4* self, uint32_t addr, uint8_t len,
+                         uint32_t as, SRxValidationResultVal* result)
+{
+  OIV4Slot*  slot;
+  OIV4Entry* entry;
+  uint32_t   idx;
+
+  if (self->disabled)
+  {
+    return false;
+  }
+
+  // Each ROA covering a prefix shorter than a slot is in all of its slots.
+  *result = SRx_RESULT_NOTFOUND;
+  slot    = self->slots[addr >> (32 - ORIGIN_INDEX_V4_BITS)];
+  for (idx = 0; slot != NULL && idx < slot->count; idx++)
+  {
+    entry = &slot->entries[idx];
+    if (   (entry->len > len)
+        || (((addr ^ entry->addr) & _mask(entry->len)) != 0))
+    {
+      continue;
+    }
+    // Any covering ROA makes the update at least invalid.
+    *result = SRx_RESULT_INVALID;
+    if ((entry->as == as) && (len <= entry->max_len))
+    {
+      *result = SRx_RESULT_VALID;
+      break;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,138 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Index of the IPv4 ROA white-list for the origin validation without walking
+ * the prefix tree. The address space is split into 2^16 slots of /16 each.
+ * Each slot references an immutable array of all ROAs whose prefix overlaps
+ * the slot: the ROAs of shorter prefixes are copied into each slot they cover,
+ * the ROAs of longer prefixes are stored in the one slot they are located in.
+ * A lookup reads a single slot.
+ *
+ * The index is maintained by the holder of the prefix cache's tree lock, the
+ * replaced slot arrays are retired into the prefix cache's epoch domain.
+ * Readers must be within that epoch.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __ORIGIN_INDEX_H__
+#define __ORIGIN_INDEX_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "shared/srx_defs.h"
+#include "util/epoch.h"
+
+/** The number of address bits selecting the slot. */
+#define ORIGIN_INDEX_V4_BITS  16
+/** The number of slots. */
+#define ORIGIN_INDEX_V4_SLOTS (1 << ORIGIN_INDEX_V4_BITS)
+
+/** A single ROA within a slot. */
+typedef struct {
+  /** The prefix address in host byte order. */
+  uint32_t addr;
+  /** The origin AS of the ROA. */
+  uint32_t as;
+  /** The prefix length. */
+  uint8_t  len;
+  /** The max length of the ROA. */
+  uint8_t  max_len;
+} OIV4Entry;
+
+/** The immutable content of a slot. */
+typedef struct {
+  /** The number of entries. */
+  uint32_t  count;
+  /** The entries. */
+  OIV4Entry entries[];
+} OIV4Slot;
+
+/** The IPv4 origin index. */
+typedef struct {
+  /** The slots, NULL if no ROA overlaps the slot. */
+  OIV4Slot* volatile * slots;
+  /** Set if a change could not be applied, lookups are not answered until
+   * the index is cleared. */
+  volatile bool        disabled;
+} OriginIndexV4;
+
+/**
+ * Initialize the empty index.
+ *
+ * @param self The index.
+ *
+ * @return false if not enough memory was available.
+ */
+bool initOriginIndexV4(OriginIndexV4* self);
+
+/**
+ * Release all slots and the index itself. No reader must access the index.
+ *
+ * @param self The index.
+ */
+void releaseOriginIndexV4(OriginIndexV4* self);
+
+/**
+ * Remove all entries and enable a disabled index. No reader must access the
+ * index.
+ *
+ * @param self The index.
+ */
+void clearOriginIndexV4(OriginIndexV4* self);
+
+/**
+ * Replace the ROAs of the given prefix with the given ROAs. The caller must
+ * serialize all writers.
+ *
+ * @param self The index.
+ * @param epoch The epoch domain the replaced slot arrays are retired in.
+ * @param addr The prefix address in host byte order.
+ * @param len The prefix length.
+ * @param roas The new ROAs of the prefix, only the AS and max length are used.
+ * @param count The number of ROAs, 0 removes the prefix.
+ *
+ * @return false if not enough memory was available, the index is disabled.
+ */
+bool setOriginIndexV4(OriginIndexV4* self, EpochDomain* epoch, uint32_t addr,
+                      uint8_t len, OIV4Entry* roas, uint32_t count);
+
+/**
+ * Determine the origin validation state of the given prefix and origin AS.
+ * The caller must be within the epoch.
+ *
+ * @param self The index.
+ * @param addr The prefix address in host byte order.
+ * @param len The prefix length.
+ * @param as The origin AS.
+ * @param result OUT - The validation state.
+ *
+ * @return false if the index is disabled.
+ */
+bool lookupOriginIndexV4(OriginIndexV4* self, uint32_t addr, uint8_t len,
+                         uint32_t as, SRxValidationResultVal* result);
+
+#endif // !__ORIGIN_INDEX_H__
@@ -29,10 +29,65 @@
  *  - getOriginStatus: Triggered by the SRx - Router - proxy for each
  *                     validation request.
  * 
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Enabled the tree lock. requestUpdateValidation keeps the write
+ *              lock for the complete validation. Fixed two missing unlocks in
+ *              addROAwl and delROAwl.
+ *            * Replaced the per prefix and per AS SLists with arrays. The AS
+ *              array is sorted and searched using binary search, the ROA 
+ *              array is sorted by max length.
+ *            * requestUpdateValidation determines the result without lock 
+ *              using the ROA sets published per prefix. Tree nodes and ROA
+ *              sets are protected by an epoch domain. The update is
+ *              registered in the tree by the next holder of the tree lock.
+ *            * Implemented removeUpdate. Removed updates undo their AS and
+ *              ROA counters, prefixes without ASes left get retired.
+ *            * Added exportROAwl.
+ *            * Added the ROA index of each validation cache. flagAllROAwl and
+ *              cleanAllROAwl only visit the ROAs of the given validation 
+ *              cache.
+ *            * The AS and ROA arrays are allocated from the array pool, added
+ *              getPrefixCacheMemory.
+ *            * Lookups use static patricia prefixes, the tree copies a prefix
+ *              only when it is inserted. delROAwl does not insert prefixes.
+ *          - 2026/10/15 - kyehwanl
+ *            * Count the VRPs while adding and removing ROA white-list 
+ *              entries, added getNumberOfVRPs and getNumberOfPrefixes.
+ *            * Added dumpPrefixCache, writes JSON lines in chunks without 
+ *              holding the tree lock.
+ *            * IPv4 updates are validated without lock using the IPv4 origin
+ *              index instead of walking up the prefix tree.
+ *            * Match ROA sets and update arrays against an AS number in one
+ *              sweep over packed arrays.
+ *            * The update list links the records intrusively, removing an
+ *              update unlinks it directly. The children of a prefix are 
+ *              gathered in a vector.
+ *            * Reserve the AS and ROA arrays and size the ROA index using the
+ *              expected numbers of prefixes and ROAs.
+ *            * Added the shared ROA table. The white-list is published into
+ *              the table, or updates are validated using an attached table
+ *              instead of the own white-list.
+ *            * Adding and removing a ROA walks the covered subtree in place
+ *              with an explicit stack, added _walkPrefixes.
+ *            * Each prefix links the nearest less specific prefix with ROAs,
+ *              the coverage of updates follows these links instead of
+ *              walking up the tree.
+ *            * The prefixes and their arrays are allocated from the arena of
+ *              the cache. emptyCache and releasePrefixCache drop the tree and
+ *              its arena as a whole, emptyCache swaps in a new generation and
+ *              drops the old one after giving up the locks.
+ *            * Name the locks for the lock statistics.
+ *            * Account the arena under MEM_TAG_PREFIXES.
+ *            * Added validateProvisionalUpdates, validates the updates
+ *              received before the first validation cache was synchronized.
+ *            * Added requestUpdateValidationV4, IPv4 updates are converted
+ *              into the tree prefix without going through the IPPrefix.
+ *            * Registering an update a second time does not add its id to
+ *              the shared ids again.
  * 0.3.0.10 - 2015/11/10 - oborchert
  *            * Moved outputPrefixCacheAsXML from c file to header.
  * 0.3.0    - 2013/03/20 - oborchert
@@ -53,6 +108,7 @@
  * -----------------------------------------------------------------------------
  */
 
+#include <arpa/inet.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -60,11 +116,22 @@
 #include "server/prefix_cache.h"
 #include "shared/srx_defs.h"
 #include "util/log.h"
+#include "util/json_out.h"
+#include "util/lock_stats.h"
 #include "util/math.h"
+#include "util/vector.h"
 #include "util/xml_out.h"
 
 #define  HDR "[PrefixCache [0x%08X]]: "
 
+/** The slab size of the pools of the arena. */
+#define PC_POOL_SLAB_SIZE 65536
+/** The number of removals a batch can have without allocating memory. */
+#define PC_LOCAL_REMOVALS 32
+/** The stack size of the subtree walk. Each level of the tree leaves at most
+ * one sibling on the stack, an IPv6 tree has at most 129 levels. */
+#define PC_WALK_STACK_SIZE 256
+
 /*-----------------------------
  * R/W lock and mutex debugging
  */
@@ -99,8 +166,9 @@
   #define CHANGE_WRITE_LOCK_COUNT(OP)
 #endif
 
-// Enable mutexes and locking
-#if 0
+// Enable mutexes and locking. Required since multiple command handler threads
+// can access the cache at the same time.
+#if 1
   #define READ_LOCK(VAR) \
     CHANGE_READ_LOCK_COUNT(+);        \
     PRINT_LINE_VAR("Read lock", VAR); \
@@ -151,8 +219,67 @@
   #define UNLOCK_MUTEX(VAR)
 #endif
 
+/**
+ * Create a new arena. The prefixes and arrays of the expected numbers of
+ * prefixes and ROAs are reserved, the first full load of the validation caches
+ * then does not allocate slabs.
+ *
+ * @param sysConfig The system configuration or NULL.
+ *
+ * @return The arena or NULL if not enough memory is available.
+ *
+ * @since 0.4.1.0
+ */
+static PC_Arena* _createArena(Configuration* sysConfig)
+{
+  PC_Arena* arena = malloc(sizeof(PC_Arena));
+
+  if (arena == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the prefix cache arena!");
+    return NULL;
+  }
+  initMemPool(&arena->prefixPool, sizeof(PC_Prefix),
+              PC_POOL_SLAB_SIZE / sizeof(PC_Prefix));
+  initSizeClassPool(&arena->arrayPool, PC_POOL_SLAB_SIZE);
+  setMemPoolTag(&arena->prefixPool, MEM_TAG_PREFIXES);
+  setSizeClassPoolTag(&arena->arrayPool, MEM_TAG_PREFIXES);
+
+  if (   (sysConfig != NULL)
+      && (   !reserveMemPool(&arena->prefixPool, sysConfig->expectedPrefixes)
+          || !reserveSizeClassPool(&arena->arrayPool,
+                                   PC_INITIAL_ARRAY_SIZE * sizeof(PC_AS),
+                                   sysConfig->expectedPrefixes)
+          || !reserveSizeClassPool(&arena->arrayPool,
+                                   PC_INITIAL_ARRAY_SIZE * sizeof(PC_ROA),
+                                   sysConfig->expectedROAs)))
+  {
+    LOG(LEVEL_WARNING, "Could not pre-allocate memory for %u prefixes and "
+                       "%u ROAs!", sysConfig->expectedPrefixes,
+                       sysConfig->expectedROAs);
+  }
+
+  return arena;
+}
+
+/**
+ * Release the arena with all prefixes and arrays allocated from it.
+ *
+ * @param arena The arena.
+ *
+ * @since 0.4.1.0
+ */
+static void _releaseArena(PC_Arena* arena)
+{
+  releaseMemPool(&arena->prefixPool);
+  releaseSizeClassPool(&arena->arrayPool);
+  free(arena);
+}
+
 /**
  * Initializes an empty cache and creates a link to an existing Update Cache.
+ * The expected numbers of prefixes and ROAs of the update cache's system 
+ * configuration are used to reserve memory.
  *
  * @param self the Instance of prefix cache that should be initialized.
  * @param updateCache Instance of the Update Cache that should be notified
@@ -161,11 +288,21 @@
  */
 bool initializePrefixCache(PrefixCache* self, UpdateCache* updateCache)
 {
+  Configuration* sysConfig = updateCache != NULL ? updateCache->sysConfig
+                                                  : NULL;
+
+  self->arena = _createArena(sysConfig);
+  if (self->arena == NULL)
+  {
+    return false;
+  }
+  
   // Create the patricia prefix tree
   self->prefixTree = New_Patricia(PATRICIA_MAXBITS); // 128 = IPv6
   if (self->prefixTree == NULL)
   {
     RAISE_ERROR("Failed to initialize the prefix tree");
+    _releaseArena(self->arena);
     return false;
   }
  
@@ -174,6 +311,7 @@ bool initializePrefixCache(PrefixCache* self, UpdateCache* updateCache)
   {
     RAISE_ERROR("Failed to initialize the updates mutex");
     Destroy_Patricia(self->prefixTree, NULL);
+    _releaseArena(self->arena);
     return false;
   }
   int step = 0;
@@ -202,381 +340,1801 @@ bool initializePrefixCache(PrefixCache* self, UpdateCache* updateCache)
       case 2:  releaseRWLock(&self->asLock);
       case 1:  releaseRWLock(&self->treeLock);
       default: Destroy_Patricia(self->prefixTree, NULL);
+               _releaseArena(self->arena);
                return false;
     }
   }
+  setLockName(&self->updatesMutex, "prefixCache.updatesMutex");
+  setLockName(&self->treeLock,     "prefixCache.treeLock");
+  setLockName(&self->asLock,       "prefixCache.asLock");
+  setLockName(&self->validLock,    "prefixCache.validLock");
+  setLockName(&self->otherLock,    "prefixCache.otherLock");
 
   // Misc.
   self->updateCache = updateCache;
-  initSList(&self->updates);
+  initDList(&self->updates);
+  self->inBatch = false;
+  memset(&self->batchUpdates, 0, sizeof(PC_UpdateArray));
+  initEpochDomain(&self->epoch);
+  self->readersBlocked = false;
+  self->pendingUpdates = NULL;
+  self->valCaches      = NULL;
+  self->noVRPs         = 0;
+  self->sharedROAs     = NULL;
+  self->roaGeneration  = 0;
+  self->sharedGeneration = 0;
+  
+  // Size the ROA index for the expected ROAs.
+  self->roaIndexCapacity = PC_INITIAL_ARRAY_SIZE;
+  if (sysConfig != NULL)
+  {
+    self->roaIndexCapacity = MAX(self->roaIndexCapacity, 
+                                 MIN(sysConfig->expectedROAs, 
+                                     PC_MAX_CACHE_ROAS));
+  }
+  if (!initOriginIndexV4(&self->originIndexV4))
+  {
+    // Not fatal, the lookups walk the prefix tree instead.
+    RAISE_SYS_ERROR("Not enough memory for the IPv4 origin index!");
+  }
   return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// ARRAY HELPERS
+////////////////////////////////////////////////////////////////////////////////
+
 /**
- * This method only frees up the memory attached. No update counter or other
- * maintenance values are maintained here. This method should not be
- * called for other than a clean emptying of the cache.
- * 
- * @param prefix the particular pc prefix to be released.
+ * Allocate an array from the given pool or from the heap.
+ *
+ * @param pool The pool or NULL to use the heap.
+ * @param size The size in bytes.
+ *
+ * @return The array or NULL if not enough memory is available.
+ *
+ * @since 0.4.1.0
  */
-static void releasePrefix(PC_Prefix* prefix)
+static void* _allocArray(SizeClassPool* pool, size_t size)
 {
-  SListNode* asListNode;
-  SListNode* roaListNode;
-  PC_AS*  asNumber;
-  PC_ROA* roa;
-  
-  releaseSList(&prefix->valid);
-  releaseSList(&prefix->other);
-  
-  // All ases
-  FOREACH_SLIST(&prefix->asn, asListNode)
+  return pool != NULL ? allocFromSizeClassPool(pool, size) : malloc(size);
+}
+
+/**
+ * Free an array allocated with _allocArray.
+ *
+ * @param pool The pool the array is allocated from or NULL.
+ * @param array The array, may be NULL.
+ * @param size The size the array was allocated with.
+ *
+ * @since 0.4.1.0
+ */
+static void _freeArray(SizeClassPool* pool, void* array, size_t size)
+{
+  if (pool != NULL)
   {
-    asNumber = (PC_AS*)asListNode->data;
-    if (asNumber != NULL)
-    {      
-      FOREACH_SLIST(&asNumber->roas, roaListNode)
-      {
-        roa = (PC_ROA*)roaListNode->data;
-        if (roa != NULL)
-        {
-          free(roa);
-          roa = NULL;
-        }
-      }
-      releaseSList(&asNumber->roas);
-      free(asNumber);
-      asNumber = NULL;
-    }
+    freeToSizeClassPool(pool, array, size);
+  }
+  else
+  {
+    free(array);
   }
-  releaseSList(&prefix->asn);  
-  free(prefix);
 }
 
 /**
- * Frees all allocated resources. the prefix cache itself must be freed outside.
+ * Adds the update to the given update array. The array grows if needed.
+ * 
+ * @param pool The pool the array is allocated from or NULL for the heap.
+ * @param array The update array
+ * @param pcUpdate The update to be added
+ * 
+ * @return false if the array could not be extended.
+ * 
+ * @since 0.4.1.0
  */
-void releasePrefixCache(PrefixCache* self)
+static bool _addToUpdateArray(SizeClassPool* pool, PC_UpdateArray* array,
+                              PC_Update* pcUpdate)
 {
-  if (self != NULL) 
+  if (array->size == array->capacity)
   {
-    patricia_node_t*  treeNode;
-    SListNode*        listNode;
-    PC_Prefix*        prefix;
-    PC_Update*        pc_update;
-    
-    // Free all prefixes and node-data
-    WRITE_LOCK(&self->asLock);
-    WRITE_LOCK(&self->validLock);
-    WRITE_LOCK(&self->otherLock);
+    uint32_t    newCapacity = array->capacity == 0 ? PC_INITIAL_ARRAY_SIZE 
+                                                   : array->capacity * 2;
+    PC_Update** updates = _allocArray(pool, newCapacity * sizeof(PC_Update*));
+    uint32_t*   asns    = _allocArray(pool, newCapacity * sizeof(uint32_t));
 
-    PATRICIA_WALK(self->prefixTree->head, treeNode)
+    // Both arrays grow together, the capacity is valid for both of them.
+    if ((updates == NULL) || (asns == NULL))
     {
-      prefix = PATRICIA_DATA_GET(treeNode, PC_Prefix);            
-      releasePrefix(prefix);
-    } PATRICIA_WALK_END;
-    RAISE_ERROR("Check if the treeNode has to be released independent or if it gets released with the Destroy_Patricia!");
-    Destroy_Patricia(self->prefixTree, NULL);
-    // test if the DestroyPatricia deleted everything!
-    free(treeNode);        //           <<<<<<<------ Hopefully this causes a sigdev
-    // end of test. If it was freed before this should cause a SIGDEV!!!! (I HOPE SO)
-    
-    
-    releaseRWLock(&self->otherLock);
-    releaseRWLock(&self->validLock);
-    releaseRWLock(&self->asLock);
-    releaseRWLock(&self->treeLock);
-
-    // Free all updates
-    LOCK_MUTEX(&self->updatesMutex);
-    FOREACH_SLIST(&self->updates, listNode)
+      _freeArray(pool, updates, newCapacity * sizeof(PC_Update*));
+      _freeArray(pool, asns, newCapacity * sizeof(uint32_t));
+      return false;
+    }
+    if (array->size > 0)
     {
-      pc_update = (PC_Update*)getDataOfSListNode(listNode);
-      free(pc_update);
+      memcpy(updates, array->updates, array->size * sizeof(PC_Update*));
+      memcpy(asns, array->asns, array->size * sizeof(uint32_t));
     }
-    releaseSList(&self->updates);
-    releaseMutex(&self->updatesMutex);
+    _freeArray(pool, array->updates, array->capacity * sizeof(PC_Update*));
+    _freeArray(pool, array->asns, array->capacity * sizeof(uint32_t));
+    array->updates  = updates;
+    array->asns     = asns;
+    array->capacity = newCapacity;
   }
+  array->asns[array->size]      = pcUpdate->as;
+  array->updates[array->size++] = pcUpdate;
+  
+  return true;
 }
 
 /**
- * Empty the complete update cache. This method empties the prefix tree and the 
- * all Updates.
+ * Removes the update from the given update array. The last update of the array
+ * takes the position of the removed one.
  * 
- * @param self The update cache to be emptied!
+ * @param array The update array
+ * @param pcUpdate The update to be removed
+ * 
+ * @return false if the update was not found.
+ * 
+ * @since 0.4.1.0
  */
-void emptyCache(PrefixCache* self)
+static bool _removeFromUpdateArray(PC_UpdateArray* array, PC_Update* pcUpdate)
 {
-  //TODO: Implement for version 0.3.x
-#ifndef SRX_ALL
-  RAISE_ERROR("NOT IMPLEMENTED YET, PLANNED FOR PROTOTYPE 0.3.x");
-#else
-  if (self != NULL) 
+  uint32_t idx;
+  
+  for (idx = 0; idx < array->size; idx++)
   {
-    patricia_node_t*  treeNode;
-    SListNode*        listNode;
-    PC_Prefix*        prefix;
-    PC_AS*            pc_as;
-    PC_ROA*           pc_roa;
-    PC_Update*        pc_update;
-    
-    // Free all prefixes and node-data
-    WRITE_LOCK(&self->asLock);
-    WRITE_LOCK(&self->validLock);
-    WRITE_LOCK(&self->otherLock);
-
-    PATRICIA_WALK(self->prefixTree->head, treeNode)
+    if (array->updates[idx] == pcUpdate)
     {
-      prefix = (PC_Prefix*)treeNode->data;
-      if (prefix != NULL)
-      {
-        releasePrefix(prefix);
-      }
-      treeNode->data = NULL;
-    } PATRICIA_WALK_END;    
-    Clear_Patricia(self->prefixTree, NULL);
-    
-    // Free all updates
-    LOCK_MUTEX(&self->updatesMutex);
-    FOREACH_SLIST(&self->updates, listNode)
-    {      
-      pc_update = (PC_Update*)listNode->data;
-      if (pc_update != NULL)
-      {
-        free(pc_update);
-      }
+      array->size--;
+      array->updates[idx] = array->updates[array->size];
+      array->asns[idx]    = array->asns[array->size];
+      return true;
     }
-    emptySList(&self->updates);
-    UNLOCK_MUTEX(&self->updatesMutex);
-    
-    UNLOCK_WRITE_LOCK(&self->asLock);
-    UNLOCK_WRITE_LOCK(&self->validLock);
-    UNLOCK_WRITE_LOCK(&self->otherLock);
-  }  
-#endif
+  }
+  
+  return false;
 }
 
 /**
- * This method returns the parent prefix or NULL if no more parent is available.
- * The parent prefix is NOT the patricia tree parent, it is the next available
- * stored prefix within the tree.
+ * Release the memory of the update array, the updates are not freed.
  * 
- * @param prefix The patricia tree node whose parent has to be examined for an 
- *               SRx prefix.
+ * @param pool The pool the array is allocated from or NULL for the heap.
+ * @param array The update array
  * 
- * @return The parent prefix if it exists or NULL.
+ * @since 0.4.1.0
  */
-PC_Prefix* getParent(patricia_node_t* node)
-{  
-  PC_Prefix* retVal = NULL;
-  if (node != NULL)
-  {
-    if (node->parent != NULL)
-    {
-      node = node->parent;
-      // Patricia parent found, does it contain a PC_Prefix?
-      retVal = node->data != NULL ? (PC_Prefix*)node->data : getParent(node);
-    }      
-  }
-  // No further parent Found
-  return retVal;
+static void _releaseUpdateArray(SizeClassPool* pool, PC_UpdateArray* array)
+{
+  _freeArray(pool, array->updates, array->capacity * sizeof(PC_Update*));
+  _freeArray(pool, array->asns, array->capacity * sizeof(uint32_t));
+  memset(array, 0, sizeof(PC_UpdateArray));
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// FOREWARD DECLARATIONS
-////////////////////////////////////////////////////////////////////////////////
-static prefix_t* ipPrefixToPrefix_t(IPPrefix* from);
-static void notifyUpdateCacheForROAChange(UpdateCache* updCache, 
-                    SRxUpdateID* updateID, SRxValidationResultVal newROAResult);
-static void _ROAwl_changeStateOfOther(UpdateCache* updateCache, 
-                                      PC_Prefix* pcPrefix, 
-                                      SRxValidationResultVal newState);
-static void printXML(PrefixCache* self, char* methodName);
-
 /**
- * Returns the requested AS attached to the given prefix. In case the AS does 
- * not exist, a new one is created and added.
+ * Return the position of the first update starting at the given position that
+ * is announced by the given AS. The packed AS numbers are compared in blocks
+ * without an early exit, which allows the compiler to vectorize the compare.
  * 
- * @param pcPrefix The prefix cache prefix instance.
- * @param as The as number of the prefix.
+ * @param array The update array
+ * @param from The position to start at.
+ * @param as The origin AS.
  * 
- * @return The prefix cache AS or NULL in case a fatal internal error occurred.
+ * @return The position or the size of the array if no update is found.
+ * 
+ * @since 0.4.1.0
  */
-static PC_AS* getASFromPrefix(PC_Prefix* pcPrefix, uint32_t as)
+static uint32_t _findUpdateAS(PC_UpdateArray* array, uint32_t from, 
+                              uint32_t as)
 {
-  PC_AS* pcAS = NULL;
-  int idx;
+  uint32_t hits;
+  uint32_t bit;
   
-  // Go through the list until the as number is found.
-  for (idx = 0; idx < pcPrefix->asn.size; idx++)
+  for (; from + PC_MATCH_BLOCK <= array->size; from += PC_MATCH_BLOCK)
   {
-    pcAS = (PC_AS*)getFromSList(&pcPrefix->asn, idx);
-    if (pcAS->asn == as)
+    hits = 0;
+    for (bit = 0; bit < PC_MATCH_BLOCK; bit++)
     {
-      break;
+      hits |= (uint32_t)(array->asns[from + bit] == as) << bit;
     }
-    else
+    if (hits != 0)
     {
-      pcAS = NULL;
+      return from + __builtin_ctz(hits);
     }
   }
-  
-  // If the AS is not found, create one.
-  if (pcAS == NULL)
+  for (; from < array->size; from++)
   {
-    pcAS = malloc(sizeof(PC_AS));
-    if (appendDataToSList(&pcPrefix->asn, pcAS))
-    {
-      pcAS->asn          = as;
-      pcAS->update_count = 0;
-      initSList(&pcAS->roas);      
-    }
-    else
+    if (array->asns[from] == as)
     {
-      RAISE_SYS_ERROR( HDR "Could not add AS%u to the prefix tree!",
-                       pthread_self(), as);
-      free(pcAS);
-      pcAS = NULL;
+      break;
     }
   }
-  return pcAS;
+  
+  return from;
 }
 
 /**
- * Return all direct children in the trie one level down that contain a 
- * PC_Prefix. The children are NOT the prefix tree nodes. The children are the 
- * PC_Prefix nodes attached to the data elements. Once a child is found NO 
- * grandchild is searched for.
+ * Determine if any ROA of the set matches the given origin AS and prefix 
+ * length. All ROAs are compared in one sweep over the packed arrays.
  * 
- * @param children The list where all children will be stored in. The stored 
- *                 children are of type PC_Prefix*
- * @param node the patricia node whose PC_Prefix children will be searched for.
+ * @param roaSet The ROA set.
+ * @param as The origin AS.
+ * @param bitlen The prefix length.
  * 
- * @return true if any children could be found.
+ * @return true if the set contains a matching ROA.
+ * 
+ * @since 0.4.1.0
  */
-static bool getChildren(SList* children, patricia_node_t* node)
+static bool _matchROASet(PC_ROASet* roaSet, uint32_t as, uint8_t bitlen)
 {
-  if (node->l != NULL)
+  uint32_t match = 0;
+  uint32_t idx;
+  
+  for (idx = 0; idx < roaSet->count; idx++)
   {
-    if (node->l->data != NULL)
-    {
-      if (!appendDataToSList(children, node->l->data))
-      {
-        RAISE_SYS_ERROR("Could not gather prefix children. Memory Problems, "
-                        "Not all children could be added!");
-        emptySList(children);
-      }
-    }
-    else
+    match |= (roaSet->as[idx] == as) & (bitlen <= roaSet->max_len[idx]);
+  }
+  
+  return match != 0;
+}
+
+/**
+ * Adds the update id to the ids sharing the update record. The array grows if
+ * needed. An id the record already contains is not added again, an update
+ * might be registered a second time, e.g. by validateProvisionalUpdates.
+ * 
+ * @param pcUpdate The update record
+ * @param updateID The id of the update
+ * 
+ * @return false if the array could not be extended.
+ * 
+ * @since 0.4.1.0
+ */
+static bool _addSharedID(PC_Update* pcUpdate, SRxUpdateID updateID)
+{
+  uint32_t idx;
+
+  if (pcUpdate->updateID == updateID)
+  {
+    return true;
+  }
+  for (idx = 0; idx < pcUpdate->noSharedIDs; idx++)
+  {
+    if (pcUpdate->sharedIDs[idx] == updateID)
     {
-      getChildren(children, node->l); 
+      return true;
     }
   }
-  if (node->r != NULL)
+
+  if (pcUpdate->noSharedIDs == pcUpdate->sharedCapacity)
   {
-    if (node->r->data != NULL)
+    uint32_t     newCapacity = pcUpdate->sharedCapacity == 0 
+                               ? PC_INITIAL_ARRAY_SIZE 
+                               : pcUpdate->sharedCapacity * 2;
+    SRxUpdateID* ids = realloc(pcUpdate->sharedIDs, 
+                               newCapacity * sizeof(SRxUpdateID));
+    if (ids == NULL)
     {
-      if (!appendDataToSList(children, node->r->data))
-      {
-        RAISE_SYS_ERROR("Could not gather prefix children. Memory Problems, "
-                        "Not all children could be added!");
-        emptySList(children);
-      }
+      return false;
     }
-    else
-    {
-      getChildren(children, node->r); 
-    }    
+    pcUpdate->sharedIDs      = ids;
+    pcUpdate->sharedCapacity = newCapacity;
   }
-  return children->size > 0;
+  pcUpdate->sharedIDs[pcUpdate->noSharedIDs++] = updateID;
+  
+  return true;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// Request Validation
-////////////////////////////////////////////////////////////////////////////////
-
-static bool _performUpdateValidationNewPrefix(PrefixCache* self, 
-                                              PC_Update* update, uint32_t as);
-static bool _performUpdateValidationKnownPrefix(PrefixCache* self, 
-                                                PC_Update* update, uint32_t as, 
-                                                bool isNew);
-
 /**
- * Request the validation for an update received. During the process of 
- * validating of adding the update it will be added to the cache, the validation 
- * is done by using the data within the prefix cache. Each update MUST be added
- *  only once! Once added, changes of the validation state are signaled to the 
- * update cache and with this to the registered clients.
+ * Removes the update id from the ids of the update record. In case the id the
+ * record was created for is removed, the last shared id takes its place. The 
+ * last id of a record can not be removed.
  * 
- * @param self The prefix cache
- * @param updateID the id of the update itself
- * @param prefix The prefix of the update
- * @param as The AS number of the update
+ * @param pcUpdate The update record
+ * @param updateID The id of the update
  * 
- * @return false indicates an error, most likely memory related! (fatal)
+ * @return false if the id was not found or is the last id of the record.
+ * 
+ * @since 0.4.1.0
  */
-bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID, 
-                             IPPrefix* prefix, uint32_t as)
+static bool _removeSharedID(PC_Update* pcUpdate, SRxUpdateID updateID)
 {
-  // the node within the prefix tree. the data of it is the PC_prefix 
-  // information.
-  patricia_node_t* treeNode = NULL;
-  // the prefix in patricia tree notation. It is needed to find the pc_prefix 
-  prefix_t*        lookupPrefix = ipPrefixToPrefix_t(prefix);
-  // This is the prefix the algorithm runs on.
-  PC_Prefix*       pcPrefix = NULL;
-  // The update itself
-  PC_Update*       pcUpdate = malloc(sizeof(PC_Update));
-  // The AS instance
-  PC_AS*           pcAS = NULL;
-  // The update id. I know it is so=illy but the structure might change.
-  SRxUpdateID      updID = *updateID;
+  uint32_t idx;
   
-  WRITE_LOCK(&self->treeLock);
- 
-  pcUpdate->roa_match = 0;
-  pcUpdate->updateID  = updID;
-  pcUpdate->as = as;
-  if (!appendDataToSList(&self->updates, pcUpdate))
+  if (pcUpdate->noSharedIDs == 0)
   {
-    RAISE_SYS_ERROR( HDR "Could not add update [0x%08X] to prefix cache!",
-                     pthread_self(), updID);
-    free(pcUpdate);
-    free(lookupPrefix);
-    UNLOCK_WRITE_LOCK(&self->treeLock);
     return false;
   }
-  
-  // Create or get the existing prefix node
-  // Return the prefix tree element for the prefix in question. This lookup will
-  // insert the requested prefix in the tree if it doesn't exist already.
-  // Therefore the result value equals NULL can be interpreted as an internal
-  // ERROR.
-  treeNode = patricia_lookup(self->prefixTree, lookupPrefix);
-  if (treeNode == NULL)
+  if (pcUpdate->updateID == updateID)
   {
-    RAISE_ERROR("Failed to append a prefix to the prefix tree");
-    deleteFromSList(&self->updates, pcUpdate);
-    free(pcUpdate);
-    free(lookupPrefix);    
-    UNLOCK_WRITE_LOCK(&self->treeLock);
-    return false;
+    pcUpdate->updateID = pcUpdate->sharedIDs[--pcUpdate->noSharedIDs];
+    return true;
   }
-  else
+  for (idx = 0; idx < pcUpdate->noSharedIDs; idx++)
   {
-    pcUpdate->treeNode = treeNode;
+    if (pcUpdate->sharedIDs[idx] == updateID)
+    {
+      pcUpdate->sharedIDs[idx] = pcUpdate->sharedIDs[--pcUpdate->noSharedIDs];
+      return true;
+    }
   }
   
-// Maybe keep the write lock!
-  WRITE_TO_READ_LOCK(&self->treeLock);
+  return false;
+}
+
+/**
+ * Frees the update record including its shared ids.
+ * 
+ * @param pcUpdate The update record.
+ * 
+ * @since 0.4.1.0
+ */
+static void _freeUpdateRecord(PC_Update* pcUpdate)
+{
+  free(pcUpdate->sharedIDs);
+  free(pcUpdate);
+}
+
+/**
+ * Search the sorted AS array of the prefix for the given AS number.
+ * 
+ * @param pcPrefix The prefix cache prefix
+ * @param as The AS number
+ * @param pos OUT - The position of the AS or the position where it has to be
+ *            inserted. Can be NULL.
+ * 
+ * @return The AS or NULL if not found.
+ * 
+ * @since 0.4.1.0
+ */
+static PC_AS* _findAS(PC_Prefix* pcPrefix, uint32_t as, uint32_t* pos)
+{
+  uint32_t low  = 0;
+  uint32_t high = pcPrefix->asnCount;
+  uint32_t mid;
+  
+  while (low < high)
+  {
+    mid = low + ((high - low) / 2);
+    if (pcPrefix->asn[mid].asn < as)
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid;
+    }
+  }
+  
+  if (pos != NULL)
+  {
+    *pos = low;
+  }
+  
+  return ((low < pcPrefix->asnCount) && (pcPrefix->asn[low].asn == as)) 
+         ? &pcPrefix->asn[low] : NULL;
+}
+
+/**
+ * Inserts a new AS at the given position into the AS array of the prefix.
+ * 
+ * @note Pointers to other ASes of this prefix become invalid.
+ * 
+ * @param self The prefix cache
+ * @param pcPrefix The prefix cache prefix
+ * @param as The AS number
+ * @param pos The position determined by _findAS
+ * 
+ * @return The new AS or NULL if not enough memory is available.
+ * 
+ * @since 0.4.1.0
+ */
+static PC_AS* _insertAS(PrefixCache* self, PC_Prefix* pcPrefix, uint32_t as,
+                        uint32_t pos)
+{
+  PC_AS* pcAS;
+  
+  if (pcPrefix->asnCount == pcPrefix->asnCapacity)
+  {
+    uint32_t newCapacity = pcPrefix->asnCapacity == 0 ? PC_INITIAL_ARRAY_SIZE
+                                                    : pcPrefix->asnCapacity * 2;
+    PC_AS* asn = reallocFromSizeClassPool(&self->arena->arrayPool,
+                                     pcPrefix->asn,
+                                     pcPrefix->asnCapacity * sizeof(PC_AS),
+                                     newCapacity * sizeof(PC_AS));
+    if (asn == NULL)
+    {
+      return NULL;
+    }
+    pcPrefix->asn         = asn;
+    pcPrefix->asnCapacity = newCapacity;
+  }
+  
+  memmove(&pcPrefix->asn[pos+1], &pcPrefix->asn[pos], 
+          (pcPrefix->asnCount - pos) * sizeof(PC_AS));
+  pcPrefix->asnCount++;
+  
+  pcAS = &pcPrefix->asn[pos];
+  pcAS->asn          = as;
+  pcAS->roas         = NULL;
+  pcAS->roaCount     = 0;
+  pcAS->roaCapacity  = 0;
+  pcAS->update_count = 0;
+  pcAS->record       = NULL;
+  
+  return pcAS;
+}
+
+/**
+ * Removes the AS from the AS array of the prefix and releases its ROAs.
+ * 
+ * @param self The prefix cache
+ * @param pcPrefix The prefix cache prefix
+ * @param pcAS The AS, MUST be part of the prefix.
+ * 
+ * @since 0.4.1.0
+ */
+static void _removeAS(PrefixCache* self, PC_Prefix* pcPrefix, PC_AS* pcAS)
+{
+  uint32_t pos = (uint32_t)(pcAS - pcPrefix->asn);
+  
+  freeToSizeClassPool(&self->arena->arrayPool, pcAS->roas,
+                      pcAS->roaCapacity * sizeof(PC_ROA));
+  pcPrefix->asnCount--;
+  memmove(&pcPrefix->asn[pos], &pcPrefix->asn[pos+1], 
+          (pcPrefix->asnCount - pos) * sizeof(PC_AS));
+}
+
+/**
+ * Returns the ROA of the given AS with the given max length and validation 
+ * cache.
+ * 
+ * @param pcAS The AS
+ * @param maxLen The max length of the ROA
+ * @param valCacheID The validation cache ID
+ * 
+ * @return The ROA or NULL if not found.
+ * 
+ * @since 0.4.1.0
+ */
+static PC_ROA* _findROA(PC_AS* pcAS, uint8_t maxLen, uint32_t valCacheID)
+{
+  uint16_t idx;
+  
+  // The array is sorted by descending max length.
+  for (idx = 0; (idx < pcAS->roaCount) && (pcAS->roas[idx].max_len >= maxLen); 
+       idx++)
+  {
+    if (   (pcAS->roas[idx].max_len == maxLen)
+        && (pcAS->roas[idx].valCacheID == valCacheID))
+    {
+      return &pcAS->roas[idx];
+    }
+  }
+  
+  return NULL;
+}
+
+/**
+ * Adds a new ROA to the given AS. The ROA array remains sorted by descending 
+ * max length.
+ * 
+ * @note Pointers to other ROAs of this AS become invalid.
+ * 
+ * @param self The prefix cache
+ * @param pcAS The AS
+ * @param maxLen The max length of the ROA
+ * @param valCacheID The validation cache ID
+ * 
+ * @return The new ROA or NULL if not enough memory is available.
+ * 
+ * @since 0.4.1.0
+ */
+static PC_ROA* _insertROA(PrefixCache* self, PC_AS* pcAS, uint8_t maxLen, 
+                          uint32_t valCacheID)
+{
+  PC_ROA*  pcROA;
+  uint16_t pos;
+  
+  if (pcAS->roaCount == pcAS->roaCapacity)
+  {
+    uint16_t newCapacity = pcAS->roaCapacity == 0 ? PC_INITIAL_ARRAY_SIZE
+                                                  : pcAS->roaCapacity * 2;
+    PC_ROA* roas = reallocFromSizeClassPool(&self->arena->arrayPool,
+                                         pcAS->roas,
+                                         pcAS->roaCapacity * sizeof(PC_ROA),
+                                         newCapacity * sizeof(PC_ROA));
+    if (roas == NULL)
+    {
+      return NULL;
+    }
+    pcAS->roas        = roas;
+    pcAS->roaCapacity = newCapacity;
+  }
+  
+  for (pos = 0; (pos < pcAS->roaCount) && (pcAS->roas[pos].max_len >= maxLen);
+       pos++) {}
+  memmove(&pcAS->roas[pos+1], &pcAS->roas[pos], 
+          (pcAS->roaCount - pos) * sizeof(PC_ROA));
+  pcAS->roaCount++;
+  
+  pcROA = &pcAS->roas[pos];
+  pcROA->valCacheID     = valCacheID;
+  pcROA->max_len        = maxLen;
+  pcROA->deferred_count = 0;
+  pcROA->roa_count      = 1;
+  pcROA->update_count   = 0;
+  
+  return pcROA;
+}
+
+/**
+ * Removes the ROA from the given AS.
+ * 
+ * @param pcAS The AS
+ * @param pcROA The ROA, MUST be part of the AS.
+ * 
+ * @since 0.4.1.0
+ */
+static void _removeROA(PC_AS* pcAS, PC_ROA* pcROA)
+{
+  uint16_t pos = (uint16_t)(pcROA - pcAS->roas);
+  
+  pcAS->roaCount--;
+  memmove(&pcAS->roas[pos], &pcAS->roas[pos+1], 
+          (pcAS->roaCount - pos) * sizeof(PC_ROA));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ROA INDEX OF THE VALIDATION CACHES
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A ROA within the index of its validation cache. Tree nodes are not removed 
+ * before the tree gets cleared, the ROA itself is found through its AS and max
+ * length because the ROA and AS arrays move.
+ * 
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** The tree node of the prefix the ROA is attached to. */
+  patricia_node_t* treeNode;
+  /** The AS number of the ROA. */
+  uint32_t         as;
+  /** The max length of the ROA. */
+  uint8_t          max_len;
+} PC_CacheROA;
+
+/**
+ * All ROAs of a validation cache.
+ * 
+ * @since 0.4.1.0
+ */
+struct _PC_ValCache {
+  /** The validation cache ID, the key of the hash table. */
+  uint32_t       valCacheID;
+  /** The ROAs, each PC_ROA knows its position. */
+  PC_CacheROA*   roas;
+  /** The number of ROAs stored in roas. */
+  uint32_t       count;
+  /** The number of ROAs that fit into roas without extending it. */
+  uint32_t       capacity;
+  UT_hash_handle hh;
+};
+
+/**
+ * Return the ROA an index entry refers to.
+ * 
+ * @param entry The index entry.
+ * @param valCacheID The validation cache ID of the index.
+ * 
+ * @return The ROA or NULL if the index is broken.
+ * 
+ * @since 0.4.1.0
+ */
+static PC_ROA* _getIndexedROA(PC_CacheROA* entry, uint32_t valCacheID)
+{
+  PC_Prefix* pcPrefix = (PC_Prefix*)entry->treeNode->data;
+  PC_AS*     pcAS     = pcPrefix != NULL ? _findAS(pcPrefix, entry->as, NULL) 
+                                         : NULL;
+  
+  return pcAS != NULL ? _findROA(pcAS, entry->max_len, valCacheID) : NULL;
+}
+
+/**
+ * Return the index of the given validation cache with room for at least one 
+ * more ROA. The index is created if needed. The caller MUST hold the write 
+ * lock of the tree.
+ * 
+ * @param self The prefix cache.
+ * @param valCacheID The validation cache ID.
+ * 
+ * @return The index or NULL if not enough memory is available.
+ * 
+ * @since 0.4.1.0
+ */
+static PC_ValCache* _reserveIndexEntry(PrefixCache* self, uint32_t valCacheID)
+{
+  PC_ValCache* valCache;
+  
+  HASH_FIND_INT(self->valCaches, &valCacheID, valCache);
+  if (valCache == NULL)
+  {
+    valCache = calloc(1, sizeof(PC_ValCache));
+    if (valCache == NULL)
+    {
+      return NULL;
+    }
+    valCache->valCacheID = valCacheID;
+    HASH_ADD_INT(self->valCaches, valCacheID, valCache);
+  }
+  
+  if (valCache->count == PC_MAX_CACHE_ROAS)
+  {
+    RAISE_ERROR("Validation cache 0x%08X exceeds %u ROAs!", valCacheID,
+                PC_MAX_CACHE_ROAS);
+    return NULL;
+  }
+  if (valCache->count == valCache->capacity)
+  {
+    uint32_t     newCapacity = valCache->capacity == 0 
+                               ? self->roaIndexCapacity 
+                               : MIN(valCache->capacity * 2, PC_MAX_CACHE_ROAS);
+    PC_CacheROA* roas = realloc(valCache->roas, 
+                                newCapacity * sizeof(PC_CacheROA));
+    if (roas == NULL)
+    {
+      return NULL;
+    }
+    valCache->roas     = roas;
+    valCache->capacity = newCapacity;
+  }
+  
+  return valCache;
+}
+
+/**
+ * Add the ROA to the index reserved with _reserveIndexEntry.
+ * 
+ * @param valCache The index of the ROA's validation cache.
+ * @param treeNode The tree node of the ROA's prefix.
+ * @param as The AS number of the ROA.
+ * @param pcROA The ROA.
+ * 
+ * @since 0.4.1.0
+ */
+static void _addIndexEntry(PC_ValCache* valCache, patricia_node_t* treeNode,
+                           uint32_t as, PC_ROA* pcROA)
+{
+  PC_CacheROA* entry = &valCache->roas[valCache->count];
+  
+  entry->treeNode = treeNode;
+  entry->as       = as;
+  entry->max_len  = pcROA->max_len;
+  pcROA->cacheIdx = valCache->count++;
+}
+
+/**
+ * Remove the entry of a ROA that was removed from the prefix. The last entry 
+ * of the index takes its position. An empty index is released. The caller MUST
+ * hold the write lock of the tree.
+ * 
+ * @param self The prefix cache.
+ * @param valCacheID The validation cache ID of the removed ROA.
+ * @param cacheIdx The index position of the removed ROA.
+ * 
+ * @since 0.4.1.0
+ */
+static void _removeIndexEntry(PrefixCache* self, uint32_t valCacheID, 
+                              uint32_t cacheIdx)
+{
+  PC_ValCache* valCache;
+  PC_ROA*      pcROA;
+  
+  HASH_FIND_INT(self->valCaches, &valCacheID, valCache);
+  if ((valCache == NULL) || (cacheIdx >= valCache->count))
+  {
+    RAISE_SYS_ERROR("BUG: ROA not found in the index of validation cache "
+                    "0x%08X!", valCacheID);
+    return;
+  }
+  
+  valCache->count--;
+  if (cacheIdx < valCache->count)
+  {
+    valCache->roas[cacheIdx] = valCache->roas[valCache->count];
+    pcROA = _getIndexedROA(&valCache->roas[cacheIdx], valCacheID);
+    if (pcROA != NULL)
+    {
+      pcROA->cacheIdx = cacheIdx;
+    }
+  }
+  
+  if (valCache->count == 0)
+  {
+    HASH_DEL(self->valCaches, valCache);
+    free(valCache->roas);
+    free(valCache);
+  }
+}
+
+/**
+ * Release the indexes of all validation caches.
+ * 
+ * @param valCaches The hash table of the indexes, empty afterwards.
+ * 
+ * @since 0.4.1.0
+ */
+static void _releaseIndexes(PC_ValCache** valCaches)
+{
+  PC_ValCache* valCache;
+  PC_ValCache* tmp;
+  
+  HASH_ITER(hh, *valCaches, valCache, tmp)
+  {
+    HASH_DEL(*valCaches, valCache);
+    free(valCache->roas);
+    free(valCache);
+  }
+}
+
+/**
+ * Creates a new and empty prefix cache prefix within the arena and attaches
+ * it to the given tree node. The caller MUST hold the write lock of the tree.
+ * 
+ * @param self The prefix cache.
+ * @param treeNode The tree node.
+ * 
+ * @return The pc prefix or NULL if not enough memory is available.
+ * 
+ * @since 0.4.1.0
+ */
+static PC_Prefix* _createPCPrefix(PrefixCache* self, patricia_node_t* treeNode)
+{
+  PC_Prefix* pcPrefix = allocFromMemPool(&self->arena->prefixPool);
+  
+  PC_Prefix* parent;
+
+  if (pcPrefix != NULL)
+  {
+    memset(pcPrefix, 0, sizeof(PC_Prefix));
+    pcPrefix->arena    = self->arena;
+    pcPrefix->treeNode = treeNode;
+    // A new prefix has no ROAs, the links of more specific prefixes stay.
+    parent = getParent(treeNode);
+    if (parent != NULL)
+    {
+      pcPrefix->roaParent = parent->roaCount > 0 ? parent
+                                                 : parent->roaParent;
+    }
+    // Readers without lock must find an initialized prefix.
+    __sync_synchronize();
+    treeNode->data     = pcPrefix;
+  }
+  
+  return pcPrefix;
+}
+
+/**
+ * Release the update, AS, and ROA arrays of the prefix. Readers without lock
+ * do not access them, this can be done before the prefix gets retired. The 
+ * caller MUST hold the write lock of the tree.
+ * 
+ * @param self The prefix cache.
+ * @param prefix The prefix.
+ * 
+ * @since 0.4.1.0
+ */
+static void _releasePrefixArrays(PrefixCache* self, PC_Prefix* prefix)
+{
+  uint32_t idx;
+  
+  _releaseUpdateArray(&self->arena->arrayPool, &prefix->valid);
+  _releaseUpdateArray(&self->arena->arrayPool, &prefix->other);
+  
+  // All ases
+  for (idx = 0; idx < prefix->asnCount; idx++)
+  {
+    freeToSizeClassPool(&self->arena->arrayPool, prefix->asn[idx].roas,
+                        prefix->asn[idx].roaCapacity * sizeof(PC_ROA));
+  }
+  freeToSizeClassPool(&self->arena->arrayPool, prefix->asn,
+                      prefix->asnCapacity * sizeof(PC_AS));
+  prefix->asn         = NULL;
+  prefix->asnCount    = 0;
+  prefix->asnCapacity = 0;
+}
+
+/**
+ * Release function of a prefix of a dropped tree. The prefix and its arrays
+ * are released with the arena, only the ROA set is freed here.
+ * 
+ * @param prefix The PC_Prefix of the dropped tree.
+ *
+ * @since 0.4.1.0
+ */
+static void _releaseDroppedPrefix(void* prefix)
+{
+  free(((PC_Prefix*)prefix)->roaSet);
+}
+
+/**
+ * Release function for prefixes retired from the epoch domain. The arrays of
+ * the prefix are released already. Retired data is released by the writer
+ * only, which holds the write lock of the tree.
+ * 
+ * @param prefix The PC_Prefix to be released.
+ * 
+ * @since 0.4.1.0
+ */
+static void _releaseRetiredPrefix(void* prefix)
+{
+  PC_Prefix* pcPrefix = (PC_Prefix*)prefix;
+
+  free(pcPrefix->roaSet);
+  freeToMemPool(&pcPrefix->arena->prefixPool, pcPrefix);
+}
+
+/**
+ * Replace the ROAs of the given IPv4 prefix within the IPv4 origin index. 
+ * Other prefixes are ignored. The caller MUST hold the write lock of the tree.
+ * 
+ * @param self The prefix cache.
+ * @param pcPrefix The prefix.
+ * @param roaSet The ROAs of the prefix or NULL if it has none left.
+ * 
+ * @since 0.4.1.0
+ */
+static void _publishOriginIndex(PrefixCache* self, PC_Prefix* pcPrefix,
+                                PC_ROASet* roaSet)
+{
+  prefix_t*  prefix = pcPrefix->treeNode->prefix;
+  OIV4Entry* roas   = NULL;
+  uint32_t   count  = roaSet != NULL ? roaSet->count : 0;
+  uint32_t   idx;
+  
+  if ((prefix->family != AF_INET) || self->originIndexV4.disabled)
+  {
+    return;
+  }
+  if (count > 0)
+  {
+    roas = malloc(count * sizeof(OIV4Entry));
+    if (roas == NULL)
+    {
+      RAISE_SYS_ERROR("Not enough memory to update the IPv4 origin index, "
+                      "the index is disabled!");
+      self->originIndexV4.disabled = true;
+      return;
+    }
+    for (idx = 0; idx < count; idx++)
+    {
+      roas[idx].as      = roaSet->as[idx];
+      roas[idx].max_len = roaSet->max_len[idx];
+    }
+  }
+  setOriginIndexV4(&self->originIndexV4, &self->epoch, 
+                   ntohl(prefix->add.sin.s_addr), prefix->bitlen, roas, count);
+  free(roas);
+}
+
+/**
+ * Unlink the prefix without AS from its tree node and retire it. The caller 
+ * MUST hold the write lock of the tree.
+ * 
+ * @param self The prefix cache.
+ * @param pcPrefix The prefix.
+ * 
+ * @since 0.4.1.0
+ */
+static void _retirePrefix(PrefixCache* self, PC_Prefix* pcPrefix)
+{
+  if (pcPrefix->roaSet != NULL)
+  {
+    _publishOriginIndex(self, pcPrefix, NULL);
+  }
+  // Readers without lock might still see the prefix.
+  pcPrefix->treeNode->data = NULL;
+  _releasePrefixArrays(self, pcPrefix);
+  retireEpochData(&self->epoch, pcPrefix, _releaseRetiredPrefix);
+}
+
+/**
+ * Publish a new copy of all ROAs attached to the given prefix for readers 
+ * without lock. The old copy gets retired. The caller MUST hold the write lock
+ * of the tree.
+ * 
+ * @param self The prefix cache.
+ * @param pcPrefix The prefix whose ROAs changed.
+ * 
+ * @since 0.4.1.0
+ */
+static void _publishROASet(PrefixCache* self, PC_Prefix* pcPrefix)
+{
+  PC_ROASet* oldSet = pcPrefix->roaSet;
+  PC_ROASet* newSet = NULL;
+  uint32_t   count  = 0;
+  uint32_t   asIdx;
+  uint16_t   roaIdx;
+  
+  for (asIdx = 0; asIdx < pcPrefix->asnCount; asIdx++)
+  {
+    count += pcPrefix->asn[asIdx].roaCount;
+  }
+  
+  if (count > 0)
+  {
+    newSet = malloc(sizeof(PC_ROASet) + count * (sizeof(uint32_t) + 1));
+    if (newSet == NULL)
+    {
+      // Keep the old set, the registration of updates corrects the result.
+      RAISE_SYS_ERROR("Not enough memory to publish the ROAs of a prefix!");
+      return;
+    }
+    newSet->count   = 0;
+    newSet->max_len = (uint8_t*)&newSet->as[count];
+    for (asIdx = 0; asIdx < pcPrefix->asnCount; asIdx++)
+    {
+      for (roaIdx = 0; roaIdx < pcPrefix->asn[asIdx].roaCount; roaIdx++)
+      {
+        newSet->as[newSet->count] = pcPrefix->asn[asIdx].asn;
+        newSet->max_len[newSet->count] 
+                                  = pcPrefix->asn[asIdx].roas[roaIdx].max_len;
+        newSet->count++;
+      }
+    }
+  }
+  
+  __sync_synchronize();
+  pcPrefix->roaSet = newSet;
+  if (oldSet != NULL)
+  {
+    retireEpochData(&self->epoch, oldSet, free);
+  }
+  _publishOriginIndex(self, pcPrefix, newSet);
+  self->roaGeneration++;
+}
+
+static void _registerPendingUpdates(PrefixCache* self);
+static void _tryRegisterPendingUpdates(PrefixCache* self);
+
+/**
+ * Release a generation of the cache nothing can reach anymore: The tree, the
+ * arena of its prefixes, the ROA indexes, and the update records. Only the
+ * tree nodes, the ROA sets, and the update records are freed one by one, the
+ * prefixes and their arrays go with the arena. No lock is needed, readers
+ * without lock MUST not see the tree anymore.
+ *
+ * @param tree The prefix tree.
+ * @param arena The arena of the prefixes of the tree.
+ * @param valCaches The ROA indexes of the validation caches.
+ * @param updates The update records, empty afterwards.
+ *
+ * @since 0.4.1.0
+ */
+static void _dropGeneration(patricia_tree_t* tree, PC_Arena* arena,
+                            PC_ValCache* valCaches, DList* updates)
+{
+  DListNode* listNode;
+
+  Destroy_Patricia(tree, _releaseDroppedPrefix);
+  _releaseArena(arena);
+  _releaseIndexes(&valCaches);
+  while ((listNode = shiftFromDList(updates)) != NULL)
+  {
+    _freeUpdateRecord(DLIST_ENTRY(listNode, PC_Update, listNode));
+  }
+}
+
+/**
+ * Frees all allocated resources. the prefix cache itself must be freed outside.
+ */
+void releasePrefixCache(PrefixCache* self)
+{
+  if (self != NULL) 
+  {
+    PC_Update* pc_update;
+    
+    // No reader without lock must access the tree anymore.
+    self->readersBlocked = true;
+    synchronizeEpoch(&self->epoch);
+    releaseEpochDomain(&self->epoch);
+    while (self->pendingUpdates != NULL)
+    {
+      pc_update = self->pendingUpdates;
+      self->pendingUpdates = pc_update->pendingNext;
+      _freeUpdateRecord(pc_update);
+    }
+    
+    // Free the tree, all prefixes and node-data, and all updates
+    WRITE_LOCK(&self->asLock);
+    WRITE_LOCK(&self->validLock);
+    WRITE_LOCK(&self->otherLock);
+    LOCK_MUTEX(&self->updatesMutex);
+    _dropGeneration(self->prefixTree, self->arena, self->valCaches,
+                    &self->updates);
+    self->prefixTree = NULL;
+    self->arena      = NULL;
+    self->valCaches  = NULL;
+    releaseOriginIndexV4(&self->originIndexV4);
+    
+    releaseRWLock(&self->otherLock);
+    releaseRWLock(&self->validLock);
+    releaseRWLock(&self->asLock);
+    releaseRWLock(&self->treeLock);
+    releaseMutex(&self->updatesMutex);
+    _releaseUpdateArray(NULL, &self->batchUpdates);
+  }
+}
+
+/**
+ * Empty the complete update cache. This method empties the prefix tree and the 
+ * all Updates. A new tree and arena are swapped in while the locks are held,
+ * the old ones are released after the locks are given up.
+ * 
+ * @param self The update cache to be emptied!
+ */
+void emptyCache(PrefixCache* self)
+{
+  if (self != NULL) 
+  {
+    Configuration*   sysConfig = self->updateCache != NULL
+                                 ? self->updateCache->sysConfig : NULL;
+    patricia_tree_t* oldTree;
+    PC_Arena*        oldArena;
+    PC_ValCache*     oldIndexes;
+    DList            oldUpdates;
+
+    // Build the new generation before any lock is taken.
+    patricia_tree_t* newTree  = New_Patricia(PATRICIA_MAXBITS);
+    PC_Arena*        newArena = _createArena(sysConfig);
+    if ((newTree == NULL) || (newArena == NULL))
+    {
+      RAISE_ERROR("Not enough memory to empty the prefix cache!");
+      if (newTree != NULL)
+      {
+        Destroy_Patricia(newTree, NULL);
+      }
+      if (newArena != NULL)
+      {
+        _releaseArena(newArena);
+      }
+      return;
+    }
+    initDList(&oldUpdates);
+    
+    // Register all pending updates, they get freed with all others. Then stop
+    // the readers without lock, the tree itself gets swapped.
+    WRITE_LOCK(&self->treeLock);
+    _registerPendingUpdates(self);
+    self->readersBlocked = true;
+    synchronizeEpoch(&self->epoch);
+    releaseEpochDomain(&self->epoch);
+    
+    WRITE_LOCK(&self->asLock);
+    WRITE_LOCK(&self->validLock);
+    WRITE_LOCK(&self->otherLock);
+
+    oldTree          = self->prefixTree;
+    oldArena         = self->arena;
+    oldIndexes       = self->valCaches;
+    self->prefixTree = newTree;
+    self->arena      = newArena;
+    self->valCaches  = NULL;
+    clearOriginIndexV4(&self->originIndexV4);
+    
+    LOCK_MUTEX(&self->updatesMutex);
+    moveDList(&self->updates, &oldUpdates);
+    UNLOCK_MUTEX(&self->updatesMutex);
+    self->noVRPs = 0;
+    self->roaGeneration++;
+    
+    UNLOCK_WRITE_LOCK(&self->asLock);
+    UNLOCK_WRITE_LOCK(&self->validLock);
+    UNLOCK_WRITE_LOCK(&self->otherLock);
+    
+    // Readers without lock must find the new tree.
+    __sync_synchronize();
+    self->readersBlocked = false;
+    UNLOCK_WRITE_LOCK(&self->treeLock);
+    _tryRegisterPendingUpdates(self);
+
+    // Nothing can reach the old generation anymore.
+    _dropGeneration(oldTree, oldArena, oldIndexes, &oldUpdates);
+  }  
+}
+
+/**
+ * This method returns the parent prefix or NULL if no more parent is available.
+ * The parent prefix is NOT the patricia tree parent, it is the next available
+ * stored prefix within the tree.
+ * 
+ * @param prefix The patricia tree node whose parent has to be examined for an 
+ *               SRx prefix.
+ * 
+ * @return The parent prefix if it exists or NULL.
+ */
+PC_Prefix* getParent(patricia_node_t* node)
+{  
+  PC_Prefix* retVal = NULL;
+  if (node != NULL)
+  {
+    if (node->parent != NULL)
+    {
+      node = node->parent;
+      // Patricia parent found, does it contain a PC_Prefix?
+      retVal = node->data != NULL ? (PC_Prefix*)node->data : getParent(node);
+    }      
+  }
+  // No further parent Found
+  return retVal;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// FOREWARD DECLARATIONS
+////////////////////////////////////////////////////////////////////////////////
+static void ipPrefixToPrefix_t(IPPrefix* from, prefix_t* to);
+static void ipV4PrefixToPrefix_t(uint32_t address, uint8_t length,
+                                 prefix_t* to);
+static void prefix_tToIPPrefix(prefix_t* from, IPPrefix* to);
+static void notifyUpdateCacheForROAChange(UpdateCache* updCache, 
+                    SRxUpdateID* updateID, SRxValidationResultVal newROAResult);
+static void _ROAwl_changeStateOfOther(PrefixCache* self, 
+                                      PC_Prefix* pcPrefix, 
+                                      SRxValidationResultVal newState);
+static void _notifyROAChange(PrefixCache* self, PC_Update* pcUpdate,
+                             SRxValidationResultVal newROAResult);
+static void _notifyUpdateRecord(PrefixCache* self, PC_Update* pcUpdate,
+                                SRxValidationResultVal newROAResult);
+static void printXML(PrefixCache* self, char* methodName);
+
+/**
+ * Returns the requested AS attached to the given prefix. In case the AS does 
+ * not exist, a new one is created and added.
+ * 
+ * @param pcPrefix The prefix cache prefix instance.
+ * @param as The as number of the prefix.
+ * 
+ * @return The prefix cache AS or NULL in case a fatal internal error occurred.
+ */
+static PC_AS* getASFromPrefix(PrefixCache* self, PC_Prefix* pcPrefix, 
+                              uint32_t as)
+{
+  uint32_t pos;
+  PC_AS*   pcAS = _findAS(pcPrefix, as, &pos);
+  
+  // If the AS is not found, create one.
+  if (pcAS == NULL)
+  {
+    pcAS = _insertAS(self, pcPrefix, as, pos);
+    if (pcAS == NULL)
+    {
+      RAISE_SYS_ERROR( HDR "Could not add AS%u to the prefix tree!",
+                       pthread_self(), as);
+    }
+  }
+  return pcAS;
+}
+
+/**
+ * Return all direct children in the trie one level down that contain a 
+ * PC_Prefix. The children are NOT the prefix tree nodes. The children are the 
+ * PC_Prefix nodes attached to the data elements. Once a child is found NO 
+ * grandchild is searched for.
+ * 
+ * @param children The list where all children will be stored in. The stored 
+ *                 children are of type PC_Prefix*
+ * @param node the patricia node whose PC_Prefix children will be searched for.
+ * 
+ * @return true if any children could be found.
+ */
+static bool getChildren(Vector* children, patricia_node_t* node)
+{
+  if (node->l != NULL)
+  {
+    if (node->l->data != NULL)
+    {
+      if (!appendDataToVector(children, &node->l->data))
+      {
+        RAISE_SYS_ERROR("Could not gather prefix children. Memory Problems, "
+                        "Not all children could be added!");
+        emptyVector(children);
+      }
+    }
+    else
+    {
+      getChildren(children, node->l); 
+    }
+  }
+  if (node->r != NULL)
+  {
+    if (node->r->data != NULL)
+    {
+      if (!appendDataToVector(children, &node->r->data))
+      {
+        RAISE_SYS_ERROR("Could not gather prefix children. Memory Problems, "
+                        "Not all children could be added!");
+        emptyVector(children);
+      }
+    }
+    else
+    {
+      getChildren(children, node->r); 
+    }    
+  }
+  return sizeOfVector(children) > 0;
+}
+
+/**
+ * Called by _walkPrefixes for each visited prefix.
+ *
+ * @param self The prefix cache.
+ * @param pcPrefix The visited prefix.
+ * @param parent The visited prefix the given prefix was reached from, NULL
+ *               for the prefix the walk started with.
+ * @param context The context given to _walkPrefixes.
+ *
+ * @return true if the children of the prefix have to be visited as well.
+ *
+ * @since 0.4.1.0
+ */
+typedef bool (*PC_PrefixVisitor)(PrefixCache* self, PC_Prefix* pcPrefix,
+                                 PC_Prefix* parent, void* context);
+
+/** An element of the stack of the subtree walk. */
+typedef struct {
+  /** The tree node to be examined. */
+  patricia_node_t* node;
+  /** The visited prefix the node was reached from. */
+  PC_Prefix*       parent;
+} PC_WalkElem;
+
+/**
+ * Visit the given prefix and, depth first, all prefixes of its subtree in
+ * place. The walk uses an explicit stack of fixed size instead of recursion
+ * and gathering the children, it does not allocate memory. A prefix is only
+ * visited if the visitor returned true for the prefix it is reached from. The
+ * visitor MUST NOT modify the tree structure.
+ *
+ * @param self The prefix cache.
+ * @param pcPrefix The prefix the walk starts with.
+ * @param visitor The visitor called for each prefix.
+ * @param context The context handed to the visitor.
+ *
+ * @since 0.4.1.0
+ */
+static void _walkPrefixes(PrefixCache* self, PC_Prefix* pcPrefix,
+                          PC_PrefixVisitor visitor, void* context)
+{
+  PC_WalkElem      stack[PC_WALK_STACK_SIZE];
+  int              top = 0;
+  patricia_node_t* node;
+  PC_Prefix*       parent;
+
+  stack[top].node   = pcPrefix->treeNode;
+  stack[top].parent = NULL;
+  top++;
+
+  while (top > 0)
+  {
+    top--;
+    node   = stack[top].node;
+    parent = stack[top].parent;
+
+    // Glue nodes are passed through, the children of a prefix are only
+    // examined if the visitor asks for it.
+    if (node->data != NULL)
+    {
+      if (!visitor(self, (PC_Prefix*)node->data, parent, context))
+      {
+        continue;
+      }
+      parent = (PC_Prefix*)node->data;
+    }
+
+    if (top + 2 > PC_WALK_STACK_SIZE)
+    {
+      RAISE_SYS_ERROR("BUG: The prefix tree is deeper than %d levels, the "
+                      "subtree is not visited completely!",
+                      PC_WALK_STACK_SIZE);
+      continue;
+    }
+    // Push the right child first to visit the left one first.
+    if (node->r != NULL)
+    {
+      stack[top].node   = node->r;
+      stack[top].parent = parent;
+      top++;
+    }
+    if (node->l != NULL)
+    {
+      stack[top].node   = node->l;
+      stack[top].parent = parent;
+      top++;
+    }
+  }
+}
+
+/**
+ * Visitor of _setROAParents, links the prefixes below the first prefix to the
+ * new ROA parent.
+ *
+ * @param self The prefix cache.
+ * @param pcPrefix The visited prefix.
+ * @param parent The visited parent prefix, NULL for the first prefix.
+ * @param context The new ROA parent.
+ *
+ * @return true if the prefixes below are linked to the same ROA parent.
+ *
+ * @since 0.4.1.0
+ */
+static bool _setROAParent(PrefixCache* self, PC_Prefix* pcPrefix,
+                          PC_Prefix* parent, void* context)
+{
+  if (parent != NULL)
+  {
+    pcPrefix->roaParent = (PC_Prefix*)context;
+  }
+  // A prefix with ROAs is the ROA parent of its subtree.
+  return (parent == NULL) || (pcPrefix->roaCount == 0);
+}
+
+/**
+ * The given prefix got its first ROA or lost its last ROA. Link all more
+ * specific prefixes up to the next prefix with ROAs to the new ROA parent.
+ * The caller MUST hold the write lock of the tree.
+ *
+ * @param self The prefix cache.
+ * @param pcPrefix The prefix whose ROAs changed.
+ *
+ * @since 0.4.1.0
+ */
+static void _setROAParents(PrefixCache* self, PC_Prefix* pcPrefix)
+{
+  _walkPrefixes(self, pcPrefix, _setROAParent,
+                pcPrefix->roaCount > 0 ? pcPrefix : pcPrefix->roaParent);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Request Validation
+////////////////////////////////////////////////////////////////////////////////
+
+static bool _performUpdateValidationNewPrefix(PrefixCache* self, 
+                                              PC_Update* update, uint32_t as);
+static bool _performUpdateValidationKnownPrefix(PrefixCache* self, 
+                                                PC_Update* update, uint32_t as, 
+                                                bool isNew);
+static bool _registerUpdate(PrefixCache* self, PC_Update* pcUpdate);
+
+/**
+ * Check if the prefix cache uses an attached shared ROA table instead of its
+ * own white-list.
+ *
+ * @param self The prefix cache
+ *
+ * @return true if a shared ROA table is attached read-only.
+ *
+ * @since 0.4.1.0
+ */
+static inline bool _isSharedROAsAttached(PrefixCache* self)
+{
+  return (self->sharedROAs != NULL) && self->sharedROAs->readOnly;
+}
+
+/**
+ * Determine the origin validation state of the given prefix and origin using
+ * the shared ROA table. The caller MUST be within the epoch.
+ *
+ * @param self The prefix cache
+ * @param lookupPrefix The prefix of the update
+ * @param as The origin AS of the update
+ * @param result Receives the validation state.
+ *
+ * @return false if the state could not be determined.
+ *
+ * @since 0.4.1.0
+ */
+static bool _lookupSharedROAs(PrefixCache* self, prefix_t* lookupPrefix,
+                              uint32_t as, SRxValidationResultVal* result)
+{
+  return lookupPrefix->family == AF_INET
+         ? lookupSharedROATable(self->sharedROAs, SHARED_ROA_V4,
+                                (uint8_t*)&lookupPrefix->add.sin,
+                                lookupPrefix->bitlen, as, result)
+         : lookupSharedROATable(self->sharedROAs, SHARED_ROA_V6,
+                                (uint8_t*)&lookupPrefix->add.sin6,
+                                lookupPrefix->bitlen, as, result);
+}
+
+/**
+ * Determine the origin validation state of the given prefix and origin using
+ * the published ROA sets only. No lock is taken, the tree nodes and ROA sets 
+ * are read within an epoch. 
+ * 
+ * @param self The prefix cache
+ * @param lookupPrefix The prefix of the update
+ * @param as The origin AS of the update
+ * @param result Receives the validation state.
+ * 
+ * @return false if the state can not be determined without lock.
+ * 
+ * @since 0.4.1.0
+ */
+static bool _lookupOriginState(PrefixCache* self, prefix_t* lookupPrefix, 
+                               uint32_t as, SRxValidationResultVal* result)
+{
+  patricia_node_t* treeNode;
+  PC_Prefix*       pcPrefix;
+  PC_ROASet*       roaSet;
+  
+  if (!enterEpoch(&self->epoch))
+  {
+    return false;
+  }
+  if (_isSharedROAsAttached(self))
+  {
+    // Nothing published yet is treated like an empty white-list.
+    if (!_lookupSharedROAs(self, lookupPrefix, as, result))
+    {
+      *result = SRx_RESULT_NOTFOUND;
+    }
+    leaveEpoch(&self->epoch);
+    return true;
+  }
+  if (self->readersBlocked)
+  {
+    leaveEpoch(&self->epoch);
+    return false;
+  }
+  
+  if (   (lookupPrefix->family == AF_INET)
+      && lookupOriginIndexV4(&self->originIndexV4, 
+                             ntohl(lookupPrefix->add.sin.s_addr),
+                             lookupPrefix->bitlen, as, result))
+  {
+    leaveEpoch(&self->epoch);
+    return true;
+  }
+  
+  *result = SRx_RESULT_NOTFOUND;
+  // Walk from the most specific prefix covering the update up the tree. Tree 
+  // nodes are never removed while readers are allowed.
+  treeNode = patricia_search_best(self->prefixTree, lookupPrefix);
+  for (; treeNode != NULL; treeNode = treeNode->parent)
+  {
+    pcPrefix = (PC_Prefix*)treeNode->data;
+    roaSet   = pcPrefix != NULL ? pcPrefix->roaSet : NULL;
+    if (roaSet == NULL)
+    {
+      continue;
+    }
+    // Any ROA of a covering prefix makes the update at least invalid.
+    *result = SRx_RESULT_INVALID;
+    if (_matchROASet(roaSet, as, lookupPrefix->bitlen))
+    {
+      *result = SRx_RESULT_VALID;
+      break;
+    }
+  }
+  
+  leaveEpoch(&self->epoch);
+  return true;
+}
+
+/**
+ * Add the update to the list of updates waiting to be registered within the
+ * tree.
+ * 
+ * @param self The prefix cache
+ * @param pcUpdate The update.
+ * 
+ * @since 0.4.1.0
+ */
+static void _queuePendingUpdate(PrefixCache* self, PC_Update* pcUpdate)
+{
+  PC_Update* head;
+  
+  do
+  {
+    head = self->pendingUpdates;
+    pcUpdate->pendingNext = head;
+  } while (!__sync_bool_compare_and_swap(&self->pendingUpdates, head, 
+                                         pcUpdate));
+}
+
+/**
+ * Register all pending updates in the tree. The caller MUST hold the write 
+ * lock of the tree. Each update reports its validation state once registered,
+ * the update cache only notifies the clients if it differs from the state 
+ * reported by the lock free validation.
+ * 
+ * @param self The prefix cache
+ * 
+ * @since 0.4.1.0
+ */
+static void _registerPendingUpdates(PrefixCache* self)
+{
+  PC_Update* pcUpdate;
+  PC_Update* ordered = NULL;
+  PC_Update* next;
+  
+  if (self->pendingUpdates == NULL)
+  {
+    return;
+  }
+  
+  // Take the complete list and turn it into the order of arrival.
+  pcUpdate = __sync_lock_test_and_set(&self->pendingUpdates, NULL);
+  while (pcUpdate != NULL)
+  {
+    next = pcUpdate->pendingNext;
+    pcUpdate->pendingNext = ordered;
+    ordered = pcUpdate;
+    pcUpdate = next;
+  }
+  
+  while (ordered != NULL)
+  {
+    pcUpdate = ordered;
+    ordered  = pcUpdate->pendingNext;
+    pcUpdate->pendingNext = NULL;
+    if (!_registerUpdate(self, pcUpdate))
+    {
+      RAISE_SYS_ERROR( HDR "Could not register update in the prefix cache!",
+                       pthread_self());
+    }
+  }
+}
+
+/**
+ * Register the pending updates if the tree lock is available. Whoever holds 
+ * the lock calls this function after releasing it, an update queued while 
+ * the lock is held will therefore not be left behind.
+ * 
+ * @param self The prefix cache
+ * 
+ * @since 0.4.1.0
+ */
+static void _tryRegisterPendingUpdates(PrefixCache* self)
+{
+  __sync_synchronize();
+  while ((self->pendingUpdates != NULL) && tryWriteLock(&self->treeLock))
+  {
+    _registerPendingUpdates(self);
+    UNLOCK_WRITE_LOCK(&self->treeLock);
+    __sync_synchronize();
+  }
+}
+
+/**
+ * Allocate and initialize the update record of an update to be validated. The
+ * caller sets the pending prefix.
+ * 
+ * @param updateID the id of the update itself
+ * @param as The AS number of the update
+ * 
+ * @return The update record or NULL if not enough memory was available.
+ *
+ * @since 0.4.1.0
+ */
+static PC_Update* _createPendingUpdate(SRxUpdateID* updateID, uint32_t as)
+{
+  PC_Update* pcUpdate = malloc(sizeof(PC_Update));
+
+  if (pcUpdate == NULL)
+  {
+    RAISE_SYS_ERROR( HDR "Could not add update [0x%08X] to prefix cache!",
+                     pthread_self(), *updateID);
+    return NULL;
+  }
+  
+  pcUpdate->roa_match     = 0;
+  pcUpdate->notifyPending = false;
+  pcUpdate->updateID      = *updateID;
+  pcUpdate->sharedIDs     = NULL;
+  pcUpdate->noSharedIDs   = 0;
+  pcUpdate->sharedCapacity = 0;
+  pcUpdate->as            = as;
+  pcUpdate->treeNode      = NULL;
+  pcUpdate->pendingNext   = NULL;
+  pcUpdate->listNode.next = NULL;
+  pcUpdate->listNode.prev = NULL;
+
+  return pcUpdate;
+}
+
+/**
+ * Report the validation state of the update determined without lock and queue
+ * the update for the registration within the tree.
+ *
+ * @param self The prefix cache
+ * @param pcUpdate The update record with the pending prefix set.
+ *
+ * @return true
+ *
+ * @since 0.4.1.0
+ */
+static bool _requestPendingValidation(PrefixCache* self, PC_Update* pcUpdate)
+{
+  // The validation state determined without lock
+  SRxValidationResultVal state;
+
+  if (_lookupOriginState(self, &pcUpdate->pendingPrefix, pcUpdate->as,
+                         &state))
+  {
+    notifyUpdateCacheForROAChange(self->updateCache, &pcUpdate->updateID, 
+                                  state);
+  }
+  if (_isSharedROAsAttached(self))
+  {
+    // Without own white-list the update is revalidated by refreshSharedROAs.
+    _freeUpdateRecord(pcUpdate);
+    return true;
+  }
+  
+  _queuePendingUpdate(self, pcUpdate);
+  _tryRegisterPendingUpdates(self);
+  
+  return true;
+}
+
+/**
+ * Request the validation for an update received. During the process of
+ * validating of adding the update it will be added to the cache, the validation
+ * is done by using the data within the prefix cache. An update requested again
+ * is registered only once, its validation state is reported again. Once added,
+ * changes of the validation state are signaled to the update cache and with
+ * this to the registered clients.
+ *
+ * The validation state is determined without lock using the published ROA
+ * sets and reported right away. The update itself is registered in the tree
+ * by the next thread holding the tree lock, this thread might be the caller.
+ *
+ * @param self The prefix cache
+ * @param updateID the id of the update itself
+ * @param prefix The prefix of the update
+ * @param as The AS number of the update
+ *
+ * @return false indicates an error, most likely memory related! (fatal)
+ */
+bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
+                             IPPrefix* prefix, uint32_t as)
+{
+  if (prefix->ip.version == 4)
+  {
+    return requestUpdateValidationV4(self, updateID, prefix->ip.addr.v4.u32,
+                                     prefix->length, as);
+  }
+
+  PC_Update* pcUpdate = _createPendingUpdate(updateID, as);
+
+  if (pcUpdate == NULL)
+  {
+    return false;
+  }
+  ipPrefixToPrefix_t(prefix, &pcUpdate->pendingPrefix);
+
+  return _requestPendingValidation(self, pcUpdate);
+}
+
+/**
+ * The IPv4 specialization of requestUpdateValidation. The prefix is given as
+ * 32 bit address and length and is not converted from an IPPrefix.
+ *
+ * @param self The prefix cache
+ * @param updateID the id of the update itself
+ * @param address The IPv4 address of the prefix (network order)
+ * @param length The prefix length
+ * @param as The AS number of the update
+ *
+ * @return false indicates an error, most likely memory related! (fatal)
+ *
+ * @since 0.4.1.0
+ */
+bool requestUpdateValidationV4(PrefixCache* self, SRxUpdateID* updateID,
+                               uint32_t address, uint8_t length, uint32_t as)
+{
+  PC_Update* pcUpdate = _createPendingUpdate(updateID, as);
+
+  if (pcUpdate == NULL)
+  {
+    return false;
+  }
+  ipV4PrefixToPrefix_t(address, length, &pcUpdate->pendingPrefix);
+
+  return _requestPendingValidation(self, pcUpdate);
+}
+
+/**
+ * Add the update to the existing record of its prefix and origin AS. The 
+ * update gets the validation state of the record reported, the given update 
+ * record is freed.
+ * 
+ * @param self The prefix cache
+ * @param record The registered record of the prefix and origin AS.
+ * @param pcUpdate The pending update record of the update.
+ * 
+ * @return false if not enough memory was available.
+ * 
+ * @since 0.4.1.0
+ */
+static bool _shareUpdateRecord(PrefixCache* self, PC_Update* record, 
+                               PC_Update* pcUpdate)
+{
+  SRxUpdateID updID = pcUpdate->updateID;
+  
+  _freeUpdateRecord(pcUpdate);
+  if (!_addSharedID(record, updID))
+  {
+    RAISE_SYS_ERROR( HDR "Could not add update [0x%08X] to the record of its "
+                         "prefix and origin!", pthread_self(), updID);
+    return false;
+  }
+  notifyUpdateCacheForROAChange(self->updateCache, &updID, 
+                                record->roa_match > 0 
+                                ? SRx_RESULT_VALID
+                                : ((PC_Prefix*)record->treeNode->data)
+                                                              ->state_of_other);
+  return true;
+}
+
+/**
+ * Register the update within the tree and report its validation state to the 
+ * update cache. An update whose prefix and origin AS already have a record 
+ * joins this record. The caller MUST hold the write lock of the tree.
+ * 
+ * @param self The prefix cache
+ * @param pcUpdate The update, the tree copies its pendingPrefix if needed.
+ * 
+ * @return false indicates an error, most likely memory related! (fatal)
+ */
+static bool _registerUpdate(PrefixCache* self, PC_Update* pcUpdate)
+{
+  // the node within the prefix tree. the data of it is the PC_prefix 
+  // information.
+  patricia_node_t* treeNode = NULL;
+  // This is the prefix the algorithm runs on.
+  PC_Prefix*       pcPrefix = NULL;
+  // The AS instance
+  PC_AS*           pcAS = NULL;
+  // The update id. I know it is so=illy but the structure might change.
+  SRxUpdateID      updID = pcUpdate->updateID;
+  // The origin AS
+  uint32_t         as = pcUpdate->as;
+  
+  // Create or get the existing prefix node
+  // Return the prefix tree element for the prefix in question. This lookup will
+  // insert a copy of the requested prefix in the tree if it doesn't exist 
+  // already. Therefore the result value equals NULL can be interpreted as an 
+  // internal ERROR.
+  treeNode = patricia_lookup(self->prefixTree, &pcUpdate->pendingPrefix);
+  if (treeNode == NULL)
+  {
+    RAISE_ERROR("Failed to append a prefix to the prefix tree");
+    _freeUpdateRecord(pcUpdate);
+    return false;
+  }
+  
+  // Is the prefix and origin already validated for another update?
+  if (treeNode->data != NULL)
+  {
+    pcAS = _findAS((PC_Prefix*)treeNode->data, as, NULL);
+    if ((pcAS != NULL) && (pcAS->record != NULL))
+    {
+      return _shareUpdateRecord(self, pcAS->record, pcUpdate);
+    }
+  }
+  
+  appendToDList(&self->updates, &pcUpdate->listNode);
+  pcUpdate->treeNode = treeNode;
+  
+  // The validation modifies the prefix and its lists.
   bool retVal = true;
   
-  // Already existed - need to free given prefix
-  if (lookupPrefix->ref_count > 0) // If the prefix would have been existed 
-  {                     // already this instance would not have been referenced.
+  // A node just inserted has no data yet, neither has a node left from a 
+  // removed ROA or a node that only joins two branches of the tree.
+  if (treeNode->data == NULL)
+  {
     // (Does P exist ? NO)
     retVal = _performUpdateValidationNewPrefix(self, pcUpdate, as);
-    UNLOCK_READ_LOCK(&self->treeLock);
     
     // printXML(self, "requestUpdateValidation");
 
@@ -585,9 +2143,6 @@ bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
   else
   {
     // (Does P exist ? Yes)
-    // The prefix already existed in the tree, free the newly created one.
-    free(lookupPrefix); 
-    
     pcPrefix = (PC_Prefix*)treeNode->data;
     
     if (pcPrefix->roa_coverage > 0)
@@ -595,38 +2150,37 @@ bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
       // (P::ROA_Count == 0 ? No)                           //false = ! NEW P
       retVal = _performUpdateValidationKnownPrefix(self, pcUpdate, as, false);
       
-      UNLOCK_READ_LOCK(&self->treeLock);
       return retVal;
     }
     else
     {
       // (P::ROA_Count == 0 ? Yes)
-      if (!appendDataToSList(&pcPrefix->other, pcUpdate))
+      if (!_addToUpdateArray(&self->arena->arrayPool, &pcPrefix->other,
+                             pcUpdate))
       {
         RAISE_SYS_ERROR( HDR "Could not add update [0x%08X] to P::other!", 
-                         pthread_self(), updateID);
+                         pthread_self(), updID);
         // remove update only, other updates for this prefix do exist!
-        deleteFromSList(&self->updates, pcUpdate);
-        free(pcUpdate);
-        UNLOCK_READ_LOCK(&self->treeLock);
+        removeFromDList(&self->updates, &pcUpdate->listNode);
+        _freeUpdateRecord(pcUpdate);
         return false;
       }
       
-      pcAS = getASFromPrefix(pcPrefix, as);
+      pcAS = getASFromPrefix(self, pcPrefix, as);
       if (pcAS == NULL)
       {
         // Error already generated!
         RAISE_SYS_ERROR( HDR "Remove update [0x%08X] from cache, could not add"
                              " required AS to prefix!", 
-                         pthread_self(), updateID);
-        deleteFromSList(&pcPrefix->other, pcUpdate);
-        deleteFromSList(&self->updates, pcUpdate);
-        free(pcUpdate);
-        UNLOCK_READ_LOCK(&self->treeLock);
+                         pthread_self(), updID);
+        _removeFromUpdateArray(&pcPrefix->other, pcUpdate);
+        removeFromDList(&self->updates, &pcUpdate->listNode);
+        _freeUpdateRecord(pcUpdate);
         return false;
       }
       
       pcAS->update_count++;
+      pcAS->record = pcUpdate;
       
       //BUG #18 - missing notification of update cache
       notifyUpdateCacheForROAChange(self->updateCache, &pcUpdate->updateID,
@@ -634,8 +2188,6 @@ bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
       // End BUG#18
     }
     
-    UNLOCK_READ_LOCK(&self->treeLock);
-    
     //printXML(self, "requestUpdateValidation");
     
     return true;
@@ -661,14 +2213,13 @@ static bool _performUpdateValidationNewPrefix(PrefixCache* self,
                     pthread_self(), pcUpdate->updateID);
     return false;
   }
-  PC_Prefix* pcPrefix = malloc(sizeof(PC_Prefix));
-  pcPrefix->treeNode = pcUpdate->treeNode;
-  pcUpdate->treeNode->data = pcPrefix;
-  
-  initSList(&pcPrefix->asn);
-  initSList(&pcPrefix->other);
-  initSList(&pcPrefix->valid);
-  pcPrefix->roa_coverage = 0;
+  PC_Prefix* pcPrefix = _createPCPrefix(self, pcUpdate->treeNode);
+  if (pcPrefix == NULL)
+  {
+    RAISE_SYS_ERROR(HDR "Not enough memory to store the prefix of update "
+                        "[0x%08X]!", pthread_self(), pcUpdate->updateID);
+    return false;
+  }
   
   PC_Prefix* parent_pcPrefix = getParent(pcUpdate->treeNode);
   if (parent_pcPrefix != NULL)
@@ -701,7 +2252,8 @@ static bool _performUpdateValidation_PrefixNotCovered(PrefixCache* self,
   if (pcUpdate->roa_match == 0)
   {
     // (U::ROA_Count == 0) => Yes
-    if (appendDataToSList(&pcPrefix->other, pcUpdate))
+    if (_addToUpdateArray(&self->arena->arrayPool, &pcPrefix->other,
+                          pcUpdate))
     {
       notifyUpdateCacheForROAChange(self->updateCache, &pcUpdate->updateID, 
                               (SRxValidationResultVal)pcPrefix->state_of_other);
@@ -716,7 +2268,8 @@ static bool _performUpdateValidation_PrefixNotCovered(PrefixCache* self,
   else
   {
     // (U::ROA_Count == 0) => No
-    if (appendDataToSList(&pcPrefix->valid, pcUpdate))
+    if (_addToUpdateArray(&self->arena->arrayPool, &pcPrefix->valid,
+                          pcUpdate))
     {
       notifyUpdateCacheForROAChange(self->updateCache, &pcUpdate->updateID, 
                                     SRx_RESULT_VALID);      
@@ -749,42 +2302,52 @@ static void _performUpdateValidation_PrefixIsCovereByAROA (
                                    PC_Prefix* pcPrefix_Po, PC_Prefix* pcPrefix,
                                    PC_Update* pcUpdate, uint32_t as, bool isNew)
 {
-  SListNode* asListNode;
-  SListNode* roaListNode;
+  PC_AS*   pcAS;
+  PC_ROA*  pcROA;
+  uint32_t asIdx;
+  uint32_t asEnd;
+  uint16_t roaIdx;
+  uint16_t bitlen = pcPrefix_Po->treeNode->prefix->bitlen;
 
-  PC_AS*  pcAS;
-  PC_ROA* pcROA;
+  if (isNew)
+  {
+    // All ASes have to be scanned to determine the coverage of Po.
+    asIdx = 0;
+    asEnd = pcPrefix->asnCount;
+  }
+  else
+  {
+    // The coverage is maintained by the ROA management, only the AS of the 
+    // update is of interest.
+    pcAS = _findAS(pcPrefix, as, &asIdx);
+    asEnd = pcAS != NULL ? asIdx + 1 : asIdx;
+  }
 
-  FOREACH_SLIST(&pcPrefix->asn, asListNode)
+  for (; asIdx < asEnd; asIdx++)
   {
-    pcAS = (PC_AS*)asListNode->data;
-    
-    // Could be added for optimization, leave it out at this point.
-    // if (!isNew && pcAS->asn != as)
-    // {
-    //   continue;
-    // }
+    pcAS = &pcPrefix->asn[asIdx];
     
-    // AS number matches, does prefix also cover this one?
-    FOREACH_SLIST(&pcAS->roas, roaListNode)
+    // The ROAs are sorted by descending max length. Stop at the first ROA that
+    // does not cover Po anymore.
+    for (roaIdx = 0; roaIdx < pcAS->roaCount; roaIdx++)
     {
-      pcROA = (PC_ROA*)roaListNode->data;
-
-      // Does ROA cover PO
-      if (pcPrefix_Po->treeNode->prefix->bitlen <= pcROA->max_len)
-      {        
-        // prefix covers update
-        if (isNew)
-        {
-          // NEW prefix, increase the Po coverage. Otherwise it is increased 
-          // by ROA management itself.
-          pcPrefix_Po->roa_coverage++;
-        }
-        if (pcAS->asn == as)
-        {
-          pcROA->update_count++;
-          pcUpdate->roa_match += pcROA->roa_count;
-        }
+      pcROA = &pcAS->roas[roaIdx];
+      if (bitlen > pcROA->max_len)
+      {
+        break;
+      }
+      
+      // prefix covers update
+      if (isNew)
+      {
+        // NEW prefix, increase the Po coverage. Otherwise it is increased 
+        // by ROA management itself.
+        pcPrefix_Po->roa_coverage++;
+      }
+      if (pcAS->asn == as)
+      {
+        pcROA->update_count++;
+        pcUpdate->roa_match += pcROA->roa_count;
       }
     }
   }
@@ -807,7 +2370,11 @@ static bool _performUpdateValidationKnownPrefix(PrefixCache* self,
 {
   PC_Prefix* pcPrefix = (PC_Prefix*)pcUpdate->treeNode->data;
   PC_Prefix* pcPrefix_Po = pcPrefix;
-  PC_AS*     pcAS = getASFromPrefix(pcPrefix, as);
+  PC_AS*     pcAS = getASFromPrefix(self, pcPrefix, as);
+  if (pcAS == NULL)
+  {
+    return false;
+  }
   pcAS->update_count++;
   
   // P might be covered by a ROA (we don't know if NEW prefix). 
@@ -818,8 +2385,8 @@ static bool _performUpdateValidationKnownPrefix(PrefixCache* self,
                                                   pcUpdate, as, isNew);
 
     // (Exist less specific P' ?) => yes
-    // P := P'
-    pcPrefix = getParent(pcPrefix->treeNode);
+    // P := P', prefixes without ROAs in between do not cover Po.
+    pcPrefix = pcPrefix->roaParent;
 
     if (pcPrefix == NULL)
     {
@@ -827,8 +2394,12 @@ static bool _performUpdateValidationKnownPrefix(PrefixCache* self,
       break;
     }    
   }
-  return _performUpdateValidation_PrefixNotCovered(self, pcPrefix_Po, 
-                                                  pcUpdate);
+  if (!_performUpdateValidation_PrefixNotCovered(self, pcPrefix_Po, pcUpdate))
+  {
+    return false;
+  }
+  // The AS array did not change since the AS was determined.
+  pcAS->record = pcUpdate;
     
   return true;
 }
@@ -838,9 +2409,75 @@ static bool _performUpdateValidationKnownPrefix(PrefixCache* self,
 ////////////////////////////////////////////////////////////////////////////////
 
 /**
- * This method will remove the given update from the prefix cache.
+ * Remove the update record from its prefix and undo all counters the record 
+ * added during its validation. The prefix is retired once no AS is attached 
+ * to it anymore. The caller MUST hold the write lock of the tree.
+ * 
+ * @param self The prefix cache.
+ * @param pcPrefix The prefix the update record is attached to.
+ * @param pcUpdate The update record to be removed.
  * 
- * NOT IMPLEMENTED PRIOR VERSION 0.3
+ * @since 0.4.1.0
+ */
+static void _removeUpdateFromPrefix(PrefixCache* self, PC_Prefix* pcPrefix,
+                                    PC_Update* pcUpdate)
+{
+  patricia_node_t* treeNode = pcPrefix->treeNode;
+  uint16_t         bitlen   = treeNode->prefix->bitlen;
+  PC_Prefix*       pcCover  = pcPrefix;
+  PC_AS*           pcAS;
+  PC_ROA*          pcROA;
+  uint16_t         roaIdx;
+  
+  if (!_removeFromUpdateArray(&pcPrefix->valid, pcUpdate))
+  {
+    _removeFromUpdateArray(&pcPrefix->other, pcUpdate);
+  }
+  
+  // The ROAs of the origin AS that cover the prefix counted the update.
+  while ((pcUpdate->roa_match > 0) && (pcCover != NULL))
+  {
+    pcAS = _findAS(pcCover, pcUpdate->as, NULL);
+    if (pcAS != NULL)
+    {
+      for (roaIdx = 0; roaIdx < pcAS->roaCount; roaIdx++)
+      {
+        pcROA = &pcAS->roas[roaIdx];
+        if (bitlen > pcROA->max_len)
+        {
+          break;
+        }
+        if (pcROA->update_count > 0)
+        {
+          pcROA->update_count--;
+        }
+      }
+    }
+    pcCover = pcCover->roaParent;
+  }
+  
+  pcAS = _findAS(pcPrefix, pcUpdate->as, NULL);
+  if (pcAS != NULL)
+  {
+    pcAS->record = NULL;
+    if (pcAS->update_count > 0)
+    {
+      pcAS->update_count--;
+    }
+    if ((pcAS->update_count == 0) && (pcAS->roaCount == 0))
+    {
+      _removeAS(self, pcPrefix, pcAS);
+    }
+  }
+  
+  if (pcPrefix->asnCount == 0)
+  {
+    _retirePrefix(self, pcPrefix);
+  }
+}
+
+/**
+ * This method will remove the given update from the prefix cache.
  * 
  * @param self The prefix cache.
  * @param updateID The id of the update that has to be removed.
@@ -852,9 +2489,116 @@ static bool _performUpdateValidationKnownPrefix(PrefixCache* self,
 bool removeUpdate(PrefixCache* self, SRxUpdateID* updateID, IPPrefix* prefix,
                   uint32_t as)
 {
-  //TODO: Implement for 0.3.x
-  RAISE_ERROR("IMPLEMENTATION EXPECTED FOR VERSION 0.4.0");
-  return true;
+  PC_UpdateRemoval removal;
+  
+  removal.updateID = *updateID;
+  removal.as       = as;
+  cpyPrefix(&removal.prefix, prefix);
+  
+  return removeUpdates(self, &removal, 1) == 1;
+}
+
+/**
+ * Remove the given updates from the prefix cache. The tree stays write locked
+ * for the complete batch. Updates not found are skipped.
+ * 
+ * @param self The prefix cache.
+ * @param removals The updates to be removed.
+ * @param noRemovals The number of updates.
+ * 
+ * @return The number of updates removed.
+ * 
+ * @since 0.4.1.0
+ */
+uint32_t removeUpdates(PrefixCache* self, PC_UpdateRemoval* removals, 
+                       uint32_t noRemovals)
+{
+  patricia_node_t* treeNode;
+  prefix_t         lookupPrefix;
+  PC_Prefix*       pcPrefix;
+  PC_AS*           pcAS;
+  PC_Update*       pcUpdate;
+  PC_Update*       localRemoved[PC_LOCAL_REMOVALS];
+  PC_Update**      removed = localRemoved;
+  uint32_t         noRemoved = 0;
+  uint32_t         noRemovedIDs = 0;
+  uint32_t         idx;
+  
+  if (_isSharedROAsAttached(self))
+  {
+    // The updates are not registered in the tree.
+    for (idx = 0; idx < noRemovals; idx++)
+    {
+      removals[idx].removed = false;
+    }
+    return 0;
+  }
+  if (noRemovals > PC_LOCAL_REMOVALS)
+  {
+    removed = malloc(noRemovals * sizeof(PC_Update*));
+  }
+  if (removed == NULL)
+  {
+    RAISE_SYS_ERROR(HDR "Not enough memory to remove %u updates!", 
+                    pthread_self(), noRemovals);
+    return 0;
+  }
+  
+  WRITE_LOCK(&self->treeLock);
+  // The updates might still wait for their registration.
+  _registerPendingUpdates(self);
+  
+  for (idx = 0; idx < noRemovals; idx++)
+  {
+    removals[idx].removed = false;
+    ipPrefixToPrefix_t(&removals[idx].prefix, &lookupPrefix);
+    treeNode = patricia_search_exact(self->prefixTree, &lookupPrefix);
+    
+    pcPrefix = treeNode != NULL ? (PC_Prefix*)treeNode->data : NULL;
+    if (pcPrefix == NULL)
+    {
+      // The update was stored only, it never got validated.
+      continue;
+    }
+    
+    pcAS     = _findAS(pcPrefix, removals[idx].as, NULL);
+    pcUpdate = pcAS != NULL ? pcAS->record : NULL;
+    if (pcUpdate == NULL)
+    {
+      continue;
+    }
+    
+    if (_removeSharedID(pcUpdate, removals[idx].updateID))
+    {
+      // Other updates still share the record.
+      removals[idx].removed = true;
+      noRemovedIDs++;
+    }
+    else if (pcUpdate->updateID == removals[idx].updateID)
+    {
+      _removeUpdateFromPrefix(self, pcPrefix, pcUpdate);
+      removeFromDList(&self->updates, &pcUpdate->listNode);
+      pcUpdate->treeNode    = NULL;
+      removed[noRemoved++]  = pcUpdate;
+      removals[idx].removed = true;
+      noRemovedIDs++;
+    }
+  }
+  
+  reclaimEpochData(&self->epoch);
+  UNLOCK_WRITE_LOCK(&self->treeLock);
+  _tryRegisterPendingUpdates(self);
+  
+  for (idx = 0; idx < noRemoved; idx++)
+  {
+    _freeUpdateRecord(removed[idx]);
+  }
+  if (removed != localRemoved)
+  {
+    free(removed);
+  }
+  
+  return noRemovedIDs;
 }
 
 /**
@@ -880,10 +2624,16 @@ bool belongsToRfc5398(uint32_t asn)
 static void _addROAwl_CheckCoverage(PrefixCache* self, uint8_t prefixLen,
                                   PC_Prefix* pcPrefix, PC_Prefix* parentPrefix);
 static void _addROAwl_verifyUpdates(PrefixCache* self, PC_Prefix* pcPrefix, 
-                                    PC_ROA* pcROA);
-static void _addROAwl_moveMatchedUpdatesToValid(UpdateCache* updateCache, 
-                                               SList* validList, 
-                                               SList* otherList, PC_ROA* pcROA);
+                                    uint32_t as, PC_ROA* pcROA);
+static bool _addROAwl_verifyPrefix(PrefixCache* self, PC_Prefix* pcPrefix,
+                                   PC_Prefix* parent, void* context);
+static void _addROAwl_moveMatchedUpdatesToValid(PrefixCache* self, 
+                                               PC_UpdateArray* validList, 
+                                               PC_UpdateArray* otherList, 
+                                               uint32_t as, PC_ROA* pcROA);
+static bool _addROAwl(PrefixCache* self, uint32_t originAS, 
+                      IPPrefix* prefix, uint8_t maxLen, 
+                      uint32_t session_id, uint32_t valCacheID);
 
 /**
  * Add the given ROA white-list entry provided by the specified validation cache
@@ -902,6 +2652,32 @@ static void _addROAwl_moveMatchedUpdatesToValid(UpdateCache* updateCache,
  */
 bool addROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix, 
               uint8_t maxLen, uint32_t session_id, uint32_t valCacheID)
+{
+  bool retVal;
+  
+  if (_isSharedROAsAttached(self))
+  {
+    return true;
+  }
+  WRITE_LOCK(&self->treeLock);
+  _registerPendingUpdates(self);
+  retVal = _addROAwl(self, originAS, prefix, maxLen, session_id, valCacheID);
+  reclaimEpochData(&self->epoch);
+  UNLOCK_WRITE_LOCK(&self->treeLock);
+  _tryRegisterPendingUpdates(self);
+  
+  return retVal;
+}
+
+/**
+ * Same as addROAwl but expects the caller to hold the write lock of the prefix
+ * tree.
+ * 
+ * @since 0.4.1.0
+ */
+static bool _addROAwl(PrefixCache* self, uint32_t originAS, 
+                      IPPrefix* prefix, uint8_t maxLen, 
+                      uint32_t session_id, uint32_t valCacheID)
 {
   if (belongsToRfc5398(originAS))
   {
@@ -914,51 +2690,41 @@ bool addROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
   // information.
   patricia_node_t* treeNode = NULL;
   // the prefix in patricia tree notation. It is needed to find the pc_prefix 
-  prefix_t*        lookupPrefix = ipPrefixToPrefix_t(prefix);
+  prefix_t         lookupPrefix;
   // This is the prefix the algorithm runs on.
   PC_Prefix*       pcPrefix = NULL;
   // The AS instance
   PC_AS*           pcAS = NULL;
   // The ROA instance
   PC_ROA*          pcROA = NULL;
-  // The as list node
-  SListNode*      asListNode;
-  // The roa list node
-  SListNode*      roaListNode;
+  // The position of the AS within the prefix
+  uint32_t         asPos = 0;
+  // The ROA index of the validation cache
+  PC_ValCache*     valCache = NULL;
   
   
-  WRITE_LOCK(&self->treeLock);
-   
   // Create or get the existing prefix node
   // Return the prefix tree element for the prefix in question. This lookup will
-  // insert the requested prefix in the tree if it doesn't exist already.
-  // Therefore the result value equals NULL can be interpreted as an internal
-  // ERROR.
-  treeNode = patricia_lookup(self->prefixTree, lookupPrefix);
+  // insert a copy of the requested prefix in the tree if it doesn't exist 
+  // already. Therefore the result value equals NULL can be interpreted as an 
+  // internal ERROR.
+  ipPrefixToPrefix_t(prefix, &lookupPrefix);
+  treeNode = patricia_lookup(self->prefixTree, &lookupPrefix);
   if (treeNode == NULL)
   {
     RAISE_ERROR("Failed to append a prefix to the prefix tree");
-    free(lookupPrefix);    
-    UNLOCK_WRITE_LOCK(&self->treeLock);
     return false;
   }
-  
-  // Already existed - need to free given prefix
-  if (lookupPrefix->ref_count == 0) 
-  { // patricia prefix already exists in tree, free unused helper
-    free(lookupPrefix); // prefix already existed. This instance is not used.
-  }
 
   if (treeNode->data == NULL)
   {
     // (Does P exist ? NO) - Created here
-    pcPrefix = malloc(sizeof(PC_Prefix));
-    pcPrefix->treeNode = treeNode;
-    treeNode->data = pcPrefix;
-    initSList(&pcPrefix->asn);
-    initSList(&pcPrefix->other);
-    initSList(&pcPrefix->valid);
-    pcPrefix->roa_coverage = 0;
+    pcPrefix = _createPCPrefix(self, treeNode);
+    if (pcPrefix == NULL)
+    {
+      RAISE_SYS_ERROR("Not enough memory to add a ROA white-list entry!");
+      return false;
+    }
 
     // Exist less Specific P'
     PC_Prefix* pcParent = getParent(pcPrefix->treeNode);
@@ -981,25 +2747,13 @@ bool addROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
   }
   else
   {
-    // free(lookupPrefix); // prefix already existed. This instance is not used.
     pcPrefix = (PC_Prefix*)treeNode->data;
   }
 
   if(pcPrefix!=NULL) 
   {
       // IF P CONTAINS AS
-      FOREACH_SLIST(&pcPrefix->asn, asListNode)
-      {
-	  pcAS = (PC_AS*)asListNode->data;
-	  if (pcAS->asn == originAS)
-	  {      
-	      break;
-	  }
-	  else
-	  {
-	      pcAS = NULL;
-	  }
-      }
+      pcAS = _findAS(pcPrefix, originAS, &asPos);
   } else{
       RAISE_ERROR(" exist! --> patricia tree fetch error");
       RAISE_ERROR(" STOP this point -- press any key");
@@ -1011,49 +2765,39 @@ bool addROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
   if (pcAS == NULL)
   {
     // (P contains AS ? => No
-    pcAS = malloc(sizeof(PC_AS));
-    pcAS->asn = originAS;
-    pcAS->update_count = 0;
-    initSList(&pcAS->roas);
-    appendDataToSList(&pcPrefix->asn, pcAS);
+    pcAS = _insertAS(self, pcPrefix, originAS, asPos);
+    if (pcAS == NULL)
+    {
+      RAISE_SYS_ERROR("Not enough memory to add AS%u to the prefix!",
+                      originAS);
+      return false;
+    }
   }
   
-  FOREACH_SLIST(&pcAS->roas, roaListNode)  
+  pcROA = _findROA(pcAS, maxLen, valCacheID);
+  if (pcROA == NULL)
   {
-    pcROA = (PC_ROA*)roaListNode->data;
-    if (pcROA->valCacheID == valCacheID)
+    valCache = _reserveIndexEntry(self, valCacheID);
+    pcROA    = valCache != NULL ? _insertROA(self, pcAS, maxLen, 
+                                                   valCacheID) : NULL;
+    if (pcROA == NULL)
     {
-      if (pcROA->max_len == maxLen)
-      {
-        break;
-      }
-      else
-      {
-        pcROA = NULL;
-      }
+      RAISE_SYS_ERROR("Not enough memory to add a ROA white-list entry!");
+      return false;
     }
-    else
+    _addIndexEntry(valCache, treeNode, originAS, pcROA);
+    if (++pcPrefix->roaCount == 1)
     {
-      pcROA = NULL;
+      _setROAParents(self, pcPrefix);
     }
   }
-  if (pcROA == NULL)
-  {
-    pcROA = malloc(sizeof(PC_ROA));
-    pcROA->valCacheID = valCacheID;
-    pcROA->as = originAS;
-    pcROA->max_len = maxLen;      
-    pcROA->deferred_count = 0;
-    pcROA->roa_count = 1;
-    pcROA->update_count = 0;
-    appendDataToSList(&pcAS->roas, pcROA);
-  }
   else
   {
     pcROA->roa_count++;
   }  
-  _addROAwl_verifyUpdates(self, pcPrefix, pcROA);
-  UNLOCK_WRITE_LOCK(&self->treeLock);
+  self->noVRPs++;
+  _publishROASet(self, pcPrefix);
+  _addROAwl_verifyUpdates(self, pcPrefix, originAS, pcROA);
   
   //printXML(self, "addROAwl");
   
@@ -1077,12 +2821,10 @@ static void _addROAwl_CheckCoverage(PrefixCache* self, uint8_t prefixLen,
 {
   // The AS instance
   PC_AS*     pcAS = NULL;
-  // The ROA instance
-  PC_ROA*    pcROA = NULL;
-  // The as list node
-  SListNode* asListNode;
-  // The roa list node
-  SListNode* roaListNode;
+  // The ROA index
+  uint16_t   roaIdx;
+  // The AS index
+  uint32_t   asIdx;
   
   LOG(LEVEL_NOTICE,"In Check Parent Coverage!");
   
@@ -1093,23 +2835,19 @@ static void _addROAwl_CheckCoverage(PrefixCache* self, uint8_t prefixLen,
     if (parentPrefix->roa_coverage > 0)
     {
       // FOR EACH P'AS
-      FOREACH_SLIST(&parentPrefix->asn, asListNode)
+      for (asIdx = 0; asIdx < parentPrefix->asnCount; asIdx++)
       {
-        pcAS = (PC_AS*)asListNode->data;
-        if (pcAS->roas.size > 0)
+        pcAS = &parentPrefix->asn[asIdx];
+        // Sorted by descending max length
+        for (roaIdx = 0; (roaIdx < pcAS->roaCount) 
+                         && (pcAS->roas[roaIdx].max_len >= prefixLen); 
+             roaIdx++)
         {
-          FOREACH_SLIST(&pcAS->roas, roaListNode)
-          {
-            pcROA = (PC_ROA*)roaListNode->data;
-            if (pcROA->max_len >= prefixLen)
-            {
-              pcPrefix->roa_coverage += pcROA->roa_count;
-            }
-          }
+          pcPrefix->roa_coverage += pcAS->roas[roaIdx].roa_count;
         }
       }
-      // Get the parent or NULL
-      parentPrefix = getParent(parentPrefix->treeNode);
+      // Get the next parent with ROAs or NULL
+      parentPrefix = parentPrefix->roaParent;
     }
     else
     {
@@ -1120,19 +2858,57 @@ static void _addROAwl_CheckCoverage(PrefixCache* self, uint8_t prefixLen,
 }
 
 
+/** The context of the subtree walks of adding and removing a ROA. */
+typedef struct {
+  /** The AS number of the ROA. */
+  uint32_t               as;
+  /** The ROA. */
+  PC_ROA*                pcROA;
+  /** The Other state of the parent of the prefix the walk starts with. */
+  SRxValidationResultVal parentStateOfOther;
+} PC_ROAwlWalk;
+
 /**
- * This is the subroutine for add ROA whitelist. It returns false in case 
- * something went wrong.
+ * This is the subroutine for add ROA whitelist. It verifies the updates of the
+ * given prefix and of all prefixes below it.
  * 
  * @param self Instance of the prefix cache.
  * @param pcPrefix The prefix to examine
+ * @param as The AS number of the roa.
  * @param pcROA The roa to be added.
  */
 static void _addROAwl_verifyUpdates(PrefixCache* self, PC_Prefix* pcPrefix, 
-                                    PC_ROA* pcROA)
+                                    uint32_t as, PC_ROA* pcROA)
+{
+  PC_ROAwlWalk walk;
+
+  walk.as                 = as;
+  walk.pcROA              = pcROA;
+  walk.parentStateOfOther = SRx_RESULT_NOTFOUND;
+  _walkPrefixes(self, pcPrefix, _addROAwl_verifyPrefix, &walk);
+}
+
+/**
+ * Verify the updates of a single prefix for the added ROA, called for each
+ * prefix of the subtree walk.
+ *
+ * @param self Instance of the prefix cache.
+ * @param pcPrefix The prefix to examine
+ * @param parent The examined parent prefix (not used).
+ * @param context The PC_ROAwlWalk with the AS number and the roa.
+ *
+ * @return true if the children have to be checked as well.
+ *
+ * @since 0.4.1.0
+ */
+static bool _addROAwl_verifyPrefix(PrefixCache* self, PC_Prefix* pcPrefix,
+                                   PC_Prefix* parent, void* context)
 {
-  // nodes in valid list
-  SListNode* validListNode = NULL;
+  PC_ROAwlWalk* walk  = (PC_ROAwlWalk*)context;
+  uint32_t      as    = walk->as;
+  PC_ROA*       pcROA = walk->pcROA;
+  // index in valid list
+  uint32_t   idx;
   // The pc Update
   PC_Update* pcUpdate = NULL;
   // Indicates if children have to be checked as well.
@@ -1145,24 +2921,23 @@ static void _addROAwl_verifyUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
     pcPrefix->roa_coverage++;
     
     // For each matched Update
-    FOREACH_SLIST (&pcPrefix->valid, validListNode)
+    for (idx = _findUpdateAS(&pcPrefix->valid, 0, as); 
+         idx < pcPrefix->valid.size;
+         idx = _findUpdateAS(&pcPrefix->valid, idx + 1, as))
     {
-      pcUpdate = (PC_Update*)validListNode->data;
-      if (pcUpdate->as == pcROA->as)
-      {
-        pcUpdate->roa_match++;
-        pcROA->update_count++;
-      }
+      pcUpdate = pcPrefix->valid.updates[idx];
+      pcUpdate->roa_match++;
+      pcROA->update_count++;
     }
     
     // Move all matches from Other to Valid.
-    _addROAwl_moveMatchedUpdatesToValid(self->updateCache, &pcPrefix->valid,
-                                        &pcPrefix->other, pcROA);
+    _addROAwl_moveMatchedUpdatesToValid(self, &pcPrefix->valid,
+                                        &pcPrefix->other, as, pcROA);
     
     // For Each Update in Other
     if (pcPrefix->state_of_other == SRx_RESULT_NOTFOUND)
     {
-      _ROAwl_changeStateOfOther(self->updateCache, pcPrefix, 
+      _ROAwl_changeStateOfOther(self, pcPrefix, 
                                 SRx_RESULT_INVALID);
     }
     
@@ -1173,127 +2948,78 @@ static void _addROAwl_verifyUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
     // (Does R cover P ? ) => No
     if (pcPrefix->state_of_other == SRx_RESULT_NOTFOUND)
     {
-      _ROAwl_changeStateOfOther(self->updateCache, pcPrefix, 
+      _ROAwl_changeStateOfOther(self, pcPrefix, 
                                 SRx_RESULT_INVALID);
       
       checkChildren = true;
     }
   }
   
-  if (checkChildren)
-  {
-    SList childrenList;
-    SListNode* childrenListNode = NULL;
-    initSList(&childrenList);
-    
-    if (getChildren(&childrenList, pcPrefix->treeNode))
-    {
-      FOREACH_SLIST(&childrenList, childrenListNode)
-      {
-        pcPrefix = (PC_Prefix*)childrenListNode->data;
-        _addROAwl_verifyUpdates(self, pcPrefix, pcROA);
-      }
-      releaseSList(&childrenList);    
-    }
-  }
+  return checkChildren;
 }
 
 /**
  * Change the P::State_of_Other to the given new state and notify all updates 
  * stored in the "other" list.
  * 
- * @param updateCache The update cache
+ * @param self The prefix cache
  * @param pcPrefix The prefix whose updates have to be changed.
  * @param newState The new validation state.
  */
-static void _ROAwl_changeStateOfOther(UpdateCache* updateCache, 
+static void _ROAwl_changeStateOfOther(PrefixCache* self, 
                                       PC_Prefix* pcPrefix, 
                                       SRxValidationResultVal newState)
 {
   PC_Update* pcUpdate;
-  SListNode* otherListNode;
+  uint32_t   idx;
   
   // P::State_of_Other == UNKNOWN ? Yes
   pcPrefix->state_of_other = newState;
-  FOREACH_SLIST(&pcPrefix->other, otherListNode)
+  for (idx = 0; idx < pcPrefix->other.size; idx++)
   {
-    pcUpdate = (PC_Update*)otherListNode->data;
-    notifyUpdateCacheForROAChange(updateCache, &pcUpdate->updateID, newState);
+    pcUpdate = pcPrefix->other.updates[idx];
+    _notifyROAChange(self, pcUpdate, newState);
   }  
 }
 
 /**
  * Moves the list nodes from otherList to validList.
  * 
- * @param updateCache The cache containing the updates that are affected. 
+ * @param self The prefix cache containing the updates that are affected. 
  * @param validList the list of valid updates.
  * @param otherList the list of not valid updates.
+ * @param as The AS number of the ROA.
  * @param pcROA the ROA that is used to match updates.
  */
-static void _addROAwl_moveMatchedUpdatesToValid(UpdateCache* updateCache, 
-                                                SList* validList, 
-                                                SList* otherList, PC_ROA* pcROA)
+static void _addROAwl_moveMatchedUpdatesToValid(PrefixCache* self, 
+                                                PC_UpdateArray* validList, 
+                                                PC_UpdateArray* otherList, 
+                                                uint32_t as, PC_ROA* pcROA)
 {
-  SListNode* nodeToMove = NULL;
-  SListNode* currNode = otherList->root;
-  SListNode* prevNode = NULL;
   PC_Update* pcUpdate;
+  uint32_t   readIdx  = _findUpdateAS(otherList, 0, as);
+  uint32_t   writeIdx = readIdx;
   
-  // For each matched Update Do:
-  while (currNode != NULL)
+  // For each matched Update Do: Compact the other list in place while moving
+  // the matched updates into the valid list. The updates in front of the 
+  // first match stay where they are.
+  for (; readIdx < otherList->size; readIdx++)
   {
-    pcUpdate = (PC_Update*)currNode->data;
-    if (pcUpdate->as == pcROA->as)
+    pcUpdate = otherList->updates[readIdx];
+    if ((otherList->asns[readIdx] == as) 
+        && _addToUpdateArray(&self->arena->arrayPool, validList, pcUpdate))
     {
-      nodeToMove = currNode;
       pcUpdate->roa_match++;
       pcROA->update_count++;
-      notifyUpdateCacheForROAChange(updateCache, &pcUpdate->updateID, 
-                                    SRx_RESULT_VALID);
+      _notifyROAChange(self, pcUpdate, SRx_RESULT_VALID);
     }
     else
     {
-      prevNode = currNode;
-    }
-    
-    // Advance in list to not loose the next pointer
-    currNode = currNode->next;
-    
-    if (nodeToMove != NULL)
-    {
-      // Remove Node from Other
-      otherList->size--;
-      if (prevNode == NULL)
-      {
-        // Node was the List Head
-        otherList->root = nodeToMove->next;
-      }
-      else
-      {        
-        prevNode->next = nodeToMove->next;
-      }
-      
-      if (nodeToMove->next == NULL)
-      {
-        // Node was last node
-        otherList->last = prevNode;
-      }
-      
-      // Now add it into valid list
-      validList->size++;
-      nodeToMove->next = NULL;
-      if (validList->root == NULL)
-      {
-        validList->root  = nodeToMove;
-      }
-      else
-      {
-        validList->last->next = nodeToMove;
-      }
-      validList->last = nodeToMove;
-      nodeToMove = NULL;
+      otherList->asns[writeIdx]      = otherList->asns[readIdx];
+      otherList->updates[writeIdx++] = pcUpdate;
     }
-  }  
+  }
+  otherList->size = writeIdx;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1301,10 +3027,16 @@ static void _addROAwl_moveMatchedUpdatesToValid(UpdateCache* updateCache,
 ////////////////////////////////////////////////////////////////////////////////
 
 static void _delROAwl_validateUpdates(PrefixCache* self, PC_Prefix* pcPrefix, 
-                      PC_ROA* pcROA, SRxValidationResultVal parentStateOfOther);
+                      uint32_t as, PC_ROA* pcROA, 
+                      SRxValidationResultVal parentStateOfOther);
+static bool _delROAwl_validatePrefix(PrefixCache* self, PC_Prefix* pcPrefix,
+                                     PC_Prefix* parent, void* context);
 
-static void _delROAwl_moveToOther(UpdateCache* updateCache, PC_Prefix* pcPrefix, 
-                                  PC_ROA* pcROA);
+static void _delROAwl_moveToOther(PrefixCache* self, PC_Prefix* pcPrefix, 
+                                  uint32_t as, PC_ROA* pcROA);
+static bool _delROAwl(PrefixCache* self, uint32_t originAS, 
+                      IPPrefix* prefix, uint8_t maxLen, 
+                      uint32_t session_id, uint32_t valCacheID);
 
 /**
  * Delete the given ROA white-list entry provided by the specified validation 
@@ -1322,47 +3054,54 @@ static void _delROAwl_moveToOther(UpdateCache* updateCache, PC_Prefix* pcPrefix,
  */
 bool delROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix, 
               uint8_t maxLen, uint32_t session_id, uint32_t valCacheID)
+{
+  bool retVal;
+  
+  if (_isSharedROAsAttached(self))
+  {
+    return true;
+  }
+  WRITE_LOCK(&self->treeLock);
+  _registerPendingUpdates(self);
+  retVal = _delROAwl(self, originAS, prefix, maxLen, session_id, valCacheID);
+  reclaimEpochData(&self->epoch);
+  UNLOCK_WRITE_LOCK(&self->treeLock);
+  _tryRegisterPendingUpdates(self);
+  
+  return retVal;
+}
+
+/**
+ * Same as delROAwl but expects the caller to hold the write lock of the prefix
+ * tree.
+ * 
+ * @since 0.4.1.0
+ */
+static bool _delROAwl(PrefixCache* self, uint32_t originAS, 
+                      IPPrefix* prefix, uint8_t maxLen, 
+                      uint32_t session_id, uint32_t valCacheID)
 {
   // the node within the prefix tree. the data of it is the PC_prefix 
   // information.
   patricia_node_t* treeNode = NULL;
   // the prefix in patricia tree notation. It is needed to find the pc_prefix 
-  prefix_t*        lookupPrefix = ipPrefixToPrefix_t(prefix);
+  prefix_t         lookupPrefix;
   // This is the prefix the algorithm runs on.
   PC_Prefix*       pcPrefix = NULL;
   // The AS instance
   PC_AS*           pcAS = NULL;
   // The ROA instance
   PC_ROA*          pcROA = NULL;
-  // The AS list node  
-  SListNode*       asListNode = NULL;
-  // The ROA list node  
-  SListNode*       roaListNode = NULL;
+  // The index position of the ROA
+  uint32_t         cacheIdx;
   
   
-  WRITE_LOCK(&self->treeLock);
-   
-  // Create or get the existing prefix node
-  // Return the prefix tree element for the prefix in question. This lookup will
-  // insert the requested prefix in the tree if it doesn't exist already.
-  // Therefore the result value equals NULL can be interpreted as an internal
-  // ERROR.
-  treeNode = patricia_lookup(self->prefixTree, lookupPrefix);
-  if (treeNode == NULL)
-  {
-    RAISE_ERROR("Failed to access the prefix tree");
-    free(lookupPrefix);    
-    UNLOCK_WRITE_LOCK(&self->treeLock);
-    return false;
-  }
-  
-  // Already existed - need to free given prefix
-  if (lookupPrefix->ref_count == 0)
-  {
-    free(lookupPrefix); // prefix already existed. This instance is not used.
-  }
+  // Get the existing prefix node. A withdrawal never adds a prefix to the 
+  // tree, a prefix that is not found is handled like a prefix without data.
+  ipPrefixToPrefix_t(prefix, &lookupPrefix);
+  treeNode = patricia_search_exact(self->prefixTree, &lookupPrefix);
  
-  if (treeNode->data == NULL)
+  if ((treeNode == NULL) || (treeNode->data == NULL))
   {
     if (belongsToRfc5398(originAS))
     {
@@ -1378,75 +3117,40 @@ bool delROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
       RAISE_ERROR("Received a ROA white-list withdrawal for an entry that does "
                   "not exist!");
     }
-    UNLOCK_WRITE_LOCK(&self->treeLock);
     return false;
   }
   else
   {
-  //  free(lookupPrefix); // prefix already existed. This instance is not used.
     pcPrefix = (PC_Prefix*)treeNode->data;
   }
 
   if(pcPrefix!=NULL) 
   {
     // find the ROA to be deleted
-    FOREACH_SLIST(&pcPrefix->asn, asListNode)
-    {
-      pcAS = (PC_AS*)asListNode->data;
-      if (pcAS->asn == originAS)
-      {
-        break;
-      }
-      else
-      {
-        pcAS = NULL;
-      }
-    }
+    pcAS = _findAS(pcPrefix, originAS, NULL);
   }
   else
   {
     RAISE_ERROR("Received a ROA white-list withdrawal for an entry that does "
                 "not exist! --> patricia tree fetch error");
-    UNLOCK_WRITE_LOCK(&self->treeLock);
     RAISE_ERROR(" STOP this point -- press any key");
     getchar();
     return false;    
   }
   
-  if (pcAS == NULL)
-  {
-    RAISE_ERROR("Received a ROA white-list withdrawal for an entry that does "
-                "not exist!");
-    UNLOCK_WRITE_LOCK(&self->treeLock);
-    return false;    
-  }
-  
-  FOREACH_SLIST(&pcAS->roas, roaListNode)
-  {
-    pcROA = (PC_ROA*)roaListNode->data;
-      if (pcROA->valCacheID == valCacheID)
-    {
-      if (pcROA->max_len == maxLen)
-      {
-        // FOUND!!!!
-        break;
-      }
-      else
-      {
-        pcROA = NULL;        
-      }
-    }
-    else
-    {
-      pcROA = NULL;
-    }
+  if (pcAS == NULL)
+  {
+    RAISE_ERROR("Received a ROA white-list withdrawal for an entry that does "
+                "not exist!");
+    return false;    
   }
   
+  pcROA = _findROA(pcAS, maxLen, valCacheID);
+  
   if (pcROA == NULL)
   {
     RAISE_ERROR("Received a ROA white-list withdrawal for an entry that does "
                 "not exist!");
-    UNLOCK_WRITE_LOCK(&self->treeLock);
     return false;    
   } 
   
@@ -1455,44 +3159,57 @@ bool delROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
   if (pcParentPrefix != NULL)
   {
     // (Exist less specific P') ?  => Yes
-    _delROAwl_validateUpdates(self, pcPrefix, pcROA, 
+    _delROAwl_validateUpdates(self, pcPrefix, originAS, pcROA, 
                               pcParentPrefix->state_of_other);    
   }
   else
   {
     // (Exist less specific P') ?  => No
-    _delROAwl_validateUpdates(self, pcPrefix, pcROA, SRx_RESULT_NOTFOUND);
+    _delROAwl_validateUpdates(self, pcPrefix, originAS, pcROA, 
+                              SRx_RESULT_NOTFOUND);
   }
   
   pcROA->roa_count--;
+  self->noVRPs--;
   if (pcROA->roa_count < 0)
   {
     RAISE_SYS_ERROR("BUG in code, ROA Count should not go below 0!");
   }
   
+  if (pcROA->deferred_count > pcROA->roa_count)
+  {
+    pcROA->deferred_count = pcROA->roa_count;
+  }
+  
   if (pcROA->roa_count == 0)
   {
     LOG(LEVEL_DEBUG, HDR "Remove ROA entry!", pthread_self());
-    deleteFromSList(&pcAS->roas, pcROA);
-    free(pcROA);
+    cacheIdx = pcROA->cacheIdx;
+    _removeROA(pcAS, pcROA);
+    _removeIndexEntry(self, valCacheID, cacheIdx);
+    if (--pcPrefix->roaCount == 0)
+    {
+      _setROAParents(self, pcPrefix);
+    }
     
-    if (pcAS->roas.size == 0)
+    if (pcAS->roaCount == 0)
     {      
       if (pcAS->update_count == 0)
       {
         LOG(LEVEL_DEBUG, HDR "Remove AS from prefix!", pthread_self());
-        deleteFromSList(&pcPrefix->asn, pcAS);
-        free(pcAS);
-        
-        if (pcPrefix->asn.size == 0)
-        {
-          free(pcPrefix);
-          treeNode->data = NULL;
-        }
+        _removeAS(self, pcPrefix, pcAS);
       }
     }
+    
+    if (pcPrefix->asnCount == 0)
+    {
+      _retirePrefix(self, pcPrefix);
+    }
+    else
+    {
+      _publishROASet(self, pcPrefix);
+    }
   }
-  UNLOCK_WRITE_LOCK(&self->treeLock);
   
   //printXML(self, "delROAwl");
   
@@ -1504,12 +3221,45 @@ bool delROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
  * 
  * @param self The prefix cache
  * @param pcPrefix The prefix itself
+ * @param as The AS number of the ROA
  * @param pcROA The ROA
  * @param parentStateOfOther the Other state of the parent.
  */
 static void _delROAwl_validateUpdates(PrefixCache* self, PC_Prefix* pcPrefix, 
-                     PC_ROA* pcROA, SRxValidationResultVal parentStateOfOther)
+                     uint32_t as, PC_ROA* pcROA, 
+                     SRxValidationResultVal parentStateOfOther)
+{
+  PC_ROAwlWalk walk;
+
+  walk.as                 = as;
+  walk.pcROA              = pcROA;
+  walk.parentStateOfOther = parentStateOfOther;
+  _walkPrefixes(self, pcPrefix, _delROAwl_validatePrefix, &walk);
+}
+
+/**
+ * Re-validate the updates of a single prefix for the removed ROA, called for
+ * each prefix of the subtree walk.
+ *
+ * @param self The prefix cache
+ * @param pcPrefix The prefix itself
+ * @param parent The examined parent prefix, NULL for the first prefix.
+ * @param context The PC_ROAwlWalk with the AS number, the ROA and the Other
+ *                state of the parent of the first prefix.
+ *
+ * @return true if the children have to be checked as well.
+ *
+ * @since 0.4.1.0
+ */
+static bool _delROAwl_validatePrefix(PrefixCache* self, PC_Prefix* pcPrefix,
+                                     PC_Prefix* parent, void* context)
 {
+  PC_ROAwlWalk*          walk  = (PC_ROAwlWalk*)context;
+  uint32_t               as    = walk->as;
+  PC_ROA*                pcROA = walk->pcROA;
+  SRxValidationResultVal parentStateOfOther = parent != NULL
+                                              ? parent->state_of_other
+                                              : walk->parentStateOfOther;
   bool checkForChildren = false;
   
   if (pcPrefix->treeNode->prefix->bitlen <= pcROA->max_len)
@@ -1525,173 +3275,826 @@ static void _delROAwl_validateUpdates(PrefixCache* self, PC_Prefix* pcPrefix,
     {
       if (pcPrefix->roa_coverage == 0)
       {
-        _ROAwl_changeStateOfOther(self->updateCache, pcPrefix, 
+        _ROAwl_changeStateOfOther(self, pcPrefix, 
                                   SRx_RESULT_NOTFOUND);        
       }
     }
-    _delROAwl_moveToOther(self->updateCache, pcPrefix, pcROA);
+    _delROAwl_moveToOther(self, pcPrefix, as, pcROA);
     checkForChildren = true;
   }
   else
   {
-    // (Does R cover P) ? => No
-    if (pcPrefix->roa_coverage == 0)
-    {
-      if (parentStateOfOther == SRx_RESULT_NOTFOUND)
-      {
-        _ROAwl_changeStateOfOther(self->updateCache, pcPrefix, 
-                                  SRx_RESULT_NOTFOUND);
-        checkForChildren = true;        
-      }
-    }
+    // (Does R cover P) ? => No
+    if (pcPrefix->roa_coverage == 0)
+    {
+      if (parentStateOfOther == SRx_RESULT_NOTFOUND)
+      {
+        _ROAwl_changeStateOfOther(self, pcPrefix, 
+                                  SRx_RESULT_NOTFOUND);
+        checkForChildren = true;        
+      }
+    }
+  }
+  
+  return checkForChildren;
+}
+
+/**
+ * Move all possible matches from valid into other
+ * @param self The prefix cache whose update cache is informed in case an 
+ *             update changes validation state.
+ * @param pcPrefix The prefix under investigation 
+ * @param as The AS number of the ROA
+ * @param pcROA the ROA that is removed
+ */
+static void _delROAwl_moveToOther(PrefixCache* self, PC_Prefix* pcPrefix, 
+                                  uint32_t as, PC_ROA* pcROA)
+{
+  PC_UpdateArray* validList = &pcPrefix->valid;
+  PC_Update*      pcUpdate;
+  uint32_t        readIdx  = _findUpdateAS(validList, 0, as);
+  uint32_t        writeIdx = readIdx;
+  
+  // For each matched Update Do: Compact the valid list in place while moving
+  // the updates without any further ROA match into the other list. The 
+  // updates in front of the first match stay where they are.
+  for (; readIdx < validList->size; readIdx++)
+  {
+    pcUpdate = validList->updates[readIdx];
+    if ((validList->asns[readIdx] == as) && (pcROA->update_count > 0))
+    {
+      pcUpdate->roa_match--;
+      if (pcROA->roa_count == 1)
+      { // because this is the last ROA to delete, remove update count.
+        pcROA->update_count--;
+      }
+      if (pcUpdate->roa_match < 0)
+      {
+        RAISE_SYS_ERROR("BUG: ROA Count in update MUST NOT go below 0!");
+      }
+      if (pcROA->roa_count < 0)
+      {
+        RAISE_SYS_ERROR("BUG: ROA Count in ROA MUST NOT go below 0!");
+      }
+      
+      if (   (pcUpdate->roa_match == 0) 
+          && _addToUpdateArray(&self->arena->arrayPool, &pcPrefix->other,
+                               pcUpdate))
+      {
+        _notifyROAChange(self, pcUpdate, pcPrefix->state_of_other);
+        continue;
+      }
+    }
+    validList->asns[writeIdx]      = validList->asns[readIdx];
+    validList->updates[writeIdx++] = pcUpdate;
+  }
+  validList->size = writeIdx;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// APPLY A BATCH OF ROA WHITELIST CHANGES
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Apply the given list of ROA white-list announcements and withdrawals and 
+ * report the final state of each affected update. The caller MUST hold the 
+ * write lock of the tree.
+ * 
+ * @param self The prefix cache
+ * @param changes The ROA white-list changes in the order received.
+ * @param noChanges The number of changes.
+ * 
+ * @return The number of changes that could be applied.
+ * 
+ * @since 0.4.1.0
+ */
+static uint32_t _applyROAwlChanges(PrefixCache* self, PC_ROAwlChange* changes, 
+                                   uint32_t noChanges)
+{
+  PC_ROAwlChange*        change;
+  PC_Update*             pcUpdate;
+  PC_Prefix*             pcPrefix;
+  SRxValidationResultVal newState;
+  uint32_t               applied = 0;
+  uint32_t               idx;
+  
+  // Apply all changes, the notifications are collected in batchUpdates.
+  self->inBatch = true;
+  for (idx = 0; idx < noChanges; idx++)
+  {
+    change = &changes[idx];
+    if (change->isAnn ? _addROAwl(self, change->originAS, &change->prefix,
+                                  change->maxLen, change->session_id, 
+                                  change->valCacheID)
+                      : _delROAwl(self, change->originAS, &change->prefix,
+                                  change->maxLen, change->session_id, 
+                                  change->valCacheID))
+    {
+      applied++;
+    }
+  }
+  self->inBatch = false;
+  
+  // Now report the final state of each affected update. The update cache only
+  // notifies the clients if the result differs from the one stored.
+  for (idx = 0; idx < self->batchUpdates.size; idx++)
+  {
+    pcUpdate = self->batchUpdates.updates[idx];
+    pcUpdate->notifyPending = false;
+    if (pcUpdate->roa_match > 0)
+    {
+      newState = SRx_RESULT_VALID;
+    }
+    else
+    {
+      pcPrefix = (PC_Prefix*)pcUpdate->treeNode->data;
+      newState = pcPrefix != NULL ? pcPrefix->state_of_other 
+                                  : SRx_RESULT_NOTFOUND;
+    }
+    _notifyUpdateRecord(self, pcUpdate, newState);
+  }
+  LOG(LEVEL_DEBUG, HDR "Applied %u of %u ROA white-list changes affecting %u "
+                   "updates!", pthread_self(), applied, noChanges, 
+                   self->batchUpdates.size);
+  self->batchUpdates.size = 0;
+  
+  return applied;
+}
+
+/**
+ * Apply the given list of ROA white-list announcements and withdrawals in one
+ * pass. The prefix tree stays write locked for the complete batch and each 
+ * affected update reports its final validation state only once after all 
+ * changes are applied.
+ * 
+ * @param self The prefix cache
+ * @param changes The ROA white-list changes in the order received.
+ * @param noChanges The number of changes.
+ * 
+ * @return The number of changes that could be applied.
+ * 
+ * @since 0.4.1.0
+ */
+uint32_t applyROAwlChanges(PrefixCache* self, PC_ROAwlChange* changes, 
+                           uint32_t noChanges)
+{
+  uint32_t applied;
+  
+  if (_isSharedROAsAttached(self))
+  {
+    return noChanges;
+  }
+  WRITE_LOCK(&self->treeLock);
+  // Updates validated until now
+  _registerPendingUpdates(self);
+  applied = _applyROAwlChanges(self, changes, noChanges);
+  reclaimEpochData(&self->epoch);
+  UNLOCK_WRITE_LOCK(&self->treeLock);
+  _tryRegisterPendingUpdates(self);
+  
+  return applied;
+}
+
+/**
+ * Export all ROA white-list entries as announcements. A ROA that represents
+ * multiple identical ROAs is exported once for each of them. Applying the
+ * exported changes to an empty prefix cache rebuilds the same white-list.
+ * 
+ * @param self The prefix cache
+ * @param session_id The session id stored in each change.
+ * @param changes OUT - The exported changes. The array is allocated and must 
+ *                be freed by the caller, NULL if nothing is exported.
+ * @param noChanges OUT - The number of exported changes.
+ * 
+ * @return false if not enough memory was available.
+ * 
+ * @since 0.4.1.0
+ */
+bool exportROAwl(PrefixCache* self, uint32_t session_id,
+                 PC_ROAwlChange** changes, uint32_t* noChanges)
+{
+  patricia_node_t* treeNode;
+  PC_Prefix*       pcPrefix;
+  PC_AS*           pcAS;
+  PC_ROA*          pcROA;
+  PC_ROAwlChange*  change;
+  IPPrefix         prefix;
+  bool             retVal = true;
+  uint32_t         asIdx;
+  uint16_t         roaIdx;
+  uint16_t         count;
+  
+  *changes   = NULL;
+  *noChanges = 0;
+  READ_LOCK(&self->treeLock);
+  // Count first to allocate the changes in one piece.
+  PATRICIA_WALK(self->prefixTree->head, treeNode)
+  {
+    pcPrefix = (PC_Prefix*)treeNode->data;
+    for (asIdx = 0; (pcPrefix != NULL) && (asIdx < pcPrefix->asnCount); asIdx++)
+    {
+      pcAS = &pcPrefix->asn[asIdx];
+      for (roaIdx = 0; roaIdx < pcAS->roaCount; roaIdx++)
+      {
+        *noChanges += pcAS->roas[roaIdx].roa_count;
+      }
+    }
+  } PATRICIA_WALK_END;
+  
+  if (*noChanges > 0)
+  {
+    *changes = malloc(*noChanges * sizeof(PC_ROAwlChange));
+    if (*changes == NULL)
+    {
+      RAISE_SYS_ERROR("Not enough memory to export %u ROA white-list entries!",
+                      *noChanges);
+      *noChanges = 0;
+      retVal     = false;
+    }
+  }
+  
+  change = *changes;
+  if (change != NULL)
+  {
+    PATRICIA_WALK(self->prefixTree->head, treeNode)
+    {
+      pcPrefix = (PC_Prefix*)treeNode->data;
+      if ((pcPrefix != NULL) && (pcPrefix->asnCount > 0))
+      {
+        prefix_tToIPPrefix(treeNode->prefix, &prefix);
+      }
+      for (asIdx = 0; (pcPrefix != NULL) && (asIdx < pcPrefix->asnCount); 
+           asIdx++)
+      {
+        pcAS = &pcPrefix->asn[asIdx];
+        for (roaIdx = 0; roaIdx < pcAS->roaCount; roaIdx++)
+        {
+          pcROA = &pcAS->roas[roaIdx];
+          for (count = 0; count < pcROA->roa_count; count++)
+          {
+            change->isAnn      = true;
+            change->originAS   = pcAS->asn;
+            change->prefix     = prefix;
+            change->maxLen     = pcROA->max_len;
+            change->session_id = session_id;
+            change->valCacheID = pcROA->valCacheID;
+            change++;
+          }
+        }
+      }
+    } PATRICIA_WALK_END;
+  }
+  UNLOCK_READ_LOCK(&self->treeLock);
+  _tryRegisterPendingUpdates(self);
+  
+  return retVal;
+}
+
+/**
+ * Use the given shared ROA table. A table created for the publication gets
+ * the white-list of the prefix cache published by publishSharedROAs. An
+ * attached table replaces the white-list: ROA white-list changes are dropped,
+ * updates are validated using the table and revalidated by
+ * refreshSharedROAs. Must be called before the first update or ROA is added.
+ *
+ * @param self The prefix cache
+ * @param table The shared ROA table.
+ *
+ * @since 0.4.1.0
+ */
+void setSharedROATable(PrefixCache* self, SharedROATable* table)
+{
+  self->sharedROAs = table;
+  // The empty white-list is published as well.
+  self->sharedGeneration = table->readOnly ? 0 : UINT64_MAX;
+}
+
+/**
+ * Publish the ROA white-list into the shared ROA table if it changed since
+ * the last publication. The tree is read locked while the ROAs are copied.
+ *
+ * @param self The prefix cache
+ *
+ * @return false if the white-list could not be published.
+ *
+ * @since 0.4.1.0
+ */
+bool publishSharedROAs(PrefixCache* self)
+{
+  patricia_node_t* treeNode;
+  PC_Prefix*       pcPrefix;
+  PC_AS*           pcAS;
+  SharedROA*       roas;
+  SharedROA*       roa;
+  uint32_t         generation;
+  uint32_t         count = 0;
+  uint32_t         asIdx;
+  uint16_t         roaIdx;
+
+  if (   (self->sharedROAs == NULL) || self->sharedROAs->readOnly
+      || (self->roaGeneration == self->sharedGeneration))
+  {
+    return true;
+  }
+
+  READ_LOCK(&self->treeLock);
+  generation = self->roaGeneration;
+  // Identical ROAs of different validation caches are published once.
+  PATRICIA_WALK(self->prefixTree->head, treeNode)
+  {
+    pcPrefix = (PC_Prefix*)treeNode->data;
+    for (asIdx = 0; (pcPrefix != NULL) && (asIdx < pcPrefix->asnCount); asIdx++)
+    {
+      count += pcPrefix->asn[asIdx].roaCount;
+    }
+  } PATRICIA_WALK_END;
+
+  roas = beginSharedROAPublication(self->sharedROAs, count);
+  roa  = roas;
+  if (roa != NULL)
+  {
+    PATRICIA_WALK(self->prefixTree->head, treeNode)
+    {
+      pcPrefix = (PC_Prefix*)treeNode->data;
+      for (asIdx = 0; (pcPrefix != NULL) && (asIdx < pcPrefix->asnCount);
+           asIdx++)
+      {
+        pcAS = &pcPrefix->asn[asIdx];
+        for (roaIdx = 0; roaIdx < pcAS->roaCount; roaIdx++)
+        {
+          memset(roa, 0, sizeof(SharedROA));
+          if (treeNode->prefix->family == AF_INET)
+          {
+            roa->family = SHARED_ROA_V4;
+            memcpy(roa->addr, &treeNode->prefix->add.sin, 4);
+          }
+          else
+          {
+            roa->family = SHARED_ROA_V6;
+            memcpy(roa->addr, &treeNode->prefix->add.sin6, 16);
+          }
+          roa->len     = treeNode->prefix->bitlen;
+          roa->as      = pcAS->asn;
+          roa->max_len = pcAS->roas[roaIdx].max_len;
+          roa++;
+        }
+      }
+    } PATRICIA_WALK_END;
+  }
+  UNLOCK_READ_LOCK(&self->treeLock);
+  _tryRegisterPendingUpdates(self);
+
+  if (roas == NULL)
+  {
+    return false;
+  }
+  endSharedROAPublication(self->sharedROAs, count);
+  self->sharedGeneration = generation;
+
+  return true;
+}
+
+/** A validation state changed by a new generation of the shared ROAs. */
+typedef struct {
+  /** The update. */
+  SRxUpdateID            updateID;
+  /** The new validation state. */
+  SRxValidationResultVal roaResult;
+} PC_SharedChange;
+
+/** The state of the revalidation using the shared ROAs. */
+typedef struct {
+  /** The prefix cache. */
+  PrefixCache* self;
+  /** The changed validation states, PC_SharedChange. */
+  Vector       changes;
+  /** Set if not all updates could be revalidated. */
+  bool         incomplete;
+} PC_SharedRevalidation;
+
+/**
+ * Update cache visitor that revalidates an update using the shared ROAs and
+ * collects the changed validation states. The caller is within the epoch.
+ *
+ * @see UpdateCacheVisitor
+ *
+ * @since 0.4.1.0
+ */
+static bool _revalidateSharedUpdate(void* user, SRxUpdateID* updateID,
+                                    uint32_t asn, IPPrefix* prefix,
+                                    SRxDefaultResult* defResult,
+                                    SRxResult* srxResult, uint8_t* blob,
+                                    uint32_t blobLength, bool bgpsecAttr)
+{
+  PC_SharedRevalidation* reval = (PC_SharedRevalidation*)user;
+  PC_SharedChange        change;
+  prefix_t               lookupPrefix;
+
+  // Only updates with an origin validation state.
+  if (   (srxResult->roaResult != SRx_RESULT_VALID)
+      && (srxResult->roaResult != SRx_RESULT_NOTFOUND)
+      && (srxResult->roaResult != SRx_RESULT_INVALID))
+  {
+    return true;
+  }
+  ipPrefixToPrefix_t(prefix, &lookupPrefix);
+  if (!_lookupSharedROAs(reval->self, &lookupPrefix, asn, &change.roaResult))
+  {
+    reval->incomplete = true;
+  }
+  else if (change.roaResult != srxResult->roaResult)
+  {
+    change.updateID = *updateID;
+    if (!appendDataToVector(&reval->changes, &change))
+    {
+      reval->incomplete = true;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Map the attached shared ROA table again if it was replaced and revalidate
+ * all updates of the update cache if a new generation of the table was
+ * published. Changed validation states are reported to the update cache.
+ * Must not be called concurrently.
+ *
+ * @param self The prefix cache
+ *
+ * @return The number of updates whose validation state changed.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t refreshSharedROAs(PrefixCache* self)
+{
+  PC_SharedRevalidation reval;
+  PC_SharedChange*      change;
+  SharedROAMap*         oldMap;
+  uint64_t              generation;
+  uint32_t              idx;
+  uint32_t              count;
+
+  if (!_isSharedROAsAttached(self))
+  {
+    return 0;
+  }
+  generation = refreshSharedROATable(self->sharedROAs, &oldMap);
+  if (oldMap != NULL)
+  {
+    // Lookups might still use the replaced mapping.
+    synchronizeEpoch(&self->epoch);
+    releaseSharedROAMap(oldMap);
+    self->sharedGeneration = 0;
+  }
+  if ((generation == 0) || (generation == self->sharedGeneration))
+  {
+    return 0;
+  }
+
+  reval.self       = self;
+  reval.incomplete = false;
+  initVector(&reval.changes, sizeof(PC_SharedChange));
+  if (!enterEpoch(&self->epoch))
+  {
+    releaseVector(&reval.changes);
+    return 0;
+  }
+  walkUpdateCache(self->updateCache, _revalidateSharedUpdate, &reval);
+  leaveEpoch(&self->epoch);
+
+  // The update cache is not locked anymore.
+  count = sizeOfVector(&reval.changes);
+  for (idx = 0; idx < count; idx++)
+  {
+    change = (PC_SharedChange*)getFromVector(&reval.changes, idx);
+    notifyUpdateCacheForROAChange(self->updateCache, &change->updateID,
+                                  change->roaResult);
+  }
+  releaseVector(&reval.changes);
+  // An incomplete revalidation is repeated with the next refresh.
+  if (!reval.incomplete)
+  {
+    self->sharedGeneration = generation;
+  }
+  LOG(LEVEL_INFO, HDR "Shared ROA table generation %llu, %u updates changed",
+                  pthread_self(), (unsigned long long)generation, count);
+
+  return count;
+}
+
+/** An update whose origin validation is still undefined. */
+typedef struct {
+  /** The update. */
+  SRxUpdateID updateID;
+  /** The origin AS of the update. */
+  uint32_t    asn;
+  /** The prefix of the update. */
+  IPPrefix    prefix;
+} PC_ProvisionalUpdate;
+
+/**
+ * Update cache visitor that collects the updates without origin validation
+ * state in the given vector of PC_ProvisionalUpdate.
+ *
+ * @see UpdateCacheVisitor
+ *
+ * @since 0.4.1.0
+ */
+static bool _collectProvisionalUpdate(void* user, SRxUpdateID* updateID,
+                                      uint32_t asn, IPPrefix* prefix,
+                                      SRxDefaultResult* defResult,
+                                      SRxResult* srxResult, uint8_t* blob,
+                                      uint32_t blobLength, bool bgpsecAttr)
+{
+  PC_ProvisionalUpdate update;
+
+  if (srxResult->roaResult != SRx_RESULT_UNDEFINED)
+  {
+    return true;
+  }
+  update.updateID = *updateID;
+  update.asn      = asn;
+  update.prefix   = *prefix;
+
+  // Stop the walk if no memory is left, the collected updates are validated.
+  return appendDataToVector((Vector*)user, &update);
+}
+
+/**
+ * Request the origin validation of all updates of the update cache whose
+ * origin validation state is still undefined, e.g. the updates received
+ * before the first validation cache was synchronized. The changed states are
+ * reported to the update cache as for any other validation.
+ *
+ * @param self The prefix cache
+ *
+ * @return The number of updates whose validation was requested.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t validateProvisionalUpdates(PrefixCache* self)
+{
+  PC_ProvisionalUpdate* update;
+  Vector                updates;
+  uint32_t              idx;
+  uint32_t              count;
+
+  initVector(&updates, sizeof(PC_ProvisionalUpdate));
+  if (!walkUpdateCache(self->updateCache, _collectProvisionalUpdate,
+                       &updates))
+  {
+    RAISE_ERROR("Not enough memory to validate all provisional updates!");
   }
-  
-  if (checkForChildren)
+
+  // The update cache is not locked anymore.
+  count = sizeOfVector(&updates);
+  for (idx = 0; idx < count; idx++)
   {
-    SList childrenList;
-    SListNode* childrenListNode = NULL;
-    PC_Prefix* childPrefix = NULL;
-    initSList(&childrenList);
-    
-    if (getChildren(&childrenList, pcPrefix->treeNode))
-    {
-      FOREACH_SLIST(&childrenList, childrenListNode)
-      {
-        childPrefix = (PC_Prefix*)childrenListNode->data;
-        _delROAwl_validateUpdates(self, childPrefix, pcROA, 
-                                  pcPrefix->state_of_other);
-      }
-      releaseSList(&childrenList);
-    }
+    update = (PC_ProvisionalUpdate*)getFromVector(&updates, idx);
+    requestUpdateValidation(self, &update->updateID, &update->prefix,
+                            update->asn);
   }
+  releaseVector(&updates);
+  LOG(LEVEL_INFO, HDR "Validated %u updates received before the first "
+                  "synchronization", pthread_self(), count);
+
+  return count;
 }
 
 /**
- * Move all possible matches from valid into other
- * @param updateCache The update cache to be informed in case an update changes
- *                    validation state.
- * @param pcPrefix The prefix under investigation 
- * @param pcROA the ROA that is removed
+ * Determine the memory used by the ROA white-list. The updates are not 
+ * included.
+ * 
+ * @param self The prefix cache
+ * @param stats OUT - The memory statistics.
+ * 
+ * @since 0.4.1.0
  */
-static void _delROAwl_moveToOther(UpdateCache* updateCache, PC_Prefix* pcPrefix, 
-                                  PC_ROA* pcROA)
+void getPrefixCacheMemory(PrefixCache* self, PC_MemoryStats* stats)
 {
-  SListNode* nodeToMove = NULL;
-  SListNode* currNode = pcPrefix->valid.root;
-  SListNode* prevNode = NULL;
-  PC_Update* pcUpdate;
-  
-  // For each matched Update Do:
-  while ((currNode != NULL) && (pcROA->update_count > 0))
+  patricia_node_t* treeNode;
+  PC_Prefix*       pcPrefix;
+  PC_AS*           pcAS;
+  PC_ValCache*     valCache;
+  PC_ValCache*     tmp;
+  PC_ROASet*       roaSet;
+  MemPool*         memPool;
+  uint32_t         asIdx;
+  uint16_t         roaIdx;
+  int              idx;
+
+  memset(stats, 0, sizeof(PC_MemoryStats));
+  READ_LOCK(&self->treeLock);
+  stats->treeBytes = self->prefixTree->num_active_node 
+                     * (sizeof(patricia_node_t) + sizeof(prefix_t));
+  PATRICIA_WALK(self->prefixTree->head, treeNode)
   {
-    pcUpdate = (PC_Update*)currNode->data;
-    if (pcUpdate->as == pcROA->as)
+    pcPrefix = (PC_Prefix*)treeNode->data;
+    if (pcPrefix != NULL)
     {
-      pcUpdate->roa_match--;
-      if (pcROA->roa_count == 1)
-      { // because this is the last ROA to delete, remove update count.
-        pcROA->update_count--;
-      }
-      if (pcUpdate->roa_match < 0)
-      {
-        RAISE_SYS_ERROR("BUG: ROA Count in update MUST NOT go below 0!");
-      }
-      if (pcROA->roa_count < 0)
+      stats->prefixes++;
+      stats->prefixBytes += sizeof(PC_Prefix);
+      roaSet = pcPrefix->roaSet;
+      if (roaSet != NULL)
       {
-        RAISE_SYS_ERROR("BUG: ROA Count in ROA MUST NOT go below 0!");
+        stats->prefixBytes += sizeof(PC_ROASet) 
+                              + roaSet->count * (sizeof(uint32_t) + 1);
       }
-      
-      if (pcUpdate->roa_match == 0)
+      stats->ases       += pcPrefix->asnCount;
+      stats->arrayBytes += pcPrefix->asnCapacity * sizeof(PC_AS);
+      for (asIdx = 0; asIdx < pcPrefix->asnCount; asIdx++)
       {
-        nodeToMove = currNode;        
-        notifyUpdateCacheForROAChange(updateCache, &pcUpdate->updateID,       
-                                      pcPrefix->state_of_other);
+        pcAS = &pcPrefix->asn[asIdx];
+        stats->roas       += pcAS->roaCount;
+        stats->arrayBytes += pcAS->roaCapacity * sizeof(PC_ROA);
+        for (roaIdx = 0; roaIdx < pcAS->roaCount; roaIdx++)
+        {
+          stats->vrps += pcAS->roas[roaIdx].roa_count;
+        }
       }
     }
-    else
-    {
-      prevNode = currNode;
-    }
+  } PATRICIA_WALK_END;
 
-    currNode = currNode->next;
+  HASH_ITER(hh, self->valCaches, valCache, tmp)
+  {
+    stats->indexBytes += sizeof(PC_ValCache) 
+                         + valCache->capacity * sizeof(PC_CacheROA);
+  }
 
-    if (nodeToMove != NULL)
-    {
-      // Remove Node from Valid
-      pcPrefix->valid.size--;
-      if (prevNode == NULL)
-      {
-        // Node was the List Head
-        pcPrefix->valid.root = nodeToMove->next;
-      }
-      else
-      {        
-        prevNode->next = nodeToMove->next;
-      }
-      
-      if (nodeToMove->next == NULL)
-      {
-        // Node was last node
-        pcPrefix->valid.last = prevNode;
-      }
-      
-      // Now add it into other list
-      pcPrefix->other.size++;
-      nodeToMove->next = NULL;
-      if (pcPrefix->other.root == NULL)
-      {
-        pcPrefix->other.root  = nodeToMove;
-      }
-      else
-      {
-        pcPrefix->other.last->next = nodeToMove;
-      }
-      pcPrefix->other.last  = nodeToMove;
-      nodeToMove = NULL;
-    }
+  for (idx = 0; idx < MEM_POOL_SIZE_CLASSES; idx++)
+  {
+    memPool = &self->arena->arrayPool.classes[idx];
+    stats->poolBytes += (size_t)memPool->numSlabs * memPool->objsPerSlab 
+                        * memPool->objSize;
   }
+  memPool = &self->arena->prefixPool;
+  stats->poolBytes += (size_t)memPool->numSlabs * memPool->objsPerSlab
+                      * memPool->objSize;
+  UNLOCK_READ_LOCK(&self->treeLock);
+}
+
+/**
+ * Return the number of ROA white-list entries (VRPs) stored in the cache. 
+ * This function does not lock, the value might miss a concurrent change.
+ * 
+ * @param self The prefix cache.
+ * 
+ * @return The number of VRPs.
+ * 
+ * @since 0.4.1.0
+ */
+uint32_t getNumberOfVRPs(PrefixCache* self)
+{
+  return self->noVRPs;
+}
+
+/**
+ * Return the number of prefixes stored in the prefix tree. This function does
+ * not lock, the value might miss a concurrent change.
+ * 
+ * @param self The prefix cache.
+ * 
+ * @return The number of prefixes.
+ * 
+ * @since 0.4.1.0
+ */
+uint32_t getNumberOfPrefixes(PrefixCache* self)
+{
+  return self->prefixTree->num_active_node;
 }
 
 /**
  * Remove all ROA whitelist entries from the given validation cache with the 
  * given session id value. Used for giving up a cache, executing a cache reset
- * or session id change.
- * 
- * NOT IMPLEMENTED PRIOR VERSION 0.3
+ * or session id change. Only the ROAs of the validation cache are visited and
+ * all withdrawals are applied as one batch.
  * 
  * @param self The prefix cache instance
  * @param session_id the session_id of this session
  * @param valCacheID the validation cache ID
  * @param deferredOnly clean only the deferred ROA's
  * 
- * @return the number of ROA whitelist entries to be removed.
+ * @return the number of ROA whitelist entries removed or -1 if not enough 
+ *         memory was available.
  */
 int cleanAllROAwl(PrefixCache* self, uint32_t session_id, uint32_t valCacheID,
                   bool deferredOnly)
 {
-  RAISE_ERROR("NOT IMPLEMENTED PRIOR VERSION 0.3");
-  // Go top down and remove all existing ROA.s
-  return true;
+  PC_ValCache*    valCache;
+  PC_CacheROA*    entry;
+  PC_ROA*         pcROA;
+  PC_ROAwlChange* changes   = NULL;
+  PC_ROAwlChange* change;
+  uint32_t        noChanges = 0;
+  uint32_t        idx;
+  uint16_t        count;
+  int             retVal    = 0;
+  
+  WRITE_LOCK(&self->treeLock);
+  _registerPendingUpdates(self);
+  HASH_FIND_INT(self->valCaches, &valCacheID, valCache);
+  
+  // Count first to allocate the withdrawals in one piece.
+  for (idx = 0; (valCache != NULL) && (idx < valCache->count); idx++)
+  {
+    pcROA = _getIndexedROA(&valCache->roas[idx], valCacheID);
+    if (pcROA != NULL)
+    {
+      noChanges += deferredOnly ? pcROA->deferred_count : pcROA->roa_count;
+    }
+  }
+  
+  if (noChanges > 0)
+  {
+    changes = malloc(noChanges * sizeof(PC_ROAwlChange));
+    if (changes == NULL)
+    {
+      RAISE_SYS_ERROR("Not enough memory to remove %u ROA white-list entries "
+                      "of validation cache 0x%08X!", noChanges, valCacheID);
+      retVal = -1;
+    }
+  }
+  
+  if (changes != NULL)
+  {
+    change = changes;
+    for (idx = 0; idx < valCache->count; idx++)
+    {
+      entry = &valCache->roas[idx];
+      pcROA = _getIndexedROA(entry, valCacheID);
+      count = pcROA == NULL ? 0 : deferredOnly ? pcROA->deferred_count 
+                                               : pcROA->roa_count;
+      for (; count > 0; count--)
+      {
+        change->isAnn      = false;
+        change->originAS   = entry->as;
+        prefix_tToIPPrefix(entry->treeNode->prefix, &change->prefix);
+        change->maxLen     = entry->max_len;
+        change->session_id = session_id;
+        change->valCacheID = valCacheID;
+        change++;
+      }
+    }
+    // The index shrinks while the withdrawals are applied.
+    retVal = (int)_applyROAwlChanges(self, changes, noChanges);
+    free(changes);
+    HASH_FIND_INT(self->valCaches, &valCacheID, valCache);
+  }
+  
+  // The remaining ROAs are current.
+  for (idx = 0; (retVal != -1) && (valCache != NULL) && (idx < valCache->count); 
+       idx++)
+  {
+    pcROA = _getIndexedROA(&valCache->roas[idx], valCacheID);
+    if (pcROA != NULL)
+    {
+      pcROA->deferred_count = 0;
+    }
+  }
+  
+  reclaimEpochData(&self->epoch);
+  UNLOCK_WRITE_LOCK(&self->treeLock);
+  _tryRegisterPendingUpdates(self);
+  
+  return retVal;
 }
 
 /**
  * Flag all ROA whitelist entries of the given validation cache with the given 
  * session id value. This is used in case a session id value switch occurred and
- * the state of ROA white-list entries gets rebuild.
+ * the state of ROA white-list entries gets rebuild. Only the ROAs of the 
+ * validation cache are visited.
  *
- * NOT IMPLEMENTED PRIOR VERSION 0.4
- * 
  * @param self The validation cache
  * @param sessionID the session id whose values have to be flagged.
  * @param valCacheID The validation cache ID.
  * 
- * @return The number of ROA white-list entries to be flagged.
+ * @return The number of ROA white-list entries flagged.
  */
 int flagAllROAwl(PrefixCache* self, uint32_t sessionID, uint32_t valCacheID)
 {
-  RAISE_ERROR("NOT IMPLEMENTED PRIOR VERSION 0.4");
-  // Flag it by setting the defferedCount to ROA-count.
-  return true;
+  PC_ValCache* valCache;
+  PC_ROA*      pcROA;
+  uint32_t     idx;
+  int          flagged = 0;
+  
+  WRITE_LOCK(&self->treeLock);
+  HASH_FIND_INT(self->valCaches, &valCacheID, valCache);
+  for (idx = 0; (valCache != NULL) && (idx < valCache->count); idx++)
+  {
+    // Flag it by setting the deferred count to ROA-count.
+    pcROA = _getIndexedROA(&valCache->roas[idx], valCacheID);
+    if (pcROA != NULL)
+    {
+      pcROA->deferred_count = pcROA->roa_count;
+      flagged += pcROA->roa_count;
+    }
+  }
+  UNLOCK_WRITE_LOCK(&self->treeLock);
+  _tryRegisterPendingUpdates(self);
+  
+  return flagged;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1700,35 +4103,72 @@ int flagAllROAwl(PrefixCache* self, uint32_t sessionID, uint32_t valCacheID)
 
 
 /** 
- * Creates a prefix_t out of an IPPrefix.
+ * Fills a prefix_t with the given IPPrefix. The prefix is marked as static 
+ * (\c ref_count = -1), it can be located on the stack or be embedded into 
+ * another structure. In case \c patricia_lookup inserts it into the tree, the
+ * tree stores its own copy.
+ * 
+ * @param from The IPPrefix.
+ * @param to The patricia tree prefix to be filled.
  * 
- * @note The returned pointer needs to be freed (\c ref_count = 0) unless it 
- *       is passed to \c  patricia_lookup
+ * @since 0.4.1.0
  */
-static prefix_t* ipPrefixToPrefix_t(IPPrefix* from)
+static void ipPrefixToPrefix_t(IPPrefix* from, prefix_t* to)
 {
-  prefix_t* to = (prefix_t*)malloc(sizeof(prefix_t));
-  if (to == NULL)
-  {
-    return NULL;
-  }
-
-  to->bitlen    = from->length;
-  to->ref_count = 0; // Will be 'Ref'ed by lookup
-
   if (from->ip.version == 4)
   {
-    to->family         = AF_INET;
-    to->add.sin.s_addr = from->ip.addr.v4.u32;
+    ipV4PrefixToPrefix_t(from->ip.addr.v4.u32, from->length, to);
   } 
   else
   {
-    to->family = AF_INET6;
+    to->bitlen    = from->length;
+    to->ref_count = -1; // Static prefix, lookup copies it
+    to->family    = AF_INET6;
 
     memcpy(&to->add.sin6, &from->ip.addr.v6.in_addr, sizeof(IPv6Address));
   }
+}
 
-  return to;
+/**
+ * Fills a prefix_t with the given IPv4 prefix, see ipPrefixToPrefix_t.
+ *
+ * @param address The IPv4 address (network order).
+ * @param length The prefix length.
+ * @param to The patricia tree prefix to be filled.
+ *
+ * @since 0.4.1.0
+ */
+static void ipV4PrefixToPrefix_t(uint32_t address, uint8_t length,
+                                 prefix_t* to)
+{
+  to->bitlen         = length;
+  to->ref_count      = -1; // Static prefix, lookup copies it
+  to->family         = AF_INET;
+  to->add.sin.s_addr = address;
+}
+
+/**
+ * Fills the IPPrefix with the given patricia tree prefix.
+ * 
+ * @param from The patricia tree prefix.
+ * @param to The IPPrefix to be filled.
+ * 
+ * @since 0.4.1.0
+ */
+static void prefix_tToIPPrefix(prefix_t* from, IPPrefix* to)
+{
+  memset(to, 0, sizeof(IPPrefix));
+  to->length = from->bitlen;
+  if (from->family == AF_INET)
+  {
+    to->ip.version     = 4;
+    to->ip.addr.v4.u32 = from->add.sin.s_addr;
+  }
+  else
+  {
+    to->ip.version = 6;
+    memcpy(&to->ip.addr.v6.in_addr, &from->add.sin6, sizeof(IPv6Address));
+  }
 }
 
 /**
@@ -1737,16 +4177,33 @@ static prefix_t* ipPrefixToPrefix_t(IPPrefix* from)
  * 
  * @return The text (human readable) version of the prefix.
  *
- * @note Local, static buffer - i.e. not thread-safe!
+ * @note Buffer local to the calling thread, it is overwritten by the next 
+ *       call of the same thread.
  */
 const char* ipOfPrefix_tToStr(prefix_t* prefix)
 {
-  #define BUF_SIZE  MAX_IP_V6_STR_LEN
-  static const char buf[BUF_SIZE];
+  static __thread char buf[MAX_IP_V6_STR_LEN];
+
+  return ipOfPrefix_tToStrBuf(prefix, buf, MAX_IP_V6_STR_LEN);
+}
 
+/**
+ * Writes a textual representation of a given patricia tree prefix into the 
+ * given buffer.
+ * 
+ * @param prefix The patricia tree prefix.
+ * @param buf The buffer, should be at least MAX_IP_V6_STR_LEN bytes.
+ * @param bufSize The size of the buffer.
+ * 
+ * @return The text (human readable) version of the prefix, this is buf.
+ * 
+ * @since 0.4.1.0
+ */
+const char* ipOfPrefix_tToStrBuf(prefix_t* prefix, char* buf, size_t bufSize)
+{
   return (prefix->family == AF_INET) 
-      ? ipV4AddressToStr((IPv4Address*)&prefix->add.sin, (char*)buf, BUF_SIZE)
-      : ipV6AddressToStr((IPv6Address*)&prefix->add.sin6, (char*)buf, BUF_SIZE);
+      ? ipV4AddressToStr((IPv4Address*)&prefix->add.sin, buf, bufSize)
+      : ipV6AddressToStr((IPv6Address*)&prefix->add.sin6, buf, bufSize);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1788,10 +4245,8 @@ static void outputPrefix(XMLOut* out, patricia_node_t* treeNode)
   PC_Update*  pcUpdate = NULL;
   PC_AS*      pcAS     = NULL;
   PC_ROA*     pcROA    = NULL;
-  SListNode*  asListNode    = NULL;
-  SListNode*  roaListNode   = NULL;
-  SListNode*  otherListNode = NULL;
-  SListNode*  validListNode = NULL;
+  uint32_t    idx;
+  uint32_t    roaIdx;
 
   openTag(out, "prefix");
   if (treeNode->data == NULL)
@@ -1810,18 +4265,18 @@ static void outputPrefix(XMLOut* out, patricia_node_t* treeNode)
                  pcPrefix->state_of_other == SRx_RESULT_NOTFOUND ? "NOTFOUND"
                                                                  : "INVALID");
 
-    FOREACH_SLIST(&pcPrefix->asn, asListNode)
+    for (idx = 0; idx < pcPrefix->asnCount; idx++)
     {
-      pcAS = (PC_AS*)asListNode->data;
+      pcAS = &pcPrefix->asn[idx];
       openTag(out, "as");
       addU32Attrib(out, "as-number", pcAS->asn);
       addU32Attrib(out, "update-count", pcAS->update_count);
-      FOREACH_SLIST(&pcAS->roas, roaListNode)
+      for (roaIdx = 0; roaIdx < pcAS->roaCount; roaIdx++)
       {
-        pcROA = (PC_ROA*)roaListNode->data;
+        pcROA = &pcAS->roas[roaIdx];
         openTag(out, "roa");        
         addU32Attrib(out, "valCacheID",   pcROA->valCacheID);
-        addU32Attrib(out, "as",           pcROA->as);
+        addU32Attrib(out, "as",           pcAS->asn);
         addU32Attrib(out, "max-length",   pcROA->max_len);
         addU32Attrib(out, "roa-count",    pcROA->roa_count);
         addU32Attrib(out, "deferred-count",    pcROA->deferred_count);
@@ -1832,13 +4287,14 @@ static void outputPrefix(XMLOut* out, patricia_node_t* treeNode)
     }
     openTag(out, "valid");
     addU32Attrib(out, "no-updates", pcPrefix->valid.size);
-    FOREACH_SLIST(&pcPrefix->valid, validListNode)
+    for (idx = 0; idx < pcPrefix->valid.size; idx++)
     {
-      pcUpdate = (PC_Update*)validListNode->data;
+      pcUpdate = pcPrefix->valid.updates[idx];
       openTag(out, "update");
       addH32Attrib(out, "update-id", pcUpdate->updateID);
       addU32Attrib(out, "as",        pcUpdate->as);
       addU32Attrib(out, "roa-match", pcUpdate->roa_match);
+      addU32Attrib(out, "shared-updates", pcUpdate->noSharedIDs);
       closeTag(out); // update
     }
     closeTag(out); // valid
@@ -1848,31 +4304,32 @@ static void outputPrefix(XMLOut* out, patricia_node_t* treeNode)
     addStrAttrib(out, "state", 
                  pcPrefix->state_of_other == SRx_RESULT_NOTFOUND ? "NOTFOUND"
                                                                  : "INVALID");
-    FOREACH_SLIST(&pcPrefix->other, otherListNode)
+    for (idx = 0; idx < pcPrefix->other.size; idx++)
     {
-      pcUpdate = (PC_Update*)otherListNode->data;
+      pcUpdate = pcPrefix->other.updates[idx];
       openTag(out, "update");
       addH32Attrib(out, "update-id", pcUpdate->updateID);
       addU32Attrib(out, "origin-as", pcUpdate->as);
       addU32Attrib(out, "roa-match", pcUpdate->roa_match);
+      addU32Attrib(out, "shared-updates", pcUpdate->noSharedIDs);
       closeTag(out); // update
     }
     closeTag(out); // other
   }
   
   // Children
-  SList childrenList;
-  SListNode* childrenListNode = NULL;
+  Vector   childrenList;
+  uint32_t childIdx;
   
-  initSList(&childrenList);
+  initVector(&childrenList, sizeof(PC_Prefix*));
   getChildren(&childrenList, treeNode);
   
-  FOREACH_SLIST(&childrenList, childrenListNode)
+  for (childIdx = 0; childIdx < sizeOfVector(&childrenList); childIdx++)
   {
-    pcPrefix = (PC_Prefix*)childrenListNode->data;   
+    pcPrefix = *(PC_Prefix**)getFromVector(&childrenList, childIdx);
     outputPrefix(out, pcPrefix->treeNode);    
   }
-  releaseSList(&childrenList);
+  releaseVector(&childrenList);
   
   closeTag(out); // prefix
 }
@@ -1886,9 +4343,10 @@ static void outputPrefix(XMLOut* out, patricia_node_t* treeNode)
 void outputPrefixCacheAsXML(PrefixCache* self, FILE* stream)
 {
   XMLOut      out;
-  SListNode*  updateListNode;
+  DListNode*  updateListNode;
   PC_Update*  pcUpdate;
 
+  READ_LOCK(&self->treeLock);
   initXMLOut(&out, stream);
   openTag(&out, "prefix-cache");
 
@@ -1899,12 +4357,12 @@ void outputPrefixCacheAsXML(PrefixCache* self, FILE* stream)
   }
 
   // Updates
-  if (sizeOfSList(&self->updates))
+  if (sizeOfDList(&self->updates) > 0)
   {
     openTag(&out, "updates");
-    FOREACH_SLIST(&self->updates, updateListNode)
+    FOREACH_DLIST(&self->updates, updateListNode)
     {
-      pcUpdate = (PC_Update*)getDataOfSListNode(updateListNode);
+      pcUpdate = DLIST_ENTRY(updateListNode, PC_Update, listNode);
       openTag(&out, "update");
         addH32Attrib(&out, "update-id", pcUpdate->updateID);
         addU32Attrib(&out, "origin-as", pcUpdate->as);
@@ -1912,6 +4370,7 @@ void outputPrefixCacheAsXML(PrefixCache* self, FILE* stream)
                   ipOfPrefix_tToStr(pcUpdate->treeNode->prefix), 
                   pcUpdate->treeNode->prefix->bitlen);
         addU32Attrib(&out, "roa-count", pcUpdate->roa_match);
+        addU32Attrib(&out, "shared-updates", pcUpdate->noSharedIDs);
         if (pcUpdate->roa_match > 0)
         {
           addStrAttrib(&out, "val-state", "VALID");          
@@ -1935,6 +4394,162 @@ void outputPrefixCacheAsXML(PrefixCache* self, FILE* stream)
 
   closeTag(&out);
   releaseXMLOut(&out);
+  UNLOCK_READ_LOCK(&self->treeLock);
+  _tryRegisterPendingUpdates(self);
+}
+
+/**
+ * Return the node following the given one in pre-order. Only the parent and
+ * child links are used, no stack is needed to resume a walk.
+ * 
+ * @param treeNode The current tree node.
+ * 
+ * @return The next tree node or NULL.
+ * 
+ * @since 0.4.1.0
+ */
+static patricia_node_t* _nextTreeNode(patricia_node_t* treeNode)
+{
+  if (treeNode->l != NULL)
+  {
+    return treeNode->l;
+  }
+  if (treeNode->r != NULL)
+  {
+    return treeNode->r;
+  }
+  for (; treeNode->parent != NULL; treeNode = treeNode->parent)
+  {
+    if (   (treeNode->parent->l == treeNode) 
+        && (treeNode->parent->r != NULL))
+    {
+      return treeNode->parent->r;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Add the JSON line of the given prefix to the output.
+ * 
+ * @param out The JSON output.
+ * @param pcPrefix The prefix.
+ * 
+ * @since 0.4.1.0
+ */
+static void _dumpPrefix(JSONOut* out, PC_Prefix* pcPrefix)
+{
+  char        buf[MAX_IP_V6_STR_LEN + 4];
+  size_t      len;
+  PC_ROASet*  roaSet = pcPrefix->roaSet;
+  uint32_t    idx;
+
+  ipOfPrefix_tToStrBuf(pcPrefix->treeNode->prefix, buf, MAX_IP_V6_STR_LEN);
+  len = strlen(buf);
+  snprintf(buf + len, sizeof(buf) - len, "/%u", 
+           pcPrefix->treeNode->prefix->bitlen);
+
+  openJSONObject(out, NULL);
+  addJSONStr(out, "prefix", buf);
+  addJSONU32(out, "roa-coverage", pcPrefix->roa_coverage);
+  addJSONStr(out, "state-of-other", 
+             pcPrefix->state_of_other == SRx_RESULT_NOTFOUND ? "NOTFOUND"
+                                                             : "INVALID");
+  openJSONArray(out, "roas");
+  for (idx = 0; roaSet != NULL && idx < roaSet->count; idx++)
+  {
+    openJSONObject(out, NULL);
+    addJSONU32(out, "as", roaSet->as[idx]);
+    addJSONU32(out, "max-len", roaSet->max_len[idx]);
+    closeJSONObject(out);
+  }
+  closeJSONArray(out);
+  closeJSONObject(out);
+}
+
+/**
+ * Write the prefixes and their published ROAs as JSON lines (one object per 
+ * prefix) into the given stream. The tree is walked in chunks of 
+ * PC_DUMP_CHUNK nodes, each chunk is read within the epoch domain without 
+ * taking the tree lock and written once the epoch is left. The dump is not 
+ * a snapshot, changes made during the dump might or might not be included.
+ * 
+ * @param self The prefix cache.
+ * @param stream The stream to write into.
+ * 
+ * @return false if the dump is incomplete, either the output failed or the 
+ *         cache was emptied during the dump.
+ * 
+ * @since 0.4.1.0
+ */
+bool dumpPrefixCache(PrefixCache* self, FILE* stream)
+{
+  JSONOut          out;
+  patricia_node_t* treeNode;
+  prefix_t         resume;
+  bool             haveResume = false;
+  bool             ok         = true;
+  int              visited;
+
+  initJSONOut(&out, stream);
+  
+  while (ok)
+  {
+    if (!enterEpoch(&self->epoch))
+    {
+      ok = false;
+      break;
+    }
+    if (self->readersBlocked)
+    {
+      leaveEpoch(&self->epoch);
+      ok = false;
+      break;
+    }
+    
+    if (haveResume)
+    {
+      // Tree nodes are never removed while readers are allowed.
+      treeNode = patricia_search_exact(self->prefixTree, &resume);
+      if (treeNode == NULL)
+      {
+        leaveEpoch(&self->epoch);
+        ok = false;
+        break;
+      }
+      treeNode = _nextTreeNode(treeNode);
+    }
+    else
+    {
+      treeNode = self->prefixTree->head;
+    }
+    
+    for (visited = 0; treeNode != NULL && visited < PC_DUMP_CHUNK; visited++)
+    {
+      if (treeNode->prefix != NULL)
+      {
+        memcpy(&resume, treeNode->prefix, sizeof(prefix_t));
+        resume.ref_count = -1;
+        haveResume       = true;
+        if (treeNode->data != NULL)
+        {
+          _dumpPrefix(&out, (PC_Prefix*)treeNode->data);
+        }
+      }
+      treeNode = _nextTreeNode(treeNode);
+    }
+    leaveEpoch(&self->epoch);
+    
+    ok = flushJSONOut(&out);
+    if (treeNode == NULL)
+    {
+      break;
+    }
+  }
+  
+  releaseJSONOut(&out);
+  
+  return ok;
 }
 
 /*-----------------------
@@ -1975,3 +4590,57 @@ static void notifyUpdateCacheForROAChange(UpdateCache* updCache,
   }
 }
 
+/**
+ * Notifies the Update Cache about a change of ROA prefix/origin validation of
+ * the given update. While a batch of ROA changes is applied the update is only
+ * marked and reports its final state once the batch is completed.
+ *
+ * @param self The prefix cache
+ * @param pcUpdate The update whose validation state changed.
+ * @param newROAResult The new validation state.
+ * 
+ * @since 0.4.1.0
+ */
+static void _notifyROAChange(PrefixCache* self, PC_Update* pcUpdate,
+                             SRxValidationResultVal newROAResult)
+{
+  if (self->inBatch)
+  {
+    if (pcUpdate->notifyPending)
+    {
+      return;
+    }
+    if (_addToUpdateArray(NULL, &self->batchUpdates, pcUpdate))
+    {
+      pcUpdate->notifyPending = true;
+      return;
+    }
+    // Not enough memory to defer it, report it right away.
+  }
+  _notifyUpdateRecord(self, pcUpdate, newROAResult);
+}
+
+/**
+ * Notifies the Update Cache about the validation state of all updates that
+ * share the given update record.
+ *
+ * @param self The prefix cache
+ * @param pcUpdate The update record.
+ * @param newROAResult The validation state.
+ * 
+ * @since 0.4.1.0
+ */
+static void _notifyUpdateRecord(PrefixCache* self, PC_Update* pcUpdate,
+                                SRxValidationResultVal newROAResult)
+{
+  uint32_t idx;
+  
+  notifyUpdateCacheForROAChange(self->updateCache, &pcUpdate->updateID, 
+                                newROAResult);
+  for (idx = 0; idx < pcUpdate->noSharedIDs; idx++)
+  {
+    notifyUpdateCacheForROAChange(self->updateCache, &pcUpdate->sharedIDs[idx],
+                                  newROAResult);
+  }
+}
+
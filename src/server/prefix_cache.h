@@ -22,10 +22,53 @@
  *
  * Prefix Cache.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Replaced the SLists valid, other, and asn of PC_Prefix with 
+ *              arrays. The AS array is sorted by AS number.
+ *            * PC_AS::roas is a packed array sorted by max length.
+ *            * Added PC_ROAwlChange and applyROAwlChanges to apply a complete
+ *              set of ROA white-list changes in one pass.
+ *            * Added the epoch domain, the published ROA set of each prefix
+ *              and the pending updates to PrefixCache to allow validation
+ *              without taking the tree lock.
+ *            * Implemented removeUpdate and added removeUpdates to remove a 
+ *              batch of updates with a single pass over the update list.
+ *            * Added exportROAwl.
+ *            * Added the ROA index of each validation cache and implemented
+ *              flagAllROAwl and cleanAllROAwl on top of it.
+ *            * Packed PC_ROA into 16 bytes, the AS number is taken from the 
+ *              PC_AS. The AS and ROA arrays are allocated from the array pool
+ *              of the prefix cache.
+ *            * Added PC_MemoryStats and getPrefixCacheMemory.
+ *            * PC_Update embeds its pending prefix. Added ipOfPrefix_tToStrBuf,
+ *              ipOfPrefix_tToStr uses a buffer local to the calling thread.
+ *            * PC_Update is the origin validation record shared by all updates
+ *              of the same prefix and origin AS, PC_AS refers to it.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added the VRP counter and getNumberOfVRPs, getNumberOfPrefixes
+ *              to allow reading the cache size without lock.
+ *            * Added PC_DUMP_CHUNK and dumpPrefixCache.
+ *            * Added the IPv4 origin index.
+ *            * The ROA sets store the AS numbers and max lengths in separate 
+ *              packed arrays, removed PC_ROAEntry. Update arrays keep the 
+ *              origin AS of each update in a packed array.
+ *            * The update records are linked into an intrusive list instead
+ *              of the SList.
+ *            * Added roaIndexCapacity, initializePrefixCache reserves memory
+ *              using the expected numbers of prefixes and ROAs.
+ *            * Added the shared ROA table, setSharedROATable,
+ *              publishSharedROAs, and refreshSharedROAs.
+ *            * Added PC_Prefix::roaCount and PC_Prefix::roaParent, the link
+ *              to the nearest less specific prefix with ROAs.
+ *            * Added PC_Arena. The prefixes and the AS, ROA, and update arrays
+ *              are allocated from the arena of the cache, emptyCache swaps in
+ *              a new arena and tree and drops the old ones without lock.
+ *            * Added validateProvisionalUpdates.
+ *            * Added requestUpdateValidationV4.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  *            * Moved outputPrefixCacheAsXML from c file to header.
@@ -54,14 +97,116 @@
 #define HAVE_IPV6
 #include <patricia.h>
  
+#include "server/origin_index.h"
+#include "server/shared_roa.h"
 #include "server/update_cache.h"
 #include "shared/srx_defs.h"
+#include "util/epoch.h"
+#include "util/mem_pool.h"
 #include "util/mutex.h"
 #include "util/prefix.h"
+#include "util/dlist.h"
 #include "util/rwlock.h"
-#include "util/slist.h"
 
 
+/**
+ * Origin validation record of a prefix and origin AS. All updates with the
+ * same prefix and origin AS share one record, it is validated once and each
+ * change of its validation state is reported for all of its updates. Until it 
+ * is registered in the tree, the record only holds the update it was created
+ * for.
+ */
+typedef struct {
+  /** The id of the update in the update cache the record was created for. */
+  SRxUpdateID      updateID;
+  /** The ids of all other updates sharing this record. */
+  SRxUpdateID*     sharedIDs;
+  /** The number of ids stored in sharedIDs. */
+  uint32_t         noSharedIDs;
+  /** The number of ids that fit into sharedIDs without extending it. */
+  uint32_t         sharedCapacity;
+  /** The origin AS */
+  uint32_t         as;
+  /** The patricia tree node this update is assigned to. */
+  patricia_node_t* treeNode;
+  /** Number of ROAs that cover this update. If the value == 0 the update MUST
+   * be located in the 'other' list, otherwise the update must be located in the
+   * valid list. */
+  uint16_t         roa_match;
+  /** Set while the update waits for the end of an ROA batch to report its
+   * final validation state. */
+  bool             notifyPending;
+  /** The prefix of an update not registered in the tree yet. It is a static
+   * prefix, the tree stores its own copy. */
+  prefix_t         pendingPrefix;
+  /** The next update waiting for registration. */
+  void*            pendingNext;
+  /** Links the record into the update list of the prefix cache. 
+   * @since 0.4.1.0 */
+  DListNode        listNode;
+} PC_Update;
+
+/** The initial number of elements of the per prefix and per AS arrays. */
+#define PC_INITIAL_ARRAY_SIZE 4
+
+/** The number of packed AS numbers compared at once. 
+ * @since 0.4.1.0 */
+#define PC_MATCH_BLOCK 16
+
+/**
+ * An array of updates. The order of the updates is not maintained.
+ */
+typedef struct {
+  /** The updates. */
+  PC_Update** updates;
+  /** The origin AS of each update, packed to be matched without accessing the
+   * updates. @since 0.4.1.0 */
+  uint32_t*   asns;
+  /** The number of updates stored. */
+  uint32_t    size;
+  /** The number of updates that fit into the array without extending it. */
+  uint32_t    capacity;
+} PC_UpdateArray;
+
+/**
+ * A single ROA white-list announcement or withdrawal as staged by the RPKI 
+ * handler until the validation cache signals the end of data.
+ * 
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** true for an announcement, false for a withdrawal. */
+  bool     isAnn;
+  /** The origin AS of the ROA white-list entry. */
+  uint32_t originAS;
+  /** The prefix of the ROA white-list entry. */
+  IPPrefix prefix;
+  /** The max length of the ROA white-list entry. */
+  uint8_t  maxLen;
+  /** The session id of the validation cache session. */
+  uint32_t session_id;
+  /** The validation cache ID. */
+  uint32_t valCacheID;
+} PC_ROAwlChange;
+
+/**
+ * An update to be removed from the prefix cache.
+ * 
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** The id of the update. */
+  SRxUpdateID updateID;
+  /** The prefix of the update. */
+  IPPrefix    prefix;
+  /** The origin AS of the update. */
+  uint32_t    as;
+  /** OUT - Set if the update was found and removed. */
+  bool        removed;
+} PC_UpdateRemoval;
+
+/** The ROA index of a validation cache, defined in prefix_cache.c. */
+typedef struct _PC_ValCache PC_ValCache;
 
 /**
  * A single Prefix Cache.
@@ -69,8 +214,8 @@
 typedef struct {
   UpdateCache*      updateCache;
   patricia_tree_t*  prefixTree;
-  // This list is not really needed!
-  SList             updates;
+  // The update records registered in the tree, not shared ones
+  DList             updates;
  
   // Access control variables
   Mutex             updatesMutex;
@@ -78,64 +223,87 @@ typedef struct {
   RWLock            otherLock;
   RWLock            validLock;
   RWLock            asLock;
+  
+  /** Indicates that ROA changes are applied as one batch. Validation results
+   * are not reported before the batch is completed. */
+  bool              inBatch;
+  /** The updates whose validation state got touched during the batch. */
+  PC_UpdateArray    batchUpdates;
+  
+  /** Protects the tree nodes and ROA sets read without the tree lock. */
+  EpochDomain       epoch;
+  /** Set while the complete tree gets released, readers must use the lock.*/
+  volatile bool     readersBlocked;
+  /** Updates validated without lock that wait to be registered in the tree
+   * by the next holder of the tree lock. */
+  PC_Update* volatile pendingUpdates;
+  
+  /** The ROAs of each validation cache, hashed by the validation cache ID. 
+   * Protected by the tree lock. */
+  PC_ValCache*      valCaches;
+  /** The number of ROAs the index of a validation cache is allocated for 
+   * with its first ROA. */
+  uint32_t          roaIndexCapacity;
+  /** The arena the prefixes and their arrays are allocated from. Protected
+   * by the tree lock. */
+  struct _PC_Arena* arena;
+  /** The number of ROA white-list entries (VRPs) stored. Written under the 
+   * tree lock, can be read without lock. */
+  volatile uint32_t noVRPs;
+  /** The IPv4 ROAs indexed by address for lookups without the tree. 
+   * Maintained under the tree lock, read within the epoch. */
+  OriginIndexV4     originIndexV4;
+  /** The shared ROA table the white-list is published into or, if attached
+   * read-only, the origin validation uses instead of the own white-list.
+   * NULL if none. The mapping of an attached table is read within the
+   * epoch. */
+  SharedROATable*   sharedROAs;
+  /** Increased with each change of the ROAs of a prefix. Written under the
+   * tree lock. */
+  volatile uint32_t roaGeneration;
+  /** The ROA generation published last, or the generation of the attached
+   * table the updates were validated with last. */
+  uint64_t          sharedGeneration;
 } PrefixCache;
 
 /**
- * Update with reference counter.
+ * Immutable copy of all ROAs attached to a prefix. Each change creates a new
+ * set which replaces the old one, the old one gets retired. The AS numbers and
+ * max lengths are stored in two packed arrays, the ROA at position i is 
+ * as[i] / max_len[i]. This allows matching all ROAs in one sweep.
+ * 
+ * @since 0.4.1.0
  */
 typedef struct {
-  /** The id of the update in the update cache. */
-  SRxUpdateID      updateID;
-  /** The origin AS */
-  uint32_t         as;
-  /** The patricia tree node this update is assigned to. */
-  patricia_node_t* treeNode;
-  /** Number of ROAs that cover this update. If the value == 0 the update MUST
-   * be located in the 'other' list, otherwise the update must be located in the
-   * valid list. */
-  uint16_t         roa_match;
-} PC_Update;
+  /** The number of ROAs. */
+  uint32_t  count;
+  /** The max lengths, stored in the same allocation behind the AS numbers. */
+  uint8_t*  max_len;
+  /** The AS numbers. */
+  uint32_t  as[];
+} PC_ROASet;
 
-typedef struct {
-  /** Contains the tree node. */
-  patricia_node_t* treeNode;
-  /** Number of ROAs covering this prefix (attached and through max-length.  */
-  uint32_t roa_coverage;
-  /** The validation state of updates in the 'other' list. 
-   * Acceptable values are SRx_RESULT_UNKNOWN and SRx_RESULT_INVALID */
-  SRxValidationResultVal  state_of_other;
-  
-  /** Contains all updates considered valid. */
-  SList    valid;
-  /** Contains all updates considered valid. */
-  SList    other;
-  /** Contains all ASN's attached to this prefix either through ROA.s or 
-   * updates or both. Each AS (PC_AS) is listed only once. */
-  SList    asn;
-} PC_Prefix;
+/** The maximum number of ROAs a single validation cache can maintain. */
+#define PC_MAX_CACHE_ROAS (1 << 24)
+
+/** The number of tree nodes dumpPrefixCache reads per epoch section. 
+ * @since 0.4.1.0 */
+#define PC_DUMP_CHUNK 1024
 
 /**
- * The Origin AS associated with the update.
+ * A ROA white-list entry packed into 16 bytes. The AS number is the one of the
+ * PC_AS the ROA is stored in, the prefix the one of the PC_Prefix.
  */
 typedef struct {
-  /** The AS number*/
-  uint32_t asn;
-  /** the list of ROAs attached to this AS*/
-  SList    roas;  
-  // OR 
-  // PC_ROA[] roas; // the length of the array is (32-length) + 1
-  
-  /** The number of updates announced by to this as. (only for the prefix this 
-   * instance is attached to/ */
+  /** The id of the validation cache that maintains this ROA-white-list entry.*/
+  uint32_t valCacheID;
+  /** The number of updates covered by this ROA. */
   uint32_t update_count;
-} PC_AS;
-
-typedef struct {
-  /** The AS number of this roa. */
-  uint32_t as;
+  /** The position of this ROA within the ROA index of its validation cache.*/
+  uint32_t cacheIdx : 24;
   /** the max length of the ROA. The prefix of the ROA can be determined though
    * the prefix the ROA is attached to.*/
-  uint8_t  max_len;
+  uint32_t max_len  : 8;
   /** The number of identical ROAs that are represented by this instance.*/
   uint16_t roa_count;
   /** The number of identical ROAS that are represented by this instance
@@ -145,14 +313,82 @@ typedef struct {
    * of deferred_count. This counter indicates a re-synchronization if it is 
    * other than zero "0"*/
   uint16_t deferred_count;
-  /** The id of the validation cache that maintains this ROA-white-list entry.*/
-  uint32_t valCacheID;
-  /** The number of updates covered by this ROA. */
-  uint32_t update_count;
 } PC_ROA;
 
+/**
+ * The Origin AS associated with the update.
+ */
+typedef struct {
+  /** The AS number*/
+  uint32_t asn;
+  /** The number of update records announced by to this as. (only for the 
+   * prefix this instance is attached to/ */
+  uint32_t update_count;
+  /** The update record shared by all updates of this prefix and AS or NULL. 
+   * @since 0.4.1.0 */
+  PC_Update* record;
+  /** The ROAs attached to this AS, allocated from the array pool of the 
+   * prefix cache. The array is sorted by descending max length, a scan for 
+   * ROAs covering a given prefix length can stop at the first ROA with a 
+   * smaller max length. */
+  PC_ROA*  roas;
+  /** The number of ROAs stored in roas. */
+  uint16_t roaCount;
+  /** The number of ROAs that fit into roas without extending it. */
+  uint16_t roaCapacity;
+} PC_AS;
+
+typedef struct _PC_Prefix {
+  /** Contains the tree node. */
+  patricia_node_t* treeNode;
+  /** Number of ROAs covering this prefix (attached and through max-length.  */
+  uint32_t roa_coverage;
+  /** The validation state of updates in the 'other' list. 
+   * Acceptable values are SRx_RESULT_UNKNOWN and SRx_RESULT_INVALID */
+  SRxValidationResultVal  state_of_other;
+  
+  /** Contains all updates considered valid. */
+  PC_UpdateArray valid;
+  /** Contains all updates not considered valid. */
+  PC_UpdateArray other;
+  /** Contains all ASN's attached to this prefix either through ROA.s or 
+   * updates or both. Each AS (PC_AS) is listed only once. The array is sorted
+   * by AS number and allocated from the array pool of the prefix cache. */
+  PC_AS*   asn;
+  /** The number of ASes stored in asn. */
+  uint32_t asnCount;
+  /** The number of ASes that fit into asn without extending it. */
+  uint32_t asnCapacity;
+  /** The ROAs attached to this prefix as seen by lock free readers or NULL.*/
+  PC_ROASet* volatile roaSet;
+  /** The number of ROAs attached to this prefix over all ASes. */
+  uint32_t roaCount;
+  /** The nearest less specific prefix with ROAs attached or NULL. Maintained
+   * by the ROA management, covering ROAs are found without walking up the
+   * tree. */
+  struct _PC_Prefix* roaParent;
+  /** The arena the prefix is allocated from. */
+  struct _PC_Arena*  arena;
+} PC_Prefix;
+
+/**
+ * The memory of one generation of the prefix tree. The prefixes and their AS,
+ * ROA, and update arrays are allocated from the arena, a cleared cache drops
+ * the complete arena instead of freeing each object.
+ *
+ * @since 0.4.1.0
+ */
+typedef struct _PC_Arena {
+  /** The prefixes (PC_Prefix). */
+  MemPool       prefixPool;
+  /** The AS, ROA, and update arrays of the prefixes. */
+  SizeClassPool arrayPool;
+} PC_Arena;
+
 /**
  * Initializes an empty cache and creates a link to an existing Update Cache.
+ * The expected numbers of prefixes and ROAs of the update cache's system 
+ * configuration are used to reserve memory.
  *
  * @param self the Instance of prefix cache that should be initialized.
  * @param updateCache Instance of the Update Cache that should be notified
@@ -168,7 +404,10 @@ void releasePrefixCache(PrefixCache* self);
 
 /**
  * Request the validation for an update received. The result will be stored in 
- * the update cache's update by calling its notification method.
+ * the update cache's update by calling its notification method. The result is
+ * determined without taking the tree lock, the update gets registered for 
+ * later ROA changes once the tree lock is available. An update requested again
+ * is registered only once, its validation state is reported again.
  * 
  * @param self The prefix cache
  * @param updateID the id of the update itself
@@ -180,11 +419,26 @@ void releasePrefixCache(PrefixCache* self);
 bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID, 
                              IPPrefix* prefix, uint32_t as);
 
+/**
+ * The IPv4 specialization of requestUpdateValidation. The prefix is given as
+ * 32 bit address and length and is not converted from an IPPrefix.
+ *
+ * @param self The prefix cache
+ * @param updateID the id of the update itself
+ * @param address The IPv4 address of the prefix (network order)
+ * @param length The prefix length
+ * @param as The AS number of the update
+ *
+ * @return true if the validation request could be performed.
+ *
+ * @since 0.4.1.0
+ */
+bool requestUpdateValidationV4(PrefixCache* self, SRxUpdateID* updateID,
+                               uint32_t address, uint8_t length, uint32_t as);
+
 /**
  * This method will remove the given update from the prefix cache.
  * 
- * NOT IMPLEMENTED PRIOR VERSION 0.3
- * 
  * @param self The prefix cache.
  * @param updateID The id of the update that has to be removed.
  * @param prefix The prefix of the update.
@@ -195,6 +449,21 @@ bool requestUpdateValidation(PrefixCache* self, SRxUpdateID* updateID,
 bool removeUpdate(PrefixCache* self, SRxUpdateID* updateID, IPPrefix* prefix,
                   uint32_t as);
 
+/**
+ * Remove the given updates from the prefix cache. The tree stays write locked
+ * for the complete batch. Updates not found are skipped.
+ * 
+ * @param self The prefix cache.
+ * @param removals The updates to be removed.
+ * @param noRemovals The number of updates.
+ * 
+ * @return The number of updates removed.
+ * 
+ * @since 0.4.1.0
+ */
+uint32_t removeUpdates(PrefixCache* self, PC_UpdateRemoval* removals, 
+                       uint32_t noRemovals);
+
 /**
  * Add the given ROA white-list entry provided by the specified validation cache
  * with the given session id.
@@ -231,19 +500,171 @@ bool addROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix,
 bool delROAwl(PrefixCache* self, uint32_t originAS, IPPrefix* prefix, 
               uint8_t maxLen, uint32_t session_id, uint32_t valCacheID);
 
+/**
+ * Apply the given list of ROA white-list announcements and withdrawals in one
+ * pass. The prefix tree stays write locked for the complete batch and each 
+ * affected update reports its final validation state only once after all 
+ * changes are applied. Updates that end up in the same state they started in
+ * are not reported at all.
+ * 
+ * @param self The prefix cache
+ * @param changes The ROA white-list changes in the order received.
+ * @param noChanges The number of changes.
+ * 
+ * @return The number of changes that could be applied.
+ * 
+ * @since 0.4.1.0
+ */
+uint32_t applyROAwlChanges(PrefixCache* self, PC_ROAwlChange* changes, 
+                           uint32_t noChanges);
+
+/**
+ * The memory used by the ROA white-list of a prefix cache.
+ * 
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** The number of ROA white-list entries (VRPs), identical ones included. */
+  uint32_t vrps;
+  /** The number of ROA records (PC_ROA). */
+  uint32_t roas;
+  /** The number of AS records (PC_AS). */
+  uint32_t ases;
+  /** The number of prefixes with data (PC_Prefix). */
+  uint32_t prefixes;
+  /** The bytes of the patricia tree nodes and their prefixes. */
+  size_t   treeBytes;
+  /** The bytes of the prefixes and the ROA sets of the lock free readers. */
+  size_t   prefixBytes;
+  /** The bytes of the AS and ROA arrays, unused capacity included. */
+  size_t   arrayBytes;
+  /** The bytes of the ROA indexes of the validation caches. */
+  size_t   indexBytes;
+  /** The bytes reserved by the slabs of the arena. */
+  size_t   poolBytes;
+} PC_MemoryStats;
+
+/**
+ * Determine the memory used by the ROA white-list. The updates are not 
+ * included.
+ * 
+ * @param self The prefix cache
+ * @param stats OUT - The memory statistics.
+ * 
+ * @since 0.4.1.0
+ */
+void getPrefixCacheMemory(PrefixCache* self, PC_MemoryStats* stats);
+
+/**
+ * Return the number of ROA white-list entries (VRPs) stored in the cache. 
+ * This function does not lock, the value might miss a concurrent change.
+ * 
+ * @param self The prefix cache.
+ * 
+ * @return The number of VRPs.
+ * 
+ * @since 0.4.1.0
+ */
+uint32_t getNumberOfVRPs(PrefixCache* self);
+
+/**
+ * Return the number of prefixes stored in the prefix tree. This function does
+ * not lock, the value might miss a concurrent change.
+ * 
+ * @param self The prefix cache.
+ * 
+ * @return The number of prefixes.
+ * 
+ * @since 0.4.1.0
+ */
+uint32_t getNumberOfPrefixes(PrefixCache* self);
+
+/**
+ * Export all ROA white-list entries as announcements. A ROA that represents
+ * multiple identical ROAs is exported once for each of them. Applying the
+ * exported changes to an empty prefix cache rebuilds the same white-list.
+ * 
+ * @param self The prefix cache
+ * @param session_id The session id stored in each change.
+ * @param changes OUT - The exported changes. The array is allocated and must 
+ *                be freed by the caller, NULL if nothing is exported.
+ * @param noChanges OUT - The number of exported changes.
+ * 
+ * @return false if not enough memory was available.
+ * 
+ * @since 0.4.1.0
+ */
+bool exportROAwl(PrefixCache* self, uint32_t session_id,
+                 PC_ROAwlChange** changes, uint32_t* noChanges);
+
+/**
+ * Use the given shared ROA table. A table created for the publication gets
+ * the white-list of the prefix cache published by publishSharedROAs. An
+ * attached table replaces the white-list: ROA white-list changes are dropped,
+ * updates are validated using the table and revalidated by
+ * refreshSharedROAs. Must be called before the first update or ROA is added.
+ *
+ * @param self The prefix cache
+ * @param table The shared ROA table.
+ *
+ * @since 0.4.1.0
+ */
+void setSharedROATable(PrefixCache* self, SharedROATable* table);
+
+/**
+ * Publish the ROA white-list into the shared ROA table if it changed since
+ * the last publication. The tree is read locked while the ROAs are copied.
+ *
+ * @param self The prefix cache
+ *
+ * @return false if the white-list could not be published.
+ *
+ * @since 0.4.1.0
+ */
+bool publishSharedROAs(PrefixCache* self);
+
+/**
+ * Map the attached shared ROA table again if it was replaced and revalidate
+ * all updates of the update cache if a new generation of the table was
+ * published. Changed validation states are reported to the update cache.
+ * Must not be called concurrently.
+ *
+ * @param self The prefix cache
+ *
+ * @return The number of updates whose validation state changed.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t refreshSharedROAs(PrefixCache* self);
+
+/**
+ * Request the origin validation of all updates of the update cache whose
+ * origin validation state is still undefined, e.g. the updates received
+ * before the first validation cache was synchronized. The changed states are
+ * reported to the update cache as for any other validation.
+ *
+ * @param self The prefix cache
+ *
+ * @return The number of updates whose validation was requested.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t validateProvisionalUpdates(PrefixCache* self);
+
 /**
  * Remove all ROA whitelist entries from the given validation cache with the 
  * given session id value. Used for giving up a cache, executing a cache reset
- * or session id change.
- * 
- * NOT IMPLEMENTED PRIOR VERSION 0.4
+ * or session id change. Only the ROAs of the validation cache are visited and
+ * all withdrawals are applied as one batch.
  * 
  * @param self The prefix cache instance
  * @param session_id the session id of this session
  * @param valCacheID the validation cache ID
- * @param deferredOnly clean only the deferred ROA's
+ * @param deferredOnly clean only the deferred ROA's. The deferred count of the
+ *                     remaining ROAs is reset.
  * 
- * @return the number of ROA white-list entries to be removed.
+ * @return the number of ROA white-list entries removed or -1 if not enough 
+ *         memory was available.
  */
 int cleanAllROAwl(PrefixCache* self, uint32_t session_id, uint32_t valCacheID,
                   bool deferredOnly);
@@ -251,22 +672,22 @@ int cleanAllROAwl(PrefixCache* self, uint32_t session_id, uint32_t valCacheID,
 /**
  * Flag all ROA white-list entries of the given validation cache with the given 
  * session id value. This is used in case a session id value switch occurred and
- * the state of ROA white-list entries gets rebuild.
+ * the state of ROA white-list entries gets rebuild. The entries stay in place 
+ * until cleanAllROAwl removes the ones not announced again.
  *
- * NOT IMPLEMENTED PRIOR VERSION 0.4.0
- * 
  * @param self The validation cache
  * @param sessionID the session id whose values have to be flagged.
  * @param valCacheID The validation cache ID.
  * 
- * @return The number of ROA white-list entries to be flagged.
+ * @return The number of ROA white-list entries flagged.
  */
 int flagAllROAwl(PrefixCache* self, uint32_t sessionID, uint32_t valCacheID);
 
 
 /**
  * Empty the complete update cache. This method empties the prefix tree and the 
- * all Updates.
+ * all Updates. A new tree and arena are swapped in while the locks are held,
+ * the old ones are released after the locks are given up.
  * 
  * @param self The update cache to be emptied!
  */
@@ -294,10 +715,25 @@ PC_Prefix* getParent(patricia_node_t* node);
  * 
  * @return The text (human readable) version of the prefix.
  *
- * @note Local, static buffer - i.e. not thread-safe!
+ * @note Buffer local to the calling thread, it is overwritten by the next 
+ *       call of the same thread.
  */
 const char* ipOfPrefix_tToStr(prefix_t* prefix);
 
+/**
+ * Writes a textual representation of a given patricia tree prefix into the 
+ * given buffer.
+ * 
+ * @param prefix The patricia tree prefix.
+ * @param buf The buffer, should be at least MAX_IP_V6_STR_LEN bytes.
+ * @param bufSize The size of the buffer.
+ * 
+ * @return The text (human readable) version of the prefix, this is buf.
+ * 
+ * @since 0.4.1.0
+ */
+const char* ipOfPrefix_tToStrBuf(prefix_t* prefix, char* buf, size_t bufSize);
+
 /**
  * Convert the cache into an XML stream
  * 
@@ -306,6 +742,20 @@ const char* ipOfPrefix_tToStr(prefix_t* prefix);
  */
 void outputPrefixCacheAsXML(PrefixCache* self, FILE* stream);
 
+/**
+ * Write the prefixes and their published ROAs as JSON lines into the given 
+ * stream. The tree lock is not taken, the tree is read in chunks within the
+ * epoch domain. The dump is not a snapshot of the cache.
+ * 
+ * @param self The prefix cache itself
+ * @param stream The stream to write it into.
+ * 
+ * @return false if the dump is incomplete.
+ * 
+ * @since 0.4.1.0
+ */
+bool dumpPrefixCache(PrefixCache* self, FILE* stream);
+
 
 
 
@@ -0,0 +1,1088 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Replicates the caches of the SRx server to a hot standby server. The changes
+ * are recorded by the threads applying them and sent by the replication thread
+ * of the primary server. The standby server applies them within one thread.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "server/cache_snapshot.h"
+#include "server/replication.h"
+#include "util/log.h"
+#include "util/thread.h"
+
+#define HDR "([0x%08X] Replication): "
+
+/** The time in milliseconds the primary server waits for a standby server
+ * before it checks if it has to stop. */
+#define REPL_ACCEPT_WAIT_MS 1000
+/** The time in milliseconds without change after which a heartbeat is sent. */
+#define REPL_HEARTBEAT_MS   500
+/** The time in seconds the standby server waits before it connects again. */
+#define REPL_RETRY_WAIT     1
+/** The initial size of the event buffer. */
+#define REPL_EVENTS_SIZE    65536
+/** The maximum size of the events not yet sent to the standby server, no
+ * single event is larger. */
+#define REPL_MAX_EVENTS     (64 * 1024 * 1024)
+/** The maximum size of the snapshot sent to the standby server. */
+#define REPL_MAX_SNAPSHOT   (4ULL * 1024 * 1024 * 1024)
+
+/** The snapshot of the caches, count is the number of sessions. */
+#define RE_TYPE_SNAPSHOT       1
+/** ROA white-list changes, count is the number of PC_ROAwlChange. */
+#define RE_TYPE_ROA_CHANGES    2
+/** The ROA white-list of a validation cache is flagged. */
+#define RE_TYPE_ROA_FLAG       3
+/** The ROA white-list of a validation cache is cleaned. */
+#define RE_TYPE_ROA_CLEAN      4
+/** The session of a validation cache changed. */
+#define RE_TYPE_SESSION        5
+/** An update was stored. */
+#define RE_TYPE_UPDATE_STORE   6
+/** The validation result of an update changed. */
+#define RE_TYPE_UPDATE_RESULT  7
+/** An update was removed by the garbage collector. */
+#define RE_TYPE_UPDATE_COLLECT 8
+/** Nothing changed, the primary server is alive. */
+#define RE_TYPE_HEARTBEAT      9
+
+/** The header of each event. */
+typedef struct {
+  /** The type of the event (RE_TYPE_...). */
+  uint32_t type;
+  /** The number of records of the event. */
+  uint32_t count;
+  /** The number of bytes following the header. */
+  uint64_t length;
+} RE_Header;
+
+/** The flagged or cleaned ROA white-list of a validation cache. */
+typedef struct {
+  uint32_t sessionID;
+  uint32_t valCacheID;
+  uint32_t deferredOnly;
+} RE_ROAwlSession;
+
+/** The session of a validation cache. */
+typedef struct {
+  RPKISession session;
+  uint32_t    hasSession;
+} RE_Session;
+
+/** An update, followed by the blob of blobLength bytes. */
+typedef struct {
+  SRxUpdateID      updateID;
+  uint32_t         asn;
+  IPPrefix         prefix;
+  SRxDefaultResult defResult;
+  SRxResult        result;
+  uint32_t         blobLength;
+  uint32_t         bgpsecAttr; // 1 if the blob is the BGPSec path attribute
+} RE_Update;
+
+static void* _replicationLoop(void* selfPtr);
+
+/**
+ * Send all the given data.
+ *
+ * @param sockFd The socket.
+ * @param data The data.
+ * @param size The number of bytes.
+ *
+ * @return false if the data could not be sent.
+ */
+static bool _sendAll(int sockFd, const void* data, size_t size)
+{
+  const uint8_t* ptr = (const uint8_t*)data;
+  ssize_t        sent;
+
+  while (size > 0)
+  {
+    sent = send(sockFd, ptr, size, MSG_NOSIGNAL);
+    if (sent <= 0)
+    {
+      return false;
+    }
+    ptr  += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+/**
+ * Receive exactly the given number of bytes.
+ *
+ * @param sockFd The socket.
+ * @param data Receives the data.
+ * @param size The number of bytes.
+ *
+ * @return false if the connection is closed or timed out.
+ */
+static bool _recvAll(int sockFd, void* data, size_t size)
+{
+  uint8_t* ptr = (uint8_t*)data;
+  ssize_t  bytes;
+
+  while (size > 0)
+  {
+    bytes = recv(sockFd, ptr, size, 0);
+    if (bytes <= 0)
+    {
+      return false;
+    }
+    ptr  += bytes;
+    size -= bytes;
+  }
+  return true;
+}
+
+/**
+ * Append an event to the recorded events if a standby server is served. The
+ * standby server is dropped if the events exceed REPL_MAX_EVENTS.
+ *
+ * @param self The replication.
+ * @param type The type of the event.
+ * @param count The number of records.
+ * @param data The records.
+ * @param length The size of the records.
+ * @param extra Data following the records or NULL.
+ * @param extraLength The size of the extra data.
+ */
+static void _record(Replication* self, uint32_t type, uint32_t count,
+                    void* data, size_t length, void* extra,
+                    size_t extraLength)
+{
+  RE_Header header;
+  size_t    needed;
+  size_t    capacity;
+  uint8_t*  events;
+
+  lockMutex(&self->mutex);
+  if (self->recording && !self->overflow)
+  {
+    needed = self->eventsSize + sizeof(RE_Header) + length + extraLength;
+    if (needed > self->eventsCapacity)
+    {
+      capacity = (self->eventsCapacity == 0) ? REPL_EVENTS_SIZE
+                                             : self->eventsCapacity;
+      while (capacity < needed)
+      {
+        capacity *= 2;
+      }
+      events = (capacity <= REPL_MAX_EVENTS)
+               ? realloc(self->events, capacity) : NULL;
+      if (events == NULL)
+      {
+        // The standby server can not keep up, it is synchronized again.
+        self->overflow = true;
+        signalCond(&self->cond);
+        unlockMutex(&self->mutex);
+        return;
+      }
+      self->events         = events;
+      self->eventsCapacity = capacity;
+    }
+    if (self->eventsSize == 0)
+    {
+      signalCond(&self->cond);
+    }
+    header.type   = type;
+    header.count  = count;
+    header.length = length + extraLength;
+    memcpy(self->events + self->eventsSize, &header, sizeof(RE_Header));
+    self->eventsSize += sizeof(RE_Header);
+    if (length > 0)
+    {
+      memcpy(self->events + self->eventsSize, data, length);
+      self->eventsSize += length;
+    }
+    if (extraLength > 0)
+    {
+      memcpy(self->events + self->eventsSize, extra, extraLength);
+      self->eventsSize += extraLength;
+    }
+  }
+  unlockMutex(&self->mutex);
+}
+
+/**
+ * Stop recording the changes and disconnect the standby server if connected.
+ *
+ * @param self The replication.
+ */
+static void _dropStandby(Replication* self)
+{
+  stopRPKIReplication(self->rpkiHandler);
+
+  lockMutex(&self->mutex);
+  self->recording  = false;
+  self->overflow   = false;
+  self->eventsSize = 0;
+  unlockMutex(&self->mutex);
+
+  if (self->standbyFd != -1)
+  {
+    close(self->standbyFd);
+    self->standbyFd = -1;
+  }
+}
+
+/**
+ * Serve the given standby server. The changes are recorded from now on, then
+ * the snapshot is sent. Changes already contained in the snapshot are ignored
+ * by the standby server.
+ *
+ * @param self The replication.
+ * @param sockFd The socket of the standby server.
+ */
+static void _acceptStandby(Replication* self, int sockFd)
+{
+  RPKISession*    sessions   = NULL;
+  uint32_t        noSessions = 0;
+  PC_ROAwlChange* roas       = NULL;
+  uint32_t        noROAs     = 0;
+  uint8_t*        data       = NULL;
+  size_t          size       = 0;
+  RE_Header       header;
+  struct timeval  timeout;
+  bool            sent = false;
+
+  timeout.tv_sec  = self->timeout;
+  timeout.tv_usec = 0;
+  setsockopt(sockFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  self->standbyFd = sockFd;
+
+  lockMutex(&self->mutex);
+  self->eventsSize = 0;
+  self->overflow   = false;
+  self->recording  = true;
+  unlockMutex(&self->mutex);
+
+  if (   startRPKIReplication(self->rpkiHandler, self, &sessions, &noSessions,
+                              &roas, &noROAs)
+      && buildCacheSnapshot(sessions, noSessions, roas, noROAs,
+                            self->updCache, &data, &size))
+  {
+    if (size > REPL_MAX_SNAPSHOT)
+    {
+      LOG(LEVEL_ERROR, "The snapshot of %zu bytes exceeds the maximum size "
+                       "of %llu bytes!", size, REPL_MAX_SNAPSHOT);
+    }
+    else
+    {
+      memset(&header, 0, sizeof(RE_Header));
+      header.type   = RE_TYPE_SNAPSHOT;
+      header.count  = noSessions;
+      header.length = size;
+      sent =    _sendAll(sockFd, &header, sizeof(RE_Header))
+             && _sendAll(sockFd, data, size);
+    }
+  }
+  free(sessions);
+  free(roas);
+  free(data);
+
+  if (sent)
+  {
+    LOG(LEVEL_INFO, "Standby server connected, snapshot of %zu bytes with %u "
+                    "sessions and %u ROA-wl entries sent", size, noSessions,
+                    noROAs);
+  }
+  else
+  {
+    LOG(LEVEL_WARNING, "Failed to send the snapshot to the standby server!");
+    _dropStandby(self);
+  }
+}
+
+/**
+ * Send the recorded events to the standby server, a heartbeat if none are
+ * recorded within REPL_HEARTBEAT_MS.
+ *
+ * @param self The replication.
+ *
+ * @return false if the standby server has to be dropped.
+ */
+static bool _sendEvents(Replication* self)
+{
+  RE_Header header;
+  uint8_t*  events;
+  size_t    capacity;
+  size_t    size;
+  bool      overflow;
+
+  lockMutex(&self->mutex);
+  if ((self->eventsSize == 0) && !self->overflow)
+  {
+    waitCond(&self->cond, &self->mutex, REPL_HEARTBEAT_MS);
+  }
+  overflow = self->overflow;
+  size     = self->eventsSize;
+  // Swap the buffers, the events are sent without lock.
+  events               = self->events;
+  capacity             = self->eventsCapacity;
+  self->events         = self->spare;
+  self->eventsCapacity = self->spareCapacity;
+  self->eventsSize     = 0;
+  self->spare          = events;
+  self->spareCapacity  = capacity;
+  unlockMutex(&self->mutex);
+
+  if (overflow)
+  {
+    LOG(LEVEL_WARNING, "The standby server does not keep up, it is "
+                       "synchronized again.");
+    return false;
+  }
+  if (size == 0)
+  {
+    memset(&header, 0, sizeof(RE_Header));
+    header.type = RE_TYPE_HEARTBEAT;
+    return _sendAll(self->standbyFd, &header, sizeof(RE_Header));
+  }
+
+  return _sendAll(self->standbyFd, self->spare, size);
+}
+
+/**
+ * Create the replication server of the primary server, bind it to the given
+ * port and start its thread. One standby server is served at a time.
+ *
+ * @param self The replication.
+ * @param port The port to listen on.
+ * @param timeout The time in seconds a standby server has to receive data.
+ * @param rpkiHandler The RPKI handler.
+ * @param updCache The update cache.
+ *
+ * @return true if the replication server could be started.
+ */
+bool createReplicationServer(Replication* self, int port, int timeout,
+                             RPKIHandler* rpkiHandler, UpdateCache* updCache)
+{
+  struct sockaddr_in srvAddr;
+  int yes = 1;
+
+  memset(self, 0, sizeof(Replication));
+  self->rpkiHandler = rpkiHandler;
+  self->updCache    = updCache;
+  self->prefixCache = rpkiHandler->prefixCache;
+  self->timeout     = timeout;
+  self->srvSockFd   = -1;
+  self->standbyFd   = -1;
+
+  if (!initMutex(&self->mutex))
+  {
+    RAISE_ERROR("Failed to initialize the replication mutex!");
+    return false;
+  }
+  if (initCond(&self->cond) != 0)
+  {
+    RAISE_ERROR("Failed to initialize the replication condition!");
+    releaseMutex(&self->mutex);
+    return false;
+  }
+
+  // Create a TCP socket
+  self->srvSockFd = socket(AF_INET, SOCK_STREAM, 0);
+  if (self->srvSockFd < 0)
+  {
+    RAISE_SYS_ERROR("Failed to open a socket");
+    destroyCond(&self->cond);
+    releaseMutex(&self->mutex);
+    return false;
+  }
+
+  // Bind to a server-address
+  memset(&srvAddr, 0, sizeof (struct sockaddr_in));
+  srvAddr.sin_family = AF_INET;
+  srvAddr.sin_addr.s_addr = INADDR_ANY;
+  srvAddr.sin_port = htons(port);
+
+  // Allow a restart without having to wait for the socket to be released.
+  setsockopt(self->srvSockFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof (yes));
+
+  if (   (bind(self->srvSockFd, (struct sockaddr*)&srvAddr,
+               sizeof (struct sockaddr_in)) < 0)
+      || (listen(self->srvSockFd, 1) < 0))
+  {
+    RAISE_SYS_ERROR("Failed to bind the replication socket to port %d", port);
+    close(self->srvSockFd);
+    destroyCond(&self->cond);
+    releaseMutex(&self->mutex);
+    return false;
+  }
+
+  // Nothing is recorded until a standby server connects.
+  setUpdateCacheReplication(updCache, self);
+  self->keepGoing = true;
+  if (createThread(&self->thread, NULL, THREAD_CLASS_HOUSEKEEPING,
+                   "srx-repl", _replicationLoop, (void*)self) != 0)
+  {
+    RAISE_ERROR("Failed to create the replication thread!");
+    self->keepGoing = false;
+    setUpdateCacheReplication(updCache, NULL);
+    close(self->srvSockFd);
+    destroyCond(&self->cond);
+    releaseMutex(&self->mutex);
+    return false;
+  }
+
+  LOG(LEVEL_INFO, "Replication server on port [%u] created.", port);
+  return true;
+}
+
+/**
+ * Stop the replication server, disconnect the standby server and release the
+ * resources. Can be called more than once.
+ *
+ * @param self The replication.
+ */
+void releaseReplicationServer(Replication* self)
+{
+  if (self->keepGoing)
+  {
+    // The thread checks the flag at least once per REPL_ACCEPT_WAIT_MS and
+    // drops the standby server before it stops.
+    self->keepGoing = false;
+    pthread_join(self->thread, NULL);
+    close(self->srvSockFd);
+    self->srvSockFd = -1;
+    // No thread records events once detached.
+    setUpdateCacheReplication(self->updCache, NULL);
+    free(self->events);
+    free(self->spare);
+    self->events = NULL;
+    self->spare  = NULL;
+    destroyCond(&self->cond);
+    releaseMutex(&self->mutex);
+  }
+}
+
+/**
+ * Serve one standby server at a time until the server is released.
+ *
+ * @param selfPtr The pointer to the replication.
+ *
+ * @return NULL
+ */
+static void* _replicationLoop(void* selfPtr)
+{
+  Replication*  self = (Replication*)selfPtr;
+  struct pollfd pfd;
+  int           sockFd;
+
+  LOG (LEVEL_DEBUG, HDR "Replication Thread started!", pthread_self());
+
+  pfd.fd     = self->srvSockFd;
+  pfd.events = POLLIN;
+  while (self->keepGoing)
+  {
+    if (self->standbyFd == -1)
+    {
+      if (poll(&pfd, 1, REPL_ACCEPT_WAIT_MS) <= 0)
+      {
+        continue;
+      }
+      sockFd = accept(self->srvSockFd, NULL, NULL);
+      if (sockFd >= 0)
+      {
+        _acceptStandby(self, sockFd);
+      }
+    }
+    else if (!_sendEvents(self))
+    {
+      LOG(LEVEL_WARNING, "Lost the standby server.");
+      _dropStandby(self);
+    }
+  }
+  if (self->standbyFd != -1)
+  {
+    _dropStandby(self);
+  }
+
+  LOG (LEVEL_DEBUG, HDR "Replication Thread stopped!", pthread_self());
+
+  return NULL;
+}
+
+/**
+ * Store, remove, or replace the session of a validation cache in the
+ * session table of the standby server.
+ *
+ * @param self The replication.
+ * @param session The session.
+ * @param hasSession false if the session was dropped.
+ */
+static void _updateSession(Replication* self, RPKISession* session,
+                           bool hasSession)
+{
+  uint32_t idx;
+
+  for (idx = 0; idx < self->noSessions; idx++)
+  {
+    if (self->sessions[idx].valCacheID == session->valCacheID)
+    {
+      break;
+    }
+  }
+  if (!hasSession)
+  {
+    if (idx < self->noSessions)
+    {
+      self->noSessions--;
+      self->sessions[idx] = self->sessions[self->noSessions];
+    }
+  }
+  else if (idx < self->noSessions)
+  {
+    self->sessions[idx] = *session;
+  }
+  else if (idx < REPL_MAX_SESSIONS)
+  {
+    self->sessions[idx] = *session;
+    self->noSessions++;
+  }
+  else
+  {
+    LOG(LEVEL_WARNING, "More than %u validation cache sessions, the session of "
+                       "cache [0x%08X] is not resumed!", REPL_MAX_SESSIONS,
+                       session->valCacheID);
+  }
+}
+
+/**
+ * Apply an update event to the caches of the standby server.
+ *
+ * @param self The replication.
+ * @param type The type of the event.
+ * @param update The update.
+ * @param blob The blob of the update.
+ */
+static void _applyUpdate(Replication* self, uint32_t type, RE_Update* update,
+                         uint8_t* blob)
+{
+  UC_UpdateStatistics statistics;
+  PC_UpdateRemoval    removal;
+  SRxResult           result;
+
+  switch (type)
+  {
+    case RE_TYPE_UPDATE_STORE:
+      // Updates already contained in the snapshot are not stored again.
+      restoreCacheUpdate(self->prefixCache, self->updCache, &update->updateID,
+                         update->asn, &update->prefix, &update->defResult,
+                         &update->result,
+                         (update->blobLength > 0) ? blob : NULL,
+                         update->blobLength, update->bgpsecAttr != 0);
+      break;
+    case RE_TYPE_UPDATE_RESULT:
+      memset(&statistics, 0, sizeof(UC_UpdateStatistics));
+      statistics.updateID = &update->updateID;
+      if (!getUpdateData(self->updCache, &statistics))
+      {
+        break;
+      }
+      if (update->result.bgpsecResult != statistics.result.bgpsecResult)
+      {
+        result.roaResult    = SRx_RESULT_DONOTUSE;
+        result.bgpsecResult = update->result.bgpsecResult;
+        modifyUpdateResult(self->updCache, &update->updateID, &result);
+      }
+      // The origin is validated using the own ROA white-list once the primary
+      // server validated it. The state is reported right away, no other
+      // thread blocks the readers of the prefix cache.
+      if (   (update->result.roaResult != SRx_RESULT_UNDEFINED)
+          && (statistics.result.roaResult == SRx_RESULT_UNDEFINED))
+      {
+        requestUpdateValidation(self->prefixCache, &update->updateID,
+                                &update->prefix, update->asn);
+      }
+      break;
+    case RE_TYPE_UPDATE_COLLECT:
+      memset(&removal, 0, sizeof(PC_UpdateRemoval));
+      removal.updateID = update->updateID;
+      removal.prefix   = update->prefix;
+      removal.as       = update->asn;
+      removeUpdates(self->prefixCache, &removal, 1);
+      collectUpdate(self->updCache, &update->updateID);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Apply an event to the caches of the standby server.
+ *
+ * @param self The replication.
+ * @param header The header of the event.
+ * @param data The data of the event.
+ *
+ * @return false if the event is not valid.
+ */
+static bool _applyEvent(Replication* self, RE_Header* header, uint8_t* data)
+{
+  RE_ROAwlSession* roaSession = (RE_ROAwlSession*)data;
+  RE_Session*      session    = (RE_Session*)data;
+  RE_Update*       update     = (RE_Update*)data;
+
+  switch (header->type)
+  {
+    case RE_TYPE_HEARTBEAT:
+      return header->length == 0;
+    case RE_TYPE_ROA_CHANGES:
+      if (header->length != header->count * sizeof(PC_ROAwlChange))
+      {
+        return false;
+      }
+      applyROAwlChanges(self->prefixCache, (PC_ROAwlChange*)data,
+                        header->count);
+      return true;
+    case RE_TYPE_ROA_FLAG:
+    case RE_TYPE_ROA_CLEAN:
+      if (header->length != sizeof(RE_ROAwlSession))
+      {
+        return false;
+      }
+      if (header->type == RE_TYPE_ROA_FLAG)
+      {
+        flagAllROAwl(self->prefixCache, roaSession->sessionID,
+                     roaSession->valCacheID);
+      }
+      else
+      {
+        cleanAllROAwl(self->prefixCache, roaSession->sessionID,
+                      roaSession->valCacheID, roaSession->deferredOnly != 0);
+      }
+      return true;
+    case RE_TYPE_SESSION:
+      if (header->length != sizeof(RE_Session))
+      {
+        return false;
+      }
+      _updateSession(self, &session->session, session->hasSession != 0);
+      return true;
+    case RE_TYPE_UPDATE_STORE:
+    case RE_TYPE_UPDATE_RESULT:
+    case RE_TYPE_UPDATE_COLLECT:
+      if (   (header->length < sizeof(RE_Update))
+          || (header->length != sizeof(RE_Update) + update->blobLength))
+      {
+        return false;
+      }
+      _applyUpdate(self, header->type, update, data + sizeof(RE_Update));
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Connect to the primary server. The timeout bounds the connect and each
+ * receive.
+ *
+ * @param host The host of the primary server.
+ * @param port The replication port of the primary server.
+ * @param timeout The timeout in seconds.
+ *
+ * @return The socket or -1 if no connection could be established.
+ */
+static int _connectPrimary(const char* host, int port, int timeout)
+{
+  struct hostent*    svr;
+  struct sockaddr_in svrAddr;
+  struct timeval     tv;
+  int                sockFd;
+
+  svr = gethostbyname(host);
+  if (svr == NULL)
+  {
+    LOG(LEVEL_WARNING, "Unknown primary server '%s'", host);
+    return -1;
+  }
+
+  sockFd = socket(AF_INET, SOCK_STREAM, 0);
+  if (sockFd < 0)
+  {
+    RAISE_SYS_ERROR("Failed to open a socket");
+    return -1;
+  }
+  tv.tv_sec  = timeout;
+  tv.tv_usec = 0;
+  setsockopt(sockFd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  setsockopt(sockFd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  memset(&svrAddr, 0, sizeof (struct sockaddr_in));
+  svrAddr.sin_family = AF_INET;
+  svrAddr.sin_port   = htons(port);
+  memcpy(&svrAddr.sin_addr.s_addr, svr->h_addr, svr->h_length);
+  if (connect(sockFd, (struct sockaddr*)&svrAddr, sizeof(svrAddr)) != 0)
+  {
+    close(sockFd);
+    return -1;
+  }
+
+  return sockFd;
+}
+
+/**
+ * Receive the snapshot and the changes from the primary server and apply them
+ * until the connection is lost. The connection is given up once the primary
+ * server announces a snapshot larger than REPL_MAX_SNAPSHOT or an event larger
+ * than REPL_MAX_EVENTS.
+ *
+ * @param self The replication.
+ * @param sockFd The socket of the primary server.
+ * @param loaded OUT - Set once the caches are modified.
+ */
+static void _followPrimary(Replication* self, int sockFd, bool* loaded)
+{
+  RE_Header    header;
+  uint8_t*     data     = NULL;
+  size_t       dataSize = 0;
+  uint8_t*     newData;
+  RPKISession* sessions;
+  uint32_t     noSessions;
+  uint32_t     idx;
+
+  while (_recvAll(sockFd, &header, sizeof(RE_Header)))
+  {
+    // The length is not trusted before it is checked, the first event is the
+    // snapshot.
+    if (header.length > (*loaded ? REPL_MAX_EVENTS : REPL_MAX_SNAPSHOT))
+    {
+      LOG(LEVEL_ERROR, "Invalid length of %llu bytes received from the "
+                       "primary server!", (unsigned long long)header.length);
+      break;
+    }
+    if (header.length > dataSize)
+    {
+      newData = realloc(data, header.length);
+      if (newData == NULL)
+      {
+        RAISE_SYS_ERROR("Not enough memory to receive %llu bytes from the "
+                        "primary server!", (unsigned long long)header.length);
+        break;
+      }
+      data     = newData;
+      dataSize = header.length;
+    }
+    if ((header.length > 0) && !_recvAll(sockFd, data, header.length))
+    {
+      break;
+    }
+
+    if (!*loaded)
+    {
+      if (   (header.type != RE_TYPE_SNAPSHOT)
+          || !loadCacheSnapshotData(data, header.length, self->prefixCache,
+                                    self->updCache, &sessions, &noSessions))
+      {
+        LOG(LEVEL_ERROR, "Invalid snapshot received from the primary "
+                         "server!");
+        break;
+      }
+      *loaded = true;
+      self->noSessions = 0;
+      for (idx = 0; idx < noSessions; idx++)
+      {
+        _updateSession(self, &sessions[idx], true);
+      }
+      free(sessions);
+      LOG(LEVEL_INFO, "Synchronized with the primary server, following %u "
+                      "sessions", self->noSessions);
+    }
+    else if (!_applyEvent(self, &header, data))
+    {
+      LOG(LEVEL_ERROR, "Invalid event of type %u received from the primary "
+                       "server!", header.type);
+      break;
+    }
+  }
+  free(data);
+}
+
+/**
+ * Follow the given primary server until it can not be reached for the given
+ * timeout. The snapshot and the changes received are applied to the empty
+ * caches. The garbage collector of the update cache must not run, the updates
+ * are collected as the primary server collects them.
+ *
+ * @param self The replication.
+ * @param host The host of the primary server.
+ * @param port The replication port of the primary server.
+ * @param timeout The time in seconds after which the primary server is lost.
+ * @param prefixCache The prefix cache.
+ * @param updCache The update cache.
+ * @param sessions OUT - The sessions of the validation caches to be resumed,
+ *                 NULL if there are none. Must be freed by the caller.
+ * @param noSessions OUT - The number of sessions.
+ *
+ * @return false if not enough memory was available.
+ */
+bool runReplicationStandby(Replication* self, const char* host, int port,
+                           int timeout, PrefixCache* prefixCache,
+                           UpdateCache* updCache, RPKISession** sessions,
+                           uint32_t* noSessions)
+{
+  bool   loaded = false;
+  time_t lost;
+  int    sockFd;
+
+  memset(self, 0, sizeof(Replication));
+  self->prefixCache = prefixCache;
+  self->updCache    = updCache;
+  self->timeout     = timeout;
+  self->srvSockFd   = -1;
+  self->standbyFd   = -1;
+  *sessions   = NULL;
+  *noSessions = 0;
+
+  LOG(LEVEL_INFO, "Standby server of the primary server %s:%d", host, port);
+  lost = time(NULL);
+  while (time(NULL) - lost < timeout)
+  {
+    sockFd = _connectPrimary(host, port, timeout);
+    if (sockFd == -1)
+    {
+      sleep(REPL_RETRY_WAIT);
+      continue;
+    }
+    // The snapshot replaces all data received before.
+    if (loaded)
+    {
+      emptyCache(prefixCache);
+      emptyUpdateCache(updCache);
+      self->noSessions = 0;
+      loaded = false;
+    }
+    _followPrimary(self, sockFd, &loaded);
+    close(sockFd);
+    LOG(LEVEL_WARNING, "Lost the connection to the primary server.");
+    lost = time(NULL);
+  }
+
+  LOG(LEVEL_INFO, "Primary server not reachable, taking over with %u "
+                  "sessions", self->noSessions);
+  if (self->noSessions > 0)
+  {
+    *sessions = malloc(self->noSessions * sizeof(RPKISession));
+    if (*sessions == NULL)
+    {
+      RAISE_SYS_ERROR("Not enough memory to resume the sessions!");
+      return false;
+    }
+    memcpy(*sessions, self->sessions, self->noSessions * sizeof(RPKISession));
+    *noSessions = self->noSessions;
+  }
+
+  return true;
+}
+
+/**
+ * Replicate the given ROA white-list changes.
+ *
+ * @param self The replication.
+ * @param changes The changes in the order applied.
+ * @param noChanges The number of changes.
+ */
+void replicateROAwlChanges(Replication* self, PC_ROAwlChange* changes,
+                           uint32_t noChanges)
+{
+  if (self->recording && (noChanges > 0))
+  {
+    _record(self, RE_TYPE_ROA_CHANGES, noChanges, changes,
+            noChanges * sizeof(PC_ROAwlChange), NULL, 0);
+  }
+}
+
+/**
+ * Replicate the flagging of the ROA white-list entries of a validation cache.
+ *
+ * @param self The replication.
+ * @param sessionID The session id.
+ * @param valCacheID The validation cache ID.
+ */
+void replicateROAwlFlag(Replication* self, uint32_t sessionID,
+                        uint32_t valCacheID)
+{
+  RE_ROAwlSession event;
+
+  if (self->recording)
+  {
+    memset(&event, 0, sizeof(RE_ROAwlSession));
+    event.sessionID  = sessionID;
+    event.valCacheID = valCacheID;
+    _record(self, RE_TYPE_ROA_FLAG, 1, &event, sizeof(RE_ROAwlSession),
+            NULL, 0);
+  }
+}
+
+/**
+ * Replicate the cleaning of the ROA white-list entries of a validation cache.
+ *
+ * @param self The replication.
+ * @param sessionID The session id.
+ * @param valCacheID The validation cache ID.
+ * @param deferredOnly clean only the deferred ROA's.
+ */
+void replicateROAwlClean(Replication* self, uint32_t sessionID,
+                         uint32_t valCacheID, bool deferredOnly)
+{
+  RE_ROAwlSession event;
+
+  if (self->recording)
+  {
+    memset(&event, 0, sizeof(RE_ROAwlSession));
+    event.sessionID    = sessionID;
+    event.valCacheID   = valCacheID;
+    event.deferredOnly = deferredOnly ? 1 : 0;
+    _record(self, RE_TYPE_ROA_CLEAN, 1, &event, sizeof(RE_ROAwlSession),
+            NULL, 0);
+  }
+}
+
+/**
+ * Replicate the session of a validation cache.
+ *
+ * @param self The replication.
+ * @param session The session.
+ * @param hasSession false if the session was dropped.
+ */
+void replicateSession(Replication* self, RPKISession* session,
+                      bool hasSession)
+{
+  RE_Session event;
+
+  if (self->recording)
+  {
+    memset(&event, 0, sizeof(RE_Session));
+    event.session    = *session;
+    event.hasSession = hasSession ? 1 : 0;
+    _record(self, RE_TYPE_SESSION, 1, &event, sizeof(RE_Session), NULL, 0);
+  }
+}
+
+/**
+ * Replicate an update stored in the update cache.
+ *
+ * @param self The replication.
+ * @param updateID The id of the update.
+ * @param asn The origin AS of the update.
+ * @param prefix The prefix of the update.
+ * @param defResult The default result of the update.
+ * @param blob The update blob or NULL.
+ * @param blobLength The length of the blob.
+ * @param bgpsecAttr true if the blob is the BGPSec path attribute, false if
+ *                   it is the AS path.
+ */
+void replicateUpdateStore(Replication* self, SRxUpdateID* updateID,
+                          uint32_t asn, IPPrefix* prefix,
+                          SRxDefaultResult* defResult, uint8_t* blob,
+                          uint32_t blobLength, bool bgpsecAttr)
+{
+  RE_Update event;
+
+  if (self->recording)
+  {
+    memset(&event, 0, sizeof(RE_Update));
+    event.updateID            = *updateID;
+    event.asn                 = asn;
+    event.prefix              = *prefix;
+    event.defResult           = *defResult;
+    event.result.roaResult    = SRx_RESULT_UNDEFINED;
+    event.result.bgpsecResult = SRx_RESULT_UNDEFINED;
+    event.blobLength          = (blob != NULL) ? blobLength : 0;
+    event.bgpsecAttr          = bgpsecAttr ? 1 : 0;
+    _record(self, RE_TYPE_UPDATE_STORE, 1, &event, sizeof(RE_Update), blob,
+            event.blobLength);
+  }
+}
+
+/**
+ * Replicate the changed validation result of an update.
+ *
+ * @param self The replication.
+ * @param updateID The id of the update.
+ * @param prefix The prefix of the update.
+ * @param asn The origin AS of the update.
+ * @param result The validation result.
+ */
+void replicateUpdateResult(Replication* self, SRxUpdateID* updateID,
+                           IPPrefix* prefix, uint32_t asn, SRxResult* result)
+{
+  RE_Update event;
+
+  if (self->recording)
+  {
+    memset(&event, 0, sizeof(RE_Update));
+    event.updateID = *updateID;
+    event.asn      = asn;
+    event.prefix   = *prefix;
+    event.result   = *result;
+    _record(self, RE_TYPE_UPDATE_RESULT, 1, &event, sizeof(RE_Update), NULL,
+            0);
+  }
+}
+
+/**
+ * Replicate the removal of an update by the garbage collector.
+ *
+ * @param self The replication.
+ * @param updateID The id of the update.
+ * @param prefix The prefix of the update.
+ * @param asn The origin AS of the update.
+ */
+void replicateUpdateCollect(Replication* self, SRxUpdateID* updateID,
+                            IPPrefix* prefix, uint32_t asn)
+{
+  RE_Update event;
+
+  if (self->recording)
+  {
+    memset(&event, 0, sizeof(RE_Update));
+    event.updateID            = *updateID;
+    event.asn                 = asn;
+    event.prefix              = *prefix;
+    event.result.roaResult    = SRx_RESULT_UNDEFINED;
+    event.result.bgpsecResult = SRx_RESULT_UNDEFINED;
+    _record(self, RE_TYPE_UPDATE_COLLECT, 1, &event, sizeof(RE_Update), NULL,
+            0);
+  }
+}
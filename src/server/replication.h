@@ -0,0 +1,229 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Replicates the caches of the SRx server to a hot standby server. The primary
+ * server sends a snapshot of the validation cache sessions, the ROA
+ * white-list, and the update cache to the standby server once it connects,
+ * followed by all changes in the order they are applied. The standby server
+ * applies them to its own caches and takes over once the primary server can
+ * not be reached for the configured timeout. It then resumes the validation
+ * cache sessions with a serial query and keeps the updates for the keep window
+ * so the proxies can register for them again.
+ *
+ * The data is sent in host byte order, both servers must run the same build on
+ * the same architecture.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __REPLICATION_H__
+#define __REPLICATION_H__
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "server/prefix_cache.h"
+#include "server/rpki_handler.h"
+#include "server/update_cache.h"
+#include "util/mutex.h"
+
+/** The maximum number of validation cache sessions a standby server follows.
+ */
+#define REPL_MAX_SESSIONS 256
+
+/** Contains the information needed for the replication of the caches. */
+typedef struct _Replication {
+  /** The RPKI handler of the primary server. */
+  RPKIHandler*  rpkiHandler;
+  /** The update cache. */
+  UpdateCache*  updCache;
+  /** The prefix cache. */
+  PrefixCache*  prefixCache;
+  /** The time in seconds without data after which the peer is lost. */
+  int           timeout;
+
+  /** The server socket file descriptor of the primary server. */
+  int           srvSockFd;
+  /** The socket of the standby server, -1 if none is connected. */
+  int           standbyFd;
+  /** The thread sending the changes to the standby server. */
+  pthread_t     thread;
+  /** Indicates if the primary server has to keep running. */
+  volatile bool keepGoing;
+
+  /** Protects the recorded events. */
+  Mutex         mutex;
+  /** Signals recorded events to the thread. */
+  Cond          cond;
+  /** Indicates if the changes are recorded for a standby server. */
+  volatile bool recording;
+  /** Set if the events exceeded the limit, the standby server is dropped. */
+  bool          overflow;
+  /** The recorded events not yet sent. */
+  uint8_t*      events;
+  /** The number of bytes used in events. */
+  size_t        eventsSize;
+  /** The size of events. */
+  size_t        eventsCapacity;
+  /** The events currently sent by the thread. */
+  uint8_t*      spare;
+  /** The size of spare. */
+  size_t        spareCapacity;
+
+  /** The validation cache sessions followed by the standby server. */
+  RPKISession   sessions[REPL_MAX_SESSIONS];
+  /** The number of sessions. */
+  uint32_t      noSessions;
+} Replication;
+
+/**
+ * Create the replication server of the primary server, bind it to the given
+ * port and start its thread. One standby server is served at a time.
+ *
+ * @param self The replication.
+ * @param port The port to listen on.
+ * @param timeout The time in seconds a standby server has to receive data.
+ * @param rpkiHandler The RPKI handler.
+ * @param updCache The update cache.
+ *
+ * @return true if the replication server could be started.
+ */
+bool createReplicationServer(Replication* self, int port, int timeout,
+                             RPKIHandler* rpkiHandler, UpdateCache* updCache);
+
+/**
+ * Stop the replication server, disconnect the standby server and release the
+ * resources. Can be called more than once.
+ *
+ * @param self The replication.
+ */
+void releaseReplicationServer(Replication* self);
+
+/**
+ * Follow the given primary server until it can not be reached for the given
+ * timeout. The snapshot and the changes received are applied to the empty
+ * caches. The garbage collector of the update cache must not run, the updates
+ * are collected as the primary server collects them.
+ *
+ * @param self The replication.
+ * @param host The host of the primary server.
+ * @param port The replication port of the primary server.
+ * @param timeout The time in seconds after which the primary server is lost.
+ * @param prefixCache The prefix cache.
+ * @param updCache The update cache.
+ * @param sessions OUT - The sessions of the validation caches to be resumed,
+ *                 NULL if there are none. Must be freed by the caller.
+ * @param noSessions OUT - The number of sessions.
+ *
+ * @return false if not enough memory was available.
+ */
+bool runReplicationStandby(Replication* self, const char* host, int port,
+                           int timeout, PrefixCache* prefixCache,
+                           UpdateCache* updCache, RPKISession** sessions,
+                           uint32_t* noSessions);
+
+/**
+ * Replicate the given ROA white-list changes.
+ *
+ * @param self The replication.
+ * @param changes The changes in the order applied.
+ * @param noChanges The number of changes.
+ */
+void replicateROAwlChanges(Replication* self, PC_ROAwlChange* changes,
+                           uint32_t noChanges);
+
+/**
+ * Replicate the flagging of the ROA white-list entries of a validation cache.
+ *
+ * @param self The replication.
+ * @param sessionID The session id.
+ * @param valCacheID The validation cache ID.
+ */
+void replicateROAwlFlag(Replication* self, uint32_t sessionID,
+                        uint32_t valCacheID);
+
+/**
+ * Replicate the cleaning of the ROA white-list entries of a validation cache.
+ *
+ * @param self The replication.
+ * @param sessionID The session id.
+ * @param valCacheID The validation cache ID.
+ * @param deferredOnly clean only the deferred ROA's.
+ */
+void replicateROAwlClean(Replication* self, uint32_t sessionID,
+                         uint32_t valCacheID, bool deferredOnly);
+
+/**
+ * Replicate the session of a validation cache.
+ *
+ * @param self The replication.
+ * @param session The session.
+ * @param hasSession false if the session was dropped.
+ */
+void replicateSession(Replication* self, RPKISession* session,
+                      bool hasSession);
+
+/**
+ * Replicate an update stored in the update cache.
+ *
+ * @param self The replication.
+ * @param updateID The id of the update.
+ * @param asn The origin AS of the update.
+ * @param prefix The prefix of the update.
+ * @param defResult The default result of the update.
+ * @param blob The update blob or NULL.
+ * @param blobLength The length of the blob.
+ * @param bgpsecAttr true if the blob is the BGPSec path attribute, false if
+ *                   it is the AS path.
+ */
+void replicateUpdateStore(Replication* self, SRxUpdateID* updateID,
+                          uint32_t asn, IPPrefix* prefix,
+                          SRxDefaultResult* defResult, uint8_t* blob,
+                          uint32_t blobLength, bool bgpsecAttr);
+
+/**
+ * Replicate the changed validation result of an update.
+ *
+ * @param self The replication.
+ * @param updateID The id of the update.
+ * @param prefix The prefix of the update.
+ * @param asn The origin AS of the update.
+ * @param result The validation result.
+ */
+void replicateUpdateResult(Replication* self, SRxUpdateID* updateID,
+                           IPPrefix* prefix, uint32_t asn, SRxResult* result);
+
+/**
+ * Replicate the removal of an update by the garbage collector.
+ *
+ * @param self The replication.
+ * @param updateID The id of the update.
+ * @param prefix The prefix of the update.
+ * @param asn The origin AS of the update.
+ */
+void replicateUpdateCollect(Replication* self, SRxUpdateID* updateID,
+                            IPPrefix* prefix, uint32_t asn);
+
+#endif // !__REPLICATION_H__
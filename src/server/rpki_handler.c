@@ -22,10 +22,31 @@
  *
  * This handler processes ROA validation
  *
- * @version 0.3.0
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0 - 2026/10/14 - kyehwanl
+ *           * Prefix announcements and withdrawals are staged and applied
+ *             to the prefix cache in one pass once End of Data is received.
+ *             Staged changes are dropped on cache reset and connection loss.
+ *           * Keep the session id and serial of the applied data. A session
+ *             restored from a snapshot is resumed with a serial query.
+ *           * Implemented the cache reset. The ROAs of the validation cache 
+ *             are flagged and the ones not announced again are removed at the
+ *             next End of Data. The same happens for the reset query sent 
+ *             after a connection loss.
+ *           * The sessions to all configured validation caches run in 
+ *             parallel. The first cache that completes its data serves the
+ *             initial validation, the others are merged in as they complete.
+ *         - 2026/10/15 - kyehwanl
+ *           * Keep the time of the last End of Data of each cache.
+ *           * Store the router keys in the key cache.
+ *           * Added setRPKISyncCallback, called once the first cache is
+ *             synchronized.
+ *           * Added startRPKIReplication and stopRPKIReplication. The changes
+ *             of the ROA white-list and of the sessions are replicated to the
+ *             standby server.
  *   0.3.0 - 2013/01/28 - oborchert
  *           * Update to be compliant to draft-ietf-sidr-rpki-rtr.26. This
  *             update does not include the secure protocol section. The protocol
@@ -40,6 +61,8 @@
  * -----------------------------------------------------------------------------
  */
 
+#include <stdlib.h>
+#include "server/replication.h"
 #include "server/rpki_handler.h"
 #include "util/log.h"
 
@@ -53,6 +76,8 @@
 #define DEFAULT_FLAGS   0x0
 /** Keep the connection upon an error */
 #define KEEP_CONNECTION true
+/** Initial number of ROA white-list changes the staging area can hold. */
+#define INITIAL_STAGE_SIZE 1024
 
 #define HDR "([0x%08X] RPKI Handler): "
 
@@ -62,46 +87,168 @@
 
 static void handlePrefix (uint32_t valCacheID, uint16_t session_id,
                           bool isAnn, IPPrefix* prefix, uint16_t maxLen,
-                          uint32_t oas, void* rpkiHandler);
-static void handleReset (uint32_t valCacheID, void* rpkiHandler);
-static bool handleError (uint16_t errNo, const char* msg, void* rpkiHandler);
+                          uint32_t oas, void* rpkiCache);
+static void handleReset (uint32_t valCacheID, void* rpkiCache);
+static void handleEndOfData (uint32_t valCacheID, uint16_t session_id,
+                             void* rpkiCache);
+static bool handleError (uint16_t errNo, const char* msg, void* rpkiCache);
 static int handleConnection (void* user);
 static void handleRouterKey (uint32_t valCacheID, uint16_t session_id,
                           bool isAnn, uint32_t oas, const char* ski,
-                          const char* keyInfo, void* rpkiHandler);
+                          const char* keyInfo, void* rpkiCache);
 
 
 
 
 /**
- * Configure the RPKI Handler and create an RPKIRouter client.
+ * Configure the RPKI Handler and create an RPKIRouter client for each
+ * validation cache.
  *
  * @param handler The RPKIHandler instance.
  * @param prefixCache The instance of the prefix cache
- * @param serverHost The RPKI/Router server (RPKI Validation Cache)
- * @param serverPort The port of the server to be connected to.
+ * @param keyCache The instance of the key cache
+ * @param serverHosts The RPKI/Router servers (RPKI Validation Caches)
+ * @param serverPorts The ports of the servers to be connected to.
+ * @param noServers The number of servers.
+ * @param sessions The sessions whose ROAs are already stored in the prefix 
+ *                 cache.
+ * @param noSessions The number of sessions.
  * @return
  */
 bool createRPKIHandler (RPKIHandler* handler, PrefixCache* prefixCache,
-                        const char* serverHost, int serverPort)
+                        KeyCache* keyCache, const char** serverHosts, int* serverPorts,
+                        uint8_t noServers, RPKISession* sessions,
+                        uint32_t noSessions)
 {
+  RPKICache* cache;
+  uint32_t   valCacheID;
+  uint32_t   sIdx;
+  int        idx;
+  int        cIdx;
+
   // Attach the prefix cache
   handler->prefixCache = prefixCache;
+  handler->keyCache    = keyCache;
+  handler->caches      = NULL;
+  handler->noCaches    = 0;
+  handler->syncedCache = NULL;
+  handler->started     = time(NULL);
+  handler->syncCallback = NULL;
+  handler->syncUser     = NULL;
+  handler->replication  = NULL;
+
+  if (noServers == 0)
+  {
+    RAISE_ERROR("No validation cache specified");
+    return false;
+  }
+  if (!initMutex(&handler->sessionMutex))
+  {
+    RAISE_ERROR("Failed to initialize the session mutex");
+    return false;
+  }
+  // Nothing staged yet, the staging areas are allocated on demand.
+  handler->caches = calloc(noServers, sizeof(RPKICache));
+  if (handler->caches == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for %u validation caches", noServers);
+    releaseMutex(&handler->sessionMutex);
+    return false;
+  }
 
-  // Create the RPKI/Router protocol client instance
-  handler->rrclParams.prefixCallback     = handlePrefix;
-  handler->rrclParams.resetCallback      = handleReset;
-  handler->rrclParams.errorCallback      = handleError;
-  handler->rrclParams.routerKeyCallback  = handleRouterKey;
-  handler->rrclParams.connectionCallback = handleConnection;
+  for (idx = 0; idx < noServers; idx++)
+  {
+    cache = &handler->caches[idx];
+    cache->handler = handler;
 
-  handler->rrclParams.serverHost         = serverHost;
-  handler->rrclParams.serverPort         = serverPort;
+    cache->rrclParams.prefixCallback     = handlePrefix;
+    cache->rrclParams.resetCallback      = handleReset;
+    cache->rrclParams.endOfDataCallback  = handleEndOfData;
+    cache->rrclParams.errorCallback      = handleError;
+    cache->rrclParams.routerKeyCallback  = handleRouterKey;
+    cache->rrclParams.connectionCallback = handleConnection;
 
-  if (!createRPKIRouterClient(&handler->rrclInstance, &handler->rrclParams,
-                               handler))
+    cache->rrclParams.serverHost         = serverHosts[idx];
+    cache->rrclParams.serverPort         = serverPorts[idx];
+
+    // The ID is needed to find the restored session of the cache.
+    cache->rrclInstance.params = &cache->rrclParams;
+    valCacheID = createRouterClientID(&cache->rrclInstance);
+    for (cIdx = 0; cIdx < idx; cIdx++)
+    {
+      if (handler->caches[cIdx].rrclInstance.routerClientID == valCacheID)
+      {
+        RAISE_ERROR("Validation cache %s:%d is specified twice", 
+                    serverHosts[idx], serverPorts[idx]);
+        free(handler->caches);
+        handler->caches = NULL;
+        releaseMutex(&handler->sessionMutex);
+        return false;
+      }
+    }
+    cache->rrclInstance.routerClientID = valCacheID;
+    cache->rrclInstance.resumeSession  = false;
+
+    for (sIdx = 0; sIdx < noSessions; sIdx++)
+    {
+      if (sessions[sIdx].valCacheID == valCacheID)
+      {
+        // The data of the session is in the prefix cache already.
+        cache->hasSession = true;
+        cache->sessionID  = sessions[sIdx].sessionID;
+        cache->serial     = sessions[sIdx].serial;
+
+        cache->rrclInstance.sessionID     = cache->sessionID;
+        cache->rrclInstance.serial        = cache->serial;
+        cache->rrclInstance.resumeSession = true;
+        if (handler->syncedCache == NULL)
+        {
+          handler->syncedCache = cache;
+        }
+        break;
+      }
+    }
+  }
+  handler->noCaches = noServers;
+
+  // Remove the restored ROAs of validation caches no longer configured.
+  for (sIdx = 0; sIdx < noSessions; sIdx++)
   {
-    return false;
+    for (idx = 0; idx < noServers; idx++)
+    {
+      if (handler->caches[idx].rrclInstance.routerClientID 
+          == sessions[sIdx].valCacheID)
+      {
+        break;
+      }
+    }
+    if (idx == noServers)
+    {
+      LOG(LEVEL_INFO, HDR "Removed %d restored ROA-wl entries of the no longer"
+                      " configured validation cache 0x%08X", pthread_self(),
+                      cleanAllROAwl(prefixCache, sessions[sIdx].sessionID,
+                                    sessions[sIdx].valCacheID, false),
+                      sessions[sIdx].valCacheID);
+    }
+  }
+
+  // Create the RPKI/Router protocol client instances, they run in parallel.
+  for (idx = 0; idx < noServers; idx++)
+  {
+    cache = &handler->caches[idx];
+    if (!createRPKIRouterClient(&cache->rrclInstance, &cache->rrclParams,
+                                cache))
+    {
+      while (idx-- > 0)
+      {
+        releaseRPKIRouterClient(&handler->caches[idx].rrclInstance);
+      }
+      free(handler->caches);
+      handler->caches   = NULL;
+      handler->noCaches = 0;
+      releaseMutex(&handler->sessionMutex);
+      return false;
+    }
   }
 
   return true;
@@ -114,9 +261,261 @@ bool createRPKIHandler (RPKIHandler* handler, PrefixCache* prefixCache,
  */
 void releaseRPKIHandler(RPKIHandler* handler)
 {
+  int idx;
+
   if (handler != NULL)
   {
-    releaseRPKIRouterClient(&handler->rrclInstance);
+    for (idx = 0; idx < handler->noCaches; idx++)
+    {
+      releaseRPKIRouterClient(&handler->caches[idx].rrclInstance);
+      free(handler->caches[idx].staged);
+    }
+    free(handler->caches);
+    handler->caches      = NULL;
+    handler->noCaches    = 0;
+    handler->syncedCache = NULL;
+    releaseMutex(&handler->sessionMutex);
+  }
+}
+
+/**
+ * Copy the sessions of all validation caches that completed a serial. The
+ * caller MUST hold the session mutex.
+ *
+ * @param handler The RPKI handler.
+ * @param sessions OUT - The sessions. Must be freed by the caller.
+ * @param noSessions OUT - The number of sessions.
+ *
+ * @return false if not enough memory was available.
+ *
+ * @since 0.4.1.0
+ */
+static bool _copySessions(RPKIHandler* handler, RPKISession** sessions,
+                          uint32_t* noSessions)
+{
+  RPKICache* cache;
+  int        idx;
+
+  *noSessions = 0;
+  *sessions   = malloc(handler->noCaches * sizeof(RPKISession));
+  if (*sessions == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory to export the sessions!");
+    return false;
+  }
+  for (idx = 0; idx < handler->noCaches; idx++)
+  {
+    cache = &handler->caches[idx];
+    if (cache->hasSession)
+    {
+      (*sessions)[*noSessions].valCacheID = cache->rrclInstance.routerClientID;
+      (*sessions)[*noSessions].sessionID  = cache->sessionID;
+      (*sessions)[*noSessions].serial     = cache->serial;
+      (*noSessions)++;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Export the sessions of all validation caches that completed a serial and
+ * the ROA white-list entries of these caches.
+ *
+ * @param handler The RPKI handler.
+ * @param sessions OUT - The sessions. Must be freed by the caller.
+ * @param noSessions OUT - The number of sessions.
+ * @param roas OUT - The ROA white-list entries. Must be freed by the caller.
+ * @param noROAs OUT - The number of ROA white-list entries.
+ *
+ * @return false if no validation cache completed a serial (yet).
+ *
+ * @since 0.4.1.0
+ */
+bool exportRPKISessions(RPKIHandler* handler, RPKISession** sessions, 
+                        uint32_t* noSessions, PC_ROAwlChange** roas,
+                        uint32_t* noROAs)
+{
+  uint32_t   readIdx;
+  uint32_t   sIdx;
+  uint32_t   kept = 0;
+  
+  *sessions   = NULL;
+  *noSessions = 0;
+  *roas       = NULL;
+  *noROAs     = 0;
+
+  lockMutex(&handler->sessionMutex);
+  if (!_copySessions(handler, sessions, noSessions))
+  {
+    unlockMutex(&handler->sessionMutex);
+    return false;
+  }
+  
+  if ((*noSessions > 0) && exportROAwl(handler->prefixCache, 0, roas, noROAs))
+  {
+    // Keep the ROAs of the exported sessions only.
+    for (readIdx = 0; readIdx < *noROAs; readIdx++)
+    {
+      for (sIdx = 0; sIdx < *noSessions; sIdx++)
+      {
+        if ((*sessions)[sIdx].valCacheID == (*roas)[readIdx].valCacheID)
+        {
+          (*roas)[kept] = (*roas)[readIdx];
+          (*roas)[kept++].session_id = (*sessions)[sIdx].sessionID;
+          break;
+        }
+      }
+    }
+    *noROAs = kept;
+  }
+  else
+  {
+    free(*sessions);
+    *sessions   = NULL;
+    *noSessions = 0;
+  }
+  unlockMutex(&handler->sessionMutex);
+  
+  return *noSessions > 0;
+}
+
+/**
+ * Export the sessions of all validation caches that completed a serial and
+ * all ROA white-list entries, then attach the replication. All changes after
+ * the export are replicated, the flags of the caches that are reloaded are
+ * replicated right away.
+ *
+ * @param handler The RPKI handler.
+ * @param replication The replication to the standby server.
+ * @param sessions OUT - The sessions. Must be freed by the caller.
+ * @param noSessions OUT - The number of sessions.
+ * @param roas OUT - All ROA white-list entries. Must be freed by the caller.
+ * @param noROAs OUT - The number of ROA white-list entries.
+ *
+ * @return false if not enough memory was available, the replication is not
+ *         attached then.
+ *
+ * @since 0.4.1.0
+ */
+bool startRPKIReplication(RPKIHandler* handler,
+                          struct _Replication* replication,
+                          RPKISession** sessions, uint32_t* noSessions,
+                          PC_ROAwlChange** roas, uint32_t* noROAs)
+{
+  RPKICache* cache;
+  uint32_t   rIdx;
+  int        idx;
+
+  *roas   = NULL;
+  *noROAs = 0;
+
+  lockMutex(&handler->sessionMutex);
+  if (   !_copySessions(handler, sessions, noSessions)
+      || !exportROAwl(handler->prefixCache, 0, roas, noROAs))
+  {
+    unlockMutex(&handler->sessionMutex);
+    free(*sessions);
+    *sessions   = NULL;
+    *noSessions = 0;
+    return false;
+  }
+  // The ROAs of a cache without session are exported as well, its reload
+  // continues on the standby.
+  for (rIdx = 0; rIdx < *noROAs; rIdx++)
+  {
+    for (idx = 0; idx < handler->noCaches; idx++)
+    {
+      cache = &handler->caches[idx];
+      if (cache->rrclInstance.routerClientID == (*roas)[rIdx].valCacheID)
+      {
+        (*roas)[rIdx].session_id = cache->sessionID;
+        break;
+      }
+    }
+  }
+  handler->replication = replication;
+  for (idx = 0; idx < handler->noCaches; idx++)
+  {
+    cache = &handler->caches[idx];
+    if (cache->resetPending)
+    {
+      replicateROAwlFlag(replication, cache->sessionID,
+                         cache->rrclInstance.routerClientID);
+    }
+  }
+  unlockMutex(&handler->sessionMutex);
+
+  return true;
+}
+
+/**
+ * Detach the replication, the changes are not replicated anymore.
+ *
+ * @param handler The RPKI handler.
+ *
+ * @since 0.4.1.0
+ */
+void stopRPKIReplication(RPKIHandler* handler)
+{
+  lockMutex(&handler->sessionMutex);
+  handler->replication = NULL;
+  unlockMutex(&handler->sessionMutex);
+}
+
+/**
+ * Send a reset query to all validation caches.
+ *
+ * @param handler The RPKI handler.
+ *
+ * @return The number of caches the query could be sent to.
+ *
+ * @since 0.4.1.0
+ */
+int sendRPKIResetQueries(RPKIHandler* handler)
+{
+  int sent = 0;
+  int idx;
+
+  for (idx = 0; idx < handler->noCaches; idx++)
+  {
+    if (sendResetQuery(&handler->caches[idx].rrclInstance))
+    {
+      sent++;
+    }
+  }
+
+  return sent;
+}
+
+/**
+ * Register the callback that is called once the first validation cache
+ * completed its initial synchronization. If a cache is synchronized already,
+ * e.g. a session restored from a snapshot, the callback is called right away
+ * from within this function.
+ *
+ * @param handler The RPKI handler.
+ * @param callback The callback.
+ * @param user The user pointer handed to the callback.
+ *
+ * @since 0.4.1.0
+ */
+void setRPKISyncCallback(RPKIHandler* handler, RPKISyncCallback callback,
+                         void* user)
+{
+  bool synced;
+
+  // Under the session mutex, either the End of Data handler sees the callback
+  // or the synchronized cache is seen here.
+  lockMutex(&handler->sessionMutex);
+  synced = handler->syncedCache != NULL;
+  handler->syncCallback = synced ? NULL : callback;
+  handler->syncUser     = user;
+  unlockMutex(&handler->sessionMutex);
+
+  if (synced && (callback != NULL))
+  {
+    callback(user);
   }
 }
 
@@ -124,10 +523,143 @@ void releaseRPKIHandler(RPKIHandler* handler)
 // RPKI/Router client callback
 ////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Apply all staged ROA white-list changes of the cache to the prefix cache and
+ * empty the staging area.
+ *
+ * @param cache The validation cache.
+ *
+ * @since 0.4.1.0
+ */
+static void applyStagedChanges(RPKICache* cache)
+{
+  if (cache->noStaged > 0)
+  {
+    uint32_t applied = applyROAwlChanges(cache->handler->prefixCache, 
+                                         cache->staged, cache->noStaged);
+    if (cache->handler->replication != NULL)
+    {
+      replicateROAwlChanges(cache->handler->replication, cache->staged,
+                            cache->noStaged);
+    }
+    LOG(LEVEL_DEBUG, HDR "Applied %u of %u staged ROA-wl changes", 
+                     pthread_self(), applied, cache->noStaged);
+    cache->noStaged = 0;
+  }
+}
+
+/**
+ * Add the given change to the staging area. The area grows if needed.
+ *
+ * @param cache The validation cache.
+ * @param change The ROA white-list change.
+ *
+ * @return false if the staging area could not be extended.
+ *
+ * @since 0.4.1.0
+ */
+static bool stageChange(RPKICache* cache, PC_ROAwlChange* change)
+{
+  if (cache->noStaged == cache->stagedCapacity)
+  {
+    uint32_t newCapacity = cache->stagedCapacity == 0 
+                           ? INITIAL_STAGE_SIZE : cache->stagedCapacity * 2;
+    PC_ROAwlChange* staged = realloc(cache->staged, 
+                                     newCapacity * sizeof(PC_ROAwlChange));
+    if (staged == NULL)
+    {
+      return false;
+    }
+    cache->staged         = staged;
+    cache->stagedCapacity = newCapacity;
+  }
+  cache->staged[cache->noStaged++] = *change;
+
+  return true;
+}
+
+/**
+ * Replicate the session state of the given cache if a replication is
+ * attached. The caller MUST hold the session mutex.
+ *
+ * @param cache The validation cache.
+ *
+ * @since 0.4.1.0
+ */
+static void _replicateCacheSession(RPKICache* cache)
+{
+  RPKISession session;
+
+  if (cache->handler->replication != NULL)
+  {
+    session.valCacheID = cache->rrclInstance.routerClientID;
+    session.sessionID  = cache->sessionID;
+    session.serial     = cache->serial;
+    replicateSession(cache->handler->replication, &session, cache->hasSession);
+  }
+}
+
+/**
+ * The given cache has no complete data in the prefix cache anymore. If it was
+ * the synchronized cache, another cache with complete data takes over. The 
+ * caller MUST hold the session mutex.
+ *
+ * @param cache The validation cache.
+ *
+ * @since 0.4.1.0
+ */
+static void dropSession(RPKICache* cache)
+{
+  RPKIHandler* handler = cache->handler;
+  int          idx;
+
+  cache->hasSession = false;
+  _replicateCacheSession(cache);
+  if (handler->syncedCache == cache)
+  {
+    handler->syncedCache = NULL;
+    for (idx = 0; idx < handler->noCaches; idx++)
+    {
+      if (handler->caches[idx].hasSession)
+      {
+        handler->syncedCache = &handler->caches[idx];
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * The validation cache sends its complete data again. Drop what is not applied
+ * yet and flag the ROAs of the validation cache. The caller MUST hold the 
+ * session mutex.
+ *
+ * @param cache The validation cache.
+ *
+ * @since 0.4.1.0
+ */
+static void flagForReload(RPKICache* cache)
+{
+  uint32_t valCacheID = cache->rrclInstance.routerClientID;
+  int      flagged    = flagAllROAwl(cache->handler->prefixCache, 
+                                     cache->sessionID, valCacheID);
+  
+  LOG(LEVEL_DEBUG, HDR "Flagged %d ROA-wl entries of validation cache 0x%08X",
+                   pthread_self(), flagged, valCacheID);
+  if (cache->handler->replication != NULL)
+  {
+    replicateROAwlFlag(cache->handler->replication, cache->sessionID,
+                       valCacheID);
+  }
+  cache->noStaged     = 0;
+  cache->resetPending = true;
+  dropSession(cache);
+}
+
 /** This method handles prefix announcements and withdrawals received by the
  * RPKI cache via the RPKI/Router Protocol. They are also called whitelist
- * entries. This prefixes will be stored or removed from the prefix cache
- * depending on the value of isAnn.
+ * entries. This prefixes will be staged and stored or removed from the prefix 
+ * cache depending on the value of isAnn once the end of data is received.
  *
  * @param valCacheID The id of the validation cache.
  * @param session_id the id of the session id value. (NETWORK ORDER)
@@ -135,12 +667,12 @@ void releaseRPKIHandler(RPKIHandler* handler)
  * @param prefix The prefix itself
  * @param maxLen The maximum length for this prefix
  * @param oas The origin AS
- * @param user the RPKI handler of the prefix that points to the prefix cache.
+ * @param rpkiCache the validation cache of the prefix.
  *
  */
 static void handlePrefix (uint32_t valCacheID, uint16_t session_id,
                           bool isAnn, IPPrefix* prefix, uint16_t maxLen,
-                          uint32_t oas, void* rpkiHandler)
+                          uint32_t oas, void* rpkiCache)
 {
   char prefixBuf[MAX_PREFIX_STR_LEN_V6];
 
@@ -151,14 +683,93 @@ static void handlePrefix (uint32_t valCacheID, uint16_t session_id,
       valCacheID, session_id);
 
   // This method takes care of the received white list prefix/origin entry.
-  RPKIHandler* hanlder = (RPKIHandler*)rpkiHandler;
-  if (isAnn)
+  RPKICache*     cache = (RPKICache*)rpkiCache;
+  PC_ROAwlChange change;
+  
+  change.isAnn      = isAnn;
+  change.originAS   = oas;
+  change.prefix     = *prefix;
+  change.maxLen     = maxLen;
+  change.session_id = session_id;
+  change.valCacheID = valCacheID;
+  
+  if (!stageChange(cache, &change))
   {
-    addROAwl(hanlder->prefixCache, oas, prefix, maxLen, session_id, valCacheID);
+    // Keep the order of the changes, apply what is staged and this one.
+    RAISE_SYS_ERROR("Not enough memory to stage the ROA-wl change, apply it "
+                    "directly!");
+    lockMutex(&cache->handler->sessionMutex);
+    applyStagedChanges(cache);
+    applyROAwlChanges(cache->handler->prefixCache, &change, 1);
+    if (cache->handler->replication != NULL)
+    {
+      replicateROAwlChanges(cache->handler->replication, &change, 1);
+    }
+    // The prefix cache is between two serials until the next End of Data.
+    dropSession(cache);
+    unlockMutex(&cache->handler->sessionMutex);
   }
-  else
+}
+
+/**
+ * All prefix announcements and withdrawals of the current serial are received.
+ * Apply the staged changes to the prefix cache in one pass. The first cache
+ * that completes its data becomes the synchronized cache, the data of the 
+ * other caches is merged in as it completes.
+ *
+ * @param valCacheID The ID of the validation cache.
+ * @param session_id The session id of the data.
+ * @param rpkiCache The validation cache.
+ *
+ * @since 0.4.1.0
+ */
+static void handleEndOfData (uint32_t valCacheID, uint16_t session_id,
+                             void* rpkiCache)
+{
+  RPKICache*   cache   = (RPKICache*)rpkiCache;
+  RPKIHandler* handler = cache->handler;
+  RPKISyncCallback callback = NULL;
+  
+  LOG(LEVEL_DEBUG, HDR "End of Data: valCacheID: 0x%08X, session_id: 0x%04X, "
+                   "%u ROA-wl changes staged", pthread_self(), valCacheID, 
+                   session_id, cache->noStaged);
+  lockMutex(&handler->sessionMutex);
+  applyStagedChanges(cache);
+  if (cache->resetPending)
   {
-    delROAwl(hanlder->prefixCache, oas, prefix, maxLen, session_id, valCacheID);
+    // Remove the flagged ROAs that were not announced again.
+    int removed = cleanAllROAwl(handler->prefixCache, session_id, valCacheID, 
+                                true);
+    LOG(LEVEL_DEBUG, HDR "Removed %d ROA-wl entries not announced again", 
+                     pthread_self(), removed);
+    if ((removed != -1) && (handler->replication != NULL))
+    {
+      replicateROAwlClean(handler->replication, session_id, valCacheID, true);
+    }
+    cache->resetPending = removed == -1;
+  }
+  cache->hasSession = !cache->resetPending;
+  cache->sessionID  = session_id;
+  cache->serial     = cache->rrclInstance.serial;
+  cache->lastEndOfData = time(NULL);
+  _replicateCacheSession(cache);
+  if (cache->hasSession && (handler->syncedCache == NULL))
+  {
+    handler->syncedCache = cache;
+    LOG(LEVEL_INFO, HDR "Validation cache %s:%d synchronized first after %lds,"
+                    " the other validation caches are merged in the background",
+                    pthread_self(), cache->rrclParams.serverHost, 
+                    cache->rrclParams.serverPort,
+                    (long)(time(NULL) - handler->started));
+    // The callback is called only once.
+    callback = handler->syncCallback;
+    handler->syncCallback = NULL;
+  }
+  unlockMutex(&handler->sessionMutex);
+
+  if (callback != NULL)
+  {
+    callback(handler->syncUser);
   }
 }
 
@@ -166,16 +777,17 @@ static void handlePrefix (uint32_t valCacheID, uint16_t session_id,
  * Handle the reset for the prefix cache.
  *
  * @param valCacheID The ID of the validation cache.
- * @param rpkiHandler The RPKIHandler that contains the cache to be reseted.
+ * @param rpkiCache The validation cache to be reseted.
  */
-static void handleReset (uint32_t valCacheID, void* rpkiHandler)
+static void handleReset (uint32_t valCacheID, void* rpkiCache)
 {
   LOG(LEVEL_DEBUG, HDR "Prefix: Reset", pthread_self());
-  RPKIHandler* handler = (RPKIHandler*)rpkiHandler;
-  RAISE_ERROR("Handle Reset not implemented yet! - doDo: remove or flag all "
-              "ROAS from the given validation Cache");
-  handler = NULL; // just to supress the compiler warning. Must be removed later
-  // @TODO: Remove or flag all ROAS from the given validation Cache
+  RPKICache* cache = (RPKICache*)rpkiCache;
+  
+  // The cache sends the complete data again.
+  lockMutex(&cache->handler->sessionMutex);
+  flagForReload(cache);
+  unlockMutex(&cache->handler->sessionMutex);
 }
 
 /**
@@ -183,12 +795,15 @@ static void handleReset (uint32_t valCacheID, void* rpkiHandler)
  *
  * @param errNo The error number specified in the error package
  * @param msg The text message contained in the error package
- * @param user The Handler that received the error message (RPKI).
+ * @param user The validation cache that received the error message (RPKI).
  * @return
  */
 static bool handleError (uint16_t errNo, const char* msg, void* user)
 {
-  RAISE_ERROR("RPKI/Router error (%hu): \'%s\'", errNo, msg);
+  RPKICache* cache = (RPKICache*)user;
+
+  RAISE_ERROR("RPKI/Router error (%hu) from %s:%d: \'%s\'", errNo, 
+              cache->rrclParams.serverHost, cache->rrclParams.serverPort, msg);
   return KEEP_CONNECTION;
 }
 
@@ -196,23 +811,56 @@ static bool handleError (uint16_t errNo, const char* msg, void* user)
  * Called when the connection is lost. It returns the delay for the next
  * connection attempt.
  *
- * @param user The handler of the connection.
+ * @param user The validation cache of the connection.
  * @return
  */
 static int handleConnection (void* user)
 {
-  LOG(LEVEL_INFO, "Connection to RPKI/Router protocol server lost "
-                  "- reconnecting after %dsec", RECONNECT_DELAY);
+  RPKICache* cache = (RPKICache*)user;
+  
+  // Changes without End of Data are incomplete, the serial did not advance.
+  cache->noStaged = 0;
+  if (!cache->rrclInstance.resumeSession)
+  {
+    // The next connection starts with a reset query.
+    lockMutex(&cache->handler->sessionMutex);
+    flagForReload(cache);
+    unlockMutex(&cache->handler->sessionMutex);
+  }
+  LOG(LEVEL_INFO, "Connection to RPKI/Router protocol server %s:%d lost "
+                  "- reconnecting after %dsec", cache->rrclParams.serverHost,
+                  cache->rrclParams.serverPort, RECONNECT_DELAY);
   return RECONNECT_DELAY;
 }
 
 
+/**
+ * Store or delete the announced or withdrawn router key in the key cache.
+ *
+ * @param valCacheID The ID of the validation cache.
+ * @param session_id The session id.
+ * @param isAnn true for an announcement, false for a withdrawal.
+ * @param oas The AS number of the router key.
+ * @param ski The subject key identifier.
+ * @param keyInfo The DER encoded subject public key info.
+ * @param rpkiCache The validation cache.
+ */
 static void handleRouterKey (uint32_t valCacheID, uint16_t session_id,
                           bool isAnn, uint32_t oas, const char* ski,
-                          const char* keyInfo, void* rpkiHandler)
+                          const char* keyInfo, void* rpkiCache)
 {
+  RPKICache* cache = (RPKICache*)rpkiCache;
 
-  // TODO: call API's registerPublicKey method
+  if (isAnn)
+  {
+    storeRouterKey(cache->handler->keyCache, oas, (const uint8_t*)ski,
+                   (const uint8_t*)keyInfo, 
+                   sizeof(((RPKIRouterKeyHeader*)NULL)->keyInfo));
+  }
+  else if (!deleteRouterKey(cache->handler->keyCache, oas, 
+                            (const uint8_t*)ski))
+  {
+    LOG(LEVEL_NOTICE, "Validation cache [0x%08X] withdrew unknown router key "
+                      "of AS %u", valCacheID, oas);
+  }
 }
-
-
@@ -20,10 +20,25 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added the staging area for ROA white-list changes. They are 
+ *              applied to the prefix cache at the end of data.
+ *            * Added RPKISession and exportRPKISession. The handler keeps the
+ *              session id and serial of the data applied to the prefix cache
+ *              and can resume a session restored from a snapshot.
+ *            * Added RPKICache, the handler runs the sessions to multiple
+ *              validation caches in parallel. Replaced exportRPKISession
+ *              with exportRPKISessions.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added the time of the last End of Data to RPKICache.
+ *            * Added the key cache, it receives the router keys.
+ *            * Added RPKISyncCallback and setRPKISyncCallback.
+ *            * Added the replication to the standby server,
+ *              startRPKIReplication and stopRPKIReplication.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  *            * Removed warning for comments within a comment
@@ -35,39 +50,214 @@
 #define __RPKI_HANDLER_H__
 
 #include <pthread.h>
+#include <time.h>
+#include "server/key_cache.h"
 #include "server/prefix_cache.h"
 #include "server/rpki_router_client.h"
+#include "util/mutex.h"
 #include "util/prefix.h"
 
 /**
- * A single RPKI/Router Handler.
+ * The state of a validation cache session: the validation cache, the session
+ * id, and the serial of the data in the prefix cache.
+ *
+ * @since 0.4.1.0
  */
 typedef struct {
-  PrefixCache*            prefixCache;
+  /** The ID of the validation cache (see createRouterClientID). */
+  uint32_t valCacheID;
+  /** The session id (in network order!). */
+  uint32_t sessionID;
+  /** The serial (in network order!). */
+  uint32_t serial;
+} RPKISession;
+
+struct _RPKIHandler;
+struct _Replication;
+
+/**
+ * Called once the first validation cache completed its initial
+ * synchronization. It is called without any lock of the handler held.
+ *
+ * @param user The user pointer given with setRPKISyncCallback.
+ *
+ * @since 0.4.1.0
+ */
+typedef void (*RPKISyncCallback)(void* user);
+
+/**
+ * The session to a single validation cache. The sessions of all caches of
+ * a handler run in parallel, each in the thread of its RPKI/Router client.
+ *
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** The handler this cache belongs to. */
+  struct _RPKIHandler*    handler;
   RPKIRouterClientParams  rrclParams;
   RPKIRouterClient        rrclInstance;
+  
+  /** ROA white-list changes received since the last End of Data. */
+  PC_ROAwlChange*         staged;
+  /** The number of staged changes. */
+  uint32_t                noStaged;
+  /** The number of changes that fit into the staging area. */
+  uint32_t                stagedCapacity;
+  
+  /** Indicates that the prefix cache contains the data of sessionID and 
+   * serial. */
+  bool                    hasSession;
+  /** The session id of the applied data (in network order!). */
+  uint32_t                sessionID;
+  /** The serial of the applied data (in network order!). */
+  uint32_t                serial;
+  /** The time the last End of Data was applied, 0 if none was received. */
+  time_t                  lastEndOfData;
+  /** Set once the ROAs of the validation cache are flagged because it sends 
+   * its complete data again. The ROAs not announced again are removed with the
+   * next End of Data. */
+  bool                    resetPending;
+} RPKICache;
+
+/**
+ * A single RPKI/Router Handler. It maintains the sessions to all configured
+ * validation caches, the ROAs of each cache are kept in the prefix cache 
+ * under the ID of the cache.
+ */
+typedef struct _RPKIHandler {
+  PrefixCache*            prefixCache;
+  /** The cache the router keys are stored in. @since 0.4.1.0 */
+  KeyCache*               keyCache;
+  /** The validation caches. */
+  RPKICache*              caches;
+  /** The number of validation caches. */
+  uint8_t                 noCaches;
+  
+  /** Keeps the session state of all caches consistent with the changes 
+   * applied to the prefix cache. */
+  Mutex                   sessionMutex;
+  /** The cache that completed its initial synchronization first, the prefix
+   * cache serves validation with its data while the other caches are still 
+   * synchronizing. NULL as long as no cache is synchronized. */
+  RPKICache*              syncedCache;
+  /** The time the handler was created. */
+  time_t                  started;
+  /** Called once the first cache is synchronized. @since 0.4.1.0 */
+  RPKISyncCallback        syncCallback;
+  /** The user pointer of the sync callback. @since 0.4.1.0 */
+  void*                   syncUser;
+  /** Receives the changes of the ROA white-list and of the sessions, NULL if
+   * no standby server is attached. Guarded by the session mutex.
+   * @since 0.4.1.0 */
+  struct _Replication*    replication;
 } RPKIHandler;
 
 /**
  * Initializes the instance, registers an existing Prefix Cache and creates
- * a RPKI/Router Client instance.
+ * one RPKI/Router Client instance for each validation cache. All sessions run
+ * in parallel.
  *
  * @param self Variable that should be initialized
  * @param prefixCache Existing cache that should be registered
- * @param serverHost RPKI/Router protocol server host name
- * @param serverPort RPKI/Router protocol server port number
+ * @param keyCache Existing cache the router keys are stored in
+ * @param serverHosts RPKI/Router protocol server host names
+ * @param serverPorts RPKI/Router protocol server port numbers
+ * @param noServers The number of RPKI/Router protocol servers.
+ * @param sessions Sessions whose ROA white-list entries are already stored in
+ *                 the prefix cache, e.g. restored from a snapshot. Each is 
+ *                 resumed with a serial query by the server of the same ID.
+ *                 The ROAs of sessions without server are removed.
+ * @param noSessions The number of sessions.
  * @return \c true = all went through, \c false = an error occurred
  */
 bool createRPKIHandler(RPKIHandler* self, PrefixCache* prefixCache,
-                       const char* serverHost, int serverPort);
+                       KeyCache* keyCache, const char** serverHosts, int* serverPorts,
+                       uint8_t noServers, RPKISession* sessions,
+                       uint32_t noSessions);
 
 /**
  * Frees all resources.
- * Also releases the RPKI/Router instance.
+ * Also releases the RPKI/Router instances.
  *
  * @param self Handler instance
  */
 void releaseRPKIHandler(RPKIHandler* self);
 
+/**
+ * Export the sessions of all validation caches that completed a serial and
+ * the ROA white-list entries of these caches.
+ *
+ * @param self Handler instance
+ * @param sessions OUT - The sessions. Must be freed by the caller.
+ * @param noSessions OUT - The number of sessions.
+ * @param roas OUT - The ROA white-list entries as announcements. Must be 
+ *             freed by the caller.
+ * @param noROAs OUT - The number of ROA white-list entries.
+ *
+ * @return false if no validation cache completed a serial (yet).
+ *
+ * @since 0.4.1.0
+ */
+bool exportRPKISessions(RPKIHandler* self, RPKISession** sessions, 
+                        uint32_t* noSessions, PC_ROAwlChange** roas,
+                        uint32_t* noROAs);
+
+/**
+ * Export the sessions of all validation caches that completed a serial and
+ * all ROA white-list entries, then attach the replication. All changes after
+ * the export are replicated, the flags of the caches that are reloaded are
+ * replicated right away.
+ *
+ * @param self Handler instance
+ * @param replication The replication to the standby server.
+ * @param sessions OUT - The sessions. Must be freed by the caller.
+ * @param noSessions OUT - The number of sessions.
+ * @param roas OUT - All ROA white-list entries. Must be freed by the caller.
+ * @param noROAs OUT - The number of ROA white-list entries.
+ *
+ * @return false if not enough memory was available, the replication is not
+ *         attached then.
+ *
+ * @since 0.4.1.0
+ */
+bool startRPKIReplication(RPKIHandler* self, struct _Replication* replication,
+                          RPKISession** sessions, uint32_t* noSessions,
+                          PC_ROAwlChange** roas, uint32_t* noROAs);
+
+/**
+ * Detach the replication, the changes are not replicated anymore.
+ *
+ * @param self Handler instance
+ *
+ * @since 0.4.1.0
+ */
+void stopRPKIReplication(RPKIHandler* self);
+
+/**
+ * Send a reset query to all validation caches.
+ *
+ * @param self Handler instance
+ *
+ * @return The number of caches the query could be sent to.
+ *
+ * @since 0.4.1.0
+ */
+int sendRPKIResetQueries(RPKIHandler* self);
+
+/**
+ * Register the callback that is called once the first validation cache
+ * completed its initial synchronization. If a cache is synchronized already,
+ * e.g. a session restored from a snapshot, the callback is called right away
+ * from within this function.
+ *
+ * @param self Handler instance
+ * @param callback The callback.
+ * @param user The user pointer handed to the callback.
+ *
+ * @since 0.4.1.0
+ */
+void setRPKISyncCallback(RPKIHandler* self, RPKISyncCallback callback,
+                         void* user);
+
 #endif // !__RPKI_HANDLER_H__
 
@@ -30,6 +30,22 @@
  *            * Added capability to only have the receiving of PDU's done once
  *              by using the clients stopAfterEndofData attribute rather than a
  *              hard coded bool value in manageConnection.
+ *          - 2026/10/14 - kyehwanl
+ *            * Call the endOfDataCallback once an End of Data PDU with a valid
+ *              session id is received.
+ *            * Resume a given session with a serial query on the first 
+ *              connection, see RPKIRouterClient::resumeSession.
+ *            * The PDUs are decoded out of a ring buffer that a socket reader
+ *              thread fills with large reads, see RPKIRecvPipe. Fixed the
+ *              buffer extension for large PDUs which was 8 bytes short and
+ *              read the skipped data once more.
+ *            * Implemented createRouterClientID as a hash over the server
+ *              host name and port.
+ *          - 2026/10/15 - kyehwanl
+ *            * Keep the serial of the last Serial Notify.
+ *            * The session threads are placed and named by createThread.
+ *            * Account the receive ring and PDU buffer under
+ *              MEM_TAG_RTR_BUFFERS.
  * 0.3.0.10 - 2016/01/21 - kyehwanl
  *            * added pthread cancel state for enabling keyboard interrupt
  * 0.3.0.10 - 2015/11/10 - oborchert
@@ -52,18 +68,26 @@
  *            * Code Created
  * -----------------------------------------------------------------------------
  */
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <arpa/inet.h>
 #include <signal.h>
+#include <sys/socket.h>
 #include "server/rpki_router_client.h"
 #include "util/client_socket.h"
 #include "util/log.h"
+#include "util/mem_stats.h"
 #include "util/socket.h"
 #include "util/prefix.h"
+#include "util/thread.h"
 
 #define HDR "([0x%08X] RPKI Router Client): "
 
+/** The size of the receive ring of a connection. A full table sync is drained
+ * from the socket with reads of up to this size. */
+#define RECV_RING_SIZE (1024 * 1024)
+
 /**
  * Handle received IPv4 Prefixes.
  *
@@ -238,6 +262,229 @@ static bool checkSessionID(RPKIRouterClient* client, uint32_t sessionID)
   return retVal;
 }
 
+/**
+ * Give up the session that was to be resumed. The reset callback allows the 
+ * user to drop the data of the session and the session id of the next cache
+ * response is accepted.
+ *
+ * @param client The client connection.
+ *
+ * @since 0.4.1.0
+ */
+static void giveUpResumedSession(RPKIRouterClient* client)
+{
+  if (client->resumeSession)
+  {
+    LOG(LEVEL_INFO, HDR "The session 0x%04X can not be resumed, reload the "
+                    "cache data!", pthread_self(), ntohs(client->sessionID));
+    client->resumeSession = false;
+    client->startup       = true;
+    client->params->resetCallback(client->routerClientID, client->user);
+  }
+}
+
+/**
+ * The socket reader thread of the receive pipeline. It reads as much as the
+ * free space of the ring allows and only waits once the ring is full.
+ *
+ * @param pipePtr The receive pipeline.
+ *
+ * @return NULL
+ *
+ * @since 0.4.1.0
+ */
+static void* socketReader(void* pipePtr)
+{
+  RPKIRecvPipe* pipe = (RPKIRecvPipe*)pipePtr;
+  uint32_t      tail;
+  uint32_t      space;
+  ssize_t       received;
+
+  LOG(LEVEL_DEBUG, HDR "Socket reader started!", pthread_self());
+  lockMutex(&pipe->mutex);
+  while (!pipe->stop)
+  {
+    if (pipe->count == pipe->size)
+    {
+      waitCond(&pipe->spaceCond, &pipe->mutex, 0);
+      continue;
+    }
+    // Only the decoder moves the head, the free space can only grow.
+    tail  = (pipe->head + pipe->count) % pipe->size;
+    space = tail < pipe->head ? pipe->head - tail : pipe->size - tail;
+    unlockMutex(&pipe->mutex);
+
+    received = recv(pipe->fd, pipe->ring + tail, space, 0);
+
+    lockMutex(&pipe->mutex);
+    if (received <= 0)
+    {
+      if ((received == -1) && (errno == EINTR))
+      {
+        continue;
+      }
+      break;
+    }
+    pipe->count += (uint32_t)received;
+    signalCond(&pipe->dataCond);
+  }
+  pipe->eof = true;
+  signalCond(&pipe->dataCond);
+  unlockMutex(&pipe->mutex);
+  LOG(LEVEL_DEBUG, HDR "Socket reader stopped!", pthread_self());
+
+  return NULL;
+}
+
+/**
+ * Start the receive pipeline for the current connection of the client.
+ *
+ * @param client The client connection.
+ *
+ * @return false if the pipeline could not be started.
+ *
+ * @since 0.4.1.0
+ */
+static bool startRecvPipe(RPKIRouterClient* client)
+{
+  RPKIRecvPipe* pipe = &client->recvPipe;
+  int           ret;
+
+  pipe->ring = malloc(RECV_RING_SIZE);
+  if (pipe->ring == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the receive ring!");
+    return false;
+  }
+  addMemStats(MEM_TAG_RTR_BUFFERS, RECV_RING_SIZE, 1);
+  pipe->size    = RECV_RING_SIZE;
+  pipe->head    = 0;
+  pipe->count   = 0;
+  pipe->fd      = client->clSock.clientFD;
+  pipe->stop    = false;
+  pipe->eof     = false;
+  pipe->running = true;
+
+  ret = createThread(&pipe->thread, NULL, THREAD_CLASS_RPKI, "srx-rtr-read",
+                     socketReader, pipe);
+  if (ret)
+  {
+    RAISE_ERROR("Failed to spawn the socket reader thread (result: %d)", ret);
+    pipe->running = false;
+    addMemStats(MEM_TAG_RTR_BUFFERS, -(int64_t)RECV_RING_SIZE, -1);
+    free(pipe->ring);
+    pipe->ring = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Stop the receive pipeline, data not decoded yet is dropped. Can be called by
+ * the worker thread and during the release of the client, only the first call
+ * stops the reader.
+ *
+ * @param client The client connection.
+ *
+ * @since 0.4.1.0
+ */
+static void stopRecvPipe(RPKIRouterClient* client)
+{
+  RPKIRecvPipe* pipe = &client->recvPipe;
+  bool          running;
+
+  lockMutex(&pipe->mutex);
+  running       = pipe->running;
+  pipe->running = false;
+  pipe->stop    = true;
+  signalCond(&pipe->spaceCond);
+  unlockMutex(&pipe->mutex);
+
+  if (running)
+  {
+    // Wake the reader up in case it waits for data.
+    shutdown(pipe->fd, SHUT_RD);
+    pthread_join(pipe->thread, NULL);
+
+    lockMutex(&pipe->mutex);
+    addMemStats(MEM_TAG_RTR_BUFFERS, -(int64_t)pipe->size, -1);
+    free(pipe->ring);
+    pipe->ring  = NULL;
+    pipe->size  = 0;
+    pipe->head  = 0;
+    pipe->count = 0;
+    unlockMutex(&pipe->mutex);
+  }
+}
+
+/**
+ * Cleanup handler that unlocks the pipeline mutex if the worker thread gets
+ * canceled while waiting for data.
+ *
+ * @param pipePtr The receive pipeline.
+ *
+ * @since 0.4.1.0
+ */
+static void unlockRecvPipe(void* pipePtr)
+{
+  unlockMutex(&((RPKIRecvPipe*)pipePtr)->mutex);
+}
+
+/**
+ * Take the given number of bytes out of the receive pipeline, wait until they
+ * are received.
+ *
+ * @param pipe The receive pipeline.
+ * @param dst The buffer the bytes are copied into, NULL to skip the bytes.
+ * @param length The number of bytes.
+ *
+ * @return false if the connection is lost before all bytes are received.
+ *
+ * @since 0.4.1.0
+ */
+static bool readRecvPipe(RPKIRecvPipe* pipe, uint8_t* dst, uint32_t length)
+{
+  uint32_t copy;
+
+  lockMutex(&pipe->mutex);
+  pthread_cleanup_push(unlockRecvPipe, pipe);
+  while (length > 0)
+  {
+    if (pipe->count == 0)
+    {
+      if (pipe->eof)
+      {
+        break;
+      }
+      waitCond(&pipe->dataCond, &pipe->mutex, 0);
+      continue;
+    }
+    // Copy up to the end of the ring at once.
+    copy = pipe->size - pipe->head;
+    if (copy > pipe->count)
+    {
+      copy = pipe->count;
+    }
+    if (copy > length)
+    {
+      copy = length;
+    }
+    if (dst != NULL)
+    {
+      memcpy(dst, pipe->ring + pipe->head, copy);
+      dst += copy;
+    }
+    pipe->head   = (pipe->head + copy) % pipe->size;
+    pipe->count -= copy;
+    length      -= copy;
+    signalCond(&pipe->spaceCond);
+  }
+  pthread_cleanup_pop(1);
+
+  return length == 0;
+}
+
 /**
  * This method implements the receiver thread between the RPKI client and
  * RPKI server. It reads each PDU completely.
@@ -264,6 +511,13 @@ static void receivePDUs(RPKIRouterClient* client, bool returnAterEndOfData)
   // set false once the connection is shut down.
   bool             keepGoing = true;
 
+  // The socket reader keeps running for the connection, PDUs received after
+  // an End of Data stay in the pipeline for the next call.
+  if (!client->recvPipe.running && !startRecvPipe(client))
+  {
+    return;
+  }
+
   // Allocate the message buffer
   byteBuffer = malloc(bytesAllocated);
   // Set the bufferPtr to the position where the remaining data has be loaded
@@ -274,6 +528,7 @@ static void receivePDUs(RPKIRouterClient* client, bool returnAterEndOfData)
     RAISE_ERROR("Could not allocate enough memory to read from socket!");
     return;
   }
+  addMemStats(MEM_TAG_RTR_BUFFERS, bytesAllocated, 1);
 
   // KeepGoing until a cache session id changed / in case of connection loss,
   // a break stops this while loop.
@@ -281,8 +536,8 @@ static void receivePDUs(RPKIRouterClient* client, bool returnAterEndOfData)
   {
     // Read the common data for the Common header. This method fails in case the
     // connection is lost.
-    if (!recvNum(getClientFDPtr(&client->clSock), byteBuffer,
-                 sizeof(RPKICommonHeader)))
+    if (!readRecvPipe(&client->recvPipe, byteBuffer, 
+                      sizeof(RPKICommonHeader)))
     {
       LOG(LEVEL_DEBUG, HDR "Connection lost!", pthread_self());
       break;
@@ -308,15 +563,17 @@ static void receivePDUs(RPKIRouterClient* client, bool returnAterEndOfData)
     if (bytesMissing > 0)
     {
       // Check if the current buffer is big enough
-      if (bytesMissing > bytesAllocated)
+      if (pduLen > bytesAllocated)
       {
         // The current buffer is to small -> try to increase it.
-        uint8_t* newBuffer = realloc(byteBuffer, bytesMissing);
+        uint8_t* newBuffer = realloc(byteBuffer, pduLen);
         if (newBuffer)
         {
+          addMemStats(MEM_TAG_RTR_BUFFERS, pduLen - bytesAllocated, 0);
           byteBuffer = newBuffer; // reset to the bigger space
-          bytesAllocated = bytesMissing;
+          bytesAllocated = pduLen;
           bufferPtr = (byteBuffer + sizeof(RPKICommonHeader));
+          hdr = (RPKICommonHeader*)byteBuffer;
         }
         else
         {
@@ -326,15 +583,16 @@ static void receivePDUs(RPKIRouterClient* client, bool returnAterEndOfData)
                       hdr->type, pduLen, bytesMissing);
 
           // Skip over the data
-          if (!skipBytes(&client->clSock, bytesMissing))
+          if (!readRecvPipe(&client->recvPipe, NULL, bytesMissing))
           {
             break;
           }
+          continue;
         }
       }
 
       // Now load the remaining data
-      if (!recvNum(getClientFDPtr(&client->clSock), bufferPtr, bytesMissing))
+      if (!readRecvPipe(&client->recvPipe, bufferPtr, bytesMissing))
       {
         break;
       }
@@ -355,6 +613,9 @@ static void receivePDUs(RPKIRouterClient* client, bool returnAterEndOfData)
         // Respond with a serial query
         if (checkSessionID(client, ((RPKISerialNotifyHeader*)hdr)->sessionID))
         {
+          // store not byte-swapped
+          client->notifiedSerial = 
+                            ((RPKISerialNotifyHeader*)byteBuffer)->serial;
           sendSerialQuery(client);
         }
         else
@@ -378,6 +639,13 @@ static void receivePDUs(RPKIRouterClient* client, bool returnAterEndOfData)
         {
           // store not byte-swapped
           client->serial = ((RPKIEndOfDataHeader*)byteBuffer)->serial;
+          // A session to be resumed is up to date now.
+          client->resumeSession = false;
+          if (client->params->endOfDataCallback != NULL)
+          {
+            client->params->endOfDataCallback(client->routerClientID, 
+                                              client->sessionID, client->user);
+          }
           keepGoing = !returnAterEndOfData;
         }
         else
@@ -390,7 +658,14 @@ static void receivePDUs(RPKIRouterClient* client, bool returnAterEndOfData)
         break;
       case PDU_TYPE_CACHE_RESET :
         // Reset our cache
-        client->params->resetCallback(client->routerClientID, client->user);
+        if (client->resumeSession)
+        {
+          giveUpResumedSession(client);
+        }
+        else
+        {
+          client->params->resetCallback(client->routerClientID, client->user);
+        }
         // Respond with a cache reset
         sendResetQuery(client);
         break;
@@ -417,6 +692,7 @@ static void receivePDUs(RPKIRouterClient* client, bool returnAterEndOfData)
     }
   }
   // Release the buffer again.
+  addMemStats(MEM_TAG_RTR_BUFFERS, -(int64_t)bytesAllocated, -1);
   free(byteBuffer);
 }
 
@@ -458,8 +734,10 @@ static void* manageConnection (void* clientPtr)
 
   while (!client->stop)
   {
-    // Start off every new connection with a reset
-    if (sendResetQuery(client))
+    // Start off every new connection with a reset unless the session can be
+    // resumed.
+    if (client->resumeSession ? sendSerialQuery(client) 
+                              : sendResetQuery(client))
     {
       // Receive and process all PDUs - This is a loop until the connection
       // is either lost, closed, or the end of data is received (single request)
@@ -473,6 +751,7 @@ static void* manageConnection (void* clientPtr)
     }
 
     // The connection is lost or did not even exist yet.
+    stopRecvPipe(client);
 
     // Test if the connection stopped!
     if (client->stop)
@@ -521,6 +800,7 @@ static void* manageConnection (void* clientPtr)
       }
       LOG (LEVEL_DEBUG, HDR "CACHE SESSION ID CHANGE: SEND RESET QUERY",
                         pthread_self());
+      giveUpResumedSession(client);
       if (sendResetQuery(client))
       {
         // Receive and process all PDUs. The flag client->session_id_changed
@@ -545,18 +825,31 @@ static void* manageConnection (void* clientPtr)
 }
 
 /**
- * Creates an ID for this RouterClient.
+ * Creates an ID for this RouterClient. The ID is a FNV-1a hash over the host
+ * name and port of the server, it stays the same across restarts and allows
+ * to find the ROAs of the server in the prefix cache again.
  *
- * @param self the client instance
+ * @param self the client instance, the parameters must be set.
  *
- * @todo add some implementation
- *
- * @return currently only 0
+ * @return the ID
  */
 uint32_t createRouterClientID(RPKIRouterClient* self)
 {
-  // TODO: Add implementation for a unique ID. Maybe an initial hash over self.
-  return 0;
+  const char* host = self->params->serverHost;
+  uint32_t    port = (uint32_t)self->params->serverPort;
+  uint32_t    hash = 2166136261u;
+  int         idx;
+
+  while ((host != NULL) && (*host != '\0'))
+  {
+    hash = (hash ^ (uint8_t)*host++) * 16777619u;
+  }
+  for (idx = 0; idx < 4; idx++)
+  {
+    hash = (hash ^ ((port >> (idx * 8)) & 0xFF)) * 16777619u;
+  }
+
+  return hash;
 }
 
 /**
@@ -599,6 +892,18 @@ bool createRPKIRouterClient (RPKIRouterClient* self,
     closeClientSocket(&self->clSock);
   }
 
+  // The receive pipeline is started with the first receipt of PDUs.
+  memset(&self->recvPipe, 0, sizeof(RPKIRecvPipe));
+  if (   !initMutex(&self->recvPipe.mutex) 
+      || !initCond(&self->recvPipe.dataCond)
+      || !initCond(&self->recvPipe.spaceCond))
+  {
+    RAISE_ERROR("Failed to initialize the receive pipeline");
+    releaseMutex(&self->writeMutex);
+    closeClientSocket(&self->clSock);
+    return false;
+  }
+
   // User data
   self->user = user;
 
@@ -608,14 +913,18 @@ bool createRPKIRouterClient (RPKIRouterClient* self,
 
   // Configure necessary data for cache session id. The configuration
   // startup=true allows the sessionID attribute to be set without further
-  // action.
-  self->sessionID        = 0xffff;
+  // action. A session to be resumed keeps its sessionID and serial.
+  if (!self->resumeSession)
+  {
+    self->sessionID = 0xffff;
+  }
   self->sessionIDChanged = false;
-  self->startup          = true;
+  self->startup          = !self->resumeSession;
 
   self->routerClientID = createRouterClientID(self);
 
-  ret = pthread_create (&self->thread, NULL, manageConnection, self);
+  ret = createThread(&self->thread, NULL, THREAD_CLASS_RPKI, "srx-rtr",
+                     manageConnection, self);
   if (ret)
   {
     RAISE_ERROR("Failed to spawn a receiving thread (result: %d)", ret);
@@ -635,6 +944,7 @@ void releaseRPKIRouterClient (RPKIRouterClient* self)
 {
   // Close the connection
   self->stop = true;
+  stopRecvPipe(self);
   releaseMutex(&self->writeMutex);
   closeClientSocket(&self->clSock);
 
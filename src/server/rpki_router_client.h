@@ -32,6 +32,12 @@
  * 0.4.1.0  - 2016/08/30 - oborchert
  *            * Added parameter 'stopAfterEndOfData' to structure
  *              RPKIRouterClient.
+ *          - 2026/10/14 - kyehwanl
+ *            * Added the optional endOfDataCallback to RPKIRouterClientParams.
+ *            * Added parameter 'resumeSession' to structure RPKIRouterClient.
+ *            * Added the receive pipeline RPKIRecvPipe to RPKIRouterClient.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added parameter 'notifiedSerial' to structure RPKIRouterClient.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  * 0.3.0.7  - 2015/04/17 - oborchert
@@ -107,6 +113,21 @@ typedef struct {
    */
   void (*resetCallback)(uint32_t valCacheID,  void* user);
 
+  /**
+   * The cache sent an End of Data PDU for the current session. All prefix
+   * announcements and withdrawals of this serial are received.
+   *
+   * @note Optional - can be \c NULL
+   *
+   * @param valCacheID The id of the validation cache.
+   * @param sessionID  The cache sessionID of the data.
+   * @param user       User data
+   *
+   * @since 0.4.1.0
+   */
+  void (*endOfDataCallback)(uint32_t valCacheID, uint16_t sessionID, 
+                            void* user);
+
   /**
    * This method is called in case of a cache session id change. This normally
    * requires a total cache reset and start from new. After this method a
@@ -169,6 +190,41 @@ typedef struct {
   int         serverPort;
 } RPKIRouterClientParams;
 
+/**
+ * The receive pipeline of a connection. A socket reader thread drains the 
+ * socket into the ring with reads as large as the free space allows while the
+ * worker thread decodes the PDUs out of the ring and passes them on. The
+ * reader only stops draining the socket once the ring is full.
+ *
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** The ring buffer, allocated while the reader runs. */
+  uint8_t*  ring;
+  /** The size of the ring. */
+  uint32_t  size;
+  /** The position of the first byte not decoded yet. */
+  uint32_t  head;
+  /** The number of bytes received but not decoded yet. */
+  uint32_t  count;
+  /** The socket the reader drains. */
+  int       fd;
+  /** Indicates that the reader thread is running. */
+  bool      running;
+  /** Set to stop the reader thread. */
+  bool      stop;
+  /** Set once the reader thread receives no more data. */
+  bool      eof;
+  /** The socket reader thread. */
+  pthread_t thread;
+  /** Protects all attributes above. */
+  Mutex     mutex;
+  /** Signaled when data was received or the reader ended. */
+  Cond      dataCond;
+  /** Signaled when data was decoded or the reader has to stop. */
+  Cond      spaceCond;
+} RPKIRecvPipe;
+
 /**
  * A single client.
  *
@@ -193,6 +249,10 @@ typedef struct {
   Mutex                    writeMutex;
   /** The last used serial number for this connection (in network order!). */
   uint32_t                 serial; // < Stored in network order
+  /** The serial of the last Serial Notify received, zero if none was 
+   * received yet (in network order!).
+   * @since 0.4.1.0 */
+  uint32_t                 notifiedSerial; // < Stored in network order
   /** The type of the previous send PDU. */
   RPKIRouterPDUType        lastSent;
   /** The type of the last received PDU. */
@@ -215,12 +275,24 @@ typedef struct {
    * without continuous polling.
    * @since 0.4.1.0 */
   bool                     stopAfterEndOfData;
+  /** Resume the session given in sessionID and serial (e.g. restored from a
+   * snapshot) with a serial query instead of starting with a reset query. If
+   * the validation cache can not resume the session, the reset callback is 
+   * called before the data is loaded with a reset query. Must be set prior
+   * to createRPKIRouterClient.
+   * @since 0.4.1.0 */
+  bool                     resumeSession;
+  /** The receive pipeline of the current connection.
+   * @since 0.4.1.0 */
+  RPKIRecvPipe             recvPipe;
 } RPKIRouterClient;
 
 /**
- * Create a unique router client ID
+ * Create a unique router client ID. The ID depends only on the server host 
+ * name and port of the client parameters.
  *
- * @param self the router clinet the ID has to be generated for.
+ * @param self the router clinet the ID has to be generated for. The 
+ *             parameters must be set.
  *
  * @return the ID;
  */
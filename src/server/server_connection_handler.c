@@ -20,10 +20,51 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.4.0.1
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Run the server loop in MODE_EVENT_LOOP if event loop threads 
+ *              are configured.
+ *            * Generate the update ID as negotiated with the client.
+ *            * Release the output buffer of a lost client connection.
+ *            * The receiver queue references PDUs in the receive chunk instead
+ *              of copying them.
+ *            * Record the receive time, the receiver queue wait time and the
+ *              receiver queue depth.
+ *          - 2026/10/15 - kyehwanl
+ *            * Count the validation requests of each client. A new mapping 
+ *              starts with zero counters.
+ *            * Added getSCHReceiverQueueSize.
+ *            * Only queue validation requests that still need a validation,
+ *              updates with a final result are answered by the receiver.
+ *            * Added the lazy validation mode. New updates are validated
+ *              during idle time unless the router has no usable default
+ *              result. A new update is always validated for the requested
+ *              types, not only if its default result is undefined.
+ *            * The receiver queue thread is placed and named by createThread.
+ *            * Offer the shared memory transport to co-located proxies if
+ *              configured.
+ *            * Unpack bulk verify requests into single validation requests.
+ *            * Process the synchronization updates of a reconnected proxy.
+ *            * Queue each command with its priority class, unpacked bulk
+ *              verify requests are queued as bulk commands.
+ *            * The receiver queue is bounded. Added updateFlowControl which
+ *              asks the proxies to pause sending while a queue is above its
+ *              high water mark.
+ *            * Receiver queue elements and PDU copies are packet buffers.
+ *            * Start the trace of sampled updates.
+ *            * Name the receiver queue mutex for the lock statistics.
+ *            * Added the provisional mode. Until the first validation cache
+ *              is synchronized the origin validation is not requested, the
+ *              router works with its default result.
+ *            * The receiver queue is split into lanes, each served by its own
+ *              receiver thread. The packets of a client always use the same
+ *              lane to keep their order.
+ *            * processValidationRequest keeps the prefix on the stack and
+ *              handles IPv4 and IPv6 requests in separate paths. IPv4
+ *              requests generate the update ID from the 32 bit address.
  * 0.4.0.1  - 2016/07/02 - oborchert
  *            * Fixed wrongful conversion of a nework encoded word into a host
  *              encoded int. Changed from ntol to ntohs.
@@ -55,9 +96,12 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#include "util/lock_stats.h"
 #include "util/log.h"
+#include "util/thread.h"
 #include "server/server_connection_handler.h"
 #include "server/srx_packet_sender.h"
+#include "server/stage_stats.h"
 #include "shared/srx_identifier.h"
 #include "shared/srx_packets.h"
 #include "shared/srx_defs.h"
@@ -75,72 +119,226 @@ typedef struct {
   uint8_t* pdu;
   uint32_t size;
   bool     consumed;
+  PacketChunk* chunk; // The chunk pdu is stored in or NULL if pdu is a copy
+  uint64_t queued;    // Time (ns) the pdu was queued
   void* next;   
 } SCH_ReceiverQueueElement;
 
-/** the receiver queue itself */
+/** A lane of the receiver queue. Each lane is served by its own thread, the
+ * packets of a client always use the same lane and keep their order.
+ * (since 0.4.1.0) */
 typedef struct {
   // The head element, the next one to take
   SCH_ReceiverQueueElement* head;
   // The tail element, the last one added
   SCH_ReceiverQueueElement* tail;
-  // the size of the queue
+  // the size of the lane
   int         size;
-  // the queue handler itself
+  // The maximum number of PDUs in the lane
+  int         maxSize;
+  // the lane handler itself
   pthread_t   handler;
-  // indicates if the queue is running.
+  // indicates if the handler thread was started and not joined yet.
+  bool        started;
+  // indicates if the lane is running.
   bool        running;
   // Mutex and Condition for thread handling
   Mutex       mutex;
   Cond        condition;  
+  // Signaled once a full lane has room again
+  Cond        notFull;
   
+  ServerConnectionHandler* svrConnHandler;
+} SCH_ReceiverLane;
+
+/** the receiver queue itself */
+typedef struct {
+  // The lanes, one per receiver thread (since 0.4.1.0)
+  SCH_ReceiverLane* lanes;
+  // The number of lanes (since 0.4.1.0)
+  uint8_t           noLanes;
+
   ServerConnectionHandler* svrConnHandler;  
 } SCH_ReceiverQueue;
 
 // wait until notify or 1 s timeout - this is just to allow a wakeup
 #define SCH_RECEIVE_QUEUE_WAIT_MS 1000
 
+// The maximum number of PDUs in the receiver queue, the receiving thread waits
+// until the lane of the client has room again. The lanes share this maximum.
+#define SCH_RECEIVE_QUEUE_MAX 65536
+
+// The water marks of the flow control. The receiver queue and command queue
+// are measured in PDUs, the send queue in bytes.
+#define FLOW_RECEIVE_HIGH 32768
+#define FLOW_RECEIVE_LOW  8192
+#define FLOW_COMMAND_HIGH 32768
+#define FLOW_COMMAND_LOW  8192
+#define FLOW_SEND_HIGH    (32 * 1024 * 1024)
+#define FLOW_SEND_LOW     (8 * 1024 * 1024)
+
+// The queue levels are checked once per this number of received PDUs.
+#define FLOW_CHECK_PDUS   64
+
 // Forward declaration
-SCH_ReceiverQueueElement* fetchSCHReceiverPacket(SCH_ReceiverQueue* queue);
+SCH_ReceiverQueueElement* fetchSCHReceiverPacket(SCH_ReceiverLane* lane);
 void stopSCHReceiverQueue(SCH_ReceiverQueue* queue);
 void _handlePacket(ServerSocket* svrSock, ServerClient* client,
                    void* packet, PacketLength length, void* srvConHandler);
 
 /**
- * Create the sender queue including the thread that manages the queue.
+ * Free the given receiver queue element and release the PDU it holds.
+ *
+ * @param packet The element to be freed.
+ *
+ * @since 0.4.1.0
+ */
+static void _freeSCHReceiverPacket(SCH_ReceiverQueueElement* packet)
+{
+  if (packet->chunk != NULL)
+  {
+    releasePacketChunk(packet->chunk);
+  }
+  else
+  {
+    freePacketBuffer(packet->pdu);
+  }
+  freePacketBuffer(packet);
+}
+
+/**
+ * Initialize a lane of the receiver queue.
+ *
+ * @param lane The lane to be initialized.
+ * @param srvConnHandler The server connection handler.
+ * @param maxSize The maximum number of PDUs in the lane.
+ *
+ * @return true if the lane could be initialized.
+ *
+ * @since 0.4.1.0
+ */
+static bool _initSCHReceiverLane(SCH_ReceiverLane* lane,
+                                 ServerConnectionHandler* srvConnHandler,
+                                 int maxSize)
+{
+  if (!initMutex(&lane->mutex))
+  {
+    return false;
+  }
+  if (!initCond(&lane->condition))
+  {
+    releaseMutex(&lane->mutex);
+    return false;
+  }
+  if (!initCond(&lane->notFull))
+  {
+    destroyCond(&lane->condition);
+    releaseMutex(&lane->mutex);
+    return false;
+  }
+  lane->head    = NULL;
+  lane->tail    = NULL;
+  lane->size    = 0;
+  lane->maxSize = maxSize;
+  lane->started = false;
+  lane->running = false;
+  lane->svrConnHandler = srvConnHandler;
+  setLockName(&lane->mutex, "receiverQueue.mutex");
+
+  return true;
+}
+
+/**
+ * Release the mutex and conditions of the lane.
+ *
+ * @param lane The lane to be released.
+ *
+ * @since 0.4.1.0
+ */
+static void _releaseSCHReceiverLane(SCH_ReceiverLane* lane)
+{
+  releaseMutex(&lane->mutex);
+  destroyCond(&lane->condition);
+  destroyCond(&lane->notFull);
+  lane->svrConnHandler = NULL;
+}
+
+/**
+ * Determine the lane of the given client. All packets of a client use the
+ * same lane.
+ *
+ * @param queue The receiver queue
+ * @param client The client the packet was received from
+ *
+ * @return The lane.
+ *
+ * @since 0.4.1.0
+ */
+static inline SCH_ReceiverLane* _getSCHReceiverLane(SCH_ReceiverQueue* queue,
+                                                    ServerClient* client)
+{
+  // The client instances are allocated, the lower bits carry no information.
+  uint64_t hash = (uint64_t)(uintptr_t)client * 0x9E3779B97F4A7C15ULL;
+
+  return &queue->lanes[(hash >> 32) % queue->noLanes];
+}
+
+/**
+ * Create the receiver queue with one lane per receiver thread. The threads
+ * are started by startSCHReceiverQueue.
+ *
+ * @param srvConnHandler The server connection handler.
+ * @param noLanes The number of lanes (receiver threads), at least one.
  * 
  * @return the SCH_ReceiverQueue or NULL.
  * 
  * @since 0.3.0
  */
 SCH_ReceiverQueue* createSCHReceiverQueue(ServerConnectionHandler* 
-                                                                 srvConnHandler)
+                                                                srvConnHandler,
+                                          uint8_t noLanes)
 {
   SCH_ReceiverQueue* queue = malloc(sizeof(SCH_ReceiverQueue));
+  int idx;
+
+  if (noLanes == 0)
+  {
+    noLanes = 1;
+  }
   if (queue != NULL)
   {
-    if (initMutex(&queue->mutex))
+    queue->svrConnHandler = srvConnHandler;
+    queue->noLanes        = 0;
+    queue->lanes          = malloc(noLanes * sizeof(SCH_ReceiverLane));
+    if (queue->lanes == NULL)
     {
-      if (!initCond(&queue->condition))
+      free(queue);
+      queue = NULL;
+    }
+  }
+  if (queue != NULL)
+  {
+    for (idx = 0; idx < noLanes; idx++)
+    {
+      if (!_initSCHReceiverLane(&queue->lanes[idx], srvConnHandler,
+                                SCH_RECEIVE_QUEUE_MAX / noLanes))
       {
-        releaseMutex(&queue->mutex);
-        free(queue);
-        queue = NULL;
+        break;
       }
     }
-    else
+    if (idx < noLanes)
     {
+      while (idx-- > 0)
+      {
+        _releaseSCHReceiverLane(&queue->lanes[idx]);
+      }
+      free(queue->lanes);
       free(queue);
       queue = NULL;
     }
-    
-    if (queue != NULL)
+    else
     {
-      queue->head    = NULL;
-      queue->tail    = NULL;
-      queue->size    = 0;
-      queue->running = false;
-      queue->svrConnHandler = srvConnHandler;
+      queue->noLanes = noLanes;
     }
   }
     
@@ -157,6 +355,8 @@ SCH_ReceiverQueue* createSCHReceiverQueue(ServerConnectionHandler*
  */
 void releaseSCHReceiverQueue(SCH_ReceiverQueue* queue)
 {
+  int idx;
+
   LOG(LEVEL_INFO, "Enter release Server Connection Handler Receiver Queue...");
 
   if (queue == NULL)
@@ -166,17 +366,17 @@ void releaseSCHReceiverQueue(SCH_ReceiverQueue* queue)
   }
   else
   {
-    if (queue->running)
-    {
-      // Stops and cleans the queue
-      stopSCHReceiverQueue(queue);
-    }
-    if (queue->head != NULL)
+    // Stops and cleans the queue if not done already
+    stopSCHReceiverQueue(queue);
+    for (idx = 0; idx < queue->noLanes; idx++)
     {
-      RAISE_SYS_ERROR("Queue should be already empty!");
+      if (queue->lanes[idx].head != NULL)
+      {
+        RAISE_SYS_ERROR("Queue should be already empty!");
+      }
+      _releaseSCHReceiverLane(&queue->lanes[idx]);
     }
-    releaseMutex(&queue->mutex);
-    destroyCond(&queue->condition);
+    free(queue->lanes);
     queue->svrConnHandler = NULL;
     free (queue);
   }
@@ -185,18 +385,19 @@ void releaseSCHReceiverQueue(SCH_ReceiverQueue* queue)
 }
 
 /** 
- * The thread loop of the queue. To stop the queue call stopSendQueue()
+ * The thread loop of a lane of the queue. To stop the queue call
+ * stopSCHReceiverQueue()
  * 
- * @param The queue itself
+ * @param The lane of the queue
  * 
  * @return NULL
  * 
  * @since 0.3.0
  */
-void* schReceiverQueueThreadLoop(void* thisQueue)
+void* schReceiverQueueThreadLoop(void* thisLane)
 {
-  SCH_ReceiverQueue* queue = (SCH_ReceiverQueue*)thisQueue;
-  if (queue == NULL)
+  SCH_ReceiverLane* lane = (SCH_ReceiverLane*)thisLane;
+  if (lane == NULL)
   {
     RAISE_SYS_ERROR("Server Connection Handler Receiver Queue is not "
                     "initialized!");
@@ -205,15 +406,26 @@ void* schReceiverQueueThreadLoop(void* thisQueue)
   {
     SCH_ReceiverQueueElement* packet = NULL;
     LOG(LEVEL_DEBUG, "Enter loop of Server Connection Handler Receiver Queue.");
-    while (queue->running)
+    while (lane->running)
     {
-      packet = fetchSCHReceiverPacket(queue);
+      packet = fetchSCHReceiverPacket(lane);
       if (packet != NULL)
       {
+        recordStage(STAGE_RECEIVER_QUEUE, packet->queued);
+        if (isUpdateTracing())
+        {
+          setTracedPDUTimes(packet->queued, getStageTime());
+        }
+        // Allow the command queue to keep a reference of the PDU as well.
+        setDispatchedPacketChunk(packet->chunk);
         _handlePacket(packet->svrSock, packet->client, packet->pdu, 
-                      packet->size, queue->svrConnHandler);
-        free(packet->pdu);
-        free(packet);
+                      packet->size, lane->svrConnHandler);
+        setDispatchedPacketChunk(NULL);
+        _freeSCHReceiverPacket(packet);
+      }
+      if (lane->svrConnHandler->flowPaused)
+      {
+        updateFlowControl(lane->svrConnHandler);
       }
     }
     LOG(LEVEL_DEBUG, "Exit loop of Server Connection Handler REceiver Queue!");
@@ -223,8 +435,8 @@ void* schReceiverQueueThreadLoop(void* thisQueue)
 }
 
 /**
- * Start the send queue. In case the queue is already started this method does 
- * not further start it.
+ * Start the receiver queue, one thread per lane. In case the queue is already
+ * started this method does not further start it.
  * 
  * @return true if the Queue is running.
  * 
@@ -232,7 +444,10 @@ void* schReceiverQueueThreadLoop(void* thisQueue)
  */
 bool startSCHReceiverQueue(SCH_ReceiverQueue* queue)
 {
+  SCH_ReceiverLane* lane;
   bool retVal = false;
+  char name[16];
+  int  idx;
   
   if (queue == NULL)
   {
@@ -241,32 +456,51 @@ bool startSCHReceiverQueue(SCH_ReceiverQueue* queue)
   }
   else
   {
-    lockMutex(&queue->mutex);
-    if (!queue->running)
+    retVal = true;
+    for (idx = 0; retVal && (idx < queue->noLanes); idx++)
     {
-      queue->running = true;    
-      if (pthread_create(&queue->handler, NULL, schReceiverQueueThreadLoop, 
-                         queue) != 0)
+      lane = &queue->lanes[idx];
+      lockMutex(&lane->mutex);
+      if (!lane->running)
       {
-        queue->running = false;
-        RAISE_SYS_ERROR("Could not start the Server Connection Handler Receiver"
-                        " queue!");
+        lane->running = true;
+        snprintf(name, sizeof(name), "srx-recv-%d", idx);
+        if (createThread(&lane->handler, NULL, THREAD_CLASS_RECEIVER,
+                         name, schReceiverQueueThreadLoop, lane) != 0)
+        {
+          lane->running = false;
+          RAISE_SYS_ERROR("Could not start the Server Connection Handler "
+                          "Receiver queue thread %d!", idx);
+        }
+        else
+        {
+          lane->started = true;
+        }
       }
+      retVal = lane->running;
+      unlockMutex(&lane->mutex);
+    }
+    if (!retVal)
+    {
+      // Without its thread a lane would not be served.
+      stopSCHReceiverQueue(queue);
     }
-
-    retVal = queue->running;
-    unlockMutex(&queue->mutex);
   }
   return retVal;
 }
 
 /**
- * Stop the queue but does not destroy the thread itself.
+ * Stop all lanes of the queue, join their threads and drop the remaining
+ * packets.
  * 
  * @since 0.3.0
  */
 void stopSCHReceiverQueue(SCH_ReceiverQueue* queue)
 {
+  SCH_ReceiverLane* lane;
+  SCH_ReceiverQueueElement* packet = NULL;
+  int idx;
+
   if (queue == NULL)
   {
     RAISE_SYS_ERROR("Server Connection Handler Receiver queue is not "
@@ -274,87 +508,105 @@ void stopSCHReceiverQueue(SCH_ReceiverQueue* queue)
   }
   else
   {
-    lockMutex(&queue->mutex);
-    if (queue->running)
+    for (idx = 0; idx < queue->noLanes; idx++)
     {
-      queue->running = false;
-      // Stop the queue by waking it up
-      LOG(LEVEL_INFO, "stopSCHReceiverQueue: send notification...");
-      signalCond(&queue->condition);
+      lane = &queue->lanes[idx];
+      lockMutex(&lane->mutex);
+      if (lane->running)
+      {
+        lane->running = false;
+        // Stop the lane by waking it up
+        LOG(LEVEL_INFO, "stopSCHReceiverQueue: send notification to lane "
+                        "%d...", idx);
+        signalCond(&lane->condition);
+        pthread_cond_broadcast(&lane->notFull);
+      }
+      unlockMutex(&lane->mutex);
     }
-    unlockMutex(&queue->mutex);
-    // Give the queue thread a chance to process the notify or run into a
+    // Give the queue threads a chance to process the notify or run into a
     // wait timeout.   
     LOG(LEVEL_INFO, "stopSCHReceiverQueue: sleep for %u ms", 
                     SCH_RECEIVE_QUEUE_WAIT_MS * 2);
     usleep(SCH_RECEIVE_QUEUE_WAIT_MS * 2);
     
-    lockMutex(&queue->mutex);
-    // Free the remainder of the queue.
-    LOG(LEVEL_INFO, "stopSCHReceiverQueue: wait for queue thread to join...");
-    pthread_join(queue->handler, NULL);
-    LOG(LEVEL_INFO, "schReceiverQueueThreadLoop STOPPED. Empty remainder of "
-                    "queue!");
-    SCH_ReceiverQueueElement* packet = NULL;
-    while (queue->head != NULL)
+    for (idx = 0; idx < queue->noLanes; idx++)
     {
-      packet = queue->head;
-      queue->head = (SCH_ReceiverQueueElement*)packet->next;
-      // Free the allocated memory
-      free(packet->pdu);
-      free(packet);
-      queue->size--;
+      lane = &queue->lanes[idx];
+      if (lane->started)
+      {
+        LOG(LEVEL_INFO, "stopSCHReceiverQueue: wait for queue thread %d to "
+                        "join...", idx);
+        pthread_join(lane->handler, NULL);
+        lane->started = false;
+      }
+      lockMutex(&lane->mutex);
+      // Free the remainder of the lane.
+      while (lane->head != NULL)
+      {
+        packet = lane->head;
+        lane->head = (SCH_ReceiverQueueElement*)packet->next;
+        // Free the allocated memory
+        _freeSCHReceiverPacket(packet);
+        lane->size--;
+      }
+      lane->tail = NULL;
+      unlockMutex(&lane->mutex);
     }
-    queue->tail = NULL;
-    unlockMutex(&queue->mutex);
+    LOG(LEVEL_INFO, "schReceiverQueueThreadLoop STOPPED. Emptied remainder of "
+                    "queue!");
   }
 }
 
 /**
- * Retrieve the next packet from the queue as long as the queue is running. 
- * in case the queue is not running this method returns NULL.
+ * Retrieve the next packet from the lane as long as the lane is running.
+ * in case the lane is not running this method returns NULL.
  * 
- * @return  the next packet of NULL if the queue is empty.
+ * @return  the next packet of NULL if the lane is empty.
  * 
  * @since 0.3.0
  */
-SCH_ReceiverQueueElement* fetchSCHReceiverPacket(SCH_ReceiverQueue* queue)
+SCH_ReceiverQueueElement* fetchSCHReceiverPacket(SCH_ReceiverLane* lane)
 {
   SCH_ReceiverQueueElement* packet = NULL;
   
-  if (queue != NULL)
+  if (lane != NULL)
   {
-    lockMutex(&queue->mutex);
-    while (queue->size == 0 && queue->running)
+    lockMutex(&lane->mutex);
+    while (lane->size == 0 && lane->running)
     {
       // wait until notify is called or after a timeout.      
-      waitCond(&queue->condition, &queue->mutex, SCH_RECEIVE_QUEUE_WAIT_MS);
-      if(!queue->running)
+      waitCond(&lane->condition, &lane->mutex, SCH_RECEIVE_QUEUE_WAIT_MS);
+      if(!lane->running)
       {
         LOG(LEVEL_INFO, "Server Connection Handler Receiver Queue received "
                         "shutdown!");
       }
     }
 
-    // If queue is still running and a packet is available take it
-    if (queue->running && queue->head != NULL)
+    // If lane is still running and a packet is available take it
+    if (lane->running && lane->head != NULL)
     {
-      packet = queue->head;
-      queue->size--;
-      queue->head = (SCH_ReceiverQueueElement*)packet->next;
+      packet = lane->head;
+      lane->size--;
+      lane->head = (SCH_ReceiverQueueElement*)packet->next;
       packet->next = NULL;   
+      if (lane->size == lane->maxSize - 1)
+      {
+        pthread_cond_broadcast(&lane->notFull);
+      }
     }
-    unlockMutex(&queue->mutex);
+    unlockMutex(&lane->mutex);
   }
   return packet;
 }
 
 /**
- * Queue a copy of the the packet and return the size of the queue. The copy of 
+ * Queue a copy of the the packet in the lane of the client. The copy of
  * the packet will be freed by the queue handler thread itself.
  * 
- * @param pdu The received PDU to be added to the queue. ( A copy will be 
- *            created and stored)
+ * @param pdu The received PDU to be added to the queue. ( A reference of the
+ *            receive chunk is stored, a copy is only created if the PDU is
+ *            not stored in a chunk)
  * @param svrSoc The server socket 
  * @param client The client to received from
  * @param size The size of the PDU
@@ -368,17 +620,33 @@ bool addToSCHReceiverQueue(uint8_t* pdu, ServerSocket* svrSoc,
                            ServerClient* client, size_t size, 
                            SCH_ReceiverQueue* queue)
 {
-  SCH_ReceiverQueueElement* packet = malloc(sizeof(SCH_ReceiverQueueElement));
+  SCH_ReceiverLane* lane = _getSCHReceiverLane(queue, client);
+  SCH_ReceiverQueueElement* packet;
   bool retVal = false;
+
+  packet = allocPacketBuffer(sizeof(SCH_ReceiverQueueElement));
   
-  lockMutex(&queue->mutex);
+  lockMutex(&lane->mutex);
+  // Push back on the receiving thread, it stops reading from the sockets.
+  while (lane->running && (lane->size >= lane->maxSize))
+  {
+    waitCond(&lane->notFull, &lane->mutex, SCH_RECEIVE_QUEUE_WAIT_MS);
+  }
   if (packet != NULL)
   {
     memset(packet, 0, sizeof(SCH_ReceiverQueueElement));
-    packet->pdu = malloc(size);
+    packet->chunk = retainDispatchedPacket(pdu, size);
+    if (packet->chunk != NULL)
+    {
+      packet->pdu = pdu;
+    }
+    else if ((packet->pdu = allocPacketBuffer(size)) != NULL)
+    {
+      memcpy(packet->pdu, pdu, size);  
+    }
     if (packet->pdu == NULL)
     {
-      free(packet);
+      freePacketBuffer(packet);
     }
     else
     {
@@ -387,23 +655,24 @@ bool addToSCHReceiverQueue(uint8_t* pdu, ServerSocket* svrSoc,
       packet->client   = client;
       packet->next     = NULL;
       packet->size     = size;
-      memcpy(packet->pdu, pdu, size);  
-      if (queue->size == 0)
+      packet->queued   = getStageTime();
+      if (lane->size == 0)
       {
-        queue->head = packet;
-        queue->tail = packet;
+        lane->head = packet;
+        lane->tail = packet;
       }
       else
       {
-        queue->tail->next = packet;
-        queue->tail = packet;
+        lane->tail->next = packet;
+        lane->tail = packet;
       }
-      queue->size++;
-      // Signal a new packet is in the queue
-      signalCond(&queue->condition);
+      lane->size++;
+      recordQueueDepth(STATS_QUEUE_RECEIVER, lane->size);
+      // Signal a new packet is in the lane
+      signalCond(&lane->condition);
     }
   }
-  unlockMutex(&queue->mutex);
+  unlockMutex(&lane->mutex);
   
   if (!retVal)
   {
@@ -464,11 +733,13 @@ bool createServerConnectionHandler(ServerConnectionHandler* self,
       
       self->updateCache = updCache;
       self->sysConfig = sysConfig;
+      self->provisional = sysConfig->mode_provisional_sync;
       
       if (!sysConfig->mode_no_receivequeue)
       {
         // Enable the receiver queue
-        SCH_ReceiverQueue* queue = createSCHReceiverQueue(self);
+        SCH_ReceiverQueue* queue = createSCHReceiverQueue(self,
+                                              sysConfig->receiverThreads);
         if (queue == NULL)
         {
           RAISE_SYS_ERROR("Could not create the Server Connection Handler "
@@ -483,7 +754,7 @@ bool createServerConnectionHandler(ServerConnectionHandler* self,
           else
           {
             // Free the allocated memory again
-            free(queue);
+            releaseSCHReceiverQueue(queue);
           }          
         }
       }
@@ -527,12 +798,14 @@ void releaseServerConnectionHandler(ServerConnectionHandler* self)
  * @param client The client instance where the packet was received on
  * @param updateCache The instance of the update cache
  * @param hdr The validation request header
+ * @param priority The command queue priority of the validation.
  *
  * @return false if an internal (fatal) error occurred, otherwise true.
  */
 bool processValidationRequest(ServerConnectionHandler* self,
                               ServerSocket* svrSock, ClientThread* client,
-                              SRXRPOXY_BasicHeader_VerifyRequest* hdr)
+                              SRXRPOXY_BasicHeader_VerifyRequest* hdr,
+                              CommandQueuePriority priority)
 {
   LOG(LEVEL_DEBUG, HDR "Enter processValidationRequest", pthread_self());
 
@@ -562,53 +835,60 @@ bool processValidationRequest(ServerConnectionHandler* self,
   SRxUpdateID updateID = 0;
   
   bool doStoreUpdate = false;
-  IPPrefix* prefix = NULL;
+  // The prefix is only needed during this call, only the bytes of its IP
+  // version are set.
+  IPPrefix prefix;
   // Specify the client id as a receiver only when validation is requested.
   uint8_t clientID = (doOriginVal || doPathVal) ? client->routerID : 0;
+  bool    crc32cID = self->proxyMap[client->routerID].crc32cID;
     
-  // 1. Prepare for and generate the ID of the update
-  prefix = malloc(sizeof(IPPrefix));  
-  memset(prefix, 0, sizeof(IPPrefix));
-  prefix->length     = hdr->prefixLen;  
+  // 1. Prepare for and generate the ID of the update, each IP version has its
+  //    own path.
+  prefix.length = hdr->prefixLen;
   BGPSecData bgpsecData;
   memset (&bgpsecData, 0, sizeof(BGPSecData));
-  // initialize the val pointer - it will be adjusted within the correct 
-  // request type.
-  uint8_t* valPtr = (uint8_t*)hdr;
   if (v4)
   {
     SRXPROXY_VERIFY_V4_REQUEST* v4Hdr = (SRXPROXY_VERIFY_V4_REQUEST*)hdr;
-    valPtr += sizeof(SRXPROXY_VERIFY_V4_REQUEST);
-    prefix->ip.version     = 4;
-    prefix->ip.addr.v4     = v4Hdr->prefixAddress;
+    // The path data follows the request
+    uint8_t* valPtr = (uint8_t*)hdr + sizeof(SRXPROXY_VERIFY_V4_REQUEST);
+    prefix.ip.version      = 4;
+    prefix.ip.addr.v4.u32  = v4Hdr->prefixAddress.u32;
     originAS               = ntohl(v4Hdr->originAS);
     bgpsecData.numberHops  = ntohs(v4Hdr->bgpsecValReqData.numHops);
     bgpsecData.attr_length = ntohs(v4Hdr->bgpsecValReqData.attrLen);
+    if (bgpsecData.numberHops != 0)
+    {
+      bgpsecData.asPath = (uint32_t*)valPtr;
+    }
+    if (bgpsecData.attr_length != 0)
+    {
+      // bgpsec attribute comes after the as4 path
+      bgpsecData.bgpsec_path_attr = valPtr + (bgpsecData.numberHops * 4);
+    }
+    // 2. Generate the CRC based updateID using the 32 bit address
+    updateID = crc32cID
+               ? generateIdentifierCRC32CV4(originAS, prefix.ip.addr.v4.u32,
+                                            prefix.length, &bgpsecData)
+               : generateIdentifierV4(originAS, prefix.ip.addr.v4.u32,
+                                      prefix.length, &bgpsecData);
   }
   else
   {
+    // The path data of IPv6 requests is not part of the update ID.
     SRXPROXY_VERIFY_V6_REQUEST* v6Hdr = (SRXPROXY_VERIFY_V6_REQUEST*)hdr;
-    valPtr += sizeof(SRXPROXY_VERIFY_V6_REQUEST);
-    prefix->ip.version = 6;
-    prefix->ip.addr.v6 = v6Hdr->prefixAddress;
-    originAS           = ntohl(v6Hdr->originAS);
-  }
-  
-  if (bgpsecData.numberHops != 0)
-  {
-    bgpsecData.asPath = (uint32_t*)valPtr;
-  }
-  if (bgpsecData.attr_length != 0)
-  {
-    // bgpsec attribute comes after the as4 path
-    bgpsecData.bgpsec_path_attr = valPtr + (bgpsecData.numberHops * 4);
+    prefix.ip.version = 6;
+    prefix.ip.addr.v6 = v6Hdr->prefixAddress;
+    originAS          = ntohl(v6Hdr->originAS);
+    // 2. Generate the CRC based updateID
+    updateID = crc32cID
+               ? generateIdentifierCRC32C(originAS, &prefix, &bgpsecData)
+               : generateIdentifier(originAS, &prefix, &bgpsecData);
   }
   
-  // 2. Generate the CRC based updateID
-  updateID = generateIdentifier(originAS, prefix, &bgpsecData);      
   // test for collision and attempt to resolve
   collisionID = updateID;    
-  while(detectCollision(self->updateCache, &updateID, prefix, originAS,
+  while(detectCollision(self->updateCache, &updateID, &prefix, originAS,
                         &bgpsecData))
   {
     updateID++;
@@ -619,6 +899,10 @@ bool processValidationRequest(ServerConnectionHandler* self,
       " could have been [0x%08X] but was changed to a collision free ID "
       "[0x%08X]!", collisionID, updateID);
   }
+  if (isUpdateTraced(updateID))
+  {
+    startUpdateTrace(updateID);
+  }
   
   //  3. Try to find the update, if it does not exist yet, store it.
   SRxResult        srxRes;
@@ -627,6 +911,10 @@ bool processValidationRequest(ServerConnectionHandler* self,
   // register the client as listener (only if the update already exists)
   ProxyClientMapping* clientMapping = clientID > 0 ? &self->proxyMap[clientID]
                                                    : NULL;
+  if (clientMapping != NULL)
+  {
+    __sync_add_and_fetch(&clientMapping->noRequests, 1);
+  }
   doStoreUpdate = !getUpdateResult (self->updateCache, &updateID, 
                                     clientID, clientMapping, 
                                     &srxRes, &defResInfo);
@@ -652,12 +940,11 @@ bool processValidationRequest(ServerConnectionHandler* self,
     defResInfo.resSourceBGPSEC     = hdr->bgpsecResSrc;
     
     if (!storeUpdate(self->updateCache, clientID, clientMapping,
-                     &updateID, prefix, originAS, &defResInfo, &bgpsecData))
+                     &updateID, &prefix, originAS, &defResInfo, &bgpsecData))
     {
       RAISE_SYS_ERROR("Could not store update [0x%08X]!!", updateID);
       // Maybe check for ID conflict, if not then get result again - or just
       // quit here!
-      free(prefix);    
       return false;
     }
     
@@ -665,8 +952,6 @@ bool processValidationRequest(ServerConnectionHandler* self,
     srxRes.roaResult    = defResInfo.result.roaResult;
     srxRes.bgpsecResult = defResInfo.result.bgpsecResult;
   }
-  free(prefix);
-  prefix = NULL;
 
   // Just check if the client has the correct values for the requested results
   if (doOriginVal && (hdr->roaDefRes != srxRes.roaResult))
@@ -703,14 +988,87 @@ bool processValidationRequest(ServerConnectionHandler* self,
     }
   }
 
-  if (doOriginVal || doPathVal)
+  // Fast path: An update already known with a final result for all requested
+  // validations is answered above and does not need the command handler.
+  uint8_t valFlags  = 0;
+  uint8_t idleFlags = 0;
+  if (doStoreUpdate)
+  {
+    // A new update is not validated yet, whatever default the router sent.
+    valFlags = hdr->flags & SRX_FLAG_ROA_AND_BGPSEC;
+    if (self->sysConfig->mode_lazy_validation)
+    {
+      // The router works with its default result until the validation is
+      // done, only an undefined default is validated right away. Everything
+      // else, including the validations not requested, waits for idle time.
+      idleFlags = SRX_FLAG_ROA_AND_BGPSEC;
+      if (hdr->roaDefRes != SRx_RESULT_UNDEFINED)
+      {
+        valFlags = valFlags & ~SRX_FLAG_ROA;
+      }
+      if (hdr->bgpsecDefRes != SRx_RESULT_UNDEFINED)
+      {
+        valFlags = valFlags & ~SRX_FLAG_BGPSEC;
+      }
+      idleFlags = idleFlags & ~valFlags;
+    }
+  }
+  else
+  {
+    // A request for a result that is still undefined is served right away,
+    // even if the validation is already waiting for idle time.
+    if (doOriginVal && (srxRes.roaResult == SRx_RESULT_UNDEFINED))
+    {
+      valFlags = valFlags | SRX_FLAG_ROA;
+    }
+    if (doPathVal && (srxRes.bgpsecResult == SRx_RESULT_UNDEFINED))
+    {
+      valFlags = valFlags | SRX_FLAG_BGPSEC;
+    }
+  }
+  // The update is stored, make sure the flag is read after the store.
+  __sync_synchronize();
+  if (self->provisional)
+  {
+    // No validation cache is synchronized yet, the origin validation is done
+    // for all stored updates once the first one is. The router works with
+    // its default result meanwhile.
+    valFlags  = valFlags & ~SRX_FLAG_ROA;
+    idleFlags = idleFlags & ~SRX_FLAG_ROA;
+  }
+
+  if (idleFlags > 0)
+  {
+    // The idle command keeps its own copy, the flags can be changed later.
+    hdr->flags = idleFlags;
+    if (!queueCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY,
+                      COMMAND_PRIORITY_IDLE, svrSock, client, updateID,
+                      ntohl(hdr->length), (uint8_t*)hdr))
+    {
+      // The idle ring is full. Requested validations are not dropped, the
+      // prevalidation of the others is.
+      LOG(LEVEL_DEBUG, HDR "Idle ring is full, validate update [0x%08X] "
+                       "right away.", pthread_self(), updateID);
+      if (doOriginVal)
+      {
+        valFlags = valFlags | (idleFlags & SRX_FLAG_ROA);
+      }
+      if (doPathVal)
+      {
+        valFlags = valFlags | (idleFlags & SRX_FLAG_BGPSEC);
+      }
+    }
+  }
+
+  if (valFlags > 0)
   {
-    // Only keep the validation flags.
-    hdr->flags = sendFlags & SRX_FLAG_ROA_AND_BGPSEC;
+    // Only keep the validations that are still outstanding.
+    hdr->flags = valFlags;
     
     // create the validation command!
-    if (!queueCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY, svrSock, client, 
-                      updateID, ntohl(hdr->length), (uint8_t*)hdr))
+    if (!queueCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY, priority,
+                      svrSock, client, updateID, ntohl(hdr->length),
+                      (uint8_t*)hdr))
     {
       RAISE_ERROR("Could not add validation request to command queue!");
       retVal = false;
@@ -721,6 +1079,240 @@ bool processValidationRequest(ServerConnectionHandler* self,
   return retVal;
 }
 
+/**
+ * Unpack the bulk verify request into one validation request per prefix and
+ * process each of them. The AS path and bgpsec path attribute are copied only
+ * once, all updates of the bulk store the same path data which is interned by
+ * the update cache. This method does NOT send error packets to the proxy!
+ *
+ * @param self The server connection handler.
+ * @param svrSock The server socket used to send possible receipts
+ * @param client The client instance where the packet was received on
+ * @param hdr The bulk verify request
+ * @param length The length of the received packet
+ *
+ * @return false if the packet is malformed or an internal (fatal) error
+ *         occurred, otherwise true.
+ *
+ * @since 0.4.1.0
+ */
+static bool _processBulkValidationRequest(ServerConnectionHandler* self,
+                                          ServerSocket* svrSock,
+                                          ClientThread* client,
+                                          SRXPROXY_VERIFY_BULK_REQUEST* hdr,
+                                          PacketLength length)
+{
+  bool     v4         = hdr->ipVersion == 4;
+  uint32_t noEntries  = ntohl(hdr->noEntries);
+  uint16_t numHops    = ntohs(hdr->numHops);
+  uint16_t attrLen    = ntohs(hdr->attrLen);
+  uint32_t pathLength = (numHops * 4) + attrLen;
+  uint32_t entrySize  = v4 ? sizeof(SRXPROXY_BULK_ENTRY_V4)
+                           : sizeof(SRXPROXY_BULK_ENTRY_V6);
+  uint32_t reqSize    = v4 ? sizeof(SRXPROXY_VERIFY_V4_REQUEST)
+                           : sizeof(SRXPROXY_VERIFY_V6_REQUEST);
+  uint8_t* entryPtr   = (uint8_t*)hdr + sizeof(SRXPROXY_VERIFY_BULK_REQUEST)
+                        + pathLength;
+  uint8_t* request;
+  uint32_t idx;
+  bool     retVal     = true;
+
+  SRXRPOXY_BasicHeader_VerifyRequest* common;
+
+  if (!self->proxyMap[client->routerID].bulkVerify)
+  {
+    RAISE_ERROR("Client [0x%02X] did not negotiate bulk verify requests!",
+                client->routerID);
+    return false;
+  }
+  if (   ((hdr->ipVersion != 4) && (hdr->ipVersion != 6))
+      || (length < sizeof(SRXPROXY_VERIFY_BULK_REQUEST))
+      || (noEntries > SRX_MAX_BULK_ENTRIES)
+      || (ntohl(hdr->length) != length)
+      || (length !=   sizeof(SRXPROXY_VERIFY_BULK_REQUEST) + pathLength
+                    + (noEntries * entrySize)))
+  {
+    RAISE_ERROR("Malformed bulk verify request of %u bytes received from "
+                "client [0x%02X]!", length, client->routerID);
+    return false;
+  }
+
+  // All requests of the bulk share the same header and path data.
+  request = malloc(reqSize + pathLength);
+  if (request == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory to unpack the bulk verify request!");
+    return false;
+  }
+  memset(request, 0, reqSize);
+  memcpy(request + reqSize,
+         (uint8_t*)hdr + sizeof(SRXPROXY_VERIFY_BULK_REQUEST), pathLength);
+  common = (SRXRPOXY_BasicHeader_VerifyRequest*)request;
+  common->type         = v4 ? PDU_SRXPROXY_VERIFY_V4_REQUEST
+                            : PDU_SRXPROXY_VERIFY_V6_REQUEST;
+  common->roaResSrc    = hdr->roaResSrc;
+  common->bgpsecResSrc = hdr->bgpsecResSrc;
+  common->length       = htonl(reqSize + pathLength);
+  common->roaDefRes    = hdr->roaDefRes;
+  common->bgpsecDefRes = hdr->bgpsecDefRes;
+
+  for (idx = 0; (idx < noEntries) && retVal; idx++, entryPtr += entrySize)
+  {
+    if (v4)
+    {
+      SRXPROXY_BULK_ENTRY_V4*     entry = (SRXPROXY_BULK_ENTRY_V4*)entryPtr;
+      SRXPROXY_VERIFY_V4_REQUEST* v4Hdr = (SRXPROXY_VERIFY_V4_REQUEST*)request;
+      common->prefixLen     = entry->prefixLen;
+      common->requestToken  = entry->requestToken;
+      v4Hdr->prefixAddress  = entry->prefixAddress;
+      v4Hdr->originAS       = entry->originAS;
+      v4Hdr->bgpsecLength   = htonl(pathLength);
+      v4Hdr->bgpsecValReqData.numHops = hdr->numHops;
+      v4Hdr->bgpsecValReqData.attrLen = hdr->attrLen;
+    }
+    else
+    {
+      SRXPROXY_BULK_ENTRY_V6*     entry = (SRXPROXY_BULK_ENTRY_V6*)entryPtr;
+      SRXPROXY_VERIFY_V6_REQUEST* v6Hdr = (SRXPROXY_VERIFY_V6_REQUEST*)request;
+      common->prefixLen     = entry->prefixLen;
+      common->requestToken  = entry->requestToken;
+      v6Hdr->prefixAddress  = entry->prefixAddress;
+      v6Hdr->originAS       = entry->originAS;
+      v6Hdr->bgpsecLength   = htonl(pathLength);
+      v6Hdr->bgpsecValReqData.numHops = hdr->numHops;
+      v6Hdr->bgpsecValReqData.attrLen = hdr->attrLen;
+    }
+    // processValidationRequest reduces the flags to the open validations.
+    common->flags = (hdr->flags & (SRX_FLAG_ROA | SRX_FLAG_BGPSEC))
+                    | (common->requestToken != 0 ? SRX_FLAG_REQUEST_RECEIPT
+                                                 : 0);
+    retVal = processValidationRequest(self, svrSock, client, common,
+                                      COMMAND_PRIORITY_BULK);
+  }
+  free(request);
+
+  return retVal;
+}
+
+/**
+ * Process the synchronization updates of a proxy. The proxy is registered for
+ * all listed updates that are still stored in the update cache, results that
+ * differ from the results known to the proxy are send as verification
+ * notifications. The updates not stored anymore are reported back within a
+ * missing updates packet, the proxy has to verify them again. This method
+ * does NOT send error packets to the proxy!
+ *
+ * @param self The server connection handler.
+ * @param svrSock The server socket used to send the notifications
+ * @param client The client instance where the packet was received on
+ * @param hdr The synchronization updates
+ * @param length The length of the received packet
+ *
+ * @return false if the packet is malformed or an internal (fatal) error
+ *         occurred, otherwise true.
+ *
+ * @since 0.4.1.0
+ */
+static bool _processSyncUpdates(ServerConnectionHandler* self,
+                                ServerSocket* svrSock, ClientThread* client,
+                                SRXPROXY_SYNC_UPDATES* hdr,
+                                PacketLength length)
+{
+  ProxyClientMapping* mapping = &self->proxyMap[client->routerID];
+  bool     useQueue  = !self->sysConfig->mode_no_sendqueue;
+  uint32_t noUpdates = ntohl(hdr->noUpdates);
+  uint32_t noMissing = 0;
+  uint32_t idx;
+  uint8_t  resultType;
+  bool     retVal    = true;
+
+  SRXPROXY_NOTIFICATION_ENTRY* entry;
+  SRXPROXY_SYNC_MISSING*       missing;
+  SRxUpdateID                  updateID;
+  SRxResult                    srxRes;
+  SRxDefaultResult             defResInfo;
+
+  if (!mapping->incrSync)
+  {
+    RAISE_ERROR("Client [0x%02X] did not negotiate the incremental "
+                "synchronization!", client->routerID);
+    return false;
+  }
+  if (   (length < sizeof(SRXPROXY_SYNC_UPDATES))
+      || (noUpdates > SRX_MAX_SYNC_UPDATES)
+      || (ntohl(hdr->length) != length)
+      || (length !=   sizeof(SRXPROXY_SYNC_UPDATES)
+                    + (noUpdates * sizeof(SRXPROXY_NOTIFICATION_ENTRY))))
+  {
+    RAISE_ERROR("Malformed synchronization updates of %u bytes received from "
+                "client [0x%02X]!", length, client->routerID);
+    return false;
+  }
+
+  missing = malloc(  sizeof(SRXPROXY_SYNC_MISSING)
+                   + (noUpdates * sizeof(SRxUpdateID)));
+  if (missing == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory to process the synchronization!");
+    return false;
+  }
+  memset(missing, 0, sizeof(SRXPROXY_SYNC_MISSING));
+
+  for (idx = 0; idx < noUpdates; idx++)
+  {
+    entry    = &hdr->update[idx];
+    updateID = ntohl(entry->updateID);
+    // Registers the client with the update if it is still stored.
+    if (!getUpdateResult(self->updateCache, &updateID, client->routerID,
+                         mapping, &srxRes, &defResInfo))
+    {
+      missing->updateID[noMissing++] = entry->updateID;
+      continue;
+    }
+
+    // Report the results that changed while the proxy was disconnected.
+    resultType = 0;
+    if (   (srxRes.roaResult != SRx_RESULT_UNDEFINED)
+        && (   ((entry->resultType & SRX_FLAG_ROA) == 0)
+            || (entry->roaResult != srxRes.roaResult)))
+    {
+      resultType |= SRX_FLAG_ROA;
+    }
+    if (   (srxRes.bgpsecResult != SRx_RESULT_UNDEFINED)
+        && (   ((entry->resultType & SRX_FLAG_BGPSEC) == 0)
+            || (entry->bgpsecResult != srxRes.bgpsecResult)))
+    {
+      resultType |= SRX_FLAG_BGPSEC;
+    }
+    if (   (resultType != 0)
+        && !sendVerifyNotification(svrSock, client, updateID, resultType,
+                                   DONOTUSE_REQUEST_TOKEN, srxRes.roaResult,
+                                   srxRes.bgpsecResult, useQueue))
+    {
+      retVal = false;
+    }
+  }
+
+  if (noMissing > 0)
+  {
+    length = sizeof(SRXPROXY_SYNC_MISSING) + (noMissing * sizeof(SRxUpdateID));
+    missing->type      = PDU_SRXPROXY_SYNC_MISSING;
+    missing->length    = htonl(length);
+    missing->noUpdates = htonl(noMissing);
+    if (!sendPacketToProxy(svrSock, client, missing, length, useQueue))
+    {
+      RAISE_ERROR("Could not send the missing updates to client [0x%02X]!",
+                  client->routerID);
+      retVal = false;
+    }
+  }
+  LOG(LEVEL_INFO, "Synchronized %u updates with client [0x%02X], %u updates "
+                  "are missing.", noUpdates, client->routerID, noMissing);
+  free(missing);
+
+  return retVal;
+}
+
 /**
  * This method processes the validation result request. This method is called by
  * the packet handler and if necessary the request will be added to the command
@@ -774,9 +1366,9 @@ static bool processSignatureRequest(ServerConnectionHandler* self,
   }
   else // No data was available, add request to command handler for signing
   {
-    if (!queueCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY, svrSock, client, 
-                                      updateID, ntohl(hdr->length), 
-                                      (uint8_t*)hdr))
+    if (!queueCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY,
+                      COMMAND_PRIORITY_VERIFY, svrSock, client, updateID,
+                      ntohl(hdr->length), (uint8_t*)hdr))
     {
       RAISE_ERROR("Could not add validation request to command queue!");
       retVal = false;
@@ -861,7 +1453,8 @@ void _handlePacket(ServerSocket* svrSock, ServerClient* client,
           // This is done because within this process SRx calculates already the
           // UpdateID and adds it to the command item.
           if (!processValidationRequest(self, svrSock, clientThread,
-                                   (SRXRPOXY_BasicHeader_VerifyRequest*)packet))
+                                   (SRXRPOXY_BasicHeader_VerifyRequest*)packet,
+                                   COMMAND_PRIORITY_VERIFY))
           {
             sendError(SRXERR_INTERNAL_ERROR, svrSock, client, false);
             sendGoodbye(svrSock, client, false);
@@ -871,6 +1464,47 @@ void _handlePacket(ServerSocket* svrSock, ServerClient* client,
         }
 //#endif
         break;
+      case PDU_SRXPROXY_VERIFY_BULK_REQUEST:
+        if (!clientThread->initialized)
+        {
+          // A handshake was not performed, otherwise the clientThread would be
+          // initialized!!!
+          RAISE_SYS_ERROR("Connection not initialized yet - "
+                          "Handshake missing!!!");
+          sendError(SRXERR_INTERNAL_ERROR, svrSock, client, false);
+          sendGoodbye(svrSock, client, false);
+        }
+        else
+        {
+          LOG(LEVEL_DEBUG, HDR "Received Bulk Verify Request from proxy"
+                          "[0x%08X]", pthread_self(), clientThread);
+          // Each prefix is processed as its own validation request.
+          if (!_processBulkValidationRequest(self, svrSock, clientThread,
+                                         (SRXPROXY_VERIFY_BULK_REQUEST*)packet,
+                                         length))
+          {
+            sendError(SRXERR_INTERNAL_ERROR, svrSock, client, false);
+            sendGoodbye(svrSock, client, false);
+          }
+        }
+        break;
+      case PDU_SRXPROXY_SYNC_UPDATES:
+        if (!clientThread->initialized)
+        {
+          // A handshake was not performed, otherwise the clientThread would be
+          // initialized!!!
+          RAISE_SYS_ERROR("Connection not initialized yet - "
+                          "Handshake missing!!!");
+          sendError(SRXERR_INTERNAL_ERROR, svrSock, client, false);
+          sendGoodbye(svrSock, client, false);
+        }
+        else if (!_processSyncUpdates(self, svrSock, clientThread,
+                                      (SRXPROXY_SYNC_UPDATES*)packet, length))
+        {
+          sendError(SRXERR_INTERNAL_ERROR, svrSock, client, false);
+          sendGoodbye(svrSock, client, false);
+        }
+        break;
       case PDU_SRXPROXY_SIGN_REQUEST:
         if (!clientThread->initialized)
         {
@@ -970,9 +1604,12 @@ void _handlePacket(ServerSocket* svrSock, ServerClient* client,
     if (addToQueue)
     {
       // Whatever SRX packet except validation and signature request. It will
-      // be added to the command queue for further processing.
-      queueCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY, svrSock, client,
-                   dataID, length, (uint8_t*)packet);
+      // be added to the command queue for further processing. Deletions and
+      // session commands must not wait behind the validation requests.
+      queueCommand(self->cmdQueue, COMMAND_TYPE_SRX_PROXY,
+                   bhdr->type == PDU_SRXPROXY_DELTE_UPDATE
+                     ? COMMAND_PRIORITY_DELETE : COMMAND_PRIORITY_CONTROL,
+                   svrSock, client, dataID, length, (uint8_t*)packet);
     } 
   }
   LOG(LEVEL_DEBUG, HDR "Exit handlePacket", pthread_self());
@@ -1003,14 +1640,24 @@ void handlePacket(ServerSocket* svrSock, ServerClient* client,
   // Preparation for receiver queue
   ServerConnectionHandler* handler = (ServerConnectionHandler*)srvConHandler;
   SCH_ReceiverQueue* queue = (SCH_ReceiverQueue*)handler->receiverQueue;
+  uint64_t start = getStageTime();
   if (queue == NULL)
   {
+    if (isUpdateTracing())
+    {
+      setTracedPDUTimes(start, 0);
+    }
     _handlePacket(svrSock, client, packet, length, srvConHandler);
   }
   else
   {
     addToSCHReceiverQueue(packet, svrSock, client, length, queue);
   }
+  recordStage(STAGE_PDU_RECEIVE, start);
+  if ((__sync_add_and_fetch(&handler->flowCheck, 1) % FLOW_CHECK_PDUS) == 0)
+  {
+    updateFlowControl(handler);
+  }
 }
 
 /**
@@ -1057,6 +1704,7 @@ static bool handleStatusChange(ServerSocket* svrSock, ServerClient* client,
     }
 
     deleteFromSList(&self->clients, client);
+    releaseClientSendBuffer(client);
     
     bool crashed = !(self->inShutdown || clientThread->goodByeReceived);
     deactivateConnectionMapping(self, clientThread->routerID, crashed, 
@@ -1082,8 +1730,18 @@ void startProcessingRequests(ServerConnectionHandler* self,
                              CommandQueue* cmdQueue) 
 {
   LOG(LEVEL_DEBUG, HDR "Enter startProcessingRequests", pthread_self());
+  ClientMode clMode = MODE_SINGLE_CLIENT;
+
   self->cmdQueue = cmdQueue;
-  runServerLoop(&self->svrSock, MODE_SINGLE_CLIENT, handlePacket,
+  if (self->sysConfig->eventLoopThreads > 0)
+  {
+    if (setEventLoopThreads(&self->svrSock, self->sysConfig->eventLoopThreads))
+    {
+      clMode = MODE_EVENT_LOOP;
+    }
+  }
+  setShmTransport(&self->svrSock, self->sysConfig->shmTransport);
+  runServerLoop(&self->svrSock, clMode, handlePacket,
                 handleStatusChange, self);
   LOG(LEVEL_DEBUG, HDR "Exit startProcessingRequests", pthread_self());
 }
@@ -1348,6 +2006,8 @@ bool addMapping(ServerConnectionHandler* self, uint32_t proxyID,
       // it is a previous mapping that gets reconfigured / (re)activated
       self->noMappings++;
       self->proxyMap[clientID].proxyID    = proxyID;
+      self->proxyMap[clientID].noRequests      = 0;
+      self->proxyMap[clientID].noNotifications = 0;
     }
     self->proxyMap[clientID].socket     = cSocket;
     self->proxyMap[clientID].isActive   = activate;
@@ -1480,3 +2140,102 @@ void markConnectionHandlerShutdown(ServerConnectionHandler* self)
 {
   self->inShutdown = true;
 }
+
+/**
+ * Return the number of packets waiting in the receiver queue. This function 
+ * does not lock the queue.
+ * 
+ * @param self The connection handler instance
+ * 
+ * @return The number of packets queued, 0 if no receiver queue is used.
+ * 
+ * @since 0.4.1.0
+ */
+int getSCHReceiverQueueSize(ServerConnectionHandler* self)
+{
+  SCH_ReceiverQueue* queue = (SCH_ReceiverQueue*)self->receiverQueue;
+  int size = 0;
+  int idx;
+
+  if (queue != NULL)
+  {
+    for (idx = 0; idx < queue->noLanes; idx++)
+    {
+      size += queue->lanes[idx].size;
+    }
+  }
+  
+  return size;
+}
+
+/**
+ * End the provisional mode. The origin validation of new updates is requested
+ * right away again. The updates received during the provisional mode must be
+ * validated after this call (see validateProvisionalUpdates).
+ *
+ * @param self The connection handler instance
+ *
+ * @since 0.4.1.0
+ */
+void endProvisionalMode(ServerConnectionHandler* self)
+{
+  // Updates stored after this point are validated by the receiver, the ones
+  // stored before are found by the walk of the update cache that follows.
+  self->provisional = false;
+  __sync_synchronize();
+  LOG(LEVEL_INFO, "First validation cache synchronized, end of the "
+                  "provisional mode");
+}
+
+/**
+ * Compare the levels of the receiver queue, the command queue, and the send
+ * queue with their water marks. Once one of them passes its high water mark
+ * the proxies that negotiated the flow control are asked to pause sending,
+ * once all of them drained below their low water marks they are asked to
+ * resume.
+ *
+ * @param self The connection handler instance
+ *
+ * @since 0.4.1.0
+ */
+void updateFlowControl(ServerConnectionHandler* self)
+{
+  int           rcvSize = getSCHReceiverQueueSize(self);
+  int           cmdSize = self->cmdQueue != NULL
+                          ? getUnprocessedQueueSize(self->cmdQueue) : 0;
+  size_t        sndSize = getSendQueueSize();
+  bool          pause;
+  SListNode*    cnode;
+  ClientThread* clientThread;
+
+  if (!self->flowPaused)
+  {
+    pause =    (rcvSize >= FLOW_RECEIVE_HIGH) || (cmdSize >= FLOW_COMMAND_HIGH)
+            || (sndSize >= FLOW_SEND_HIGH);
+  }
+  else
+  {
+    pause =    (rcvSize > FLOW_RECEIVE_LOW) || (cmdSize > FLOW_COMMAND_LOW)
+            || (sndSize > FLOW_SEND_LOW);
+  }
+
+  // Only one thread reports the change.
+  if (   (pause == self->flowPaused)
+      || !__sync_bool_compare_and_swap(&self->flowPaused, !pause, pause))
+  {
+    return;
+  }
+
+  LOG(LEVEL_NOTICE, "%s the proxies (receiver queue: %d, command queue: %d, "
+                    "send queue: %zu bytes)", pause ? "Pause" : "Resume",
+                    rcvSize, cmdSize, sndSize);
+  FOREACH_SLIST(&self->clients, cnode)
+  {
+    clientThread = (ClientThread*)getDataOfSListNode(cnode);
+    if (   (clientThread != NULL) && clientThread->initialized
+        && self->proxyMap[clientThread->routerID].flowControl)
+    {
+      sendFlowControl(&self->svrSock, clientThread, pause, false);
+    }
+  }
+}
@@ -21,10 +21,22 @@
  * by this software.
  *
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added crc32cID to the ProxyClientMapping.
+ *            * Added multiNotify to the ProxyClientMapping.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added the request and notification counters to the 
+ *              ProxyClientMapping and getSCHReceiverQueueSize.
+ *            * Added the AS number of the router to the ProxyClientMapping.
+ *            * Added bulkVerify to the ProxyClientMapping.
+ *            * Added incrSync to the ProxyClientMapping.
+ *            * Added flowControl to the ProxyClientMapping, the flow control
+ *              state to the connection handler, and updateFlowControl.
+ *            * Added the provisional mode and endProvisionalMode.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  * 0.3.0    - 2013/02/15 - oborchert
@@ -75,6 +87,9 @@ typedef struct {
   uint32_t proxyID;
   /** Contains the Socket information */
   void* socket;
+  /** The AS number of the router, provided in the hello packet. The target
+   * AS of the most recent BGPSec signature. (since 0.4.1.0) */
+  uint32_t asn;
   /** Defines if the map entry is actively used at this point in time.*/
   bool isActive;
   /** Specifies if this entry is pre-defined using a configuration script. */
@@ -85,6 +100,27 @@ typedef struct {
   /** Number of updates assigned to this client. This allows a more efficient
    * cleanup. */
   uint32_t updateCount;  
+  /** Specifies if the update IDs of this client are generated using CRC-32C
+   * over the raw data (negotiated during the handshake). */
+  bool crc32cID;
+  /** Specifies if result changes are send to this client using multi 
+   * verification notifications (negotiated during the handshake). */
+  bool multiNotify;
+  /** Specifies if this client sends bulk verify requests (negotiated during
+   * the handshake). (since 0.4.1.0) */
+  bool bulkVerify;
+  /** Specifies if this client synchronizes by sending the updates it knows
+   * (negotiated during the handshake). (since 0.4.1.0) */
+  bool incrSync;
+  /** Specifies if this client pauses sending on request of the server
+   * (negotiated during the handshake). (since 0.4.1.0) */
+  bool flowControl;
+  /** The number of validation requests received from this client. Only 
+   * changed using atomic operations. (since 0.4.1.0) */
+  volatile uint64_t noRequests;
+  /** The number of validation results sent to this client. Only changed 
+   * using atomic operations. (since 0.4.1.0) */
+  volatile uint64_t noNotifications;
 } ProxyClientMapping;
 
 #define MAX_PROXY_CLIENT_ELEMENTS MAX_PROXY_MAPPINGS
@@ -123,6 +159,15 @@ typedef struct {
   
   // The internal receiver queue. NULL if not used. since 0.3.0
   void*              receiverQueue;
+
+  // Set while the proxies are asked to pause sending. since 0.4.1.0
+  volatile bool      flowPaused;
+  // The number of PDUs received, used to check the queues periodically.
+  // since 0.4.1.0
+  volatile uint32_t  flowCheck;
+  // Set until the first validation cache is synchronized, the origin
+  // validation is not requested meanwhile. since 0.4.1.0
+  volatile bool      provisional;
 } ServerConnectionHandler;
 
 /**
@@ -177,6 +222,42 @@ void stopProcessingRequests(ServerConnectionHandler* self);
  */
 void markConnectionHandlerShutdown(ServerConnectionHandler* self);
 
+/**
+ * Return the number of packets waiting in the receiver queue. This function 
+ * does not lock the queue.
+ * 
+ * @param self The connection handler instance
+ * 
+ * @return The number of packets queued, 0 if no receiver queue is used.
+ * 
+ * @since 0.4.1.0
+ */
+int getSCHReceiverQueueSize(ServerConnectionHandler* self);
+
+/**
+ * Compare the levels of the receiver queue, the command queue, and the send
+ * queue with their water marks. Once one of them passes its high water mark
+ * the proxies that negotiated the flow control are asked to pause sending,
+ * once all of them drained below their low water marks they are asked to
+ * resume.
+ *
+ * @param self The connection handler instance
+ *
+ * @since 0.4.1.0
+ */
+void updateFlowControl(ServerConnectionHandler* self);
+
+/**
+ * End the provisional mode. The origin validation of new updates is requested
+ * right away again. The updates received during the provisional mode must be
+ * validated after this call (see validateProvisionalUpdates).
+ *
+ * @param self The connection handler instance
+ *
+ * @since 0.4.1.0
+ */
+void endProvisionalMode(ServerConnectionHandler* self);
+
 /**
  * Sends a packet to all connected clients.
  *
@@ -0,0 +1,497 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "server/shared_roa.h"
+#include "util/log.h"
+
+#define HDR "([0x%08X] Shared ROA Table): "
+
+/**
+ * Return the ROAs of the given buffer.
+ *
+ * @param header The header of the segment.
+ * @param idx The index of the buffer.
+ *
+ * @return The ROAs.
+ */
+static inline SharedROA* _getROAs(SharedROAHeader* header, uint32_t idx)
+{
+  return (SharedROA*)(header + 1) + (size_t)idx * header->capacity;
+}
+
+/**
+ * Return the size of a segment with the given capacity.
+ *
+ * @param capacity The number of ROAs per buffer.
+ *
+ * @return The size in bytes.
+ */
+static inline size_t _getSegmentSize(uint32_t capacity)
+{
+  return sizeof(SharedROAHeader) + 2 * (size_t)capacity * sizeof(SharedROA);
+}
+
+/**
+ * Compare the prefixes of the two ROAs.
+ *
+ * @param roa1 The first ROA.
+ * @param roa2 The second ROA.
+ *
+ * @return <0, 0, or >0 like memcmp.
+ */
+static inline int _comparePrefix(const SharedROA* roa1, const SharedROA* roa2)
+{
+  if (roa1->family != roa2->family)
+  {
+    return (int)roa1->family - (int)roa2->family;
+  }
+  if (roa1->len != roa2->len)
+  {
+    return (int)roa1->len - (int)roa2->len;
+  }
+  return memcmp(roa1->addr, roa2->addr, sizeof(roa1->addr));
+}
+
+/**
+ * Compare two ROAs by prefix, origin AS, and max length. Used to sort the
+ * buffers.
+ *
+ * @param elem1 The first ROA.
+ * @param elem2 The second ROA.
+ *
+ * @return <0, 0, or >0 like memcmp.
+ */
+static int _compareROA(const void* elem1, const void* elem2)
+{
+  const SharedROA* roa1 = (const SharedROA*)elem1;
+  const SharedROA* roa2 = (const SharedROA*)elem2;
+  int              cmp  = _comparePrefix(roa1, roa2);
+
+  if (cmp != 0)
+  {
+    return cmp;
+  }
+  if (roa1->as != roa2->as)
+  {
+    return roa1->as < roa2->as ? -1 : 1;
+  }
+  return (int)roa1->max_len - (int)roa2->max_len;
+}
+
+/**
+ * Copy the address masked to the given prefix length.
+ *
+ * @param dest OUT - The masked address, 16 bytes.
+ * @param src The address.
+ * @param len The prefix length.
+ * @param bytes The number of address bytes, 4 or 16.
+ */
+static void _maskAddress(uint8_t* dest, const uint8_t* src, uint8_t len,
+                         int bytes)
+{
+  int idx;
+  int bits;
+
+  memset(dest, 0, 16);
+  for (idx = 0; idx < bytes; idx++)
+  {
+    bits = len - idx * 8;
+    if (bits <= 0)
+    {
+      break;
+    }
+    dest[idx] = bits >= 8 ? src[idx] : src[idx] & (uint8_t)(0xFF << (8 - bits));
+  }
+}
+
+/**
+ * Map the given segment.
+ *
+ * @param fd The file descriptor of the segment.
+ * @param size The size of the segment.
+ * @param prot The protection of the mapping.
+ * @param inode The inode of the segment.
+ *
+ * @return The mapping or NULL.
+ */
+static SharedROAMap* _mapSegment(int fd, size_t size, int prot, ino_t inode)
+{
+  SharedROAMap* map = malloc(sizeof(SharedROAMap));
+
+  if (map == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory to map the shared ROA table!");
+    return NULL;
+  }
+  map->header = mmap(NULL, size, prot, MAP_SHARED, fd, 0);
+  if (map->header == MAP_FAILED)
+  {
+    RAISE_SYS_ERROR("Could not map the shared ROA table (%s)!",
+                    strerror(errno));
+    free(map);
+    return NULL;
+  }
+  map->size  = size;
+  map->inode = inode;
+
+  return map;
+}
+
+/**
+ * Determine the validation state using the given buffer.
+ *
+ * @param buffer The state of the buffer.
+ * @param roas The ROAs of the buffer.
+ * @param count The number of ROAs.
+ * @param family The family of the prefix.
+ * @param addr The prefix address in network byte order.
+ * @param len The prefix length.
+ * @param as The origin AS.
+ *
+ * @return The validation state.
+ */
+static SRxValidationResultVal _lookupBuffer(SharedROABuffer* buffer,
+                                            SharedROA* roas, uint32_t count,
+                                            uint8_t family, const uint8_t* addr,
+                                            uint8_t len, uint32_t as)
+{
+  SRxValidationResultVal result = SRx_RESULT_NOTFOUND;
+  SharedROA              key;
+  uint32_t               low;
+  uint32_t               high;
+  uint32_t               mid;
+  int                    coverLen;
+
+  memset(&key, 0, sizeof(SharedROA));
+  key.family = family;
+  // Each covering prefix length is searched separately, most specific first.
+  for (coverLen = len; coverLen >= 0; coverLen--)
+  {
+    if (!buffer->hasLength[family][coverLen])
+    {
+      continue;
+    }
+    key.len = (uint8_t)coverLen;
+    _maskAddress(key.addr, addr, key.len, family == SHARED_ROA_V4 ? 4 : 16);
+
+    low  = 0;
+    high = count;
+    while (low < high)
+    {
+      mid = low + (high - low) / 2;
+      if (_comparePrefix(&roas[mid], &key) < 0)
+      {
+        low = mid + 1;
+      }
+      else
+      {
+        high = mid;
+      }
+    }
+    for (; (low < count) && (_comparePrefix(&roas[low], &key) == 0); low++)
+    {
+      // Any covering ROA makes the update at least invalid.
+      result = SRx_RESULT_INVALID;
+      if ((roas[low].as == as) && (len <= roas[low].max_len))
+      {
+        return SRx_RESULT_VALID;
+      }
+    }
+  }
+
+  return result;
+}
+
+bool createSharedROATable(SharedROATable* self, const char* name,
+                          uint32_t capacity)
+{
+  SharedROAMap* map  = NULL;
+  size_t        size = _getSegmentSize(capacity);
+  struct stat   segStat;
+  int           fd;
+
+  memset(self, 0, sizeof(SharedROATable));
+  self->name = malloc(strlen(name) + 1);
+  if (self->name == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the shared ROA table!");
+    return false;
+  }
+  strcpy(self->name, name);
+
+  // Attached processes keep the replaced segment until they refresh.
+  shm_unlink(name);
+  fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd == -1)
+  {
+    RAISE_SYS_ERROR("Could not create the shared ROA table '%s' (%s)!", name,
+                    strerror(errno));
+  }
+  else if ((ftruncate(fd, size) != 0) || (fstat(fd, &segStat) != 0))
+  {
+    RAISE_SYS_ERROR("Could not size the shared ROA table '%s' (%s)!", name,
+                    strerror(errno));
+  }
+  else
+  {
+    map = _mapSegment(fd, size, PROT_READ | PROT_WRITE, segStat.st_ino);
+  }
+  if (fd != -1)
+  {
+    close(fd);
+  }
+  if (map == NULL)
+  {
+    if (fd != -1)
+    {
+      shm_unlink(name);
+    }
+    free(self->name);
+    self->name = NULL;
+    return false;
+  }
+
+  // The segment is zeroed, the magic is written last to let readers know the
+  // header is complete.
+  map->header->format   = SHARED_ROA_FORMAT;
+  map->header->capacity = capacity;
+  __sync_synchronize();
+  map->header->magic    = SHARED_ROA_MAGIC;
+  self->map      = map;
+  self->readOnly = false;
+  LOG(LEVEL_INFO, HDR "Created '%s' for %u ROAs", pthread_self(), name,
+                  capacity);
+
+  return true;
+}
+
+bool attachSharedROATable(SharedROATable* self, const char* name)
+{
+  SharedROAMap* old;
+
+  memset(self, 0, sizeof(SharedROATable));
+  self->name = malloc(strlen(name) + 1);
+  if (self->name == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the shared ROA table!");
+    return false;
+  }
+  strcpy(self->name, name);
+  self->readOnly = true;
+
+  if (refreshSharedROATable(self, &old) == 0)
+  {
+    LOG(LEVEL_INFO, HDR "Nothing published in '%s' yet", pthread_self(),
+                    name);
+  }
+
+  return true;
+}
+
+void releaseSharedROATable(SharedROATable* self)
+{
+  if (self->map != NULL)
+  {
+    releaseSharedROAMap(self->map);
+    self->map = NULL;
+  }
+  free(self->name);
+  self->name = NULL;
+}
+
+void releaseSharedROAMap(void* map)
+{
+  if (map != NULL)
+  {
+    munmap(((SharedROAMap*)map)->header, ((SharedROAMap*)map)->size);
+    free(map);
+  }
+}
+
+SharedROA* beginSharedROAPublication(SharedROATable* self, uint32_t count)
+{
+  SharedROAHeader* header = self->map->header;
+  uint32_t         idx    = header->active ^ 1;
+
+  if (count > header->capacity)
+  {
+    RAISE_ERROR("The shared ROA table '%s' can not take %u ROAs, the capacity"
+                " is %u!", self->name, count, header->capacity);
+    return NULL;
+  }
+  // Readers still using the buffer repeat their lookup.
+  header->buffers[idx].seq++;
+  __sync_synchronize();
+
+  return _getROAs(header, idx);
+}
+
+uint64_t endSharedROAPublication(SharedROATable* self, uint32_t count)
+{
+  SharedROAHeader* header = self->map->header;
+  uint32_t         idx    = header->active ^ 1;
+  SharedROABuffer* buffer = &header->buffers[idx];
+  SharedROA*       roas   = _getROAs(header, idx);
+  uint32_t         kept   = 0;
+  uint32_t         roaIdx;
+
+  qsort(roas, count, sizeof(SharedROA), _compareROA);
+  memset(buffer->hasLength, 0, sizeof(buffer->hasLength));
+  for (roaIdx = 0; roaIdx < count; roaIdx++)
+  {
+    if (   (roas[roaIdx].family > SHARED_ROA_V6)
+        || (roas[roaIdx].len > 128))
+    {
+      continue;
+    }
+    if ((kept == 0) || (_compareROA(&roas[kept - 1], &roas[roaIdx]) != 0))
+    {
+      buffer->hasLength[roas[roaIdx].family][roas[roaIdx].len] = 1;
+      roas[kept++] = roas[roaIdx];
+    }
+  }
+  buffer->count = kept;
+  __sync_synchronize();
+  buffer->seq++;
+  __sync_synchronize();
+  header->active = idx;
+  __sync_synchronize();
+  header->generation++;
+
+  return header->generation;
+}
+
+uint64_t refreshSharedROATable(SharedROATable* self, SharedROAMap** old)
+{
+  SharedROAMap*    map = self->map;
+  SharedROAMap*    newMap;
+  SharedROAHeader* header;
+  struct stat      segStat;
+  int              fd;
+
+  *old = NULL;
+  fd   = shm_open(self->name, O_RDONLY, 0);
+  if (fd != -1)
+  {
+    if (   (fstat(fd, &segStat) == 0)
+        && ((map == NULL) || (segStat.st_ino != map->inode))
+        && (segStat.st_size >= sizeof(SharedROAHeader)))
+    {
+      newMap = _mapSegment(fd, segStat.st_size, PROT_READ, segStat.st_ino);
+      header = newMap != NULL ? newMap->header : NULL;
+      // A segment still being created is mapped with the next refresh.
+      if (   (header != NULL) && (header->magic == SHARED_ROA_MAGIC)
+          && (header->format == SHARED_ROA_FORMAT)
+          && (_getSegmentSize(header->capacity) <= newMap->size))
+      {
+        LOG(LEVEL_INFO, HDR "Attached '%s' with %u ROAs per buffer",
+                        pthread_self(), self->name, header->capacity);
+        *old      = map;
+        self->map = map = newMap;
+      }
+      else
+      {
+        releaseSharedROAMap(newMap);
+      }
+    }
+    close(fd);
+  }
+
+  return map != NULL ? map->header->generation : 0;
+}
+
+bool lookupSharedROATable(SharedROATable* self, uint8_t family,
+                          const uint8_t* addr, uint8_t len, uint32_t as,
+                          SRxValidationResultVal* result)
+{
+  SharedROAMap*          map = self->map;
+  SharedROAHeader*       header;
+  SharedROABuffer*       buffer;
+  SRxValidationResultVal state;
+  uint32_t               idx;
+  uint32_t               seq;
+  uint32_t               count;
+  int                    tries;
+
+  if (   (map == NULL) || (family > SHARED_ROA_V6)
+      || (len > (family == SHARED_ROA_V4 ? 32 : 128)))
+  {
+    return false;
+  }
+  header = map->header;
+
+  for (tries = 0; tries < SHARED_ROA_RETRIES; tries++)
+  {
+    if (header->generation == 0)
+    {
+      return false;
+    }
+    idx    = header->active & 1;
+    buffer = &header->buffers[idx];
+    seq    = buffer->seq;
+    __sync_synchronize();
+    if ((seq & 1) != 0)
+    {
+      continue;
+    }
+    // The count might be written concurrently, stay within the buffer.
+    count = buffer->count;
+    if (count > header->capacity)
+    {
+      count = header->capacity;
+    }
+    state = _lookupBuffer(buffer, _getROAs(header, idx), count, family, addr,
+                          len, as);
+    __sync_synchronize();
+    if (buffer->seq == seq)
+    {
+      *result = state;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+uint32_t getSharedROACount(SharedROATable* self)
+{
+  SharedROAMap* map = self->map;
+
+  return (map != NULL) && (map->header->generation > 0)
+         ? map->header->buffers[map->header->active & 1].count
+         : 0;
+}
@@ -0,0 +1,228 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * A ROA white-list published in a shared memory segment. One SRx server
+ * maintains the white-list of its validation caches and publishes it, other
+ * SRx server processes map the segment read-only and validate the origin of
+ * their updates without keeping a copy of the white-list and without a
+ * session of their own.
+ *
+ * The segment holds two buffers of ROAs sorted by family, prefix length, and
+ * address. The publisher writes the buffer readers do not use and switches
+ * the readers over to it, each publication increments the generation of the
+ * table. Each buffer has a sequence number that is odd while the buffer is
+ * written, readers do not lock and repeat a lookup that overlapped with a
+ * write of its buffer.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __SHARED_ROA_H__
+#define __SHARED_ROA_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "shared/srx_defs.h"
+
+/** Identifies a shared ROA segment ("SROA"). */
+#define SHARED_ROA_MAGIC   0x53524F41
+/** The format of the segment, increased with each incompatible change. */
+#define SHARED_ROA_FORMAT  1
+/** The number of attempts of a lookup that overlaps with publications. */
+#define SHARED_ROA_RETRIES 16
+
+/** The family of an IPv4 ROA. */
+#define SHARED_ROA_V4 0
+/** The family of an IPv6 ROA. */
+#define SHARED_ROA_V6 1
+
+/** A single ROA within a buffer. */
+typedef struct {
+  /** The prefix address in network byte order, IPv4 uses the first 4 bytes.
+   * The bits beyond the prefix length are 0. */
+  uint8_t  addr[16];
+  /** The origin AS. */
+  uint32_t as;
+  /** The family, SHARED_ROA_V4 or SHARED_ROA_V6. */
+  uint8_t  family;
+  /** The prefix length. */
+  uint8_t  len;
+  /** The max length. */
+  uint8_t  max_len;
+  /** Unused, 0. */
+  uint8_t  reserved;
+} SharedROA;
+
+/** The state of a buffer. */
+typedef struct {
+  /** Odd while the buffer is written. */
+  volatile uint32_t seq;
+  /** The number of ROAs in the buffer. */
+  uint32_t          count;
+  /** Set for each prefix length of a family the buffer has ROAs of. */
+  uint8_t           hasLength[2][129];
+} SharedROABuffer;
+
+/** The header of the segment, the two buffers of ROAs follow. */
+typedef struct {
+  /** SHARED_ROA_MAGIC */
+  uint32_t          magic;
+  /** SHARED_ROA_FORMAT */
+  uint32_t          format;
+  /** The number of ROAs each buffer can take. */
+  uint32_t          capacity;
+  /** The buffer the readers use. */
+  volatile uint32_t active;
+  /** The number of publications, 0 if nothing is published yet. */
+  volatile uint64_t generation;
+  /** The state of the buffers. */
+  SharedROABuffer   buffers[2];
+} SharedROAHeader;
+
+/** A mapping of the segment. */
+typedef struct {
+  /** The mapped segment. */
+  SharedROAHeader* header;
+  /** The size of the mapping. */
+  size_t           size;
+  /** The inode of the segment, a new segment under the same name has
+   * another one. */
+  ino_t            inode;
+} SharedROAMap;
+
+/** The published or attached ROA table. */
+typedef struct {
+  /** The current mapping, NULL if none. */
+  SharedROAMap* volatile map;
+  /** The name of the segment. */
+  char*                  name;
+  /** Set if the table is attached read-only. */
+  bool                   readOnly;
+} SharedROATable;
+
+/**
+ * Create the segment with the given name and map it for the publication. An
+ * existing segment with the name is replaced, processes that attached it
+ * switch to the new segment with refreshSharedROATable.
+ *
+ * @param self The table.
+ * @param name The name of the segment, e.g. "/srx_roas".
+ * @param capacity The maximum number of ROAs that can be published.
+ *
+ * @return false if the segment could not be created.
+ */
+bool createSharedROATable(SharedROATable* self, const char* name,
+                          uint32_t capacity);
+
+/**
+ * Map the segment with the given name read-only. The segment does not need
+ * to exist yet, the table is mapped once it does by refreshSharedROATable.
+ *
+ * @param self The table.
+ * @param name The name of the segment.
+ *
+ * @return false if the table could not be initialized.
+ */
+bool attachSharedROATable(SharedROATable* self, const char* name);
+
+/**
+ * Unmap the segment, the segment itself stays for the attached processes. No
+ * lookup must be running.
+ *
+ * @param self The table.
+ */
+void releaseSharedROATable(SharedROATable* self);
+
+/**
+ * Unmap the given mapping and free it.
+ *
+ * @param map The mapping.
+ */
+void releaseSharedROAMap(void* map);
+
+/**
+ * Start a publication. The returned buffer is filled by the caller with the
+ * ROAs in any order and published with endSharedROAPublication.
+ *
+ * @param self The published table.
+ * @param count The number of ROAs.
+ *
+ * @return The buffer or NULL if the ROAs exceed the capacity.
+ */
+SharedROA* beginSharedROAPublication(SharedROATable* self, uint32_t count);
+
+/**
+ * Sort the ROAs of the buffer returned by beginSharedROAPublication, drop
+ * duplicates, and switch the readers over to the buffer.
+ *
+ * @param self The published table.
+ * @param count The number of ROAs written into the buffer.
+ *
+ * @return The generation of the publication.
+ */
+uint64_t endSharedROAPublication(SharedROATable* self, uint32_t count);
+
+/**
+ * Map the segment if it was created or replaced since the last call. The
+ * replaced mapping is returned and must be released with releaseSharedROAMap
+ * once no lookup can use it anymore. Must not be called concurrently.
+ *
+ * @param self The attached table.
+ * @param old OUT - The replaced mapping or NULL.
+ *
+ * @return The generation of the mapped table, 0 if nothing is published.
+ */
+uint64_t refreshSharedROATable(SharedROATable* self, SharedROAMap** old);
+
+/**
+ * Determine the origin validation state of the given prefix and origin AS.
+ * Does not lock. The mapping must not be released during the call.
+ *
+ * @param self The table.
+ * @param family SHARED_ROA_V4 or SHARED_ROA_V6.
+ * @param addr The prefix address in network byte order.
+ * @param len The prefix length.
+ * @param as The origin AS.
+ * @param result OUT - The validation state.
+ *
+ * @return false if nothing is published or the lookup overlapped with too
+ *         many publications.
+ */
+bool lookupSharedROATable(SharedROATable* self, uint8_t family,
+                          const uint8_t* addr, uint8_t len, uint32_t as,
+                          SRxValidationResultVal* result);
+
+/**
+ * Return the number of ROAs readers currently use.
+ *
+ * @param self The table.
+ *
+ * @return The number of ROAs.
+ */
+uint32_t getSharedROACount(SharedROATable* self);
+
+#endif // !__SHARED_ROA_H__
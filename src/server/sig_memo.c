@@ -0,0 +1,201 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Bounded memo of signature verification results.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "server/sig_memo.h"
+#include "util/log.h"
+
+/**
+ * Select the set of the given key. The key is a digest, its leading bytes 
+ * are distributed uniformly.
+ *
+ * @param self The memo.
+ * @param key The key.
+ *
+ * @return The set index.
+ */
+static inline uint32_t _setIndex(SigMemo* self, const uint8_t* key)
+{
+  uint32_t hash = ((uint32_t)key[0] << 24) | ((uint32_t)key[1] << 16)
+                  | ((uint32_t)key[2] << 8) | key[3];
+
+  return hash & (self->noSets - 1);
+}
+
+/**
+ * Initialize the memo.
+ *
+ * @param self The memo.
+ * @param maxEntries The maximum number of entries, rounded down to a power of 
+ *                   two sets. 0 disables the memo.
+ *
+ * @return false if not enough memory was available, the memo is disabled.
+ */
+bool initSigMemo(SigMemo* self, uint32_t maxEntries)
+{
+  uint32_t noSets = 1;
+  int      idx;
+
+  memset(self, 0, sizeof(SigMemo));
+  if (maxEntries < SIG_MEMO_WAYS)
+  {
+    return true;
+  }
+  while (noSets * 2 <= maxEntries / SIG_MEMO_WAYS)
+  {
+    noSets *= 2;
+  }
+
+  self->sets = calloc(noSets, sizeof(SigMemoSet));
+  if (self->sets == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the signature memo!");
+    return false;
+  }
+  self->noSets = noSets;
+  for (idx = 0; idx < SIG_MEMO_LOCKS; idx++)
+  {
+    initMutex(&self->locks[idx]);
+  }
+
+  return true;
+}
+
+/**
+ * Release the memo.
+ *
+ * @param self The memo.
+ */
+void releaseSigMemo(SigMemo* self)
+{
+  int idx;
+
+  if (self->sets != NULL)
+  {
+    for (idx = 0; idx < SIG_MEMO_LOCKS; idx++)
+    {
+      releaseMutex(&self->locks[idx]);
+    }
+    free(self->sets);
+    self->sets   = NULL;
+    self->noSets = 0;
+  }
+}
+
+/**
+ * Look up the result of a verification.
+ *
+ * @param self The memo.
+ * @param key The digest identifying the verification (SIG_MEMO_KEY_LENGTH).
+ * @param valid OUT - The memorized result.
+ *
+ * @return false if the verification is not memorized.
+ */
+bool lookupSigMemo(SigMemo* self, const uint8_t* key, bool* valid)
+{
+  SigMemoSet* set;
+  uint32_t    setIdx;
+  int         idx;
+  bool        found = false;
+
+  if (self->sets == NULL)
+  {
+    return false;
+  }
+
+  setIdx = _setIndex(self, key);
+  set    = &self->sets[setIdx];
+  lockMutex(&self->locks[setIdx & (SIG_MEMO_LOCKS - 1)]);
+  for (idx = 0; (idx < SIG_MEMO_WAYS) && !found; idx++)
+  {
+    if (   set->entries[idx].used
+        && (memcmp(set->entries[idx].key, key, SIG_MEMO_KEY_LENGTH) == 0))
+    {
+      *valid = set->entries[idx].valid;
+      found  = true;
+    }
+  }
+  unlockMutex(&self->locks[setIdx & (SIG_MEMO_LOCKS - 1)]);
+
+  if (found)
+  {
+    __sync_add_and_fetch(&self->hits, 1);
+  }
+  else
+  {
+    __sync_add_and_fetch(&self->misses, 1);
+  }
+
+  return found;
+}
+
+/**
+ * Memorize the result of a verification.
+ *
+ * @param self The memo.
+ * @param key The digest identifying the verification (SIG_MEMO_KEY_LENGTH).
+ * @param valid The result.
+ */
+void storeSigMemo(SigMemo* self, const uint8_t* key, bool valid)
+{
+  SigMemoSet*   set;
+  SigMemoEntry* entry = NULL;
+  uint32_t      setIdx;
+  int           idx;
+
+  if (self->sets == NULL)
+  {
+    return;
+  }
+
+  setIdx = _setIndex(self, key);
+  set    = &self->sets[setIdx];
+  lockMutex(&self->locks[setIdx & (SIG_MEMO_LOCKS - 1)]);
+  // Another worker might have stored the same verification meanwhile.
+  for (idx = 0; (idx < SIG_MEMO_WAYS) && (entry == NULL); idx++)
+  {
+    if (   set->entries[idx].used
+        && (memcmp(set->entries[idx].key, key, SIG_MEMO_KEY_LENGTH) == 0))
+    {
+      entry = &set->entries[idx];
+    }
+  }
+  if (entry == NULL)
+  {
+    entry     = &set->entries[set->next];
+    set->next = (set->next + 1) % SIG_MEMO_WAYS;
+    memcpy(entry->key, key, SIG_MEMO_KEY_LENGTH);
+    entry->used = true;
+  }
+  entry->valid = valid;
+  unlockMutex(&self->locks[setIdx & (SIG_MEMO_LOCKS - 1)]);
+}
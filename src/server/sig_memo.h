@@ -0,0 +1,124 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Bounded memo of signature verification results. An entry is identified by
+ * a SHA-256 digest over the router key (serial, AS, SKI), the digest of the
+ * signed data and the signature, see BGPSecHandler. The memo is set
+ * associative: the leading bytes of the digest select a set of 
+ * SIG_MEMO_WAYS entries, a full set replaces its entries round robin. The
+ * sets are protected by striped locks.
+ *
+ * The memo is never flushed. A withdrawn router key that is stored again 
+ * gets a new serial, the entries of the old key are not found anymore and 
+ * are replaced over time.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __SIG_MEMO_H__
+#define __SIG_MEMO_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "util/mutex.h"
+
+/** The length of the entry key. */
+#define SIG_MEMO_KEY_LENGTH 32
+/** The number of entries per set. */
+#define SIG_MEMO_WAYS       4
+/** The number of locks, a power of two. */
+#define SIG_MEMO_LOCKS      64
+
+/** A single memo entry. */
+typedef struct {
+  /** The digest identifying the verification. */
+  uint8_t key[SIG_MEMO_KEY_LENGTH];
+  /** The entry is in use. */
+  bool    used;
+  /** The signature was verified. */
+  bool    valid;
+} SigMemoEntry;
+
+/** A set of entries. */
+typedef struct {
+  SigMemoEntry entries[SIG_MEMO_WAYS];
+  /** The entry replaced next. */
+  uint8_t      next;
+} SigMemoSet;
+
+/** The signature memo. */
+typedef struct {
+  /** The sets, NULL if the memo is disabled. */
+  SigMemoSet*       sets;
+  /** The number of sets, a power of two. */
+  uint32_t          noSets;
+  /** The locks, the set index selects the lock. */
+  Mutex             locks[SIG_MEMO_LOCKS];
+  /** The number of lookups answered. */
+  volatile uint64_t hits;
+  /** The number of lookups not answered. */
+  volatile uint64_t misses;
+} SigMemo;
+
+/**
+ * Initialize the memo.
+ *
+ * @param self The memo.
+ * @param maxEntries The maximum number of entries, rounded down to a power of 
+ *                   two sets. 0 disables the memo.
+ *
+ * @return false if not enough memory was available, the memo is disabled.
+ */
+bool initSigMemo(SigMemo* self, uint32_t maxEntries);
+
+/**
+ * Release the memo.
+ *
+ * @param self The memo.
+ */
+void releaseSigMemo(SigMemo* self);
+
+/**
+ * Look up the result of a verification.
+ *
+ * @param self The memo.
+ * @param key The digest identifying the verification (SIG_MEMO_KEY_LENGTH).
+ * @param valid OUT - The memorized result.
+ *
+ * @return false if the verification is not memorized.
+ */
+bool lookupSigMemo(SigMemo* self, const uint8_t* key, bool* valid);
+
+/**
+ * Memorize the result of a verification.
+ *
+ * @param self The memo.
+ * @param key The digest identifying the verification (SIG_MEMO_KEY_LENGTH).
+ * @param valid The result.
+ */
+void storeSigMemo(SigMemo* self, const uint8_t* key, bool valid);
+
+#endif // !__SIG_MEMO_H__
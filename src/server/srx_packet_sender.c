@@ -22,11 +22,35 @@
  *
  * This file contains the functions to send srx-proxy packets.
  * 
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * 
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added flags parameter to sendHelloResponse.
+ *            * Replaced the global packet list of the send queue with per 
+ *              client output buffers. Queued packets are coalesced and 
+ *              written without blocking, a slow client does not stall the 
+ *              others.
+ *            * Added sendPacketToProxy and releaseClientSendBuffer.
+ *            * Record the socket send time and the send queue size.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added getSendQueueSize.
+ *            * The send queue thread is placed and named by createThread.
+ *            * The output buffer of a client is bounded, a sender waits for
+ *              the queue thread to make room and drops the packet if the
+ *              client does not drain its buffer in time.
+ *            * Added sendFlowControl.
+ *            * Trace the verify notifications of sampled updates.
+ *            * Name the send queue mutex for the lock statistics.
+ *            * Account the send buffers under MEM_TAG_SEND_QUEUE.
+ *            * Adaptive batching: a client that does not drain its data as
+ *              fast as it is queued is collected once its batch reaches the
+ *              byte threshold or its oldest packet the time budget, an idle
+ *              client is still written right away. Added setSendBatching
+ *              and getClientSendStats. The queue thread waits without
+ *              timeout if nothing is pending.
  * 0.3.0.10 - 2015/11/10 - oborchert
  *            * Fixed assignment bug in stopSendQueue
  *            * Added return value (NULL) to sendQueueThreadLoop
@@ -39,57 +63,116 @@
  * 0.1.0    - 2011/11/01 - oborchert
  *            * File Created.
  */
+#include <errno.h>
+#include <poll.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
 #include "server/srx_packet_sender.h"
+#include "server/stage_stats.h"
 #include "shared/srx_packets.h"
+#include "util/lock_stats.h"
 #include "util/log.h"
+#include "util/mem_stats.h"
 #include "util/mutex.h"
 #include "util/server_socket.h"
+#include "util/thread.h"
 
-typedef struct {
-  // The pdu to be send
-  uint8_t*      pdu;    
-  // The size of the pdu
-  size_t        size;
+/**
+ * The output buffer of a single client. Packets are appended to the fill 
+ * buffer. The send queue thread swaps it with the out buffer and writes the
+ * out buffer with as few system calls as possible.
+ */
+typedef struct _SendBuffer {
   // The server socket to send from
-  ServerSocket* srcSock;
+  ServerSocket*       srvSock;
   // The client to send to
-  ServerClient* client;
-  // The next packet in the queue
-  void*         next; 
-} SendPacket;
+  ServerClient*       client;
+  // The packets queued since the last swap
+  uint8_t*            fill;
+  // The number of bytes in the fill buffer
+  size_t              fillSize;
+  // The capacity of the fill buffer
+  size_t              fillCapacity;
+  // The packets currently written by the send queue thread
+  uint8_t*            out;
+  // The number of bytes in the out buffer
+  size_t              outSize;
+  // The number of bytes of the out buffer already written
+  size_t              outSent;
+  // The capacity of the out buffer
+  size_t              outCapacity;
+  // Set while the queue thread writes the out buffer without holding the mutex
+  bool                flushing;
+  // The number of threads currently sending directly to this client
+  int                 directSending;
+  // The number of threads waiting for room in the fill buffer
+  int                 waiters;
+  // Set once the buffer is about to be released, waiting senders give up
+  bool                closing;
+  // The time (ns) the first packet was added to the empty fill buffer
+  uint64_t            fillSince;
+  // The number of packets in the fill buffer
+  uint32_t            fillPackets;
+  // Set while the client does not drain its data as fast as it is queued,
+  // its fill buffer is then collected in batches.
+  bool                batching;
+  // Set by the queue thread if the last flush blocked
+  bool                blocked;
+  // The batches written to the client
+  SendBatchStats      stats;
+  // The next buffer
+  struct _SendBuffer* next;
+} SendBuffer;
 
 typedef struct {
-  // the head element of the queue
-  SendPacket* head;
-  // the tail element of the queue
-  SendPacket* tail;
-  // the size of the queue
-  int        size;
+  // The output buffers of all clients
+  SendBuffer* buffers;
+  // The number of bytes queued in all fill buffers
+  size_t      size;
+  // Set when packets were queued since the queue thread last collected them
+  bool        newData;
   // the queue handler itself
-  pthread_t handler;
+  pthread_t   handler;
   // indicates if the queue is running.
   bool        running;
   // Mutex and Condition for thread handling
   Mutex       mutex;
   Cond        condition;
-  
+  // Signaled each time a flush or a direct send is completed
+  Cond        flushed;
+  // The time (ns) the packets of a batching client may wait, 0 = no batching
+  uint64_t    batchDelay;
+  // The number of bytes that completes the batch of a client
+  size_t      batchBytes;
 } SendPacketQueue;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Packet Sending Queue
 ////////////////////////////////////////////////////////////////////////////////
 
-// wait until notify or 1 s timeout - this is just to allow a wakeup
-#define SEND_QUEUE_WAIT_MS 1000
+// The time to wait for a blocked client socket before all buffers are checked
+// again.
+#define SEND_QUEUE_RETRY_MS 10
+// The maximum number of client buffers written in one round.
+#define SEND_QUEUE_MAX_FLUSH 256
+// The initial size of a client output buffer
+#define SEND_BUFFER_INITIAL_SIZE 4096
+// The maximum number of bytes queued in the fill buffer of a client
+#define SEND_BUFFER_MAX_SIZE (64 * 1024 * 1024)
+// The time a sender waits for room in a full client buffer before the packet
+// is dropped.
+#define SEND_BUFFER_FULL_TIMEOUT_MS 5000
+// The default time in microseconds the packets of a batching client may wait
+#define SEND_BATCH_DEFAULT_DELAY_US 200
+// The default number of bytes that completes the batch of a client
+#define SEND_BATCH_DEFAULT_BYTES (64 * 1024)
 
 // The send queue 
 static SendPacketQueue* SEND_QUEUE = NULL;
 
-// Forward declaration
-SendPacket* fetchSendPacket();
-
 /**
  * Create the sender queue including the thread that manages the queue.
  * 
@@ -102,10 +185,12 @@ bool createSendQueue()
   SendPacketQueue* queue = malloc(sizeof(SendPacketQueue));
   if (queue != NULL)
   {
-    queue->head    = NULL;
-    queue->tail    = NULL;
+    queue->buffers = NULL;
     queue->size    = 0;
+    queue->newData = false;
     queue->running = false;
+    queue->batchDelay = SEND_BATCH_DEFAULT_DELAY_US * 1000ULL;
+    queue->batchBytes = SEND_BATCH_DEFAULT_BYTES;
     
     if (initMutex(&queue->mutex))
     {
@@ -115,18 +200,46 @@ bool createSendQueue()
         free(queue);
         queue = NULL;
       }
+      else if (!initCond(&queue->flushed))
+      {
+        destroyCond(&queue->condition);
+        releaseMutex(&queue->mutex);
+        free(queue);
+        queue = NULL;
+      }
     }
     else
     {
       free(queue);
       queue = NULL;
     }    
+    if (queue != NULL)
+    {
+      setLockName(&queue->mutex, "sendQueue.mutex");
+    }
     SEND_QUEUE = queue;
   }
     
   return queue != NULL;
 }
 
+/**
+ * Free the given client output buffer.
+ * 
+ * @param buffer The buffer to be freed.
+ * 
+ * @since 0.4.1.0
+ */
+static void _freeSendBuffer(SendBuffer* buffer)
+{
+  addMemStats(MEM_TAG_SEND_QUEUE, -(int64_t)(sizeof(SendBuffer)
+                                             + buffer->fillCapacity
+                                             + buffer->outCapacity), -1);
+  free(buffer->fill);
+  free(buffer->out);
+  free(buffer);
+}
+
 /**
  * Stops the queue is not already stopped and frees all memory associated with 
  * it.
@@ -144,12 +257,13 @@ void releaseSendQueue()
       // Stops and cleans the queue
       stopSendQueue(SEND_QUEUE);
     }
-    if (SEND_QUEUE->head != NULL)
+    if (SEND_QUEUE->buffers != NULL)
     {
       RAISE_SYS_ERROR("Queue should be already empty!");
     }
     releaseMutex(&SEND_QUEUE->mutex);
     destroyCond(&SEND_QUEUE->condition);
+    destroyCond(&SEND_QUEUE->flushed);
     free (SEND_QUEUE);
     SEND_QUEUE = NULL;
     
@@ -157,8 +271,314 @@ void releaseSendQueue()
   }  
 }
 
+/**
+ * Return the number of bytes waiting in the send queue. This function does 
+ * not lock the queue.
+ * 
+ * @return The number of bytes queued, 0 if no send queue exists.
+ * 
+ * @since 0.4.1.0
+ */
+size_t getSendQueueSize()
+{
+  SendPacketQueue* queue = SEND_QUEUE;
+  
+  return queue != NULL ? queue->size : 0;
+}
+
+/**
+ * Configure the batching of clients that do not drain their data as fast as
+ * it is queued. The data of such a client is written once it reaches the
+ * given number of bytes or its oldest packet waited the given time. Idle
+ * clients are always written right away.
+ *
+ * @param delayMicros The time in microseconds the packets of a batching client
+ *                    may wait, 0 disables the batching.
+ * @param maxBytes The number of bytes that completes a batch.
+ *
+ * @since 0.4.1.0
+ */
+void setSendBatching(uint32_t delayMicros, size_t maxBytes)
+{
+  SendPacketQueue* queue = SEND_QUEUE;
+
+  if (queue != NULL)
+  {
+    lockMutex(&queue->mutex);
+    queue->batchDelay = delayMicros * 1000ULL;
+    queue->batchBytes = maxBytes;
+    signalCond(&queue->condition);
+    unlockMutex(&queue->mutex);
+  }
+}
+
+/**
+ * Return the batch statistics of the given client.
+ *
+ * @param client The client.
+ * @param stats OUT - The statistics.
+ *
+ * @return false if the send queue has no output buffer for the client.
+ *
+ * @since 0.4.1.0
+ */
+bool getClientSendStats(ServerClient* client, SendBatchStats* stats)
+{
+  SendPacketQueue* queue = SEND_QUEUE;
+  SendBuffer*      buffer;
+  bool             found = false;
+
+  if (queue != NULL)
+  {
+    lockMutex(&queue->mutex);
+    for (buffer = queue->buffers; buffer != NULL; buffer = buffer->next)
+    {
+      if (buffer->client == client)
+      {
+        *stats = buffer->stats;
+        stats->batching = buffer->batching;
+        found = true;
+        break;
+      }
+    }
+    unlockMutex(&queue->mutex);
+  }
+
+  return found;
+}
+
+/**
+ * Return the output buffer of the given client.
+ * 
+ * @note The queue mutex must be held.
+ * 
+ * @param queue The send queue
+ * @param srvSoc The server socket to be used for sending
+ * @param client The client
+ * @param create Create the buffer if it does not exist.
+ * 
+ * @return The buffer or NULL if not found or not enough memory.
+ * 
+ * @since 0.4.1.0
+ */
+static SendBuffer* _getSendBuffer(SendPacketQueue* queue, ServerSocket* srvSoc,
+                                  ServerClient* client, bool create)
+{
+  SendBuffer* buffer = queue->buffers;
+  
+  while ((buffer != NULL) && (buffer->client != client))
+  {
+    buffer = buffer->next;
+  }
+  
+  if ((buffer == NULL) && create)
+  {
+    buffer = malloc(sizeof(SendBuffer));
+    if (buffer != NULL)
+    {
+      memset(buffer, 0, sizeof(SendBuffer));
+      addMemStats(MEM_TAG_SEND_QUEUE, sizeof(SendBuffer), 1);
+      buffer->srvSock = srvSoc;
+      buffer->client  = client;
+      buffer->next    = queue->buffers;
+      queue->buffers  = buffer;
+    }
+  }
+  
+  return buffer;
+}
+
+/**
+ * Indicates if the buffer still contains data that was not written yet or is
+ * currently written.
+ * 
+ * @note The queue mutex must be held.
+ * 
+ * @param buffer The client output buffer.
+ * 
+ * @return true if data is pending.
+ * 
+ * @since 0.4.1.0
+ */
+static bool _hasPendingData(SendBuffer* buffer)
+{
+  return    buffer->flushing || (buffer->fillSize > 0) 
+         || (buffer->outSent < buffer->outSize);
+}
+
+/**
+ * Append a copy of the packet to the fill buffer of the client.
+ * 
+ * @note The queue mutex must be held.
+ * 
+ * @param buffer The client output buffer.
+ * @param pdu The packet to be added.
+ * @param size The size of the packet.
+ * 
+ * @return false if the buffer could not be extended.
+ * 
+ * @since 0.4.1.0
+ */
+static bool _appendToSendBuffer(SendBuffer* buffer, void* pdu, size_t size)
+{
+  if (buffer->fillSize + size > buffer->fillCapacity)
+  {
+    size_t newCapacity = buffer->fillCapacity == 0 ? SEND_BUFFER_INITIAL_SIZE 
+                                                   : buffer->fillCapacity;
+    while (newCapacity < buffer->fillSize + size)
+    {
+      newCapacity *= 2;
+    }
+    uint8_t* fill = realloc(buffer->fill, newCapacity);
+    if (fill == NULL)
+    {
+      return false;
+    }
+    addMemStats(MEM_TAG_SEND_QUEUE, newCapacity - buffer->fillCapacity, 0);
+    buffer->fill         = fill;
+    buffer->fillCapacity = newCapacity;
+  }
+  memcpy(buffer->fill + buffer->fillSize, pdu, size);
+  buffer->fillSize += size;
+  
+  return true;
+}
+
+/**
+ * Write as much of the out buffer as the client socket accepts without 
+ * blocking.
+ * 
+ * @note Called without holding the queue mutex, the buffer is marked as 
+ *       flushing.
+ * 
+ * @param buffer The client output buffer.
+ * 
+ * @return 1 if the out buffer is written completely, 0 if the socket would 
+ *         block and -1 if the data could not be send and got dropped.
+ * 
+ * @since 0.4.1.0
+ */
+static int _flushSendBuffer(SendBuffer* buffer)
+{
+  ClientThread* clt = (ClientThread*)buffer->client;
+  ssize_t       sent;
+  
+  while (buffer->outSent < buffer->outSize)
+  {
+    if (!clt->active)
+    {
+      RAISE_ERROR("Trying to send a packet over an inactive connection");
+      buffer->outSent = buffer->outSize;
+      return -1;
+    }
+    sent = send(clt->clientFD, buffer->out + buffer->outSent, 
+                buffer->outSize - buffer->outSent, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent > 0)
+    {
+      buffer->outSent += sent;
+    }
+    else if ((sent < 0) && (errno == EINTR))
+    {
+      continue;
+    }
+    else if ((sent < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+    {
+      return 0;
+    }
+    else
+    {
+      RAISE_SYS_ERROR("Could not send %u queued bytes to client!", 
+                      buffer->outSize - buffer->outSent);
+      buffer->outSent = buffer->outSize;
+      return -1;
+    }
+  }
+  
+  return 1;
+}
+
+/**
+ * Determine if the fill buffer of a batching client should wait for more
+ * packets. It waits until it holds the batch bytes or its oldest packet
+ * waited the batch delay, nobody waits for room in it meanwhile.
+ *
+ * @note The queue mutex must be held.
+ *
+ * @param queue The send queue
+ * @param buffer The client output buffer with a non empty fill buffer.
+ * @param now The current time (ns).
+ * @param wakeup IN/OUT - The earliest time (ns) a deferred batch is due, 0 if
+ *               none is deferred.
+ *
+ * @return true if the fill buffer is not collected yet.
+ *
+ * @since 0.4.1.0
+ */
+static bool _deferBatch(SendPacketQueue* queue, SendBuffer* buffer,
+                        uint64_t now, uint64_t* wakeup)
+{
+  uint64_t due = buffer->fillSince + queue->batchDelay;
+
+  if (   !buffer->batching || (queue->batchDelay == 0)
+      || (buffer->fillSize >= queue->batchBytes) || (buffer->waiters > 0)
+      || (now >= due))
+  {
+    return false;
+  }
+  if ((*wakeup == 0) || (due < *wakeup))
+  {
+    *wakeup = due;
+  }
+
+  return true;
+}
+
+/**
+ * Swap the fill and the out buffer of the client and record the batch.
+ *
+ * @note The queue mutex must be held and the out buffer is written
+ *       completely.
+ *
+ * @param queue The send queue
+ * @param buffer The client output buffer.
+ *
+ * @since 0.4.1.0
+ */
+static void _collectBatch(SendPacketQueue* queue, SendBuffer* buffer)
+{
+  uint8_t* swap         = buffer->out;
+  size_t   swapCapacity = buffer->outCapacity;
+
+  // More than one packet arrived while the last batch was written, the
+  // client does not keep up with its data.
+  if (buffer->fillPackets > 1)
+  {
+    buffer->batching = true;
+  }
+  buffer->stats.noBatches++;
+  buffer->stats.noPackets += buffer->fillPackets;
+  buffer->stats.noBytes   += buffer->fillSize;
+  if (buffer->fillPackets > buffer->stats.maxPackets)
+  {
+    buffer->stats.maxPackets = buffer->fillPackets;
+  }
+
+  buffer->out          = buffer->fill;
+  buffer->outCapacity  = buffer->fillCapacity;
+  buffer->outSize      = buffer->fillSize;
+  buffer->outSent      = 0;
+  buffer->fill         = swap;
+  buffer->fillCapacity = swapCapacity;
+  queue->size         -= buffer->fillSize;
+  buffer->fillSize     = 0;
+  buffer->fillPackets  = 0;
+}
+
 /** 
  * The thread loop of the queue. To stop the queue call stopSendQueue()
+ * Each round all client buffers with pending data are written. A client that
+ * does not accept data keeps its remainder while the other clients are served.
+ * The data of a batching client is collected once its batch is complete.
  * 
  * @param notused - Not Used
  * 
@@ -175,23 +595,115 @@ void* sendQueueThreadLoop(void* notused)
   }
   else
   {
-    SendPacket* packet = NULL;
+    SendBuffer*   work[SEND_QUEUE_MAX_FLUSH];
+    struct pollfd blocked[SEND_QUEUE_MAX_FLUSH];
+    SendBuffer*   buffer;
+    int           noWork;
+    int           noBlocked;
+    int           idx;
+    int           timeout;
+    uint64_t      start;
+    uint64_t      now;
+    uint64_t      wakeup;
+    
     LOG(LEVEL_DEBUG, "Enter sendqueue loop.");
+    lockMutex(&queue->mutex);
     while (queue->running)
     {
-      packet = fetchSendPacket(queue);
-      if (packet != NULL)
+      // Collect the buffers to be written, swap the fill and out buffers of
+      // the ones whose out buffer is written completely.
+      noWork = 0;
+      wakeup = 0;
+      now    = getStageTime();
+      queue->newData = false;
+      for (buffer = queue->buffers; 
+           (buffer != NULL) && (noWork < SEND_QUEUE_MAX_FLUSH); 
+           buffer = buffer->next)
+      {
+        if (buffer->directSending > 0)
+        {
+          continue;
+        }
+        if (buffer->outSent == buffer->outSize)
+        {
+          if (buffer->fillSize == 0)
+          {
+            // The client drained all its data, it is idle again.
+            buffer->batching = false;
+          }
+          else if (!_deferBatch(queue, buffer, now, &wakeup))
+          {
+            _collectBatch(queue, buffer);
+          }
+        }
+        if (buffer->outSent < buffer->outSize)
+        {
+          buffer->flushing = true;
+          work[noWork++]   = buffer;
+        }
+      }
+      
+      if (noWork == 0)
+      {
+        // wait until notify is called or the next batch is due.
+        if (wakeup == 0)
+        {
+          waitCond(&queue->condition, &queue->mutex, 0);
+        }
+        else
+        {
+          waitCondMicros(&queue->condition, &queue->mutex,
+                         (wakeup - now + 999) / 1000);
+        }
+        continue;
+      }
+      
+      // Write without holding the mutex, new packets can be queued meanwhile.
+      unlockMutex(&queue->mutex);
+      noBlocked = 0;
+      for (idx = 0; idx < noWork; idx++)
       {
-        if (!sendPacketToClient(packet->srcSock, packet->client, packet->pdu, 
-                                packet->size))
+        start = getStageTime();
+        work[idx]->blocked = _flushSendBuffer(work[idx]) == 0;
+        if (work[idx]->blocked)
         {
-          SRXPROXY_BasicHeader* bhdr = (SRXPROXY_BasicHeader*)packet->pdu;
-          RAISE_ERROR("Could not send packet of type [%u]!", bhdr->type);
+          blocked[noBlocked].fd      = ((ClientThread*)work[idx]->client)
+                                       ->clientFD;
+          blocked[noBlocked].events  = POLLOUT;
+          blocked[noBlocked].revents = 0;
+          noBlocked++;
         }
-        free(packet->pdu);
-        free(packet);
+        recordStage(STAGE_SOCKET_SEND, start);
+      }
+      lockMutex(&queue->mutex);
+      for (idx = 0; idx < noWork; idx++)
+      {
+        work[idx]->flushing = false;
+        if (work[idx]->blocked)
+        {
+          // The socket does not drain as fast as the data is queued.
+          work[idx]->batching = true;
+        }
+      }
+      pthread_cond_broadcast(&queue->flushed);
+      
+      if ((noBlocked == noWork) && !queue->newData)
+      {
+        // Only blocked clients are left, wait until one of them drains or
+        // the next batch is due.
+        timeout = SEND_QUEUE_RETRY_MS;
+        now     = getStageTime();
+        if ((wakeup != 0) && (wakeup < now + timeout * 1000000ULL))
+        {
+          timeout = wakeup > now ? (int)((wakeup - now + 999999) / 1000000)
+                                 : 0;
+        }
+        unlockMutex(&queue->mutex);
+        poll(blocked, noBlocked, timeout);
+        lockMutex(&queue->mutex);
       }
     }
+    unlockMutex(&queue->mutex);
     LOG(LEVEL_DEBUG, "Exit send queue loop!");
   }
   
@@ -221,8 +733,8 @@ bool startSendQueue()
     if (!queue->running)
     {
       queue->running = true;    
-      if (pthread_create(&queue->handler, NULL, sendQueueThreadLoop, NULL) 
-                         != 0)
+      if (createThread(&queue->handler, NULL, THREAD_CLASS_SENDER,
+                       "srx-send", sendQueueThreadLoop, NULL) != 0)
       {
         queue->running = false;
         RAISE_SYS_ERROR("Could not start the send queue handler!");
@@ -251,6 +763,7 @@ void stopSendQueue()
   else
   {
     lockMutex(&queue->mutex);
+    bool wasRunning = queue->running;
     if (queue->running)
     {
       queue->running = false;
@@ -259,125 +772,169 @@ void stopSendQueue()
       signalCond(&queue->condition);
     }
     unlockMutex(&queue->mutex);
-    // Give the queue thread a chance to process the notify or run into a
-    // wait timeout.   
-    LOG(LEVEL_INFO, "StopSendQueue: sleep for %u ms", SEND_QUEUE_WAIT_MS * 2);
-    usleep(SEND_QUEUE_WAIT_MS * 2);
+    
+    if (wasRunning)
+    {
+      // Free the remainder of the queue.
+      LOG(LEVEL_INFO, "StopSendQueue: wait for queue thread to join...");
+      pthread_join(queue->handler, NULL);
+    }
     
     lockMutex(&queue->mutex);
-    // Free the remainder of the queue.
-    LOG(LEVEL_INFO, "StopSendQueue: wait for queue thread to join...");
-    pthread_join(queue->handler, NULL);
     LOG(LEVEL_INFO, "SendQueueThrealLoop STOPPED. Empty remainder of queue!");
-    SendPacket* packet = NULL;
-    while (queue->head != NULL)
+    SendBuffer* buffer = NULL;
+    while (queue->buffers != NULL)
     {
-      packet = queue->head;
-      queue->head = (SendPacket*)packet->next;
+      buffer = queue->buffers;
+      queue->buffers = buffer->next;
       // Free the allocated memory
-      free(packet->pdu);
-      free(packet);
-      queue->size--;
+      _freeSendBuffer(buffer);
     }
-    queue->tail = NULL;
+    queue->size = 0;
     unlockMutex(&queue->mutex);
   }
 }
 
 /**
- * Retrieve the next packet from the queue as long as the queue is running. 
- * in case the queue is not running this method returns NULL.
+ * Release the output buffer of the given client. Must be called before the 
+ * client connection is released. Data that could not be written yet is 
+ * dropped.
  * 
- * @return  the next packet of NULL if the queue is empty.
+ * @param client The client whose buffer has to be released.
  * 
- * @since 0.3.0
+ * @since 0.4.1.0
  */
-SendPacket* fetchSendPacket() 
+void releaseClientSendBuffer(ServerClient* client)
 {
   SendPacketQueue* queue = SEND_QUEUE;
-  SendPacket* packet = NULL;
+  SendBuffer**     bufferPtr;
+  SendBuffer*      buffer;
   
   if (queue != NULL)
   {
     lockMutex(&queue->mutex);
-    while (queue->size == 0 && queue->running)
+    for (bufferPtr = &queue->buffers; *bufferPtr != NULL; 
+         bufferPtr = &(*bufferPtr)->next)
     {
-      // wait until notify is called or after a timeout.      
-      waitCond(&queue->condition, &queue->mutex, SEND_QUEUE_WAIT_MS);
-      if(!queue->running)
+      if ((*bufferPtr)->client == client)
       {
-        LOG(LEVEL_INFO, "Sending queue received shutdown!");
+        break;
       }
     }
-
-    // If queue is still running and a packet is available take it
-    if (queue->running && queue->head != NULL)
+    buffer = *bufferPtr;
+    if (buffer != NULL)
     {
-      packet = queue->head;
-      queue->size--;
-      queue->head = (SendPacket*)packet->next;
-      packet->next = NULL;   
+      // The queue thread or a direct sender currently writes to the client,
+      // senders waiting for room give up.
+      buffer->closing = true;
+      pthread_cond_broadcast(&queue->flushed);
+      while (   buffer->flushing || (buffer->directSending > 0)
+             || (buffer->waiters > 0))
+      {
+        waitCond(&queue->flushed, &queue->mutex, 0);
+      }
+      // The list might have changed while waiting, find the buffer again.
+      for (bufferPtr = &queue->buffers; *bufferPtr != buffer; 
+           bufferPtr = &(*bufferPtr)->next);
+      *bufferPtr = buffer->next;
+      if (_hasPendingData(buffer))
+      {
+        LOG(LEVEL_INFO, "Drop %u queued bytes of a closed client connection", 
+            buffer->fillSize + (buffer->outSize - buffer->outSent));
+      }
+      queue->size -= buffer->fillSize;
+      _freeSendBuffer(buffer);
     }
     unlockMutex(&queue->mutex);
   }
-  return packet;
 }
 
 /**
- * Queue a copy of the the packet and return the size of the queue. The copy of 
- * the packet will be free'd by the queue handler thread itself.
+ * Wait until the fill buffer of the client can take the given number of
+ * bytes. This pushes back on the producers of a client that does not read
+ * its data.
+ *
+ * @note The queue mutex must be held.
+ *
+ * @param queue The send queue
+ * @param buffer The output buffer of the client.
+ * @param size The size of the PDU
+ *
+ * @return false if the buffer is still full after SEND_BUFFER_FULL_TIMEOUT_MS
+ *         or is released meanwhile.
+ *
+ * @since 0.4.1.0
+ */
+static bool _waitForSendBuffer(SendPacketQueue* queue, SendBuffer* buffer,
+                               size_t size)
+{
+  int waited = 0;
+
+  buffer->waiters++;
+  while (   queue->running && !buffer->closing
+         && ((buffer->fillSize + size) > SEND_BUFFER_MAX_SIZE)
+         && (waited < SEND_BUFFER_FULL_TIMEOUT_MS))
+  {
+    // Make sure the queue thread collects the buffer.
+    signalCond(&queue->condition);
+    waitCond(&queue->flushed, &queue->mutex, SEND_QUEUE_RETRY_MS);
+    waited += SEND_QUEUE_RETRY_MS;
+  }
+  buffer->waiters--;
+  if (buffer->closing)
+  {
+    // Wake up releaseClientSendBuffer
+    pthread_cond_broadcast(&queue->flushed);
+    return false;
+  }
+
+  return (buffer->fillSize + size) <= SEND_BUFFER_MAX_SIZE;
+}
+
+/**
+ * Queue a copy of the the packet in the output buffer of the client. The 
+ * packets of a client are written by the queue handler thread.
  * 
+ * @note The queue mutex must be held.
+ * 
+ * @param queue The send queue
+ * @param buffer The output buffer of the client.
  * @param pdu The PDU to be added to the queue.
- * @param srvSoc The server socket to be used for sending
- * @param client The client to send to
+ * @param size The size of the PDU
  * 
  * @return true if the packet was queued, otherwise false.
  * 
  * @since 0.3.0
  */
-bool addToSendQueue(uint8_t* pdu, ServerSocket* srvSoc, ServerClient* client, 
-                    size_t size)
+static bool addToSendQueue(SendPacketQueue* queue, SendBuffer* buffer, 
+                           uint8_t* pdu, size_t size)
 {
-  SendPacketQueue* queue = SEND_QUEUE;
-  
-  SendPacket* packet = malloc(sizeof(SendPacket));
-  bool retVal = false;
+  bool retVal;
   
-  lockMutex(&queue->mutex);
-  if (packet != NULL)
+  if (buffer->fillSize == 0)
   {
-    memset(packet, 0, sizeof(SendPacket));
-    packet->pdu = malloc(size);
-    if (packet->pdu == NULL)
-    {
-      free(packet);
-    }
-    else
+    buffer->fillSince = getStageTime();
+  }
+  retVal = _appendToSendBuffer(buffer, pdu, size);
+  if (retVal)
+  {
+    buffer->fillPackets++;
+    // Only the first packet since the last collection wakes up the thread.
+    // A batching client wakes it up with its first packet, the thread then
+    // waits for the batch delay, and once its batch is complete.
+    if (   !queue->newData
+        && (   !buffer->batching || (queue->batchDelay == 0)
+            || (buffer->fillPackets == 1)
+            || (buffer->fillSize >= queue->batchBytes)))
     {
-      retVal = true;
-      packet->srcSock  = srvSoc;
-      packet->client   = client;
-      packet->next     = NULL;
-      packet->size     = size;
-      memcpy(packet->pdu, pdu, size);  
-      if (queue->size == 0)
-      {
-        queue->head = packet;
-        queue->tail = packet;
-      }
-      else
-      {
-        queue->tail->next = packet;
-        queue->tail = packet;
-      }
-      queue->size++;
       // Signal a new packet is in the queue
+      queue->newData = true;
       signalCond(&queue->condition);
     }
+    queue->size += size;
+    recordQueueDepth(STATS_QUEUE_SEND, queue->size);
   }
-  unlockMutex(&queue->mutex);
-  
-  if (!retVal)
+  else
   {
     RAISE_SYS_ERROR("Not enough memory to queue packets in send queue!");
   }
@@ -390,36 +947,77 @@ bool addToSendQueue(uint8_t* pdu, ServerSocket* srvSoc, ServerClient* client,
 ////////////////////////////////////////////////////////////////////////////////
 
 /**
- * This method redirects the sending requests to the sending queue.
+ * Send the packet to the client either directly or using the sending queue. 
+ * Packets that must be send directly are queued as well if the client still 
+ * has queued data, this keeps the order of the packets.
  * 
  * @param srvSoc The server socket
  * @param client The server client
- * @param data The data to be send
+ * @param pdu The data to be send
  * @param size The length of the data to be send.
  * @param useQueue Use the queue if possible.
  * 
- * @return 
+ * @return true if the packet was send or queued.
  */
-bool __sendPacketToClient(ServerSocket* srvSoc, ServerClient* client,
-                          void* pdu, size_t size, bool useQueue)
+bool sendPacketToProxy(ServerSocket* srvSoc, ServerClient* client,
+                       void* pdu, size_t size, bool useQueue)
 {
-  bool retVal = false;
+  SendPacketQueue* queue = SEND_QUEUE;
+  SendBuffer*      buffer;
+  uint64_t         start;
+  bool             retVal = false;
   
-  if (!useQueue)
+  if (queue == NULL)
   {
-    retVal = sendPacketToClient(srvSoc, client, pdu, size);
+    if (useQueue)
+    {
+      LOG(LEVEL_WARNING, "The sender queue is not initialized, send PDU "
+                         "directly without queue!");
+    }
+    return sendPacketToClient(srvSoc, client, pdu, size);
+  }
+  
+  lockMutex(&queue->mutex);
+  buffer = _getSendBuffer(queue, srvSoc, client, true);
+  if (buffer == NULL)
+  {
+    unlockMutex(&queue->mutex);
+    RAISE_SYS_ERROR("Not enough memory to queue packets in send queue!");
+    return false;
   }
-  else 
+  
+  if (useQueue || _hasPendingData(buffer))
   {
-    if (SEND_QUEUE==NULL)
+    if (_waitForSendBuffer(queue, buffer, size))
     {
-      LOG(LEVEL_WARNING, "The sender queue is not initialized, send PDU directly "
-                         "without queue!");
+      retVal = addToSendQueue(queue, buffer, pdu, size);
     }
     else
     {
-      retVal = addToSendQueue(pdu, srvSoc, client, size);
+      LOG(LEVEL_WARNING, "The output buffer of a client is full, drop a PDU "
+                         "of %zu bytes!", size);
     }
+    unlockMutex(&queue->mutex);
+  }
+  else
+  {
+    // Keep the queue thread away from this client while sending.
+    buffer->directSending++;
+    unlockMutex(&queue->mutex);
+    
+    start  = getStageTime();
+    retVal = sendPacketToClient(srvSoc, client, pdu, size);
+    recordStage(STAGE_SOCKET_SEND, start);
+    
+    lockMutex(&queue->mutex);
+    buffer->directSending--;
+    pthread_cond_broadcast(&queue->flushed);
+    if ((buffer->directSending == 0) && (buffer->fillSize > 0))
+    {
+      // Packets were queued meanwhile, the queue thread skipped them.
+      signalCond(&queue->condition);
+    }
+    unlockMutex(&queue->mutex);
   }
   
   return retVal;
@@ -432,11 +1030,12 @@ bool __sendPacketToClient(ServerSocket* srvSoc, ServerClient* client,
  * @param proxyID The id of the proxy
  * @param srvSoc The server socket
  * @param client The client who received the original message
+ * @param flags The hello flags accepted by the server (SRX_HELLO_FLAG_*)
  *
  * @return true if the packet could be send, otherwise false.
  */
 bool sendHelloResponse(ServerSocket* srvSoc, ServerClient* client,
-                       uint32_t proxyID)
+                       uint32_t proxyID, uint8_t flags)
 {
   bool retVal = true;
   uint32_t length = sizeof(SRXPROXY_HELLO_RESPONSE);
@@ -445,6 +1044,7 @@ bool sendHelloResponse(ServerSocket* srvSoc, ServerClient* client,
 
   pdu->type    = PDU_SRXPROXY_HELLO_RESPONSE;
   pdu->version = htons(SRX_PROTOCOL_VER);
+  pdu->flags   = flags;
   pdu->length  = htonl(length);
   pdu->proxyIdentifier = htonl(proxyID);
   
@@ -478,7 +1078,7 @@ bool sendGoodbye(ServerSocket* srvSoc, ServerClient* client, bool useQueue)
   pdu->keepWindow = 0; // Not used on the client side!
   pdu->length     = htonl(length);
 
-  if (!__sendPacketToClient(srvSoc, client, pdu, length, useQueue))
+  if (!sendPacketToProxy(srvSoc, client, pdu, length, useQueue))
   {
     RAISE_ERROR("Could not send Goodbye message!");
     retVal = false;
@@ -530,7 +1130,7 @@ bool sendVerifyNotification(ServerSocket* srvSoc, ServerClient* client,
 
   pdu->length = htonl(length);
   
-  if (!__sendPacketToClient(srvSoc, client, pdu, length, useQueue))
+  if (!sendPacketToProxy(srvSoc, client, pdu, length, useQueue))
   {
     RAISE_ERROR("Could not send the verify notification for update [0x%08X]!",
                 updateID);
@@ -540,6 +1140,10 @@ bool sendVerifyNotification(ServerSocket* srvSoc, ServerClient* client,
   if (retVal)
   {
     LOG(LEVEL_DEBUG, "Notification send for update [0x%08X]", updateID);    
+    if (isUpdateTraced(updateID))
+    {
+      traceUpdate(updateID, TRACE_NOTIFICATION);
+    }
   }
 
   free(pdu);
@@ -576,7 +1180,7 @@ bool sendSignatureNotification(ServerSocket* srvSoc, ServerClient* client,
   memcpy(blob, bgpsecBlob, bgpsecLength);
 
   // Send the pdu to the client
-  if (!__sendPacketToClient(srvSoc, client, pdu, length, useQueue))
+  if (!sendPacketToProxy(srvSoc, client, pdu, length, useQueue))
   {
     RAISE_SYS_ERROR("Could not send the signature notification for update "
                     "[0x%08X]", updateID);
@@ -608,7 +1212,7 @@ bool sendSynchRequest(ServerSocket* srvSoc, ServerClient* client, bool useQueue)
   pdu->length    = htonl(length);
 
   // Send the pdu to the client
-  if (!__sendPacketToClient(srvSoc, client, pdu, length, useQueue))
+  if (!sendPacketToProxy(srvSoc, client, pdu, length, useQueue))
   {
     RAISE_SYS_ERROR("Could not send the synchonization request");
     retVal = false;
@@ -619,6 +1223,41 @@ bool sendSynchRequest(ServerSocket* srvSoc, ServerClient* client, bool useQueue)
 }
 
 
+/**
+ * Ask the proxy to pause or resume sending. Only send to proxies that
+ * negotiated SRX_HELLO_FLAG_FLOW_CONTROL.
+ *
+ * @param srvSoc The server socket
+ * @param client The client of the communication.
+ * @param pause true to pause, false to resume.
+ * @param useQueue Use the sending queue.
+ *
+ * @return true if the packet could be send, otherwise false.
+ *
+ * @since 0.4.1.0
+ */
+bool sendFlowControl(ServerSocket* srvSoc, ServerClient* client, bool pause,
+                     bool useQueue)
+{
+  SRXPROXY_FLOW_CONTROL pdu;
+  uint32_t length = sizeof(SRXPROXY_FLOW_CONTROL);
+
+  memset(&pdu, 0, length);
+  pdu.type   = PDU_SRXPROXY_FLOW_CONTROL;
+  pdu.pause  = pause ? 1 : 0;
+  pdu.length = htonl(length);
+
+  // Send the pdu to the client
+  if (!sendPacketToProxy(srvSoc, client, &pdu, length, useQueue))
+  {
+    RAISE_SYS_ERROR("Could not send the flow control");
+    return false;
+  }
+
+  return true;
+}
+
+
 /**
  * Send an error report to the proxy.
  *
@@ -642,7 +1281,7 @@ bool sendError(uint16_t errorCode, ServerSocket* srvSoc, ServerClient* client,
   pdu->length    = htonl(length);
 
   // Send the pdu to the client
-  if (!__sendPacketToClient(srvSoc, client, pdu, length, useQueue))
+  if (!sendPacketToProxy(srvSoc, client, pdu, length, useQueue))
   {
     RAISE_SYS_ERROR("Could not send the error report type [%0x04X]", errorCode);
     retVal = false;
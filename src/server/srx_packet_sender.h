@@ -22,11 +22,19 @@
  *
  * This file contains the functions to send srx-proxy packets.
  * 
- * @version 0.3.0
+ * @version 0.4.1.0
  *
  * Changelog:
  * 
  * -----------------------------------------------------------------------------
+ *   0.4.1.0 - 2026/10/14 - kyehwanl
+ *   * Added flags parameter to sendHelloResponse.
+ *   * The send queue keeps one output buffer per client and coalesces the
+ *     queued packets into large writes.
+ *   * Added sendPacketToProxy and releaseClientSendBuffer.
+ *   * Added getSendQueueSize.
+ *   * Added sendFlowControl. The output buffer of each client is bounded.
+ *   * Added SendBatchStats, setSendBatching and getClientSendStats.
  *   0.3.0 - 2013/01/02 - oborchert
  *   * Added changelog.
  *   * Added sending queue to prevent buffer overflows in the receiver socket 
@@ -41,6 +49,26 @@
 #include <stdbool.h>
 #include "util/server_socket.h"
 
+/**
+ * The batches the send queue wrote to a client. A batch is the data queued
+ * for the client since the previous write.
+ *
+ * @since 0.4.1.0
+ */
+typedef struct {
+  /** The number of batches. */
+  uint64_t noBatches;
+  /** The number of packets of all batches. */
+  uint64_t noPackets;
+  /** The number of bytes of all batches. */
+  uint64_t noBytes;
+  /** The number of packets of the largest batch. */
+  uint32_t maxPackets;
+  /** Set while the client does not drain its data as fast as it is queued
+   * and its packets are collected in batches. */
+  bool     batching;
+} SendBatchStats;
+
 /**
  * Create the sender queue including the thread that manages the queue.
  * 
@@ -75,17 +103,83 @@ void stopSendQueue();
  */
 void releaseSendQueue();
 
+/**
+ * Return the number of bytes waiting in the send queue. This function does 
+ * not lock the queue.
+ * 
+ * @return The number of bytes queued, 0 if no send queue exists.
+ * 
+ * @since 0.4.1.0
+ */
+size_t getSendQueueSize();
+
+/**
+ * Configure the batching of clients that do not drain their data as fast as
+ * it is queued. The data of such a client is written once it reaches the
+ * given number of bytes or its oldest packet waited the given time. Idle
+ * clients are always written right away.
+ *
+ * @param delayMicros The time in microseconds the packets of a batching client
+ *                    may wait, 0 disables the batching.
+ * @param maxBytes The number of bytes that completes a batch.
+ *
+ * @since 0.4.1.0
+ */
+void setSendBatching(uint32_t delayMicros, size_t maxBytes);
+
+/**
+ * Return the batch statistics of the given client.
+ *
+ * @param client The client.
+ * @param stats OUT - The statistics.
+ *
+ * @return false if the send queue has no output buffer for the client.
+ *
+ * @since 0.4.1.0
+ */
+bool getClientSendStats(ServerClient* client, SendBatchStats* stats);
+
+/**
+ * Release the output buffer of the given client. Must be called before the 
+ * client connection is released. Data that could not be written yet is 
+ * dropped.
+ * 
+ * @param client The client whose buffer has to be released.
+ * 
+ * @since 0.4.1.0
+ */
+void releaseClientSendBuffer(ServerClient* client);
+
+/**
+ * Send the given packet to the client either directly or using the sending 
+ * queue. Packets that must be send directly are queued as well if the client
+ * still has queued data, this keeps the order of the packets.
+ * 
+ * @param svrSock The server socket
+ * @param client The client of the communication.
+ * @param pdu The data to be send
+ * @param size The length of the data to be send.
+ * @param useQueue Use the sending queue or not.
+ * 
+ * @return true if the packet could be send or queued, otherwise false.
+ * 
+ * @since 0.4.1.0
+ */
+bool sendPacketToProxy(ServerSocket* svrSock, ServerClient* client, void* pdu,
+                       size_t size, bool useQueue);
+
 /**
  * Send a hello response to the client. This method does not use the send queue
  *
  * @param proxyID The id of the proxy
  * @param srcSock The server socket
  * @param client The client who received the original message
+ * @param flags The hello flags accepted by the server (SRX_HELLO_FLAG_*)
  *
  * @return true if the packet could be send, otherwise false.
  */
 bool sendHelloResponse(ServerSocket* srcSock, ServerClient* client,
-                       uint32_t proxyID);
+                       uint32_t proxyID, uint8_t flags);
 
 /**
  * Send a goodbye packet to the proxy. The proxy does not use the keepWindow,
@@ -148,6 +242,22 @@ bool sendSignatureNotification(ServerSocket* svrSock, ServerClient* client,
 bool sendSynchRequest(ServerSocket* svrSock, ServerClient* client, 
                       bool useQueue);
 
+/**
+ * Ask the proxy to pause or resume sending. Only send to proxies that
+ * negotiated SRX_HELLO_FLAG_FLOW_CONTROL.
+ *
+ * @param svrSock The server socket
+ * @param client The client of the communication.
+ * @param pause true to pause, false to resume.
+ * @param useQueue Use the sending queue
+ *
+ * @return true if the packet could be send, otherwise false.
+ *
+ * @since 0.4.1.0
+ */
+bool sendFlowControl(ServerSocket* svrSock, ServerClient* client, bool pause,
+                     bool useQueue);
+
 /**
  * Send an error report to the proxy.
  * 
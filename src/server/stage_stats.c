@@ -0,0 +1,327 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Latency histograms of the processing stages and depth histograms of the
+ * queues. The histograms are static, they are zero at program start.
+ *
+ * The spans of the sampled updates are stored in a ring, a new span claims the
+ * next position with an atomic increment. Unsampled updates only read the
+ * sample rate.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ *            * Added the sampled update trace ring.
+ */
+
+#include <string.h>
+#include "server/stage_stats.h"
+
+/** One in this many update IDs is traced, 0 if tracing is off. */
+volatile uint32_t g_updateTraceRate = 0;
+
+/** The latency histograms of the stages. */
+static Histogram _stages[NUM_STAGES];
+/** The depth histograms of the queues. */
+static Histogram _queues[NUM_STATS_QUEUES];
+/** The time (ns) the first value was recorded or of the last reset. */
+static volatile uint64_t _startTime = 0;
+
+/** The names of the stages. */
+static const char* _stageNames[NUM_STAGES] = {
+  "pdu-receive", "receiver-queue", "command-queue", "validation",
+  "result-broadcast", "socket-send"
+};
+
+/** The names of the queues. */
+static const char* _queueNames[NUM_STATS_QUEUES] = {
+  "receiver-queue", "command-queue", "send-queue"
+};
+
+/** The names of the trace points. */
+static const char* _tracePointNames[NUM_TRACE_POINTS] = {
+  "receive", "dequeue", "fetch", "validated", "modified", "notified"
+};
+
+/** The spans of the sampled updates. */
+static UpdateTraceSpan _traceRing[UPDATE_TRACE_RING_SIZE];
+/** The number of spans ever started. */
+static volatile uint32_t _traceHead = 0;
+/** The receive time of the PDU the thread handles. */
+static __thread uint64_t _pduReceived = 0;
+/** The receiver queue dequeue time of the PDU the thread handles. */
+static __thread uint64_t _pduDequeued = 0;
+
+/**
+ * Remember the time the first value was recorded.
+ *
+ * @param now The current time.
+ */
+static inline void _markStart(uint64_t now)
+{
+  if (_startTime == 0)
+  {
+    __sync_bool_compare_and_swap(&_startTime, 0, now);
+  }
+}
+
+/**
+ * Record the time passed since the given start time for the stage.
+ *
+ * @param stage The stage.
+ * @param start The start time taken with getStageTime.
+ */
+void recordStage(ServerStage stage, uint64_t start)
+{
+  uint64_t now = getStageTime();
+
+  _markStart(start);
+  recordHistogram(&_stages[stage], now > start ? now - start : 0);
+}
+
+/**
+ * Record the depth of the queue, called each time an element is queued.
+ *
+ * @param queue The queue.
+ * @param depth The depth after the element was queued.
+ */
+void recordQueueDepth(StatsQueue queue, uint64_t depth)
+{
+  recordHistogram(&_queues[queue], depth);
+}
+
+/**
+ * Set all statistics back to zero.
+ */
+void resetStageStats()
+{
+  int idx;
+
+  for (idx = 0; idx < NUM_STAGES; idx++)
+  {
+    resetHistogram(&_stages[idx]);
+  }
+  for (idx = 0; idx < NUM_STATS_QUEUES; idx++)
+  {
+    resetHistogram(&_queues[idx]);
+  }
+  _startTime = getStageTime();
+}
+
+/**
+ * Return a snapshot of the latency histogram (nano seconds) of the stage.
+ *
+ * @param stage The stage.
+ * @param snapshot (out) The snapshot.
+ */
+void getStageSnapshot(ServerStage stage, HistogramSnapshot* snapshot)
+{
+  getHistogramSnapshot(&_stages[stage], snapshot);
+}
+
+/**
+ * Return a snapshot of the depth histogram of the queue.
+ *
+ * @param queue The queue.
+ * @param snapshot (out) The snapshot.
+ */
+void getQueueDepthSnapshot(StatsQueue queue, HistogramSnapshot* snapshot)
+{
+  getHistogramSnapshot(&_queues[queue], snapshot);
+}
+
+/**
+ * Return the name of the stage.
+ *
+ * @param stage The stage.
+ *
+ * @return The name.
+ */
+const char* stageToStr(ServerStage stage)
+{
+  return stage < NUM_STAGES ? _stageNames[stage] : "unknown";
+}
+
+/**
+ * Return the name of the queue.
+ *
+ * @param queue The queue.
+ *
+ * @return The name.
+ */
+const char* statsQueueToStr(StatsQueue queue)
+{
+  return queue < NUM_STATS_QUEUES ? _queueNames[queue] : "unknown";
+}
+
+/**
+ * Return the time in seconds since the statistics were started or reset.
+ *
+ * @return The time in seconds.
+ */
+uint64_t getStageStatsAge()
+{
+  uint64_t start = _startTime;
+
+  return start != 0 ? (getStageTime() - start) / 1000000000ULL : 0;
+}
+
+/**
+ * Trace one in the given number of update IDs, 0 turns the tracing off. The
+ * ring keeps the spans recorded so far.
+ *
+ * @param rate The sample rate.
+ *
+ * @since 0.4.1.0
+ */
+void setUpdateTraceRate(uint32_t rate)
+{
+  g_updateTraceRate = rate;
+}
+
+/**
+ * Set the receive time and the receiver queue dequeue time of the PDU the
+ * calling thread handles next. Only called while tracing is on.
+ *
+ * @param received The time (ns) the PDU was received.
+ * @param dequeued The time (ns) the PDU was taken out of the receiver queue,
+ *                 0 if no receiver queue is used.
+ *
+ * @since 0.4.1.0
+ */
+void setTracedPDUTimes(uint64_t received, uint64_t dequeued)
+{
+  _pduReceived = received;
+  _pduDequeued = dequeued;
+}
+
+/**
+ * Start a new span for the sampled update. The span starts with the times of
+ * the PDU the calling thread handles (see setTracedPDUTimes).
+ *
+ * @param updateID The ID of the update.
+ *
+ * @since 0.4.1.0
+ */
+void startUpdateTrace(uint32_t updateID)
+{
+  uint32_t         pos  = __sync_fetch_and_add(&_traceHead, 1);
+  UpdateTraceSpan* span = &_traceRing[pos & (UPDATE_TRACE_RING_SIZE - 1)];
+  int              idx;
+
+  // Invalidate the span while it is reused.
+  span->sequence = 0;
+  __sync_synchronize();
+  span->updateID = updateID;
+  for (idx = 0; idx < NUM_TRACE_POINTS; idx++)
+  {
+    span->time[idx] = 0;
+  }
+  span->time[TRACE_PDU_RECEIVE]      = _pduReceived;
+  span->time[TRACE_RECEIVER_DEQUEUE] = _pduDequeued;
+  __sync_synchronize();
+  span->sequence = pos + 1;
+}
+
+/**
+ * Record the current time for the trace point in the most recent span of the
+ * sampled update. Nothing is recorded if the update has no recent span.
+ *
+ * @param updateID The ID of the update.
+ * @param point The trace point.
+ *
+ * @since 0.4.1.0
+ */
+void traceUpdate(uint32_t updateID, TracePoint point)
+{
+  uint32_t         head = _traceHead;
+  uint32_t         pos;
+  UpdateTraceSpan* span;
+  int              idx;
+
+  for (idx = 1; (idx <= UPDATE_TRACE_LOOKUP) && (idx <= head); idx++)
+  {
+    pos  = head - idx;
+    span = &_traceRing[pos & (UPDATE_TRACE_RING_SIZE - 1)];
+    if ((span->sequence == pos + 1) && (span->updateID == updateID))
+    {
+      span->time[point] = getStageTime();
+      break;
+    }
+  }
+}
+
+/**
+ * Copy the most recent spans of the ring, the oldest first.
+ *
+ * @param spans (out) The array the spans are copied into.
+ * @param max The maximum number of spans to be copied.
+ *
+ * @return The number of spans copied.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t getUpdateTraces(UpdateTraceSpan* spans, uint32_t max)
+{
+  uint32_t         head  = _traceHead;
+  uint32_t         count = 0;
+  uint32_t         first;
+  uint32_t         pos;
+  UpdateTraceSpan* span;
+
+  if (max > UPDATE_TRACE_RING_SIZE)
+  {
+    max = UPDATE_TRACE_RING_SIZE;
+  }
+  first = head > max ? head - max : 0;
+  for (pos = first; pos != head; pos++)
+  {
+    span = &_traceRing[pos & (UPDATE_TRACE_RING_SIZE - 1)];
+    // Skip the spans that are reused or not complete yet.
+    if (span->sequence == pos + 1)
+    {
+      memcpy(&spans[count], (void*)span, sizeof(UpdateTraceSpan));
+      if (spans[count].sequence == pos + 1)
+      {
+        count++;
+      }
+    }
+  }
+
+  return count;
+}
+
+/**
+ * Return the name of the trace point.
+ *
+ * @param point The trace point.
+ *
+ * @return The name.
+ *
+ * @since 0.4.1.0
+ */
+const char* tracePointToStr(TracePoint point)
+{
+  return point < NUM_TRACE_POINTS ? _tracePointNames[point] : "unknown";
+}
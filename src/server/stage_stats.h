@@ -0,0 +1,285 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Latency histograms of the processing stages of a validation request and
+ * depth histograms of the queues between them. The statistics are process
+ * wide, recording does not lock.
+ *
+ * A sample of the updates (1 in N update IDs) can be traced through the
+ * stages, the spans of the most recent sampled updates are kept in a ring.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ *            * Added the sampled update trace ring.
+ */
+
+#ifndef __STAGE_STATS_H__
+#define __STAGE_STATS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "util/histogram.h"
+
+/** The number of spans kept in the update trace ring, a power of 2. */
+#define UPDATE_TRACE_RING_SIZE 1024
+/** The number of the most recent spans searched for the span of an update. */
+#define UPDATE_TRACE_LOOKUP    64
+
+/** The processing stages. */
+typedef enum {
+  /** Handling of a received PDU until it is queued (receive thread). */
+  STAGE_PDU_RECEIVE        = 0,
+  /** Time a PDU waits in the receiver queue. */
+  STAGE_RECEIVER_QUEUE     = 1,
+  /** Time a command waits in the command queue. */
+  STAGE_COMMAND_QUEUE      = 2,
+  /** Processing of a validation request by the command handler. */
+  STAGE_VALIDATION         = 3,
+  /** Broadcast of changed results to the proxies. */
+  STAGE_RESULT_BROADCAST   = 4,
+  /** Writing data to a proxy socket. */
+  STAGE_SOCKET_SEND        = 5,
+  /** The number of stages. */
+  NUM_STAGES               = 6
+} ServerStage;
+
+/** The queues between the stages. */
+typedef enum {
+  /** PDUs in the receiver queue. */
+  STATS_QUEUE_RECEIVER = 0,
+  /** Commands in the command queue lane. */
+  STATS_QUEUE_COMMAND  = 1,
+  /** Bytes in the send queue. */
+  STATS_QUEUE_SEND     = 2,
+  /** The number of queues. */
+  NUM_STATS_QUEUES     = 3
+} StatsQueue;
+
+/** The points a traced update passes. */
+typedef enum {
+  /** The PDU of the update was received. */
+  TRACE_PDU_RECEIVE      = 0,
+  /** The PDU was taken out of the receiver queue. */
+  TRACE_RECEIVER_DEQUEUE = 1,
+  /** The validation command was fetched from the command queue. */
+  TRACE_COMMAND_FETCH    = 2,
+  /** The prefix cache completed the origin validation request. */
+  TRACE_VALIDATION       = 3,
+  /** The result was modified in the update cache. */
+  TRACE_RESULT_MODIFY    = 4,
+  /** The verify notification was written or queued. */
+  TRACE_NOTIFICATION     = 5,
+  /** The number of trace points. */
+  NUM_TRACE_POINTS       = 6
+} TracePoint;
+
+/**
+ * The span of a traced update. Each point holds the time (ns) the update
+ * passed it the last time or 0.
+ */
+typedef struct {
+  /** The ID of the update. */
+  uint32_t          updateID;
+  /** The position of the span within the ring + 1, 0 while unused. */
+  volatile uint32_t sequence;
+  /** The times the update passed the trace points. */
+  volatile uint64_t time[NUM_TRACE_POINTS];
+} UpdateTraceSpan;
+
+/** One in this many update IDs is traced, 0 if tracing is off. Only read it
+ * using isUpdateTracing and isUpdateTraced. */
+extern volatile uint32_t g_updateTraceRate;
+
+/**
+ * Return the monotonic time in nano seconds, used as the start time of a
+ * stage.
+ *
+ * @return The time in nano seconds.
+ */
+static inline uint64_t getStageTime()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Record the time passed since the given start time for the stage.
+ *
+ * @param stage The stage.
+ * @param start The start time taken with getStageTime.
+ */
+void recordStage(ServerStage stage, uint64_t start);
+
+/**
+ * Record the depth of the queue, called each time an element is queued.
+ *
+ * @param queue The queue.
+ * @param depth The depth after the element was queued.
+ */
+void recordQueueDepth(StatsQueue queue, uint64_t depth);
+
+/**
+ * Set all statistics back to zero.
+ */
+void resetStageStats();
+
+/**
+ * Return a snapshot of the latency histogram (nano seconds) of the stage.
+ *
+ * @param stage The stage.
+ * @param snapshot (out) The snapshot.
+ */
+void getStageSnapshot(ServerStage stage, HistogramSnapshot* snapshot);
+
+/**
+ * Return a snapshot of the depth histogram of the queue.
+ *
+ * @param queue The queue.
+ * @param snapshot (out) The snapshot.
+ */
+void getQueueDepthSnapshot(StatsQueue queue, HistogramSnapshot* snapshot);
+
+/**
+ * Return the name of the stage.
+ *
+ * @param stage The stage.
+ *
+ * @return The name.
+ */
+const char* stageToStr(ServerStage stage);
+
+/**
+ * Return the name of the queue.
+ *
+ * @param queue The queue.
+ *
+ * @return The name.
+ */
+const char* statsQueueToStr(StatsQueue queue);
+
+/**
+ * Return the time in seconds since the statistics were started or reset.
+ *
+ * @return The time in seconds.
+ */
+uint64_t getStageStatsAge();
+
+/**
+ * Indicates if updates are traced at all.
+ *
+ * @return true if the tracing is on.
+ *
+ * @since 0.4.1.0
+ */
+static inline bool isUpdateTracing()
+{
+  return g_updateTraceRate != 0;
+}
+
+/**
+ * Indicates if the update is sampled for tracing.
+ *
+ * @param updateID The ID of the update.
+ *
+ * @return true if the update is traced.
+ *
+ * @since 0.4.1.0
+ */
+static inline bool isUpdateTraced(uint32_t updateID)
+{
+  uint32_t rate = g_updateTraceRate;
+
+  return (rate != 0) && ((updateID % rate) == 0);
+}
+
+/**
+ * Trace one in the given number of update IDs, 0 turns the tracing off. The
+ * ring keeps the spans recorded so far.
+ *
+ * @param rate The sample rate.
+ *
+ * @since 0.4.1.0
+ */
+void setUpdateTraceRate(uint32_t rate);
+
+/**
+ * Set the receive time and the receiver queue dequeue time of the PDU the
+ * calling thread handles next. Only called while tracing is on.
+ *
+ * @param received The time (ns) the PDU was received.
+ * @param dequeued The time (ns) the PDU was taken out of the receiver queue,
+ *                 0 if no receiver queue is used.
+ *
+ * @since 0.4.1.0
+ */
+void setTracedPDUTimes(uint64_t received, uint64_t dequeued);
+
+/**
+ * Start a new span for the sampled update. The span starts with the times of
+ * the PDU the calling thread handles (see setTracedPDUTimes).
+ *
+ * @param updateID The ID of the update.
+ *
+ * @since 0.4.1.0
+ */
+void startUpdateTrace(uint32_t updateID);
+
+/**
+ * Record the current time for the trace point in the most recent span of the
+ * sampled update. Nothing is recorded if the update has no recent span.
+ *
+ * @param updateID The ID of the update.
+ * @param point The trace point.
+ *
+ * @since 0.4.1.0
+ */
+void traceUpdate(uint32_t updateID, TracePoint point);
+
+/**
+ * Copy the most recent spans of the ring, the oldest first.
+ *
+ * @param spans (out) The array the spans are copied into.
+ * @param max The maximum number of spans to be copied.
+ *
+ * @return The number of spans copied.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t getUpdateTraces(UpdateTraceSpan* spans, uint32_t max);
+
+/**
+ * Return the name of the trace point.
+ *
+ * @param point The trace point.
+ *
+ * @return The name.
+ *
+ * @since 0.4.1.0
+ */
+const char* tracePointToStr(TracePoint point);
+
+#endif // !__STAGE_STATS_H__
@@ -20,15 +20,74 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * The update cache holds the updates in two separate structures, one is the 
- * update cache, a hash table with the update id as key and the update as 
- * value. The other is a list, that allows to scan through all updates. Both 
- * MUST be maintained the same.
+ * The update cache holds the updates in a hash table with the update id as 
+ * key and the update as value. The memory of the updates is managed by a 
+ * memory pool, identical blobs are shared using a blob store.
  * 
- * @version 0.4.0.1
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Protect the client references of an update with the item mutex
+ *              to allow multiple command handler threads.
+ *            * storeUpdate re-checks for the update once the item mutex is 
+ *              acquired and releases the mutex in case of an error.
+ *            * Replaced the allItems list and the per update malloc calls
+ *              with memory pools. The pools are sized using the configured
+ *              expected number of updates.
+ *            * Replaced the uthash table and its single r/w lock with a
+ *              sharded hash table. Each shard has its own lock and doubles its
+ *              buckets incrementally to keep lookups short while growing.
+ *            * modifyUpdateResult writes the changed update into the change
+ *              log instead of calling the result callback. The change log 
+ *              thread reports the final result of the logged updates in
+ *              batches outside of the item mutex.
+ *            * Added setUpdateResultsChangedCallback to report the batches 
+ *              at once.
+ *            * Fixed the BGPsec result change detection which compared with
+ *              the ROA result.
+ *            * Implemented the garbage collector. Updates without clients are
+ *              scheduled in a timer wheel and removed from the prefix cache 
+ *              and the update cache in small batches within a time budget 
+ *              per second. Replaced gcTestAndDeleteUpdate.
+ *            * unregisterClientID used the keep time as GC time.
+ *            * Keep the shard of an update locked while the update is used,
+ *              the garbage collector releases the updates under the write
+ *              lock of their shard. The item mutex only guards the pools, the
+ *              blob store, and the timer wheel, the client index got its own
+ *              mutex. The result of an update that can not be logged is
+ *              reported after the shard is unlocked.
+ *            * Added walkUpdateCache.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added dumpUpdateCache, writes JSON lines while locking one
+ *              shard at a time.
+ *            * Remember if the blob is the BGPSec path attribute and added
+ *              getUpdateSigningData. getUpdateSignature does not reject the
+ *              signing anymore.
+ *            * Identical update blobs are stored once in the blob store, 
+ *              detectCollision compares the blob handles.
+ *            * The clients of an update are kept in an inline bitmap instead
+ *              of the client array allocated from the client pool.
+ *            * Index the updates of each client. unregisterClientID visits 
+ *              only the updates of the client and releases the locks after
+ *              each batch instead of walking the whole table at once.
+ *            * Fixed the size of lockedClients.
+ *            * Size the table shards using the expected number of updates.
+ *            * The garbage collector and the change log thread are placed and
+ *              named by createThread.
+ *            * Trace the result modifications of sampled updates.
+ *            * Name the locks for the lock statistics.
+ *            * Account the entries, buckets and client index memory.
+ *            * detectCollision compares an IPv4 prefix as one 32 bit word and
+ *              compares the prefix length as well.
+ *            * Each entry stores the fingerprint of its prefix, origin AS, and
+ *              path. detectCollision compares the fingerprints instead of the
+ *              prefix and the blob.
+ *            * Replicate stored, collected, and changed updates to the standby
+ *              server. Added collectUpdate and keepUpdatesWithoutClient.
+ *            * The kind of the blob is passed to the cache visitor and
+ *              replicated with the update.
  * 0.4.0.1  - 2016/07/02 - oborchert
  *            * Removed misleading error message. The system generated an error
  *              for each update that could not be stored a second time. 
@@ -51,66 +110,225 @@
  *            * Code created.
  */
 
-#include <uthash.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <malloc.h>
 #include <time.h>
 #include "server/update_cache.h"
 #include "server/server_connection_handler.h"
 #include "server/prefix_cache.h"
+#include "server/replication.h"
+#include "server/stage_stats.h"
 #include "shared/srx_defs.h"
 #include "shared/srx_packets.h"
+#include "util/json_out.h"
+#include "util/lock_stats.h"
 #include "util/log.h"
+#include "util/mem_stats.h"
 #include "util/prefix.h"
 #include "util/xml_out.h"
 #include "util/mutex.h"
-
-/* Number of preallocated result slots */
-//#define NUM_PREALLOC  20
-#define NUM_PREALLOC  1
+#include "util/thread.h"
+
+/* Minimum number of cache entries allocated at once */
+#define ENTRY_SLAB_MIN   64
+/* Maximum number of cache entries allocated at once */
+#define ENTRY_SLAB_MAX   65536
+/* The number of 64 bit words of the client bitmap, one bit per client ID */
+#define CLIENT_WORDS     ((MAX_PROXY_CLIENT_ELEMENTS + 63) / 64)
+/* The initial number of buckets of each table shard, MUST be a power of 2 */
+#define SHARD_INIT_BUCKETS 64
+/* The maximum number of buckets of each shard sized by the expected number of
+ * updates */
+#define SHARD_MAX_INIT_BUCKETS (1 << 20)
+/* The number of old buckets migrated with each write access during a resize */
+#define SHARD_MIGRATE_STEP 16
+/* The initial number of ids the change log can hold */
+#define CHANGE_LOG_INIT_SIZE 1024
+/* The maximum number of changes reported per callback call */
+#define CHANGE_LOG_BATCH     256
+/** The number of updates removed by the garbage collector per lock hold. */
+#define GC_BATCH_SIZE        64
+/** The initial number of ids a client index can hold. */
+#define CLIENT_INDEX_INIT_SIZE 256
 
 #define HDR "([0x%08X] UpdateCache): "
 
 /**
- * A single update result.
+ * A single update result. Guarded by the lock of its shard, the entry of the
+ * garbage collector and gcExpired by the item mutex.
  */
-typedef struct {
-  uint8_t* clients;           // clients with value 0 are unused.
-  uint8_t  noPossibleClients; // maximum number of clients in list without 
-                              // extending
+typedef struct _CacheEntry {
+  uint64_t clients[CLIENT_WORDS]; // One bit per client ID referencing the 
+                                  // update.
+  uint8_t  noClients;             // The number of bits set in clients.
   
   SRxUpdateID      updateID;  // the unique update ID.
   
-  UT_hash_handle   hh;            // The hash table where this entry is stored 
-                                  // in
+  struct _CacheEntry* next;       // The next entry within the hash bucket
   uint32_t         asn;           // The Origin AS of this update
   IPPrefix         prefix;        // The prefix of this update
   SRxResult        srxResult;     // The result generated by SRx
   SRxDefaultResult defaultResult; // The result provided by verification 
                                   // request.
   uint32_t         roaRefCount;   // the number of ROA's that cover this update
+  SRxResult        reportedResult;// The result before the logged changes
+  uint8_t          changeFlags;   // The results changed since the update was
+                                  // logged in the change log, 0 = not logged 
 
   uint16_t         gcFlag;        // Indicates when this entry can be deleted
                                   // by the garbage collector.
+  TimerWheelEntry  gcEntry;       // Schedules the entry for garbage collection
+  bool             gcExpired;     // The entry is in the expired list of the
+                                  // garbage collector
   
   uint32_t         blobLength;    // The length of the update blob
-  uint8_t*         blob;          // The update blob itself.
+  uint8_t*         blob;          // The update blob, interned in the blob
+                                  // store and shared with other updates.
+  bool             bgpsecAttr;    // The blob is the BGPSec path attribute,
+                                  // otherwise the AS path.
+  uint64_t         fingerprint;   // The fingerprint of prefix, origin AS, and
+                                  // path, see _fingerprintUpdate
 } CacheEntry;
 
+/** Returns the cache entry of the given garbage collector entry. */
+#define GC_CACHE_ENTRY(ENTRY) \
+  ((CacheEntry*)((uint8_t*)(ENTRY) - offsetof(CacheEntry, gcEntry)))
+
+/**
+ * Used to walk through all entries of the hash table. All shards MUST be 
+ * locked during the walk.
+ */
+typedef struct {
+  uint32_t    shard;  // The current shard
+  bool        old;    // Indicates if the old buckets are walked
+  uint32_t    bucket; // The current bucket
+  CacheEntry* entry;  // The current entry
+} TableCursor;
+
 // Forward declarations
 bool _addClientReference(UpdateCache* self, CacheEntry* cEntry, 
                          uint8_t clientID, ProxyClientMapping* clientMapping);
+static void _indexClientUpdate(UpdateCache* self, uint8_t clientID,
+                               SRxUpdateID updateID);
 uint16_t getGCTime(uint16_t keepTime);
+void setGCFlag(UpdateCache* self, CacheEntry* cEntry, uint16_t keepTime);
+
+/**
+ * Checks if the client references the update.
+ *
+ * @param cEntry The update.
+ * @param clientID The client ID.
+ *
+ * @return true if the bit of the client is set.
+ */
+static inline bool _isClientSet(CacheEntry* cEntry, uint8_t clientID)
+{
+  return (cEntry->clients[clientID >> 6] & (1ULL << (clientID & 63))) != 0;
+}
+
+/**
+ * Fill the IDs of all clients referencing the update into the array in 
+ * ascending order.
+ *
+ * @param cEntry The update.
+ * @param clientIDs The array, must hold at least cEntry->noClients elements.
+ *
+ * @return The number of client IDs filled in.
+ */
+static int _getClients(CacheEntry* cEntry, uint8_t* clientIDs)
+{
+  uint64_t word;
+  int      idx;
+  int      count = 0;
+
+  for (idx = 0; idx < CLIENT_WORDS; idx++)
+  {
+    for (word = cEntry->clients[idx]; word != 0; word &= word - 1)
+    {
+      clientIDs[count++] = (uint8_t)((idx << 6) + __builtin_ctzll(word));
+    }
+  }
+
+  return count;
+}
+
+/**
+ * Select the path data of the update the same way storeCacheEntryBlob does.
+ *
+ * @param bgpsecData The bgpsec (and bgp4) data or NULL.
+ * @param data OUT - The path data.
+ *
+ * @return The length of the path data.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t _selectUpdateData(BGPSecData* bgpsecData, uint8_t** data)
+{
+  *data = NULL;
+  if (bgpsecData == NULL)
+  {
+    return 0;
+  }
+  if (bgpsecData->attr_length != 0)
+  {
+    *data = bgpsecData->bgpsec_path_attr;
+    return bgpsecData->attr_length;
+  }
+  *data = (uint8_t*)bgpsecData->asPath;
+  return bgpsecData->numberHops * 4;
+}
+
+/**
+ * Generate the fingerprint of an update. It is the SipHash of the prefix,
+ * the origin AS, and the SipHash of the path data, keyed with the secret key
+ * of the cache. Without the key no path can be crafted to match the
+ * fingerprint of another update.
+ *
+ * @param self The update cache.
+ * @param prefix The prefix of the update.
+ * @param asn The origin AS of the update.
+ * @param bgpsecData The bgpsec (and bgp4) data or NULL.
+ *
+ * @return The fingerprint.
+ *
+ * @since 0.4.1.0
+ */
+static uint64_t _fingerprintUpdate(UpdateCache* self, IPPrefix* prefix,
+                                   uint32_t asn, BGPSecData* bgpsecData)
+{
+  // The path hash, origin AS, IP version, prefix length, and address
+  uint8_t  fpData[8 + 4 + 1 + 1 + 16];
+  uint8_t* data       = NULL;
+  uint32_t dataLength = _selectUpdateData(bgpsecData, &data);
+  uint64_t pathHash   = siphash(self->fpKey, data, dataLength);
+
+  memcpy(fpData, &pathHash, 8);
+  memcpy(fpData + 8, &asn, 4);
+  fpData[12] = prefix->ip.version;
+  fpData[13] = prefix->length;
+  if (prefix->ip.version == 4)
+  {
+    memcpy(fpData + 14, &prefix->ip.addr.v4.u32, 4);
+    return siphash(self->fpKey, fpData, 14 + 4);
+  }
+  memcpy(fpData + 14, prefix->ip.addr.v6.u8, 16);
+  return siphash(self->fpKey, fpData, sizeof(fpData));
+}
 
 /**
  * This function selects the data from bgpsecData that is used for ID generation
  * - see srx_identifier::generateIdentifier and stores it in the cache entry.
  * It is important that both data blobs are same otherwise problems with the
  * ID finding are given.
- * This method copies the data from bgpsecData into the cache entry. Therefore
- * the memory allocated in bgpsecData can safely be deallocated.
+ * The data is interned in the blob store of the update cache, updates with 
+ * the same data share the blob. Therefore the memory allocated in bgpsecData 
+ * can safely be deallocated.
  * 
+ * @param self The update cache providing the blob store.
  * @param cEntry The cache entry where the blob data will be stored in.
  * @param bgpsecData The bgpsec (and bgp4) data that has to be stored.
  * 
@@ -120,91 +338,899 @@ uint16_t getGCTime(uint16_t keepTime);
  * 
  * @see srx_identifier.h::generateIdentifier
  */
-bool storeCacheEntryBlob(CacheEntry* cEntry, BGPSecData* bgpsecData)
+static bool storeCacheEntryBlob(UpdateCache* self, CacheEntry* cEntry, 
+                                BGPSecData* bgpsecData)
+{
+  bool retVal = false;
+  
+  if (cEntry->blob == NULL)
+  {
+    if (bgpsecData->attr_length != 0)
+    {
+      cEntry->blobLength = bgpsecData->attr_length;
+      cEntry->blob = internBlob(&self->blobStore, 
+                                bgpsecData->bgpsec_path_attr, 
+                                cEntry->blobLength);
+      if (cEntry->blob != NULL)
+      {
+        cEntry->bgpsecAttr = true;
+        retVal = true;
+      }
+    }
+    else
+    {
+      cEntry->blobLength = bgpsecData->numberHops * 4;
+      if (cEntry->blobLength == 0)
+      {
+        return false;
+      }
+      cEntry->blob = internBlob(&self->blobStore, 
+                                (uint8_t*)bgpsecData->asPath, 
+                                cEntry->blobLength);
+      retVal = cEntry->blob != NULL;
+    }
+    if (cEntry->blob == NULL)
+    {
+      cEntry->blobLength = 0;
+    }
+  }
+  
+  return retVal;
+}
+
+/*---------------------
+ * Hash-table functions
+ *
+ * @note Uses one R/W lock per shard
+ */
+
+/**
+ * Generate the hash of the update id. The upper bits select the shard, the 
+ * lower bits the bucket within the shard.
+ *
+ * @param updateID The update ID
+ *
+ * @return The hash value.
+ */
+static inline uint32_t _tableHash(SRxUpdateID updateID)
+{
+  return (uint32_t)updateID * 2654435761u;
+}
+
+/**
+ * Return the shard the hash value belongs to.
+ *
+ * @param self The update cache.
+ * @param hash The hash of the update id.
+ *
+ * @return The shard.
+ */
+static inline UC_TableShard* _tableShard(UpdateCache* self, uint32_t hash)
+{
+  return &self->shards[(hash >> 24) & (UC_TABLE_SHARDS - 1)];
+}
+
+/**
+ * Return the head of the bucket chain the hash value belongs to. During a 
+ * resize entries that are not migrated yet are found in the old buckets.
+ *
+ * @param shard The shard, MUST be locked.
+ * @param hash The hash of the update id.
+ * @param old Select the old buckets if they are not migrated yet.
+ *
+ * @return The link to the first entry of the bucket or NULL if old is true
+ *         and the bucket is migrated already.
+ */
+static CacheEntry** _tableBucket(UC_TableShard* shard, uint32_t hash, bool old)
+{
+  if (old)
+  {
+    if ((shard->oldBuckets == NULL) || ((hash & shard->oldMask) 
+                                        < shard->migrated))
+    {
+      return NULL;
+    }
+    return (CacheEntry**)&shard->oldBuckets[hash & shard->oldMask];
+  }
+  return (CacheEntry**)&shard->buckets[hash & shard->mask];
+}
+
+/**
+ * Move at most the given number of old buckets into the new buckets. Releases
+ * the old buckets once all are migrated.
+ *
+ * @param shard The shard, MUST be write locked.
+ * @param count The maximum number of buckets to migrate.
+ */
+static void _migrateBuckets(UC_TableShard* shard, uint32_t count)
+{
+  CacheEntry*  cEntry;
+  CacheEntry** bucket;
+
+  while ((shard->oldBuckets != NULL) && (count-- > 0))
+  {
+    cEntry = (CacheEntry*)shard->oldBuckets[shard->migrated];
+    while (cEntry != NULL)
+    {
+      CacheEntry* next = cEntry->next;
+      bucket = _tableBucket(shard, _tableHash(cEntry->updateID), false);
+      cEntry->next = *bucket;
+      *bucket      = cEntry;
+      cEntry       = next;
+    }
+    shard->oldBuckets[shard->migrated] = NULL;
+    if (shard->migrated++ == shard->oldMask)
+    {
+      addMemStats(MEM_TAG_UPDATES,
+                  -(int64_t)((shard->oldMask + 1) * sizeof(void*)), -1);
+      free(shard->oldBuckets);
+      shard->oldBuckets = NULL;
+      shard->oldMask    = 0;
+      shard->migrated   = 0;
+    }
+  }
+}
+
+/**
+ * Double the number of buckets of the shard. The entries are migrated with
+ * the following write accesses.
+ *
+ * @param shard The shard, MUST be write locked.
+ */
+static void _growShard(UC_TableShard* shard)
+{
+  uint32_t noBuckets = (shard->mask + 1) * 2;
+  void**   buckets   = calloc(noBuckets, sizeof(void*));
+
+  if (buckets == NULL)
+  {
+    // Not critical, the chains just get longer.
+    LOG(LEVEL_WARNING, HDR "Not enough memory to grow the hash table to %u "
+                       "buckets!", pthread_self(), noBuckets);
+    return;
+  }
+  addMemStats(MEM_TAG_UPDATES, noBuckets * sizeof(void*), 1);
+  // A previous resize must be completed first.
+  _migrateBuckets(shard, shard->oldMask + 1);
+  shard->oldBuckets = shard->buckets;
+  shard->oldMask    = shard->mask;
+  shard->migrated   = 0;
+  shard->buckets    = buckets;
+  shard->mask       = noBuckets - 1;
+}
+
+/**
+ * Lock all shards of the table in ascending order.
+ *
+ * @param self The update cache.
+ * @param write Acquire write locks instead of read locks.
+ */
+static void _lockTable(UpdateCache* self, bool write)
+{
+  int idx;
+
+  for (idx = 0; idx < UC_TABLE_SHARDS; idx++)
+  {
+    if (write)
+    {
+      acquireWriteLock(&self->shards[idx].lock);
+    }
+    else
+    {
+      acquireReadLock(&self->shards[idx].lock);
+    }
+  }
+}
+
+/**
+ * Unlock all shards locked using _lockTable.
+ *
+ * @param self The update cache.
+ * @param write The shards are write locked.
+ */
+static void _unlockTable(UpdateCache* self, bool write)
+{
+  int idx;
+
+  for (idx = UC_TABLE_SHARDS - 1; idx >= 0; idx--)
+  {
+    if (write)
+    {
+      unlockWriteLock(&self->shards[idx].lock);
+    }
+    else
+    {
+      unlockReadLock(&self->shards[idx].lock);
+    }
+  }
+}
+
+/**
+ * Return the next entry of the table walk. Entries MUST NOT be added or 
+ * removed during the walk.
+ *
+ * @param self The update cache, all shards MUST be locked.
+ * @param cursor The cursor of the walk. For the first call the cursor MUST be
+ *               set to all zero.
+ *
+ * @return The next entry or NULL if all entries are walked.
+ */
+static CacheEntry* _tableNext(UpdateCache* self, TableCursor* cursor)
+{
+  UC_TableShard* shard;
+
+  if (cursor->entry != NULL)
+  {
+    cursor->entry = cursor->entry->next;
+    if (cursor->entry != NULL)
+    {
+      return cursor->entry;
+    }
+    cursor->bucket++;
+  }
+
+  while (cursor->shard < UC_TABLE_SHARDS)
+  {
+    shard = &self->shards[cursor->shard];
+    if (!cursor->old)
+    {
+      for (; cursor->bucket <= shard->mask; cursor->bucket++)
+      {
+        if (shard->buckets[cursor->bucket] != NULL)
+        {
+          cursor->entry = (CacheEntry*)shard->buckets[cursor->bucket];
+          return cursor->entry;
+        }
+      }
+      // Continue with the buckets not migrated yet.
+      cursor->old    = true;
+      cursor->bucket = shard->migrated;
+    }
+    if (shard->oldBuckets != NULL)
+    {
+      for (; cursor->bucket <= shard->oldMask; cursor->bucket++)
+      {
+        if (shard->oldBuckets[cursor->bucket] != NULL)
+        {
+          cursor->entry = (CacheEntry*)shard->oldBuckets[cursor->bucket];
+          return cursor->entry;
+        }
+      }
+    }
+    cursor->shard++;
+    cursor->old    = false;
+    cursor->bucket = 0;
+  }
+
+  return NULL;
+}
+
+/**
+ * Search the bucket chain for the update with the given update id.
+ *
+ * @param cEntry The first entry of the chain.
+ * @param updateID The update ID to search for.
+ *
+ * @return The entry or NULL if not found.
+ */
+static CacheEntry* _findInChain(CacheEntry* cEntry, SRxUpdateID updateID)
+{
+  while ((cEntry != NULL) && (cEntry->updateID != updateID))
+  {
+    cEntry = cEntry->next;
+  }
+  return cEntry;
+}
+
+/**
+ * Unlock the shard locked by tableFind.
+ *
+ * @param shard The shard.
+ * @param write The shard is write locked.
+ */
+static void _unlockShard(UC_TableShard* shard, bool write)
+{
+  if (write)
+  {
+    unlockWriteLock(&shard->lock);
+  }
+  else
+  {
+    unlockReadLock(&shard->lock);
+  }
+}
+
+/**
+ * This method searches the cache for the update with the given update id.
+ * if found the result is written into the out pointer. The shard of the
+ * update id stays locked, found or not, and MUST be unlocked using
+ * _unlockShard once the update is not used anymore.
+ * 
+ * @param self The reference for the update cache
+ * @param updateID The update ID to search for.
+ * @param write Write lock the shard to modify the update or the shard.
+ * @param shard OUT - The locked shard of the update id.
+ * @param out the cache entry containing the update in case it was found.
+ * 
+ * @return true if the update was found, otherwise false.
+ */
+static bool tableFind(UpdateCache* self, SRxUpdateID updateID, bool write,
+                      UC_TableShard** shard, CacheEntry** out)
+{
+  uint32_t     hash = _tableHash(updateID);
+  CacheEntry** bucket;
+
+  *shard = _tableShard(self, hash);
+  *out   = NULL;
+  if (write)
+  {
+    acquireWriteLock(&(*shard)->lock);
+  }
+  else
+  {
+    acquireReadLock(&(*shard)->lock);
+  }
+  // Entries not migrated yet are in the old bucket, all others in the new one.
+  bucket = _tableBucket(*shard, hash, true);
+  if (bucket != NULL)
+  {
+    *out = _findInChain(*bucket, updateID);
+  }
+  if (*out == NULL)
+  {
+    *out = _findInChain(*_tableBucket(*shard, hash, false), updateID);
+  }
+
+  return (*out != NULL);
+}
+
+/**
+ * Add the update encapsulated in the cache entry element into the cache. The 
+ * key is the updateID and the value is the cache entry containing the update 
+ * information.
+ * 
+ * @param shard The shard of the update, MUST be write locked.
+ * @param cEntry the update to be stored.
+ */
+static void tableAdd(UC_TableShard* shard, CacheEntry* cEntry)
+{
+  uint32_t     hash = _tableHash(cEntry->updateID);
+  CacheEntry** bucket;
+
+  _migrateBuckets(shard, SHARD_MIGRATE_STEP);
+  // New entries always go into the new buckets.
+  bucket       = _tableBucket(shard, hash, false);
+  cEntry->next = *bucket;
+  *bucket      = cEntry;
+  shard->size++;
+  if ((shard->size > shard->mask + 1) && (shard->oldBuckets == NULL))
+  {
+    _growShard(shard);
+  }
+}
+
+/**
+ * Remove the update entry from the update cache. This method does NOT release
+ * the memory attached to the cache entry!!!
+ * 
+ * @param shard The shard of the update, MUST be write locked.
+ * @param cEntry the entry containing the update information.
+ */
+static void tableDel(UC_TableShard* shard, CacheEntry* cEntry)
+{
+  uint32_t     hash = _tableHash(cEntry->updateID);
+  CacheEntry** link = NULL;
+
+  _migrateBuckets(shard, SHARD_MIGRATE_STEP);
+  link = _tableBucket(shard, hash, true);
+  while ((link != NULL) && (*link != NULL) && (*link != cEntry))
+  {
+    link = &(*link)->next;
+  }
+  if ((link == NULL) || (*link == NULL))
+  {
+    link = _tableBucket(shard, hash, false);
+    while ((*link != NULL) && (*link != cEntry))
+    {
+      link = &(*link)->next;
+    }
+  }
+  if (*link != NULL)
+  {
+    *link = cEntry->next;
+    cEntry->next = NULL;
+    shard->size--;
+  }
+}  
+
+/**
+ * Release the locks and buckets of the given number of shards.
+ *
+ * @param self The update cache.
+ * @param noShards The number of shards to release, starting with the first.
+ */
+static void _releaseShards(UpdateCache* self, int noShards)
+{
+  int idx;
+
+  for (idx = 0; idx < noShards; idx++)
+  {
+    releaseRWLock(&self->shards[idx].lock);
+    addMemStats(MEM_TAG_UPDATES,
+                -(int64_t)((self->shards[idx].mask + 1) * sizeof(void*)), -1);
+    if (self->shards[idx].oldBuckets != NULL)
+    {
+      addMemStats(MEM_TAG_UPDATES,
+                  -(int64_t)((self->shards[idx].oldMask + 1) * sizeof(void*)),
+                  -1);
+    }
+    free(self->shards[idx].buckets);
+    free(self->shards[idx].oldBuckets);
+    self->shards[idx].buckets    = NULL;
+    self->shards[idx].oldBuckets = NULL;
+  }
+}
+
+/*---------------------
+ * Change log functions
+ */
+
+/**
+ * Report the final results of the given updates. Each update is looked up
+ * with its shard write locked, the callback is called without any lock for
+ * at most CHANGE_LOG_BATCH updates.
+ *
+ * @param self The update cache.
+ * @param ids The ids of the logged updates.
+ * @param count The number of ids.
+ */
+static void _reportChanges(UpdateCache* self, SRxUpdateID* ids, uint32_t count)
+{
+  SRxValidationResult results[CHANGE_LOG_BATCH];
+  SRxValidationResult* valRes;
+  CacheEntry*    cEntry;
+  UC_TableShard* shard;
+  uint32_t    noResults;
+  uint32_t    pos;
+  uint32_t    idx;
+
+  for (pos = 0; pos < count; pos += CHANGE_LOG_BATCH)
+  {
+    noResults = 0;
+    for (idx = pos; (idx < count) && (idx < pos + CHANGE_LOG_BATCH); idx++)
+    {
+      // The update might be deleted in the meantime.
+      if (   !tableFind(self, ids[idx], true, &shard, &cEntry)
+          || (cEntry->changeFlags == 0))
+      {
+        _unlockShard(shard, true);
+        continue;
+      }
+      valRes = &results[noResults];
+      valRes->updateID  = ids[idx];
+      valRes->valType   = 0;
+      valRes->valResult = cEntry->srxResult;
+      // Only report results that differ after all changes.
+      if (   (cEntry->changeFlags & SRX_FLAG_ROA)
+          && (cEntry->srxResult.roaResult 
+              != cEntry->reportedResult.roaResult))
+      {
+        valRes->valType |= SRX_FLAG_ROA;
+      }
+      if (   (cEntry->changeFlags & SRX_FLAG_BGPSEC)
+          && (cEntry->srxResult.bgpsecResult 
+              != cEntry->reportedResult.bgpsecResult))
+      {
+        valRes->valType |= SRX_FLAG_BGPSEC;
+      }
+      cEntry->changeFlags = 0;
+      _unlockShard(shard, true);
+      if (valRes->valType != 0)
+      {
+        noResults++;
+      }
+    }
+
+    if ((self->resBatchCallback != NULL) && (noResults > 0))
+    {
+      self->resBatchCallback(results, noResults);
+    }
+    else
+    {
+      for (idx = 0; idx < noResults; idx++)
+      {
+        self->resChangedCallback(&results[idx]);
+      }
+    }
+  }
+}
+
+/**
+ * The thread of the change log. It takes all logged updates at once and
+ * reports them while new changes are logged into the other buffer.
+ *
+ * @param data The update cache.
+ *
+ * @return NULL
+ */
+static void* _changeLogLoop(void* data)
+{
+  UpdateCache*  self = (UpdateCache*)data;
+  UC_ChangeLog* log  = &self->changeLog;
+  SRxUpdateID*  ids  = NULL;
+  SRxUpdateID*  tmpIDs;
+  uint32_t      size = 0;
+  uint32_t      tmpSize;
+  uint32_t      count;
+
+  lockMutex(&log->mutex);
+  while (log->running)
+  {
+    if (log->count == 0)
+    {
+      waitCond(&log->cond, &log->mutex, 0);
+      continue;
+    }
+    // Swap the buffers
+    tmpIDs     = log->ids;
+    tmpSize    = log->size;
+    count      = log->count;
+    log->ids   = ids;
+    log->size  = size;
+    log->count = 0;
+    ids        = tmpIDs;
+    size       = tmpSize;
+    unlockMutex(&log->mutex);
+
+    _reportChanges(self, ids, count);
+
+    lockMutex(&log->mutex);
+  }
+  unlockMutex(&log->mutex);
+  free(ids);
+
+  return NULL;
+}
+
+/**
+ * Log the update for reporting. The shard of the update MUST be write locked.
+ *
+ * @param self The update cache.
+ * @param cEntry The update whose result changed.
+ * @param oldResult The result before the change.
+ * @param flags The results that changed.
+ *
+ * @return false if the update could not be logged.
+ */
+static bool _logChange(UpdateCache* self, CacheEntry* cEntry, 
+                       SRxResult* oldResult, uint8_t flags)
+{
+  UC_ChangeLog* log = &self->changeLog;
+  SRxUpdateID*  ids;
+  bool          retVal = true;
+
+  if (cEntry->changeFlags != 0)
+  {
+    // Already logged, it reports the final result anyhow.
+    cEntry->changeFlags |= flags;
+    return true;
+  }
+
+  lockMutex(&log->mutex);
+  if (log->count == log->size)
+  {
+    ids = realloc(log->ids, (log->size > 0 ? log->size * 2 
+                                           : CHANGE_LOG_INIT_SIZE)
+                            * sizeof(SRxUpdateID));
+    if (ids == NULL)
+    {
+      retVal = false;
+    }
+    else
+    {
+      log->ids  = ids;
+      log->size = log->size > 0 ? log->size * 2 : CHANGE_LOG_INIT_SIZE;
+    }
+  }
+  if (retVal)
+  {
+    log->ids[log->count++] = cEntry->updateID;
+    cEntry->reportedResult = *oldResult;
+    cEntry->changeFlags    = flags;
+    signalCond(&log->cond);
+  }
+  unlockMutex(&log->mutex);
+
+  return retVal;
+}
+
+/**
+ * Start the thread of the change log.
+ *
+ * @param self The update cache.
+ *
+ * @return true if the thread runs.
+ */
+static bool _startChangeLog(UpdateCache* self)
+{
+  UC_ChangeLog* log = &self->changeLog;
+
+  memset(log, 0, sizeof(UC_ChangeLog));
+  if (!initMutex(&log->mutex))
+  {
+    return false;
+  }
+  if (!initCond(&log->cond))
+  {
+    releaseMutex(&log->mutex);
+    return false;
+  }
+  log->running = true;
+  if (createThread(&log->thread, NULL, THREAD_CLASS_HOUSEKEEPING,
+                   "srx-changelog", _changeLogLoop, self) != 0)
+  {
+    log->running = false;
+    destroyCond(&log->cond);
+    releaseMutex(&log->mutex);
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Stop the thread of the change log. Changes not reported yet are dropped.
+ *
+ * @param self The update cache.
+ */
+static void _stopChangeLog(UpdateCache* self)
+{
+  UC_ChangeLog* log = &self->changeLog;
+
+  lockMutex(&log->mutex);
+  log->running = false;
+  signalCond(&log->cond);
+  unlockMutex(&log->mutex);
+  pthread_join(log->thread, NULL);
+
+  free(log->ids);
+  log->ids = NULL;
+  destroyCond(&log->cond);
+  releaseMutex(&log->mutex);
+}
+
+/**
+ * Checks if any client references the update. The shard of the update MUST be
+ * locked.
+ *
+ * @param cEntry The update.
+ *
+ * @return true if at least one client references the update.
+ */
+static bool _hasClients(CacheEntry* cEntry)
+{
+  return cEntry->noClients > 0;
+}
+
+/**
+ * Move the expired updates of the timer wheel to the end of the expired list.
+ * The item mutex MUST be locked.
+ *
+ * @param self The update cache.
+ * @param now The current time in seconds.
+ */
+static void _gcTakeExpired(UpdateCache* self, uint64_t now)
+{
+  UC_GarbageCollector* gc    = &self->gc;
+  TimerWheelEntry*     entry = advanceTimerWheel(&gc->wheel, now);
+
+  *gc->expiredTail = entry;
+  while (entry != NULL)
+  {
+    GC_CACHE_ENTRY(entry)->gcExpired = true;
+    gc->expiredTail = &entry->next;
+    entry = entry->next;
+  }
+}
+
+/**
+ * Select the next batch of updates to be collected from the expired list.
+ * Updates that got referenced again are dropped, updates whose keep time got
+ * extended are scheduled again. The selected updates stay marked as expired,
+ * collectUpdate does not release them. The item mutex and the shards MUST NOT
+ * be locked.
+ *
+ * @param self The update cache.
+ * @param now The current time in seconds.
+ * @param batch OUT - The updates to be collected.
+ * @param removals OUT - The updates to be removed from the prefix cache.
+ *
+ * @return The number of updates selected.
+ */
+static uint32_t _gcSelectBatch(UpdateCache* self, uint64_t now, 
+                               CacheEntry** batch, PC_UpdateRemoval* removals)
 {
-  bool retVal = false;
-  
-  if (cEntry->blob == NULL)
+  UC_GarbageCollector* gc = &self->gc;
+  TimerWheelEntry*     entry;
+  CacheEntry*          cEntry;
+  UC_TableShard*       shard;
+  uint32_t             noBatch = 0;
+
+  while (noBatch < GC_BATCH_SIZE)
   {
-    if (bgpsecData->attr_length != 0)
+    lockMutex(&self->itemMutex);
+    entry = gc->expired;
+    if (entry != NULL)
     {
-      cEntry->blobLength = bgpsecData->attr_length;
-      cEntry->blob = malloc(cEntry->blobLength);
-      if (cEntry->blob != NULL)
+      gc->expired = entry->next;
+      if (gc->expired == NULL)
       {
-        memcpy(cEntry->blob, bgpsecData->bgpsec_path_attr, cEntry->blobLength);
-        retVal = true;
+        gc->expiredTail = &gc->expired;
       }
+      entry->next = NULL;
     }
-    else
+    unlockMutex(&self->itemMutex);
+    if (entry == NULL)
     {
-      cEntry->blobLength = bgpsecData->numberHops * 4;
-      cEntry->blob = malloc(cEntry->blobLength);
-      if (cEntry->blob != NULL)
+      break;
+    }
+
+    // Only the collector releases an expired update, it stays valid.
+    cEntry = GC_CACHE_ENTRY(entry);
+    shard  = _tableShard(self, _tableHash(cEntry->updateID));
+    acquireReadLock(&shard->lock);
+    if (_hasClients(cEntry) || (entry->expires > now))
+    {
+      lockMutex(&self->itemMutex);
+      cEntry->gcExpired = false;
+      if (!_hasClients(cEntry))
       {
-        memcpy(cEntry->blob, bgpsecData->asPath, cEntry->blobLength);
-        retVal = true;
+        addToTimerWheel(&gc->wheel, entry, entry->expires);
       }
+      unlockMutex(&self->itemMutex);
+    }
+    else
+    {
+      removals[noBatch].updateID = cEntry->updateID;
+      removals[noBatch].as       = cEntry->asn;
+      cpyPrefix(&removals[noBatch].prefix, &cEntry->prefix);
+      batch[noBatch++] = cEntry;
     }
+    unlockReadLock(&shard->lock);
   }
-  
-  return retVal;
+
+  return noBatch;
 }
 
-/*---------------------
- * Hash-table functions
- *
- * @note Uses R/W lock
- */
 /**
- * This method searches the cache for the update with the given update id.
- * if found the result is written into the out pointer.
- * 
- * @param self The reference for the update cache
- * @param updateID The update ID to search for.
- * @param out the cache entry containing the update in case it was found.
- * 
- * @return true if the update was found, otherwise false.
+ * Remove the given update from the update cache and release it. The update
+ * MUST NOT have clients and MUST NOT be marked as expired unless the garbage
+ * collector releases it. Its shard MUST be write locked and the item mutex
+ * MUST be locked.
+ *
+ * @param self The update cache.
+ * @param shard The shard of the update.
+ * @param cEntry The update.
  */
-static bool tableFind(UpdateCache* self, SRxUpdateID updateID, CacheEntry** out) 
+static void _collectEntry(UpdateCache* self, UC_TableShard* shard,
+                          CacheEntry* cEntry)
 {
-  acquireReadLock(&self->tableLock);
-  HASH_FIND(hh, (CacheEntry*)self->table, &updateID, sizeof(SRxUpdateID), 
-            (*out));
-  unlockReadLock(&self->tableLock);
+  UC_GarbageCollector* gc = &self->gc;
 
-  return (*out != NULL);
+  if (self->replication != NULL)
+  {
+    replicateUpdateCollect(self->replication, &cEntry->updateID,
+                           &cEntry->prefix, cEntry->asn);
+  }
+  removeFromTimerWheel(&gc->wheel, &cEntry->gcEntry);
+  tableDel(shard, cEntry);
+  __sync_sub_and_fetch(&self->numUpdates, 1);
+  gc->collected++;
+  releaseBlob(&self->blobStore, cEntry->blob);
+  freeToMemPool(&self->entryPool, cEntry);
 }
 
 /**
- * Add the update encapsulated in the cache entry element into the cache. The 
- * key is the updateID and the value is the cache entry containing the update 
- * information.
- * 
- * @param self the update cache.
- * @param cEntry the update to be stored.
+ * Run the garbage collector once. The expired updates are removed from the 
+ * prefix cache without holding any lock, then from the update cache, each
+ * under the write lock of its shard. Updates that got referenced again in the
+ * meantime are kept and validated again. The collector mutex MUST be locked.
+ *
+ * @param self The update cache.
  */
-static void tableAdd(UpdateCache* self, CacheEntry* cEntry) 
+static void _collectGarbage(UpdateCache* self)
 {
-  acquireWriteLock(&self->tableLock);
-  HASH_ADD(hh, *((CacheEntry**)&self->table), updateID, sizeof(SRxUpdateID), 
-           cEntry);
-  unlockWriteLock(&self->tableLock);
+  UC_GarbageCollector* gc = &self->gc;
+  CacheEntry*          batch[GC_BATCH_SIZE];
+  PC_UpdateRemoval     removals[GC_BATCH_SIZE];
+  CacheEntry*          cEntry;
+  UC_TableShard*       shard;
+  struct timespec      start;
+  struct timespec      current;
+  uint64_t             now;
+  uint64_t             elapsed;
+  uint32_t             noBatch;
+  uint32_t             idx;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  lockMutex(&self->itemMutex);
+  now = (uint64_t)time(NULL);
+  _gcTakeExpired(self, now);
+  unlockMutex(&self->itemMutex);
+
+  while ((noBatch = _gcSelectBatch(self, now, batch, removals)) > 0)
+  {
+    if (gc->prefixCache != NULL)
+    {
+      removeUpdates((PrefixCache*)gc->prefixCache, removals, noBatch);
+    }
+
+    for (idx = 0; idx < noBatch; idx++)
+    {
+      cEntry = batch[idx];
+      shard  = _tableShard(self, _tableHash(cEntry->updateID));
+      acquireWriteLock(&shard->lock);
+      lockMutex(&self->itemMutex);
+      if (_hasClients(cEntry))
+      {
+        // Referenced again, it is validated again below.
+        cEntry->gcExpired = false;
+      }
+      else
+      {
+        removals[idx].removed = false;
+        _collectEntry(self, shard, cEntry);
+      }
+      unlockMutex(&self->itemMutex);
+      unlockWriteLock(&shard->lock);
+    }
+
+    for (idx = 0; idx < noBatch; idx++)
+    {
+      if (removals[idx].removed)
+      {
+        requestUpdateValidation((PrefixCache*)gc->prefixCache, 
+                                &removals[idx].updateID, &removals[idx].prefix, 
+                                removals[idx].as);
+      }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &current);
+    elapsed = ((uint64_t)(current.tv_sec - start.tv_sec) * 1000)
+              + ((current.tv_nsec - start.tv_nsec) / 1000000);
+    if (elapsed >= gc->budget)
+    {
+      // The rest waits for the next run.
+      break;
+    }
+  }
 }
 
 /**
- * Remove the update entry from the update cache. This method does NOT release
- * the memory attached to the cache entry!!!
- * 
- * @param self The update cache.
- * @param cEntry the entry containing the update information.
+ * The thread of the garbage collector. It collects once a second.
+ *
+ * @param data The update cache.
+ *
+ * @return NULL
  */
-static void tableDel(UpdateCache* self, CacheEntry* cEntry) 
+static void* _gcLoop(void* data)
 {
-  acquireWriteLock(&self->tableLock);
-  HASH_DEL(*((CacheEntry**)&self->table), cEntry);
-  unlockWriteLock(&self->tableLock);
-}  
+  UpdateCache*         self = (UpdateCache*)data;
+  UC_GarbageCollector* gc   = &self->gc;
+
+  lockMutex(&gc->mutex);
+  while (gc->running)
+  {
+    waitCond(&gc->cond, &gc->mutex, 1000);
+    if (gc->running)
+    {
+      _collectGarbage(self);
+    }
+  }
+  unlockMutex(&gc->mutex);
+
+  return NULL;
+}
 
 /*--------
  * Exports
@@ -224,47 +1250,282 @@ static void tableDel(UpdateCache* self, CacheEntry* cEntry)
 bool createUpdateCache(UpdateCache* self, UpdateResultChanged chCallback, 
                        uint8_t minNumberOfUpdates, Configuration* sysConfig) 
 {
+  UC_TableShard* shard;
+  uint32_t       buckets = SHARD_INIT_BUCKETS;
+  int            idx;
+
+  // Size the shards for one update per bucket, the first full table load 
+  // then does not resize them.
+  while (   (sysConfig != NULL) && (buckets < SHARD_MAX_INIT_BUCKETS)
+         && (buckets * UC_TABLE_SHARDS < sysConfig->expectedUpdates))
+  {
+    buckets <<= 1;
+  }
+
   if (!initMutex(&self->itemMutex)) 
   {
     RAISE_ERROR("Unable to setup the item Mutex");
     return false;
   }
-  if (!createRWLock(&self->tableLock)) 
+  if (!initMutex(&self->indexMutex))
+  {
+    RAISE_ERROR("Unable to setup the client index Mutex");
+    releaseMutex(&self->itemMutex);
+    return false;
+  }
+  memset(self->shards, 0, sizeof(self->shards));
+  for (idx = 0; idx < UC_TABLE_SHARDS; idx++)
   {
-    RAISE_ERROR("Unable to setup the hash table r/w lock");
+    shard = &self->shards[idx];
+    // Written instead of calloc'ed to fault the pages in now.
+    shard->buckets = malloc(buckets * sizeof(void*));
+    if (shard->buckets != NULL)
+    {
+      memset(shard->buckets, 0, buckets * sizeof(void*));
+      addMemStats(MEM_TAG_UPDATES, buckets * sizeof(void*), 1);
+    }
+    if ((shard->buckets == NULL) || !createRWLock(&shard->lock)) 
+    {
+      RAISE_ERROR("Unable to setup the hash table shards");
+      free(shard->buckets);
+      _releaseShards(self, idx);
+      releaseMutex(&self->indexMutex);
+      releaseMutex(&self->itemMutex);
+      return false;
+    }
+    shard->mask = buckets - 1;
+    setLockName(&shard->lock, "updateCache.shard.lock");
+  }
+  setLockName(&self->itemMutex, "updateCache.itemMutex");
+  setLockName(&self->indexMutex, "updateCache.indexMutex");
+
+  memset(&self->gc, 0, sizeof(UC_GarbageCollector));
+  if (!initMutex(&self->gc.mutex))
+  {
+    RAISE_ERROR("Unable to setup the garbage collector Mutex");
+    _releaseShards(self, UC_TABLE_SHARDS);
+    releaseMutex(&self->indexMutex);
+    releaseMutex(&self->itemMutex);
+    return false;
+  }
+  if (!initCond(&self->gc.cond))
+  {
+    RAISE_ERROR("Unable to setup the garbage collector condition");
+    releaseMutex(&self->gc.mutex);
+    _releaseShards(self, UC_TABLE_SHARDS);
+    releaseMutex(&self->indexMutex);
+    releaseMutex(&self->itemMutex);
+    return false;
+  }
+  initTimerWheel(&self->gc.wheel, (uint64_t)time(NULL));
+  self->gc.expiredTail = &self->gc.expired;
+  self->gc.budget      = sysConfig != NULL ? sysConfig->gcTimeBudget : 0;
+
+  if (!generateSipHashKey(self->fpKey))
+  {
+    LOG(LEVEL_WARNING, "Could not read /dev/urandom, the update fingerprints "
+                       "use a key derived from the time!");
+  }
+  if (!initBlobStore(&self->blobStore))
+  {
+    RAISE_ERROR("Unable to setup the blob store");
+    destroyCond(&self->gc.cond);
+    releaseMutex(&self->gc.mutex);
+    _releaseShards(self, UC_TABLE_SHARDS);
+    releaseMutex(&self->indexMutex);
+    releaseMutex(&self->itemMutex);
+    return false;
+  }
+
+  if (!_startChangeLog(self))
+  {
+    RAISE_ERROR("Unable to start the change log");
+    releaseBlobStore(&self->blobStore);
+    destroyCond(&self->gc.cond);
+    releaseMutex(&self->gc.mutex);
+    _releaseShards(self, UC_TABLE_SHARDS);
+    releaseMutex(&self->indexMutex);
     releaseMutex(&self->itemMutex);
     return false;
   }
 
   self->resChangedCallback = chCallback;
-  // By default keep the hashtable null, it will be initialized with the first 
-  // element that will be added.
-  self->table = NULL;
-  self->itemsUsed = NUM_PREALLOC;
+  self->resBatchCallback   = NULL;
+  self->replication        = NULL;
+  self->numUpdates = 0;
   self->minNumberOfClients = DEFAULT_NUMBER_CLIENTS;
-  self->lockedClients = malloc(MAX_PROXY_CLIENT_ELEMENTS);
-  memset(self->lockedClients, false, MAX_PROXY_CLIENT_ELEMENTS);
+  self->lockedClients = calloc(MAX_PROXY_CLIENT_ELEMENTS, sizeof(uint32_t));
+  self->clientIndex   = calloc(MAX_PROXY_CLIENT_ELEMENTS, 
+                               sizeof(UC_ClientIndex));
+  if ((self->lockedClients == NULL) || (self->clientIndex == NULL))
+  {
+    RAISE_ERROR("Unable to setup the client index");
+    free(self->lockedClients);
+    free(self->clientIndex);
+    _stopChangeLog(self);
+    releaseBlobStore(&self->blobStore);
+    destroyCond(&self->gc.cond);
+    releaseMutex(&self->gc.mutex);
+    _releaseShards(self, UC_TABLE_SHARDS);
+    releaseMutex(&self->indexMutex);
+    releaseMutex(&self->itemMutex);
+    return false;
+  }
+  addMemStats(MEM_TAG_CLIENTS,
+              MAX_PROXY_CLIENT_ELEMENTS
+              * (sizeof(uint32_t) + sizeof(UC_ClientIndex)), 2);
   
   self->sysConfig = sysConfig;
-    
-  initSList(&self->allItems);
+
+  // Size the entry slabs using the expected number of updates. Large caches
+  // grow in large steps, small caches do not waste memory.
+  uint32_t expected = sysConfig != NULL ? sysConfig->expectedUpdates : 0;
+  uint32_t slabObjs = expected / 16;
+  slabObjs = slabObjs < ENTRY_SLAB_MIN ? ENTRY_SLAB_MIN
+                                       : slabObjs > ENTRY_SLAB_MAX 
+                                         ? ENTRY_SLAB_MAX : slabObjs;
+  initMemPool(&self->entryPool, sizeof(CacheEntry), slabObjs);
+  setMemPoolTag(&self->entryPool, MEM_TAG_UPDATES);
+
+  if ((expected > 0) && !reserveMemPool(&self->entryPool, expected))
+  {
+    LOG(LEVEL_WARNING, HDR "Could not pre-allocate memory for %u updates!",
+                       pthread_self(), expected);
+  }
 
   return true;
 }
 
+/**
+ * Register the callback that is called with the batches of changed results
+ * reported by the change log. If not set, resChangedCallback is called for
+ * each changed result.
+ *
+ * @param self The update cache
+ * @param callback The batch callback or NULL.
+ *
+ * @since 0.4.1.0
+ */
+void setUpdateResultsChangedCallback(UpdateCache* self, 
+                                     UpdateResultsChanged callback)
+{
+  self->resBatchCallback = callback;
+}
+
+/**
+ * Attach the replication to the standby server. The stored and collected
+ * updates and the changed validation results are handed to it.
+ *
+ * @param self The update cache
+ * @param replication The replication or NULL.
+ *
+ * @since 0.4.1.0
+ */
+void setUpdateCacheReplication(UpdateCache* self,
+                               struct _Replication* replication)
+{
+  // The updates use the replication while their shard is locked.
+  _lockTable(self, true);
+  self->replication = replication;
+  _unlockTable(self, true);
+}
+
+/**
+ * Start the thread of the garbage collector. It removes the updates without
+ * client from the given prefix cache as well. The time budget is taken from
+ * the system configuration.
+ *
+ * @param self The update cache
+ * @param prefixCache The prefix cache (PrefixCache*) that validates the 
+ *                    updates.
+ *
+ * @return true if the garbage collector runs.
+ *
+ * @since 0.4.1.0
+ */
+bool startUpdateCacheGC(UpdateCache* self, void* prefixCache)
+{
+  UC_GarbageCollector* gc = &self->gc;
+  bool retVal = true;
+
+  lockMutex(&gc->mutex);
+  if (!gc->running)
+  {
+    gc->prefixCache = prefixCache;
+    gc->running     = true;
+    if (createThread(&gc->thread, NULL, THREAD_CLASS_HOUSEKEEPING, "srx-gc",
+                     _gcLoop, self) != 0)
+    {
+      RAISE_SYS_ERROR("Could not start the garbage collector!");
+      gc->running = false;
+      retVal      = false;
+    }
+  }
+  unlockMutex(&gc->mutex);
+
+  return retVal;
+}
+
+/**
+ * Stop the thread of the garbage collector. MUST be called before the prefix
+ * cache given to startUpdateCacheGC is released. Does nothing if the garbage
+ * collector does not run.
+ *
+ * @param self The update cache
+ *
+ * @since 0.4.1.0
+ */
+void stopUpdateCacheGC(UpdateCache* self)
+{
+  UC_GarbageCollector* gc = &self->gc;
+  bool running;
+
+  lockMutex(&gc->mutex);
+  running     = gc->running;
+  gc->running = false;
+  signalCond(&gc->cond);
+  unlockMutex(&gc->mutex);
+
+  if (running)
+  {
+    pthread_join(gc->thread, NULL);
+  }
+  gc->prefixCache = NULL;
+}
+
 //TODO: Documentation
 void releaseUpdateCache(UpdateCache* self) 
 {
+  int idx;
+
   RAISE_ERROR("Release Update Cache also should empty the cache first!");
   if (self != NULL) 
   {
-    releaseRWLock(&self->tableLock);
-    releaseMutex(&self->itemMutex);
-
-    // Empty cache first
+    // Stop reporting and collecting, then empty the cache
+    _stopChangeLog(self);
+    stopUpdateCacheGC(self);
     emptyUpdateCache(self);
+    _releaseShards(self, UC_TABLE_SHARDS);
+    destroyCond(&self->gc.cond);
+    releaseMutex(&self->gc.mutex);
+    releaseMutex(&self->indexMutex);
+    releaseMutex(&self->itemMutex);
     free(self->lockedClients);
-    releaseSList(&self->allItems);
+    for (idx = 0; idx < MAX_PROXY_CLIENT_ELEMENTS; idx++)
+    {
+      if (self->clientIndex[idx].ids != NULL)
+      {
+        addMemStats(MEM_TAG_CLIENTS, -(int64_t)(self->clientIndex[idx].size
+                                                * sizeof(SRxUpdateID)), -1);
+      }
+      free(self->clientIndex[idx].ids);
+    }
+    free(self->clientIndex);
+    addMemStats(MEM_TAG_CLIENTS,
+                -(int64_t)(MAX_PROXY_CLIENT_ELEMENTS
+                           * (sizeof(uint32_t) + sizeof(UC_ClientIndex))), -2);
+    releaseMemPool(&self->entryPool);
+    releaseBlobStore(&self->blobStore);
   }
 }
 
@@ -295,15 +1556,17 @@ bool getUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
 {
   // The cache entry also need the addition of source and predefined result.
   CacheEntry* cEntry = NULL;
+  UC_TableShard* shard;
   // By default declare the update as not found
   bool retVal = false;
+  bool assigned = false;
   // This seems to be silly at this point but it might be that the id will 
   // become MD5 or even more. For this we accept a pointer to the structure
   // but store it as value only. See documentation for SRxUpdateID for more info
   SRxUpdateID updID = *updateID;
 
-  // Look for the update
-  if (tableFind(self, updID, &cEntry)) 
+  // Look for the update, registering the client modifies it.
+  if (tableFind(self, updID, clientID > 0, &shard, &cEntry))
   {
     // Prefix Origin values
     srxRes->roaResult               = cEntry->srxResult.roaResult;
@@ -318,8 +1581,8 @@ bool getUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
     if (clientID > 0)
     {
       // Register the update with the client!
-      _addClientReference(self, cEntry, clientID, 
-                          (ProxyClientMapping*)clientMapping);
+      assigned = _addClientReference(self, cEntry, clientID,
+                                     (ProxyClientMapping*)clientMapping);
     }
     
     retVal = true;
@@ -335,84 +1598,165 @@ bool getUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
     defaultRes->resSourceBGPSEC     = SRxRS_DONOTUSE;
     defaultRes->result.bgpsecResult = SRx_RESULT_DONOTUSE;
   }
+  _unlockShard(shard, clientID > 0);
+
+  if (assigned)
+  {
+    _indexClientUpdate(self, clientID, updID);
+  }
 
   return retVal;
 }
 
 /**
- * Assign the given client to the cache entry. This method extends the memory
- * if needed.
+ * Compare two update ids. Used to sort the client index.
+ *
+ * @param elem1 The first update id.
+ * @param elem2 The second update id.
+ *
+ * @return <0, 0, or >0 like memcmp.
+ */
+static int _compareUpdateIDs(const void* elem1, const void* elem2)
+{
+  SRxUpdateID id1 = *(const SRxUpdateID*)elem1;
+  SRxUpdateID id2 = *(const SRxUpdateID*)elem2;
+
+  return id1 < id2 ? -1 : id1 > id2 ? 1 : 0;
+}
+
+/**
+ * Drop the stale and duplicate ids of the client index. An id is kept if the 
+ * client is still assigned to the update. The index mutex MUST be locked, the
+ * shards MUST NOT be locked.
+ * 
+ * @param self The update cache.
+ * @param clientID The client whose index is compacted.
+ * 
+ * @since 0.4.1.0
+ */
+static void _compactClientIndex(UpdateCache* self, uint8_t clientID)
+{
+  UC_ClientIndex* index = &self->clientIndex[clientID];
+  UC_TableShard*  shard;
+  CacheEntry*     cEntry;
+  uint32_t        kept  = 0;
+  uint32_t        idx;
+
+  // Sorted, the duplicates of an id follow each other.
+  qsort(index->ids, index->count, sizeof(SRxUpdateID), _compareUpdateIDs);
+  for (idx = 0; idx < index->count; idx++)
+  {
+    if ((kept > 0) && (index->ids[kept - 1] == index->ids[idx]))
+    {
+      continue;
+    }
+    if (   tableFind(self, index->ids[idx], false, &shard, &cEntry)
+        && _isClientSet(cEntry, clientID))
+    {
+      index->ids[kept++] = index->ids[idx];
+    }
+    _unlockShard(shard, false);
+  }
+  index->count = kept;
+}
+
+/**
+ * Append the update to the index of the client. If the array is full and at 
+ * least half of its ids are stale it is compacted, otherwise it grows. The 
+ * shards MUST NOT be locked, the index mutex is locked here.
+ * 
+ * @param self The update cache.
+ * @param clientID The client assigned to the update.
+ * @param updateID The id of the update.
+ * 
+ * @since 0.4.1.0
+ */
+static void _indexClientUpdate(UpdateCache* self, uint8_t clientID, 
+                               SRxUpdateID updateID)
+{
+  UC_ClientIndex* index = &self->clientIndex[clientID];
+  SRxUpdateID*    ids;
+  uint32_t        size;
+
+  lockMutex(&self->indexMutex);
+  if (index->incomplete)
+  {
+    unlockMutex(&self->indexMutex);
+    return;
+  }
+  if ((index->count == index->size) && (index->count >= 2 * index->live))
+  {
+    _compactClientIndex(self, clientID);
+  }
+  if (index->count == index->size)
+  {
+    size = index->size == 0 ? CLIENT_INDEX_INIT_SIZE : index->size * 2;
+    ids  = realloc(index->ids, size * sizeof(SRxUpdateID));
+    if (ids == NULL)
+    {
+      LOG(LEVEL_WARNING, "Not enough memory to index the updates of client "
+                         "[0x%02X]!", clientID);
+      index->incomplete = true;
+      unlockMutex(&self->indexMutex);
+      return;
+    }
+    addMemStats(MEM_TAG_CLIENTS, (size - index->size) * sizeof(SRxUpdateID),
+                index->size == 0 ? 1 : 0);
+    index->ids  = ids;
+    index->size = size;
+  }
+  index->ids[index->count++] = updateID;
+  unlockMutex(&self->indexMutex);
+}
+
+/**
+ * Assign the given client to the cache entry. The shard of the update MUST be
+ * write locked. A newly assigned update MUST be added to the client index
+ * using _indexClientUpdate once the shard is unlocked.
  * 
  * @param cEntry The cache entry containing the update
  * @param clientID The client assigned to the update.
  * 
- * @return true if the client is attached!
+ * @return true if the client got assigned, false if it was assigned already.
  */
 bool _addClientReference(UpdateCache* self, CacheEntry* cEntry, 
                          uint8_t clientID, ProxyClientMapping* clientMapping)
 {
-  bool added = false;
-  int idx;
-  
+  bool assigned = false;
+
   if (clientID == 0)
   {
     RAISE_SYS_ERROR("Invalid client ID %d added to the Update Cache for Update"
                     "[0x%08X]!!!", clientID, cEntry->updateID);
   }
   
-  // Try to find then ext empty spot.
-  for (idx = 0; idx < cEntry->noPossibleClients; idx++)
+  if (!_isClientSet(cEntry, clientID))
   {
-    if (cEntry->clients[idx]==0)
-    {
-      cEntry->clients[idx] = clientID;      
-      //TODO: depending on the final GC implementation if the GC uses a delete
-      //      list, remove this cEntry from there in case gcFlag > 0
-      // Increase the update count of this client
-      clientMapping->updateCount++;
-      added = true;
-      break;
-    }
-    else if (cEntry->clients[idx]==clientID)
-    {
-      added = true;
-      break;      
-    }
+    cEntry->clients[clientID >> 6] |= 1ULL << (clientID & 63);
+    cEntry->noClients++;
+    // Changed together with the bit, the index follows later.
+    __sync_add_and_fetch(&self->clientIndex[clientID].live, 1);
+    // Increase the update count of this client
+    __sync_add_and_fetch(&clientMapping->updateCount, 1);
+    assigned = true;
   }
-    
-  if (added)
+
+  // Only a scheduled update or a new maximum needs the item mutex.
+  if (assigned || (cEntry->gcFlag != 0))
   {
-    cEntry->gcFlag       = 0; // Reset the GC flag
-  }
-  else
-  { // run out of memory, increase the array list
-    // TODO: Maybe set a counter flag in UpdateCahce. this flag
-    // could be used to automatically increase the minimum number of clients
-    // by 2 or the default value for future updates. A minimum threshold could
-    // be 1000 extensions or even configured?
-    
-    int newSize = cEntry->noPossibleClients + self->minNumberOfClients;
-    cEntry->clients = realloc(cEntry->clients, newSize);
-    
-    if (cEntry->clients)
-    {
-      for (idx = cEntry->noPossibleClients; idx < newSize; idx++)
-      { // initialize with zero "0"
-        cEntry->clients[idx] = (uint8_t)0;
-      }
-      // Now add the new client
-      cEntry->clients[cEntry->noPossibleClients] = clientID;
-      cEntry->noPossibleClients = (uint8_t)newSize;
-      added = true;
-    }
-    else
+    lockMutex(&self->itemMutex);
+    // The callers size their client arrays using the maximum.
+    if (cEntry->noClients > self->minNumberOfClients)
     {
-      RAISE_SYS_ERROR("Extending client memory for Update[0x%08X] failed!!",
-                      cEntry->updateID);
+      self->minNumberOfClients = cEntry->noClients;
     }
+    cEntry->gcFlag       = 0; // Reset the GC flag
+    // An update in the expired list is dropped by the garbage collector.
+    removeFromTimerWheel(&self->gc.wheel, &cEntry->gcEntry);
+    unlockMutex(&self->itemMutex);
   }
   
-  return added;
+  return assigned;
 }
 
 /**
@@ -456,7 +1800,9 @@ int storeUpdate(UpdateCache* self, uint8_t clientID, void* clientMapping,
                 SRxUpdateID* updateID, IPPrefix* prefix, uint32_t asn, 
                 SRxDefaultResult* defRes, BGPSecData* bgpSec)
 {
-  CacheEntry* cEntry;
+  CacheEntry*    cEntry;
+  UC_TableShard* shard;
+  bool           assigned = false;
   
   int retVal = 1; // by default report it worked
   
@@ -469,45 +1815,46 @@ int storeUpdate(UpdateCache* self, uint8_t clientID, void* clientMapping,
                    pthread_self(), updID);
   
   // Existing entry then only update the result values.
-  if (tableFind(self, updID, &cEntry))
+  if (tableFind(self, updID, false, &shard, &cEntry))
   {
+    _unlockShard(shard, false);
     LOG(LEVEL_WARNING, "Attempt to store an update that already exists in "
                        "update cache!");
     retVal = 0;
   }
   else
   {
+    _unlockShard(shard, false);
     // The update will be stored in two phases, first it will be stored in the 
     // update list that is accessible from outside. The the update information 
     // will be stored in the hash table.    
     
     // Store a brand new update in the list
-    // New entry
-    lockMutex(&self->itemMutex);
+    // New entry, the fingerprint is generated before locking.
+    uint64_t fingerprint = _fingerprintUpdate(self, prefix, asn, bgpSec);
 
-    if (self->itemsUsed == NUM_PREALLOC) 
+    // Another thread might have stored the same update in the meantime.
+    if (tableFind(self, updID, true, &shard, &cEntry))
     {
-      // In case the pre-allocated empty space is used up, create more. 
-      self->availItems = appendToSList(&self->allItems, 
-                                       sizeof(CacheEntry) * NUM_PREALLOC);
-      if (self->availItems == NULL) 
-      {
-        return -1;
-      }
-      self->itemsUsed = 0;
+      _unlockShard(shard, true);
+      return 0;
     }
 
-    // now get the new accessible space.
-    cEntry = (CacheEntry*)(self->availItems 
-                           + (self->itemsUsed * sizeof(CacheEntry)));
-    // mark the entry as used for now.
-    self->itemsUsed++; 
-    
-  //    unlockMutex(&self->itemMutex);
+    // The pool and the blob store are guarded by the item mutex.
+    lockMutex(&self->itemMutex);
+    cEntry = (CacheEntry*)allocFromMemPool(&self->entryPool);
+    if (cEntry == NULL) 
+    {
+      unlockMutex(&self->itemMutex);
+      _unlockShard(shard, true);
+      return -1;
+    }
+    memset(cEntry, 0, sizeof(CacheEntry));
     
     cEntry->updateID      = updID;
     cEntry->asn           = asn;
     cpyPrefix(&cEntry->prefix, prefix);
+    cEntry->fingerprint   = fingerprint;
     cEntry->srxResult.bgpsecResult = SRx_RESULT_UNDEFINED;
     cEntry->srxResult.roaResult    = SRx_RESULT_UNDEFINED;
     
@@ -530,7 +1877,7 @@ int storeUpdate(UpdateCache* self, uint8_t clientID, void* clientMapping,
     if (bgpSec != NULL)
     {
       //TODO: see BZ197 - this cases once a while a SEGDEV
-      if (!storeCacheEntryBlob(cEntry, bgpSec))
+      if (!storeCacheEntryBlob(self, cEntry, bgpSec))
       {
         // Actually we end up here when the element exists already in the cache.
         // It is not an error. BZ 1010
@@ -541,37 +1888,39 @@ int storeUpdate(UpdateCache* self, uint8_t clientID, void* clientMapping,
       cEntry->blobLength = 0;
       cEntry->blob = NULL;
     }    
+    unlockMutex(&self->itemMutex);
 
-    // Add the client ID to the update
-    int memsize = sizeof(uint8_t) * self->minNumberOfClients;
-    cEntry->clients = malloc(memsize);
-    memset(cEntry->clients, 0, memsize);
-    cEntry->noPossibleClients = self->minNumberOfClients;
-    
     // ClientID might be zero "0" is the request is store only - This should not
     // be the norm. updates with zero clients will be subject to garbage 
     // collection after a while.
     if (clientID > 0)
     {
-      if (!_addClientReference(self, cEntry, 
-                               clientID, (ProxyClientMapping*)clientMapping))
-      {
-        retVal = -1;
-        RAISE_SYS_ERROR("ERROR assigning client to update!!!");
-        // TODO: maybe remove the entry from the list!!!
-      }
+      // A new update, the client is always assigned.
+      assigned = _addClientReference(self, cEntry, clientID,
+                                     (ProxyClientMapping*)clientMapping);
     }
     else
     {
       // Mark for GC
       uint16_t keepWindow = (uint16_t)self->sysConfig->defaultKeepWindow;
-      cEntry->gcFlag = getGCTime(keepWindow);
+      setGCFlag(self, cEntry, keepWindow);
     }
     
     // Finally add the entry to cache.
-    tableAdd(self, cEntry);
+    tableAdd(shard, cEntry);
+    __sync_add_and_fetch(&self->numUpdates, 1);
+    if (self->replication != NULL)
+    {
+      replicateUpdateStore(self->replication, &cEntry->updateID, asn, prefix,
+                           &cEntry->defaultResult, cEntry->blob,
+                           cEntry->blobLength, cEntry->bgpsecAttr);
+    }
 
-    unlockMutex(&self->itemMutex);  
+    _unlockShard(shard, true);
+    if (assigned)
+    {
+      _indexClientUpdate(self, clientID, updID);
+    }
   }
   return retVal;
 }
@@ -597,28 +1946,26 @@ bool modifyUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
                         SRxResult* result)
 {
   CacheEntry* cEntry;
-  bool retVal = true;
+  UC_TableShard* shard;
+  bool retVal    = true;
+  bool reportNow = false;
+  SRxValidationResult valRes;
   // This seems to be silly at this point but it might be that the id will 
   // become MD5 or even more. For this we accept a pointer to the structure
   // but store it as value only. See documentation for SRxUpdateID for more info
   SRxUpdateID updID = *updateID;
 
   // Existing entry then only update the result values.
-  if (!tableFind(self, updID, &cEntry))
+  if (!tableFind(self, updID, true, &shard, &cEntry))
   {
     RAISE_SYS_ERROR("Does not exist in update cache, can not modify it!");
     retVal = false;    
   }
   else
   {
-    lockMutex(&self->itemMutex);    
-    
-    SRxValidationResult valRes;
+    SRxResult oldResult = cEntry->srxResult;
     valRes.updateID = updID;
     valRes.valType  = 0;
-    valRes.valResult.roaResult    = cEntry->srxResult.roaResult;
-    valRes.valResult.bgpsecResult = cEntry->srxResult.bgpsecResult;
-    //valRes.clientID		  = cEntry->clientID;
     
     // Check if ROA results can be used.
     if (result->roaResult != SRx_RESULT_DONOTUSE)
@@ -627,105 +1974,88 @@ bool modifyUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
       {
         valRes.valType |= SRX_FLAG_ROA;        
         cEntry->srxResult.roaResult = result->roaResult;
-        valRes.valResult.roaResult = result->roaResult;
       }
     }
     
     // Check if BGPSEC results can be used.
     if (result->bgpsecResult != SRx_RESULT_DONOTUSE)
     { // Check for changes in bgpsec result
-      if (result->bgpsecResult != cEntry->srxResult.roaResult)
+      if (result->bgpsecResult != cEntry->srxResult.bgpsecResult)
       {
         valRes.valType |= SRX_FLAG_BGPSEC;        
         cEntry->srxResult.bgpsecResult = result->bgpsecResult;
-        valRes.valResult.bgpsecResult = result->bgpsecResult;
       }      
     }
 
+    // The standby validates the origin itself once it learns the update got
+    // an origin result.
+    if ((valRes.valType != 0) && (self->replication != NULL))
+    {
+      replicateUpdateResult(self->replication, &updID, &cEntry->prefix,
+                            cEntry->asn, &cEntry->srxResult);
+    }
+
     // check if a validation result changed.
     if (valRes.valType != 0)
     {
-      if (self->resChangedCallback != NULL)
-      {
-        // Notify of the change of validation result.
-        self->resChangedCallback(&valRes);     
-      }
-      else
+      if (self->resChangedCallback == NULL)
       {
         RAISE_ERROR("No resChangedCallback function registered! "
                     "Cannot propagate the changes in the validation result!");
         retVal = false;
       }
+      // The change log thread reports the final result.
+      else if (!_logChange(self, cEntry, &oldResult, valRes.valType))
+      {
+        // Report it right away, this is the only way to not loose it.
+        LOG(LEVEL_WARNING, HDR "Not enough memory to log the change of update "
+                           "[0x%08X]!", pthread_self(), updID);
+        valRes.valResult = cEntry->srxResult;
+        reportNow        = true;
+      }
     }
-    
-    unlockMutex(&self->itemMutex);
   }
+  _unlockShard(shard, true);
   
-  return retVal;
-}
-
-/**
- * Try to finally delete the update.
- * 
- * @param self The Update cache
- * @param cEntry The cache entry (update)
- * @param pCache The prefix cache.
- * @param force  Force the deletion of the update. This ignores if the update is
- *               still referenced by clients.
- * 
- * @return true if the update was deleted, otherwise false/
- * 
- * @since 0.3.0
- */
-bool gcTestAndDeleteUpdate(UpdateCache* self, CacheEntry* cEntry, 
-                           void* pCache, bool force)
-{
-  //TODO: Test one last time if the update can be deleted. If so then delete it.
-  // This method MUST be called by the garbage collector.
-  LOG(LEVEL_INFO,"IMPLEMENTATION CAN BE EXPECTED WITH VERSION 0.4");
-  bool delete = !force;
-  
-  if (!force)
+  // The callback looks up the update again, the shard must be unlocked.
+  if (reportNow)
   {
-    // 1. CHECK IF GC TIME IS READY
-
-    // 2. CHECK ONE MORE TIME IF NO REFERENCE EXISTS
+    self->resChangedCallback(&valRes);     
   }
-  
-  if (delete)
+  if (retVal && isUpdateTraced(updID))
   {
-    if (!removeUpdate((PrefixCache*)pCache, &cEntry->updateID, &cEntry->prefix,
-                      cEntry->asn))
-    {
-      // The reason might be that the update was not validated. (stored only)
-      LOG(LEVEL_WARNING, "Could not delete the update 0x08X from the prefix "
-                         "cache!");
-    }
-
-    // now remove it from the update cache
-    // Does not release the memory but only removes the hash table entry
-    tableDel(self, cEntry);
-    // Now remove it from the allItems list of the cache
-    deleteFromSList(&self->allItems, cEntry);
-
-    // Free the memory of the bgpsec blob;
-    free(cEntry->blob);
-    // Free the cache entry.
-    free(cEntry);
+    traceUpdate(updID, TRACE_RESULT_MODIFY);
   }
-
-  return delete;
+  
+  return retVal;
 }
 
 /** 
- * Set the flag when the update can be garbage collected.
+ * Set the flag when the update can be garbage collected and schedule the 
+ * update with the garbage collector. The shard of the update MUST be write
+ * locked, the item mutex is locked here.
  * 
+ * @param self The update cache
  * @param cEntry The cache entry - update
- * @param timeOfDeletion The GC time when the update can be deleted.
+ * @param keepTime The time in seconds the update is kept before it can be 
+ *                 deleted.
  */
-void setGCFlag(CacheEntry* cEntry, uint16_t timeOfDeletion)
+void setGCFlag(UpdateCache* self, CacheEntry* cEntry, uint16_t keepTime)
 {
-  cEntry->gcFlag = timeOfDeletion;
+  uint64_t expires = (uint64_t)time(NULL) + keepTime;
+  
+  cEntry->gcFlag = getGCTime(keepTime);
+  lockMutex(&self->itemMutex);
+  if (cEntry->gcExpired)
+  {
+    // The garbage collector schedules it again if the time is extended.
+    cEntry->gcEntry.expires = expires;
+  }
+  else
+  {
+    addToTimerWheel(&self->gc.wheel, &cEntry->gcEntry, expires);
+  }
+  unlockMutex(&self->itemMutex);
 }
 
 /**
@@ -756,43 +2086,19 @@ uint16_t getGCTime(uint16_t keepTime)
  */
 int _deleteUpdateFromCache_clientMgmt(CacheEntry* entry, uint8_t clientID)
 {
-  int idx;
-  bool found  = false;
-  bool others = false;
-  
-  for (idx = 0; idx < entry->noPossibleClients; idx++)
+  if (!_isClientSet(entry, clientID))
   {
-    if (entry->clients[idx] == clientID)
-    {
-      found = true;
-      entry->clients[idx] = (uint8_t)0;
-    }
-    else if(entry->clients[idx] != 0)
-    {
-      others = true;
-      if (found)
-      {
-        // Move all clients one to the left
-        if (entry->clients[idx] != 0)
-        {
-          entry->clients[idx-1] = entry->clients[idx];
-          entry->clients[idx] = 0;
-        }
-        else
-        {
-          // can stop here
-          break;
-        }
-      }
-    }
+    return -1;
   }
+  entry->clients[clientID >> 6] &= ~(1ULL << (clientID & 63));
+  entry->noClients--;
   
-  return !found ? -1 : others ? 1 : 0;
+  return entry->noClients > 0 ? 1 : 0;
 }  
  
 /**
  * Removes the update data from the list and releases all memory associated to 
- * it.
+ * it. The shard of the update MUST be write locked.
  * 
  * @note This method ONLY deletes the update from the update cache. It is 
  *       important to assure that other references such as the prefix_cache
@@ -804,16 +2110,16 @@ int _deleteUpdateFromCache_clientMgmt(CacheEntry* entry, uint8_t clientID)
  *                 If this id is zero all mappings and the update itself will be 
  *                 removed!
  * @param cEntry   The update itself.
- * @param timeOfDeletion A proposed real-time in seconds until the update should
- *                 be kept before final deletion. The cache might remove the 
- *                 update at any other time though.
+ * @param keepTime A proposed time in seconds the update should be kept before
+ *                 final deletion. The cache might remove the update at any 
+ *                 other time though.
  * 
  * @return true If the update / association could be removed, false if the 
  *              update was not either found in the cache or no association to 
  *              the client was found.
  */
 int _deleteUpdateFromCache(UpdateCache* self, uint8_t clientID, 
-                           CacheEntry*  cEntry, uint16_t timeOfDeletion)
+                           CacheEntry*  cEntry, uint16_t keepTime)
 {
   bool retVal = false;
   
@@ -827,9 +2133,10 @@ int _deleteUpdateFromCache(UpdateCache* self, uint8_t clientID,
       retVal = false;
       break;
     case 0 : // no reference left
-      setGCFlag(cEntry, timeOfDeletion);
+      setGCFlag(self, cEntry, keepTime);
     case 1 : // still some left, don't delete
     default:
+      __sync_sub_and_fetch(&self->clientIndex[clientID].live, 1);
       retVal = true;
   }
 
@@ -862,6 +2169,7 @@ bool deleteUpdateFromCache(UpdateCache* self, uint8_t clientID,
                            SRxUpdateID* updateID, uint16_t keepTime)
 {
   CacheEntry* cEntry;
+  UC_TableShard* shard;
   bool retVal = false;
   // This seems to be silly at this point but it might be that the id will 
   // become MD5 or even more. For this we accept a pointer to the structure
@@ -871,17 +2179,17 @@ bool deleteUpdateFromCache(UpdateCache* self, uint8_t clientID,
   {
     keepTime = self->sysConfig->defaultKeepWindow;
   }
-  uint16_t timeToBeDeleted = getGCTime(keepTime);
 
   // Get the update cache entry from the update cache.
-  if (tableFind(self, updID, &cEntry)) 
+  if (tableFind(self, updID, true, &shard, &cEntry))
   {
-    retVal = _deleteUpdateFromCache(self, clientID, cEntry, timeToBeDeleted);
+    retVal = _deleteUpdateFromCache(self, clientID, cEntry, keepTime);
   }
   else
   {
     LOG(LEVEL_INFO, "Delete aborted, update [0x%08X] not found!", updID);
   }
+  _unlockShard(shard, true);
   
   return retVal;
 }
@@ -907,33 +2215,90 @@ UpdSigResult* getUpdateSignature(UpdateCache* self, UpdSigResult* result,
 {
   ////////////////////////////////////////////////////////////////////////////// TOUCHED( ); OK ( ); NOT YET (x)
   CacheEntry* cEntry;
+  UC_TableShard* shard;
   // This seems to be silly at this point but it might be that the id will 
   // become MD5 or even more. For this we accept a pointer to the structure
   // but store it as value only. See documentation for SRxUpdateID for more info
   SRxUpdateID updID = *updateID;
   
   
-  // Currently we do NOT support any algorithm!
-  RAISE_ERROR("UPDATE SIGNATURES ARE CURRENTLY NOT SUPPORTED!");
-
-  // Currently we by default throw an algorithm not supported error.
-  // This can be overwritten by update not found. Once signing is supported
-  // this will be changed.
-  result->containsError   = true;
-  result->errorCode       = SRXERR_ALGO_NOT_SUPPORTED;
+  // Signatures are not stored, each request is signed by the BGPSec handler.
+  result->containsError   = false;
+  result->errorCode       = 0;
   result->signatureLength = 0;
   result->signatureBlock  = NULL;
 
   // Look for the update
-  if (!tableFind(self, updID, &cEntry))
+  if (!tableFind(self, updID, false, &shard, &cEntry))
   {
     LOG(LEVEL_INFO, "Update [0x%08X] not found! Can not sign it!", updID);
-    result->errorCode = SRXERR_UPDATE_NOT_FOUND;
+    result->containsError = true;
+    result->errorCode     = SRXERR_UPDATE_NOT_FOUND;
   }
+  _unlockShard(shard, false);
 
   return result;
 }
 
+/**
+ * Return the data of the update needed to sign it for a peer: the prefix and
+ * a copy of the BGPSec path attribute received with the update.
+ *
+ * @param self The update cache
+ * @param updateID The id of the update
+ * @param prefix OUT - The prefix of the update.
+ * @param attr OUT - A copy of the BGPSec path attribute, NULL if the update was
+ *             received without. Must be released by the caller using free.
+ * @param attrLength OUT - The length of the attribute.
+ * @param noHops OUT - The number of hops of the AS path of an update without
+ *               BGPSec path attribute.
+ *
+ * @return false if the update was not found or not enough memory was 
+ *         available.
+ *
+ * @since 0.4.1.0
+ */
+bool getUpdateSigningData(UpdateCache* self, SRxUpdateID* updateID,
+                          IPPrefix* prefix, uint8_t** attr, 
+                          uint16_t* attrLength, uint16_t* noHops)
+{
+  CacheEntry*    cEntry;
+  UC_TableShard* shard;
+  bool           retVal = false;
+
+  *attr       = NULL;
+  *attrLength = 0;
+  *noHops     = 0;
+
+  if (tableFind(self, *updateID, false, &shard, &cEntry))
+  {
+    retVal = true;
+    cpyPrefix(prefix, &cEntry->prefix);
+    if (cEntry->bgpsecAttr)
+    {
+      *attr = malloc(cEntry->blobLength);
+      if (*attr != NULL)
+      {
+        memcpy(*attr, cEntry->blob, cEntry->blobLength);
+        *attrLength = (uint16_t)cEntry->blobLength;
+      }
+      else
+      {
+        RAISE_SYS_ERROR("Not enough memory to sign update [0x%08X]!", 
+                        *updateID);
+        retVal = false;
+      }
+    }
+    else
+    {
+      *noHops = (uint16_t)(cEntry->blobLength / 4);
+    }
+  }
+  _unlockShard(shard, false);
+
+  return retVal;
+}
+
 /**
  * This method is not for usage within the update cache management. It is 
  * mainly to allow the server console to query for update information.
@@ -947,6 +2312,7 @@ UpdSigResult* getUpdateSignature(UpdateCache* self, UpdSigResult* result,
 bool getUpdateData(UpdateCache* self, UC_UpdateStatistics* statistics)
 { 
   CacheEntry* cEntry;
+  UC_TableShard* shard;
   bool retVal = false;
   
   if (statistics == NULL)
@@ -957,25 +2323,30 @@ bool getUpdateData(UpdateCache* self, UC_UpdateStatistics* statistics)
   {
     RAISE_SYS_ERROR("The given updaetID is 0 (INVALID ID)!");
   }
-  // Look for the update
-  else if (tableFind(self, *statistics->updateID, &cEntry)) 
+  else
   {
-    retVal = true;
-    statistics->asn                           = cEntry->asn;
-    cpyPrefix(&statistics->prefix, &cEntry->prefix);
-    statistics->bgpsecResult.containsError    = false;
-    statistics->bgpsecResult.errorCode        = 0;
-    statistics->bgpsecResult.signatureBlock   = NULL;
-    statistics->bgpsecResult.signatureLength  = 0;
-    statistics->defResult.resSourceROA   =cEntry->defaultResult.resSourceROA;    
-    statistics->defResult.resSourceBGPSEC=cEntry->defaultResult.resSourceBGPSEC;
-    statistics->defResult.result.roaResult =
+    // Look for the update
+    if (tableFind(self, *statistics->updateID, false, &shard, &cEntry))
+    {
+      retVal = true;
+      statistics->asn                           = cEntry->asn;
+      cpyPrefix(&statistics->prefix, &cEntry->prefix);
+      statistics->bgpsecResult.containsError    = false;
+      statistics->bgpsecResult.errorCode        = 0;
+      statistics->bgpsecResult.signatureBlock   = NULL;
+      statistics->bgpsecResult.signatureLength  = 0;
+      statistics->defResult.resSourceROA = cEntry->defaultResult.resSourceROA;
+      statistics->defResult.resSourceBGPSEC 
+                                      = cEntry->defaultResult.resSourceBGPSEC;
+      statistics->defResult.result.roaResult =
                                          cEntry->defaultResult.result.roaResult;
-    statistics->defResult.result.bgpsecResult = 
+      statistics->defResult.result.bgpsecResult = 
                                       cEntry->defaultResult.result.bgpsecResult;
-    statistics->result.roaResult    = cEntry->srxResult.roaResult;
-    statistics->result.bgpsecResult = cEntry->srxResult.bgpsecResult;
-    statistics->roa_count           = cEntry->roaRefCount;
+      statistics->result.roaResult    = cEntry->srxResult.roaResult;
+      statistics->result.bgpsecResult = cEntry->srxResult.bgpsecResult;
+      statistics->roa_count           = cEntry->roaRefCount;
+    }
+    _unlockShard(shard, false);
   }  
   return retVal;
 }
@@ -984,25 +2355,137 @@ bool getUpdateData(UpdateCache* self, UC_UpdateStatistics* statistics)
 void emptyUpdateCache(UpdateCache* self) 
 {
   ////////////////////////////////////////////////////////////////////////////// TOUCHED( ); OK ( ); NOT YET (x); Tested ( )
-  acquireWriteLock(&self->tableLock);
+  UC_TableShard* shard;
+  int            idx;
+
+  // The garbage collector must not hold any update. Then the lock order of
+  // the update cache: index mutex, table locks, item mutex.
+  lockMutex(&self->gc.mutex);
+  lockMutex(&self->indexMutex);
+  _lockTable(self, true);
   lockMutex(&self->itemMutex);
   
-  emptySList(&self->allItems);
+  emptyMemPool(&self->entryPool);
+  emptyBlobStore(&self->blobStore);
+
+  // Keep the buckets, the cache most likely fills up again to the same size.
+  for (idx = 0; idx < UC_TABLE_SHARDS; idx++)
+  {
+    shard = &self->shards[idx];
+    memset(shard->buckets, 0, (shard->mask + 1) * sizeof(void*));
+    if (shard->oldBuckets != NULL)
+    {
+      addMemStats(MEM_TAG_UPDATES,
+                  -(int64_t)((shard->oldMask + 1) * sizeof(void*)), -1);
+    }
+    free(shard->oldBuckets);
+    shard->oldBuckets = NULL;
+    shard->oldMask    = 0;
+    shard->migrated   = 0;
+    shard->size       = 0;
+  }
+  // Keep the ids arrays, the clients most likely come back.
+  for (idx = 0; idx < MAX_PROXY_CLIENT_ELEMENTS; idx++)
+  {
+    self->clientIndex[idx].count      = 0;
+    self->clientIndex[idx].live       = 0;
+    self->clientIndex[idx].incomplete = false;
+  }
+  self->numUpdates = 0;
+  initTimerWheel(&self->gc.wheel, (uint64_t)time(NULL));
+  self->gc.expired     = NULL;
+  self->gc.expiredTail = &self->gc.expired;
+
   unlockMutex(&self->itemMutex);
+  _unlockTable(self, true);
+  unlockMutex(&self->indexMutex);
+  unlockMutex(&self->gc.mutex);
+}
+
+/**
+ * Remove the given update without client from the update cache. The caller
+ * removes it from the prefix cache. The standby server follows the garbage
+ * collector of the primary server this way.
+ *
+ * @param self The update cache
+ * @param updateID The id of the update.
+ *
+ * @return false if the update is not stored, has clients, or is about to be
+ *         collected by the garbage collector.
+ *
+ * @since 0.4.1.0
+ */
+bool collectUpdate(UpdateCache* self, SRxUpdateID* updateID)
+{
+  CacheEntry*    cEntry;
+  UC_TableShard* shard;
+  bool           retVal = false;
+
+  if (tableFind(self, *updateID, true, &shard, &cEntry) && !_hasClients(cEntry))
+  {
+    lockMutex(&self->itemMutex);
+    // The garbage collector releases the updates of its expired list.
+    if (!cEntry->gcExpired)
+    {
+      _collectEntry(self, shard, cEntry);
+      retVal = true;
+    }
+    unlockMutex(&self->itemMutex);
+  }
+  _unlockShard(shard, true);
+
+  return retVal;
+}
+
+/**
+ * Keep all updates without client for the given time from now on. The standby
+ * server stores the updates without client and calls this once it takes over,
+ * the clients then have the keep time to register for them again.
+ *
+ * @param self The update cache
+ * @param keepTime The time in seconds the updates are kept.
+ *
+ * @since 0.4.1.0
+ */
+void keepUpdatesWithoutClient(UpdateCache* self, uint16_t keepTime)
+{
+  CacheEntry* cEntry;
+  TableCursor cursor;
 
-  self->table     = NULL;
-  self->itemsUsed = NUM_PREALLOC;
+  _lockTable(self, true);
+  memset(&cursor, 0, sizeof(TableCursor));
+  for (cEntry = _tableNext(self, &cursor); cEntry != NULL;
+       cEntry = _tableNext(self, &cursor))
+  {
+    if (!_hasClients(cEntry))
+    {
+      setGCFlag(self, cEntry, keepTime);
+    }
+  }
+  _unlockTable(self, true);
+}
 
-  unlockWriteLock(&self->tableLock);
+/**
+ * Returns the number of updates currently stored in the update cache.
+ *
+ * @param self The update cache
+ *
+ * @return The number of updates.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t getNumberOfUpdates(UpdateCache* self)
+{
+  return self->numUpdates;
 }
 
 
 /**
  * This method is used to configure the update cache in such that the minimum 
  * number of clients expected per update can be configured. the value MUST not 
- * be zero, zero values are reset to be one. This function does not change 
- * already created updates in the cache. They will be extended on an as needed
- * basis.
+ * be zero, zero values are reset to be one. The updates hold all client IDs,
+ * the value only sizes the client arrays of the callers of 
+ * getClientIDsOfUpdate and grows with the clients referencing an update.
  * 
  * @param self the UpdateCache instance.
  * @param noClients The minimum number of clients expected per update.
@@ -1033,35 +2516,31 @@ int getClientIDsOfUpdate(UpdateCache* self, SRxUpdateID* updateID,
 {
   // The cache entry also need the addition of source and predefined result.
   CacheEntry* cEntry = NULL;
+  UC_TableShard* shard;
   int retVal = 0;
-  int idx = 0;
   
   // Look for the update
-  if (tableFind(self, *updateID, &cEntry)) 
+  if (tableFind(self, *updateID, false, &shard, &cEntry))
   {
-    if (cEntry->noPossibleClients <= size)
+    if (cEntry->noClients <= size)
     {
-      // Run through the list of clients and fill them in the provided 
-      // array
-      for (idx = 0; idx < cEntry->noPossibleClients; idx++)
-      {
-        if (cEntry->clients[idx] != 0)
-        {
-          clientIDs[retVal++] = cEntry->clients[idx];
-        }
-      }
+      retVal = _getClients(cEntry, clientIDs);
     }
     else
     {
       retVal = -1;
     }    
   }
+  _unlockShard(shard, false);
   
   return retVal;    
 }
 
 /**
  * Removed the association of the client to all updates within the cache.
+ * Only the updates in the index of the client are visited, each with its
+ * shard write locked. If the index is incomplete all updates are walked at
+ * once.
  * 
  * @param self The update cache
  * @param clientID The client ID
@@ -1076,42 +2555,84 @@ int unregisterClientID(UpdateCache* self, uint8_t clientID, void* clientMapping,
                        uint32_t keepTime)
 {
   int idsRemoved = -1;
-  SListNode*  lNode;
   CacheEntry* cEntry;
+  UC_TableShard* shard;
+  TableCursor cursor;
   ProxyClientMapping* mapping = (ProxyClientMapping*)clientMapping;
+  UC_ClientIndex*     index   = &self->clientIndex[clientID];
+  SRxUpdateID*        ids;
+  uint32_t            count;
+  uint32_t            size;
+  uint32_t            idx;
+  bool                incomplete;
   
-  acquireWriteLock(&self->tableLock);
-  lockMutex(&self->itemMutex);
-  if (!self->lockedClients[clientID])
+  lockMutex(&self->indexMutex);
+  if (self->lockedClients[clientID])
+  {
+    LOG(LEVEL_ERROR, "Attempt to unregister clocked client[0x%02X] from update "
+                     "cache!", clientID);
+    unlockMutex(&self->indexMutex);
+    return idsRemoved;
+  }
+  idsRemoved = 0;
+  self->lockedClients[clientID]=true;
+  // Take the ids, the index starts over.
+  incomplete   = index->incomplete;
+  ids          = index->ids;
+  count        = index->count;
+  size         = index->size;
+  index->ids   = NULL;
+  index->count = 0;
+  index->size  = 0;
+  index->incomplete = false;
+  unlockMutex(&self->indexMutex);
+  
+  if (incomplete)
   {
-    idsRemoved = 0;
-    self->lockedClients[clientID]=true;
-    FOREACH_SLIST(&self->allItems, lNode) 
+    _lockTable(self, true);
+    memset(&cursor, 0, sizeof(TableCursor));
+    while (   (mapping->updateCount > 0)
+           && ((cEntry = _tableNext(self, &cursor)) != NULL))
     {
-      cEntry = (CacheEntry*)lNode->data;
-      if (cEntry != NULL)
+      if (_isClientSet(cEntry, clientID)
+          && _deleteUpdateFromCache(self, clientID, cEntry, (uint16_t)keepTime))
       {
-        if (_deleteUpdateFromCache(self, clientID, cEntry, keepTime))
-        {
-          idsRemoved++;
-          mapping->updateCount--;
-        }
+        idsRemoved++;
+        __sync_sub_and_fetch(&mapping->updateCount, 1);
       }
-      if (mapping->updateCount == 0)
-      {
-        break;
-      }      
     }
-    self->lockedClients[clientID]=false;
+    _unlockTable(self, true);
   }
   else
   {
-    LOG(LEVEL_ERROR, "Attempt to unregister clocked client[0x%02X] from update "
-                     "cache!", clientID);
-    
+    for (idx = 0; (idx < count) && (mapping->updateCount > 0); idx++)
+    {
+      // Stale and duplicate ids are not assigned to the client anymore.
+      if (   tableFind(self, ids[idx], true, &shard, &cEntry)
+          && _isClientSet(cEntry, clientID)
+          && _deleteUpdateFromCache(self, clientID, cEntry, (uint16_t)keepTime))
+      {
+        idsRemoved++;
+        __sync_sub_and_fetch(&mapping->updateCount, 1);
+      }
+      _unlockShard(shard, true);
+    }
   }
-  unlockMutex(&self->itemMutex);
-  unlockWriteLock(&self->tableLock);  
+
+  lockMutex(&self->indexMutex);
+  if (index->ids == NULL)
+  {
+    // Keep the memory for the next updates of the client.
+    index->ids  = ids;
+    index->size = size;
+  }
+  else if (ids != NULL)
+  {
+    addMemStats(MEM_TAG_CLIENTS, -(int64_t)(size * sizeof(SRxUpdateID)), -1);
+    free(ids);
+  }
+  self->lockedClients[clientID]=false;
+  unlockMutex(&self->indexMutex);
   
   return idsRemoved;
 }
@@ -1134,55 +2655,18 @@ bool detectCollision(UpdateCache* self, SRxUpdateID* updateID, IPPrefix* prefix,
                      uint32_t asn, BGPSecData* bgpsecData)
 {
   CacheEntry* cEntry;
+  UC_TableShard* shard;
   bool collision = false;
 
-  uint32_t dataLength = 0;
-  uint8_t* data       = NULL;
-  
-  if (bgpsecData->attr_length != 0)
-  {
-    dataLength = bgpsecData->attr_length;
-    data       = bgpsecData->bgpsec_path_attr;
-  }
-  else
-  {
-    dataLength = bgpsecData->numberHops * 4;
-    data       = (uint8_t*)bgpsecData->asPath;
-  }
-    
   // Try to find the update itself.
-  if (tableFind(self, *updateID, &cEntry)) 
+  if (tableFind(self, *updateID, false, &shard, &cEntry))
   {
-    // An update was found, now declare collision until it is determined that 
-    // the update found is the same as the update requested.
-    collision = true;
-    if (cEntry->asn == asn)
-    {
-      if (cEntry->blobLength == dataLength)
-      {
-        // Now check the ip prefix first, then the data blob
-        int  idx = 0;
-        int  bytes = (cEntry->prefix.ip.version == 4) ? 4  : 16;
-        // collision will be set true as soon as a collision is found.
-        collision = false;
-        while (!collision && idx < bytes)
-        {
-          // 1. 4 bytes of v4 and v6 overlap
-          collision = (        prefix->ip.addr.v6.u8[bytes] !=
-                       cEntry->prefix.ip.addr.v6.u8[bytes]);
-          idx++;
-        }
-
-        idx = 0;
-        // Now check the data blob - only if  not already collided
-        while (!collision && idx < dataLength)
-        {
-          collision = (data[idx] != cEntry->blob[idx]);
-          idx++;
-        }
-      }
-    }
+    // The fingerprint covers prefix, origin AS, and path. Only if it differs
+    // the update found is a different update with the same ID.
+    collision =    cEntry->fingerprint
+                != _fingerprintUpdate(self, prefix, asn, bgpsecData);
   }
+  _unlockShard(shard, false);
   
   return collision;
 }
@@ -1259,6 +2743,179 @@ bool printXMLValResult(XMLOut* out, const char* attrName,
   return retVal;
 }
 
+/**
+ * Call the visitor for each update stored in the update cache. All shards are
+ * read locked during the walk, the visitor must not call back into the update
+ * cache.
+ * 
+ * @param self The update cache.
+ * @param visitor The function called for each update.
+ * @param user User data passed to the visitor.
+ * 
+ * @return false if the visitor stopped the walk.
+ * 
+ * @since 0.4.1.0
+ */
+bool walkUpdateCache(UpdateCache* self, UpdateCacheVisitor visitor, void* user)
+{
+  CacheEntry* update;
+  TableCursor cursor;
+  bool        retVal = true;
+  
+  _lockTable(self, false);
+  memset(&cursor, 0, sizeof(TableCursor));
+  for (update = _tableNext(self, &cursor); retVal && (update != NULL); 
+       update = _tableNext(self, &cursor))
+  {
+    retVal = visitor(user, &update->updateID, update->asn, &update->prefix,
+                     &update->defaultResult, &update->srxResult, 
+                     update->blob, update->blobLength, update->bgpsecAttr);
+  }
+  _unlockTable(self, false);
+  
+  return retVal;
+}
+
+/**
+ * Return the JSON string of the given validation result.
+ * 
+ * @param result The validation result.
+ * @param hasNotFound Indicates if NOTFOUND is a valid result.
+ * 
+ * @return The string.
+ * 
+ * @since 0.4.1.0
+ */
+static const char* _valResultToStr(SRxValidationResultVal result, 
+                                   bool hasNotFound)
+{
+  switch (result)
+  {
+    case SRx_RESULT_DONOTUSE  : return "DONOTUSE";
+    case SRx_RESULT_UNDEFINED : return "UNDEFINED";
+    case SRx_RESULT_VALID     : return "VALID";
+    case SRx_RESULT_INVALID   : return "INVALID";
+    case SRx_RESULT_NOTFOUND  : 
+      if (hasNotFound)
+      {
+        return "NOTFOUND";
+      }
+    default:
+      return "UNKNOWN";
+  }
+}
+
+/**
+ * Add the JSON line of the given update to the output.
+ * 
+ * @param out The JSON output.
+ * @param update The update.
+ * 
+ * @since 0.4.1.0
+ */
+static void _dumpUpdate(JSONOut* out, CacheEntry* update)
+{
+  char    buf[MAX_IP_V6_STR_LEN + 4];
+  size_t  len;
+  uint8_t clients[MAX_PROXY_CLIENT_ELEMENTS];
+  int     noClients;
+  int     clIdx;
+
+  snprintf(buf, sizeof(buf), "%s", ipToStr(&update->prefix.ip));
+  len = strlen(buf);
+  snprintf(buf + len, sizeof(buf) - len, "/%u", update->prefix.length);
+
+  openJSONObject(out, NULL);
+  addJSONH32(out, "update-id", update->updateID);
+  addJSONU32(out, "origin-as", update->asn);
+  addJSONStr(out, "prefix", buf);
+  addJSONStr(out, "origin-val", 
+             _valResultToStr(update->srxResult.roaResult, true));
+  addJSONStr(out, "path-val", 
+             _valResultToStr(update->srxResult.bgpsecResult, false));
+  addJSONStr(out, "def-origin-val", 
+             _valResultToStr(update->defaultResult.result.roaResult, true));
+  addJSONStr(out, "def-path-val", 
+             _valResultToStr(update->defaultResult.result.bgpsecResult, true));
+  addJSONInt(out, "roa-count", update->roaRefCount);
+  noClients = _getClients(update, clients);
+  openJSONArray(out, "clients");
+  for (clIdx = 0; clIdx < noClients; clIdx++)
+  {
+    addJSONU32(out, NULL, clients[clIdx]);
+  }
+  closeJSONArray(out);
+  addJSONU32(out, "gc", update->gcFlag);
+  addJSONU32(out, "blob-length", update->blobLength);
+  closeJSONObject(out);
+}
+
+/**
+ * Add the JSON lines of all updates in the given bucket chains.
+ * 
+ * @param out The JSON output.
+ * @param buckets The bucket array.
+ * @param from The first bucket.
+ * @param to The last bucket.
+ * 
+ * @since 0.4.1.0
+ */
+static void _dumpBuckets(JSONOut* out, void** buckets, uint32_t from, 
+                         uint32_t to)
+{
+  CacheEntry* update;
+  uint32_t    idx;
+
+  for (idx = from; idx <= to; idx++)
+  {
+    for (update = (CacheEntry*)buckets[idx]; update != NULL; 
+         update = update->next)
+    {
+      _dumpUpdate(out, update);
+    }
+  }
+}
+
+/**
+ * Write the updates as JSON lines (one object per update) into the given 
+ * stream. Only one shard is read locked at a time, its lines are generated 
+ * in memory and written once the shard is unlocked. The dump is not a 
+ * snapshot, updates stored or removed during the dump might or might not be
+ * included.
+ * 
+ * @param self The update cache.
+ * @param stream The stream to write into.
+ * 
+ * @return false if the output failed.
+ * 
+ * @since 0.4.1.0
+ */
+bool dumpUpdateCache(UpdateCache* self, FILE* stream)
+{
+  JSONOut        out;
+  UC_TableShard* shard;
+  bool           ok = true;
+  int            idx;
+
+  initJSONOut(&out, stream);
+  for (idx = 0; ok && idx < UC_TABLE_SHARDS; idx++)
+  {
+    shard = &self->shards[idx];
+    acquireReadLock(&shard->lock);
+    _dumpBuckets(&out, shard->buckets, 0, shard->mask);
+    if (shard->oldBuckets != NULL)
+    {
+      _dumpBuckets(&out, shard->oldBuckets, shard->migrated, 
+                   shard->oldMask);
+    }
+    unlockReadLock(&shard->lock);
+    ok = flushJSONOut(&out);
+  }
+  releaseJSONOut(&out);
+
+  return ok;
+}
+
 /**
  * Print the content of the update cache to the given file.
  * 
@@ -1274,10 +2931,11 @@ void outputUpdateCacheAsXML(UpdateCache* self, FILE* stream, int maxBlob)
 {
 #define CLIENT_LIST_STRING_LEN 1024
   XMLOut      out;
-  SListNode*  updateListNode;
   CacheEntry* update;
-  uint8_t     clIdx;
-  uint8_t     noClients;
+  TableCursor cursor;
+  int         clIdx;
+  int         noClients = 0;
+  uint8_t     clients[MAX_PROXY_CLIENT_ELEMENTS];
   char        clientString[CLIENT_LIST_STRING_LEN];
   memset(clientString, '\0', CLIENT_LIST_STRING_LEN);
   char*       strPtr = NULL;
@@ -1286,36 +2944,30 @@ void outputUpdateCacheAsXML(UpdateCache* self, FILE* stream, int maxBlob)
 
   // Add the current gc time
   addU32Attrib(&out, "current-gc-time", getGCTime(0));          
+  addU32Attrib(&out, "gc-scheduled", self->gc.wheel.count);
+  addU32Attrib(&out, "gc-collected", self->gc.collected);
   
   // Updates
-  if (sizeOfSList(&self->allItems))
+  _lockTable(self, false);
+  memset(&cursor, 0, sizeof(TableCursor));
+  update = _tableNext(self, &cursor);
+  if (update != NULL)
   {
     openTag(&out, "updates");
-    FOREACH_SLIST(&self->allItems, updateListNode)
+    for (; update != NULL; update = _tableNext(self, &cursor))
     {
-      update = (CacheEntry*)getDataOfSListNode(updateListNode);
       openTag(&out, "update");
         addH32Attrib(&out, "update-id", update->updateID);
         // noClients contains the number of clients used during the last run.
         // the multiplicator "4" is used for the maximum space used for any 
         // client ID (3 char + comma)
         memset(clientString, '\0', noClients*4);
-        noClients = 0;
         strPtr = clientString;
-        for(clIdx = 0; clIdx < update->noPossibleClients; clIdx++)
+        noClients = _getClients(update, clients);
+        for(clIdx = 0; clIdx < noClients; clIdx++)
         {
-          if (update->clients[clIdx] != 0)
-          {
-            noClients++;
-            if (noClients == 1)
-            {
-              strPtr += sprintf(strPtr, "%u", update->clients[clIdx]);
-            }
-            else
-            {
-              strPtr += sprintf(strPtr, ",%u", update->clients[clIdx]);
-            }
-          }
+          strPtr += sprintf(strPtr, clIdx == 0 ? "%u" : ",%u", 
+                            clients[clIdx]);
         }
         addU32Attrib(&out, "no-clients", noClients);
         if (noClients > 0)
@@ -1359,6 +3011,7 @@ void outputUpdateCacheAsXML(UpdateCache* self, FILE* stream, int maxBlob)
     }
     closeTag(&out);
   }
+  _unlockTable(self, false);
 
   closeTag(&out);
   releaseXMLOut(&out);
@@ -20,15 +20,40 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * The update cache holds the updates in two separate structures, one is the 
- * update cache, a hash table with the update id as key and the update as 
- * value. The other is a list, that allows to scan through all updates. Both 
- * MUST be maintained the same.
+ * The update cache holds the updates in a hash table with the update id as 
+ * key and the update as value. The memory of the updates is managed by a 
+ * memory pool, identical blobs are shared using a blob store.
  * 
- * @version 0.4.0.0
+ * @version 0.4.1.0
  * 
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Replaced the allItems list with memory pools for the cache 
+ *              entries, client arrays, and blobs.
+ *            * Added getNumberOfUpdates.
+ *            * Replaced the single locked hash table with UC_TABLE_SHARDS
+ *              independently locked shards that resize incrementally.
+ *            * Result changes are written into a change log and broadcasted
+ *              in batches by the change log thread.
+ *            * Added UpdateResultsChanged and setUpdateResultsChangedCallback.
+ *            * Added the garbage collector and startUpdateCacheGC / 
+ *              stopUpdateCacheGC.
+ *            * Added walkUpdateCache.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added dumpUpdateCache.
+ *            * Added getUpdateSigningData.
+ *            * The update blobs are interned in a blob store.
+ *            * Removed the client pool, the clients of an update are kept in
+ *              a bitmap.
+ *            * Added the client index, unregisterClientID only visits the
+ *              updates of the client.
+ *            * Added the fingerprint key fpKey.
+ *            * Added the replication to the standby server, collectUpdate,
+ *              and keepUpdatesWithoutClient.
+ *            * The updates are guarded by the lock of their shard, the client
+ *              index by the new index mutex.
+ *            * UpdateCacheVisitor receives the kind of the blob.
  * 0.4.0.0  - 2016/06/19 - oborchert
  *            * added function storeCacheEntryBlob
  * 0.3.0.10 - 2015/11/09 - oborchert
@@ -51,12 +76,34 @@
 #define __UPDATE_CACHE_H__
 
 #include <stdio.h>
+#include <pthread.h>
+#include "server/blob_store.h"
 #include "server/configuration.h"
 #include "shared/srx_defs.h"
 #include "shared/srx_packets.h"
+#include "shared/siphash.h"
 #include "util/mutex.h"
 #include "util/rwlock.h"
-#include "util/slist.h"
+#include "util/mem_pool.h"
+#include "util/timer.h"
+
+/** The number of hash table shards, MUST be a power of 2. */
+#define UC_TABLE_SHARDS 64
+
+/**
+ * One shard of the update hash table. Each shard has its own lock and grows
+ * on its own. During a resize the entries are moved from the old into the 
+ * new buckets a few buckets at a time by the writers of the shard.
+ */
+typedef struct {
+  RWLock   lock;       // Guards this shard and its updates
+  void**   buckets;    // The bucket chains of the current table
+  uint32_t mask;       // The number of buckets - 1
+  void**   oldBuckets; // The buckets not migrated yet or NULL 
+  uint32_t oldMask;    // The number of old buckets - 1
+  uint32_t migrated;   // The number of old buckets migrated already
+  uint32_t size;       // The number of entries within the shard
+} UC_TableShard;
 
 /**
  * Function that is called in case a result changed.
@@ -67,27 +114,106 @@
 typedef void (*UpdateResultChanged)(SRxValidationResult* result);
 
 /**
- * A single Update Cache.
+ * Function that is called with a batch of changed results.
+ *
+ * @param results The changed results
+ * @param count The number of results
+ */
+typedef void (*UpdateResultsChanged)(SRxValidationResult* results, 
+                                     uint32_t count);
+
+/**
+ * The log of updates whose validation result changed but was not reported
+ * yet. Each update is logged only once until the thread of the log reports 
+ * its final result.
+ */
+typedef struct {
+  Mutex        mutex;   // Guards the log
+  Cond         cond;    // Signals new changes and the stop of the log
+  SRxUpdateID* ids;     // The ids of the changed updates
+  uint32_t     count;   // The number of logged ids
+  uint32_t     size;    // The number of ids the array can hold
+  bool         running; // Indicates if the thread of the log runs
+  pthread_t    thread;  // The thread that reports the changes
+} UC_ChangeLog;
+
+/**
+ * The garbage collector of the update cache. Updates without any client wait
+ * in the timer wheel until their keep time passed. Once a second the thread of
+ * the collector removes the expired updates from the prefix cache and the 
+ * update cache in small batches until its time budget is used up.
+ */
+typedef struct {
+  Mutex             mutex;       // Guards the collector, held while collecting
+  Cond              cond;        // Signals the stop of the collector
+  TimerWheel        wheel;       // The updates without client by expiry second,
+                                 // guarded by the item mutex
+  TimerWheelEntry*  expired;     // The expired updates not collected yet, 
+                                 // guarded by the item mutex
+  TimerWheelEntry** expiredTail; // The end of the expired list
+  void*             prefixCache; // The prefix cache the updates are removed 
+                                 // from
+  uint32_t          budget;      // The milliseconds to spend per second
+  uint32_t          collected;   // The number of updates collected
+  bool              running;     // Indicates if the thread of the collector 
+                                 // runs
+  pthread_t         thread;      // The thread of the collector
+} UC_GarbageCollector;
+
+/**
+ * The ids of the updates a client is assigned to. An id is appended when the 
+ * client is assigned to the update and stays when the assignment ends, such 
+ * stale ids are skipped and dropped once the array is full. Guarded by the 
+ * index mutex, live is changed atomically together with the client bits of
+ * the updates.
+ */
+typedef struct {
+  SRxUpdateID* ids;        // The update ids, might contain stale ids
+  uint32_t     count;      // The number of ids in the array
+  uint32_t     size;       // The number of ids the array can hold
+  uint32_t     live;       // The number of updates assigned to the client
+  bool         incomplete; // An id could not be stored, unregistering the 
+                           // client walks all updates
+} UC_ClientIndex;
+
+struct _Replication;
+
+/**
+ * A single Update Cache. The locks are acquired in the order index mutex,
+ * shards, item mutex.
  */
 typedef struct {  
   Configuration*      sysConfig;  // The system configuration
   UpdateResultChanged resChangedCallback;
-  Mutex               itemMutex;
-  // TODO Check if allItems can be removed!
-  SList               allItems;   // All updates in an SList.
-  void*               availItems; // pointer to the next available cEntry
-  int                 itemsUsed;  // number of cEntries used
-  RWLock              tableLock;
-  void*               table;      // The hash table for quick lookup
+  // If set it is called instead of resChangedCallback for reported changes
+  UpdateResultsChanged resBatchCallback;
+  Mutex               itemMutex;  // Guards the pools and the timer wheel
+  Mutex               indexMutex; // Guards the client index
+  MemPool             entryPool;  // The memory of all cache entries
+  BlobStore           blobStore;  // The interned update blobs
+  // The secret key of the update fingerprints
+  uint8_t             fpKey[SIPHASH_KEY_LENGTH];
+  uint32_t            numUpdates; // The number of updates stored
+  // The hash table for quick lookup, sharded by the update id
+  UC_TableShard       shards[UC_TABLE_SHARDS];
+  // The result changes not reported yet
+  UC_ChangeLog        changeLog;
+  // Removes the updates without client once their keep time passed
+  UC_GarbageCollector gc;
+  // Receives the stored, collected, and changed updates, NULL if not
+  // replicated
+  struct _Replication* replication;
   // The is also the maximum number of clients currently installed. It is
-  // called minNumberOfclients because it is the minimum expected and therefore
-  // the initial number of array elements needed per update. This number might
-  // grow over time and will be always maintained and reflects at least the 
-  // maximum number of clients used, sometimes a bit more.
+  // called minNumberOfclients because it is the minimum expected. This number
+  // might grow over time and will be always maintained and reflects at least
+  // the maximum number of clients of an update, it sizes the client arrays 
+  // passed to getClientIDsOfUpdate.
   uint8_t             minNumberOfClients;
+  // The updates of each client, indexed by the client ID
+  UC_ClientIndex*     clientIndex;
   // determines if a particular client is locked. A client is locked if the 
   // cache works on cleaning updates from this client. During this phase no 
-  // updates can be assigned to this client.
+  // updates can be assigned to this client. Guarded by the index mutex.
   uint32_t*           lockedClients;
 } UpdateCache;
 
@@ -116,7 +242,7 @@ typedef struct {
   UpdSigResult     bgpsecResult;
 } UC_UpdateStatistics;
 
-#define DEFAULT_NUMBER_CLIENTS 2; 
+#define DEFAULT_NUMBER_CLIENTS 2
 
 /**
  * Initialized the update cache. The memory for the cache MUST be allocated
@@ -132,6 +258,57 @@ typedef struct {
 bool createUpdateCache(UpdateCache* self, UpdateResultChanged chCallback, 
                        uint8_t minNumberOfUpdates, Configuration* sysConfig);
 
+/**
+ * Register the callback that is called with the batches of changed results
+ * reported by the change log. If not set, resChangedCallback is called for
+ * each changed result.
+ *
+ * @param self The update cache
+ * @param callback The batch callback or NULL.
+ *
+ * @since 0.4.1.0
+ */
+void setUpdateResultsChangedCallback(UpdateCache* self, 
+                                     UpdateResultsChanged callback);
+
+/**
+ * Attach the replication to the standby server. The stored and collected
+ * updates and the changed validation results are handed to it.
+ *
+ * @param self The update cache
+ * @param replication The replication or NULL.
+ *
+ * @since 0.4.1.0
+ */
+void setUpdateCacheReplication(UpdateCache* self,
+                               struct _Replication* replication);
+
+/**
+ * Start the thread of the garbage collector. It removes the updates without
+ * client from the given prefix cache as well. The time budget is taken from
+ * the system configuration.
+ *
+ * @param self The update cache
+ * @param prefixCache The prefix cache (PrefixCache*) that validates the 
+ *                    updates.
+ *
+ * @return true if the garbage collector runs.
+ *
+ * @since 0.4.1.0
+ */
+bool startUpdateCacheGC(UpdateCache* self, void* prefixCache);
+
+/**
+ * Stop the thread of the garbage collector. MUST be called before the prefix
+ * cache given to startUpdateCacheGC is released. Does nothing if the garbage
+ * collector does not run.
+ *
+ * @param self The update cache
+ *
+ * @since 0.4.1.0
+ */
+void stopUpdateCacheGC(UpdateCache* self);
+
 /**
  * Frees all allocated resources.
  *
@@ -164,7 +341,8 @@ bool getUpdateResult(UpdateCache* self, SRxUpdateID* updateID,
 
 /**
  * This function returns the update signature if already existent. It will NOT
- * start the signing. If no signature exists the return value is NULL
+ * start the signing. If no signature exists the return value is NULL. 
+ * Signatures are not stored, the signing is done by the BGPSec handler.
  *
  * @param self The instance of the update cache
  * @param result The result of the function call.
@@ -181,6 +359,28 @@ UpdSigResult* getUpdateSignature(UpdateCache* self, UpdSigResult* result,
                                  uint32_t peerAS, uint16_t algorithm,
                                  bool complete);
 
+/**
+ * Return the data of the update needed to sign it for a peer: the prefix and
+ * a copy of the BGPSec path attribute received with the update.
+ *
+ * @param self The update cache
+ * @param updateID The id of the update
+ * @param prefix OUT - The prefix of the update.
+ * @param attr OUT - A copy of the BGPSec path attribute, NULL if the update was
+ *             received without. Must be released by the caller using free.
+ * @param attrLength OUT - The length of the attribute.
+ * @param noHops OUT - The number of hops of the AS path of an update without
+ *               BGPSec path attribute.
+ *
+ * @return false if the update was not found or not enough memory was 
+ *         available.
+ *
+ * @since 0.4.1.0
+ */
+bool getUpdateSigningData(UpdateCache* self, SRxUpdateID* updateID,
+                          IPPrefix* prefix, uint8_t** attr, 
+                          uint16_t* attrLength, uint16_t* noHops);
+
 /**
  * This method is not for usage within the update cache management. It is 
  * mainly to allow the server console to query for update information.
@@ -265,6 +465,44 @@ bool deleteUpdateFromCache(UpdateCache* self, uint8_t clientID,
  */
 void emptyUpdateCache(UpdateCache* self);
 
+/**
+ * Remove the given update without client from the update cache. The caller
+ * removes it from the prefix cache. The standby server follows the garbage
+ * collector of the primary server this way.
+ *
+ * @param self The update cache
+ * @param updateID The id of the update.
+ *
+ * @return false if the update is not stored, has clients, or is about to be
+ *         collected by the garbage collector.
+ *
+ * @since 0.4.1.0
+ */
+bool collectUpdate(UpdateCache* self, SRxUpdateID* updateID);
+
+/**
+ * Keep all updates without client for the given time from now on. The standby
+ * server stores the updates without client and calls this once it takes over,
+ * the clients then have the keep time to register for them again.
+ *
+ * @param self The update cache
+ * @param keepTime The time in seconds the updates are kept.
+ *
+ * @since 0.4.1.0
+ */
+void keepUpdatesWithoutClient(UpdateCache* self, uint16_t keepTime);
+
+/**
+ * Returns the number of updates currently stored in the update cache.
+ *
+ * @param self The update cache
+ *
+ * @return The number of updates.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t getNumberOfUpdates(UpdateCache* self);
+
 /**
  * This method is used to configure the update cache in such that the minimum 
  * number of clients expected per update can be configured. the value MUST not 
@@ -298,8 +536,10 @@ int getClientIDsOfUpdate(UpdateCache* self, SRxUpdateID* updateID,
 
 /**
  * Stores a result for in the update cache for later retrieval.
- * If this overwrites an existing update result, then the registered 
- * UpdateResultChanged callback is called. The update MUST exist! Only result
+ * If this overwrites an existing update result, the update is logged and the
+ * registered UpdateResultChanged callback is called later on by the change 
+ * log thread with the final result. Changes that flip back before they are
+ * reported are not reported at all. The update MUST exist! Only result
  * values other than SRx_RESULT_DONOTUSE are used. This allows to change only 
  * one value, not necessary both.
  *
@@ -334,7 +574,8 @@ int unregisterClientID(UpdateCache* self, uint8_t clientID, void* clientMapping,
 /**
  * This method determines if an update with the given ID already exist. If so,
  * a collision is detected. A collision is detected if an update with the same
- * updateID already exist but the data is different.
+ * updateID already exist but the data is different. The data is compared
+ * using the fingerprint of prefix, origin AS, and path stored with the update.
  * 
  * @param self The Update cache
  * @param updateID Update ID to be checked!
@@ -366,6 +607,46 @@ bool detectCollision(UpdateCache* self, SRxUpdateID* updateID, IPPrefix* prefix,
  */
 //bool storeCacheEntryBlob(CacheEntry* cEntry, BGPSecData* bgpsecData);
 
+/**
+ * Called by walkUpdateCache for each update. The update cache is locked
+ * during the call, the function must not call back into the update cache.
+ * 
+ * @param user The user data given to walkUpdateCache.
+ * @param updateID The id of the update.
+ * @param asn The origin AS of the update.
+ * @param prefix The prefix of the update.
+ * @param defResult The default result of the update.
+ * @param srxResult The current validation result of the update.
+ * @param blob The update blob, NULL if none is stored.
+ * @param blobLength The length of the blob.
+ * @param bgpsecAttr true if the blob is the BGPSec path attribute, false if
+ *                   it is the AS path.
+ * 
+ * @return false to stop the walk.
+ * 
+ * @since 0.4.1.0
+ */
+typedef bool (*UpdateCacheVisitor)(void* user, SRxUpdateID* updateID,
+                                   uint32_t asn, IPPrefix* prefix,
+                                   SRxDefaultResult* defResult,
+                                   SRxResult* srxResult, uint8_t* blob,
+                                   uint32_t blobLength, bool bgpsecAttr);
+
+/**
+ * Call the visitor for each update stored in the update cache. All shards are
+ * read locked during the walk, the visitor must not call back into the update
+ * cache.
+ * 
+ * @param self The update cache.
+ * @param visitor The function called for each update.
+ * @param user User data passed to the visitor.
+ * 
+ * @return false if the visitor stopped the walk.
+ * 
+ * @since 0.4.1.0
+ */
+bool walkUpdateCache(UpdateCache* self, UpdateCacheVisitor visitor, void* user);
+
 /**
  * Print the content of the update cache to the given file.
  * 
@@ -378,4 +659,17 @@ bool detectCollision(UpdateCache* self, SRxUpdateID* updateID, IPPrefix* prefix,
  * 
  */
 void outputUpdateCacheAsXML(UpdateCache* self, FILE* stream, int maxBlob);
+
+/**
+ * Write the updates as JSON lines into the given stream. Only one shard is 
+ * locked at a time, the dump is not a snapshot of the cache.
+ * 
+ * @param self the update cache
+ * @param stream The stream to be written into.
+ * 
+ * @return false if the output failed.
+ * 
+ * @since 0.4.1.0
+ */
+bool dumpUpdateCache(UpdateCache* self, FILE* stream);
 #endif // !__UPDATE_CACHE_H__
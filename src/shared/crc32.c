@@ -20,7 +20,19 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added crc32c (Castagnoli) using SSE4.2 / ARMv8 CRC instructions
+ *              if available and slice-by-8 otherwise.
  */
+#include <pthread.h>
+#include <string.h>
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
 #include "shared/crc32.h"
 
 // CRC-32 polynominal:
@@ -110,3 +122,176 @@ uint32_t crc32(uint8_t *pData, uint32_t uSize)
   }
   return ~pCrc32;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// CRC-32C (Castagnoli)
+////////////////////////////////////////////////////////////////////////////////
+
+/** The CRC-32C polynomial in reversed bit order. */
+#define CRC32C_POLY 0x82F63B78
+
+/** The slice-by-8 tables, generated once. */
+static uint32_t crc32cTab[8][256];
+/** Guards the generation of the tables and the selection of the kernel. */
+static pthread_once_t crc32cOnce = PTHREAD_ONCE_INIT;
+/** The kernel used to calculate the CRC-32C value. */
+static uint32_t (*crc32cKernel)(uint32_t crc, const uint8_t* data, 
+                                uint32_t length) = NULL;
+
+/**
+ * Table based CRC-32C calculation processing 8 bytes per round on little 
+ * endian systems.
+ *
+ * @param crc The current (inverted) crc value
+ * @param data The data block
+ * @param length The size of the data block
+ *
+ * @return The new (inverted) crc value
+ */
+static uint32_t _crc32cSlice8(uint32_t crc, const uint8_t* data, 
+                              uint32_t length)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  uint32_t low, high;
+
+  while (length >= 8)
+  {
+    memcpy(&low,  data,     4);
+    memcpy(&high, data + 4, 4);
+    low ^= crc;
+    crc =   crc32cTab[7][low & 0xFF]          ^ crc32cTab[6][(low >> 8) & 0xFF]
+          ^ crc32cTab[5][(low >> 16) & 0xFF]  ^ crc32cTab[4][low >> 24]
+          ^ crc32cTab[3][high & 0xFF]         ^ crc32cTab[2][(high >> 8) & 0xFF]
+          ^ crc32cTab[1][(high >> 16) & 0xFF] ^ crc32cTab[0][high >> 24];
+    data   += 8;
+    length -= 8;
+  }
+#endif
+  while (length-- > 0)
+  {
+    crc = crc32cTab[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+  }
+
+  return crc;
+}
+
+#if defined(__x86_64__)
+/**
+ * CRC-32C calculation using the SSE4.2 crc32 instructions.
+ *
+ * @param crc The current (inverted) crc value
+ * @param data The data block
+ * @param length The size of the data block
+ *
+ * @return The new (inverted) crc value
+ */
+__attribute__((target("sse4.2")))
+static uint32_t _crc32cSSE42(uint32_t crc, const uint8_t* data, 
+                             uint32_t length)
+{
+  uint64_t crc64 = crc;
+  uint64_t value;
+
+  while (length >= 8)
+  {
+    memcpy(&value, data, 8);
+    crc64   = __builtin_ia32_crc32di(crc64, value);
+    data   += 8;
+    length -= 8;
+  }
+  crc = (uint32_t)crc64;
+  while (length-- > 0)
+  {
+    crc = __builtin_ia32_crc32qi(crc, *data++);
+  }
+
+  return crc;
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+/**
+ * CRC-32C calculation using the ARMv8 crc32c instructions.
+ *
+ * @param crc The current (inverted) crc value
+ * @param data The data block
+ * @param length The size of the data block
+ *
+ * @return The new (inverted) crc value
+ */
+static uint32_t _crc32cARMv8(uint32_t crc, const uint8_t* data, 
+                             uint32_t length)
+{
+  uint64_t value;
+
+  while (length >= 8)
+  {
+    memcpy(&value, data, 8);
+    crc     = __crc32cd(crc, value);
+    data   += 8;
+    length -= 8;
+  }
+  while (length-- > 0)
+  {
+    crc = __crc32cb(crc, *data++);
+  }
+
+  return crc;
+}
+#endif
+
+/**
+ * Generate the slice-by-8 tables and select the fastest available kernel.
+ */
+static void _initCRC32C(void)
+{
+  uint32_t crc;
+  int      idx, bit, slice;
+
+  for (idx = 0; idx < 256; idx++)
+  {
+    crc = (uint32_t)idx;
+    for (bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : (crc >> 1);
+    }
+    crc32cTab[0][idx] = crc;
+  }
+  for (idx = 0; idx < 256; idx++)
+  {
+    crc = crc32cTab[0][idx];
+    for (slice = 1; slice < 8; slice++)
+    {
+      crc = crc32cTab[0][crc & 0xFF] ^ (crc >> 8);
+      crc32cTab[slice][idx] = crc;
+    }
+  }
+
+  crc32cKernel = _crc32cSlice8;
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("sse4.2"))
+  {
+    crc32cKernel = _crc32cSSE42;
+  }
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+  crc32cKernel = _crc32cARMv8;
+#endif
+}
+
+/**
+ * Generates a CRC-32C (Castagnoli) number for the given data block.
+ *
+ * @param crc The crc value of the previous data, 0 for the first block.
+ * @param data The data block
+ * @param length The size of the data block in bytes.
+ *
+ * @return The CRC-32C value
+ *
+ * @since 0.4.1.0
+ */
+uint32_t crc32c(uint32_t crc, const uint8_t* data, uint32_t length)
+{
+  pthread_once(&crc32cOnce, _initCRC32C);
+
+  return ~crc32cKernel(~crc, data, length);
+}
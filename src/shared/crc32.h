@@ -20,10 +20,13 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added crc32c (Castagnoli) using SSE4.2 / ARMv8 CRC instructions
+ *              if available and slice-by-8 otherwise.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Added Changelog
  *            * Fixed speller in documentation header
@@ -41,6 +44,23 @@ extern "C" {
 
 uint32_t crc32(uint8_t *pData, uint32_t uSize);
 
+/**
+ * Generates a CRC-32C (Castagnoli) number for the given data block. The 
+ * hardware CRC32 instructions (SSE4.2 or ARMv8) are used if available, 
+ * otherwise a slice-by-8 table implementation is used. The CRC can be 
+ * calculated over multiple blocks by passing the result of the previous block 
+ * as crc value.
+ *
+ * @param crc The crc value of the previous data, 0 for the first block.
+ * @param data The data block
+ * @param length The size of the data block in bytes.
+ *
+ * @return The CRC-32C value
+ *
+ * @since 0.4.1.0
+ */
+uint32_t crc32c(uint32_t crc, const uint8_t* data, uint32_t length);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -0,0 +1,145 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "shared/siphash.h"
+
+#define ROTL64(X, B) (uint64_t)(((X) << (B)) | ((X) >> (64 - (B))))
+
+#define SIPROUND(V0, V1, V2, V3) \
+  do { \
+    V0 += V1; V1 = ROTL64(V1, 13); V1 ^= V0; V0 = ROTL64(V0, 32); \
+    V2 += V3; V3 = ROTL64(V3, 16); V3 ^= V2; \
+    V0 += V3; V3 = ROTL64(V3, 21); V3 ^= V0; \
+    V2 += V1; V1 = ROTL64(V1, 17); V1 ^= V2; V2 = ROTL64(V2, 32); \
+  } while (0)
+
+/**
+ * Read 8 bytes as little endian word.
+ *
+ * @param data The bytes.
+ *
+ * @return The word.
+ */
+static inline uint64_t _readLE64(const uint8_t* data)
+{
+  return    ((uint64_t)data[0])       | ((uint64_t)data[1] << 8)
+          | ((uint64_t)data[2] << 16) | ((uint64_t)data[3] << 24)
+          | ((uint64_t)data[4] << 32) | ((uint64_t)data[5] << 40)
+          | ((uint64_t)data[6] << 48) | ((uint64_t)data[7] << 56);
+}
+
+/**
+ * Generates the SipHash-2-4 value of the given data block.
+ *
+ * @param key The key (SIPHASH_KEY_LENGTH bytes).
+ * @param data The data block
+ * @param length The size of the data block in bytes.
+ *
+ * @return The 64 bit hash value.
+ *
+ * @since 0.4.1.0
+ */
+uint64_t siphash(const uint8_t* key, const uint8_t* data, uint32_t length)
+{
+  uint64_t k0   = _readLE64(key);
+  uint64_t k1   = _readLE64(key + 8);
+  uint64_t v0   = 0x736f6d6570736575ULL ^ k0;
+  uint64_t v1   = 0x646f72616e646f6dULL ^ k1;
+  uint64_t v2   = 0x6c7967656e657261ULL ^ k0;
+  uint64_t v3   = 0x7465646279746573ULL ^ k1;
+  uint64_t last = ((uint64_t)length) << 56;
+  uint64_t word;
+  uint32_t left = length & 7;
+  const uint8_t* end = data + (length - left);
+
+  for (; data != end; data += 8)
+  {
+    word = _readLE64(data);
+    v3 ^= word;
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    v0 ^= word;
+  }
+  // The remaining bytes and the length form the last word.
+  while (left > 0)
+  {
+    left--;
+    last |= ((uint64_t)data[left]) << (8 * left);
+  }
+  v3 ^= last;
+  SIPROUND(v0, v1, v2, v3);
+  SIPROUND(v0, v1, v2, v3);
+  v0 ^= last;
+
+  v2 ^= 0xff;
+  SIPROUND(v0, v1, v2, v3);
+  SIPROUND(v0, v1, v2, v3);
+  SIPROUND(v0, v1, v2, v3);
+  SIPROUND(v0, v1, v2, v3);
+
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/**
+ * Fill the given key with random bytes read from /dev/urandom. If it can not
+ * be read the key is derived from the time and the process ID.
+ *
+ * @param key The key to fill (SIPHASH_KEY_LENGTH bytes).
+ *
+ * @return false if the key could not be read from /dev/urandom.
+ *
+ * @since 0.4.1.0
+ */
+bool generateSipHashKey(uint8_t* key)
+{
+  struct timespec now;
+  uint64_t        seed[2];
+  ssize_t         bytes = -1;
+  int             fd    = open("/dev/urandom", O_RDONLY);
+
+  if (fd >= 0)
+  {
+    bytes = read(fd, key, SIPHASH_KEY_LENGTH);
+    close(fd);
+  }
+  if (bytes == SIPHASH_KEY_LENGTH)
+  {
+    return true;
+  }
+
+  clock_gettime(CLOCK_REALTIME, &now);
+  seed[0] = ((uint64_t)now.tv_sec << 32) ^ (uint64_t)now.tv_nsec;
+  seed[1] = ((uint64_t)getpid() << 32) ^ (uint64_t)(uintptr_t)&now;
+  memcpy(key, seed, SIPHASH_KEY_LENGTH);
+
+  return false;
+}
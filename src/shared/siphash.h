@@ -0,0 +1,75 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * SipHash-2-4, a keyed 64 bit hash function. With a secret key the hash of
+ * crafted data can not be predicted, which makes it suitable as fingerprint
+ * of data received from the network.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef SIPHASH_H
+#define	SIPHASH_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/** The length of a SipHash key in bytes. */
+#define SIPHASH_KEY_LENGTH 16
+
+/**
+ * Generates the SipHash-2-4 value of the given data block.
+ *
+ * @param key The key (SIPHASH_KEY_LENGTH bytes).
+ * @param data The data block
+ * @param length The size of the data block in bytes.
+ *
+ * @return The 64 bit hash value.
+ *
+ * @since 0.4.1.0
+ */
+uint64_t siphash(const uint8_t* key, const uint8_t* data, uint32_t length);
+
+/**
+ * Fill the given key with random bytes read from /dev/urandom. If it can not
+ * be read the key is derived from the time and the process ID.
+ *
+ * @param key The key to fill (SIPHASH_KEY_LENGTH bytes).
+ *
+ * @return false if the key could not be read from /dev/urandom.
+ *
+ * @since 0.4.1.0
+ */
+bool generateSipHashKey(uint8_t* key);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SIPHASH_H */
@@ -20,10 +20,16 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.4.0.0
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added generateIdentifierCRC32C.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added the IPv4 specialized generateIdentifierV4 and
+ *              generateIdentifierCRC32CV4, the generic functions dispatch
+ *              once on the IP version.
  * 0.4.0.0  - 2016/06/19 - oborchert
  *            * Changed the input parameters of the ID generation. 
  * 0.3.0.10 - 2015/11/09 - oborchert
@@ -37,24 +43,24 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <arpa/inet.h>
 #include "shared/crc32.h"
 #include "shared/srx_identifier.h"
 #include "util/prefix.h"
 #include "srx_defs.h"
 
 /**
- * This particular method generates an ID out of the given data using a simple
- * CRC32 algorithm. All data is used as is, no tranformation from host to
- * network and vice versa is performed.
+ * Select the data blob the ID is generated over. A change in the blob
+ * selection does impact the function update_cache.c:storeCacheEntryBlob
  *
- * @param originAS The origin AS of the data
- * @param prefix The prefix to be announced (IPPrefix)
  * @param data The bgpsec data object which contains the BGP4 path as well.
+ * @param blob OUT - The start of the blob.
  *
- * @return return an ID.
+ * @return The length of the blob in bytes.
+ *
+ * @since 0.4.1.0
  */
-uint32_t generateIdentifier(uint32_t originAS, IPPrefix* prefix, 
-                            BGPSecData* data)
+static uint32_t _getIdentifierBlob(BGPSecData* data, uint8_t** blob)
 {
   // @TODO: Check what the data block should consist of, the BGP4 path or the 
   //        BGPSec Path or maybe both ?
@@ -62,60 +68,181 @@ uint32_t generateIdentifier(uint32_t originAS, IPPrefix* prefix,
   // Then if we receive a request if a particular BGPSEC path for a particular
   // BGP4 path exist this can only be answered by the BGP4 path.
   // This needs some more thoughts later one. 
-  uint32_t blobLength = 0;
-  uint8_t* blob = NULL;
-  // A change in the blob generation does impact the function 
-  // update_cache.c:storeCacheEntryBlob
   if (data->bgpsec_path_attr != 0)
   {
-    blobLength = data->attr_length;
-    blob = (uint8_t*)data->bgpsec_path_attr;    
+    *blob = (uint8_t*)data->bgpsec_path_attr;
+    return data->attr_length;
+  }
+  *blob = (uint8_t*)data->asPath;
+  return data->numberHops * 4;
+}
+
+/**
+ * Append the blob as hex text to the given buffer.
+ *
+ * @param dataPtr The buffer position to write to.
+ * @param blob The blob.
+ * @param blobLength The length of the blob.
+ *
+ * @since 0.4.1.0
+ */
+static void _appendHexBlob(char* dataPtr, uint8_t* blob, uint32_t blobLength)
+{
+  int i;
+
+  for (i = 0; i < blobLength; i++)
+  {
+    sprintf(dataPtr, "%02X", *(char*)blob);
+    dataPtr += 2;
+    blob++;
   }
-  else
+}
+
+/**
+ * This particular method generates an ID out of the given data using a simple
+ * CRC32 algorithm. All data is used as is, no tranformation from host to
+ * network and vice versa is performed.
+ *
+ * @param originAS The origin AS of the data
+ * @param prefix The prefix to be announced (IPPrefix)
+ * @param data The bgpsec data object which contains the BGP4 path as well.
+ *
+ * @return return an ID.
+ */
+uint32_t generateIdentifier(uint32_t originAS, IPPrefix* prefix,
+                            BGPSecData* data)
+{
+  if (prefix->ip.version == 4)
   {
-    blobLength = data->numberHops * 4;
-    blob = (uint8_t*)data->asPath;
+    return generateIdentifierV4(originAS, prefix->ip.addr.v4.u32,
+                                prefix->length, data);
   }
 
-  uint32_t crc  = 0;
-  uint32_t prefixSize = prefix->ip.version == 4 ? 4
-                                                : sizeof(prefix->ip.addr.v6.u8);
+  uint8_t* blob       = NULL;
+  uint32_t blobLength = _getIdentifierBlob(data, &blob);
+  uint32_t prefixSize = sizeof(prefix->ip.addr.v6.u8);
   uint32_t length = (  4           /* OriginAS */
                      + prefixSize  /* IPPrefix */
                      + 1           /* Prefix Length */
                      + blobLength  /* The length of the data blob */
                     ) * 2;         /* To generate a hex string. */
 
-  char dataText[length];
-  memset(dataText, '\0', length);
+  char dataText[length + 1];
   char* dataPtr = dataText;
   int i;
 
   sprintf(dataPtr, "%08X", originAS);
   dataPtr += 8;
-  if (prefix->ip.version == 4)
+  for (i = 0; i < prefixSize; i++)
   {
-    sprintf(dataPtr, "%08X%02X", prefix->ip.addr.v4.u32, prefix->length);
-    dataPtr += 10;
+    sprintf(dataPtr, "%02X", prefix->ip.addr.v6.u8[i]);
+    dataPtr += 2;
   }
-  else
+  sprintf(dataPtr, "%02X", prefix->length);
+  dataPtr += 2;
+  _appendHexBlob(dataPtr, blob, blobLength);
+
+  return crc32((uint8_t*)dataText, length);
+}
+
+/**
+ * The IPv4 specialization of generateIdentifier. It generates the same ID as
+ * generateIdentifier does for the IPv4 prefix.
+ *
+ * @param originAS The origin AS of the data
+ * @param address The IPv4 address of the prefix (IPv4Address.u32)
+ * @param length The prefix length
+ * @param data The bgpsec data object which contains the BGP4 path as well.
+ *
+ * @return return an ID.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t generateIdentifierV4(uint32_t originAS, uint32_t address,
+                              uint8_t length, BGPSecData* data)
+{
+  uint8_t* blob       = NULL;
+  uint32_t blobLength = _getIdentifierBlob(data, &blob);
+  uint32_t textLength = (4 + 4 + 1 + blobLength) * 2;
+  char     dataText[textLength + 1];
+
+  sprintf(dataText, "%08X%08X%02X", originAS, address, length);
+  _appendHexBlob(dataText + 18, blob, blobLength);
+
+  return crc32((uint8_t*)dataText, textLength);
+}
+
+
+/**
+ * Generates an ID out of the given data using CRC-32C over the raw bytes of
+ * the origin AS (network order), the prefix address, the prefix length and 
+ * the path data.
+ *
+ * @param originAS The origin AS of the data
+ * @param prefix The prefix to be announced (IPPrefix)
+ * @param data The bgpsec data object which contains the BGP4 path as well.
+ *
+ * @return return an ID.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t generateIdentifierCRC32C(uint32_t originAS, IPPrefix* prefix, 
+                                  BGPSecData* data)
+{
+  if (prefix->ip.version == 4)
   {
-    for (i = 0; i < prefixSize; i++)
-    {
-      sprintf(dataPtr, "%02X", prefix->ip.addr.v6.u8[i]);
-      dataPtr += 2;
-    }
-    sprintf(dataPtr, "%02X", prefix->length);
-    dataPtr += 2;
+    return generateIdentifierCRC32CV4(originAS, prefix->ip.addr.v4.u32,
+                                      prefix->length, data);
   }
 
-  for (i = 0; i < blobLength; i++)
+  uint8_t* blob       = NULL;
+  uint32_t blobLength = _getIdentifierBlob(data, &blob);
+  // OriginAS, IPPrefix, Prefix Length
+  uint8_t  header[4 + sizeof(prefix->ip.addr.v6.u8) + 1];
+  uint32_t netAS = htonl(originAS);
+
+  memcpy(header, &netAS, 4);
+  memcpy(header + 4, prefix->ip.addr.v6.u8, sizeof(prefix->ip.addr.v6.u8));
+  header[sizeof(header) - 1] = prefix->length;
+
+  uint32_t crc = crc32c(0, header, sizeof(header));
+  if (blobLength > 0)
   {
-    sprintf(dataPtr, "%02X", *(char*)blob);
-    dataPtr += 2;
-    blob++;
-  }  
-  crc = crc32((uint8_t*)dataText, length);
+    crc = crc32c(crc, blob, blobLength);
+  }
   return crc;
 }
 
+/**
+ * The IPv4 specialization of generateIdentifierCRC32C. It generates the same
+ * ID as generateIdentifierCRC32C does for the IPv4 prefix.
+ *
+ * @param originAS The origin AS of the data
+ * @param address The IPv4 address of the prefix (IPv4Address.u32)
+ * @param length The prefix length
+ * @param data The bgpsec data object which contains the BGP4 path as well.
+ *
+ * @return return an ID.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t generateIdentifierCRC32CV4(uint32_t originAS, uint32_t address,
+                                    uint8_t length, BGPSecData* data)
+{
+  uint8_t* blob       = NULL;
+  uint32_t blobLength = _getIdentifierBlob(data, &blob);
+  // OriginAS, IPv4 address, Prefix Length
+  uint8_t  header[4 + 4 + 1];
+  uint32_t netAS = htonl(originAS);
+
+  memcpy(header, &netAS, 4);
+  memcpy(header + 4, &address, 4);
+  header[8] = length;
+
+  uint32_t crc = crc32c(0, header, sizeof(header));
+  if (blobLength > 0)
+  {
+    crc = crc32c(crc, blob, blobLength);
+  }
+  return crc;
+}
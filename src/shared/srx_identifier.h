@@ -20,10 +20,14 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.4.0.0
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added generateIdentifierCRC32C.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added generateIdentifierV4 and generateIdentifierCRC32CV4.
  * 0.4.0.0  - 2016/06/19 - oborchert
  *            * Changed the input parameters of the ID generation. 
  * 0.3.0.10 - 2015/11/09 - oborchert
@@ -55,6 +59,56 @@
 uint32_t generateIdentifier(uint32_t originAS, IPPrefix* prefix, 
                             BGPSecData* data);
 
+/**
+ * Generates an ID out of the given data using CRC-32C over the raw bytes of
+ * the origin AS (network order), the prefix address, the prefix length and 
+ * the path data. No text conversion or memory allocation is performed. This 
+ * generates different IDs than generateIdentifier and is only used if 
+ * negotiated during the handshake (SRX_HELLO_FLAG_CRC32C_ID).
+ *
+ * @param originAS The origin AS of the data
+ * @param prefix The prefix to be announced (IPPrefix)
+ * @param data The bgpsec data object which contains the BGP4 path as well.
+ *
+ * @return return an ID.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t generateIdentifierCRC32C(uint32_t originAS, IPPrefix* prefix, 
+                                  BGPSecData* data);
+
+/**
+ * The IPv4 specialization of generateIdentifier. It generates the same ID as
+ * generateIdentifier does for the IPv4 prefix.
+ *
+ * @param originAS The origin AS of the data
+ * @param address The IPv4 address of the prefix (IPv4Address.u32)
+ * @param length The prefix length
+ * @param data The bgpsec data object which contains the BGP4 path as well.
+ *
+ * @return return an ID.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t generateIdentifierV4(uint32_t originAS, uint32_t address,
+                              uint8_t length, BGPSecData* data);
+
+/**
+ * The IPv4 specialization of generateIdentifierCRC32C. It generates the same
+ * ID as generateIdentifierCRC32C does for the IPv4 prefix.
+ *
+ * @param originAS The origin AS of the data
+ * @param address The IPv4 address of the prefix (IPv4Address.u32)
+ * @param length The prefix length
+ * @param data The bgpsec data object which contains the BGP4 path as well.
+ *
+ * @return return an ID.
+ *
+ * @since 0.4.1.0
+ */
+uint32_t generateIdentifierCRC32CV4(uint32_t originAS, uint32_t address,
+                                    uint8_t length, BGPSecData* data);
+
 
 #endif	/* SRX_IDENTIFIER_H */
 
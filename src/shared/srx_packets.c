@@ -21,10 +21,17 @@
  * by this software.
  *
  *
- * @version 0.4.0.0
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added the multi verification notification and put the packet
+ *              type names in the order of the packet types.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added the bulk verify request.
+ *            * Added the synchronization updates and missing updates.
+ *            * Added the flow control packet.
  * 0.4.0.0  - 2016/06/19 - oborchert
  *            * moved up to version 0.4.0.0 to be synched with header file.
  * 0.3.0.10 - 2015/11/10 - oborchert
@@ -51,12 +58,18 @@ static const char* PACKET_TYPES[PDU_SRXPROXY_UNKNOWN + 1] = {
   "Goodbye",
   "Verify_IPv4",
   "Verify_IPv6",
-  "Request_Receipt",
-  "Delete_Update",
-  "Synch_Request",
+  "Sign_Request",
   "Verification_Notification",
   "Signature_Notification",
+  "Delete_Update",
+  "Peer_Change",
+  "Synch_Request",
   "Error",
+  "Verification_Notification_Multi",
+  "Verify_Bulk",
+  "Sync_Updates",
+  "Sync_Missing",
+  "Flow_Control",
   "Unknown"
 };
 
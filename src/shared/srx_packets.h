@@ -24,10 +24,21 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  * 
- * @version 0.4.0.0
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Turned the zero field of hello and hello response into flags.
+ *            * Added SRX_HELLO_FLAG_CRC32C_ID.
+ *            * Added SRX_HELLO_FLAG_MULTI_NOTIFY and the multi verification
+ *              notification packet.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added SRX_HELLO_FLAG_BULK_VERIFY and the bulk verify request
+ *              packet.
+ *            * Added SRX_HELLO_FLAG_INCR_SYNC and the synchronization updates
+ *              and missing updates packets.
+ *            * Added SRX_HELLO_FLAG_FLOW_CONTROL and the flow control packet.
  * 0.4.0.0  - 2016/06/19 - oborchert
  *            * Moved the proxy-srx-server protocol to version 2.
  *            * Split BGPSecValData into BGPSecValReqData and BGPSecValResData. 
@@ -63,6 +74,25 @@
 /** Block Type Bits */
 #define SRX_PROXY_BLOCK_TYPE_LATEST_SIGNATURE  1
 
+/** Hello Flags Bits. Set in the hello by the proxy to request a feature, set
+ * in the hello response by the server if the feature is used. */
+#define SRX_HELLO_FLAG_CRC32C_ID               1
+#define SRX_HELLO_FLAG_MULTI_NOTIFY            2
+#define SRX_HELLO_FLAG_BULK_VERIFY             4
+#define SRX_HELLO_FLAG_INCR_SYNC               8
+#define SRX_HELLO_FLAG_FLOW_CONTROL           16
+
+/** The maximum number of notifications within one multi verification 
+ * notification packet. */
+#define SRX_MAX_MULTI_NOTIFICATIONS         1024
+
+/** The maximum number of prefixes within one bulk verify request packet. */
+#define SRX_MAX_BULK_ENTRIES                1024
+
+/** The maximum number of updates within one synchronization updates or
+ * missing updates packet. */
+#define SRX_MAX_SYNC_UPDATES                4096
+
 /** Peer Change Type */
 #define SRX_PROXY_PEER_CHANGE_TYPE_REMOVE 0
 #define SRX_PROXY_PEER_CHANGE_TYPE_ADD    1
@@ -98,7 +128,12 @@ typedef enum {
   PDU_SRXPROXY_PEER_CHANGE       =  9,
   PDU_SRXPROXY_SYNC_REQUEST      = 10,
   PDU_SRXPROXY_ERROR             = 11,
-  PDU_SRXPROXY_UNKNOWN           = 12    // NOT IN SPEC
+  PDU_SRXPROXY_VERI_NOTIFICATION_MULTI = 12, // SRX_HELLO_FLAG_MULTI_NOTIFY
+  PDU_SRXPROXY_VERIFY_BULK_REQUEST = 13, // SRX_HELLO_FLAG_BULK_VERIFY
+  PDU_SRXPROXY_SYNC_UPDATES      = 14,   // SRX_HELLO_FLAG_INCR_SYNC
+  PDU_SRXPROXY_SYNC_MISSING      = 15,   // SRX_HELLO_FLAG_INCR_SYNC
+  PDU_SRXPROXY_FLOW_CONTROL      = 16,   // SRX_HELLO_FLAG_FLOW_CONTROL
+  PDU_SRXPROXY_UNKNOWN           = 17    // NOT IN SPEC
 } SRxProxyPDUType;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -129,7 +164,7 @@ typedef struct {
 typedef struct {
   uint8_t    type;              // 0
   uint16_t   version;
-  uint8_t    zero;
+  uint8_t    flags;             // SRX_HELLO_FLAG_*
   uint32_t   length;            // Variable 20(+) Bytes
   uint32_t   proxyIdentifier;
   uint32_t   asn;
@@ -143,7 +178,7 @@ typedef struct {
 typedef struct {
   uint8_t   type;              // 1
   uint16_t  version;
-  uint8_t   zero;
+  uint8_t   flags;             // SRX_HELLO_FLAG_*
   uint32_t  length;            // 12 Bytes
   uint32_t  proxyIdentifier;
 } __attribute__((packed)) SRXPROXY_HELLO_RESPONSE;
@@ -233,6 +268,52 @@ typedef struct {
   BGPSECValReqData bgpsecValReqData;
 } __attribute__((packed)) SRXPROXY_VERIFY_V6_REQUEST;
 
+/**
+ * A single IPv4 prefix within the bulk verify request packet.
+ */
+typedef struct {
+  uint32_t    requestToken;    // Zero if no receipt is requested
+  uint32_t    originAS;
+  IPv4Address prefixAddress;
+  uint8_t     prefixLen;
+  uint8_t     zero[3];
+} __attribute__((packed)) SRXPROXY_BULK_ENTRY_V4;
+
+/**
+ * A single IPv6 prefix within the bulk verify request packet.
+ */
+typedef struct {
+  uint32_t    requestToken;    // Zero if no receipt is requested
+  uint32_t    originAS;
+  IPv6Address prefixAddress;
+  uint8_t     prefixLen;
+  uint8_t     zero[3];
+} __attribute__((packed)) SRXPROXY_BULK_ENTRY_V6;
+
+/**
+ * This struct specifies the bulk verify request packet. It is only send to
+ * servers that negotiated SRX_HELLO_FLAG_BULK_VERIFY and carries the prefixes
+ * of one BGP update. The flags and default results apply to all prefixes. The
+ * header is followed by numHops integer values representing the bgp4 as path,
+ * the bgpsec_path_attr of the length attrLen and noEntries entries of the type
+ * SRXPROXY_BULK_ENTRY_V4 or SRXPROXY_BULK_ENTRY_V6.
+ */
+typedef struct {
+  uint8_t     type;            // 13
+  uint8_t     flags;           // Without SRX_FLAG_REQUEST_RECEIPT
+  uint8_t     roaResSrc;
+  uint8_t     bgpsecResSrc;
+  uint32_t    length;          // 20 + (4 * numHops) + attrLen
+                               //    + (entry size * noEntries) Bytes
+  uint8_t     roaDefRes;
+  uint8_t     bgpsecDefRes;
+  uint8_t     ipVersion;       // 4 or 6
+  uint8_t     zero;
+  uint32_t    noEntries;
+  uint16_t    numHops;
+  uint16_t    attrLen;
+} __attribute__((packed)) SRXPROXY_VERIFY_BULK_REQUEST;
+
 /**
  * This struct specifies the sign request packet
  */
@@ -259,6 +340,31 @@ typedef struct {
   SRxUpdateID updateID;
 } __attribute__((packed)) SRXPROXY_VERIFY_NOTIFICATION;
 
+/**
+ * A single notification within the multi verification notification packet.
+ */
+typedef struct {
+  SRxUpdateID updateID;
+  uint8_t     resultType;  // Without SRX_FLAG_REQUEST_RECEIPT
+  uint8_t     roaResult;
+  uint8_t     bgpsecResult;
+  uint8_t     zero;
+} __attribute__((packed)) SRXPROXY_NOTIFICATION_ENTRY;
+
+/**
+ * This struct specifies the multi verification notification packet. It is 
+ * only send to proxies that negotiated SRX_HELLO_FLAG_MULTI_NOTIFY and carries 
+ * result changes that do not require a receipt.
+ */
+typedef struct {
+  uint8_t     type;            // 12
+  uint16_t    reserved;
+  uint8_t     zero;
+  uint32_t    length;          // 12 + (8 * noNotifications) Bytes
+  uint32_t    noNotifications;
+  SRXPROXY_NOTIFICATION_ENTRY notification[0];
+} __attribute__((packed)) SRXPROXY_VERIFY_NOTIFICATION_MULTI;
+
 /**
  * This struct specifies the signature notification packet
  */
@@ -304,6 +410,52 @@ typedef struct {
   uint32_t    length;          // 8 Bytes
 } __attribute__((packed)) SRXPROXY_SYNCH_REQUEST;
 
+/**
+ * This struct specifies the synchronization updates packet. It is send by
+ * proxies that negotiated SRX_HELLO_FLAG_INCR_SYNC instead of verifying all
+ * updates again. It lists the updates the proxy verified before together with
+ * the results it knows (the resultType specifies the known results). The
+ * server registers the proxy for the updates it still holds, reports the
+ * results that differ using verification notifications, and answers with the
+ * missing updates.
+ */
+typedef struct {
+  uint8_t     type;            // 14
+  uint16_t    reserved;
+  uint8_t     zero;
+  uint32_t    length;          // 12 + (8 * noUpdates) Bytes
+  uint32_t    noUpdates;
+  SRXPROXY_NOTIFICATION_ENTRY update[0];
+} __attribute__((packed)) SRXPROXY_SYNC_UPDATES;
+
+/**
+ * This struct specifies the missing updates packet. It lists the updates of a
+ * synchronization updates packet the server does not hold anymore. These must
+ * be verified again.
+ */
+typedef struct {
+  uint8_t     type;            // 15
+  uint16_t    reserved;
+  uint8_t     zero;
+  uint32_t    length;          // 12 + (4 * noUpdates) Bytes
+  uint32_t    noUpdates;
+  SRxUpdateID updateID[0];
+} __attribute__((packed)) SRXPROXY_SYNC_MISSING;
+
+/**
+ * This struct specifies the flow control packet. It is only send to proxies
+ * that negotiated SRX_HELLO_FLAG_FLOW_CONTROL. Once one of the server queues
+ * passes its high water mark the server asks the proxies to pause sending
+ * (pause = 1), once all queues drained below their low water marks it lets
+ * them resume (pause = 0).
+ */
+typedef struct {
+  uint8_t     type;            // 16
+  uint16_t    reserved;
+  uint8_t     pause;
+  uint32_t    length;          // 8 Bytes
+} __attribute__((packed)) SRXPROXY_FLOW_CONTROL;
+
 /**
  * This struct specifies the error packet
  */
@@ -32,7 +32,23 @@
  *
  * Changelog:
  * -----------------------------------------------------------------------------
- * 0.4.1.0  - 2016/08/30 - oborchert
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * append maps the prefix file into memory and parses it with
+ *              multiple threads into blocks of entries. It also reads the
+ *              CSV and JSON exports of the validators.
+ *            * Added the VRP generator (generate), the churn mode (churn), 
+ *              and the synchronization statistics of the clients (stats).
+ *            * sendPrefixes serializes the full set and the deltas once into
+ *              snapshots shared by all clients and writes them with a single
+ *              sendNumv without holding the cache lock.
+ *            * Replaced the entry list of the cache with a serial-indexed
+ *              delta log, the current state, and a withdrawal queue. Serial
+ *              Queries seek the log with a binary search, only expired
+ *              withdrawals are visited by the service timer.
+ *            * Added the event mode (-e <threads>). All clients are served by
+ *              a few epoll reactors, the responses and the notifications are
+ *              queued per client instead of blocking on slow readers.
+ *          - 2016/08/30 - oborchert
  *            * Added a proper configuration section.
  *          - 2016/08/26 - oborchert
  *            * Changed client list display from using index to file descriptor
@@ -91,6 +107,11 @@
 #include <readline/history.h>
 #include <uthash.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include "server/srx_server.h"
 #include "shared/rpki_router.h"
 #include "util/debug.h"
@@ -100,12 +121,28 @@
 #include "util/rwlock.h"
 #include "util/mutex.h"
 #include "util/server_socket.h"
-#include "util/slist.h"
 #include "util/socket.h"
 #include "util/str.h"
 #include "util/timer.h"
 #include "util/prefix.h"
 
+/** The maximum number of threads parsing a prefix file. */
+#define LOADER_MAX_THREADS  8
+/** The minimum number of bytes parsed by one loader thread. */
+#define LOADER_MIN_CHUNK    (1024 * 1024)
+/** The maximum number of fields of a line in a prefix or CSV file. */
+#define LOADER_LINE_FIELDS  4
+/** The separators of the fields of a line in a prefix or CSV file. */
+#define IS_LOADER_SEP(C) \
+  (((C) == ' ') || ((C) == '\t') || ((C) == ',') || ((C) == '\r'))
+/** White spaces of JSON. */
+#define IS_JSON_SPACE(C) \
+  (((C) == ' ') || ((C) == '\t') || ((C) == '\n') || ((C) == '\r'))
+/** The characters ending a JSON number or literal. */
+#define IS_JSON_DELIM(C) \
+  (   ((C) == ',') || ((C) == '}') || ((C) == ']') || ((C) == '{') \
+   || ((C) == '[') || IS_JSON_SPACE(C))
+
 /** This structure specified one cache entry. */
 typedef struct {
   /** Current serial number of the entry */
@@ -135,8 +172,82 @@ typedef struct {
 
   char* ski;            // Subject Key Identifier
   char* pPubKeyData;    // Subject Public Key Info
+
+  /** The slot of the entry in the delta log. */
+  uint32_t  logIdx;
+  /** The position of an announced entry in the current state. */
+  uint32_t  currIdx;
+  /** The block the entry is allocated in, NULL if allocated on its own. */
+  struct _ValCacheBlock* block;
 } ValCacheEntry;
 
+/** The entries of a prefix file, allocated at once. */
+typedef struct _ValCacheBlock {
+  /** The number of entries not freed yet. */
+  uint32_t      noLive;
+  /** The entries. */
+  ValCacheEntry entries[];
+} ValCacheBlock;
+
+/** A part of a prefix file, parsed by one loader thread. */
+typedef struct {
+  /** The start of the mapped file. */
+  const char*    fileStart;
+  /** The first character of the chunk. */
+  const char*    start;
+  /** The end of the chunk, behind a line break or the end of an object. */
+  const char*    end;
+  /** true if the file is a JSON export. */
+  bool           isJSON;
+  /** The parsed entries, cleared (flags, prefix, max length, AS only). */
+  ValCacheBlock* block;
+  /** The number of parsed entries. */
+  uint32_t       noEntries;
+  /** The number of invalid entries. */
+  uint32_t       noInvalid;
+  /** The file offset of the first invalid entry. */
+  size_t         firstInvalid;
+  /** Set if the block could not be allocated. */
+  bool           failed;
+  /** Set if the chunk is parsed by its own thread. */
+  bool           started;
+  /** The loader thread. */
+  pthread_t      thread;
+} PrefixChunk;
+
+/** A prefix file parsed by the loader threads. */
+typedef struct {
+  /** The chunks in the order of the file. */
+  PrefixChunk chunks[LOADER_MAX_THREADS];
+  int         noChunks;
+  /** The number of invalid entries of all chunks. */
+  uint32_t    noInvalid;
+  /** The file offset of the first invalid entry. */
+  size_t      firstInvalid;
+} PrefixLoad;
+
+/** A serialized set of prefix and router key PDUs shared by all clients. */
+typedef struct {
+  /** The number of references, the snapshot table holds one. */
+  uint32_t  refCount;
+  /** The version of the cache the snapshot was serialized from. */
+  uint32_t  version;
+  /** true if the snapshot contains the full set (Reset Query). */
+  bool      isReset;
+  /** The client serial of the delta (Serial Query). */
+  uint32_t  clientSerial;
+  /** The max. serial of the cache when the snapshot was serialized. */
+  uint32_t  maxSerial;
+  /** The number of prefix and key PDUs. */
+  uint32_t  noPDUs;
+  /** The size of the PDUs in bytes. */
+  size_t    size;
+  /** The allocated size of data. */
+  size_t    capacity;
+  /** The serialized PDUs. */
+  uint8_t*  data;
+} RTRSnapshot;
+
 /** Single client */
 typedef struct {
   /** Socket - but also the hash identifier */
@@ -145,6 +256,21 @@ typedef struct {
   UT_hash_handle  hh;
   /** The version used with this client */
   int             version;
+  /** The number of synchronizations (Cache Responses) sent to this client. */
+  uint32_t        noSyncs;
+  /** The number of prefix and key PDUs sent to this client. */
+  uint64_t        noPDUs;
+  /** The number of prefix and key PDUs of the last synchronization. */
+  uint32_t        lastSyncPDUs;
+  /** The duration of the last synchronization in milliseconds. */
+  double          lastSyncMillis;
+  /** The time between the last Serial Notify and the End of Data of the 
+   * synchronization it triggered, in milliseconds. */
+  double          lastNotifyMillis;
+  /** The time (ns) the last Serial Notify was sent, 0 once it is answered. */
+  uint64_t        notifyTime;
+  /** The connection in the event mode, otherwise NULL. */
+  ServerClient*   svrClient;
 } CacheClient;
 
 /**
@@ -158,6 +284,9 @@ typedef struct {
   int   port;
   /** A script containing cache commands to be executed upon start */
   char* script;
+  /** The number of reactor threads of the event mode, 0 serves each client
+   * by its own thread. */
+  int   eventThreads;
 } RPKI_SRV_Configuration;
 
 #define CMD_ID_QUIT       0
@@ -179,6 +308,20 @@ typedef struct {
 #define CMD_ID_CLIENTS   16
 #define CMD_ID_RUN       17
 #define CMD_ID_SLEEP     18
+#define CMD_ID_GENERATE  19
+#define CMD_ID_CHURN     20
+#define CMD_ID_STATS     21
+
+/** The number of router keys the churn may pick before it gives up. */
+#define WITHDRAW_MAX_MISSES 16
+/** The initial capacity of the arrays of the cache. */
+#define CACHE_INIT_CAPACITY 1024
+/** The number of delta snapshots kept, one per client serial. */
+#define SNAPSHOT_MAX_DELTAS 8
+/** The initial size of a snapshot buffer. */
+#define SNAPSHOT_INIT_SIZE  65536
+/** The maximum number of bytes queued per client in the event mode. */
+#define EVENT_SEND_QUEUE_LIMIT (256 * 1024 * 1024)
 
 #define DEF_RPKI_PORT    /*323*/ 50001
 #define UNDEF_VERSION    -1
@@ -195,26 +338,81 @@ const char* HISTORY_FILENAME          = ".rpkirtr_svr.history\0";
 const char* USER_PROMPT               = ">> \0";
 const int   SERVICE_TIMER_INTERVAL    = 60;   ///< Service interval (sec)
 const int   CACHE_EXPIRATION_INTERVAL = 3600; ///< Sec. to keep removed entries
+const int   GENERATOR_V6_PERCENT      = 20;   ///< Share of generated v6 VRPs
+const int   CHURN_NOTIFY_INTERVAL     = 10;   ///< Default churn notify (sec)
 
 /*-----------------
  * Global variables
  */
 struct {
-  SList     entries;
+  /** The serial-indexed delta log, each entry is listed once with its latest
+   * serial. A superseded slot is NULL but keeps its serial for the seek. */
+  ValCacheEntry** log;
+  /** The serials of the log slots in ascending order. */
+  uint32_t*       logSerials;
+  uint32_t        logSize, logCapacity;
+  /** The number of superseded slots in the log. */
+  uint32_t        noSuperseded;
+  /** The current state, all announced entries in no particular order. */
+  ValCacheEntry** current;
+  uint32_t        noCurrent, currentCapacity;
+  /** The withdrawn entries in the order they expire, starting at wdHead. */
+  ValCacheEntry** withdrawn;
+  uint32_t        wdHead, wdSize, wdCapacity;
+  /** The number of entries, announced and withdrawn. */
+  uint32_t        noEntries;
   RWLock    lock;
   uint32_t  maxSerial;
   uint32_t  minPSExpired, maxSExpired;
+  uint32_t  version;
 } cache;
 
+/** The serialized snapshots of the cache, shared by all clients. */
+struct {
+  /** Protects the table and the references of the snapshots. */
+  Mutex         mutex;
+  /** The full set. */
+  RTRSnapshot*  full;
+  /** The deltas, replaced round robin. */
+  RTRSnapshot*  deltas[SNAPSHOT_MAX_DELTAS];
+  /** The delta to be replaced next. */
+  uint32_t      nextDelta;
+} snapshots;
+
 struct {
   int   timer;
   bool  notify;
 } service;
 
+/** The state of the VRP generator and its churn mode. */
+struct {
+  /** The state of the random generator. */
+  uint64_t  random;
+  /** The churn thread. */
+  pthread_t thread;
+  /** Indicates if the churn thread is running. */
+  bool      churning;
+  /** VRPs announced per second by the churn thread. */
+  uint32_t  announceRate;
+  /** VRPs withdrawn per second by the churn thread. */
+  uint32_t  withdrawRate;
+  /** Seconds between two Serial Notifies of the churn thread. */
+  uint32_t  notifyInterval;
+  /** The number of VRPs generated, including the churn. */
+  uint64_t  noGenerated;
+  /** The number of VRPs withdrawn by the churn thread. */
+  uint64_t  noWithdrawn;
+  /** The number of Serial Notifies sent by the churn thread. */
+  uint64_t  noNotifies;
+} generator;
+
 /** Reference to the server socket. */
 ServerSocket svrSocket;
 /** A list of cache clients */
 CacheClient* clients   = NULL;
+/** Protects the list of clients. In the event mode it also keeps the PDUs
+ * sent to all clients out of a response that is queued. */
+Mutex        clientMutex;
 /** Verbose mode on or off */
 bool         verbose   = true;
 /** the current cache session id value */
@@ -241,9 +439,357 @@ uint16_t     sessionID = 0;
   printf(FMT, ## __VA_ARGS__); \
   OPROMPT()
 
+////////////////////////////////////////////////////////////////////////////////
+// SERIAL-INDEXED DELTA LOG OF THE CACHE
+////////////////////////////////////////////////////////////////////////////////
+/**
+ * Make sure the array can take the given number of elements.
+ *
+ * @param array The array, might be moved.
+ * @param capacity The capacity of the array, gets updated.
+ * @param needed The number of elements needed.
+ * @param elemSize The size of an element.
+ *
+ * @return false if not enough memory was available.
+ *
+ * @since 0.4.1.0
+ */
+static bool reserveArray(void** array, uint32_t* capacity, uint32_t needed,
+                         size_t elemSize)
+{
+  uint32_t newCap = *capacity == 0 ? CACHE_INIT_CAPACITY : *capacity;
+  void*    newArray;
+
+  if (needed <= *capacity)
+  {
+    return true;
+  }
+  while (newCap < needed)
+  {
+    newCap *= 2;
+  }
+  newArray = realloc(*array, newCap * elemSize);
+  if (newArray == NULL)
+  {
+    return false;
+  }
+  *array    = newArray;
+  *capacity = newCap;
+
+  return true;
+}
+
+/**
+ * Remove the superseded slots from the log. The caller MUST hold the write
+ * lock of the cache.
+ *
+ * @since 0.4.1.0
+ */
+static void compactLog()
+{
+  uint32_t readIdx;
+  uint32_t writeIdx = 0;
+
+  for (readIdx = 0; readIdx < cache.logSize; readIdx++)
+  {
+    if (cache.log[readIdx] != NULL)
+    {
+      cache.log[writeIdx]        = cache.log[readIdx];
+      cache.logSerials[writeIdx] = cache.logSerials[readIdx];
+      cache.log[writeIdx]->logIdx = writeIdx;
+      writeIdx++;
+    }
+  }
+  cache.logSize      = writeIdx;
+  cache.noSuperseded = 0;
+}
+
+/**
+ * Mark the log slot of the entry as superseded, the log gets compacted once
+ * half of it is superseded.
+ *
+ * @param cEntry The entry.
+ *
+ * @since 0.4.1.0
+ */
+static void supersedeLogSlot(ValCacheEntry* cEntry)
+{
+  cache.log[cEntry->logIdx] = NULL;
+  cache.noSuperseded++;
+}
+
+/**
+ * Append the entry with its current serial to the log. The log MUST have room
+ * for it.
+ *
+ * @param cEntry The entry.
+ *
+ * @since 0.4.1.0
+ */
+static void appendToLog(ValCacheEntry* cEntry)
+{
+  cEntry->logIdx                  = cache.logSize;
+  cache.log[cache.logSize]        = cEntry;
+  cache.logSerials[cache.logSize] = cEntry->serial;
+  cache.logSize++;
+}
+
+/**
+ * Make sure the log can take one more slot, superseded slots are removed
+ * before the log grows.
+ *
+ * @return false if not enough memory was available.
+ *
+ * @since 0.4.1.0
+ */
+static bool reserveLogSlot()
+{
+  uint32_t capacity = cache.logCapacity;
+
+  if (   (cache.logSize == cache.logCapacity)
+      && (cache.noSuperseded >= cache.logSize / 2))
+  {
+    compactLog();
+  }
+  if (!reserveArray((void**)&cache.log, &capacity, cache.logSize + 1,
+                    sizeof(ValCacheEntry*)))
+  {
+    return false;
+  }
+  // Both arrays always have the same capacity.
+  if (!reserveArray((void**)&cache.logSerials, &cache.logCapacity,
+                    cache.logSize + 1, sizeof(uint32_t)))
+  {
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Add the new announcement to the log and the current state. The serial of
+ * the entry MUST be newer than all serials in the log. The caller MUST hold
+ * the write lock of the cache.
+ *
+ * @param cEntry The entry, the cache takes it over.
+ *
+ * @return false if not enough memory was available, the entry is not added.
+ *
+ * @since 0.4.1.0
+ */
+static bool addCacheEntry(ValCacheEntry* cEntry)
+{
+  if (   !reserveLogSlot()
+      || !reserveArray((void**)&cache.current, &cache.currentCapacity,
+                       cache.noCurrent + 1, sizeof(ValCacheEntry*)))
+  {
+    return false;
+  }
+  appendToLog(cEntry);
+  cEntry->currIdx = cache.noCurrent;
+  cache.current[cache.noCurrent++] = cEntry;
+  cache.noEntries++;
+
+  return true;
+}
+
+/**
+ * Withdraw the announced entry. It gets the next serial, moves to the end of
+ * the log, and expires at the given time. The caller MUST hold the write lock
+ * of the cache.
+ *
+ * @param cEntry The announced entry.
+ * @param expires The time the withdrawal expires.
+ *
+ * @return false if not enough memory was available, the entry is unchanged.
+ *
+ * @since 0.4.1.0
+ */
+static bool withdrawCacheEntry(ValCacheEntry* cEntry, time_t expires)
+{
+  ValCacheEntry* last;
+
+  if (   !reserveLogSlot()
+      || !reserveArray((void**)&cache.withdrawn, &cache.wdCapacity,
+                       cache.wdSize + 1, sizeof(ValCacheEntry*)))
+  {
+    return false;
+  }
+
+  // Remove from the current state, the last entry takes its place.
+  last = cache.current[--cache.noCurrent];
+  cache.current[cEntry->currIdx] = last;
+  last->currIdx = cEntry->currIdx;
+
+  cEntry->flags  &= ~PREFIX_FLAG_ANNOUNCEMENT;
+  cEntry->serial  = ++cache.maxSerial;
+  cEntry->expires = expires;
+  supersedeLogSlot(cEntry);
+  appendToLog(cEntry);
+  cache.withdrawn[cache.wdSize++] = cEntry;
+
+  return true;
+}
+
+/**
+ * Free the entry and its router key data. The block of the entry is freed
+ * with its last entry.
+ *
+ * @param cEntry The entry.
+ *
+ * @since 0.4.1.0
+ */
+static void freeCacheEntry(ValCacheEntry* cEntry)
+{
+  free(cEntry->ski);
+  free(cEntry->pPubKeyData);
+  if (cEntry->block == NULL)
+  {
+    free(cEntry);
+  }
+  else if (--cEntry->block->noLive == 0)
+  {
+    // The last entry of the block
+    free(cEntry->block);
+  }
+}
+
+/**
+ * Delete the withdrawals that expired. The withdrawals expire in the order
+ * they were made. The caller MUST hold the write lock of the cache.
+ *
+ * @param now The current time.
+ *
+ * @return The number of deleted entries.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t deleteExpiredWithdrawals(time_t now)
+{
+  ValCacheEntry* cEntry;
+  uint32_t       removed = 0;
+
+  while (   (cache.wdHead < cache.wdSize)
+         && (cache.withdrawn[cache.wdHead]->expires <= now))
+  {
+    cEntry = cache.withdrawn[cache.wdHead++];
+    cache.minPSExpired = MIN(cache.minPSExpired, cEntry->prevSerial);
+    cache.maxSExpired  = MAX(cache.maxSExpired, cEntry->serial);
+    supersedeLogSlot(cEntry);
+    cache.noEntries--;
+    freeCacheEntry(cEntry);
+    removed++;
+  }
+  if (cache.noSuperseded >= cache.logSize / 2)
+  {
+    compactLog();
+  }
+  // Drop the expired entries in front of the withdrawal queue.
+  if (cache.wdHead >= cache.wdSize / 2)
+  {
+    memmove(cache.withdrawn, &cache.withdrawn[cache.wdHead],
+            (cache.wdSize - cache.wdHead) * sizeof(ValCacheEntry*));
+    cache.wdSize -= cache.wdHead;
+    cache.wdHead  = 0;
+  }
+
+  return removed;
+}
+
+/**
+ * Return the first log slot whose serial is newer than the given serial.
+ * The caller MUST hold the read lock of the cache.
+ *
+ * @param clientSerial The serial of the client.
+ *
+ * @return The slot, the size of the log if the client is up to date.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t seekLog(uint32_t clientSerial)
+{
+  uint32_t low  = 0;
+  uint32_t high = cache.logSize;
+  uint32_t mid;
+
+  while (low < high)
+  {
+    mid = low + (high - low) / 2;
+    if (cache.logSerials[mid] > clientSerial)
+    {
+      high = mid;
+    }
+    else
+    {
+      low = mid + 1;
+    }
+  }
+
+  return low;
+}
+
+/**
+ * Free all entries, the cache is empty afterwards. The caller MUST hold the
+ * write lock of the cache.
+ *
+ * @since 0.4.1.0
+ */
+static void clearCache()
+{
+  uint32_t idx;
+
+  for (idx = 0; idx < cache.logSize; idx++)
+  {
+    if (cache.log[idx] != NULL)
+    {
+      freeCacheEntry(cache.log[idx]);
+    }
+  }
+  cache.logSize      = 0;
+  cache.noSuperseded = 0;
+  cache.noCurrent    = 0;
+  cache.wdHead       = 0;
+  cache.wdSize       = 0;
+  cache.noEntries    = 0;
+}
+
+/**
+ * Release all entries and the memory of the log.
+ *
+ * @since 0.4.1.0
+ */
+static void releaseCache()
+{
+  clearCache();
+  free(cache.log);
+  free(cache.logSerials);
+  free(cache.current);
+  free(cache.withdrawn);
+  cache.log         = NULL;
+  cache.logSerials  = NULL;
+  cache.current     = NULL;
+  cache.withdrawn   = NULL;
+  cache.logCapacity = cache.currentCapacity = cache.wdCapacity = 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // CLIENT SERVER COMMUNICATION AND UTILITIES
 ////////////////////////////////////////////////////////////////////////////////
+/**
+ * Return the monotonic time in nano seconds. Used to measure the 
+ * synchronization of the clients.
+ *
+ * @return The time in nano seconds.
+ *
+ * @since 0.4.1.0
+ */
+uint64_t getTimeNanos()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 /**
  * This function checks the validity of the requested serial number. It might
  * be that the cache performed a serial number overflow. This means the serial
@@ -273,46 +819,55 @@ bool checkSerial(uint32_t cache_min, uint32_t cache_max, uint32_t client_serial)
 }
 
 /**
- * Drop the session to the session with the given file descriptor.
- * @param fdPtr The file descriptor
+ * Send the PDU to the client. In the event mode the server socket queues the
+ * part that cannot be written right away, otherwise the call blocks.
  *
- * @return true if the session could be dropped.
+ * @param ccl The client.
+ * @param pdu The PDU.
+ * @param len The length of the PDU.
+ *
+ * @return true if the PDU was sent or queued.
+ *
+ * @since 0.4.1.0
  */
-bool dropSession(int* fdPtr)
+bool sendToClient(CacheClient* ccl, void* pdu, size_t len)
 {
-  bool result = false;
-  if (HASH_COUNT(clients) > 0)
-  {
-    CacheClient*  cl;
+  // sendNum resets a broken descriptor, the client keeps its hash key.
+  int fd = ccl->fd;
 
-    acquireReadLock(&cache.lock);
-    for (cl = clients; cl; cl = cl->hh.next)
-    {
-      if (&cl->fd == fdPtr)
-      {
-        OUTPUTF(true, "Close session to the given client\n");
+  if (ccl->svrClient != NULL)
+  {
+    return sendPacketToClient(&svrSocket, ccl->svrClient, pdu, len);
+  }
+  return sendNum(&fd, pdu, len);
+}
 
-        // TODO: Close session and remove it from list.
+/**
+ * Drop the session to the given client.
+ *
+ * @param ccl The client.
+ *
+ * @return true if the session could be dropped.
+ */
+bool dropSession(CacheClient* ccl)
+{
+  OUTPUTF(true, "Close session to the given client\n");
 
-        result = true;
-        break;
-      }
-    }
-    unlockReadLock(&cache.lock);
-  }
+  // TODO: Close session and remove it from list.
 
-  return result;
+  return ccl != NULL;
 }
 
 /**
  * Send a PDU that contains the serial field. This method can be used to
  * send SERIAL_NOTIFY (4.1), SERIAL_QUERY (4.2), or END_OF_DATA (4.7)
- * @param fdPtr The file descriptor to be used to send the packet.
+ * @param ccl The client the packet is sent to.
  * @param type The PDU type.
  *
  * @return
  */
-bool sendPDUWithSerial(int* fdPtr, RPKIRouterPDUType type, uint32_t serial)
+bool sendPDUWithSerial(CacheClient* ccl, RPKIRouterPDUType type,
+                       uint32_t serial)
 {
   uint8_t                pdu[sizeof(RPKISerialQueryHeader)];
   RPKISerialQueryHeader* hdr;
@@ -326,17 +881,17 @@ bool sendPDUWithSerial(int* fdPtr, RPKIRouterPDUType type, uint32_t serial)
   hdr->serial    = htonl(serial);
   // Send
   OUTPUTF(true, "Sending an RPKI-RTR 'PDU[%u] with Serial'\n", type);
-  return sendNum(fdPtr, &pdu, sizeof(RPKISerialQueryHeader));
+  return sendToClient(ccl, &pdu, sizeof(RPKISerialQueryHeader));
 }
 
 /**
  * Send a CACHE RESET to the client.
  *
- * @param fdPtr the socket connection
+ * @param ccl the client
  *
  * @return true id the packet was send successful.
  */
-bool sendCacheReset(int* fdPtr)
+bool sendCacheReset(CacheClient* ccl)
 {
   uint8_t               pdu[sizeof(RPKICacheResetHeader)];
   RPKICacheResetHeader* hdr;
@@ -348,7 +903,7 @@ bool sendCacheReset(int* fdPtr)
   hdr->reserved = 0;
   hdr->length   = htonl(sizeof(RPKICacheResetHeader));
 
-  return sendNum(fdPtr, &pdu, sizeof(RPKICacheResetHeader));
+  return sendToClient(ccl, &pdu, sizeof(RPKICacheResetHeader));
 }
 
 /**
@@ -375,179 +930,416 @@ bool sendCacheResponse(int* fdPtr)
 }
 
 /**
- * Send IP prefixes
+ * Invalidate all snapshots of the cache. Each writer calls this after it
+ * modified the cache, the next synchronization serializes the cache again.
  *
- * @param fdPtr The file descriptor
- * @param clientSerial the serial the client requested.
- * @param clientSessionID the sessionID of the client request.
- * @param isReset if set to true both clientSerial nor clientSessionID is
- *                ignored.
+ * @since 0.4.1.0
  */
-void sendPrefixes(int* fdPtr, uint32_t clientSerial, uint16_t clientSessionID,
-                  bool isReset)
+void cacheChanged()
 {
-  // No need to send the notify anymore
-  service.notify = false;
-
-  // Let no one modify the cache
-  acquireReadLock(&cache.lock);
+  __sync_add_and_fetch(&cache.version, 1);
+}
 
-  // Send "Cache Reset" in case
-  // A: The client and the cache operate on a different SESSION IDddd
-  // B: The serial of the client can not be served buy the cache.
-  if (!isReset && (clientSessionID != sessionID))
-  { // session id is incorrect, drop this session
-    dropSession(fdPtr);
-  }
-  else if (   !isReset
-           && (checkSerial(cache.minPSExpired, cache.maxSExpired, clientSerial))
-          )
-  { // Serial is incorrect, send a Cache Reset
-    if (!sendCacheReset(fdPtr))
-    {
-      ERRORF("Error: Failed to send a 'Cache Reset'\n");
-    }
+/**
+ * Drop a reference to the snapshot, the last one frees it. The caller MUST
+ * hold the snapshot mutex.
+ *
+ * @param snapshot The snapshot or NULL.
+ *
+ * @since 0.4.1.0
+ */
+static void dropSnapshot(RTRSnapshot* snapshot)
+{
+  if ((snapshot != NULL) && (--snapshot->refCount == 0))
+  {
+    free(snapshot->data);
+    free(snapshot);
   }
-  else
-  { // Send the prefix
-    // Send 'Cache Response'
-    if (!sendCacheResponse(fdPtr))
-    {
-      ERRORF("Error: Failed to send a 'Cache Response'\n");
-    }
-    else
-    {
-      printf("Cache size = %u\n", cache.entries.size);
-      if (cache.entries.size > 0) // there is always a root.
-      {
-        ValCacheEntry* cEntry;
-
-        uint8_t               v4pdu[sizeof(RPKIIPv4PrefixHeader)];
-        uint8_t               v6pdu[sizeof(RPKIIPv6PrefixHeader)];
-        RPKIIPv4PrefixHeader* v4hdr = (RPKIIPv4PrefixHeader*)v4pdu;
-        RPKIIPv6PrefixHeader* v6hdr = (RPKIIPv6PrefixHeader*)v6pdu;
-        RPKIRouterKeyHeader   rkhdr;
-
-        // Basic initialization of data that does NOT change
-        v4hdr->version  = RPKI_RTR_PROTOCOL_VERSION;
-        v4hdr->type     = PDU_TYPE_IP_V4_PREFIX;
-        v4hdr->reserved = 0;
-        v4hdr->length   = htonl(sizeof(RPKIIPv4PrefixHeader));
-
-        v6hdr->version  = RPKI_RTR_PROTOCOL_VERSION;
-        v6hdr->type     = PDU_TYPE_IP_V6_PREFIX;
-        v6hdr->reserved = 0;
-        v6hdr->length   = htonl(sizeof(RPKIIPv6PrefixHeader));
-
-        rkhdr.version   = RPKI_RTR_PROTOCOL_VERSION;
-        rkhdr.type      = PDU_TYPE_ROUTER_KEY;
-        rkhdr.zero      = 0;
-
-        // helps to find the next serial number
-        SListNode*  currNode;
-        uint32_t    serial;
-
-        // Go through list until next available serial is found
-        FOREACH_SLIST(&cache.entries, currNode)
-        {
-          serial = ((ValCacheEntry*)getDataOfSListNode(currNode))->serial;
-          if (isReset || (serial > clientSerial))
-          {
-            break;
-          }
-        }
+}
 
-        // Go over each node. currNode is not null if a serial was found.
-        for (; currNode; currNode = getNextNodeOfSListNode(currNode))
-        {
-          cEntry = (ValCacheEntry*)getDataOfSListNode(currNode);
+/**
+ * Release the snapshot acquired with acquireSnapshot.
+ *
+ * @param snapshot The snapshot.
+ *
+ * @since 0.4.1.0
+ */
+static void releaseSnapshot(RTRSnapshot* snapshot)
+{
+  lockMutex(&snapshots.mutex);
+  dropSnapshot(snapshot);
+  unlockMutex(&snapshots.mutex);
+}
 
-          // Skip entries that are already expired.
-          if (isReset)
-          {
-            if ((cEntry->flags & PREFIX_FLAG_ANNOUNCEMENT) == 0)
-            {
-              // This entry is NOT an announcement. Because we send a fresh set,
-              // only announcements will be send, no withdrawals.
-              continue;
-            }
-          }
+/**
+ * Release the snapshot once the server socket sent its queued data.
+ *
+ * @param snapshot The snapshot.
+ *
+ * @since 0.4.1.0
+ */
+static void releaseQueuedSnapshot(void* snapshot)
+{
+  releaseSnapshot((RTRSnapshot*)snapshot);
+}
 
-          // Skip entries that were never announced to the client
-          if (   (cEntry->serial != cEntry->prevSerial)
-              && (cEntry->prevSerial > clientSerial))
-          {
-            continue;
-          }
+/**
+ * Append a PDU to the snapshot.
+ *
+ * @param snapshot The snapshot.
+ * @param pdu The PDU.
+ * @param len The length of the PDU.
+ *
+ * @return false if not enough memory was available.
+ *
+ * @since 0.4.1.0
+ */
+static bool appendToSnapshot(RTRSnapshot* snapshot, void* pdu, size_t len)
+{
+  size_t   newCap;
+  uint8_t* newData;
+
+  if (snapshot->size + len > snapshot->capacity)
+  {
+    newCap = snapshot->capacity == 0 ? SNAPSHOT_INIT_SIZE
+                                     : snapshot->capacity;
+    while (newCap < snapshot->size + len)
+    {
+      newCap *= 2;
+    }
+    newData = realloc(snapshot->data, newCap);
+    if (newData == NULL)
+    {
+      return false;
+    }
+    snapshot->data     = newData;
+    snapshot->capacity = newCap;
+  }
+  memcpy(snapshot->data + snapshot->size, pdu, len);
+  snapshot->size += len;
+  snapshot->noPDUs++;
 
-          // Send 'Router Key'
-          if( cEntry->prefixLength == 0 && cEntry->prefixMaxLength == 0 &&
-              cEntry->ski && cEntry->pPubKeyData)
+  return true;
+}
 
-          {
-            rkhdr.flags     = cEntry->flags;
-            memcpy(&rkhdr.ski, cEntry->ski, 20);
-            memcpy(&rkhdr.keyInfo, cEntry->pPubKeyData, 91);
-            rkhdr.as        = cEntry->asNumber;
-            rkhdr.length    = htonl(sizeof(RPKIRouterKeyHeader));
-
-            OUTPUTF(false, "Sending an 'Router Key' (serial = %u)\n",
-                    cEntry->serial);
-            if (!sendNum(fdPtr, &rkhdr, sizeof(RPKIRouterKeyHeader)))
-            {
-              ERRORF("Error: Failed to send a 'Prefix'\n");
-              break;
-            }
-            continue;
-          }
+/**
+ * Serialize the PDU of the given entry into the snapshot.
+ *
+ * @param snapshot The snapshot.
+ * @param cEntry The prefix or router key entry.
+ *
+ * @return false if not enough memory was available.
+ *
+ * @since 0.4.1.0
+ */
+static bool serializeEntry(RTRSnapshot* snapshot, ValCacheEntry* cEntry)
+{
+  RPKIIPv4PrefixHeader v4hdr;
+  RPKIIPv6PrefixHeader v6hdr;
+  RPKIRouterKeyHeader  rkhdr;
 
-          // Send 'Prefix'
-          if (!cEntry->isV6)
-          {
-            v4hdr->flags     = cEntry->flags;
-            v4hdr->prefixLen = cEntry->prefixLength;
-            v4hdr->maxLen    = cEntry->prefixMaxLength;
-            v4hdr->zero      = (uint8_t)0;
-            v4hdr->addr      = cEntry->address.v4;
-            v4hdr->as        = cEntry->asNumber;
-            OUTPUTF(false, "Sending an 'IPv4Prefix' (serial = %u)\n",
-                    cEntry->serial);
-            if (!sendNum(fdPtr, &v4pdu, sizeof(RPKIIPv4PrefixHeader)))
-            {
-              ERRORF("Error: Failed to send a 'Prefix'\n");
-              break;
-            }
-          }
-          else
-          {
-            v6hdr->flags     = cEntry->flags;
-            v6hdr->prefixLen = cEntry->prefixLength;
-            v6hdr->maxLen    = cEntry->prefixMaxLength;
-            v6hdr->zero      = (uint8_t)0;
-            v6hdr->addr      = cEntry->address.v6;
-            v6hdr->as        = cEntry->asNumber;
-            OUTPUTF(false, "Sending an 'IPv6Prefix' (serial = %u)\n",
-                    cEntry->serial);
-            if (!sendNum(fdPtr, &v6pdu, sizeof(RPKIIPv6PrefixHeader)))
-            {
-              ERRORF("Error: Failed to send a 'Prefix'\n");
-              break;
-            }
-          }
-        }
+  // Serialize 'Router Key'
+  if( cEntry->prefixLength == 0 && cEntry->prefixMaxLength == 0 &&
+      cEntry->ski && cEntry->pPubKeyData)
+
+  {
+    rkhdr.version   = RPKI_RTR_PROTOCOL_VERSION;
+    rkhdr.type      = PDU_TYPE_ROUTER_KEY;
+    rkhdr.zero      = 0;
+    rkhdr.flags     = cEntry->flags;
+    memcpy(&rkhdr.ski, cEntry->ski, 20);
+    memcpy(&rkhdr.keyInfo, cEntry->pPubKeyData, 91);
+    rkhdr.as        = cEntry->asNumber;
+    rkhdr.length    = htonl(sizeof(RPKIRouterKeyHeader));
+
+    OUTPUTF(false, "Serializing a 'Router Key' (serial = %u)\n",
+            cEntry->serial);
+    return appendToSnapshot(snapshot, &rkhdr, sizeof(RPKIRouterKeyHeader));
+  }
+
+  // Serialize 'Prefix'
+  if (!cEntry->isV6)
+  {
+    v4hdr.version   = RPKI_RTR_PROTOCOL_VERSION;
+    v4hdr.type      = PDU_TYPE_IP_V4_PREFIX;
+    v4hdr.reserved  = 0;
+    v4hdr.length    = htonl(sizeof(RPKIIPv4PrefixHeader));
+    v4hdr.flags     = cEntry->flags;
+    v4hdr.prefixLen = cEntry->prefixLength;
+    v4hdr.maxLen    = cEntry->prefixMaxLength;
+    v4hdr.zero      = (uint8_t)0;
+    v4hdr.addr      = cEntry->address.v4;
+    v4hdr.as        = cEntry->asNumber;
+    OUTPUTF(false, "Serializing an 'IPv4Prefix' (serial = %u)\n",
+            cEntry->serial);
+    return appendToSnapshot(snapshot, &v4hdr, sizeof(RPKIIPv4PrefixHeader));
+  }
+
+  v6hdr.version   = RPKI_RTR_PROTOCOL_VERSION;
+  v6hdr.type      = PDU_TYPE_IP_V6_PREFIX;
+  v6hdr.reserved  = 0;
+  v6hdr.length    = htonl(sizeof(RPKIIPv6PrefixHeader));
+  v6hdr.flags     = cEntry->flags;
+  v6hdr.prefixLen = cEntry->prefixLength;
+  v6hdr.maxLen    = cEntry->prefixMaxLength;
+  v6hdr.zero      = (uint8_t)0;
+  v6hdr.addr      = cEntry->address.v6;
+  v6hdr.as        = cEntry->asNumber;
+  OUTPUTF(false, "Serializing an 'IPv6Prefix' (serial = %u)\n",
+          cEntry->serial);
+  return appendToSnapshot(snapshot, &v6hdr, sizeof(RPKIIPv6PrefixHeader));
+}
+
+/**
+ * Serialize the prefix and router key PDUs for the given client serial. The
+ * full set is taken from the current state, a delta from the log starting at
+ * the first entry newer than the client serial. The caller MUST hold the read
+ * lock of the cache.
+ *
+ * @param clientSerial the serial the client requested.
+ * @param isReset if set to true the clientSerial is ignored and the full set
+ *                is serialized.
+ * @param version The version of the cache.
+ *
+ * @return The new snapshot with one reference or NULL if not enough memory was
+ *         available.
+ *
+ * @since 0.4.1.0
+ */
+static RTRSnapshot* buildSnapshot(uint32_t clientSerial, bool isReset,
+                                  uint32_t version)
+{
+  RTRSnapshot*   snapshot = calloc(1, sizeof(RTRSnapshot));
+  bool           ok       = snapshot != NULL;
+  ValCacheEntry* cEntry;
+  uint32_t       idx;
+
+  if (!ok)
+  {
+    return NULL;
+  }
+  snapshot->refCount     = 1;
+  snapshot->version      = version;
+  snapshot->isReset      = isReset;
+  snapshot->clientSerial = clientSerial;
+  snapshot->maxSerial    = cache.maxSerial;
+
+  printf("Cache size = %u\n", cache.noEntries);
+  if (isReset)
+  {
+    // Because we send a fresh set, only announcements will be send, no
+    // withdrawals.
+    for (idx = 0; ok && (idx < cache.noCurrent); idx++)
+    {
+      ok = serializeEntry(snapshot, cache.current[idx]);
+    }
+  }
+  else
+  {
+    // Go over each log slot newer than the client serial.
+    for (idx = seekLog(clientSerial); ok && (idx < cache.logSize); idx++)
+    {
+      cEntry = cache.log[idx];
+      // Skip superseded slots and entries that were never announced to the
+      // client
+      if (   (cEntry == NULL)
+          || (   (cEntry->serial != cEntry->prevSerial)
+              && (cEntry->prevSerial > clientSerial)))
+      {
+        continue;
       }
+      ok = serializeEntry(snapshot, cEntry);
+    }
+  }
+
+  if (!ok)
+  {
+    dropSnapshot(snapshot);
+    snapshot = NULL;
+  }
+
+  return snapshot;
+}
 
-      // Send 'End of Data'
-      OUTPUTF(true, "Sending an 'End of Data (max. serial = %u)\n",
-              cache.maxSerial);
+/**
+ * Return the snapshot for the given client serial. A snapshot of the current
+ * cache version is shared, otherwise a new one is serialized and replaces the
+ * full set or the oldest delta. The caller MUST hold the read lock of the
+ * cache and release the snapshot with releaseSnapshot.
+ *
+ * @param clientSerial the serial the client requested.
+ * @param isReset if set to true the full set is returned.
+ *
+ * @return The snapshot or NULL if not enough memory was available.
+ *
+ * @since 0.4.1.0
+ */
+static RTRSnapshot* acquireSnapshot(uint32_t clientSerial, bool isReset)
+{
+  uint32_t      version  = cache.version;
+  RTRSnapshot*  snapshot = NULL;
+  RTRSnapshot** slot     = &snapshots.full;
+  uint32_t      idx;
+
+  // Clients asking at the same time wait for one serialization.
+  lockMutex(&snapshots.mutex);
+  if (!isReset)
+  {
+    slot = &snapshots.deltas[snapshots.nextDelta];
+    for (idx = 0; idx < SNAPSHOT_MAX_DELTAS; idx++)
+    {
+      if (   (snapshots.deltas[idx] != NULL)
+          && (snapshots.deltas[idx]->clientSerial == clientSerial))
+      {
+        slot = &snapshots.deltas[idx];
+        break;
+      }
+    }
+  }
 
-      if (!sendPDUWithSerial(fdPtr, PDU_TYPE_END_OF_DATA, cache.maxSerial))
+  if (   (*slot != NULL) && ((*slot)->version == version)
+      && ((*slot)->isReset || ((*slot)->clientSerial == clientSerial)))
+  {
+    snapshot = *slot;
+  }
+  else
+  {
+    snapshot = buildSnapshot(clientSerial, isReset, version);
+    if (snapshot != NULL)
+    {
+      if (slot == &snapshots.deltas[snapshots.nextDelta])
       {
-        ERRORF("Error: Failed to send a 'End of Data'\n");
+        snapshots.nextDelta = (snapshots.nextDelta + 1) % SNAPSHOT_MAX_DELTAS;
       }
+      dropSnapshot(*slot);
+      *slot = snapshot;
+    }
+  }
+  if (snapshot != NULL)
+  {
+    snapshot->refCount++;
+  }
+  unlockMutex(&snapshots.mutex);
+
+  return snapshot;
+}
+
+/**
+ * Send IP prefixes. The prefix and key PDUs are taken from a snapshot shared
+ * by all clients and written together with the 'Cache Response' and the 'End
+ * of Data' without holding the cache lock. In the event mode the snapshot is
+ * queued without copying it.
+ *
+ * @param ccl The client
+ * @param clientSerial the serial the client requested.
+ * @param clientSessionID the sessionID of the client request.
+ * @param isReset if set to true both clientSerial nor clientSessionID is
+ *                ignored.
+ *
+ * @return The number of prefix and key PDUs sent.
+ */
+uint32_t sendPrefixes(CacheClient* ccl, uint32_t clientSerial,
+                      uint16_t clientSessionID, bool isReset)
+{
+  // The number of prefix and key PDUs sent.
+  uint32_t                noPDUs   = 0;
+  RTRSnapshot*            snapshot = NULL;
+  RPKICacheResponseHeader response;
+  RPKISerialQueryHeader   endOfData;
+  struct iovec            iov[3];
+  int                     fd       = ccl->fd;
+  bool                    sent;
+
+  // No need to send the notify anymore
+  service.notify = false;
+
+  // Let no one modify the cache
+  acquireReadLock(&cache.lock);
+
+  // Send "Cache Reset" in case
+  // A: The client and the cache operate on a different SESSION IDddd
+  // B: The serial of the client can not be served buy the cache.
+  if (!isReset && (clientSessionID != sessionID))
+  { // session id is incorrect, drop this session
+    dropSession(ccl);
+  }
+  else if (   !isReset
+           && (checkSerial(cache.minPSExpired, cache.maxSExpired, clientSerial))
+          )
+  { // Serial is incorrect, send a Cache Reset
+    if (!sendCacheReset(ccl))
+    {
+      ERRORF("Error: Failed to send a 'Cache Reset'\n");
+    }
+  }
+  else
+  { // Serialize the prefixes
+    snapshot = acquireSnapshot(clientSerial, isReset);
+    if (snapshot == NULL)
+    {
+      ERRORF("Error: Not enough memory to serialize the cache\n");
     }
   }
   unlockReadLock(&cache.lock);
+
+  if (snapshot != NULL)
+  { // Send the prefix
+    response.version   = RPKI_RTR_PROTOCOL_VERSION;
+    response.type      = (uint8_t)PDU_TYPE_CACHE_RESPONSE;
+    response.sessionID = htons(sessionID);
+    response.length    = htonl(sizeof(RPKICacheResetHeader));
+
+    endOfData.version   = RPKI_RTR_PROTOCOL_VERSION;
+    endOfData.type      = (uint8_t)PDU_TYPE_END_OF_DATA;
+    endOfData.sessionID = htons(sessionID);
+    endOfData.length    = htonl(sizeof(RPKISerialQueryHeader));
+    endOfData.serial    = htonl(snapshot->maxSerial);
+
+    iov[0].iov_base = &response;
+    iov[0].iov_len  = sizeof(RPKICacheResetHeader);
+    iov[1].iov_base = snapshot->data;
+    iov[1].iov_len  = snapshot->size;
+    iov[2].iov_base = &endOfData;
+    iov[2].iov_len  = sizeof(RPKISerialQueryHeader);
+
+    OUTPUTF(true, "Sending a 'Cache Response', %u PDUs (%zu bytes), and an "
+                  "'End of Data (max. serial = %u)\n",
+            snapshot->noPDUs, snapshot->size, snapshot->maxSerial);
+    noPDUs = snapshot->noPDUs;
+    if (ccl->svrClient != NULL)
+    {
+      // The queue takes over the reference of the snapshot.
+      lockMutex(&clientMutex);
+      sent = sendPacketToClient(&svrSocket, ccl->svrClient, &response,
+                                sizeof(RPKICacheResetHeader));
+      if (sent)
+      {
+        sent = sendSharedToClient(&svrSocket, ccl->svrClient, snapshot->data,
+                                  snapshot->size, releaseQueuedSnapshot,
+                                  snapshot);
+        snapshot = NULL;
+      }
+      sent = sent && sendPacketToClient(&svrSocket, ccl->svrClient,
+                                        &endOfData,
+                                        sizeof(RPKISerialQueryHeader));
+      unlockMutex(&clientMutex);
+    }
+    else
+    {
+      sent = sendNumv(&fd, iov, 3);
+    }
+    if (!sent)
+    {
+      ERRORF("Error: Failed to send the prefixes\n");
+      noPDUs = 0;
+    }
+    if (snapshot != NULL)
+    {
+      releaseSnapshot(snapshot);
+    }
+  }
+
+  return noPDUs;
 }
 
 /**
@@ -565,14 +1357,20 @@ int sendSerialNotifyToAllClients()
             cache.maxSerial);
 
     acquireReadLock(&cache.lock);
+    lockMutex(&clientMutex);
     for (client = clients; client; client = client->hh.next)
     {
-      if (!sendPDUWithSerial(&client->fd, PDU_TYPE_SERIAL_NOTIFY,
-                             cache.maxSerial))
+      if (!sendPDUWithSerial(client, PDU_TYPE_SERIAL_NOTIFY, cache.maxSerial))
       {
         ERRORF("Error: Failed to send a 'Serial Notify\n");
       }
+      else if (client->notifyTime == 0)
+      {
+        // Measure from the oldest notify the client did not answer yet.
+        client->notifyTime = getTimeNanos();
+      }
     }
+    unlockMutex(&clientMutex);
 
     unlockReadLock(&cache.lock);
   }
@@ -593,15 +1391,15 @@ int sendCacheResetToAllClients()
 
     OUTPUTF(true, "Sending 'Cache Reset' to all clients\n");
 
+    lockMutex(&clientMutex);
     for (client = clients; client; client = client->hh.next)
     {
-      if (!sendCacheReset(&client->fd))
+      if (!sendCacheReset(client))
       {
         ERRORF("Error: Failed to send a 'Cache Reset\n");
       }
     }
-
-    unlockReadLock(&cache.lock);
+    unlockMutex(&clientMutex);
   }
 
   return CMD_ID_RESET;
@@ -796,15 +1594,17 @@ bool sendErrorReport(int* fdPtr, uint16_t errNo, char* data)
   {
     OUTPUTF(true, "Sending multiple 'Error Report' (Error = %hhu)\n", errNo);
 
+    lockMutex(&clientMutex);
     for (cl = clients; cl; cl = cl->hh.next)
     {
-      if (!sendNum(&cl->fd, &pdu, length))
+      if (!sendToClient(cl, &pdu, length))
       {
         ERRORF("Error: Failed to send an 'Error Report'\n");
         succ = false;
         break;
       }
     }
+    unlockMutex(&clientMutex);
   }
 
   return succ;
@@ -866,6 +1666,109 @@ bool printErrorReport(uint8_t errNo, void* data, uint32_t dataLen)
 }
 
 // ClientConnectionAccepted
+/**
+ * Record the statistics of a synchronization of the client that ended with the
+ * End of Data sent just now.
+ *
+ * @param ccl The client.
+ * @param syncStart The time (ns) the synchronization started.
+ * @param noPDUs The number of prefix and key PDUs sent.
+ *
+ * @since 0.4.1.0
+ */
+void recordSync(CacheClient* ccl, uint64_t syncStart, uint32_t noPDUs)
+{
+  uint64_t now = getTimeNanos();
+
+  ccl->noSyncs++;
+  ccl->noPDUs         += noPDUs;
+  ccl->lastSyncPDUs    = noPDUs;
+  ccl->lastSyncMillis  = (now - syncStart) / 1000000.0;
+  if (ccl->notifyTime != 0)
+  {
+    ccl->lastNotifyMillis = (now - ccl->notifyTime) / 1000000.0;
+    ccl->notifyTime       = 0;
+  }
+}
+
+/**
+ * Process a PDU received from the client.
+ *
+ * @param ccl The client.
+ * @param hdr The common header of the PDU.
+ * @param buf The data following the common header or NULL.
+ * @param dataLength The length of the data following the common header.
+ * @param diffReq The time since the last request of the client.
+ *
+ * @since 0.4.1.0
+ */
+void processPDU(CacheClient* ccl, RPKICommonHeader* hdr, void* buf,
+                uint32_t dataLength, time_t diffReq)
+{
+  uint64_t syncStart;
+  uint32_t noPDUs;
+  uint32_t serial;
+  uint16_t clientSessionID;
+
+  switch (ccl->version)
+  {
+    case UNDEF_VERSION:
+      ccl->version = hdr->version;
+      break;
+    case 0:
+    case 1:
+      break;
+    default:
+      sendErrorPDU(&ccl->fd, hdr, "Unsupported Version");
+      return;
+  }
+  if (ccl->version != hdr->version)
+  {
+    // Send error.
+    sendErrorPDU(&ccl->fd, hdr, "Illegal switch of version number!");
+    return;
+  }
+
+  printf ("Received Data From Client [%x]...\n", ccl->fd);
+
+  // Action depending on the type
+  switch ((RPKIRouterPDUType)hdr->type)
+  {
+    case PDU_TYPE_SERIAL_QUERY:
+      OUTPUTF(true, "[+%lds] Received a 'Serial Query'\n", diffReq);
+      if (dataLength != 4)
+      {
+        ERRORF("Error: Invalid 'Serial Query'\n");
+        dumpHex(stderr, buf, dataLength);
+      }
+      else
+      {
+        serial          = ntohl(*((uint32_t*)buf));
+        clientSessionID = ntohs(hdr->mixed);
+        syncStart       = getTimeNanos();
+        noPDUs = sendPrefixes(ccl, serial, clientSessionID, false);
+        recordSync(ccl, syncStart, noPDUs);
+      }
+      break;
+
+    case PDU_TYPE_RESET_QUERY:
+      OUTPUTF(true, "[+%lds] Received a 'Reset Query'\n", diffReq);
+      syncStart = getTimeNanos();
+      noPDUs    = sendPrefixes(ccl, 0, sessionID, true);
+      recordSync(ccl, syncStart, noPDUs);
+      break;
+
+    case PDU_TYPE_ERROR_REPORT:
+      printErrorReport(ntohs(hdr->mixed), buf, dataLength);
+      break;
+
+    case PDU_TYPE_RESERVED:
+
+    default:
+      ERRORF("Error: Invalid PDU type: %hhu\n", hdr->type);
+  }
+}
+
 /**
  * Handle the data received from the client.
  *
@@ -881,7 +1784,9 @@ void handleClient(ServerSocket* svrSock, int sock, void* user)
   void*            buf;
   CacheClient*     ccl = NULL;
 
+  lockMutex(&clientMutex);
   HASH_FIND_INT(clients, &sock, ccl);
+  unlockMutex(&clientMutex);
   if (ccl == NULL)
   {
     ERRORF("Error: Cannot find client sessoin!\n");
@@ -895,25 +1800,6 @@ void handleClient(ServerSocket* svrSock, int sock, void* user)
   // read the beginning of the header to see how many bytes are actually needed
   while (recvNum(&sock, &hdr, sizeof(RPKICommonHeader)))
   {
-    switch (ccl->version)
-    {
-      case UNDEF_VERSION:
-        ccl->version = hdr.version;
-        break;
-      case 0:
-      case 1:
-        break;
-      default:
-        sendErrorPDU(&ccl->fd, &hdr, "Unsupported Version");
-        continue;
-    }
-    if (ccl->version != hdr.version)
-    {
-      // Send error.
-      sendErrorPDU(&ccl->fd, &hdr, "Illegal switch of version number!");
-      continue;
-    }
-
     // determine the remaining data that needs to be received - if any
     remainingDataLentgh = ntohl(hdr.length) - sizeof(RPKICommonHeader);
 
@@ -932,6 +1818,7 @@ void handleClient(ServerSocket* svrSock, int sock, void* user)
       if (!recvNum(&sock, buf, remainingDataLentgh))
       {
         ERRORF("Error: Failed to receive the data\n");
+        free(buf);
         close(sock);
         break;
       }
@@ -944,302 +1831,941 @@ void handleClient(ServerSocket* svrSock, int sock, void* user)
     // Time since the last request
     diffReq = lastReq - time(NULL);
 
-    printf ("Received Data From Client [%x]...\n", sock);
+    processPDU(ccl, &hdr, buf, remainingDataLentgh, diffReq);
 
-    // Action depending on the type
-    switch ((RPKIRouterPDUType)hdr.type)
-    {
-      case PDU_TYPE_SERIAL_QUERY:
-        OUTPUTF(true, "[+%lds] Received a 'Serial Query'\n", diffReq);
-        uint32_t serial;
-        uint16_t sessionID;
-        if (remainingDataLentgh != 4)
-        {
-          ERRORF("Error: Invalid 'Serial Query'\n");
-          dumpHex(stderr, buf, remainingDataLentgh);
-        }
-        else
-        {
-          serial = ntohl(*((uint32_t*)buf));
-          sessionID  = ntohs(hdr.mixed);
-          sendPrefixes(&sock, serial, sessionID, false);
-        }
-        break;
+    free(buf);
 
-      case PDU_TYPE_RESET_QUERY:
-        OUTPUTF(true, "[+%lds] Received a 'Reset Query'\n", diffReq);
-        sendPrefixes(&sock, 0, sessionID, true);
-        break;
+    // Time after processing the request
+    lastReq = time(NULL);
+  }
+}
 
-      case PDU_TYPE_ERROR_REPORT:
-        printErrorReport(ntohs(hdr.mixed), buf, remainingDataLentgh);
-        break;
+/**
+ * Handle a PDU received from the client in the event mode. The PDUs are
+ * framed by the reactor of the server socket using the length field of the
+ * common header.
+ *
+ * @param svrSock The server socket.
+ * @param client The connection of the client.
+ * @param packet The complete PDU.
+ * @param length The length of the PDU.
+ * @param user NOT USED
+ *
+ * @since 0.4.1.0
+ */
+void handleClientPDU(ServerSocket* svrSock, ServerClient* client,
+                     void* packet, PacketLength length, void* user)
+{
+  RPKICommonHeader* hdr = (RPKICommonHeader*)packet;
+  int               fd  = ((ClientThread*)client)->clientFD;
+  CacheClient*      ccl = NULL;
+
+  // The client is removed by the reactor that calls this function.
+  lockMutex(&clientMutex);
+  HASH_FIND_INT(clients, &fd, ccl);
+  unlockMutex(&clientMutex);
+  if (ccl == NULL)
+  {
+    ERRORF("Error: Cannot find client session!\n");
+    return;
+  }
 
-      case PDU_TYPE_RESERVED:
+  processPDU(ccl, hdr, length > sizeof(RPKICommonHeader) ? hdr + 1 : NULL,
+             length - sizeof(RPKICommonHeader), 0);
+}
 
+/**
+ * Handles client session status
+ *
+ * @param svrSock The server socket that receives the data
+ * @param client The connection in the event mode, otherwise NULL
+ * @param fd The file descriptor
+ * @param connected Indicates if the connection will be established of shut down
+ * @param user NOT USED
+ *
+ * @return false is an error occured.
+ */
+bool handleStatus(ServerSocket* svrSock, ServerClient* client, int fd,
+                  bool connected, void* user)
+{
+  CacheClient* ccl = NULL;
+
+  if (connected)
+  {
+    ccl = (CacheClient*)malloc(sizeof(CacheClient));
+    if (ccl == NULL)
+    {
+      ERRORF("Error: Out of memory - rejecting client\n");
+      return false;
+    }
+    memset(ccl, 0, sizeof(CacheClient));
+    ccl->fd        = fd;
+    ccl->version   = UNDEF_VERSION;
+    ccl->svrClient = client;
+    lockMutex(&clientMutex);
+    HASH_ADD_INT(clients, fd, ccl);
+    unlockMutex(&clientMutex);
+  }
+  else
+  {
+    lockMutex(&clientMutex);
+    HASH_FIND_INT(clients, &fd, ccl);
+    if (ccl != NULL)
+    {
+      HASH_DEL(clients, ccl);
+    }
+    unlockMutex(&clientMutex);
+    if (ccl != NULL)
+    {
+      memset(ccl, 0, sizeof(CacheClient));
+      free(ccl);
+      ccl = NULL;
+    }
+    else
+    {
+      ERRORF("Error: Unknown client\n");
+    }
+    if (client != NULL)
+    {
+      // The event mode leaves the release of the connection to the user.
+      deleteFromSList(&svrSock->cthreads, client);
+    }
+  }
+  return true;
+}
+
+
+void* handleServerRunLoop(void* data)
+{
+  RPKI_SRV_Configuration* cfg = (RPKI_SRV_Configuration*)data;
+
+  LOG (LEVEL_DEBUG, "([0x%08X]) > RPKI Server Thread started!", pthread_self());
+
+  if (cfg->eventThreads > 0)
+  {
+    runServerLoop (&svrSocket, MODE_EVENT_LOOP,
+                   handleClientPDU, handleStatus, NULL);
+  }
+  else
+  {
+    runServerLoop (&svrSocket, MODE_CUSTOM_CALLBACK,
+                   handleClient, handleStatus, NULL);
+  }
+
+  LOG (LEVEL_DEBUG, "([0x%08X]) < RPKI Server Thread stopped!", pthread_self());
+
+  pthread_exit(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Read the data from the file.
+////////////////////////////////////////////////////////////////////////////////
+
+/*----------------------
+ * Prefix file functions
+ */
+
+int stripLineBreak(char* str)
+{
+  int pos = strlen(str) - 1;
+
+  while (pos >= 0)
+  {
+    if ((str[pos] != 0xA) && (str[pos] != 0xD))
+    {
+      break;
+    }
+    str[pos--] = '\0';
+  }
+  return pos + 1;
+}
+
+/**
+ * Read prefix data from a given file or from command line. An error while
+ * reading from command line will result in skipping the line and posting a
+ * WARNING. An error from command line results in abort of the operation.
+ *
+ * @param arg The filename or the data provided via command line.
+ * @param serial The serial number of the prefix announcement(s).
+ * @param isFile determine if the argument given specifies a file or input data.
+ *
+ * @return true if the prefix(es) could be send.
+ */
+bool readPrefixData(const char* arg, uint32_t serial, bool isFile)
+{
+  #define LINE_BUF_SIZE 80
+  #define NUM_FIELDS    3  // prefix max_len as
+
+  FILE*          fh;
+  int            lineNo;
+  char           buf[LINE_BUF_SIZE];
+  char*          bptr;
+  int            idx;
+  char*          fields[NUM_FIELDS];
+  IPPrefix       prefix;
+  uint32_t       maxLen;
+  uint32_t       oas;
+  ValCacheEntry* cEntry;
+  bool           goOn=true;
+
+  #define SKIP_IF(COND, MSG, VAR) \
+    if (COND)                     \
+    {                             \
+      ERRORF("Warning: " MSG " (line %d): '%s'\n", lineNo, VAR); \
+      continue;                   \
+    }
+
+  if (isFile)
+  {
+    fh = fopen(arg, "rt");
+    if (fh == NULL)
+    {
+      ERRORF("Error: Failed to open '%s'\n", arg);
+      return false;
+    }
+  }
+  else
+  {
+    if (arg == NULL)
+    {
+      ERRORF("Error: Data missing: <prefix> <maxlen> <as>\n");
+      return false;
+    }
+  }
+
+  // Read line by line
+  for (; goOn; lineNo++)
+  {
+    if (isFile)
+    {
+      goOn = fgets(buf, LINE_BUF_SIZE, fh);
+      if (!goOn)
+      {
+        continue;
+      }
+    }
+    else
+    {
+      // Stop after the one line.
+      goOn = false;
+      // here filename is not the name of the file, it contains the one and only
+      // line of data. (Called by addPrefix);
+      strncpy(buf, arg, LINE_BUF_SIZE);
+    }
+
+    // Skip comments
+    if (buf[0] == '#')
+    {
+      continue;
+    }
+
+    // Make sure the line is not empty
+    if (stripLineBreak(buf) == 0)
+    {
+      continue;
+    }
+
+    // Put into fields for later processing
+    bptr = buf;
+    idx  = 0;
+    // FIX BZ164
+    bool fieldIsNull = false;
+    do
+    {
+      fields[idx] = strsep(&bptr, " \t");
+      fieldIsNull = fields[idx] == NULL;
+
+      if (fieldIsNull)
+      {
+        if (idx < NUM_FIELDS)
+        {
+          if (isFile)
+          {
+            ERRORF("ERROR: Line[%d] Parameters missing : '%s'\n", lineNo, buf);
+          }
+          else
+          {
+            ERRORF("ERROR: Parameters missing : '%s'\n"
+                   "try Help for more information\n", buf);
+          }
+          return false;
+        }
+      }
+      else if (fields[idx][0] == 0)
+      {
+        // To the else if block above:
+        // It can happen that the buffer contains "      a.b.c.d/d   x   y   "
+        // in this case the read field "fields[idx][0]" is zero for each list of
+        // blanks. In this case read the next element in the buffer and don't
+        // increase the idx, the field has to be refilled.
+        continue;
+      }
+
+      idx++;
+    } while (idx < NUM_FIELDS && !fieldIsNull);
+
+    // Parse fields
+    SKIP_IF(!strToIPPrefix(fields[0], &prefix),
+            "Invalid IP Prefix", fields[0]);
+
+    maxLen = strtoul(fields[1], NULL, 10);
+    SKIP_IF(!BETWEEN(maxLen, 0, GET_MAX_PREFIX_LEN(prefix.ip)),
+            "Invalid max. length", fields[1]);
+
+    oas = strtoul(fields[2], NULL, 10);
+    SKIP_IF(oas == 0,
+            "Invalid origin AS", fields[2]);
+
+    // Append
+    cEntry = (ValCacheEntry*)calloc(1, sizeof(ValCacheEntry));
+    if (cEntry == NULL)
+    {
+      fclose(fh);
+      return false;
+    }
+    cEntry->serial  = cEntry->prevSerial = serial++;
+    cEntry->expires = 0;
+
+    cEntry->flags           = PREFIX_FLAG_ANNOUNCEMENT;
+    cEntry->prefixLength    = prefix.length;
+    cEntry->prefixMaxLength = (uint8_t)maxLen;
+
+    if (prefix.ip.version == 4)
+    {
+      cEntry->isV6 = false;
+      memcpy(&cEntry->address.v4.in_addr, &prefix.ip.addr, 4);
+      cEntry->asNumber = htonl(oas);
+
+    }
+    else
+    {
+      cEntry->isV6 = true;
+      memcpy(&cEntry->address.v6.in_addr, &prefix.ip.addr, 16);
+      cEntry->asNumber = htonl(oas);
+    }
+
+    if (!addCacheEntry(cEntry))
+    {
+      free(cEntry);
+      if (isFile)
+      {
+        fclose(fh);
+      }
+      return false;
+    }
+  }
+
+  if (isFile)
+  {
+    fclose(fh);
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BULK PREFIX LOADER
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Parse the decimal number at the given position.
+ *
+ * @param pos The first character.
+ * @param end The end of the input.
+ * @param value OUT - The number.
+ *
+ * @return The position behind the number, NULL if there is no number or it
+ *         exceeds 32 bits.
+ *
+ * @since 0.4.1.0
+ */
+static const char* scanU32(const char* pos, const char* end, uint32_t* value)
+{
+  const char* start = pos;
+  uint64_t    val   = 0;
+
+  while ((pos < end) && (*pos >= '0') && (*pos <= '9'))
+  {
+    val = val * 10 + (*pos++ - '0');
+    if (val > 0xFFFFFFFFULL)
+    {
+      pos = start;
+      break;
+    }
+  }
+  *value = (uint32_t)val;
+
+  return pos == start ? NULL : pos;
+}
+
+/**
+ * Parse an AS number, with or without the prefix "AS".
+ *
+ * @param pos The first character.
+ * @param end The end of the AS number.
+ * @param as OUT - The AS number.
+ *
+ * @return true if the whole input is an AS number.
+ *
+ * @since 0.4.1.0
+ */
+static bool scanASN(const char* pos, const char* end, uint32_t* as)
+{
+  if (   (end - pos > 2) && ((pos[0] == 'A') || (pos[0] == 'a'))
+      && ((pos[1] == 'S') || (pos[1] == 's')))
+  {
+    pos += 2;
+  }
+
+  return scanU32(pos, end, as) == end;
+}
+
+/**
+ * Parse the prefix into the entry.
+ *
+ * @param pos The first character.
+ * @param end The end of the prefix.
+ * @param cEntry The entry, the address, length, and IP version are set.
+ *
+ * @return true if the whole input is a valid prefix.
+ *
+ * @since 0.4.1.0
+ */
+static bool scanPrefix(const char* pos, const char* end, ValCacheEntry* cEntry)
+{
+  char        buf[INET6_ADDRSTRLEN];
+  const char* slash = memchr(pos, '/', end - pos);
+  uint32_t    len;
+
+  if ((slash == NULL) || (slash - pos >= INET6_ADDRSTRLEN))
+  {
+    return false;
+  }
+  memcpy(buf, pos, slash - pos);
+  buf[slash - pos] = '\0';
+  cEntry->isV6 = memchr(buf, ':', slash - pos) != NULL;
+  if (inet_pton(cEntry->isV6 ? AF_INET6 : AF_INET, buf,
+                &cEntry->address) != 1)
+  {
+    return false;
+  }
+  if (   (scanU32(slash + 1, end, &len) != end) || (len == 0)
+      || (len > (cEntry->isV6 ? 128 : 32)))
+  {
+    return false;
+  }
+  cEntry->prefixLength = (uint8_t)len;
+
+  return true;
+}
+
+/**
+ * Parse the max length and check it against the prefix of the entry.
+ *
+ * @param pos The first character.
+ * @param end The end of the max length.
+ * @param cEntry The entry with the prefix set, the max length gets set.
+ *
+ * @return true if the whole input is a valid max length.
+ *
+ * @since 0.4.1.0
+ */
+static bool scanMaxLength(const char* pos, const char* end,
+                          ValCacheEntry* cEntry)
+{
+  uint32_t maxLen;
+
+  if (   (scanU32(pos, end, &maxLen) != end)
+      || (maxLen > (cEntry->isV6 ? 128 : 32)))
+  {
+    return false;
+  }
+  cEntry->prefixMaxLength = (uint8_t)maxLen;
+
+  return true;
+}
+
+/**
+ * Parse one line of a prefix file. The line is either in the format of the
+ * prefix files, "<prefix> <maxlen> <as>", or in the CSV format of the
+ * validators, "<as>,<prefix>,<maxlen>[,<trust anchor>]".
+ *
+ * @param pos The first character of the line.
+ * @param end The end of the line.
+ * @param cEntry The cleared entry to be filled.
+ *
+ * @return true if the line contains a valid entry.
+ *
+ * @since 0.4.1.0
+ */
+static bool scanPrefixLine(const char* pos, const char* end,
+                           ValCacheEntry* cEntry)
+{
+  const char* fStart[LOADER_LINE_FIELDS];
+  const char* fEnd[LOADER_LINE_FIELDS];
+  int         noFields = 0;
+  int         pIdx;
+  int         asIdx;
+  uint32_t    as;
+
+  while (noFields < LOADER_LINE_FIELDS)
+  {
+    while ((pos < end) && IS_LOADER_SEP(*pos))
+    {
+      pos++;
+    }
+    if (pos == end)
+    {
+      break;
+    }
+    fStart[noFields] = pos;
+    while ((pos < end) && !IS_LOADER_SEP(*pos))
+    {
+      pos++;
+    }
+    fEnd[noFields++] = pos;
+  }
+  if (noFields < 3)
+  {
+    return false;
+  }
+
+  // The CSV format starts with the AS number.
+  pIdx  = memchr(fStart[0], '/', fEnd[0] - fStart[0]) == NULL ? 1 : 0;
+  asIdx = pIdx == 0 ? 2 : 0;
+  if (   !scanPrefix(fStart[pIdx], fEnd[pIdx], cEntry)
+      || !scanMaxLength(fStart[pIdx + 1], fEnd[pIdx + 1], cEntry)
+      || !scanASN(fStart[asIdx], fEnd[asIdx], &as)
+      || ((pIdx == 0) && (as == 0)))
+  {
+    return false;
+  }
+  cEntry->flags    = PREFIX_FLAG_ANNOUNCEMENT;
+  cEntry->asNumber = htonl(as);
+
+  return true;
+}
+
+/**
+ * Parse the lines of the chunk into its block.
+ *
+ * @param chunk The chunk.
+ *
+ * @since 0.4.1.0
+ */
+static void scanPrefixLines(PrefixChunk* chunk)
+{
+  const char*    pos = chunk->start;
+  const char*    eol;
+  ValCacheEntry* cEntry;
+
+  while (pos < chunk->end)
+  {
+    eol = memchr(pos, '\n', chunk->end - pos);
+    eol = eol == NULL ? chunk->end : eol;
+    while ((pos < eol) && IS_LOADER_SEP(*pos))
+    {
+      pos++;
+    }
+    if ((pos < eol) && (*pos != '#'))
+    {
+      cEntry = &chunk->block->entries[chunk->noEntries];
+      memset(cEntry, 0, sizeof(ValCacheEntry));
+      if (scanPrefixLine(pos, eol, cEntry))
+      {
+        chunk->noEntries++;
+      }
+      // The first line of a CSV file is the header.
+      else if (pos != chunk->fileStart)
+      {
+        if (chunk->noInvalid++ == 0)
+        {
+          chunk->firstInvalid = pos - chunk->fileStart;
+        }
+      }
+    }
+    pos = eol + 1;
+  }
+}
+
+/**
+ * Parse the ROA objects of a JSON export into the block of the chunk. Each
+ * flat object with the members "prefix", "maxLength", and "asn" is an entry,
+ * all other members and objects are skipped.
+ *
+ * @param chunk The chunk.
+ *
+ * @since 0.4.1.0
+ */
+static void scanPrefixJSON(PrefixChunk* chunk)
+{
+  #define KEY_IS(NAME) \
+    ((keyLen == sizeof(NAME) - 1) && (memcmp(key, NAME, keyLen) == 0))
+
+  const char*    pos = chunk->start;
+  const char*    end = chunk->end;
+  const char*    key;
+  const char*    vStart;
+  const char*    vEnd;
+  size_t         keyLen;
+  ValCacheEntry* cEntry = &chunk->block->entries[chunk->noEntries];
+  uint32_t       as;
+  int            noMembers = 0;
+  bool           valid     = true;
+
+  memset(cEntry, 0, sizeof(ValCacheEntry));
+  while (pos < end)
+  {
+    switch (*pos)
+    {
+      case '{':
+        memset(cEntry, 0, sizeof(ValCacheEntry));
+        noMembers = 0;
+        valid     = true;
+        pos++;
+        break;
+      case '}':
+        if (   (noMembers == 3) && valid
+            && (cEntry->prefixMaxLength <= (cEntry->isV6 ? 128 : 32)))
+        {
+          cEntry->flags = PREFIX_FLAG_ANNOUNCEMENT;
+          chunk->noEntries++;
+          cEntry = &chunk->block->entries[chunk->noEntries];
+        }
+        else if ((noMembers > 0) && (chunk->noInvalid++ == 0))
+        {
+          chunk->firstInvalid = pos - chunk->fileStart;
+        }
+        memset(cEntry, 0, sizeof(ValCacheEntry));
+        noMembers = 0;
+        valid     = true;
+        pos++;
+        break;
+      case '"':
+        key = pos + 1;
+        pos = memchr(key, '"', end - key);
+        if (pos == NULL)
+        {
+          pos = end;
+          break;
+        }
+        keyLen = pos++ - key;
+        while ((pos < end) && IS_JSON_SPACE(*pos))
+        {
+          pos++;
+        }
+        if ((pos == end) || (*pos != ':'))
+        {
+          // A string within an array
+          break;
+        }
+        pos++;
+        while ((pos < end) && IS_JSON_SPACE(*pos))
+        {
+          pos++;
+        }
+        if ((pos < end) && (*pos == '"'))
+        {
+          vStart = ++pos;
+          vEnd   = memchr(vStart, '"', end - vStart);
+          vEnd   = vEnd == NULL ? end : vEnd;
+          pos    = vEnd == end ? end : vEnd + 1;
+        }
+        else
+        {
+          // Numbers and literals, objects and arrays are left to the loop.
+          vStart = pos;
+          while ((pos < end) && !IS_JSON_DELIM(*pos))
+          {
+            pos++;
+          }
+          vEnd = pos;
+        }
+        if (KEY_IS("prefix"))
+        {
+          valid = scanPrefix(vStart, vEnd, cEntry) && valid;
+          noMembers++;
+        }
+        else if (KEY_IS("maxLength"))
+        {
+          // The prefix might follow, the max length is checked at the end.
+          valid = (scanU32(vStart, vEnd, &as) == vEnd) && (as <= 128)
+                  && valid;
+          cEntry->prefixMaxLength = (uint8_t)as;
+          noMembers++;
+        }
+        else if (KEY_IS("asn"))
+        {
+          valid = scanASN(vStart, vEnd, &as) && valid;
+          cEntry->asNumber = htonl(as);
+          noMembers++;
+        }
+        break;
       default:
-        ERRORF("Error: Invalid PDU type: %hhu\n", hdr.type);
+        pos++;
     }
-
-    free(buf);
-
-    // Time after processing the request
-    lastReq = time(NULL);
   }
+  #undef KEY_IS
 }
 
 /**
- * Handles client session status
+ * Parse the chunk of the prefix file into a block of entries. Called by the
+ * loader threads.
  *
- * @param svrSock The server socket that receives the data
- * @param client NOT USED
- * @param fd The file descriptor
- * @param connected Indicates if the connection will be established of shut down
- * @param user NOT USED
+ * @param data The chunk.
  *
- * @return false is an error occured.
+ * @return NULL
+ *
+ * @since 0.4.1.0
  */
-bool handleStatus(ServerSocket* svrSock, ServerClient* client, int fd,
-                  bool connected, void* user)
+static void* parsePrefixChunk(void* data)
 {
-  CacheClient* ccl = NULL;
+  PrefixChunk* chunk    = (PrefixChunk*)data;
+  char         delim    = chunk->isJSON ? '}' : '\n';
+  uint32_t     capacity = 1;
+  const char*  pos;
+
+  // Each entry ends with a delimiter except the last one.
+  for (pos = chunk->start;
+       (pos = memchr(pos, delim, chunk->end - pos)) != NULL; pos++)
+  {
+    capacity++;
+  }
+  chunk->block = malloc(sizeof(ValCacheBlock)
+                        + capacity * sizeof(ValCacheEntry));
+  if (chunk->block == NULL)
+  {
+    chunk->failed = true;
+    return NULL;
+  }
 
-  if (connected)
+  if (chunk->isJSON)
   {
-    ccl = (CacheClient*)malloc(sizeof(CacheClient));
-    if (ccl == NULL)
-    {
-      ERRORF("Error: Out of memory - rejecting client\n");
-      return false;
-    }
-    memset(ccl, 0, sizeof(CacheClient));
-    ccl->fd      = fd;
-    ccl->version = UNDEF_VERSION;
-    HASH_ADD_INT(clients, fd, ccl);
+    scanPrefixJSON(chunk);
   }
   else
   {
-    HASH_FIND_INT(clients, &fd, ccl);
-    if (ccl != NULL)
-    {
-      HASH_DEL(clients, ccl);
-      memset(ccl, 0, sizeof(CacheClient));
-      ccl = NULL;
-    }
-    else
-    {
-      ERRORF("Error: Unknown client\n");
-    }
+    scanPrefixLines(chunk);
   }
-  return true;
-}
-
-
-void* handleServerRunLoop(void* _unused)
-{
-  LOG (LEVEL_DEBUG, "([0x%08X]) > RPKI Server Thread started!", pthread_self());
-
-  runServerLoop (&svrSocket, MODE_CUSTOM_CALLBACK,
-                 handleClient, handleStatus, NULL);
-
-  LOG (LEVEL_DEBUG, "([0x%08X]) < RPKI Server Thread stopped!", pthread_self());
 
-  pthread_exit(0);
+  return NULL;
 }
 
-////////////////////////////////////////////////////////////////////////////////
-// Read the data from the file.
-////////////////////////////////////////////////////////////////////////////////
-
-/*----------------------
- * Prefix file functions
+/**
+ * Free the blocks not taken over by the cache.
+ *
+ * @param load The parsed chunks.
+ *
+ * @since 0.4.1.0
  */
-
-int stripLineBreak(char* str)
+static void releasePrefixLoad(PrefixLoad* load)
 {
-  int pos = strlen(str) - 1;
+  int idx;
 
-  while (pos >= 0)
+  for (idx = 0; idx < load->noChunks; idx++)
   {
-    if ((str[pos] != 0xA) && (str[pos] != 0xD))
-    {
-      break;
-    }
-    str[pos--] = '\0';
+    free(load->chunks[idx].block);
+    load->chunks[idx].block = NULL;
   }
-  return pos + 1;
 }
 
 /**
- * Read prefix data from a given file or from command line. An error while
- * reading from command line will result in skipping the line and posting a
- * WARNING. An error from command line results in abort of the operation.
+ * Map the prefix file into memory and parse it, large files are split into
+ * chunks parsed by multiple threads. The file is either a prefix file, a CSV
+ * export, or a JSON export of a validator. Each chunk is parsed into a single
+ * block of entries. Does not access the cache.
  *
- * @param arg The filename or the data provided via command line.
- * @param dest
- * @param serial The serial number of the prefix announcement(s).
- * @param isFile determine if the argument given specifies a file or input data.
+ * @param fileName The name of the file.
+ * @param load OUT - The parsed chunks.
  *
- * @return true if the prefix(es) could be send.
+ * @return false if the file could not be read or not enough memory was
+ *         available.
+ *
+ * @since 0.4.1.0
  */
-bool readPrefixData(const char* arg, SList* dest, uint32_t serial, bool isFile)
+static bool parsePrefixFile(const char* fileName, PrefixLoad* load)
 {
-  #define LINE_BUF_SIZE 80
-  #define NUM_FIELDS    3  // prefix max_len as
+  struct stat  st;
+  const char*  data;
+  const char*  pos;
+  const char*  end;
+  PrefixChunk* chunk;
+  long         noCPUs;
+  int          cpus;
+  int          noChunks;
+  int          fd;
+  int          idx;
+  bool         isJSON;
+  bool         ok = true;
+
+  memset(load, 0, sizeof(PrefixLoad));
+  fd = open(fileName, O_RDONLY);
+  if (fd == -1)
+  {
+    ERRORF("Error: Failed to open '%s'\n", fileName);
+    return false;
+  }
+  if (fstat(fd, &st) == -1)
+  {
+    ERRORF("Error: Failed to read '%s'\n", fileName);
+    close(fd);
+    return false;
+  }
+  if (st.st_size == 0)
+  {
+    close(fd);
+    return true;
+  }
+  data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    ERRORF("Error: Failed to map '%s'\n", fileName);
+    return false;
+  }
+  madvise((void*)data, st.st_size, MADV_SEQUENTIAL);
+  end = data + st.st_size;
 
-  FILE*          fh;
-  int            lineNo;
-  char           buf[LINE_BUF_SIZE];
-  char*          bptr;
-  int            idx;
-  char*          fields[NUM_FIELDS];
-  IPPrefix       prefix;
-  uint32_t       maxLen;
-  uint32_t       oas;
-  ValCacheEntry* cEntry;
-  bool           goOn=true;
+  pos = data;
+  while ((pos < end) && IS_JSON_SPACE(*pos))
+  {
+    pos++;
+  }
+  isJSON = (pos < end) && ((*pos == '{') || (*pos == '['));
 
-  #define SKIP_IF(COND, MSG, VAR) \
-    if (COND)                     \
-    {                             \
-      ERRORF("Warning: " MSG " (line %d): '%s'\n", lineNo, VAR); \
-      continue;                   \
-    }
+  noCPUs   = sysconf(_SC_NPROCESSORS_ONLN);
+  cpus     = noCPUs < 1 ? 1 : (int)noCPUs;
+  noChunks = MIN(MIN(LOADER_MAX_THREADS, cpus),
+                 (int)(st.st_size / LOADER_MIN_CHUNK) + 1);
 
-  if (isFile)
+  // Each chunk ends behind a delimiter, the last one at the end of the file.
+  pos = data;
+  for (idx = 0; (idx < noChunks) && (pos < end); idx++)
   {
-    fh = fopen(arg, "rt");
-    if (fh == NULL)
+    chunk = &load->chunks[load->noChunks++];
+    chunk->fileStart = data;
+    chunk->isJSON    = isJSON;
+    chunk->start     = pos;
+    chunk->end       = idx == noChunks - 1
+                       ? end : data + (st.st_size / noChunks) * (idx + 1);
+    if (chunk->end < pos)
     {
-      ERRORF("Error: Failed to open '%s'\n", arg);
-      return false;
+      chunk->end = pos;
     }
+    chunk->end = memchr(chunk->end, isJSON ? '}' : '\n', end - chunk->end);
+    chunk->end = chunk->end == NULL ? end : chunk->end + 1;
+    pos        = chunk->end;
   }
-  else
+
+  for (idx = 1; idx < load->noChunks; idx++)
   {
-    if (arg == NULL)
-    {
-      ERRORF("Error: Data missing: <prefix> <maxlen> <as>\n");
-      return false;
-    }
+    chunk          = &load->chunks[idx];
+    chunk->started = pthread_create(&chunk->thread, NULL, parsePrefixChunk,
+                                    chunk) == 0;
   }
-
-  // Read line by line
-  for (; goOn; lineNo++)
+  parsePrefixChunk(&load->chunks[0]);
+  for (idx = 0; idx < load->noChunks; idx++)
   {
-    if (isFile)
-    {
-      goOn = fgets(buf, LINE_BUF_SIZE, fh);
-      if (!goOn)
-      {
-        continue;
-      }
-    }
-    else
-    {
-      // Stop after the one line.
-      goOn = false;
-      // here filename is not the name of the file, it contains the one and only
-      // line of data. (Called by addPrefix);
-      strncpy(buf, arg, LINE_BUF_SIZE);
-    }
-
-    // Skip comments
-    if (buf[0] == '#')
+    chunk = &load->chunks[idx];
+    if (chunk->started)
     {
-      continue;
+      pthread_join(chunk->thread, NULL);
     }
-
-    // Make sure the line is not empty
-    if (stripLineBreak(buf) == 0)
+    else if (idx > 0)
     {
-      continue;
+      parsePrefixChunk(chunk);
     }
-
-    // Put into fields for later processing
-    bptr = buf;
-    idx  = 0;
-    // FIX BZ164
-    bool fieldIsNull = false;
-    do
+    ok = ok && !chunk->failed;
+    if (chunk->noInvalid > 0)
     {
-      fields[idx] = strsep(&bptr, " \t");
-      fieldIsNull = fields[idx] == NULL;
-
-      if (fieldIsNull)
-      {
-        if (idx < NUM_FIELDS)
-        {
-          if (isFile)
-          {
-            ERRORF("ERROR: Line[%d] Parameters missing : '%s'\n", lineNo, buf);
-          }
-          else
-          {
-            ERRORF("ERROR: Parameters missing : '%s'\n"
-                   "try Help for more information\n", buf);
-          }
-          return false;
-        }
-      }
-      else if (fields[idx][0] == 0)
+      if (load->noInvalid == 0)
       {
-        // To the else if block above:
-        // It can happen that the buffer contains "      a.b.c.d/d   x   y   "
-        // in this case the read field "fields[idx][0]" is zero for each list of
-        // blanks. In this case read the next element in the buffer and don't
-        // increase the idx, the field has to be refilled.
-        continue;
+        load->firstInvalid = chunk->firstInvalid;
       }
+      load->noInvalid += chunk->noInvalid;
+    }
+  }
+  munmap((void*)data, st.st_size);
 
-      idx++;
-    } while (idx < NUM_FIELDS && !fieldIsNull);
+  if (!ok)
+  {
+    ERRORF("Error: Not enough memory to load '%s'\n", fileName);
+    releasePrefixLoad(load);
+  }
+  else if (load->noInvalid > 0)
+  {
+    ERRORF("Warning: Skipped %u invalid entr%s of '%s', the first at byte "
+           "%lu\n", load->noInvalid, load->noInvalid == 1 ? "y" : "ies",
+           fileName, (unsigned long)load->firstInvalid);
+  }
 
-    // Parse fields
-    SKIP_IF(!strToIPPrefix(fields[0], &prefix),
-            "Invalid IP Prefix", fields[0]);
+  return ok;
+}
 
-    maxLen = strtoul(fields[1], NULL, 10);
-    SKIP_IF(!BETWEEN(maxLen, 0, GET_MAX_PREFIX_LEN(prefix.ip)),
-            "Invalid max. length", fields[1]);
+/**
+ * Add the parsed entries to the cache, each entry gets its own serial. The
+ * cache takes over the blocks. The caller MUST hold the write lock of the
+ * cache.
+ *
+ * @param load The parsed chunks.
+ * @param serial The serial number of the first entry.
+ *
+ * @return false if not enough memory was available, no entry is added.
+ *
+ * @since 0.4.1.0
+ */
+static bool addPrefixLoad(PrefixLoad* load, uint32_t serial)
+{
+  PrefixChunk*   chunk;
+  ValCacheBlock* block;
+  uint32_t       total = 0;
+  uint32_t       capacity;
+  int            idx;
+  uint32_t       eIdx;
 
-    oas = strtoul(fields[2], NULL, 10);
-    SKIP_IF(oas == 0,
-            "Invalid origin AS", fields[2]);
+  for (idx = 0; idx < load->noChunks; idx++)
+  {
+    total += load->chunks[idx].noEntries;
+  }
+  // Both log arrays always have the same capacity.
+  capacity = cache.logCapacity;
+  if (   !reserveArray((void**)&cache.log, &capacity,
+                       cache.logSize + total, sizeof(ValCacheEntry*))
+      || !reserveArray((void**)&cache.logSerials, &cache.logCapacity,
+                       cache.logSize + total, sizeof(uint32_t))
+      || !reserveArray((void**)&cache.current, &cache.currentCapacity,
+                       cache.noCurrent + total, sizeof(ValCacheEntry*)))
+  {
+    return false;
+  }
 
-    // Append
-    cEntry = (ValCacheEntry*)appendToSList(dest, sizeof(ValCacheEntry));
-    if (cEntry == NULL)
+  for (idx = 0; idx < load->noChunks; idx++)
+  {
+    chunk = &load->chunks[idx];
+    if (chunk->block == NULL)
     {
-      fclose(fh);
-      return false;
+      continue;
     }
-    cEntry->serial  = cEntry->prevSerial = serial++;
-    cEntry->expires = 0;
-
-    cEntry->flags           = PREFIX_FLAG_ANNOUNCEMENT;
-    cEntry->prefixLength    = prefix.length;
-    cEntry->prefixMaxLength = (uint8_t)maxLen;
-
-    if (prefix.ip.version == 4)
+    if (chunk->noEntries == 0)
     {
-      cEntry->isV6 = false;
-      memcpy(&cEntry->address.v4.in_addr, &prefix.ip.addr, 4);
-      cEntry->asNumber = htonl(oas);
-
+      free(chunk->block);
+      chunk->block = NULL;
+      continue;
     }
-    else
+    // Give back the estimated capacity not used.
+    block = realloc(chunk->block, sizeof(ValCacheBlock)
+                                  + chunk->noEntries * sizeof(ValCacheEntry));
+    block = block == NULL ? chunk->block : block;
+    block->noLive = chunk->noEntries;
+    chunk->block  = NULL;
+    for (eIdx = 0; eIdx < block->noLive; eIdx++)
     {
-      cEntry->isV6 = true;
-      memcpy(&cEntry->address.v6.in_addr, &prefix.ip.addr, 16);
-      cEntry->asNumber = htonl(oas);
+      block->entries[eIdx].serial     = serial;
+      block->entries[eIdx].prevSerial = serial++;
+      block->entries[eIdx].block      = block;
+      addCacheEntry(&block->entries[eIdx]);
     }
   }
 
-  if (isFile)
-  {
-    fclose(fh);
-  }
   return true;
 }
 
@@ -1337,6 +2863,8 @@ int showHelp(char* command)
            "  - sessionID <number> : Generates a new session id.\n"
            "  - append <filename>  : Appends a prefix file's content to the "
                                      "cache\n"
+           "                         (<prefix> <maxlen> <as> per line, or a\n"
+           "                         CSV or JSON export of a validator)\n"
            "  - add <prefix> <maxlen> <as> : \n"
            "                         Manually add a whitelist entry\n"
            "  - addNow <prefix> <maxlen> <as> :\n"
@@ -1352,6 +2880,12 @@ int showHelp(char* command)
            "                         all real fields comma separated.\n"
            "  - notify               Send a SERIAL NOTIFY to all clients.\n"
            "  - reset                Send a CACHE RESET to all clients.\n"
+           "  - generate <count> [v6-percent [seed]] :\n"
+           "                         Generates VRPs with realistic prefix\n"
+           "                         lengths and appends them to the cache.\n"
+           "  - churn <announce/s> <withdraw/s> [notify-seconds] | stop :\n"
+           "                         Announces and withdraws generated VRPs\n"
+           "                         each second and sends periodic notifies.\n"
 
            "\n"
            "Program Commands:\n"
@@ -1361,6 +2895,8 @@ int showHelp(char* command)
            "                        but only as the very last command!\n"
            "                        Otherwise it will be ignored!\n"
            "  - clients           : Lists all clients\n"
+           "  - stats             : Lists the generator counters and the\n"
+           "                        ingest rate and sync time of each client\n"
            "  - run <filename>    : Executes a file line-by-line\n"
            "  - sleep <seconds>   : Pauses execution\n"
            "\n\n");
@@ -1468,22 +3004,41 @@ int toggleVerboseMode()
  */
 bool appendPrefixData(char* arg, bool fromFile)
 {
-  size_t  numBefore, numAdded;
-  bool    succ;
+  size_t     numBefore, numAdded;
+  bool       succ;
+  PrefixLoad load;
+  uint64_t   start = getTimeNanos();
+
+  // A file is parsed before the cache gets locked.
+  if (fromFile && !parsePrefixFile(arg, &load))
+  {
+    return false;
+  }
 
   acquireReadLock(&cache.lock);
-  numBefore = sizeOfSList(&cache.entries);
+  numBefore = cache.noEntries;
 
   changeReadToWriteLock(&cache.lock);
-  succ = readPrefixData(arg, &cache.entries, cache.maxSerial + 1, fromFile);
+  succ = fromFile ? addPrefixLoad(&load, cache.maxSerial + 1)
+                  : readPrefixData(arg, cache.maxSerial + 1, false);
   changeWriteToReadLock(&cache.lock);
 
   // Check how many entries were added
-  numAdded = succ ? (sizeOfSList(&cache.entries) - numBefore) : 0;
+  numAdded = succ ? (cache.noEntries - numBefore) : 0;
   cache.maxSerial += numAdded;
+  cacheChanged();
   unlockReadLock(&cache.lock);
 
-  OUTPUTF(true, "Read %d entr%s\n", (int)numAdded,(fromFile ? "ies" : "y"));
+  if (fromFile)
+  {
+    releasePrefixLoad(&load);
+    OUTPUTF(true, "Read %d entries in %.3f sec.\n", (int)numAdded,
+            (getTimeNanos() - start) / 1000000000.0);
+  }
+  else
+  {
+    OUTPUTF(true, "Read %d entry\n", (int)numAdded);
+  }
 
   // Send notify at least one entry was added
   if (numAdded > 0)
@@ -1520,7 +3075,7 @@ unsigned char hex2bin_byte(char* in)
 #define OFFSET_PUBKEY 170
 #define OFFSET_SKI 130
 #define COMMAND_BUF_SIZE 256
-bool readRouterKeyData(const char* arg, SList* dest, uint32_t serial, bool isFile)
+bool readRouterKeyData(const char* arg, uint32_t serial, bool isFile)
 {
 
   char  buffKey[KEY_BIN_SIZE];
@@ -1581,7 +3136,7 @@ bool readRouterKeyData(const char* arg, SList* dest, uint32_t serial, bool isFil
   }
 
   // new instance to append
-  cEntry = (ValCacheEntry*)appendToSList(dest, sizeof(ValCacheEntry));
+  cEntry = (ValCacheEntry*)calloc(1, sizeof(ValCacheEntry));
   if (cEntry == NULL)
   {
     fclose(fpKey);
@@ -1603,6 +3158,16 @@ bool readRouterKeyData(const char* arg, SList* dest, uint32_t serial, bool isFil
   memcpy(cEntry->ski, buffSKI_bin, SKI_SIZE);
   memcpy(cEntry->pPubKeyData, buffKey, KEY_BIN_SIZE);
 
+  if (!addCacheEntry(cEntry))
+  {
+    freeCacheEntry(cEntry);
+    if (isFile)
+    {
+      fclose(fpKey);
+    }
+    return false;
+  }
+
   if (isFile)
     fclose(fpKey);
 
@@ -1617,17 +3182,18 @@ bool appendRouterKeyData(char* arg, bool fromFile)
   bool    succ;
 
   acquireReadLock(&cache.lock);
-  numBefore = sizeOfSList(&cache.entries);
+  numBefore = cache.noEntries;
 
   changeReadToWriteLock(&cache.lock);
 
   // TODO: function for certificate reading
-  succ = readRouterKeyData(arg, &cache.entries, cache.maxSerial+1, fromFile);
+  succ = readRouterKeyData(arg, cache.maxSerial+1, fromFile);
 
   changeWriteToReadLock(&cache.lock);
 
-  numAdded = succ ? (sizeOfSList(&cache.entries) - numBefore) : 0;
+  numAdded = succ ? (cache.noEntries - numBefore) : 0;
   cache.maxSerial += numAdded;
+  cacheChanged();
   unlockReadLock(&cache.lock);
 
 
@@ -1708,7 +3274,8 @@ int appendPrefixFile(char* fileName)
 int emptyCache()
 {
   acquireWriteLock(&cache.lock);
-  emptySList(&cache.entries);
+  clearCache();
+  cacheChanged();
   unlockWriteLock(&cache.lock);
 
   OUTPUTF(true, "Emptied the cache\n");
@@ -1726,7 +3293,7 @@ int printCache()
   #define IPBUF_SIZE   MAX_IP_V6_STR_LEN
 
   time_t      now;
-  SListNode*  lnode;
+  uint32_t    idx;
   unsigned    pos = 1;
   ValCacheEntry* cEntry;
   char        ipBuf[IPBUF_SIZE];
@@ -1735,15 +3302,19 @@ int printCache()
 
   acquireReadLock(&cache.lock);
   printf("Session ID: %u (0x%04X)\n", sessionID, sessionID);
-  if (sizeOfSList(&cache.entries) == 0)
+  if (cache.noEntries == 0)
   {
     printf("Cache is empty\n");
   }
   else
   {
-    FOREACH_SLIST(&cache.entries, lnode)
+    for (idx = 0; idx < cache.logSize; idx++)
     {
-      cEntry = (ValCacheEntry*)getDataOfSListNode(lnode);
+      cEntry = cache.log[idx];
+      if (cEntry == NULL)
+      {
+        continue;
+      }
 
       printf("%c %4u: ",
              ((cEntry->flags & PREFIX_FLAG_ANNOUNCEMENT) ? ' ' : '*'), pos++);
@@ -1788,7 +3359,6 @@ bool processEntryRemoval(char* arg)
   int            startIndex, endIndex, currPos;
   char*          aptr;
   ValCacheEntry* currEntry;
-  SListNode*     prevNode, *currIndex;
   time_t         tsExp;
   int            removed = 0;
 
@@ -1816,8 +3386,8 @@ bool processEntryRemoval(char* arg)
 
   // Within bounds
   acquireReadLock(&cache.lock);
-  if (   !BETWEEN(startIndex, 1, sizeOfSList(&cache.entries))
-      || !BETWEEN(endIndex, startIndex, sizeOfSList(&cache.entries)))
+  if (   !BETWEEN(startIndex, 1, cache.noEntries)
+      || !BETWEEN(endIndex, startIndex, cache.noEntries))
   {
     unlockReadLock(&cache.lock);
     ERRORF("Error: Invalid index(es): '%s'\n", arg);
@@ -1827,37 +3397,27 @@ bool processEntryRemoval(char* arg)
   // When removed entries expire
   tsExp = time(NULL) + CACHE_EXPIRATION_INTERVAL;
 
-  // Go over the list
+  // Go over the log, without superseded slots the index is the slot. The
+  // withdrawals are appended behind the given range.
   changeReadToWriteLock(&cache.lock);
-
-  prevNode  = (startIndex == 1)
-              ? NULL
-              : getNodeFromSList(&cache.entries, startIndex - 2);
+  compactLog();
 
   for (currPos = startIndex; currPos <= endIndex; currPos++)
   {
-    currIndex = (prevNode == NULL)
-                ? getNodeFromSList(&cache.entries, startIndex - 1)
-                : getNextNodeOfSListNode(prevNode);
-
-    currEntry = (ValCacheEntry*)getDataOfSListNode(currIndex);
+    currEntry = cache.log[currPos - 1];
 
     if (currEntry->serial == currEntry->prevSerial)
     {
+      if (!withdrawCacheEntry(currEntry, tsExp))
+      {
+        ERRORF("Error: Not enough memory to remove more entries\n");
+        break;
+      }
       removed++;
-      currEntry->flags &= ~PREFIX_FLAG_ANNOUNCEMENT;
-      currEntry->serial = ++cache.maxSerial;
-      currEntry->expires = tsExp;
-
-      // Move to end
-      moveSListNode(&cache.entries, &cache.entries, currIndex, prevNode);
-    }
-    else
-    {
-      prevNode = currIndex;
     }
   }
 
+  cacheChanged();
   unlockWriteLock(&cache.lock);
   OUTPUTF(true, "Removed %d entries\n", removed);
 
@@ -1936,17 +3496,8 @@ int issueErrorReport(char* arg)
     msg++;
   }
 
-  // Send
-  CacheClient* ccl = NULL;
-  if (HASH_COUNT(clients) > 0)
-  {
-    OUTPUTF(true, "Sending multiple 'Error Report' (Error = %hhu)\n", errNo);
-
-    for (ccl = clients; ccl; ccl = ccl->hh.next)
-    {
-      sendErrorReport(&ccl->fd ,errNo, msg);
-    }
-  }
+  // Send, the report goes out to all clients
+  sendErrorReport(NULL, errNo, msg);
 
   return CMD_ID_ERROR;
 }
@@ -1963,6 +3514,7 @@ int listClients()
   CacheClient*  cl;
   unsigned      idx = 1;
 
+  lockMutex(&clientMutex);
   if (HASH_COUNT(clients) == 0)
   {
     printf("No clients\n");
@@ -1974,6 +3526,7 @@ int listClients()
       printf("%u: %s\n", cl->fd, socketToStr(cl->fd, true, buf, BUF_SIZE));
     }
   }
+  unlockMutex(&clientMutex);
 
   return CMD_ID_CLIENTS;
 }
@@ -2065,6 +3618,435 @@ int processQuit()
   return CMD_ID_QUIT;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// VRP GENERATOR AND CHURN
+////////////////////////////////////////////////////////////////////////////////
+
+/** The prefix length distribution of generated IPv4 VRPs in per mil. */
+static const uint16_t GEN_V4_LEN_DIST[][2] = {
+  {24, 560}, {23, 80}, {22, 120}, {21, 50}, {20, 60}, {19, 40}, {18, 25},
+  {17, 15}, {16, 40}, {15, 4}, {14, 3}, {13, 2}, {12, 1}
+};
+
+/** The prefix length distribution of generated IPv6 VRPs in per mil. */
+static const uint16_t GEN_V6_LEN_DIST[][2] = {
+  {48, 420}, {47, 30}, {46, 30}, {44, 70}, {42, 30}, {40, 60}, {36, 50},
+  {33, 30}, {32, 210}, {29, 50}, {28, 20}
+};
+
+/**
+ * Return the next pseudo random number of the generator (xorshift64*).
+ *
+ * @return The random number.
+ *
+ * @since 0.4.1.0
+ */
+static uint64_t nextRandom()
+{
+  generator.random ^= generator.random >> 12;
+  generator.random ^= generator.random << 25;
+  generator.random ^= generator.random >> 27;
+  return generator.random * 2685821657736338717ULL;
+}
+
+/**
+ * Select a prefix length of the given distribution.
+ *
+ * @param dist The distribution as pairs of length and per mil.
+ * @param size The number of pairs.
+ *
+ * @return The prefix length.
+ *
+ * @since 0.4.1.0
+ */
+static uint8_t selectPrefixLength(const uint16_t dist[][2], int size)
+{
+  uint32_t pick = nextRandom() % 1000;
+  uint32_t sum  = 0;
+  int      idx;
+
+  for (idx = 0; idx < size; idx++)
+  {
+    sum += dist[idx][1];
+    if (pick < sum)
+    {
+      return dist[idx][0];
+    }
+  }
+  return dist[0][0];
+}
+
+/**
+ * Fill the cache entry with a generated VRP. Most VRPs have a max length equal
+ * to the prefix length, the others allow more specifics up to /24 (IPv4) or 
+ * /48 (IPv6). The origin ASes are taken from the range of the allocated 2 and
+ * 4 byte ASes.
+ *
+ * @param cEntry The entry to be filled.
+ * @param isV6 Generate an IPv6 VRP.
+ *
+ * @since 0.4.1.0
+ */
+static void generateVRP(ValCacheEntry* cEntry, bool isV6)
+{
+  uint64_t rnd    = nextRandom();
+  uint8_t  maxLen = isV6 ? 48 : 24;
+  uint8_t  bits;
+  int      idx;
+
+  memset(cEntry, 0, sizeof(ValCacheEntry));
+  cEntry->flags = PREFIX_FLAG_ANNOUNCEMENT;
+  cEntry->isV6  = isV6;
+  if (!isV6)
+  {
+    cEntry->prefixLength = selectPrefixLength(GEN_V4_LEN_DIST,
+                      sizeof(GEN_V4_LEN_DIST) / sizeof(GEN_V4_LEN_DIST[0]));
+    // Unicast space 1.0.0.0 - 223.255.255.255
+    cEntry->address.v4.u32 = htonl(  (uint32_t)((1 + (rnd % 223)) << 24
+                                   | ((rnd >> 8) & 0xFFFFFF))
+                                   & (0xFFFFFFFFU 
+                                      << (32 - cEntry->prefixLength)));
+  }
+  else
+  {
+    cEntry->prefixLength = selectPrefixLength(GEN_V6_LEN_DIST,
+                      sizeof(GEN_V6_LEN_DIST) / sizeof(GEN_V6_LEN_DIST[0]));
+    // Global unicast 2000::/3, all generated prefixes are shorter than /64
+    for (idx = 0; idx < 8; idx++)
+    {
+      cEntry->address.v6.u8[idx] = (uint8_t)(rnd >> (idx * 8));
+    }
+    cEntry->address.v6.u8[0] = 0x20 | (cEntry->address.v6.u8[0] & 0x1F);
+    bits = cEntry->prefixLength;
+    for (idx = 0; idx < 8; idx++, bits = bits > 8 ? bits - 8 : 0)
+    {
+      if (bits < 8)
+      {
+        cEntry->address.v6.u8[idx] &= (uint8_t)(0xFF << (8 - bits));
+      }
+    }
+  }
+
+  rnd = nextRandom();
+  cEntry->prefixMaxLength = cEntry->prefixLength;
+  if (((rnd % 100) < 15) && (cEntry->prefixLength < maxLen))
+  {
+    cEntry->prefixMaxLength += (uint8_t)(1 + ((rnd >> 8) 
+                                         % (maxLen - cEntry->prefixLength)));
+  }
+  // 2 byte ASes up to 64495, 4 byte ASes from 131072 on.
+  rnd >>= 16;
+  cEntry->asNumber = htonl((rnd % 100) < 60 ? 1 + ((rnd >> 8) % 64495)
+                                            : 131072 + ((rnd >> 8) % 300000));
+}
+
+/**
+ * Append the given number of generated VRPs to the cache. Each VRP gets its
+ * own serial number.
+ *
+ * @param count The number of VRPs.
+ * @param v6Percent The share of IPv6 VRPs in percent.
+ *
+ * @return The number of VRPs added.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t appendGeneratedVRPs(uint32_t count, uint32_t v6Percent)
+{
+  ValCacheEntry* cEntry;
+  uint32_t       idx;
+
+  acquireWriteLock(&cache.lock);
+  for (idx = 0; idx < count; idx++)
+  {
+    cEntry = (ValCacheEntry*)calloc(1, sizeof(ValCacheEntry));
+    if (cEntry != NULL)
+    {
+      generateVRP(cEntry, (nextRandom() % 100) < v6Percent);
+      cEntry->serial = cEntry->prevSerial = cache.maxSerial + 1;
+    }
+    if ((cEntry == NULL) || !addCacheEntry(cEntry))
+    {
+      free(cEntry);
+      ERRORF("Error: Not enough memory to generate more VRPs\n");
+      break;
+    }
+    cache.maxSerial++;
+  }
+  cacheChanged();
+  unlockWriteLock(&cache.lock);
+  generator.noGenerated += idx;
+
+  return idx;
+}
+
+/**
+ * Withdraw the given number of announced VRPs selected at random from the
+ * current state. The withdrawals are moved to the end of the log, the same way
+ * the command remove does. Router keys are not withdrawn.
+ *
+ * @param count The number of VRPs to withdraw.
+ *
+ * @return The number of VRPs withdrawn.
+ *
+ * @since 0.4.1.0
+ */
+static uint32_t withdrawRandomVRPs(uint32_t count)
+{
+  ValCacheEntry* cEntry;
+  uint32_t       withdrawn = 0;
+  uint32_t       attempts  = 0;
+  time_t         tsExp = time(NULL) + CACHE_EXPIRATION_INTERVAL;
+
+  acquireWriteLock(&cache.lock);
+  // Each attempt picks an announced entry, the attempts are limited in case
+  // only router keys are left.
+  while (   (withdrawn < count) && (cache.noCurrent > 0)
+         && (attempts++ < 2 * count + WITHDRAW_MAX_MISSES))
+  {
+    cEntry = cache.current[nextRandom() % cache.noCurrent];
+    if (cEntry->ski != NULL)
+    {
+      continue;
+    }
+    if (!withdrawCacheEntry(cEntry, tsExp))
+    {
+      ERRORF("Error: Not enough memory to withdraw more VRPs\n");
+      break;
+    }
+    withdrawn++;
+  }
+  cacheChanged();
+  unlockWriteLock(&cache.lock);
+  generator.noWithdrawn += withdrawn;
+
+  return withdrawn;
+}
+
+/**
+ * The churn thread. Once a second the configured number of VRPs is announced
+ * and withdrawn, a Serial Notify is sent every notify interval.
+ *
+ * @param _unused Not used.
+ *
+ * @return NULL
+ *
+ * @since 0.4.1.0
+ */
+void* churnLoop(void* _unused)
+{
+  uint32_t seconds = 0;
+
+  while (generator.churning)
+  {
+    sleep(1);
+    if (generator.announceRate > 0)
+    {
+      appendGeneratedVRPs(generator.announceRate, GENERATOR_V6_PERCENT);
+    }
+    if (generator.withdrawRate > 0)
+    {
+      withdrawRandomVRPs(generator.withdrawRate);
+    }
+    if (++seconds >= generator.notifyInterval)
+    {
+      seconds = 0;
+      generator.noNotifies++;
+      sendSerialNotifyToAllClients();
+    }
+  }
+
+  pthread_exit(0);
+}
+
+/**
+ * Generate VRPs and append them to the cache. Format: 
+ * "<count> [v6-percent [seed]]". Verbose output is turned off, printing each
+ * PDU would limit the rate the clients are served with.
+ *
+ * @param arg The arguments.
+ *
+ * @return CMD_ID_GENERATE
+ *
+ * @since 0.4.1.0
+ */
+int generateVRPs(char* arg)
+{
+  uint32_t      count;
+  uint32_t      v6Percent = GENERATOR_V6_PERCENT;
+  unsigned long percent;
+  uint32_t      added;
+  uint64_t      start;
+  double        elapsed;
+  char*         next;
+
+  if (arg == NULL)
+  {
+    ERRORF("Error: Number of VRPs missing\n");
+    return CMD_ID_GENERATE;
+  }
+  count = strtoul(arg, &next, 10);
+  if (*next != '\0')
+  {
+    // MIN evaluates its arguments twice, parse the share only once.
+    percent   = strtoul(next, &next, 10);
+    v6Percent = (uint32_t)MIN(percent, 100);
+    if (*next != '\0')
+    {
+      generator.random = strtoull(next, NULL, 10);
+    }
+  }
+  if (generator.random == 0)
+  {
+    generator.random = 1;
+  }
+
+  if (verbose)
+  {
+    toggleVerboseMode();
+  }
+
+  start   = getTimeNanos();
+  added   = appendGeneratedVRPs(count, v6Percent);
+  elapsed = (getTimeNanos() - start) / 1000000.0;
+  printf("Generated %u VRPs (%u%% IPv6) in %.1f ms, max. serial = %u\n", 
+         added, v6Percent, elapsed, cache.maxSerial);
+
+  if (added > 0)
+  {
+    service.notify = true;
+  }
+
+  return CMD_ID_GENERATE;
+}
+
+/**
+ * Start, modify, or stop the churn. Format: 
+ * "<announce/s> <withdraw/s> [notify-interval]" or "stop". Without argument
+ * the current churn settings are displayed.
+ *
+ * @param arg The arguments.
+ *
+ * @return CMD_ID_CHURN
+ *
+ * @since 0.4.1.0
+ */
+int processChurn(char* arg)
+{
+  uint32_t announceRate;
+  uint32_t withdrawRate;
+  uint32_t interval = CHURN_NOTIFY_INTERVAL;
+  char*    next;
+
+  if (arg == NULL)
+  {
+    if (generator.churning)
+    {
+      printf("Churn: %u announcements/s, %u withdrawals/s, notify every %u "
+             "s\n", generator.announceRate, generator.withdrawRate, 
+             generator.notifyInterval);
+    }
+    else
+    {
+      printf("Churn is stopped\n");
+    }
+    return CMD_ID_CHURN;
+  }
+
+  if (strcmp(arg, "stop") == 0)
+  {
+    if (generator.churning)
+    {
+      generator.churning = false;
+      pthread_join(generator.thread, NULL);
+      printf("Churn stopped\n");
+    }
+    return CMD_ID_CHURN;
+  }
+
+  announceRate = strtoul(arg, &next, 10);
+  withdrawRate = strtoul(next, &next, 10);
+  if (*next != '\0')
+  {
+    interval = strtoul(next, NULL, 10);
+  }
+  if ((announceRate == 0) && (withdrawRate == 0))
+  {
+    ERRORF("Error: Invalid churn '%s'\n", arg);
+    return CMD_ID_CHURN;
+  }
+
+  generator.announceRate   = announceRate;
+  generator.withdrawRate   = withdrawRate;
+  generator.notifyInterval = MAX(interval, 1);
+  if (generator.random == 0)
+  {
+    generator.random = 1;
+  }
+  if (!generator.churning)
+  {
+    if (verbose)
+    {
+      toggleVerboseMode();
+    }
+    generator.churning = true;
+    if (pthread_create(&generator.thread, NULL, churnLoop, NULL) != 0)
+    {
+      generator.churning = false;
+      ERRORF("Error: Failed to start the churn\n");
+      return CMD_ID_CHURN;
+    }
+  }
+  printf("Churn: %u announcements/s, %u withdrawals/s, notify every %u s\n",
+         generator.announceRate, generator.withdrawRate, 
+         generator.notifyInterval);
+
+  return CMD_ID_CHURN;
+}
+
+/**
+ * Display the generator counters and the synchronization statistics of each
+ * client. The ingest rate is the rate the client accepted the PDUs of its 
+ * last synchronization, the sync time is the time between the Serial Notify 
+ * and the End of Data of the synchronization it triggered.
+ *
+ * @return CMD_ID_STATS
+ *
+ * @since 0.4.1.0
+ */
+int showStatistics()
+{
+  #define STAT_BUF_SIZE (MAX_IP_V6_STR_LEN + 6)
+  char          buf[STAT_BUF_SIZE];
+  CacheClient*  cl;
+
+  acquireReadLock(&cache.lock);
+  printf("Cache: %u entries, %u announced, max. serial = %u\n",
+         cache.noEntries, cache.noCurrent, cache.maxSerial);
+  unlockReadLock(&cache.lock);
+  printf("Generator: %llu generated, %llu withdrawn, %llu notifies\n",
+         (unsigned long long)generator.noGenerated, 
+         (unsigned long long)generator.noWithdrawn,
+         (unsigned long long)generator.noNotifies);
+
+  lockMutex(&clientMutex);
+  for (cl = clients; cl; cl = cl->hh.next)
+  {
+    printf("%u: %s\n", cl->fd, socketToStr(cl->fd, true, buf, STAT_BUF_SIZE));
+    printf("   syncs=%u, PDUs=%llu, last sync: %u PDUs in %.1f ms (%.0f "
+           "PDUs/s), notify to End of Data: %.1f ms\n",
+           cl->noSyncs, (unsigned long long)cl->noPDUs, cl->lastSyncPDUs,
+           cl->lastSyncMillis, 
+           cl->lastSyncMillis > 0 ? cl->lastSyncPDUs * 1000.0 
+                                    / cl->lastSyncMillis 
+                                  : 0.0,
+           cl->lastNotifyMillis);
+  }
+  unlockMutex(&clientMutex);
+
+  return CMD_ID_STATS;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // CONSOLE INPUT
 ////////////////////////////////////////////////////////////////////////////////
@@ -2111,8 +4093,11 @@ int handleLine(char* line)
   CMD_CASE("error",     issueErrorReport);
   CMD_CASE("notify",    sendSerialNotifyToAllClients);
   CMD_CASE("reset",     sendCacheResetToAllClients);
+  CMD_CASE("generate",  generateVRPs);
+  CMD_CASE("churn",     processChurn);
 
   CMD_CASE("clients",   listClients);
+  CMD_CASE("stats",     showStatistics);
   CMD_CASE("run",       executeScript);
   CMD_CASE("sleep",     pauseExecution);
 
@@ -2170,28 +4155,14 @@ void handleUserInput()
  */
 void deleteExpiredEntriesFromCache(time_t now)
 {
-  SListNode*  currNode, *nextNode;
-  ValCacheEntry* cEntry;
   uint32_t    removed = 0;
 
   acquireWriteLock(&cache.lock);
-  currNode = getRootNodeOfSList(&cache.entries);
-  while (currNode)
+  // Only the withdrawals expire, oldest first.
+  removed = deleteExpiredWithdrawals(now);
+  if (removed > 0)
   {
-    cEntry   = (ValCacheEntry*)getDataOfSListNode(currNode);
-    nextNode = getNextNodeOfSListNode(currNode);
-
-    // Entry expired
-    if ((cEntry->expires > 0) && (cEntry->expires <= now))
-    {
-      cache.minPSExpired = MIN(cache.minPSExpired, cEntry->prevSerial);
-      cache.maxSExpired  = MAX(cache.maxSExpired, cEntry->serial);
-
-      deleteFromSList(&cache.entries, cEntry);
-      removed++;
-    }
-
-    currNode = nextNode;
+    cacheChanged();
   }
   unlockWriteLock(&cache.lock);
 
@@ -2243,7 +4214,7 @@ void handleSigInt(int signal)
 
 bool setupCache()
 {
-  initSList(&cache.entries);
+  memset(&cache, 0, sizeof(cache));
   if (!createRWLock(&cache.lock))
   {
     ERRORF("Error: Failed to create the cache R/W lock");
@@ -2252,10 +4223,40 @@ bool setupCache()
   cache.maxSerial     = 0;
   cache.minPSExpired  = UINT32_MAX;
   cache.maxSExpired   = 0;
+  cache.version       = 0;
+
+  memset(&snapshots, 0, sizeof(snapshots));
+  if (!initMutex(&snapshots.mutex))
+  {
+    ERRORF("Error: Failed to create the snapshot mutex");
+    releaseRWLock(&cache.lock);
+    return false;
+  }
 
   return true;
 }
 
+/**
+ * Release all snapshots of the cache. No client must be served anymore.
+ *
+ * @since 0.4.1.0
+ */
+void releaseSnapshots()
+{
+  uint32_t idx;
+
+  lockMutex(&snapshots.mutex);
+  dropSnapshot(snapshots.full);
+  snapshots.full = NULL;
+  for (idx = 0; idx < SNAPSHOT_MAX_DELTAS; idx++)
+  {
+    dropSnapshot(snapshots.deltas[idx]);
+    snapshots.deltas[idx] = NULL;
+  }
+  unlockMutex(&snapshots.mutex);
+  releaseMutex(&snapshots.mutex);
+}
+
 bool setupService()
 {
   service.timer = setupTimer(serviceTimerExpired);
@@ -2283,6 +4284,10 @@ static void syntax(const char* prgName)
   printf ("  options:\n");
   printf ("    -f <script>  A script that has to be executed as soon as\n");
   printf ("                 the server is started.\n");
+  printf ("    -e <threads> Serve all clients from the given number of\n");
+  printf ("                 event loop threads (1..%u) instead of one\n",
+          MAX_EVENT_LOOP_THREADS);
+  printf ("                 thread per client.\n");
   printf ("  For backwards compatibility a script also can be added after a\n");
   printf ("  port is specified.! - For future usage, use -f <script> to \n");
   printf ("  specify a script!\n");
@@ -2342,6 +4347,22 @@ static bool parseParams(int argc, const char* argv[],
             eVal   = 1;
           }
           break;
+        case 'e':
+          idx++;
+          if (idx < argc)
+          {
+            cfg->eventThreads = strtol(argv[idx], NULL, 10);
+          }
+          if (   (cfg->eventThreads < 1)
+              || (cfg->eventThreads > MAX_EVENT_LOOP_THREADS))
+          {
+            printf ("ERROR: Number of event loop threads missing or "
+                    "invalid!\n");
+            doHelp = true;
+            retVal = false;
+            eVal   = 1;
+          }
+          break;
         default:
           printf ("ERROR: Invalid parameter '%s'\n", arg);
           doHelp = true;
@@ -2410,11 +4431,17 @@ int main(int argc, const char* argv[])
   }
 
   // Bind to the port
-  if (!createServerSocket(&svrSocket, config.port, true))
+  if (   !initMutex(&clientMutex)
+      || !createServerSocket(&svrSocket, config.port, true))
   {
     releaseRWLock(&cache.lock);
     return -3;
   }
+  if (config.eventThreads > 0)
+  {
+    setEventLoopThreads(&svrSocket, (uint8_t)config.eventThreads);
+    setEventLoopSendQueue(&svrSocket, EVENT_SEND_QUEUE_LIMIT);
+  }
 
   // Service (= maintenance)
   if (!setupService())
@@ -2427,7 +4454,7 @@ int main(int argc, const char* argv[])
   showVersion();
 
   // Start run loop and handle user input
-  if (pthread_create(&rlthread, NULL, handleServerRunLoop, NULL) == 0)
+  if (pthread_create(&rlthread, NULL, handleServerRunLoop, &config) == 0)
   {
     // Handle Ctrl-C
     struct sigaction new_sigaction, old_sigaction;
@@ -2472,6 +4499,13 @@ int main(int argc, const char* argv[])
     ERRORF("Error: Failed to start server run-loop\n");
   }
 
+  // Stop the churn
+  if (generator.churning)
+  {
+    generator.churning = false;
+    pthread_join(generator.thread, NULL);
+  }
+
   // Stop all timers
   deleteAllTimers();
 
@@ -2479,8 +4513,9 @@ int main(int argc, const char* argv[])
   stopServerLoop(&svrSocket);
 
   // Cleanup
+  releaseSnapshots();
   releaseRWLock(&cache.lock);
-  releaseSList(&cache.entries);
+  releaseCache();
 
   return ret;
 }
@@ -0,0 +1,1233 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * End-to-end benchmark of the SRx server. A table of updates, either generated
+ * or read from a file, is replayed through libSRxProxy by a number of
+ * concurrent proxies. Each verification request asks for a receipt, the time
+ * between sending the request and receiving its notification is the latency
+ * of the request. The report contains the latency percentiles, the sustained
+ * throughput and the memory used by the server process.
+ *
+ * The table file contains one update per line: "<prefix> <AS path>", the last
+ * AS of the path is the origin AS. Lines starting with '#' are ignored.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code Created
+ * -----------------------------------------------------------------------------
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "client/srx_api.h"
+#include "shared/srx_defs.h"
+#include "util/log.h"
+#include "util/prefix.h"
+#include "util/str.h"
+
+#define BENCH_NAME            "SRx Benchmark"
+#define BENCH_VERSION         "0.4.1.0"
+
+#define DEFAULT_SERVER        "localhost"
+#define DEFAULT_PORT          17900
+#define DEFAULT_PROXY_ID      "10.0.0.1"
+#define DEFAULT_PROXY_AS      50
+#define DEFAULT_PEERAS        51
+#define DEFAULT_PROXIES       1
+#define DEFAULT_NO_V4         900000
+#define DEFAULT_NO_V6         200000
+#define DEFAULT_BATCH         1000
+#define DEFAULT_WINDOW        20000
+#define DEFAULT_TIMEOUT       120
+#define DEFAULT_SEED          1
+
+/** The number of distinct origin ASes of the synthetic table. */
+#define BENCH_NO_ORIGINS      75000
+/** The number of transit ASes the synthetic AS paths are made of. */
+#define BENCH_NO_TRANSIT      500
+/** The longest AS path of the synthetic table. */
+#define BENCH_MAX_HOPS        12
+/** Maximum length of a line in the table file. */
+#define BENCH_MAX_LINE        1024
+/** Used to convert seconds into nano seconds. */
+#define NSEC_PER_SEC          1000000000ULL
+
+/**
+ * One update of the table. The AS path is stored in the path pool of the
+ * table in network format.
+ */
+typedef struct {
+  /** The prefix of the update. */
+  IPPrefix prefix;
+  /** The origin AS */
+  uint32_t originAS;
+  /** The offset of the AS path in the path pool. */
+  uint32_t pathOffset;
+  /** The number of hops of the AS path. */
+  uint16_t noHops;
+} BenchUpdate;
+
+/**
+ * The table replayed by each proxy.
+ */
+typedef struct {
+  /** The updates. */
+  BenchUpdate* updates;
+  /** The number of updates. */
+  uint32_t     size;
+  /** The number of updates that fit into the array. */
+  uint32_t     capacity;
+  /** The AS paths of all updates in network format. */
+  uint32_t*    pathPool;
+  /** The number of ASes stored in the path pool. */
+  uint32_t     poolSize;
+  /** The number of ASes that fit into the path pool. */
+  uint32_t     poolCapacity;
+  /** The number of IPv4 updates. */
+  uint32_t     noV4;
+  /** The number of IPv6 updates. */
+  uint32_t     noV6;
+} BenchTable;
+
+/**
+ * The configuration of the benchmark.
+ */
+typedef struct {
+  /** The SRx server host. */
+  char*    host;
+  /** The SRx server port. */
+  uint32_t port;
+  /** The number of concurrent proxies. */
+  uint32_t noProxies;
+  /** The number of synthetic IPv4 updates. */
+  uint32_t noV4;
+  /** The number of synthetic IPv6 updates. */
+  uint32_t noV6;
+  /** The table file or NULL for a synthetic table. */
+  char*    tableFile;
+  /** The number of requests send in one batch. */
+  uint32_t batchSize;
+  /** The maximum number of requests without receipt per proxy. */
+  uint32_t window;
+  /** Seconds to wait for outstanding receipts. */
+  uint32_t timeout;
+  /** The seed of the synthetic table. */
+  uint32_t seed;
+  /** Split the table between the proxies instead of replaying it by each. */
+  bool     split;
+  /** Request path validation in addition to origin validation. */
+  bool     pathVal;
+  /** The pid of the SRx server to report its memory, 0 if unknown. */
+  pid_t    serverPID;
+} BenchConfiguration;
+
+/**
+ * One proxy of the benchmark. The counters are protected by the mutex, the
+ * replay thread waits on the condition once its window of outstanding
+ * receipts is filled.
+ */
+typedef struct {
+  /** The index of the proxy. */
+  uint32_t           id;
+  /** The proxy instance. */
+  SRxProxy*          proxy;
+  /** The replay thread. */
+  pthread_t          thread;
+  /** The benchmark configuration. */
+  BenchConfiguration* config;
+  /** The table. */
+  BenchTable*        table;
+  /** The first update of the table replayed by this proxy. */
+  uint32_t           first;
+  /** The number of updates replayed by this proxy. */
+  uint32_t           count;
+  /** The send time (ns) of each request, indexed by localID - 1. */
+  uint64_t*          sendTime;
+  /** The latency (ns) of each receipt in the order of reception. */
+  uint64_t*          latency;
+  /** The number of requests sent. */
+  uint32_t           noSent;
+  /** The number of receipts received. */
+  uint32_t           noReceipts;
+  /** The number of notifications received without receipt. */
+  uint32_t           noNotify;
+  /** The time (ns) the last receipt was received. */
+  uint64_t           lastReceipt;
+  /** Set once the connection failed or was lost. */
+  bool               failed;
+  /** Set once the replay thread is done. */
+  bool               finished;
+  /** Protects the counters. */
+  pthread_mutex_t    mutex;
+  /** Signaled with each receipt. */
+  pthread_cond_t     cond;
+} BenchProxy;
+
+/** The seed of the random generator. */
+static uint64_t randState = DEFAULT_SEED;
+
+/**
+ * The IPv4 prefix length distribution of the synthetic table in per mil.
+ */
+static const uint16_t v4LenDist[][2] = {
+  {24, 580}, {23, 90}, {22, 110}, {21, 50}, {20, 50}, {19, 40}, {18, 25},
+  {17, 15}, {16, 30}, {15, 4}, {14, 3}, {13, 2}, {12, 1}
+};
+
+/**
+ * The IPv6 prefix length distribution of the synthetic table in per mil.
+ */
+static const uint16_t v6LenDist[][2] = {
+  {48, 460}, {47, 30}, {46, 30}, {44, 60}, {40, 50}, {36, 40}, {33, 30},
+  {32, 160}, {29, 40}, {28, 20}, {42, 80}
+};
+
+/**
+ * The AS path length distribution of the synthetic table in per mil, the
+ * first element is a path with one hop.
+ */
+static const uint16_t hopDist[BENCH_MAX_HOPS] = {
+  20, 120, 300, 280, 150, 70, 30, 15, 7, 4, 2, 2
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Helpers
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Return the monotonic time in nano seconds.
+ *
+ * @return The time in nano seconds.
+ */
+static uint64_t _now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * Return the next pseudo random number (xorshift64*). The synthetic table
+ * depends on the seed only.
+ *
+ * @return The random number.
+ */
+static uint64_t _random()
+{
+  randState ^= randState >> 12;
+  randState ^= randState << 25;
+  randState ^= randState >> 27;
+  return randState * 2685821657736338717ULL;
+}
+
+/**
+ * Select a value of the given distribution.
+ *
+ * @param dist The distribution as pairs of value and per mil.
+ * @param size The number of pairs.
+ *
+ * @return The selected value.
+ */
+static uint16_t _selectFromDist(const uint16_t dist[][2], uint32_t size)
+{
+  uint32_t pick = _random() % 1000;
+  uint32_t sum  = 0;
+  uint32_t idx;
+
+  for (idx = 0; idx < size; idx++)
+  {
+    sum += dist[idx][1];
+    if (pick < sum)
+    {
+      return dist[idx][0];
+    }
+  }
+  return dist[0][0];
+}
+
+/**
+ * Read the resident set size of the given process.
+ *
+ * @param pid The process id.
+ *
+ * @return The resident set size in kB or 0 if it could not be determined.
+ */
+static uint64_t _getRSS(pid_t pid)
+{
+  char     fileName[64];
+  char     line[256];
+  uint64_t rss = 0;
+  FILE*    file;
+
+  snprintf(fileName, sizeof(fileName), "/proc/%d/status", (int)pid);
+  file = fopen(fileName, "r");
+  if (file != NULL)
+  {
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+      if (strncmp(line, "VmRSS:", 6) == 0)
+      {
+        rss = strtoull(line + 6, NULL, 10);
+        break;
+      }
+    }
+    fclose(file);
+  }
+
+  return rss;
+}
+
+/**
+ * Used by qsort to sort the latencies.
+ *
+ * @param a The first latency.
+ * @param b The second latency.
+ *
+ * @return negative, zero, or positive.
+ */
+static int _cmpLatency(const void* a, const void* b)
+{
+  uint64_t la = *(const uint64_t*)a;
+  uint64_t lb = *(const uint64_t*)b;
+  return la < lb ? -1 : (la > lb ? 1 : 0);
+}
+
+/**
+ * Return the given percentile of the sorted latencies.
+ *
+ * @param latency The sorted latencies.
+ * @param size The number of latencies.
+ * @param perMil The percentile in per mil.
+ *
+ * @return The latency in micro seconds.
+ */
+static double _percentile(uint64_t* latency, uint64_t size, uint32_t perMil)
+{
+  uint64_t idx;
+
+  if (size == 0)
+  {
+    return 0;
+  }
+  idx = (size * perMil) / 1000;
+  if (idx >= size)
+  {
+    idx = size - 1;
+  }
+  return latency[idx] / 1000.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// The table
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Add an update to the table. Both arrays grow if needed.
+ *
+ * @param table The table
+ * @param prefix The prefix of the update.
+ * @param asPath The AS path in host format, the last AS is the origin.
+ * @param noHops The number of hops.
+ *
+ * @return false if not enough memory is available.
+ */
+static bool _addUpdate(BenchTable* table, IPPrefix* prefix, uint32_t* asPath,
+                       uint16_t noHops)
+{
+  BenchUpdate* update;
+  uint32_t     idx;
+
+  if (table->size == table->capacity)
+  {
+    uint32_t     newCapacity = table->capacity == 0 ? 1024
+                                                    : table->capacity * 2;
+    BenchUpdate* updates = realloc(table->updates,
+                                   newCapacity * sizeof(BenchUpdate));
+    if (updates == NULL)
+    {
+      return false;
+    }
+    table->updates  = updates;
+    table->capacity = newCapacity;
+  }
+  if ((table->poolSize + noHops) > table->poolCapacity)
+  {
+    uint32_t  newCapacity = table->poolCapacity == 0 ? 4096
+                                                     : table->poolCapacity * 2;
+    uint32_t* pool;
+    while (newCapacity < (table->poolSize + noHops))
+    {
+      newCapacity *= 2;
+    }
+    pool = realloc(table->pathPool, newCapacity * sizeof(uint32_t));
+    if (pool == NULL)
+    {
+      return false;
+    }
+    table->pathPool     = pool;
+    table->poolCapacity = newCapacity;
+  }
+
+  update = &table->updates[table->size++];
+  memcpy(&update->prefix, prefix, sizeof(IPPrefix));
+  update->originAS   = noHops > 0 ? asPath[noHops - 1] : 0;
+  update->pathOffset = table->poolSize;
+  update->noHops     = noHops;
+  for (idx = 0; idx < noHops; idx++)
+  {
+    table->pathPool[table->poolSize++] = htonl(asPath[idx]);
+  }
+  if (prefix->ip.version == 4)
+  {
+    table->noV4++;
+  }
+  else
+  {
+    table->noV6++;
+  }
+
+  return true;
+}
+
+/**
+ * Generate a synthetic AS path. The first hop is the peer AS, the origin AS
+ * is bound to the prefix number to let each origin announce several prefixes.
+ *
+ * @param prefixNo The number of the prefix within the table.
+ * @param asPath The path to be filled, at least BENCH_MAX_HOPS long.
+ *
+ * @return The number of hops.
+ */
+static uint16_t _generatePath(uint32_t prefixNo, uint32_t* asPath)
+{
+  uint32_t pick   = _random() % 1000;
+  uint32_t sum    = 0;
+  uint16_t noHops = BENCH_MAX_HOPS;
+  uint16_t idx;
+
+  for (idx = 0; idx < BENCH_MAX_HOPS; idx++)
+  {
+    sum += hopDist[idx];
+    if (pick < sum)
+    {
+      noHops = idx + 1;
+      break;
+    }
+  }
+
+  asPath[0] = DEFAULT_PEERAS;
+  for (idx = 1; idx < noHops; idx++)
+  {
+    asPath[idx] = 1000 + (_random() % BENCH_NO_TRANSIT);
+  }
+  // Origins announce around 15 prefixes each. They are 4 byte ASes to keep
+  // them apart from the transit ASes.
+  asPath[noHops - 1] = 65536 + ((prefixNo * 2654435761U) % BENCH_NO_ORIGINS);
+
+  return noHops;
+}
+
+/**
+ * Generate the synthetic table.
+ *
+ * @param table The table to be filled.
+ * @param cfg The benchmark configuration.
+ *
+ * @return false if not enough memory is available.
+ */
+static bool _generateTable(BenchTable* table, BenchConfiguration* cfg)
+{
+  IPPrefix prefix;
+  uint32_t asPath[BENCH_MAX_HOPS];
+  uint16_t noHops;
+  uint64_t rnd;
+  uint32_t idx;
+  uint32_t byteIdx;
+  uint8_t  bits;
+
+  randState = cfg->seed != 0 ? cfg->seed : DEFAULT_SEED;
+  for (idx = 0; idx < cfg->noV4; idx++)
+  {
+    memset(&prefix, 0, sizeof(IPPrefix));
+    prefix.ip.version = 4;
+    prefix.length     = _selectFromDist(v4LenDist,
+                                  sizeof(v4LenDist) / sizeof(v4LenDist[0]));
+    // Unicast space 1.0.0.0 - 223.255.255.255
+    rnd = _random();
+    prefix.ip.addr.v4.u32 = (uint32_t)(((1 + (rnd % 223)) << 24)
+                                       | ((rnd >> 8) & 0xFFFFFF));
+    prefix.ip.addr.v4.u32 &= 0xFFFFFFFFU << (32 - prefix.length);
+    prefix.ip.addr.v4.u32 = htonl(prefix.ip.addr.v4.u32);
+    noHops = _generatePath(idx, asPath);
+    if (!_addUpdate(table, &prefix, asPath, noHops))
+    {
+      return false;
+    }
+  }
+
+  for (idx = 0; idx < cfg->noV6; idx++)
+  {
+    memset(&prefix, 0, sizeof(IPPrefix));
+    prefix.ip.version = 6;
+    prefix.length     = _selectFromDist(v6LenDist,
+                                  sizeof(v6LenDist) / sizeof(v6LenDist[0]));
+    // Global unicast 2000::/3
+    rnd = _random();
+    for (byteIdx = 0; byteIdx < 8; byteIdx++)
+    {
+      prefix.ip.addr.v6.u8[byteIdx] = (uint8_t)(rnd >> (byteIdx * 8));
+    }
+    prefix.ip.addr.v6.u8[0] = 0x20 | (prefix.ip.addr.v6.u8[0] & 0x1F);
+    // Clear the host bits, all synthetic prefixes are at most /64
+    bits = prefix.length;
+    for (byteIdx = 0; byteIdx < 16; byteIdx++)
+    {
+      if (bits >= 8)
+      {
+        bits -= 8;
+      }
+      else
+      {
+        prefix.ip.addr.v6.u8[byteIdx] &= (uint8_t)(0xFF << (8 - bits));
+        bits = 0;
+      }
+    }
+    noHops = _generatePath(cfg->noV4 + idx, asPath);
+    if (!_addUpdate(table, &prefix, asPath, noHops))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Read the table from the given file.
+ *
+ * @param table The table to be filled.
+ * @param fileName The name of the table file.
+ *
+ * @return false if the file could not be read.
+ */
+static bool _readTable(BenchTable* table, const char* fileName)
+{
+  char     line[BENCH_MAX_LINE];
+  uint32_t asPath[BENCH_MAX_LINE / 2];
+  uint16_t noHops;
+  uint32_t lineNo = 0;
+  IPPrefix prefix;
+  char*    token;
+  char*    savePtr;
+  bool     retVal = true;
+  FILE*    file   = fopen(fileName, "r");
+
+  if (file == NULL)
+  {
+    printf("ERROR: Could not open the table file '%s'!\n", fileName);
+    return false;
+  }
+
+  while (retVal && (fgets(line, BENCH_MAX_LINE, file) != NULL))
+  {
+    lineNo++;
+    token = strtok_r(line, " \t\r\n", &savePtr);
+    if ((token == NULL) || (token[0] == '#'))
+    {
+      continue;
+    }
+    if (!strToIPPrefix(token, &prefix))
+    {
+      printf("WARNING: Invalid prefix '%s' in line %u!\n", token, lineNo);
+      continue;
+    }
+    noHops = 0;
+    while ((token = strtok_r(NULL, " \t\r\n", &savePtr)) != NULL)
+    {
+      asPath[noHops++] = strtoul(token, NULL, 10);
+    }
+    if (noHops == 0)
+    {
+      printf("WARNING: Update in line %u has no AS path!\n", lineNo);
+      continue;
+    }
+    retVal = _addUpdate(table, &prefix, asPath, noHops);
+  }
+  fclose(file);
+
+  return retVal;
+}
+
+/**
+ * Free the memory of the table.
+ *
+ * @param table The table.
+ */
+static void _releaseTable(BenchTable* table)
+{
+  free(table->updates);
+  free(table->pathPool);
+  memset(table, 0, sizeof(BenchTable));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Proxy callbacks
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Record the latency of the receipt. Notifications of result changes are
+ * counted only.
+ *
+ * @see ValidationReady in srx_api.h
+ */
+static bool handleValidationResult(SRxUpdateID          updateID,
+                                   uint32_t             localID,
+                                   ValidationResultType valType,
+                                   uint8_t              roaResult,
+                                   uint8_t              bgpsecResult,
+                                   void* userPtr)
+{
+  BenchProxy* bProxy = (BenchProxy*)userPtr;
+  uint64_t    now    = _now();
+
+  pthread_mutex_lock(&bProxy->mutex);
+  if (   (localID != 0) && (localID <= bProxy->count)
+      && (bProxy->noReceipts < bProxy->count))
+  {
+    bProxy->latency[bProxy->noReceipts++] = now
+                                            - bProxy->sendTime[localID - 1];
+    bProxy->lastReceipt = now;
+    pthread_cond_signal(&bProxy->cond);
+  }
+  else
+  {
+    bProxy->noNotify++;
+  }
+  pthread_mutex_unlock(&bProxy->mutex);
+
+  return true;
+}
+
+/**
+ * Signatures are not requested by the benchmark.
+ *
+ * @see SignaturesReady in srx_api.h
+ */
+static void handleSignatures(SRxUpdateID updateID, BGPSecCallbackData* data,
+                             void* userPtr)
+{
+}
+
+/**
+ * A synchronization request is ignored, the table is replayed once.
+ *
+ * @see SyncNotification in srx_api.h
+ */
+static void handleSyncRequest(void* userPtr)
+{
+}
+
+/**
+ * Stop the replay of the proxy once the connection fails.
+ *
+ * @see SrxCommManagement in srx_api.h
+ */
+static void commManagement(SRxProxyCommCode mainCode, int subCode,
+                           void* userPtr)
+{
+  BenchProxy* bProxy = (BenchProxy*)userPtr;
+
+  if (isErrorCode(mainCode))
+  {
+    printf("Proxy %u: SRx error %u, sub code %i!\n", bProxy->id, mainCode,
+           subCode);
+    if (   (mainCode == COM_ERR_PROXY_CONNECTION_LOST)
+        || (mainCode == COM_ERR_PROXY_COULD_NOT_SEND))
+    {
+      pthread_mutex_lock(&bProxy->mutex);
+      bProxy->failed = true;
+      pthread_cond_signal(&bProxy->cond);
+      pthread_mutex_unlock(&bProxy->mutex);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Replay
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Connects the proxy to the SRx server and sends the updates in batches, never
+ * more than the window of requests without receipt. Returns once all receipts
+ * are received or the timeout is reached.
+ *
+ * @param bProxy The proxy.
+ */
+static void _replayTable(BenchProxy* bProxy)
+{
+  BenchConfiguration* cfg    = bProxy->config;
+  BenchTable*        table   = bProxy->table;
+  SRxVerifyRequest*  requests;
+  BGPSecData*        bgpsec;
+  BenchUpdate*       update;
+  SRxDefaultResult   defResult;
+  struct timespec    deadline;
+  uint32_t           noBatch;
+  uint32_t           noSent;
+  uint32_t           next = 0;
+  uint32_t           idx;
+  uint32_t           peerAS = DEFAULT_PEERAS;
+
+  requests = malloc(cfg->batchSize * sizeof(SRxVerifyRequest));
+  bgpsec   = malloc(cfg->batchSize * sizeof(BGPSecData));
+  if ((requests == NULL) || (bgpsec == NULL))
+  {
+    printf("ERROR: Proxy %u: Not enough memory!\n", bProxy->id);
+    bProxy->failed = true;
+    free(requests);
+    free(bgpsec);
+    return;
+  }
+
+  defResult.result.roaResult    = SRx_RESULT_UNDEFINED;
+  defResult.result.bgpsecResult = SRx_RESULT_UNDEFINED;
+  defResult.resSourceROA        = SRxRS_UNKNOWN;
+  defResult.resSourceBGPSEC     = SRxRS_UNKNOWN;
+
+  addPeers(bProxy->proxy, 1, &peerAS);
+  if (!connectToSRx(bProxy->proxy, cfg->host, cfg->port,
+                    SRX_DEFAULT_HANDSHAKE_TIMEOUT, false))
+  {
+    printf("ERROR: Proxy %u could not connect to %s:%u!\n", bProxy->id,
+           cfg->host, cfg->port);
+    bProxy->failed = true;
+    free(requests);
+    free(bgpsec);
+    return;
+  }
+
+  while ((next < bProxy->count) && !bProxy->failed)
+  {
+    // Wait for the window to open
+    pthread_mutex_lock(&bProxy->mutex);
+    while (   !bProxy->failed
+           && ((bProxy->noSent - bProxy->noReceipts) >= cfg->window))
+    {
+      pthread_cond_wait(&bProxy->cond, &bProxy->mutex);
+    }
+    noBatch = cfg->window - (bProxy->noSent - bProxy->noReceipts);
+    pthread_mutex_unlock(&bProxy->mutex);
+
+    if (noBatch > cfg->batchSize)
+    {
+      noBatch = cfg->batchSize;
+    }
+    if (noBatch > (bProxy->count - next))
+    {
+      noBatch = bProxy->count - next;
+    }
+
+    for (idx = 0; idx < noBatch; idx++)
+    {
+      update = &table->updates[bProxy->first + next + idx];
+      bgpsec[idx].numberHops       = update->noHops;
+      bgpsec[idx].asPath           = &table->pathPool[update->pathOffset];
+      bgpsec[idx].attr_length      = 0;
+      bgpsec[idx].bgpsec_path_attr = NULL;
+
+      requests[idx].localID            = next + idx + 1;
+      requests[idx].usePrefixOriginVal = true;
+      requests[idx].usePathVal         = cfg->pathVal;
+      requests[idx].defaultResult      = &defResult;
+      requests[idx].prefix             = &update->prefix;
+      requests[idx].as32               = update->originAS;
+      requests[idx].bgpsec             = &bgpsec[idx];
+    }
+
+    // The receipt might arrive before verifyUpdateBatch returns.
+    pthread_mutex_lock(&bProxy->mutex);
+    bProxy->noSent += noBatch;
+    for (idx = 0; idx < noBatch; idx++)
+    {
+      bProxy->sendTime[next + idx] = _now();
+    }
+    pthread_mutex_unlock(&bProxy->mutex);
+
+    noSent = verifyUpdateBatch(bProxy->proxy, noBatch, requests);
+    if (noSent < noBatch)
+    {
+      pthread_mutex_lock(&bProxy->mutex);
+      bProxy->noSent -= noBatch - noSent;
+      bProxy->failed  = true;
+      pthread_mutex_unlock(&bProxy->mutex);
+    }
+    next += noSent;
+  }
+
+  // Wait for the outstanding receipts
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += cfg->timeout;
+  pthread_mutex_lock(&bProxy->mutex);
+  while (!bProxy->failed && (bProxy->noReceipts < bProxy->noSent))
+  {
+    if (pthread_cond_timedwait(&bProxy->cond, &bProxy->mutex, &deadline)
+        == ETIMEDOUT)
+    {
+      printf("WARNING: Proxy %u: %u receipts not received within %u "
+             "seconds!\n", bProxy->id, bProxy->noSent - bProxy->noReceipts,
+             cfg->timeout);
+      break;
+    }
+  }
+  pthread_mutex_unlock(&bProxy->mutex);
+
+  disconnectFromSRx(bProxy->proxy, SRX_DEFAULT_KEEP_WINDOW);
+  free(requests);
+  free(bgpsec);
+}
+
+/**
+ * The replay thread of a proxy.
+ *
+ * @param data The BenchProxy.
+ *
+ * @return NULL
+ */
+static void* _replay(void* data)
+{
+  BenchProxy* bProxy = (BenchProxy*)data;
+
+  _replayTable(bProxy);
+  pthread_mutex_lock(&bProxy->mutex);
+  bProxy->finished = true;
+  pthread_mutex_unlock(&bProxy->mutex);
+
+  return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Program
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Print the program syntax.
+ *
+ * @param prgName The program name.
+ */
+static void syntax(const char* prgName)
+{
+  printf ("Syntax: %s [options]\n", prgName);
+  printf ("  options:\n");
+  printf ("    -s <host>    The SRx server host (default: %s).\n",
+          DEFAULT_SERVER);
+  printf ("    -p <port>    The SRx server port (default: %u).\n",
+          DEFAULT_PORT);
+  printf ("    -c <count>   The number of concurrent proxies (default: %u).\n",
+          DEFAULT_PROXIES);
+  printf ("    -4 <count>   Synthetic IPv4 updates (default: %u).\n",
+          DEFAULT_NO_V4);
+  printf ("    -6 <count>   Synthetic IPv6 updates (default: %u).\n",
+          DEFAULT_NO_V6);
+  printf ("    -f <file>    Replay the table file instead of a synthetic\n");
+  printf ("                 table. Each line: <prefix> <AS path>\n");
+  printf ("    -b <count>   Requests per batch (default: %u).\n",
+          DEFAULT_BATCH);
+  printf ("    -w <count>   Requests without receipt per proxy (default: "
+          "%u).\n", DEFAULT_WINDOW);
+  printf ("    -t <sec>     Wait for outstanding receipts (default: %u).\n",
+          DEFAULT_TIMEOUT);
+  printf ("    -r <seed>    The seed of the synthetic table (default: %u).\n",
+          DEFAULT_SEED);
+  printf ("    -m <pid>     Report the memory of the SRx server process.\n");
+  printf ("    -d           Split the table between the proxies, by default\n");
+  printf ("                 each proxy replays the complete table.\n");
+  printf ("    -P           Request path validation as well.\n");
+  printf ("    -h           This help.\n");
+}
+
+/**
+ * Parses the program parameters and set the configuration. This function
+ * returns true if the program can continue and the exit Value.
+ *
+ * @param argc    The argument count
+ * @param argv    The Argument array
+ * @param cfg     The program configuration
+ * @param exitVal The exit value pointer if needed
+ *
+ * @return true if the program can continue, false if it should be ended.
+ */
+static bool parseParams(int argc, const char* argv[],
+                        BenchConfiguration* cfg, int* exitVal)
+{
+  bool  retVal = true;
+  int   eVal   = 0;
+  bool  doHelp = false;
+  char* arg    = NULL;
+  char* value  = NULL;
+  int   idx    = 0;
+
+  for (idx = 1; (idx < argc) && !doHelp; idx++)
+  {
+    arg = (char*)argv[idx];
+    if ((arg[0] != '-') || (arg[1] == '\0'))
+    {
+      printf ("ERROR: Invalid parameter '%s'\n", arg);
+      doHelp = true;
+      retVal = false;
+      eVal   = 1;
+      continue;
+    }
+    arg++;
+    switch (arg[0])
+    {
+      case 'h':
+      case 'H':
+      case '?':
+        doHelp = true;
+        retVal = false;
+        continue;
+      case 'd':
+        cfg->split = true;
+        continue;
+      case 'P':
+        cfg->pathVal = true;
+        continue;
+      default:
+        break;
+    }
+
+    // All other parameters require a value
+    if ((idx + 1) >= argc)
+    {
+      printf ("ERROR: Value of parameter '-%s' missing!\n", arg);
+      doHelp = true;
+      retVal = false;
+      eVal   = 1;
+      continue;
+    }
+    value = (char*)argv[++idx];
+    switch (arg[0])
+    {
+      case 's':
+        cfg->host = value;
+        break;
+      case 'p':
+        cfg->port = strtoul(value, NULL, 10);
+        break;
+      case 'c':
+        cfg->noProxies = strtoul(value, NULL, 10);
+        break;
+      case '4':
+        cfg->noV4 = strtoul(value, NULL, 10);
+        break;
+      case '6':
+        cfg->noV6 = strtoul(value, NULL, 10);
+        break;
+      case 'f':
+        cfg->tableFile = value;
+        break;
+      case 'b':
+        cfg->batchSize = strtoul(value, NULL, 10);
+        break;
+      case 'w':
+        cfg->window = strtoul(value, NULL, 10);
+        break;
+      case 't':
+        cfg->timeout = strtoul(value, NULL, 10);
+        break;
+      case 'r':
+        cfg->seed = strtoul(value, NULL, 10);
+        break;
+      case 'm':
+        cfg->serverPID = (pid_t)strtol(value, NULL, 10);
+        break;
+      default:
+        printf ("ERROR: Invalid parameter '-%s'\n", arg);
+        doHelp = true;
+        retVal = false;
+        eVal   = 1;
+        break;
+    }
+  }
+
+  if (doHelp)
+  {
+    syntax(argv[0]);
+  }
+
+  if ((cfg->noProxies == 0) || (cfg->batchSize == 0) || (cfg->window == 0))
+  {
+    printf ("ERROR: Proxies, batch size, and window must not be 0!\n");
+    retVal = false;
+    eVal   = 1;
+  }
+
+  if (exitVal != NULL)
+  {
+    *exitVal = eVal;
+  }
+
+  return retVal;
+}
+
+/**
+ * Print the report of the benchmark.
+ *
+ * @param cfg The configuration.
+ * @param proxies The proxies.
+ * @param start The time (ns) the replay started.
+ * @param rss The server memory in kB before, at the peak, and after the
+ *            replay.
+ */
+static void _printReport(BenchConfiguration* cfg, BenchProxy* proxies,
+                         uint64_t start, uint64_t rss[3])
+{
+  uint64_t  noSent     = 0;
+  uint64_t  noReceipts = 0;
+  uint64_t  noNotify   = 0;
+  uint64_t  last       = start;
+  uint64_t* latency;
+  uint64_t  size       = 0;
+  double    elapsed;
+  uint32_t  idx;
+
+  for (idx = 0; idx < cfg->noProxies; idx++)
+  {
+    noSent     += proxies[idx].noSent;
+    noReceipts += proxies[idx].noReceipts;
+    noNotify   += proxies[idx].noNotify;
+    if (proxies[idx].lastReceipt > last)
+    {
+      last = proxies[idx].lastReceipt;
+    }
+    printf("Proxy %2u: %u requests, %u receipts, %u notifications%s\n", idx,
+           proxies[idx].noSent, proxies[idx].noReceipts, proxies[idx].noNotify,
+           proxies[idx].failed ? " (FAILED)" : "");
+  }
+
+  latency = malloc((noReceipts > 0 ? noReceipts : 1) * sizeof(uint64_t));
+  if (latency == NULL)
+  {
+    printf("ERROR: Not enough memory to sort the latencies!\n");
+    return;
+  }
+  for (idx = 0; idx < cfg->noProxies; idx++)
+  {
+    memcpy(latency + size, proxies[idx].latency,
+           proxies[idx].noReceipts * sizeof(uint64_t));
+    size += proxies[idx].noReceipts;
+  }
+  qsort(latency, size, sizeof(uint64_t), _cmpLatency);
+  elapsed = (last - start) / (double)NSEC_PER_SEC;
+
+  printf("\n%s Report\n", BENCH_NAME);
+  printf("  Requests........: %lu\n", (unsigned long)noSent);
+  printf("  Receipts........: %lu\n", (unsigned long)noReceipts);
+  printf("  Notifications...: %lu\n", (unsigned long)noNotify);
+  printf("  Elapsed.........: %.3f s\n", elapsed);
+  printf("  Throughput......: %.0f updates/s\n",
+         elapsed > 0 ? noReceipts / elapsed : 0.0);
+  printf("  Latency (us)....: p50=%.1f p99=%.1f p999=%.1f max=%.1f\n",
+         _percentile(latency, size, 500), _percentile(latency, size, 990),
+         _percentile(latency, size, 999),
+         size > 0 ? latency[size - 1] / 1000.0 : 0.0);
+  if (cfg->serverPID != 0)
+  {
+    printf("  Server RSS (kB).: start=%lu peak=%lu end=%lu\n",
+           (unsigned long)rss[0], (unsigned long)rss[1],
+           (unsigned long)rss[2]);
+  }
+
+  free(latency);
+}
+
+/**
+ * Start the SRx benchmark.
+ *
+ * @param argc The number of arguments passed to the program
+ * @param argv The arguments passed to the program
+ *
+ * @return The program exit level.
+ */
+int main(int argc, const char* argv[])
+{
+  BenchConfiguration cfg;
+  BenchTable         table;
+  BenchProxy*        proxies;
+  BenchProxy*        bProxy;
+  uint32_t           proxyID = IPtoInt(DEFAULT_PROXY_ID);
+  uint64_t           rss[3]  = { 0, 0, 0 };
+  uint64_t           start;
+  uint64_t           current;
+  uint32_t           perProxy;
+  uint32_t           noDone;
+  uint32_t           noCreated = 0;
+  uint32_t           noStarted = 0;
+  uint32_t           idx;
+  int                ret = 0;
+
+  memset(&cfg, 0, sizeof(BenchConfiguration));
+  memset(&table, 0, sizeof(BenchTable));
+  cfg.host      = DEFAULT_SERVER;
+  cfg.port      = DEFAULT_PORT;
+  cfg.noProxies = DEFAULT_PROXIES;
+  cfg.noV4      = DEFAULT_NO_V4;
+  cfg.noV6      = DEFAULT_NO_V6;
+  cfg.batchSize = DEFAULT_BATCH;
+  cfg.window    = DEFAULT_WINDOW;
+  cfg.timeout   = DEFAULT_TIMEOUT;
+  cfg.seed      = DEFAULT_SEED;
+
+  if (!parseParams(argc, argv, &cfg, &ret))
+  {
+    return ret;
+  }
+
+  setLogMethodToFile(stderr);
+  setLogLevel(LEVEL_ERROR);
+
+  printf("%s Version %s\n", BENCH_NAME, BENCH_VERSION);
+  if (cfg.tableFile != NULL ? !_readTable(&table, cfg.tableFile)
+                            : !_generateTable(&table, &cfg))
+  {
+    printf("ERROR: Could not create the table!\n");
+    _releaseTable(&table);
+    return -1;
+  }
+  printf("Table: %u updates (%u IPv4, %u IPv6), %u proxies\n", table.size,
+         table.noV4, table.noV6, cfg.noProxies);
+
+  proxies = calloc(cfg.noProxies, sizeof(BenchProxy));
+  if (proxies == NULL)
+  {
+    printf("ERROR: Not enough memory for %u proxies!\n", cfg.noProxies);
+    _releaseTable(&table);
+    return -1;
+  }
+
+  perProxy = cfg.split ? table.size / cfg.noProxies : table.size;
+  for (idx = 0; (idx < cfg.noProxies) && (ret == 0); idx++, noCreated++)
+  {
+    bProxy = &proxies[idx];
+    bProxy->id       = idx;
+    bProxy->config   = &cfg;
+    bProxy->table    = &table;
+    bProxy->first    = cfg.split ? idx * perProxy : 0;
+    bProxy->count    = (cfg.split && (idx == cfg.noProxies - 1))
+                       ? table.size - bProxy->first : perProxy;
+    bProxy->sendTime = malloc((bProxy->count + 1) * sizeof(uint64_t));
+    bProxy->latency  = malloc((bProxy->count + 1) * sizeof(uint64_t));
+    pthread_mutex_init(&bProxy->mutex, NULL);
+    pthread_cond_init(&bProxy->cond, NULL);
+    bProxy->proxy    = createSRxProxy(handleValidationResult, handleSignatures,
+                                      handleSyncRequest, commManagement,
+                                      proxyID + idx, DEFAULT_PROXY_AS, bProxy);
+    if (   (bProxy->sendTime == NULL) || (bProxy->latency == NULL)
+        || (bProxy->proxy == NULL))
+    {
+      printf("ERROR: Could not create proxy %u!\n", idx);
+      ret = -1;
+    }
+  }
+
+  if (cfg.serverPID != 0)
+  {
+    rss[0] = _getRSS(cfg.serverPID);
+    rss[1] = rss[0];
+  }
+
+  start = _now();
+  for (; (noStarted < cfg.noProxies) && (ret == 0); noStarted++)
+  {
+    if (pthread_create(&proxies[noStarted].thread, NULL, _replay,
+                       &proxies[noStarted]) != 0)
+    {
+      printf("ERROR: Could not start the replay of proxy %u!\n", noStarted);
+      ret = -1;
+      break;
+    }
+  }
+
+  // Sample the server memory while the proxies replay the table.
+  do
+  {
+    sleep(1);
+    noDone = 0;
+    for (idx = 0; idx < cfg.noProxies; idx++)
+    {
+      bProxy = &proxies[idx];
+      pthread_mutex_lock(&bProxy->mutex);
+      if (bProxy->finished)
+      {
+        noDone++;
+      }
+      pthread_mutex_unlock(&bProxy->mutex);
+    }
+    if (cfg.serverPID != 0)
+    {
+      current = _getRSS(cfg.serverPID);
+      rss[1] = current > rss[1] ? current : rss[1];
+    }
+  } while (noDone < noStarted);
+
+  for (idx = 0; idx < noStarted; idx++)
+  {
+    pthread_join(proxies[idx].thread, NULL);
+  }
+  if (cfg.serverPID != 0)
+  {
+    rss[2] = _getRSS(cfg.serverPID);
+  }
+
+  if (ret == 0)
+  {
+    _printReport(&cfg, proxies, start, rss);
+  }
+
+  for (idx = 0; idx < noCreated; idx++)
+  {
+    bProxy = &proxies[idx];
+    if (bProxy->proxy != NULL)
+    {
+      releaseSRxProxy(bProxy->proxy);
+    }
+    free(bProxy->sendTime);
+    free(bProxy->latency);
+    pthread_mutex_destroy(&bProxy->mutex);
+    pthread_cond_destroy(&bProxy->cond);
+  }
+  free(proxies);
+  _releaseTable(&table);
+
+  return ret;
+}
@@ -0,0 +1,807 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * In-process micro benchmark of the prefix cache and the update cache. Both
+ * caches are linked directly into the benchmark, no server, socket, or RPKI
+ * cache is involved. A synthetic workload is run through the phases
+ * addROAwl, storeUpdate, requestUpdateValidation, modifyUpdateResult and
+ * delROAwl. Each phase reports one CSV line with its timing and the number of
+ * allocations made during the phase.
+ *
+ * The allocations are counted by wrapping malloc, calloc, realloc and free at
+ * link time (-Wl,--wrap=...), see Makefile.am. The counters are process wide,
+ * they include the allocations of the change log thread of the update cache.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code Created
+ * -----------------------------------------------------------------------------
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include "server/prefix_cache.h"
+#include "server/server_connection_handler.h"
+#include "server/update_cache.h"
+#include "shared/srx_defs.h"
+#include "util/log.h"
+#include "util/prefix.h"
+
+#define BENCH_NAME            "SRx Cache Benchmark"
+#define BENCH_VERSION         "0.4.1.0"
+
+#define DEFAULT_NO_ROAS       100000
+#define DEFAULT_NO_UPDATES    100000
+#define DEFAULT_MIN_LEN       16
+#define DEFAULT_MAX_LEN       24
+#define DEFAULT_MOAS          1
+#define DEFAULT_DEPTH         1
+#define DEFAULT_V6_PERCENT    0
+#define DEFAULT_SEED          1
+
+/** The first origin AS of the workload (below the rfc5398 range). */
+#define BENCH_FIRST_AS        1000
+/** The number of distinct origin ASes of the workload. */
+#define BENCH_NO_ORIGINS      60000
+/** The shortest covering ROA of an IPv4 / IPv6 prefix. */
+#define BENCH_MIN_V4_LEN      8
+#define BENCH_MIN_V6_LEN      16
+/** Per mil of the updates that are not covered by any ROA. */
+#define BENCH_NOTFOUND_PERMIL 100
+/** Per mil of the updates that are announced by a foreign origin. */
+#define BENCH_FOREIGN_PERMIL  200
+/** Per mil of the updates that are more specific than the ROA allows. */
+#define BENCH_LONGER_PERMIL   100
+/** The session id and validation cache id of the ROAs. */
+#define BENCH_SESSION_ID      1
+#define BENCH_VAL_CACHE_ID    1
+/** The client id used to store the updates. */
+#define BENCH_CLIENT_ID       1
+/** Used to convert seconds into nano seconds. */
+#define NSEC_PER_SEC          1000000000ULL
+
+/**
+ * One ROA white-list entry of the workload.
+ */
+typedef struct {
+  /** The prefix of the ROA */
+  IPPrefix prefix;
+  /** The origin AS */
+  uint32_t originAS;
+  /** The max length */
+  uint8_t  maxLen;
+} BenchROA;
+
+/**
+ * One update of the workload.
+ */
+typedef struct {
+  /** The update id */
+  SRxUpdateID updateID;
+  /** The prefix of the update */
+  IPPrefix    prefix;
+  /** The origin AS */
+  uint32_t    originAS;
+} BenchUpdate;
+
+/**
+ * The parameters of the workload.
+ */
+typedef struct {
+  /** The number of ROA prefixes. */
+  uint32_t noROAs;
+  /** The number of updates. */
+  uint32_t noUpdates;
+  /** The shortest prefix length of the ROA prefixes. */
+  uint8_t  minLen;
+  /** The longest prefix length of the ROA prefixes. */
+  uint8_t  maxLen;
+  /** The number of origin ASes per ROA prefix (MOAS fan-out). */
+  uint32_t moas;
+  /** The number of ROAs covering each other per ROA prefix. */
+  uint32_t depth;
+  /** The percentage of IPv6 prefixes. */
+  uint32_t v6Percent;
+  /** The seed of the workload. */
+  uint32_t seed;
+  /** Print the CSV header. */
+  bool     header;
+} BenchConfiguration;
+
+/**
+ * The allocation counters, see the malloc wrappers below.
+ */
+typedef struct {
+  /** The number of malloc, calloc and realloc calls. */
+  uint64_t allocs;
+  /** The number of free calls with a pointer other than NULL. */
+  uint64_t frees;
+  /** The number of bytes requested. */
+  uint64_t bytes;
+} BenchAllocStats;
+
+/** The allocation counters of the process. */
+static BenchAllocStats allocStats = { 0, 0, 0 };
+
+/** The state of the random number generator. */
+static uint64_t randState = DEFAULT_SEED;
+
+////////////////////////////////////////////////////////////////////////////////
+// ALLOCATION COUNTERS
+////////////////////////////////////////////////////////////////////////////////
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void  __real_free(void* ptr);
+
+/**
+ * Count the allocation and call the real malloc.
+ *
+ * @param size The number of bytes.
+ *
+ * @return The allocated memory.
+ */
+void* __wrap_malloc(size_t size)
+{
+  __sync_add_and_fetch(&allocStats.allocs, 1);
+  __sync_add_and_fetch(&allocStats.bytes, size);
+  return __real_malloc(size);
+}
+
+/**
+ * Count the allocation and call the real calloc.
+ *
+ * @param nmemb The number of elements.
+ * @param size The size of each element.
+ *
+ * @return The allocated memory.
+ */
+void* __wrap_calloc(size_t nmemb, size_t size)
+{
+  __sync_add_and_fetch(&allocStats.allocs, 1);
+  __sync_add_and_fetch(&allocStats.bytes, nmemb * size);
+  return __real_calloc(nmemb, size);
+}
+
+/**
+ * Count the allocation and call the real realloc.
+ *
+ * @param ptr The memory to be resized.
+ * @param size The new number of bytes.
+ *
+ * @return The re-allocated memory.
+ */
+void* __wrap_realloc(void* ptr, size_t size)
+{
+  __sync_add_and_fetch(&allocStats.allocs, 1);
+  __sync_add_and_fetch(&allocStats.bytes, size);
+  return __real_realloc(ptr, size);
+}
+
+/**
+ * Count the release and call the real free.
+ *
+ * @param ptr The memory to be released.
+ */
+void __wrap_free(void* ptr)
+{
+  if (ptr != NULL)
+  {
+    __sync_add_and_fetch(&allocStats.frees, 1);
+  }
+  __real_free(ptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// WORKLOAD
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Return the monotonic time in nano seconds.
+ *
+ * @return The time in nano seconds.
+ */
+static uint64_t _now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * Return the next pseudo random number (xorshift64*). The workload depends
+ * on the seed only.
+ *
+ * @return The random number.
+ */
+static uint64_t _random()
+{
+  randState ^= randState >> 12;
+  randState ^= randState << 25;
+  randState ^= randState >> 27;
+  return randState * 2685821657736338717ULL;
+}
+
+/**
+ * Set the prefix length and clear all host bits.
+ *
+ * @param prefix The prefix.
+ * @param length The new prefix length.
+ */
+static void _setPrefixLength(IPPrefix* prefix, uint8_t length)
+{
+  uint8_t* bytes = prefix->ip.version == 4 ? prefix->ip.addr.v4.u8
+                                           : prefix->ip.addr.v6.u8;
+  int      size  = prefix->ip.version == 4 ? 4 : 16;
+  int      idx;
+
+  prefix->length = length;
+  for (idx = 0; idx < size; idx++)
+  {
+    if (length >= 8)
+    {
+      length -= 8;
+    }
+    else
+    {
+      bytes[idx] &= (uint8_t)(0xFF00 >> length);
+      length = 0;
+    }
+  }
+}
+
+/**
+ * Fill the given prefix with a random address of the given length.
+ *
+ * @param prefix The prefix to be filled.
+ * @param v6 true for an IPv6 prefix.
+ * @param length The prefix length.
+ */
+static void _randomPrefix(IPPrefix* prefix, bool v6, uint8_t length)
+{
+  uint64_t rnd;
+  int      idx;
+
+  memset(prefix, 0, sizeof(IPPrefix));
+  prefix->length = length;
+  if (!v6)
+  {
+    prefix->ip.version = 4;
+    rnd = length == 0 ? 0 : (_random() >> 32) & (0xFFFFFFFFU << (32 - length));
+    prefix->ip.addr.v4.u32 = htonl((uint32_t)rnd);
+  }
+  else
+  {
+    prefix->ip.version = 6;
+    for (idx = 0; idx < 16; idx++)
+    {
+      prefix->ip.addr.v6.u8[idx] = (uint8_t)(_random() >> 56);
+    }
+    // Place all prefixes into 2000::/3
+    prefix->ip.addr.v6.u8[0] = 0x20 | (prefix->ip.addr.v6.u8[0] & 0x1F);
+    _setPrefixLength(prefix, length);
+  }
+}
+
+/**
+ * Generate the ROA white-list entries of the workload. Each of the noROAs
+ * prefixes gets moas origins, each of them is covered by depth - 1 ROAs of
+ * the same origin with shorter prefixes.
+ *
+ * @param cfg The workload parameters.
+ * @param noROAs (out) The number of generated ROA white-list entries.
+ *
+ * @return The ROA white-list entries or NULL.
+ */
+static BenchROA* _generateROAs(BenchConfiguration* cfg, uint32_t* noROAs)
+{
+  BenchROA* roas = malloc((size_t)cfg->noROAs * cfg->moas * cfg->depth
+                          * sizeof(BenchROA));
+  BenchROA* roa;
+  IPPrefix  prefix;
+  bool      v6;
+  uint8_t   length;
+  uint8_t   minLen;
+  uint32_t  idx, moas, depth;
+  uint32_t  count = 0;
+
+  if (roas == NULL)
+  {
+    return NULL;
+  }
+
+  for (idx = 0; idx < cfg->noROAs; idx++)
+  {
+    v6     = (_random() % 100) < cfg->v6Percent;
+    length = cfg->minLen + (_random() % (cfg->maxLen - cfg->minLen + 1));
+    if (v6)
+    {
+      // The same distribution, shifted into the IPv6 prefix lengths.
+      length += 24;
+    }
+    minLen = v6 ? BENCH_MIN_V6_LEN : BENCH_MIN_V4_LEN;
+    _randomPrefix(&prefix, v6, length);
+
+    for (moas = 0; moas < cfg->moas; moas++)
+    {
+      for (depth = 0; (depth < cfg->depth) && (length - depth >= minLen);
+           depth++)
+      {
+        roa = &roas[count++];
+        roa->prefix   = prefix;
+        roa->originAS = BENCH_FIRST_AS
+                        + ((idx * cfg->moas + moas) % BENCH_NO_ORIGINS);
+        roa->maxLen   = length;
+        _setPrefixLength(&roa->prefix, length - depth);
+      }
+    }
+  }
+
+  *noROAs = count;
+  return roas;
+}
+
+/**
+ * Generate the updates of the workload. Most updates announce a ROA prefix
+ * by one of its origins, the others are not covered at all, are announced by
+ * a foreign origin, or are more specific than the ROA allows.
+ *
+ * @param cfg The workload parameters.
+ * @param roas The ROA white-list entries.
+ * @param noROAs The number of ROA white-list entries.
+ *
+ * @return The updates or NULL.
+ */
+static BenchUpdate* _generateUpdates(BenchConfiguration* cfg, BenchROA* roas,
+                                     uint32_t noROAs)
+{
+  BenchUpdate* updates = malloc((size_t)cfg->noUpdates * sizeof(BenchUpdate));
+  BenchUpdate* update;
+  BenchROA*    roa;
+  uint32_t     idx;
+  uint32_t     pick;
+  uint8_t      maxAddrLen;
+  bool         v6;
+
+  if (updates == NULL)
+  {
+    return NULL;
+  }
+
+  for (idx = 0; idx < cfg->noUpdates; idx++)
+  {
+    update = &updates[idx];
+    // Knuth's multiplicative hash is a bijection of the 32 bit numbers.
+    update->updateID = (SRxUpdateID)(idx * 2654435761U);
+    pick = _random() % 1000;
+
+    if ((noROAs == 0) || (pick < BENCH_NOTFOUND_PERMIL))
+    {
+      v6 = (_random() % 100) < cfg->v6Percent;
+      _randomPrefix(&update->prefix, v6, v6 ? cfg->maxLen + 24 : cfg->maxLen);
+      update->originAS = BENCH_FIRST_AS + (_random() % BENCH_NO_ORIGINS);
+      continue;
+    }
+
+    roa = &roas[_random() % noROAs];
+    update->prefix   = roa->prefix;
+    update->originAS = roa->originAS;
+    _setPrefixLength(&update->prefix, roa->maxLen);
+    pick -= BENCH_NOTFOUND_PERMIL;
+    if (pick < BENCH_FOREIGN_PERMIL)
+    {
+      update->originAS = BENCH_FIRST_AS + BENCH_NO_ORIGINS
+                         + (_random() % BENCH_NO_ORIGINS);
+    }
+    else if (pick < BENCH_FOREIGN_PERMIL + BENCH_LONGER_PERMIL)
+    {
+      maxAddrLen = update->prefix.ip.version == 4 ? 32 : 128;
+      if (roa->maxLen < maxAddrLen)
+      {
+        update->prefix.length = roa->maxLen + 1;
+      }
+    }
+  }
+
+  return updates;
+}
+
+/**
+ * Called by the change log of the update cache for each changed result.
+ *
+ * @param result The changed result.
+ */
+static void _resultChanged(SRxValidationResult* result)
+{
+  // Nothing to deliver, no client is connected.
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// REPORT
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Take a snapshot of the allocation counters.
+ *
+ * @param stats (out) The snapshot.
+ */
+static void _snapshotAllocs(BenchAllocStats* stats)
+{
+  stats->allocs = __sync_add_and_fetch(&allocStats.allocs, 0);
+  stats->frees  = __sync_add_and_fetch(&allocStats.frees, 0);
+  stats->bytes  = __sync_add_and_fetch(&allocStats.bytes, 0);
+}
+
+/**
+ * Print the CSV header.
+ */
+static void _printHeader()
+{
+  printf("operation,roas,moas,depth,min_len,max_len,v6_percent,updates,"
+         "count,failed,total_ns,ns_per_op,ops_per_sec,allocs,frees,bytes\n");
+}
+
+/**
+ * Print the CSV line of one phase.
+ *
+ * @param cfg The workload parameters.
+ * @param operation The name of the measured function.
+ * @param count The number of calls.
+ * @param failed The number of calls that failed.
+ * @param start The time (ns) the phase started.
+ * @param allocs The allocation counters at the start of the phase.
+ */
+static void _printPhase(BenchConfiguration* cfg, const char* operation,
+                        uint32_t count, uint32_t failed, uint64_t start,
+                        BenchAllocStats* allocs)
+{
+  uint64_t        total = _now() - start;
+  BenchAllocStats end;
+
+  _snapshotAllocs(&end);
+  printf("%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%llu,%.1f,%.0f,%llu,%llu,%llu\n",
+         operation, cfg->noROAs, cfg->moas, cfg->depth, cfg->minLen,
+         cfg->maxLen, cfg->v6Percent, cfg->noUpdates, count, failed,
+         (unsigned long long)total,
+         count > 0 ? (double)total / count : 0.0,
+         total > 0 ? (double)count * NSEC_PER_SEC / total : 0.0,
+         (unsigned long long)(end.allocs - allocs->allocs),
+         (unsigned long long)(end.frees - allocs->frees),
+         (unsigned long long)(end.bytes - allocs->bytes));
+  fflush(stdout);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PROGRAM
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Print the program syntax.
+ *
+ * @param prgName The program name.
+ */
+static void syntax(const char* prgName)
+{
+  printf ("%s Version %s\n", BENCH_NAME, BENCH_VERSION);
+  printf ("Syntax: %s [options]\n", prgName);
+  printf ("  options:\n");
+  printf ("    -r <count>   The number of ROA prefixes (default: %u).\n",
+          DEFAULT_NO_ROAS);
+  printf ("    -u <count>   The number of updates (default: %u).\n",
+          DEFAULT_NO_UPDATES);
+  printf ("    -l <len>     The shortest ROA prefix length (default: %u).\n",
+          DEFAULT_MIN_LEN);
+  printf ("    -L <len>     The longest ROA prefix length (default: %u).\n",
+          DEFAULT_MAX_LEN);
+  printf ("    -m <count>   Origin ASes per ROA prefix (default: %u).\n",
+          DEFAULT_MOAS);
+  printf ("    -d <count>   Covering ROAs per ROA prefix, including the\n"
+          "                 prefix itself (default: %u).\n", DEFAULT_DEPTH);
+  printf ("    -6 <percent> The percentage of IPv6 prefixes, the prefix\n"
+          "                 lengths are shifted by 24 (default: %u).\n",
+          DEFAULT_V6_PERCENT);
+  printf ("    -s <seed>    The seed of the workload (default: %u).\n",
+          DEFAULT_SEED);
+  printf ("    -n           Do not print the CSV header.\n");
+  printf ("    -h           This help.\n");
+}
+
+/**
+ * Parses the program parameters and set the configuration. This function
+ * returns true if the program can continue and the exit Value.
+ *
+ * @param argc    The argument count
+ * @param argv    The Argument array
+ * @param cfg     The program configuration
+ * @param exitVal The exit value pointer if needed
+ *
+ * @return true if the program can continue, false if it should be ended.
+ */
+static bool parseParams(int argc, const char* argv[],
+                        BenchConfiguration* cfg, int* exitVal)
+{
+  bool  retVal = true;
+  int   eVal   = 0;
+  bool  doHelp = false;
+  char* arg    = NULL;
+  char* value  = NULL;
+  int   idx    = 0;
+
+  for (idx = 1; (idx < argc) && !doHelp; idx++)
+  {
+    arg = (char*)argv[idx];
+    if ((arg[0] != '-') || (arg[1] == '\0'))
+    {
+      printf ("ERROR: Invalid parameter '%s'\n", arg);
+      doHelp = true;
+      retVal = false;
+      eVal   = 1;
+      continue;
+    }
+    arg++;
+    switch (arg[0])
+    {
+      case 'h':
+      case 'H':
+      case '?':
+        doHelp = true;
+        retVal = false;
+        continue;
+      case 'n':
+        cfg->header = false;
+        continue;
+      default:
+        break;
+    }
+
+    // All other parameters require a value
+    if ((idx + 1) >= argc)
+    {
+      printf ("ERROR: Value of parameter '-%s' missing!\n", arg);
+      doHelp = true;
+      retVal = false;
+      eVal   = 1;
+      continue;
+    }
+    value = (char*)argv[++idx];
+    switch (arg[0])
+    {
+      case 'r':
+        cfg->noROAs = strtoul(value, NULL, 10);
+        break;
+      case 'u':
+        cfg->noUpdates = strtoul(value, NULL, 10);
+        break;
+      case 'l':
+        cfg->minLen = (uint8_t)strtoul(value, NULL, 10);
+        break;
+      case 'L':
+        cfg->maxLen = (uint8_t)strtoul(value, NULL, 10);
+        break;
+      case 'm':
+        cfg->moas = strtoul(value, NULL, 10);
+        break;
+      case 'd':
+        cfg->depth = strtoul(value, NULL, 10);
+        break;
+      case '6':
+        cfg->v6Percent = strtoul(value, NULL, 10);
+        break;
+      case 's':
+        cfg->seed = strtoul(value, NULL, 10);
+        break;
+      default:
+        printf ("ERROR: Invalid parameter '-%s'\n", arg);
+        doHelp = true;
+        retVal = false;
+        eVal   = 1;
+        break;
+    }
+  }
+
+  if (doHelp)
+  {
+    syntax(argv[0]);
+  }
+  else if (   (cfg->moas == 0) || (cfg->depth == 0) || (cfg->v6Percent > 100)
+           || (cfg->minLen < BENCH_MIN_V4_LEN) || (cfg->maxLen > 31)
+           || (cfg->minLen > cfg->maxLen))
+  {
+    printf ("ERROR: MOAS and depth must not be 0, the ROA prefix lengths "
+            "must be within %u and 31, the IPv6 percentage within 0 and "
+            "100!\n", BENCH_MIN_V4_LEN);
+    retVal = false;
+    eVal   = 1;
+  }
+
+  if (exitVal != NULL)
+  {
+    *exitVal = eVal;
+  }
+
+  return retVal;
+}
+
+/**
+ * The main function of the cache benchmark.
+ *
+ * @param argc The number of arguments
+ * @param argv The arguments
+ *
+ * @return 0 if the benchmark ran, otherwise 1 or -1.
+ */
+int main(int argc, const char* argv[])
+{
+  BenchConfiguration  cfg;
+  UpdateCache         updCache;
+  PrefixCache         prefixCache;
+  ProxyClientMapping  clientMapping;
+  BenchAllocStats     allocs;
+  BenchROA*           roas    = NULL;
+  BenchUpdate*        updates = NULL;
+  SRxDefaultResult    defRes;
+  SRxResult           result;
+  uint32_t            noROAs  = 0;
+  uint32_t            failed;
+  uint32_t            idx;
+  uint64_t            start;
+  int                 ret = 0;
+
+  memset(&cfg, 0, sizeof(BenchConfiguration));
+  cfg.noROAs    = DEFAULT_NO_ROAS;
+  cfg.noUpdates = DEFAULT_NO_UPDATES;
+  cfg.minLen    = DEFAULT_MIN_LEN;
+  cfg.maxLen    = DEFAULT_MAX_LEN;
+  cfg.moas      = DEFAULT_MOAS;
+  cfg.depth     = DEFAULT_DEPTH;
+  cfg.v6Percent = DEFAULT_V6_PERCENT;
+  cfg.seed      = DEFAULT_SEED;
+  cfg.header    = true;
+
+  if (!parseParams(argc, argv, &cfg, &ret))
+  {
+    return ret;
+  }
+
+  setLogMethodToFile(stderr);
+  setLogLevel(LEVEL_ERROR);
+
+  randState = cfg.seed != 0 ? cfg.seed : DEFAULT_SEED;
+  roas = _generateROAs(&cfg, &noROAs);
+  updates = roas != NULL ? _generateUpdates(&cfg, roas, noROAs) : NULL;
+  if (updates == NULL)
+  {
+    printf("ERROR: Not enough memory for the workload!\n");
+    free(roas);
+    return -1;
+  }
+
+  memset(&updCache, 0, sizeof(UpdateCache));
+  memset(&prefixCache, 0, sizeof(PrefixCache));
+  memset(&clientMapping, 0, sizeof(ProxyClientMapping));
+  if (!createUpdateCache(&updCache, _resultChanged, 1, NULL))
+  {
+    printf("ERROR: Could not create the update cache!\n");
+    free(updates);
+    free(roas);
+    return -1;
+  }
+  if (!initializePrefixCache(&prefixCache, &updCache))
+  {
+    printf("ERROR: Could not initialize the prefix cache!\n");
+    releaseUpdateCache(&updCache);
+    free(updates);
+    free(roas);
+    return -1;
+  }
+
+  if (cfg.header)
+  {
+    _printHeader();
+  }
+
+  _snapshotAllocs(&allocs);
+  start = _now();
+  for (idx = 0, failed = 0; idx < noROAs; idx++)
+  {
+    if (!addROAwl(&prefixCache, roas[idx].originAS, &roas[idx].prefix,
+                  roas[idx].maxLen, BENCH_SESSION_ID, BENCH_VAL_CACHE_ID))
+    {
+      failed++;
+    }
+  }
+  _printPhase(&cfg, "addROAwl", noROAs, failed, start, &allocs);
+
+  memset(&defRes, 0, sizeof(SRxDefaultResult));
+  defRes.result.roaResult    = SRx_RESULT_UNDEFINED;
+  defRes.result.bgpsecResult = SRx_RESULT_UNDEFINED;
+  defRes.resSourceROA        = SRxRS_UNKNOWN;
+  defRes.resSourceBGPSEC     = SRxRS_UNKNOWN;
+  _snapshotAllocs(&allocs);
+  start = _now();
+  for (idx = 0, failed = 0; idx < cfg.noUpdates; idx++)
+  {
+    if (storeUpdate(&updCache, BENCH_CLIENT_ID, &clientMapping,
+                    &updates[idx].updateID, &updates[idx].prefix,
+                    updates[idx].originAS, &defRes, NULL) != 1)
+    {
+      failed++;
+    }
+  }
+  _printPhase(&cfg, "storeUpdate", cfg.noUpdates, failed, start, &allocs);
+
+  _snapshotAllocs(&allocs);
+  start = _now();
+  for (idx = 0, failed = 0; idx < cfg.noUpdates; idx++)
+  {
+    if (!requestUpdateValidation(&prefixCache, &updates[idx].updateID,
+                                 &updates[idx].prefix, updates[idx].originAS))
+    {
+      failed++;
+    }
+  }
+  _printPhase(&cfg, "requestUpdateValidation", cfg.noUpdates, failed, start,
+              &allocs);
+
+  // Flip the ROA result of each update, the path result stays untouched.
+  result.bgpsecResult = SRx_RESULT_DONOTUSE;
+  _snapshotAllocs(&allocs);
+  start = _now();
+  for (idx = 0, failed = 0; idx < cfg.noUpdates; idx++)
+  {
+    result.roaResult = (idx & 1) ? SRx_RESULT_INVALID : SRx_RESULT_VALID;
+    if (!modifyUpdateResult(&updCache, &updates[idx].updateID, &result))
+    {
+      failed++;
+    }
+  }
+  _printPhase(&cfg, "modifyUpdateResult", cfg.noUpdates, failed, start,
+              &allocs);
+
+  _snapshotAllocs(&allocs);
+  start = _now();
+  for (idx = 0, failed = 0; idx < noROAs; idx++)
+  {
+    if (!delROAwl(&prefixCache, roas[idx].originAS, &roas[idx].prefix,
+                  roas[idx].maxLen, BENCH_SESSION_ID, BENCH_VAL_CACHE_ID))
+    {
+      failed++;
+    }
+  }
+  _printPhase(&cfg, "delROAwl", noROAs, failed, start, &allocs);
+
+  releasePrefixCache(&prefixCache);
+  releaseUpdateCache(&updCache);
+  free(updates);
+  free(roas);
+
+  return ret;
+}
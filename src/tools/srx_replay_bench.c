@@ -0,0 +1,985 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * In-process replay benchmark of the SRx server. Captured PDU traces are fed
+ * directly into the packet handler of the server connection handler and into
+ * the RPKI/Router protocol decoder, no proxy, validation cache, or network
+ * socket is involved. The RPKI/Router trace is replayed first, then the
+ * SRx-proxy trace. Each phase reports one CSV line with its timing and the
+ * number of allocations made during the phase.
+ *
+ * A trace is the raw byte stream of one connection as received by the server,
+ * the PDUs are framed by their length field. The SRx-proxy trace must start
+ * with the hello PDU of the proxy, it is processed before the measurement
+ * starts and only once. Goodbye PDUs are skipped. The RPKI/Router trace must
+ * contain at least one End of Data PDU.
+ *
+ * The sockets are stubbed at link time (-Wl,--wrap=...), see Makefile.am:
+ * the server socket is never bound, PDUs sent to the proxy are counted and
+ * dropped, and the connection to the validation cache is one end of a unix
+ * socket pair the RPKI/Router trace is written into. The allocations are
+ * counted by wrapping malloc, calloc, realloc and free the same way. The
+ * counters are process wide, use a single command handler thread (default)
+ * for comparable numbers.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code Created
+ * -----------------------------------------------------------------------------
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "server/bgpsec_handler.h"
+#include "server/command_handler.h"
+#include "server/command_queue.h"
+#include "server/configuration.h"
+#include "server/key_cache.h"
+#include "server/prefix_cache.h"
+#include "server/rpki_handler.h"
+#include "server/server_connection_handler.h"
+#include "server/update_cache.h"
+#include "shared/rpki_router.h"
+#include "shared/srx_packets.h"
+#include "util/client_socket.h"
+#include "util/log.h"
+#include "util/server_socket.h"
+#include "util/slist.h"
+
+#define BENCH_NAME            "SRx Replay Benchmark"
+#define BENCH_VERSION         "0.4.1.0"
+
+#define DEFAULT_LOOPS         1
+#define DEFAULT_THREADS       1
+
+/** The host name and port used for the stubbed validation cache. */
+#define REPLAY_RPKI_HOST      "replay"
+#define REPLAY_RPKI_PORT      323
+/** The time (ms) to wait for the handshake and for the End of Data. */
+#define REPLAY_TIMEOUT_MS     10000
+/** The time (ns) between two checks if the queues are drained. */
+#define REPLAY_POLL_NS        100000
+/** Used to convert seconds into nano seconds. */
+#define NSEC_PER_SEC          1000000000ULL
+
+/**
+ * A trace loaded into memory.
+ */
+typedef struct {
+  /** The content of the trace file. */
+  uint8_t* data;
+  /** The size of the trace in bytes. */
+  uint32_t size;
+  /** The number of PDUs. */
+  uint32_t noPDUs;
+  /** The length of the largest PDU. */
+  uint32_t maxPDU;
+  /** The number of End of Data PDUs (RPKI/Router trace only). */
+  uint32_t noEndOfData;
+} ReplayTrace;
+
+/**
+ * The parameters of the replay.
+ */
+typedef struct {
+  /** The file of the SRx-proxy trace or NULL. */
+  const char* proxyTrace;
+  /** The file of the RPKI/Router trace or NULL. */
+  const char* rpkiTrace;
+  /** The number of times the SRx-proxy trace is replayed. */
+  uint32_t    loops;
+  /** The number of command handler threads. */
+  uint8_t     threads;
+  /** Print the CSV header. */
+  bool        header;
+} BenchConfiguration;
+
+/**
+ * The allocation counters, see the malloc wrappers below.
+ */
+typedef struct {
+  /** The number of malloc, calloc and realloc calls. */
+  uint64_t allocs;
+  /** The number of free calls with a pointer other than NULL. */
+  uint64_t frees;
+  /** The number of bytes requested. */
+  uint64_t bytes;
+} BenchAllocStats;
+
+/** The allocation counters of the process. */
+static BenchAllocStats allocStats = { 0, 0, 0 };
+/** The number of PDUs sent to the proxy. */
+static volatile uint64_t sentPDUs = 0;
+/** The end of the socket pair the RPKI/Router trace is written into. */
+static int rpkiPeerFD = -1;
+/** The number of End of Data PDUs processed. */
+static volatile uint32_t noEndOfData = 0;
+/** The End of Data callback of the RPKI handler. */
+static void (*handleEndOfData)(uint32_t valCacheID, uint16_t sessionID,
+                               void* user) = NULL;
+
+/** The server components, the result callbacks need the command handler. */
+static Configuration           config;
+static UpdateCache             updCache;
+static PrefixCache             prefixCache;
+static KeyCache                keyCache;
+static RPKIHandler             rpkiHandler;
+static BGPSecHandler           bgpsecHandler;
+static ServerConnectionHandler svrConnHandler;
+static CommandHandler          cmdHandler;
+static CommandQueue            cmdQueue;
+
+/** Declared in server_connection_handler.c */
+void _handlePacket(ServerSocket* svrSock, ServerClient* client,
+                   void* packet, PacketLength length, void* srvConHandler);
+
+////////////////////////////////////////////////////////////////////////////////
+// ALLOCATION COUNTERS
+////////////////////////////////////////////////////////////////////////////////
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void  __real_free(void* ptr);
+
+/**
+ * Count the allocation and call the real malloc.
+ *
+ * @param size The number of bytes.
+ *
+ * @return The allocated memory.
+ */
+void* __wrap_malloc(size_t size)
+{
+  __sync_add_and_fetch(&allocStats.allocs, 1);
+  __sync_add_and_fetch(&allocStats.bytes, size);
+  return __real_malloc(size);
+}
+
+/**
+ * Count the allocation and call the real calloc.
+ *
+ * @param nmemb The number of elements.
+ * @param size The size of each element.
+ *
+ * @return The allocated memory.
+ */
+void* __wrap_calloc(size_t nmemb, size_t size)
+{
+  __sync_add_and_fetch(&allocStats.allocs, 1);
+  __sync_add_and_fetch(&allocStats.bytes, nmemb * size);
+  return __real_calloc(nmemb, size);
+}
+
+/**
+ * Count the allocation and call the real realloc.
+ *
+ * @param ptr The memory to be resized.
+ * @param size The new number of bytes.
+ *
+ * @return The re-allocated memory.
+ */
+void* __wrap_realloc(void* ptr, size_t size)
+{
+  __sync_add_and_fetch(&allocStats.allocs, 1);
+  __sync_add_and_fetch(&allocStats.bytes, size);
+  return __real_realloc(ptr, size);
+}
+
+/**
+ * Count the release and call the real free.
+ *
+ * @param ptr The memory to be released.
+ */
+void __wrap_free(void* ptr)
+{
+  if (ptr != NULL)
+  {
+    __sync_add_and_fetch(&allocStats.frees, 1);
+  }
+  __real_free(ptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SOCKET STUBS
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The server socket is not bound, no proxy can connect.
+ *
+ * @param self The server socket.
+ * @param port Not used.
+ * @param verbose Not used.
+ *
+ * @return true
+ */
+bool __wrap_createServerSocket(ServerSocket* self, int port, bool verbose)
+{
+  memset(self, 0, sizeof(ServerSocket));
+  self->serverFD = -1;
+  self->shmFD    = -1;
+  initSList(&self->cthreads);
+  return true;
+}
+
+/**
+ * Count the PDU and drop it.
+ *
+ * @param self The server socket.
+ * @param client The client.
+ * @param packet The PDU.
+ * @param length The length of the PDU.
+ *
+ * @return true
+ */
+bool __wrap_sendPacketToClient(ServerSocket* self, ServerClient* client,
+                               void* packet, size_t length)
+{
+  __sync_add_and_fetch(&sentPDUs, 1);
+  return true;
+}
+
+/**
+ * The replayed connection is never closed.
+ *
+ * @param self The server socket.
+ * @param client The client.
+ *
+ * @return 0
+ */
+int __wrap_closeClientConnection(ServerSocket* self, ServerClient* client)
+{
+  return 0;
+}
+
+/**
+ * Connect the client to one end of a unix socket pair, the trace is written
+ * into the other end.
+ *
+ * @param self The client socket.
+ * @param host Not used.
+ * @param port Not used.
+ * @param failNoServer Not used.
+ * @param type The type of the socket.
+ * @param allowToClose Indicates if the socket is allowed to be closed.
+ *
+ * @return false if the socket pair could not be created.
+ */
+bool __wrap_createClientSocket(ClientSocket* self, const char* host, int port,
+                               bool failNoServer, ClientSocketType type,
+                               bool allowToClose)
+{
+  int fds[2];
+
+  memset(self, 0, sizeof(ClientSocket));
+  self->clientFD = -1;
+  self->oldFD    = -1;
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+  {
+    RAISE_SYS_ERROR("Could not create the socket pair of the validation "
+                    "cache!");
+    return false;
+  }
+  self->type        = type;
+  self->clientFD    = fds[0];
+  self->oldFD       = fds[0];
+  self->canBeClosed = allowToClose;
+  rpkiPeerFD        = fds[1];
+  return true;
+}
+
+/**
+ * Close the client end of the socket pair.
+ *
+ * @param self The client socket.
+ */
+void __wrap_closeClientSocket(ClientSocket* self)
+{
+  if (self->clientFD != -1)
+  {
+    close(self->clientFD);
+    self->clientFD = -1;
+  }
+}
+
+/**
+ * The replayed validation cache cannot be reconnected.
+ *
+ * @param self The client socket.
+ * @param delay Not used.
+ * @param max_attempts Not used.
+ *
+ * @return false
+ */
+bool __wrap_reconnectToServer(ClientSocket* self, int delay, int max_attempts)
+{
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// REPLAY
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Return the monotonic time in nano seconds.
+ *
+ * @return The time in nano seconds.
+ */
+static uint64_t _now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * Sleep for the poll interval.
+ */
+static void _poll()
+{
+  struct timespec ts = { 0, REPLAY_POLL_NS };
+  nanosleep(&ts, NULL);
+}
+
+/**
+ * Load the trace and check the framing of its PDUs. Both the SRx-proxy PDUs
+ * and the RPKI/Router PDUs carry their total length at offset 4.
+ *
+ * @param fileName The trace file.
+ * @param trace (out) The loaded trace.
+ *
+ * @return false if the trace could not be loaded.
+ */
+static bool _loadTrace(const char* fileName, ReplayTrace* trace)
+{
+  FILE*    file = fopen(fileName, "rb");
+  long     size;
+  uint32_t pos;
+  uint32_t length;
+
+  memset(trace, 0, sizeof(ReplayTrace));
+  if (file == NULL)
+  {
+    printf("ERROR: Cannot open the trace '%s'!\n", fileName);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  trace->data = size > 0 ? malloc(size) : NULL;
+  if (   (trace->data == NULL)
+      || (fread(trace->data, 1, size, file) != (size_t)size))
+  {
+    printf("ERROR: Cannot read the trace '%s'!\n", fileName);
+    fclose(file);
+    free(trace->data);
+    trace->data = NULL;
+    return false;
+  }
+  fclose(file);
+  trace->size = (uint32_t)size;
+
+  for (pos = 0; pos < trace->size; pos += length)
+  {
+    if (trace->size - pos < sizeof(RPKICommonHeader))
+    {
+      break;
+    }
+    length = ntohl(((RPKICommonHeader*)(trace->data + pos))->length);
+    if ((length < sizeof(RPKICommonHeader)) || (length > trace->size - pos))
+    {
+      break;
+    }
+    if (((RPKICommonHeader*)(trace->data + pos))->type
+        == PDU_TYPE_END_OF_DATA)
+    {
+      trace->noEndOfData++;
+    }
+    if (length > trace->maxPDU)
+    {
+      trace->maxPDU = length;
+    }
+    trace->noPDUs++;
+  }
+  if (pos != trace->size)
+  {
+    printf("ERROR: Trace '%s' has an invalid PDU at offset %u!\n", fileName,
+           pos);
+    free(trace->data);
+    trace->data = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Count the End of Data and hand it to the RPKI handler.
+ *
+ * @param valCacheID The ID of the validation cache.
+ * @param sessionID The session ID.
+ * @param user The validation cache.
+ */
+static void _endOfData(uint32_t valCacheID, uint16_t sessionID, void* user)
+{
+  handleEndOfData(valCacheID, sessionID, user);
+  __sync_add_and_fetch(&noEndOfData, 1);
+}
+
+/**
+ * Called by the update cache for each changed result.
+ *
+ * @param result The changed result.
+ */
+static void _resultChanged(SRxValidationResult* result)
+{
+  broadcastResult(&cmdHandler, result);
+}
+
+/**
+ * Called by the update cache for each batch of changed results.
+ *
+ * @param results The changed results.
+ * @param count The number of results.
+ */
+static void _resultsChanged(SRxValidationResult* results, uint32_t count)
+{
+  broadcastResults(&cmdHandler, results, count);
+}
+
+/**
+ * Create all components of the server the way the server does, the sockets
+ * are stubbed.
+ *
+ * @param cfg The replay parameters.
+ *
+ * @return false if a component could not be created.
+ */
+static bool _setupServer(BenchConfiguration* cfg)
+{
+  const char* rpkiHosts[1] = { REPLAY_RPKI_HOST };
+  int         rpkiPorts[1] = { REPLAY_RPKI_PORT };
+
+  initConfiguration(&config);
+  config.mode_no_sendqueue     = true;
+  config.mode_no_receivequeue  = true;
+  config.commandHandlerThreads = cfg->threads;
+
+  if (   !createUpdateCache(&updCache, _resultChanged, config.expectedProxies,
+                            &config)
+      || !initializePrefixCache(&prefixCache, &updCache)
+      || !createKeyCache(&keyCache, &updCache, NULL, NULL))
+  {
+    printf("ERROR: Could not create the caches!\n");
+    return false;
+  }
+  setUpdateResultsChangedCallback(&updCache, _resultsChanged);
+
+  if (!createRPKIHandler(&rpkiHandler, &prefixCache, &keyCache, rpkiHosts,
+                         rpkiPorts, 1, NULL, 0))
+  {
+    printf("ERROR: Could not create the RPKI handler!\n");
+    return false;
+  }
+  handleEndOfData = rpkiHandler.caches[0].rrclParams.endOfDataCallback;
+  rpkiHandler.caches[0].rrclParams.endOfDataCallback = _endOfData;
+
+  if (   !createBGPSecHandler(&bgpsecHandler, &keyCache, config.bgpsec_host,
+                              config.bgpsec_port, config.bgpsecWorkers,
+                              config.bgpsecMemoSize)
+      || !createServerConnectionHandler(&svrConnHandler, &updCache, &config)
+      || !initializeCommandHandler(&cmdHandler, &config, &svrConnHandler,
+                                   &bgpsecHandler, &rpkiHandler, &updCache)
+      || !initializeCommandQueue(&cmdQueue, config.commandHandlerThreads)
+      || !startProcessingCommands(&cmdHandler, &cmdQueue))
+  {
+    printf("ERROR: Could not create the handlers!\n");
+    return false;
+  }
+  svrConnHandler.cmdQueue = &cmdQueue;
+
+  return true;
+}
+
+/**
+ * Release all components of the server.
+ */
+static void _releaseServer()
+{
+  stopProcessingCommands(&cmdHandler);
+  releaseCommandQueue(&cmdQueue);
+  releaseServerConnectionHandler(&svrConnHandler);
+  releaseCommandHandler(&cmdHandler);
+  releaseBGPSecHandler(&bgpsecHandler);
+  releaseRPKIHandler(&rpkiHandler);
+  if (rpkiPeerFD != -1)
+  {
+    close(rpkiPeerFD);
+    rpkiPeerFD = -1;
+  }
+  releaseKeyCache(&keyCache);
+  releasePrefixCache(&prefixCache);
+  releaseUpdateCache(&updCache);
+  releaseConfiguration(&config);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// REPORT
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Take a snapshot of the allocation counters.
+ *
+ * @param stats (out) The snapshot.
+ */
+static void _snapshotAllocs(BenchAllocStats* stats)
+{
+  stats->allocs = __sync_add_and_fetch(&allocStats.allocs, 0);
+  stats->frees  = __sync_add_and_fetch(&allocStats.frees, 0);
+  stats->bytes  = __sync_add_and_fetch(&allocStats.bytes, 0);
+}
+
+/**
+ * Print the CSV header.
+ */
+static void _printHeader()
+{
+  printf("phase,threads,loops,pdus,bytes,total_ns,ns_per_pdu,pdus_per_sec,"
+         "allocs,allocs_per_pdu,frees,alloc_bytes,sent_pdus\n");
+}
+
+/**
+ * Print the CSV line of one phase.
+ *
+ * @param cfg The replay parameters.
+ * @param phase The name of the phase.
+ * @param loops The number of times the trace was replayed.
+ * @param pdus The number of PDUs replayed.
+ * @param bytes The number of bytes replayed.
+ * @param total The duration (ns) of the phase.
+ * @param allocs The allocation counters at the start of the phase.
+ * @param end The allocation counters at the end of the phase.
+ * @param sent The number of PDUs sent to the proxy during the phase.
+ */
+static void _printPhase(BenchConfiguration* cfg, const char* phase,
+                        uint32_t loops, uint64_t pdus, uint64_t bytes,
+                        uint64_t total, BenchAllocStats* allocs,
+                        BenchAllocStats* end, uint64_t sent)
+{
+  printf("%s,%u,%u,%llu,%llu,%llu,%.1f,%.0f,%llu,%.2f,%llu,%llu,%llu\n",
+         phase, cfg->threads, loops, (unsigned long long)pdus,
+         (unsigned long long)bytes, (unsigned long long)total,
+         pdus > 0 ? (double)total / pdus : 0.0,
+         total > 0 ? (double)pdus * NSEC_PER_SEC / total : 0.0,
+         (unsigned long long)(end->allocs - allocs->allocs),
+         pdus > 0 ? (double)(end->allocs - allocs->allocs) / pdus : 0.0,
+         (unsigned long long)(end->frees - allocs->frees),
+         (unsigned long long)(end->bytes - allocs->bytes),
+         (unsigned long long)sent);
+  fflush(stdout);
+}
+
+/**
+ * Replay the RPKI/Router trace. The trace is written into the socket pair of
+ * the validation cache, the phase ends once the last End of Data is applied.
+ *
+ * @param cfg The replay parameters.
+ * @param trace The RPKI/Router trace.
+ *
+ * @return false if the trace could not be replayed.
+ */
+static bool _replayRPKI(BenchConfiguration* cfg, ReplayTrace* trace)
+{
+  BenchAllocStats allocs;
+  BenchAllocStats end;
+  uint64_t        start;
+  uint64_t        sent;
+  uint64_t        waited = 0;
+  uint32_t        pos;
+  ssize_t         written;
+  uint8_t         drain[256];
+
+  _snapshotAllocs(&allocs);
+  sent  = sentPDUs;
+  start = _now();
+  for (pos = 0; pos < trace->size; pos += (uint32_t)written)
+  {
+    written = write(rpkiPeerFD, trace->data + pos, trace->size - pos);
+    if (written <= 0)
+    {
+      printf("ERROR: Could not write the RPKI/Router trace!\n");
+      return false;
+    }
+  }
+  while (noEndOfData < trace->noEndOfData)
+  {
+    if (waited++ > (uint64_t)REPLAY_TIMEOUT_MS * 1000000 / REPLAY_POLL_NS)
+    {
+      printf("ERROR: The End of Data of the RPKI/Router trace was not "
+             "processed!\n");
+      return false;
+    }
+    _poll();
+  }
+  start = _now() - start;
+  _snapshotAllocs(&end);
+  _printPhase(cfg, "rpki", 1, trace->noPDUs, trace->size, start, &allocs,
+              &end, sentPDUs - sent);
+
+  // Drop the queries of the client.
+  while (recv(rpkiPeerFD, drain, sizeof(drain), MSG_DONTWAIT) > 0) {}
+
+  return true;
+}
+
+/**
+ * Replay the SRx-proxy trace. The hello PDU is handled before the measurement
+ * starts, then the trace is replayed the configured number of times. The
+ * phase handlePacket covers the calls of the packet handler, the phase
+ * processed ends once all queued commands are processed.
+ *
+ * @param cfg The replay parameters.
+ * @param trace The SRx-proxy trace.
+ *
+ * @return false if the trace could not be replayed.
+ */
+static bool _replayProxy(BenchConfiguration* cfg, ReplayTrace* trace)
+{
+  ClientThread*         client;
+  SRXPROXY_BasicHeader* bhdr   = (SRXPROXY_BasicHeader*)trace->data;
+  uint8_t*              buffer = malloc(trace->maxPDU);
+  BenchAllocStats       allocs;
+  BenchAllocStats       handled;
+  BenchAllocStats       processed;
+  uint64_t              start;
+  uint64_t              handledTime;
+  uint64_t              handledSent;
+  uint64_t              sent;
+  uint64_t              waited = 0;
+  uint64_t              pdus   = 0;
+  uint64_t              bytes  = 0;
+  uint32_t              pos;
+  uint32_t              length;
+  uint32_t              loop;
+  bool                  retVal = false;
+
+  client = calloc(1, sizeof(ClientThread));
+  if ((buffer == NULL) || (client == NULL))
+  {
+    printf("ERROR: Not enough memory to replay the SRx-proxy trace!\n");
+    free(buffer);
+    free(client);
+    return false;
+  }
+  if ((trace->noPDUs == 0) || (bhdr->type != PDU_SRXPROXY_HELLO))
+  {
+    printf("ERROR: The SRx-proxy trace does not start with a hello PDU!\n");
+    free(buffer);
+    free(client);
+    return false;
+  }
+
+  // Connect the client and perform the handshake.
+  client->active   = true;
+  client->clientFD = -1;
+  client->shmFD    = -1;
+  client->svrSock  = &svrConnHandler.svrSock;
+  initMutex(&client->writeMutex);
+  appendDataToSList(&svrConnHandler.clients, client);
+
+  length = ntohl(bhdr->length);
+  memcpy(buffer, trace->data, length);
+  _handlePacket(&svrConnHandler.svrSock, client, buffer, length,
+                &svrConnHandler);
+  while (!client->initialized)
+  {
+    if (waited++ > (uint64_t)REPLAY_TIMEOUT_MS * 1000000 / REPLAY_POLL_NS)
+    {
+      printf("ERROR: The handshake of the SRx-proxy trace failed!\n");
+      break;
+    }
+    _poll();
+  }
+
+  if (client->initialized)
+  {
+    _snapshotAllocs(&allocs);
+    sent  = sentPDUs;
+    start = _now();
+    for (loop = 0; loop < cfg->loops; loop++)
+    {
+      for (pos = ntohl(bhdr->length); pos < trace->size; pos += length)
+      {
+        length = ntohl(((SRXPROXY_BasicHeader*)(trace->data + pos))->length);
+        if (   (trace->data[pos] == PDU_SRXPROXY_HELLO)
+            || (trace->data[pos] == PDU_SRXPROXY_GOODBYE))
+        {
+          continue;
+        }
+        // The PDU is copied the way it is received.
+        memcpy(buffer, trace->data + pos, length);
+        _handlePacket(&svrConnHandler.svrSock, client, buffer, length,
+                      &svrConnHandler);
+        pdus++;
+        bytes += length;
+      }
+    }
+    handledTime = _now() - start;
+    handledSent = sentPDUs - sent;
+    _snapshotAllocs(&handled);
+
+    while (   (getTotalQueueSize(&cmdQueue) > 0)
+           || (getBGPSecQueueSize(&bgpsecHandler) > 0))
+    {
+      _poll();
+    }
+    start = _now() - start;
+    _snapshotAllocs(&processed);
+
+    // Both phases start with the first PDU.
+    _printPhase(cfg, "handlePacket", cfg->loops, pdus, bytes, handledTime,
+                &allocs, &handled, handledSent);
+    _printPhase(cfg, "processed", cfg->loops, pdus, bytes, start, &allocs,
+                &processed, sentPDUs - sent);
+    retVal = true;
+  }
+
+  deleteFromSList(&svrConnHandler.clients, client);
+  releaseMutex(&client->writeMutex);
+  free(client);
+  free(buffer);
+
+  return retVal;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PROGRAM
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Print the program syntax.
+ *
+ * @param prgName The program name.
+ */
+static void syntax(const char* prgName)
+{
+  printf ("%s Version %s\n", BENCH_NAME, BENCH_VERSION);
+  printf ("Syntax: %s [options]\n", prgName);
+  printf ("  options:\n");
+  printf ("    -r <file>    The RPKI/Router trace, replayed first.\n");
+  printf ("    -p <file>    The SRx-proxy trace, it starts with the hello\n"
+          "                 PDU of the proxy.\n");
+  printf ("    -l <count>   The number of times the SRx-proxy trace is\n"
+          "                 replayed (default: %u).\n", DEFAULT_LOOPS);
+  printf ("    -t <count>   The number of command handler threads\n"
+          "                 (default: %u).\n", DEFAULT_THREADS);
+  printf ("    -n           Do not print the CSV header.\n");
+  printf ("    -h           This help.\n");
+}
+
+/**
+ * Parses the program parameters and set the configuration. This function
+ * returns true if the program can continue and the exit Value.
+ *
+ * @param argc    The argument count
+ * @param argv    The Argument array
+ * @param cfg     The program configuration
+ * @param exitVal The exit value pointer if needed
+ *
+ * @return true if the program can continue, false if it should be ended.
+ */
+static bool parseParams(int argc, const char* argv[],
+                        BenchConfiguration* cfg, int* exitVal)
+{
+  bool  retVal = true;
+  int   eVal   = 0;
+  bool  doHelp = false;
+  char* arg    = NULL;
+  char* value  = NULL;
+  int   idx    = 0;
+
+  for (idx = 1; (idx < argc) && !doHelp; idx++)
+  {
+    arg = (char*)argv[idx];
+    if ((arg[0] != '-') || (arg[1] == '\0'))
+    {
+      printf ("ERROR: Invalid parameter '%s'\n", arg);
+      doHelp = true;
+      retVal = false;
+      eVal   = 1;
+      continue;
+    }
+    arg++;
+    switch (arg[0])
+    {
+      case 'h':
+      case 'H':
+      case '?':
+        doHelp = true;
+        retVal = false;
+        continue;
+      case 'n':
+        cfg->header = false;
+        continue;
+      default:
+        break;
+    }
+
+    // All other parameters require a value
+    if ((idx + 1) >= argc)
+    {
+      printf ("ERROR: Value of parameter '-%s' missing!\n", arg);
+      doHelp = true;
+      retVal = false;
+      eVal   = 1;
+      continue;
+    }
+    value = (char*)argv[++idx];
+    switch (arg[0])
+    {
+      case 'r':
+        cfg->rpkiTrace = value;
+        break;
+      case 'p':
+        cfg->proxyTrace = value;
+        break;
+      case 'l':
+        cfg->loops = strtoul(value, NULL, 10);
+        break;
+      case 't':
+        cfg->threads = (uint8_t)strtoul(value, NULL, 10);
+        break;
+      default:
+        printf ("ERROR: Invalid parameter '-%s'\n", arg);
+        doHelp = true;
+        retVal = false;
+        eVal   = 1;
+        break;
+    }
+  }
+
+  if (doHelp)
+  {
+    syntax(argv[0]);
+  }
+  else if ((cfg->rpkiTrace == NULL) && (cfg->proxyTrace == NULL))
+  {
+    printf ("ERROR: At least one trace is required!\n");
+    retVal = false;
+    eVal   = 1;
+  }
+  else if (   (cfg->loops == 0) || (cfg->threads == 0)
+           || (cfg->threads > MAX_COMMAND_QUEUE_LANES))
+  {
+    printf ("ERROR: The loops must not be 0, the threads must be within 1 "
+            "and %u!\n", MAX_COMMAND_QUEUE_LANES);
+    retVal = false;
+    eVal   = 1;
+  }
+
+  if (exitVal != NULL)
+  {
+    *exitVal = eVal;
+  }
+
+  return retVal;
+}
+
+/**
+ * The main function of the replay benchmark.
+ *
+ * @param argc The number of arguments
+ * @param argv The arguments
+ *
+ * @return 0 if the traces were replayed, otherwise 1 or -1.
+ */
+int main(int argc, const char* argv[])
+{
+  BenchConfiguration cfg;
+  ReplayTrace        rpkiTrace;
+  ReplayTrace        proxyTrace;
+  int                ret = 0;
+
+  memset(&cfg, 0, sizeof(BenchConfiguration));
+  cfg.loops   = DEFAULT_LOOPS;
+  cfg.threads = DEFAULT_THREADS;
+  cfg.header  = true;
+
+  if (!parseParams(argc, argv, &cfg, &ret))
+  {
+    return ret;
+  }
+
+  setLogMethodToFile(stderr);
+  setLogLevel(LEVEL_ERROR);
+
+  memset(&rpkiTrace, 0, sizeof(ReplayTrace));
+  memset(&proxyTrace, 0, sizeof(ReplayTrace));
+  if (   ((cfg.rpkiTrace != NULL) && !_loadTrace(cfg.rpkiTrace, &rpkiTrace))
+      || ((cfg.proxyTrace != NULL)
+          && !_loadTrace(cfg.proxyTrace, &proxyTrace)))
+  {
+    free(rpkiTrace.data);
+    return -1;
+  }
+  if ((cfg.rpkiTrace != NULL) && (rpkiTrace.noEndOfData == 0))
+  {
+    printf("ERROR: The RPKI/Router trace does not contain an End of Data!\n");
+    free(rpkiTrace.data);
+    free(proxyTrace.data);
+    return -1;
+  }
+
+  // A partially created server is not released, the process ends anyway.
+  if (!_setupServer(&cfg))
+  {
+    ret = -1;
+  }
+  else
+  {
+    if (cfg.header)
+    {
+      _printHeader();
+    }
+    if (   ((cfg.rpkiTrace != NULL) && !_replayRPKI(&cfg, &rpkiTrace))
+        || ((cfg.proxyTrace != NULL) && !_replayProxy(&cfg, &proxyTrace)))
+    {
+      ret = 1;
+    }
+    _releaseServer();
+  }
+
+  free(rpkiTrace.data);
+  free(proxyTrace.data);
+
+  return ret;
+}
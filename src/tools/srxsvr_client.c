@@ -22,10 +22,13 @@
  *
  * This program allows to test the SRX server implementation.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Added the MRT replay (replay) and the notification latency of
+ *              the replayed requests to the statistics framework.
  * 0.3.0.10 - 2015/11/10 - oborchert
  *            * Added initialization of variables in runScript
  *            * Removed unused variables from doVerify
@@ -103,6 +106,7 @@
 #include <time.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <arpa/inet.h>
 #include <sys/select.h>
 #include <readline/readline.h>
 #include <readline/history.h>
@@ -138,6 +142,7 @@
 #define CMD_SIGN       "sign"
 #define CMD_DELETE     "delete"
 #define CMD_RUN        "run"
+#define CMD_REPLAY     "replay"
 
 #define CMD_STAT_START             "stat-start"
 #define CMD_STAT_STOP              "stat-stop"
@@ -151,19 +156,60 @@
 #define CMD_RESET_PROXY                  "RESET_PROXY"
 #define CMD_USE_NON_BLOCKING_SOCKET_TYPE "NON_BLOCKING_SOCKET"
 
+#define NSEC_PER_SEC      1000000000ULL
+
+// MRT replay - since 0.4.1.0
+/** The maximum number of proxies used by the replay, one per MRT peer. */
+#define REPLAY_MAX_PROXIES 64
+/** The number of requests a replay proxy sends with one batch. */
+#define REPLAY_BATCH       256
+/** The number of ASes of the AS paths of one batch. */
+#define REPLAY_POOL_SIZE   (REPLAY_BATCH * 16)
+/** The maximum number of ASes of a replayed AS path. */
+#define REPLAY_MAX_HOPS    255
+/** The maximum number of replayed requests without receipt. */
+#define REPLAY_WINDOW      20000
+/** Seconds the replay waits for the outstanding receipts. */
+#define REPLAY_TIMEOUT     60
+/** The replay does not pause for less than a millisecond (ns). */
+#define REPLAY_MIN_PAUSE   1000000ULL
+
+// MRT format (RFC 6396)
+#define MRT_HEADER_LEN               12
+#define MRT_TABLE_DUMP_V2            13
+#define MRT_BGP4MP                   16
+#define MRT_BGP4MP_ET                17
+#define MRT_PEER_INDEX_TABLE          1
+#define MRT_RIB_IPV4_UNICAST          2
+#define MRT_RIB_IPV6_UNICAST          4
+#define MRT_BGP4MP_MESSAGE            1
+#define MRT_BGP4MP_MESSAGE_AS4        4
+#define MRT_BGP4MP_MESSAGE_LOCAL      6
+#define MRT_BGP4MP_MESSAGE_AS4_LOCAL  7
+#define MRT_PEER_TYPE_IPV6         0x01
+#define MRT_PEER_TYPE_AS4          0x02
+#define MRT_AFI_IPV6                  2
+#define MRT_SAFI_UNICAST              1
+#define MRT_ATTR_EXT_LENGTH        0x10
+#define MRT_ATTR_AS_PATH              2
+#define MRT_ATTR_MP_REACH_NLRI       14
+#define MRT_ATTR_AS4_PATH            17
+#define MRT_AS_SEQUENCE               2
+#define BGP_MSG_UPDATE                2
+
 // For readline Code Completion
 // since 0.3.0
 static char* cmd_code[] = {
              CMD_QUIT, CMD_EXIT, CMD_HELP, CMD_CREDITS,
              CMD_CONNECT, CMD_DISCONNECT, CMD_RECONNECT,
              CMD_ADD_PEER, CMD_DEL_PEER, CMD_VERIFY, CMD_SIGN, CMD_DELETE, 
-             CMD_RUN, 
+             CMD_RUN, CMD_REPLAY,
              CMD_STAT_START, CMD_STAT_STOP, CMD_STAT_INIT, 
              CMD_STAT_MARK_NO_RECEIPT, CMD_STAT_MARK_WITH_RECEIPT, 
              CMD_STAT_EXIT_ON_MARK, CMD_STAT_PRINT, 
              CMD_LOG_LEVEL, CMD_RESET_PROXY, CMD_USE_NON_BLOCKING_SOCKET_TYPE
 };
-static uint32_t cmd_code_len = 23; // 23 commands in the array above
+static uint32_t cmd_code_len = 24; // 24 commands in the array above
 
 // Indicates the socket type of the proxy
 static bool isBlocking = true;
@@ -172,6 +218,9 @@ static bool isBlocking = true;
 /** See writeLog. */
 static bool keepGoing    = true;
 static SRxProxy* proxy   = NULL;
+/** The SRx server of the last connect, used by the replay. */
+static char      lastHost[256] = DEFAULT_SERVER;
+static uint32_t  lastPort      = DEFAULT_PORT;
 static LogLevel logLevel = LEVEL_ERROR;
 
 // Forward declaration
@@ -200,6 +249,91 @@ static bool     stat_need_init = true;
 static bool     stat_exit_on_mark = false;
 static struct timespec stat_startTime;
 static struct timespec stat_stopTime;
+/** The notification latency (ns) of the replayed requests, see fstatAddLatency.
+ * Protected by stat_mutex. */
+static uint64_t* stat_latency = NULL;
+static uint32_t  stat_noLatency = 0;
+static uint32_t  stat_latencyCapacity = 0;
+static pthread_mutex_t stat_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Record the time between sending a request and receiving its receipt.
+ *
+ * @param latency The latency in nano seconds.
+ *
+ * @since 0.4.1.0
+ */
+void fstatAddLatency(uint64_t latency)
+{
+  uint64_t* newLatency;
+  uint32_t  newCapacity;
+
+  pthread_mutex_lock(&stat_mutex);
+  if (stat_noLatency == stat_latencyCapacity)
+  {
+    newCapacity = stat_latencyCapacity == 0 ? 65536 : stat_latencyCapacity * 2;
+    newLatency  = realloc(stat_latency, newCapacity * sizeof(uint64_t));
+    if (newLatency != NULL)
+    {
+      stat_latency         = newLatency;
+      stat_latencyCapacity = newCapacity;
+    }
+  }
+  if (stat_noLatency < stat_latencyCapacity)
+  {
+    stat_latency[stat_noLatency++] = latency;
+  }
+  pthread_mutex_unlock(&stat_mutex);
+}
+
+/**
+ * Compare two latencies for qsort.
+ *
+ * @param a The first latency.
+ * @param b The second latency.
+ *
+ * @return -1, 0, or 1
+ *
+ * @since 0.4.1.0
+ */
+static int fstatCmpLatency(const void* a, const void* b)
+{
+  uint64_t la = *(const uint64_t*)a;
+  uint64_t lb = *(const uint64_t*)b;
+
+  return la < lb ? -1 : (la > lb ? 1 : 0);
+}
+
+/**
+ * Print the minimum, average, percentiles, and maximum of the recorded
+ * notification latency.
+ *
+ * @since 0.4.1.0
+ */
+void fstatPrintLatency()
+{
+  uint64_t sum = 0;
+  uint32_t idx;
+
+  pthread_mutex_lock(&stat_mutex);
+  if (stat_noLatency > 0)
+  {
+    qsort(stat_latency, stat_noLatency, sizeof(uint64_t), fstatCmpLatency);
+    for (idx = 0; idx < stat_noLatency; idx++)
+    {
+      sum += stat_latency[idx];
+    }
+    #define LAT_MS(IDX) (stat_latency[IDX] / 1000000.0)
+    printf("\tNotification latency of %u receipts (ms): min %.3f, avg %.3f, "
+           "p50 %.3f, p99 %.3f, max %.3f\n", stat_noLatency, LAT_MS(0),
+           sum / 1000000.0 / stat_noLatency,
+           LAT_MS((uint64_t)(stat_noLatency - 1) * 50 / 100),
+           LAT_MS((uint64_t)(stat_noLatency - 1) * 99 / 100),
+           LAT_MS(stat_noLatency - 1));
+  }
+  pthread_mutex_unlock(&stat_mutex);
+}
+
 
 /**
  * Increments the notification counter. This number contains the notifications
@@ -278,6 +412,9 @@ void fstatInitializeStatistics(bool addHistory)
     stat_stopTime.tv_sec  = stat_startTime.tv_sec;
     stat_stopTime.tv_nsec = stat_startTime.tv_nsec;
     stat_need_init = false;
+    pthread_mutex_lock(&stat_mutex);
+    stat_noLatency = 0;
+    pthread_mutex_unlock(&stat_mutex);
   }
   if (addHistory)
   {
@@ -408,6 +545,7 @@ void fstatGetStatistics(bool addHistory)
   buffPtr += sprintf (buffPtr, "\tTotal processing time: %f sec.\n", 
                      totalElapsedTimeSec);
   printf("%s", buffer);
+  fstatPrintLatency();
         
   if (addHistory)
   {
@@ -1163,6 +1301,9 @@ void doConnect(bool log, char** argPtr)
   {
     proxy->proxyID = proxyID;
   }
+  snprintf(lastHost, sizeof(lastHost), "%s",
+           host == NULL ? DEFAULT_SERVER : host);
+  lastPort  = port;
   connected = connectToSRx(proxy, host == NULL ? DEFAULT_SERVER : host, port, 
                            SRX_DEFAULT_HANDSHAKE_TIMEOUT, !isBlocking);
   printf ("Connection to %s %s\n", 
@@ -1512,6 +1653,1092 @@ void doDelete(bool log, char** argPtr)
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// MRT replay - Since 0.4.1.0
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * One proxy of the replay. It sends the announcements of one or more MRT
+ * peers in batches.
+ */
+typedef struct {
+  /** The proxy instance. */
+  SRxProxy*        proxy;
+  /** The pending requests. */
+  SRxVerifyRequest requests[REPLAY_BATCH];
+  /** The prefixes of the pending requests. */
+  IPPrefix         prefixes[REPLAY_BATCH];
+  /** The AS paths of the pending requests. */
+  BGPSecData       bgpsec[REPLAY_BATCH];
+  /** The number of pending requests. */
+  uint32_t         noRequests;
+  /** The ASes of the pending AS paths in network format. */
+  uint32_t         pathPool[REPLAY_POOL_SIZE];
+  /** The number of ASes stored in the path pool. */
+  uint32_t         poolSize;
+} ReplayProxy;
+
+/** An MRT peer and the proxy its announcements are replayed with. */
+typedef struct {
+  /** The address of the peer. */
+  uint8_t      addr[16];
+  /** true if the peer address is an IPv6 address. */
+  bool         isV6;
+  /** The AS of the peer. */
+  uint32_t     peerAS;
+  /** The proxy of the peer. */
+  ReplayProxy* rProxy;
+} ReplayPeer;
+
+/** The state of the replay. */
+static struct {
+  /** Protects the send times and the counters. */
+  pthread_mutex_t  mutex;
+  /** Signaled with each receipt or failure. */
+  pthread_cond_t   cond;
+  /** The send time (ns) of each request, indexed by localID - 1. */
+  uint64_t*        sendTime;
+  uint32_t         sendCapacity;
+  /** The number of requests sent. */
+  uint32_t         noSent;
+  /** The number of receipts received. */
+  uint32_t         noReceipts;
+  /** Set once a proxy lost its connection. */
+  bool             failed;
+
+  /** The peers found in the MRT file. */
+  ReplayPeer*      peers;
+  uint32_t         noPeers, peerCapacity;
+  /** The peers of the last TABLE_DUMP_V2 peer index table. */
+  uint32_t*        peerIndex;
+  uint32_t         noPeerIndex;
+  /** The proxies, the peers beyond the maximum share them. */
+  ReplayProxy*     proxies[REPLAY_MAX_PROXIES];
+  uint32_t         noProxies, maxProxies;
+  /** Announcements per second, 0 = as fast as possible. */
+  uint32_t         rate;
+  /** The time (ns) the replay started. */
+  uint64_t         start;
+  /** The number of announcements replayed. */
+  uint64_t         noUpdates;
+  /** The number of withdrawals, they are not replayed. */
+  uint64_t         noWithdrawals;
+  /** The number of records that are not supported or malformed. */
+  uint64_t         noSkipped;
+  /** The default result of all requests. */
+  SRxDefaultResult defResult;
+} replay = { .mutex    = PTHREAD_MUTEX_INITIALIZER,
+              .cond     = PTHREAD_COND_INITIALIZER,
+              .sendTime = NULL };
+
+/**
+ * Return the monotonic time in nano seconds.
+ *
+ * @return The time in nano seconds.
+ */
+static uint64_t replayNow()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * Record the latency of the receipt of a replayed request.
+ *
+ * @see ValidationReady in srx_api.h
+ */
+static bool handleReplayResult(SRxUpdateID          updateID,
+                               uint32_t             localID,
+                               ValidationResultType valType,
+                               uint8_t              roaResult,
+                               uint8_t              bgpsecResult,
+                               void* userPtr)
+{
+  uint64_t now = replayNow();
+
+  pthread_mutex_lock(&replay.mutex);
+  if ((localID != 0) && (localID <= replay.noSent))
+  {
+    replay.noReceipts++;
+    fstatAddLatency(now - replay.sendTime[localID - 1]);
+    fstatIncReceipt();
+    pthread_cond_signal(&replay.cond);
+  }
+  fstatIncNotify();
+  pthread_mutex_unlock(&replay.mutex);
+
+  return true;
+}
+
+/**
+ * The replay does not answer synchronization requests.
+ *
+ * @see SyncNotification in srx_api.h
+ */
+static void handleReplaySync(void* userPtr)
+{
+}
+
+/**
+ * Stop the replay once a proxy lost its connection.
+ *
+ * @see SrxCommManagement in srx_api.h
+ */
+static void replayCommManagement(SRxProxyCommCode mainCode, int subCode,
+                                 void* userPtr)
+{
+  if (isErrorCode(mainCode))
+  {
+    printf("Replay: SRx error %u, sub code %i!\n", mainCode, subCode);
+    if (   (mainCode == COM_ERR_PROXY_CONNECTION_LOST)
+        || (mainCode == COM_ERR_PROXY_COULD_NOT_SEND)
+        || (mainCode == COM_ERR_PROXY_DUPLICATE_PROXY_ID))
+    {
+      pthread_mutex_lock(&replay.mutex);
+      replay.failed = true;
+      pthread_cond_signal(&replay.cond);
+      pthread_mutex_unlock(&replay.mutex);
+    }
+  }
+}
+
+/**
+ * Send the pending requests of the proxy. Waits as long as the window of
+ * requests without receipt is filled.
+ *
+ * @param rProxy The replay proxy.
+ *
+ * @return false if the replay failed.
+ */
+static bool replayFlush(ReplayProxy* rProxy)
+{
+  uint32_t  noBatch = rProxy->noRequests;
+  uint32_t  noSent;
+  uint32_t  newCapacity;
+  uint64_t* newSendTime;
+  uint32_t  idx;
+  bool      ok;
+
+  if (noBatch == 0)
+  {
+    return !replay.failed;
+  }
+
+  pthread_mutex_lock(&replay.mutex);
+  while (   !replay.failed
+         && ((replay.noSent - replay.noReceipts) >= REPLAY_WINDOW))
+  {
+    pthread_cond_wait(&replay.cond, &replay.mutex);
+  }
+  if (replay.noSent + noBatch > replay.sendCapacity)
+  {
+    newCapacity = replay.sendCapacity == 0 ? 65536 : replay.sendCapacity * 2;
+    newSendTime = realloc(replay.sendTime, newCapacity * sizeof(uint64_t));
+    if (newSendTime == NULL)
+    {
+      printf("ERROR: Not enough memory to replay more updates!\n");
+      replay.failed = true;
+    }
+    else
+    {
+      replay.sendTime     = newSendTime;
+      replay.sendCapacity = newCapacity;
+    }
+  }
+  ok = !replay.failed;
+  if (ok)
+  {
+    // The receipt might arrive before verifyUpdateBatch returns.
+    for (idx = 0; idx < noBatch; idx++)
+    {
+      rProxy->requests[idx].localID = replay.noSent + idx + 1;
+      replay.sendTime[replay.noSent + idx] = replayNow();
+    }
+    replay.noSent += noBatch;
+  }
+  pthread_mutex_unlock(&replay.mutex);
+
+  if (ok)
+  {
+    noSent = verifyUpdateBatch(rProxy->proxy, noBatch, rProxy->requests);
+    if (stat_started)
+    {
+      stat_requests_send += noSent;
+    }
+    if (noSent < noBatch)
+    {
+      pthread_mutex_lock(&replay.mutex);
+      replay.noSent -= noBatch - noSent;
+      replay.failed  = true;
+      pthread_mutex_unlock(&replay.mutex);
+      ok = false;
+    }
+  }
+  rProxy->noRequests = 0;
+  rProxy->poolSize   = 0;
+
+  return ok;
+}
+
+/**
+ * Send the pending requests of all proxies.
+ *
+ * @return false if the replay failed.
+ */
+static bool replayFlushAll()
+{
+  bool     ok = true;
+  uint32_t idx;
+
+  for (idx = 0; ok && (idx < replay.noProxies); idx++)
+  {
+    ok = replayFlush(replay.proxies[idx]);
+  }
+
+  return ok;
+}
+
+/**
+ * Create and connect the proxy with the given proxy ID.
+ *
+ * @param proxyID The proxy ID.
+ *
+ * @return The replay proxy or NULL.
+ */
+static ReplayProxy* replayCreateProxy(uint32_t proxyID)
+{
+  ReplayProxy* rProxy = calloc(1, sizeof(ReplayProxy));
+
+  if (rProxy == NULL)
+  {
+    printf("ERROR: Not enough memory for another proxy!\n");
+    return NULL;
+  }
+  rProxy->proxy = createSRxProxy(handleReplayResult, handleSignatures,
+                                 handleReplaySync, replayCommManagement,
+                                 proxyID,
+                                 50, // ProxyAS
+                                 rProxy);
+  if (rProxy->proxy == NULL)
+  {
+    printf("ERROR: Proxy %s could not be created!\n", intToIP(proxyID));
+    free(rProxy);
+    return NULL;
+  }
+  if (!connectToSRx(rProxy->proxy, lastHost, lastPort,
+                    SRX_DEFAULT_HANDSHAKE_TIMEOUT, false))
+  {
+    printf("ERROR: Proxy %s could not connect to %s:%u!\n",
+           intToIP(proxyID), lastHost, lastPort);
+    releaseSRxProxy(rProxy->proxy);
+    free(rProxy);
+    return NULL;
+  }
+
+  return rProxy;
+}
+
+/**
+ * Return the peer with the given address and AS, a new peer is mapped to a
+ * proxy. Each of the first peers gets an own proxy, the proxy ID is the BGP
+ * identifier of the peer if known, otherwise its address.
+ *
+ * @param addr The peer address, 4 or 16 bytes.
+ * @param isV6 true if the address is an IPv6 address.
+ * @param peerAS The AS of the peer.
+ * @param bgpID The BGP identifier (network format) or 0 if unknown.
+ *
+ * @return The peer or NULL if the replay failed.
+ */
+static ReplayPeer* replayGetPeer(uint8_t* addr, bool isV6, uint32_t peerAS,
+                                 uint32_t bgpID)
+{
+  ReplayPeer* peer;
+  ReplayPeer* newPeers;
+  uint32_t    newCapacity;
+  uint32_t    proxyID;
+  uint32_t    idx;
+  uint8_t     addrLen = isV6 ? 16 : 4;
+
+  for (idx = 0; idx < replay.noPeers; idx++)
+  {
+    peer = &replay.peers[idx];
+    if (   (peer->isV6 == isV6) && (peer->peerAS == peerAS)
+        && (memcmp(peer->addr, addr, addrLen) == 0))
+    {
+      return peer;
+    }
+  }
+
+  if (replay.noPeers == replay.peerCapacity)
+  {
+    newCapacity = replay.peerCapacity == 0 ? 64 : replay.peerCapacity * 2;
+    newPeers    = realloc(replay.peers, newCapacity * sizeof(ReplayPeer));
+    if (newPeers == NULL)
+    {
+      printf("ERROR: Not enough memory for another peer!\n");
+      return NULL;
+    }
+    replay.peers        = newPeers;
+    replay.peerCapacity = newCapacity;
+  }
+  peer = &replay.peers[replay.noPeers];
+  memset(peer, 0, sizeof(ReplayPeer));
+  memcpy(peer->addr, addr, addrLen);
+  peer->isV6   = isV6;
+  peer->peerAS = peerAS;
+
+  if (replay.noProxies < replay.maxProxies)
+  {
+    proxyID = ntohl(bgpID);
+    for (idx = 0; (proxyID == 0) && (idx < addrLen); idx += 4)
+    {
+      proxyID ^= ntohl(*(uint32_t*)(addr + idx));
+    }
+    if (proxyID == 0)
+    {
+      proxyID = replay.noProxies + 1;
+    }
+    // A router with IPv4 and IPv6 sessions has one BGP identifier.
+    for (idx = 0; idx < replay.noProxies; idx++)
+    {
+      if (replay.proxies[idx]->proxy->proxyID == proxyID)
+      {
+        proxyID++;
+        idx = (uint32_t)-1;
+      }
+    }
+    peer->rProxy = replayCreateProxy(proxyID);
+    if (peer->rProxy == NULL)
+    {
+      return NULL;
+    }
+    replay.proxies[replay.noProxies++] = peer->rProxy;
+    printf("Replay peer AS %u with proxy %s\n", peerAS, intToIP(proxyID));
+  }
+  else
+  {
+    peer->rProxy = replay.proxies[replay.noPeers % replay.noProxies];
+    printf("Replay peer AS %u with proxy #%u\n", peerAS,
+           replay.noPeers % replay.noProxies + 1);
+  }
+  addPeers(peer->rProxy->proxy, 1, &peerAS);
+  replay.noPeers++;
+
+  return peer;
+}
+
+/**
+ * Queue the verification of the announcement, paced to the replay rate.
+ *
+ * @param peer The peer that announced the prefix.
+ * @param prefix The prefix.
+ * @param path The AS path in network format.
+ * @param noHops The number of ASes of the path.
+ * @param originAS The origin AS.
+ *
+ * @return false if the replay failed.
+ */
+static bool replayUpdate(ReplayPeer* peer, IPPrefix* prefix, uint32_t* path,
+                         uint16_t noHops, uint32_t originAS)
+{
+  ReplayProxy* rProxy = peer->rProxy;
+  uint32_t     idx;
+  uint64_t     due;
+  uint64_t     now;
+  struct timespec pause;
+
+  if (replay.rate > 0)
+  {
+    due = replay.start + replay.noUpdates * NSEC_PER_SEC / replay.rate;
+    now = replayNow();
+    if (due > now + REPLAY_MIN_PAUSE)
+    {
+      // Send what is due before pausing.
+      if (!replayFlushAll())
+      {
+        return false;
+      }
+      now = replayNow();
+      if (due > now)
+      {
+        pause.tv_sec  = (due - now) / NSEC_PER_SEC;
+        pause.tv_nsec = (due - now) % NSEC_PER_SEC;
+        nanosleep(&pause, NULL);
+      }
+    }
+  }
+
+  if (   (rProxy->noRequests == REPLAY_BATCH)
+      || (rProxy->poolSize + noHops > REPLAY_POOL_SIZE))
+  {
+    if (!replayFlush(rProxy))
+    {
+      return false;
+    }
+  }
+
+  idx = rProxy->noRequests++;
+  rProxy->prefixes[idx] = *prefix;
+  rProxy->bgpsec[idx].numberHops       = noHops;
+  rProxy->bgpsec[idx].asPath           = &rProxy->pathPool[rProxy->poolSize];
+  rProxy->bgpsec[idx].attr_length      = 0;
+  rProxy->bgpsec[idx].bgpsec_path_attr = NULL;
+  memcpy(&rProxy->pathPool[rProxy->poolSize], path, noHops * sizeof(uint32_t));
+  rProxy->poolSize += noHops;
+
+  rProxy->requests[idx].localID            = 0; // set by replayFlush
+  rProxy->requests[idx].usePrefixOriginVal = true;
+  rProxy->requests[idx].usePathVal         = false;
+  rProxy->requests[idx].defaultResult      = &replay.defResult;
+  rProxy->requests[idx].prefix             = &rProxy->prefixes[idx];
+  rProxy->requests[idx].as32               = originAS;
+  rProxy->requests[idx].bgpsec             = &rProxy->bgpsec[idx];
+  replay.noUpdates++;
+
+  return true;
+}
+
+/**
+ * The path attributes of an announcement.
+ */
+typedef struct {
+  /** The AS path in network format. */
+  uint32_t path[REPLAY_MAX_HOPS];
+  /** The number of ASes of the path. */
+  uint16_t noHops;
+  /** The origin AS, 0 if the path ends with an AS_SET. */
+  uint32_t originAS;
+  /** The MP_REACH_NLRI attribute or NULL. */
+  uint8_t* mpReach;
+  /** The length of the MP_REACH_NLRI attribute. */
+  uint16_t mpReachLen;
+} MRTAttributes;
+
+/**
+ * Parse the AS_PATH attribute. Longer paths are truncated, the origin AS is
+ * kept.
+ *
+ * @param data The attribute value.
+ * @param len The length of the attribute value.
+ * @param asSize The size of an AS number, 2 or 4.
+ * @param attr OUT - The path and the origin AS.
+ *
+ * @return false if the attribute is malformed.
+ */
+static bool mrtParseASPath(uint8_t* data, uint16_t len, uint8_t asSize,
+                           MRTAttributes* attr)
+{
+  uint8_t  segType;
+  uint8_t  segLen;
+  uint32_t as = 0;
+  uint16_t pos = 0;
+  uint8_t  idx;
+
+  attr->noHops   = 0;
+  attr->originAS = 0;
+  while (pos + 2 <= len)
+  {
+    segType = data[pos];
+    segLen  = data[pos + 1];
+    pos    += 2;
+    if (pos + segLen * asSize > len)
+    {
+      return false;
+    }
+    for (idx = 0; idx < segLen; idx++, pos += asSize)
+    {
+      as = asSize == 4 ? ntohl(*(uint32_t*)(data + pos))
+                       : ntohs(*(uint16_t*)(data + pos));
+      if (attr->noHops < REPLAY_MAX_HOPS)
+      {
+        attr->path[attr->noHops++] = htonl(as);
+      }
+    }
+    // The origin is the last AS of an AS_SEQUENCE, an AS_SET has none.
+    attr->originAS = segType == MRT_AS_SEQUENCE ? as : 0;
+  }
+  if ((attr->noHops == REPLAY_MAX_HOPS) && (attr->originAS != 0))
+  {
+    attr->path[REPLAY_MAX_HOPS - 1] = htonl(attr->originAS);
+  }
+
+  return pos == len;
+}
+
+/**
+ * Parse the path attributes of an announcement.
+ *
+ * @param data The path attributes.
+ * @param len The length of the path attributes.
+ * @param asSize The size of an AS number in the AS_PATH, 2 or 4.
+ * @param attr OUT - The parsed attributes.
+ *
+ * @return false if the attributes are malformed or contain no AS_PATH.
+ */
+static bool mrtParseAttributes(uint8_t* data, uint32_t len, uint8_t asSize,
+                               MRTAttributes* attr)
+{
+  uint8_t* asPath    = NULL;
+  uint16_t asPathLen = 0;
+  uint8_t* as4Path   = NULL;
+  uint16_t as4PathLen = 0;
+  uint32_t pos       = 0;
+  uint8_t  flags;
+  uint8_t  type;
+  uint16_t attrLen;
+
+  attr->mpReach    = NULL;
+  attr->mpReachLen = 0;
+  while (pos + 3 <= len)
+  {
+    flags = data[pos];
+    type  = data[pos + 1];
+    if ((flags & MRT_ATTR_EXT_LENGTH) != 0)
+    {
+      if (pos + 4 > len)
+      {
+        return false;
+      }
+      attrLen = ntohs(*(uint16_t*)(data + pos + 2));
+      pos    += 4;
+    }
+    else
+    {
+      attrLen = data[pos + 2];
+      pos    += 3;
+    }
+    if (pos + attrLen > len)
+    {
+      return false;
+    }
+    switch (type)
+    {
+      case MRT_ATTR_AS_PATH:
+        asPath    = data + pos;
+        asPathLen = attrLen;
+        break;
+      case MRT_ATTR_AS4_PATH:
+        as4Path    = data + pos;
+        as4PathLen = attrLen;
+        break;
+      case MRT_ATTR_MP_REACH_NLRI:
+        attr->mpReach    = data + pos;
+        attr->mpReachLen = attrLen;
+        break;
+      default:
+        break;
+    }
+    pos += attrLen;
+  }
+
+  // A 2 byte speaker carries the 4 byte path in AS4_PATH.
+  if ((asSize == 2) && (as4Path != NULL))
+  {
+    return mrtParseASPath(as4Path, as4PathLen, 4, attr);
+  }
+  return (asPath != NULL) && mrtParseASPath(asPath, asPathLen, asSize, attr);
+}
+
+/**
+ * Replay each prefix of the NLRI.
+ *
+ * @param peer The peer that announced the prefixes.
+ * @param nlri The NLRI.
+ * @param len The length of the NLRI.
+ * @param isV6 true for IPv6 prefixes.
+ * @param attr The path attributes of the announcement.
+ *
+ * @return false if the replay failed.
+ */
+static bool mrtReplayNLRI(ReplayPeer* peer, uint8_t* nlri, uint32_t len,
+                          bool isV6, MRTAttributes* attr)
+{
+  IPPrefix prefix;
+  uint32_t pos = 0;
+  uint8_t  bytes;
+  uint8_t  maxLen = isV6 ? 128 : 32;
+
+  while (pos < len)
+  {
+    memset(&prefix, 0, sizeof(IPPrefix));
+    prefix.ip.version = isV6 ? 6 : 4;
+    prefix.length     = nlri[pos++];
+    bytes             = (prefix.length + 7) / 8;
+    if ((prefix.length > maxLen) || (pos + bytes > len))
+    {
+      replay.noSkipped++;
+      return true;
+    }
+    memcpy(isV6 ? prefix.ip.addr.v6.u8 : prefix.ip.addr.v4.u8, nlri + pos,
+           bytes);
+    pos += bytes;
+    if (!replayUpdate(peer, &prefix, attr->path, attr->noHops,
+                      attr->originAS))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Process a TABLE_DUMP_V2 PEER_INDEX_TABLE record. The peers are mapped to
+ * the proxies right away.
+ *
+ * @param data The record.
+ * @param len The length of the record.
+ *
+ * @return false if the replay failed.
+ */
+static bool mrtProcessPeerIndex(uint8_t* data, uint32_t len)
+{
+  ReplayPeer* peer;
+  uint32_t*   newIndex;
+  uint32_t    pos;
+  uint32_t    bgpID;
+  uint32_t    peerAS;
+  uint16_t    noPeers;
+  uint16_t    idx;
+  uint8_t     peerType;
+  uint8_t     addrLen;
+  uint8_t*    addr;
+
+  // Collector BGP ID, view name
+  if (len < 8)
+  {
+    replay.noSkipped++;
+    return true;
+  }
+  pos = 6 + ntohs(*(uint16_t*)(data + 4));
+  if (pos + 2 > len)
+  {
+    replay.noSkipped++;
+    return true;
+  }
+  noPeers = ntohs(*(uint16_t*)(data + pos));
+  pos    += 2;
+
+  newIndex = realloc(replay.peerIndex, (noPeers + 1) * sizeof(uint32_t));
+  if (newIndex == NULL)
+  {
+    printf("ERROR: Not enough memory for the peer index table!\n");
+    return false;
+  }
+  replay.peerIndex   = newIndex;
+  replay.noPeerIndex = 0;
+
+  for (idx = 0; idx < noPeers; idx++)
+  {
+    if (pos + 1 > len)
+    {
+      break;
+    }
+    peerType = data[pos];
+    addrLen  = (peerType & MRT_PEER_TYPE_IPV6) != 0 ? 16 : 4;
+    if (pos + 5 + addrLen
+        + ((peerType & MRT_PEER_TYPE_AS4) != 0 ? 4 : 2) > len)
+    {
+      break;
+    }
+    bgpID = *(uint32_t*)(data + pos + 1);
+    addr  = data + pos + 5;
+    pos  += 5 + addrLen;
+    if ((peerType & MRT_PEER_TYPE_AS4) != 0)
+    {
+      peerAS = ntohl(*(uint32_t*)(data + pos));
+      pos   += 4;
+    }
+    else
+    {
+      peerAS = ntohs(*(uint16_t*)(data + pos));
+      pos   += 2;
+    }
+    peer = replayGetPeer(addr, addrLen == 16, peerAS, bgpID);
+    if (peer == NULL)
+    {
+      return false;
+    }
+    replay.peerIndex[replay.noPeerIndex++] = peer - replay.peers;
+  }
+
+  return true;
+}
+
+/**
+ * Process a TABLE_DUMP_V2 RIB_IPV4_UNICAST or RIB_IPV6_UNICAST record. Each
+ * RIB entry is replayed as an announcement of its peer.
+ *
+ * @param data The record.
+ * @param len The length of the record.
+ * @param isV6 true for RIB_IPV6_UNICAST.
+ *
+ * @return false if the replay failed.
+ */
+static bool mrtProcessRIB(uint8_t* data, uint32_t len, bool isV6)
+{
+  MRTAttributes attr;
+  uint32_t      pos;
+  uint16_t      noEntries;
+  uint16_t      peerIdx;
+  uint16_t      attrLen;
+  uint16_t      idx;
+  uint8_t       bytes;
+
+  // Sequence number, prefix
+  if (len < 5)
+  {
+    replay.noSkipped++;
+    return true;
+  }
+  bytes = (data[4] + 7) / 8;
+  pos   = 5 + bytes;
+  if (pos + 2 > len)
+  {
+    replay.noSkipped++;
+    return true;
+  }
+  noEntries = ntohs(*(uint16_t*)(data + pos));
+  pos      += 2;
+
+  for (idx = 0; idx < noEntries; idx++)
+  {
+    // Peer index, originated time, attribute length
+    if (pos + 8 > len)
+    {
+      replay.noSkipped++;
+      break;
+    }
+    peerIdx = ntohs(*(uint16_t*)(data + pos));
+    attrLen = ntohs(*(uint16_t*)(data + pos + 6));
+    pos    += 8;
+    if ((pos + attrLen > len) || (peerIdx >= replay.noPeerIndex))
+    {
+      replay.noSkipped++;
+      break;
+    }
+    // TABLE_DUMP_V2 always uses 4 byte AS numbers.
+    if (!mrtParseAttributes(data + pos, attrLen, 4, &attr))
+    {
+      replay.noSkipped++;
+    }
+    else if (!mrtReplayNLRI(&replay.peers[replay.peerIndex[peerIdx]],
+                            data + 4, 1 + bytes, isV6, &attr))
+    {
+      return false;
+    }
+    pos += attrLen;
+  }
+
+  return true;
+}
+
+/**
+ * Process a BGP4MP MESSAGE record. The announcements of an UPDATE message are
+ * replayed, the withdrawals are counted only.
+ *
+ * @param data The record.
+ * @param len The length of the record.
+ * @param asSize The size of the AS numbers, 2 or 4.
+ *
+ * @return false if the replay failed.
+ */
+static bool mrtProcessBGP4MP(uint8_t* data, uint32_t len, uint8_t asSize)
+{
+  MRTAttributes attr;
+  ReplayPeer*   peer;
+  uint8_t*      msg;
+  uint32_t      msgLen;
+  uint32_t      peerAS;
+  uint16_t      afi;
+  uint8_t       addrLen;
+  uint16_t      wdLen;
+  uint16_t      attrLen;
+  uint32_t      pos;
+  uint8_t       nhLen;
+
+  // Peer AS, local AS, interface index, AFI
+  pos = 2 * asSize + 4;
+  if (pos > len)
+  {
+    replay.noSkipped++;
+    return true;
+  }
+  peerAS  = asSize == 4 ? ntohl(*(uint32_t*)data) : ntohs(*(uint16_t*)data);
+  afi     = ntohs(*(uint16_t*)(data + 2 * asSize + 2));
+  addrLen = afi == MRT_AFI_IPV6 ? 16 : 4;
+  // Peer and local address, BGP header
+  if (pos + 2 * addrLen + 19 > len)
+  {
+    replay.noSkipped++;
+    return true;
+  }
+  msg    = data + pos + 2 * addrLen;
+  msgLen = len - (pos + 2 * addrLen);
+  if (msg[18] != BGP_MSG_UPDATE)
+  {
+    return true;
+  }
+
+  // Withdrawn routes, path attributes, NLRI
+  if (msgLen < 23)
+  {
+    replay.noSkipped++;
+    return true;
+  }
+  wdLen = ntohs(*(uint16_t*)(msg + 19));
+  if (21 + wdLen + 2 > msgLen)
+  {
+    replay.noSkipped++;
+    return true;
+  }
+  attrLen = ntohs(*(uint16_t*)(msg + 21 + wdLen));
+  if (21 + wdLen + 2 + attrLen > msgLen)
+  {
+    replay.noSkipped++;
+    return true;
+  }
+  if (wdLen > 0)
+  {
+    replay.noWithdrawals++;
+  }
+  if (attrLen == 0)
+  {
+    return true;
+  }
+  if (!mrtParseAttributes(msg + 23 + wdLen, attrLen, asSize, &attr))
+  {
+    replay.noSkipped++;
+    return true;
+  }
+
+  peer = replayGetPeer(data + pos, addrLen == 16, peerAS, 0);
+  if (peer == NULL)
+  {
+    return false;
+  }
+  pos = 23 + wdLen + attrLen;
+  if (!mrtReplayNLRI(peer, msg + pos, msgLen - pos, false, &attr))
+  {
+    return false;
+  }
+
+  // IPv6 announcements: AFI, SAFI, next hop, reserved, NLRI
+  if ((attr.mpReach != NULL) && (attr.mpReachLen >= 5)
+      && (ntohs(*(uint16_t*)attr.mpReach) == MRT_AFI_IPV6)
+      && (attr.mpReach[2] == MRT_SAFI_UNICAST))
+  {
+    nhLen = attr.mpReach[3];
+    pos   = 4 + nhLen + 1;
+    if (pos <= attr.mpReachLen)
+    {
+      return mrtReplayNLRI(peer, attr.mpReach + pos, attr.mpReachLen - pos,
+                           true, &attr);
+    }
+    replay.noSkipped++;
+  }
+
+  return true;
+}
+
+/**
+ * Release all proxies and peers of the replay.
+ */
+static void replayRelease()
+{
+  uint32_t idx;
+
+  for (idx = 0; idx < replay.noProxies; idx++)
+  {
+    disconnectFromSRx(replay.proxies[idx]->proxy, SRX_DEFAULT_KEEP_WINDOW);
+    releaseSRxProxy(replay.proxies[idx]->proxy);
+    free(replay.proxies[idx]);
+    replay.proxies[idx] = NULL;
+  }
+  replay.noProxies = 0;
+  free(replay.peers);
+  replay.peers        = NULL;
+  replay.noPeers      = 0;
+  replay.peerCapacity = 0;
+  free(replay.peerIndex);
+  replay.peerIndex    = NULL;
+  replay.noPeerIndex  = 0;
+  free(replay.sendTime);
+  replay.sendTime     = NULL;
+  replay.sendCapacity = 0;
+}
+
+/**
+ * Replay the announcements of an MRT file (TABLE_DUMP_V2 RIB or BGP4MP
+ * UPDATES) through libSRxProxy. Each MRT peer is mapped to a proxy of its own
+ * which connects to the SRx server of the last connect command. Each request
+ * asks for a receipt, the time until the receipt is received is recorded by
+ * the statistics framework. The statistics are started for the replay unless
+ * they are running already.
+ *
+ * @param log indicates if the command is added to the history.
+ * @param argPtr The MRT file, the rate in announcements per second (0 = as
+ *               fast as possible), and the maximum number of proxies.
+ */
+void doReplay(bool log, char** argPtr)
+{
+  struct timespec deadline;
+  uint8_t         header[MRT_HEADER_LEN];
+  uint8_t*        data = NULL;
+  uint8_t*        newData;
+  uint32_t        capacity = 0;
+  uint32_t        len;
+  uint16_t        type;
+  uint16_t        subType;
+  char            fname[256];
+  FILE*           fh;
+  bool            ok = true;
+  bool            ownStatistics = !stat_started;
+
+  snprintf(fname, sizeof(fname), "%s", prompt(argPtr, "MRT filename ? "));
+  replay.rate       = promptU32(argPtr, "Updates per second [0=unlimited] ? ");
+  replay.maxProxies = promptU32(argPtr, "Max. number of proxies [default: "
+                                        "one per peer] ? ");
+  if ((replay.maxProxies == 0) || (replay.maxProxies > REPLAY_MAX_PROXIES))
+  {
+    replay.maxProxies = REPLAY_MAX_PROXIES;
+  }
+
+  fh = fopen(fname, "rb");
+  if (fh == NULL)
+  {
+    printf("Error: Attempt to open file '%s' returned error [%d]\n", fname,
+           errno);
+    return;
+  }
+  if (log)
+  {
+    addToHistory("%s %s %u %u", CMD_REPLAY, fname, replay.rate,
+                 replay.maxProxies);
+  }
+
+  replay.noSent        = 0;
+  replay.noReceipts    = 0;
+  replay.failed        = false;
+  replay.noUpdates     = 0;
+  replay.noWithdrawals = 0;
+  replay.noSkipped     = 0;
+  replay.defResult.result.roaResult    = SRx_RESULT_UNDEFINED;
+  replay.defResult.result.bgpsecResult = SRx_RESULT_UNDEFINED;
+  replay.defResult.resSourceROA        = SRxRS_UNKNOWN;
+  replay.defResult.resSourceBGPSEC     = SRxRS_UNKNOWN;
+
+  if (ownStatistics)
+  {
+    if (stat_need_init)
+    {
+      fstatInitializeStatistics(false);
+    }
+    fstatStartStatistics();
+  }
+  replay.start = replayNow();
+
+  while (ok && (fread(header, MRT_HEADER_LEN, 1, fh) == 1))
+  {
+    type    = ntohs(*(uint16_t*)(header + 4));
+    subType = ntohs(*(uint16_t*)(header + 6));
+    len     = ntohl(*(uint32_t*)(header + 8));
+    if (len > capacity)
+    {
+      newData = realloc(data, len);
+      if (newData == NULL)
+      {
+        printf("ERROR: Not enough memory for an MRT record of %u bytes!\n",
+               len);
+        break;
+      }
+      data     = newData;
+      capacity = len;
+    }
+    if ((len > 0) && (fread(data, len, 1, fh) != 1))
+    {
+      printf("ERROR: The MRT file is truncated!\n");
+      break;
+    }
+
+    switch (type)
+    {
+      case MRT_TABLE_DUMP_V2:
+        switch (subType)
+        {
+          case MRT_PEER_INDEX_TABLE:
+            ok = mrtProcessPeerIndex(data, len);
+            break;
+          case MRT_RIB_IPV4_UNICAST:
+          case MRT_RIB_IPV6_UNICAST:
+            ok = mrtProcessRIB(data, len, subType == MRT_RIB_IPV6_UNICAST);
+            break;
+          default:
+            replay.noSkipped++;
+        }
+        break;
+      case MRT_BGP4MP:
+      case MRT_BGP4MP_ET:
+        // The extended timestamp adds the microseconds.
+        newData = type == MRT_BGP4MP_ET ? data + 4 : data;
+        len     = type == MRT_BGP4MP_ET && len >= 4 ? len - 4 : len;
+        switch (subType)
+        {
+          case MRT_BGP4MP_MESSAGE:
+          case MRT_BGP4MP_MESSAGE_LOCAL:
+            ok = mrtProcessBGP4MP(newData, len, 2);
+            break;
+          case MRT_BGP4MP_MESSAGE_AS4:
+          case MRT_BGP4MP_MESSAGE_AS4_LOCAL:
+            ok = mrtProcessBGP4MP(newData, len, 4);
+            break;
+          default:
+            // State changes
+            break;
+        }
+        break;
+      default:
+        replay.noSkipped++;
+    }
+  }
+  fclose(fh);
+  free(data);
+  ok = ok && replayFlushAll();
+
+  // Wait for the outstanding receipts
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += REPLAY_TIMEOUT;
+  pthread_mutex_lock(&replay.mutex);
+  while (!replay.failed && (replay.noReceipts < replay.noSent))
+  {
+    if (pthread_cond_timedwait(&replay.cond, &replay.mutex, &deadline)
+        == ETIMEDOUT)
+    {
+      printf("WARNING: %u receipts not received within %u seconds!\n",
+             replay.noSent - replay.noReceipts, REPLAY_TIMEOUT);
+      break;
+    }
+  }
+  pthread_mutex_unlock(&replay.mutex);
+
+  printf("Replayed %llu announcements of %u peers with %u proxies in %.3f "
+         "sec. (%llu withdrawals and %llu records skipped)%s\n",
+         (unsigned long long)replay.noUpdates, replay.noPeers,
+         replay.noProxies, (replayNow() - replay.start) / (double)NSEC_PER_SEC,
+         (unsigned long long)replay.noWithdrawals,
+         (unsigned long long)replay.noSkipped,
+         replay.failed ? " - FAILED" : "");
+  if (ownStatistics)
+  {
+    fstatGetStatistics(false);
+    fstatStopStatistics(false);
+  }
+  replayRelease();
+}
+
 /*-----
  * Main
  */
@@ -1569,7 +2796,11 @@ void showHelp()
          CMD_DELETE " <keep-window> <update-id>\n"
          "      Send a delete request for the given update to the srx server\n"
          CMD_RUN " <filename>\n"
-         "      Execute a script with commands in it.\n\n"
+         "      Execute a script with commands in it.\n"
+         CMD_REPLAY " <mrt-file> <updates/sec(0=unlimited)> <max-proxies>\n"
+         "      Replay the announcements of an uncompressed MRT file\n"
+         "      (TABLE_DUMP_V2 or BGP4MP) with one proxy per peer. The\n"
+         "      receipt latency is added to the statistics.\n\n"
          "Statistics Framework Commands:\n"    
          "------------------------------\n"
          " The statistics framework should only be used in combination with\n"
@@ -1844,6 +3075,7 @@ bool processLine(bool log, char* line)
   else IF_EQ_DO(CMD_SIGN, doSign(log, &arg))
   else IF_EQ_DO(CMD_DELETE, doDelete(log, &arg))
   else IF_EQ_DO(CMD_RUN, runScript(log, &arg))  
+  else IF_EQ_DO(CMD_REPLAY, doReplay(log, &arg))
   else IF_EQ_DO(CMD_STAT_INIT, fstatInitializeStatistics(true))
   else IF_EQ_DO(CMD_STAT_START, fstatStartStatistics(true))
   else IF_EQ_DO(CMD_STAT_MARK_WITH_RECEIPT, fstatMarkNotifications(&arg, true))
@@ -27,6 +27,9 @@
  * 0.4.1.0 - 2016/10/26 - oborchert
  *           * BZ1037: Replaces legacy calls to bzero with memset
  *           * Reformated Changelog
+ *         - 2026/10/15 - kyehwanl
+ *           * Added createShmClientSocket. Closing or reconnecting the socket
+ *             ends its shared memory transport.
  * 0.3.0.0 - 2012/12/17 - oborchert
  *           * Added changelog.
  *           * Changed Structure of client socket to allow different handling 
@@ -41,11 +44,13 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <netdb.h>
+#include <ifaddrs.h>
 #include <sys/socket.h>
 #include <errno.h>
 #include "util/client_socket.h"
 #include "util/log.h"
 #include "util/packet.h"
+#include "util/shm_transport.h"
 #include "util/socket.h"
 
 /**
@@ -80,6 +85,7 @@ bool createClientSocket(ClientSocket* self, const char* host, int port,
   self->oldFD = -1;
   self->type = UNDEFINED_CLIENT_SOCKET; // for now
   self->canBeClosed = true; // for now
+  self->shmTransport = false;
 
   // Resolve the host name
   svr = gethostbyname(host);
@@ -131,6 +137,88 @@ bool createClientSocket(ClientSocket* self, const char* host, int port,
   return true;
 }
 
+/**
+ * Check if the given address belongs to this host.
+ *
+ * @param addr The IPv4 address in network byte order.
+ *
+ * @return true for a loopback address or an address of a local interface.
+ *
+ * @since 0.4.1.0
+ */
+static bool _isLocalAddress(struct in_addr* addr)
+{
+  struct ifaddrs* ifList;
+  struct ifaddrs* ifa;
+  bool local = (ntohl(addr->s_addr) >> 24) == 127;
+
+  if (!local && (getifaddrs(&ifList) == 0))
+  {
+    for (ifa = ifList; (ifa != NULL) && !local; ifa = ifa->ifa_next)
+    {
+      local =    (ifa->ifa_addr != NULL)
+              && (ifa->ifa_addr->sa_family == AF_INET)
+              && (((struct sockaddr_in*)ifa->ifa_addr)->sin_addr.s_addr
+                  == addr->s_addr);
+    }
+    freeifaddrs(ifList);
+  }
+
+  return local;
+}
+
+/**
+ * Connects to a server on the same host using the shared memory transport.
+ * The file descriptor of the socket is the control connection of the
+ * transport, all functions of socket.c use the transport for it. Fails if the
+ * host is not a local address or the server does not provide the transport,
+ * the caller then uses createClientSocket.
+ *
+ * @param self The Client socket.
+ * @param host The host to attach to.
+ * @param port The TCP port of the server.
+ * @param type The type of this socket.
+ * @param allowToClose indicates if the socket is allowed to be closed.
+ *
+ * @return true if the transport is established.
+ *
+ * @since 0.4.1.0
+ */
+bool createShmClientSocket(ClientSocket* self, const char* host, int port,
+                           ClientSocketType type, bool allowToClose)
+{
+  struct hostent* svr = gethostbyname(host);
+  int fd;
+
+  if (   (svr == NULL) || (svr->h_addrtype != AF_INET)
+      || !_isLocalAddress((struct in_addr*)svr->h_addr))
+  {
+    return false;
+  }
+  fd = connectShmTransport(port);
+  if (fd == -1)
+  {
+    return false;
+  }
+
+  // Keep the TCP address for a reconnect in case the transport is gone.
+  memset(&self->svrAddr, 0, sizeof (struct sockaddr_in));
+  self->svrAddr.sin_family = AF_INET;
+  self->svrAddr.sin_port = htons(port);
+  memcpy(&(self->svrAddr.sin_addr.s_addr), svr->h_addr, svr->h_length);
+
+  self->clientFD = fd;
+  self->oldFD = fd;
+  self->type = type;
+  self->canBeClosed = allowToClose;
+  self->reconnect = true;
+  self->shmTransport = true;
+  LOG(LEVEL_INFO, "Connected to the server at %s:%u using shared memory",
+                  host, port);
+
+  return true;
+}
+
 /**
  * Closes the client socket and turns off the reconnect feature. This method
  * closes the socket on transport layer if possible, otherwise it only sets
@@ -147,6 +235,8 @@ void closeClientSocket(ClientSocket* self)
     stopReconnectingToServer(self);
     if (fileDescriptor > -1)
     {
+      // The transport also ends if the socket itself must stay open.
+      closeShmTransport(fileDescriptor);
       // At least keep old behavior and close it if it is an rpki client socket.
       if (self->canBeClosed)
       {
@@ -192,6 +282,7 @@ bool reconnectToServer(ClientSocket* self, int delay, int max_attempts)
     int fileDescriptor = self->clientFD > -1 ? self->clientFD : self->oldFD;
     if (fileDescriptor > -1)
     {
+      closeShmTransport(fileDescriptor);
       close(fileDescriptor);
     }
   }
@@ -207,6 +298,18 @@ bool reconnectToServer(ClientSocket* self, int delay, int max_attempts)
                      ++att, max_att, delay);
     max_attempts--;
 
+    // A restarted server on the same host might provide the transport again.
+    if (self->shmTransport && (self->clientFD == -1))
+    {
+      self->clientFD = connectShmTransport(ntohs(self->svrAddr.sin_port));
+      self->oldFD = self->clientFD;
+      if (self->clientFD != -1)
+      {
+        succ = true;
+        break;
+      }
+    }
+
     // Create a new one socket if necessary
     if (self->clientFD == -1)
     {
@@ -24,10 +24,12 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Added createShmClientSocket.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  *            * Added Changelog
@@ -73,6 +75,9 @@ typedef struct {
   bool                canBeClosed; // if this is false, the socket must not be
                                    // closed!! This is to allow external
                                    // socket control.
+  /** The server is on the same host and is connected using the shared memory
+   * transport, a reconnect tries the transport first. */
+  bool                shmTransport;
 } ClientSocket;
 
 /**
@@ -101,6 +106,26 @@ bool createClientSocket(ClientSocket* self, const char* host, int port,
                         bool failNoServer, ClientSocketType type,
                         bool allowToClose);
 
+/**
+ * Connects to a server on the same host using the shared memory transport.
+ * The file descriptor of the socket is the control connection of the
+ * transport, all functions of socket.c use the transport for it. Fails if the
+ * host is not a local address or the server does not provide the transport,
+ * the caller then uses createClientSocket.
+ *
+ * @param self The Client socket.
+ * @param host The host to attach to.
+ * @param port The TCP port of the server.
+ * @param type The type of this socket.
+ * @param allowToClose indicates if the socket is allowed to be closed.
+ *
+ * @return true if the transport is established.
+ *
+ * @since 0.4.1.0
+ */
+bool createShmClientSocket(ClientSocket* self, const char* host, int port,
+                           ClientSocketType type, bool allowToClose);
+
 /**
  * Closes a client-socket.
  *
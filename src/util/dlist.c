@@ -0,0 +1,97 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ *            * Added moveDList.
+ */
+
+#include "util/dlist.h"
+
+void initDList(DList* self)
+{
+  self->head.next = &self->head;
+  self->head.prev = &self->head;
+  self->size      = 0;
+}
+
+void appendToDList(DList* self, DListNode* node)
+{
+  node->next            = &self->head;
+  node->prev            = self->head.prev;
+  self->head.prev->next = node;
+  self->head.prev       = node;
+  self->size++;
+}
+
+void removeFromDList(DList* self, DListNode* node)
+{
+  if (node->next == NULL)
+  {
+    return;
+  }
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->next       = NULL;
+  node->prev       = NULL;
+  self->size--;
+}
+
+DListNode* shiftFromDList(DList* self)
+{
+  DListNode* node = self->head.next;
+
+  if (node == &self->head)
+  {
+    return NULL;
+  }
+  removeFromDList(self, node);
+
+  return node;
+}
+
+bool isInDList(DListNode* node)
+{
+  return node->next != NULL;
+}
+
+uint32_t sizeOfDList(DList* self)
+{
+  return self->size;
+}
+
+void moveDList(DList* self, DList* dest)
+{
+  if (self->head.next == &self->head)
+  {
+    return;
+  }
+  self->head.next->prev = dest->head.prev;
+  self->head.prev->next = &dest->head;
+  dest->head.prev->next = self->head.next;
+  dest->head.prev       = self->head.prev;
+  dest->size           += self->size;
+  initDList(self);
+}
@@ -0,0 +1,174 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * An intrusive doubly-linked list. The node is embedded into the structure 
+ * that is listed, appending and unlinking is O(1) and does not allocate.
+ *
+ * @note Not thread-safe!
+ *
+ * Usage example:
+ * @code
+ * typedef struct {
+ *   int       value;
+ *   DListNode link;
+ * } MyStruct;
+ *
+ * DList      list;
+ * DListNode* node;
+ * MyStruct   item;
+ *
+ * initDList(&list);
+ * appendToDList(&list, &item.link);
+ * FOREACH_DLIST(&list, node)
+ * {
+ *   printf("%d\n", DLIST_ENTRY(node, MyStruct, link)->value);
+ * }
+ * removeFromDList(&list, &item.link);
+ * @endcode
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ *            * Added moveDList.
+ */
+
+#ifndef __DLIST_H__
+#define __DLIST_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * A single node, embedded into the listed structure.
+ */
+typedef struct _DListNode
+{
+  struct _DListNode* next; ///< The next node, NULL if not listed
+  struct _DListNode* prev; ///< The previous node, NULL if not listed
+} DListNode;
+
+/**
+ * The list. The head is a sentinel node, an empty list links it to itself.
+ */
+typedef struct
+{
+  DListNode head; ///< The sentinel node
+  uint32_t  size; ///< The number of nodes listed
+} DList;
+
+/**
+ * Returns the structure the node is embedded into.
+ *
+ * @param NODEPTR The node
+ * @param TYPE The type of the structure
+ * @param MEMBER The name of the node within the structure
+ */
+#define DLIST_ENTRY(NODEPTR, TYPE, MEMBER) \
+  ((TYPE*)((uint8_t*)(NODEPTR) - offsetof(TYPE, MEMBER)))
+
+/**
+ * Loops over a list putting the current node in a variable. The current node
+ * MUST NOT be removed within the loop, use FOREACH_DLIST_SAFE instead.
+ *
+ * @param DLISTPTR The list
+ * @param NODEPTR The variable that receives the current node
+ */
+#define FOREACH_DLIST(DLISTPTR, NODEPTR) \
+  for (NODEPTR = (DLISTPTR)->head.next; NODEPTR != &(DLISTPTR)->head; \
+       NODEPTR = NODEPTR->next)
+
+/**
+ * Loops over a list putting the current node in a variable. The current node
+ * can be removed within the loop.
+ *
+ * @param DLISTPTR The list
+ * @param NODEPTR The variable that receives the current node
+ * @param NEXTPTR A variable that holds the next node
+ */
+#define FOREACH_DLIST_SAFE(DLISTPTR, NODEPTR, NEXTPTR) \
+  for (NODEPTR = (DLISTPTR)->head.next, NEXTPTR = NODEPTR->next; \
+       NODEPTR != &(DLISTPTR)->head; \
+       NODEPTR = NEXTPTR, NEXTPTR = NODEPTR->next)
+
+/**
+ * Initializes an empty list.
+ *
+ * @param self The list
+ */
+extern void initDList(DList* self);
+
+/**
+ * Appends the node to the end of the list. The node MUST NOT be listed.
+ *
+ * @param self The list
+ * @param node The node
+ */
+extern void appendToDList(DList* self, DListNode* node);
+
+/**
+ * Removes the node from the list. A node that is not listed is ignored.
+ *
+ * @param self The list the node is listed in
+ * @param node The node
+ */
+extern void removeFromDList(DList* self, DListNode* node);
+
+/**
+ * Removes and returns the first node of the list.
+ *
+ * @param self The list
+ *
+ * @return The first node, or \c NULL if the list is empty
+ */
+extern DListNode* shiftFromDList(DList* self);
+
+/**
+ * Checks if the node is listed.
+ *
+ * @param node The node
+ *
+ * @return \c true if the node is listed
+ */
+extern bool isInDList(DListNode* node);
+
+/**
+ * Returns the number of nodes listed.
+ *
+ * @param self The list
+ *
+ * @return The number of nodes
+ */
+extern uint32_t sizeOfDList(DList* self);
+
+/**
+ * Move all nodes of the list to the end of the given destination list. The
+ * list is empty afterwards.
+ *
+ * @param self The list whose nodes are moved.
+ * @param dest The destination list.
+ */
+extern void moveDList(DList* self, DList* dest);
+
+#endif // !__DLIST_H__
@@ -0,0 +1,265 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Epoch based memory reclamation. Each thread that reads gets a reader slot
+ * that is valid for all domains. The slot is handed back when the thread
+ * terminates.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Code created.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include "util/epoch.h"
+#include "util/log.h"
+
+#define HDR "([0x%08X] Epoch): "
+
+/** Marks the reader slots in use. */
+static volatile uint8_t _slotUsed[EPOCH_MAX_READERS];
+/** Used to hand the slot back once the thread terminates. */
+static pthread_key_t    _slotKey;
+/** Creates the slot key only once. */
+static pthread_once_t   _slotKeyOnce = PTHREAD_ONCE_INIT;
+/** The reader slot of the calling thread, -1 if none is assigned yet. */
+static __thread int     _readerSlot = -1;
+
+/**
+ * Hand the reader slot back. Called when a thread with a slot terminates.
+ *
+ * @param slot The slot number + 1.
+ */
+static void _releaseSlot(void* slot)
+{
+  _slotUsed[(intptr_t)slot - 1] = 0;
+  __sync_synchronize();
+}
+
+/**
+ * Create the key used to hand the slots back.
+ */
+static void _createSlotKey()
+{
+  pthread_key_create(&_slotKey, _releaseSlot);
+}
+
+/**
+ * Return the reader slot of the calling thread, assign one if needed.
+ *
+ * @return The slot or -1 if all slots are in use.
+ */
+static int _getReaderSlot()
+{
+  int idx;
+
+  if (_readerSlot == -1)
+  {
+    pthread_once(&_slotKeyOnce, _createSlotKey);
+    for (idx = 0; idx < EPOCH_MAX_READERS; idx++)
+    {
+      if (__sync_bool_compare_and_swap(&_slotUsed[idx], 0, 1))
+      {
+        _readerSlot = idx;
+        pthread_setspecific(_slotKey, (void*)(intptr_t)(idx + 1));
+        break;
+      }
+    }
+  }
+
+  return _readerSlot;
+}
+
+/**
+ * Initializes the epoch domain.
+ *
+ * @param self The domain to be initialized.
+ */
+void initEpochDomain(EpochDomain* self)
+{
+  memset(self, 0, sizeof(EpochDomain));
+  self->epoch = 1;
+}
+
+/**
+ * Releases all retired data of the domain. No reader must be within the
+ * domain anymore.
+ *
+ * @param self The domain.
+ */
+void releaseEpochDomain(EpochDomain* self)
+{
+  EpochRetired* retired;
+
+  while (self->retired != NULL)
+  {
+    retired = self->retired;
+    self->retired = retired->next;
+    retired->release(retired->data);
+    free(retired);
+  }
+  self->noRetired = 0;
+}
+
+/**
+ * Enter the current epoch. Until leaveEpoch is called, no data reachable by
+ * the calling thread is released. Calls can not be nested.
+ *
+ * @param self The domain.
+ *
+ * @return false if no reader slot is available for the calling thread.
+ */
+bool enterEpoch(EpochDomain* self)
+{
+  int slot = _getReaderSlot();
+
+  if (slot == -1)
+  {
+    return false;
+  }
+  self->readers[slot] = self->epoch;
+  // The epoch must be visible before any shared data is read.
+  __sync_synchronize();
+
+  return true;
+}
+
+/**
+ * Leave the epoch entered with enterEpoch.
+ *
+ * @param self The domain.
+ */
+void leaveEpoch(EpochDomain* self)
+{
+  // All reads must be completed before the slot is cleared.
+  __sync_synchronize();
+  self->readers[_readerSlot] = 0;
+}
+
+/**
+ * Retire the given data. The data MUST already be unlinked. It is released
+ * once all readers that possibly see it left their epoch.
+ *
+ * @param self The domain.
+ * @param data The data to be retired.
+ * @param release The function that releases the data.
+ */
+void retireEpochData(EpochDomain* self, void* data, EpochReleaseFunc release)
+{
+  EpochRetired* retired = malloc(sizeof(EpochRetired));
+
+  if (retired == NULL)
+  {
+    // Not enough memory to keep it, wait for the readers instead.
+    LOG(LEVEL_WARNING, HDR "Not enough memory to retire data, wait for all "
+                       "readers!", pthread_self());
+    synchronizeEpoch(self);
+    release(data);
+    return;
+  }
+
+  // The unlink must be visible before the epoch moves on.
+  __sync_synchronize();
+  retired->data    = data;
+  retired->release = release;
+  retired->epoch   = __sync_fetch_and_add(&self->epoch, 1);
+  retired->next    = self->retired;
+  self->retired    = retired;
+  self->noRetired++;
+}
+
+/**
+ * Release all retired data no reader can see anymore. Must be called by the
+ * writer only.
+ *
+ * @param self The domain.
+ *
+ * @return The number of elements released.
+ */
+uint32_t reclaimEpochData(EpochDomain* self)
+{
+  EpochRetired** link;
+  EpochRetired*  retired;
+  uint64_t       oldest   = self->epoch;
+  uint32_t       released = 0;
+  uint64_t       readerEpoch;
+  int            idx;
+
+  __sync_synchronize();
+  for (idx = 0; idx < EPOCH_MAX_READERS; idx++)
+  {
+    readerEpoch = self->readers[idx];
+    if ((readerEpoch != 0) && (readerEpoch < oldest))
+    {
+      oldest = readerEpoch;
+    }
+  }
+
+  // The list is sorted newest first, everything behind the first element that
+  // was retired before the oldest reader entered can be released.
+  link = &self->retired;
+  while ((*link != NULL) && ((*link)->epoch >= oldest))
+  {
+    link = &(*link)->next;
+  }
+  retired = *link;
+  *link   = NULL;
+  while (retired != NULL)
+  {
+    EpochRetired* next = retired->next;
+    retired->release(retired->data);
+    free(retired);
+    retired = next;
+    released++;
+  }
+  self->noRetired -= released;
+
+  return released;
+}
+
+/**
+ * Wait until all readers that entered before this call left their epoch.
+ *
+ * @param self The domain.
+ */
+void synchronizeEpoch(EpochDomain* self)
+{
+  uint64_t target = __sync_fetch_and_add(&self->epoch, 1);
+  uint64_t readerEpoch;
+  int      idx;
+
+  __sync_synchronize();
+  for (idx = 0; idx < EPOCH_MAX_READERS; idx++)
+  {
+    readerEpoch = self->readers[idx];
+    while ((readerEpoch != 0) && (readerEpoch <= target))
+    {
+      sched_yield();
+      readerEpoch = self->readers[idx];
+    }
+  }
+}
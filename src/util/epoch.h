@@ -0,0 +1,129 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Epoch based memory reclamation. Readers access shared data without locking
+ * while they are within an epoch. Writers, which must be serialized by the
+ * caller, unlink data and retire it. Retired data is released once no reader
+ * that might still see it remains within its epoch.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __EPOCH_H__
+#define __EPOCH_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** The maximum number of threads that can read at the same time. Threads
+ * that do not get a reader slot have to use the locked path. */
+#define EPOCH_MAX_READERS 64
+
+/** The function that releases retired data. */
+typedef void (*EpochReleaseFunc)(void* data);
+
+/** A retired data element. */
+typedef struct _EpochRetired {
+  void*                 data;    // The retired data
+  EpochReleaseFunc      release; // The function that releases the data
+  uint64_t              epoch;   // The epoch the data was retired in
+  struct _EpochRetired* next;    // The element retired before this one
+} EpochRetired;
+
+/** The epoch domain shared by the readers and writers of a data structure. */
+typedef struct {
+  /** The current epoch, starts with 1. */
+  volatile uint64_t epoch;
+  /** The epoch each reader slot entered or 0 if the slot is not reading. */
+  volatile uint64_t readers[EPOCH_MAX_READERS];
+  /** The retired data, newest first. Only accessed by the writer. */
+  EpochRetired*     retired;
+  /** The number of retired elements not released yet. */
+  uint32_t          noRetired;
+} EpochDomain;
+
+/**
+ * Initializes the epoch domain.
+ *
+ * @param self The domain to be initialized.
+ */
+void initEpochDomain(EpochDomain* self);
+
+/**
+ * Releases all retired data of the domain. No reader must be within the
+ * domain anymore.
+ *
+ * @param self The domain.
+ */
+void releaseEpochDomain(EpochDomain* self);
+
+/**
+ * Enter the current epoch. Until leaveEpoch is called, no data reachable by
+ * the calling thread is released. Calls can not be nested.
+ *
+ * @param self The domain.
+ *
+ * @return false if no reader slot is available for the calling thread. In
+ *         this case the caller must not access the data without lock.
+ */
+bool enterEpoch(EpochDomain* self);
+
+/**
+ * Leave the epoch entered with enterEpoch.
+ *
+ * @param self The domain.
+ */
+void leaveEpoch(EpochDomain* self);
+
+/**
+ * Retire the given data. The data MUST already be unlinked, new readers must
+ * not be able to find it anymore. It is released once all readers that
+ * possibly see it left their epoch. Must be called by the writer only.
+ *
+ * @param self The domain.
+ * @param data The data to be retired.
+ * @param release The function that releases the data.
+ */
+void retireEpochData(EpochDomain* self, void* data, EpochReleaseFunc release);
+
+/**
+ * Release all retired data no reader can see anymore. Must be called by the
+ * writer only.
+ *
+ * @param self The domain.
+ *
+ * @return The number of elements released.
+ */
+uint32_t reclaimEpochData(EpochDomain* self);
+
+/**
+ * Wait until all readers that entered before this call left their epoch.
+ *
+ * @param self The domain.
+ */
+void synchronizeEpoch(EpochDomain* self);
+
+#endif // __EPOCH_H__
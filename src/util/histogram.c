@@ -0,0 +1,210 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Lock free histogram with logarithmic buckets. Each thread picks its shard
+ * once, round robin.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#include <string.h>
+#include "util/histogram.h"
+
+/** The shard the next new thread gets. */
+static volatile uint32_t _nextShard = 0;
+/** The shard of the calling thread, -1 if none is assigned yet. */
+static __thread int      _shard = -1;
+
+/**
+ * Return the bucket of the given value.
+ *
+ * @param value The value.
+ *
+ * @return The bucket index.
+ */
+static inline uint32_t _getBucket(uint64_t value)
+{
+  int exp;
+
+  if (value < HISTOGRAM_SUB_BUCKETS)
+  {
+    return (uint32_t)value;
+  }
+  exp = 63 - __builtin_clzll(value);
+  if (exp > HISTOGRAM_MAX_BITS)
+  {
+    return HISTOGRAM_BUCKETS - 1;
+  }
+  return (exp - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS
+         + (uint32_t)(value >> (exp - HISTOGRAM_SUB_BITS))
+         - HISTOGRAM_SUB_BUCKETS;
+}
+
+/**
+ * Return the largest value that falls into the given bucket.
+ *
+ * @param bucket The bucket index.
+ *
+ * @return The upper bound of the bucket.
+ */
+static uint64_t _getBucketLimit(uint32_t bucket)
+{
+  uint32_t exp;
+  uint64_t width;
+
+  if (bucket < HISTOGRAM_SUB_BUCKETS)
+  {
+    return bucket;
+  }
+  exp   = bucket / HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BITS - 1;
+  width = 1ULL << (exp - HISTOGRAM_SUB_BITS);
+  return (uint64_t)(bucket % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS)
+         * width + width - 1;
+}
+
+/**
+ * Initializes the histogram, all counters are zero.
+ *
+ * @param self The histogram.
+ */
+void initHistogram(Histogram* self)
+{
+  memset(self, 0, sizeof(Histogram));
+}
+
+/**
+ * Record the given value. Does not lock, can be called by any thread.
+ *
+ * @param self The histogram.
+ * @param value The value.
+ */
+void recordHistogram(Histogram* self, uint64_t value)
+{
+  HistogramShard* shard;
+  uint64_t        max;
+
+  if (_shard == -1)
+  {
+    _shard = __sync_fetch_and_add(&_nextShard, 1) % HISTOGRAM_SHARDS;
+  }
+  shard = &self->shards[_shard];
+
+  __sync_add_and_fetch(&shard->counts[_getBucket(value)], 1);
+  __sync_add_and_fetch(&shard->count, 1);
+  __sync_add_and_fetch(&shard->sum, value);
+  max = shard->max;
+  while ((value > max)
+         && !__sync_bool_compare_and_swap(&shard->max, max, value))
+  {
+    max = shard->max;
+  }
+}
+
+/**
+ * Set all counters back to zero. Values recorded concurrently might be lost
+ * or counted partially.
+ *
+ * @param self The histogram.
+ */
+void resetHistogram(Histogram* self)
+{
+  memset(self, 0, sizeof(Histogram));
+  __sync_synchronize();
+}
+
+/**
+ * Merge the shards of the histogram into the given snapshot.
+ *
+ * @param self The histogram.
+ * @param snapshot (out) The snapshot.
+ */
+void getHistogramSnapshot(Histogram* self, HistogramSnapshot* snapshot)
+{
+  HistogramShard* shard;
+  int             idx, bucket;
+
+  memset(snapshot, 0, sizeof(HistogramSnapshot));
+  for (idx = 0; idx < HISTOGRAM_SHARDS; idx++)
+  {
+    shard = &self->shards[idx];
+    for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+    {
+      snapshot->counts[bucket] += shard->counts[bucket];
+      snapshot->count          += shard->counts[bucket];
+    }
+    snapshot->sum += shard->sum;
+    if (shard->max > snapshot->max)
+    {
+      snapshot->max = shard->max;
+    }
+  }
+}
+
+/**
+ * Return the value below which the given share of the values of the snapshot
+ * lies. The value is the upper bound of the bucket it was found in.
+ *
+ * @param snapshot The snapshot.
+ * @param perMil The share in per mil (500 = median, 999 = 99.9%).
+ *
+ * @return The value or 0 if the snapshot is empty.
+ */
+uint64_t getHistogramPercentile(HistogramSnapshot* snapshot, uint32_t perMil)
+{
+  uint64_t rank;
+  uint64_t sum = 0;
+  uint64_t limit;
+  uint32_t bucket;
+
+  if (snapshot->count == 0)
+  {
+    return 0;
+  }
+  rank = (snapshot->count * perMil + 999) / 1000;
+  rank = rank == 0 ? 1 : rank;
+  for (bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++)
+  {
+    sum += snapshot->counts[bucket];
+    if (sum >= rank)
+    {
+      limit = _getBucketLimit(bucket);
+      return limit < snapshot->max ? limit : snapshot->max;
+    }
+  }
+  return snapshot->max;
+}
+
+/**
+ * Return the average of all values of the snapshot.
+ *
+ * @param snapshot The snapshot.
+ *
+ * @return The average or 0 if the snapshot is empty.
+ */
+uint64_t getHistogramMean(HistogramSnapshot* snapshot)
+{
+  return snapshot->count > 0 ? snapshot->sum / snapshot->count : 0;
+}
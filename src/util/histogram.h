@@ -0,0 +1,134 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Lock free histogram with logarithmic buckets. Each power of two is split
+ * into HISTOGRAM_SUB_BUCKETS linear buckets, the relative error of a value
+ * read back is below 1 / HISTOGRAM_SUB_BUCKETS. Recording threads write into
+ * one of HISTOGRAM_SHARDS shards to keep them off each other's cache lines,
+ * readers merge the shards into a snapshot.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include <stdint.h>
+
+/** The number of bits of the linear part of a bucket. */
+#define HISTOGRAM_SUB_BITS     4
+/** The number of linear buckets per power of two. */
+#define HISTOGRAM_SUB_BUCKETS  (1 << HISTOGRAM_SUB_BITS)
+/** The largest power of two recorded, larger values go into the last bucket.
+ * For nano seconds this is about 18 minutes. */
+#define HISTOGRAM_MAX_BITS     40
+/** The number of buckets. */
+#define HISTOGRAM_BUCKETS      \
+          ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 2) * HISTOGRAM_SUB_BUCKETS)
+/** The number of shards the recording threads are spread over. */
+#define HISTOGRAM_SHARDS       8
+
+/** One shard of a histogram. */
+typedef struct {
+  /** The number of values per bucket. */
+  volatile uint64_t counts[HISTOGRAM_BUCKETS];
+  /** The number of values recorded. */
+  volatile uint64_t count;
+  /** The sum of all values recorded. */
+  volatile uint64_t sum;
+  /** The largest value recorded. */
+  volatile uint64_t max;
+} HistogramShard;
+
+/** The histogram. */
+typedef struct {
+  HistogramShard shards[HISTOGRAM_SHARDS];
+} Histogram;
+
+/** The merged content of a histogram at one point in time. */
+typedef struct {
+  /** The number of values per bucket. */
+  uint64_t counts[HISTOGRAM_BUCKETS];
+  /** The number of values recorded. */
+  uint64_t count;
+  /** The sum of all values recorded. */
+  uint64_t sum;
+  /** The largest value recorded. */
+  uint64_t max;
+} HistogramSnapshot;
+
+/**
+ * Initializes the histogram, all counters are zero.
+ *
+ * @param self The histogram.
+ */
+void initHistogram(Histogram* self);
+
+/**
+ * Record the given value. Does not lock, can be called by any thread.
+ *
+ * @param self The histogram.
+ * @param value The value.
+ */
+void recordHistogram(Histogram* self, uint64_t value);
+
+/**
+ * Set all counters back to zero. Values recorded concurrently might be lost
+ * or counted partially.
+ *
+ * @param self The histogram.
+ */
+void resetHistogram(Histogram* self);
+
+/**
+ * Merge the shards of the histogram into the given snapshot.
+ *
+ * @param self The histogram.
+ * @param snapshot (out) The snapshot.
+ */
+void getHistogramSnapshot(Histogram* self, HistogramSnapshot* snapshot);
+
+/**
+ * Return the value below which the given share of the values of the snapshot
+ * lies. The value is the upper bound of the bucket it was found in.
+ *
+ * @param snapshot The snapshot.
+ * @param perMil The share in per mil (500 = median, 999 = 99.9%).
+ *
+ * @return The value or 0 if the snapshot is empty.
+ */
+uint64_t getHistogramPercentile(HistogramSnapshot* snapshot, uint32_t perMil);
+
+/**
+ * Return the average of all values of the snapshot.
+ *
+ * @param snapshot The snapshot.
+ *
+ * @return The average or 0 if the snapshot is empty.
+ */
+uint64_t getHistogramMean(HistogramSnapshot* snapshot);
+
+#endif // !__HISTOGRAM_H__
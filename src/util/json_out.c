@@ -0,0 +1,274 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "util/json_out.h"
+
+/** The initial size of the output buffer. */
+#define JSON_OUT_INIT_CAPACITY 4096
+
+/**
+ * Make sure the buffer can take the given number of additional bytes.
+ *
+ * @param self Instance
+ * @param len The number of bytes needed.
+ *
+ * @return false if the memory could not be allocated.
+ */
+static bool _reserve(JSONOut* self, size_t len)
+{
+  size_t newCap;
+  char*  newBuf;
+
+  if (self->failed)
+  {
+    return false;
+  }
+  if (self->size + len + 1 <= self->capacity)
+  {
+    return true;
+  }
+
+  newCap = self->capacity == 0 ? JSON_OUT_INIT_CAPACITY : self->capacity;
+  while (newCap < self->size + len + 1)
+  {
+    newCap *= 2;
+  }
+  newBuf = realloc(self->buffer, newCap);
+  if (newBuf == NULL)
+  {
+    self->failed = true;
+    return false;
+  }
+  self->buffer   = newBuf;
+  self->capacity = newCap;
+
+  return true;
+}
+
+/**
+ * Append formatted output.
+ *
+ * @param self Instance
+ * @param fmt The format string.
+ */
+static void _append(JSONOut* self, const char* fmt, ...)
+{
+  va_list ap;
+  int     len;
+
+  if (!_reserve(self, 64))
+  {
+    return;
+  }
+
+  va_start(ap, fmt);
+  len = vsnprintf(self->buffer + self->size, self->capacity - self->size,
+                  fmt, ap);
+  va_end(ap);
+
+  if (len < 0)
+  {
+    self->failed = true;
+  }
+  else if (self->size + len < self->capacity)
+  {
+    self->size += len;
+  }
+  else if (_reserve(self, len))
+  {
+    va_start(ap, fmt);
+    vsnprintf(self->buffer + self->size, self->capacity - self->size, fmt, ap);
+    va_end(ap);
+    self->size += len;
+  }
+}
+
+/**
+ * Append the separator and member name for the next value.
+ *
+ * @param self Instance
+ * @param name The member name or NULL.
+ */
+static void _beginValue(JSONOut* self, const char* name)
+{
+  if (self->depth > 0)
+  {
+    if (!self->first[self->depth - 1])
+    {
+      _append(self, ",");
+    }
+    self->first[self->depth - 1] = false;
+  }
+  if (name != NULL)
+  {
+    _append(self, "\"%s\":", name);
+  }
+}
+
+/**
+ * Open an object or array.
+ *
+ * @param self Instance
+ * @param name The member name or NULL.
+ * @param bracket The opening bracket.
+ */
+static void _open(JSONOut* self, const char* name, char bracket)
+{
+  _beginValue(self, name);
+  if (self->depth >= JSON_OUT_MAX_DEPTH)
+  {
+    self->failed = true;
+    return;
+  }
+  _append(self, "%c", bracket);
+  self->first[self->depth++] = true;
+}
+
+/**
+ * Close an object or array, closing the outermost ends the line.
+ *
+ * @param self Instance
+ * @param bracket The closing bracket.
+ */
+static void _close(JSONOut* self, char bracket)
+{
+  if (self->depth == 0)
+  {
+    self->failed = true;
+    return;
+  }
+  self->depth--;
+  _append(self, self->depth == 0 ? "%c\n" : "%c", bracket);
+}
+
+void initJSONOut(JSONOut* self, FILE* stream)
+{
+  memset(self, 0, sizeof(JSONOut));
+  self->stream = stream;
+}
+
+void releaseJSONOut(JSONOut* self)
+{
+  if (self != NULL)
+  {
+    free(self->buffer);
+    self->buffer   = NULL;
+    self->size     = 0;
+    self->capacity = 0;
+  }
+}
+
+bool flushJSONOut(JSONOut* self)
+{
+  bool ok = !self->failed;
+
+  if (ok && self->size > 0)
+  {
+    ok = fwrite(self->buffer, 1, self->size, self->stream) == self->size;
+  }
+  self->size = 0;
+
+  return ok;
+}
+
+size_t getJSONOutSize(JSONOut* self)
+{
+  return self->size;
+}
+
+void openJSONObject(JSONOut* self, const char* name)
+{
+  _open(self, name, '{');
+}
+
+void closeJSONObject(JSONOut* self)
+{
+  _close(self, '}');
+}
+
+void openJSONArray(JSONOut* self, const char* name)
+{
+  _open(self, name, '[');
+}
+
+void closeJSONArray(JSONOut* self)
+{
+  _close(self, ']');
+}
+
+void addJSONStr(JSONOut* self, const char* name, const char* str)
+{
+  const char* pos;
+
+  _beginValue(self, name);
+  _append(self, "\"");
+  for (pos = str; *pos != '\0'; pos++)
+  {
+    if (*pos == '"' || *pos == '\\')
+    {
+      _append(self, "\\%c", *pos);
+    }
+    else if ((unsigned char)*pos < 0x20)
+    {
+      _append(self, "\\u%04x", (unsigned char)*pos);
+    }
+    else
+    {
+      _append(self, "%c", *pos);
+    }
+  }
+  _append(self, "\"");
+}
+
+void addJSONBool(JSONOut* self, const char* name, bool flag)
+{
+  _beginValue(self, name);
+  _append(self, flag ? "true" : "false");
+}
+
+void addJSONInt(JSONOut* self, const char* name, int value)
+{
+  _beginValue(self, name);
+  _append(self, "%d", value);
+}
+
+void addJSONU32(JSONOut* self, const char* name, uint32_t value)
+{
+  _beginValue(self, name);
+  _append(self, "%u", value);
+}
+
+void addJSONH32(JSONOut* self, const char* name, uint32_t value)
+{
+  _beginValue(self, name);
+  _append(self, "\"0x%08X\"", value);
+}
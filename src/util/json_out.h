@@ -0,0 +1,186 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * A primitive collection of functions to create JSON lines (one JSON object
+ * per line). The output is collected in memory and only written into the
+ * stream with flushJSONOut. This allows to generate the output while holding
+ * a lock and to write it after the lock is released.
+ *
+ * Example:
+ * @code
+ * JSONOut out;
+ *
+ * initJSONOut(&out, stdout);
+ * openJSONObject(&out, NULL);
+ *   addJSONStr(&out, "name", "child-a");
+ *   openJSONArray(&out, "ids");
+ *     addJSONU32(&out, NULL, 123);
+ *   closeJSONArray(&out);
+ * closeJSONObject(&out);   // ends the line
+ * flushJSONOut(&out);
+ * releaseJSONOut(&out);
+ * @endcode
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __JSON_OUT_H__
+#define __JSON_OUT_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** The maximum nesting of objects and arrays. */
+#define JSON_OUT_MAX_DEPTH 8
+
+/**
+ * A single JSON Out(put) instance.
+ *
+ * @note Do not modify
+ */
+typedef struct {
+  // Argument
+  FILE*  stream;
+
+  // Internal
+  char*  buffer;
+  size_t size;
+  size_t capacity;
+  int    depth;
+  bool   first[JSON_OUT_MAX_DEPTH];
+  bool   failed;
+} JSONOut;
+
+/**
+ * Initializes the JSON Out.
+ *
+ * @param self Variable that should be initialized
+ * @param stream The JSON will be written to this output stream
+ */
+void initJSONOut(JSONOut* self, FILE* stream);
+
+/**
+ * Frees all allocated resources. Output not flushed is dropped.
+ *
+ * @param self Instance
+ */
+void releaseJSONOut(JSONOut* self);
+
+/**
+ * Write the collected output into the stream.
+ *
+ * @param self Instance
+ *
+ * @return false if the output could not be generated or written.
+ */
+bool flushJSONOut(JSONOut* self);
+
+/**
+ * Return the number of bytes collected and not flushed yet.
+ *
+ * @param self Instance
+ *
+ * @return The number of bytes.
+ */
+size_t getJSONOutSize(JSONOut* self);
+
+/**
+ * Opens an object. Closing the outermost object ends the line.
+ *
+ * @param self Instance
+ * @param name The member name or NULL within an array or on top level.
+ */
+void openJSONObject(JSONOut* self, const char* name);
+
+/**
+ * Closes an object.
+ *
+ * @param self Instance
+ */
+void closeJSONObject(JSONOut* self);
+
+/**
+ * Opens an array.
+ *
+ * @param self Instance
+ * @param name The member name or NULL within an array.
+ */
+void openJSONArray(JSONOut* self, const char* name);
+
+/**
+ * Closes an array.
+ *
+ * @param self Instance
+ */
+void closeJSONArray(JSONOut* self);
+
+/**
+ * Adds a string. The characters " and \ are escaped.
+ *
+ * @param self Instance
+ * @param name The member name or NULL within an array.
+ * @param str String value
+ */
+void addJSONStr(JSONOut* self, const char* name, const char* str);
+
+/**
+ * Adds a boolean.
+ *
+ * @param self Instance
+ * @param name The member name or NULL within an array.
+ * @param flag \c true / \c false
+ */
+void addJSONBool(JSONOut* self, const char* name, bool flag);
+
+/**
+ * Adds an integer.
+ *
+ * @param self Instance
+ * @param name The member name or NULL within an array.
+ * @param value Integer value
+ */
+void addJSONInt(JSONOut* self, const char* name, int value);
+
+/**
+ * Adds an unsigned 32-bit integer.
+ *
+ * @param self Instance
+ * @param name The member name or NULL within an array.
+ * @param value Integer value
+ */
+void addJSONU32(JSONOut* self, const char* name, uint32_t value);
+
+/**
+ * Adds a 32-bit integer as hex string ("0x0000ABCD").
+ *
+ * @param self Instance
+ * @param name The member name or NULL within an array.
+ * @param value Integer value
+ */
+void addJSONH32(JSONOut* self, const char* name, uint32_t value);
+
+#endif // !__JSON_OUT_H__
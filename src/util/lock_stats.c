@@ -0,0 +1,351 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Contention statistics of named locks. The locks are found by address in an
+ * open addressing table that is only written while holding the name mutex,
+ * lookups do not lock.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "util/lock_stats.h"
+
+#ifdef LOCK_STATS
+
+/** The statistics of all locks of one name. */
+typedef struct {
+  const char*       name;
+  uint32_t          noLocks;
+  volatile uint64_t shared;
+  volatile uint64_t contended;
+  Histogram         wait;
+  Histogram         hold;
+} LockStats;
+
+/** One named lock. */
+typedef struct {
+  /** The lock, NULL if the slot was never used. A slot keeps its lock after
+   * the name is cleared to not break the probe chains. */
+  void* volatile      lock;
+  /** The statistics or NULL if the lock is not recorded (anymore). */
+  LockStats* volatile stats;
+  /** The time the lock was acquired exclusively, 0 if not held. */
+  volatile uint64_t   lockedAt;
+} LockSlot;
+
+static pthread_mutex_t _nameMutex = PTHREAD_MUTEX_INITIALIZER;
+static LockStats*      _names[LOCK_STATS_MAX_NAMES];
+static uint32_t        _noNames = 0;
+static LockSlot        _slots[LOCK_STATS_SLOTS];
+
+/**
+ * Return the first slot to probe for the given lock.
+ *
+ * @param lock The lock.
+ *
+ * @return The slot index.
+ */
+static inline uint32_t _hashLock(void* lock)
+{
+  uint64_t addr = (uint64_t)(uintptr_t)lock;
+  return (uint32_t)((addr * 0x9E3779B97F4A7C15ULL) >> 32)
+         & (LOCK_STATS_SLOTS - 1);
+}
+
+/**
+ * Find the slot of the given lock.
+ *
+ * @param lock The lock.
+ *
+ * @return The slot or NULL if the lock never had a name.
+ */
+static LockSlot* _findSlot(void* lock)
+{
+  uint32_t idx = _hashLock(lock);
+  uint32_t probe;
+  void*    slotLock;
+
+  for (probe = 0; probe < LOCK_STATS_SLOTS; probe++)
+  {
+    slotLock = _slots[idx].lock;
+    if (slotLock == lock)
+    {
+      return &_slots[idx];
+    }
+    if (slotLock == NULL)
+    {
+      break;
+    }
+    idx = (idx + 1) & (LOCK_STATS_SLOTS - 1);
+  }
+
+  return NULL;
+}
+
+/**
+ * Return the statistics of the given name, create them if needed. Must be
+ * called while holding the name mutex.
+ *
+ * @param name The name of the lock.
+ *
+ * @return The statistics or NULL if no more names are available.
+ */
+static LockStats* _getNameStats(const char* name)
+{
+  LockStats* stats;
+  uint32_t   idx;
+
+  for (idx = 0; idx < _noNames; idx++)
+  {
+    if (strcmp(_names[idx]->name, name) == 0)
+    {
+      return _names[idx];
+    }
+  }
+  if (_noNames == LOCK_STATS_MAX_NAMES)
+  {
+    return NULL;
+  }
+
+  stats = malloc(sizeof(LockStats));
+  if (stats != NULL)
+  {
+    memset(stats, 0, sizeof(LockStats));
+    stats->name = name;
+    initHistogram(&stats->wait);
+    initHistogram(&stats->hold);
+    _names[_noNames++] = stats;
+  }
+
+  return stats;
+}
+
+void setLockName(void* lock, const char* name)
+{
+  LockStats* stats;
+  LockSlot*  slot;
+  uint32_t   idx;
+  uint32_t   probe;
+
+  pthread_mutex_lock(&_nameMutex);
+  stats = _getNameStats(name);
+  slot  = _findSlot(lock);
+  if ((stats != NULL) && (slot == NULL))
+  {
+    // Take the first unused slot of the probe chain.
+    idx = _hashLock(lock);
+    for (probe = 0; probe < LOCK_STATS_SLOTS; probe++)
+    {
+      if (_slots[idx].lock == NULL)
+      {
+        slot = &_slots[idx];
+        break;
+      }
+      idx = (idx + 1) & (LOCK_STATS_SLOTS - 1);
+    }
+  }
+  if ((stats != NULL) && (slot != NULL))
+  {
+    if (slot->stats != NULL)
+    {
+      slot->stats->noLocks--;
+    }
+    slot->lockedAt = 0;
+    slot->stats    = stats;
+    __sync_synchronize();
+    slot->lock     = lock;
+    stats->noLocks++;
+  }
+  pthread_mutex_unlock(&_nameMutex);
+}
+
+void clearLockName(void* lock)
+{
+  LockSlot* slot;
+
+  pthread_mutex_lock(&_nameMutex);
+  slot = _findSlot(lock);
+  if ((slot != NULL) && (slot->stats != NULL))
+  {
+    slot->stats->noLocks--;
+    slot->stats = NULL;
+  }
+  pthread_mutex_unlock(&_nameMutex);
+}
+
+uint64_t getLockTime(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+void recordLockAcquire(void* lock, uint64_t waitStart, bool exclusive)
+{
+  LockSlot*  slot  = _findSlot(lock);
+  LockStats* stats = (slot != NULL) ? slot->stats : NULL;
+  uint64_t   now   = 0;
+
+  if (stats == NULL)
+  {
+    return;
+  }
+  if ((waitStart != 0) || exclusive)
+  {
+    now = getLockTime();
+  }
+  if (waitStart != 0)
+  {
+    __sync_fetch_and_add(&stats->contended, 1);
+    recordHistogram(&stats->wait, now - waitStart);
+  }
+  else
+  {
+    recordHistogram(&stats->wait, 0);
+  }
+  if (exclusive)
+  {
+    slot->lockedAt = now;
+  }
+  else
+  {
+    __sync_fetch_and_add(&stats->shared, 1);
+  }
+}
+
+void restartLockHold(void* lock)
+{
+  LockSlot* slot = _findSlot(lock);
+
+  if ((slot != NULL) && (slot->stats != NULL))
+  {
+    slot->lockedAt = getLockTime();
+  }
+}
+
+void recordLockRelease(void* lock)
+{
+  LockSlot*  slot  = _findSlot(lock);
+  LockStats* stats = (slot != NULL) ? slot->stats : NULL;
+  uint64_t   lockedAt;
+
+  if (stats == NULL)
+  {
+    return;
+  }
+  lockedAt = slot->lockedAt;
+  if (lockedAt != 0)
+  {
+    slot->lockedAt = 0;
+    recordHistogram(&stats->hold, getLockTime() - lockedAt);
+  }
+}
+
+uint32_t getLockStats(LockStatsSnapshot* stats, uint32_t max)
+{
+  uint32_t idx;
+
+  pthread_mutex_lock(&_nameMutex);
+  for (idx = 0; (idx < _noNames) && (idx < max); idx++)
+  {
+    stats[idx].name      = _names[idx]->name;
+    stats[idx].noLocks   = _names[idx]->noLocks;
+    stats[idx].shared    = _names[idx]->shared;
+    stats[idx].contended = _names[idx]->contended;
+    getHistogramSnapshot(&_names[idx]->wait, &stats[idx].wait);
+    getHistogramSnapshot(&_names[idx]->hold, &stats[idx].hold);
+  }
+  pthread_mutex_unlock(&_nameMutex);
+
+  return idx;
+}
+
+void resetLockStats(void)
+{
+  uint32_t idx;
+
+  pthread_mutex_lock(&_nameMutex);
+  for (idx = 0; idx < _noNames; idx++)
+  {
+    _names[idx]->shared    = 0;
+    _names[idx]->contended = 0;
+    resetHistogram(&_names[idx]->wait);
+    resetHistogram(&_names[idx]->hold);
+  }
+  pthread_mutex_unlock(&_nameMutex);
+}
+
+bool isLockStatsEnabled(void)
+{
+  return true;
+}
+
+#else // !LOCK_STATS
+
+void setLockName(void* lock, const char* name)
+{
+}
+
+void clearLockName(void* lock)
+{
+}
+
+uint64_t getLockTime(void)
+{
+  return 0;
+}
+
+void recordLockAcquire(void* lock, uint64_t waitStart, bool exclusive)
+{
+}
+
+void restartLockHold(void* lock)
+{
+}
+
+void recordLockRelease(void* lock)
+{
+}
+
+uint32_t getLockStats(LockStatsSnapshot* stats, uint32_t max)
+{
+  return 0;
+}
+
+void resetLockStats(void)
+{
+}
+
+bool isLockStatsEnabled(void)
+{
+  return false;
+}
+
+#endif // !LOCK_STATS
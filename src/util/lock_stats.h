@@ -0,0 +1,137 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Contention statistics of named locks. The mutex and R/W lock wrappers
+ * record for each lock that was given a name the number of acquisitions, the
+ * time spent waiting for it and the time it was held exclusively. Locks that
+ * share a name are counted together. The recording is only compiled in with
+ * LOCK_STATS (configure --enable-lock-stats), otherwise all functions but
+ * isLockStatsEnabled do nothing.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __LOCK_STATS_H__
+#define __LOCK_STATS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "util/histogram.h"
+
+/** The maximum number of different lock names. */
+#define LOCK_STATS_MAX_NAMES  32
+/** The maximum number of locks that can be named at the same time. */
+#define LOCK_STATS_SLOTS      1024
+
+/** The statistics of all locks of one name at one point in time. */
+typedef struct {
+  /** The name of the locks. */
+  const char*       name;
+  /** The number of locks currently registered with this name. */
+  uint32_t          noLocks;
+  /** The number of shared (read) acquisitions. */
+  uint64_t          shared;
+  /** The number of acquisitions that had to wait. */
+  uint64_t          contended;
+  /** The wait time of all acquisitions in nano seconds. */
+  HistogramSnapshot wait;
+  /** The time the locks were held exclusively in nano seconds. */
+  HistogramSnapshot hold;
+} LockStatsSnapshot;
+
+/**
+ * Return if the lock statistics are compiled in.
+ *
+ * @return true if the server was built with LOCK_STATS.
+ */
+bool isLockStatsEnabled(void);
+
+/**
+ * Give the lock a name. From now on its acquisitions are recorded under
+ * that name. Does nothing if the name or the lock table is exhausted.
+ *
+ * @param lock The mutex or R/W lock.
+ * @param name The name, must stay valid for the lifetime of the process.
+ */
+void setLockName(void* lock, const char* name);
+
+/**
+ * Stop recording the given lock, called when the lock is released.
+ *
+ * @param lock The mutex or R/W lock.
+ */
+void clearLockName(void* lock);
+
+/**
+ * Return the current monotonic time in nano seconds, used to time the wait
+ * of a contended acquisition.
+ *
+ * @return The time in nano seconds.
+ */
+uint64_t getLockTime(void);
+
+/**
+ * Record an acquisition of the lock. Locks without name are ignored.
+ *
+ * @param lock The mutex or R/W lock.
+ * @param waitStart The time the wait started or 0 if the lock was acquired
+ *                  without waiting.
+ * @param exclusive true for a mutex or write lock, false for a read lock.
+ */
+void recordLockAcquire(void* lock, uint64_t waitStart, bool exclusive);
+
+/**
+ * Restart the hold time of an exclusively held lock without counting an
+ * acquisition, used after a condition wait reacquired the mutex.
+ *
+ * @param lock The mutex.
+ */
+void restartLockHold(void* lock);
+
+/**
+ * Record the release of an exclusively held lock. Locks without name are
+ * ignored.
+ *
+ * @param lock The mutex or R/W lock.
+ */
+void recordLockRelease(void* lock);
+
+/**
+ * Copy the statistics of up to max lock names into the given array.
+ *
+ * @param stats (out) The array of statistics.
+ * @param max The size of the array.
+ *
+ * @return The number of names copied.
+ */
+uint32_t getLockStats(LockStatsSnapshot* stats, uint32_t max);
+
+/**
+ * Set the statistics of all locks back to zero.
+ */
+void resetLockStats(void);
+
+#endif // !__LOCK_STATS_H__
@@ -19,10 +19,23 @@
  * to set the log method at the beginning of the application - otherwise
  * eventual message will be discarded.
  *
- * @version 0.3.0.7
+ * Once the log writer is started, messages for a file or syslog are formatted
+ * into a ring buffer of the calling thread and written by the log writer 
+ * thread. The messages of one thread keep their order, the messages of 
+ * different threads might be interleaved differently than they were logged.
+ * If the ring of a thread is full, errors and warnings wait for space, all 
+ * other messages are dropped and counted.
+ *
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0 - 2026/10/15 - kyehwanl
+ *           * Added the log writer thread, see startLogWriter.
+ *           * The timestamp is kept per thread and formatted once per second.
+ *           * The active level is exported as logActiveLevel to allow the
+ *             LOG macro to skip the call for suppressed messages.
+ *           * The log writer thread is placed and named by createThread.
  * 0.3.0.7 - 2015/04/21 - oborchert
  *           * Added ChangeLog.
  * 0.1.1.0 - 2010/06/25 - borchert
@@ -34,9 +47,15 @@
  *           * Code Created
  * -----------------------------------------------------------------------------
  */
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <time.h>
 #include <syslog.h>
 #include "util/log.h"
+#include "util/thread.h"
 
 /*----------
  * Constants
@@ -45,6 +64,13 @@
 #define TIMESTAMP_MAX_LEN 18
 #define TIMESTAMP_FORMAT  "%D %I:%M.%S"
 
+/** The number of records in the ring of each thread (power of two). */
+#define LOG_RING_SIZE     256
+/** The maximum length of a message in the ring, longer ones are truncated. */
+#define LOG_RECORD_SIZE   512
+/** The time in milliseconds the log writer sleeps if all rings are empty. */
+#define LOG_WRITER_IDLE_MS 5
+
 static const char* LOG_LEVEL_TEXT[] = {
      "EMERGENCY",
      "CRITICAL",
@@ -60,10 +86,51 @@ static const char* LOG_LEVEL_TEXT[] = {
  * Global variables
  */
 
-static LogLevel _activeLevel = LEVEL_DEBUG;
-static char _tsBuf[TIMESTAMP_MAX_LEN];
+LogLevel logActiveLevel = LEVEL_DEBUG;
+static __thread char   _tsBuf[TIMESTAMP_MAX_LEN];
+static __thread time_t _tsTime = 0;
 static LogMessagePosted _callback = NULL;
 
+/*-------------------------
+ * Log writer and its rings
+ */
+
+/** A message waiting in a ring. */
+typedef struct {
+  LogLevel level;
+  char     msg[LOG_RECORD_SIZE];
+} LogRecord;
+
+/** The ring of a single thread. Only the owner moves the head, only the log
+ * writer moves the tail. */
+typedef struct _LogRing {
+  volatile uint32_t head;
+  volatile uint32_t tail;
+  /** The number of messages dropped because the ring was full. */
+  volatile uint32_t dropped;
+  /** The number of dropped messages already reported by the log writer. */
+  uint32_t          reported;
+  /** Set once the owning thread ended, the ring is freed once empty. */
+  volatile bool     orphaned;
+  struct _LogRing*  next;
+  LogRecord         records[LOG_RING_SIZE];
+} LogRing;
+
+/** The ring of the calling thread. */
+static __thread LogRing* _ring = NULL;
+/** All rings, protected by _ringMutex. */
+static LogRing*          _rings = NULL;
+static pthread_mutex_t   _ringMutex = PTHREAD_MUTEX_INITIALIZER;
+/** Used to mark the ring of an ending thread as orphaned. */
+static pthread_key_t     _ringKey;
+static pthread_once_t    _ringKeyOnce = PTHREAD_ONCE_INIT;
+
+static pthread_t         _writer;
+static volatile bool     _writerRunning = false;
+/** Wakes up the log writer before its idle time passed. */
+static pthread_mutex_t   _writerMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t    _writerCond  = PTHREAD_COND_INITIALIZER;
+
 /*--------------------
  * "_write*" variables
  */
@@ -105,6 +172,23 @@ static void _writeToSyslog (LogLevel level, const char* fmt, va_list args)
   vsyslog((int) level, fmt, args);
 }
 
+/**
+ * Pass an already formatted message to the given callback.
+ *
+ * @param cb The callback.
+ * @param level The log level.
+ * @param fmt Format string
+ * @param ... Arguments
+ */
+static void _emit (LogMessagePosted cb, LogLevel level, const char* fmt, ...)
+{
+  va_list al;
+
+  va_start(al, fmt);
+  cb(level, fmt, al);
+  va_end(al);
+}
+
 /**
  * Writes a single error message into the registered buffer.
  *
@@ -151,7 +235,7 @@ void setLogMethodToCallback (LogMessagePosted cb)
  */
 void setLogLevel (LogLevel level)
 {
-  _activeLevel = level;
+  logActiveLevel = level;
 }
 
 /**
@@ -163,7 +247,232 @@ void setLogLevel (LogLevel level)
  */
 LogLevel getLogLevel()
 {
-  return _activeLevel;
+  return logActiveLevel;
+}
+
+/**
+ * Mark the ring of an ending thread as orphaned, the log writer releases it 
+ * once all its messages are written.
+ *
+ * @param ring The ring of the thread.
+ */
+static void _orphanRing (void* ring)
+{
+  ((LogRing*)ring)->orphaned = true;
+}
+
+/**
+ * Create the key used to detect the end of a thread.
+ */
+static void _createRingKey ()
+{
+  pthread_key_create(&_ringKey, _orphanRing);
+}
+
+/**
+ * Return the ring of the calling thread, it is created with the first call.
+ *
+ * @return The ring or NULL if not enough memory is available.
+ */
+static LogRing* _getRing ()
+{
+  if (_ring == NULL)
+  {
+    pthread_once(&_ringKeyOnce, _createRingKey);
+    _ring = calloc(1, sizeof(LogRing));
+    if (_ring != NULL)
+    {
+      pthread_setspecific(_ringKey, _ring);
+      pthread_mutex_lock(&_ringMutex);
+      _ring->next = _rings;
+      _rings      = _ring;
+      pthread_mutex_unlock(&_ringMutex);
+    }
+  }
+  return _ring;
+}
+
+/**
+ * Format the message into the ring of the calling thread.
+ *
+ * @param level Log level
+ * @param fmt Format string
+ * @param args Arguments
+ *
+ * @return false if the message could not be queued and must be written
+ *         directly.
+ */
+static bool _queueRecord (LogLevel level, const char* fmt, va_list args)
+{
+  LogRing*   ring = _getRing();
+  LogRecord* record;
+
+  if (ring == NULL)
+  {
+    return false;
+  }
+  if (ring->head - ring->tail == LOG_RING_SIZE)
+  {
+    pthread_mutex_lock(&_writerMutex);
+    pthread_cond_signal(&_writerCond);
+    pthread_mutex_unlock(&_writerMutex);
+    if (level > LEVEL_WARNING)
+    {
+      ring->dropped++;
+      return true;
+    }
+    while (_writerRunning && (ring->head - ring->tail == LOG_RING_SIZE))
+    {
+      sched_yield();
+    }
+    if (ring->head - ring->tail == LOG_RING_SIZE)
+    {
+      return false;
+    }
+  }
+  record = &ring->records[ring->head & (LOG_RING_SIZE - 1)];
+  record->level = level;
+  vsnprintf(record->msg, LOG_RECORD_SIZE, fmt, args);
+  // Publish the record after it is complete.
+  __sync_synchronize();
+  ring->head++;
+
+  return true;
+}
+
+/**
+ * Write all queued messages of all rings and release the rings of ended 
+ * threads.
+ *
+ * @return true if at least one message was written.
+ */
+static bool _drainRings ()
+{
+  LogRing**  link;
+  LogRing*   ring;
+  LogRecord* record;
+  LogMessagePosted cb = _callback;
+  uint32_t   head;
+  uint32_t   dropped;
+  bool       written = false;
+
+  pthread_mutex_lock(&_ringMutex);
+  link = &_rings;
+  while (*link != NULL)
+  {
+    ring = *link;
+    head = ring->head;
+    __sync_synchronize();
+    while (ring->tail != head)
+    {
+      record = &ring->records[ring->tail & (LOG_RING_SIZE - 1)];
+      if ((cb == _writeToFile) && (_stream != NULL))
+      {
+        // Flushed once per pass
+        fprintf(_stream, "%s %s\n", LOG_LEVEL_TEXT[record->level], 
+                record->msg);
+      }
+      else if (cb != NULL)
+      {
+        _emit(cb, record->level, "%s", record->msg);
+      }
+      __sync_synchronize();
+      ring->tail++;
+      written = true;
+    }
+    dropped = ring->dropped;
+    if ((dropped != ring->reported) && (cb != NULL))
+    {
+      _emit(cb, LEVEL_WARNING, "[%s] Log ring full, %u messages dropped", 
+            logTimeStamp(), dropped - ring->reported);
+      ring->reported = dropped;
+      written = true;
+    }
+    if (ring->orphaned && (ring->tail == ring->head))
+    {
+      *link = ring->next;
+      free(ring);
+      continue;
+    }
+    link = &ring->next;
+  }
+  pthread_mutex_unlock(&_ringMutex);
+
+  if (written && (cb == _writeToFile) && (_stream != NULL))
+  {
+    fflush(_stream);
+  }
+
+  return written;
+}
+
+/**
+ * The loop of the log writer thread.
+ *
+ * @param arg Not used
+ *
+ * @return NULL
+ */
+static void* _logWriterLoop (void* arg)
+{
+  struct timespec wakeup;
+
+  while (_writerRunning)
+  {
+    if (!_drainRings())
+    {
+      clock_gettime(CLOCK_REALTIME, &wakeup);
+      wakeup.tv_nsec += LOG_WRITER_IDLE_MS * 1000000L;
+      if (wakeup.tv_nsec >= 1000000000L)
+      {
+        wakeup.tv_sec++;
+        wakeup.tv_nsec -= 1000000000L;
+      }
+      pthread_mutex_lock(&_writerMutex);
+      pthread_cond_timedwait(&_writerCond, &_writerMutex, &wakeup);
+      pthread_mutex_unlock(&_writerMutex);
+    }
+  }
+  _drainRings();
+
+  return NULL;
+}
+
+/**
+ * Start the log writer thread. From now on messages for a file or syslog are 
+ * written by the log writer.
+ *
+ * @return true if the log writer is running.
+ *
+ * @since 0.4.1.0
+ */
+bool startLogWriter ()
+{
+  if (!_writerRunning)
+  {
+    _writerRunning = true;
+    if (createThread(&_writer, NULL, THREAD_CLASS_HOUSEKEEPING, "srx-log",
+                     _logWriterLoop, NULL) != 0)
+    {
+      _writerRunning = false;
+    }
+  }
+  return _writerRunning;
+}
+
+/**
+ * Stop the log writer thread after all queued messages are written. From now
+ * on all messages are written by the calling thread.
+ *
+ * @since 0.4.1.0
+ */
+void stopLogWriter ()
+{
+  if (_writerRunning)
+  {
+    _writerRunning = false;
+    pthread_join(_writer, NULL);
+  }
 }
 
 /*
@@ -175,18 +484,28 @@ LogLevel getLogLevel()
  */
 void writeLog (LogLevel level, const char* fmt, ...)
 {
-  if ((_callback != NULL) && (level <= _activeLevel))
+  if ((_callback != NULL) && (level <= logActiveLevel))
   {
     va_list al;
+    bool    queued = false;
 
     va_start(al, fmt);
-    _callback(level, fmt, al);
+    if (   _writerRunning 
+        && ((_callback == _writeToFile) || (_callback == _writeToSyslog)))
+    {
+      queued = _queueRecord(level, fmt, al);
+    }
+    if (!queued)
+    {
+      _callback(level, fmt, al);
+    }
     va_end(al);
   }
 }
 
 /**
- * Generate the timestamp
+ * Generate the timestamp. The timestamp is kept per thread and only formatted
+ * again once the second changed.
  *
  * @return The current timestamp as formated string.
  */
@@ -194,7 +513,11 @@ const char* logTimeStamp ()
 {
   time_t now = time(NULL);
   struct tm ret_tm;
-  strftime(_tsBuf, TIMESTAMP_MAX_LEN, TIMESTAMP_FORMAT, localtime_r(&now, &ret_tm)); //--> error in quagga, due to localtime  *change into localtime_r() --KH--
+  if (now != _tsTime)
+  {
+    strftime(_tsBuf, TIMESTAMP_MAX_LEN, TIMESTAMP_FORMAT, localtime_r(&now, &ret_tm)); //--> error in quagga, due to localtime  *change into localtime_r() --KH--
+    _tsTime = now;
+  }
   return (const char*) _tsBuf;
 }
 
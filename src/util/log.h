@@ -19,10 +19,13 @@
  * to set the log method at the beginning of the application - otherwise 
  * eventual message will be discarded.
  *  
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Added startLogWriter and stopLogWriter.
+ *            * LOG only evaluates its arguments if the level is active.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  * 0.3.0.7  - 2015/04/21 - oborchert
@@ -42,6 +45,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdbool.h>
 #include <errno.h>
 
 /** 
@@ -137,6 +141,34 @@ extern void setLogLevel(LogLevel level);
  */
 extern LogLevel getLogLevel(); 
 
+/**
+ * The active log level, messages above this level are suppressed. Use 
+ * setLogLevel to change it.
+ *
+ * @since 0.4.1.0
+ */
+extern LogLevel logActiveLevel;
+
+/**
+ * Start the log writer thread. From now on messages for a file or syslog are 
+ * formatted into a ring buffer of the calling thread and written by the log 
+ * writer. The messages of different threads might be written in a different 
+ * order than they were logged.
+ *
+ * @return true if the log writer is running.
+ *
+ * @since 0.4.1.0
+ */
+extern bool startLogWriter();
+
+/**
+ * Stop the log writer thread after all queued messages are written. From now
+ * on all messages are written by the calling thread.
+ *
+ * @since 0.4.1.0
+ */
+extern void stopLogWriter();
+
 /**
  * Writes a single message. 
  * The function syntax is similar to 'printf'.
@@ -163,9 +195,11 @@ extern const char* logTimeStamp();
  * Macros
  */
 
-/** See writeLog. */
+/** See writeLog. The arguments are only evaluated if the level is active. */
 #define LOG(LEVEL, FMT, ...) \
-  writeLog(LEVEL, "[%s] " FMT, logTimeStamp(), ## __VA_ARGS__)
+  (((LEVEL) <= logActiveLevel) \
+     ? writeLog(LEVEL, "[%s] " FMT, logTimeStamp(), ## __VA_ARGS__) \
+     : (void)0)
 
 #define STRINGIFY_ARG(ARG) #ARG
 #define STRINGIFY_IND(ARG) STRINGIFY_ARG(ARG)
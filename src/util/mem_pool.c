@@ -0,0 +1,444 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ * 
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ * 
+ * We would appreciate acknowledgment if the software is used.
+ * 
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ * 
+ * 
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required 
+ * by this software.
+ *
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Code created
+ *          - 2026/10/15 - kyehwanl
+ *            * Added reserveSizeClassPool.
+ *            * Large blocks carry a header that links them into the list of
+ *              the pool.
+ *            * Account the slabs and objects under the tag of the pool.
+ */
+#include <string.h>
+#include "util/mem_pool.h"
+#include "util/log.h"
+
+/**
+ * The header of each slab. The objects follow the header.
+ */
+typedef struct _MemPoolSlab
+{
+  struct _MemPoolSlab* next;
+  // Keep the alignment of the objects.
+  uint64_t             align;
+} MemPoolSlab;
+
+/**
+ * The header of a block larger than MEM_POOL_MAX_CLASS. The block follows the
+ * header.
+ */
+typedef struct _MemPoolLarge
+{
+  struct _MemPoolLarge* next;
+  struct _MemPoolLarge* prev;
+} MemPoolLarge;
+
+/**
+ * A free object, the link uses the memory of the object itself.
+ */
+typedef struct _MemPoolFreeObj
+{
+  struct _MemPoolFreeObj* next;
+} MemPoolFreeObj;
+
+bool initMemPool(MemPool* self, size_t objSize, uint32_t objsPerSlab)
+{
+  // Each object must be able to store the free list link and be aligned.
+  if (objSize < sizeof(MemPoolFreeObj))
+  {
+    objSize = sizeof(MemPoolFreeObj);
+  }
+  objSize = (objSize + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+
+  self->objSize     = objSize;
+  self->objsPerSlab = objsPerSlab < MEM_POOL_MIN_SLAB_OBJS 
+                      ? MEM_POOL_MIN_SLAB_OBJS : objsPerSlab;
+  self->slabs       = NULL;
+  self->freeList    = NULL;
+  self->numSlabs    = 0;
+  self->used        = 0;
+  self->tag         = MEM_TAG_OTHER;
+
+  return true;
+}
+
+void setMemPoolTag(MemPool* self, MemTag tag)
+{
+  self->tag = tag;
+}
+
+/**
+ * Returns the size of one slab of the pool in bytes.
+ *
+ * @param self The memory pool
+ *
+ * @return The size of a slab including its header.
+ */
+static inline size_t _getSlabSize(MemPool* self)
+{
+  return sizeof(MemPoolSlab) + (self->objSize * self->objsPerSlab);
+}
+
+void releaseMemPool(MemPool* self)
+{
+  MemPoolSlab* slab = (MemPoolSlab*)self->slabs;
+  MemPoolSlab* next;
+
+  while (slab != NULL)
+  {
+    next = slab->next;
+    free(slab);
+    slab = next;
+  }
+  addMemStats(self->tag, -(int64_t)(_getSlabSize(self) * self->numSlabs),
+              -(int64_t)self->used);
+
+  self->slabs    = NULL;
+  self->freeList = NULL;
+  self->numSlabs = 0;
+  self->used     = 0;
+}
+
+/**
+ * Adds all objects of the given slab to the free list.
+ *
+ * @param self The memory pool
+ * @param slab The slab
+ */
+static void _addSlabToFreeList(MemPool* self, MemPoolSlab* slab)
+{
+  uint8_t*        objects = (uint8_t*)(slab + 1);
+  MemPoolFreeObj* obj;
+  int             idx;
+
+  // Link backwards so the first object of the slab is the first to be used.
+  for (idx = self->objsPerSlab - 1; idx >= 0; idx--)
+  {
+    obj = (MemPoolFreeObj*)(objects + (idx * self->objSize));
+    obj->next = (MemPoolFreeObj*)self->freeList;
+    self->freeList = obj;
+  }
+}
+
+/**
+ * Allocates one more slab for the pool.
+ *
+ * @param self The memory pool
+ *
+ * @return true if the slab could be allocated.
+ */
+static bool _growMemPool(MemPool* self)
+{
+  MemPoolSlab* slab = malloc(_getSlabSize(self));
+  if (slab == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for another memory pool slab!");
+    return false;
+  }
+  addMemStats(self->tag, _getSlabSize(self), 0);
+
+  slab->next  = (MemPoolSlab*)self->slabs;
+  self->slabs = slab;
+  self->numSlabs++;
+  _addSlabToFreeList(self, slab);
+
+  return true;
+}
+
+bool reserveMemPool(MemPool* self, uint32_t numObjs)
+{
+  while ((self->numSlabs * self->objsPerSlab) < numObjs)
+  {
+    if (!_growMemPool(self))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void* allocFromMemPool(MemPool* self)
+{
+  MemPoolFreeObj* obj;
+
+  if ((self->freeList == NULL) && !_growMemPool(self))
+  {
+    return NULL;
+  }
+
+  obj = (MemPoolFreeObj*)self->freeList;
+  self->freeList = obj->next;
+  self->used++;
+  addMemStats(self->tag, 0, 1);
+
+  return obj;
+}
+
+void freeToMemPool(MemPool* self, void* obj)
+{
+  if (obj != NULL)
+  {
+    ((MemPoolFreeObj*)obj)->next = (MemPoolFreeObj*)self->freeList;
+    self->freeList = obj;
+    self->used--;
+    addMemStats(self->tag, 0, -1);
+  }
+}
+
+void emptyMemPool(MemPool* self)
+{
+  MemPoolSlab* slab;
+
+  addMemStats(self->tag, 0, -(int64_t)self->used);
+  self->freeList = NULL;
+  self->used     = 0;
+  for (slab = (MemPoolSlab*)self->slabs; slab != NULL; slab = slab->next)
+  {
+    _addSlabToFreeList(self, slab);
+  }
+}
+
+/**
+ * Returns the size class for the given size.
+ *
+ * @param size The size in bytes
+ *
+ * @return The index of the size class or -1 if the size is larger than the 
+ *         largest size class.
+ */
+static int _getSizeClass(size_t size)
+{
+  int    idx       = 0;
+  size_t classSize = MEM_POOL_MIN_CLASS;
+
+  while (classSize < size)
+  {
+    classSize <<= 1;
+    if (++idx == MEM_POOL_SIZE_CLASSES)
+    {
+      return -1;
+    }
+  }
+
+  return idx;
+}
+
+bool initSizeClassPool(SizeClassPool* self, size_t slabSize)
+{
+  int    idx;
+  size_t classSize = MEM_POOL_MIN_CLASS;
+
+  for (idx = 0; idx < MEM_POOL_SIZE_CLASSES; idx++)
+  {
+    initMemPool(&self->classes[idx], classSize, 
+                (uint32_t)(slabSize / classSize));
+    classSize <<= 1;
+  }
+  self->largeBlocks = 0;
+  self->largeList   = NULL;
+  self->largeBytes  = 0;
+  self->tag         = MEM_TAG_OTHER;
+
+  return true;
+}
+
+void setSizeClassPoolTag(SizeClassPool* self, MemTag tag)
+{
+  int idx;
+
+  for (idx = 0; idx < MEM_POOL_SIZE_CLASSES; idx++)
+  {
+    setMemPoolTag(&self->classes[idx], tag);
+  }
+  self->tag = tag;
+}
+
+void releaseSizeClassPool(SizeClassPool* self)
+{
+  MemPoolLarge* large = (MemPoolLarge*)self->largeList;
+  MemPoolLarge* next;
+  int           idx;
+
+  for (idx = 0; idx < MEM_POOL_SIZE_CLASSES; idx++)
+  {
+    releaseMemPool(&self->classes[idx]);
+  }
+  while (large != NULL)
+  {
+    next = large->next;
+    free(large);
+    large = next;
+  }
+  addMemStats(self->tag, -(int64_t)self->largeBytes,
+              -(int64_t)self->largeBlocks);
+  self->largeBlocks = 0;
+  self->largeList   = NULL;
+  self->largeBytes  = 0;
+}
+
+/**
+ * Links the header of a large block into the list of the pool.
+ *
+ * @param self The size class pool
+ * @param large The header of the large block
+ */
+static void _linkLargeBlock(SizeClassPool* self, MemPoolLarge* large)
+{
+  large->prev = NULL;
+  large->next = (MemPoolLarge*)self->largeList;
+  if (large->next != NULL)
+  {
+    large->next->prev = large;
+  }
+  self->largeList = large;
+}
+
+/**
+ * Removes the header of a large block from the list of the pool.
+ *
+ * @param self The size class pool
+ * @param large The header of the large block
+ */
+static void _unlinkLargeBlock(SizeClassPool* self, MemPoolLarge* large)
+{
+  if (large->prev != NULL)
+  {
+    large->prev->next = large->next;
+  }
+  else
+  {
+    self->largeList = large->next;
+  }
+  if (large->next != NULL)
+  {
+    large->next->prev = large->prev;
+  }
+}
+
+bool reserveSizeClassPool(SizeClassPool* self, size_t size, 
+                          uint32_t numBlocks)
+{
+  int sizeClass = _getSizeClass(size);
+
+  if (sizeClass < 0)
+  {
+    return false;
+  }
+  numBlocks += self->classes[sizeClass].used;
+
+  return reserveMemPool(&self->classes[sizeClass], numBlocks);
+}
+
+void* allocFromSizeClassPool(SizeClassPool* self, size_t size)
+{
+  int   sizeClass = _getSizeClass(size);
+  void* block     = NULL;
+
+  if (sizeClass >= 0)
+  {
+    block = allocFromMemPool(&self->classes[sizeClass]);
+  }
+  else
+  {
+    MemPoolLarge* large = malloc(sizeof(MemPoolLarge) + size);
+    if (large != NULL)
+    {
+      _linkLargeBlock(self, large);
+      self->largeBlocks++;
+      self->largeBytes += sizeof(MemPoolLarge) + size;
+      addMemStats(self->tag, sizeof(MemPoolLarge) + size, 1);
+      block = large + 1;
+    }
+  }
+
+  return block;
+}
+
+void* reallocFromSizeClassPool(SizeClassPool* self, void* block, 
+                               size_t oldSize, size_t newSize)
+{
+  int   oldClass = _getSizeClass(oldSize);
+  int   newClass = _getSizeClass(newSize);
+  void* newBlock;
+
+  if (block == NULL)
+  {
+    return allocFromSizeClassPool(self, newSize);
+  }
+
+  if ((oldClass == newClass) && (oldClass >= 0))
+  {
+    // The block is already large enough.
+    return block;
+  }
+
+  if ((oldClass < 0) && (newClass < 0))
+  {
+    MemPoolLarge* large = (MemPoolLarge*)block - 1;
+    _unlinkLargeBlock(self, large);
+    newBlock = realloc(large, sizeof(MemPoolLarge) + newSize);
+    // The old block stays valid if it could not be resized.
+    _linkLargeBlock(self, newBlock != NULL ? newBlock : large);
+    if (newBlock != NULL)
+    {
+      self->largeBytes += newSize - oldSize;
+      addMemStats(self->tag, (int64_t)newSize - (int64_t)oldSize, 0);
+    }
+    return newBlock != NULL ? (MemPoolLarge*)newBlock + 1 : NULL;
+  }
+
+  newBlock = allocFromSizeClassPool(self, newSize);
+  if (newBlock != NULL)
+  {
+    memcpy(newBlock, block, oldSize < newSize ? oldSize : newSize);
+    freeToSizeClassPool(self, block, oldSize);
+  }
+
+  return newBlock;
+}
+
+void freeToSizeClassPool(SizeClassPool* self, void* block, size_t size)
+{
+  int sizeClass;
+
+  if (block != NULL)
+  {
+    sizeClass = _getSizeClass(size);
+    if (sizeClass >= 0)
+    {
+      freeToMemPool(&self->classes[sizeClass], block);
+    }
+    else
+    {
+      _unlinkLargeBlock(self, (MemPoolLarge*)block - 1);
+      free((MemPoolLarge*)block - 1);
+      self->largeBlocks--;
+      self->largeBytes -= sizeof(MemPoolLarge) + size;
+      addMemStats(self->tag, -(int64_t)(sizeof(MemPoolLarge) + size), -1);
+    }
+  }
+}
@@ -0,0 +1,243 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ * 
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ * 
+ * We would appreciate acknowledgment if the software is used.
+ * 
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ * 
+ * 
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required 
+ * by this software.
+ *
+ * A slab allocator for objects of a fixed size and a size-classed pool that
+ * serves variable sized memory blocks from a set of slab allocators. Both
+ * avoid one malloc per object and keep objects of the same kind close to each
+ * other which reduces heap fragmentation of long running processes.
+ *
+ * @note Not thread-safe! The caller has to provide the synchronization.
+ *
+ * Usage example (w/o checking for errors):
+ * @code
+ * MemPool pool;
+ * MyStruct* sptr;
+ *
+ * initMemPool(&pool, sizeof(MyStruct), 1024);
+ * sptr = allocFromMemPool(&pool);
+ * :
+ * freeToMemPool(&pool, sptr);
+ * releaseMemPool(&pool);
+ * @endcode
+ *
+ * Uses log.h to report error messages
+ * 
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Code created
+ *          - 2026/10/15 - kyehwanl
+ *            * Added reserveSizeClassPool.
+ *            * The size class pool keeps its large blocks listed, releasing
+ *              the pool frees them as well.
+ *            * Account the slabs and objects under the tag of the pool.
+ * 
+ */
+#ifndef __MEM_POOL_H__
+#define __MEM_POOL_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "util/mem_stats.h"
+
+/** The number of size classes of a SizeClassPool. */
+#define MEM_POOL_SIZE_CLASSES  10
+/** The smallest size class in bytes. */
+#define MEM_POOL_MIN_CLASS     8
+/** The largest size class in bytes, larger blocks are allocated via malloc. */
+#define MEM_POOL_MAX_CLASS     (MEM_POOL_MIN_CLASS << (MEM_POOL_SIZE_CLASSES-1))
+/** The minimum number of objects per slab. */
+#define MEM_POOL_MIN_SLAB_OBJS 16
+
+/**
+ * A slab allocator for objects of a fixed size.
+ */
+typedef struct
+{
+  size_t   objSize;     ///< The size of each object (aligned)
+  uint32_t objsPerSlab; ///< Number of objects allocated with one slab
+  void*    slabs;       ///< The list of allocated slabs
+  void*    freeList;    ///< The list of free objects
+  uint32_t numSlabs;    ///< The number of slabs allocated
+  uint32_t used;        ///< The number of objects currently in use
+  MemTag   tag;         ///< The tag the memory is accounted for
+} MemPool;
+
+/**
+ * A pool of slab allocators, one per power of two size class.
+ */
+typedef struct
+{
+  MemPool classes[MEM_POOL_SIZE_CLASSES]; ///< The size classes
+  uint32_t largeBlocks;                   ///< Blocks allocated via malloc
+  void*    largeList;                     ///< The list of the large blocks
+  size_t   largeBytes;                    ///< The size of the large blocks
+  MemTag   tag;                           ///< The tag of the large blocks
+} SizeClassPool;
+
+/**
+ * Initializes an empty pool.
+ *
+ * @param self The memory pool
+ * @param objSize The size of each object in bytes
+ * @param objsPerSlab The number of objects allocated at once
+ *
+ * @return true if the pool could be initialized.
+ */
+extern bool initMemPool(MemPool* self, size_t objSize, uint32_t objsPerSlab);
+
+/**
+ * Sets the tag the slabs and objects of the pool are accounted for. The
+ * tag of a new pool is MEM_TAG_OTHER. Must be set before the first slab is
+ * allocated.
+ *
+ * @param self The memory pool
+ * @param tag The tag
+ *
+ * @since 0.4.1.0
+ */
+extern void setMemPoolTag(MemPool* self, MemTag tag);
+
+/**
+ * Frees all slabs of the pool. All objects of the pool become invalid.
+ *
+ * @param self The memory pool
+ */
+extern void releaseMemPool(MemPool* self);
+
+/**
+ * Pre-allocates enough slabs to serve the given number of objects without
+ * any further allocation.
+ *
+ * @param self The memory pool
+ * @param numObjs The number of objects
+ *
+ * @return true if the memory could be reserved.
+ */
+extern bool reserveMemPool(MemPool* self, uint32_t numObjs);
+
+/**
+ * Returns a (not initialized) object of the pool.
+ *
+ * @param self The memory pool
+ *
+ * @return The object or NULL if not enough memory is available.
+ */
+extern void* allocFromMemPool(MemPool* self);
+
+/**
+ * Returns the given object back to the pool.
+ *
+ * @param self The memory pool
+ * @param obj The object, must be allocated from this pool. May be NULL.
+ */
+extern void freeToMemPool(MemPool* self, void* obj);
+
+/**
+ * Marks all objects as free without releasing the slabs.
+ *
+ * @param self The memory pool
+ */
+extern void emptyMemPool(MemPool* self);
+
+/**
+ * Initializes the size class pool.
+ *
+ * @param self The size class pool
+ * @param slabSize The desired size of a slab in bytes.
+ *
+ * @return true if the pool could be initialized.
+ */
+extern bool initSizeClassPool(SizeClassPool* self, size_t slabSize);
+
+/**
+ * Sets the tag the memory of all size classes and the large blocks is
+ * accounted for. Must be set before the first block is allocated.
+ *
+ * @param self The size class pool
+ * @param tag The tag
+ *
+ * @since 0.4.1.0
+ */
+extern void setSizeClassPoolTag(SizeClassPool* self, MemTag tag);
+
+/**
+ * Frees all memory of the pool, blocks larger than MEM_POOL_MAX_CLASS
+ * included. All blocks of the pool become invalid.
+ *
+ * @param self The size class pool
+ */
+extern void releaseSizeClassPool(SizeClassPool* self);
+
+/**
+ * Pre-allocates enough slabs in the size class of the given size to serve the
+ * given number of blocks without any further allocation. Blocks larger than
+ * MEM_POOL_MAX_CLASS can not be reserved.
+ *
+ * @param self The size class pool
+ * @param size The size of each block in bytes
+ * @param numBlocks The number of blocks
+ *
+ * @return true if the memory could be reserved.
+ */
+extern bool reserveSizeClassPool(SizeClassPool* self, size_t size, 
+                                 uint32_t numBlocks);
+
+/**
+ * Returns a memory block of at least the given size.
+ *
+ * @param self The size class pool
+ * @param size The requested size in bytes, must be > 0
+ *
+ * @return The memory block or NULL.
+ */
+extern void* allocFromSizeClassPool(SizeClassPool* self, size_t size);
+
+/**
+ * Resizes a block allocated from this pool. The content is preserved up to the
+ * smaller of both sizes. In case both sizes belong to the same size class the 
+ * given block is returned.
+ *
+ * @param self The size class pool
+ * @param block The existing block or NULL
+ * @param oldSize The size that was used to allocate the block
+ * @param newSize The new size, must be > 0
+ *
+ * @return The (new) block or NULL, in the later case the old block remains 
+ *         valid.
+ */
+extern void* reallocFromSizeClassPool(SizeClassPool* self, void* block, 
+                                      size_t oldSize, size_t newSize);
+
+/**
+ * Returns the given block back to the pool.
+ *
+ * @param self The size class pool
+ * @param block The block, may be NULL
+ * @param size The size that was used to allocate the block
+ */
+extern void freeToSizeClassPool(SizeClassPool* self, void* block, size_t size);
+
+#endif // !__MEM_POOL_H__
@@ -0,0 +1,162 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Memory accounting by subsystem. The changes of a thread are kept in a
+ * thread local array and added to the shared counters with atomic operations.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "util/mem_stats.h"
+
+/** The changes of a thread that are not added to the shared counters yet. */
+typedef struct {
+  int64_t bytes[NUM_MEM_TAGS];
+  int64_t objects[NUM_MEM_TAGS];
+} MemStatsDelta;
+
+/** The shared counters. */
+static volatile int64_t _bytes[NUM_MEM_TAGS];
+static volatile int64_t _objects[NUM_MEM_TAGS];
+static volatile int64_t _maxBytes[NUM_MEM_TAGS];
+
+/** The changes of the calling thread. */
+static __thread MemStatsDelta _delta;
+/** Set once the thread registered the flush at its end. */
+static __thread bool          _deltaKeySet = false;
+/** The key used to flush the changes when a thread ends. */
+static pthread_key_t          _deltaKey;
+/** Creates the key once. */
+static pthread_once_t         _deltaOnce = PTHREAD_ONCE_INIT;
+
+/** The names of the tags. */
+static const char* _tagNames[NUM_MEM_TAGS] = {
+  "other", "updates", "blobs", "clients", "prefixes", "command-queue",
+  "receive", "send-queue", "rtr-buffers"
+};
+
+/**
+ * Add the changes of the calling thread for the given tag to the shared
+ * counters and raise the high-water mark if needed.
+ *
+ * @param tag The subsystem.
+ */
+static void _flushTag(MemTag tag)
+{
+  int64_t bytes;
+  int64_t max;
+
+  bytes = __sync_add_and_fetch(&_bytes[tag], _delta.bytes[tag]);
+  __sync_fetch_and_add(&_objects[tag], _delta.objects[tag]);
+  _delta.bytes[tag]   = 0;
+  _delta.objects[tag] = 0;
+
+  max = _maxBytes[tag];
+  while (   (bytes > max)
+         && !__sync_bool_compare_and_swap(&_maxBytes[tag], max, bytes))
+  {
+    max = _maxBytes[tag];
+  }
+}
+
+/**
+ * Called when a thread ends, flushes its remaining changes.
+ *
+ * @param data Not used.
+ */
+static void _exitMemStats(void* data)
+{
+  flushMemStats();
+}
+
+/**
+ * Create the key that flushes the changes of an ending thread.
+ */
+static void _createDeltaKey(void)
+{
+  pthread_key_create(&_deltaKey, _exitMemStats);
+}
+
+void addMemStats(MemTag tag, int64_t bytes, int64_t objects)
+{
+  if (!_deltaKeySet)
+  {
+    pthread_once(&_deltaOnce, _createDeltaKey);
+    // Any non NULL value makes the destructor run.
+    pthread_setspecific(_deltaKey, &_delta);
+    _deltaKeySet = true;
+  }
+
+  _delta.bytes[tag]   += bytes;
+  _delta.objects[tag] += objects;
+  if (   (llabs(_delta.bytes[tag]) >= MEM_STATS_FLUSH_BYTES)
+      || (llabs(_delta.objects[tag]) >= MEM_STATS_FLUSH_OBJS))
+  {
+    _flushTag(tag);
+  }
+}
+
+void flushMemStats(void)
+{
+  int tag;
+
+  for (tag = 0; tag < NUM_MEM_TAGS; tag++)
+  {
+    if ((_delta.bytes[tag] != 0) || (_delta.objects[tag] != 0))
+    {
+      _flushTag((MemTag)tag);
+    }
+  }
+}
+
+void getMemStats(MemTag tag, MemStats* stats)
+{
+  stats->bytes    = _bytes[tag];
+  stats->objects  = _objects[tag];
+  stats->maxBytes = _maxBytes[tag];
+  // The high-water mark is only raised at a flush.
+  if (stats->maxBytes < stats->bytes)
+  {
+    stats->maxBytes = stats->bytes;
+  }
+}
+
+void resetMemStatsMax(void)
+{
+  int tag;
+
+  for (tag = 0; tag < NUM_MEM_TAGS; tag++)
+  {
+    _maxBytes[tag] = _bytes[tag];
+  }
+}
+
+const char* memTagToStr(MemTag tag)
+{
+  return (tag < NUM_MEM_TAGS) ? _tagNames[tag] : "unknown";
+}
@@ -0,0 +1,118 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Memory accounting by subsystem. The allocations of each subsystem are
+ * counted under a tag: the bytes allocated from the heap, the number of
+ * objects and the highest number of bytes seen. Each thread collects its
+ * changes locally and adds them to the shared counters once they exceed
+ * MEM_STATS_FLUSH_BYTES or MEM_STATS_FLUSH_OBJS, or when the thread ends.
+ * The shared counters can therefore lag behind by that much per thread.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __MEM_STATS_H__
+#define __MEM_STATS_H__
+
+#include <stdint.h>
+
+/** The bytes a thread collects before it updates the shared counters. */
+#define MEM_STATS_FLUSH_BYTES  65536
+/** The objects a thread collects before it updates the shared counters. */
+#define MEM_STATS_FLUSH_OBJS   256
+
+/** The subsystems memory is accounted for. */
+typedef enum {
+  /** Memory pools that were not given a tag. */
+  MEM_TAG_OTHER = 0,
+  /** The entries and hash table of the update cache. */
+  MEM_TAG_UPDATES,
+  /** The update blobs of the blob store. */
+  MEM_TAG_BLOBS,
+  /** The client arrays and client index of the update cache. */
+  MEM_TAG_CLIENTS,
+  /** The prefixes, AS and ROA arrays of the prefix cache. */
+  MEM_TAG_PREFIXES,
+  /** The rings of the command queue. */
+  MEM_TAG_COMMAND_QUEUE,
+  /** The packet buffers: receive chunks, receiver queue elements, and
+   * copies of large packets. */
+  MEM_TAG_RECEIVE,
+  /** The buffers of the send queue. */
+  MEM_TAG_SEND_QUEUE,
+  /** The receive buffers of the RPKI router clients. */
+  MEM_TAG_RTR_BUFFERS,
+  NUM_MEM_TAGS
+} MemTag;
+
+/** The counters of one tag. */
+typedef struct {
+  /** The bytes currently allocated. */
+  int64_t bytes;
+  /** The number of objects currently allocated. */
+  int64_t objects;
+  /** The highest number of bytes allocated since the last reset. */
+  int64_t maxBytes;
+} MemStats;
+
+/**
+ * Account for the allocation (positive values) or release (negative values)
+ * of memory. Does not lock, can be called by any thread.
+ *
+ * @param tag The subsystem.
+ * @param bytes The change of the allocated bytes.
+ * @param objects The change of the number of objects.
+ */
+void addMemStats(MemTag tag, int64_t bytes, int64_t objects);
+
+/**
+ * Add the changes collected by the calling thread to the shared counters.
+ */
+void flushMemStats(void);
+
+/**
+ * Read the counters of the given tag.
+ *
+ * @param tag The subsystem.
+ * @param stats (out) The counters.
+ */
+void getMemStats(MemTag tag, MemStats* stats);
+
+/**
+ * Set the high-water marks back to the current number of bytes.
+ */
+void resetMemStatsMax(void);
+
+/**
+ * Return the name of the tag.
+ *
+ * @param tag The subsystem.
+ *
+ * @return The name.
+ */
+const char* memTagToStr(MemTag tag);
+
+#endif // !__MEM_STATS_H__
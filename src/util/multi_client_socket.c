@@ -21,10 +21,16 @@
  * by this software.
  *
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Requests are pipelined, the pending requests are indexed by id
+ *              and completed by future or callback, or by their timeout.
+ *            * Requests and responses are framed as id, length, and data.
+ *            * The monitor wakes up periodically to expire requests and is
+ *              stopped and joined by releaseMultiClientSocket.
  * 0.3.0.10 - 2015/11/10 - oborchert
  *            * Added Initialization for function variables in monitorThread
  *          - 2015/11/09 - oborchert
@@ -33,80 +39,280 @@
  * 0.1.0    - 2010/12/01 -pgleichm
  *            * Code created. 
  */
-// @TODO: This can be deleted
-
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <time.h>
+#include <uthash.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include "util/multi_client_socket.h"
 #include "util/client_socket.h"
 #include "util/log.h"
 #include "util/socket.h"
 
+/** The interval (milliseconds) in which timed out requests are expired */
+#define MCS_SWEEP_INTERVAL 50
+
+/**
+ * A single pending request - waiting for a response.
+ */
+struct _MCSRequest {
+  uint32_t             id;
+  MultiClientSocket*   owner;
+  void*                buffer;
+  size_t               bufferSize;
+  size_t               numRead;
+  uint64_t             deadline;  // Monotonic milliseconds
+  // Either the callback completes the request or the future is resolved
+  MultiClientCallback  callback;
+  void*                user;
+  bool                 done;
+  Cond                 cond;
+  // Chains the requests completed together
+  struct _MCSRequest*  next;
+  UT_hash_handle       hh;
+};
+
+typedef struct _MCSRequest MCSRequest;
+
+/**
+ * Return the monotonic time in milliseconds.
+ *
+ * @return The current time.
+ */
+static uint64_t _nowMillis()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((uint64_t)now.tv_sec * 1000) + (now.tv_nsec / 1000000);
+}
+
 /**
- * A single entry in the server queue - waiting for a response.
+ * Free the request.
+ *
+ * @param req The request that is not in the pending table anymore.
  */
-typedef struct {
-  uint32_t  id;
-  Mutex     mutex; 
-  void*     buffer;
-  size_t    bufferSize;
-  size_t    numRead;
-} QueueData;  
+static void _freeRequest(MCSRequest* req)
+{
+  if (req->callback == NULL)
+  {
+    pthread_cond_destroy(&req->cond);
+  }
+  free(req);
+}
 
 /**
- * Waits for incoming data and depending on the id wakes up the corresponding
- * - currently sleeping - caller.
+ * Complete a request that was removed from the pending table. Either the
+ * callback is called and the request is freed or the future is resolved.
+ *
+ * @param req The request.
+ * @param numRead The size of the response or -1.
+ */
+static void _completeRequest(MCSRequest* req, size_t numRead)
+{
+  MultiClientSocket* self = req->owner;
+
+  if (req->callback != NULL)
+  {
+    req->callback(req->id, req->buffer, numRead, req->user);
+    _freeRequest(req);
+  }
+  else
+  {
+    lockMutex(&self->pendingMutex);
+    req->numRead = numRead;
+    req->done    = true;
+    signalCond(&req->cond);
+    unlockMutex(&self->pendingMutex);
+  }
+}
+
+/**
+ * Complete the chained requests with an error.
+ *
+ * @param req The first request of the chain.
+ */
+static void _failRequests(MCSRequest* req)
+{
+  MCSRequest* next;
+
+  while (req != NULL)
+  {
+    next = req->next;
+    _completeRequest(req, -1);
+    req = next;
+  }
+}
+
+/**
+ * Remove the request with the given id from the pending table.
+ *
+ * @param self The socket.
+ * @param id The id of the request.
+ *
+ * @return The request or NULL if no request with the id is pending.
+ */
+static MCSRequest* _takeRequest(MultiClientSocket* self, uint32_t id)
+{
+  MCSRequest* req = NULL;
+
+  lockMutex(&self->pendingMutex);
+  HASH_FIND(hh, self->pending, &id, sizeof(uint32_t), req);
+  if (req != NULL)
+  {
+    HASH_DEL(self->pending, req);
+    self->noPending--;
+  }
+  unlockMutex(&self->pendingMutex);
+
+  return req;
+}
+
+/**
+ * Complete all requests whose deadline passed with an error. If the
+ * connection is closed all requests are completed.
+ *
+ * @param self The socket.
+ * @param now The current time or 0 to complete all requests.
+ */
+static void _expireRequests(MultiClientSocket* self, uint64_t now)
+{
+  MCSRequest* req;
+  MCSRequest* tmp;
+  MCSRequest* expired = NULL;
+
+  lockMutex(&self->pendingMutex);
+  HASH_ITER(hh, self->pending, req, tmp)
+  {
+    if ((now == 0) || (req->deadline <= now))
+    {
+      HASH_DEL(self->pending, req);
+      self->noPending--;
+      req->next = expired;
+      expired   = req;
+    }
+  }
+  unlockMutex(&self->pendingMutex);
+
+  // The callbacks are called without holding the lock, they might submit
+  // new requests.
+  _failRequests(expired);
+}
+
+/**
+ * Read the data of a response into the buffer of the request.
+ *
+ * @param self The socket.
+ * @param req The request.
+ * @param length The length of the response data.
+ * @param numRead OUT - The number of bytes stored in the buffer.
+ *
+ * @return false if the connection got lost.
+ */
+static bool _readResponse(MultiClientSocket* self, MCSRequest* req,
+                          uint32_t length, size_t* numRead)
+{
+  int* fd = getClientFDPtr(&self->clSock);
+
+  // Enough buffer space
+  if (req->bufferSize >= length)
+  {
+    *numRead = length;
+    return recvNum(fd, req->buffer, length);
+  }
+
+  // Fill the buffer and skip the rest
+  *numRead = req->bufferSize;
+  return recvNum(fd, req->buffer, req->bufferSize)
+         && skipBytes(&self->clSock, length - req->bufferSize);
+}
+
+/**
+ * Waits for incoming responses and completes the pending request with the
+ * id of the response. Requests that are not answered in time are expired.
  *
  * @note PThread syntax
  *
  * @param data The client-socket (MultiClientSocket)
  */
-static void* monitorThread(void* data) {
-  RAISE_ERROR("NOT CHECKED YET!!!");
-  
-  MultiClientSocket*  cs = (MultiClientSocket*)data;
-  uint32_t            id = 0;
-  SListNode*          cnode = NULL;
-  QueueData*          qdata = NULL;
+static void* monitorThread(void* data)
+{
+  MultiClientSocket* cs        = (MultiClientSocket*)data;
+  uint32_t           frame[2]  = { 0, 0 }; // id and length
+  uint64_t           nextSweep = _nowMillis() + MCS_SWEEP_INTERVAL;
+  uint64_t           now       = 0;
+  MCSRequest*        req       = NULL;
+  size_t             numRead   = 0;
+  struct pollfd      pfd;
+  int                ready;
 
-  LOG (LEVEL_DEBUG, "([0x%08X]) > Multi Client Socket Thread started!", pthread_self());    
+  LOG (LEVEL_DEBUG, "([0x%08X]) > Multi Client Socket Thread started!",
+                    pthread_self());
   
-  // Process each
-  for (;;) {
-    // No connection anymore - terminate the monitor
-    if (!recvNum(getClientFDPtr(&cs->clSock), &id, 
-                 sizeof(uint32_t))) {
+  for (;;)
+  {
+    pfd.fd      = *getClientFDPtr(&cs->clSock);
+    pfd.events  = POLLIN;
+    pfd.revents = 0;
+    ready = poll(&pfd, 1, MCS_SWEEP_INTERVAL);
+    if ((ready < 0) && (errno != EINTR))
+    {
       break;
     }
 
-    // Search the node for the id
-    FOREACH_SLIST(&cs->queue, cnode) {
-      if (((QueueData*)getDataOfSListNode(cnode))->id == id) {
-        break; // Found
+    if (ready > 0)
+    {
+      // No connection anymore - terminate the monitor
+      if (!recvNum(&pfd.fd, frame, sizeof(frame)))
+      {
+        break;
+      }
+
+      req = _takeRequest(cs, frame[0]);
+      if (req == NULL)
+      {
+        // The request timed out already
+        if (!skipBytes(&cs->clSock, frame[1]))
+        {
+          break;
+        }
+      }
+      else if (_readResponse(cs, req, frame[1], &numRead))
+      {
+        _completeRequest(req, numRead);
+      }
+      else
+      {
+        _completeRequest(req, -1);
+        break;
       }
     }
-    
-    // Read the data and then wake up the function
-    qdata = (QueueData*)getDataOfSListNode(cnode);
-    qdata->numRead = receiveData(&cs->clSock, qdata->buffer, qdata->bufferSize);
-    unlockMutex(&qdata->mutex); 
-  }
 
-  // Unblock all remaining calls
-  for (cnode = cs->queue.root; cnode; cnode = cnode->next) {
-    ((QueueData*)getDataOfSListNode(cnode))->numRead = -1;
-    unlockMutex(&((QueueData*)getDataOfSListNode(cnode))->mutex);
+    now = _nowMillis();
+    if (now >= nextSweep)
+    {
+      _expireRequests(cs, now);
+      nextSweep = now + MCS_SWEEP_INTERVAL;
+    }
   }
 
-  LOG (LEVEL_DEBUG, "([0x%08X]) < Multi Cient Socket Thread stopped!", pthread_self());      
+  // Do not accept new requests and fail all remaining requests
+  lockMutex(&cs->pendingMutex);
+  cs->connected = false;
+  unlockMutex(&cs->pendingMutex);
+  _expireRequests(cs, 0);
+
+  LOG (LEVEL_DEBUG, "([0x%08X]) < Multi Client Socket Thread stopped!",
+                    pthread_self());
   
   pthread_exit(0);
 }
 
-//TODO: Check this might be old code that can be removed!!
 bool createMultiClientSocket(MultiClientSocket* self,
                              const char* host, int port)
 {
-  RAISE_ERROR("NOT CHECKED YET!!!");
-  
   // Open the connection
   if (!createClientSocket(&self->clSock, host, port, true, 
                           UNDEFINED_CLIENT_SOCKET, true))
@@ -115,14 +321,23 @@ bool createMultiClientSocket(MultiClientSocket* self,
   }
 
   // Initialize the variables
-  initSList(&self->queue);
-  if (!initMutex(&self->idMutex))
+  self->pending   = NULL;
+  self->noPending = 0;
+  self->nextId    = 0;
+  self->connected = true;
+  if (!initMutex(&self->sendMutex))
+  {
+    RAISE_SYS_ERROR("Failed to create a send mutex");
+    closeClientSocket(&self->clSock);
+    return false;
+  }
+  if (!initMutex(&self->pendingMutex))
   {
-    RAISE_SYS_ERROR("Failed to create an Id mutex");
+    RAISE_SYS_ERROR("Failed to create a pending mutex");
     closeClientSocket(&self->clSock);
+    releaseMutex(&self->sendMutex);
     return false;
   }
-  self->maxId = 0;
 
   // Start the monitor
   if (pthread_create(&self->monitor, NULL, monitorThread, 
@@ -130,86 +345,186 @@ bool createMultiClientSocket(MultiClientSocket* self,
   {
     RAISE_ERROR("Not enough resource for the client socket monitor");
     closeClientSocket(&self->clSock);
-    releaseMutex(&self->idMutex);
+    releaseMutex(&self->pendingMutex);
+    releaseMutex(&self->sendMutex);
     return false;
   }
 
   return true;
 }
 
-void releaseMultiClientSocket(MultiClientSocket* self) {
-  RAISE_ERROR("NOT CHECKED YET!!!");
-  
-  if (self != NULL) {
+void releaseMultiClientSocket(MultiClientSocket* self)
+{
+  if (self != NULL)
+  {
+    // Wake up the monitor, it completes all pending requests before it stops
+    shutdown(*getClientFDPtr(&self->clSock), SHUT_RDWR);
+    pthread_join(self->monitor, NULL);
     closeClientSocket(&self->clSock);
-    releaseSList(&self->queue);
-    releaseMutex(&self->idMutex);
+    releaseMutex(&self->pendingMutex);
+    releaseMutex(&self->sendMutex);
   }
 }
 
 /**
- * Returns a unique identifier.
+ * Register the request under a unique id and send it.
  *
- * @param mcs Multi Client-socket
- * @return Numeric identifier
+ * @param self The socket.
+ * @param req The request, it belongs to the socket once registered.
+ * @param data Data to send
+ * @param dataSize Size (in Bytes) to send
+ *
+ * @return false if the request could not be sent, the request is freed.
  */
-static uint32_t getId(MultiClientSocket* mcs) {
-  RAISE_ERROR("NOT CHECKED YET!!!");
+static bool _sendRequest(MultiClientSocket* self, MCSRequest* req,
+                         void* data, size_t dataSize)
+{
+  MCSRequest*  found = NULL;
+  uint32_t     frame[2];
+  struct iovec iov[2];
+  bool         sent;
 
-  uint32_t id;
+  lockMutex(&self->pendingMutex);
+  if (!self->connected)
+  {
+    unlockMutex(&self->pendingMutex);
+    _freeRequest(req);
+    return false;
+  }
+  // Skip ids that still wait for a response after the counter wrapped
+  do
+  {
+    req->id = self->nextId++;
+    HASH_FIND(hh, self->pending, &req->id, sizeof(uint32_t), found);
+  } while (found != NULL);
+  HASH_ADD(hh, self->pending, id, sizeof(uint32_t), req);
+  self->noPending++;
+  frame[0] = req->id;
+  frame[1] = (uint32_t)dataSize;
+  unlockMutex(&self->pendingMutex);
 
-  lockMutex(&mcs->idMutex);
-  id = mcs->maxId;
-  mcs->maxId++;
-  unlockMutex(&mcs->idMutex);
+  // From here on the monitor might complete the request at any time
+  iov[0].iov_base = frame;
+  iov[0].iov_len  = sizeof(frame);
+  iov[1].iov_base = data;
+  iov[1].iov_len  = dataSize;
+  lockMutex(&self->sendMutex);
+  sent = sendNumv(getClientFDPtr(&self->clSock), iov, 2);
+  unlockMutex(&self->sendMutex);
 
-  return id;
+  if (!sent)
+  {
+    // Only if the request is still pending it was not completed yet.
+    found = _takeRequest(self, frame[0]);
+    if (found != NULL)
+    {
+      _freeRequest(found);
+      return false;
+    }
+  }
+
+  return true;
 }
 
-size_t exchangeData(MultiClientSocket* self, 
-                    void* data, size_t dataSize,
-                    void* buffer, size_t bufferSize) {
-  RAISE_ERROR("NOT CHECKED YET!!!");
-  
-  QueueData*  qdata;
-  size_t      num;
-
-  // Create a new queue node and corresponding mutex (locked)
-  qdata = (QueueData*)appendToSList(&self->queue, sizeof(QueueData));
-  if (qdata == NULL) {
-    return -1;
-  }
-  if (!initMutex(&qdata->mutex)) {
-    deleteFromSList(&self->queue, qdata);
-    return -1;
-  }
-  lockMutex(&qdata->mutex);
- 
-  // Assign an id and copy the parameters so that the monitor can access them
-  qdata->id         = getId(self);
-  qdata->buffer     = buffer;
-  qdata->bufferSize = bufferSize;
-
-  // Send the id, and then the data
-  if (sendNum(getClientFDPtr(&self->clSock), 
-              &qdata->id, sizeof(uint32_t))
-      && sendData(&self->clSock, data, dataSize)) {
-  
-    // Block until the monitor wakes us up
-    waitMutex(&qdata->mutex);
+/**
+ * Allocate a request.
+ *
+ * @param self The socket.
+ * @param buffer Buffer for the server's response
+ * @param bufferSize Size of \c buffer
+ * @param timeout The time (milliseconds) to wait for the response.
+ * @param callback The callback or NULL for a future.
+ * @param user The user pointer handed to the callback.
+ *
+ * @return The request or NULL.
+ */
+static MCSRequest* _createRequest(MultiClientSocket* self,
+                                  void* buffer, size_t bufferSize,
+                                  uint32_t timeout,
+                                  MultiClientCallback callback, void* user)
+{
+  MCSRequest* req = calloc(1, sizeof(MCSRequest));
 
-    // Number of bytes read
-    num = qdata->numRead;
-  
-  // Failed to send the id or data
-  } else {
-    num = -1;
+  if (req == NULL)
+  {
+    RAISE_ERROR("Not enough memory for a multi client request");
+    return NULL;
+  }
+  if ((callback == NULL) && !initCond(&req->cond))
+  {
+    RAISE_SYS_ERROR("Failed to create the condition of a request");
+    free(req);
+    return NULL;
+  }
+  req->owner      = self;
+  req->buffer     = buffer;
+  req->bufferSize = bufferSize;
+  req->numRead    = -1;
+  req->deadline   = _nowMillis() + timeout;
+  req->callback   = callback;
+  req->user       = user;
+
+  return req;
+}
+
+MCSFuture* submitRequest(MultiClientSocket* self,
+                         void* data, size_t dataSize,
+                         void* buffer, size_t bufferSize,
+                         uint32_t timeout)
+{
+  MCSRequest* req = _createRequest(self, buffer, bufferSize, timeout,
+                                   NULL, NULL);
+
+  // A future is not freed before it is waited for.
+  if ((req == NULL) || !_sendRequest(self, req, data, dataSize))
+  {
+    return NULL;
+  }
+
+  return req;
+}
+
+size_t waitForResponse(MCSFuture* future)
+{
+  MultiClientSocket* self = future->owner;
+  size_t             numRead;
+
+  lockMutex(&self->pendingMutex);
+  while (!future->done)
+  {
+    waitCond(&future->cond, &self->pendingMutex, 0);
   }
+  numRead = future->numRead;
+  unlockMutex(&self->pendingMutex);
+  _freeRequest(future);
+
+  return numRead;
+}
 
-  // Remove the mutex and node
-  releaseMutex(&qdata->mutex);
-  deleteFromSList(&self->queue, qdata);
+bool submitRequestCallback(MultiClientSocket* self,
+                           void* data, size_t dataSize,
+                           void* buffer, size_t bufferSize,
+                           uint32_t timeout,
+                           MultiClientCallback callback, void* user)
+{
+  MCSRequest* req;
 
-  return num;
+  if (callback == NULL)
+  {
+    RAISE_ERROR("A callback request requires a callback");
+    return false;
+  }
+  req = _createRequest(self, buffer, bufferSize, timeout, callback, user);
+
+  return (req != NULL) && _sendRequest(self, req, data, dataSize);
 }
 
+size_t exchangeData(MultiClientSocket* self,
+                    void* data, size_t dataSize,
+                    void* buffer, size_t bufferSize)
+{
+  MCSFuture* future = submitRequest(self, data, dataSize, buffer, bufferSize,
+                                    MCS_DEFAULT_TIMEOUT);
+
+  return (future != NULL) ? waitForResponse(future) : -1;
+}
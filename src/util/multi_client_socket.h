@@ -21,14 +21,26 @@
  * *
  * Exchange of multiple data packets over a single connection.
  *
+ * Requests are pipelined: each request is sent as id, length, and data and
+ * the caller is not blocked until the response arrives. The server answers
+ * with id, length, and data in any order. Pending requests are indexed by
+ * their id, the monitor thread completes them either by resolving a future
+ * or by calling the callback of the request. Requests not answered within
+ * their timeout are completed with an error.
+ *
  * \note The server (server_socket.h) must run in MODE_MULTIPLE_CLIENTS mode 
  *
  * log.h is used for the handling of error messages.
  * 
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Replaced the blocking exchange by pipelined requests with an id
+ *              indexed pending table, futures, callbacks, and timeouts.
+ *            * exchangeData is a submitted request followed by the wait for
+ *              its future.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  *            * Added Changelog
@@ -36,16 +48,40 @@
  *            * File Created.
  * 
  */
-// @TODO: Check if this can be deleted
-
 #ifndef __MULTI_CLIENT_SOCKET_H__
 #define __MULTI_CLIENT_SOCKET_H__
 
 #include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include "util/client_socket.h"
 #include "util/mutex.h"
-#include "util/slist.h"
+
+/** The timeout used by exchangeData (milliseconds) */
+#define MCS_DEFAULT_TIMEOUT 5000
+
+/**
+ * The callback that completes a request.
+ *
+ * @note Called by the monitor thread, it must not block for long.
+ *
+ * @param id The id of the request.
+ * @param buffer The buffer given with the request.
+ * @param numRead The size of the response, (size_t)-1 if the request timed
+ *                out or the connection got lost.
+ * @param user The user pointer given with the request.
+ *
+ * @since 0.4.1.0
+ */
+typedef void (*MultiClientCallback)(uint32_t id, void* buffer, size_t numRead,
+                                    void* user);
+
+/**
+ * A pending request, see submitRequest.
+ *
+ * @since 0.4.1.0
+ */
+typedef struct _MCSRequest MCSFuture;
 
 /** 
  * A single Multi Client Socket
@@ -53,11 +89,17 @@
  * \note Do not access any of the member variables directly!
  */
 typedef struct {
-  ClientSocket  clSock;
-  pthread_t     monitor;
-  SList         queue;
-  uint32_t      maxId;
-  Mutex         idMutex;
+  ClientSocket        clSock;
+  pthread_t           monitor;
+  // Serializes the frames of the requests on the connection
+  Mutex               sendMutex;
+  // Guards the pending table, nextId, and connected
+  Mutex               pendingMutex;
+  // The pending requests indexed by their id
+  struct _MCSRequest* pending;
+  uint32_t            noPending;
+  uint32_t            nextId;
+  bool                connected;
 } MultiClientSocket;
 
 /**
@@ -73,14 +115,76 @@ extern bool createMultiClientSocket(MultiClientSocket* self,
                                     const char* host, int port);
 
 /**
- * Closes a client-socket.
+ * Closes a client-socket. All pending requests are completed with an error.
  *
  * @param self Socket instance
  */
 extern void releaseMultiClientSocket(MultiClientSocket* self);
 
 /**
- * Exchanges a message with the server.
+ * Sends a request to the server without waiting for the response. The
+ * response is written into the buffer and can be retrieved with
+ * waitForResponse.
+ *
+ * @param self Socket instance
+ * @param data Data to send
+ * @param dataSize Size (in Bytes) to send
+ * @param buffer (out) Buffer for the server's response, it must stay valid
+ *               until the future is resolved.
+ * @param bufferSize Size of \c buffer
+ * @param timeout The time (milliseconds) to wait for the response.
+ *
+ * @return The future of the request or NULL if the request could not be sent.
+ *
+ * @since 0.4.1.0
+ */
+extern MCSFuture* submitRequest(MultiClientSocket* self,
+                                void* data, size_t dataSize,
+                                void* buffer, size_t bufferSize,
+                                uint32_t timeout);
+
+/**
+ * Waits until the future is resolved and releases it. Must be called exactly
+ * once for each future.
+ *
+ * @param future The future returned by submitRequest.
+ *
+ * @return Size of the server's response, or \c -1 in case of an error or a
+ *         timeout.
+ *
+ * @since 0.4.1.0
+ */
+extern size_t waitForResponse(MCSFuture* future);
+
+/**
+ * Sends a request to the server without waiting for the response. Once the
+ * response is written into the buffer, the request timed out, or the
+ * connection got lost, the callback is called by the monitor thread.
+ *
+ * @param self Socket instance
+ * @param data Data to send
+ * @param dataSize Size (in Bytes) to send
+ * @param buffer (out) Buffer for the server's response, it must stay valid
+ *               until the callback is called.
+ * @param bufferSize Size of \c buffer
+ * @param timeout The time (milliseconds) to wait for the response.
+ * @param callback The callback that completes the request.
+ * @param user The user pointer handed to the callback.
+ *
+ * @return \c true if the request is sent, \c false if the request could not
+ *         be sent, in this case the callback is not called.
+ *
+ * @since 0.4.1.0
+ */
+extern bool submitRequestCallback(MultiClientSocket* self,
+                                  void* data, size_t dataSize,
+                                  void* buffer, size_t bufferSize,
+                                  uint32_t timeout,
+                                  MultiClientCallback callback, void* user);
+
+/**
+ * Exchanges a message with the server. Other requests can be in flight on
+ * the same connection at the same time.
  * 
  * \param self Socket instance
  * \param data Data to send
@@ -94,4 +198,3 @@ extern size_t exchangeData(MultiClientSocket* self,
                            void* buffer, size_t bufferSize);
 
 #endif // !__MULTI_CLIENT_SOCKET_H__
-
@@ -28,6 +28,10 @@
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Record the contention of named mutexes if built with
+ *              LOCK_STATS.
+ *            * Added waitCondMicros.
  * 0.3.0.10 - 2016/01/21 - kyehwanl
  *            * change log level of waitCond() from LOGLEVEL to LEVEL_COMM,
  *              in order to avoid the infinate printing while waiting command
@@ -35,6 +39,7 @@
 
 #include <time.h>
 #include "util/mutex.h"
+#include "util/lock_stats.h"
 #include "util/log.h"
 
 #define LOGLEVEL LEVEL_DEBUG
@@ -48,6 +53,9 @@ inline bool initMutex(Mutex* self)
 inline void releaseMutex(Mutex* self)
 {
   LOG(LOGLEVEL, "([0x%08X] Mutex):  >  [0x%08X] RELEASE", pthread_self(), self);
+#ifdef LOCK_STATS
+  clearLockName(self);
+#endif
   (void)pthread_mutex_destroy(self);
 }
 
@@ -55,7 +63,17 @@ inline void lockMutex(Mutex* self)
 {
   LOG(LOGLEVEL, "([0x%08X] Mutex): --> [0x%08X] REQ LOCK ",
       pthread_self(), self);
+#ifdef LOCK_STATS
+  uint64_t waitStart = 0;
+  if (pthread_mutex_trylock(self) != 0)
+  {
+    waitStart = getLockTime();
+    (void)pthread_mutex_lock(self);
+  }
+  recordLockAcquire(self, waitStart, true);
+#else
   (void)pthread_mutex_lock(self);
+#endif
   LOG(LOGLEVEL, "([0x%08X] Mutex): <-- [0x%08X] LOCKED",
       pthread_self(), self);
 }
@@ -64,6 +82,9 @@ inline void unlockMutex(Mutex* self)
 {
   LOG(LOGLEVEL, "([0x%08X] Mutex): ==> [0x%08X] UNLOCK",
       pthread_self(), self);
+#ifdef LOCK_STATS
+  recordLockRelease(self);
+#endif
   (void)pthread_mutex_unlock(self);
   LOG(LOGLEVEL, "([0x%08X] Mutex): <== [0x%08X] UNLOCKED",
       pthread_self(), self);
@@ -92,8 +113,18 @@ inline int signalCond(Cond *cond)
   return (pthread_cond_signal(cond));
 }
 
-/** Wait for time milliseconds. time - 0 = until notify called! */
-inline int waitCond(Cond *cond, Mutex *self, uint32_t millis)
+/**
+ * Wait for the condition, see waitCond.
+ *
+ * @param cond The condition.
+ * @param self The mutex held by the caller.
+ * @param millis The maximum time to wait or 0 to wait without timeout.
+ *
+ * @return The result of the pthread condition wait.
+ *
+ * @since 0.4.1.0
+ */
+static int _waitCond(Cond *cond, Mutex *self, uint32_t millis)
 {
   if (millis > 0)
   {
@@ -119,6 +150,59 @@ inline int waitCond(Cond *cond, Mutex *self, uint32_t millis)
   }
 }
 
+/** Wait for time milliseconds. time - 0 = until notify called! */
+inline int waitCond(Cond *cond, Mutex *self, uint32_t millis)
+{
+#ifdef LOCK_STATS
+  int retVal;
+
+  // The mutex is not held while waiting for the condition.
+  recordLockRelease(self);
+  retVal = _waitCond(cond, self, millis);
+  restartLockHold(self);
+
+  return retVal;
+#else
+  return _waitCond(cond, self, millis);
+#endif
+}
+
+/**
+ * Wait for the condition at most the given number of microseconds.
+ *
+ * @param cond The condition.
+ * @param self The mutex held by the caller.
+ * @param micros The maximum time to wait.
+ *
+ * @return The result of the pthread condition wait, ETIMEDOUT if the time
+ *         passed.
+ *
+ * @since 0.4.1.0
+ */
+int waitCondMicros(Cond *cond, Mutex *self, uint64_t micros)
+{
+  struct timespec to;
+  int retVal;
+
+  clock_gettime(CLOCK_REALTIME, &to);
+  to.tv_sec  += micros / 1000000;
+  to.tv_nsec += (micros % 1000000) * 1000;
+  if (to.tv_nsec >= 1000000000L)
+  {
+    to.tv_sec++;
+    to.tv_nsec -= 1000000000L;
+  }
+#ifdef LOCK_STATS
+  recordLockRelease(self);
+#endif
+  retVal = pthread_cond_timedwait(cond, self, &to);
+#ifdef LOCK_STATS
+  restartLockHold(self);
+#endif
+
+  return retVal;
+}
+
 /**
  * Destroy the condition object
  *
@@ -24,10 +24,12 @@
  * @note Currently based on PThread
  * log.h is used for error reporting.
  * 
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Added waitCondMicros.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  *            * Added Changelog
@@ -96,6 +98,20 @@ extern int signalCond(Cond *cond);
 /** Wait for a time milli seconds. time - 0 = until notify called! */
 extern int waitCond(Cond *cond, Mutex *self, uint32_t millis);
 
+/**
+ * Wait for the condition at most the given number of microseconds.
+ *
+ * @param cond The condition.
+ * @param self The mutex held by the caller.
+ * @param micros The maximum time to wait.
+ *
+ * @return The result of the pthread condition wait, ETIMEDOUT if the time
+ *         passed.
+ *
+ * @since 0.4.1.0
+ */
+extern int waitCondMicros(Cond *cond, Mutex *self, uint64_t micros);
+
 /**
  * wait for a given amount of milli seconds
  * 
@@ -21,10 +21,20 @@
  * by this software.
  *
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * receivePackets reads large chunks and processes all complete
+ *              PDUs of a chunk before it goes back to the socket. PDUs split
+ *              across chunks are kept at the front of the buffer.
+ *            * The receive buffer is a reference counted PacketChunk. Handlers
+ *              can keep references to dispatched PDUs instead of copying them.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added the per thread packet buffer pools. Receive chunks are
+ *              taken from the pool and replaced instead of reallocated.
+ *            * Account the packet buffers under MEM_TAG_RECEIVE.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Added Changelog
  *            * Fixed speller in documentations
@@ -40,17 +50,435 @@
 #include "util/packet.h"
 #include "util/server_socket.h"
 #include "util/log.h"
+#include "util/mem_stats.h"
 #include "util/mutex.h"
 #include "util/socket.h"
 
 #define HDR "([0x%08X] Packet): "
 
+/** The initial size of the receive buffer. Large enough to hold many PDUs. */
+#define RECV_BUFFER_SIZE 65536
+
+/** A shared chunk with less free space than this is replaced by a new one. */
+#define RECV_BUFFER_MIN_FREE 4096
+
+/** The chunk the calling thread currently dispatches PDUs from. */
+static __thread PacketChunk* _dispatchedChunk = NULL;
+
+/**
+ * The header of each packet buffer. The buffer follows the header.
+ */
+typedef struct _PacketBuffer {
+  struct _PacketBufferPool* pool;      // The owning pool, NULL if not pooled
+  struct _PacketBuffer*     next;      // The link within a free list
+  uint32_t                  sizeClass; // The size class of the buffer
+  uint32_t                  size;      // The size if not pooled
+} PacketBuffer;
+
+/**
+ * The packet buffer pool of a thread. Only the owner uses the cached lists,
+ * other threads hand buffers back through the returned list. The pool lives
+ * as long as the owner or one of its buffers.
+ */
+typedef struct _PacketBufferPool {
+  PacketBuffer* volatile returned;  // Buffers freed by other threads
+  volatile uint32_t      refCount;  // The owner and each buffer in use
+  PacketBuffer*          cached[PACKET_BUFFER_CLASSES];   // Free buffers
+  uint32_t               noCached[PACKET_BUFFER_CLASSES]; // Their number
+} PacketBufferPool;
+
+/** The size of the buffers of each size class. */
+static const uint32_t _bufferClassSize[PACKET_BUFFER_CLASSES] = {
+  sizeof(SRXPROXY_VERIFY_V4_REQUEST) + PACKET_BUFFER_PATH_SIZE,
+  sizeof(SRXPROXY_VERIFY_V6_REQUEST) + PACKET_BUFFER_PATH_SIZE,
+  PACKET_BUFFER_BGPSEC_SIZE,
+  sizeof(PacketChunk) + RECV_BUFFER_SIZE
+};
+
+/** The maximum number of free buffers a pool keeps of each size class. */
+static const uint32_t _bufferClassCache[PACKET_BUFFER_CLASSES] = {
+  256, 256, 64, 8
+};
+
+/** The packet buffer pool of the calling thread. */
+static __thread PacketBufferPool* _bufferPool = NULL;
+/** The key used to release the pool when its thread ends. */
+static pthread_key_t              _bufferPoolKey;
+/** Creates the key once. */
+static pthread_once_t             _bufferPoolOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Free the buffer and account for it.
+ *
+ * @param buffer The buffer.
+ *
+ * @since 0.4.1.0
+ */
+static void _freeBuffer(PacketBuffer* buffer)
+{
+  uint32_t size = buffer->sizeClass < PACKET_BUFFER_CLASSES
+                  ? _bufferClassSize[buffer->sizeClass] : buffer->size;
+
+  addMemStats(MEM_TAG_RECEIVE, -(int64_t)(sizeof(PacketBuffer) + size), -1);
+  free(buffer);
+}
+
+/**
+ * Free all buffers of the given list.
+ *
+ * @param buffer The first buffer of the list or NULL.
+ *
+ * @since 0.4.1.0
+ */
+static void _freeBufferList(PacketBuffer* buffer)
+{
+  PacketBuffer* next;
+
+  while (buffer != NULL)
+  {
+    next = buffer->next;
+    _freeBuffer(buffer);
+    buffer = next;
+  }
+}
+
+/**
+ * Drop a reference of the pool. The last reference frees the pool together
+ * with all buffers it still holds.
+ *
+ * @param pool The pool.
+ *
+ * @since 0.4.1.0
+ */
+static void _dropBufferPool(PacketBufferPool* pool)
+{
+  int idx;
+
+  if (__sync_sub_and_fetch(&pool->refCount, 1) == 0)
+  {
+    _freeBufferList(__sync_lock_test_and_set(&pool->returned, NULL));
+    for (idx = 0; idx < PACKET_BUFFER_CLASSES; idx++)
+    {
+      _freeBufferList(pool->cached[idx]);
+    }
+    free(pool);
+  }
+}
+
+/**
+ * Called when the owner of the pool ends. The free buffers are released, the
+ * buffers still in use keep the pool alive.
+ *
+ * @param data The pool of the thread.
+ *
+ * @since 0.4.1.0
+ */
+static void _exitBufferPool(void* data)
+{
+  PacketBufferPool* pool = (PacketBufferPool*)data;
+  int               idx;
+
+  for (idx = 0; idx < PACKET_BUFFER_CLASSES; idx++)
+  {
+    _freeBufferList(pool->cached[idx]);
+    pool->cached[idx]   = NULL;
+    pool->noCached[idx] = 0;
+  }
+  _bufferPool = NULL;
+  _dropBufferPool(pool);
+}
+
+/**
+ * Create the key that releases the pool of an ending thread.
+ *
+ * @since 0.4.1.0
+ */
+static void _createBufferPoolKey(void)
+{
+  pthread_key_create(&_bufferPoolKey, _exitBufferPool);
+}
+
+/**
+ * Return the pool of the calling thread, it is created with the first call.
+ *
+ * @return The pool or NULL if not enough memory is available.
+ *
+ * @since 0.4.1.0
+ */
+static PacketBufferPool* _getBufferPool(void)
+{
+  if (_bufferPool == NULL)
+  {
+    pthread_once(&_bufferPoolOnce, _createBufferPoolKey);
+    _bufferPool = calloc(1, sizeof(PacketBufferPool));
+    if (_bufferPool != NULL)
+    {
+      _bufferPool->refCount = 1;
+      pthread_setspecific(_bufferPoolKey, _bufferPool);
+    }
+  }
+  return _bufferPool;
+}
+
+/**
+ * Add the buffer to the free list of its size class within the pool of the
+ * calling thread. Buffers beyond the limit of the size class are freed.
+ *
+ * @param pool The pool of the calling thread.
+ * @param buffer The buffer.
+ *
+ * @since 0.4.1.0
+ */
+static void _cacheBuffer(PacketBufferPool* pool, PacketBuffer* buffer)
+{
+  uint32_t sizeClass = buffer->sizeClass;
+
+  if (pool->noCached[sizeClass] < _bufferClassCache[sizeClass])
+  {
+    buffer->next = pool->cached[sizeClass];
+    pool->cached[sizeClass] = buffer;
+    pool->noCached[sizeClass]++;
+  }
+  else
+  {
+    _freeBuffer(buffer);
+  }
+}
+
+/**
+ * Allocate a packet buffer of at least the given size. Buffers of the size
+ * classes (verify request IPv4, verify request IPv6, BGPsec path attribute,
+ * receive chunk) are taken from the pool of the calling thread, larger ones
+ * from the heap.
+ *
+ * @param size The number of bytes needed.
+ *
+ * @return The buffer or NULL if not enough memory is available.
+ *
+ * @since 0.4.1.0
+ */
+void* allocPacketBuffer(uint32_t size)
+{
+  PacketBufferPool* pool   = _getBufferPool();
+  PacketBuffer*     buffer = NULL;
+  PacketBuffer*     returned;
+  uint32_t          sizeClass;
+
+  for (sizeClass = 0; (sizeClass < PACKET_BUFFER_CLASSES)
+                      && (_bufferClassSize[sizeClass] < size); sizeClass++) {}
+
+  if ((pool == NULL) || (sizeClass == PACKET_BUFFER_CLASSES))
+  {
+    // Not pooled
+    buffer = malloc(sizeof(PacketBuffer) + size);
+    if (buffer == NULL)
+    {
+      return NULL;
+    }
+    buffer->pool      = NULL;
+    buffer->sizeClass = PACKET_BUFFER_CLASSES;
+    buffer->size      = size;
+    addMemStats(MEM_TAG_RECEIVE, sizeof(PacketBuffer) + size, 1);
+    return buffer + 1;
+  }
+
+  // Take back the buffers other threads released.
+  if ((pool->cached[sizeClass] == NULL) && (pool->returned != NULL))
+  {
+    returned = __sync_lock_test_and_set(&pool->returned, NULL);
+    while (returned != NULL)
+    {
+      buffer   = returned;
+      returned = returned->next;
+      _cacheBuffer(pool, buffer);
+    }
+  }
+
+  buffer = pool->cached[sizeClass];
+  if (buffer != NULL)
+  {
+    pool->cached[sizeClass] = buffer->next;
+    pool->noCached[sizeClass]--;
+  }
+  else
+  {
+    buffer = malloc(sizeof(PacketBuffer) + _bufferClassSize[sizeClass]);
+    if (buffer == NULL)
+    {
+      return NULL;
+    }
+    buffer->pool      = pool;
+    buffer->sizeClass = sizeClass;
+    addMemStats(MEM_TAG_RECEIVE,
+                sizeof(PacketBuffer) + _bufferClassSize[sizeClass], 1);
+  }
+  __sync_add_and_fetch(&pool->refCount, 1);
+
+  return buffer + 1;
+}
+
+/**
+ * Free a buffer allocated with allocPacketBuffer. Any thread can free the
+ * buffer, it is handed back to the pool of the thread that allocated it.
+ *
+ * @param data The buffer, can be NULL.
+ *
+ * @since 0.4.1.0
+ */
+void freePacketBuffer(void* data)
+{
+  PacketBuffer*     buffer;
+  PacketBufferPool* pool;
+  PacketBuffer*     head;
+
+  if (data == NULL)
+  {
+    return;
+  }
+  buffer = (PacketBuffer*)data - 1;
+  pool   = buffer->pool;
+  if (pool == NULL)
+  {
+    _freeBuffer(buffer);
+    return;
+  }
+
+  if (pool == _bufferPool)
+  {
+    _cacheBuffer(pool, buffer);
+  }
+  else
+  {
+    // The owner takes the complete list at once, a push cannot suffer ABA.
+    do
+    {
+      head         = pool->returned;
+      buffer->next = head;
+    } while (!__sync_bool_compare_and_swap(&pool->returned, head, buffer));
+  }
+  _dropBufferPool(pool);
+}
+
+/**
+ * Allocate a new packet chunk of the given size. The caller holds the only 
+ * reference.
+ *
+ * @param size The number of bytes the chunk can store.
+ *
+ * @return The chunk or NULL if not enough memory is available.
+ *
+ * @since 0.4.1.0
+ */
+PacketChunk* createPacketChunk(uint32_t size)
+{
+  PacketChunk* chunk = allocPacketBuffer(sizeof(PacketChunk) + size);
+  if (chunk != NULL)
+  {
+    chunk->refCount = 1;
+    chunk->size     = size;
+  }
+  return chunk;
+}
+
+/**
+ * Add a reference to the given chunk.
+ *
+ * @param chunk The chunk the caller already holds a reference of.
+ *
+ * @since 0.4.1.0
+ */
+void retainPacketChunk(PacketChunk* chunk)
+{
+  __sync_add_and_fetch(&chunk->refCount, 1);
+}
+
+/**
+ * Release a reference of the given chunk. The last reference frees the chunk.
+ *
+ * @param chunk The chunk to release, can be NULL.
+ *
+ * @since 0.4.1.0
+ */
+void releasePacketChunk(PacketChunk* chunk)
+{
+  if ((chunk != NULL) && (__sync_sub_and_fetch(&chunk->refCount, 1) == 0))
+  {
+    freePacketBuffer(chunk);
+  }
+}
+
+/**
+ * Set the chunk that holds the PDUs dispatched by the calling thread.
+ *
+ * @param chunk The chunk or NULL.
+ *
+ * @since 0.4.1.0
+ */
+void setDispatchedPacketChunk(PacketChunk* chunk)
+{
+  _dispatchedChunk = chunk;
+}
+
+/**
+ * Retain the chunk the given PDU is stored in. This only succeeds for PDUs 
+ * that are currently dispatched by the calling thread and are stored in a 
+ * chunk. 
+ *
+ * @param pdu The PDU
+ * @param length The length of the PDU
+ *
+ * @return The retained chunk or NULL if the PDU must be copied.
+ *
+ * @since 0.4.1.0
+ */
+PacketChunk* retainDispatchedPacket(void* pdu, uint32_t length)
+{
+  PacketChunk* chunk = _dispatchedChunk;
+  uint8_t*     start = (uint8_t*)pdu;
+
+  if ((chunk == NULL) || (start < chunk->data) 
+      || (start + length > chunk->data + chunk->size))
+  {
+    return NULL;
+  }
+  retainPacketChunk(chunk);
+  return chunk;
+}
+
+/**
+ * Replace the given chunk with a new one of the given size. The bytes not 
+ * processed yet are copied to the front of the new chunk and the reference of
+ * the old chunk is released.
+ * 
+ * @param chunk The chunk to be replaced.
+ * @param start The position of the first byte not processed yet.
+ * @param fill The number of bytes stored in the chunk.
+ * @param size The size of the new chunk.
+ * 
+ * @return The new chunk or NULL if not enough memory is available. In this 
+ *         case the old chunk is kept.
+ * 
+ * @since 0.4.1.0
+ */
+static PacketChunk* _replaceChunk(PacketChunk* chunk, uint32_t start, 
+                                  uint32_t fill, uint32_t size)
+{
+  PacketChunk* newChunk = createPacketChunk(size);
+  if (newChunk != NULL)
+  {
+    memcpy(newChunk->data, chunk->data + start, fill - start);
+    releasePacketChunk(chunk);
+  }
+  return newChunk;
+}
+
 /**
  * This function runs in a loop to receive packets. This function is used as 
  * receiver loop on both sides, SRx server as well as SRx client. IN case the 
  * SRx server uses. this method the parameter connHandler MUST be NULL.
  *
- * @note Blocking call, only if in server mode. Clients run through only once.
+ * @note Blocking call, only if in server mode. Clients run through only once,
+ *       they process all PDUs received with one read.
  *
  * @param fdPtr        The file descriptor of the socket
  * @param dispatcher   The dispatcher method that receives all packets and
@@ -69,14 +497,24 @@ bool receivePackets(int* fdPtr, SRxPacketHandler dispatcher, void* pHandler,
   bool retVal = true;
   // 8 bytes that contain the type and length
   uint32_t              basicLength = sizeof(SRXPROXY_BasicHeader);
-  // Buffer that contains the bytes received.
-  uint8_t*              buffer = malloc(basicLength);
-  // A helper that points into the buffer at byte 9
-  uint8_t*              buffHelper = buffer;//+basicLength;
+  // The chunk that contains the bytes received.
+  PacketChunk*          chunk  = createPacketChunk(RECV_BUFFER_SIZE);
+  // The bytes received
+  uint8_t*              buffer = chunk != NULL ? chunk->data : NULL;
   // The size of the current buffer. Can be larger than the message itself
-  uint32_t              buffSize   = basicLength;
-  // Bytes left after the basic length (of 8 bytes)
-  uint32_t              remainder  = buffSize - basicLength;
+  uint32_t              buffSize   = RECV_BUFFER_SIZE;
+  // The next chunk in case the current one must be replaced
+  PacketChunk*          newChunk   = NULL;
+  // Indicates if handlers hold references to the current chunk
+  bool                  shared     = false;
+  // The number of bytes stored in the buffer
+  uint32_t              buffFill   = 0;
+  // The position of the first byte not processed yet.
+  uint32_t              buffStart  = 0;
+  // The number of bytes to be received next
+  uint32_t              toReceive  = 0;
+  // The number of bytes received
+  size_t                received   = 0;
   // The header mask layer put on top of the buffer for easier access
   SRXPROXY_BasicHeader* hdr        = (SRXPROXY_BasicHeader*)buffer;
   // The length of the PDU within the buffer
@@ -93,35 +531,114 @@ bool receivePackets(int* fdPtr, SRxPacketHandler dispatcher, void* pHandler,
     cmdQueue = (CommandQueue *)hSvrConnection->cmdQueue;
   }
 
+  if (chunk == NULL)
+  {
+    RAISE_ERROR("Not enough memory for receiving packets");
+    return false;
+  }
+
   // used to keep the receiver going.
   bool keepGoing = true;
 
   // Keeps the thread rolling - Process all packets
   while (keepGoing)
   {
-    // initialize the buffer as \0
-    // memset(buffer, 0, buffSize);
-    // Only the basic header needs to be initialized at this point. The 
-    // remainder will be initialized later.
-    memset(buffer, 0, sizeof(SRXPROXY_BasicHeader));
+    // Process all complete PDUs stored in the buffer. Handlers can keep
+    // references to the PDUs of the chunk.
+    setDispatchedPacketChunk(chunk);
+    while (((buffFill - buffStart) >= basicLength) && (*fdPtr != -1))
+    {
+      hdr = (SRXPROXY_BasicHeader*)(buffer + buffStart);
+      pduLength = ntohl(hdr->length);
+      if (pduLength < basicLength)
+      {
+        RAISE_ERROR( HDR "Received PDU is invalid!", pthread_self());
+        pduLength = basicLength;
+      }
+      if ((buffFill - buffStart) < pduLength)
+      {
+        // The PDU is split, the remainder is not received yet.
+        break;
+      }
+      
+      // the first byte of the buffer contains the pdu type
+      LOG(LEVEL_DEBUG, HDR "Received data and call dispatcher.", 
+          pthread_self());
+      // call the dispatcher that deals with the packet
+      // TODO: Good point to have a receiver queue handing it over to.
+      dispatcher(hdr, pHandler);
+      buffStart += pduLength;
+    }
+    setDispatchedPacketChunk(NULL);
+    
+    // Move a split PDU to the front of the buffer. This is only possible as
+    // long as no handler holds a reference to the chunk. The reference count
+    // cannot increase concurrently, only holders of a reference add more.
+    shared = chunk->refCount > 1;
+    if ((buffStart > 0) && !shared)
+    {
+      buffFill -= buffStart;
+      memmove(buffer, buffer + buffStart, buffFill);
+      buffStart = 0;
+    }
     
-    hdr = (SRXPROXY_BasicHeader*)buffer;
     if (pHandlerType == PHT_PROXY)
     {
-      // When in proxy, don't continue looping, the client reads once and then 
-      // leaves
-      keepGoing = false;
+      // When in proxy, don't continue looping once all received PDUs are 
+      // processed, the client reads once and then leaves
+      if (received > 0 && buffFill == buffStart)
+      {
+        keepGoing = false;
+        continue;
+      }
     }
-
-    retVal = true;    
-    // Get the data
-    if (!recvNum(fdPtr, buffer, basicLength))
+    
+    // Determine the number of bytes needed to complete the next PDU
+    pduLength = basicLength;
+    if ((buffFill - buffStart) >= basicLength)
+    {
+      pduLength = ntohl(((SRXPROXY_BasicHeader*)(buffer + buffStart))->length);
+    }
+    if (    ((buffSize - buffStart) < pduLength)
+         || ((buffStart > 0) && ((buffSize - buffFill) < RECV_BUFFER_MIN_FREE)))
+    {
+      // Either the current packet is larger than the current buffer or the
+      // shared chunk is used up - need a new or larger buffer. The chunks
+      // come from the pool of this thread and are not resized.
+      buffSize = pduLength > RECV_BUFFER_SIZE ? pduLength : RECV_BUFFER_SIZE;
+      newChunk = _replaceChunk(chunk, buffStart, buffFill, buffSize);
+      if (newChunk == NULL)
+      {
+        RAISE_ERROR("Not enough memory for receiving packets");
+        retVal = false;
+        keepGoing = false;
+        continue;
+      }
+      chunk       = newChunk;
+      chunk->size = buffSize;
+      buffer      = chunk->data;
+      buffFill   -= buffStart;
+      buffStart   = 0;
+    }
+    
+    // Fill up the buffer. A proxy that already received data only completes
+    // the split PDU to not read beyond it.
+    toReceive = ((pHandlerType == PHT_PROXY) && (received > 0)) 
+                ? pduLength - (buffFill - buffStart) : buffSize - buffFill;    
+    received = recvChunk(fdPtr, buffer + buffFill, toReceive);
+    if (received == 0)
     {
       // Just get the error, might not be used though!      
       int error = getLastRecvError();
       keepGoing = false;
+      retVal    = false;
       
-      if (pHandlerType == PHT_PROXY)
+      if (buffFill > buffStart)
+      {
+        RAISE_ERROR("Could not receive the remaining %u bytes, error %d!",
+                    pduLength - (buffFill - buffStart), error);
+      }
+      else if (pHandlerType == PHT_PROXY)
       {
         // Within SRx Proxy
         ClientConnectionHandler* cHandler =  
@@ -129,18 +646,13 @@ bool receivePackets(int* fdPtr, SRxPacketHandler dispatcher, void* pHandler,
         
         if (!cHandler->stop)
         {
-          if(*fdPtr == -1)
-          {
-            retVal = false;
-          }
-          //return retVal;
+          // Only a closed socket is an error
+          retVal = *fdPtr != -1;
         }
         else
         {
           LOG(LEVEL_DEBUG, HDR "Data delivery interrupted - End server loop!",
               pthread_self());
-          retVal = false;
-          //return;
         }
       }
       else if (pHandlerType == PHT_SERVER)
@@ -148,82 +660,19 @@ bool receivePackets(int* fdPtr, SRxPacketHandler dispatcher, void* pHandler,
         // Within SRx Server (or rpki_rtr test harness
         LOG(LEVEL_DEBUG, HDR "Connection to client closed (errno %d)", 
                          pthread_self(), error);
-        retVal = false;
       }
       else
       {
         RAISE_SYS_ERROR("Invalid pHandler type!!!", pHandlerType);
-        retVal = false;
       }
-      
       continue;
-      // return retVal;
-    }
-
-    // Data was received!!    
-    pduLength = ntohl(hdr->length);
-    if (buffSize < pduLength)
-    {
-      // The current packet is Larger than the current buffer size
-      // - need to resize the buffer
-      buffSize = (size_t)pduLength;
-      buffer  = realloc(buffer, buffSize);
-
-      if (buffer == NULL)
-      {
-        RAISE_ERROR("Not enough memory for receiving packets");
-        retVal = false;
-        keepGoing = false;
-        continue;
-        //break;
-      	//return retVal;
-      }
-      // might be same address but just in case.
-      buffHelper = buffer + basicLength;
-    }
-    
-    // Determine how much data is missing to complete the packet
-    remainder = pduLength - basicLength;
-    if (remainder > pduLength)
-    {
-      RAISE_ERROR( HDR "Received PDU is invalid!", pthread_self());
-      remainder = 0;
-    }
-    // initialize the extended memory with \0
-    memset(buffHelper, 0, buffSize - basicLength);
-
-    // Receive the remainder of the packet
-    if (!recvNum(fdPtr, buffHelper, (size_t)remainder))
-    {
-      int error = getLastRecvError();
-      RAISE_ERROR("Could not receive the basic remaining %u bytes, error %d!",
-                  remainder, error);
-      //break;
-      retVal = false;
-      keepGoing = false;
-      continue;
-      //return retVal;
-    }
-
-    if (retVal)
-    {
-      // the first byte of the buffer contains the pdu type
-      LOG(LEVEL_DEBUG, HDR "Received data and call dispatcher.", 
-          pthread_self());
-      // call the dispatcher that deals with the packet
-      // TODO: Good point to have a receiver queue handing it over to.
-      dispatcher((SRXPROXY_BasicHeader*)buffer, pHandler);
     }
+    buffFill += received;
   }
 
-  // Release the buffer and parameter structure
-  if (buffer != NULL)
-  {
-    buffHelper = NULL;
-    free(buffer);
-  }
+  // Release the reference of the receiver, handlers might still hold theirs.
+  releasePacketChunk(chunk);
   LOG(LEVEL_DEBUG, HDR "Leave receive packets function.", pthread_self());
 
   return retVal;
 }
-
@@ -20,10 +20,16 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added PacketChunk, a reference counted receive buffer that
+ *              allows to hand PDUs to other threads without copying them.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added allocPacketBuffer and freePacketBuffer, packet buffers
+ *              are recycled by a pool of the allocating thread.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  *            * Added Changelog
@@ -38,6 +44,27 @@
 /** Specifies the length of a packet. */
 typedef uint32_t PacketLength;
 
+/** The number of size classes of the packet buffer pools. */
+#define PACKET_BUFFER_CLASSES 4
+
+/** The bytes of AS path a pooled verify request buffer has room for. */
+#define PACKET_BUFFER_PATH_SIZE 64
+
+/** The size of a pooled buffer for PDUs carrying a BGPsec path attribute. */
+#define PACKET_BUFFER_BGPSEC_SIZE 4096
+
+/**
+ * A reference counted chunk of memory the receiver reads into. PDUs stored
+ * in a chunk can be referenced by queues as long as they hold a reference.
+ * The bytes of a chunk are never moved or overwritten while other references
+ * exist.
+ */
+typedef struct {
+  volatile uint32_t refCount; // The number of references held
+  uint32_t          size;     // The number of bytes in data
+  uint8_t           data[];   // The bytes received
+} PacketChunk;
+
 /** This enumeration helps to determine who uses the packet handler, the SRx 
  * server or the SRx proxy. */
 typedef enum {
@@ -78,5 +105,84 @@ typedef void (*SRxPacketHandler)(SRXPROXY_BasicHeader* dataHeader,
 bool receivePackets(int* fdPtr, SRxPacketHandler dispatcher, void* pHandler, 
                     PacketHandlerType pHandlerType);
 
+/**
+ * Allocate a packet buffer of at least the given size. Buffers of the size
+ * classes (verify request IPv4, verify request IPv6, BGPsec path attribute,
+ * receive chunk) are taken from the pool of the calling thread, larger ones
+ * from the heap.
+ *
+ * @param size The number of bytes needed.
+ *
+ * @return The buffer or NULL if not enough memory is available.
+ *
+ * @since 0.4.1.0
+ */
+void* allocPacketBuffer(uint32_t size);
+
+/**
+ * Free a buffer allocated with allocPacketBuffer. Any thread can free the
+ * buffer, it is handed back to the pool of the thread that allocated it.
+ *
+ * @param buffer The buffer, can be NULL.
+ *
+ * @since 0.4.1.0
+ */
+void freePacketBuffer(void* buffer);
+
+/**
+ * Allocate a new packet chunk of the given size. The caller holds the only 
+ * reference.
+ *
+ * @param size The number of bytes the chunk can store.
+ *
+ * @return The chunk or NULL if not enough memory is available.
+ *
+ * @since 0.4.1.0
+ */
+PacketChunk* createPacketChunk(uint32_t size);
+
+/**
+ * Add a reference to the given chunk.
+ *
+ * @param chunk The chunk the caller already holds a reference of.
+ *
+ * @since 0.4.1.0
+ */
+void retainPacketChunk(PacketChunk* chunk);
+
+/**
+ * Release a reference of the given chunk. The last reference frees the chunk.
+ *
+ * @param chunk The chunk to release, can be NULL.
+ *
+ * @since 0.4.1.0
+ */
+void releasePacketChunk(PacketChunk* chunk);
+
+/**
+ * Set the chunk that holds the PDUs dispatched by the calling thread. Threads
+ * that hand PDUs of a chunk to a handler set the chunk before and reset it to
+ * NULL afterwards.
+ *
+ * @param chunk The chunk or NULL.
+ *
+ * @since 0.4.1.0
+ */
+void setDispatchedPacketChunk(PacketChunk* chunk);
+
+/**
+ * Retain the chunk the given PDU is stored in. This only succeeds for PDUs 
+ * that are currently dispatched by the calling thread and are stored in a 
+ * chunk. The caller must release the chunk once the PDU is not used anymore.
+ *
+ * @param pdu The PDU
+ * @param length The length of the PDU
+ *
+ * @return The retained chunk or NULL if the PDU must be copied.
+ *
+ * @since 0.4.1.0
+ */
+PacketChunk* retainDispatchedPacket(void* pdu, uint32_t length);
+
 #endif // !__PACKET_H__
 
@@ -23,10 +23,12 @@
  * IPv4 and IPv6 address and prefix structures and functions.
  * log.h is used for error message handling.
  * 
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * cpyPrefix copies only the 4 address bytes of an IPv4 prefix.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed unused variables in cpyPrefix  
  * 0.3.0    - 2013/01/28 - oborchert
@@ -164,7 +166,8 @@ const char* ipPrefixToStr(IPPrefix* prefix, char* dest, size_t size) {
 
 
 /**
- * Copy the contents of source prefix into destination prefix.
+ * Copy the contents of source prefix into destination prefix. Only the 4
+ * address bytes of an IPv4 prefix are copied.
  * 
  * @param dst The destination prefix
  * @param src The source prefix
@@ -179,7 +182,14 @@ extern bool cpyPrefix(IPPrefix* dst, IPPrefix* src)
   {
     dst->length     = src->length;
     dst->ip.version = src->ip.version;
-    memcpy(dst->ip.addr.v6.u8, src->ip.addr.v6.u8, 16);
+    if (src->ip.version == 4)
+    {
+      dst->ip.addr.v4.u32 = src->ip.addr.v4.u32;
+    }
+    else
+    {
+      memcpy(dst->ip.addr.v6.u8, src->ip.addr.v6.u8, 16);
+    }
   }  
   return retVal;
 }
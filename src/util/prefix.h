@@ -23,10 +23,13 @@
  * IPv4 and IPv6 address and prefix structures and functions.
  * log.h is used for error message handling.
  * 
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ *   0.4.1.0  - 2026/10/15 - kyehwanl
+ *              * cpyPrefix copies only the 4 address bytes of an IPv4 prefix.
+ *              * Added IS_SAME_IPV4_PREFIX.
  *   0.3.0.10 - 2015/11/06 - oborchert
  *              * removed types.h
  *   0.3.0    - 2013/01/28 - oborchert
@@ -127,6 +130,22 @@ typedef struct {
 #define GET_MAX_PREFIX_LEN(IP_ADDR) \
   (((IP_ADDR).version == 4) ? MAX_PREFIX_LEN_V4 : MAX_PREFIX_LEN_v6)
 
+/**
+ * Compare an IPv4 prefix with a prefix of any version. Only the 32 bit address
+ * and the length are compared.
+ *
+ * @param V4_PREFIX An IPPrefix of version 4
+ * @param PREFIX The IPPrefix to compare with
+ *
+ * @return true if both prefixes are equal
+ *
+ * @since 0.4.1.0
+ */
+#define IS_SAME_IPV4_PREFIX(V4_PREFIX, PREFIX) \
+  (   ((PREFIX).ip.version == 4) \
+   && ((PREFIX).ip.addr.v4.u32 == (V4_PREFIX).ip.addr.v4.u32) \
+   && ((PREFIX).length == (V4_PREFIX).length))
+
 /**
  * Parses textual representation of an IPv4 address.
  * 
@@ -211,10 +230,11 @@ extern const char* ipAddressToStr(IPAddress* ip, char* dest, size_t size);
 extern const char* ipPrefixToStr(IPPrefix* prefix, char* dest, size_t size);
 
 /**
- * Copy the contents of source prefix into destination prefix.
+ * Copy the contents of source prefix into destination prefix. Only the 4
+ * address bytes of an IPv4 prefix are copied.
  * 
  * @param dst The destination prefix
- * @param src The source IPv4Address
+ * @param src The source prefix
  * 
  * @return true if the prefix copy was successful.
  */
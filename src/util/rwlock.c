@@ -26,6 +26,7 @@
  */
 
 #include "util/rwlock.h"
+#include "util/lock_stats.h"
 #include "util/log.h"
 
 bool createRWLock(RWLock* self)
@@ -43,6 +44,9 @@ void releaseRWLock(RWLock* self)
 {
   if (self != NULL) 
   {
+#ifdef LOCK_STATS
+    clearLockName(self);
+#endif
     int ret = pthread_rwlock_destroy(self);
 
     // Unlock if busy
@@ -57,9 +61,55 @@ void releaseRWLock(RWLock* self)
   }
 }
 
+#ifdef LOCK_STATS
+/**
+ * Acquire the read lock and record the acquisition and its wait.
+ *
+ * @param self Instance
+ *
+ * @since 0.4.1.0
+ */
+static void _recordReadLock(RWLock* self)
+{
+  uint64_t waitStart = 0;
+
+  if (pthread_rwlock_tryrdlock(self) != 0)
+  {
+    waitStart = getLockTime();
+    pthread_rwlock_rdlock(self);
+  }
+  recordLockAcquire(self, waitStart, false);
+}
+
+/**
+ * Acquire the write lock and record the acquisition and its wait.
+ *
+ * @param self Instance
+ *
+ * @since 0.4.1.0
+ */
+static void _recordWriteLock(RWLock* self)
+{
+  uint64_t waitStart = 0;
+
+  if (pthread_rwlock_trywrlock(self) != 0)
+  {
+    waitStart = getLockTime();
+    pthread_rwlock_wrlock(self);
+  }
+  recordLockAcquire(self, waitStart, true);
+}
+
+#define RDLOCK(SELF) _recordReadLock(SELF)
+#define WRLOCK(SELF) _recordWriteLock(SELF)
+#else
+#define RDLOCK(SELF) pthread_rwlock_rdlock(SELF)
+#define WRLOCK(SELF) pthread_rwlock_wrlock(SELF)
+#endif
+
 void acquireReadLock(RWLock* self)
 {
-  pthread_rwlock_rdlock(self);
+  RDLOCK(self);
 }
 
 void unlockReadLock(RWLock* self)
@@ -69,11 +119,26 @@ void unlockReadLock(RWLock* self)
 
 void acquireWriteLock(RWLock* self)
 {
-  pthread_rwlock_wrlock(self);
+  WRLOCK(self);
+}
+
+bool tryWriteLock(RWLock* self)
+{
+  if (pthread_rwlock_trywrlock(self) != 0)
+  {
+    return false;
+  }
+#ifdef LOCK_STATS
+  recordLockAcquire(self, 0, true);
+#endif
+  return true;
 }
 
 void unlockWriteLock(RWLock* self)
 {
+#ifdef LOCK_STATS
+  recordLockRelease(self);
+#endif
   pthread_rwlock_unlock(self);
 }
 
@@ -81,15 +146,17 @@ void changeReadToWriteLock(RWLock* self)
 {
   if (pthread_rwlock_unlock(self) == 0)
   {
-    pthread_rwlock_wrlock(self);
+    WRLOCK(self);
   }
 }
 
 void changeWriteToReadLock(RWLock* self)
 {
+#ifdef LOCK_STATS
+  recordLockRelease(self);
+#endif
   if (pthread_rwlock_unlock(self) == 0)
   {
-    pthread_rwlock_rdlock(self);
+    RDLOCK(self);
   }
 }
-
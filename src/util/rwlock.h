@@ -22,10 +22,12 @@
  * Read/write lock - multiple readers or one writer at the same time
  * @note Currently based on PThread
  * 
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added tryWriteLock.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  *            * Added Changelog
@@ -81,6 +83,16 @@ extern void unlockReadLock(RWLock* self);
  */
 extern void acquireWriteLock(RWLock* self);
 
+/** 
+ * Acquires a write lock if no other read or write lock is held.
+ *
+ * @param self Instance
+ * @return \c true = the write lock is acquired, \c false = the lock is busy
+ *
+ * @since 0.4.1.0
+ */
+extern bool tryWriteLock(RWLock* self);
+
 /**
  * Unlocks a write lock.
  *
@@ -26,7 +26,19 @@
  *
  * Changelog:
  * -----------------------------------------------------------------------------
- *  0.4.1.0 - 2016/10/26 - oborchert
+ *  0.4.1.0 - 2026/10/14 - kyehwanl
+ *            * Added MODE_EVENT_LOOP. All connections are served by a small
+ *              number of epoll reactor threads using non-blocking sockets.
+ *            * MODE_MULTIPLE_CLIENTS uses a fixed pool of worker threads per
+ *              connection instead of a thread per received packet.
+ *          - 2026/10/15 - kyehwanl
+ *            * The connection threads are placed and named by createThread.
+ *            * Co-located proxies can connect using the shared memory
+ *              transport in MODE_SINGLE_CLIENT, see setShmTransport.
+ *            * MODE_EVENT_LOOP can queue the data that cannot be written
+ *              right away, the reactors write it once the socket becomes
+ *              writable. See setEventLoopSendQueue and sendSharedToClient.
+ *          - 2016/10/26 - oborchert
  *            * BZ1037: Replaces legacy calls to bzero with memset
  *          - 2016/08/19 - oborchert
  *            * Moved socket connection error strings to the header file.
@@ -54,7 +66,11 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <pthread.h>
@@ -64,6 +80,8 @@
 #include "util/slist.h"
 #include "util/socket.h"
 #include "util/server_socket.h"
+#include "util/shm_transport.h"
+#include "util/thread.h"
 
 #define HDR  "([0x%08X] Server Socket): "
 
@@ -117,6 +135,25 @@ static bool initWriteMutex(ClientThread* cthread)
   return true;
 }
 
+/**
+ * Close the shared memory transport of the client and its control connection.
+ * Only the first call for a client closes them.
+ *
+ * @param ct Instance
+ *
+ * @since 0.4.1.0
+ */
+static void closeShmClient(ClientThread* ct)
+{
+  int fd = __sync_lock_test_and_set(&ct->shmFD, -1);
+
+  if (fd != -1)
+  {
+    closeShmTransport(fd);
+    close(fd);
+  }
+}
+
 /**
  * Clean-up of a single ClientThread.
  *
@@ -125,6 +162,9 @@ static bool initWriteMutex(ClientThread* cthread)
  */
 static void clientThreadCleanup(ClientMode mode, ClientThread* ct)
 {
+  // Unmap the rings before the status callback releases the client.
+  closeShmClient(ct);
+
   // Let the user know about the client loss
   if (ct->svrSock->statusCallback != NULL)
   {
@@ -248,23 +288,30 @@ static void* single_handleClient(void* clientThread)
  * MODE_MULTIPLE_CLIENTS
  */
 
+/** The number of worker threads processing the packets of one client 
+ * connection. */
+#define MULTI_WORKER_THREADS 4
+/** The maximum number of received packets per client connection that wait for
+ * or are in processing by a worker. The reader blocks if all are in use. */
+#define MULTI_MAX_PENDING    64
+
 /**
- * A single packet thread.
+ * A single received packet. It is handed to the callback as ServerClient and 
+ * provides the id needed to tag the response.
  *
  * @note MODE_MULTIPLE_CLIENTS
  */
-typedef struct
+typedef struct _PacketJob
 {
   // Data that never changes - just to pass it
   ClientThread* clThread;
-  Mutex* readMutex;
-  Mutex* writeMutex; // Unlike "readMutex" this is just a weak copy
+  Mutex* writeMutex; // Just a weak copy
 
   // "Pool" data
-  pthread_t thread;
-  bool active;
   void* buffer;
   size_t bufferSize;
+  /** The next job in the queue or the free list. */
+  struct _PacketJob* next;
 
   // Data that changes on every access
 #pragma pack(1)
@@ -275,7 +322,37 @@ typedef struct
     PacketLength packetLen;
   } hdr;
 #pragma pack(0)
-} PacketThread;
+} PacketJob;
+
+/**
+ * The worker pool of a single client connection. The reader of the 
+ * connection fills the queue, the workers process it.
+ *
+ * @note MODE_MULTIPLE_CLIENTS
+ */
+typedef struct
+{
+  /** Guards the queue and the free list. */
+  Mutex      mutex;
+  /** Signaled when a packet is queued or the pool stops. */
+  Cond       jobAvailable;
+  /** Signaled when a job returns to the free list. */
+  Cond       slotAvailable;
+  /** All jobs of this pool. */
+  PacketJob  jobs[MULTI_MAX_PENDING];
+  /** Unused jobs. */
+  PacketJob* freeJobs;
+  /** The first received packet waiting for a worker. */
+  PacketJob* head;
+  /** The last received packet waiting for a worker. */
+  PacketJob* tail;
+  /** Set to true once the reader stopped. */
+  bool       stop;
+  /** The worker threads. */
+  pthread_t  workers[MULTI_WORKER_THREADS];
+  /** The number of started workers. */
+  int        numWorkers;
+} PacketWorkerPool;
 
 /**
  * Sends the result back to the client.
@@ -288,7 +365,7 @@ typedef struct
  */
 static bool multi_sendResult(ServerClient* client, void* data, size_t size)
 {
-  PacketThread* pt = (PacketThread*)client;
+  PacketJob* pt = (PacketJob*)client;
 
   if (pt->clThread->active)
   {
@@ -312,66 +389,238 @@ static bool multi_sendResult(ServerClient* client, void* data, size_t size)
 }
 
 /**
- * Receives a single packet, calls the callback and then waits until the
- * client-thread unblocks this call.
+ * Worker thread that passes the queued packets to the callback until the 
+ * pool is stopped and the queue is empty.
  *
  * @note MODE_MULTIPLE_CLIENTS
  * @note PThread syntax
  *
- * @param arg PacketThread instance
- * @return \c 0 = successful, \c 1+ = error
+ * @param arg PacketWorkerPool instance
+ * @return Always \c 0
  */
-static void* multi_handleSinglePacket(void* arg)
+static void* multi_handlePackets(void* arg)
 {
-  PacketThread* pt = (PacketThread*)arg;
-  bool succ;
+  PacketWorkerPool* pool = (PacketWorkerPool*)arg;
+  PacketJob*        job;
 
-  LOG (LEVEL_DEBUG, "([0x%08X]) > Server Socket (SinglePacketHandler) thread "
+  LOG (LEVEL_DEBUG, "([0x%08X]) > Server Socket (PacketWorker) thread "
                     "started!", pthread_self());
-  
+
+  lockMutex(&pool->mutex);
+  for (;;)
+  {
+    while ((pool->head == NULL) && !pool->stop)
+    {
+      waitCond(&pool->jobAvailable, &pool->mutex, 0);
+    }
+    job = pool->head;
+    if (job == NULL)
+    {
+      // Stopped and nothing left to do
+      break;
+    }
+    pool->head = job->next;
+    if (pool->head == NULL)
+    {
+      pool->tail = NULL;
+    }
+    unlockMutex(&pool->mutex);
+
+    // Let the user-callback process the packet 
+    ((ServerPacketReceived)job->clThread->svrSock->modeCallback)(
+                                                job->clThread->svrSock, job,
+                                                job->buffer, job->hdr.packetLen,
+                                                job->clThread->svrSock->user);
+
+    lockMutex(&pool->mutex);
+    job->next      = pool->freeJobs;
+    pool->freeJobs = job;
+    signalCond(&pool->slotAvailable);
+  }
+  unlockMutex(&pool->mutex);
+
+  LOG (LEVEL_DEBUG, "([0x%08X]) < Server Socket (PacketWorker) thread "
+                    "stopped!", pthread_self());
+
+  pthread_exit(0);
+}
+
+/**
+ * Initializes the worker pool and starts the worker threads.
+ *
+ * @note MODE_MULTIPLE_CLIENTS
+ *
+ * @param pool The pool to be initialized
+ * @param cthread The client connection
+ *
+ * @return \c true = started, \c false = failed to start any worker
+ */
+static bool multi_initWorkerPool(PacketWorkerPool* pool, ClientThread* cthread)
+{
+  int idx;
+
+  memset(pool, 0, sizeof(PacketWorkerPool));
+  if (!initMutex(&pool->mutex))
+  {
+    RAISE_ERROR("Failed to create the mutex of the packet worker pool");
+    return false;
+  }
+  initCond(&pool->jobAvailable);
+  initCond(&pool->slotAvailable);
+
+  for (idx = 0; idx < MULTI_MAX_PENDING; idx++)
+  {
+    pool->jobs[idx].clThread   = cthread;
+    pool->jobs[idx].writeMutex = &cthread->writeMutex;
+    pool->jobs[idx].next       = pool->freeJobs;
+    pool->freeJobs = &pool->jobs[idx];
+  }
+
+  for (idx = 0; idx < MULTI_WORKER_THREADS; idx++)
+  {
+    if (createThread(&pool->workers[idx], NULL, THREAD_CLASS_NETWORK,
+                     "srx-worker", multi_handlePackets, pool) != 0)
+    {
+      RAISE_ERROR("Failed to create a packet worker thread");
+      break;
+    }
+    pool->numWorkers++;
+  }
+
+  if (pool->numWorkers == 0)
+  {
+    destroyCond(&pool->jobAvailable);
+    destroyCond(&pool->slotAvailable);
+    releaseMutex(&pool->mutex);
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Stops the worker pool once all queued packets are processed, joins the 
+ * workers and releases all resources. Also used as cancellation cleanup 
+ * handler for the client reader.
+ *
+ * @note MODE_MULTIPLE_CLIENTS
+ *
+ * @param arg The PacketWorkerPool instance
+ */
+static void multi_releaseWorkerPool(void* arg)
+{
+  PacketWorkerPool* pool = (PacketWorkerPool*)arg;
+  int idx;
+
+  lockMutex(&pool->mutex);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->jobAvailable);
+  unlockMutex(&pool->mutex);
+
+  for (idx = 0; idx < pool->numWorkers; idx++)
+  {
+    pthread_join(pool->workers[idx], NULL);
+  }
+
+  for (idx = 0; idx < MULTI_MAX_PENDING; idx++)
+  {
+    safeFree(pool->jobs[idx].buffer);
+    pool->jobs[idx].buffer = NULL;
+  }
+
+  destroyCond(&pool->jobAvailable);
+  destroyCond(&pool->slotAvailable);
+  releaseMutex(&pool->mutex);
+}
+
+/**
+ * Receives a single packet into a free job of the pool and queues it for the
+ * workers. Blocks until a job is available.
+ *
+ * @note MODE_MULTIPLE_CLIENTS
+ *
+ * @param pool The worker pool of this connection
+ * @param cthread The client connection
+ *
+ * @return \c false if the connection is lost or no memory is available.
+ */
+static bool multi_receivePacket(PacketWorkerPool* pool, ClientThread* cthread)
+{
+  PacketJob* job;
+  bool       succ;
+  int        cancelState;
+
+  // Don't allow to be cancelled while holding the pool mutex
+  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancelState);
+  lockMutex(&pool->mutex);
+  while (pool->freeJobs == NULL)
+  {
+    waitCond(&pool->slotAvailable, &pool->mutex, 0);
+  }
+  job = pool->freeJobs;
+  pool->freeJobs = job->next;
+  unlockMutex(&pool->mutex);
+  pthread_setcancelstate(cancelState, NULL);
+
+  // Get the id and packet length
+  succ = recvNum(&cthread->clientFD, (void*)&job->hdr,
+                 sizeof (PacketLength) + sizeof (uint32_t));
+
   // Buffer not large enough - resize
-  if (pt->bufferSize < pt->hdr.packetLen)
+  if (succ && (job->bufferSize < job->hdr.packetLen))
   {
-    void* newBuf = realloc(pt->buffer, pt->hdr.packetLen);
+    void* newBuf = realloc(job->buffer, job->hdr.packetLen);
 
     // Not enough memory
     if (newBuf == NULL)
     {
-      if (pt->bufferSize > 0)
-      {
-        free(pt->buffer);
-      }
       RAISE_SYS_ERROR("Not enough memory for the packet data");
-      pthread_exit((void*)1);
+      succ = false;
+    }
+    else
+    {
+      job->buffer     = newBuf;
+      job->bufferSize = job->hdr.packetLen;
     }
-
-    pt->buffer = newBuf;
-    pt->bufferSize = pt->hdr.packetLen;
   }
 
   // Receive the packet
-  succ = recvNum(&pt->clThread->clientFD, pt->buffer, pt->hdr.packetLen);
-  unlockMutex(pt->readMutex);
+  if (succ)
+  {
+    succ = recvNum(&cthread->clientFD, job->buffer, job->hdr.packetLen);
+  }
 
-  // Let the user-callback process the packet 
+  pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cancelState);
+  lockMutex(&pool->mutex);
   if (succ)
   {
-    ((ServerPacketReceived)pt->clThread->svrSock->modeCallback)(
-                                                  pt->clThread->svrSock, pt,
-                                                  pt->buffer, pt->hdr.packetLen,
-                                                  pt->clThread->svrSock->user);
+    // Hand it over to the workers
+    job->next = NULL;
+    if (pool->tail != NULL)
+    {
+      pool->tail->next = job;
+    }
+    else
+    {
+      pool->head = job;
+    }
+    pool->tail = job;
+    signalCond(&pool->jobAvailable);
+  }
+  else
+  {
+    job->next      = pool->freeJobs;
+    pool->freeJobs = job;
   }
+  unlockMutex(&pool->mutex);
+  pthread_setcancelstate(cancelState, NULL);
 
-  pt->active = false;
-  
-  LOG (LEVEL_DEBUG, "([0x%08X]) < Server Socket (SinglePacketHandler) thread "
-                    "stopped!", pthread_self());      
-  
-  pthread_exit(succ ? 0 : (void*)2);
+  return succ;
 }
 
 /**
- * Thread that reads all packets and passes them to a callback.
+ * Thread that reads all packets and passes them to a fixed pool of worker 
+ * threads which call the callback.
  *
  * @note MODE_MULTIPLE_CLIENTS
  * @note PThread syntax
@@ -381,13 +630,8 @@ static void* multi_handleSinglePacket(void* arg)
  */
 static void* multi_handleClient(void* data)
 {
-  RAISE_SYS_ERROR("LOOK1 ****************************************************");
-  
   ClientThread* cthread = (ClientThread*)data;
-  Mutex rmutex;
-  SList packetThreads;
-  SListNode* node;
-  PacketThread* currPT;
+  PacketWorkerPool pool;
   
   LOG(LEVEL_DEBUG, "([0x%08X]) > Proxy Client Connection Thread started "
                    "(ServerSocket::multi_handleClient)", pthread_self());
@@ -403,10 +647,10 @@ static void* multi_handleClient(void* data)
     pthread_exit((void*)1);
   }
 
-  // Create the read-mutex
-  if (!initMutex(&rmutex))
+  // The worker pool
+  if (!multi_initWorkerPool(&pool, cthread))
   {
-    RAISE_ERROR("Failed to create a read mutex for the client thread");
+    RAISE_ERROR("Failed to create the packet workers for the client thread");
     clientThreadCleanup(MODE_MULTIPLE_CLIENTS, cthread);
 
     LOG(LEVEL_DEBUG, "([0x%08X]) < Proxy Client Connection Thread stopped (2) "
@@ -415,68 +659,12 @@ static void* multi_handleClient(void* data)
     pthread_exit((void*)2);
   }
 
-  // A thread per command
-  initSList(&packetThreads);
-
-  // Process all packets
-  for (;;)
-  {
-    // Look for an inactive node and recycle it
-
-    FOREACH_SLIST(&packetThreads, node)
-    {
-      if (!((PacketThread*)getDataOfSListNode(node))->active)
-      {
-        break;
-      }
-    }
-
-    // Found an inactive node - use it
-    if (node != NULL)
-    {
-      currPT = (PacketThread*)getDataOfSListNode(node);
-
-      // Otherwise, create a new node
-    }
-    else
-    {
-      currPT = appendToSList(&packetThreads, sizeof (PacketThread));
-      if (currPT == NULL)
-      {
-        RAISE_SYS_ERROR("Not enough space to receive another packet");
-        break;
-      }
-      currPT->clThread = cthread;
-      currPT->writeMutex = &cthread->writeMutex;
-      currPT->readMutex = &rmutex;
-      currPT->buffer = NULL;
-      currPT->bufferSize = 0;
-    }
-
-    // Get the id and packet length
-    lockMutex(&rmutex);
-    if (!recvNum(&cthread->clientFD, (void*)&currPT->hdr,
-                 sizeof (PacketLength) + sizeof (uint32_t)))
-    {
-      break;
-    }
-
-    // Receive and process in a separate thread
-    currPT->active = true;
-    pthread_create(&currPT->thread, NULL, multi_handleSinglePacket,
-                   (void*)currPT);
-  }
-
-  // Thread list and internal buffers clean-up
-
-  FOREACH_SLIST(&packetThreads, node)
+  // Process all packets - stop the workers also if this thread gets cancelled 
+  pthread_cleanup_push(multi_releaseWorkerPool, &pool);
+  while (multi_receivePacket(&pool, cthread))
   {
-    safeFree(((PacketThread*)getDataOfSListNode(node))->buffer);
   }
-  releaseSList(&packetThreads);
-
-  // Mutex
-  releaseMutex(&rmutex);
+  pthread_cleanup_pop(1);
 
   // Finish up
   clientThreadCleanup(MODE_MULTIPLE_CLIENTS, cthread);
@@ -523,63 +711,821 @@ static void* custom_handleClient(void* data)
   pthread_exit(0);
 }
 
-/*--------
- * Exports
+/*----------------
+ * MODE_EVENT_LOOP
  */
 
+/** The maximum number of events a reactor fetches with one epoll_wait. */
+#define EVLOOP_MAX_EVENTS      64
+/** The initial size of the receive buffer of each connection. */
+#define EVLOOP_RCV_BUFFER_SIZE 4096
+/** Number of reads performed on one connection before the reactor continues
+ * with the next ready connection. */
+#define EVLOOP_READ_BUDGET     16
+/** The maximum number of queued buffers written with one call. */
+#define EVLOOP_MAX_IOV         16
+
 /**
- * Create the server socket where SRx is listening on.
- * @param self
- * @param port
- * @param verbose
- * @return
+ * An epoll reactor thread. Each reactor serves all connections assigned to it
+ * using non-blocking sockets.
+ *
+ * @note MODE_EVENT_LOOP
  */
-bool createServerSocket(ServerSocket* self, int port, bool verbose)
+struct _EventReactor
 {
-  struct sockaddr_in addr;
-  int yes = 1;
+  /** The reactor thread. */
+  pthread_t     thread;
+  /** The epoll instance of this reactor. */
+  int           epollFD;
+  /** eventfd used to wake up the reactor, e.g. during shutdown. */
+  int           wakeFD;
+  /** Keeps the reactor loop going. */
+  bool          running;
+  /** The server socket this reactor belongs to. */
+  ServerSocket* svrSock;
+};
+
+typedef struct _EventReactor EventReactor;
 
-  // Create a TCP socket
-  self->serverFD = socket(AF_INET, SOCK_STREAM, 0);
-  if (self->serverFD < 0)
+/**
+ * A buffer waiting in the send queue of a connection.
+ *
+ * @note MODE_EVENT_LOOP
+ */
+struct _SendSegment
+{
+  /** The next buffer of the queue. */
+  struct _SendSegment* next;
+  /** The data, either shared or a copy stored behind this segment. */
+  uint8_t*             data;
+  /** The size of the data. */
+  size_t               size;
+  /** The number of bytes already sent. */
+  size_t               offset;
+  /** Releases shared data, NULL for a copy. */
+  void               (*release)(void*);
+  /** The owner of shared data. */
+  void*                owner;
+};
+
+typedef struct _SendSegment SendSegment;
+
+/**
+ * Change the events the reactor waits for on the given connection. The
+ * writeMutex of the connection must be held.
+ *
+ * @note MODE_EVENT_LOOP
+ *
+ * @param cthread The client connection
+ * @param writable true to wait for the socket to become writable as well.
+ */
+static void evloop_armWrite(ClientThread* cthread, bool writable)
+{
+  struct epoll_event event;
+
+  if (cthread->sndArmed == writable)
   {
-    RAISE_SYS_ERROR("Failed to open a socket");
-    return false;
+    return;
   }
 
-  // Bind to a server-address
-  memset(&addr, 0, sizeof (struct sockaddr_in));
-  addr.sin_family = AF_INET;
-  addr.sin_addr.s_addr = INADDR_ANY; // inet_pton
-  addr.sin_port = htons(port);
+  memset(&event, 0, sizeof(struct epoll_event));
+  event.events   = EPOLLIN | EPOLLRDHUP | (writable ? EPOLLOUT : 0);
+  event.data.ptr = cthread;
+  if (epoll_ctl(cthread->reactor->epollFD, EPOLL_CTL_MOD, cthread->clientFD,
+                &event) == -1)
+  {
+    RAISE_SYS_ERROR("Failed to modify the events of a client connection");
+    return;
+  }
+  cthread->sndArmed = writable;
+}
 
-  // Inserted to be able to restart after crash without having to wait for the 
-  // socket to be released by the OS.
-  setsockopt(self->serverFD, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof (yes));
+/**
+ * Remove the given number of sent bytes from the send queue and release the
+ * buffers that are sent completely. The writeMutex of the connection must be
+ * held.
+ *
+ * @note MODE_EVENT_LOOP
+ *
+ * @param cthread The client connection
+ * @param sent The number of bytes sent.
+ */
+static void evloop_consumeQueue(ClientThread* cthread, size_t sent)
+{
+  SendSegment* segment;
+  size_t       left;
 
-  if (bind(self->serverFD, (struct sockaddr*)&addr, 
-           sizeof (struct sockaddr_in)) < 0)
+  cthread->sndQueued -= sent;
+  while ((cthread->sndHead != NULL) && (sent > 0))
   {
-    char* errStr = NULL;
-    switch (errno)
+    segment = cthread->sndHead;
+    left    = segment->size - segment->offset;
+    if (sent < left)
     {
-      case EADDRINUSE:
-        errStr = SOC_ERR_EADDRINUSE;                
-        RAISE_ERROR("%s", errStr);
-        break;
-      case EADDRNOTAVAIL:
-        errStr = SOC_ERR_EADDRNOTAVAIL;
-        RAISE_ERROR("%s", errStr);
-        break;
-      case EAFNOSUPPORT:
-        errStr = SOC_ERR_EAFNOSUPPORT;
-        RAISE_ERROR("%s", errStr);
-        break;
-      case EBADF:
-        errStr = SOC_ERR_EBADF;
-        RAISE_ERROR("%s", errStr);
+      segment->offset += sent;
+      break;
+    }
+    sent -= left;
+    cthread->sndHead = segment->next;
+    if (segment->release != NULL)
+    {
+      segment->release(segment->owner);
+    }
+    free(segment);
+  }
+  if (cthread->sndHead == NULL)
+  {
+    cthread->sndTail = NULL;
+  }
+}
+
+/**
+ * Release all buffers of the send queue without sending them. The writeMutex
+ * of the connection must be held unless the reactors are stopped.
+ *
+ * @note MODE_EVENT_LOOP
+ *
+ * @param cthread The client connection
+ */
+static void evloop_clearQueue(ClientThread* cthread)
+{
+  evloop_consumeQueue(cthread, cthread->sndQueued);
+}
+
+/**
+ * Write as much of the send queue as the socket takes without blocking. The
+ * writeMutex of the connection must be held.
+ *
+ * @note MODE_EVENT_LOOP
+ *
+ * @param cthread The client connection
+ *
+ * @return false if the connection is lost.
+ */
+static bool evloop_flushQueue(ClientThread* cthread)
+{
+  struct iovec  iov[EVLOOP_MAX_IOV];
+  struct msghdr msg;
+  SendSegment*  segment;
+  ssize_t       sent;
+  int           count;
+
+  while (cthread->sndHead != NULL)
+  {
+    count = 0;
+    for (segment = cthread->sndHead; (segment != NULL)
+                                     && (count < EVLOOP_MAX_IOV);
+         segment = segment->next, count++)
+    {
+      iov[count].iov_base = segment->data + segment->offset;
+      iov[count].iov_len  = segment->size - segment->offset;
+    }
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = count;
+
+    sent = sendmsg(cthread->clientFD, &msg, MSG_NOSIGNAL);
+    if (sent < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      // Either the socket is full or the connection is lost.
+      return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+    }
+    evloop_consumeQueue(cthread, (size_t)sent);
+  }
+
+  return true;
+}
+
+/**
+ * Send the data without blocking. The part that cannot be written right away
+ * is queued and written by the reactor once the socket becomes writable.
+ *
+ * @note MODE_EVENT_LOOP
+ *
+ * @param cthread The client connection
+ * @param data The data to send
+ * @param size The size of the data
+ * @param release Releases shared data once it is sent, NULL to copy the data.
+ * @param owner The owner of shared data.
+ *
+ * @return false if the connection is lost or the queue limit is exceeded.
+ */
+static bool evloop_sendResult(ClientThread* cthread, void* data, size_t size,
+                              void (*release)(void*), void* owner)
+{
+  SendSegment* segment;
+  ssize_t      sent    = 0;
+  bool         retVal  = false;
+
+  lockMutex(&cthread->writeMutex);
+  if (!cthread->active || cthread->closeRequested)
+  {
+    RAISE_ERROR("Trying to send a packet over an inactive connection");
+  }
+  else
+  {
+    // Write right away unless older data is still waiting.
+    while ((cthread->sndHead == NULL) && (size > 0))
+    {
+      sent = send(cthread->clientFD, data, size, MSG_NOSIGNAL);
+      if ((sent >= 0) || (errno != EINTR))
+      {
         break;
-      case EINVAL:
+      }
+    }
+    if (sent < 0)
+    {
+      sent = (errno == EAGAIN) || (errno == EWOULDBLOCK) ? 0 : -1;
+    }
+
+    if (sent < 0)
+    {
+      LOG(LEVEL_DEBUG, HDR "Connection to client lost (errno %d)",
+                       pthread_self(), errno);
+    }
+    else if ((size_t)sent == size)
+    {
+      retVal = true;
+    }
+    else if (cthread->sndQueued + (size - sent)
+             > cthread->svrSock->sndQueueLimit)
+    {
+      // The client does not read, don't let it eat up the memory.
+      RAISE_ERROR("The send queue of a client exceeds %u bytes, the "
+                  "connection is shut down",
+                  (uint32_t)cthread->svrSock->sndQueueLimit);
+      shutdown(cthread->clientFD, SHUT_RDWR);
+    }
+    else
+    {
+      segment = malloc(sizeof(SendSegment) + (release == NULL ? size : 0));
+      if (segment == NULL)
+      {
+        RAISE_SYS_ERROR("Not enough memory to queue a packet");
+        shutdown(cthread->clientFD, SHUT_RDWR);
+      }
+      else
+      {
+        segment->next    = NULL;
+        segment->size    = size;
+        segment->offset  = (size_t)sent;
+        segment->release = release;
+        segment->owner   = owner;
+        segment->data    = (uint8_t*)data;
+        if (release == NULL)
+        {
+          segment->data = (uint8_t*)(segment + 1);
+          memcpy(segment->data, data, size);
+        }
+        if (cthread->sndTail != NULL)
+        {
+          cthread->sndTail->next = segment;
+        }
+        else
+        {
+          cthread->sndHead = segment;
+        }
+        cthread->sndTail    = segment;
+        cthread->sndQueued += size - (size_t)sent;
+        evloop_armWrite(cthread, true);
+        // The queue now references the shared data.
+        release = NULL;
+        retVal  = true;
+      }
+    }
+  }
+  unlockMutex(&cthread->writeMutex);
+
+  if (release != NULL)
+  {
+    release(owner);
+  }
+
+  return retVal;
+}
+
+/**
+ * Write the send queue of the connection once the socket became writable.
+ *
+ * @note MODE_EVENT_LOOP
+ *
+ * @param cthread The client connection
+ *
+ * @return false if the connection is lost.
+ */
+static bool evloop_writeClient(ClientThread* cthread)
+{
+  bool retVal;
+
+  lockMutex(&cthread->writeMutex);
+  retVal = evloop_flushQueue(cthread);
+  if (retVal && (cthread->sndHead == NULL))
+  {
+    evloop_armWrite(cthread, false);
+  }
+  unlockMutex(&cthread->writeMutex);
+
+  return retVal;
+}
+
+/**
+ * Pass all complete PDUs within the receive buffer of the given client to the
+ * callback and keep the remainder of an incomplete PDU at the beginning of the
+ * buffer. The buffer will be enlarged in case the pending PDU does not fit.
+ *
+ * @note MODE_EVENT_LOOP
+ *
+ * @param cthread The client connection
+ *
+ * @return false if an invalid PDU was received or the buffer could not be 
+ *         enlarged.
+ */
+static bool evloop_dispatchPackets(ClientThread* cthread)
+{
+  ServerSocket* svrSock   = cthread->svrSock;
+  uint32_t    basicLength = sizeof(SRXPROXY_BasicHeader);
+  uint8_t*    pdu         = cthread->rcvBuffer;
+  uint32_t    available   = cthread->rcvFill;
+  uint32_t    pduLength;
+  uint8_t*    newBuffer;
+
+  while ((available >= basicLength) && !cthread->closeRequested)
+  {
+    pduLength = ntohl(((SRXPROXY_BasicHeader*)pdu)->length);
+    if (pduLength < basicLength)
+    {
+      RAISE_ERROR("Received PDU is invalid!");
+      return false;
+    }
+    if (available < pduLength)
+    {
+      // Wait for the remainder.
+      break;
+    }
+
+    LOG(LEVEL_DEBUG, HDR "Received data and call dispatcher.", pthread_self());
+    svrSock->modeCallback(svrSock, cthread, pdu, pduLength, svrSock->user);
+    pdu       += pduLength;
+    available -= pduLength;
+  }
+
+  // Move the incomplete PDU to the beginning of the buffer
+  if ((available > 0) && (pdu != cthread->rcvBuffer))
+  {
+    memmove(cthread->rcvBuffer, pdu, available);
+  }
+  cthread->rcvFill = available;
+
+  if (available >= basicLength)
+  {
+    pduLength = ntohl(((SRXPROXY_BasicHeader*)cthread->rcvBuffer)->length);
+    if (pduLength > cthread->rcvSize)
+    {
+      newBuffer = realloc(cthread->rcvBuffer, pduLength);
+      if (newBuffer == NULL)
+      {
+        RAISE_SYS_ERROR("Not enough memory for receiving packets");
+        return false;
+      }
+      cthread->rcvBuffer = newBuffer;
+      cthread->rcvSize   = pduLength;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Read all data currently available on the client socket and dispatch the 
+ * received PDUs.
+ *
+ * @note MODE_EVENT_LOOP
+ *
+ * @param cthread The client connection
+ *
+ * @return false if the connection is lost or has to be closed.
+ */
+static bool evloop_readClient(ClientThread* cthread)
+{
+  int     budget = EVLOOP_READ_BUDGET;
+  ssize_t rbytes;
+
+  while (budget-- > 0)
+  {
+    rbytes = recv(cthread->clientFD, cthread->rcvBuffer + cthread->rcvFill,
+                  cthread->rcvSize - cthread->rcvFill, MSG_NOSIGNAL);
+    if (rbytes == 0)
+    {
+      LOG(LEVEL_DEBUG, HDR "Connection to client closed", pthread_self());
+      return false;
+    }
+    if (rbytes < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+      {
+        // All data read
+        break;
+      }
+      LOG(LEVEL_DEBUG, HDR "Connection to client closed (errno %d)", 
+                       pthread_self(), errno);
+      return false;
+    }
+
+    cthread->rcvFill += (uint32_t)rbytes;
+    if (!evloop_dispatchPackets(cthread) || cthread->closeRequested)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Remove the client connection from its reactor, close the socket and inform
+ * the user about the loss of the connection. In case the connection was closed
+ * using closeClientConnection the user is not informed, the client is removed
+ * from the client list instead.
+ *
+ * @note MODE_EVENT_LOOP
+ * @note The client object might be released during this call.
+ *
+ * @param reactor The reactor of the client
+ * @param cthread The client connection
+ */
+static void evloop_releaseClient(EventReactor* reactor, ClientThread* cthread)
+{
+  ServerSocket* svrSock = cthread->svrSock;
+  int           fd      = cthread->clientFD;
+
+  epoll_ctl(reactor->epollFD, EPOLL_CTL_DEL, fd, NULL);
+
+  // Wait for a possibly ongoing send and prevent further sending
+  lockMutex(&cthread->writeMutex);
+  cthread->active = false;
+  evloop_clearQueue(cthread);
+  unlockMutex(&cthread->writeMutex);
+  releaseMutex(&cthread->writeMutex);
+
+  free(cthread->rcvBuffer);
+  cthread->rcvBuffer = NULL;
+  cthread->rcvSize   = 0;
+  cthread->rcvFill   = 0;
+
+  // Information
+  if (svrSock->verbose)
+  {
+    char buf[MAX_SOCKET_STRING_LEN];
+
+    LOG(LEVEL_INFO, "Client disconnected: %s",
+        socketToStr(fd, true, buf, MAX_SOCKET_STRING_LEN));
+  }
+
+  if (cthread->closeRequested)
+  {
+    deleteFromSList(&svrSock->cthreads, cthread);
+  }
+  else if (svrSock->statusCallback != NULL)
+  {
+    // Let the user know about the client loss
+    svrSock->statusCallback(svrSock, cthread, fd, false, svrSock->user);
+  }
+
+  close(fd);
+}
+
+/**
+ * The reactor thread. Waits for incoming data on all connections assigned to
+ * this reactor and processes them.
+ *
+ * @note MODE_EVENT_LOOP
+ * @note PThread syntax
+ *
+ * @param data The EventReactor instance
+ *
+ * @return Always \c 0
+ */
+static void* evloop_runReactor(void* data)
+{
+  EventReactor*      reactor = (EventReactor*)data;
+  struct epoll_event events[EVLOOP_MAX_EVENTS];
+  ClientThread*      cthread;
+  uint64_t           wakeValue;
+  int                numEvents;
+  int                idx;
+  bool               connected;
+
+  LOG(LEVEL_DEBUG, "([0x%08X]) > Proxy Client Reactor Thread started "
+                   "(ServerSocket::evloop_runReactor)", pthread_self());
+
+  while (reactor->running)
+  {
+    numEvents = epoll_wait(reactor->epollFD, events, EVLOOP_MAX_EVENTS, -1);
+    if (numEvents < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      RAISE_SYS_ERROR("Waiting for client events failed");
+      break;
+    }
+
+    for (idx = 0; idx < numEvents; idx++)
+    {
+      cthread = (ClientThread*)events[idx].data.ptr;
+      if (cthread == NULL)
+      {
+        // Wake up call
+        if (read(reactor->wakeFD, &wakeValue, sizeof(uint64_t)) < 0)
+        {
+          wakeValue = 0;
+        }
+        continue;
+      }
+
+      // Write the pending data first, it might be the reply awaited.
+      connected = true;
+      if ((events[idx].events & EPOLLOUT) != 0)
+      {
+        connected = evloop_writeClient(cthread);
+      }
+      if (connected && ((events[idx].events & ~EPOLLOUT) != 0))
+      {
+        connected = evloop_readClient(cthread);
+      }
+      if (!connected)
+      {
+        evloop_releaseClient(reactor, cthread);
+      }
+    }
+  }
+
+  LOG(LEVEL_DEBUG, "([0x%08X]) < Proxy Client Reactor Thread stopped "
+                   "(ServerSocket::evloop_runReactor)", pthread_self());
+
+  pthread_exit(0);
+}
+
+/**
+ * Stops and joins all running reactor threads and releases their resources.
+ * The client connections are not closed.
+ *
+ * @note MODE_EVENT_LOOP
+ *
+ * @param self The server socket
+ */
+static void evloop_stopReactors(ServerSocket* self)
+{
+  uint64_t wakeValue = 1;
+  bool     joined    = true;
+  int      idx;
+
+  if (self->reactors == NULL)
+  {
+    return;
+  }
+
+  for (idx = 0; idx < self->numReactors; idx++)
+  {
+    EventReactor* reactor = &self->reactors[idx];
+    if (reactor->running)
+    {
+      reactor->running = false;
+      if (write(reactor->wakeFD, &wakeValue, sizeof(uint64_t)) < 0)
+      {
+        RAISE_SYS_ERROR("Failed to wake up a reactor thread");
+      }
+      if (!pthread_equal(pthread_self(), reactor->thread))
+      {
+        pthread_join(reactor->thread, NULL);
+      }
+      else
+      {
+        // Called from within a reactor - the reactor is still in use.
+        joined = false;
+      }
+    }
+    if (reactor->epollFD != -1)
+    {
+      close(reactor->epollFD);
+    }
+    if (reactor->wakeFD != -1)
+    {
+      close(reactor->wakeFD);
+    }
+    reactor->epollFD = -1;
+    reactor->wakeFD  = -1;
+  }
+
+  if (joined)
+  {
+    free(self->reactors);
+    self->reactors = NULL;
+  }
+}
+
+/**
+ * Creates the epoll instances and starts the reactor threads.
+ *
+ * @note MODE_EVENT_LOOP
+ *
+ * @param self The server socket
+ *
+ * @return false if the reactors could not be started.
+ */
+static bool evloop_startReactors(ServerSocket* self)
+{
+  struct epoll_event event;
+  EventReactor*      reactor;
+  int                idx;
+  char               name[THREAD_NAME_LEN + 1];
+
+  self->reactors = calloc(self->numReactors, sizeof(EventReactor));
+  if (self->reactors == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the reactor threads");
+    return false;
+  }
+  self->nextReactor = 0;
+
+  for (idx = 0; idx < self->numReactors; idx++)
+  {
+    reactor = &self->reactors[idx];
+    reactor->svrSock = self;
+    reactor->epollFD = epoll_create1(0);
+    reactor->wakeFD  = eventfd(0, EFD_NONBLOCK);
+    reactor->running = false;
+    if ((reactor->epollFD == -1) || (reactor->wakeFD == -1))
+    {
+      RAISE_SYS_ERROR("Failed to create the event loop of a reactor thread");
+      break;
+    }
+
+    memset(&event, 0, sizeof(struct epoll_event));
+    event.events   = EPOLLIN;
+    event.data.ptr = NULL;
+    if (epoll_ctl(reactor->epollFD, EPOLL_CTL_ADD, reactor->wakeFD, &event) 
+        == -1)
+    {
+      RAISE_SYS_ERROR("Failed to register the wake up call of a reactor");
+      break;
+    }
+
+    reactor->running = true;
+    snprintf(name, sizeof(name), "srx-loop-%d", idx);
+    if (createThread(&reactor->thread, NULL, THREAD_CLASS_NETWORK, name,
+                     evloop_runReactor, reactor) != 0)
+    {
+      reactor->running = false;
+      RAISE_ERROR("Failed to create a reactor thread");
+      break;
+    }
+  }
+
+  if (idx < self->numReactors)
+  {
+    // Initialize the remaining descriptors to allow a proper cleanup.
+    for (idx++; idx < self->numReactors; idx++)
+    {
+      self->reactors[idx].epollFD = -1;
+      self->reactors[idx].wakeFD  = -1;
+    }
+    evloop_stopReactors(self);
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Switch the new client connection into non-blocking mode and hand it over to
+ * the next reactor.
+ *
+ * @note MODE_EVENT_LOOP
+ *
+ * @param self The server socket
+ * @param cthread The new client connection
+ *
+ * @return false if the connection could not be assigned to a reactor.
+ */
+static bool evloop_attachClient(ServerSocket* self, ClientThread* cthread)
+{
+  EventReactor*      reactor;
+  struct epoll_event event;
+  int                flags = fcntl(cthread->clientFD, F_GETFL, 0);
+
+  if ((flags == -1) 
+      || (fcntl(cthread->clientFD, F_SETFL, flags | O_NONBLOCK) == -1))
+  {
+    RAISE_SYS_ERROR("Failed to switch the client socket into non-blocking "
+                    "mode");
+    return false;
+  }
+
+  cthread->rcvBuffer = malloc(EVLOOP_RCV_BUFFER_SIZE);
+  if (cthread->rcvBuffer == NULL)
+  {
+    RAISE_SYS_ERROR("Not enough memory for the receive buffer");
+    return false;
+  }
+  cthread->rcvSize = EVLOOP_RCV_BUFFER_SIZE;
+  cthread->rcvFill = 0;
+
+  if (!initWriteMutex(cthread))
+  {
+    free(cthread->rcvBuffer);
+    cthread->rcvBuffer = NULL;
+    return false;
+  }
+
+  reactor = &self->reactors[self->nextReactor];
+  self->nextReactor = (self->nextReactor + 1) % self->numReactors;
+  cthread->reactor = reactor;
+  cthread->thread  = reactor->thread;
+
+  // From here on the reactor owns the connection.
+  memset(&event, 0, sizeof(struct epoll_event));
+  event.events   = EPOLLIN | EPOLLRDHUP;
+  event.data.ptr = cthread;
+  if (epoll_ctl(reactor->epollFD, EPOLL_CTL_ADD, cthread->clientFD, &event) 
+      == -1)
+  {
+    RAISE_SYS_ERROR("Failed to add the client connection to the reactor");
+    releaseMutex(&cthread->writeMutex);
+    free(cthread->rcvBuffer);
+    cthread->rcvBuffer = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+/*--------
+ * Exports
+ */
+
+/**
+ * Create the server socket where SRx is listening on.
+ * @param self
+ * @param port
+ * @param verbose
+ * @return
+ */
+bool createServerSocket(ServerSocket* self, int port, bool verbose)
+{
+  struct sockaddr_in addr;
+  int yes = 1;
+
+  // Create a TCP socket
+  self->serverFD = socket(AF_INET, SOCK_STREAM, 0);
+  if (self->serverFD < 0)
+  {
+    RAISE_SYS_ERROR("Failed to open a socket");
+    return false;
+  }
+
+  // Bind to a server-address
+  memset(&addr, 0, sizeof (struct sockaddr_in));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = INADDR_ANY; // inet_pton
+  addr.sin_port = htons(port);
+
+  // Inserted to be able to restart after crash without having to wait for the 
+  // socket to be released by the OS.
+  setsockopt(self->serverFD, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof (yes));
+
+  if (bind(self->serverFD, (struct sockaddr*)&addr, 
+           sizeof (struct sockaddr_in)) < 0)
+  {
+    char* errStr = NULL;
+    switch (errno)
+    {
+      case EADDRINUSE:
+        errStr = SOC_ERR_EADDRINUSE;                
+        RAISE_ERROR("%s", errStr);
+        break;
+      case EADDRNOTAVAIL:
+        errStr = SOC_ERR_EADDRNOTAVAIL;
+        RAISE_ERROR("%s", errStr);
+        break;
+      case EAFNOSUPPORT:
+        errStr = SOC_ERR_EAFNOSUPPORT;
+        RAISE_ERROR("%s", errStr);
+        break;
+      case EBADF:
+        errStr = SOC_ERR_EBADF;
+        RAISE_ERROR("%s", errStr);
+        break;
+      case EINVAL:
         errStr = SOC_ERR_EINVAL;
         RAISE_ERROR("%s", errStr);
         break;
@@ -657,9 +1603,239 @@ bool createServerSocket(ServerSocket* self, int port, bool verbose)
   self->stopping = 0;
   self->verbose = verbose;
 
+  // MODE_EVENT_LOOP
+  self->reactors    = NULL;
+  self->numReactors   = 1;
+  self->nextReactor   = 0;
+  self->sndQueueLimit = 0;
+
+  // Shared memory transport
+  self->shmTransport = false;
+  self->shmFD        = -1;
+  self->port         = port;
+  initMutex(&self->acceptMutex);
+
+  return true;
+}
+
+/**
+ * Set the number of epoll reactor threads used in MODE_EVENT_LOOP.
+ *
+ * @param self The server-socket instance
+ * @param numReactors The number of reactor threads (1..MAX_EVENT_LOOP_THREADS)
+ *
+ * @return false if the number is out of range.
+ *
+ * @since 0.4.1.0
+ */
+bool setEventLoopThreads(ServerSocket* self, uint8_t numReactors)
+{
+  if ((numReactors == 0) || (numReactors > MAX_EVENT_LOOP_THREADS))
+  {
+    RAISE_ERROR("The number of reactor threads must be between 1 and %d!",
+                MAX_EVENT_LOOP_THREADS);
+    return false;
+  }
+  self->numReactors = numReactors;
   return true;
 }
 
+/**
+ * Let the sending of packets in MODE_EVENT_LOOP queue the data that cannot be
+ * written right away instead of blocking until it is written. The reactor of
+ * the connection writes the queued data once the socket becomes writable. A
+ * connection whose queue would exceed the limit is shut down. Must be called
+ * prior to runServerLoop.
+ *
+ * @param self The server-socket instance
+ * @param limit The maximum number of bytes queued per connection, 0 restores
+ *              the blocking send.
+ *
+ * @since 0.4.1.0
+ */
+void setEventLoopSendQueue(ServerSocket* self, size_t limit)
+{
+  self->sndQueueLimit = limit;
+}
+
+/**
+ * Enable or disable the shared memory transport for proxies on the same host.
+ * Must be called prior to runServerLoop.
+ *
+ * @param self The server-socket instance
+ * @param enable true to accept the shared memory transport.
+ *
+ * @since 0.4.1.0
+ */
+void setShmTransport(ServerSocket* self, bool enable)
+{
+  self->shmTransport = enable;
+}
+
+/**
+ * Register a new client connection, inform the user, and start serving it.
+ * The connection is closed if it is not accepted.
+ *
+ * @param self The server-socket instance
+ * @param clientFD The socket of the new client.
+ * @param caddr The address of the client.
+ * @param shm true if the socket is the control connection of a shared memory
+ *            transport.
+ *
+ * @since 0.4.1.0
+ */
+static void _acceptClient(ServerSocket* self, int clientFD,
+                          struct sockaddr* caddr, bool shm)
+{
+  static void* (*CL_THREAD_ROUTINES[NUM_CLIENT_MODES])(void*) = {
+                               single_handleClient,
+                               multi_handleClient,
+                               custom_handleClient,
+                               NULL // MODE_EVENT_LOOP uses reactor threads
+  };
+
+  char infoBuffer[MAX_SOCKET_STRING_LEN];
+  ClientThread* cthread;
+  ClientMode clMode = self->mode;
+  pthread_attr_t attr;
+  int ret;
+
+  // Information
+  if (self->verbose)
+  {
+    LOG(LEVEL_DEBUG, HDR "New client connection: %s", pthread_self(),
+        sockAddrToStr(caddr, infoBuffer, MAX_SOCKET_STRING_LEN));
+    LOG(LEVEL_INFO, "New client connection: %s",
+        sockAddrToStr(caddr, infoBuffer, MAX_SOCKET_STRING_LEN));
+  }
+
+  // Both accept loops register their clients in the same list.
+  lockMutex(&self->acceptMutex);
+
+  // Spawn a thread for the new connection
+  cthread = self->stopping == 0
+            ? (ClientThread*)appendToSList(&self->cthreads,
+                                           sizeof (ClientThread))
+            : NULL;
+  if (cthread == NULL)
+  {
+    if (self->stopping == 0)
+    {
+      RAISE_ERROR("Not enough memory for another connection");
+    }
+    if (shm)
+    {
+      closeShmTransport(clientFD);
+    }
+    close(clientFD);
+  }
+  else
+  {
+    bool accepted = true;
+
+    // Let the user know about the new client
+    if (self->statusCallback != NULL)
+    {
+////////////////////////////////////////////////////////////////////////////////
+      //TODO: the mode might not be needed anymore
+      accepted = self->statusCallback(self,
+                                      (   (clMode == MODE_SINGLE_CLIENT)
+                                       || (clMode == MODE_EVENT_LOOP))
+                                      ? cthread : NULL,
+                                      clientFD, true, self->user);
+    }
+
+    // Start the thread
+    if (accepted)
+    {
+      cthread->active          = true;
+      cthread->initialized     = false;
+      cthread->goodByeReceived = false;
+
+      cthread->proxyID  = 0; // will be changed for srx-proxy during handshake
+      cthread->routerID = 0; // Indicates that it is currently not usable,
+                             // must be set during handshake
+      cthread->clientFD = clientFD;
+      cthread->shmFD    = shm ? clientFD : -1;
+      cthread->svrSock  = self;
+      cthread->caddr    = *caddr;
+
+      cthread->reactor        = NULL;
+      cthread->rcvBuffer      = NULL;
+      cthread->rcvSize        = 0;
+      cthread->rcvFill        = 0;
+      cthread->closeRequested = false;
+      cthread->sndHead        = NULL;
+      cthread->sndTail        = NULL;
+      cthread->sndQueued      = 0;
+      cthread->sndArmed       = false;
+
+      if (clMode == MODE_EVENT_LOOP)
+      {
+        accepted = evloop_attachClient(self, cthread);
+      }
+      else
+      {
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        ret = createThread(&(cthread->thread), &attr,
+                           THREAD_CLASS_NETWORK, "srx-client",
+                           CL_THREAD_ROUTINES[clMode], (void*)cthread);
+        pthread_attr_destroy(&attr);
+        if (ret != 0)
+        {
+          accepted = false;
+          RAISE_ERROR("Failed to create a client thread");
+        }
+      }
+    }
+
+    // Error or the callback denied the client
+    if (!accepted)
+    {
+      if (shm)
+      {
+        closeShmTransport(clientFD);
+      }
+      close(clientFD);
+      deleteFromSList(&self->cthreads, cthread);
+    }
+  }
+
+  unlockMutex(&self->acceptMutex);
+}
+
+/**
+ * Thread that accepts the shared memory transports offered by proxies on the
+ * same host. Ends once stopServerLoop shuts the listening socket down.
+ *
+ * @note PThread syntax
+ *
+ * @param data The server-socket instance
+ *
+ * @since 0.4.1.0
+ */
+static void* _acceptShmClients(void* data)
+{
+  ServerSocket* self = (ServerSocket*)data;
+  struct sockaddr caddr;
+  int clientFD;
+
+  memset(&caddr, 0, sizeof(struct sockaddr));
+  caddr.sa_family = AF_UNIX;
+
+  while ((clientFD = acceptShmTransport(self->shmFD)) != -1)
+  {
+    LOG(LEVEL_DEBUG, HDR "Proxy client connected using the shared memory "
+                     "transport", pthread_self());
+    _acceptClient(self, clientFD, &caddr, true);
+  }
+
+  LOG(LEVEL_DEBUG, HDR "Stopped accepting shared memory transports",
+                   pthread_self());
+  return NULL;
+}
+
 /**
  * This is the server loop for the SRx - Proxy server connection.
  * 
@@ -673,18 +1849,10 @@ void runServerLoop(ServerSocket* self, ClientMode clMode,
                    void (*modeCallback)(), ClientStatusChanged statusCallback,
                    void* user)
 {
-  static void* (*CL_THREAD_ROUTINES[NUM_CLIENT_MODES])(void*) = {
-                               single_handleClient,
-                               multi_handleClient,
-                               custom_handleClient
-  };
-
   int cliendFD;
   struct sockaddr caddr;
   socklen_t caddrSize;
-  char infoBuffer[MAX_SOCKET_STRING_LEN];
-  ClientThread* cthread;
-  int ret;
+  pthread_t shmThread;
 
   pthread_attr_t attr;
   pthread_attr_init(&attr);
@@ -699,6 +1867,38 @@ void runServerLoop(ServerSocket* self, ClientMode clMode,
   // No active threads
   initSList(&self->cthreads);
 
+  // Start the reactor threads
+  if (clMode == MODE_EVENT_LOOP)
+  {
+    if (!evloop_startReactors(self))
+    {
+      RAISE_ERROR("Failed to start the event loop");
+      return;
+    }
+    LOG(LEVEL_DEBUG, HDR "Serve client connections using %u reactor "
+                     "thread(s)", pthread_self(), self->numReactors);
+  }
+
+  // Co-located proxies can connect through shared memory, the reactors of
+  // MODE_EVENT_LOOP only serve TCP sockets.
+  if (self->shmTransport && (clMode == MODE_SINGLE_CLIENT))
+  {
+    self->shmFD = createShmTransportListener(self->port);
+    if (   (self->shmFD != -1)
+        && (createThread(&shmThread, &attr, THREAD_CLASS_NETWORK, "srx-shm",
+                         _acceptShmClients, self) != 0))
+    {
+      RAISE_ERROR("Failed to start the shared memory transport");
+      close(self->shmFD);
+      self->shmFD = -1;
+    }
+  }
+  else if (self->shmTransport)
+  {
+    LOG(LEVEL_WARNING, "The shared memory transport is not available in this "
+                       "client mode, proxies use TCP");
+  }
+
   // Prepare socket to accept connections
   listen(self->serverFD, MAX_PENDING_CONNECTIONS);
   
@@ -724,70 +1924,10 @@ void runServerLoop(ServerSocket* self, ClientMode clMode,
       break;
     }
 
-    // Information
-    if (self->verbose)
-    {
-      LOG(LEVEL_DEBUG, HDR "New client connection: %s", pthread_self(),
-          sockAddrToStr(&caddr, infoBuffer, MAX_SOCKET_STRING_LEN));
-      LOG(LEVEL_INFO, "New client connection: %s",
-          sockAddrToStr(&caddr, infoBuffer, MAX_SOCKET_STRING_LEN));
-    }
-
-    // Spawn a thread for the new connection
-    cthread = (ClientThread*)appendToSList(&self->cthreads,
-                                           sizeof (ClientThread));
-    if (cthread == NULL)
-    {
-      RAISE_ERROR("Not enough memory for another connection");
-      close(cliendFD);
-    }
-    else
-    {
-      bool accepted = true;
-      
-      // Let the user know about the new client
-      if (self->statusCallback != NULL)
-      {
-////////////////////////////////////////////////////////////////////////////////
-        //TODO: the mode might not be needed anymore
-        accepted = self->statusCallback(self,
-                                        (clMode == MODE_SINGLE_CLIENT) ? cthread
-                                                                       : NULL,
-                                        cliendFD, true, self->user);
-      }
-
-      // Start the thread
-      if (accepted)
-      {
-        cthread->active          = true;
-        cthread->initialized     = false;
-        cthread->goodByeReceived = false;
-        
-        cthread->proxyID  = 0; // will be changed for srx-proxy during handshake
-        cthread->routerID = 0; // Indicates that it is currently not usable, 
-                               // must be set during handshake
-        cthread->clientFD = cliendFD;
-        cthread->svrSock  = self;
-        cthread->caddr	  = caddr;
-
-        ret = pthread_create(&(cthread->thread), &attr,
-                             CL_THREAD_ROUTINES[clMode],
-                             (void*)cthread);
-        if (ret != 0)
-        {
-          accepted = false;
-          RAISE_ERROR("Failed to create a client thread");
-        }
-      }
-
-      // Error or the callback denied the client
-      if (!accepted)
-      {
-        close(cliendFD);
-        deleteFromSList(&self->cthreads, cthread);
-      }
-    }
+    _acceptClient(self, cliendFD, &caddr, false);
   }
+
+  pthread_attr_destroy(&attr);
 }
 
 /**
@@ -803,11 +1943,28 @@ static void _killClientThread(void* clt)
   if (clientThread->active)
   {
     // Close the client connection
-    close(clientThread->clientFD);
+    if (clientThread->shmFD != -1)
+    {
+      closeShmClient(clientThread);
+    }
+    else
+    {
+      close(clientThread->clientFD);
+    }
 
-    // Wait until the thread terminated - if necessary
-    //pthread_join(clientThread->thread, NULL);
-    pthread_cancel(clientThread->thread);
+    if (clientThread->svrSock->mode == MODE_EVENT_LOOP)
+    {
+      // The reactor threads are stopped already, don't cancel them.
+      evloop_clearQueue(clientThread);
+      free(clientThread->rcvBuffer);
+      clientThread->rcvBuffer = NULL;
+    }
+    else
+    {
+      // Wait until the thread terminated - if necessary
+      //pthread_join(clientThread->thread, NULL);
+      pthread_cancel(clientThread->thread);
+    }
 
     // Release the write-mutex
     releaseMutex(&clientThread->writeMutex);
@@ -828,10 +1985,24 @@ void stopServerLoop(ServerSocket* self)
   {
     // Stop accepting connections 
     close(self->serverFD);
+    if (self->shmFD != -1)
+    {
+      // The shutdown ends the wait of the accepting thread.
+      shutdown(self->shmFD, SHUT_RDWR);
+      close(self->shmFD);
+    }
+
+    // Stop the reactors prior to closing their connections
+    if (self->mode == MODE_EVENT_LOOP)
+    {
+      evloop_stopReactors(self);
+    }
 
     // Kill all threads
+    lockMutex(&self->acceptMutex);
     foreachInSList(&self->cthreads, _killClientThread);
     releaseSList(&self->cthreads);
+    unlockMutex(&self->acceptMutex);
   }
 }
 
@@ -846,7 +2017,11 @@ bool sendPacketToClient(ServerSocket* self, ServerClient* client,
     return false;
   }
 
-  if (self->mode == MODE_SINGLE_CLIENT)
+  if ((self->mode == MODE_EVENT_LOOP) && (self->sndQueueLimit > 0))
+  {
+    return evloop_sendResult((ClientThread*)client, data, size, NULL, NULL);
+  }
+  if ((self->mode == MODE_SINGLE_CLIENT) || (self->mode == MODE_EVENT_LOOP))
   {
     return single_sendResult(client, data, size);
   }
@@ -858,6 +2033,46 @@ bool sendPacketToClient(ServerSocket* self, ServerClient* client,
   return false;
 }
 
+/**
+ * Sends a buffer that is shared with other clients. With the send queue of
+ * MODE_EVENT_LOOP enabled the buffer is queued without copying it, otherwise
+ * it is sent like sendPacketToClient does. The release function is called
+ * once the buffer is not referenced anymore, this includes a failure.
+ *
+ * @param self Server-socket instance
+ * @param client Client
+ * @param data Data (w/o length) that should be send
+ * @param size Size in Bytes of \c data
+ * @param release Called with \c owner once the data is not needed anymore,
+ *                may be \c NULL.
+ * @param owner The owner of the data.
+ *
+ * @return \c true = sent or queued, \c false = an error occurred
+ *
+ * @since 0.4.1.0
+ */
+bool sendSharedToClient(ServerSocket* self, ServerClient* client,
+                        void* data, size_t size, void (*release)(void*),
+                        void* owner)
+{
+  bool retVal;
+
+  if ((self != NULL) && (self->mode == MODE_EVENT_LOOP)
+      && (self->sndQueueLimit > 0) && (release != NULL))
+  {
+    return evloop_sendResult((ClientThread*)client, data, size, release,
+                             owner);
+  }
+
+  retVal = sendPacketToClient(self, client, data, size);
+  if (release != NULL)
+  {
+    release(owner);
+  }
+
+  return retVal;
+}
+
 /**
  * Closes the connection associated with the given client.
  * 
@@ -874,6 +2089,20 @@ int closeClientConnection(ServerSocket* self, ServerClient* client)
                        "[FD: 0x%08X]", pthread_self() , clientThread->thread,
                        clientThread->proxyID, clientThread->clientFD);
   
+  if ((self->mode == MODE_EVENT_LOOP) && (self->stopping == 0))
+  {
+    // The connection is owned by its reactor which might be processing it
+    // right now. The shutdown wakes up the reactor which then releases the
+    // client.
+    clientThread->closeRequested = true;
+    shutdown(clientThread->clientFD, SHUT_RDWR);
+    LOG(LEVEL_DEBUG, HDR "Client connection [ID:%u] shut down!", 
+                     pthread_self(), clientThread->proxyID);
+    LOG(LEVEL_INFO, "Client connection [ID:%u] closed!", 
+                    clientThread->proxyID);
+    return true;
+  }
+
   //deleteMapping(self, clientThread);
   _killClientThread(clientThread);
   LOG(LEVEL_DEBUG, HDR "Client connection [ID:%u] closed!", pthread_self(),
@@ -27,7 +27,14 @@
  *
  * Changelog:
  * -----------------------------------------------------------------------------
- *  0.4.1.0 - 2016/08/19 - oborchert
+ *  0.4.1.0 - 2026/10/14 - kyehwanl
+ *            * Added MODE_EVENT_LOOP which serves all client connections from
+ *              a small number of epoll reactor threads.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added the shared memory transport, see setShmTransport.
+ *            * Added the send queues of MODE_EVENT_LOOP, see
+ *              setEventLoopSendQueue and sendSharedToClient.
+ *          - 2016/08/19 - oborchert
  *            * Moved socket connection error strings to this header file.
  *  0.3.0.0 - 2013/01/04 - oborchert
  *            * Added parameter goodByeReceived to ClientThread structure.
@@ -69,6 +76,12 @@
  *   <td>ClientConnectionAccepted</td>
  *   <td>no</td>
  * </tr>
+ * <tr>
+ *   <td>MODE_EVENT_LOOP</td>
+ *   <td>1 client, 1 connection, N connections per reactor thread</td>
+ *   <td>ServerPacketReceived</td>
+ *   <td>yes</td>
+ * </tr>
  * </table>
  *
  */
@@ -81,6 +94,8 @@
 
 /** Maximum number of clients waiting to be accepted for connection. */
 #define MAX_PENDING_CONNECTIONS 5
+/** Maximum number of reactor threads in MODE_EVENT_LOOP. */
+#define MAX_EVENT_LOOP_THREADS  16
 
 ////////////////////////////////////////////////////////////////////////////////
 // ERROR STRINGS - Moved from code to here with version 0.4.1.0
@@ -130,6 +145,8 @@ typedef enum
   MODE_SINGLE_CLIENT = 0, // 1 client  : 1 connection, ServerPacketReceived
   MODE_MULTIPLE_CLIENTS, // N clients : 1 connection, ServerPacketReceived
   MODE_CUSTOM_CALLBACK, // Custom, ClientConnectionAccepted
+  MODE_EVENT_LOOP,      // 1 client  : 1 connection, ServerPacketReceived,
+                        // non-blocking sockets served by epoll reactors
 
   NUM_CLIENT_MODES ///< Number of different modes (needs to be the last item)
 } ClientMode;
@@ -143,6 +160,10 @@ typedef void ServerClient;
 
 /* Forward declaration */
 struct _ServerSocket;
+/* Forward declaration of the epoll reactor used in MODE_EVENT_LOOP. */
+struct _EventReactor;
+/* Forward declaration of a buffer queued for sending in MODE_EVENT_LOOP. */
+struct _SendSegment;
 
 /**
  * A server-socket.
@@ -167,7 +188,7 @@ typedef struct _ServerSocket ServerSocket;
  * }
  * @endcode
  *
- * ClientMode: MODE_SINGLE_CLIENT, MODE_MULTIPLE_CLIENTS
+ * ClientMode: MODE_SINGLE_CLIENT, MODE_MULTIPLE_CLIENTS, MODE_EVENT_LOOP
  *
  * @param svrSock Server-socket instance
  * @param client Client that sent the packet
@@ -198,7 +219,8 @@ typedef void (*ClientConnectionAccepted)(ServerSocket* svrSock, int sock,
  * false as return-value denies the client, true accepts the client.
  *
  * @param svrSock Server-socket instance
- * @param client Client in MODE_SINGLE_CLIENT, otherwise \c NULL
+ * @param client Client in MODE_SINGLE_CLIENT and MODE_EVENT_LOOP, otherwise 
+ *               \c NULL
  * @param fd New/lost file descriptor (= socket)
  * @param connected true = new client, false = client lost
  * @param user User-defined data, for srx-server the server connection handler
@@ -222,6 +244,28 @@ struct _ServerSocket
   int stopping;
   SList cthreads;
   bool verbose;
+
+  // MODE_EVENT_LOOP only
+  /** The reactor threads. */
+  struct _EventReactor* reactors;
+  /** The number of reactor threads to start (default 1). */
+  uint8_t numReactors;
+  /** The reactor the next accepted connection will be assigned to. */
+  uint8_t nextReactor;
+  /** The maximum number of bytes queued per connection, 0 if sending blocks
+   * until the data is written. */
+  size_t sndQueueLimit;
+
+  // Shared memory transport, MODE_SINGLE_CLIENT only
+  /** Accept the shared memory transport of proxies on the same host. */
+  bool shmTransport;
+  /** The listening unix socket of the shared memory transport or -1. */
+  int shmFD;
+  /** The TCP port, it also names the unix socket. */
+  int port;
+  /** Serializes the registration of clients accepted via TCP and via the
+   * shared memory transport. */
+  Mutex acceptMutex;
 } ;
 
 /**
@@ -239,6 +283,9 @@ typedef struct
   bool initialized;
   /** The file descriptor of the client socket. */
   int clientFD;
+  /** The control connection if the client uses the shared memory transport,
+   * otherwise -1. Unlike clientFD it is kept after the connection failed. */
+  int shmFD;
   /** Used as proxyID for SRx-Proxy connections to allow assigning updates to 
    *  the client. */
   uint32_t proxyID;
@@ -261,6 +308,27 @@ typedef struct
   ServerSocket* svrSock;
   /* The socket address. */
   struct sockaddr caddr;  
+
+  // MODE_EVENT_LOOP only
+  /** The reactor this connection is attached to. */
+  struct _EventReactor* reactor;
+  /** Receive buffer that collects partially received PDUs. */
+  uint8_t* rcvBuffer;
+  /** The size of the receive buffer. */
+  uint32_t rcvSize;
+  /** The number of bytes currently stored in the receive buffer. */
+  uint32_t rcvFill;
+  /** Set by closeClientConnection, the reactor releases the connection
+   * without calling the status callback. */
+  bool closeRequested;
+  /** The first buffer waiting to be sent, see setEventLoopSendQueue. */
+  struct _SendSegment* sndHead;
+  /** The last buffer waiting to be sent. */
+  struct _SendSegment* sndTail;
+  /** The number of bytes waiting to be sent. */
+  size_t sndQueued;
+  /** Indicates if the reactor waits for the socket to become writable. */
+  bool sndArmed;
 } ClientThread;
 
 /**
@@ -273,6 +341,47 @@ typedef struct
  */
 bool createServerSocket(ServerSocket* self, int port, bool verbose);
 
+/**
+ * Set the number of epoll reactor threads used in MODE_EVENT_LOOP. Must be 
+ * called prior to runServerLoop. Connections are assigned to the reactors in 
+ * a round robin manner.
+ *
+ * @param self The server-socket instance
+ * @param numReactors The number of reactor threads (1..MAX_EVENT_LOOP_THREADS)
+ *
+ * @return \c false if the number is out of range.
+ *
+ * @since 0.4.1.0
+ */
+bool setEventLoopThreads(ServerSocket* self, uint8_t numReactors);
+
+/**
+ * Let the sending of packets in MODE_EVENT_LOOP queue the data that cannot be
+ * written right away instead of blocking until it is written. The reactor of
+ * the connection writes the queued data once the socket becomes writable. A
+ * connection whose queue would exceed the limit is shut down. Must be called
+ * prior to runServerLoop.
+ *
+ * @param self The server-socket instance
+ * @param limit The maximum number of bytes queued per connection, 0 restores
+ *              the blocking send.
+ *
+ * @since 0.4.1.0
+ */
+void setEventLoopSendQueue(ServerSocket* self, size_t limit);
+
+/**
+ * Enable or disable the shared memory transport for proxies on the same host.
+ * Must be called prior to runServerLoop. The transport is only provided in
+ * MODE_SINGLE_CLIENT, all other modes serve TCP only.
+ *
+ * @param self The server-socket instance
+ * @param enable true to accept the shared memory transport.
+ *
+ * @since 0.4.1.0
+ */
+void setShmTransport(ServerSocket* self, bool enable);
+
 /**
  * Starts the runloop which processes all client connections, and depending 
  * on the mode even the receipt of the packets.
@@ -306,6 +415,7 @@ void stopServerLoop(ServerSocket* self);
  *
  * @note For MODE_MULTIPLE_CLIENTS this function must be called from
  *       within ServerPacketReceived.
+ * @note For MODE_EVENT_LOOP this function can be called from any thread.
  *
  * @param self Server-socket instance
  * @param client Client
@@ -316,9 +426,34 @@ void stopServerLoop(ServerSocket* self);
 bool sendPacketToClient(ServerSocket* self, ServerClient* client,
                         void* data, size_t size);
 
+/**
+ * Sends a buffer that is shared with other clients. With the send queue of
+ * MODE_EVENT_LOOP enabled the buffer is queued without copying it, otherwise
+ * it is sent like sendPacketToClient does. The release function is called
+ * once the buffer is not referenced anymore, this includes a failure.
+ *
+ * @param self Server-socket instance
+ * @param client Client
+ * @param data Data (w/o length) that should be send
+ * @param size Size in Bytes of \c data
+ * @param release Called with \c owner once the data is not needed anymore,
+ *                may be \c NULL.
+ * @param owner The owner of the data.
+ *
+ * @return \c true = sent or queued, \c false = an error occurred
+ *
+ * @since 0.4.1.0
+ */
+bool sendSharedToClient(ServerSocket* self, ServerClient* client,
+                        void* data, size_t size, void (*release)(void*),
+                        void* owner);
+
 /**
  * Closes the connection associated with the given client.
  * 
+ * @note In MODE_EVENT_LOOP the connection is shut down immediately but the 
+ *       client object is released by its reactor thread.
+ *
  * @param self The server socket whose client has to be handled,
  * @param client The client connection object to be closed.
  * 
@@ -0,0 +1,947 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+// Required for memfd_create.
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "util/log.h"
+#include "util/shm_transport.h"
+
+#define HDR "([0x%08X] Shm Transport): "
+
+/** Identifies the shared memory region. */
+#define SHM_TRANSPORT_MAGIC   0x53525852
+/** The version of the region layout and the offer. */
+#define SHM_TRANSPORT_VERSION 1
+/** The number of descriptors handed over: the region and four eventfds. */
+#define SHM_TRANSPORT_NUM_FDS 5
+/** The time in seconds the offer and its answer may take. */
+#define SHM_TRANSPORT_TIMEOUT 2
+/** The maximum number of pending offers. */
+#define SHM_TRANSPORT_BACKLOG 5
+
+/** The ring from the proxy to the server. */
+#define RING_TO_SERVER 0
+/** The ring from the server to the proxy. */
+#define RING_TO_PROXY  1
+
+/**
+ * A single producer single consumer byte ring. The positions are running
+ * counters, the number of stored bytes is head - tail. Each position is
+ * written by one side only and has its own cache line.
+ */
+typedef struct {
+  /** The number of bytes written, only changed by the producer. */
+  volatile uint32_t head;
+  uint8_t           padHead[60];
+  /** The number of bytes read, only changed by the consumer. */
+  volatile uint32_t tail;
+  uint8_t           padTail[60];
+  /** Set by the consumer before it sleeps on an empty ring. */
+  volatile uint32_t readerWaiting;
+  /** Set by the producer before it sleeps on a full ring. */
+  volatile uint32_t writerWaiting;
+  uint8_t           padWait[56];
+} ShmRing;
+
+/** The shared memory region, the data of both rings follows. */
+typedef struct {
+  /** SHM_TRANSPORT_MAGIC */
+  uint32_t          magic;
+  /** SHM_TRANSPORT_VERSION */
+  uint32_t          version;
+  /** The size of each ring. */
+  uint32_t          ringSize;
+  /** Set by the side that closes the transport. */
+  volatile uint32_t closed;
+  uint8_t           padHeader[48];
+  /** RING_TO_SERVER and RING_TO_PROXY */
+  ShmRing           rings[2];
+} ShmRegion;
+
+/** The offer sent by the proxy together with the descriptors. */
+typedef struct {
+  /** SHM_TRANSPORT_MAGIC */
+  uint32_t magic;
+  /** SHM_TRANSPORT_VERSION */
+  uint32_t version;
+  /** The size of each ring. */
+  uint32_t ringSize;
+} ShmOffer;
+
+/** The transport as seen by one side. */
+struct _ShmTransport {
+  /** The control connection. */
+  int               fd;
+  /** The mapped region. */
+  ShmRegion*        region;
+  /** The size of the mapping. */
+  size_t            size;
+  /** The ring this side reads from. */
+  ShmRing*          rx;
+  /** The data of the receive ring. */
+  uint8_t*          rxData;
+  /** Signaled by the peer if the receive ring got data. */
+  int               rxDataEvent;
+  /** Signaled for the peer if the receive ring got space. */
+  int               rxSpaceEvent;
+  /** The ring this side writes into. */
+  ShmRing*          tx;
+  /** The data of the send ring. */
+  uint8_t*          txData;
+  /** Signaled for the peer if the send ring got data. */
+  int               txDataEvent;
+  /** Signaled by the peer if the send ring got space. */
+  int               txSpaceEvent;
+  /** Readable if rxDataEvent or the control connection is. */
+  int               pollFD;
+  /** The size of each ring. */
+  uint32_t          ringSize;
+  /** The registration and each acquire hold a reference. */
+  volatile uint32_t refCount;
+  /** Set once the transport is unregistered. */
+  volatile bool     closed;
+};
+
+/** The transports by the descriptor of their control connection. */
+static ShmTransport* volatile _transports[SHM_TRANSPORT_MAX_FD];
+/** Guards the registration and the references. */
+static pthread_mutex_t        _registryMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Return the size of the region with two rings of the given size.
+ *
+ * @param ringSize The size of each ring.
+ *
+ * @return The size of the region.
+ */
+static inline size_t _getRegionSize(uint32_t ringSize)
+{
+  return sizeof(ShmRegion) + 2 * (size_t)ringSize;
+}
+
+/**
+ * Wake up the side waiting on the given eventfd.
+ *
+ * @param event The eventfd.
+ */
+static inline void _signal(int event)
+{
+  uint64_t one = 1;
+
+  if (write(event, &one, sizeof(uint64_t)) != sizeof(uint64_t)
+      && (errno != EAGAIN))
+  {
+    LOG(LEVEL_DEBUG, HDR "Failed to signal eventfd %d", pthread_self(),
+                     event);
+  }
+}
+
+/**
+ * Reset the given non blocking eventfd.
+ *
+ * @param event The eventfd.
+ */
+static inline void _drain(int event)
+{
+  uint64_t count;
+
+  (void)(read(event, &count, sizeof(uint64_t)) == sizeof(uint64_t));
+}
+
+/**
+ * Build the name of the abstract unix socket of the server.
+ *
+ * @param port The TCP port of the server.
+ * @param addr OUT - The address.
+ *
+ * @return The length of the address.
+ */
+static socklen_t _getAddress(int port, struct sockaddr_un* addr)
+{
+  int len;
+
+  memset(addr, 0, sizeof(struct sockaddr_un));
+  addr->sun_family = AF_UNIX;
+  // The leading 0 of sun_path selects the abstract namespace.
+  len = snprintf(addr->sun_path + 1, sizeof(addr->sun_path) - 1,
+                 SHM_TRANSPORT_NAME, port);
+
+  return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + len);
+}
+
+/**
+ * Limit the time a blocking send or receive on the given socket may take.
+ *
+ * @param fd The socket.
+ */
+static void _setTimeout(int fd)
+{
+  struct timeval timeout;
+
+  timeout.tv_sec  = SHM_TRANSPORT_TIMEOUT;
+  timeout.tv_usec = 0;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+/**
+ * Free the transport and close its eventfds. The control connection is not
+ * closed.
+ *
+ * @param self The transport, can be NULL.
+ */
+static void _freeTransport(ShmTransport* self)
+{
+  if (self == NULL)
+  {
+    return;
+  }
+  if (self->region != NULL)
+  {
+    munmap(self->region, self->size);
+  }
+  if (self->rxDataEvent != -1)
+  {
+    close(self->rxDataEvent);
+  }
+  if (self->rxSpaceEvent != -1)
+  {
+    close(self->rxSpaceEvent);
+  }
+  if (self->txDataEvent != -1)
+  {
+    close(self->txDataEvent);
+  }
+  if (self->txSpaceEvent != -1)
+  {
+    close(self->txSpaceEvent);
+  }
+  if (self->pollFD != -1)
+  {
+    close(self->pollFD);
+  }
+  free(self);
+}
+
+/**
+ * Create the transport of one side for the given region and eventfds. The
+ * transport takes over the eventfds and the mapping, also if it fails.
+ *
+ * @param fd The control connection.
+ * @param region The mapped region.
+ * @param events The data and space eventfds of the ring to the server and
+ *               the ring to the proxy.
+ * @param server true for the server side.
+ *
+ * @return The transport or NULL if it could not be created.
+ */
+static ShmTransport* _createTransport(int fd, ShmRegion* region, int* events,
+                                      bool server)
+{
+  ShmTransport*      self = malloc(sizeof(ShmTransport));
+  struct epoll_event event;
+  int                rxRing = server ? RING_TO_SERVER : RING_TO_PROXY;
+  int                txRing = server ? RING_TO_PROXY  : RING_TO_SERVER;
+  int                idx;
+
+  if (self == NULL)
+  {
+    munmap(region, _getRegionSize(region->ringSize));
+    for (idx = 0; idx < 4; idx++)
+    {
+      close(events[idx]);
+    }
+    return NULL;
+  }
+  self->fd           = fd;
+  self->region       = region;
+  self->ringSize     = region->ringSize;
+  self->size         = _getRegionSize(self->ringSize);
+  self->rx           = &region->rings[rxRing];
+  self->rxData       = (uint8_t*)(region + 1) + rxRing * self->ringSize;
+  self->rxDataEvent  = events[rxRing * 2];
+  self->rxSpaceEvent = events[rxRing * 2 + 1];
+  self->tx           = &region->rings[txRing];
+  self->txData       = (uint8_t*)(region + 1) + txRing * self->ringSize;
+  self->txDataEvent  = events[txRing * 2];
+  self->txSpaceEvent = events[txRing * 2 + 1];
+  self->refCount     = 1;
+  self->closed       = false;
+
+  self->pollFD = epoll_create1(EPOLL_CLOEXEC);
+  if (self->pollFD == -1)
+  {
+    _freeTransport(self);
+    return NULL;
+  }
+  memset(&event, 0, sizeof(struct epoll_event));
+  event.events = EPOLLIN;
+  if (   (epoll_ctl(self->pollFD, EPOLL_CTL_ADD, self->rxDataEvent, &event)
+          != 0)
+      || (epoll_ctl(self->pollFD, EPOLL_CTL_ADD, fd, &event) != 0))
+  {
+    _freeTransport(self);
+    return NULL;
+  }
+
+  return self;
+}
+
+/**
+ * Register the transport for its control connection.
+ *
+ * @param self The transport.
+ *
+ * @return false if the descriptor is out of range or already registered.
+ */
+static bool _registerTransport(ShmTransport* self)
+{
+  bool retVal = false;
+
+  pthread_mutex_lock(&_registryMutex);
+  if (   (self->fd >= 0) && (self->fd < SHM_TRANSPORT_MAX_FD)
+      && (_transports[self->fd] == NULL))
+  {
+    _transports[self->fd] = self;
+    retVal = true;
+  }
+  pthread_mutex_unlock(&_registryMutex);
+
+  return retVal;
+}
+
+/**
+ * Create the listening unix socket of the server.
+ *
+ * @param port The TCP port of the server.
+ *
+ * @return The listening socket or -1 if it could not be created.
+ */
+int createShmTransportListener(int port)
+{
+  struct sockaddr_un addr;
+  socklen_t          len = _getAddress(port, &addr);
+  int                fd  = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+  if (fd == -1)
+  {
+    RAISE_SYS_ERROR("Failed to create the shared memory transport socket");
+    return -1;
+  }
+  if (   (bind(fd, (struct sockaddr*)&addr, len) != 0)
+      || (listen(fd, SHM_TRANSPORT_BACKLOG) != 0))
+  {
+    RAISE_SYS_ERROR("Failed to listen for shared memory transports on '@"
+                    SHM_TRANSPORT_NAME "'", port);
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+/**
+ * Receive and verify the offer of a proxy, map its region and create the
+ * server side of the transport.
+ *
+ * @param fd The control connection.
+ *
+ * @return The transport or NULL if the offer is invalid.
+ */
+static ShmTransport* _receiveOffer(int fd)
+{
+  ShmOffer         offer;
+  struct iovec     iov = { &offer, sizeof(ShmOffer) };
+  struct msghdr    msg;
+  struct cmsghdr*  cmsg;
+  struct stat      regionStat;
+  union {
+    struct cmsghdr hdr;
+    char           buf[CMSG_SPACE(SHM_TRANSPORT_NUM_FDS * sizeof(int))];
+  } control;
+  int              fds[SHM_TRANSPORT_NUM_FDS];
+  int              numFDs = 0;
+  ShmRegion*       region = MAP_FAILED;
+  size_t           size   = 0;
+  ssize_t          len;
+  int              idx;
+
+  memset(&msg, 0, sizeof(struct msghdr));
+  msg.msg_iov        = &iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+  len = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+
+  cmsg = len > 0 ? CMSG_FIRSTHDR(&msg) : NULL;
+  if (   (cmsg != NULL) && (cmsg->cmsg_level == SOL_SOCKET)
+      && (cmsg->cmsg_type == SCM_RIGHTS))
+  {
+    numFDs = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    numFDs = numFDs > SHM_TRANSPORT_NUM_FDS ? SHM_TRANSPORT_NUM_FDS : numFDs;
+    memcpy(fds, CMSG_DATA(cmsg), numFDs * sizeof(int));
+  }
+
+  if (   (len == sizeof(ShmOffer)) && (numFDs == SHM_TRANSPORT_NUM_FDS)
+      && (offer.magic == SHM_TRANSPORT_MAGIC)
+      && (offer.version == SHM_TRANSPORT_VERSION)
+      && (offer.ringSize >= 4096) && (offer.ringSize <= (1U << 30))
+      && ((offer.ringSize & (offer.ringSize - 1)) == 0)
+      && (fstat(fds[0], &regionStat) == 0))
+  {
+    size = _getRegionSize(offer.ringSize);
+    if (regionStat.st_size >= (off_t)size)
+    {
+      region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0],
+                    0);
+    }
+  }
+  if (numFDs > 0)
+  {
+    close(fds[0]);
+  }
+
+  if (   (region != MAP_FAILED) && (region->magic == SHM_TRANSPORT_MAGIC)
+      && (region->ringSize == offer.ringSize))
+  {
+    return _createTransport(fd, region, &fds[1], true);
+  }
+
+  LOG(LEVEL_WARNING, "Declined an invalid shared memory transport offer");
+  if (region != MAP_FAILED)
+  {
+    munmap(region, size);
+  }
+  for (idx = 1; idx < numFDs; idx++)
+  {
+    close(fds[idx]);
+  }
+  return NULL;
+}
+
+/**
+ * Wait for the next proxy that offers a shared memory transport. Invalid
+ * offers are declined and the next one is awaited.
+ *
+ * @param listenFD The listening socket.
+ *
+ * @return The control connection with a registered transport or -1 if the
+ *         listening socket failed.
+ */
+int acceptShmTransport(int listenFD)
+{
+  ShmTransport* transport;
+  uint32_t      answer;
+  int           fd;
+
+  for (;;)
+  {
+    fd = accept4(listenFD, NULL, NULL, SOCK_CLOEXEC);
+    if (fd == -1)
+    {
+      if ((errno == EINTR) || (errno == ECONNABORTED))
+      {
+        continue;
+      }
+      return -1;
+    }
+
+    _setTimeout(fd);
+    transport = _receiveOffer(fd);
+    if ((transport != NULL) && !_registerTransport(transport))
+    {
+      LOG(LEVEL_WARNING, "Declined a shared memory transport, descriptor %d "
+                         "out of range", fd);
+      _freeTransport(transport);
+      transport = NULL;
+    }
+
+    answer = transport != NULL ? 0 : 1;
+    if (send(fd, &answer, sizeof(uint32_t), MSG_NOSIGNAL) == sizeof(uint32_t)
+        && (transport != NULL))
+    {
+      return fd;
+    }
+    if (transport != NULL)
+    {
+      closeShmTransport(fd);
+    }
+    close(fd);
+  }
+}
+
+/**
+ * Offer a shared memory transport to the server listening on the given port
+ * of this host.
+ *
+ * @param port The TCP port of the server.
+ *
+ * @return The control connection with a registered transport or -1 if the
+ *         server does not provide the transport.
+ */
+int connectShmTransport(int port)
+{
+  struct sockaddr_un addr;
+  socklen_t          addrLen = _getAddress(port, &addr);
+  ShmOffer           offer;
+  struct iovec       iov = { &offer, sizeof(ShmOffer) };
+  struct msghdr      msg;
+  struct cmsghdr*    cmsg;
+  union {
+    struct cmsghdr   hdr;
+    char             buf[CMSG_SPACE(SHM_TRANSPORT_NUM_FDS * sizeof(int))];
+  } control;
+  int                fds[SHM_TRANSPORT_NUM_FDS];
+  ShmTransport*      transport = NULL;
+  ShmRegion*         region    = MAP_FAILED;
+  size_t             size      = _getRegionSize(SHM_TRANSPORT_RING_SIZE);
+  uint32_t           answer    = 1;
+  int                fd;
+  int                idx;
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if ((fd == -1) || (connect(fd, (struct sockaddr*)&addr, addrLen) != 0))
+  {
+    LOG(LEVEL_DEBUG, HDR "No shared memory transport on port %d",
+                     pthread_self(), port);
+    if (fd != -1)
+    {
+      close(fd);
+    }
+    return -1;
+  }
+  _setTimeout(fd);
+
+  for (idx = 0; idx < SHM_TRANSPORT_NUM_FDS; idx++)
+  {
+    fds[idx] = idx == 0 ? memfd_create("srx-transport", MFD_CLOEXEC)
+                        : eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  }
+  if (   (fds[0] != -1) && (fds[1] != -1) && (fds[2] != -1)
+      && (fds[3] != -1) && (fds[4] != -1) && (ftruncate(fds[0], size) == 0))
+  {
+    region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+  }
+
+  if (region != MAP_FAILED)
+  {
+    // The mapping is zero filled, the rings are empty. The first data must
+    // wake up the readers, they might only poll.
+    region->magic    = SHM_TRANSPORT_MAGIC;
+    region->version  = SHM_TRANSPORT_VERSION;
+    region->ringSize = SHM_TRANSPORT_RING_SIZE;
+    region->rings[RING_TO_SERVER].readerWaiting = 1;
+    region->rings[RING_TO_PROXY].readerWaiting  = 1;
+
+    offer.magic    = SHM_TRANSPORT_MAGIC;
+    offer.version  = SHM_TRANSPORT_VERSION;
+    offer.ringSize = SHM_TRANSPORT_RING_SIZE;
+    memset(&msg, 0, sizeof(struct msghdr));
+    memset(&control, 0, sizeof(control));
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type  = SCM_RIGHTS;
+    cmsg->cmsg_len   = CMSG_LEN(SHM_TRANSPORT_NUM_FDS * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds, SHM_TRANSPORT_NUM_FDS * sizeof(int));
+
+    if (   (sendmsg(fd, &msg, MSG_NOSIGNAL) == sizeof(ShmOffer))
+        && (recv(fd, &answer, sizeof(uint32_t), MSG_WAITALL)
+            == sizeof(uint32_t))
+        && (answer == 0))
+    {
+      transport = _createTransport(fd, region, &fds[1], false);
+      region    = MAP_FAILED;
+      fds[1]    = fds[2] = fds[3] = fds[4] = -1;
+    }
+  }
+
+  if (region != MAP_FAILED)
+  {
+    munmap(region, size);
+  }
+  for (idx = 0; idx < SHM_TRANSPORT_NUM_FDS; idx++)
+  {
+    if (fds[idx] != -1)
+    {
+      close(fds[idx]);
+    }
+  }
+  if ((transport != NULL) && !_registerTransport(transport))
+  {
+    _freeTransport(transport);
+    transport = NULL;
+  }
+  if (transport == NULL)
+  {
+    LOG(LEVEL_INFO, "The server on port %d declined the shared memory "
+                    "transport", port);
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+/**
+ * Return the transport registered for the given descriptor. The caller must
+ * release the transport once it is not used anymore.
+ *
+ * @param fd The file descriptor, can be -1.
+ *
+ * @return The transport or NULL if the descriptor has none.
+ */
+ShmTransport* acquireShmTransport(int fd)
+{
+  ShmTransport* self;
+
+  // Sockets without transport don't take the lock.
+  if ((fd < 0) || (fd >= SHM_TRANSPORT_MAX_FD) || (_transports[fd] == NULL))
+  {
+    return NULL;
+  }
+  pthread_mutex_lock(&_registryMutex);
+  self = _transports[fd];
+  if (self != NULL)
+  {
+    self->refCount++;
+  }
+  pthread_mutex_unlock(&_registryMutex);
+
+  return self;
+}
+
+/**
+ * Release a transport returned by acquireShmTransport.
+ *
+ * @param self The transport.
+ */
+void releaseShmTransport(ShmTransport* self)
+{
+  if (__sync_sub_and_fetch(&self->refCount, 1) == 0)
+  {
+    _freeTransport(self);
+  }
+}
+
+/**
+ * Check if the transport or its peer is closed.
+ *
+ * @param self The transport.
+ *
+ * @return true if closed.
+ */
+static inline bool _isClosed(ShmTransport* self)
+{
+  return self->closed || (self->region->closed != 0);
+}
+
+/**
+ * Close the transport because the peer broke the ring protocol. The positions
+ * are written by the peer as well and can not be trusted afterwards. Wakes up
+ * all threads waiting for the transport as well as the peer.
+ *
+ * @param self The transport.
+ * @param fd The control connection, set to -1.
+ */
+static void _abortTransport(ShmTransport* self, int* fd)
+{
+  LOG(LEVEL_WARNING, "Closed the shared memory transport of descriptor %d, "
+                     "the peer corrupted a ring", self->fd);
+  self->closed         = true;
+  self->region->closed = 1;
+  __sync_synchronize();
+  _signal(self->rxDataEvent);
+  _signal(self->txSpaceEvent);
+  _signal(self->txDataEvent);
+  _signal(self->rxSpaceEvent);
+  *fd = -1;
+}
+
+/**
+ * Receive the bytes available in the receive ring, at least one and at most
+ * max. Blocks while the ring is empty unless the control connection is non
+ * blocking.
+ *
+ * @param self The transport.
+ * @param fd The control connection, set to -1 if the transport is closed.
+ * @param buffer OUT - The received bytes.
+ * @param max The size of the buffer.
+ *
+ * @return The number of bytes received, 0 if the ring is empty and the
+ *         control connection is non blocking, -1 if the transport is closed
+ *         or the peer corrupted the ring.
+ */
+ssize_t recvShmTransport(ShmTransport* self, int* fd, void* buffer,
+                         size_t max)
+{
+  ShmRing*      ring   = self->rx;
+  uint32_t      mask   = self->ringSize - 1;
+  bool          lost   = false;
+  struct pollfd pfd[2];
+  uint32_t      head;
+  uint32_t      tail;
+  uint32_t      avail;
+  uint32_t      pos;
+  uint32_t      first;
+  int           flags;
+
+  for (;;)
+  {
+    _drain(self->rxDataEvent);
+    // The peer can write the whole region, read each position once.
+    head  = ring->head;
+    tail  = ring->tail;
+    avail = head - tail;
+    __sync_synchronize();
+    if (avail > self->ringSize)
+    {
+      _abortTransport(self, fd);
+      return -1;
+    }
+    if (avail > 0)
+    {
+      avail = avail > max ? (uint32_t)max : avail;
+      pos   = tail & mask;
+      first = self->ringSize - pos;
+      first = first > avail ? avail : first;
+      memcpy(buffer, self->rxData + pos, first);
+      memcpy((uint8_t*)buffer + first, self->rxData, avail - first);
+      __sync_synchronize();
+      ring->tail = tail + avail;
+      __sync_synchronize();
+      if (   ring->writerWaiting
+          && __sync_bool_compare_and_swap(&ring->writerWaiting, 1, 0))
+      {
+        _signal(self->rxSpaceEvent);
+      }
+      // Keep the poll descriptor readable while data is left, otherwise ask
+      // for a wake up before the ring is found empty next time.
+      if (ring->head == ring->tail)
+      {
+        ring->readerWaiting = 1;
+        __sync_synchronize();
+      }
+      if (ring->head != ring->tail)
+      {
+        _signal(self->rxDataEvent);
+      }
+      return avail;
+    }
+
+    ring->readerWaiting = 1;
+    __sync_synchronize();
+    if (ring->head != ring->tail)
+    {
+      continue;
+    }
+    // The owner might have reset the descriptor to abort the wait.
+    flags = *fd != -1 ? fcntl(self->fd, F_GETFL) : -1;
+    if (lost || (flags == -1) || _isClosed(self))
+    {
+      *fd = -1;
+      return -1;
+    }
+    if ((flags & O_NONBLOCK) != 0)
+    {
+      return 0;
+    }
+
+    pfd[0].fd      = self->rxDataEvent;
+    pfd[0].events  = POLLIN;
+    pfd[0].revents = 0;
+    pfd[1].fd      = self->fd;
+    pfd[1].events  = POLLIN;
+    pfd[1].revents = 0;
+    if ((poll(pfd, 2, -1) == -1) && (errno != EINTR))
+    {
+      lost = true;
+    }
+    // Nothing is sent on the control connection, readable means hang up.
+    lost = lost || (pfd[1].revents != 0);
+  }
+}
+
+/**
+ * Write the given bytes into the send ring. Blocks while the ring is full.
+ *
+ * @param self The transport.
+ * @param fd The control connection, set to -1 if the transport is closed.
+ * @param buffer The bytes to send.
+ * @param num The number of bytes.
+ *
+ * @return false if the transport is closed or the peer corrupted the ring.
+ */
+bool sendShmTransport(ShmTransport* self, int* fd, void* buffer, size_t num)
+{
+  ShmRing*      ring = self->tx;
+  uint32_t      mask = self->ringSize - 1;
+  struct pollfd pfd[2];
+  uint32_t      head;
+  uint32_t      tail;
+  uint32_t      space;
+  uint32_t      pos;
+  uint32_t      first;
+
+  while (num > 0)
+  {
+    if (_isClosed(self))
+    {
+      *fd = -1;
+      return false;
+    }
+    // The peer can write the whole region, read each position once.
+    head = ring->head;
+    tail = ring->tail;
+    __sync_synchronize();
+    if (head - tail > self->ringSize)
+    {
+      _abortTransport(self, fd);
+      return false;
+    }
+    space = self->ringSize - (head - tail);
+    if (space > 0)
+    {
+      space = space > num ? (uint32_t)num : space;
+      pos   = head & mask;
+      first = self->ringSize - pos;
+      first = first > space ? space : first;
+      memcpy(self->txData + pos, buffer, first);
+      memcpy(self->txData, (uint8_t*)buffer + first, space - first);
+      __sync_synchronize();
+      ring->head = head + space;
+      __sync_synchronize();
+      if (   ring->readerWaiting
+          && __sync_bool_compare_and_swap(&ring->readerWaiting, 1, 0))
+      {
+        _signal(self->txDataEvent);
+      }
+      buffer = (uint8_t*)buffer + space;
+      num   -= space;
+      continue;
+    }
+
+    ring->writerWaiting = 1;
+    __sync_synchronize();
+    if (ring->head - ring->tail < self->ringSize)
+    {
+      continue;
+    }
+    pfd[0].fd      = self->txSpaceEvent;
+    pfd[0].events  = POLLIN;
+    pfd[0].revents = 0;
+    pfd[1].fd      = self->fd;
+    pfd[1].events  = POLLIN;
+    pfd[1].revents = 0;
+    if (   ((poll(pfd, 2, -1) == -1) && (errno != EINTR))
+        || (pfd[1].revents != 0))
+    {
+      *fd = -1;
+      return false;
+    }
+    _drain(self->txSpaceEvent);
+  }
+
+  return true;
+}
+
+/**
+ * Return the descriptor that becomes readable when data can be received from
+ * the transport of the given descriptor or the peer is lost.
+ *
+ * @param fd The control connection.
+ *
+ * @return The descriptor to poll, fd itself if it has no transport.
+ */
+int getShmTransportPollFD(int fd)
+{
+  ShmTransport* self   = acquireShmTransport(fd);
+  int           pollFD = fd;
+
+  if (self != NULL)
+  {
+    pollFD = self->pollFD;
+    releaseShmTransport(self);
+  }
+
+  return pollFD;
+}
+
+/**
+ * Unregister the transport of the given descriptor and wake up all threads
+ * waiting for it as well as the peer. The descriptor itself is not closed.
+ *
+ * @param fd The control connection.
+ */
+void closeShmTransport(int fd)
+{
+  ShmTransport* self = NULL;
+
+  pthread_mutex_lock(&_registryMutex);
+  if ((fd >= 0) && (fd < SHM_TRANSPORT_MAX_FD))
+  {
+    self = _transports[fd];
+    _transports[fd] = NULL;
+  }
+  pthread_mutex_unlock(&_registryMutex);
+
+  if (self != NULL)
+  {
+    self->closed         = true;
+    self->region->closed = 1;
+    __sync_synchronize();
+    // Local readers and writers, then the peer.
+    _signal(self->rxDataEvent);
+    _signal(self->txSpaceEvent);
+    _signal(self->txDataEvent);
+    _signal(self->rxSpaceEvent);
+    releaseShmTransport(self);
+  }
+}
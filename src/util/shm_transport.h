@@ -0,0 +1,158 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Shared memory transport between a proxy and an SRx server on the same host.
+ * Each connection uses two single producer single consumer byte rings in a
+ * memory region created by the proxy, one per direction. Readers and writers
+ * only sleep if their ring is empty or full, the other side wakes them using
+ * an eventfd. The region and the eventfds are handed to the server over an
+ * abstract unix domain socket named after the server port. This socket stays
+ * open as the control connection: its file descriptor identifies the
+ * connection within socket.c, and its hang up signals a lost peer.
+ *
+ * The transport is registered for the file descriptor of the control
+ * connection. recvNum, recvChunk, and sendNum move the data through the rings
+ * for registered descriptors, all other code keeps using the descriptor as
+ * if it were a TCP socket.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __SHM_TRANSPORT_H__
+#define __SHM_TRANSPORT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/** The number of bytes of each ring, a power of two. */
+#define SHM_TRANSPORT_RING_SIZE (1 << 20)
+/** Transports are registered for descriptors below this value only. */
+#define SHM_TRANSPORT_MAX_FD    4096
+/** The name of the abstract unix socket of the server, %d is the port. */
+#define SHM_TRANSPORT_NAME      "srx-server-%d"
+
+/** A registered transport, see acquireShmTransport. */
+typedef struct _ShmTransport ShmTransport;
+
+/**
+ * Create the unix socket the server accepts the shared memory transports on.
+ *
+ * @param port The TCP port of the server.
+ *
+ * @return The listening socket or -1 if it could not be created.
+ */
+int createShmTransportListener(int port);
+
+/**
+ * Wait for the next proxy that offers a shared memory transport. Invalid
+ * offers are declined and the next one is awaited.
+ *
+ * @note Blocking call, a shutdown of the listening socket ends the wait.
+ *
+ * @param listenFD The listening socket.
+ *
+ * @return The control connection with a registered transport or -1 if the
+ *         listening socket failed.
+ */
+int acceptShmTransport(int listenFD);
+
+/**
+ * Offer a shared memory transport to the server listening on the given port
+ * of this host.
+ *
+ * @param port The TCP port of the server.
+ *
+ * @return The control connection with a registered transport or -1 if the
+ *         server does not provide the transport.
+ */
+int connectShmTransport(int port);
+
+/**
+ * Return the transport registered for the given descriptor. The caller must
+ * release the transport once it is not used anymore.
+ *
+ * @param fd The file descriptor, can be -1.
+ *
+ * @return The transport or NULL if the descriptor has none.
+ */
+ShmTransport* acquireShmTransport(int fd);
+
+/**
+ * Release a transport returned by acquireShmTransport.
+ *
+ * @param self The transport.
+ */
+void releaseShmTransport(ShmTransport* self);
+
+/**
+ * Receive the bytes available in the receive ring, at least one and at most
+ * max. Blocks while the ring is empty unless the control connection is non
+ * blocking.
+ *
+ * @param self The transport.
+ * @param fd The control connection, set to -1 if the transport is closed.
+ * @param buffer OUT - The received bytes.
+ * @param max The size of the buffer.
+ *
+ * @return The number of bytes received, 0 if the ring is empty and the
+ *         control connection is non blocking, -1 if the transport is closed.
+ */
+ssize_t recvShmTransport(ShmTransport* self, int* fd, void* buffer,
+                         size_t max);
+
+/**
+ * Write the given bytes into the send ring. Blocks while the ring is full.
+ *
+ * @param self The transport.
+ * @param fd The control connection, set to -1 if the transport is closed.
+ * @param buffer The bytes to send.
+ * @param num The number of bytes.
+ *
+ * @return false if the transport is closed.
+ */
+bool sendShmTransport(ShmTransport* self, int* fd, void* buffer, size_t num);
+
+/**
+ * Return the descriptor that becomes readable when data can be received from
+ * the transport of the given descriptor or the peer is lost. It allows to
+ * poll the transport from an external event loop.
+ *
+ * @param fd The control connection.
+ *
+ * @return The descriptor to poll, fd itself if it has no transport.
+ */
+int getShmTransportPollFD(int fd);
+
+/**
+ * Unregister the transport of the given descriptor and wake up all threads
+ * waiting for it as well as the peer. The descriptor itself is not closed.
+ *
+ * @param fd The control connection.
+ */
+void closeShmTransport(int fd);
+
+#endif // !__SHM_TRANSPORT_H__
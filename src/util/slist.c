@@ -21,10 +21,12 @@
  * by this software.
  *
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added deleteMatchingFromSList.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Added Changelog
  *            * Fixed speller in documentation header
@@ -206,6 +208,41 @@ bool deleteFromSList(SList* self, void* data) // SUSPICIOUS --KH--
   return false;
 }
 
+int deleteMatchingFromSList(SList* self, bool (*match)(void* data))
+{
+  SListNode* currNode = self->root;
+  SListNode* prevNode = NULL;
+  SListNode* nextNode;
+  int        deleted  = 0;
+
+  while (currNode != NULL)
+  {
+    nextNode = currNode->next;
+    if (match(currNode->data))
+    {
+      if (prevNode != NULL)
+      {
+        prevNode->next = nextNode;
+      }
+      else
+      {
+        self->root = nextNode;
+      }
+      free(currNode);
+      deleted++;
+    }
+    else
+    {
+      prevNode = currNode;
+    }
+    currNode = nextNode;
+  }
+  self->last  = prevNode;
+  self->size -= deleted;
+
+  return deleted;
+}
+
 /**
  * Removes all nodes from the list and frees up the memory used. This method is
  * equivalent to releaseList followed by initList.
@@ -42,10 +42,12 @@
  * Uses log.h to report error messages
  * 
  * 
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added deleteMatchingFromSList.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  *            * Added Changelog
@@ -157,6 +159,18 @@ extern bool insertDataIntoSList(SList* self, int index, void* data);
  */
 extern bool deleteFromSList(SList* self, void* data);
 
+/**
+ * Removes all nodes whose memory block matches in one pass. The memory blocks
+ * themselves are not released.
+ *
+ * @param self List instance
+ * @param match Returns \c true for the memory blocks to be removed
+ * @return The number of nodes removed
+ *
+ * @since 0.4.1.0
+ */
+extern int deleteMatchingFromSList(SList* self, bool (*match)(void* data));
+
 /**
  * Removes all nodes from the list and frees up the memory used. This method is
  * equivalent to releaseList followed by initList.
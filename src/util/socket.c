@@ -20,10 +20,20 @@
  * other licenses. Please refer to the licenses of all libraries required
  * by this software.
  *
- * @version 0.3.0
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0 - 2026/10/14 - kyehwanl
+ *           * sendNum waits for the socket to become writable instead of 
+ *             spinning on EAGAIN. A partially written buffer is always 
+ *             completed.
+ *           * Added recvChunk, moved the receive error handling into 
+ *             _recvOnce.
+ *         - 2026/10/15 - kyehwanl
+ *           * recvNum, recvChunk, and sendNum use the shared memory transport
+ *             of the socket if one is registered.
+ *           * Added sendNumv.
  *   0.3.0 - 2013/02/27 - oborchert
  *           * Changed handling of errors by storing errno and not always 
  *             calling it. In certain circumstances of thread handling the errno
@@ -46,12 +56,25 @@
 #include "shared/srx_packets.h"
 #include "util/socket.h"
 #include "util/log.h"
+#include "util/shm_transport.h"
 
 #include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
 #include <pthread.h>
 
 #define HDR "([0x%08X] Socket {%u}): "
 
+/** The time in milliseconds sendNum waits for a non blocking socket to become
+ * writable before it gives up - only if no data was written yet. */
+#define SEND_POLL_TIMEOUT_MS 1000
+
+#ifndef IOV_MAX
+/** The maximum number of buffers of a single sendmsg call (POSIX minimum is
+ * 16, Linux allows 1024). */
+#define IOV_MAX 1024
+#endif
+
 /** Contains the last produced error code while sending. */
 static int _sockSendError = 0;
 /** Contains the last produced error code while receiving. */
@@ -65,6 +88,116 @@ typedef enum {
 // Forward declaration
 void _setLastError(int errorCode, SockOperation operation);
 
+/**
+ * Perform a single receive call and handle its errors. In case of an error or
+ * a lost connection \c fd is set to \c -1.
+ *
+ * @param fd The file descriptor of the socket.
+ * @param buffer The buffer to be filled.
+ * @param num The maximum number of bytes to be received.
+ * @param flags The flags passed to recv.
+ *
+ * @return the number of bytes received, 0 if the call has to be repeated or 
+ *         -1 if the socket failed.
+ *
+ * @since 0.4.1.0
+ */
+static ssize_t _recvOnce(int* fd, void* buffer, size_t num, int flags)
+{
+  ssize_t rbytes;
+  
+  LOG(LEVEL_COMM, HDR "Wait to read (%u) bytes from Socket (status:%u).",
+                   pthread_self(), *fd, num, errno);
+  _setLastError(0, false);
+  rbytes = recv(*fd, buffer, num, flags);
+  LOG(LEVEL_COMM, HDR "Read %u of %u bytes from Socket (status: %u).",
+                   pthread_self(), *fd, rbytes, num, errno);
+  // An error occurred
+  if (rbytes == -1)
+  {      
+    int ioError = errno;
+    _setLastError(ioError, false);
+    if ((ioError == EAGAIN) || (ioError == EINTR))
+    {
+      return 0;
+    }
+    // Print an error message only if not intentional
+    if ((ioError != EBADF) && (ioError != ECONNRESET))
+    {
+      RAISE_SYS_ERROR("Socket error 0x%X (%u) while receiving data!",
+                      ioError, ioError);
+    }
+    else
+    {
+      LOG(LEVEL_DEBUG, HDR "Socket error 0x%X (%u) while receiving data - "
+                       "Close socket!", pthread_self(), ioError, ioError);
+      //close(*fd);
+    }
+    *fd = -1;
+    return -1;
+  }
+
+  // Connection lost
+  if (rbytes == 0)
+  {
+    LOG(LEVEL_INFO, "Connection reset by peer.");
+    //close(*fd); // No CLOSE_WAIT
+    *fd = -1;
+    return -1;
+  }
+  
+  return rbytes;
+}
+
+/**
+ * Receive from the shared memory transport of the socket and handle the end of
+ * the transport like _recvOnce handles a lost connection.
+ *
+ * @param transport The transport of the socket.
+ * @param fd The file descriptor of the socket, set to -1 if the transport is
+ *           closed.
+ * @param buffer The buffer to be filled.
+ * @param max The size of the buffer.
+ *
+ * @return the number of bytes received, 0 if nothing is available on a non
+ *         blocking socket, -1 if the transport is closed.
+ *
+ * @since 0.4.1.0
+ */
+static ssize_t _recvShm(ShmTransport* transport, int* fd, void* buffer,
+                        size_t max)
+{
+  ssize_t rbytes = recvShmTransport(transport, fd, buffer, max);
+
+  if (rbytes == 0)
+  {
+    _setLastError(EAGAIN, SOCK_OP_RCV);
+  }
+  else if (rbytes == -1)
+  {
+    LOG(LEVEL_INFO, "Shared memory transport closed by peer.");
+    _setLastError(ECONNRESET, SOCK_OP_RCV);
+  }
+
+  return rbytes;
+}
+
+/**
+ * Release the shared memory transport, used as cancellation clean-up handler
+ * because the client threads of the server are cancelled while they wait.
+ *
+ * @param transport The transport or NULL.
+ *
+ * @since 0.4.1.0
+ */
+static void _releaseShm(void* transport)
+{
+  if (transport != NULL)
+  {
+    releaseShmTransport((ShmTransport*)transport);
+  }
+}
+
 /**
  * This method receives bytes and writes them into the given buffer.
  *
@@ -78,6 +211,7 @@ void _setLastError(int errorCode, SockOperation operation);
 bool recvNum(int* fd, void* buffer, size_t num)
 {
   ssize_t     rbytes;
+  ShmTransport* transport;
   _setLastError(0, SOCK_OP_RCV);
   
   if (*fd == -1)
@@ -87,54 +221,59 @@ bool recvNum(int* fd, void* buffer, size_t num)
   }
 
   // Loop until all data is received.
+  transport = acquireShmTransport(*fd);
+  pthread_cleanup_push(_releaseShm, transport);
   while (num > 0)
   {
-    LOG(LEVEL_COMM, HDR "Wait to read (%u) bytes from Socket (status:%u).",
-                     pthread_self(), *fd, num, errno);
-    //rbytes = recv(*fd, buffer, num, MSG_WAITALL);
-    _setLastError(0, false);
-    rbytes = recv(*fd, buffer, num, MSG_NOSIGNAL | MSG_WAITALL);
-    LOG(LEVEL_COMM, HDR "Read %u of %u bytes from Socket (status: %u).",
-                     pthread_self(), *fd, rbytes, num, errno);
-    // An error occurred
+    rbytes = transport != NULL ? _recvShm(transport, fd, buffer, num)
+                               : _recvOnce(fd, buffer, num,
+                                           MSG_NOSIGNAL | MSG_WAITALL);
     if (rbytes == -1)
-    {      
-      int ioError = errno;
-      _setLastError(ioError, false);
-      if (ioError != EAGAIN)
-      {
-        // Print an error message only if not intentional
-        if ((ioError != EBADF) && (ioError != ECONNRESET))
-        {
-          RAISE_SYS_ERROR("Socket error 0x%X (%u) while receiving data!",
-                          ioError, ioError);
-        }
-        else
-        {
-          LOG(LEVEL_DEBUG, HDR "Socket error 0x%X (%u) while receiving data - "
-                           "Close socket!", pthread_self(), ioError, ioError);
-          //close(*fd);
-        }
-        *fd = -1;
-        return false;
-      }
-    }
-
-    // Connection lost
-    if (rbytes == 0)
     {
-      LOG(LEVEL_INFO, "Connection reset by peer.");
-      //close(*fd); // No CLOSE_WAIT
-      *fd = -1;
-      return false;
+      break;
     }
-
-
     buffer += rbytes;
     num -= rbytes;
   };
+  pthread_cleanup_pop(1);
 
-  return true;
+  return num == 0;
+}
+
+/**
+ * This method receives whatever is available on the socket, at least one and
+ * at most max bytes, and writes it into the given buffer.
+ *
+ * @param fd The file descriptor of the socket.
+ * @param buffer The buffer to be filled.
+ * @param max The size of the buffer.
+ *
+ * @return the number of bytes received or 0 if the socket failed.
+ *
+ * @since 0.4.1.0
+ */
+size_t recvChunk(int* fd, void* buffer, size_t max)
+{
+  ssize_t rbytes = 0;
+  ShmTransport* transport;
+  _setLastError(0, SOCK_OP_RCV);
+  
+  if (*fd == -1)
+  {
+    _setLastError(EBADF, SOCK_OP_RCV);
+    return 0;
+  }
+
+  transport = acquireShmTransport(*fd);
+  pthread_cleanup_push(_releaseShm, transport);
+  while (rbytes == 0)
+  {
+    rbytes = transport != NULL ? _recvShm(transport, fd, buffer, max)
+                               : _recvOnce(fd, buffer, max, MSG_NOSIGNAL);
+  }
+  pthread_cleanup_pop(1);
+
+  return rbytes == -1 ? 0 : (size_t)rbytes;
 }
 
 /**
@@ -151,6 +290,10 @@ bool sendNum(int* fd, void* buffer, size_t num)
 {
   ssize_t sbytes;
   bool retVal = true;
+  bool partial = false;
+  struct pollfd pfd;
+  int ioError;
+  ShmTransport* transport;
 
   // Reset the error code
   _setLastError(0, SOCK_OP_SEND);
@@ -162,6 +305,17 @@ bool sendNum(int* fd, void* buffer, size_t num)
     return false;
   }
 
+  // Co-located peer, the data goes through the shared memory ring.
+  transport = acquireShmTransport(*fd);
+  if (transport != NULL)
+  {
+    pthread_cleanup_push(_releaseShm, transport);
+    retVal = sendShmTransport(transport, fd, buffer, num);
+    pthread_cleanup_pop(1);
+    _setLastError(retVal ? 0 : ECONNRESET, SOCK_OP_SEND);
+    return retVal;
+  }
+
   while (num > 0)
   {
     sbytes = send(*fd, buffer, num, MSG_NOSIGNAL | MSG_WAITALL);
@@ -170,7 +324,8 @@ bool sendNum(int* fd, void* buffer, size_t num)
     // Any Error occurred
     if (sbytes <= 0)
     {
-      _setLastError(errno, SOCK_OP_SEND);
+      ioError = errno;
+      _setLastError(ioError, SOCK_OP_SEND);
       // Removed this sys error to allow the caller for completely deal with it.
       // If an error occurs, the error will be stored and can be retrieved using 
       // the method getLastSendError. In addition this method will return false
@@ -178,15 +333,28 @@ bool sendNum(int* fd, void* buffer, size_t num)
       //RAISE_SYS_ERROR("Socket error 0x%X (%u) while sending data!",
       //                    errno, errno);
 
-      /* Partial write. */
-      if (errno == EWOULDBLOCK || errno == EAGAIN)
+      if (ioError == EINTR)
       {
-        // TODO: later, re-try algorithm should be introduced here
         continue;
-        //retVal = false;
-        //break;
       }
-      else if ((errno != EBADF) && (errno != ECONNRESET))
+      /* Socket buffer full (non blocking socket). */
+      if (ioError == EWOULDBLOCK || ioError == EAGAIN)
+      {
+        // Wait until the socket is writable again. Once a part of the buffer 
+        // is written the remainder MUST follow, otherwise the stream is 
+        // corrupted. Without any data written the caller gets EAGAIN and can
+        // decide to retry later.
+        pfd.fd      = *fd;
+        pfd.events  = POLLOUT;
+        pfd.revents = 0;
+        if (   (poll(&pfd, 1, SEND_POLL_TIMEOUT_MS) > 0)
+            || partial || (errno == EINTR))
+        {
+          continue;
+        }
+        return false;
+      }
+      else if ((ioError != EBADF) && (ioError != ECONNRESET))
       {
         ;//close(*fd);
       }
@@ -198,11 +366,125 @@ bool sendNum(int* fd, void* buffer, size_t num)
 
     buffer += sbytes;
     num -= sbytes;
+    partial = true;
   }
 
+  _setLastError(0, SOCK_OP_SEND);
   return retVal;
 }
 
+/**
+ * Writes all given buffers to a socket with as few system calls as possible.
+ * The buffers are written in the given order. In case of an error, \c fd is
+ * set to \c -1.
+ *
+ * @param fd File-descriptor pointer
+ * @param iov The buffers, the array is modified while the data is written.
+ * @param count The number of buffers.
+ *
+ * @return \c true = successful, \c = failed
+ *
+ * @since 0.4.1.0
+ */
+bool sendNumv(int* fd, struct iovec* iov, int count)
+{
+  struct msghdr msg;
+  struct pollfd pfd;
+  ssize_t       sbytes;
+  int           ioError;
+  bool          partial = false;
+  int           idx;
+  ShmTransport* transport;
+
+  _setLastError(0, SOCK_OP_SEND);
+
+  if (*fd == -1)
+  {
+    LOG(LEVEL_DEBUG, FILE_LINE_INFO " File descriptor is invalid!");
+    _setLastError(EBADF, SOCK_OP_SEND);
+    return false;
+  }
+
+  // The shared memory ring is written buffer by buffer.
+  transport = acquireShmTransport(*fd);
+  if (transport != NULL)
+  {
+    releaseShmTransport(transport);
+    for (idx = 0; idx < count; idx++)
+    {
+      if (!sendNum(fd, iov[idx].iov_base, iov[idx].iov_len))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  memset(&msg, 0, sizeof(struct msghdr));
+  while (count > 0)
+  {
+    // Skip the buffers written completely.
+    if (iov->iov_len == 0)
+    {
+      iov++;
+      count--;
+      continue;
+    }
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = count < IOV_MAX ? count : IOV_MAX;
+    sbytes = sendmsg(*fd, &msg, MSG_NOSIGNAL);
+
+    if (sbytes <= 0)
+    {
+      ioError = errno;
+      _setLastError(ioError, SOCK_OP_SEND);
+      if (ioError == EINTR)
+      {
+        continue;
+      }
+      // Same as sendNum, once a part is written the remainder MUST follow.
+      if (ioError == EWOULDBLOCK || ioError == EAGAIN)
+      {
+        pfd.fd      = *fd;
+        pfd.events  = POLLOUT;
+        pfd.revents = 0;
+        if (   (poll(&pfd, 1, SEND_POLL_TIMEOUT_MS) > 0)
+            || partial || (errno == EINTR))
+        {
+          continue;
+        }
+        return false;
+      }
+      *fd = -1;
+      return false;
+    }
+
+    partial = true;
+    while (sbytes > 0)
+    {
+      if ((size_t)sbytes >= iov->iov_len)
+      {
+        sbytes -= iov->iov_len;
+        iov->iov_len = 0;
+      }
+      else
+      {
+        iov->iov_base = (uint8_t*)iov->iov_base + sbytes;
+        iov->iov_len -= sbytes;
+        sbytes = 0;
+      }
+      if (iov->iov_len == 0)
+      {
+        iov++;
+        count--;
+      }
+    }
+  }
+
+  _setLastError(0, SOCK_OP_SEND);
+  return true;
+}
+
 /**
  * Generate the address string of the socket.
  *
@@ -222,6 +504,11 @@ const char* sockAddrToStr(const struct sockaddr* sa, char* dest, size_t size)
   {
     return strncpy(dest, "(null)", size);
   }
+  // Shared memory transport
+  if (sa->sa_family == AF_UNIX)
+  {
+    return strncpy(dest, "(local)", size);
+  }
 
   // IPv4
   if (sa->sa_family == AF_INET)
@@ -20,10 +20,14 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Added recvChunk.
+ *          - 2026/10/15 - kyehwanl
+ *            * Added sendNumv.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  * 0.3.0    - 2013/01/09 - oborchert
@@ -41,6 +45,7 @@
 #define __SOCKET_H__
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include "util/prefix.h"
 
 /** 
@@ -65,6 +70,22 @@
  */
 bool recvNum(int* fd, void* buffer, size_t num);
 
+/**
+ * Reads the bytes available on a socket, at least one and at most \c max.
+ * In case of an error, \c fd is set to \c -1.
+ *
+ * @note Blocking call until at least one Byte is received.
+ *
+ * @param fd File-descriptor pointer
+ * @param buffer (out) Destination for the read data
+ * @param max Size of the buffer
+ * @return The number of Bytes read, \c 0 = failed
+ * @see recvNum
+ *
+ * @since 0.4.1.0
+ */
+size_t recvChunk(int* fd, void* buffer, size_t max);
+
 /** 
  * Writes \c num Bytes to a socket.
  * In case of an error, \c fd is closed and set to \c -1.
@@ -76,6 +97,21 @@ bool recvNum(int* fd, void* buffer, size_t num);
  */
 bool sendNum(int* fd, void* buffer, size_t num);
 
+/**
+ * Writes all given buffers to a socket with as few system calls as possible.
+ * The buffers are written in the given order. In case of an error, \c fd is
+ * set to \c -1.
+ *
+ * @param fd File-descriptor pointer
+ * @param iov The buffers, the array is modified while the data is written.
+ * @param count The number of buffers.
+ *
+ * @return \c true = successful, \c = failed
+ *
+ * @since 0.4.1.0
+ */
+bool sendNumv(int* fd, struct iovec* iov, int count);
+
 /**
  * Returns a textual representation of a \c sockaddr.
  *
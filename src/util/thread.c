@@ -0,0 +1,179 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+// Required for the affinity and thread name functions.
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include "util/thread.h"
+#include "util/log.h"
+
+/** The names of the thread classes. */
+static const char* _CLASS_NAMES[NUM_THREAD_CLASSES] = {
+  "command", "receiver", "sender", "network", "rpki", "bgpsec", "housekeeping"
+};
+
+/** The CPUs of each class. */
+static cpu_set_t _classCPUs[NUM_THREAD_CLASSES];
+/** Indicates if the threads of a class are pinned. */
+static bool      _classPinned[NUM_THREAD_CLASSES];
+
+/**
+ * Parse the CPU list into the CPU set.
+ *
+ * @param cpus The CPU list
+ * @param set OUT - The CPUs
+ *
+ * @return false if the list is invalid.
+ */
+static bool _parseCPUList(const char* cpus, cpu_set_t* set)
+{
+  const char* pos = cpus;
+  char*       end;
+  long        first;
+  long        last;
+
+  CPU_ZERO(set);
+  while (*pos != '\0')
+  {
+    first = strtol(pos, &end, 10);
+    last  = first;
+    if ((end == pos) || (first < 0))
+    {
+      return false;
+    }
+    pos = end;
+    if (*pos == '-')
+    {
+      last = strtol(++pos, &end, 10);
+      if ((end == pos) || (last < first))
+      {
+        return false;
+      }
+      pos = end;
+    }
+    if (last >= CPU_SETSIZE)
+    {
+      return false;
+    }
+    for (; first <= last; first++)
+    {
+      CPU_SET(first, set);
+    }
+    if (*pos == ',')
+    {
+      if (*(++pos) == '\0')
+      {
+        return false;
+      }
+    }
+    else if (*pos != '\0')
+    {
+      return false;
+    }
+  }
+
+  return CPU_COUNT(set) > 0;
+}
+
+const char* getThreadClassName(ThreadClass threadClass)
+{
+  return _CLASS_NAMES[threadClass];
+}
+
+bool isValidCPUList(const char* cpus)
+{
+  cpu_set_t set;
+
+  return _parseCPUList(cpus, &set);
+}
+
+bool setThreadClassCPUs(ThreadClass threadClass, const char* cpus)
+{
+  cpu_set_t set;
+
+  if ((cpus == NULL) || (*cpus == '\0'))
+  {
+    _classPinned[threadClass] = false;
+    return true;
+  }
+  if (!_parseCPUList(cpus, &set))
+  {
+    RAISE_ERROR("Invalid CPU list '%s' for the %s threads!", cpus,
+                _CLASS_NAMES[threadClass]);
+    return false;
+  }
+  _classCPUs[threadClass]   = set;
+  _classPinned[threadClass] = true;
+
+  return true;
+}
+
+int createThread(pthread_t* thread, pthread_attr_t* attr,
+                 ThreadClass threadClass, const char* name,
+                 void* (*start)(void*), void* arg)
+{
+  pthread_attr_t  localAttr;
+  pthread_attr_t* useAttr = attr;
+  char            threadName[THREAD_NAME_LEN + 1];
+  int             ret;
+
+  if (_classPinned[threadClass])
+  {
+    if (useAttr == NULL)
+    {
+      pthread_attr_init(&localAttr);
+      useAttr = &localAttr;
+    }
+    if (pthread_attr_setaffinity_np(useAttr, sizeof(cpu_set_t),
+                                    &_classCPUs[threadClass]) != 0)
+    {
+      LOG(LEVEL_WARNING, "Could not pin the %s thread '%s'!",
+                         _CLASS_NAMES[threadClass], name != NULL ? name : "");
+    }
+  }
+
+  ret = pthread_create(thread, useAttr, start, arg);
+  if (useAttr == &localAttr)
+  {
+    pthread_attr_destroy(&localAttr);
+  }
+
+  if ((ret == 0) && (name != NULL))
+  {
+    strncpy(threadName, name, THREAD_NAME_LEN);
+    threadName[THREAD_NAME_LEN] = '\0';
+    pthread_setname_np(*thread, threadName);
+  }
+
+  return ret;
+}
@@ -0,0 +1,120 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * Placement of the threads. Each thread belongs to a class, the threads of a
+ * class can be pinned to a set of CPUs and are named for ps / top. Pinned
+ * threads allocate their memory on the NUMA node of their CPUs with the
+ * default (first touch) memory policy. Threads of a class without CPUs are
+ * left to the scheduler.
+ *
+ * The CPUs are configured before the threads are created, they do not move
+ * threads that are running already.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __THREAD_H__
+#define __THREAD_H__
+
+#include <pthread.h>
+#include <stdbool.h>
+
+/** The maximum length of a thread name, excluding the terminating 0. */
+#define THREAD_NAME_LEN 15
+
+/**
+ * The classes of threads that are placed together.
+ */
+typedef enum {
+  /** The command handlers. */
+  THREAD_CLASS_COMMAND      = 0,
+  /** The receiver queue of the server connection handler. */
+  THREAD_CLASS_RECEIVER     = 1,
+  /** The send queue. */
+  THREAD_CLASS_SENDER       = 2,
+  /** The proxy connections: reactors, socket workers, and client threads. */
+  THREAD_CLASS_NETWORK      = 3,
+  /** The RPKI/Router sessions with the validation caches. */
+  THREAD_CLASS_RPKI         = 4,
+  /** The BGPSec path validation and signing workers. */
+  THREAD_CLASS_BGPSEC       = 5,
+  /** Garbage collector, change log, console, metrics, logging, and timers. */
+  THREAD_CLASS_HOUSEKEEPING = 6,
+  /** The number of thread classes. */
+  NUM_THREAD_CLASSES        = 7
+} ThreadClass;
+
+/**
+ * Returns the name of the thread class as used in the configuration.
+ *
+ * @param threadClass The thread class
+ *
+ * @return The name, e.g. "command".
+ */
+extern const char* getThreadClassName(ThreadClass threadClass);
+
+/**
+ * Checks if the given string is a valid CPU list. A list consists of CPU
+ * numbers and ranges separated by commas, e.g. "0-3,8".
+ *
+ * @param cpus The CPU list
+ *
+ * @return true if the list is valid and contains at least one CPU.
+ */
+extern bool isValidCPUList(const char* cpus);
+
+/**
+ * Pins the threads of the given class created from now on to the given CPUs.
+ *
+ * @param threadClass The thread class
+ * @param cpus The CPU list, NULL or an empty list leaves the threads to the
+ *             scheduler.
+ *
+ * @return false if the CPU list is invalid, the setting is not changed.
+ */
+extern bool setThreadClassCPUs(ThreadClass threadClass, const char* cpus);
+
+/**
+ * Creates a thread like pthread_create and places it according to its class.
+ * The affinity is set in the attributes so the thread never runs on other
+ * CPUs. The thread is named, longer names are truncated to THREAD_NAME_LEN
+ * characters.
+ *
+ * @param thread OUT - The thread
+ * @param attr The attributes or NULL. The affinity of a pinned class is set
+ *             in the given attributes.
+ * @param threadClass The class of the thread
+ * @param name The name of the thread or NULL
+ * @param start The function the thread runs
+ * @param arg The argument of the function
+ *
+ * @return 0 if the thread was created, otherwise the error of pthread_create.
+ */
+extern int createThread(pthread_t* thread, pthread_attr_t* attr,
+                        ThreadClass threadClass, const char* name,
+                        void* (*start)(void*), void* arg);
+
+#endif // !__THREAD_H__
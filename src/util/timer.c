@@ -20,10 +20,25 @@
  * other licenses. Please refer to the licenses of all libraries required 
  * by this software.
  *
- * @version 0.3.0.10
+ * The managed timers are kept within a hierarchical timer wheel. Each level
+ * has TIMER_WHEEL_SLOTS slots, the slots of level n cover 
+ * TIMER_WHEEL_SLOTS^n ticks each. Entries are moved down one level each time
+ * the lower level completed a round (cascade), entries of level 0 expire. 
+ * The timer thread advances the wheel of the managed timers.
+ *
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Replaced the SIGALRM based implementation and the timer list 
+ *              with a hierarchical timer wheel driven by a timer thread. 
+ *              Starting and stopping a timer does not scan all timers anymore
+ *              and the process wide alarm is not used anymore.
+ *            * Timer ids are stable, deleting a timer does not change the id
+ *              of the timers set up after it.
+ *          - 2026/10/15 - kyehwanl
+ *            * The timer thread is placed and named by createThread.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Added Changelog
  *            * Fixed speller in documentation header
@@ -31,221 +46,522 @@
  * 0.1.0    - 2009/12/32 -pgleichm
  *            * Code created. 
  */
-#include <stdio.h>
-#include <signal.h>
-#include <sys/time.h>
-#include "util/slist.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "util/mutex.h"
 #include "util/timer.h"
-// @TODO: Check if still used of if already replaced by stock functions.
+#include "util/thread.h"
+
+/** The mask of the slot index within a wheel level */
+#define TIMER_WHEEL_MASK   (TIMER_WHEEL_SLOTS - 1)
+/** The number of ticks the wheel covers */
+#define TIMER_WHEEL_RANGE  (1ULL << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS))
+
 /**
  * A single timer
  */
 typedef struct {
-  int           id;
-  bool          active;
-  time_t        future; 
-  int           interval;
-  TimerExpired  callback;
+  TimerWheelEntry entry;    // The wheel entry, MUST be the first attribute
+  int             id;
+  bool            active;
+  int             interval; // The interval in seconds, -1 = only once
+  TimerExpired    callback;
 } Timer;
 
-/** Prevents that the timer-list gets reset */
-static bool   _initialized = false;
-/** List of all timers */
-static SList  _timerList;
-/** Id of the active timer */
-static int    _activeId; 
-
+/** A callback to be called by the timer thread */
+typedef struct {
+  TimerExpired callback;
+  int          id;
+} TimerFiring;
+
+/** Guards all managed timers */
+static Mutex        _timerMutex = PTHREAD_MUTEX_INITIALIZER;
+/** Wakes up the timer thread */
+static Cond         _timerCond;
+/** The timer thread */
+static pthread_t    _timerThread;
+/** Prevents that the timers get reset */
+static bool         _initialized = false;
+/** Indicates if the timer thread has to continue */
+static bool         _running = false;
+/** The wheel of the managed timers */
+static TimerWheel   _wheel;
+/** The managed timers, the id is the index */
+static Timer**      _timers = NULL;
+/** The number of elements of _timers */
+static int          _maxTimers = 0;
+/** The callbacks of the expired timers, used by the timer thread only */
+static TimerFiring* _firing = NULL;
+/** The number of elements of _firing */
+static int          _maxFiring = 0;
+
+/*------------
+ * Timer wheel
+ */
 
-static void setTimer(int sec) 
+/**
+ * Link the entry into the slot it belongs to.
+ *
+ * @param self The timer wheel
+ * @param entry The entry, MUST not be scheduled.
+ */
+static void _insertEntry(TimerWheel* self, TimerWheelEntry* entry)
 {
-  struct itimerval  tv;
+  uint64_t          expires = entry->expires;
+  uint64_t          delta;
+  int               level;
+  TimerWheelEntry** slot;
 
-  timerclear(&tv.it_interval);
-  tv.it_value.tv_usec = 0;
-  tv.it_value.tv_sec  = sec;
+  // Past entries expire with the next tick
+  if ((int64_t)(expires - self->current) < 0)
+  {
+    expires = self->current;
+  }
+  delta = expires - self->current;
+  // Entries beyond the range wait in the last level
+  if (delta >= TIMER_WHEEL_RANGE)
+  {
+    delta   = TIMER_WHEEL_RANGE - 1;
+    expires = self->current + delta;
+  }
+  for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++)
+  {
+    if (delta < (1ULL << ((level + 1) * TIMER_WHEEL_BITS)))
+    {
+      break;
+    }
+  }
+  slot = &self->slots[level]
+                     [(expires >> (level * TIMER_WHEEL_BITS)) 
+                      & TIMER_WHEEL_MASK];
 
-  setitimer(ITIMER_REAL, &tv, NULL);
+  entry->next = *slot;
+  if (entry->next != NULL)
+  {
+    entry->next->pprev = &entry->next;
+  }
+  entry->pprev = slot;
+  *slot        = entry;
+  self->count++;
 }
 
 /**
- * Sets the alarm to the earliest timer.
+ * Move all entries of the given slot into the slots they belong to now.
+ *
+ * @param self The timer wheel
+ * @param level The level of the slot.
+ * @param idx The index of the slot.
+ *
+ * @return The index of the slot.
  */
-static void selectTimer() 
+static int _cascade(TimerWheel* self, int level, int idx)
 {
-  time_t            min = 0;
-  SListNode*        cnode;
-  Timer*            tcurr, *tsel = NULL;
+  TimerWheelEntry* entry = self->slots[level][idx];
+  TimerWheelEntry* next;
 
-  // Search for the earliest time - a sorted list would be an alternative
-  FOREACH_SLIST(&_timerList, cnode) 
+  self->slots[level][idx] = NULL;
+  while (entry != NULL)
   {
-    tcurr = (Timer*)cnode->data;
+    next         = entry->next;
+    entry->pprev = NULL;
+    self->count--;
+    _insertEntry(self, entry);
+    entry = next;
+  }
 
-    // Not an active timer - skip
-    if (!tcurr->active) 
+  return idx;
+}
+
+void initTimerWheel(TimerWheel* self, uint64_t now)
+{
+  memset(self, 0, sizeof(TimerWheel));
+  self->current = now;
+}
+
+void addToTimerWheel(TimerWheel* self, TimerWheelEntry* entry, 
+                     uint64_t expires)
+{
+  removeFromTimerWheel(self, entry);
+  entry->expires = expires;
+  _insertEntry(self, entry);
+}
+
+void removeFromTimerWheel(TimerWheel* self, TimerWheelEntry* entry)
+{
+  if (entry->pprev != NULL)
+  {
+    *entry->pprev = entry->next;
+    if (entry->next != NULL)
     {
-      continue;
+      entry->next->pprev = entry->pprev;
+    }
+    entry->next  = NULL;
+    entry->pprev = NULL;
+    self->count--;
+  }
+}
+
+bool isInTimerWheel(TimerWheelEntry* entry)
+{
+  return entry->pprev != NULL;
+}
+
+TimerWheelEntry* advanceTimerWheel(TimerWheel* self, uint64_t now)
+{
+  TimerWheelEntry*  expired = NULL;
+  TimerWheelEntry** tail    = &expired;
+  TimerWheelEntry*  entry;
+  TimerWheelEntry*  next;
+  int               idx;
+  int               level;
+
+  while ((int64_t)(now - self->current) >= 0)
+  {
+    // Nothing to do for an empty wheel
+    if (self->count == 0)
+    {
+      self->current = now + 1;
+      break;
     }
 
-    // Earlier than the previous timer(s)
-    if ((tcurr->future < min) || (min == 0)) 
+    idx = (int)(self->current & TIMER_WHEEL_MASK);
+    // Level 0 completed a round, move the next slot of the higher levels down
+    for (level = 1; (idx == 0) && (level < TIMER_WHEEL_LEVELS); level++)
     {
-      tsel = tcurr;
-      min = tcurr->future;
+      idx = _cascade(self, level, 
+                     (int)((self->current >> (level * TIMER_WHEEL_BITS)) 
+                           & TIMER_WHEEL_MASK));
     }
+
+    idx   = (int)(self->current & TIMER_WHEEL_MASK);
+    entry = self->slots[0][idx];
+    self->slots[0][idx] = NULL;
+    while (entry != NULL)
+    {
+      next         = entry->next;
+      entry->pprev = NULL;
+      self->count--;
+      *tail        = entry;
+      tail         = &entry->next;
+      entry        = next;
+    }
+    *tail = NULL;
+    self->current++;
   }
 
-  // A timer has been selected
-  if (tsel != NULL) 
-  {
-    _activeId = tsel->id;
-    setTimer(tsel->future - time(NULL));
+  return expired;
+}
+
+/*---------------
+ * Managed timers
+ */
+
+/**
+ * Return the current tick of the managed timers.
+ *
+ * @return The current tick.
+ */
+static uint64_t _nowTick()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((uint64_t)now.tv_sec * TIMER_TICKS_PER_SEC)
+         + (now.tv_nsec / (1000000000 / TIMER_TICKS_PER_SEC));
+}
+
+/**
+ * Return the timer with the given id. The timer mutex MUST be locked.
+ *
+ * @param id Timer identifier
+ *
+ * @return The timer or NULL.
+ */
+static Timer* _getTimer(int id)
+{
+  return ((id >= 0) && (id < _maxTimers)) ? _timers[id] : NULL;
+}
+
+/**
+ * Add the callback to the list of callbacks to be called.
+ *
+ * @param noFiring The number of callbacks already added.
+ * @param timer The expired timer.
+ *
+ * @return The number of callbacks.
+ */
+static int _addFiring(int noFiring, Timer* timer)
+{
+  TimerFiring* firing;
 
-  // No active timer
-  } 
-  else 
+  if (noFiring == _maxFiring)
   {
-    _activeId = -1;
+    firing = realloc(_firing, (_maxFiring + 16) * sizeof(TimerFiring));
+    if (firing == NULL)
+    {
+      // The timer is lost for this round
+      return noFiring;
+    }
+    _firing     = firing;
+    _maxFiring += 16;
   }
+  _firing[noFiring].callback = timer->callback;
+  _firing[noFiring].id       = timer->id;
+
+  return noFiring + 1;
 }
 
-/** 
- * \c alarm function.
+/**
+ * The timer thread. It advances the wheel once per tick while timers are
+ * active and calls the callbacks of the expired timers without holding the
+ * timer mutex.
+ *
+ * @param data unused
  *
- * @param _sig (unused) Signal
+ * @return NULL
  */
-static void alarmSignal(int sig) 
+static void* _timerLoop(void* data)
 {
-  if (_activeId > -1) 
+  TimerWheelEntry* entry;
+  Timer*           timer;
+  struct timespec  wakeUp;
+  int              noFiring;
+  int              idx;
+
+  lockMutex(&_timerMutex);
+  while (_running)
   {
-    Timer* t = getFromSList(&_timerList, _activeId);
-
-    // Other signal was fired - restart the timer 
-    if (sig != SIGALRM) 
-    {
-      setTimer(t->future - time(NULL));
-    } 
-    else 
+    noFiring = 0;
+    entry    = advanceTimerWheel(&_wheel, _nowTick());
+    while (entry != NULL)
     {
-      // One shot timer - disable it
-      if (t->interval == -1) 
+      timer = (Timer*)entry;
+      entry = entry->next;
+      if (timer->interval > 0)
       {
-        t->active = false;
-      } 
-      else 
+        addToTimerWheel(&_wheel, &timer->entry, timer->entry.expires 
+                        + (timer->interval * TIMER_TICKS_PER_SEC));
+      }
+      else
       {
-        t->future += t->interval;
+        timer->active = false;
       }
+      noFiring = _addFiring(noFiring, timer);
+    }
 
-      // Select a new timer
-      selectTimer();
+    if (noFiring > 0)
+    {
+      unlockMutex(&_timerMutex);
+      for (idx = 0; idx < noFiring; idx++)
+      {
+        _firing[idx].callback(_firing[idx].id, time(NULL));
+      }
+      lockMutex(&_timerMutex);
+      continue;
+    }
 
-      // Call the handler
-      t->callback(t->id, time(NULL));
+    if (_wheel.count == 0)
+    {
+      pthread_cond_wait(&_timerCond, &_timerMutex);
+    }
+    else
+    {
+      // Wait for the next tick
+      wakeUp.tv_sec  = _wheel.current / TIMER_TICKS_PER_SEC;
+      wakeUp.tv_nsec = (_wheel.current % TIMER_TICKS_PER_SEC) 
+                       * (1000000000 / TIMER_TICKS_PER_SEC);
+      pthread_cond_timedwait(&_timerCond, &_timerMutex, &wakeUp);
     }
   }
+  unlockMutex(&_timerMutex);
+
+  return NULL;
 }
 
-/** 
- * Clears the \c alarm.
+/**
+ * Start the timer thread. The timer mutex MUST be locked.
+ *
+ * @return true if the thread runs.
  */
-static void clearAlarm() 
+static bool _startTimerThread()
 {
-  struct itimerval tv;
+  pthread_condattr_t attr;
 
-  timerclear(&tv.it_value);
-  setitimer(ITIMER_REAL, &tv, NULL);
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  if (pthread_cond_init(&_timerCond, &attr) != 0)
+  {
+    pthread_condattr_destroy(&attr);
+    return false;
+  }
+  pthread_condattr_destroy(&attr);
+
+  initTimerWheel(&_wheel, _nowTick());
+  _running = true;
+  if (createThread(&_timerThread, NULL, THREAD_CLASS_HOUSEKEEPING,
+                   "srx-timer", _timerLoop, NULL) != 0)
+  {
+    _running = false;
+    destroyCond(&_timerCond);
+    return false;
+  }
+
+  return true;
 }
 
 int setupTimer(TimerExpired callback) 
 {
   Timer*  t; 
+  Timer** timers;
+  int     id = -1;
  
+  lockMutex(&_timerMutex);
   // No timer yet
   if (!_initialized) 
   {
-    initSList(&_timerList);
-    _initialized = true;
-    _activeId    = -1;
-    signal(SIGALRM, alarmSignal);
+    _initialized = _startTimerThread();
   }
 
-  // Append the new timer structure
-  t = appendToSList(&_timerList, sizeof(Timer));
-  if (t == NULL) 
+  if (_initialized)
   {
-    return -1;
+    // Re-use the id of a deleted timer
+    id = 0;
+    while ((id < _maxTimers) && (_timers[id] != NULL))
+    {
+      id++;
+    }
+    if (id == _maxTimers)
+    {
+      timers = realloc(_timers, (_maxTimers + 16) * sizeof(Timer*));
+      if (timers == NULL)
+      {
+        id = -1;
+      }
+      else
+      {
+        memset(timers + _maxTimers, 0, 16 * sizeof(Timer*));
+        _timers     = timers;
+        _maxTimers += 16;
+      }
+    }
   }
 
-  t->id       = sizeOfSList(&_timerList) - 1;
-  t->active   = false;
-  t->callback = callback;
+  if (id != -1)
+  {
+    t = calloc(1, sizeof(Timer));
+    if (t == NULL) 
+    {
+      id = -1;
+    }
+    else
+    {
+      t->id       = id;
+      t->active   = false;
+      t->interval = -1;
+      t->callback = callback;
+      _timers[id] = t;
+    }
+  }
+  unlockMutex(&_timerMutex);
 
-  return t->id;
+  return id;
 }
 
 void deleteTimer(int id) 
 {
-  Timer* t = getFromSList(&_timerList, id);
+  Timer* t;
+
+  lockMutex(&_timerMutex);
+  t = _getTimer(id);
   if (t != NULL) 
   {
-    stopTimer(id);
-    deleteFromSList(&_timerList, t);
+    removeFromTimerWheel(&_wheel, &t->entry);
+    _timers[id] = NULL;
+    free(t);
   }
+  unlockMutex(&_timerMutex);
 }
 
 void deleteAllTimers() 
 {
-  clearAlarm();
-  releaseSList(&_timerList);
-  _initialized = false;
+  int idx;
+
+  lockMutex(&_timerMutex);
+  if (_initialized)
+  {
+    _running = false;
+    signalCond(&_timerCond);
+    unlockMutex(&_timerMutex);
+    pthread_join(_timerThread, NULL);
+    lockMutex(&_timerMutex);
+
+    for (idx = 0; idx < _maxTimers; idx++)
+    {
+      free(_timers[idx]);
+    }
+    free(_timers);
+    free(_firing);
+    _timers      = NULL;
+    _maxTimers   = 0;
+    _firing      = NULL;
+    _maxFiring   = 0;
+    destroyCond(&_timerCond);
+    _initialized = false;
+  }
+  unlockMutex(&_timerMutex);
 }
 
 bool isActiveTimer(int id) 
 {
-  Timer* t = getFromSList(&_timerList, id);
-  return (t == NULL) ? false : t->active;
+  Timer* t;
+  bool   active;
+
+  lockMutex(&_timerMutex);
+  t      = _getTimer(id);
+  active = (t == NULL) ? false : t->active;
+  unlockMutex(&_timerMutex);
+
+  return active;
 }
 
 /**
- * Starts the timer, to fire in the a specific time.
+ * Starts the timer, to fire in a specific number of seconds.
  *
  * @param id Timer identifier
- * @param future When to fire (UNIX timestamp)
+ * @param sec When to fire in seconds from now
  * @param interval Fire again afer \c internval seconds, \c -1 = only once
  */
-static void startTimer(int id, time_t future, int interval) 
+static void startTimer(int id, int sec, int interval) 
 {
   Timer* t;
 
-  // Active timer - then deactivate it first
-  if (_activeId == id) 
-  {
-    clearAlarm();
-  }
-
-  // Store the parameters
-  t = getFromSList(&_timerList, id);
+  lockMutex(&_timerMutex);
+  t = _getTimer(id);
   if (t != NULL) 
   {
-    t->future   = future;
     t->interval = interval;
     t->active   = true;
-
-    selectTimer();  
+    addToTimerWheel(&_wheel, &t->entry, 
+                    _nowTick() + ((uint64_t)sec * TIMER_TICKS_PER_SEC));
+    // The timer thread might wait without timeout
+    signalCond(&_timerCond);
   }
+  unlockMutex(&_timerMutex);
 }
 
 void startIntervalTimer(int id, int sec, bool oneShot) 
 {
-  startTimer(id, time(NULL) + sec, oneShot ? -1 : sec);
+  startTimer(id, sec, oneShot ? -1 : sec);
 }
 
 void startAbsoluteTimer(int id, time_t future) 
 {
-  if (future > time(NULL)) 
+  time_t now = time(NULL);
+
+  if (future > now) 
   {
-    startTimer(id, future, -1);
+    startTimer(id, (int)(future - now), -1);
   }
 }
 
@@ -253,25 +569,12 @@ void stopTimer(int id)
 {
   Timer* t;
 
-  // The given timer is the active timer
-  if (_activeId == id) 
+  lockMutex(&_timerMutex);
+  t = _getTimer(id);
+  if (t != NULL) 
   {
-    // Deactivate first
-    clearAlarm();
-
-    // Set to inactive and select a new timer
-    t = getFromSList(&_timerList, id);
+    removeFromTimerWheel(&_wheel, &t->entry);
     t->active = false;
-    selectTimer();
-
-  // Not the active timer
-  } 
-  else 
-  {
-    t = getFromSList(&_timerList, id);
-    if (t != NULL) 
-    {
-      t->active = false;
-    }
   }
-}
\ No newline at end of file
+  unlockMutex(&_timerMutex);
+}
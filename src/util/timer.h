@@ -20,12 +20,20 @@
  * by this software.
  *
  *
- * Managed timers.
+ * Managed timers. All timers are kept within a hierarchical timer wheel,
+ * starting, stopping and deleting a timer is O(1). The wheel of the managed
+ * timers is driven by a dedicated thread, the expired callbacks are called
+ * within this thread. The timer wheel itself can also be used directly for 
+ * large numbers of timers that are driven by the caller.
  * 
- * @version 0.3.0.10
+ * @version 0.4.1.0
  *
  * Changelog:
  * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/14 - kyehwanl
+ *            * Replaced the SIGALRM based implementation with a hierarchical
+ *              timer wheel driven by a timer thread.
+ *            * Added the TimerWheel API.
  * 0.3.0.10 - 2015/11/09 - oborchert
  *            * Removed types.h
  *            * Added Changelog
@@ -38,6 +46,87 @@
 
 #include <time.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+/** The number of bits of the slot index of each wheel level */
+#define TIMER_WHEEL_BITS   6
+/** The number of slots of each wheel level */
+#define TIMER_WHEEL_SLOTS  (1 << TIMER_WHEEL_BITS)
+/** The number of wheel levels. Timers further in the future than 
+ * TIMER_WHEEL_SLOTS^TIMER_WHEEL_LEVELS ticks are re-scheduled from the last
+ * level until they are due. */
+#define TIMER_WHEEL_LEVELS 4
+
+/** The number of ticks per second of the managed timers. */
+#define TIMER_TICKS_PER_SEC 10
+
+/**
+ * A single entry of the timer wheel. The memory is managed by the caller, it
+ * is usually embedded into the structure that needs the timer.
+ */
+typedef struct _TimerWheelEntry {
+  struct _TimerWheelEntry*  next;    // The next entry within the slot
+  struct _TimerWheelEntry** pprev;   // The link to this entry, NULL if not 
+                                     // scheduled
+  uint64_t                  expires; // The tick the entry expires at
+} TimerWheelEntry;
+
+/**
+ * The hierarchical timer wheel. It does not lock, the caller MUST serialize
+ * the access.
+ */
+typedef struct {
+  TimerWheelEntry* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  uint64_t         current; // The next tick to be processed
+  uint32_t         count;   // The number of scheduled entries
+} TimerWheel;
+
+/**
+ * Initializes the timer wheel.
+ *
+ * @param self The timer wheel
+ * @param now The current tick
+ */
+extern void initTimerWheel(TimerWheel* self, uint64_t now);
+
+/**
+ * Schedule the entry to expire at the given tick. An entry that is scheduled
+ * already is re-scheduled. Ticks in the past expire with the next advance.
+ *
+ * @param self The timer wheel
+ * @param entry The entry
+ * @param expires The tick the entry expires at
+ */
+extern void addToTimerWheel(TimerWheel* self, TimerWheelEntry* entry, 
+                            uint64_t expires);
+
+/**
+ * Remove the entry from the timer wheel if it is scheduled.
+ *
+ * @param self The timer wheel
+ * @param entry The entry
+ */
+extern void removeFromTimerWheel(TimerWheel* self, TimerWheelEntry* entry);
+
+/**
+ * Checks if the entry is scheduled.
+ *
+ * @param entry The entry
+ *
+ * @return true if the entry is scheduled.
+ */
+extern bool isInTimerWheel(TimerWheelEntry* entry);
+
+/**
+ * Process all ticks up to and including the given tick. The expired entries 
+ * are removed from the wheel and returned, linked using their next pointer.
+ *
+ * @param self The timer wheel
+ * @param now The current tick
+ *
+ * @return The expired entries or NULL.
+ */
+extern TimerWheelEntry* advanceTimerWheel(TimerWheel* self, uint64_t now);
 
 /**
  * Definition of the function that should be called upon the firing of a
@@ -51,6 +140,9 @@ typedef void (*TimerExpired)(int id, time_t now);
 /**
  * Sets up a new timer.
  *
+ * @note The callback is called within the timer thread. A timer that is 
+ *       stopped while it expires might be called one last time.
+ *
  * @param callback Function that should be called upon the firing of the timer
  * @return Identifier of the new timer, or \c -1 in case of an error
  */
@@ -68,7 +160,8 @@ extern void deleteTimer(int id);
 /**
  * Deletes all timers.
  *
- * @note Stops all timers
+ * @note Stops all timers and the timer thread. MUST NOT be called from 
+ *       within a timer callback.
  */
 extern void deleteAllTimers();
 
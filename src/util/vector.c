@@ -0,0 +1,119 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#include <string.h>
+#include "util/vector.h"
+
+/** The number of elements allocated with the first append. */
+#define VECTOR_INIT_CAPACITY 8
+
+void initVector(Vector* self, size_t elemSize)
+{
+  self->data     = NULL;
+  self->elemSize = elemSize;
+  self->size     = 0;
+  self->capacity = 0;
+}
+
+void releaseVector(Vector* self)
+{
+  free(self->data);
+  self->data     = NULL;
+  self->size     = 0;
+  self->capacity = 0;
+}
+
+void emptyVector(Vector* self)
+{
+  self->size = 0;
+}
+
+bool reserveVector(Vector* self, uint32_t capacity)
+{
+  uint8_t* data;
+
+  if (capacity <= self->capacity)
+  {
+    return true;
+  }
+  data = realloc(self->data, capacity * self->elemSize);
+  if (data == NULL)
+  {
+    return false;
+  }
+  self->data     = data;
+  self->capacity = capacity;
+
+  return true;
+}
+
+void* appendToVector(Vector* self)
+{
+  if (   (self->size == self->capacity)
+      && !reserveVector(self, self->capacity == 0 ? VECTOR_INIT_CAPACITY
+                                                  : self->capacity * 2))
+  {
+    return NULL;
+  }
+
+  return self->data + (self->size++ * self->elemSize);
+}
+
+bool appendDataToVector(Vector* self, const void* data)
+{
+  void* elem = appendToVector(self);
+
+  if (elem == NULL)
+  {
+    return false;
+  }
+  memcpy(elem, data, self->elemSize);
+
+  return true;
+}
+
+void removeFromVector(Vector* self, uint32_t index)
+{
+  self->size--;
+  if (index < self->size)
+  {
+    memcpy(self->data + (index * self->elemSize), 
+           self->data + (self->size * self->elemSize), self->elemSize);
+  }
+}
+
+void* getFromVector(Vector* self, uint32_t index)
+{
+  return self->data + (index * self->elemSize);
+}
+
+uint32_t sizeOfVector(Vector* self)
+{
+  return self->size;
+}
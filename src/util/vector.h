@@ -0,0 +1,150 @@
+/**
+ * This software was developed at the National Institute of Standards and
+ * Technology by employees of the Federal Government in the course of
+ * their official duties. Pursuant to title 17 Section 105 of the United
+ * States Code this software is not subject to copyright protection and
+ * is in the public domain.
+ *
+ * NIST assumes no responsibility whatsoever for its use by other parties,
+ * and makes no guarantees, expressed or implied, about its quality,
+ * reliability, or any other characteristic.
+ *
+ * We would appreciate acknowledgment if the software is used.
+ *
+ * NIST ALLOWS FREE USE OF THIS SOFTWARE IN ITS "AS IS" CONDITION AND
+ * DISCLAIM ANY LIABILITY OF ANY KIND FOR ANY DAMAGES WHATSOEVER RESULTING
+ * FROM THE USE OF THIS SOFTWARE.
+ *
+ * This software might use libraries that are under GNU public license or
+ * other licenses. Please refer to the licenses of all libraries required
+ * by this software.
+ *
+ * A growable contiguous array of elements of a fixed size. The capacity 
+ * doubles when the array is full, emptying the vector keeps the memory to be 
+ * reused.
+ *
+ * @note Not thread-safe!
+ *
+ * Usage example (w/o checking for errors):
+ * @code
+ * Vector  vec;
+ * void*   ptr;
+ * uint32_t idx;
+ *
+ * initVector(&vec, sizeof(void*));
+ * appendDataToVector(&vec, &ptr);
+ * for (idx = 0; idx < vec.size; idx++)
+ * {
+ *   ptr = *(void**)getFromVector(&vec, idx);
+ * }
+ * releaseVector(&vec);
+ * @endcode
+ *
+ * @version 0.4.1.0
+ *
+ * Changelog:
+ * -----------------------------------------------------------------------------
+ * 0.4.1.0  - 2026/10/15 - kyehwanl
+ *            * Code created.
+ */
+
+#ifndef __VECTOR_H__
+#define __VECTOR_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * A growable array.
+ */
+typedef struct
+{
+  uint8_t* data;     ///< The elements, NULL until the first append
+  size_t   elemSize; ///< The size of each element
+  uint32_t size;     ///< The number of elements stored
+  uint32_t capacity; ///< The number of elements that fit without growing
+} Vector;
+
+/**
+ * Initializes an empty vector. No memory is allocated.
+ *
+ * @param self The vector
+ * @param elemSize The size of each element
+ */
+extern void initVector(Vector* self, size_t elemSize);
+
+/**
+ * Frees the memory of the vector.
+ *
+ * @param self The vector
+ */
+extern void releaseVector(Vector* self);
+
+/**
+ * Removes all elements, the memory is kept.
+ *
+ * @param self The vector
+ */
+extern void emptyVector(Vector* self);
+
+/**
+ * Makes sure the vector can store the given number of elements without 
+ * growing.
+ *
+ * @param self The vector
+ * @param capacity The number of elements
+ *
+ * @return \c false if the memory could not be allocated
+ */
+extern bool reserveVector(Vector* self, uint32_t capacity);
+
+/**
+ * Appends a new element to the end of the vector.
+ *
+ * @param self The vector
+ *
+ * @return The uninitialized element, or \c NULL if the memory could not be
+ *         allocated. It is valid until the vector grows.
+ */
+extern void* appendToVector(Vector* self);
+
+/**
+ * Appends a copy of the given element to the end of the vector.
+ *
+ * @param self The vector
+ * @param data The element, \c elemSize bytes are copied
+ *
+ * @return \c false if the memory could not be allocated
+ */
+extern bool appendDataToVector(Vector* self, const void* data);
+
+/**
+ * Removes the element at the given position. The last element takes its
+ * place, the order of the elements is not maintained.
+ *
+ * @param self The vector
+ * @param index The position of the element
+ */
+extern void removeFromVector(Vector* self, uint32_t index);
+
+/**
+ * Returns the element at the given position.
+ *
+ * @param self The vector
+ * @param index The position of the element, MUST be less than \c size
+ *
+ * @return The element
+ */
+extern void* getFromVector(Vector* self, uint32_t index);
+
+/**
+ * Returns the number of elements stored.
+ *
+ * @param self The vector
+ *
+ * @return The number of elements
+ */
+extern uint32_t sizeOfVector(Vector* self);
+
+#endif // !__VECTOR_H__